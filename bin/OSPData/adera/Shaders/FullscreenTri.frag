@@ -28,10 +28,11 @@
 layout(location = 0, index = 0) out vec3 color;
 
 layout(location = 0) uniform sampler2D framebuffer;
+layout(location = 2) uniform vec2 uvMax;
 
 in vec2 uv;
 
 void main()
 {
-    color = texture(framebuffer, uv).rgb;
+    color = texture(framebuffer, min(uv, uvMax)).rgb;
 }
@@ -28,10 +28,13 @@
 layout(location = 0) in vec2 vertPosition;
 layout(location = 1) in vec2 vertTexCoords;
 
+// Fraction of the framebuffer texture that was rendered to
+layout(location = 1) uniform vec2 uvScale;
+
 out vec2 uv;
 
 void main()
 {
     gl_Position = vec4(vertPosition, 0.0, 1.0);
-    uv = vertTexCoords;
+    uv = vertTexCoords * uvScale;
 }
@@ -0,0 +1,59 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+ //#version 430 core
+
+// One line strip per satellite, generated from gl_VertexID and gl_InstanceID with no vertex
+// attributes. Samples are read from a ring buffer written one row per tick, see
+// adera::shader::OrbitTrailShader
+
+// xyz of each satellite packed tightly, one row of satCount satellites per sample
+layout(std430, binding = 0) readonly buffer TrailSamples
+{
+    float samples[];
+};
+
+layout(location = 0) uniform mat4 projMat;
+layout(location = 1) uniform mat4 modelViewMat;  // trail space to view space
+layout(location = 2) uniform int satCount;
+layout(location = 3) uniform int trailLength;    // rows in the ring buffer
+layout(location = 4) uniform int head;           // row of the newest sample
+layout(location = 5) uniform int sampleCount;    // rows written so far, up to trailLength
+layout(location = 6) uniform vec4 trailColor;
+
+out vec4 fragColor;
+
+void main()
+{
+    // Vertex 0 is the oldest sample, fading out towards it
+    int age = sampleCount - 1 - gl_VertexID;
+    int row = (head - age + trailLength) % trailLength;
+    int i = (row * satCount + gl_InstanceID) * 3;
+
+    vec3 pos = vec3(samples[i], samples[i + 1], samples[i + 2]);
+
+    gl_Position = projMat * modelViewMat * vec4(pos, 1.0);
+
+    fragColor = vec4(trailColor.rgb, trailColor.a * (1.0 - float(age) / float(trailLength)));
+}
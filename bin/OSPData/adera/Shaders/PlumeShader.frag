@@ -29,49 +29,41 @@
    rocket exhaust plume effect that scales with engine power
  * Tons of hardcoded parameters for now, later can generalize it and pass
    some sort of uniform block storing all the configuration options, but
-   for now this is it (dimensions of the plume can still be specified via
-   uniform, though)
+   for now this is it (dimensions, power, and color of each plume are still
+   read from the instance buffer, though)
 */
-in vec3 normal;
 in vec3 fragPos;
 
-layout(location = 0, index = 0) out vec4 color;
-
-/* Z position of plume ends
+/* Per-plume parameters from the vertex shader
+ * plumeParams.x: Engine power, which is the primary influence on plume density
+ * plumeParams.y: Flow velocity, how fast combustion noise scrolls down the plume
+ * plumeParams.z, plumeParams.w: Z position of plume ends (top, bottom)
 
- * The origin is assumed to be located at the aperture of the nozzle. These
-   values are used to compute the UV coordinates for the plume, with V
+ * The origin is assumed to be located at the aperture of the nozzle. The Z
+   bounds are used to compute the UV coordinates for the plume, with V
    increasing towards -Z.
+
+ * plumeColor alpha currently unused, but later will control maximum opacity.
+   It's nontrivial because even if the exhaust overall is very thin,
+   that doesn't mean the exhaust will be dim at the nozzle
 */
-layout(location = 3) uniform float topZ;
-layout(location = 4) uniform float bottomZ;
+flat in vec4 plumeParams;
+flat in vec4 plumeColor;
+
+layout(location = 0, index = 0) out vec4 color;
 
 layout(location = 5) uniform sampler2D nozzleNoiseTex;
 layout(location = 6) uniform sampler2D combustionNoiseTex;
 
-/* Alpha currently unused, but later will control maximum opacity.
-   It's nontrivial because even if the exhaust overall is very thin,
-   that doesn't mean the exhaust will be dim at the nozzle
- */
-layout(location = 7) uniform vec4 baseColor;
-
-layout(location = 8) uniform float flowVelocity;
 layout(location = 9) uniform float time;
 
-// Engine power, which is the primary influence on plume density
-layout(location = 10) uniform float power;
-
 const float PI = 3.14159265358;
-float height = topZ - bottomZ;
-// The plume is defined to leave the nozzle at the mesh origin
-float NOZZLE_THRESHOLD = abs(topZ / height);
-
 
 /* Converts rectilinear plume coordinates to polar
  *
  * Assumes cylinderical symmetry, and that the plume is centered at the origin.
 */
-vec2 plumeCoords(vec3 rect)
+vec2 plumeCoords(vec3 rect, float topZ, float height)
 {
     float x = rect.x;
     float y = rect.y;
@@ -84,7 +76,7 @@ vec2 plumeCoords(vec3 rect)
 }
 
 // Offset UV by time uniform and wrap
-vec2 scrollUV(vec2 UV)
+vec2 scrollUV(vec2 UV, float flowVelocity)
 {
     float tmpI;
     float scrollFac = modf(UV.y - time*flowVelocity, tmpI);
@@ -94,8 +86,16 @@ vec2 scrollUV(vec2 UV)
 
 void main()
 {
+    float power = plumeParams.x;
+    float flowVelocity = plumeParams.y;
+    float topZ = plumeParams.z;
+    float height = plumeParams.z - plumeParams.w;
+
+    // The plume is defined to leave the nozzle at the mesh origin
+    float NOZZLE_THRESHOLD = abs(topZ / height);
+
     // Generate cylinderical UVs from modelspace position of fragment
-    vec2 polarUV  = plumeCoords(fragPos);
+    vec2 polarUV  = plumeCoords(fragPos, topZ, height);
 
     /* Position Factors
 
@@ -115,14 +115,14 @@ void main()
        and any opacity.
      * The combustion noise is used to simulate fluctuations in the exhaust
        caused by combustion instability. This effect scrolls down the length
-       of the plume at a rate designated by the flowVelocity uniform.
+       of the plume at a rate designated by the flowVelocity parameter.
      * The nozzle noise is used to simulate imperfections in the exhaust caused
        by variances in the nozzle construction. Imperfections in the nozzle
        result in azimuthal differences in plume density which remain static
        throughout the burn.
     */
     float nozzleValue = 1.0 - 0.2*texture(nozzleNoiseTex, vec2(polarUV.x, 0)).r;
-    float combustValue = texture(combustionNoiseTex, scrollUV(polarUV)).r;
+    float combustValue = texture(combustionNoiseTex, scrollUV(polarUV, flowVelocity)).r;
 
     /* Effect fade
 
@@ -157,6 +157,6 @@ void main()
     // Square the magnitude of the fluctuation
     plumeDensity *= plumeDensity;
 
-    color = vec4(vec3(baseColor), plumeDensity);
+    color = vec4(vec3(plumeColor), plumeDensity);
 }
 
@@ -25,22 +25,36 @@
  //#version 430 core
 
 layout(location = 0) in vec4 vertPosition;
-layout(location = 1) in vec2 vertTexCoords;
-layout(location = 5) in vec3 vertNormal;
 
-out vec3 normal;
-out vec3 fragPos;
+// One per plume, indexed by instance. Must match adera::shader::PlumeInstanceGL
+struct PlumeInstance
+{
+    mat4 modelViewMat;
+    vec4 params;        // power, flowVelocity, topZ, bottomZ
+    vec4 color;
+};
+
+layout(std430, binding = 0) readonly buffer PlumeInstances
+{
+    PlumeInstance instances[];
+};
 
 layout(location = 0) uniform mat4 projMat;
-layout(location = 1) uniform mat4 modelTransformMat;
-layout(location = 2) uniform mat3 normalMat;
+layout(location = 1) uniform int instanceOffset;
+
+out vec3 fragPos;
+flat out vec4 plumeParams;
+flat out vec4 plumeColor;
 
 void main()
 {
-    gl_Position = projMat * modelTransformMat * vertPosition;
-    normal = normalMat * vertNormal;
+    PlumeInstance inst = instances[instanceOffset + gl_InstanceID];
+
+    gl_Position = projMat * (inst.modelViewMat * vertPosition);
 
     // Send vert position to frag shader for UV calculation
     fragPos = vec3(vertPosition);
-}
 
+    plumeParams = inst.params;
+    plumeColor = inst.color;
+}
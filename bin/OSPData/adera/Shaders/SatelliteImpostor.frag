@@ -0,0 +1,64 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+ //#version 430 core
+
+// Ray-traced sphere within a camera-facing quad, see SatelliteImpostor.vert. Satellites shown
+// larger than their actual size are drawn as flat-lit discs.
+
+in vec2 fragQuad;
+flat in vec3 fragCenter;
+flat in float fragRadius;
+flat in float fragHalfSize;
+flat in vec4 fragColor;
+
+layout(location = 0, index = 0) out vec4 color;
+
+layout(location = 0) uniform mat4 projMat;
+layout(location = 4) uniform vec3 lightDir;     // view space, towards the light
+layout(location = 5) uniform float ambient;
+
+void main()
+{
+    float d2 = dot(fragQuad, fragQuad);
+    if (d2 > 1.0)
+    {
+        discard;
+    }
+
+    // Fraction of the quad covered by the actual sphere
+    float sphereFrac = fragRadius / fragHalfSize;
+
+    vec3 normal = vec3(fragQuad, sqrt(1.0 - d2));
+    vec3 surface = fragCenter + vec3(fragQuad * fragHalfSize, normal.z * fragRadius);
+
+    // Lit like a sphere up close, blending into a flat dot as it shrinks below minPixels
+    float diffuse = max(dot(normal, lightDir), 0.0);
+    float shade = mix(1.0, ambient + (1.0 - ambient) * diffuse, sphereFrac);
+
+    color = vec4(fragColor.rgb * shade, fragColor.a);
+
+    vec4 clip = projMat * vec4(surface, 1.0);
+    gl_FragDepth = (clip.z / clip.w) * 0.5 + 0.5;
+}
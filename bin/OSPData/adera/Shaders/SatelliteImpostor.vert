@@ -0,0 +1,78 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+ //#version 430 core
+
+// Camera-facing quad per satellite, generated from gl_VertexID with no vertex attributes. Far
+// satellites are kept at least minPixels wide so they don't flicker or vanish, see
+// adera::shader::SatelliteShader
+
+// One per satellite, indexed by instance. Must match adera::shader::SatelliteInstanceGL
+struct SatInstance
+{
+    vec4 posRadius;     // camera-relative position, radius
+    vec4 color;
+};
+
+layout(std430, binding = 0) readonly buffer SatInstances
+{
+    SatInstance instances[];
+};
+
+layout(location = 0) uniform mat4 projMat;
+layout(location = 1) uniform mat4 viewRotMat;
+layout(location = 2) uniform float pixelScale;  // pixels per unit at distance 1
+layout(location = 3) uniform float minPixels;
+
+out vec2 fragQuad;
+flat out vec3 fragCenter;
+flat out float fragRadius;
+flat out float fragHalfSize;
+flat out vec4 fragColor;
+
+void main()
+{
+    SatInstance inst = instances[gl_InstanceID];
+
+    vec3 center = (viewRotMat * vec4(inst.posRadius.xyz, 1.0)).xyz;
+    float radius = inst.posRadius.w;
+
+    // Grow the quad past the sphere once it's fewer than minPixels on screen
+    float dist = max(-center.z, 0.0);
+    float halfSize = max(radius, 0.5 * minPixels * dist / pixelScale);
+
+    // Triangle strip corners: (-1,-1), (1,-1), (-1,1), (1,1)
+    vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1)) * 2.0 - 1.0;
+
+    // Move the quad in front of the sphere, so it isn't clipped by its own surface
+    vec3 pos = center + vec3(corner * halfSize, radius);
+
+    gl_Position = projMat * vec4(pos, 1.0);
+
+    fragQuad = corner;
+    fragCenter = center;
+    fragRadius = radius;
+    fragHalfSize = halfSize;
+    fragColor = inst.color;
+}
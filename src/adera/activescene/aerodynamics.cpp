@@ -0,0 +1,301 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "aerodynamics.h"
+
+#include <osp/activescene/basic_fn.h>
+
+#include <Magnum/Math/Functions.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+using namespace osp;
+using namespace osp::active;
+
+namespace adera
+{
+
+// Parts are evaluated this many at a time with independent accumulators, enough for the
+// compiler to keep each one in its own SIMD lane without reassociating float adds
+constexpr std::size_t gc_aeroLanes = 8;
+
+// A box counts as a flat surface if its thinnest side is this much smaller than the others
+constexpr float gc_plateRatio = 0.2f;
+
+// Thin airfoil lift slope, per radian
+constexpr float gc_liftSlope = 2.0f * Magnum::Math::Constants<float>::pi();
+
+/**
+ * @brief Drag coefficient of a shape, relative to the area of its bounding box's sides
+ */
+static float shape_drag_factor(EShape const shape) noexcept
+{
+    switch (shape)
+    {
+    case EShape::Box:
+        return 1.05f;
+    case EShape::Sphere:
+        // Cd 0.47 of a circle inscribed in the square
+        return 0.47f * Magnum::Math::Constants<float>::pi() / 4.0f;
+    case EShape::Capsule:
+        return 0.6f;
+    case EShape::Cylinder:
+    case EShape::Custom:
+    default:
+        return 0.8f;
+    }
+}
+
+struct AeroPartBuilder
+{
+    AeroPart    part;
+    Vector3     weightedPos;
+    float       weight      {0.0f};
+};
+
+static void add_collider(EShape const shape, Matrix4 const& tf, AeroPartBuilder& rOut) noexcept
+{
+    // Shapes are 2 units wide by default
+    Vector3 const       halfExtents = tf.scaling();
+    float   const       factor      = shape_drag_factor(shape);
+    Matrix3 const       rotation    = tf.rotation();
+
+    std::array<float, 3> const sideArea
+    {
+        4.0f * halfExtents.y() * halfExtents.z(),
+        4.0f * halfExtents.x() * halfExtents.z(),
+        4.0f * halfExtents.x() * halfExtents.y()
+    };
+
+    // dragArea += R * diag(factor * sideArea) * R^T
+    for (int k = 0; k < 3; ++k)
+    {
+        Vector3 const axis = rotation[k];
+        float   const area = factor * sideArea[k];
+        for (int i = 0; i < 3; ++i)
+        {
+            for (int j = 0; j < 3; ++j)
+            {
+                rOut.part.dragArea[i][j] += area * axis[i] * axis[j];
+            }
+        }
+    }
+
+    float const totalArea = sideArea[0] + sideArea[1] + sideArea[2];
+    rOut.weightedPos += tf.translation() * totalArea;
+    rOut.weight      += totalArea;
+
+    if (shape != EShape::Box)
+    {
+        return;
+    }
+
+    int const thin = int(std::min_element(halfExtents.data(), halfExtents.data() + 3) - halfExtents.data());
+    float const thickness = halfExtents[thin];
+    float const nextThinnest = std::min(halfExtents[(thin + 1) % 3], halfExtents[(thin + 2) % 3]);
+
+    if (thickness < gc_plateRatio * nextThinnest && sideArea[thin] > rOut.part.liftArea / gc_liftSlope)
+    {
+        rOut.part.liftNormal = rotation[thin];
+        rOut.part.liftArea   = sideArea[thin] * gc_liftSlope;
+    }
+}
+
+static void add_colliders_recurse(
+        ACtxBasic const&    rBasic,
+        ACtxPhysics const&  rPhys,
+        ActiveEnt const     ent,
+        Matrix4 const&      tf,
+        AeroPartBuilder&    rOut) noexcept
+{
+    if (ent.value < rPhys.m_shape.size() && rPhys.m_shape[ent] != EShape::None)
+    {
+        add_collider(rPhys.m_shape[ent], tf, rOut);
+    }
+
+    if ( ! rPhys.m_hasColliders.contains(ent) )
+    {
+        return;
+    }
+
+    for (ActiveEnt const child : SysSceneGraph::children(rBasic.m_scnGraph, ent))
+    {
+        if (rBasic.m_transform.contains(child))
+        {
+            add_colliders_recurse(rBasic, rPhys, child, tf * rBasic.m_transform.get(child).m_transform, rOut);
+        }
+    }
+}
+
+AeroPart SysAero::part_surface(
+        ACtxBasic const&        rBasic,
+        ACtxPhysics const&      rPhys,
+        ActiveEnt const         partEnt,
+        Matrix4 const&          partTransformWeld)
+{
+    AeroPartBuilder builder;
+
+    add_colliders_recurse(rBasic, rPhys, partEnt, partTransformWeld, builder);
+
+    builder.part.position = (builder.weight > 0.0f)
+                          ? builder.weightedPos / builder.weight
+                          : partTransformWeld.translation();
+    return builder.part;
+}
+
+void AeroSurfaces::clear() noexcept
+{
+    for (std::vector<float>* pVec : {&posX, &posY, &posZ,
+                                     &dragXX, &dragYY, &dragZZ, &dragXY, &dragXZ, &dragYZ,
+                                     &liftX, &liftY, &liftZ, &liftArea})
+    {
+        pVec->clear();
+    }
+}
+
+void AeroSurfaces::push_back(AeroPart const& part)
+{
+    posX    .push_back(part.position.x());
+    posY    .push_back(part.position.y());
+    posZ    .push_back(part.position.z());
+    dragXX  .push_back(part.dragArea[0][0]);
+    dragYY  .push_back(part.dragArea[1][1]);
+    dragZZ  .push_back(part.dragArea[2][2]);
+    dragXY  .push_back(part.dragArea[0][1]);
+    dragXZ  .push_back(part.dragArea[0][2]);
+    dragYZ  .push_back(part.dragArea[1][2]);
+    liftX   .push_back(part.liftNormal.x());
+    liftY   .push_back(part.liftNormal.y());
+    liftZ   .push_back(part.liftNormal.z());
+    liftArea.push_back(part.liftArea);
+}
+
+namespace
+{
+
+struct AeroLanes
+{
+    std::array<float, gc_aeroLanes> fx{}, fy{}, fz{};
+    std::array<float, gc_aeroLanes> tx{}, ty{}, tz{};
+};
+
+} // namespace
+
+/**
+ * @brief Force and torque of part i, accumulated into lane l
+ */
+static inline void part_force(
+        AeroSurfaces const&     s,
+        std::size_t const       i,
+        std::size_t const       l,
+        AeroFlow const&         flow,
+        float const             halfRho,
+        AeroLanes&              rOut) noexcept
+{
+    float const rx = s.posX[i] - flow.centerOfMass.x();
+    float const ry = s.posY[i] - flow.centerOfMass.y();
+    float const rz = s.posZ[i] - flow.centerOfMass.z();
+
+    Vector3 const& w = flow.angularVelocity;
+
+    // Part velocity through the air: v + w x r
+    float const vx = flow.velocity.x() + (w.y() * rz - w.z() * ry);
+    float const vy = flow.velocity.y() + (w.z() * rx - w.x() * rz);
+    float const vz = flow.velocity.z() + (w.x() * ry - w.y() * rx);
+
+    float const speedSq  = vx * vx + vy * vy + vz * vz;
+    float const speed    = std::sqrt(speedSq);
+    float const invSpeed = (speedSq > 1e-12f) ? (1.0f / speed) : 0.0f;
+
+    // Drag: -1/2 rho (v^T A v) / |v| * v
+    float const avx = s.dragXX[i] * vx + s.dragXY[i] * vy + s.dragXZ[i] * vz;
+    float const avy = s.dragXY[i] * vx + s.dragYY[i] * vy + s.dragYZ[i] * vz;
+    float const avz = s.dragXZ[i] * vx + s.dragYZ[i] * vy + s.dragZZ[i] * vz;
+    float const drag = -halfRho * (vx * avx + vy * avy + vz * avz) * invSpeed;
+
+    // Flat plate: -1/2 rho |v|^2 liftArea sin(a) cos(a) along the normal
+    float const vn      = vx * s.liftX[i] + vy * s.liftY[i] + vz * s.liftZ[i];
+    float const sinA    = vn * invSpeed;
+    float const cosA    = std::sqrt(std::max(0.0f, 1.0f - sinA * sinA));
+    float const normal  = -halfRho * s.liftArea[i] * vn * speed * cosA;
+
+    float const fx = drag * vx + normal * s.liftX[i];
+    float const fy = drag * vy + normal * s.liftY[i];
+    float const fz = drag * vz + normal * s.liftZ[i];
+
+    rOut.fx[l] += fx;
+    rOut.fy[l] += fy;
+    rOut.fz[l] += fz;
+    rOut.tx[l] += ry * fz - rz * fy;
+    rOut.ty[l] += rz * fx - rx * fz;
+    rOut.tz[l] += rx * fy - ry * fx;
+}
+
+void SysAero::forces(
+        AeroSurfaces const&     surfaces,
+        std::size_t const       first,
+        std::size_t const       count,
+        AeroFlow const&         flow,
+        Vector3&                rForce,
+        Vector3&                rTorque) noexcept
+{
+    float const halfRho = 0.5f * flow.density;
+    std::size_t const last = first + count;
+
+    AeroLanes lanes;
+
+    std::size_t i = first;
+    for (; i + gc_aeroLanes <= last; i += gc_aeroLanes)
+    {
+        for (std::size_t l = 0; l < gc_aeroLanes; ++l)
+        {
+            part_force(surfaces, i + l, l, flow, halfRho, lanes);
+        }
+    }
+    for (; i < last; ++i)
+    {
+        part_force(surfaces, i, (i - first) % gc_aeroLanes, flow, halfRho, lanes);
+    }
+
+    for (std::size_t l = 0; l < gc_aeroLanes; ++l)
+    {
+        rForce  += Vector3{lanes.fx[l], lanes.fy[l], lanes.fz[l]};
+        rTorque += Vector3{lanes.tx[l], lanes.ty[l], lanes.tz[l]};
+    }
+}
+
+float SysAero::density(AeroAtmosphere const& atmo, Vector3 const position) noexcept
+{
+    Vector3 const relative = position - atmo.center;
+
+    float const altitude = (atmo.radius > 0.0f)
+                         ? relative.length() - atmo.radius
+                         : Magnum::Math::dot(relative, atmo.up);
+
+    return atmo.seaLevelDensity * std::exp(-std::max(altitude, 0.0f) / atmo.scaleHeight);
+}
+
+} // namespace adera
@@ -0,0 +1,153 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include <osp/activescene/basic.h>
+#include <osp/activescene/physics.h>
+#include <osp/core/math_types.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace adera
+{
+
+/**
+ * @brief Aerodynamic properties of a single part, relative to the weld it's part of
+ *
+ * Computed once per weld change from the part's colliders, see SysAero::part_surface.
+ */
+struct AeroPart
+{
+    /// Area-weighted center of the part's colliders
+    osp::Vector3    position;
+
+    /// Symmetric tensor of drag coefficient times projected area (m^2). Drag along a flow
+    /// direction d is proportional to dot(d, dragArea * d).
+    osp::Matrix3    dragArea        {0.0f};
+
+    /// Unit normal of the part's largest flat surface, zero if it has none
+    osp::Vector3    liftNormal;
+
+    /// Lift curve slope times the flat surface's area (m^2)
+    float           liftArea        {0.0f};
+};
+
+/**
+ * @brief AeroParts of many bodies laid out as structure of arrays
+ *
+ * Each body's parts are contiguous, so a whole body is evaluated by a single SysAero::forces call
+ * without gathering.
+ */
+struct AeroSurfaces
+{
+    void clear() noexcept;
+    void push_back(AeroPart const& part);
+
+    [[nodiscard]] std::size_t size() const noexcept { return posX.size(); }
+
+    std::vector<float> posX, posY, posZ;
+    std::vector<float> dragXX, dragYY, dragZZ, dragXY, dragXZ, dragYZ;
+    std::vector<float> liftX, liftY, liftZ, liftArea;
+};
+
+/**
+ * @brief Air around a single body, in the body's local space
+ */
+struct AeroFlow
+{
+    /// Velocity of the center of mass relative to the surrounding air
+    osp::Vector3    velocity;
+    osp::Vector3    angularVelocity;
+    osp::Vector3    centerOfMass;
+    float           density;
+};
+
+/**
+ * @brief Exponential atmosphere, either flat along an up axis or around a spherical planet
+ */
+struct AeroAtmosphere
+{
+    float           seaLevelDensity     {1.225f};
+    float           scaleHeight         {8500.0f};
+
+    /// Planet radius, 0 for a flat atmosphere with sea level at dot(position, up) == 0
+    float           radius              {0.0f};
+    osp::Vector3    center;
+    osp::Vector3    up                  {0.0f, 0.0f, 1.0f};
+
+    /// Air moving at this velocity exerts no drag
+    osp::Vector3    wind;
+};
+
+class SysAero
+{
+    using ACtxBasic     = osp::active::ACtxBasic;
+    using ACtxPhysics   = osp::active::ACtxPhysics;
+    using ActiveEnt     = osp::active::ActiveEnt;
+
+public:
+
+    /**
+     * @brief Compute the aerodynamic surface of a part from the colliders in its subtree
+     *
+     * Colliders are approximated by their scaled bounding boxes. Each contributes a drag area
+     * along its three axes, and boxes much thinner along one axis count as flat lifting surfaces.
+     * Shielding between neighbouring parts is not considered.
+     *
+     * @param partEnt           Part's root entity
+     * @param partTransformWeld Part's transform relative to its weld, from ACtxParts
+     */
+    [[nodiscard]] static AeroPart part_surface(
+            ACtxBasic const&        rBasic,
+            ACtxPhysics const&      rPhys,
+            ActiveEnt               partEnt,
+            osp::Matrix4 const&     partTransformWeld);
+
+    /**
+     * @brief Evaluate drag and lift of a range of parts belonging to the same body
+     *
+     * Each part sees the body's velocity plus rotation at its position. Flat surfaces give a
+     * thin plate normal force of liftArea * sin(a) * cos(a), covering both lift and induced drag.
+     *
+     * @param rForce    [out] Body-space force is added to this
+     * @param rTorque   [out] Body-space torque around the center of mass is added to this
+     */
+    static void forces(
+            AeroSurfaces const&     surfaces,
+            std::size_t             first,
+            std::size_t             count,
+            AeroFlow const&         flow,
+            osp::Vector3&           rForce,
+            osp::Vector3&           rTorque) noexcept;
+
+    /**
+     * @return Air density (kg/m^3) at a scene-space position
+     */
+    [[nodiscard]] static float density(AeroAtmosphere const& atmo, osp::Vector3 position) noexcept;
+
+}; // class SysAero
+
+} // namespace adera
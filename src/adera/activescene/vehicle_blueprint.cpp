@@ -0,0 +1,272 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "vehicle_blueprint.h"
+
+#include <osp/activescene/scene_save.h>
+#include <osp/core/byte_stream_tables.h>
+#include <osp/core/Resources.h>
+#include <osp/link/signal.h>
+#include <osp/util/logging.h>
+
+#include <Corrade/Containers/ArrayViewStl.h>
+
+#include <type_traits>
+
+using namespace osp;
+using namespace osp::link;
+
+using osp::active::SysSceneSave;
+
+namespace adera
+{
+
+namespace
+{
+
+constexpr std::uint32_t gc_blueprintMagic   = 0x5650534F; // "OSPV"
+constexpr std::uint32_t gc_blueprintVersion = 1;
+
+/**
+ * @brief Call func with a std::type_identity of the signal value type of nodeType
+ *
+ * @return false if nodeType isn't a signal type, see osp::link::SignalType
+ */
+template <typename FUNC_T>
+bool visit_signal_type(NodeTypeId const nodeType, FUNC_T&& func)
+{
+    auto const visit = [nodeType, &func] (auto const tag) -> bool
+    {
+        using Value_t = typename decltype(tag)::type;
+        if (nodeType != SignalType<Value_t>::node_type())
+        {
+            return false;
+        }
+        func(tag);
+        return true;
+    };
+
+    return    visit(std::type_identity<float>{})
+           || visit(std::type_identity<int32_t>{})
+           || visit(std::type_identity<SigMask_t>{})
+           || visit(std::type_identity<Vector3>{});
+}
+
+} // namespace
+
+std::vector<std::byte> SysVehicleBlueprint::save(VehicleData const& data, Resources const& resources)
+{
+    std::vector<std::byte> out;
+
+    append_bytes(out, gc_blueprintMagic);
+    append_bytes(out, gc_blueprintVersion);
+
+    // Parts and welds
+
+    save_ids        (out, data.m_partIds);
+    save_array      (out, data.m_partTransformWeld);
+    save_array      (out, data.m_partToWeld);
+    save_multimap   (out, data.m_partToMachines, data.m_partIds);
+
+    save_ids        (out, data.m_weldIds);
+    save_multimap   (out, data.m_weldToParts, data.m_weldIds);
+
+    // Machines
+
+    Machines const &machines = data.m_machines;
+    save_ids        (out, machines.ids);
+    save_array      (out, machines.machTypes);
+    save_array      (out, machines.machToLocal);
+    save_array      (out, data.m_machToPart);
+
+    append_bytes(out, static_cast<std::uint32_t>(machines.perType.size()));
+    for (PerMachType const& perType : machines.perType)
+    {
+        save_ids    (out, perType.localIds);
+        save_array  (out, perType.localToAny);
+    }
+
+    // Nodes
+
+    append_bytes(out, static_cast<std::uint32_t>(data.m_nodePerType.size()));
+    for (NodeTypeId nodeType = 0; std::size_t(nodeType) < data.m_nodePerType.size(); ++nodeType)
+    {
+        PerNodeType const &perNodeType = data.m_nodePerType[nodeType];
+
+        save_ids        (out, perNodeType.nodeIds);
+        save_multimap   (out, perNodeType.nodeToMach,           perNodeType.nodeIds);
+        save_multimap   (out, perNodeType.machToNode,           machines.ids);
+        save_multimap   (out, perNodeType.m_machToNodeCustom,   machines.ids);
+        save_array      (out, perNodeType.m_nodeConnectCount);
+        append_bytes    (out, static_cast<std::int32_t>(perNodeType.m_connectCountTotal));
+
+        bool hasValues = false;
+        if (perNodeType.m_nodeValues)
+        {
+            hasValues = visit_signal_type(nodeType, [] (auto) { });
+            if ( ! hasValues )
+            {
+                OSP_LOG_WARN("Node type {} has values that can't be saved to a blueprint", nodeType);
+            }
+        }
+
+        append_bytes(out, static_cast<std::uint8_t>(hasValues));
+        if (hasValues)
+        {
+            visit_signal_type(nodeType, [&out, &perNodeType] (auto const tag)
+            {
+                using Value_t = typename decltype(tag)::type;
+                save_array(out, entt::any_cast<SignalValues_t<Value_t> const&>(perNodeType.m_nodeValues));
+            });
+        }
+    }
+
+    // Prefabs, as indices into a table of unique prefabs. Importers are saved by name.
+
+    SysSceneSave::save_prefabs(out, arrayView(data.m_partPrefabs), data.m_partIds, resources);
+
+    return out;
+}
+
+std::optional<VehicleData> SysVehicleBlueprint::load(
+        ArrayView<std::byte const>  blob,
+        Resources&                  rResources,
+        PkgId const                 pkg)
+{
+    ByteReader reader{blob};
+
+    std::uint32_t magic;
+    std::uint32_t version;
+    if (   ! reader.read(magic)   || magic   != gc_blueprintMagic
+        || ! reader.read(version) || version != gc_blueprintVersion )
+    {
+        return std::nullopt;
+    }
+
+    VehicleData out;
+
+    // Parts and welds
+
+    std::uint32_t partCapacity;
+    std::uint32_t weldCapacity;
+    if (   ! load_ids       (reader, out.m_partIds, partCapacity)
+        || ! load_array     (reader, out.m_partTransformWeld)
+        || ! load_array     (reader, out.m_partToWeld)
+        || ! load_multimap  (reader, out.m_partToMachines, partCapacity)
+        || ! load_ids       (reader, out.m_weldIds, weldCapacity)
+        || ! load_multimap  (reader, out.m_weldToParts, weldCapacity)
+        || out.m_partTransformWeld.size()   < partCapacity
+        || out.m_partToWeld.size()          < partCapacity )
+    {
+        return std::nullopt;
+    }
+
+    // Machines
+
+    Machines &rMachines = out.m_machines;
+
+    std::uint32_t machCapacity;
+    std::uint32_t machTypeCount;
+    if (   ! load_ids   (reader, rMachines.ids, machCapacity)
+        || ! load_array (reader, rMachines.machTypes)
+        || ! load_array (reader, rMachines.machToLocal)
+        || ! load_array (reader, out.m_machToPart)
+        || ! reader.read(machTypeCount)
+        || machTypeCount != MachTypeReg_t::size()
+        || rMachines.machTypes.size()   < machCapacity
+        || rMachines.machToLocal.size() < machCapacity
+        || out.m_machToPart.size()      < machCapacity )
+    {
+        return std::nullopt;
+    }
+
+    rMachines.perType.resize(machTypeCount);
+    for (PerMachType &rPerType : rMachines.perType)
+    {
+        std::uint32_t localCapacity;
+        if (   ! load_ids   (reader, rPerType.localIds, localCapacity)
+            || ! load_array (reader, rPerType.localToAny)
+            || rPerType.localToAny.size() < localCapacity )
+        {
+            return std::nullopt;
+        }
+    }
+
+    // Nodes
+
+    std::uint32_t nodeTypeCount;
+    if ( ! reader.read(nodeTypeCount) || nodeTypeCount != NodeTypeReg_t::size() )
+    {
+        return std::nullopt;
+    }
+
+    out.m_nodePerType.resize(nodeTypeCount);
+    for (NodeTypeId nodeType = 0; nodeType < nodeTypeCount; ++nodeType)
+    {
+        PerNodeType &rPerNodeType = out.m_nodePerType[nodeType];
+
+        std::uint32_t   nodeCapacity;
+        std::int32_t    connectCountTotal;
+        std::uint8_t    hasValues;
+        if (   ! load_ids       (reader, rPerNodeType.nodeIds, nodeCapacity)
+            || ! load_multimap  (reader, rPerNodeType.nodeToMach,         nodeCapacity)
+            || ! load_multimap  (reader, rPerNodeType.machToNode,         machCapacity)
+            || ! load_multimap  (reader, rPerNodeType.m_machToNodeCustom, machCapacity)
+            || ! load_array     (reader, rPerNodeType.m_nodeConnectCount)
+            || ! reader.read(connectCountTotal)
+            || ! reader.read(hasValues) )
+        {
+            return std::nullopt;
+        }
+        rPerNodeType.m_connectCountTotal = connectCountTotal;
+
+        if (hasValues != 0)
+        {
+            bool loaded = false;
+            visit_signal_type(nodeType, [&reader, &rPerNodeType, &loaded] (auto const tag)
+            {
+                using Values_t = SignalValues_t<typename decltype(tag)::type>;
+                rPerNodeType.m_nodeValues.emplace<Values_t>();
+                loaded = load_array(reader, entt::any_cast<Values_t&>(rPerNodeType.m_nodeValues));
+            });
+
+            if ( ! loaded )
+            {
+                return std::nullopt;
+            }
+        }
+    }
+
+    // Prefabs
+
+    out.m_partPrefabs.resize(partCapacity);
+    if ( ! SysSceneSave::load_prefabs(reader, arrayView(out.m_partPrefabs), out.m_partIds, rResources, pkg) )
+    {
+        return std::nullopt;
+    }
+
+    return out;
+}
+
+} // namespace adera
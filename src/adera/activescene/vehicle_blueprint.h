@@ -0,0 +1,71 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "VehicleBuilder.h"
+
+#include <osp/core/array_view.h>
+#include <osp/core/resourcetypes.h>
+
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+namespace adera
+{
+
+/**
+ * @brief Saves and loads VehicleData as a flat binary blueprint
+ *
+ * A blueprint stores everything VehicleBuilder resolved at build time: prefabs as indices into
+ * a table of unique (importer, prefab) pairs, weld transforms, and the machine and node tables.
+ * Every table is written as a count followed by its raw elements, with IDs kept as-is, so there
+ * are no pointers to fix up and loading is one linear pass of memcpys. Importer lookups by name
+ * happen once per unique importer instead of once per part.
+ *
+ * Blobs are written in native byte order and rely on machine and node type IDs, which are
+ * assigned at startup. Like physics snapshots, they're only meant to be read by the same build.
+ */
+class SysVehicleBlueprint
+{
+public:
+    [[nodiscard]] static std::vector<std::byte> save(VehicleData const& data, osp::Resources const& resources);
+
+    /**
+     * @brief Load a blob written by save
+     *
+     * The blob can be any memory, such as a memory-mapped file; nothing in it needs to be
+     * aligned. Importers are looked up by name in pkg, parts of importers that aren't found stay
+     * without a prefab.
+     *
+     * @return VehicleData owning references to its importers, or empty if the blob is invalid
+     */
+    [[nodiscard]] static std::optional<VehicleData> load(
+            osp::ArrayView<std::byte const>     blob,
+            osp::Resources&                     rResources,
+            osp::PkgId                          pkg);
+};
+
+} // namespace adera
@@ -0,0 +1,422 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "vehicle_handoff.h"
+
+#include <osp/core/Resources.h>
+
+#include <longeron/id_management/id_set_stl.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+using namespace osp;
+using namespace osp::active;
+using namespace osp::link;
+
+using osp::restypes::gc_importer;
+
+namespace adera
+{
+
+VehicleData SysVehicleHandoff::extract_weld(
+        ACtxParts const&                rScnParts,
+        SignalValues_t<float> const&    sigValFloat,
+        Resources&                      rResources,
+        WeldId const                    weld)
+{
+    VehicleData out;
+    out.m_machines.perType.resize(MachTypeReg_t::size());
+    out.m_nodePerType.resize(NodeTypeReg_t::size());
+
+    auto const          srcParts    = rScnParts.weldToParts[weld];
+    std::size_t const   partCount   = srcParts.size();
+
+    // Parts and the weld
+
+    WeldId const dstWeld = out.m_weldIds.create();
+
+    out.m_weldToParts.ids_reserve(out.m_weldIds.capacity());
+    out.m_weldToParts.data_reserve(partCount);
+    PartId *pDstWeldParts = out.m_weldToParts.emplace(dstWeld, partCount);
+
+    out.m_partTransformWeld .resize(partCount);
+    out.m_partPrefabs       .resize(partCount);
+    out.m_partToWeld        .resize(partCount, dstWeld);
+
+    std::size_t machCount = 0;
+    for (std::size_t i = 0; i < partCount; ++i)
+    {
+        PartId const srcPart = srcParts[i];
+        PartId const dstPart = out.m_partIds.create();
+        pDstWeldParts[i] = dstPart;
+
+        out.m_partTransformWeld[dstPart] = rScnParts.partTransformWeld[srcPart];
+
+        PrefabPair const &srcPrefab = rScnParts.partPrefabs[srcPart];
+        if (srcPrefab.m_importer.has_value())
+        {
+            out.m_partPrefabs[dstPart] = PrefabPair{rResources.owner_create(gc_importer, srcPrefab.m_importer), srcPrefab.m_prefabId};
+        }
+
+        if (rScnParts.partToMachines.contains(srcPart))
+        {
+            machCount += rScnParts.partToMachines[srcPart].size();
+        }
+    }
+
+    // Machines, local IDs are created one at a time as parts can mix machine types
+
+    Machines const  &srcMachines = rScnParts.machines;
+    Machines        &rDstMachines = out.m_machines;
+
+    std::vector<MachAnyId> dstToSrcMach;
+    dstToSrcMach.reserve(machCount);
+    std::vector<MachAnyId> srcToDstMach(srcMachines.ids.capacity(), lgrn::id_null<MachAnyId>());
+
+    rDstMachines.machTypes  .resize(machCount);
+    rDstMachines.machToLocal.resize(machCount);
+    out.m_machToPart        .resize(machCount);
+
+    out.m_partToMachines.ids_reserve(out.m_partIds.capacity());
+    out.m_partToMachines.data_reserve(machCount);
+
+    for (std::size_t i = 0; i < partCount; ++i)
+    {
+        PartId const srcPart = srcParts[i];
+        PartId const dstPart = pDstWeldParts[i];
+
+        if ( ! rScnParts.partToMachines.contains(srcPart) )
+        {
+            out.m_partToMachines.emplace(dstPart, 0);
+            continue;
+        }
+
+        auto const  srcPairs  = rScnParts.partToMachines[srcPart];
+        MachinePair *pDstPair = out.m_partToMachines.emplace(dstPart, srcPairs.size());
+
+        for (MachinePair const srcPair : srcPairs)
+        {
+            MachAnyId const     srcMach     = srcMachines.perType[srcPair.type].localToAny[srcPair.local];
+            MachAnyId const     dstMach     = rDstMachines.ids.create();
+            PerMachType         &rDstType   = rDstMachines.perType[srcPair.type];
+            MachLocalId const   dstLocal    = rDstType.localIds.create();
+
+            rDstType.localToAny.resize(rDstType.localIds.capacity(), lgrn::id_null<MachAnyId>());
+            rDstType.localToAny[dstLocal]       = dstMach;
+            rDstMachines.machTypes[dstMach]     = srcPair.type;
+            rDstMachines.machToLocal[dstMach]   = dstLocal;
+            out.m_machToPart[dstMach]           = dstPart;
+
+            srcToDstMach[srcMach] = dstMach;
+            dstToSrcMach.push_back(srcMach);
+
+            *pDstPair = { .local = dstLocal, .type = srcPair.type };
+            ++pDstPair;
+        }
+    }
+
+    // Nodes connected to the weld's machines, in order of first connection
+
+    for (NodeTypeId nodeType = 0; std::size_t(nodeType) < out.m_nodePerType.size(); ++nodeType)
+    {
+        Nodes const     &srcNodes   = rScnParts.nodePerType[nodeType];
+        PerNodeType     &rDstNodes  = out.m_nodePerType[nodeType];
+
+        std::vector<NodeId> dstToSrcNode;
+        std::vector<NodeId> srcToDstNode(srcNodes.nodeIds.capacity(), lgrn::id_null<NodeId>());
+        std::size_t         machToNodeTotal = 0;
+
+        for (MachAnyId const srcMach : dstToSrcMach)
+        {
+            if ( ! srcNodes.machToNode.contains(srcMach) )
+            {
+                continue;
+            }
+            auto const srcPorts = srcNodes.machToNode[srcMach];
+            machToNodeTotal += srcPorts.size();
+            for (NodeId const srcNode : srcPorts)
+            {
+                if (srcNode != lgrn::id_null<NodeId>() && srcToDstNode[srcNode] == lgrn::id_null<NodeId>())
+                {
+                    srcToDstNode[srcNode] = rDstNodes.nodeIds.create();
+                    dstToSrcNode.push_back(srcNode);
+                }
+            }
+        }
+
+        auto const is_junction_kept = [&srcMachines, &srcToDstMach] (Junction const& junc) noexcept
+        {
+            MachAnyId const srcMach = srcMachines.perType[junc.type].localToAny[junc.local];
+            return srcToDstMach[srcMach] != lgrn::id_null<MachAnyId>();
+        };
+
+        std::size_t nodeToMachTotal = 0;
+        for (NodeId const srcNode : dstToSrcNode)
+        {
+            auto const srcJunctions = srcNodes.nodeToMach[srcNode];
+            nodeToMachTotal += std::count_if(std::begin(srcJunctions), std::end(srcJunctions), is_junction_kept);
+        }
+
+        rDstNodes.nodeToMach        .ids_reserve(rDstNodes.nodeIds.capacity());
+        rDstNodes.nodeToMach        .data_reserve(nodeToMachTotal);
+        rDstNodes.machToNode        .ids_reserve(rDstMachines.ids.capacity());
+        rDstNodes.machToNode        .data_reserve(machToNodeTotal);
+        rDstNodes.m_machToNodeCustom.ids_reserve(rDstMachines.ids.capacity());
+
+        // Junctions to machines outside of the weld are dropped
+        for (std::size_t dstNodeInt = 0; dstNodeInt < dstToSrcNode.size(); ++dstNodeInt)
+        {
+            auto const srcJunctions = srcNodes.nodeToMach[dstToSrcNode[dstNodeInt]];
+            auto const keptCount    = std::size_t(std::count_if(std::begin(srcJunctions), std::end(srcJunctions), is_junction_kept));
+            Junction   *pDstJunc    = rDstNodes.nodeToMach.emplace(NodeId(dstNodeInt), keptCount);
+
+            for (Junction const& srcJunc : srcJunctions)
+            {
+                if (is_junction_kept(srcJunc))
+                {
+                    MachAnyId const srcMach = srcMachines.perType[srcJunc.type].localToAny[srcJunc.local];
+                    *pDstJunc = { .local  = rDstMachines.machToLocal[srcToDstMach[srcMach]],
+                                  .type   = srcJunc.type,
+                                  .custom = srcJunc.custom };
+                    ++pDstJunc;
+                }
+            }
+        }
+
+        for (std::size_t dstMachInt = 0; dstMachInt < dstToSrcMach.size(); ++dstMachInt)
+        {
+            MachAnyId const srcMach = dstToSrcMach[dstMachInt];
+            if ( ! srcNodes.machToNode.contains(srcMach) )
+            {
+                continue;
+            }
+            auto const srcPorts  = srcNodes.machToNode[srcMach];
+            NodeId     *pDstPort = rDstNodes.machToNode.emplace(MachAnyId(dstMachInt), srcPorts.size());
+
+            std::transform(std::begin(srcPorts), std::end(srcPorts), pDstPort,
+                           [&srcToDstNode] (NodeId const srcNode) -> NodeId
+            {
+                return (srcNode != lgrn::id_null<NodeId>()) ? srcToDstNode[srcNode] : lgrn::id_null<NodeId>();
+            });
+        }
+
+        if (nodeType == gc_ntSigFloat && ! dstToSrcNode.empty())
+        {
+            rDstNodes.m_nodeValues.emplace< SignalValues_t<float> >(dstToSrcNode.size());
+            auto &rValues = entt::any_cast< SignalValues_t<float>& >(rDstNodes.m_nodeValues);
+            for (std::size_t dstNodeInt = 0; dstNodeInt < dstToSrcNode.size(); ++dstNodeInt)
+            {
+                rValues[dstNodeInt] = sigValFloat[dstToSrcNode[dstNodeInt]];
+            }
+        }
+    }
+
+    return out;
+}
+
+void SysVehicleHandoff::remove_welds(
+        ACtxParts&                                  rScnParts,
+        MachineUpdater&                             rUpdMach,
+        Resources&                                  rResources,
+        ArrayView<WeldId const>                     welds,
+        KeyedVec<NodeTypeId, std::vector<NodeId>>&  rNodesRemovedOut)
+{
+    Machines &rMachines = rScnParts.machines;
+
+    std::vector<MachAnyId>      machs;
+    lgrn::IdSetStl<MachAnyId>   machRemoved;
+    machRemoved.resize(rMachines.ids.capacity());
+
+    // Parts and welds
+
+    for (WeldId const weld : welds)
+    {
+        for (PartId const part : rScnParts.weldToParts[weld])
+        {
+            if (rScnParts.partToMachines.contains(part))
+            {
+                for (MachinePair const pair : rScnParts.partToMachines[part])
+                {
+                    MachAnyId const mach = rMachines.perType[pair.type].localToAny[pair.local];
+                    machs.push_back(mach);
+                    machRemoved.insert(mach);
+                }
+                rScnParts.partToMachines.erase(part);
+            }
+
+            rResources.owner_destroy(gc_importer, std::move(rScnParts.partPrefabs[part].m_importer));
+
+            if (std::size_t(part) < rScnParts.partToActive.size())
+            {
+                ActiveEnt const ent = std::exchange(rScnParts.partToActive[part], lgrn::id_null<ActiveEnt>());
+                if (ent != lgrn::id_null<ActiveEnt>() && std::size_t(ent) < rScnParts.activeToPart.size())
+                {
+                    rScnParts.activeToPart[ent] = lgrn::id_null<PartId>();
+                }
+            }
+
+            rScnParts.partToWeld[part] = lgrn::id_null<WeldId>();
+            rScnParts.partIds.remove(part);
+        }
+
+        rScnParts.weldToParts.erase(weld);
+        if (std::size_t(weld) < rScnParts.weldToActive.size())
+        {
+            rScnParts.weldToActive[weld] = lgrn::id_null<ActiveEnt>();
+        }
+        rScnParts.weldIds.remove(weld);
+    }
+
+    // Nodes, done before machines as junctions are looked up through local IDs
+
+    rNodesRemovedOut.resize(rScnParts.nodePerType.size());
+
+    std::vector<NodeId>         touched;
+    std::vector<Junction>       keptJunctions;
+    std::vector<std::size_t>    keptOffsets;
+
+    for (NodeTypeId nodeType = 0; std::size_t(nodeType) < rScnParts.nodePerType.size(); ++nodeType)
+    {
+        Nodes &rNodes = rScnParts.nodePerType[nodeType];
+
+        touched.clear();
+        for (MachAnyId const mach : machs)
+        {
+            if ( ! rNodes.machToNode.contains(mach) )
+            {
+                continue;
+            }
+            for (NodeId const node : rNodes.machToNode[mach])
+            {
+                if (node != lgrn::id_null<NodeId>())
+                {
+                    touched.push_back(node);
+                }
+            }
+            rNodes.machToNode.erase(mach);
+        }
+
+        if (touched.empty())
+        {
+            continue;
+        }
+
+        std::sort(touched.begin(), touched.end());
+        touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+
+        // Junctions to keep are copied out first, as the multimap may reallocate when they're
+        // emplaced back
+        keptJunctions.clear();
+        keptOffsets.clear();
+        for (NodeId const node : touched)
+        {
+            keptOffsets.push_back(keptJunctions.size());
+            for (Junction const& junc : rNodes.nodeToMach[node])
+            {
+                if ( ! machRemoved.contains(rMachines.perType[junc.type].localToAny[junc.local]) )
+                {
+                    keptJunctions.push_back(junc);
+                }
+            }
+            rNodes.nodeToMach.erase(node);
+        }
+        keptOffsets.push_back(keptJunctions.size());
+
+        reserve_nodes(rNodes, rMachines.ids.capacity(), keptJunctions.size(), 0);
+
+        for (std::size_t i = 0; i < touched.size(); ++i)
+        {
+            NodeId const node  = touched[i];
+            auto const   first = keptJunctions.begin() + std::ptrdiff_t(keptOffsets[i]);
+            auto const   last  = keptJunctions.begin() + std::ptrdiff_t(keptOffsets[i + 1]);
+
+            if (first == last)
+            {
+                rNodes.nodeIds.remove(node);
+                rNodesRemovedOut[nodeType].push_back(node);
+            }
+            else
+            {
+                rNodes.nodeToMach.emplace(node, first, last);
+            }
+        }
+    }
+
+    // Machines
+
+    for (MachAnyId const mach : machs)
+    {
+        MachTypeId const    type    = rMachines.machTypes[mach];
+        MachLocalId const   local   = std::exchange(rMachines.machToLocal[mach], lgrn::id_null<MachLocalId>());
+        PerMachType         &rType  = rMachines.perType[type];
+
+        rType.localIds.remove(local);
+        rType.localToAny[local] = lgrn::id_null<MachAnyId>();
+        rMachines.ids.remove(mach);
+
+        if (std::size_t(mach) < rScnParts.machineToPart.size())
+        {
+            rScnParts.machineToPart[mach] = lgrn::id_null<PartId>();
+        }
+    }
+
+    // Removed machines must not be woken up, their IDs can be reused by new machines
+
+    auto const is_removed = [&machRemoved] (MachAnyId const mach) noexcept
+    {
+        return machRemoved.contains(mach);
+    };
+    auto const is_timer_removed = [&machRemoved] (MachineUpdater::WakeTimer const& timer) noexcept
+    {
+        return machRemoved.contains(timer.mach);
+    };
+
+    for (std::vector<MachAnyId> &rPending : rUpdMach.levelPending)
+    {
+        std::erase_if(rPending, is_removed);
+    }
+    for (std::vector<MachineUpdater::WakeTimer> &rRequests : rUpdMach.wakeRequests)
+    {
+        std::erase_if(rRequests, is_timer_removed);
+    }
+    if (std::erase_if(rUpdMach.wakeTimers, is_timer_removed) != 0)
+    {
+        std::make_heap(rUpdMach.wakeTimers.begin(), rUpdMach.wakeTimers.end(),
+                       std::greater<MachineUpdater::WakeTimer>{});
+    }
+
+    ++rScnParts.connectRevision;
+}
+
+void SysVehicleHandoff::release_owners(VehicleData& rData, Resources& rResources) noexcept
+{
+    for (PrefabPair &rPrefabPair : rData.m_partPrefabs)
+    {
+        rResources.owner_destroy(gc_importer, std::move(rPrefabPair.m_importer));
+    }
+}
+
+} // namespace adera
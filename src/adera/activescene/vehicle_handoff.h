@@ -0,0 +1,94 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "VehicleBuilder.h"
+
+#include <osp/activescene/vehicles.h>
+#include <osp/core/array_view.h>
+#include <osp/core/keyed_vector.h>
+#include <osp/link/machines.h>
+#include <osp/link/signal.h>
+
+#include <vector>
+
+namespace adera
+{
+
+/**
+ * @brief Move welds between the active scene's ACtxParts and standalone VehicleData
+ *
+ * Used to take vehicles out of the physics scene (eg. putting them on rails as universe
+ * satellites) and to bring them back through the regular vehicle spawn pipeline. Each weld
+ * becomes its own single-weld VehicleData, so only connections between machines of the same
+ * weld are kept.
+ */
+class SysVehicleHandoff
+{
+    using ACtxParts         = osp::active::ACtxParts;
+    using MachineUpdater    = osp::link::MachineUpdater;
+    using NodeId            = osp::link::NodeId;
+    using NodeTypeId        = osp::link::NodeTypeId;
+    using Resources         = osp::Resources;
+public:
+
+    /**
+     * @brief Copy a weld, its parts, machines and connected nodes into a new VehicleData
+     *
+     * IDs in the output are dense and start from zero. Float signal values of copied nodes are
+     * stored in m_nodeValues. Prefab importers get new owners, which the caller must release
+     * with Resources::owner_destroy once done with the VehicleData.
+     */
+    [[nodiscard]] static VehicleData extract_weld(
+            ACtxParts const&                            rScnParts,
+            osp::link::SignalValues_t<float> const&     sigValFloat,
+            Resources&                                  rResources,
+            WeldId                                      weld);
+
+    /**
+     * @brief Remove welds along with their parts and machines from the scene
+     *
+     * Nodes shared with machines of other welds only lose junctions to removed machines, nodes
+     * left with no junctions are removed too. Machines are removed from MachineUpdater's pending
+     * levels and wake timers. ActiveEnts aren't deleted, only unmapped; delete the old weld root
+     * entities afterwards.
+     *
+     * @param rNodesRemovedOut  [out] Appended with removed nodes per type, eg. to clear them
+     *                                from UpdateNodes
+     */
+    static void remove_welds(
+            ACtxParts&                                          rScnParts,
+            MachineUpdater&                                     rUpdMach,
+            Resources&                                          rResources,
+            osp::ArrayView<WeldId const>                        welds,
+            osp::KeyedVec<NodeTypeId, std::vector<NodeId>>&     rNodesRemovedOut);
+
+    /**
+     * @brief Release the importer owners of VehicleData made by extract_weld or blueprint load
+     */
+    static void release_owners(VehicleData& rData, Resources& rResources) noexcept;
+};
+
+} // namespace adera
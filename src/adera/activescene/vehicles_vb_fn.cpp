@@ -26,12 +26,72 @@
 
 #include <osp/core/Resources.h>
 
+#include <algorithm>
+
 using namespace osp;
 using namespace osp::active;
+using namespace osp::link;
 
 namespace adera
 {
 
+void SysVehicleSpawnVB::group_blueprints(ACtxVehicleSpawn const& rVehicleSpawn, ACtxVehicleSpawnVB& rVehicleSpawnVB)
+{
+    using Blueprint = ACtxVehicleSpawnVB::Blueprint;
+
+    std::size_t const newVehicleCount = rVehicleSpawn.new_vehicle_count();
+    ACtxVehicleSpawnVB &rVSVB = rVehicleSpawnVB;
+
+    rVSVB.blueprints.clear();
+    rVSVB.vehicleBlueprint.resize(newVehicleCount);
+
+    for (SpVehicleId vhId{0}; vhId.value < newVehicleCount; ++vhId.value)
+    {
+        VehicleData const* pVData = rVSVB.dataVB[vhId];
+        if (pVData == nullptr)
+        {
+            rVSVB.vehicleBlueprint[vhId] = ACtxVehicleSpawnVB::smc_noBlueprint;
+            continue;
+        }
+
+        // Only a few unique VehicleData are expected per spawn, so a linear search is fine
+        auto const itFound = std::find_if(rVSVB.blueprints.begin(), rVSVB.blueprints.end(),
+                                          [pVData] (Blueprint const& rBp) { return rBp.pData == pVData; });
+        if (itFound != rVSVB.blueprints.end())
+        {
+            ++itFound->copies;
+            rVSVB.vehicleBlueprint[vhId] = static_cast<std::uint32_t>(std::distance(rVSVB.blueprints.begin(), itFound));
+            continue;
+        }
+
+        rVSVB.vehicleBlueprint[vhId] = static_cast<std::uint32_t>(rVSVB.blueprints.size());
+
+        Blueprint &rBp = rVSVB.blueprints.emplace_back();
+        rBp.pData   = pVData;
+        rBp.copies  = 1;
+
+        rBp.parts.reserve(pVData->m_partIds.size());
+        for (PartId const part : pVData->m_partIds)
+        {
+            rBp.parts.push_back(part);
+        }
+
+        rBp.welds.reserve(pVData->m_weldIds.size());
+        for (WeldId const weld : pVData->m_weldIds)
+        {
+            rBp.welds.push_back(weld);
+        }
+
+        rBp.machs.reserve(pVData->m_machines.ids.size());
+        rBp.machtypeCount.assign(MachTypeReg_t::size(), 0);
+        for (MachAnyId const mach : pVData->m_machines.ids)
+        {
+            rBp.machs.push_back(mach);
+            ++rBp.machtypeCount[pVData->m_machines.machTypes[mach]];
+        }
+    }
+}
+
 void SysVehicleSpawnVB::create_parts_and_welds(ACtxVehicleSpawn& rVehicleSpawn, ACtxVehicleSpawnVB& rVehicleSpawnVB, ACtxParts& rScnParts)
 {
     std::size_t const newVehicleCount = rVehicleSpawn.new_vehicle_count();
@@ -53,20 +113,21 @@ void SysVehicleSpawnVB::create_parts_and_welds(ACtxVehicleSpawn& rVehicleSpawn,
     for (uint32_t spVhInt = 0; spVhInt < newVehicleCount; ++spVhInt)
     {
         auto const spVhId = SpVehicleId{spVhInt};
-        VehicleData const* pVData = rVSVB.dataVB[spVhId];
-        if (pVData == nullptr)
+        ACtxVehicleSpawnVB::Blueprint const* pBp = blueprint_of(rVSVB, spVhId);
+        if (pBp == nullptr)
         {
             continue;
         }
+        VehicleData const* pVData = pBp->pData;
 
         rVehicleSpawn.spawnedPartOffsets[spVhId] = SpPartId{partTotal};
-        partTotal += pVData->m_partIds.size();
+        partTotal += static_cast<uint32_t>(pBp->parts.size());
 
         rVSVB.remapPartOffsets[spVhId] = remapPartTotal;
         remapPartTotal += pVData->m_partIds.capacity();
 
         rVehicleSpawn.spawnedWeldOffsets[spVhId] = SpWeldId{weldTotal};
-        weldTotal += pVData->m_weldIds.size();
+        weldTotal += static_cast<uint32_t>(pBp->welds.size());
 
         rVSVB.remapWeldOffsets[spVhId] = remapWeldTotal;
         remapWeldTotal += pVData->m_weldIds.capacity();
@@ -78,7 +139,7 @@ void SysVehicleSpawnVB::create_parts_and_welds(ACtxVehicleSpawn& rVehicleSpawn,
     rVehicleSpawn.spawnedWelds      .resize(weldTotal);
     rVehicleSpawn.spawnedPrefabs    .resize(partTotal);
     rVSVB.remapParts                .resize(remapPartTotal, lgrn::id_null<PartId>());
-    rVSVB.remapWelds                .resize(remapPartTotal, lgrn::id_null<WeldId>());
+    rVSVB.remapWelds                .resize(remapWeldTotal, lgrn::id_null<WeldId>());
 
     // Create new Scene PartIds and WeldIds
 
@@ -116,16 +177,17 @@ void SysVehicleSpawnVB::create_parts_and_welds(ACtxVehicleSpawn& rVehicleSpawn,
     {
         auto const spVhId = SpVehicleId{spVhInt};
 
-        VehicleData const* pVData = rVSVB.dataVB[spVhId];
-        if (pVData == nullptr)
+        ACtxVehicleSpawnVB::Blueprint const* pBp = blueprint_of(rVSVB, spVhId);
+        if (pBp == nullptr)
         {
             continue;
         }
+        VehicleData const* pVData = pBp->pData;
 
         std::size_t const remapPartOffset = rVSVB.remapPartOffsets[spVhId];
         std::size_t const remapWeldOffset = rVSVB.remapWeldOffsets[spVhId];
 
-        for (PartId const srcPart : pVData->m_partIds)
+        for (PartId const srcPart : pBp->parts)
         {
             PartId const dstPart = *itDstPartIds;
             ++itDstPartIds;
@@ -134,7 +196,7 @@ void SysVehicleSpawnVB::create_parts_and_welds(ACtxVehicleSpawn& rVehicleSpawn,
             rVSVB.remapParts[remapPartOffset + srcPart] = dstPart;
         }
 
-        for (WeldId const srcWeld : pVData->m_weldIds)
+        for (WeldId const srcWeld : pBp->welds)
         {
             WeldId const dstWeld = *itDstWeldIds;
             ++itDstWeldIds;
@@ -174,14 +236,15 @@ void SysVehicleSpawnVB::request_prefabs(ACtxVehicleSpawn& rVehicleSpawn, ACtxVeh
     {
         auto const spVhId = SpVehicleId{spVhInt};
 
-        VehicleData const* pVData = rVehicleSpawnVB.dataVB[spVhId];
-        if (pVData == nullptr)
+        ACtxVehicleSpawnVB::Blueprint const* pBp = blueprint_of(rVehicleSpawnVB, spVhId);
+        if (pBp == nullptr)
         {
             continue;
         }
+        VehicleData const* pVData = pBp->pData;
 
         // Copy Part data from VehicleBuilder to scene
-        for (uint32_t srcPart : pVData->m_partIds)
+        for (PartId const srcPart : pBp->parts)
         {
             PartId const dstPart = *itDstPartIds;
             ++itDstPartIds;
@@ -208,4 +271,106 @@ void SysVehicleSpawnVB::request_prefabs(ACtxVehicleSpawn& rVehicleSpawn, ACtxVeh
 }
 
 
+void SysVehicleSpawnVB::create_machines(ACtxVehicleSpawn& rVehicleSpawn, ACtxVehicleSpawnVB& rVehicleSpawnVB, ACtxParts& rScnParts)
+{
+    std::size_t const newVehicleCount = rVehicleSpawn.new_vehicle_count();
+    ACtxVehicleSpawnVB &rVSVB = rVehicleSpawnVB;
+    Machines &rDstMachines = rScnParts.machines;
+
+    // Count total machines, and calculate offsets for remaps
+
+    std::size_t machTotal       = 0;
+    std::size_t remapMachTotal  = 0;
+
+    rVSVB.remapMachOffsets.resize(newVehicleCount);
+
+    for (SpVehicleId vhId{0}; vhId.value < newVehicleCount; ++vhId.value)
+    {
+        ACtxVehicleSpawnVB::Blueprint const* pBp = blueprint_of(rVSVB, vhId);
+        if (pBp == nullptr)
+        {
+            continue;
+        }
+
+        rVSVB.remapMachOffsets[vhId] = remapMachTotal;
+        remapMachTotal  += pBp->pData->m_machines.ids.capacity();
+        machTotal       += pBp->machs.size();
+    }
+
+    rVSVB.machtypeCount.assign(MachTypeReg_t::size(), 0);
+    for (ACtxVehicleSpawnVB::Blueprint const& rBp : rVSVB.blueprints)
+    {
+        for (MachTypeId type = 0; type < MachTypeReg_t::size(); ++type)
+        {
+            rVSVB.machtypeCount[type] += std::size_t(rBp.machtypeCount[type]) * rBp.copies;
+        }
+    }
+
+    rVehicleSpawn.spawnedMachs.resize(machTotal);
+    rVSVB.remapMachs.resize(remapMachTotal);
+
+    // Create ACtxParts MachAnyIds
+
+    rDstMachines.ids.create(rVehicleSpawn.spawnedMachs.begin(), rVehicleSpawn.spawnedMachs.end());
+    rDstMachines.machTypes  .resize(rDstMachines.ids.capacity());
+    rDstMachines.machToLocal.resize(rDstMachines.ids.capacity());
+
+    // Create ACtxParts MachLocalIds all at once for each type. spawnedMachLocals is divided into
+    // a section per type, machtypeOffsets are then used as cursors to hand them out in order.
+
+    rVSVB.spawnedMachLocals.resize(machTotal);
+    rVSVB.machtypeOffsets.resize(MachTypeReg_t::size());
+
+    std::size_t typeOffset = 0;
+    for (MachTypeId type = 0; type < MachTypeReg_t::size(); ++type)
+    {
+        std::size_t const count = rVSVB.machtypeCount[type];
+        rVSVB.machtypeOffsets[type] = typeOffset;
+
+        if (count != 0)
+        {
+            PerMachType &rDstPerType = rDstMachines.perType[type];
+            auto const itFirst = rVSVB.spawnedMachLocals.begin() + typeOffset;
+            rDstPerType.localIds.create(itFirst, itFirst + count);
+            rDstPerType.localToAny.resize(rDstPerType.localIds.capacity());
+        }
+
+        typeOffset += count;
+    }
+
+    // Populate remaps and connect MachAnyIds with MachLocalIds
+
+    auto itDstMachIds = rVehicleSpawn.spawnedMachs.cbegin();
+
+    for (SpVehicleId vhId{0}; vhId.value < newVehicleCount; ++vhId.value)
+    {
+        ACtxVehicleSpawnVB::Blueprint const* pBp = blueprint_of(rVSVB, vhId);
+        if (pBp == nullptr)
+        {
+            continue;
+        }
+
+        Machines const &srcMachines      = pBp->pData->m_machines;
+        std::size_t const remapMachOffset = rVSVB.remapMachOffsets[vhId];
+
+        for (MachAnyId const srcMach : pBp->machs)
+        {
+            MachAnyId const dstMach = *itDstMachIds;
+            ++itDstMachIds;
+
+            // Populate map for "VehicleBuilder MachAnyId -> ACtxParts MachAnyId"
+            rVSVB.remapMachs[remapMachOffset + srcMach] = dstMach;
+
+            // MachLocalIds don't need a remap, since they can be obtained from a MachAnyId.
+            MachTypeId const    type        = srcMachines.machTypes[srcMach];
+            MachLocalId const   dstLocal    = rVSVB.spawnedMachLocals[rVSVB.machtypeOffsets[type]];
+            ++rVSVB.machtypeOffsets[type];
+
+            rDstMachines.perType[type].localToAny[dstLocal] = dstMach;
+            rDstMachines.machTypes[dstMach]     = type;
+            rDstMachines.machToLocal[dstMach]   = dstLocal;
+        }
+    }
+}
+
 } // namespace adera
@@ -28,6 +28,7 @@
 
 #include <osp/activescene/vehicles.h>
 #include <osp/activescene/prefab_fn.h>
+#include <osp/link/signal.h>
 
 namespace adera
 {
@@ -36,6 +37,28 @@ struct ACtxVehicleSpawnVB
 {
     using SpVehicleId = osp::active::SpVehicleId;
 
+    /**
+     * @brief Per-VehicleData data shared by all copies of it being spawned at once
+     *
+     * Spawning many copies of the same VehicleData only has to iterate its IdRegistries once,
+     * every copy after reuses these ID lists and counts.
+     */
+    struct Blueprint
+    {
+        VehicleData const*                  pData{nullptr};
+
+        std::vector<osp::active::PartId>    parts;
+        std::vector<osp::active::WeldId>    welds;
+        std::vector<osp::link::MachAnyId>   machs;
+
+        /// Number of machines per machine type to create for each copy
+        std::vector<std::uint32_t>          machtypeCount;
+
+        std::uint32_t                       copies{0};
+    };
+
+    static constexpr std::uint32_t smc_noBlueprint = ~std::uint32_t(0);
+
     // Remap vectors convert IDs from VehicleData to ACtxParts.
     // A single vector for remaps is shared for all vehicles to spawn,
     // so offsets are used to divide up the vector.
@@ -57,6 +80,10 @@ struct ACtxVehicleSpawnVB
 
     osp::KeyedVec<SpVehicleId, VehicleData const*> dataVB;
 
+    // Unique VehicleData of this spawn, see SysVehicleSpawnVB::group_blueprints
+    std::vector<Blueprint>                  blueprints;
+    osp::KeyedVec<SpVehicleId, std::uint32_t> vehicleBlueprint;
+
     std::vector<osp::active::PartId>        remapParts;
     osp::KeyedVec<SpVehicleId, std::size_t> remapPartOffsets;
 
@@ -65,6 +92,8 @@ struct ACtxVehicleSpawnVB
 
     std::vector<std::size_t>                machtypeCount;
     std::vector<osp::link::MachAnyId>       remapMachs;
+    std::vector<osp::link::MachLocalId>     spawnedMachLocals;
+    std::vector<std::size_t>                machtypeOffsets;
     osp::KeyedVec<SpVehicleId, std::size_t> remapMachOffsets;
 
     // remapNodes are both shared between all new vehicles and all node types
@@ -79,11 +108,93 @@ class SysVehicleSpawnVB
     using ACtxPrefabs       = osp::active::ACtxPrefabs;
     using ACtxVehicleSpawn  = osp::active::ACtxVehicleSpawn;
     using Resources         = osp::Resources;
+    using SpVehicleId       = osp::active::SpVehicleId;
 public:
+    /**
+     * @brief Group vehicles to spawn by their VehicleData, and cache each one's IDs and counts
+     *
+     * Must run before any of the other functions. Vehicles with a null dataVB get smc_noBlueprint.
+     */
+    static void group_blueprints(ACtxVehicleSpawn const& rVehicleSpawn, ACtxVehicleSpawnVB& rVehicleSpawnVB);
+
+    /**
+     * @return Blueprint of a vehicle to spawn, or nullptr if it has no VehicleData
+     */
+    [[nodiscard]] static ACtxVehicleSpawnVB::Blueprint const* blueprint_of(ACtxVehicleSpawnVB const& rVehicleSpawnVB, SpVehicleId vhId) noexcept
+    {
+        std::uint32_t const index = rVehicleSpawnVB.vehicleBlueprint[vhId];
+        return (index == ACtxVehicleSpawnVB::smc_noBlueprint) ? nullptr : &rVehicleSpawnVB.blueprints[index];
+    }
+
+    /**
+     * @brief Create MachAnyIds and MachLocalIds for all new vehicles, and populate remapMachs
+     *
+     * Local IDs are created in bulk, with a single create and resize per machine type.
+     */
+    static void create_machines(ACtxVehicleSpawn& rVehicleSpawn, ACtxVehicleSpawnVB& rVehicleSpawnVB, ACtxParts& rScnParts);
+
     static void create_parts_and_welds(ACtxVehicleSpawn& rVehicleSpawn, ACtxVehicleSpawnVB& rVehicleSpawnVB, ACtxParts& rScnParts);
 
     static void request_prefabs(ACtxVehicleSpawn& rVehicleSpawn, ACtxVehicleSpawnVB const& rVehicleSpawnVB, ACtxParts& rScnParts, ACtxPrefabs& rPrefabs, Resources& rResources);
+
+    /**
+     * @brief Copy initial signal values of new vehicles' nodes, for any signal type
+     *
+     * Node IDs must already be copied and remapped, see osp::link::copy_nodes.
+     */
+    template <typename VALUE_T>
+    static void copy_signal_values(
+            ACtxVehicleSpawn const&                 rVehicleSpawn,
+            ACtxVehicleSpawnVB const&               rVehicleSpawnVB,
+            ACtxParts const&                        rScnParts,
+            osp::link::SignalValues_t<VALUE_T>&     rSigVal,
+            osp::link::UpdateNodes<VALUE_T>&        rSigUpd);
 };
 
+template <typename VALUE_T>
+void SysVehicleSpawnVB::copy_signal_values(
+        ACtxVehicleSpawn const&                 rVehicleSpawn,
+        ACtxVehicleSpawnVB const&               rVehicleSpawnVB,
+        ACtxParts const&                        rScnParts,
+        osp::link::SignalValues_t<VALUE_T>&     rSigVal,
+        osp::link::UpdateNodes<VALUE_T>&        rSigUpd)
+{
+    using osp::link::NodeId;
+    using osp::link::NodeTypeId;
+    using osp::link::SignalValues_t;
+
+    NodeTypeId const    nodeType    = osp::link::SignalType<VALUE_T>::node_type();
+    std::size_t const   maxNodes    = rScnParts.nodePerType[nodeType].nodeIds.capacity();
+    rSigUpd.nodeNewValues.resize(maxNodes);
+    rSigUpd.nodeDirty.resize(maxNodes);
+    rSigVal.resize(maxNodes);
+
+    std::size_t const newVehicleCount = rVehicleSpawn.new_vehicle_count();
+
+    auto const remapNodeOffsets2d = rVehicleSpawnVB.remap_node_offsets_2d();
+    for (SpVehicleId vhId{0}; vhId.value < newVehicleCount; ++vhId.value)
+    {
+        VehicleData const* pVData = rVehicleSpawnVB.dataVB[vhId];
+        if (pVData == nullptr)
+        {
+            continue;
+        }
+
+        PerNodeType const&  srcNodes        = pVData->m_nodePerType[nodeType];
+        if ( ! srcNodes.m_nodeValues )
+        {
+            continue; // Vehicle has no nodes of this type
+        }
+        auto const&         srcValues       = entt::any_cast< SignalValues_t<VALUE_T> const& >(srcNodes.m_nodeValues);
+        std::size_t const   nodeRemapOffset = remapNodeOffsets2d[vhId.value][nodeType];
+        auto const          nodeRemap       = Corrade::Containers::arrayView(rVehicleSpawnVB.remapNodes).exceptPrefix(nodeRemapOffset);
+
+        for (NodeId const srcNode : srcNodes.nodeIds)
+        {
+            rSigVal[nodeRemap[srcNode]] = srcValues[srcNode];
+        }
+    }
+}
+
 
 } // namespace adera
@@ -42,42 +42,31 @@ using osp::Matrix4;
 using osp::Quaternion;
 using osp::Vector3;
 
-void SysCameraController::update_view(ACtxCameraController& rCtrl, float const delta)
+namespace
 {
-    // Process control inputs
 
+/**
+ * @brief Yaw and pitch requested by held rotation keys over delta seconds
+ */
+void key_rotation(ACtxCameraController const& rCtrl, float const delta, Rad& rYaw, Rad& rPitch)
+{
     ControlSubscriber const& controls = rCtrl.m_controls;
 
-    Rad yaw = 0.0_degf;
-    Rad pitch = 0.0_degf;
-
-    // Arrow key rotation
-
     Rad const keyRotDelta = 180.0_degf * delta; // 180 degrees per second
 
-    yaw   += (  float(controls.button_held(rCtrl.m_btnRotRt))
-              - float(controls.button_held(rCtrl.m_btnRotLf)) ) * keyRotDelta;
-    pitch += (  float(controls.button_held(rCtrl.m_btnRotDn))
-              - float(controls.button_held(rCtrl.m_btnRotUp)) ) * keyRotDelta;
-
-    // Mouse rotation, if right mouse button is down
-
-    if (rCtrl.m_controls.button_held(rCtrl.m_btnOrbit))
-    {
-        // 1 degrees per step
-        constexpr Rad const mouseRotDelta = 1.0_degf;
-
-        yaw -= controls.get_input_handler()->mouse_state().m_smoothDelta.x()
-                * mouseRotDelta;
-        pitch -= controls.get_input_handler()->mouse_state().m_smoothDelta.y()
-                  * mouseRotDelta;
-    }
-
-    auto const scroll = float(rCtrl.m_controls.get_input_handler()
-                              ->scroll_state().offset.y());
+    rYaw   += (  float(controls.button_held(rCtrl.m_btnRotRt))
+               - float(controls.button_held(rCtrl.m_btnRotLf)) ) * keyRotDelta;
+    rPitch += (  float(controls.button_held(rCtrl.m_btnRotDn))
+               - float(controls.button_held(rCtrl.m_btnRotUp)) ) * keyRotDelta;
+}
 
+/**
+ * @brief Rotate a camera transform around the controller's target, if it has one
+ */
+void orbit(ACtxCameraController const& rCtrl, Matrix4& rTransform, float const orbitDistance, Rad const yaw, Rad pitch)
+{
     Vector3 const up
-            = rCtrl.m_up.isZero() ? rCtrl.m_transform.up() : rCtrl.m_up;
+            = rCtrl.m_up.isZero() ? rTransform.up() : rCtrl.m_up;
 
     // Prevent pitch overshoot if up is defined
     if ( ! rCtrl.m_up.isZero())
@@ -85,7 +74,7 @@ void SysCameraController::update_view(ACtxCameraController& rCtrl, float const d
         using Magnum::Math::angle;
         using Magnum::Math::clamp;
 
-        Rad const currentPitch = angle(rCtrl.m_up, -rCtrl.m_transform.backward());
+        Rad const currentPitch = angle(rCtrl.m_up, -rTransform.backward());
         Rad const nextPitch = currentPitch - pitch;
 
         // Limit from 1 degree (looking down) to 179 degrees (looking up)
@@ -97,26 +86,18 @@ void SysCameraController::update_view(ACtxCameraController& rCtrl, float const d
 
     if (rCtrl.m_target.has_value())
     {
-        // Orbit around target
-
-        // Scroll to move in/out
-        constexpr float const distSensitivity = 0.3f;
-        rCtrl.m_orbitDistance
-                -= rCtrl.m_orbitDistance * distSensitivity * scroll;
-        rCtrl.m_orbitDistance = std::max(rCtrl.m_orbitDistance, rCtrl.m_orbitDistanceMin);
-
         // Convert requested rotation to quaternion
         Quaternion const rotationDelta
                 = Quaternion::rotation(yaw, up)
-                * Quaternion::rotation(pitch, rCtrl.m_transform.right());
+                * Quaternion::rotation(pitch, rTransform.right());
 
         Vector3 const translation
                 = rCtrl.m_target.value()
                 + rotationDelta.transformVector(
-                    rCtrl.m_transform.backward() * rCtrl.m_orbitDistance);
+                    rTransform.backward() * orbitDistance);
 
         // look at target
-        rCtrl.m_transform = Matrix4::lookAt(translation, rCtrl.m_target.value(), up);
+        rTransform = Matrix4::lookAt(translation, rCtrl.m_target.value(), up);
     }
     else
     {
@@ -124,9 +105,10 @@ void SysCameraController::update_view(ACtxCameraController& rCtrl, float const d
     }
 }
 
-void SysCameraController::update_move(
-        ACtxCameraController& rCtrl,
-        float const delta, bool const moveTarget)
+/**
+ * @brief Translation requested by held movement keys over delta seconds
+ */
+Vector3 key_translation(ACtxCameraController const& rCtrl, Matrix4 const& transform, float const delta)
 {
     ControlSubscriber const& controls = rCtrl.m_controls;
 
@@ -139,11 +121,60 @@ void SysCameraController::update_move(
          - float( controls.button_held(rCtrl.m_btnMovFd))
     );
 
-    Vector3 const translation
-            = (   rCtrl.m_transform.right()    * command.x()
-                + rCtrl.m_transform.up()       * command.y()
-                + rCtrl.m_transform.backward() * command.z())
-            * delta * rCtrl.m_moveSpeed * rCtrl.m_orbitDistance;
+    return (   transform.right()    * command.x()
+             + transform.up()       * command.y()
+             + transform.backward() * command.z())
+           * delta * rCtrl.m_moveSpeed * rCtrl.m_orbitDistance;
+}
+
+} // namespace
+
+void SysCameraController::update_view(ACtxCameraController& rCtrl, float const delta)
+{
+    // Process control inputs
+
+    ControlSubscriber const& controls = rCtrl.m_controls;
+
+    Rad yaw = 0.0_degf;
+    Rad pitch = 0.0_degf;
+
+    // Arrow key rotation
+
+    key_rotation(rCtrl, delta, yaw, pitch);
+
+    // Mouse rotation, if right mouse button is down
+
+    if (rCtrl.m_controls.button_held(rCtrl.m_btnOrbit))
+    {
+        // 1 degrees per step
+        constexpr Rad const mouseRotDelta = 1.0_degf;
+
+        yaw -= controls.get_input_handler()->mouse_state().m_smoothDelta.x()
+                * mouseRotDelta;
+        pitch -= controls.get_input_handler()->mouse_state().m_smoothDelta.y()
+                  * mouseRotDelta;
+    }
+
+    auto const scroll = float(rCtrl.m_controls.get_input_handler()
+                              ->scroll_state().offset.y());
+
+    if (rCtrl.m_target.has_value())
+    {
+        // Scroll to move in/out
+        constexpr float const distSensitivity = 0.3f;
+        rCtrl.m_orbitDistance
+                -= rCtrl.m_orbitDistance * distSensitivity * scroll;
+        rCtrl.m_orbitDistance = std::max(rCtrl.m_orbitDistance, rCtrl.m_orbitDistanceMin);
+    }
+
+    orbit(rCtrl, rCtrl.m_transform, rCtrl.m_orbitDistance, yaw, pitch);
+}
+
+void SysCameraController::update_move(
+        ACtxCameraController& rCtrl,
+        float const delta, bool const moveTarget)
+{
+    Vector3 const translation = key_translation(rCtrl, rCtrl.m_transform, delta);
 
     rCtrl.m_transform.translation() += translation;
 
@@ -152,3 +183,33 @@ void SysCameraController::update_move(
         rCtrl.m_target.value() += translation;
     }
 }
+
+Matrix4 SysCameraController::latched_transform(
+        ACtxCameraController const& rCtrl,
+        osp::Vector2i const         mouseDelta,
+        float const                 elapsed)
+{
+    Matrix4 transform = rCtrl.m_transform;
+
+    Rad yaw = 0.0_degf;
+    Rad pitch = 0.0_degf;
+
+    key_rotation(rCtrl, elapsed, yaw, pitch);
+
+    if (rCtrl.m_controls.button_held(rCtrl.m_btnOrbit))
+    {
+        // Same as update_view, the next update moves m_smoothDelta towards the new motion by
+        // m_responseFactor. Only that part is added, what's already smoothed isn't predicted.
+        constexpr Rad const mouseRotDelta = 1.0_degf;
+        float const response = rCtrl.m_controls.get_input_handler()->mouse_state().m_responseFactor;
+
+        yaw   -= float(mouseDelta.x()) * response * mouseRotDelta;
+        pitch -= float(mouseDelta.y()) * response * mouseRotDelta;
+    }
+
+    orbit(rCtrl, transform, rCtrl.m_orbitDistance, yaw, pitch);
+
+    transform.translation() += key_translation(rCtrl, transform, elapsed);
+
+    return transform;
+}
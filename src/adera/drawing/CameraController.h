@@ -109,6 +109,22 @@ public:
      *                           camera modes are not yet finalized.
      */
     static void update_move(ACtxCameraController &rCtrl, float delta, bool moveTarget);
+
+    /**
+     * @brief Predict the camera transform with input that arrived after the last update, for
+     *        late latching right before drawing
+     *
+     * The controller itself isn't changed; the next update_view and update_move see the same
+     * input as usual.
+     *
+     * @param rCtrl         [in] Camera Controller state, as of the last update
+     * @param mouseDelta    [in] Mouse motion not yet seen by UserInputHandler::update_controls
+     * @param elapsed       [in] Seconds since the last update, held keys keep acting over this
+     */
+    [[nodiscard]] static osp::Matrix4 latched_transform(
+            ACtxCameraController const& rCtrl,
+            osp::Vector2i               mouseDelta,
+            float                       elapsed);
 };
 
 
@@ -0,0 +1,63 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include <osp/core/keyed_vector.h>
+#include <osp/drawing/draw_ent.h>
+
+#include <Magnum/Math/Color.h>
+#include <Magnum/Magnum.h>
+
+namespace adera
+{
+
+/**
+ * @brief Per-DrawEnt exhaust plume parameters, packed into a GPU buffer by the plume shader
+ *
+ * topZ and bottomZ are the Z bounds of the plume mesh in its own space, with the nozzle at topZ.
+ */
+struct PlumeParams
+{
+    float           power           {0.0f};
+    float           flowVelocity    {1.0f};
+    float           topZ            {1.0f};
+    float           bottomZ         {-1.0f};
+    Magnum::Color4  color           {1.0f, 0.6f, 0.2f, 1.0f};
+};
+
+/**
+ * @brief Exhaust plumes of a scene
+ *
+ * Engines only need to write PlumeParams::power each frame, everything else is done on the GPU.
+ */
+struct ACtxPlumes
+{
+    osp::KeyedVec<osp::draw::DrawEnt, PlumeParams>  params;
+
+    /// Seconds, scrolls the combustion noise down the plume
+    float                                           time    {0.0f};
+};
+
+} // namespace adera
@@ -57,6 +57,64 @@ void adera::shader::draw_ent_flat(
     MeshGlId const      meshId = (*rData.pMeshId)[ent].m_glId;
     Magnum::GL::Mesh    &rMesh = rData.pMeshGl->get(meshId);
 
-    rShader.setTransformationProjectionMatrix(viewProj.m_viewProj * drawTf)
+    rShader.setTransformationProjectionMatrix(viewProj.m_viewProjRotation * viewProj.origin_relative(drawTf))
            .draw(rMesh);
+
+    SysRenderGL::count_draw(*rData.pRenderGl, rMesh);
+}
+
+void adera::shader::draw_instanced_flat(
+        DrawEntSet_t const&             visible,
+        ViewProjMatrix const&           viewProj,
+        InstancedToDraw::UserData_t     userData) noexcept
+{
+    void* const pData = std::get<0>(userData);
+    assert(pData != nullptr);
+
+    auto &rData     = *reinterpret_cast<ACtxDrawFlat*>(pData);
+    auto &rScratch  = rData.instanceScratch;
+
+    bool const useArrays = rData.shaderInstancedDiffuseArray.id() != 0;
+
+    SysRenderGL::group_instances(rScratch, rData.instancedEnts, visible,
+                                 rData.pScnRender->m_materials[rData.materialId].m_ents,
+                                 *rData.pMeshId, *rData.pDiffuseTexId,
+                                 useArrays ? rData.pTexArrays : nullptr);
+
+    for (InstanceScratchGL::Group const& group : rScratch.m_groups)
+    {
+        bool const isArray    = group.texArray != lgrn::id_null<std::uint32_t>();
+        bool const hasTexture = group.texId != lgrn::id_null<TexGlId>();
+        FlatGL3D &rShader = isArray    ? rData.shaderInstancedDiffuseArray
+                          : hasTexture ? rData.shaderInstancedDiffuse
+                                       : rData.shaderInstancedUntextured;
+
+        rScratch.m_data.resize(group.count);
+        for (std::size_t i = 0; i < group.count; ++i)
+        {
+            DrawEnt const ent   = rScratch.m_sorted[group.first + i].ent;
+            float const   layer = isArray ? SysRenderGL::texture_layer(*rData.pTexArrays, *rData.pDiffuseTexId, ent) : 0.0f;
+
+            rScratch.m_data[i] = {
+                .transformation     = viewProj.origin_relative((*rData.pDrawTf)[ent]),
+                .normalMatrix       = {},
+                .color              = (rData.pColor != nullptr) ? (*rData.pColor)[ent] : Magnum::Color4{1.0f},
+                .textureOffsetLayer = {0.0f, 0.0f, layer}};
+        }
+
+        if (isArray)
+        {
+            rShader.bindTexture(rData.pTexArrays->m_arrays[group.texArray].texture);
+        }
+        else if (hasTexture)
+        {
+            rShader.bindTexture(rData.pTexGl->get(group.texId));
+        }
+
+        // Per-instance transforms and colors are multiplied with these
+        rShader.setColor(Magnum::Color4{1.0f})
+               .setTransformationProjectionMatrix(viewProj.m_viewProjRotation);
+
+        SysRenderGL::draw_instances(*rData.pRenderGl, group.meshId, rScratch.m_data, rShader);
+    }
 }
@@ -39,6 +39,21 @@ struct ACtxDrawFlat
     FlatGL3D                    shaderUntextured    {Corrade::NoCreate};
     FlatGL3D                    shaderDiffuse       {Corrade::NoCreate};
 
+    // Used for instancedEnts, needs Flag::InstancedTransformation and Flag::VertexColor
+    FlatGL3D                    shaderInstancedUntextured   {Corrade::NoCreate};
+    FlatGL3D                    shaderInstancedDiffuse      {Corrade::NoCreate};
+
+    // Optional, also needs Flag::TextureArrays and Flag::InstancedTextureOffset. If created,
+    // entities with textures in RenderGL::m_texArrays are drawn with it, mixing textures.
+    FlatGL3D                    shaderInstancedDiffuseArray {Corrade::NoCreate};
+
+    /// If true, sync_drawent_flat puts opaque entities in instancedEnts instead of a RenderGroup
+    bool                        instancing          {false};
+
+    /// Entities drawn by draw_instanced_flat. Register it in RenderGroup::instanced.
+    osp::draw::DrawEntSet_t     instancedEnts;
+    osp::draw::InstanceScratchGL instanceScratch;
+
     osp::draw::DrawTransforms_t    *pDrawTf         {nullptr};
     osp::draw::DrawEntColors_t     *pColor          {nullptr};
     osp::draw::TexGlEntStorage_t   *pDiffuseTexId   {nullptr};
@@ -46,6 +61,10 @@ struct ACtxDrawFlat
 
     osp::draw::TexGlStorage_t      *pTexGl          {nullptr};
     osp::draw::MeshGlStorage_t     *pMeshGl         {nullptr};
+    osp::draw::TextureArraysGL     *pTexArrays      {nullptr};
+
+    osp::draw::ACtxSceneRender     *pScnRender      {nullptr};
+    osp::draw::RenderGL            *pRenderGl       {nullptr};
 
     osp::draw::MaterialId materialId { lgrn::id_null<osp::draw::MaterialId>() };
 
@@ -59,6 +78,9 @@ struct ACtxDrawFlat
         pMeshId         = &rScnRenderGl .m_meshId;
         pTexGl          = &rRenderGl    .m_texGl;
         pMeshGl         = &rRenderGl    .m_meshGl;
+        pTexArrays      = &rRenderGl    .m_texArrays;
+        pScnRender      = &rScnRender;
+        pRenderGl       = &rRenderGl;
     }
 };
 
@@ -67,11 +89,19 @@ void draw_ent_flat(
         osp::draw::ViewProjMatrix const&     viewProj,
         osp::draw::EntityToDraw::UserData_t  userData) noexcept;
 
+/**
+ * @brief Draw ACtxDrawFlat::instancedEnts, one instanced draw call per mesh and texture
+ */
+void draw_instanced_flat(
+        osp::draw::DrawEntSet_t const&          visible,
+        osp::draw::ViewProjMatrix const&        viewProj,
+        osp::draw::InstancedToDraw::UserData_t  userData) noexcept;
+
 struct ArgsForSyncDrawEntFlat
 {
     osp::draw::DrawEntSet_t const&              hasMaterial;
-    osp::draw::RenderGroup::DrawEnts_t *const   pStorageOpaque;
-    osp::draw::RenderGroup::DrawEnts_t *const   pStorageTransparent;
+    osp::draw::RenderGroupWrites *const         pWritesOpaque;
+    osp::draw::RenderGroupWrites *const         pWritesTransparent;
     osp::draw::DrawEntSet_t const&              opaque;
     osp::draw::DrawEntSet_t const&              transparent;
     osp::draw::TexGlEntStorage_t const&         diffuse;
@@ -88,22 +118,37 @@ inline void sync_drawent_flat(osp::draw::DrawEnt ent, ArgsForSyncDrawEntFlat con
                       ? &args.rData.shaderDiffuse
                       : &args.rData.shaderUntextured;
 
-    if (args.pStorageTransparent != nullptr)
+    if (args.pWritesTransparent != nullptr)
     {
         auto value = (hasMaterial && args.transparent.contains(ent))
                    ? std::make_optional(osp::draw::EntityToDraw{&draw_ent_flat, {&args.rData, pShader}})
                    : std::nullopt;
 
-        osp::storage_assign(*args.pStorageTransparent, ent, std::move(value));
+        args.pWritesTransparent->assign(ent, std::move(value));
+    }
+
+    bool const opaque = hasMaterial && args.opaque.contains(ent);
+
+    if (args.rData.instancing)
+    {
+        args.rData.instancedEnts.resize(args.rData.pDrawTf->size());
+        if (opaque)
+        {
+            args.rData.instancedEnts.insert(ent);
+        }
+        else
+        {
+            args.rData.instancedEnts.erase(ent);
+        }
     }
 
-    if (args.pStorageOpaque != nullptr)
+    if (args.pWritesOpaque != nullptr)
     {
-        auto value = (hasMaterial && args.opaque.contains(ent))
+        auto value = (opaque && ! args.rData.instancing)
                    ? std::make_optional(osp::draw::EntityToDraw{&draw_ent_flat, {&args.rData, pShader}})
                    : std::nullopt;
 
-        osp::storage_assign(*args.pStorageOpaque, ent, std::move(value));
+        args.pWritesOpaque->assign(ent, std::move(value));
     }
 }
 
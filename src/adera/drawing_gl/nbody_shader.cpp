@@ -0,0 +1,97 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "nbody_shader.h"                   // IWYU pragma: associated
+
+#include <Magnum/GL/Renderer.h>
+#include <Magnum/GL/Shader.h>             // for Shader, Shader::Type
+#include <Magnum/GL/Version.h>            // for Version, Version::GL430
+
+// used by attachShaders
+#include <Corrade/Containers/Iterable.h>  // for Containers::Iterable
+
+#include <Corrade/Utility/Assert.h>       // for CORRADE_INTERNAL_ASSERT_OUTPUT
+
+#include <filesystem>
+
+using namespace osp::draw;
+using namespace adera::shader;
+
+NBodyShader::NBodyShader(ProgramBinaryCacheGL const* pCache)
+{
+    using namespace Magnum;
+
+    std::filesystem::path const compPath = "OSPData/adera/Shaders/NBody.comp";
+
+    std::uint64_t const cacheKey = (pCache != nullptr) ? pCache->key({compPath}) : 0;
+    if (pCache == nullptr || ! pCache->load(*this, cacheKey))
+    {
+        GL::Shader comp{GL::Version::GL430, GL::Shader::Type::Compute};
+        comp.addFile(compPath.string());
+
+        CORRADE_INTERNAL_ASSERT_OUTPUT(comp.compile());
+        attachShaders({comp});
+
+        if (pCache != nullptr)
+        {
+            pCache->prepare(*this);
+        }
+        CORRADE_INTERNAL_ASSERT_OUTPUT(link());
+        if (pCache != nullptr)
+        {
+            pCache->store(*this, cacheKey);
+        }
+    }
+}
+
+NBodyShader& NBodyShader::setGravConstant(float const gravConstant)
+{
+    setUniform(static_cast<Magnum::Int>(UniformPos::GravConstant), gravConstant);
+    return *this;
+}
+
+NBodyShader& NBodyShader::setSoftening(float const softening)
+{
+    setUniform(static_cast<Magnum::Int>(UniformPos::Softening2), softening * softening);
+    return *this;
+}
+
+NBodyShader& NBodyShader::bindBuffers(Magnum::GL::Buffer& rBodies, Magnum::GL::Buffer& rAccel)
+{
+    using Magnum::GL::Buffer;
+    rBodies .bind(Buffer::Target::ShaderStorage, smc_bodiesBinding);
+    rAccel  .bind(Buffer::Target::ShaderStorage, smc_accelBinding);
+    return *this;
+}
+
+void NBodyShader::calculate(Magnum::UnsignedInt const bodyCount)
+{
+    using Magnum::GL::Renderer;
+
+    setUniform(static_cast<Magnum::Int>(UniformPos::BodyCount), bodyCount);
+    dispatchCompute({(bodyCount + smc_tileSize - 1) / smc_tileSize, 1, 1});
+
+    // Accelerations are copied into a readback buffer afterwards
+    Renderer::setMemoryBarrier(Renderer::MemoryBarrier::BufferUpdate);
+}
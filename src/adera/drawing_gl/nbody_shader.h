@@ -0,0 +1,90 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include <osp/drawing_gl/rendergl.h>
+
+#include <Magnum/GL/AbstractShaderProgram.h>
+#include <Magnum/GL/Buffer.h>
+
+#include <Magnum/Magnum.h> // for Magnum::UnsignedInt
+
+namespace adera::shader
+{
+
+/**
+ * @brief Compute shader that calculates N-body accelerations by direct summation
+ *
+ * Reads positions and masses in the layout of osp::universe::NBodyOffload::bodies and writes
+ * accelerations in the layout of NBodyOffload::accel. Bodies are loaded in tiles of
+ * smc_tileSize into shared memory. Requires OpenGL 4.3.
+ */
+class NBodyShader : public Magnum::GL::AbstractShaderProgram
+{
+public:
+
+    // Shader storage buffer bindings
+    static constexpr Magnum::UnsignedInt smc_bodiesBinding  = 0;
+    static constexpr Magnum::UnsignedInt smc_accelBinding   = 1;
+
+    /// Workgroup size, must match TILE_SIZE in NBody.comp
+    static constexpr Magnum::UnsignedInt smc_tileSize       = 128;
+
+    explicit NBodyShader(Corrade::NoCreateT) noexcept : AbstractShaderProgram{Corrade::NoCreate} { }
+
+    /**
+     * @param pCache    [in] Optional program binary cache to load from and store to
+     */
+    explicit NBodyShader(osp::draw::ProgramBinaryCacheGL const* pCache = nullptr);
+
+    NBodyShader& setGravConstant(float gravConstant);
+    NBodyShader& setSoftening(float softening);
+
+    /**
+     * @brief Bind buffers. Both hold a vec4 per body, see NBody.comp for their layout.
+     */
+    NBodyShader& bindBuffers(Magnum::GL::Buffer& rBodies, Magnum::GL::Buffer& rAccel);
+
+    /**
+     * @brief Calculate accelerations of bodyCount bodies
+     */
+    void calculate(Magnum::UnsignedInt bodyCount);
+
+private:
+
+    // Uniforms
+    enum class UniformPos : Magnum::Int
+    {
+        BodyCount = 0,
+        GravConstant = 1,
+        Softening2 = 2
+    };
+
+    // Hide irrelevant calls
+    using Magnum::GL::AbstractShaderProgram::draw;
+    using Magnum::GL::AbstractShaderProgram::drawTransformFeedback;
+};
+
+} // namespace adera::shader
@@ -0,0 +1,224 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "orbit_trail_shader.h"             // IWYU pragma: associated
+
+#include <osp/core/math_2pow.h>
+
+#include <Magnum/GL/Renderer.h>
+#include <Magnum/GL/Shader.h>             // for Shader, Shader::Type
+#include <Magnum/GL/Version.h>            // for Version, Version::GL430
+#include <Magnum/Math/Matrix4.h>
+#include <Magnum/Mesh.h>
+
+// used by attachShaders
+#include <Corrade/Containers/Iterable.h>  // for Containers::Iterable
+#include <Corrade/Containers/ArrayViewStl.h>
+
+#include <Corrade/Utility/Assert.h>       // for CORRADE_INTERNAL_ASSERT_OUTPUT
+
+#include <algorithm>
+#include <filesystem>
+
+using namespace osp;
+using namespace osp::draw;
+using namespace osp::universe;
+using namespace adera::shader;
+
+void adera::shader::setup_orbit_trail_shader(ACtxDrawOrbitTrails& rData, std::uint32_t const trailLength, ProgramBinaryCacheGL const* pCache)
+{
+    using namespace Magnum;
+
+    rData.shader        = OrbitTrailShader{pCache};
+    rData.samples       = GL::Buffer{};
+    rData.strips        = GL::Mesh{MeshPrimitive::LineStrip};
+    rData.trailLength   = std::max(trailLength, 2u);
+    rData.satCount      = 0;
+    rData.sampleCount   = 0;
+}
+
+void adera::shader::append_orbit_trail_samples(
+        ACtxDrawOrbitTrails&        rData,
+        SpaceIntViewConst_t const&  x,
+        SpaceIntViewConst_t const&  y,
+        SpaceIntViewConst_t const&  z,
+        int const                   precision)
+{
+    auto const count = static_cast<std::uint32_t>(x.size());
+
+    if (count != rData.satCount || precision != rData.precision)
+    {
+        // Rows are laid out by satellite index, old samples are meaningless now
+        rData.satCount      = count;
+        rData.precision     = precision;
+        rData.head          = rData.trailLength - 1;
+        rData.sampleCount   = 0;
+        rData.ticksToSample = 0;
+        rData.samples.setData({nullptr, std::size_t(rData.trailLength) * count * 3 * sizeof(float)},
+                              Magnum::GL::BufferUsage::DynamicDraw);
+    }
+
+    if (count == 0)
+    {
+        return;
+    }
+
+    if (rData.ticksToSample != 0)
+    {
+        -- rData.ticksToSample;
+        return;
+    }
+    rData.ticksToSample = std::max(rData.sampleInterval, 1u) - 1;
+
+    // Meters relative to the coordinate space's origin. Floats lose precision far out, but only
+    // by a tiny fraction of the orbit being traced
+    double const scale = math::mul_2pow<double, int>(1.0, -precision);
+
+    rData.row.resize(std::size_t(count) * 3);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        rData.row[i * 3]     = float(double(x[i]) * scale);
+        rData.row[i * 3 + 1] = float(double(y[i]) * scale);
+        rData.row[i * 3 + 2] = float(double(z[i]) * scale);
+    }
+
+    rData.head          = (rData.head + 1) % rData.trailLength;
+    rData.sampleCount   = std::min(rData.sampleCount + 1, rData.trailLength);
+
+    rData.samples.setSubData(GLintptr(std::size_t(rData.head) * rData.row.size() * sizeof(float)), rData.row);
+}
+
+void adera::shader::draw_orbit_trails(
+        ACtxDrawOrbitTrails&        rData,
+        RenderGL&                   rRenderGl,
+        ViewProjMatrix const&       viewProj,
+        CoordTransformer const&     spaceToScene,
+        int const                   scenePrecision)
+{
+    using Magnum::GL::Renderer;
+    using Matrix4d = Magnum::Math::Matrix4<double>;
+    using Vector3d = Magnum::Math::Vector3<double>;
+
+    if (rData.sampleCount < 2)
+    {
+        return;
+    }
+
+    // Move the trails relative to the camera in double precision, the space's origin can be far
+    double const sceneScale = math::mul_2pow<double, int>(1.0, -scenePrecision);
+    double const modelScale = math::mul_2pow<double, int>(1.0, spaceToScene.m_n - scenePrecision + rData.precision);
+
+    Vector3d const spaceOrigin = Vector3d(spaceToScene.transform_position({0, 0, 0})) * sceneScale
+                               - Vector3d(viewProj.m_origin);
+
+    Matrix4d const spaceToCamera = Matrix4d::translation(spaceOrigin)
+                                 * Matrix4d{spaceToScene.rotation().toMatrix()}
+                                 * Matrix4d::scaling(Vector3d{modelScale});
+
+    rData.samples.bind(Magnum::GL::Buffer::Target::ShaderStorage, OrbitTrailShader::smc_samplesBinding);
+
+    // Faded out ends are see-through, and trails shouldn't hide each other
+    Renderer::enable(Renderer::Feature::DepthTest);
+    Renderer::enable(Renderer::Feature::Blending);
+    Renderer::setBlendFunction(
+            Renderer::BlendFunction::SourceAlpha,
+            Renderer::BlendFunction::OneMinusSourceAlpha);
+    Renderer::setDepthMask(GL_FALSE);
+
+    rData.shader
+        .setProjectionMatrix    (viewProj.m_proj)
+        .setModelViewMatrix     (viewProj.m_viewRotation * Magnum::Matrix4{spaceToCamera})
+        .setRing                (Magnum::Int(rData.satCount), Magnum::Int(rData.trailLength),
+                                 Magnum::Int(rData.head),     Magnum::Int(rData.sampleCount))
+        .setColor               (rData.color);
+
+    rData.strips.setCount(Magnum::Int(rData.sampleCount));
+    rData.strips.setInstanceCount(Magnum::Int(rData.satCount));
+    rData.shader.draw(rData.strips);
+    SysRenderGL::count_draw(rRenderGl, rData.strips, rData.satCount);
+
+    Renderer::setDepthMask(GL_TRUE);
+    Renderer::disable(Renderer::Feature::Blending);
+}
+
+OrbitTrailShader::OrbitTrailShader(ProgramBinaryCacheGL const* pCache)
+{
+    using namespace Magnum;
+
+    std::filesystem::path const vertPath = "OSPData/adera/Shaders/OrbitTrail.vert";
+    std::filesystem::path const fragPath = "OSPData/adera/Shaders/OrbitTrail.frag";
+
+    std::uint64_t const cacheKey = (pCache != nullptr) ? pCache->key({vertPath, fragPath}) : 0;
+    if (pCache == nullptr || ! pCache->load(*this, cacheKey))
+    {
+        GL::Shader vert{GL::Version::GL430, GL::Shader::Type::Vertex};
+        GL::Shader frag{GL::Version::GL430, GL::Shader::Type::Fragment};
+        vert.addFile(vertPath.string());
+        frag.addFile(fragPath.string());
+
+        CORRADE_INTERNAL_ASSERT_OUTPUT(vert.compile() && frag.compile());
+        attachShaders({vert, frag});
+
+        if (pCache != nullptr)
+        {
+            pCache->prepare(*this);
+        }
+        CORRADE_INTERNAL_ASSERT_OUTPUT(link());
+        if (pCache != nullptr)
+        {
+            pCache->store(*this, cacheKey);
+        }
+    }
+}
+
+OrbitTrailShader& OrbitTrailShader::setProjectionMatrix(Magnum::Matrix4 const& matrix)
+{
+    setUniform(static_cast<Magnum::Int>(UniformPos::ProjMat), matrix);
+    return *this;
+}
+
+OrbitTrailShader& OrbitTrailShader::setModelViewMatrix(Magnum::Matrix4 const& matrix)
+{
+    setUniform(static_cast<Magnum::Int>(UniformPos::ModelViewMat), matrix);
+    return *this;
+}
+
+OrbitTrailShader& OrbitTrailShader::setRing(
+        Magnum::Int const satCount,
+        Magnum::Int const trailLength,
+        Magnum::Int const head,
+        Magnum::Int const sampleCount)
+{
+    setUniform(static_cast<Magnum::Int>(UniformPos::SatCount),      satCount);
+    setUniform(static_cast<Magnum::Int>(UniformPos::TrailLength),   trailLength);
+    setUniform(static_cast<Magnum::Int>(UniformPos::Head),          head);
+    setUniform(static_cast<Magnum::Int>(UniformPos::SampleCount),   sampleCount);
+    return *this;
+}
+
+OrbitTrailShader& OrbitTrailShader::setColor(Magnum::Color4 const& color)
+{
+    setUniform(static_cast<Magnum::Int>(UniformPos::Color), color);
+    return *this;
+}
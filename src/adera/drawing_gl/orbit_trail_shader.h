@@ -0,0 +1,171 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include <osp/drawing_gl/rendergl.h>
+#include <osp/universe/coordinates.h>
+
+#include <Magnum/GL/AbstractShaderProgram.h>
+#include <Magnum/GL/Buffer.h>
+#include <Magnum/GL/Mesh.h>
+#include <Magnum/Math/Color.h>
+
+#include <Magnum/Magnum.h> // for Magnum::Int
+
+#include <cstdint>
+#include <vector>
+
+namespace adera::shader
+{
+
+/**
+ * @brief Draws a fading line strip behind each satellite from a ring buffer of past positions
+ *
+ * All trails are one instanced line strip draw, with positions read from a shader storage buffer
+ * of tightly packed xyz floats. Requires OpenGL 4.3.
+ */
+class OrbitTrailShader : public Magnum::GL::AbstractShaderProgram
+{
+public:
+
+    // Outputs
+    enum : Magnum::UnsignedInt
+    {
+        ColorOutput = 0
+    };
+
+    // Shader storage buffer binding of the sample ring buffer
+    static constexpr Magnum::UnsignedInt smc_samplesBinding = 0;
+
+    explicit OrbitTrailShader(Corrade::NoCreateT) noexcept : AbstractShaderProgram{Corrade::NoCreate} { }
+
+    /**
+     * @param pCache    [in] Optional program binary cache to load from and store to
+     */
+    explicit OrbitTrailShader(osp::draw::ProgramBinaryCacheGL const* pCache = nullptr);
+
+    OrbitTrailShader& setProjectionMatrix(Magnum::Matrix4 const& matrix);
+    OrbitTrailShader& setModelViewMatrix(Magnum::Matrix4 const& matrix);
+
+    /**
+     * @param satCount      [in] Satellites per ring buffer row
+     * @param trailLength   [in] Rows in the ring buffer
+     * @param head          [in] Row of the newest sample
+     * @param sampleCount   [in] Rows written so far, up to trailLength
+     */
+    OrbitTrailShader& setRing(Magnum::Int satCount, Magnum::Int trailLength, Magnum::Int head, Magnum::Int sampleCount);
+
+    OrbitTrailShader& setColor(Magnum::Color4 const& color);
+
+private:
+
+    // Uniforms
+    enum class UniformPos : Magnum::Int
+    {
+        ProjMat = 0,
+        ModelViewMat = 1,
+        SatCount = 2,
+        TrailLength = 3,
+        Head = 4,
+        SampleCount = 5,
+        Color = 6
+    };
+
+    // Hide irrelevant calls
+    using Magnum::GL::AbstractShaderProgram::drawTransformFeedback;
+    using Magnum::GL::AbstractShaderProgram::dispatchCompute;
+};
+
+/**
+ * @brief Required data for drawing orbit trails
+ *
+ * The ring buffer holds trailLength rows of positions for all satellites, so a tick only uploads
+ * one row no matter how long the trails are.
+ */
+struct ACtxDrawOrbitTrails
+{
+    OrbitTrailShader                    shader          {Corrade::NoCreate};
+
+    // No vertex buffers, samples come from gl_VertexID and gl_InstanceID
+    Magnum::GL::Mesh                    strips          {Corrade::NoCreate};
+
+    Magnum::GL::Buffer                  samples         {Corrade::NoCreate};
+
+    /// One row of samples, reused between ticks
+    std::vector<float>                  row;
+
+    std::uint32_t                       trailLength     {512};
+    std::uint32_t                       satCount        {0};
+    std::uint32_t                       head            {0};
+    std::uint32_t                       sampleCount     {0};
+
+    /// Record a sample every this many ticks, longer trails for the same GPU memory
+    std::uint32_t                       sampleInterval  {4};
+    std::uint32_t                       ticksToSample   {0};
+
+    /// Precision of the coordinate space samples were taken from
+    int                                 precision       {0};
+
+    Magnum::Color4                      color           {0.4f, 0.7f, 1.0f, 0.8f};
+};
+
+/**
+ * @brief Create OrbitTrailShader and its attribute-less line strip mesh
+ *
+ * @param trailLength   [in] Samples kept per satellite
+ * @param pCache        [in] Optional program binary cache, usually RenderGL::m_programCache
+ */
+void setup_orbit_trail_shader(ACtxDrawOrbitTrails& rData, std::uint32_t trailLength, osp::draw::ProgramBinaryCacheGL const* pCache = nullptr);
+
+/**
+ * @brief Call once per simulation tick to add the current satellite positions to the trails
+ *
+ * Only every ACtxDrawOrbitTrails::sampleInterval-th tick writes a row, uploaded with a single
+ * glBufferSubData. Trails are cleared if the satellite count or precision changes.
+ *
+ * @param x,y,z         [in] Satellite positions, e.g. from sat_views
+ * @param precision     [in] Precision of the satellites' coordinate space
+ */
+void append_orbit_trail_samples(
+        ACtxDrawOrbitTrails&                                        rData,
+        osp::universe::SpaceIntViewConst_t const&                   x,
+        osp::universe::SpaceIntViewConst_t const&                   y,
+        osp::universe::SpaceIntViewConst_t const&                   z,
+        int                                                         precision);
+
+/**
+ * @brief Draw all trails with one instanced draw call
+ *
+ * @param spaceToScene      [in] Transform from the satellites' coordinate space into the scene
+ * @param scenePrecision    [in] Precision of the scene coordinate space
+ */
+void draw_orbit_trails(
+        ACtxDrawOrbitTrails&                    rData,
+        osp::draw::RenderGL&                    rRenderGl,
+        osp::draw::ViewProjMatrix const&        viewProj,
+        osp::universe::CoordTransformer const&  spaceToScene,
+        int                                     scenePrecision);
+
+} // namespace adera::shader
@@ -30,13 +30,61 @@ using namespace Magnum::Math::Literals;
 using namespace osp;
 using namespace osp::draw;
 
+namespace
+{
+
+template <typename TEXTURE_T>
+void bind_diffuse(adera::shader::PhongGL &rShader, TEXTURE_T &rTexture)
+{
+    using Flag = adera::shader::PhongGL::Flag;
+
+    rShader.bindDiffuseTexture(rTexture);
+
+    if (rShader.flags() & (Flag::AmbientTexture | Flag::AlphaMask))
+    {
+        rShader.bindAmbientTexture(rTexture);
+    }
+}
+
+} // namespace
+
+// TODO: find a better way to deal with lights instead of hard-coding it
+void adera::shader::set_phong_lights(PhongGL &rShader, ViewProjMatrix const& viewProj)
+{
+    // Lights with w=0.0f are directional lights
+    // Directonal lights are camera-relative, so we need 'viewProj.m_view *'
+    auto const lightPositions =
+    {
+        viewProj.m_view * Vector4{ Vector3{0.2f, 0.6f, 0.5f}.normalized(), 0.0f},
+        viewProj.m_view * Vector4{-Vector3{0.0f, 0.0f, 1.0f}, 0.0f}
+    };
+
+    auto const lightColors =
+    {
+        0xddd4Cd_rgbf,
+        0x32354e_rgbf
+    };
+
+    auto const lightSpecColors =
+    {
+        0xfff5ed_rgbf,
+        0x000000_rgbf
+    };
+
+    rShader
+        .setAmbientColor(0x1a1e29ff_rgbaf)
+        .setSpecularColor(0xffffff00_rgbaf)
+        .setLightColors(lightColors)
+        .setLightSpecularColors(lightSpecColors)
+        .setLightPositions(lightPositions);
+}
+
+template <bool DIFFUSE_TEX_T>
 void adera::shader::draw_ent_phong(
         DrawEnt                     ent,
         ViewProjMatrix const&       viewProj,
         EntityToDraw::UserData_t    userData) noexcept
 {
-    using Flag = PhongGL::Flag;
-
     void* const pData   = std::get<0>(userData);
     void* const pShader = std::get<1>(userData);
     assert(pData   != nullptr);
@@ -44,11 +92,12 @@ void adera::shader::draw_ent_phong(
 
     auto &rData   = *reinterpret_cast<ACtxDrawPhong*>(pData);
     auto &rShader = *reinterpret_cast<PhongGL*>(pShader);
+    assert(bool(rShader.flags() & PhongGL::Flag::DiffuseTexture) == DIFFUSE_TEX_T);
 
     // Collect uniform information
     Matrix4 const &drawTf = (*rData.pDrawTf)[ent];
 
-    Magnum::Matrix4 entRelative = viewProj.m_view * drawTf;
+    Magnum::Matrix4 entRelative = viewProj.model_view(drawTf);
 
     /* 4th component indicates light type. A value of 0.0f indicates that the
      * light is a direction light coming from the specified direction relative
@@ -56,16 +105,10 @@ void adera::shader::draw_ent_phong(
      */
     //Vector4 light = ;
 
-    if (rShader.flags() & Flag::DiffuseTexture)
+    if constexpr (DIFFUSE_TEX_T)
     {
         TexGlId const texGlId = (*rData.pDiffuseTexId)[ent].m_glId;
-        Magnum::GL::Texture2D &rTexture = rData.pTexGl->get(texGlId);
-        rShader.bindDiffuseTexture(rTexture);
-
-        if (rShader.flags() & (Flag::AmbientTexture | Flag::AlphaMask))
-        {
-            rShader.bindAmbientTexture(rTexture);
-        }
+        bind_diffuse(rShader, rData.pTexGl->get(texGlId));
     }
 
     if (rData.pColor != nullptr)
@@ -76,39 +119,81 @@ void adera::shader::draw_ent_phong(
     MeshGlId const      meshId = (*rData.pMeshId)[ent].m_glId;
     Magnum::GL::Mesh    &rMesh = rData.pMeshGl->get(meshId);
 
-    Matrix3 a{viewProj.m_view};
-
-
-    // Lights with w=0.0f are directional lights
-    // Directonal lights are camera-relative, so we need 'viewProj.m_view *'
-    auto const lightPositions =
-    {
-        viewProj.m_view * Vector4{ Vector3{0.2f, 0.6f, 0.5f}.normalized(), 0.0f},
-        viewProj.m_view * Vector4{-Vector3{0.0f, 0.0f, 1.0f}, 0.0f}
-    };
-
-    auto const lightColors =
-    {
-        0xddd4Cd_rgbf,
-        0x32354e_rgbf
-    };
+    set_phong_lights(rShader, viewProj);
 
-    auto const lightSpecColors =
-    {
-        0xfff5ed_rgbf,
-        0x000000_rgbf
-    };
-
-    // TODO: find a better way to deal with lights instead of hard-coding it
     rShader
-        .setAmbientColor(0x1a1e29ff_rgbaf)
-        .setSpecularColor(0xffffff00_rgbaf)
-        .setLightColors(lightColors)
-        .setLightSpecularColors(lightSpecColors)
-        .setLightPositions(lightPositions)
         .setTransformationMatrix(entRelative)
         .setProjectionMatrix(viewProj.m_proj)
         .setNormalMatrix(entRelative.normalMatrix())
         .draw(rMesh);
+
+    SysRenderGL::count_draw(*rData.pRenderGl, rMesh);
+}
+
+template void adera::shader::draw_ent_phong<true>(
+        DrawEnt, ViewProjMatrix const&, EntityToDraw::UserData_t) noexcept;
+template void adera::shader::draw_ent_phong<false>(
+        DrawEnt, ViewProjMatrix const&, EntityToDraw::UserData_t) noexcept;
+
+void adera::shader::draw_instanced_phong(
+        DrawEntSet_t const&             visible,
+        ViewProjMatrix const&           viewProj,
+        InstancedToDraw::UserData_t     userData) noexcept
+{
+    void* const pData = std::get<0>(userData);
+    assert(pData != nullptr);
+
+    auto &rData     = *reinterpret_cast<ACtxDrawPhong*>(pData);
+    auto &rScratch  = rData.instanceScratch;
+
+    bool const useArrays = rData.shaderInstancedDiffuseArray.id() != 0;
+
+    SysRenderGL::group_instances(rScratch, rData.instancedEnts, visible,
+                                 rData.pScnRender->m_materials[rData.materialId].m_ents,
+                                 *rData.pMeshId, *rData.pDiffuseTexId,
+                                 useArrays ? rData.pTexArrays : nullptr);
+
+    for (InstanceScratchGL::Group const& group : rScratch.m_groups)
+    {
+        bool const isArray    = group.texArray != lgrn::id_null<std::uint32_t>();
+        bool const hasTexture = group.texId != lgrn::id_null<TexGlId>();
+        PhongGL &rShader = isArray    ? rData.shaderInstancedDiffuseArray
+                         : hasTexture ? rData.shaderInstancedDiffuse
+                                      : rData.shaderInstancedUntextured;
+
+        rScratch.m_data.resize(group.count);
+        for (std::size_t i = 0; i < group.count; ++i)
+        {
+            DrawEnt const ent = rScratch.m_sorted[group.first + i].ent;
+            Matrix4 const entRelative = viewProj.model_view((*rData.pDrawTf)[ent]);
+            float const   layer = isArray ? SysRenderGL::texture_layer(*rData.pTexArrays, *rData.pDiffuseTexId, ent) : 0.0f;
+
+            rScratch.m_data[i] = {
+                .transformation     = entRelative,
+                .normalMatrix       = entRelative.normalMatrix(),
+                .color              = (rData.pColor != nullptr) ? (*rData.pColor)[ent] : Magnum::Color4{1.0f},
+                .textureOffsetLayer = {0.0f, 0.0f, layer}};
+        }
+
+        if (isArray)
+        {
+            bind_diffuse(rShader, rData.pTexArrays->m_arrays[group.texArray].texture);
+        }
+        else if (hasTexture)
+        {
+            bind_diffuse(rShader, rData.pTexGl->get(group.texId));
+        }
+
+        set_phong_lights(rShader, viewProj);
+
+        // Per-instance transforms and colors are multiplied with these
+        rShader
+            .setDiffuseColor(Magnum::Color4{1.0f})
+            .setTransformationMatrix(Matrix4{})
+            .setProjectionMatrix(viewProj.m_proj)
+            .setNormalMatrix(Magnum::Matrix3x3{});
+
+        SysRenderGL::draw_instances(*rData.pRenderGl, group.meshId, rScratch.m_data, rShader);
+    }
 }
 
@@ -41,6 +41,21 @@ struct ACtxDrawPhong
     PhongGL                     shaderUntextured    {Corrade::NoCreate};
     PhongGL                     shaderDiffuse       {Corrade::NoCreate};
 
+    // Used for instancedEnts, needs Flag::InstancedTransformation and Flag::VertexColor
+    PhongGL                     shaderInstancedUntextured   {Corrade::NoCreate};
+    PhongGL                     shaderInstancedDiffuse      {Corrade::NoCreate};
+
+    // Optional, also needs Flag::TextureArrays and Flag::InstancedTextureOffset. If created,
+    // entities with textures in RenderGL::m_texArrays are drawn with it, mixing textures.
+    PhongGL                     shaderInstancedDiffuseArray {Corrade::NoCreate};
+
+    /// If true, sync_drawent_phong puts opaque entities in instancedEnts instead of a RenderGroup
+    bool                        instancing          {false};
+
+    /// Entities drawn by draw_instanced_phong. Register it in RenderGroup::instanced.
+    osp::draw::DrawEntSet_t     instancedEnts;
+    osp::draw::InstanceScratchGL instanceScratch;
+
     osp::draw::DrawTransforms_t    *pDrawTf         {nullptr};
     osp::draw::DrawEntColors_t     *pColor          {nullptr};
     osp::draw::TexGlEntStorage_t   *pDiffuseTexId   {nullptr};
@@ -48,6 +63,10 @@ struct ACtxDrawPhong
 
     osp::draw::TexGlStorage_t      *pTexGl          {nullptr};
     osp::draw::MeshGlStorage_t     *pMeshGl         {nullptr};
+    osp::draw::TextureArraysGL     *pTexArrays      {nullptr};
+
+    osp::draw::ACtxSceneRender     *pScnRender      {nullptr};
+    osp::draw::RenderGL            *pRenderGl       {nullptr};
 
     osp::draw::MaterialId materialId { lgrn::id_null<osp::draw::MaterialId>() };
 
@@ -61,19 +80,49 @@ struct ACtxDrawPhong
         pMeshId         = &rScnRenderGl .m_meshId;
         pTexGl          = &rRenderGl    .m_texGl;
         pMeshGl         = &rRenderGl    .m_meshGl;
+        pTexArrays      = &rRenderGl    .m_texArrays;
+        pScnRender      = &rScnRender;
+        pRenderGl       = &rRenderGl;
     }
 };
 
+/**
+ * @brief Set the hard-coded scene lights, for shaders made with a light count of 2
+ */
+void set_phong_lights(PhongGL &rShader, osp::draw::ViewProjMatrix const& viewProj);
+
+/**
+ * @brief Draw a single entity with a Phong shader
+ *
+ * Specialized on whether the shader has Flag::DiffuseTexture. sync_drawent_phong picks the one
+ * matching the shader it assigns, so drawing doesn't branch on it per entity.
+ */
+template <bool DIFFUSE_TEX_T>
 void draw_ent_phong(
         osp::draw::DrawEnt                   ent,
         osp::draw::ViewProjMatrix const&     viewProj,
         osp::draw::EntityToDraw::UserData_t  userData) noexcept;
 
+extern template void draw_ent_phong<true>(
+        osp::draw::DrawEnt, osp::draw::ViewProjMatrix const&, osp::draw::EntityToDraw::UserData_t) noexcept;
+extern template void draw_ent_phong<false>(
+        osp::draw::DrawEnt, osp::draw::ViewProjMatrix const&, osp::draw::EntityToDraw::UserData_t) noexcept;
+
+/**
+ * @brief Draw ACtxDrawPhong::instancedEnts, one instanced draw call per mesh and texture
+ *
+ * With shaderInstancedDiffuseArray, one draw call per mesh and texture array instead.
+ */
+void draw_instanced_phong(
+        osp::draw::DrawEntSet_t const&          visible,
+        osp::draw::ViewProjMatrix const&        viewProj,
+        osp::draw::InstancedToDraw::UserData_t  userData) noexcept;
+
 struct ArgsForSyncDrawEntPhong
 {
     osp::draw::DrawEntSet_t const&              hasMaterial;
-    osp::draw::RenderGroup::DrawEnts_t *const   pStorageOpaque;
-    osp::draw::RenderGroup::DrawEnts_t *const   pStorageTransparent;
+    osp::draw::RenderGroupWrites *const         pWritesOpaque;
+    osp::draw::RenderGroupWrites *const         pWritesTransparent;
     osp::draw::DrawEntSet_t const&              opaque;
     osp::draw::DrawEntSet_t const&              transparent;
     osp::draw::TexGlEntStorage_t const&         diffuse;
@@ -90,22 +139,41 @@ inline void sync_drawent_phong(osp::draw::DrawEnt ent, ArgsForSyncDrawEntPhong c
                      ? &args.rData.shaderDiffuse
                      : &args.rData.shaderUntextured;
 
-    if (args.pStorageTransparent != nullptr)
+    osp::draw::EntityToDraw::ShaderDrawFnc_t const drawFnc = hasTexture
+                                                           ? &draw_ent_phong<true>
+                                                           : &draw_ent_phong<false>;
+
+    if (args.pWritesTransparent != nullptr)
     {
         auto value = (hasMaterial && args.transparent.contains(ent))
-                   ? std::make_optional(osp::draw::EntityToDraw{&draw_ent_phong, {&args.rData, pShader}})
+                   ? std::make_optional(osp::draw::EntityToDraw{drawFnc, {&args.rData, pShader}})
                    : std::nullopt;
 
-        osp::storage_assign(*args.pStorageTransparent, ent, std::move(value));
+        args.pWritesTransparent->assign(ent, std::move(value));
+    }
+
+    bool const opaque = hasMaterial && args.opaque.contains(ent);
+
+    if (args.rData.instancing)
+    {
+        args.rData.instancedEnts.resize(args.rData.pDrawTf->size());
+        if (opaque)
+        {
+            args.rData.instancedEnts.insert(ent);
+        }
+        else
+        {
+            args.rData.instancedEnts.erase(ent);
+        }
     }
 
-    if (args.pStorageOpaque != nullptr)
+    if (args.pWritesOpaque != nullptr)
     {
-        auto value = (hasMaterial && args.opaque.contains(ent))
-                   ? std::make_optional(osp::draw::EntityToDraw{&draw_ent_phong, {&args.rData, pShader}})
+        auto value = (opaque && ! args.rData.instancing)
+                   ? std::make_optional(osp::draw::EntityToDraw{drawFnc, {&args.rData, pShader}})
                    : std::nullopt;
 
-        osp::storage_assign(*args.pStorageOpaque, ent, std::move(value));
+        args.pWritesOpaque->assign(ent, std::move(value));
     }
 }
 
@@ -24,106 +24,177 @@
  */
 #include "plume_shader.h"                  // IWYU pragma: associated
 
-#if 0
-
-#include <adera/Plume.h>                  // for PlumeEffectData
-#include <adera/SysExhaustPlume.h>        // for ACompExhaustPlume
-
-#include <osp/Active/basic.h>             // for ACompCamera
-#include <osp/Active/drawing.h>           // for ACompDrawTransform
-#include <osp/Active/SysRender.h>         // for ACompMesh
-#include <osp/Active/activetypes.h>       // for basic_sparse_set, ActiveEnt
-
+#include <Magnum/GL/Renderer.h>
 #include <Magnum/GL/Shader.h>             // for Shader, Shader::Type
-#include <Magnum/GL/Texture.h>            // for Texture2D
+#include <Magnum/GL/TextureFormat.h>
 #include <Magnum/GL/Version.h>            // for Version, Version::GL430
-#include <Magnum/GL/Renderer.h>
-
-#include <Magnum/Magnum.h>                // for Int, Color4, Matrix3x3, Matrix4
+#include <Magnum/ImageView.h>
+#include <Magnum/PixelFormat.h>
 
 // used by attachShaders
 #include <Corrade/Containers/Iterable.h>  // for Containers::Iterable
+#include <Corrade/Containers/ArrayViewStl.h>
 
 #include <Corrade/Utility/Assert.h>       // for CORRADE_INTERNAL_ASSERT_OUTPUT
 
-#include <string_view>                    // for std::string_view
-
-// IWYU pragma: no_include "osp/types.h"
-
-// IWYU pragma: no_include <memory>
-// IWYU pragma: no_include <cstddef>
-// IWYU pragma: no_include <stdint.h>
-// IWYU pragma: no_include <algorithm>
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <random>
 
 using namespace osp;
-using namespace osp::active;
-using namespace adera::active;
+using namespace osp::draw;
+using namespace adera;
 using namespace adera::shader;
 
-void PlumeShader::draw_plume(
-        ActiveEnt ent,
-        ViewProjMatrix const& viewProj,
-        EntityToDraw::UserData_t userData) noexcept
+void adera::shader::setup_plume_shader(ACtxDrawPlume& rData, ProgramBinaryCacheGL const* pCache)
 {
-    using Magnum::GL::Renderer;
-    using Magnum::GL::Texture2D;
-
-    ACtxPlumeData &rData = *reinterpret_cast<ACtxPlumeData*>(userData[0]);
-
-    // Collect uniform data
-    Matrix4 const &drawTf               = rData.m_pDrawTf->get(ent);
-    ACompExhaustPlume const &comp       = rData.m_pExaustPlumes->get(ent);
-    PlumeEffectData const &effect       = comp.m_effect;
-    MeshGlId const meshId               = rData.m_pMeshId->get(ent);
-    Magnum::GL::Mesh &rMesh             = rData.m_pMeshGl->get(meshId);
-    Magnum::GL::Texture2D &rTmpTex      = rData.m_pTexGl->get(rData.m_tmpTex);
-
-    Matrix4 const entRelative = viewProj.m_view * drawTf;
-
-    rData.m_shader
-        .bindNozzleNoiseTexture     (rTmpTex)
-        .bindCombustionNoiseTexture (rTmpTex)
-        .setMeshZBounds             (effect.m_zMax, effect.m_zMin)
-        .setBaseColor               (effect.m_color)
-        .setFlowVelocity            (effect.m_flowVelocity)
-        .updateTime                 (comp.m_time)
-        .setPower                   (comp.m_powerLevel)
-        .setTransformationMatrix    (entRelative)
-        .setProjectionMatrix        (viewProj.m_proj)
-        .setNormalMatrix            (entRelative.normalMatrix());
-
-    // Draw back face
-    Renderer::setFaceCullingMode(Renderer::PolygonFacing::Front);
-    rData.m_shader.draw(rMesh);
-
-    // Draw front face
-    Renderer::setFaceCullingMode(Renderer::PolygonFacing::Back);
-    rData.m_shader.draw(rMesh);
+    using namespace Magnum;
+
+    rData.shader            = PlumeShader{pCache};
+    rData.instanceBuffer    = GL::Buffer{};
+
+    // Tileable value noise: random values, smoothed with a wrapping box blur
+    constexpr int size = 64;
+    std::array<std::uint8_t, size * size> random;
+    std::array<std::uint8_t, size * size> smooth;
+
+    std::minstd_rand rng{1337};
+    std::uniform_int_distribution<int> dist{0, 255};
+    for (std::uint8_t &rValue : random)
+    {
+        rValue = std::uint8_t(dist(rng));
+    }
+
+    for (int y = 0; y < size; ++y)
+    {
+        for (int x = 0; x < size; ++x)
+        {
+            int sum = 0;
+            for (int dy = -1; dy <= 1; ++dy)
+            {
+                for (int dx = -1; dx <= 1; ++dx)
+                {
+                    sum += random[((y + dy + size) % size) * size + ((x + dx + size) % size)];
+                }
+            }
+            smooth[y * size + x] = std::uint8_t(sum / 9);
+        }
+    }
+
+    rData.noiseTex = GL::Texture2D{};
+    rData.noiseTex
+        .setMinificationFilter(GL::SamplerFilter::Linear)
+        .setMagnificationFilter(GL::SamplerFilter::Linear)
+        .setWrapping(GL::SamplerWrapping::Repeat)
+        .setStorage(1, GL::TextureFormat::R8, {size, size})
+        .setSubImage(0, {}, ImageView2D{PixelFormat::R8Unorm, {size, size}, smooth});
 }
 
-void PlumeShader::assign_plumes(
-        RenderGroup::ArrayView_t entities,
-        RenderGroup::Storage_t& rStorage,
-        ACtxPlumeData& rData)
+void adera::shader::draw_plumes(
+        ACtxDrawPlume&          rData,
+        DrawEntSet_t const&     visible,
+        ViewProjMatrix const&   viewProj)
 {
-    for (ActiveEnt ent : entities)
+    using Magnum::GL::Renderer;
+
+    Material const &rMat    = rData.pScnRender->m_materials[rData.materialId];
+    auto &rScratch          = rData.instanceScratch;
+
+    SysRenderGL::group_instances(rScratch, rMat.m_ents, visible, rMat.m_ents,
+                                 *rData.pMeshId, *rData.pDiffuseTexId);
+
+    if (rScratch.m_groups.empty())
     {
-        //rStorage.emplace(ent, EntityToDraw{&draw_plume, {&rData} });
+        return;
+    }
+
+    // Pack every plume into one buffer, the only per-plume CPU work
+    ACtxPlumes const &plumes = *rData.pPlumes;
+    rData.instances.resize(rScratch.m_sorted.size());
+    for (std::size_t i = 0; i < rScratch.m_sorted.size(); ++i)
+    {
+        DrawEnt const ent = rScratch.m_sorted[i].ent;
+        PlumeParams const params = (plumes.params.size() > std::size_t(ent)) ? plumes.params[ent] : PlumeParams{};
+
+        rData.instances[i] = {
+            .modelView  = viewProj.model_view((*rData.pDrawTf)[ent]),
+            .params     = {params.power, params.flowVelocity, params.topZ, params.bottomZ},
+            .color      = params.color };
+    }
+
+    rData.instanceBuffer.setData(rData.instances, Magnum::GL::BufferUsage::StreamDraw);
+    rData.instanceBuffer.bind(Magnum::GL::Buffer::Target::ShaderStorage, PlumeShader::smc_instanceBinding);
+
+    // Additive, and doesn't occlude anything
+    Renderer::enable(Renderer::Feature::DepthTest);
+    Renderer::enable(Renderer::Feature::FaceCulling);
+    Renderer::enable(Renderer::Feature::Blending);
+    Renderer::setBlendFunction(
+            Renderer::BlendFunction::SourceAlpha,
+            Renderer::BlendFunction::One);
+    Renderer::setDepthMask(GL_FALSE);
+
+    rData.shader
+        .bindNozzleNoiseTexture     (rData.noiseTex)
+        .bindCombustionNoiseTexture (rData.noiseTex)
+        .setTime                    (plumes.time)
+        .setProjectionMatrix        (viewProj.m_proj);
+
+    for (InstanceScratchGL::Group const& group : rScratch.m_groups)
+    {
+        Magnum::GL::Mesh &rMesh = rData.pRenderGl->m_meshGl.get(group.meshId);
+
+        rData.shader.setInstanceOffset(Magnum::Int(group.first));
+        rMesh.setInstanceCount(Magnum::Int(group.count));
+
+        // Draw back face
+        Renderer::setFaceCullingMode(Renderer::PolygonFacing::Front);
+        rData.shader.draw(rMesh);
+
+        // Draw front face
+        Renderer::setFaceCullingMode(Renderer::PolygonFacing::Back);
+        rData.shader.draw(rMesh);
+
+        SysRenderGL::count_draw(*rData.pRenderGl, rMesh, std::uint32_t(group.count));
+        SysRenderGL::count_draw(*rData.pRenderGl, rMesh, std::uint32_t(group.count));
+
+        // Meshes are shared with non-instanced shaders
+        rMesh.setInstanceCount(1);
     }
+
+    Renderer::setDepthMask(GL_TRUE);
+    Renderer::disable(Renderer::Feature::Blending);
 }
 
-void PlumeShader::init()
+PlumeShader::PlumeShader(ProgramBinaryCacheGL const* pCache)
 {
     using namespace Magnum;
 
-    GL::Shader vert{GL::Version::GL430, GL::Shader::Type::Vertex};
-    GL::Shader frag{GL::Version::GL430, GL::Shader::Type::Fragment};
-    vert.addFile("OSPData/adera/Shaders/PlumeShader.vert");
-    frag.addFile("OSPData/adera/Shaders/PlumeShader.frag");
+    std::filesystem::path const vertPath = "OSPData/adera/Shaders/PlumeShader.vert";
+    std::filesystem::path const fragPath = "OSPData/adera/Shaders/PlumeShader.frag";
 
-    CORRADE_INTERNAL_ASSERT_OUTPUT(vert.compile() && frag.compile());
-    attachShaders({vert, frag});
-    CORRADE_INTERNAL_ASSERT_OUTPUT(link());
+    std::uint64_t const cacheKey = (pCache != nullptr) ? pCache->key({vertPath, fragPath}) : 0;
+    if (pCache == nullptr || ! pCache->load(*this, cacheKey))
+    {
+        GL::Shader vert{GL::Version::GL430, GL::Shader::Type::Vertex};
+        GL::Shader frag{GL::Version::GL430, GL::Shader::Type::Fragment};
+        vert.addFile(vertPath.string());
+        frag.addFile(fragPath.string());
+
+        CORRADE_INTERNAL_ASSERT_OUTPUT(vert.compile() && frag.compile());
+        attachShaders({vert, frag});
+
+        if (pCache != nullptr)
+        {
+            pCache->prepare(*this);
+        }
+        CORRADE_INTERNAL_ASSERT_OUTPUT(link());
+        if (pCache != nullptr)
+        {
+            pCache->store(*this, cacheKey);
+        }
+    }
 
     // Set TexSampler2D uniforms
     setUniform(
@@ -134,70 +205,32 @@ void PlumeShader::init()
         static_cast<Int>(TextureSlot::CombustionNoiseTexUnit));
 }
 
-PlumeShader::PlumeShader()
-{
-    init();
-}
-
 PlumeShader& PlumeShader::setProjectionMatrix(Magnum::Matrix4 const& matrix)
 {
     setUniform(static_cast<Magnum::Int>(UniformPos::ProjMat), matrix);
     return *this;
 }
 
-PlumeShader& PlumeShader::setTransformationMatrix(Magnum::Matrix4 const& matrix)
-{
-    setUniform(static_cast<Magnum::Int>(UniformPos::ModelTransformMat), matrix);
-    return *this;
-}
-
-PlumeShader& PlumeShader::setNormalMatrix(Magnum::Matrix3x3 const& matrix)
+PlumeShader& PlumeShader::setInstanceOffset(Magnum::Int const offset)
 {
-    setUniform(static_cast<Magnum::Int>(UniformPos::NormalMat), matrix);
+    setUniform(static_cast<Magnum::Int>(UniformPos::InstanceOffset), offset);
     return *this;
 }
 
-PlumeShader& PlumeShader::setMeshZBounds(float topZ, float bottomZ)
+PlumeShader& PlumeShader::bindNozzleNoiseTexture(Magnum::GL::Texture2D& rTex)
 {
-    setUniform(static_cast<Magnum::Int>(UniformPos::MeshTopZ), topZ);
-    setUniform(static_cast<Magnum::Int>(UniformPos::MeshBottomZ), bottomZ);
+    rTex.bind(static_cast<Magnum::Int>(TextureSlot::NozzleNoiseTexUnit));
     return *this;
 }
 
-PlumeShader& PlumeShader::bindNozzleNoiseTexture(Magnum::GL::Texture2D& tex)
+PlumeShader& PlumeShader::bindCombustionNoiseTexture(Magnum::GL::Texture2D& rTex)
 {
-    tex.bind(static_cast<Magnum::Int>(TextureSlot::NozzleNoiseTexUnit));
+    rTex.bind(static_cast<Magnum::Int>(TextureSlot::CombustionNoiseTexUnit));
     return *this;
 }
 
-PlumeShader& PlumeShader::bindCombustionNoiseTexture(Magnum::GL::Texture2D& tex)
+PlumeShader& PlumeShader::setTime(float const time)
 {
-    tex.bind(static_cast<Magnum::Int>(TextureSlot::CombustionNoiseTexUnit));
+    setUniform(static_cast<Magnum::Int>(UniformPos::Time), time);
     return *this;
 }
-
-PlumeShader& PlumeShader::setBaseColor(const Magnum::Color4 color)
-{
-    setUniform(static_cast<Magnum::Int>(UniformPos::BaseColor), color);
-    return *this;
-}
-
-PlumeShader& PlumeShader::setFlowVelocity(const float vel)
-{
-    setUniform(static_cast<Magnum::Int>(UniformPos::FlowVelocity), vel);
-    return *this;
-}
-
-PlumeShader& PlumeShader::updateTime(const float currentTime)
-{
-    setUniform(static_cast<Magnum::Int>(UniformPos::Time), currentTime);
-    return *this;
-}
-
-PlumeShader& PlumeShader::setPower(const float power)
-{
-    setUniform(static_cast<Magnum::Int>(UniformPos::Power), power);
-    return *this;
-}
-
-#endif
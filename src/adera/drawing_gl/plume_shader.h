@@ -24,38 +24,34 @@
  */
 #pragma once
 
-#if 0
+#include "../drawing/plume.h"
 
-#include "../SysExhaustPlume.h"
+#include <osp/drawing_gl/rendergl.h>
 
-#include <osp/Active/opengl/SysRenderGL.h>
-#include <osp/Active/activetypes.h>
-
-#include <Magnum/GL/Texture.h>
 #include <Magnum/GL/AbstractShaderProgram.h>
+#include <Magnum/GL/Buffer.h>
+#include <Magnum/GL/Texture.h>
 
 #include <Magnum/Shaders/GenericGL.h>
 
 #include <Magnum/Magnum.h> // for Magnum::Int
 
-namespace osp::active { class ActiveScene; }
-namespace osp::active { struct ACompCamera; }
+#include <vector>
 
 namespace adera::shader
 {
 
-struct ACtxPlumeData;
-
+/**
+ * @brief Instanced exhaust plume shader
+ *
+ * Per-plume data is read from a shader storage buffer of PlumeInstanceGL indexed by instance, so
+ * all plumes sharing a mesh are drawn with one draw call. Requires OpenGL 4.3.
+ */
 class PlumeShader : public Magnum::GL::AbstractShaderProgram
 {
-
-    using RenderGroup = osp::active::RenderGroup;
-
 public:
     // Vertex attribs
-    Magnum::Shaders::GenericGL3D::Position Position;
-    Magnum::Shaders::GenericGL3D::Normal Normal;
-    Magnum::Shaders::GenericGL3D::TextureCoordinates TextureCoordinates;
+    using Position = Magnum::Shaders::GenericGL3D::Position;
 
     // Outputs
     enum : Magnum::UnsignedInt
@@ -63,37 +59,32 @@ public:
         ColorOutput = 0
     };
 
-    PlumeShader();
+    // Shader storage buffer binding of PlumeInstanceGL
+    static constexpr Magnum::UnsignedInt smc_instanceBinding = 0;
 
-    static void draw_plume(
-            osp::active::ActiveEnt ent,
-            osp::active::ViewProjMatrix const& viewProj,
-            osp::active::EntityToDraw::UserData_t userData) noexcept;
+    explicit PlumeShader(Corrade::NoCreateT) noexcept : AbstractShaderProgram{Corrade::NoCreate} { }
 
-    static void assign_plumes(
-            RenderGroup::ArrayView_t entities,
-            RenderGroup::Storage_t& rStorage,
-            ACtxPlumeData& rData);
+    /**
+     * @param pCache    [in] Optional program binary cache to load from and store to
+     */
+    explicit PlumeShader(osp::draw::ProgramBinaryCacheGL const* pCache = nullptr);
 
-private:
+    PlumeShader& setProjectionMatrix(Magnum::Matrix4 const& matrix);
+    PlumeShader& setInstanceOffset(Magnum::Int offset);
+    PlumeShader& bindNozzleNoiseTexture(Magnum::GL::Texture2D& rTex);
+    PlumeShader& bindCombustionNoiseTexture(Magnum::GL::Texture2D& rTex);
+    PlumeShader& setTime(float time);
 
-    // GL init
-    void init();
+private:
 
     // Uniforms
     enum class UniformPos : Magnum::Int
     {
         ProjMat = 0,
-        ModelTransformMat = 1,
-        NormalMat = 2,
-        MeshTopZ = 3,
-        MeshBottomZ = 4,
+        InstanceOffset = 1,
         NozzleNoiseTex = 5,
         CombustionNoiseTex = 6,
-        BaseColor = 7,
-        FlowVelocity = 8,
-        Time = 9,
-        Power = 10
+        Time = 9
     };
 
     // Texture2D slots
@@ -106,43 +97,81 @@ private:
     // Hide irrelevant calls
     using Magnum::GL::AbstractShaderProgram::drawTransformFeedback;
     using Magnum::GL::AbstractShaderProgram::dispatchCompute;
+};
 
-    // Private uniform setters
-    PlumeShader& setProjectionMatrix(const Magnum::Matrix4& matrix);
-    PlumeShader& setTransformationMatrix(const Magnum::Matrix4& matrix);
-    PlumeShader& setNormalMatrix(const Magnum::Matrix3x3& matrix);
+/**
+ * @brief Per-plume data in PlumeShader's storage buffer, std430 layout
+ */
+struct PlumeInstanceGL
+{
+    Magnum::Matrix4     modelView;
 
-    PlumeShader& setMeshZBounds(float topZ, float bottomZ);
-    PlumeShader& bindNozzleNoiseTexture(Magnum::GL::Texture2D& rTex);
-    PlumeShader& bindCombustionNoiseTexture(Magnum::GL::Texture2D& rTex);
-    PlumeShader& setBaseColor(const Magnum::Color4 color);
-    PlumeShader& setFlowVelocity(const float vel);
-    PlumeShader& updateTime(const float currentTime);
-    PlumeShader& setPower(const float power);
+    /// power, flowVelocity, topZ, bottomZ
+    Magnum::Vector4     params;
+    Magnum::Color4      color;
 };
 
+static_assert(sizeof(PlumeInstanceGL) == 96, "Must match PlumeInstance in PlumeShader.vert");
+
 /**
- * @brief Required data for drawing exaust plumes in the scene
+ * @brief Required data for drawing exhaust plumes in the scene
  */
-struct ACtxPlumeData
+struct ACtxDrawPlume
 {
-    template<typename COMP_T>
-    using acomp_storage_t       = typename osp::active::acomp_storage_t<COMP_T>;
-    using ACompExhaustPlume     = adera::active::ACompExhaustPlume;
-    using MeshGlId              = osp::active::MeshGlId;
-    using TexGlId               = osp::active::TexGlId;
+    PlumeShader                     shader          {Corrade::NoCreate};
+
+    // Used for both nozzle and combustion noise
+    Magnum::GL::Texture2D           noiseTex        {Corrade::NoCreate};
+
+    // All instances of a frame are uploaded with a single call
+    Magnum::GL::Buffer              instanceBuffer  {Corrade::NoCreate};
+    std::vector<PlumeInstanceGL>    instances;
+    osp::draw::InstanceScratchGL    instanceScratch;
+
+    adera::ACtxPlumes              *pPlumes         {nullptr};
 
-    PlumeShader m_shader;
+    osp::draw::DrawTransforms_t    *pDrawTf         {nullptr};
+    osp::draw::TexGlEntStorage_t   *pDiffuseTexId   {nullptr};
+    osp::draw::MeshGlEntStorage_t  *pMeshId         {nullptr};
 
-    TexGlId m_tmpTex;
+    osp::draw::ACtxSceneRender     *pScnRender      {nullptr};
+    osp::draw::RenderGL            *pRenderGl       {nullptr};
 
-    acomp_storage_t<osp::Matrix4>       *m_pDrawTf{nullptr};
-    acomp_storage_t<ACompExhaustPlume>  *m_pExaustPlumes{nullptr};
-    acomp_storage_t<MeshGlId>           *m_pMeshId{nullptr};
-    osp::active::MeshGlStorage_t        *m_pMeshGl{nullptr};
-    osp::active::TexGlStorage_t         *m_pTexGl{nullptr};
+    osp::draw::MaterialId materialId { lgrn::id_null<osp::draw::MaterialId>() };
+
+    constexpr void assign_pointers(osp::draw::ACtxSceneRender&   rScnRender,
+                                   osp::draw::ACtxSceneRenderGL& rScnRenderGl,
+                                   osp::draw::RenderGL&          rRenderGl,
+                                   adera::ACtxPlumes&            rPlumes) noexcept
+    {
+        pDrawTf         = &rScnRender   .m_drawTransform;
+        pDiffuseTexId   = &rScnRenderGl .m_diffuseTexId;
+        pMeshId         = &rScnRenderGl .m_meshId;
+        pScnRender      = &rScnRender;
+        pRenderGl       = &rRenderGl;
+        pPlumes         = &rPlumes;
+    }
 };
 
-} // namespace adera::shader
+/**
+ * @brief Create PlumeShader and its noise texture
+ *
+ * @param pCache    [in] Optional program binary cache, usually RenderGL::m_programCache
+ */
+void setup_plume_shader(ACtxDrawPlume& rData, osp::draw::ProgramBinaryCacheGL const* pCache = nullptr);
+
+/**
+ * @brief Draw all visible plumes in ACtxDrawPlume::materialId, one instanced draw call per mesh
+ *
+ * Plumes are additively blended and don't write depth, so call this after opaque objects.
+ *
+ * @param rData     [ref] Plume shader data
+ * @param visible   [in] Entities allowed to be drawn
+ * @param viewProj  [in] View and projection matrix
+ */
+void draw_plumes(
+        ACtxDrawPlume&                      rData,
+        osp::draw::DrawEntSet_t const&      visible,
+        osp::draw::ViewProjMatrix const&    viewProj);
 
-#endif
+} // namespace adera::shader
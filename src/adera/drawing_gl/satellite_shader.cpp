@@ -0,0 +1,189 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "satellite_shader.h"               // IWYU pragma: associated
+
+#include <osp/core/math_2pow.h>
+
+#include <Magnum/GL/Renderer.h>
+#include <Magnum/GL/Shader.h>             // for Shader, Shader::Type
+#include <Magnum/GL/Version.h>            // for Version, Version::GL430
+#include <Magnum/Mesh.h>
+
+// used by attachShaders
+#include <Corrade/Containers/Iterable.h>  // for Containers::Iterable
+#include <Corrade/Containers/ArrayViewStl.h>
+
+#include <Corrade/Utility/Assert.h>       // for CORRADE_INTERNAL_ASSERT_OUTPUT
+
+#include <filesystem>
+
+using namespace osp;
+using namespace osp::draw;
+using namespace osp::universe;
+using namespace adera::shader;
+
+void adera::shader::setup_satellite_shader(ACtxDrawSatellites& rData, ProgramBinaryCacheGL const* pCache)
+{
+    using namespace Magnum;
+
+    rData.shader            = SatelliteShader{pCache};
+    rData.instanceBuffer    = GL::Buffer{};
+    rData.quad              = GL::Mesh{MeshPrimitive::TriangleStrip};
+    rData.quad.setCount(4);
+}
+
+void adera::shader::write_satellite_instances(
+        ACtxDrawSatellites&                                             rData,
+        CoordTransformer const&                                         spaceToScene,
+        SpaceIntViewConst_t const&                                      x,
+        SpaceIntViewConst_t const&                                      y,
+        SpaceIntViewConst_t const&                                      z,
+        int const                                                       precision,
+        Magnum::Vector3 const&                                          origin,
+        Corrade::Containers::StridedArrayView1D<float const> const      radius,
+        Corrade::Containers::StridedArrayView1D<Magnum::Color3 const> const color,
+        float const                                                     defaultRadius,
+        Magnum::Color3 const                                            defaultColor)
+{
+    using Corrade::Containers::arrayView;
+
+    std::size_t const count = x.size();
+
+    rData.tfX.resize(count);
+    rData.tfY.resize(count);
+    rData.tfZ.resize(count);
+    coord_transform_positions(spaceToScene, x, y, z, arrayView(rData.tfX), arrayView(rData.tfY), arrayView(rData.tfZ));
+
+    double const scale = math::mul_2pow<double, int>(1.0, -precision);
+
+    rData.instances.resize(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        // Subtract the camera position before converting to float, satellites can be far away
+        Magnum::Vector3 const relative{ float(double(rData.tfX[i]) * scale - double(origin.x())),
+                                        float(double(rData.tfY[i]) * scale - double(origin.y())),
+                                        float(double(rData.tfZ[i]) * scale - double(origin.z())) };
+
+        float          const satRadius = radius.isEmpty() ? defaultRadius : radius[i];
+        Magnum::Color3 const satColor  = color .isEmpty() ? defaultColor  : color[i];
+
+        rData.instances[i] = {
+            .posRadius  = {relative, satRadius},
+            .color      = {satColor, 1.0f} };
+    }
+}
+
+void adera::shader::draw_satellites(
+        ACtxDrawSatellites&     rData,
+        RenderGL&               rRenderGl,
+        ViewProjMatrix const&   viewProj,
+        int const               viewportHeight)
+{
+    using Magnum::GL::Renderer;
+
+    if (rData.instances.empty())
+    {
+        return;
+    }
+
+    rData.instanceBuffer.setData(rData.instances, Magnum::GL::BufferUsage::StreamDraw);
+    rData.instanceBuffer.bind(Magnum::GL::Buffer::Target::ShaderStorage, SatelliteShader::smc_instanceBinding);
+
+    Renderer::enable(Renderer::Feature::DepthTest);
+    Renderer::disable(Renderer::Feature::FaceCulling);
+    Renderer::disable(Renderer::Feature::Blending);
+    Renderer::setDepthMask(GL_TRUE);
+
+    // proj[1][1] is cot(fovY / 2), so this is pixels per meter at 1 meter away
+    float const pixelScale = 0.5f * float(viewportHeight) * viewProj.m_proj[1][1];
+
+    rData.shader
+        .setProjectionMatrix    (viewProj.m_proj)
+        .setViewRotationMatrix  (viewProj.m_viewRotation)
+        .setPixelScale          (pixelScale, rData.minPixels)
+        .setLight               (rData.lightDir, rData.ambient);
+
+    rData.quad.setInstanceCount(Magnum::Int(rData.instances.size()));
+    rData.shader.draw(rData.quad);
+    SysRenderGL::count_draw(rRenderGl, rData.quad, std::uint32_t(rData.instances.size()));
+
+    Renderer::enable(Renderer::Feature::FaceCulling);
+}
+
+SatelliteShader::SatelliteShader(ProgramBinaryCacheGL const* pCache)
+{
+    using namespace Magnum;
+
+    std::filesystem::path const vertPath = "OSPData/adera/Shaders/SatelliteImpostor.vert";
+    std::filesystem::path const fragPath = "OSPData/adera/Shaders/SatelliteImpostor.frag";
+
+    std::uint64_t const cacheKey = (pCache != nullptr) ? pCache->key({vertPath, fragPath}) : 0;
+    if (pCache == nullptr || ! pCache->load(*this, cacheKey))
+    {
+        GL::Shader vert{GL::Version::GL430, GL::Shader::Type::Vertex};
+        GL::Shader frag{GL::Version::GL430, GL::Shader::Type::Fragment};
+        vert.addFile(vertPath.string());
+        frag.addFile(fragPath.string());
+
+        CORRADE_INTERNAL_ASSERT_OUTPUT(vert.compile() && frag.compile());
+        attachShaders({vert, frag});
+
+        if (pCache != nullptr)
+        {
+            pCache->prepare(*this);
+        }
+        CORRADE_INTERNAL_ASSERT_OUTPUT(link());
+        if (pCache != nullptr)
+        {
+            pCache->store(*this, cacheKey);
+        }
+    }
+}
+
+SatelliteShader& SatelliteShader::setProjectionMatrix(Magnum::Matrix4 const& matrix)
+{
+    setUniform(static_cast<Magnum::Int>(UniformPos::ProjMat), matrix);
+    return *this;
+}
+
+SatelliteShader& SatelliteShader::setViewRotationMatrix(Magnum::Matrix4 const& matrix)
+{
+    setUniform(static_cast<Magnum::Int>(UniformPos::ViewRotMat), matrix);
+    return *this;
+}
+
+SatelliteShader& SatelliteShader::setPixelScale(float const pixelScale, float const minPixels)
+{
+    setUniform(static_cast<Magnum::Int>(UniformPos::PixelScale), pixelScale);
+    setUniform(static_cast<Magnum::Int>(UniformPos::MinPixels),  minPixels);
+    return *this;
+}
+
+SatelliteShader& SatelliteShader::setLight(Magnum::Vector3 const& lightDir, float const ambient)
+{
+    setUniform(static_cast<Magnum::Int>(UniformPos::LightDir), lightDir);
+    setUniform(static_cast<Magnum::Int>(UniformPos::Ambient),  ambient);
+    return *this;
+}
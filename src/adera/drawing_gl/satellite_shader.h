@@ -0,0 +1,182 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include <osp/drawing_gl/rendergl.h>
+#include <osp/universe/coordinates.h>
+
+#include <Magnum/GL/AbstractShaderProgram.h>
+#include <Magnum/GL/Buffer.h>
+#include <Magnum/GL/Mesh.h>
+#include <Magnum/Math/Color.h>
+
+#include <Magnum/Magnum.h> // for Magnum::Int
+
+#include <vector>
+
+namespace adera::shader
+{
+
+/**
+ * @brief Instanced sphere impostor shader for drawing lots of satellites with one draw call
+ *
+ * Each satellite is a camera-facing quad with a ray-traced sphere, read from a shader storage
+ * buffer of SatelliteInstanceGL indexed by instance. Quads are kept at least a few pixels wide,
+ * so far away satellites stay visible as dots. Requires OpenGL 4.3.
+ */
+class SatelliteShader : public Magnum::GL::AbstractShaderProgram
+{
+public:
+
+    // Outputs
+    enum : Magnum::UnsignedInt
+    {
+        ColorOutput = 0
+    };
+
+    // Shader storage buffer binding of SatelliteInstanceGL
+    static constexpr Magnum::UnsignedInt smc_instanceBinding = 0;
+
+    explicit SatelliteShader(Corrade::NoCreateT) noexcept : AbstractShaderProgram{Corrade::NoCreate} { }
+
+    /**
+     * @param pCache    [in] Optional program binary cache to load from and store to
+     */
+    explicit SatelliteShader(osp::draw::ProgramBinaryCacheGL const* pCache = nullptr);
+
+    SatelliteShader& setProjectionMatrix(Magnum::Matrix4 const& matrix);
+    SatelliteShader& setViewRotationMatrix(Magnum::Matrix4 const& matrix);
+
+    /**
+     * @param pixelScale    [in] Pixels covered by 1 meter at 1 meter away
+     * @param minPixels     [in] Smallest size satellites are drawn at, in pixels
+     */
+    SatelliteShader& setPixelScale(float pixelScale, float minPixels);
+
+    /**
+     * @param lightDir  [in] Normalized view-space direction towards the light
+     */
+    SatelliteShader& setLight(Magnum::Vector3 const& lightDir, float ambient);
+
+private:
+
+    // Uniforms
+    enum class UniformPos : Magnum::Int
+    {
+        ProjMat = 0,
+        ViewRotMat = 1,
+        PixelScale = 2,
+        MinPixels = 3,
+        LightDir = 4,
+        Ambient = 5
+    };
+
+    // Hide irrelevant calls
+    using Magnum::GL::AbstractShaderProgram::drawTransformFeedback;
+    using Magnum::GL::AbstractShaderProgram::dispatchCompute;
+};
+
+/**
+ * @brief Per-satellite data in SatelliteShader's storage buffer, std430 layout
+ */
+struct SatelliteInstanceGL
+{
+    /// Position relative to the camera in meters, and radius
+    Magnum::Vector4     posRadius;
+    Magnum::Color4      color;
+};
+
+static_assert(sizeof(SatelliteInstanceGL) == 32, "Must match SatInstance in SatelliteImpostor.vert");
+
+/**
+ * @brief Required data for drawing satellites as impostors
+ */
+struct ACtxDrawSatellites
+{
+    SatelliteShader                     shader          {Corrade::NoCreate};
+
+    // No vertex buffers, quad corners come from gl_VertexID
+    Magnum::GL::Mesh                    quad            {Corrade::NoCreate};
+
+    // All instances of a frame are uploaded with a single call
+    Magnum::GL::Buffer                  instanceBuffer  {Corrade::NoCreate};
+    std::vector<SatelliteInstanceGL>    instances;
+
+    /// Positions transformed into the scene, reused between frames
+    std::vector<osp::universe::spaceint_t> tfX, tfY, tfZ;
+
+    Magnum::Vector3                     lightDir        {0.0f, 0.0f, 1.0f};
+    float                               ambient         {0.15f};
+    float                               minPixels       {3.0f};
+};
+
+/**
+ * @brief Create SatelliteShader and its attribute-less quad mesh
+ *
+ * @param pCache    [in] Optional program binary cache, usually RenderGL::m_programCache
+ */
+void setup_satellite_shader(ACtxDrawSatellites& rData, osp::draw::ProgramBinaryCacheGL const* pCache = nullptr);
+
+/**
+ * @brief Write instances of satellites straight from their coordinate space positions
+ *
+ * Positions are transformed into the scene in one batch by coord_transform_positions, then made
+ * relative to the camera in double precision before being converted to floats.
+ *
+ * @param spaceToScene  [in] Transform from the satellites' coordinate space into the scene
+ * @param x,y,z         [in] Satellite positions, e.g. from sat_views
+ * @param precision     [in] Precision of the scene coordinate space; units are 2^-precision m
+ * @param origin        [in] Camera position in the scene, ViewProjMatrix::m_origin
+ * @param radius        [in] Radius of each satellite in meters, or empty to use defaultRadius
+ * @param color         [in] Color of each satellite, or empty to use defaultColor
+ */
+void write_satellite_instances(
+        ACtxDrawSatellites&                                         rData,
+        osp::universe::CoordTransformer const&                      spaceToScene,
+        osp::universe::SpaceIntViewConst_t const&                   x,
+        osp::universe::SpaceIntViewConst_t const&                   y,
+        osp::universe::SpaceIntViewConst_t const&                   z,
+        int                                                         precision,
+        Magnum::Vector3 const&                                      origin,
+        Corrade::Containers::StridedArrayView1D<float const>        radius          = {},
+        Corrade::Containers::StridedArrayView1D<Magnum::Color3 const> color         = {},
+        float                                                       defaultRadius   = 1.0f,
+        Magnum::Color3                                              defaultColor    = {1.0f, 1.0f, 1.0f});
+
+/**
+ * @brief Draw all instances written by write_satellite_instances with one instanced draw call
+ *
+ * @param rData         [ref] Satellite shader data
+ * @param rRenderGl     [ref] Renderer, for draw call counters
+ * @param viewProj      [in] View and projection matrix
+ * @param viewportHeight [in] Height of the framebuffer being drawn to, in pixels
+ */
+void draw_satellites(
+        ACtxDrawSatellites&                 rData,
+        osp::draw::RenderGL&                rRenderGl,
+        osp::draw::ViewProjMatrix const&    viewProj,
+        int                                 viewportHeight);
+
+} // namespace adera::shader
@@ -0,0 +1,118 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "terrain_fill_shader.h"            // IWYU pragma: associated
+
+#include <Magnum/GL/Renderer.h>
+#include <Magnum/GL/Shader.h>             // for Shader, Shader::Type
+#include <Magnum/GL/Version.h>            // for Version, Version::GL430
+#include <Magnum/Math/Vector3.h>
+
+// used by attachShaders
+#include <Corrade/Containers/Iterable.h>  // for Containers::Iterable
+
+#include <Corrade/Utility/Assert.h>       // for CORRADE_INTERNAL_ASSERT_OUTPUT
+
+#include <filesystem>
+
+using namespace osp::draw;
+using namespace adera::shader;
+
+TerrainFillShader::TerrainFillShader(ProgramBinaryCacheGL const* pCache)
+{
+    using namespace Magnum;
+
+    std::filesystem::path const compPath = "OSPData/adera/Shaders/TerrainFill.comp";
+
+    std::uint64_t const cacheKey = (pCache != nullptr) ? pCache->key({compPath}) : 0;
+    if (pCache == nullptr || ! pCache->load(*this, cacheKey))
+    {
+        GL::Shader comp{GL::Version::GL430, GL::Shader::Type::Compute};
+        comp.addFile(compPath.string());
+
+        CORRADE_INTERNAL_ASSERT_OUTPUT(comp.compile());
+        attachShaders({comp});
+
+        if (pCache != nullptr)
+        {
+            pCache->prepare(*this);
+        }
+        CORRADE_INTERNAL_ASSERT_OUTPUT(link());
+        if (pCache != nullptr)
+        {
+            pCache->store(*this, cacheKey);
+        }
+    }
+}
+
+TerrainFillShader& TerrainFillShader::setFillVertexCount(Magnum::UnsignedInt const count)
+{
+    setUniform(static_cast<Magnum::Int>(UniformPos::FillVrtxCount), count);
+    return *this;
+}
+
+TerrainFillShader& TerrainFillShader::setSharedCount(Magnum::UnsignedInt const count)
+{
+    setUniform(static_cast<Magnum::Int>(UniformPos::SharedCount), count);
+    return *this;
+}
+
+TerrainFillShader& TerrainFillShader::setBatchCount(Magnum::UnsignedInt const count)
+{
+    setUniform(static_cast<Magnum::Int>(UniformPos::BatchCount), count);
+    return *this;
+}
+
+TerrainFillShader& TerrainFillShader::setRadius(float const radius)
+{
+    setUniform(static_cast<Magnum::Int>(UniformPos::Radius), radius);
+    return *this;
+}
+
+TerrainFillShader& TerrainFillShader::bindBuffers(
+        Magnum::GL::Buffer& rPositions,
+        Magnum::GL::Buffer& rSubdiv,
+        Magnum::GL::Buffer& rBatches,
+        Magnum::GL::Buffer& rJobs)
+{
+    using Magnum::GL::Buffer;
+    rPositions  .bind(Buffer::Target::ShaderStorage, smc_positionsBinding);
+    rSubdiv     .bind(Buffer::Target::ShaderStorage, smc_subdivBinding);
+    rBatches    .bind(Buffer::Target::ShaderStorage, smc_batchesBinding);
+    rJobs       .bind(Buffer::Target::ShaderStorage, smc_jobsBinding);
+    return *this;
+}
+
+void TerrainFillShader::fill(Magnum::UnsignedInt const chunkCount)
+{
+    using Magnum::GL::Renderer;
+
+    dispatchCompute({chunkCount, 1, 1});
+
+    // Positions are read as vertex attributes by the terrain draw, and shared vertex uploads of
+    // later frames must not be reordered before the shader's writes
+    Renderer::setMemoryBarrier(  Renderer::MemoryBarrier::VertexAttributeArray
+                               | Renderer::MemoryBarrier::BufferUpdate
+                               | Renderer::MemoryBarrier::ShaderStorage);
+}
@@ -0,0 +1,97 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include <osp/drawing_gl/rendergl.h>
+
+#include <Magnum/GL/AbstractShaderProgram.h>
+#include <Magnum/GL/Buffer.h>
+
+#include <Magnum/Magnum.h> // for Magnum::UnsignedInt
+
+namespace adera::shader
+{
+
+/**
+ * @brief Compute shader that calculates terrain chunk fill vertex positions
+ *
+ * Runs planeta::ChunkFillSubdivLUT on the GPU, writing positions of new chunks straight into the
+ * terrain vertex buffer, so they don't need to be uploaded. One workgroup is dispatched per
+ * chunk. Requires OpenGL 4.3.
+ */
+class TerrainFillShader : public Magnum::GL::AbstractShaderProgram
+{
+public:
+
+    // Shader storage buffer bindings
+    static constexpr Magnum::UnsignedInt smc_positionsBinding   = 0;
+    static constexpr Magnum::UnsignedInt smc_subdivBinding      = 1;
+    static constexpr Magnum::UnsignedInt smc_batchesBinding     = 2;
+    static constexpr Magnum::UnsignedInt smc_jobsBinding        = 3;
+
+    explicit TerrainFillShader(Corrade::NoCreateT) noexcept : AbstractShaderProgram{Corrade::NoCreate} { }
+
+    /**
+     * @param pCache    [in] Optional program binary cache to load from and store to
+     */
+    explicit TerrainFillShader(osp::draw::ProgramBinaryCacheGL const* pCache = nullptr);
+
+    TerrainFillShader& setFillVertexCount(Magnum::UnsignedInt count);
+    TerrainFillShader& setSharedCount(Magnum::UnsignedInt count);
+    TerrainFillShader& setBatchCount(Magnum::UnsignedInt count);
+    TerrainFillShader& setRadius(float radius);
+
+    /**
+     * @brief Bind buffers. Positions are tightly packed Vector3s; subdiv, batches, and jobs are
+     *        UnsignedInts, see TerrainFill.comp for their layout.
+     */
+    TerrainFillShader& bindBuffers(
+            Magnum::GL::Buffer& rPositions,
+            Magnum::GL::Buffer& rSubdiv,
+            Magnum::GL::Buffer& rBatches,
+            Magnum::GL::Buffer& rJobs);
+
+    /**
+     * @brief Calculate fill vertices of chunkCount chunks listed in the jobs buffer
+     */
+    void fill(Magnum::UnsignedInt chunkCount);
+
+private:
+
+    // Uniforms
+    enum class UniformPos : Magnum::Int
+    {
+        FillVrtxCount = 0,
+        SharedCount = 1,
+        BatchCount = 2,
+        Radius = 3
+    };
+
+    // Hide irrelevant calls
+    using Magnum::GL::AbstractShaderProgram::draw;
+    using Magnum::GL::AbstractShaderProgram::drawTransformFeedback;
+};
+
+} // namespace adera::shader
@@ -46,7 +46,7 @@ void adera::shader::draw_ent_visualizer(
     auto &rData = *reinterpret_cast<ACtxDrawMeshVisualizer*>(pData);
 
     Matrix4 const&  drawTf      = (*rData.m_pDrawTf)[ent];
-    Matrix4 const   entRelative = viewProj.m_view * drawTf;
+    Matrix4 const   entRelative = viewProj.model_view(drawTf);
 
     MeshVisualizer &rShader = rData.m_shader;
 
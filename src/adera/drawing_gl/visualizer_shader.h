@@ -63,36 +63,24 @@ void draw_ent_visualizer(
 inline void sync_drawent_visualizer(
         osp::draw::DrawEnt const            ent,
         osp::draw::DrawEntSet_t const&      hasMaterial,
-        osp::draw::RenderGroup::DrawEnts_t& rStorage,
+        osp::draw::RenderGroupWrites&       rWrites,
         ACtxDrawMeshVisualizer&             rData)
 {
-    bool alreadyAdded = rStorage.contains(ent);
-    if (hasMaterial.contains(ent))
-    {
-        if ( ! alreadyAdded)
-        {
-            rStorage.emplace( ent, osp::draw::EntityToDraw{&draw_ent_visualizer, {&rData} } );
-        }
-    }
-    else
-    {
-        if (alreadyAdded)
-        {
-            rStorage.erase(ent);
-        }
-    }
+    rWrites.assign(ent, hasMaterial.contains(ent)
+                        ? std::make_optional(osp::draw::EntityToDraw{&draw_ent_visualizer, {&rData}})
+                        : std::nullopt);
 }
 template <typename ITA_T, typename ITB_T>
 static void sync_drawent_visualizer(
         ITA_T const&                        first,
         ITB_T const&                        last,
         osp::draw::DrawEntSet_t const&      hasMaterial,
-        osp::draw::RenderGroup::DrawEnts_t& rStorage,
+        osp::draw::RenderGroupWrites&       rWrites,
         ACtxDrawMeshVisualizer&             rData)
 {
     std::for_each(first, last, [&] (osp::draw::DrawEnt const ent)
     {
-        sync_drawent_visualizer(ent, hasMaterial, rStorage, rData);
+        sync_drawent_visualizer(ent, hasMaterial, rWrites, rData);
     });
 }
 
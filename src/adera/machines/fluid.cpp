@@ -0,0 +1,209 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "fluid.h"
+
+#include <algorithm>
+
+using namespace osp::link;
+using namespace osp;
+
+namespace adera
+{
+
+// Tiny leak from every node to zero pressure, keeps nodes not connected to any tank solvable
+static constexpr double gc_groundConductance = 1.0e-9;
+
+static NodeId port_node(Machines const& machines, Nodes const& fluidNodes, MachTypeId const type, MachLocalId const local, PortEntry const& entry)
+{
+    MachAnyId const mach = machines.perType[type].localToAny[local];
+    if ( ! fluidNodes.machToNode.contains(mach) )
+    {
+        return lgrn::id_null<NodeId>();
+    }
+    return connected_node(lgrn::Span<NodeId const>{fluidNodes.machToNode[mach]}, entry.port);
+}
+
+static float tank_pressure(FluidTank const& tank) noexcept
+{
+    return (tank.capacity > 0.0f) ? tank.pressureFull * (tank.fluidMass / tank.capacity) : 0.0f;
+}
+
+void SysFluidNetwork::compile(ACtxFluidNetwork& rNet, Machines const& machines, Nodes const& fluidNodes)
+{
+    auto const nodeCount = static_cast<uint32_t>(fluidNodes.nodeIds.capacity());
+
+    struct PipeEdge
+    {
+        NodeId  a;
+        NodeId  b;
+        float   conductance;
+    };
+    std::vector<PipeEdge> edges;
+
+    for (MachLocalId const local : machines.perType[gc_mtFluidPipe].localIds)
+    {
+        NodeId const a = port_node(machines, fluidNodes, gc_mtFluidPipe, local, ports_fluidpipe::gc_endA);
+        NodeId const b = port_node(machines, fluidNodes, gc_mtFluidPipe, local, ports_fluidpipe::gc_endB);
+        if (   a == lgrn::id_null<NodeId>() || b == lgrn::id_null<NodeId>() || a == b
+            || local >= rNet.pipes.size())
+        {
+            continue; // Pipe leads nowhere
+        }
+        edges.push_back({a, b, rNet.pipes[local].conductance});
+    }
+
+    // Only pipes add off-diagonal entries
+    std::vector<uint32_t> rowFirst(nodeCount);
+    for (uint32_t row = 0; row < nodeCount; ++row)
+    {
+        rowFirst[row] = row;
+    }
+    for (PipeEdge const& edge : edges)
+    {
+        NodeId const hi = std::max(edge.a, edge.b);
+        rowFirst[hi] = std::min(rowFirst[hi], std::min(edge.a, edge.b));
+    }
+
+    rNet.matrix.reset(std::move(rowFirst));
+
+    for (uint32_t row = 0; row < nodeCount; ++row)
+    {
+        rNet.matrix.add(row, row, gc_groundConductance);
+    }
+    for (PipeEdge const& edge : edges)
+    {
+        rNet.matrix.add(edge.a, edge.a,  edge.conductance);
+        rNet.matrix.add(edge.b, edge.b,  edge.conductance);
+        rNet.matrix.add(edge.a, edge.b, -edge.conductance);
+    }
+
+    rNet.tankNodes.assign(rNet.tanks.size(), lgrn::id_null<NodeId>());
+    for (MachLocalId const local : machines.perType[gc_mtFluidTank].localIds)
+    {
+        if (local >= rNet.tanks.size())
+        {
+            continue;
+        }
+        NodeId const node = port_node(machines, fluidNodes, gc_mtFluidTank, local, ports_fluidtank::gc_outlet);
+        rNet.tankNodes[local] = node;
+        if (node != lgrn::id_null<NodeId>())
+        {
+            rNet.matrix.add(node, node, rNet.tanks[local].conductance);
+        }
+    }
+
+    rNet.engineNodes.assign(rNet.engines.size(), lgrn::id_null<NodeId>());
+    for (MachLocalId const local : machines.perType[gc_mtFluidEngine].localIds)
+    {
+        if (local < rNet.engines.size())
+        {
+            rNet.engineNodes[local] = port_node(machines, fluidNodes, gc_mtFluidEngine, local, ports_fluidengine::gc_inlet);
+        }
+    }
+
+    // All conductances are positive, so the matrix is diagonally dominant and always factorizes
+    rNet.compiled = rNet.matrix.factorize();
+    LGRN_ASSERTM(rNet.compiled, "Fluid network matrix must be positive definite");
+
+    rNet.pressure.assign(nodeCount, 0.0);
+}
+
+void SysFluidNetwork::step(ACtxFluidNetwork& rNet, Machines const& machines, Nodes const& fluidNodes, float const timeStep)
+{
+    if ( ! rNet.compiled )
+    {
+        return;
+    }
+
+    // Right-hand side: tanks push fluid in through their outlets, engines draw fluid out
+    std::vector<double> &rPressure = rNet.pressure;
+    std::fill(rPressure.begin(), rPressure.end(), 0.0);
+
+    for (MachLocalId const local : machines.perType[gc_mtFluidTank].localIds)
+    {
+        NodeId const node = (local < rNet.tankNodes.size()) ? rNet.tankNodes[local] : lgrn::id_null<NodeId>();
+        if (node != lgrn::id_null<NodeId>())
+        {
+            FluidTank const &tank = rNet.tanks[local];
+            rPressure[node] += double(tank.conductance) * tank_pressure(tank);
+        }
+    }
+    for (MachLocalId const local : machines.perType[gc_mtFluidEngine].localIds)
+    {
+        NodeId const node = (local < rNet.engineNodes.size()) ? rNet.engineNodes[local] : lgrn::id_null<NodeId>();
+        if (node != lgrn::id_null<NodeId>())
+        {
+            rPressure[node] -= rNet.engines[local].demand;
+        }
+    }
+
+    rNet.matrix.solve({rPressure.data(), rPressure.size()});
+
+    for (MachLocalId const local : machines.perType[gc_mtFluidTank].localIds)
+    {
+        NodeId const node = (local < rNet.tankNodes.size()) ? rNet.tankNodes[local] : lgrn::id_null<NodeId>();
+        if (node == lgrn::id_null<NodeId>())
+        {
+            continue;
+        }
+
+        FluidTank &rTank = rNet.tanks[local];
+        double const outflow    = rTank.conductance * (tank_pressure(rTank) - rPressure[node]);
+        float const  newMass    = std::clamp(float(rTank.fluidMass - outflow * timeStep), 0.0f, rTank.capacity);
+        if (newMass != rTank.fluidMass)
+        {
+            rTank.fluidMass = newMass;
+            rNet.tankMassDirty.push_back(local);
+        }
+    }
+
+    for (MachLocalId const local : machines.perType[gc_mtFluidEngine].localIds)
+    {
+        if (local >= rNet.engines.size())
+        {
+            continue;
+        }
+        NodeId const node       = (local < rNet.engineNodes.size()) ? rNet.engineNodes[local] : lgrn::id_null<NodeId>();
+        bool const   supplied   = (node != lgrn::id_null<NodeId>()) && (rPressure[node] >= 0.0);
+
+        FluidEngine &rEngine = rNet.engines[local];
+        rEngine.massFlow = supplied ? rEngine.demand : 0.0f;
+    }
+}
+
+bool SysFluidNetwork::update(ACtxFluidNetwork& rNet, Machines const& machines, Nodes const& fluidNodes, float const deltaTime)
+{
+    rNet.timeAccum += deltaTime;
+    if (rNet.timeAccum < rNet.interval)
+    {
+        return false;
+    }
+
+    step(rNet, machines, fluidNodes, rNet.timeAccum);
+    rNet.timeAccum = 0.0f;
+    return true;
+}
+
+} // namespace adera
@@ -0,0 +1,148 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include <osp/activescene/active_ent.h>
+#include <osp/core/keyed_vector.h>
+#include <osp/core/math_sparse_ldlt.h>
+#include <osp/link/machines.h>
+
+#include <vector>
+
+namespace adera
+{
+
+using osp::link::PortEntry;
+
+/**
+ * @brief Fluid nodes are pipe junctions, each with its own pressure
+ *
+ * Unlike signals, fluid nodes have no single writer. Pressures and flows are solved for the whole
+ * network at once, see SysFluidNetwork.
+ */
+inline osp::link::NodeTypeId const gc_ntFluid = osp::link::NodeTypeReg_t::create();
+
+inline osp::link::MachTypeId const gc_mtFluidTank   = osp::link::MachTypeReg_t::create();
+inline osp::link::MachTypeId const gc_mtFluidPipe   = osp::link::MachTypeReg_t::create();
+inline osp::link::MachTypeId const gc_mtFluidEngine = osp::link::MachTypeReg_t::create();
+
+namespace ports_fluidtank
+{
+PortEntry const gc_outlet           { gc_ntFluid, 0, 0 };
+}
+
+namespace ports_fluidpipe
+{
+PortEntry const gc_endA             { gc_ntFluid, 0, 0 };
+PortEntry const gc_endB             { gc_ntFluid, 1, 0 };
+}
+
+namespace ports_fluidengine
+{
+PortEntry const gc_inlet            { gc_ntFluid, 0, 0 };
+}
+
+struct FluidTank
+{
+    float                   fluidMass       {0.0f};     ///< [kg]
+    float                   capacity        {1.0f};     ///< [kg]
+    float                   dryMass         {0.0f};     ///< [kg] Added to fluidMass for ACompMass
+    float                   pressureFull    {1.0f};     ///< Pressure when full, scales with fill
+    float                   conductance     {1.0f};     ///< Of the outlet, [kg/s per unit pressure]
+    osp::active::ActiveEnt  massEnt         {lgrn::id_null<osp::active::ActiveEnt>()};
+};
+
+struct FluidPipe
+{
+    float                   conductance     {1.0f};     ///< [kg/s per unit pressure]
+};
+
+struct FluidEngine
+{
+    float                   demand          {0.0f};     ///< [kg/s] Requested mass flow
+    float                   massFlow        {0.0f};     ///< [kg/s] Mass flow actually delivered
+};
+
+/**
+ * @brief Tanks, pipes, and engines connected by fluid nodes, and the factorized network matrix
+ *
+ * Machine parameters are indexed by MachLocalId of their type. Tanks and engines are the only
+ * machines with state that changes; pipes only change the matrix.
+ */
+struct ACtxFluidNetwork
+{
+    osp::KeyedVec<osp::link::MachLocalId, FluidTank>    tanks;
+    osp::KeyedVec<osp::link::MachLocalId, FluidPipe>    pipes;
+    osp::KeyedVec<osp::link::MachLocalId, FluidEngine>  engines;
+
+    /// Tanks with a changed fluidMass since the last time this was cleared
+    std::vector<osp::link::MachLocalId>                 tankMassDirty;
+
+    /// Seconds between network updates; far slower than physics is plenty for fuel
+    float                                               interval        {0.1f};
+    float                                               timeAccum       {0.0f};
+
+    // Compiled from wiring and pipe/tank conductances by SysFluidNetwork::compile
+
+    /// Pressure of each node is solved from (pipe Laplacian + tank outlets) * p = inflow
+    osp::ProfileLDLT                                    matrix;
+    std::vector<double>                                 pressure;       ///< [NodeId]
+    osp::KeyedVec<osp::link::MachLocalId, osp::link::NodeId> tankNodes;
+    osp::KeyedVec<osp::link::MachLocalId, osp::link::NodeId> engineNodes;
+    uint32_t                                            connectRevision {~uint32_t(0)};
+    bool                                                compiled        {false};
+};
+
+class SysFluidNetwork
+{
+    using Machines      = osp::link::Machines;
+    using Nodes         = osp::link::Nodes;
+public:
+
+    /**
+     * @brief Build and factorize the network matrix
+     *
+     * Call when wiring changes, or when any pipe or tank conductance changes. Rows are fluid
+     * NodeIds, so nodes of the same vehicle stay close together and keep the profile narrow.
+     */
+    static void compile(ACtxFluidNetwork& rNet, Machines const& machines, Nodes const& fluidNodes);
+
+    /**
+     * @brief Solve pressures, then move fluid out of tanks into engines over a time step
+     *
+     * Engines at a node with negative pressure are starved, and receive no flow. Tanks with
+     * changed fluid mass are added to ACtxFluidNetwork::tankMassDirty.
+     */
+    static void step(ACtxFluidNetwork& rNet, Machines const& machines, Nodes const& fluidNodes, float timeStep);
+
+    /**
+     * @brief Accumulate time, and step once per ACtxFluidNetwork::interval passed
+     *
+     * @return true if the network was stepped
+     */
+    static bool update(ACtxFluidNetwork& rNet, Machines const& machines, Nodes const& fluidNodes, float deltaTime);
+};
+
+} // namespace adera
@@ -24,6 +24,9 @@
  */
 #include "links.h"
 
+#include <algorithm>
+#include <cmath>
+
 using namespace osp;
 
 using osp::link::MachTypeReg_t;
@@ -63,5 +66,59 @@ float thruster_influence(Vector3 const pos, Vector3 const dir, Vector3 const cmd
     return std::clamp(influence, 0.0f, 1.0f);
 }
 
+void thruster_influence_batch(RcsDriverBatch &rBatch) noexcept
+{
+    namespace ports = ports_rcsdriver;
+
+    std::size_t const size = rBatch.size();
+
+    auto const column = [&rBatch] (PortEntry const& entry) -> float const*
+    {
+        return rBatch.inputs[entry.port].data();
+    };
+
+    float const *pPosX      = column(ports::gc_posXIn);
+    float const *pPosY      = column(ports::gc_posYIn);
+    float const *pPosZ      = column(ports::gc_posZIn);
+    float const *pDirX      = column(ports::gc_dirXIn);
+    float const *pDirY      = column(ports::gc_dirYIn);
+    float const *pDirZ      = column(ports::gc_dirZIn);
+    float const *pLinX      = column(ports::gc_cmdLinXIn);
+    float const *pLinY      = column(ports::gc_cmdLinYIn);
+    float const *pLinZ      = column(ports::gc_cmdLinZIn);
+    float const *pAngX      = column(ports::gc_cmdAngXIn);
+    float const *pAngY      = column(ports::gc_cmdAngYIn);
+    float const *pAngZ      = column(ports::gc_cmdAngZIn);
+    float       *pThrOut    = rBatch.throttleOut.data();
+
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        // torque = cross(pos, dir)
+        float const torqueX = pPosY[i] * pDirZ[i] - pPosZ[i] * pDirY[i];
+        float const torqueY = pPosZ[i] * pDirX[i] - pPosX[i] * pDirZ[i];
+        float const torqueZ = pPosX[i] * pDirY[i] - pPosY[i] * pDirX[i];
+
+        float const torqueSq    = torqueX * torqueX + torqueY * torqueY + torqueZ * torqueZ;
+        float const angSq       = pAngX[i] * pAngX[i] + pAngY[i] * pAngY[i] + pAngZ[i] * pAngZ[i];
+        float const linSq       = pLinX[i] * pLinX[i] + pLinY[i] * pLinY[i] + pLinZ[i] * pLinZ[i];
+
+        float const angDot      = torqueX * pAngX[i] + torqueY * pAngY[i] + torqueZ * pAngZ[i];
+        float const linDot      = pDirX[i] * pLinX[i] + pDirY[i] * pLinY[i] + pDirZ[i] * pLinZ[i];
+
+        float const angDen      = torqueSq * angSq;
+        float const angular     = (angDen > 0.0f) ? angDot / std::sqrt(angDen) : 0.0f;
+        float const linear      = (linSq  > 0.0f) ? linDot / std::sqrt(linSq)  : 0.0f;
+
+        float const influence   = angular + linear;
+
+        // thruster_influence normalizes a zero torque into NaN when there's an angular command,
+        // which results in 0
+        bool const zeroTorque   = (angSq > 0.0f) && (torqueSq == 0.0f);
+        bool const ignore       = zeroTorque || ! (influence >= 0.01f); // also catches NaN
+
+        pThrOut[i] = ignore ? 0.0f : std::min(influence, 1.0f);
+    }
+}
+
 
 } // namespace adera
@@ -29,6 +29,9 @@
 #include <osp/link/machines.h>
 #include <osp/link/signal.h>
 
+#include <array>
+#include <vector>
+
 namespace adera
 {
 
@@ -72,8 +75,40 @@ PortEntry const gc_cmdAngXIn        { gc_ntSigFloat, 9, gc_sigIn };
 PortEntry const gc_cmdAngYIn        { gc_ntSigFloat, 10, gc_sigIn };
 PortEntry const gc_cmdAngZIn        { gc_ntSigFloat, 11, gc_sigIn };
 PortEntry const gc_throttleOut      { gc_ntSigFloat, 12, gc_sigOut };
+
+constexpr osp::link::PortId gc_inputCount = 12;
+constexpr osp::link::PortId gc_portCount  = 13;
 }
 
 float thruster_influence(osp::Vector3 pos, osp::Vector3 dir, osp::Vector3 cmdLin, osp::Vector3 cmdAng) noexcept;
 
+/**
+ * @brief Inputs and outputs of many RCS drivers packed into columns, one row per driver
+ *
+ * Input columns are indexed by port number, see ports_rcsdriver. Unconnected inputs read as 0.
+ */
+struct RcsDriverBatch
+{
+    void resize(std::size_t const size)
+    {
+        for (std::vector<float> &rColumn : inputs)
+        {
+            rColumn.resize(size);
+        }
+        throttleOut.resize(size);
+    }
+
+    std::size_t size() const noexcept { return throttleOut.size(); }
+
+    std::array<std::vector<float>, ports_rcsdriver::gc_inputCount> inputs;
+    std::vector<float> throttleOut;
+};
+
+/**
+ * @brief Same as thruster_influence, but for every row of an RcsDriverBatch
+ *
+ * Written as one branch-free loop over the columns so it can be auto-vectorized.
+ */
+void thruster_influence_batch(RcsDriverBatch &rBatch) noexcept;
+
 } // namespace adera
@@ -27,6 +27,7 @@
 #include "active_ent.h"
 
 #include "../core/keyed_vector.h"
+#include "../core/math_affine.h"
 #include "../core/math_types.h"
 #include "../core/storage.h"
 
@@ -44,12 +45,32 @@ using ActiveEntSet_t = lgrn::IdSetStl<ActiveEnt>;
 
 /**
  * @brief Component for transformation (in meters)
+ *
+ * Expected to be affine; draw transforms are multiplied without the last row.
  */
 struct ACompTransform
 {
     osp::Matrix4 m_transform;
 };
 
+/**
+ * @brief Compact alternative to ACompTransform, without the implicit last row (0, 0, 0, 1)
+ *
+ * 48 bytes instead of 64, for storage that's bandwidth-bound (e.g. many transforms copied each
+ * physics step). Convert with to_matrix4 and from_matrix4 where APIs need a Matrix4.
+ */
+struct ACompTransformAffine
+{
+    osp::math::Affine3x4 m_transform{Magnum::Math::IdentityInit};
+
+    Matrix4 to_matrix4() const noexcept { return osp::math::affine_to_matrix4(m_transform); }
+
+    static ACompTransformAffine from_matrix4(Matrix4 const& in) noexcept
+    {
+        return { osp::math::affine_from_matrix4(in) };
+    }
+};
+
 /**
  * @brief Simple name component
  */
@@ -74,16 +95,55 @@ struct ACtxSceneGraph
 
     std::vector<TreePos_t>  m_delete;
 
+    // Non-zero for entities whose ACompTransform changed since draw transforms were last
+    // calculated. Bytes instead of a bitset, so physics callbacks on different threads can mark
+    // different entities without locking.
+    osp::KeyedVec<ActiveEnt, uint8_t>    m_transformDirty;
+
+    // Incremented when entities are added or removed, since this moves tree positions around
+    uint32_t                             m_treeVersion{0};
+
     void resize(std::size_t ents)
     {
         m_treeToEnt         .reserve(ents);
         m_treeDescendants   .reserve(ents);
         m_entParent         .resize(ents);
         m_entToTreePos      .resize(ents, lgrn::id_null<TreePos_t>());
+        m_transformDirty    .resize(ents, 1);
     }
 };
 
-using ACompTransformStorage_t = Storage_t<ActiveEnt, ACompTransform>;
+/**
+ * @brief Scene graph insertions and deletions collected to be applied all at once
+ *
+ * Adding or removing entities one subtree at a time shifts the whole tree each time. A batch is
+ * instead applied with a single linear pass over the tree. See SysSceneGraph::batch_apply.
+ */
+struct SceneGraphBatch
+{
+    struct Insert
+    {
+        ActiveEnt   parent;
+        TreePos_t   first;
+        uint32_t    count;
+    };
+
+    // New subtrees, in the same layout as ACtxSceneGraph's tree but not yet placed
+    osp::KeyedVec<TreePos_t, ActiveEnt>  m_treeToEnt;
+    osp::KeyedVec<TreePos_t, uint32_t>   m_treeDescendants;
+    std::vector<Insert>                  m_inserts;
+
+    // Roots of subtrees to remove
+    std::vector<ActiveEnt>               m_cut;
+
+    // Reused between batches to avoid reallocating
+    osp::KeyedVec<TreePos_t, ActiveEnt>  m_scratchTreeToEnt;
+    osp::KeyedVec<TreePos_t, uint32_t>   m_scratchTreeDescendants;
+    std::vector<TreePos_t>               m_scratchCutPos;
+};
+
+using ACompTransformStorage_t       = Storage_t<ActiveEnt, ACompTransform>;
+using ACompTransformAffineStorage_t = Storage_t<ActiveEnt, ACompTransformAffine>;
 
 /**
  * @brief Storage for basic components
@@ -94,6 +154,13 @@ struct ACtxBasic
 
     ACtxSceneGraph                      m_scnGraph;
     ACompTransformStorage_t             m_transform;
+
+    /// Kept around to reuse its allocations between batches
+    SceneGraphBatch                     m_scnGraphBatch;
+
+    /// ActiveEnts being deleted this frame; built once from the delete vector so that sets of
+    /// ActiveEnts can drop all of them with a single bit_andnot_assign
+    ActiveEntSet_t                      m_deleted;
 };
 
 template<typename IT_T>
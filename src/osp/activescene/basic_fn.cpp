@@ -26,6 +26,8 @@
 
 #include <Corrade/Containers/ArrayViewStl.h>
 
+#include <longeron/utility/asserts.hpp>
+
 #include <algorithm>
 
 using namespace osp;
@@ -36,8 +38,8 @@ using Corrade::Containers::arrayView;
 SubtreeBuilder SubtreeBuilder::add_child(ActiveEnt ent, uint32_t descendantCount)
 {
     // Place ent into tree at m_first
-    m_rScnGraph.m_treeToEnt[m_first]        = ent;
-    m_rScnGraph.m_treeDescendants[m_first]  = descendantCount;
+    m_rTreeToEnt[m_first]                   = ent;
+    m_rTreeDescendants[m_first]             = descendantCount;
     m_rScnGraph.m_entParent[ent]            = m_root;
     m_rScnGraph.m_entToTreePos[ent]         = m_first;
 
@@ -46,7 +48,37 @@ SubtreeBuilder SubtreeBuilder::add_child(ActiveEnt ent, uint32_t descendantCount
 
     m_first = childLast;
 
-    return {m_rScnGraph, ent, childFirst, childLast};
+    return {m_rScnGraph, m_rTreeToEnt, m_rTreeDescendants, ent, childFirst, childLast};
+}
+
+void SubtreeBuilder::add_preordered(
+        ArrayView<ActiveEnt const>  ents,
+        ArrayView<uint32_t const>   descendants,
+        ArrayView<int32_t const>    parents)
+{
+    std::size_t const count = ents.size();
+
+    LGRN_ASSERT(descendants.size() == count && parents.size() == count);
+    LGRN_ASSERTM(remaining() >= count, "Subtree doesn't fit");
+
+    if (count == 0)
+    {
+        return;
+    }
+
+    LGRN_ASSERT(descendants[0] + 1 == count);
+
+    std::copy(ents.begin(),         ents.end(),         &m_rTreeToEnt[m_first]);
+    std::copy(descendants.begin(),  descendants.end(),  &m_rTreeDescendants[m_first]);
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        ActiveEnt const ent = ents[i];
+        m_rScnGraph.m_entParent[ent]    = (parents[i] == -1) ? m_root : ents[parents[i]];
+        m_rScnGraph.m_entToTreePos[ent] = m_first + TreePos_t(i);
+    }
+
+    m_first += TreePos_t(count);
 }
 
 SubtreeBuilder SysSceneGraph::add_descendants(ACtxSceneGraph& rScnGraph, uint32_t descendantCount, ActiveEnt root)
@@ -65,6 +97,7 @@ SubtreeBuilder SysSceneGraph::add_descendants(ACtxSceneGraph& rScnGraph, uint32_
 
     rScnGraph.m_treeToEnt.resize(treeNewSize);
     rScnGraph.m_treeDescendants.resize(treeNewSize);
+    ++rScnGraph.m_treeVersion;
 
     SubtreeBuilder out(rScnGraph, root, subFirst, subLast);
 
@@ -101,6 +134,148 @@ SubtreeBuilder SysSceneGraph::add_descendants(ACtxSceneGraph& rScnGraph, uint32_
     return out;
 }
 
+SubtreeBuilder SysSceneGraph::batch_add_descendants(ACtxSceneGraph& rScnGraph, SceneGraphBatch& rBatch, uint32_t descendantCount, ActiveEnt root)
+{
+    LGRN_ASSERTM(root == lgrn::id_null<ActiveEnt>() || rScnGraph.m_entToTreePos[root] != lgrn::id_null<TreePos_t>(),
+                 "Root must already be in the scene graph");
+
+    auto const first = TreePos_t(rBatch.m_treeToEnt.size());
+    auto const last  = TreePos_t(first + descendantCount);
+
+    rBatch.m_treeToEnt      .resize(last);
+    rBatch.m_treeDescendants.resize(last);
+    rBatch.m_inserts.push_back({root, first, descendantCount});
+
+    return {rScnGraph, rBatch.m_treeToEnt, rBatch.m_treeDescendants, root, first, last};
+}
+
+void SysSceneGraph::batch_apply(ACtxSceneGraph& rScnGraph, SceneGraphBatch& rBatch)
+{
+    if (rBatch.m_inserts.empty() && rBatch.m_cut.empty())
+    {
+        return;
+    }
+
+    // Tree positions of subtrees to remove, in the order they're reached
+    std::vector<TreePos_t> &rCutPos = rBatch.m_scratchCutPos;
+    rCutPos.clear();
+    for (ActiveEnt const ent : rBatch.m_cut)
+    {
+        TreePos_t const pos = rScnGraph.m_entToTreePos[ent];
+        if (pos != lgrn::id_null<TreePos_t>())
+        {
+            rCutPos.push_back(pos);
+        }
+    }
+    std::sort(rCutPos.begin(), rCutPos.end());
+    auto itCut = rCutPos.cbegin();
+
+    // Insertions grouped by parent, keeping the order they were made in
+    auto const parent_less = [] (SceneGraphBatch::Insert const& lhs, SceneGraphBatch::Insert const& rhs) noexcept
+    {
+        return lhs.parent < rhs.parent;
+    };
+    std::stable_sort(rBatch.m_inserts.begin(), rBatch.m_inserts.end(), parent_less);
+
+    auto &rOutEnts = rBatch.m_scratchTreeToEnt;
+    auto &rOutDesc = rBatch.m_scratchTreeDescendants;
+    rOutEnts.clear();
+    rOutDesc.clear();
+    rOutEnts.reserve(rScnGraph.m_treeToEnt.size() + rBatch.m_treeToEnt.size());
+    rOutDesc.reserve(rScnGraph.m_treeToEnt.size() + rBatch.m_treeToEnt.size());
+
+    std::size_t insertedTotal = 0;
+
+    // Copy a parent's new subtrees to the end of the output, making them its last children
+    auto const emit_inserts = [&] (ActiveEnt const parent)
+    {
+        auto const [itFirst, itLast] = std::equal_range(
+                rBatch.m_inserts.begin(), rBatch.m_inserts.end(),
+                SceneGraphBatch::Insert{parent, 0, 0}, parent_less);
+
+        for (auto it = itFirst; it != itLast; ++it)
+        {
+            for (TreePos_t pos = it->first; pos != it->first + it->count; ++pos)
+            {
+                ActiveEnt const ent = rBatch.m_treeToEnt[pos];
+                rScnGraph.m_entToTreePos[ent] = TreePos_t(rOutEnts.size());
+                rOutEnts.push_back(ent);
+                rOutDesc.push_back(rBatch.m_treeDescendants[pos]);
+            }
+            insertedTotal += it->count;
+        }
+    };
+
+    // Kept entities whose subtree is still being copied. Descendant counts are written once
+    // they're closed, since their subtree may have grown or shrunk.
+    struct Open
+    {
+        TreePos_t   oldEnd;
+        TreePos_t   newPos;
+        ActiveEnt   ent;
+    };
+    std::vector<Open> open;
+
+    TreePos_t const treeSize = TreePos_t(rScnGraph.m_treeToEnt.size());
+
+    rOutEnts.push_back(lgrn::id_null<ActiveEnt>());
+    rOutDesc.push_back(0);
+    open.push_back({treeSize, 0, lgrn::id_null<ActiveEnt>()});
+
+    TreePos_t pos = 1;
+    while ( ! open.empty() )
+    {
+        if (pos >= open.back().oldEnd)
+        {
+            Open const closed = open.back();
+            open.pop_back();
+            emit_inserts(closed.ent);
+            rOutDesc[closed.newPos] = uint32_t(rOutEnts.size() - closed.newPos - 1);
+            continue;
+        }
+
+        ActiveEnt const ent         = rScnGraph.m_treeToEnt[pos];
+        uint32_t const  descendants = rScnGraph.m_treeDescendants[pos];
+
+        while (itCut != rCutPos.cend() && *itCut < pos)
+        {
+            ++itCut; // Inside a subtree that was already removed
+        }
+
+        if (itCut != rCutPos.cend() && *itCut == pos)
+        {
+            for (TreePos_t removed = pos; removed != pos + descendants + 1; ++removed)
+            {
+                ActiveEnt const removedEnt = rScnGraph.m_treeToEnt[removed];
+                rScnGraph.m_entParent[removedEnt]      = lgrn::id_null<ActiveEnt>();
+                rScnGraph.m_entToTreePos[removedEnt]   = lgrn::id_null<TreePos_t>();
+            }
+            pos += descendants + 1;
+            continue;
+        }
+
+        auto const newPos = TreePos_t(rOutEnts.size());
+        rScnGraph.m_entToTreePos[ent] = newPos;
+        rOutEnts.push_back(ent);
+        rOutDesc.push_back(0);
+        open.push_back({pos + descendants + 1, newPos, ent});
+        ++pos;
+    }
+
+    LGRN_ASSERTMV(insertedTotal == rBatch.m_treeToEnt.size(),
+                  "Some batch insertions have parents that were removed or aren't in the scene graph",
+                  insertedTotal, rBatch.m_treeToEnt.size());
+
+    std::swap(rScnGraph.m_treeToEnt,       rOutEnts);
+    std::swap(rScnGraph.m_treeDescendants, rOutDesc);
+    ++rScnGraph.m_treeVersion;
+
+    rBatch.m_treeToEnt      .clear();
+    rBatch.m_treeDescendants.clear();
+    rBatch.m_inserts        .clear();
+    rBatch.m_cut            .clear();
+}
+
 ArrayView<ActiveEnt const> SysSceneGraph::descendants(ACtxSceneGraph const& rScnGraph, ActiveEnt root)
 {
     TreePos_t const rootPos = rScnGraph.m_entToTreePos[root];
@@ -140,6 +315,7 @@ void SysSceneGraph::do_delete(ACtxSceneGraph& rScnGraph)
     // since this is only a few KB in size, and is done once per update
 
     std::sort(rScnGraph.m_delete.begin(), rScnGraph.m_delete.end());
+    ++rScnGraph.m_treeVersion;
 
     TreePos_t const treeLast    = 1 + rScnGraph.m_treeDescendants[0];
 
@@ -45,10 +45,25 @@ class SubtreeBuilder
 {
 public:
     constexpr SubtreeBuilder(ACtxSceneGraph& rScnGraph, ActiveEnt root, TreePos_t first, TreePos_t last) noexcept
-     : m_rScnGraph{rScnGraph}
-     , m_root{root}
+     : SubtreeBuilder(rScnGraph, rScnGraph.m_treeToEnt, rScnGraph.m_treeDescendants, root, first, last)
+    { }
+
+    /**
+     * @brief Build into separate tree arrays, used by SceneGraphBatch
+     */
+    constexpr SubtreeBuilder(
+            ACtxSceneGraph&                 rScnGraph,
+            KeyedVec<TreePos_t, ActiveEnt>& rTreeToEnt,
+            KeyedVec<TreePos_t, uint32_t>&  rTreeDescendants,
+            ActiveEnt                       root,
+            TreePos_t                       first,
+            TreePos_t                       last) noexcept
+     : m_root{root}
      , m_first{first}
      , m_last{last}
+     , m_rScnGraph{rScnGraph}
+     , m_rTreeToEnt{rTreeToEnt}
+     , m_rTreeDescendants{rTreeDescendants}
     { }
     OSP_MOVE_ONLY_CTOR_CONSTEXPR_NOEXCEPT(SubtreeBuilder)
     ~SubtreeBuilder() { assert(m_first == m_last); }
@@ -65,6 +80,21 @@ public:
         (void) add_child(ent, 0);
     }
 
+    /**
+     * @brief Add a whole subtree that's already laid out in depth-first order
+     *
+     * Equivalent to recursively calling add_child for each entity, but copies straight into the
+     * tree arrays.
+     *
+     * @param ents          [in] Entities in depth-first order, ents[0] is the subtree root
+     * @param descendants   [in] Descendant count of each entity
+     * @param parents       [in] Index of each entity's parent in ents, or -1 for the root
+     */
+    void add_preordered(
+            ArrayView<ActiveEnt const>  ents,
+            ArrayView<uint32_t const>   descendants,
+            ArrayView<int32_t const>    parents);
+
     std::size_t remaining()
     {
         assert(m_last >= m_first);
@@ -77,6 +107,8 @@ private:
     TreePos_t m_last;
 
     ACtxSceneGraph& m_rScnGraph;
+    KeyedVec<TreePos_t, ActiveEnt>& m_rTreeToEnt;
+    KeyedVec<TreePos_t, uint32_t>&  m_rTreeDescendants;
 
 }; // class SubtreeBuilder
 
@@ -135,6 +167,33 @@ public:
      */
     [[nodiscard]] static SubtreeBuilder add_descendants(ACtxSceneGraph& rScnGraph, uint32_t descendantCount, ActiveEnt root = lgrn::id_null<ActiveEnt>());
 
+    /**
+     * @brief Reserve space for new entities in a batch, using a SubtreeBuilder
+     *
+     * Entities are added to the scene graph once batch_apply is called, after existing children
+     * of root and subtrees added earlier in the batch. root must already be in the scene graph.
+     */
+    [[nodiscard]] static SubtreeBuilder batch_add_descendants(ACtxSceneGraph& rScnGraph, SceneGraphBatch& rBatch, uint32_t descendantCount, ActiveEnt root = lgrn::id_null<ActiveEnt>());
+
+    /**
+     * @brief Queue entities and their descendants to be removed by batch_apply
+     *
+     * Unlike cut, entities may be ancestors of other entities in the same batch.
+     */
+    template<typename ITA_T, typename ITB_T>
+    static void batch_cut(SceneGraphBatch& rBatch, ITA_T first, ITB_T const& last)
+    {
+        rBatch.m_cut.insert(rBatch.m_cut.end(), first, last);
+    }
+
+    /**
+     * @brief Apply all insertions and removals of a batch in one pass over the scene graph
+     *
+     * O(tree size + batch size), regardless of how many subtrees were added or removed. The
+     * batch is cleared afterwards, keeping its allocations.
+     */
+    static void batch_apply(ACtxSceneGraph& rScnGraph, SceneGraphBatch& rBatch);
+
     /**
      * @return Iterable range of an entity's descendants
      */
@@ -151,6 +210,17 @@ public:
      */
     static ChildRange_t children(ACtxSceneGraph const& rScnGraph, ActiveEnt parent = lgrn::id_null<ActiveEnt>());
 
+    /**
+     * @brief Mark an entity's ACompTransform as changed, so draw transforms of it and its
+     *        descendants are recalculated
+     *
+     * Safe to call from multiple threads at once for different entities.
+     */
+    static void mark_transform_dirty(ACtxSceneGraph& rScnGraph, ActiveEnt const ent) noexcept
+    {
+        rScnGraph.m_transformDirty[ent] = 1;
+    }
+
     /**
      * @brief Remove multiple entities from a scene graph
      *
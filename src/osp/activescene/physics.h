@@ -26,9 +26,14 @@
 
 #include "basic.h"
 
+#include "../core/array_view.h"
 #include "../core/keyed_vector.h"
 #include "../scientific/shapes.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
 namespace osp::active
 {
 
@@ -42,6 +47,129 @@ struct ACompMass
     float   m_mass;
 };
 
+/**
+ * @brief Combined mass of an entity's descendants, in the entity's space
+ *
+ * Kept as sums (mass, first moment, and inertia about the entity's origin) rather than a center
+ * and inertia about it, so a change to one descendant can be applied as a difference. See
+ * SysPhysics::update_subtree_mass.
+ */
+struct SubtreeMass
+{
+    float   m_mass{0.0f};
+    Vector3 m_moment{0.0f};     ///< Sum of mass * position
+    Matrix3 m_inertia{0.0f};    ///< Inertia tensor about the origin
+
+    [[nodiscard]] Vector3 center() const noexcept
+    {
+        return (m_mass > 0.0f) ? (m_moment / m_mass) : Vector3{0.0f};
+    }
+
+    /// Inertia tensor about center(), through the parallel axis theorem
+    [[nodiscard]] Matrix3 inertia_about_center() const noexcept
+    {
+        Vector3 const c = center();
+        Matrix3 const outerProductC = {c * c.x(), c * c.y(), c * c.z()};
+        return m_inertia - m_mass * (Magnum::Math::dot(c, c) * Matrix3{} - outerProductC);
+    }
+
+    SubtreeMass& operator+=(SubtreeMass const& rhs) noexcept
+    {
+        m_mass += rhs.m_mass; m_moment += rhs.m_moment; m_inertia += rhs.m_inertia;
+        return *this;
+    }
+
+    SubtreeMass& operator-=(SubtreeMass const& rhs) noexcept
+    {
+        m_mass -= rhs.m_mass; m_moment -= rhs.m_moment; m_inertia -= rhs.m_inertia;
+        return *this;
+    }
+};
+
+/**
+ * @brief Raycasts submitted by any task, answered all at once by the physics backend after the
+ *        world is updated
+ *
+ * Rays and results are stored as separate arrays, all of the same length, indexed by the value
+ * returned from SysPhysics::raycast_submit.
+ */
+struct RaycastQueries
+{
+    std::vector<Vector3>    m_origins;
+    std::vector<Vector3>    m_directions;   ///< Not normalized; the ray ends at origin + direction
+    std::vector<ActiveEnt>  m_ignore;       ///< Entity with a body the ray passes through, or null
+
+    /// Fraction of direction to the closest hit, or above 1.0f for a miss
+    std::vector<float>      m_hitFraction;
+    std::vector<Vector3>    m_hitNormal;
+    std::vector<ActiveEnt>  m_hitEnt;       ///< Entity of the body hit, or null for a miss
+
+    [[nodiscard]] std::size_t size() const noexcept { return m_origins.size(); }
+
+    [[nodiscard]] bool hit(std::size_t const ray) const noexcept { return m_hitFraction[ray] <= 1.0f; }
+};
+
+/**
+ * @brief Two bodies hitting each other, reported by the physics backend
+ */
+struct PhysicsContact
+{
+    ActiveEnt   m_entA;     ///< May be null for bodies not owned by an entity
+    ActiveEnt   m_entB;
+    Vector3     m_point;    ///< World space
+    Vector3     m_impulse;  ///< On A, along the contact normal. Estimated from approach speed.
+};
+
+/**
+ * @brief Fixed-capacity buffer of contacts found during physics updates
+ *
+ * Physics threads append with a single atomic increment, nothing is allocated while the world
+ * updates. Contacts past capacity are counted, then dropped.
+ */
+struct ContactStream
+{
+    static constexpr std::size_t smc_defaultCapacity = 4096;
+
+    /// Slowest approach in m/s reported, so resting contacts aren't reported every step
+    static constexpr float smc_minSpeed = 0.1f;
+
+    ContactStream() : m_buffer(smc_defaultCapacity) { }
+
+    /// Safe to call from multiple threads at once
+    void append(PhysicsContact const& contact) noexcept
+    {
+        std::size_t const index = m_count.fetch_add(1, std::memory_order_relaxed);
+        if (index < m_buffer.size())
+        {
+            m_buffer[index] = contact;
+        }
+    }
+
+    [[nodiscard]] ArrayView<PhysicsContact const> contacts() const noexcept
+    {
+        return {m_buffer.data(), std::min(m_count.load(std::memory_order_relaxed), m_buffer.size())};
+    }
+
+    [[nodiscard]] std::size_t dropped() const noexcept
+    {
+        std::size_t const count = m_count.load(std::memory_order_relaxed);
+        return (count > m_buffer.size()) ? (count - m_buffer.size()) : 0;
+    }
+
+    void clear() noexcept { m_count.store(0, std::memory_order_relaxed); }
+
+    /// Not thread-safe, only call while the world isn't updating
+    void set_capacity(std::size_t const capacity)
+    {
+        m_buffer.resize(capacity);
+        clear();
+    }
+
+private:
+    std::vector<PhysicsContact> m_buffer;
+    std::atomic<std::size_t>    m_count{0};
+};
+
 /**
  * @brief Physics components and other data needed to support physics in a scene
  */
@@ -55,6 +183,16 @@ struct ACtxPhysics
 
     std::vector< std::pair<ActiveEnt, Vector3> > m_setVelocity;
 
+    /// Cached by SysPhysics::build_subtree_mass, only valid for m_hasSubtreeMass
+    KeyedVec<ActiveEnt, SubtreeMass> m_subtreeMass;
+    ActiveEntSet_t                  m_hasSubtreeMass;
+
+    /// Cleared each frame, see SysPhysics::raycast_submit
+    RaycastQueries                  m_rays;
+
+    /// Written to by the physics backend while updating, cleared each frame
+    ContactStream                   m_contacts;
+
 }; // struct ACtxPhysics
 
 
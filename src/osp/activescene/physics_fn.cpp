@@ -94,3 +94,164 @@ void SysPhysics::calculate_subtree_mass_inertia(
         }
     }
 }
+
+/**
+ * @brief Contribution of a single ACompMass to its parent's SubtreeMass
+ */
+static SubtreeMass mass_contribution(ACompMass const& mass, Matrix4 const& tf) noexcept
+{
+    Matrix3 const rotation = tf.rotation();
+    Matrix3 inertia{0.0f};
+    inertia[0][0] = mass.m_inertia.x();
+    inertia[1][1] = mass.m_inertia.y();
+    inertia[2][2] = mass.m_inertia.z();
+
+    Vector3 const p = tf.transformPoint(mass.m_offset);
+    Matrix3 const outerProductP = {p * p.x(), p * p.y(), p * p.z()};
+
+    return {
+        .m_mass     = mass.m_mass,
+        .m_moment   = p * mass.m_mass,
+        .m_inertia  = rotation * inertia * rotation.transposed()
+                    + mass.m_mass * (Magnum::Math::dot(p, p) * Matrix3{} - outerProductP)
+    };
+}
+
+/**
+ * @brief Move a SubtreeMass from a child's space to its parent's, given the child's transform
+ *
+ * Linear in the sums, so this also applies to differences.
+ */
+static SubtreeMass transform_subtree_mass(SubtreeMass const& in, Matrix4 const& tf) noexcept
+{
+    Matrix3 const rotation  = tf.rotation();
+    Vector3 const t         = tf.translation();
+    Vector3 const moment    = rotation * in.m_moment;
+
+    Matrix3 const outerProductT     = {t * t.x(), t * t.y(), t * t.z()};
+    Matrix3 const momentOuterT      = {moment * t.x(), moment * t.y(), moment * t.z()};
+
+    return {
+        .m_mass     = in.m_mass,
+        .m_moment   = moment + t * in.m_mass,
+        .m_inertia  = rotation * in.m_inertia * rotation.transposed()
+                    + (2.0f * Magnum::Math::dot(t, moment)) * Matrix3{}
+                    - momentOuterT - momentOuterT.transposed()
+                    + in.m_mass * (Magnum::Math::dot(t, t) * Matrix3{} - outerProductT)
+    };
+}
+
+static SubtreeMass build_subtree_mass_recurse(
+        ACompTransformStorage_t const&  rTf,
+        ACtxPhysics&                    rCtxPhys,
+        ACtxSceneGraph const&           rScnGraph,
+        ActiveEnt const                 ent)
+{
+    SubtreeMass out;
+    for (ActiveEnt const child : SysSceneGraph::children(rScnGraph, ent))
+    {
+        Matrix4 const& childTf = rTf.get(child).m_transform;
+
+        if (rCtxPhys.m_mass.contains(child))
+        {
+            out += mass_contribution(rCtxPhys.m_mass.get(child), childTf);
+        }
+
+        if (rCtxPhys.m_hasColliders.contains(child))
+        {
+            out += transform_subtree_mass(build_subtree_mass_recurse(rTf, rCtxPhys, rScnGraph, child), childTf);
+        }
+    }
+
+    rCtxPhys.m_subtreeMass[ent] = out;
+    rCtxPhys.m_hasSubtreeMass.insert(ent);
+    return out;
+}
+
+void SysPhysics::build_subtree_mass(
+        ACompTransformStorage_t const&  rTf,
+        ACtxPhysics&                    rCtxPhys,
+        ACtxSceneGraph const&           rScnGraph,
+        ActiveEnt const                 root)
+{
+    std::size_t const capacity = rScnGraph.m_entParent.size();
+    rCtxPhys.m_subtreeMass.resize(capacity);
+    rCtxPhys.m_hasSubtreeMass.resize(capacity);
+
+    build_subtree_mass_recurse(rTf, rCtxPhys, rScnGraph, root);
+}
+
+void SysPhysics::update_subtree_mass(
+        ACompTransformStorage_t const&  rTf,
+        ACtxPhysics&                    rCtxPhys,
+        ACtxSceneGraph const&           rScnGraph,
+        ActiveEnt const                 ent,
+        ACompMass const&                mass)
+{
+    Matrix4 const& entTf = rTf.get(ent).m_transform;
+
+    SubtreeMass delta = mass_contribution(mass, entTf);
+    if (rCtxPhys.m_mass.contains(ent))
+    {
+        delta -= mass_contribution(rCtxPhys.m_mass.get(ent), entTf);
+        rCtxPhys.m_mass.get(ent) = mass;
+    }
+    else
+    {
+        rCtxPhys.m_mass.emplace(ent, mass);
+    }
+
+    // The entity's own mass counts towards its parent. Further up, each subtree only counts
+    // towards the next if it has colliders, same as build_subtree_mass.
+    ActiveEnt child  = ent;
+    ActiveEnt parent = rScnGraph.m_entParent[ent];
+    while (   parent != lgrn::id_null<ActiveEnt>()
+           && std::size_t(parent) < rCtxPhys.m_subtreeMass.size()
+           && rCtxPhys.m_hasSubtreeMass.contains(parent))
+    {
+        if (child != ent)
+        {
+            delta = transform_subtree_mass(delta, rTf.get(child).m_transform);
+        }
+        rCtxPhys.m_subtreeMass[parent] += delta;
+
+        if ( ! rCtxPhys.m_hasColliders.contains(parent) )
+        {
+            break;
+        }
+        child  = parent;
+        parent = rScnGraph.m_entParent[parent];
+    }
+}
+
+std::uint32_t SysPhysics::raycast_submit(
+        ACtxPhysics&    rCtxPhys,
+        Vector3         origin,
+        Vector3         direction,
+        ActiveEnt       ignore)
+{
+    RaycastQueries &rRays = rCtxPhys.m_rays;
+    auto const index = static_cast<std::uint32_t>(rRays.m_origins.size());
+    rRays.m_origins     .push_back(origin);
+    rRays.m_directions  .push_back(direction);
+    rRays.m_ignore      .push_back(ignore);
+    return index;
+}
+
+void SysPhysics::raycast_prepare_results(RaycastQueries& rRays) noexcept
+{
+    std::size_t const count = rRays.size();
+    rRays.m_hitFraction .assign(count, 2.0f);
+    rRays.m_hitNormal   .assign(count, Vector3{0.0f});
+    rRays.m_hitEnt      .assign(count, lgrn::id_null<ActiveEnt>());
+}
+
+void SysPhysics::raycast_clear(RaycastQueries& rRays) noexcept
+{
+    rRays.m_origins     .clear();
+    rRays.m_directions  .clear();
+    rRays.m_ignore      .clear();
+    rRays.m_hitFraction .clear();
+    rRays.m_hitNormal   .clear();
+    rRays.m_hitEnt      .clear();
+}
@@ -53,9 +53,56 @@ public:
             Matrix3&                                rInertiaTensor,
             Matrix4 const&                          currentTf = {});
 
+    /**
+     * @brief Calculate and cache the SubtreeMass of root and each of its descendants with
+     *        colliders, see ACtxPhysics::m_subtreeMass
+     *
+     * Follows the same entities as calculate_subtree_mass_inertia. Costs O(subtree); call once
+     * when the subtree is built, then use update_subtree_mass for changes.
+     */
+    static void build_subtree_mass(
+            ACompTransformStorage_t const&          rTf,
+            ACtxPhysics&                            rCtxPhys,
+            ACtxSceneGraph const&                   rScnGraph,
+            ActiveEnt                               root);
+
+    /**
+     * @brief Set an entity's ACompMass, and apply the difference to the cached SubtreeMass of
+     *        each ancestor in O(depth)
+     *
+     * Rounding errors accumulate over many updates; rebuild with build_subtree_mass once in a
+     * while if exact values matter.
+     */
+    static void update_subtree_mass(
+            ACompTransformStorage_t const&          rTf,
+            ACtxPhysics&                            rCtxPhys,
+            ACtxSceneGraph const&                   rScnGraph,
+            ActiveEnt                               ent,
+            ACompMass const&                        mass);
+
     template<typename IT_T, typename ITB_T>
     static void update_delete_phys(ACtxPhysics& rCtxPhys, IT_T const& first, ITB_T const& last);
 
+    /**
+     * @brief Queue a raycast, answered by the physics backend's raycast task
+     *
+     * @return Index of the ray's results in ACtxPhysics::m_rays
+     */
+    static std::uint32_t raycast_submit(
+            ACtxPhysics&    rCtxPhys,
+            Vector3         origin,
+            Vector3         direction,
+            ActiveEnt       ignore = lgrn::id_null<ActiveEnt>());
+
+    /**
+     * @brief Size result arrays to match the submitted rays, and default them to misses
+     *
+     * Called by physics backends before answering rays.
+     */
+    static void raycast_prepare_results(RaycastQueries& rRays) noexcept;
+
+    static void raycast_clear(RaycastQueries& rRays) noexcept;
+
 };
 
 template<typename IT_T, typename ITB_T>
@@ -29,89 +29,84 @@
 #include "../vehicles/ImporterData.h"
 
 #include <Magnum/Trade/Trade.h>
-#include <Magnum/Trade/PbrMetallicRoughnessMaterialData.h>
+
+#include <Corrade/Containers/ArrayViewStl.h>
+
+#include <longeron/utility/asserts.hpp>
 
 using Corrade::Containers::ArrayView;
+using Corrade::Containers::arrayView;
 
 using osp::restypes::gc_importer;
 
 namespace osp::active
 {
 
+PrefabTemplate const& SysPrefabInit::template_of(
+        TmpPrefabRequest const&             request,
+        Resources const&                    rResources) noexcept
+{
+    auto const &rPrefabData = rResources.data_get<osp::Prefabs const>(gc_importer, request.m_importerRes);
+    LGRN_ASSERTM(request.m_prefabId < rPrefabData.m_templates.size(),
+                 "Prefab templates not compiled, see compile_prefab_templates");
+    return rPrefabData.m_templates[request.m_prefabId];
+}
+
 void SysPrefabInit::create_activeents(
         ACtxPrefabs&                        rPrefabs,
         ACtxBasic&                          rBasic,
-        Resources&                          rResources)
+        Resources&                          rResources,
+        FrameArena&                         rArena)
 {
     // Count number of entities needed to be created
     std::size_t totalEnts = 0;
     for (TmpPrefabRequest const& rPfBasic : rPrefabs.spawnRequest)
     {
-        auto const& rPrefabData = rResources.data_get<Prefabs>(gc_importer, rPfBasic.m_importerRes);
-        auto const& objects     = rPrefabData.m_prefabs[rPfBasic.m_prefabId];
-
-        totalEnts += objects.size();
+        totalEnts += template_of(rPfBasic, rResources).size();
     }
 
     // Create entities
-    rPrefabs.newEnts.resize(totalEnts);
+    rPrefabs.newEnts = rArena.allocate<ActiveEnt>(totalEnts);
     rBasic.m_activeIds.create(std::begin(rPrefabs.newEnts), std::end(rPrefabs.newEnts));
 
     // Assign new entities to each prefab to create
-    rPrefabs.spawnedEntsOffset.resize(rPrefabs.spawnRequest.size());
+    rPrefabs.spawnedEntsOffset = rArena.allocate< ArrayView<ActiveEnt const> >(rPrefabs.spawnRequest.size());
     auto itEntAvailable = std::begin(rPrefabs.newEnts);
     auto itPfEntSpanOut = std::begin(rPrefabs.spawnedEntsOffset);
     for (TmpPrefabRequest& rPfBasic : rPrefabs.spawnRequest)
     {
-        auto const& rPrefabData = rResources.data_get<Prefabs>(gc_importer, rPfBasic.m_importerRes);
-        auto const& objects     = rPrefabData.m_prefabs[rPfBasic.m_prefabId];
+        std::size_t const count = template_of(rPfBasic, rResources).size();
 
-        (*itPfEntSpanOut) = { &(*itEntAvailable), objects.size() };
+        (*itPfEntSpanOut) = { &(*itEntAvailable), count };
 
-        std::advance(itEntAvailable, objects.size());
+        std::advance(itEntAvailable, count);
         std::advance(itPfEntSpanOut, 1);
     }
 
     assert(itEntAvailable == std::end(rPrefabs.newEnts));
 }
 
+void SysPrefabInit::clear_requests(
+        ACtxPrefabs&                        rPrefabs,
+        FrameArena&                         rArena) noexcept
+{
+    rPrefabs.spawnRequest.clear();
+    rPrefabs.spawnedEntsOffset  = {};
+    rPrefabs.newEnts            = {};
+    rArena.reset();
+}
+
 void SysPrefabInit::add_to_subtree(
         TmpPrefabRequest const&             basic,
         ArrayView<ActiveEnt const>          ents,
         Resources const&                    rResources,
         SubtreeBuilder&                     bldPrefab) noexcept
 {
-    auto const &rImportData = rResources.data_get<osp::ImporterData const>(
-            gc_importer, basic.m_importerRes);
-    auto const &rPrefabData = rResources.data_get<osp::Prefabs const>(
-            gc_importer, basic.m_importerRes);
-
-    auto const& objs    = rPrefabData.m_prefabs[basic.m_prefabId];
-    auto const& parents = rPrefabData.m_prefabParents[basic.m_prefabId];
-
-    auto itObj      = std::begin(objs);
-    auto itEnt      = std::begin(ents);
-
-    auto const add_child_recurse
-            = [&rImportData, &itObj, &itEnt, &parents] (auto&& self, SubtreeBuilder& bldParent) -> void
-    {
-        std::size_t const descendants   = rImportData.m_objDescendants[*itObj];
-        auto bldChildren = bldParent.add_child(*itEnt, descendants);
-        auto children = rImportData.m_objChildren[*itObj];
-
-        std::advance(itObj, 1);
-        std::advance(itEnt, 1);
-
-        for ([[maybe_unused]] ObjId const child : children)
-        {
-            self(self, bldChildren);
-        }
-    };
+    PrefabTemplate const &rTemplate = template_of(basic, rResources);
 
-    add_child_recurse(add_child_recurse, bldPrefab);
+    LGRN_ASSERT(ents.size() == rTemplate.size());
 
-    assert(itObj == std::end(objs));
-    assert(itEnt == std::end(ents));
+    bldPrefab.add_preordered(ents, arrayView(rTemplate.descendants), arrayView(rTemplate.parents));
 }
 
 void SysPrefabInit::init_transforms(
@@ -123,21 +118,13 @@ void SysPrefabInit::init_transforms(
 
     for (TmpPrefabRequest const& rPfBasic : rPrefabs.spawnRequest)
     {
-        auto const &rImportData = rResources.data_get<osp::ImporterData const>(
-                gc_importer, rPfBasic.m_importerRes);
-        auto const &rPrefabData = rResources.data_get<osp::Prefabs const>(
-                gc_importer, rPfBasic.m_importerRes);
-
-        auto const objects = rPrefabData.m_prefabs[rPfBasic.m_prefabId];
-        auto const parents = rPrefabData.m_prefabParents[rPfBasic.m_prefabId];
+        PrefabTemplate const &rTemplate = template_of(rPfBasic, rResources);
+        auto const ents                 = ArrayView<ActiveEnt const>{*itPfEnts};
 
-        for (std::size_t i = 0; i < objects.size(); ++i)
+        rTransform.emplace(ents[0], *rPfBasic.m_pTransform);
+        for (std::size_t i = 1; i < ents.size(); ++i)
         {
-            Matrix4 const& transform = (parents[i] == -1)
-                    ? *rPfBasic.m_pTransform
-                    : rImportData.m_objTransforms[objects[i]];
-            ActiveEnt const ent = (*itPfEnts)[i];
-            rTransform.emplace(ent, transform);
+            rTransform.emplace(ents[i], rTemplate.transforms[i]);
         }
 
         ++itPfEnts;
@@ -152,16 +139,10 @@ void SysPrefabInit::init_info(
 
     for (TmpPrefabRequest const& rPfBasic : rPrefabs.spawnRequest)
     {
-        auto const &rImportData = rResources.data_get<osp::ImporterData const>(
-                gc_importer, rPfBasic.m_importerRes);
-        auto const &rPrefabData = rResources.data_get<osp::Prefabs const>(
-                gc_importer, rPfBasic.m_importerRes);
-
-        auto const ents     = ArrayView<ActiveEnt const>{*itPfEnts};
-        auto const objects = rPrefabData.m_prefabs[rPfBasic.m_prefabId];
-        auto const parents = rPrefabData.m_prefabParents[rPfBasic.m_prefabId];
+        PrefabTemplate const &rTemplate = template_of(rPfBasic, rResources);
+        auto const ents                 = ArrayView<ActiveEnt const>{*itPfEnts};
 
-        for (std::size_t i = 0; i < objects.size(); ++i)
+        for (std::size_t i = 0; i < ents.size(); ++i)
         {
             ActiveEnt const ent = ents[i];
             PrefabInstanceInfo &rInfo = rPrefabs.instanceInfo[ent];
@@ -169,7 +150,7 @@ void SysPrefabInit::init_info(
             rInfo.prefab    = rPfBasic.m_prefabId;
             rInfo.obj       = static_cast<ObjId>(i);
 
-            if (parents[i] == -1)
+            if (rTemplate.parents[i] == -1)
             {
                 rPrefabs.roots.insert(ent);
             }
@@ -184,43 +165,17 @@ void SysPrefabInit::init_physics(
             Resources const&                rResources,
             ACtxPhysics&                    rCtxPhys) noexcept
 {
-
     auto itPfEnts = rPrefabs.spawnedEntsOffset.begin();
 
     for (TmpPrefabRequest const& rPfBasic : rPrefabs.spawnRequest)
     {
-        auto const &rImportData = rResources.data_get<osp::ImporterData const>(
-                gc_importer, rPfBasic.m_importerRes);
-        auto const &rPrefabData = rResources.data_get<osp::Prefabs const>(
-                gc_importer, rPfBasic.m_importerRes);
-
-        auto const ents     = ArrayView<ActiveEnt const>{*itPfEnts};
-        auto const objects  = lgrn::Span<int const>     {rPrefabData.m_prefabs[rPfBasic.m_prefabId]};
-        auto const parents  = lgrn::Span<int const>     {rPrefabData.m_prefabParents[rPfBasic.m_prefabId]};
-
-#if 0
-        auto const assign_dyn_recurse = [&rCtxPhys, ents, objects, parents] (auto const& self, int objectId, ActiveEnt ent) -> void
-        {
-            int const parentId = parents[objectId];
-            if (parentId == -1)
-            {
-                return;
-            }
-
-            ActiveEnt const parentEnt = ents[parentId];
-
-            if ( ! rCtxPhys.m_totalDyn.contains(parentEnt) )
-            {
-                rCtxPhys.m_totalDyn.emplace(parentEnt);
-            }
-
-            self(self, parentId, parentEnt);
-        };
-#endif
+        PrefabTemplate const &rTemplate = template_of(rPfBasic, rResources);
+        auto const ents                 = ArrayView<ActiveEnt const>{*itPfEnts};
+        auto const parents              = arrayView(rTemplate.parents);
 
         auto const assign_collider_recurse
-                = [&rHasColliders = rCtxPhys.m_hasColliders, ents, objects, parents]
-                  (auto const& self, int objectId, ActiveEnt ent) -> void
+                = [&rHasColliders = rCtxPhys.m_hasColliders, ents, parents]
+                  (auto const& self, int index, ActiveEnt ent) -> void
         {
             if (rHasColliders.contains(ent))
             {
@@ -228,37 +183,31 @@ void SysPrefabInit::init_physics(
             }
             rHasColliders.insert(ent);
 
-            int const parentId = parents[objectId];
+            int const parentIndex = parents[index];
 
-            if (parentId != -1)
+            if (parentIndex != -1)
             {
-                self(self, parentId, ents[parentId]);
+                self(self, parentIndex, ents[parentIndex]);
             }
         };
 
-        for (std::size_t i = 0; i < objects.size(); ++i)
+        for (std::size_t i = 0; i < ents.size(); ++i)
         {
             ActiveEnt const ent         = ents[i];
-            int const       objectId    = objects[i];
-            float const     mass        = rPrefabData.m_objMass[objectId];
-            EShape const    shape       = rPrefabData.m_objShape[objectId];
-
+            float const     mass        = rTemplate.masses[i];
+            EShape const    shape       = rTemplate.shapes[i];
 
             rCtxPhys.m_shape[ent] = shape;
 
             if (mass != 0.0f)
             {
-                Vector3 const scale = rImportData.m_objTransforms[objectId].scaling();
-                Vector3 const inertia = collider_inertia_tensor(shape, scale, mass);
                 Vector3 const offset{0.0f, 0.0f, 0.0f};
-                rCtxPhys.m_mass.emplace( ent, ACompMass{ offset, inertia, mass } );
-
-                //assign_dyn_recurse(assign_dyn_recurse, objectId, ent);
+                rCtxPhys.m_mass.emplace( ent, ACompMass{ offset, rTemplate.inertias[i], mass } );
             }
 
             if ( (mass != 0.0f) || (shape != EShape::None) )
             {
-                assign_collider_recurse(assign_collider_recurse, objectId, ent);
+                assign_collider_recurse(assign_collider_recurse, int(i), ent);
             }
         }
 
@@ -28,6 +28,7 @@
 #include "physics.h"
 
 #include "../core/array_view.h"
+#include "../core/frame_arena.h"
 #include "../core/resourcetypes.h"
 #include "../vehicles/prefabs.h"
 
@@ -63,8 +64,11 @@ struct PrefabInstanceInfo
 struct ACtxPrefabs
 {
     std::vector<TmpPrefabRequest>               spawnRequest;
-    std::vector< ArrayView<ActiveEnt const> >   spawnedEntsOffset;
-    std::vector<ActiveEnt>                      newEnts;
+
+    // Allocated from a FrameArena by SysPrefabInit::create_activeents, only valid until the
+    // arena is reset along with spawnRequest
+    ArrayView< ArrayView<ActiveEnt const> >     spawnedEntsOffset;
+    ArrayView<ActiveEnt>                        newEnts;
 
     osp::active::ActiveEntSet_t                 roots;
     KeyedVec<ActiveEnt, PrefabInstanceInfo>     instanceInfo;
@@ -74,10 +78,25 @@ class SysPrefabInit
 {
 public:
 
+    /**
+     * @return Compiled template of the prefab a request spawns
+     */
+    [[nodiscard]] static PrefabTemplate const& template_of(
+            TmpPrefabRequest const&     request,
+            Resources const&            rResources) noexcept;
+
     static void create_activeents(
             ACtxPrefabs&                rPrefabs,
             ACtxBasic&                  rBasic,
-            Resources&                  rResources);
+            Resources&                  rResources,
+            FrameArena&                 rArena);
+
+    /**
+     * @brief Forget spawn requests and their entity views, then reset the arena they're in
+     */
+    static void clear_requests(
+            ACtxPrefabs&                rPrefabs,
+            FrameArena&                 rArena) noexcept;
 
     static void add_to_subtree(
             TmpPrefabRequest const&     basic,
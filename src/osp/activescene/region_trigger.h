@@ -0,0 +1,89 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "basic.h"
+
+#include "../core/array_view.h"
+#include "../core/keyed_vector.h"
+#include "../core/math_types.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace osp::active
+{
+
+/**
+ * @brief Axis-aligned box in scene space, an entity is inside if m_min <= position < m_max
+ *
+ * Use +/- infinity for unbounded sides, eg: a kill plane below the world.
+ */
+struct TriggerRegion
+{
+    Vector3 m_min;
+    Vector3 m_max;
+};
+
+/**
+ * @brief An entity entered or left a TriggerRegion
+ */
+struct RegionTriggerEvent
+{
+    ActiveEnt       m_ent;
+    std::uint8_t    m_region;   ///< Index into ACtxRegionTriggers::m_regions
+    bool            m_entered;  ///< True if entered, false if left
+};
+
+/**
+ * @brief Reports entities crossing the boundaries of a few TriggerRegions
+ *
+ * Only entities whose transform was marked dirty are retested (see
+ * ACtxSceneGraph::m_transformDirty), so resting entities cost a single byte read. Only crossings
+ * are reported, an entity staying inside a region does not generate more events.
+ *
+ * See SysRegionTrigger
+ */
+struct ACtxRegionTriggers
+{
+    static constexpr std::size_t smc_maxRegions = 32;
+
+    /// Regions to test against, at most smc_maxRegions
+    std::vector<TriggerRegion>          m_regions;
+
+    /// Entities tested against m_regions
+    ActiveEntSet_t                      m_tracked;
+
+    /// Bits of each region that each tracked entity is currently inside of
+    KeyedVec<ActiveEnt, std::uint32_t>  m_inside;
+
+    /// Newly tracked entities, always tested by the next update
+    ActiveEntVec_t                      m_newlyTracked;
+
+    /// Crossings found by the last update. Clear once consumed
+    std::vector<RegionTriggerEvent>     m_events;
+};
+
+} // namespace osp::active
@@ -0,0 +1,105 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "region_trigger_fn.h"
+
+#include "../core/bitvector.h"
+
+#include <bit>
+#include <utility>
+
+namespace osp::active
+{
+
+void SysRegionTrigger::track(ACtxRegionTriggers& rCtx, ActiveEnt const ent, std::size_t const capacity)
+{
+    rCtx.m_tracked.resize(capacity);
+    rCtx.m_inside.resize(capacity, 0);
+
+    rCtx.m_tracked.insert(ent);
+    rCtx.m_inside[ent] = 0;
+    rCtx.m_newlyTracked.push_back(ent);
+}
+
+std::uint32_t SysRegionTrigger::inside_mask(ArrayView<TriggerRegion const> const regions, Vector3 const& pos) noexcept
+{
+    std::uint32_t mask = 0;
+    for (std::size_t i = 0; i < regions.size(); ++i)
+    {
+        TriggerRegion const &region = regions[i];
+        bool const inside =    (region.m_min.x() <= pos.x()) & (pos.x() < region.m_max.x())
+                             & (region.m_min.y() <= pos.y()) & (pos.y() < region.m_max.y())
+                             & (region.m_min.z() <= pos.z()) & (pos.z() < region.m_max.z());
+        mask |= std::uint32_t(inside) << i;
+    }
+    return mask;
+}
+
+void SysRegionTrigger::update(
+        ACtxRegionTriggers&                 rCtx,
+        ACtxSceneGraph const&               scnGraph,
+        ACompTransformStorage_t const&      transforms)
+{
+    LGRN_ASSERTM(rCtx.m_regions.size() <= ACtxRegionTriggers::smc_maxRegions, "Too many regions");
+
+    ArrayView<TriggerRegion const> const regions{rCtx.m_regions.data(), rCtx.m_regions.size()};
+
+    auto const retest = [&rCtx, &regions, &transforms] (ActiveEnt const ent)
+    {
+        Vector3 const           pos     = transforms.get(ent).m_transform.translation();
+        std::uint32_t const     inside  = inside_mask(regions, pos);
+        std::uint32_t const     changed = inside ^ std::exchange(rCtx.m_inside[ent], inside);
+
+        for (std::uint32_t bits = changed; bits != 0; bits &= bits - 1)
+        {
+            auto const region = std::uint8_t(std::countr_zero(bits));
+            rCtx.m_events.push_back({ent, region, ((inside >> region) & 1u) != 0});
+        }
+    };
+
+    for (ActiveEnt const ent : rCtx.m_newlyTracked)
+    {
+        if (rCtx.m_tracked.contains(ent))
+        {
+            retest(ent);
+        }
+    }
+
+    for (ActiveEnt const ent : rCtx.m_tracked)
+    {
+        if (std::size_t(ent) < scnGraph.m_transformDirty.size() && scnGraph.m_transformDirty[ent] != 0)
+        {
+            retest(ent);
+        }
+    }
+
+    rCtx.m_newlyTracked.clear();
+}
+
+void SysRegionTrigger::remove_deleted(ACtxRegionTriggers& rCtx, ActiveEntSet_t const& deleted)
+{
+    bit_andnot_assign(bit_words(rCtx.m_tracked), bit_words(deleted));
+}
+
+} // namespace osp::active
@@ -0,0 +1,69 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "region_trigger.h"
+
+namespace osp::active
+{
+
+class SysRegionTrigger
+{
+public:
+
+    /**
+     * @brief Start tracking an entity, its region state is found by the next update
+     *
+     * @param capacity  [in] ActiveEnt capacity, usually ACtxBasic::m_activeIds.capacity()
+     */
+    static void track(ACtxRegionTriggers& rCtx, ActiveEnt ent, std::size_t capacity);
+
+    /**
+     * @brief Retest entities that moved or were newly tracked, and write region crossings to
+     *        ACtxRegionTriggers::m_events
+     *
+     * Positions are the translation of each entity's ACompTransform, so this is meant for
+     * entities parented directly to the scene root.
+     *
+     * Does not clear m_transformDirty, which is owned by draw transform calculation. If nothing
+     * clears it, all tracked entities are retested every update.
+     */
+    static void update(
+            ACtxRegionTriggers&                 rCtx,
+            ACtxSceneGraph const&               scnGraph,
+            ACompTransformStorage_t const&      transforms);
+
+    /**
+     * @brief Stop tracking deleted entities without reporting events for them
+     *
+     * @param deleted   [in] Deleted entities, usually ACtxBasic::m_deleted
+     */
+    static void remove_deleted(ACtxRegionTriggers& rCtx, ActiveEntSet_t const& deleted);
+
+    [[nodiscard]] static std::uint32_t inside_mask(
+            ArrayView<TriggerRegion const> regions, Vector3 const& pos) noexcept;
+};
+
+} // namespace osp::active
@@ -0,0 +1,505 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "scene_save.h"
+
+#include "../core/byte_stream_tables.h"
+#include "../core/Resources.h"
+#include "../util/logging.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+using osp::restypes::gc_importer;
+
+namespace osp::active
+{
+
+namespace
+{
+
+constexpr std::uint32_t make_tag(char const a, char const b, char const c, char const d) noexcept
+{
+    return   std::uint32_t(std::uint8_t(a))        | (std::uint32_t(std::uint8_t(b)) << 8)
+          | (std::uint32_t(std::uint8_t(c)) << 16) | (std::uint32_t(std::uint8_t(d)) << 24);
+}
+
+constexpr std::uint32_t gc_sceneMagic   = make_tag('O', 'S', 'P', 'S');
+constexpr std::uint32_t gc_sceneVersion = 1;
+
+constexpr std::uint32_t gc_chunkBasic   = make_tag('B', 'A', 'S', 'C');
+constexpr std::uint32_t gc_chunkParts   = make_tag('P', 'R', 'T', 'S');
+constexpr std::uint32_t gc_chunkSigF    = make_tag('S', 'I', 'G', 'F');
+
+constexpr std::uint32_t gc_noPrefab     = ~std::uint32_t(0);
+
+/**
+ * @return Position of the chunk's data, to pass to end_chunk once it's written
+ */
+std::size_t begin_chunk(std::vector<std::byte>& rOut, std::uint32_t const tag)
+{
+    append_bytes(rOut, tag);
+    append_bytes(rOut, std::uint64_t(0));
+    return rOut.size();
+}
+
+void end_chunk(std::vector<std::byte>& rOut, std::size_t const dataPos)
+{
+    auto const size = static_cast<std::uint64_t>(rOut.size() - dataPos);
+    std::memcpy(rOut.data() + dataPos - sizeof(std::uint64_t), &size, sizeof(std::uint64_t));
+}
+
+struct PrefabEntry
+{
+    ResId       importer;
+    PrefabId    prefab;
+};
+
+void save_basic(std::vector<std::byte>& rOut, ACtxBasic const& basic)
+{
+    ACtxSceneGraph const &scnGraph = basic.m_scnGraph;
+
+    save_ids    (rOut, basic.m_activeIds);
+    save_array  (rOut, scnGraph.m_treeToEnt);
+    save_array  (rOut, scnGraph.m_treeDescendants);
+    save_array  (rOut, scnGraph.m_entParent);
+    save_array  (rOut, scnGraph.m_entToTreePos);
+
+    // Storage components are paged internally, so gather them into flat arrays first
+    std::vector<ActiveEnt>          tfEnts;
+    std::vector<ACompTransform>     tfValues;
+    tfEnts  .reserve(basic.m_transform.size());
+    tfValues.reserve(basic.m_transform.size());
+    for (auto const [ent, transform] : basic.m_transform.each())
+    {
+        tfEnts  .push_back(ent);
+        tfValues.push_back(transform);
+    }
+    save_array  (rOut, tfEnts);
+    save_array  (rOut, tfValues);
+}
+
+[[nodiscard]] bool load_basic(ByteReader& rReader, ACtxBasic& rBasic)
+{
+    ACtxSceneGraph &rScnGraph = rBasic.m_scnGraph;
+
+    std::uint32_t                   entCapacity;
+    std::vector<ActiveEnt>          tfEnts;
+    std::vector<ACompTransform>     tfValues;
+    if (   ! load_ids   (rReader, rBasic.m_activeIds, entCapacity)
+        || ! load_array (rReader, rScnGraph.m_treeToEnt)
+        || ! load_array (rReader, rScnGraph.m_treeDescendants)
+        || ! load_array (rReader, rScnGraph.m_entParent)
+        || ! load_array (rReader, rScnGraph.m_entToTreePos)
+        || ! load_array (rReader, tfEnts)
+        || ! load_array (rReader, tfValues)
+        || rScnGraph.m_treeToEnt.empty()
+        || rScnGraph.m_treeToEnt.size()   != rScnGraph.m_treeDescendants.size()
+        || rScnGraph.m_entParent.size()   != rScnGraph.m_entToTreePos.size()
+        || tfEnts.size()                  != tfValues.size() )
+    {
+        return false;
+    }
+
+    for (ActiveEnt const ent : tfEnts)
+    {
+        if ( ! rBasic.m_activeIds.exists(ent) )
+        {
+            return false;
+        }
+    }
+
+    // Also marks every transform as dirty, they're all new as far as draw transforms are concerned
+    rScnGraph.resize(std::max<std::size_t>(rScnGraph.m_entParent.size(), entCapacity));
+
+    rBasic.m_transform.reserve(tfEnts.size());
+    rBasic.m_transform.insert(tfEnts.begin(), tfEnts.end(), tfValues.begin());
+    return true;
+}
+
+void save_parts(std::vector<std::byte>& rOut, ACtxParts const& parts, Resources const& resources)
+{
+    // Parts and welds
+
+    save_ids        (rOut, parts.partIds);
+    SysSceneSave::save_prefabs(rOut, {parts.partPrefabs.data(), parts.partPrefabs.size()}, parts.partIds, resources);
+    save_array      (rOut, parts.partTransformWeld);
+
+    save_ids        (rOut, parts.weldIds);
+    save_multimap   (rOut, parts.weldToParts, parts.weldIds);
+    save_array      (rOut, parts.partToWeld);
+
+    // Machines
+
+    link::Machines const &machines = parts.machines;
+    save_ids        (rOut, machines.ids);
+    save_array      (rOut, machines.machTypes);
+    save_array      (rOut, machines.machToLocal);
+
+    append_bytes(rOut, static_cast<std::uint32_t>(machines.perType.size()));
+    for (link::PerMachType const& perType : machines.perType)
+    {
+        save_ids    (rOut, perType.localIds);
+        save_array  (rOut, perType.localToAny);
+    }
+
+    save_multimap   (rOut, parts.partToMachines, parts.partIds);
+    save_array      (rOut, parts.machineToPart);
+
+    // Nodes
+
+    append_bytes(rOut, static_cast<std::uint32_t>(parts.nodePerType.size()));
+    for (link::Nodes const& nodes : parts.nodePerType)
+    {
+        save_ids        (rOut, nodes.nodeIds);
+        save_multimap   (rOut, nodes.nodeToMach, nodes.nodeIds);
+        save_multimap   (rOut, nodes.machToNode, machines.ids);
+    }
+    append_bytes(rOut, parts.connectRevision);
+
+    // ActiveEnts
+
+    append_bytes(rOut, static_cast<std::uint32_t>(parts.partToActive.size()));
+    rOut.reserve(rOut.size() + parts.partToActive.size() * sizeof(ActiveEnt));
+    for (ActiveEnt const ent : parts.partToActive)
+    {
+        append_bytes(rOut, ent);
+    }
+    save_array      (rOut, parts.activeToPart);
+    save_array      (rOut, parts.weldToActive);
+}
+
+[[nodiscard]] bool load_parts(ByteReader& rReader, ACtxParts& rParts, Resources& rResources, PkgId const pkg)
+{
+    // Parts and welds
+
+    std::uint32_t partCapacity;
+    if ( ! load_ids(rReader, rParts.partIds, partCapacity) )
+    {
+        return false;
+    }
+
+    rParts.partPrefabs.resize(partCapacity);
+
+    std::uint32_t weldCapacity;
+    if (   ! SysSceneSave::load_prefabs(rReader, {rParts.partPrefabs.data(), rParts.partPrefabs.size()},
+                                        rParts.partIds, rResources, pkg)
+        || ! load_array     (rReader, rParts.partTransformWeld)
+        || ! load_ids       (rReader, rParts.weldIds, weldCapacity)
+        || ! load_multimap  (rReader, rParts.weldToParts, weldCapacity)
+        || ! load_array     (rReader, rParts.partToWeld)
+        || rParts.partTransformWeld.size()  < partCapacity
+        || rParts.partToWeld.size()         < partCapacity )
+    {
+        return false;
+    }
+
+    // Machines
+
+    link::Machines &rMachines = rParts.machines;
+
+    std::uint32_t machCapacity;
+    std::uint32_t machTypeCount;
+    if (   ! load_ids   (rReader, rMachines.ids, machCapacity)
+        || ! load_array (rReader, rMachines.machTypes)
+        || ! load_array (rReader, rMachines.machToLocal)
+        || ! rReader.read(machTypeCount)
+        || machTypeCount != link::MachTypeReg_t::size()
+        || rMachines.machTypes.size()   < machCapacity
+        || rMachines.machToLocal.size() < machCapacity )
+    {
+        return false;
+    }
+
+    rMachines.perType.resize(machTypeCount);
+    for (link::PerMachType &rPerType : rMachines.perType)
+    {
+        std::uint32_t localCapacity;
+        if (   ! load_ids   (rReader, rPerType.localIds, localCapacity)
+            || ! load_array (rReader, rPerType.localToAny)
+            || rPerType.localToAny.size() < localCapacity )
+        {
+            return false;
+        }
+    }
+
+    if (   ! load_multimap  (rReader, rParts.partToMachines, partCapacity)
+        || ! load_array     (rReader, rParts.machineToPart)
+        || rParts.machineToPart.size() < machCapacity )
+    {
+        return false;
+    }
+
+    // Nodes
+
+    std::uint32_t nodeTypeCount;
+    if ( ! rReader.read(nodeTypeCount) || nodeTypeCount != link::NodeTypeReg_t::size() )
+    {
+        return false;
+    }
+
+    rParts.nodePerType.resize(nodeTypeCount);
+    for (link::Nodes &rNodes : rParts.nodePerType)
+    {
+        std::uint32_t nodeCapacity;
+        if (   ! load_ids       (rReader, rNodes.nodeIds,    nodeCapacity)
+            || ! load_multimap  (rReader, rNodes.nodeToMach, nodeCapacity)
+            || ! load_multimap  (rReader, rNodes.machToNode, machCapacity) )
+        {
+            return false;
+        }
+    }
+
+    if ( ! rReader.read(rParts.connectRevision) )
+    {
+        return false;
+    }
+
+    // ActiveEnts
+
+    std::uint32_t partToActiveSize;
+    if (   ! rReader.read(partToActiveSize)
+        || std::size_t(partToActiveSize) * sizeof(ActiveEnt) > rReader.remaining().size() )
+    {
+        return false;
+    }
+    rParts.partToActive.resize(partToActiveSize);
+    for (PartId part = 0; part < partToActiveSize; ++part)
+    {
+        if ( ! rReader.read(rParts.partToActive[part]) )
+        {
+            return false;
+        }
+    }
+
+    return     load_array(rReader, rParts.activeToPart)
+            && load_array(rReader, rParts.weldToActive);
+}
+
+} // namespace
+
+std::vector<std::byte> SysSceneSave::save(
+        ACtxBasic const&                    basic,
+        ACtxParts const&                    parts,
+        link::SignalValues_t<float> const&  sigValFloat,
+        Resources const&                    resources)
+{
+    std::vector<std::byte> out;
+
+    append_bytes(out, gc_sceneMagic);
+    append_bytes(out, gc_sceneVersion);
+
+    std::size_t const basicPos = begin_chunk(out, gc_chunkBasic);
+    save_basic(out, basic);
+    end_chunk(out, basicPos);
+
+    std::size_t const partsPos = begin_chunk(out, gc_chunkParts);
+    save_parts(out, parts, resources);
+    end_chunk(out, partsPos);
+
+    std::size_t const sigFPos = begin_chunk(out, gc_chunkSigF);
+    save_array(out, sigValFloat);
+    end_chunk(out, sigFPos);
+
+    return out;
+}
+
+bool SysSceneSave::load(
+        ArrayView<std::byte const>          blob,
+        ACtxBasic&                          rBasic,
+        ACtxParts&                          rParts,
+        link::SignalValues_t<float>&        rSigValFloat,
+        Resources&                          rResources,
+        PkgId const                         pkg)
+{
+    ByteReader reader{blob};
+
+    std::uint32_t magic;
+    std::uint32_t version;
+    if (   ! reader.read(magic)   || magic   != gc_sceneMagic
+        || ! reader.read(version) || version != gc_sceneVersion )
+    {
+        return false;
+    }
+
+    bool loadedBasic = false;
+    bool loadedParts = false;
+    bool loadedSigF  = false;
+
+    while (reader.remaining().size() != 0)
+    {
+        std::uint32_t               tag;
+        std::uint64_t               size;
+        ArrayView<std::byte const>  data{nullptr, 0};
+        if (   ! reader.read(tag)
+            || ! reader.read(size)
+            || size > reader.remaining().size()
+            || ! reader.read_view(std::size_t(size), data) )
+        {
+            return false;
+        }
+
+        // Each chunk is read on its own, so a chunk can't read into the next one
+        ByteReader chunkReader{data};
+        switch (tag)
+        {
+        case gc_chunkBasic:
+            if (loadedBasic || ! load_basic(chunkReader, rBasic))
+            {
+                return false;
+            }
+            loadedBasic = true;
+            break;
+        case gc_chunkParts:
+            if (loadedParts || ! load_parts(chunkReader, rParts, rResources, pkg))
+            {
+                return false;
+            }
+            loadedParts = true;
+            break;
+        case gc_chunkSigF:
+            if (loadedSigF || ! load_array(chunkReader, rSigValFloat))
+            {
+                return false;
+            }
+            loadedSigF = true;
+            break;
+        default:
+            break; // Unknown chunk, written by something newer
+        }
+    }
+
+    return loadedBasic && loadedParts && loadedSigF;
+}
+
+void SysSceneSave::save_prefabs(
+        std::vector<std::byte>&             rOut,
+        ArrayView<PrefabPair const>         prefabs,
+        lgrn::IdRegistryStl<PartId> const&  partIds,
+        Resources const&                    resources)
+{
+    std::vector<PrefabEntry>    prefabTable;
+    std::vector<std::uint32_t>  partPrefab(prefabs.size(), gc_noPrefab);
+
+    for (PartId const part : partIds)
+    {
+        PrefabPair const& pair      = prefabs[part];
+        ResId const       importer  = pair.m_importer;
+        if (importer == lgrn::id_null<ResId>())
+        {
+            continue;
+        }
+
+        auto const itFound = std::find_if(prefabTable.begin(), prefabTable.end(),
+                                          [importer, &pair] (PrefabEntry const& entry)
+        {
+            return entry.importer == importer && entry.prefab == pair.m_prefabId;
+        });
+
+        partPrefab[part] = static_cast<std::uint32_t>(std::distance(prefabTable.begin(), itFound));
+        if (itFound == prefabTable.end())
+        {
+            prefabTable.push_back({importer, pair.m_prefabId});
+        }
+    }
+
+    append_bytes(rOut, static_cast<std::uint32_t>(prefabTable.size()));
+    for (PrefabEntry const& entry : prefabTable)
+    {
+        std::string_view const name = resources.name(gc_importer, entry.importer);
+        append_bytes(rOut, static_cast<std::uint32_t>(name.size()));
+        append_bytes(rOut, name.data(), name.size());
+        append_bytes(rOut, entry.prefab);
+    }
+    save_array(rOut, partPrefab);
+}
+
+bool SysSceneSave::load_prefabs(
+        ByteReader&                         rReader,
+        ArrayView<PrefabPair>               rPrefabs,
+        lgrn::IdRegistryStl<PartId> const&  partIds,
+        Resources&                          rResources,
+        PkgId const                         pkg)
+{
+    std::uint32_t prefabCount;
+    if ( ! rReader.read(prefabCount) || prefabCount > rReader.remaining().size() )
+    {
+        return false;
+    }
+
+    std::vector<PrefabEntry> prefabTable(prefabCount);
+    std::string name;
+    for (PrefabEntry &rEntry : prefabTable)
+    {
+        std::uint32_t nameSize;
+        if ( ! rReader.read(nameSize) || nameSize > rReader.remaining().size() )
+        {
+            return false;
+        }
+        name.resize(nameSize);
+        if ( (nameSize != 0 && ! rReader.read(name.data(), nameSize)) || ! rReader.read(rEntry.prefab) )
+        {
+            return false;
+        }
+
+        rEntry.importer = rResources.find(gc_importer, pkg, name);
+        if (rEntry.importer == lgrn::id_null<ResId>())
+        {
+            OSP_LOG_WARN("Importer {} of saved parts not found!", name);
+        }
+    }
+
+    std::vector<std::uint32_t> partPrefab;
+    if ( ! load_array(rReader, partPrefab) )
+    {
+        return false;
+    }
+    for (PartId const part : partIds)
+    {
+        if (   part >= partPrefab.size()
+            || part >= rPrefabs.size()
+            || (partPrefab[part] != gc_noPrefab && partPrefab[part] >= prefabCount) )
+        {
+            return false;
+        }
+    }
+
+    for (PartId const part : partIds)
+    {
+        if (partPrefab[part] == gc_noPrefab)
+        {
+            continue;
+        }
+
+        PrefabEntry const& entry = prefabTable[partPrefab[part]];
+        if (entry.importer != lgrn::id_null<ResId>())
+        {
+            rPrefabs[part] = PrefabPair{rResources.owner_create(gc_importer, entry.importer), entry.prefab};
+        }
+    }
+    return true;
+}
+
+} // namespace osp::active
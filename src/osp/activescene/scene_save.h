@@ -0,0 +1,113 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "basic.h"
+#include "vehicles.h"
+
+#include "../core/array_view.h"
+#include "../core/byte_stream.h"
+#include "../core/resourcetypes.h"
+#include "../link/signal.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace osp::active
+{
+
+/**
+ * @brief Saves and loads an active scene as a chunked binary blob, for quick-saves
+ *
+ * The blob is a header followed by chunks, each a tag and size followed by its data:
+ *
+ * * 'BASC': ACtxBasic; ActiveEnt IDs, the scene graph arrays and transforms
+ * * 'PRTS': ACtxParts; parts, welds, machines, nodes and the maps between them
+ * * 'SIGF': Float signal values, see osp::link::SignalValues_t
+ *
+ * Every table is written directly as a count followed by its raw elements, and ID registries
+ * keep their IDs and free IDs as they are. Nothing is built per entity; loading is a bulk read
+ * per table followed by restoring the ID registries. Chunks with unknown tags are skipped.
+ *
+ * Like vehicle blueprints and physics snapshots, blobs are written in native byte order and rely
+ * on machine and node type IDs assigned at startup, so they're only meant to be read by the same
+ * build. State that's rebuilt every frame (dirty lists, MachineUpdater, draw data) isn't saved.
+ */
+class SysSceneSave
+{
+public:
+    [[nodiscard]] static std::vector<std::byte> save(
+            ACtxBasic const&                    basic,
+            ACtxParts const&                    parts,
+            link::SignalValues_t<float> const&  sigValFloat,
+            Resources const&                    resources);
+
+    /**
+     * @brief Load a blob written by save into empty (default-constructed) contexts
+     *
+     * Importers of part prefabs are looked up by name in pkg, parts of importers that aren't
+     * found stay without a prefab.
+     *
+     * @return false if the blob is invalid, the contexts are then left partially loaded and
+     *         should be discarded
+     */
+    [[nodiscard]] static bool load(
+            ArrayView<std::byte const>          blob,
+            ACtxBasic&                          rBasic,
+            ACtxParts&                          rParts,
+            link::SignalValues_t<float>&        rSigValFloat,
+            Resources&                          rResources,
+            PkgId                               pkg);
+
+    /**
+     * @brief Save part prefabs as indices into a table of unique (importer, prefab) pairs
+     *
+     * Importers are saved by name, so loading looks each one up once instead of once per part.
+     *
+     * @param prefabs   [in] Prefab of each part, indexed by PartId
+     */
+    static void save_prefabs(
+            std::vector<std::byte>&             rOut,
+            ArrayView<PrefabPair const>         prefabs,
+            lgrn::IdRegistryStl<PartId> const&  partIds,
+            Resources const&                    resources);
+
+    /**
+     * @brief Load part prefabs written by save_prefabs
+     *
+     * Everything is read and checked before any importer owners are created, so failing can't
+     * leak them.
+     *
+     * @param rPrefabs  [out] Prefab of each part, indexed by PartId. Must fit partIds' capacity.
+     */
+    [[nodiscard]] static bool load_prefabs(
+            ByteReader&                         rReader,
+            ArrayView<PrefabPair>               rPrefabs,
+            lgrn::IdRegistryStl<PartId> const&  partIds,
+            Resources&                          rResources,
+            PkgId                               pkg);
+};
+
+} // namespace osp::active
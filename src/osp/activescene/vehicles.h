@@ -28,6 +28,7 @@
 
 #include "../core/array_view.h"
 #include "../core/keyed_vector.h"
+#include "../core/paged_keyed_vector.h"
 #include "../core/math_types.h"
 #include "../link/machines.h"
 #include "../vehicles/prefabs.h"
@@ -57,6 +58,7 @@ struct ACtxParts
 
     link::Machines                                  machines;
     KeyedVec<link::NodeTypeId, link::Nodes>         nodePerType;
+    std::uint32_t                                   connectRevision{0}; ///< Incremented whenever nodePerType connections change
 
     lgrn::IntArrayMultiMap<WeldId, PartId>          weldToParts;
     KeyedVec<PartId, WeldId>                        partToWeld;
@@ -64,7 +66,8 @@ struct ACtxParts
     MapPartToMachines_t                             partToMachines;
     KeyedVec<link::MachAnyId, PartId>               machineToPart;
 
-    KeyedVec<PartId, ActiveEnt>                     partToActive;
+    /// Paged so PartId growth doesn't move existing entries, see PagedKeyedVec
+    PagedKeyedVec<PartId, ActiveEnt>                partToActive;
     KeyedVec<ActiveEnt, PartId>                     activeToPart;
 
     KeyedVec<WeldId, ActiveEnt>                     weldToActive;
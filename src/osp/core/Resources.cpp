@@ -24,48 +24,96 @@
  */
 #include "Resources.h"
 
+#include <atomic>
+#include <utility>
+
 using namespace osp;
 
-ResId Resources::create(ResTypeId const typeId, PkgId const pkgId, SharedString name)
+void Resources::resize_types(std::size_t const n)
+{
+    m_pStore->m_perResType.resize(n);
+    m_perInstType.resize(n);
+    if (m_pStore->m_pLoaderView != nullptr)
+    {
+        m_pStore->m_pLoaderView->m_perInstType.resize(n);
+    }
+}
+
+Resources Resources::share() const
+{
+    Resources out{m_pStore};
+    out.m_perInstType.resize(m_pStore->m_perResType.size());
+    return out;
+}
+
+ResId Resources::create(ResTypeId const typeId, PkgId const pkgId, SharedString const& name)
 {
     // Create ResId associated to specified ResTypeId
     PerResType &rPerResType = get_type(typeId);
+    std::unique_lock const lock{*rPerResType.m_mutex};
+
     ResId const newResId = rPerResType.m_resIds.create();
 
     // Resize ref counts
     rPerResType.m_resRefs.resize(rPerResType.m_resIds.capacity());
 
     // Associate it with the package
-    assert(m_pkgData.size() > std::size_t(pkgId));
-    PerPkg &rPkg = m_pkgData[std::size_t(pkgId)];
+    assert(m_pStore->m_pkgData.size() > std::size_t(pkgId));
+    PerPkg &rPkg = m_pStore->m_pkgData[std::size_t(pkgId)];
     assert(rPkg.m_resTypeOwn.size() > std::size_t(typeId));
     PerPkgResType &rPkgType = rPkg.m_resTypeOwn[std::size_t(typeId)];
     rPkgType.m_owned.resize(rPerResType.m_resIds.capacity());
     rPkgType.m_owned.insert(newResId);
 
     // Track name
-    auto const& [newIt, success] = rPkgType.m_nameToResId.emplace(std::move(name), newResId);
-    auto const& [key, value]     = *newIt;
+    StrId               nameId;
+    std::string_view    nameView;
+    {
+        std::unique_lock const namesLock{*m_pStore->m_namesMutex};
+        nameId      = m_pStore->m_names.intern(name);
+        nameView    = m_pStore->m_names.view(nameId);
+    }
+
+    [[maybe_unused]] auto const& [newIt, success] = rPkgType.m_nameToResId.emplace(nameId, newResId);
     assert(success); // emplace should always succeed
 
     rPerResType.m_resNames.resize(rPerResType.m_resIds.capacity());
-    rPerResType.m_resNames[std::size_t(value)] = key;
+    rPerResType.m_resNames[std::size_t(newResId)] = SharedString::create_reference(nameView);
+    rPerResType.m_resNameIds.resize(rPerResType.m_resIds.capacity(), lgrn::id_null<StrId>());
+    rPerResType.m_resNameIds[std::size_t(newResId)] = nameId;
+
+    rPerResType.m_resLoaders.resize(rPerResType.m_resIds.capacity());
 
     return newResId;
 }
 
 ResId Resources::find(ResTypeId const typeId, PkgId const pkgId, std::string_view const name) const noexcept
+{
+    StrId nameId;
+    {
+        std::shared_lock const namesLock{*m_pStore->m_namesMutex};
+        nameId = m_pStore->m_names.find(name);
+    }
+
+    if (nameId == lgrn::id_null<StrId>())
+    {
+        return lgrn::id_null<ResId>(); // no resource of any type has this name
+    }
+
+    return find(typeId, pkgId, nameId);
+}
+
+ResId Resources::find(ResTypeId const typeId, PkgId const pkgId, StrId const name) const noexcept
 {
     PerResType const &rPerResType = get_type(typeId);
+    std::shared_lock const lock{*rPerResType.m_mutex};
 
-    assert(m_pkgData.size() > std::size_t(pkgId));
-    PerPkg const &rPkg = m_pkgData[std::size_t(pkgId)];
+    assert(m_pStore->m_pkgData.size() > std::size_t(pkgId));
+    PerPkg const &rPkg = m_pStore->m_pkgData[std::size_t(pkgId)];
     assert(rPkg.m_resTypeOwn.size() > std::size_t(typeId));
     PerPkgResType const &rPkgType = rPkg.m_resTypeOwn[std::size_t(typeId)];
 
-    // TODO: The call to SharedString::create_reference() shouldn't be necessary
-    // but transparent comparitors for std::unordered_map don't work very well.
-    if(auto const& findIt = rPkgType.m_nameToResId.find(SharedString::create_reference(name));
+    if(auto const& findIt = rPkgType.m_nameToResId.find(name);
        findIt != rPkgType.m_nameToResId.end())
     {
         return findIt->second;
@@ -73,9 +121,24 @@ ResId Resources::find(ResTypeId const typeId, PkgId const pkgId, std::string_vie
     return lgrn::id_null<ResId>(); // not found
 }
 
+StrId Resources::intern(std::string_view const str)
+{
+    std::unique_lock const namesLock{*m_pStore->m_namesMutex};
+    return m_pStore->m_names.intern(str);
+}
+
+StrId Resources::name_id(ResTypeId const typeId, ResId const resId) const noexcept
+{
+    PerResType const &rPerResType = get_type(typeId);
+    std::shared_lock const lock{*rPerResType.m_mutex};
+
+    return rPerResType.m_resNameIds[std::size_t(resId)];
+}
+
 SharedString const& Resources::name(ResTypeId const typeId, ResId const resId) const noexcept
 {
     PerResType const &rPerResType = get_type(typeId);
+    std::shared_lock const lock{*rPerResType.m_mutex};
 
     return rPerResType.m_resNames[std::size_t(resId)];
 }
@@ -85,10 +148,71 @@ lgrn::IdRegistryStl<ResId> const& Resources::ids(ResTypeId const typeId) const n
     return get_type(typeId).m_resIds;
 }
 
+int Resources::ref_add(PerResType &rPerResType, ResId const resId, int const delta) noexcept
+{
+    // Shared lock keeps create() from resizing the counts while they're modified
+    std::shared_lock const lock{*rPerResType.m_mutex};
+    return std::atomic_ref<int>{rPerResType.m_resRefs[std::size_t(resId)]}.fetch_add(delta) + delta;
+}
+
+int Resources::inst_ref_add(ResTypeId const typeId, ResId const resId, int const delta) noexcept
+{
+    assert(std::size_t(typeId) < m_perInstType.size());
+    PerInstResType &rPerInst = m_perInstType[std::size_t(typeId)];
+
+    {
+        std::shared_lock const lock{*rPerInst.m_mutex};
+        if (std::size_t(resId) < rPerInst.m_refs.size())
+        {
+            return std::atomic_ref<int>{rPerInst.m_refs[std::size_t(resId)]}.fetch_add(delta) + delta;
+        }
+    }
+
+    // Resource was created after this Resources last resized its counts, possibly by another
+    // Resources sharing the store
+    PerResType const &rPerResType = get_type(typeId);
+    std::size_t capacity;
+    {
+        std::shared_lock const typeLock{*rPerResType.m_mutex};
+        capacity = rPerResType.m_resIds.capacity();
+    }
+
+    std::unique_lock const lock{*rPerInst.m_mutex};
+    if (std::size_t(resId) >= rPerInst.m_refs.size())
+    {
+        rPerInst.m_refs.resize(capacity);
+    }
+    return rPerInst.m_refs[std::size_t(resId)] += delta;
+}
+
 ResIdOwner_t Resources::owner_create(ResTypeId const typeId, ResId const resId) noexcept
 {
     PerResType &rPerResType = get_type(typeId);
-    rPerResType.m_resRefs[std::size_t(resId)] ++;
+
+    LazyLoader *pLoader;
+    {
+        std::shared_lock lock{*rPerResType.m_mutex};
+        pLoader = rPerResType.m_resLoaders[std::size_t(resId)].get();
+    }
+
+    if (pLoader == nullptr)
+    {
+        if (inst_ref_add(typeId, resId, 1) == 1)
+        {
+            ref_add(rPerResType, resId, 1);
+        }
+    }
+    else
+    {
+        // Other threads adding owners wait here until the first one finishes loading. Loaders
+        // may add owners to other lazy resources of the same type, hence recursive.
+        std::lock_guard const lazyLock{*rPerResType.m_lazyMutex};
+        if (inst_ref_add(typeId, resId, 1) == 1 && ref_add(rPerResType, resId, 1) == 1)
+        {
+            pLoader->m_load(*m_pStore->m_pLoaderView, typeId, resId, pLoader->m_userData);
+        }
+    }
+
     ResIdOwner_t owner;
     owner.m_id = resId;
     return owner;
@@ -101,15 +225,75 @@ void Resources::owner_destroy(ResTypeId const typeId, ResIdOwner_t&& rOwner) noe
         return;
     }
     PerResType &rPerResType = get_type(typeId);
-    int &rCount = rPerResType.m_resRefs[std::size_t(rOwner.m_id)];
-    -- rCount;
+    ResId const resId = rOwner.m_id;
     rOwner.m_id = ResIdOwner_t{};
+
+    LazyLoader *pLoader;
+    {
+        std::shared_lock lock{*rPerResType.m_mutex};
+        pLoader = rPerResType.m_resLoaders[std::size_t(resId)].get();
+    }
+
+    if (pLoader == nullptr)
+    {
+        if (inst_ref_add(typeId, resId, -1) == 0)
+        {
+            ref_add(rPerResType, resId, -1);
+        }
+        return;
+    }
+
+    std::lock_guard const lazyLock{*rPerResType.m_lazyMutex};
+    if (inst_ref_add(typeId, resId, -1) != 0 || ref_add(rPerResType, resId, -1) != 0)
+    {
+        return;
+    }
+
+    if (pLoader->m_unload != nullptr)
+    {
+        pLoader->m_unload(*m_pStore->m_pLoaderView, typeId, resId, pLoader->m_userData);
+    }
+
+    std::unique_lock const lock{*rPerResType.m_mutex};
+    for (std::size_t i = 0; i < rPerResType.m_resData.size(); ++i)
+    {
+        rPerResType.m_resDataRemove[i](rPerResType.m_resData[i], resId);
+    }
+}
+
+void Resources::set_lazy(ResTypeId const typeId, ResId const resId, LazyLoader loader)
+{
+    PerResType &rPerResType = get_type(typeId);
+    std::unique_lock const lock{*rPerResType.m_mutex};
+
+    assert(rPerResType.m_resIds.exists(resId));
+    assert(rPerResType.m_resRefs[std::size_t(resId)] == 0);
+    assert(loader.m_load != nullptr);
+
+    rPerResType.m_resLoaders[std::size_t(resId)] = std::make_unique<LazyLoader>(std::move(loader));
+
+    if (m_pStore->m_pLoaderView == nullptr)
+    {
+        // Aliasing constructor with no owner, as the store owns the view
+        Resources view{std::shared_ptr<Store>{std::shared_ptr<Store>{}, m_pStore.get()}};
+        view.m_perInstType.resize(m_pStore->m_perResType.size());
+        m_pStore->m_pLoaderView = std::make_unique<Resources>(std::move(view));
+    }
+}
+
+bool Resources::is_loaded(ResTypeId const typeId, ResId const resId) const noexcept
+{
+    PerResType const &rPerResType = get_type(typeId);
+    std::shared_lock const lock{*rPerResType.m_mutex};
+
+    return rPerResType.m_resLoaders[std::size_t(resId)] == nullptr
+        || std::atomic_ref<int>{const_cast<int&>(rPerResType.m_resRefs[std::size_t(resId)])}.load() > 0;
 }
 
 PkgId Resources::pkg_create()
 {
-    PkgId const newPkgId = m_pkgIds.create();
-    m_pkgData.resize(m_pkgIds.capacity());
-    m_pkgData[std::size_t(newPkgId)].m_resTypeOwn.resize(m_perResType.size());
+    PkgId const newPkgId = m_pStore->m_pkgIds.create();
+    m_pStore->m_pkgData.resize(m_pStore->m_pkgIds.capacity());
+    m_pStore->m_pkgData[std::size_t(newPkgId)].m_resTypeOwn.resize(m_pStore->m_perResType.size());
     return newPkgId;
 }
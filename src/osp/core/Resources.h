@@ -26,6 +26,7 @@
 
 #include "copymove_macros.h"
 #include "shared_string.h"
+#include "string_pool.h"
 #include "resourcetypes.h"
 
 #include <longeron/id_management/id_set_stl.hpp>
@@ -36,6 +37,10 @@
 #include <entt/core/any.hpp>
 
 #include <algorithm>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <string_view>
 #include <unordered_map>
 #include <vector>
@@ -43,26 +48,80 @@
 namespace osp
 {
 
+/**
+ * @brief Stores resources of different types, organized into packages
+ *
+ * Resource IDs, names, packages, and data live in a store that can be shared by several
+ * Resources, see share(). Each Resources only adds its own owner reference counts on top, so
+ * independent simulations in the same process can use one set of imported meshes, textures, and
+ * prefabs. A resource counts as owned by the store while any Resources sharing it has owners,
+ * and lazy resources are loaded and freed following that.
+ *
+ * Thread safety, locked per resource type:
+ * * Safe to call from any thread, including task executor workers: create, find, name,
+ *   owner_create, owner_destroy, is_loaded, data_add, data_get, and data_try_get.
+ * * Setup only, while no other thread uses any Resources of the same store: resize_types,
+ *   data_register, pkg_create, set_lazy, share, and iterating ids.
+ *
+ * References returned by data_get stay valid until the data is freed, but concurrent writes
+ * to the same data must be synchronized by the caller.
+ */
 class Resources
 {
     using res_data_family_t = entt::family<struct ResourceType>;
     using res_data_type_t = res_data_family_t::value_type;
+    using res_data_remove_t = void(*)(entt::any &rContainer, ResId resId);
+
+public:
+
+    /**
+     * @brief Adds and frees the data of a lazy resource, see set_lazy
+     */
+    struct LazyLoader
+    {
+        using Func_t = void(*)(Resources &rResources, ResTypeId typeId, ResId resId, entt::any &rUserData);
+
+        /// Adds data to the resource through data_add, such as by reading it from disk
+        Func_t      m_load      {nullptr};
+
+        /// Optional; release anything the data owns, such as a ResIdOwner_t, before it's freed
+        Func_t      m_unload    {nullptr};
+
+        entt::any   m_userData;
+    };
+
+private:
 
     struct PerResType
     {
         lgrn::IdRegistryStl<ResId>      m_resIds;
+
+        // Number of Resources sharing the store that own each resource
         lgrn::RefCount<int>             m_resRefs;
         std::vector<res_data_type_t>    m_resDataTypes;
         std::vector<entt::any>          m_resData;
+        std::vector<res_data_remove_t>  m_resDataRemove;
+
+        // Views into m_names. A deque, so references returned by name() stay valid while
+        // other threads create more resources
+        std::deque<SharedString>        m_resNames;
+        std::vector<StrId>              m_resNameIds;
+
+        // Null for resources that aren't lazy
+        std::vector< std::unique_ptr<LazyLoader> > m_resLoaders;
+
+        // Shared for reads and for changing refcounts, unique for changing anything else.
+        // Pointers so PerResType stays movable
+        std::unique_ptr<std::shared_mutex>      m_mutex     {std::make_unique<std::shared_mutex>()};
 
-        // Pointed to by PerPkgResType::m_nameToResId
-        std::vector<SharedString>       m_resNames;
+        // Held while loading or unloading lazy resources
+        std::unique_ptr<std::recursive_mutex>   m_lazyMutex {std::make_unique<std::recursive_mutex>()};
     };
 
     struct PerPkgResType
     {
         lgrn::IdSetStl<ResId> m_owned;
-        std::unordered_map< SharedString, ResId, std::hash<SharedString>, std::equal_to<> > m_nameToResId;
+        std::unordered_map<StrId, ResId> m_nameToResId;
     };
 
     struct PerPkg
@@ -70,50 +129,131 @@ class Resources
         std::vector<PerPkgResType> m_resTypeOwn;
     };
 
+    /// Everything except owner reference counts, shared by Resources made with share()
+    struct Store
+    {
+        std::vector<PerResType>     m_perResType;
+        lgrn::IdRegistryStl<PkgId>  m_pkgIds;
+        std::vector<PerPkg>         m_pkgData;
+
+        // Names of all resources of all types. Locked after any PerResType::m_mutex
+        StringPool                          m_names;
+        std::unique_ptr<std::shared_mutex>  m_namesMutex{std::make_unique<std::shared_mutex>()};
+
+        // Passed to LazyLoaders, so owners they create or destroy are counted by the store
+        // rather than whichever Resources happened to load or unload. Doesn't own the store.
+        std::unique_ptr<Resources>          m_pLoaderView;
+    };
+
+    /// Owner reference counts of a single Resources
+    struct PerInstResType
+    {
+        lgrn::RefCount<int>                 m_refs;
+
+        // Shared for changing counts, unique for resizing
+        std::unique_ptr<std::shared_mutex>  m_mutex{std::make_unique<std::shared_mutex>()};
+    };
+
+    explicit Resources(std::shared_ptr<Store> pStore) : m_pStore{std::move(pStore)} { }
+
 public:
 
-    Resources() = default;
+    Resources() : m_pStore{std::make_shared<Store>()} { }
     OSP_MOVE_ONLY_CTOR_ASSIGN(Resources);
 
     /**
      * @brief Resize to fit a certain number of resource types
      *
+     * Only affects Resources created with share() afterwards.
+     *
      * @param n [in] Number of types to support
      */
-    inline void resize_types(std::size_t n)
-    {
-        m_perResType.resize(n);
-    }
+    void resize_types(std::size_t n);
+
+    /**
+     * @brief Create a Resources that shares all resources and data, but not reference counts
+     *
+     * Meant for running multiple independent simulations in one process. Each gets its own
+     * Resources, so the only per-instance memory is the owner counts, and each can check that
+     * it released everything it owns.
+     */
+    [[nodiscard]] Resources share() const;
 
     /**
      * @brief Create a new resource Id
      *
      * @param typeId    [in] Resource Type Id
      * @param pkgId     [in] Package Id
-     * @param name      [in] String name identifier
+     * @param name      [in] String name identifier, copied into the name pool
      *
      * @return Newly created Resource Id
      */
-    [[nodiscard]] ResId create(ResTypeId typeId, PkgId pkgId, SharedString name);
+    [[nodiscard]] ResId create(ResTypeId typeId, PkgId pkgId, SharedString const& name);
 
     [[nodiscard]] ResId find(ResTypeId typeId, PkgId pkgId, std::string_view name) const noexcept;
 
+    /**
+     * @brief Find a resource by an interned name, without hashing the string again
+     */
+    [[nodiscard]] ResId find(ResTypeId typeId, PkgId pkgId, StrId name) const noexcept;
+
+    /**
+     * @brief Intern a string into the pool that resource names are stored in
+     *
+     * Lets a name that is looked up repeatedly be hashed only once.
+     */
+    [[nodiscard]] StrId intern(std::string_view str);
+
+    /**
+     * @return Interned name of a resource; resources with equal names have equal handles
+     */
+    [[nodiscard]] StrId name_id(ResTypeId typeId, ResId resId) const noexcept;
+
     /**
      * @brief Get name of Resource Id
      *
      * @param typeId    [in] Resource Type Id
      * @param resId     [in] Resource Id
      *
-     * @return Name of resources assigned in create(), unique to a single Package
+     * @return Name of resources assigned in create(), unique to a single Package. Points into
+     *         a pool owned by Resources and must not outlive it.
      */
     [[nodiscard]] SharedString const& name(ResTypeId typeId, ResId resId) const noexcept;
 
     [[nodiscard]] lgrn::IdRegistryStl<ResId> const& ids(ResTypeId typeId) const noexcept;
 
+    /**
+     * @brief Create an owner, adding to the resource's reference count
+     *
+     * Data of a lazy resource is loaded when its first owner is created.
+     */
     [[nodiscard]] ResIdOwner_t owner_create(ResTypeId typeId, ResId resId) noexcept;
 
+    /**
+     * @brief Destroy an owner, removing from the resource's reference count
+     *
+     * All data of a lazy resource is freed when its last owner is destroyed.
+     */
     void owner_destroy(ResTypeId typeId, ResIdOwner_t&& rOwner) noexcept;
 
+    /**
+     * @brief Make a resource lazy, only holding data while it has owners
+     *
+     * This lets a package manifest register names and metadata of everything installed, without
+     * reading any of it until a scene uses it. Data must only be accessed through an owner,
+     * and it isn't kept once the last owner is destroyed.
+     *
+     * @param typeId    [in] Resource Type Id
+     * @param resId     [in] Resource Id, must not have owners or data yet
+     * @param loader    [in] Functions to load and unload data
+     */
+    void set_lazy(ResTypeId typeId, ResId resId, LazyLoader loader);
+
+    /**
+     * @return True if the resource isn't lazy, or if it is and its data is loaded
+     */
+    [[nodiscard]] bool is_loaded(ResTypeId typeId, ResId resId) const noexcept;
+
     /**
      * @brief Register a datatype to a resource Id
      *
@@ -190,25 +330,30 @@ private:
 
     PerResType const& get_type(ResTypeId typeId) const
     {
-        assert(std::size_t(typeId) < m_perResType.size());
-        return m_perResType[std::size_t(typeId)];
+        assert(std::size_t(typeId) < m_pStore->m_perResType.size());
+        return m_pStore->m_perResType[std::size_t(typeId)];
     }
 
     PerResType& get_type(ResTypeId typeId)
     {
-        assert(std::size_t(typeId) < m_perResType.size());
-        return m_perResType[std::size_t(typeId)];
+        assert(std::size_t(typeId) < m_pStore->m_perResType.size());
+        return m_pStore->m_perResType[std::size_t(typeId)];
     }
 
     template <typename T>
     res_container_t<T>& get_container(PerResType &rPerResType, ResTypeId typeId);
 
+    /// @return Reference count of the store after adding delta
+    static int ref_add(PerResType &rPerResType, ResId resId, int delta) noexcept;
+
+    /// @return Reference count of this Resources after adding delta
+    int inst_ref_add(ResTypeId typeId, ResId resId, int delta) noexcept;
+
     template <typename T>
     res_container_t<T> const& get_container(PerResType const &rPerResType, ResTypeId typeId) const;
 
-    std::vector<PerResType>     m_perResType;
-    lgrn::IdRegistryStl<PkgId>  m_pkgIds;
-    std::vector<PerPkg>         m_pkgData;
+    std::shared_ptr<Store>          m_pStore;
+    std::vector<PerInstResType>     m_perInstType;
 };
 
 template<typename T>
@@ -224,12 +369,21 @@ void Resources::data_register(ResTypeId typeId)
 
     rTypes.push_back(type);
     rPerResType.m_resData.emplace_back(res_container_t<T>{});
+    rPerResType.m_resDataRemove.push_back([] (entt::any &rContainer, ResId const resId)
+    {
+        auto &rTypedContainer = entt::any_cast<res_container_t<T>&>(rContainer);
+        if (rTypedContainer.get(resId) != nullptr)
+        {
+            rTypedContainer.remove(resId);
+        }
+    });
 }
 
 template<typename T, typename ... ARGS_T>
 T& Resources::data_add(ResTypeId typeId, ResId resId, ARGS_T&& ... args)
 {
     PerResType &rPerResType = get_type(typeId);
+    std::unique_lock const lock{*rPerResType.m_mutex};
 
     // Ensure resource ID exists
     assert(rPerResType.m_resIds.capacity() > std::size_t(resId));
@@ -265,6 +419,7 @@ T const* Resources::data_try_get(ResTypeId typeId, ResId resId) const
     using NonConst_t = std::remove_const_t<T>;
 
     PerResType const &rPerResType = get_type(typeId);
+    std::shared_lock const lock{*rPerResType.m_mutex};
 
     // Ensure resource ID exists
     assert(rPerResType.m_resIds.capacity() > std::size_t(typeId));
@@ -279,6 +434,7 @@ template<typename T>
 T* Resources::data_try_get(ResTypeId typeId, ResId resId)
 {
     PerResType &rPerResType = get_type(typeId);
+    std::shared_lock const lock{*rPerResType.m_mutex};
 
     // Ensure resource ID exists
     assert(rPerResType.m_resIds.capacity() > std::size_t(resId));
@@ -0,0 +1,82 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <new>
+
+namespace osp
+{
+
+/**
+ * @brief Alignment for data processed in bulk, enough for any SIMD register and a cache line
+ */
+constexpr std::size_t gc_simdAlignment = 64;
+
+/**
+ * @brief Standard allocator that aligns every allocation to ALIGN_T bytes
+ *
+ * Only the start of the array is aligned, so aligned loads work on the first element then
+ * every ALIGN_T / sizeof(T) elements.
+ */
+template <typename T, std::size_t ALIGN_T>
+struct AlignedAllocator
+{
+    static_assert(ALIGN_T >= alignof(T) && (ALIGN_T & (ALIGN_T - 1)) == 0,
+                  "Alignment must be a power of two no smaller than alignof(T)");
+
+    using value_type = T;
+
+    template <typename U>
+    struct rebind
+    {
+        using other = AlignedAllocator<U, ALIGN_T>;
+    };
+
+    constexpr AlignedAllocator() noexcept = default;
+
+    template <typename U>
+    constexpr AlignedAllocator(AlignedAllocator<U, ALIGN_T> const&) noexcept { }
+
+    [[nodiscard]] T* allocate(std::size_t const count)
+    {
+        if (count > std::numeric_limits<std::size_t>::max() / sizeof(T))
+        {
+            throw std::bad_array_new_length();
+        }
+        return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t{ALIGN_T}));
+    }
+
+    void deallocate(T* const pData, [[maybe_unused]] std::size_t const count) noexcept
+    {
+        ::operator delete(pData, std::align_val_t{ALIGN_T});
+    }
+
+    template <typename U>
+    constexpr bool operator==(AlignedAllocator<U, ALIGN_T> const&) const noexcept { return true; }
+};
+
+} // namespace osp
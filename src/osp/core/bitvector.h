@@ -24,9 +24,17 @@
  */
 #pragma once
 
+#include "array_view.h"
+
 #include <longeron/containers/bit_view.hpp>
+#include <longeron/utility/asserts.hpp>
 
+#include <algorithm>
+#include <bit>
+#include <cstddef>
 #include <cstdint>
+#include <iterator>
+#include <type_traits>
 #include <vector>
 
 namespace osp
@@ -40,6 +48,226 @@ inline void bitvector_resize(BitVector_t &rBitVector, std::size_t size)
     rBitVector.ints().resize(size / 64 + (size % 64 != 0), 0);
 }
 
+//-----------------------------------------------------------------------------
+
+// Word-parallel set operations. These work on the 64-bit words of a BitVector_t or
+// lgrn::IdSetStl (see bit_words), so filtering passes cost per 64 IDs instead of per ID. Loops
+// are branchless over whole words so they auto-vectorize; see OSP_ENABLE_AVX2.
+
+/**
+ * @return View of the 64-bit words of a BitVector_t or lgrn::IdSetStl
+ */
+template <typename SET_T>
+[[nodiscard]] constexpr auto bit_words(SET_T& rSet) noexcept
+{
+    auto &rInts = [&rSet] () -> auto&
+    {
+        if constexpr (requires { rSet.bitview().ints(); })
+        {
+            return rSet.bitview().ints();
+        }
+        else
+        {
+            return rSet.ints();
+        }
+    }();
+
+    using word_t = std::remove_reference_t<decltype(*rInts.data())>;
+    static_assert(std::is_same_v<std::remove_const_t<word_t>, bitint_t>);
+    return ArrayView<word_t>{rInts.data(), rInts.size()};
+}
+
+/**
+ * @brief rA &= b. Words of rA past the end of b are cleared
+ */
+inline void bit_and_assign(ArrayView<bitint_t> const rA, ArrayView<bitint_t const> const b) noexcept
+{
+    std::size_t const common = std::min(rA.size(), b.size());
+    for (std::size_t i = 0; i < common; ++i)
+    {
+        rA[i] &= b[i];
+    }
+    std::fill(rA.begin() + common, rA.end(), 0);
+}
+
+/**
+ * @brief rA |= b. b must not have any bits set past the end of rA
+ */
+inline void bit_or_assign(ArrayView<bitint_t> const rA, ArrayView<bitint_t const> const b) noexcept
+{
+    std::size_t const common = std::min(rA.size(), b.size());
+    LGRN_ASSERTM(std::all_of(b.begin() + common, b.end(), [] (bitint_t const word) { return word == 0; }),
+                 "Union doesn't fit");
+    for (std::size_t i = 0; i < common; ++i)
+    {
+        rA[i] |= b[i];
+    }
+}
+
+/**
+ * @brief rA &= ~b, set difference
+ */
+inline void bit_andnot_assign(ArrayView<bitint_t> const rA, ArrayView<bitint_t const> const b) noexcept
+{
+    std::size_t const common = std::min(rA.size(), b.size());
+    for (std::size_t i = 0; i < common; ++i)
+    {
+        rA[i] &= ~b[i];
+    }
+}
+
+/**
+ * @return Number of bits set
+ */
+[[nodiscard]] inline std::size_t bit_count(ArrayView<bitint_t const> const a) noexcept
+{
+    std::size_t count = 0;
+    for (bitint_t const word : a)
+    {
+        count += std::size_t(std::popcount(word));
+    }
+    return count;
+}
+
+/**
+ * @return Number of bits set in both a and b, without writing the intersection anywhere
+ */
+[[nodiscard]] inline std::size_t bit_count_and(ArrayView<bitint_t const> const a, ArrayView<bitint_t const> const b) noexcept
+{
+    std::size_t const common = std::min(a.size(), b.size());
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < common; ++i)
+    {
+        count += std::size_t(std::popcount(a[i] & b[i]));
+    }
+    return count;
+}
+
+/**
+ * @brief Iterable range of the positions of bits set in OP_T{}(a[i], b[i]), as ID_T
+ *
+ * Each word is combined only once; positions are found with countr_zero, so empty words are
+ * skipped in a single compare. Don't modify a or b while iterating.
+ */
+template <typename ID_T, typename OP_T>
+class BitOnesOf2
+{
+public:
+    BitOnesOf2(ArrayView<bitint_t const> const a, ArrayView<bitint_t const> const b) noexcept
+     : m_a{a}
+     , m_b{b}
+     , m_size{OP_T::smc_fullA ? a.size() : std::min(a.size(), b.size())}
+    { }
+
+    class Iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using difference_type   = std::ptrdiff_t;
+        using value_type        = ID_T;
+
+        Iterator() = default;
+        Iterator(BitOnesOf2 const* pRange, std::size_t const wordIdx) noexcept
+         : m_pRange{pRange}
+         , m_wordIdx{wordIdx}
+        {
+            skip_empty();
+        }
+
+        [[nodiscard]] ID_T operator*() const noexcept
+        {
+            return ID_T(m_wordIdx * 64 + std::size_t(std::countr_zero(m_word)));
+        }
+
+        Iterator& operator++() noexcept
+        {
+            m_word &= m_word - 1; // clear lowest set bit
+            if (m_word == 0)
+            {
+                ++m_wordIdx;
+                skip_empty();
+            }
+            return *this;
+        }
+
+        Iterator operator++(int) noexcept
+        {
+            Iterator copy{*this};
+            ++(*this);
+            return copy;
+        }
+
+        [[nodiscard]] bool operator==(Iterator const& rhs) const noexcept
+        {
+            return m_wordIdx == rhs.m_wordIdx && m_word == rhs.m_word;
+        }
+
+    private:
+
+        void skip_empty() noexcept
+        {
+            while (m_wordIdx < m_pRange->m_size
+                   && (m_word = m_pRange->word(m_wordIdx)) == 0)
+            {
+                ++m_wordIdx;
+            }
+            if (m_wordIdx >= m_pRange->m_size)
+            {
+                m_wordIdx = m_pRange->m_size;
+                m_word    = 0;
+            }
+        }
+
+        BitOnesOf2 const    *m_pRange   {nullptr};
+        std::size_t         m_wordIdx   {0};
+        bitint_t            m_word      {0};
+    };
+
+    [[nodiscard]] Iterator begin() const noexcept { return {this, 0}; }
+    [[nodiscard]] Iterator end()   const noexcept { return {this, m_size}; }
+
+private:
+
+    [[nodiscard]] bitint_t word(std::size_t const i) const noexcept
+    {
+        return OP_T{}(m_a[i], (i < m_b.size()) ? m_b[i] : 0);
+    }
+
+    ArrayView<bitint_t const>   m_a;
+    ArrayView<bitint_t const>   m_b;
+    std::size_t                 m_size;
+};
+
+struct BitOpAnd
+{
+    static constexpr bool smc_fullA = false;
+    constexpr bitint_t operator()(bitint_t const a, bitint_t const b) const noexcept { return a & b; }
+};
+
+struct BitOpAndNot
+{
+    static constexpr bool smc_fullA = true;
+    constexpr bitint_t operator()(bitint_t const a, bitint_t const b) const noexcept { return a & ~b; }
+};
+
+/**
+ * @brief Iterate IDs set in both a and b, ie: for (DrawEnt ent : bit_ones_and<DrawEnt>(...))
+ */
+template <typename ID_T = std::size_t>
+[[nodiscard]] BitOnesOf2<ID_T, BitOpAnd> bit_ones_and(ArrayView<bitint_t const> const a, ArrayView<bitint_t const> const b) noexcept
+{
+    return {a, b};
+}
+
+/**
+ * @brief Iterate IDs set in a but not in b
+ */
+template <typename ID_T = std::size_t>
+[[nodiscard]] BitOnesOf2<ID_T, BitOpAndNot> bit_ones_andnot(ArrayView<bitint_t const> const a, ArrayView<bitint_t const> const b) noexcept
+{
+    return {a, b};
+}
+
 } // namespace osp
 
 
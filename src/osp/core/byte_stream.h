@@ -0,0 +1,110 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "array_view.h"
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace osp
+{
+
+/**
+ * @brief Append the bytes of a trivially copyable value, to be read back with ByteReader
+ *
+ * Values are written in native byte order, blobs are only meant to be read by the same build.
+ */
+template <typename T>
+void append_bytes(std::vector<std::byte>& rOut, T const& value)
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+    auto const *pBytes = reinterpret_cast<std::byte const*>(std::addressof(value));
+    rOut.insert(rOut.end(), pBytes, pBytes + sizeof(T));
+}
+
+inline void append_bytes(std::vector<std::byte>& rOut, void const* pData, std::size_t const size)
+{
+    auto const *pBytes = static_cast<std::byte const*>(pData);
+    rOut.insert(rOut.end(), pBytes, pBytes + size);
+}
+
+/**
+ * @brief Reads values written by append_bytes, in the same order
+ *
+ * Reads past the end fail and leave the output untouched.
+ */
+class ByteReader
+{
+public:
+    explicit ByteReader(ArrayView<std::byte const> data) noexcept : m_data{data} { }
+
+    template <typename T>
+    [[nodiscard]] bool read(T& rOut) noexcept
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        return read(std::addressof(rOut), sizeof(T));
+    }
+
+    [[nodiscard]] bool read(void* pOut, std::size_t const size) noexcept
+    {
+        if (size > m_data.size() - m_pos)
+        {
+            return false;
+        }
+        std::memcpy(pOut, m_data.data() + m_pos, size);
+        m_pos += size;
+        return true;
+    }
+
+    /**
+     * @brief Get a view of the next bytes without copying them, and move past them
+     */
+    [[nodiscard]] bool read_view(std::size_t const size, ArrayView<std::byte const>& rOut) noexcept
+    {
+        if (size > m_data.size() - m_pos)
+        {
+            return false;
+        }
+        rOut = {m_data.data() + m_pos, size};
+        m_pos += size;
+        return true;
+    }
+
+    /// @return Bytes not read yet
+    [[nodiscard]] ArrayView<std::byte const> remaining() const noexcept
+    {
+        return {m_data.data() + m_pos, m_data.size() - m_pos};
+    }
+
+private:
+    ArrayView<std::byte const>  m_data;
+    std::size_t                 m_pos{0};
+};
+
+} // namespace osp
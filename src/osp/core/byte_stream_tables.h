@@ -0,0 +1,214 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "byte_stream.h"
+
+#include <longeron/containers/intarray_multimap.hpp>
+#include <longeron/id_management/registry_stl.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @file
+ *
+ * Save and load the flat tables used all over the engine (vectors, ID registries and
+ * IntArrayMultiMaps) with append_bytes and ByteReader. Every table is a count followed by its raw
+ * elements, with IDs kept as they are, so loading is a linear pass of memcpys with no remapping.
+ */
+
+namespace osp
+{
+
+template <typename VEC_T>
+void save_array(std::vector<std::byte>& rOut, VEC_T const& vec)
+{
+    static_assert(std::is_trivially_copyable_v<typename VEC_T::value_type>);
+    append_bytes(rOut, static_cast<std::uint32_t>(vec.size()));
+    append_bytes(rOut, vec.data(), vec.size() * sizeof(typename VEC_T::value_type));
+}
+
+template <typename VEC_T>
+[[nodiscard]] bool load_array(ByteReader& rReader, VEC_T& rOut)
+{
+    using Value_t = typename VEC_T::value_type;
+    static_assert(std::is_trivially_copyable_v<Value_t>);
+    std::uint32_t count;
+    if ( ! rReader.read(count) || std::size_t(count) * sizeof(Value_t) > rReader.remaining().size() )
+    {
+        return false;
+    }
+    rOut.resize(count);
+    return (count == 0) || rReader.read(rOut.data(), count * sizeof(Value_t));
+}
+
+/**
+ * @brief Save the capacity and existing IDs of a registry
+ *
+ * IDs are saved as they are, so every other table can keep using them as indices.
+ */
+template <typename ID_T>
+void save_ids(std::vector<std::byte>& rOut, lgrn::IdRegistryStl<ID_T> const& ids)
+{
+    append_bytes(rOut, static_cast<std::uint32_t>(ids.capacity()));
+    append_bytes(rOut, static_cast<std::uint32_t>(ids.size()));
+
+    std::size_t pos = rOut.size();
+    rOut.resize(pos + ids.size() * sizeof(ID_T));
+    for (ID_T const id : ids)
+    {
+        std::memcpy(rOut.data() + pos, std::addressof(id), sizeof(ID_T));
+        pos += sizeof(ID_T);
+    }
+}
+
+/**
+ * @brief Restore a registry saved with save_ids into an empty registry
+ *
+ * IDs that were free when saved are free again, so new IDs are handed out the same way they
+ * would have been before saving.
+ */
+template <typename ID_T>
+[[nodiscard]] bool load_ids(ByteReader& rReader, lgrn::IdRegistryStl<ID_T>& rOut, std::uint32_t& rCapacityOut)
+{
+    std::vector<ID_T> existing;
+    if (   ! rReader.read(rCapacityOut)
+        || rCapacityOut > rReader.remaining().size()
+        || ! load_array(rReader, existing) )
+    {
+        return false;
+    }
+
+    // Create every ID up to the capacity, then remove the ones that didn't exist when saved.
+    // A new registry hands out the lowest IDs first, so this results in the same IDs.
+    std::vector<ID_T> all(rCapacityOut);
+    rOut.create(all.begin(), all.end());
+
+    std::vector<bool> keep(rCapacityOut, false);
+    for (ID_T const id : existing)
+    {
+        if (std::size_t(id) >= rCapacityOut)
+        {
+            return false;
+        }
+        keep[std::size_t(id)] = true;
+    }
+
+    for (std::uint32_t i = 0; i < rCapacityOut; ++i)
+    {
+        if ( ! keep[i] )
+        {
+            rOut.remove(ID_T(i));
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Save the partitions of a multimap, for each ID in ids that has one
+ */
+template <typename ID_T, typename DATA_T, typename IDS_T>
+void save_multimap(std::vector<std::byte>& rOut, lgrn::IntArrayMultiMap<ID_T, DATA_T> const& map, IDS_T const& ids)
+{
+    static_assert(std::is_trivially_copyable_v<DATA_T>);
+
+    std::uint32_t partitions = 0;
+    std::uint32_t dataTotal  = 0;
+    for (ID_T const id : ids)
+    {
+        if (map.contains(id))
+        {
+            ++partitions;
+            dataTotal += static_cast<std::uint32_t>(map[id].size());
+        }
+    }
+
+    rOut.reserve(rOut.size() + 2 * sizeof(std::uint32_t)
+                             + partitions * (sizeof(ID_T) + sizeof(std::uint32_t))
+                             + dataTotal * sizeof(DATA_T));
+    append_bytes(rOut, partitions);
+    append_bytes(rOut, dataTotal);
+    for (ID_T const id : ids)
+    {
+        if (map.contains(id))
+        {
+            auto const span = map[id];
+            append_bytes(rOut, id);
+            append_bytes(rOut, static_cast<std::uint32_t>(span.size()));
+            if (span.size() != 0)
+            {
+                append_bytes(rOut, std::addressof(span[0]), span.size() * sizeof(DATA_T));
+            }
+        }
+    }
+}
+
+/**
+ * @brief Load a multimap saved with save_multimap into an empty multimap
+ */
+template <typename ID_T, typename DATA_T>
+[[nodiscard]] bool load_multimap(ByteReader& rReader, lgrn::IntArrayMultiMap<ID_T, DATA_T>& rOut, std::size_t const idCapacity)
+{
+    std::uint32_t partitions;
+    std::uint32_t dataTotal;
+    if (   ! rReader.read(partitions)
+        || ! rReader.read(dataTotal)
+        || std::size_t(dataTotal) * sizeof(DATA_T) > rReader.remaining().size() )
+    {
+        return false;
+    }
+
+    rOut.ids_reserve(idCapacity);
+    rOut.data_reserve(dataTotal);
+
+    std::size_t dataLeft = dataTotal;
+    for (std::uint32_t i = 0; i < partitions; ++i)
+    {
+        ID_T            id;
+        std::uint32_t   size;
+        if (   ! rReader.read(id)
+            || ! rReader.read(size)
+            || std::size_t(id) >= idCapacity
+            || size > dataLeft
+            || rOut.contains(id) )
+        {
+            return false;
+        }
+        dataLeft -= size;
+
+        DATA_T *pData = rOut.emplace(id, size);
+        if ( size != 0 && ! rReader.read(pData, size * sizeof(DATA_T)) )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace osp
@@ -0,0 +1,186 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "array_view.h"
+#include "memory_tracking.h"
+
+#include <longeron/utility/asserts.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace osp
+{
+
+/**
+ * @brief Linear allocator for scratch data that lives until the next reset()
+ *
+ * Allocations are bumped from a block of memory, and a new larger block is added if it runs out.
+ * reset() frees everything at once; if more than one block was needed, they're merged into a
+ * single block big enough for all of them. Once the arena has seen its largest frame, a frame
+ * does no heap allocation.
+ *
+ * Only trivially destructible types are supported, as destructors are never called.
+ *
+ * Blocks can be counted in a MemoryCategory, for arenas that live as long as the program and
+ * would otherwise hide their high-water mark.
+ */
+class FrameArena
+{
+public:
+
+    FrameArena() = default;
+    explicit FrameArena(std::size_t const capacity, MemoryCategory *const pCategory = nullptr)
+     : m_pCategory{pCategory}
+    {
+        if (capacity != 0)
+        {
+            add_block(capacity);
+        }
+    }
+
+    /**
+     * @brief Allocate and value-initialize an array of count elements
+     *
+     * @return View of the array, valid until reset()
+     */
+    template <typename T>
+    [[nodiscard]] ArrayView<T> allocate(std::size_t const count)
+    {
+        static_assert(std::is_trivially_destructible_v<T>, "FrameArena never calls destructors");
+        static_assert(alignof(T) <= alignof(std::max_align_t), "Over-aligned types are not supported");
+
+        if (count == 0)
+        {
+            return {};
+        }
+
+        std::size_t const bytes = sizeof(T) * count;
+        std::size_t offset = align_up(m_blockUsed, alignof(T));
+
+        if (m_blocks.empty() || offset + bytes > m_blocks.back().size)
+        {
+            std::size_t const lastSize = m_blocks.empty() ? 0 : m_blocks.back().size;
+            add_block(std::max({bytes, lastSize * 2, smc_minBlockSize}));
+            offset = 0;
+        }
+
+        T *pData = reinterpret_cast<T*>(m_blocks.back().data.get() + offset);
+        std::uninitialized_value_construct_n(pData, count);
+
+        m_used     += (offset - m_blockUsed) + bytes;
+        m_blockUsed = offset + bytes;
+
+        return {pData, count};
+    }
+
+    /**
+     * @brief Free all allocations, invalidating all views returned by allocate()
+     */
+    void reset()
+    {
+        if (m_blocks.size() > 1)
+        {
+            std::size_t const total = capacity();
+            m_blocks.clear();
+            add_block(total);
+        }
+        m_blockUsed = 0;
+        m_used      = 0;
+    }
+
+    /**
+     * @return Bytes allocated since the last reset, including alignment padding
+     */
+    [[nodiscard]] std::size_t used() const noexcept { return m_used; }
+
+    /**
+     * @return Total bytes of all blocks
+     */
+    [[nodiscard]] std::size_t capacity() const noexcept
+    {
+        std::size_t total = 0;
+        for (Block const& block : m_blocks)
+        {
+            total += block.size;
+        }
+        return total;
+    }
+
+private:
+
+    /// Untracks the block from the arena's MemoryCategory, if any
+    struct BlockDeleter
+    {
+        void operator()(std::byte *const pData) const noexcept
+        {
+            if (pCategory != nullptr)
+            {
+                pCategory->on_free(size);
+            }
+            delete[] pData;
+        }
+
+        MemoryCategory  *pCategory  {nullptr};
+        std::size_t     size        {0};
+    };
+
+    struct Block
+    {
+        std::unique_ptr<std::byte[], BlockDeleter>  data;
+        std::size_t                                 size{0};
+    };
+
+    static constexpr std::size_t smc_minBlockSize = 4096;
+
+    static constexpr std::size_t align_up(std::size_t const value, std::size_t const align) noexcept
+    {
+        return (value + align - 1) & ~(align - 1);
+    }
+
+    void add_block(std::size_t const size)
+    {
+        LGRN_ASSERT(size != 0);
+        // Default-initialized like make_unique_for_overwrite, allocate() initializes what it hands out
+        m_blocks.push_back({std::unique_ptr<std::byte[], BlockDeleter>{new std::byte[size], BlockDeleter{m_pCategory, size}}, size});
+        if (m_pCategory != nullptr)
+        {
+            m_pCategory->on_alloc(size);
+        }
+        m_blockUsed = 0;
+    }
+
+    std::vector<Block>  m_blocks;
+    std::size_t         m_blockUsed {0};
+    std::size_t         m_used      {0};
+    MemoryCategory      *m_pCategory{nullptr};
+
+}; // class FrameArena
+
+} // namespace osp
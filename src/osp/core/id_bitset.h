@@ -0,0 +1,238 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include <longeron/utility/asserts.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace osp
+{
+
+/**
+ * @brief Dense set of IDs stored as bits, iterated a word at a time
+ *
+ * Tracks the range of words that may contain set bits, so clear() and iteration only touch
+ * words that were set since the last clear(). Iteration looks up the next set bit from the live
+ * words, so IDs inserted ahead of an iterator during iteration are visited.
+ */
+template <typename ID_T>
+class IdBitSet
+{
+    using word_t = uint64_t;
+    static constexpr std::size_t smc_wordBits = std::numeric_limits<word_t>::digits;
+
+public:
+
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = ID_T;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = void;
+        using reference         = ID_T;
+
+        const_iterator() = default;
+        const_iterator(IdBitSet const* pSet, std::size_t pos) noexcept : m_pSet{pSet}, m_pos{pos} { }
+
+        ID_T operator*() const noexcept { return ID_T(m_pos); }
+
+        const_iterator& operator++() noexcept { m_pos = m_pSet->find_next(m_pos + 1); return *this; }
+        const_iterator operator++(int) noexcept { const_iterator copy{*this}; ++(*this); return copy; }
+
+        friend bool operator==(const_iterator const& lhs, const_iterator const& rhs) noexcept { return lhs.m_pos == rhs.m_pos; }
+
+    private:
+        IdBitSet const  *m_pSet { nullptr };
+        std::size_t     m_pos   { 0 };
+    };
+
+    /**
+     * @brief Set max number of IDs (exclusive)
+     *
+     * IDs below the new capacity are kept, so this is safe to call on a set that is in use.
+     * Shrinking drops any IDs at or above the new capacity.
+     */
+    void resize(std::size_t const capacity)
+    {
+        std::size_t const wordCount = capacity / smc_wordBits + (capacity % smc_wordBits != 0);
+        m_words.resize(wordCount, 0);
+        m_capacity = capacity;
+
+        // Zero bits past the new capacity in the last word, so growing again won't revive them
+        if (std::size_t const tailBits = capacity % smc_wordBits; tailBits != 0)
+        {
+            m_words.back() &= ~(~word_t(0) << tailBits);
+        }
+
+        m_dirtyLast = std::min(m_dirtyLast, wordCount);
+        if (m_dirtyFirst >= m_dirtyLast)
+        {
+            m_dirtyFirst    = wordCount;
+            m_dirtyLast     = 0;
+        }
+    }
+
+    [[nodiscard]] std::size_t capacity() const noexcept { return m_capacity; }
+
+    void insert(ID_T const id) noexcept
+    {
+        std::size_t const pos = std::size_t(id);
+        LGRN_ASSERTMV(pos < m_capacity, "ID out of range", pos, m_capacity);
+
+        std::size_t const word = pos / smc_wordBits;
+        m_words[word] |= word_t(1) << (pos % smc_wordBits);
+        m_dirtyFirst = std::min(m_dirtyFirst, word);
+        m_dirtyLast  = std::max(m_dirtyLast,  word + 1);
+    }
+
+    template <typename IT_T, typename ITB_T>
+    void insert(IT_T first, ITB_T const last) noexcept
+    {
+        for (; first != last; ++first)
+        {
+            insert(*first);
+        }
+    }
+
+    void erase(ID_T const id) noexcept
+    {
+        std::size_t const pos = std::size_t(id);
+        LGRN_ASSERTMV(pos < m_capacity, "ID out of range", pos, m_capacity);
+        m_words[pos / smc_wordBits] &= ~(word_t(1) << (pos % smc_wordBits));
+    }
+
+    [[nodiscard]] bool contains(ID_T const id) const noexcept
+    {
+        std::size_t const pos = std::size_t(id);
+        return pos < m_capacity && (m_words[pos / smc_wordBits] & (word_t(1) << (pos % smc_wordBits))) != 0;
+    }
+
+    [[nodiscard]] bool empty() const noexcept
+    {
+        for (std::size_t word = m_dirtyFirst; word < m_dirtyLast; ++word)
+        {
+            if (m_words[word] != 0)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void clear() noexcept
+    {
+        for (std::size_t word = m_dirtyFirst; word < m_dirtyLast; ++word)
+        {
+            m_words[word] = 0;
+        }
+        m_dirtyFirst    = m_words.size();
+        m_dirtyLast     = 0;
+    }
+
+    /**
+     * @brief Move all IDs of another set into this one, leaving the other set empty
+     *
+     * Both sets must have the same capacity. Only swaps if this set is empty.
+     */
+    void take(IdBitSet& rOther) noexcept
+    {
+        LGRN_ASSERT(m_capacity == rOther.m_capacity);
+        if (empty())
+        {
+            std::swap(m_words,      rOther.m_words);
+            std::swap(m_dirtyFirst, rOther.m_dirtyFirst);
+            std::swap(m_dirtyLast,  rOther.m_dirtyLast);
+            rOther.clear();
+        }
+        else
+        {
+            for (std::size_t word = rOther.m_dirtyFirst; word < rOther.m_dirtyLast; ++word)
+            {
+                if (rOther.m_words[word] != 0)
+                {
+                    m_words[word] |= rOther.m_words[word];
+                    m_dirtyFirst = std::min(m_dirtyFirst, word);
+                    m_dirtyLast  = std::max(m_dirtyLast,  word + 1);
+                }
+            }
+            rOther.clear();
+        }
+    }
+
+    /**
+     * @return Position of first set bit at or after pos, or capacity() if there are none
+     */
+    [[nodiscard]] std::size_t find_next(std::size_t const pos) const noexcept
+    {
+        std::size_t word = std::max(pos / smc_wordBits, m_dirtyFirst);
+        if (word >= m_dirtyLast)
+        {
+            return m_capacity;
+        }
+
+        // Mask out bits before pos in the first word
+        word_t bits = m_words[word];
+        if (word == pos / smc_wordBits)
+        {
+            bits &= ~word_t(0) << (pos % smc_wordBits);
+        }
+
+        while (bits == 0)
+        {
+            ++ word;
+            if (word >= m_dirtyLast)
+            {
+                return m_capacity;
+            }
+            bits = m_words[word];
+        }
+
+        return word * smc_wordBits + std::size_t(std::countr_zero(bits));
+    }
+
+    [[nodiscard]] const_iterator begin() const noexcept { return {this, find_next(0)}; }
+    [[nodiscard]] const_iterator end() const noexcept   { return {this, m_capacity}; }
+
+private:
+
+    std::vector<word_t> m_words;
+    std::size_t         m_capacity      { 0 };
+
+    // Range of words [m_dirtyFirst, m_dirtyLast) that may have bits set
+    std::size_t         m_dirtyFirst    { 0 };
+    std::size_t         m_dirtyLast     { 0 };
+
+}; // class IdBitSet
+
+} // namespace osp
@@ -24,8 +24,13 @@
  */
 #pragma once
 
+#include "aligned_allocator.h"
+#include "array_view.h"
+
 #include <vector>
+#include <type_traits>
 
+#include <longeron/utility/asserts.hpp>
 #include <longeron/utility/enum_traits.hpp>
 
 namespace osp
@@ -80,6 +85,60 @@ public:
 
 }; // class KeyedVec
 
+/**
+ * @brief KeyedVec with storage aligned to gc_simdAlignment, for data processed by vectorized
+ *        loops
+ */
+template <typename ID_T, typename DATA_T>
+using AlignedKeyedVec = KeyedVec<ID_T, DATA_T, AlignedAllocator<DATA_T, gc_simdAlignment>>;
 
+/**
+ * @brief Copy the values of ids into rOut, in the same order as ids
+ */
+template <typename ID_T, typename DATA_T, typename ALLOC_T>
+void keyed_gather(
+        KeyedVec<ID_T, DATA_T, ALLOC_T> const&          src,
+        std::type_identity_t<ArrayView<ID_T const>>     ids,
+        std::type_identity_t<ArrayView<DATA_T>>         rOut) noexcept
+{
+    LGRN_ASSERTM(ids.size() == rOut.size(), "Output must have one element per ID");
+    for (std::size_t i = 0; i < ids.size(); ++i)
+    {
+        rOut[i] = src[ids[i]];
+    }
+}
+
+/**
+ * @brief Write each value of in to the matching ID in ids, the inverse of keyed_gather
+ */
+template <typename ID_T, typename DATA_T, typename ALLOC_T>
+void keyed_scatter(
+        std::type_identity_t<ArrayView<DATA_T const>>   in,
+        std::type_identity_t<ArrayView<ID_T const>>     ids,
+        KeyedVec<ID_T, DATA_T, ALLOC_T>&                rDst) noexcept
+{
+    LGRN_ASSERTM(ids.size() == in.size(), "Input must have one element per ID");
+    for (std::size_t i = 0; i < ids.size(); ++i)
+    {
+        rDst[ids[i]] = in[i];
+    }
+}
+
+/**
+ * @brief Assign value to every ID in mask
+ *
+ * @param mask [in] Any range of ID_T, such as lgrn::IdSetStl<ID_T>
+ */
+template <typename ID_T, typename DATA_T, typename ALLOC_T, typename MASK_T>
+void keyed_fill_masked(
+        KeyedVec<ID_T, DATA_T, ALLOC_T>&                rDst,
+        MASK_T const&                                   mask,
+        std::type_identity_t<DATA_T> const&             value)
+{
+    for (ID_T const id : mask)
+    {
+        rDst[id] = value;
+    }
+}
 
 } // namespace osp
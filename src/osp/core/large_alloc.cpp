@@ -0,0 +1,294 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "large_alloc.h"
+#include "string_concat.h"
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#if defined(__linux__)
+    #define OSP_LARGE_ALLOC_MMAP 1
+    #include <sys/mman.h>
+    #include <unistd.h>
+#else
+    #define OSP_LARGE_ALLOC_MMAP 0
+#endif
+
+namespace osp
+{
+
+namespace
+{
+
+constexpr std::size_t gc_hugePageSize = std::size_t(2) << 20;
+
+struct Mapping
+{
+    std::size_t     bytes;
+    std::size_t     length;
+    MemoryCategory  *pCategory;
+    MemoryCategory  *pMapped;
+};
+
+struct LargeAllocState
+{
+    std::mutex                                                  mutex;
+    std::map<std::string, LargeAllocPolicy, std::less<>>        policies;
+    std::unordered_map<void const*, Mapping>                    mappings;
+};
+
+LargeAllocState& large_alloc_state() noexcept
+{
+    static LargeAllocState s_state;
+    return s_state;
+}
+
+constexpr std::size_t round_up(std::size_t const value, std::size_t const multiple) noexcept
+{
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+#if OSP_LARGE_ALLOC_MMAP
+
+void* map_anonymous(std::size_t const length, int const extraFlags) noexcept
+{
+    void *const pData = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | extraFlags, -1, 0);
+    return (pData != MAP_FAILED) ? pData : nullptr;
+}
+
+/**
+ * @brief Map length bytes, starting on a huge page boundary so THP can back the whole range
+ */
+void* map_huge_aligned(std::size_t const length) noexcept
+{
+    // Over-map by one huge page, then trim both ends
+    std::size_t const padded = length + gc_hugePageSize;
+    auto *const pRaw = static_cast<unsigned char*>(map_anonymous(padded, 0));
+    if (pRaw == nullptr)
+    {
+        return nullptr;
+    }
+
+    auto const          raw     = reinterpret_cast<std::uintptr_t>(pRaw);
+    std::uintptr_t const aligned = round_up(raw, gc_hugePageSize);
+    std::size_t const   head    = aligned - raw;
+    std::size_t const   tail    = padded - head - length;
+
+    if (head != 0)
+    {
+        ::munmap(pRaw, head);
+    }
+    if (tail != 0)
+    {
+        ::munmap(pRaw + head + length, tail);
+    }
+
+    void *const pData = pRaw + head;
+    ::madvise(pData, length, MADV_HUGEPAGE);
+    return pData;
+}
+
+/**
+ * @brief Touch every page from the calling thread, so first-touch placement puts them on its node
+ */
+void prefault(void* const pData, std::size_t const length) noexcept
+{
+    static std::size_t const s_pageSize = std::size_t(::sysconf(_SC_PAGESIZE));
+
+    auto *const pBytes = static_cast<unsigned char volatile*>(pData);
+    for (std::size_t i = 0; i < length; i += s_pageSize)
+    {
+        pBytes[i] = 0;
+    }
+}
+
+void* map_pages(LargeAllocPolicy const& policy, std::size_t& rLength) noexcept
+{
+    static std::size_t const s_pageSize = std::size_t(::sysconf(_SC_PAGESIZE));
+
+    bool const local = (policy.numa == ENumaPlacement::Local);
+
+    switch (policy.hugePages)
+    {
+    case EHugePages::Explicit:
+        rLength = round_up(rLength, gc_hugePageSize);
+        if (void *const pData = map_anonymous(rLength, MAP_HUGETLB | (local ? MAP_POPULATE : 0));
+            pData != nullptr)
+        {
+            return pData;
+        }
+        // None reserved (see vm.nr_hugepages) or all in use, try transparent ones instead
+        [[fallthrough]];
+    case EHugePages::Transparent:
+    {
+        rLength = round_up(rLength, gc_hugePageSize);
+        void *const pData = map_huge_aligned(rLength);
+        if (pData != nullptr && local)
+        {
+            // Only after madvise; MAP_POPULATE would fault in small pages before it
+            prefault(pData, rLength);
+        }
+        return pData;
+    }
+    case EHugePages::None:
+        rLength = round_up(rLength, s_pageSize);
+        return map_anonymous(rLength, local ? MAP_POPULATE : 0);
+    }
+    return nullptr;
+}
+
+#endif // OSP_LARGE_ALLOC_MMAP
+
+} // namespace
+
+void large_alloc_policy_set(std::string_view const subsystem, LargeAllocPolicy const policy)
+{
+    LargeAllocState &rState = large_alloc_state();
+    std::lock_guard const lock{rState.mutex};
+
+    rState.policies.insert_or_assign(std::string{subsystem}, policy);
+}
+
+LargeAllocPolicy large_alloc_policy(std::string_view const subsystem)
+{
+    LargeAllocState &rState = large_alloc_state();
+    std::lock_guard const lock{rState.mutex};
+
+    auto const found = rState.policies.find(subsystem);
+    return (found != rState.policies.end()) ? found->second : LargeAllocPolicy{};
+}
+
+std::optional<LargeAllocPolicy> large_alloc_policy_from_name(std::string_view name) noexcept
+{
+    LargeAllocPolicy out;
+
+    while ( ! name.empty() )
+    {
+        std::size_t const       plus = name.find('+');
+        std::string_view const  part = name.substr(0, plus);
+        name = (plus == std::string_view::npos) ? std::string_view{} : name.substr(plus + 1);
+
+        if      (part == "none")  { out.hugePages = EHugePages::None; }
+        else if (part == "thp")   { out.hugePages = EHugePages::Transparent; }
+        else if (part == "huge")  { out.hugePages = EHugePages::Explicit; }
+        else if (part == "local") { out.numa      = ENumaPlacement::Local; }
+        else
+        {
+            return std::nullopt;
+        }
+    }
+
+    return out;
+}
+
+void* large_map(std::size_t const bytes, std::string_view const subsystem)
+{
+#if OSP_LARGE_ALLOC_MMAP
+    LargeAllocPolicy const policy = large_alloc_policy(subsystem);
+    if (bytes == 0 || bytes < policy.threshold || ! policy.maps_pages())
+    {
+        return nullptr;
+    }
+
+    std::size_t length = bytes;
+    void *const pData = map_pages(policy, length);
+    if (pData == nullptr)
+    {
+        return nullptr;
+    }
+
+    MemoryCategory &rCategory = memory_category(subsystem);
+    MemoryCategory &rMapped   = memory_category(string_concat(subsystem, ".mapped"));
+    rCategory.on_alloc(bytes);
+    rMapped  .on_alloc(length);
+
+    LargeAllocState &rState = large_alloc_state();
+    std::lock_guard const lock{rState.mutex};
+    rState.mappings.emplace(pData, Mapping{bytes, length, &rCategory, &rMapped});
+
+    return pData;
+#else
+    return nullptr;
+#endif
+}
+
+bool large_unmap(void* const pData) noexcept
+{
+#if OSP_LARGE_ALLOC_MMAP
+    if (pData == nullptr)
+    {
+        return false;
+    }
+
+    Mapping mapping;
+    {
+        LargeAllocState &rState = large_alloc_state();
+        std::lock_guard const lock{rState.mutex};
+
+        auto const found = rState.mappings.find(pData);
+        if (found == rState.mappings.end())
+        {
+            return false;
+        }
+        mapping = found->second;
+        rState.mappings.erase(found);
+    }
+
+    ::munmap(pData, mapping.length);
+    mapping.pCategory->on_free(mapping.bytes);
+    mapping.pMapped  ->on_free(mapping.length);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void* large_alloc(std::size_t const bytes, std::size_t const align, std::string_view const subsystem)
+{
+    if (void *const pMapped = large_map(bytes, subsystem);
+        pMapped != nullptr)
+    {
+        return pMapped;
+    }
+
+    void *const pData = ::operator new(bytes, std::align_val_t{align});
+    memory_category(subsystem).on_alloc(bytes);
+    return pData;
+}
+
+void large_free(void* const pData, std::size_t const bytes, std::size_t const align, std::string_view const subsystem) noexcept
+{
+    if (pData == nullptr || large_unmap(pData))
+    {
+        return;
+    }
+
+    memory_category(subsystem).on_free(bytes);
+    ::operator delete(pData, std::align_val_t{align});
+}
+
+} // namespace osp
@@ -0,0 +1,166 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "memory_tracking.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <optional>
+#include <string_view>
+
+namespace osp
+{
+
+enum class EHugePages : std::uint8_t
+{
+    /// Ordinary heap allocation
+    None,
+
+    /// Huge page aligned mapping advised with madvise(MADV_HUGEPAGE)
+    Transparent,
+
+    /// MAP_HUGETLB from the reserved huge page pool, Transparent if none are free
+    Explicit
+};
+
+enum class ENumaPlacement : std::uint8_t
+{
+    /// Pages land on the node of whichever thread touches them first
+    Default,
+
+    /// Fault in every page on the allocating thread, so all land on its node. Allocate per-worker
+    /// buffers from their worker.
+    Local
+};
+
+/**
+ * @brief How a subsystem allocates its large buffers, see large_alloc
+ */
+struct LargeAllocPolicy
+{
+    EHugePages      hugePages   { EHugePages::None };
+    ENumaPlacement  numa        { ENumaPlacement::Default };
+
+    /// Smaller allocations go to the ordinary heap regardless of the above
+    std::size_t     threshold   { std::size_t(2) << 20 };
+
+    [[nodiscard]] constexpr bool maps_pages() const noexcept
+    {
+        return hugePages != EHugePages::None || numa != ENumaPlacement::Default;
+    }
+};
+
+/**
+ * @brief Set the policy of a subsystem, such as "terrain_geometry" or "universe_sat_data"
+ *
+ * Only affects allocations made afterwards. Subsystems without a policy use the default one,
+ * which never maps pages.
+ */
+void large_alloc_policy_set(std::string_view subsystem, LargeAllocPolicy policy);
+
+[[nodiscard]] LargeAllocPolicy large_alloc_policy(std::string_view subsystem);
+
+/**
+ * @brief Parse a policy: "none", "thp", "huge", or "local", optionally joined as in "thp+local"
+ *
+ * Threshold is left at its default.
+ */
+[[nodiscard]] std::optional<LargeAllocPolicy> large_alloc_policy_from_name(std::string_view name) noexcept;
+
+/**
+ * @brief Map pages for bytes following the policy of subsystem
+ *
+ * Bytes are counted in memory_category(subsystem), and the whole mapping, rounded up to whole
+ * pages, in memory_category("<subsystem>.mapped").
+ *
+ * @return Page aligned memory, or nullptr if the policy leaves this size to the heap or mapping
+ *         failed. Free with large_unmap.
+ */
+[[nodiscard]] void* large_map(std::size_t bytes, std::string_view subsystem);
+
+/**
+ * @return True if pData came from large_map and was unmapped, false if it's from somewhere else
+ */
+bool large_unmap(void* pData) noexcept;
+
+/**
+ * @brief Allocate with large_map, or from the heap with the given alignment if it returns nullptr
+ *
+ * Either way, bytes are counted in memory_category(subsystem).
+ */
+[[nodiscard]] void* large_alloc(std::size_t bytes, std::size_t align, std::string_view subsystem);
+
+void large_free(void* pData, std::size_t bytes, std::size_t align, std::string_view subsystem) noexcept;
+
+/**
+ * @brief Standard allocator that allocates through large_alloc, with the policy of the subsystem
+ *        named by TAG_T
+ *
+ * TAG_T is any type with a `static constexpr std::string_view smc_name`, as with
+ * TrackingAllocator. Only the start of the array is aligned to ALIGN_T, same as AlignedAllocator.
+ */
+template <typename T, typename TAG_T, std::size_t ALIGN_T = alignof(T)>
+struct LargeAllocator
+{
+    static_assert((ALIGN_T & (ALIGN_T - 1)) == 0, "Alignment must be a power of two");
+
+    using value_type = T;
+
+    static constexpr std::size_t smc_align = std::max(ALIGN_T, alignof(T));
+
+    template <typename U>
+    struct rebind
+    {
+        using other = LargeAllocator<U, TAG_T, ALIGN_T>;
+    };
+
+    constexpr LargeAllocator() noexcept = default;
+
+    template <typename U>
+    constexpr LargeAllocator(LargeAllocator<U, TAG_T, ALIGN_T> const&) noexcept { }
+
+    [[nodiscard]] T* allocate(std::size_t const count)
+    {
+        if (count > std::numeric_limits<std::size_t>::max() / sizeof(T))
+        {
+            throw std::bad_array_new_length();
+        }
+        return static_cast<T*>(large_alloc(count * sizeof(T), smc_align, TAG_T::smc_name));
+    }
+
+    void deallocate(T* const pData, std::size_t const count) noexcept
+    {
+        large_free(pData, count * sizeof(T), smc_align, TAG_T::smc_name);
+    }
+
+    template <typename U>
+    constexpr bool operator==(LargeAllocator<U, TAG_T, ALIGN_T> const&) const noexcept { return true; }
+};
+
+} // namespace osp
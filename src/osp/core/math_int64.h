@@ -24,55 +24,124 @@
  */
 #pragma once
 
+#include "array_view.h"
 #include "math_types.h"
 
+#include <longeron/utility/asserts.hpp>
+
+#include <algorithm>
+#include <cstdint>
+
 namespace osp
 {
 
+#if defined(__SIZEOF_INT128__)
+    #define OSP_HAS_INT128 1
+    __extension__ typedef unsigned __int128 uint128_t;
+#else
+    #define OSP_HAS_INT128 0
+#endif
+
+/**
+ * @brief Largest threshold is_distance_near_64 supports; 3 * threshold^2 must fit in 64 bits
+ */
+constexpr std::uint64_t gc_distanceNearMax64 = 2479700524ul;
+
 /**
  * @brief int64 abs(lhs - rhs) with no risk of overflow
+ *
+ * The true difference always fits in uint64, so subtracting as unsigned gives the exact result
+ * even when the signed subtraction would overflow.
  */
 constexpr std::uint64_t absdelta(std::int64_t lhs, std::int64_t rhs) noexcept
 {
-    // TODO: maybe use int128 for compilers that support it?
+    return (lhs > rhs) ? (std::uint64_t(lhs) - std::uint64_t(rhs))
+                       : (std::uint64_t(rhs) - std::uint64_t(lhs));
+};
 
-    bool const lhsPositive = lhs > 0;
-    bool const rhsPositive = rhs > 0;
-    if      (   lhsPositive && ! rhsPositive )
-    {
-        return std::uint64_t(lhs) + std::uint64_t(-rhs);
-    }
-    else if ( ! lhsPositive &&   rhsPositive )
-    {
-        return std::uint64_t(-lhs) + std::uint64_t(rhs);
-    }
-    // else, lhs and rhs are the same sign. no risk of overflow
+/**
+ * @brief (distance between a and b) < threshold, using only 64-bit math
+ *
+ * Each axis is clamped to threshold first; an axis that far away already fails the test, and
+ * clamping keeps the sum of squares in range. Branch-free, so loops over it vectorize.
+ *
+ * @param threshold [in] Must be <= gc_distanceNearMax64
+ */
+constexpr bool is_distance_near_64(Vector3l const a, Vector3l const b, std::uint64_t const threshold) noexcept
+{
+    std::uint64_t const dx = std::min(absdelta(a.x(), b.x()), threshold);
+    std::uint64_t const dy = std::min(absdelta(a.y(), b.y()), threshold);
+    std::uint64_t const dz = std::min(absdelta(a.z(), b.z()), threshold);
 
-    return std::uint64_t((lhs > rhs) ? (lhs - rhs) : (rhs - lhs));
-};
+    return (dx*dx + dy*dy + dz*dz) < threshold*threshold;
+}
 
 /**
- * @brief (distance between a and b) > threshold
+ * @brief (distance between a and b) < threshold
  *
- * This function is quick and dirty, max threshold is limited to 1,431,655,765
+ * Exact for any threshold where the compiler supports 128-bit integers. Elsewhere, thresholds
+ * above gc_distanceNearMax64 are compared in long double.
  */
 constexpr bool is_distance_near(Vector3l const a, Vector3l const b, std::uint64_t const threshold) noexcept
 {
+    if (threshold <= gc_distanceNearMax64)
+    {
+        return is_distance_near_64(a, b, threshold);
+    }
+
     std::uint64_t const dx = absdelta(a.x(), b.x());
     std::uint64_t const dy = absdelta(a.y(), b.y());
     std::uint64_t const dz = absdelta(a.z(), b.z());
 
-    // 1431655765 = sqrt(2^64)/3 = max distance without risk of overflow
-    constexpr std::uint64_t dmax = 1431655765ul;
-
-    if (dx > dmax || dy > dmax || dz > dmax)
+    if (dx >= threshold || dy >= threshold || dz >= threshold)
     {
         return false;
     }
 
-    std::uint64_t const magnitudeSqr = (dx*dx + dy*dy + dz*dz);
+#if OSP_HAS_INT128
+    // Each square is below threshold^2 < 2^128, but a sum can still wrap. Subtract from
+    // threshold^2 instead of adding.
+    uint128_t const thresholdSqr = uint128_t(threshold) * threshold;
+    uint128_t const remainXY     = thresholdSqr - uint128_t(dx) * dx;
+    uint128_t const dySqr        = uint128_t(dy) * dy;
+    return dySqr < remainXY && uint128_t(dz) * dz < remainXY - dySqr;
+#else
+    using ld = long double;
+    return ld(dx)*ld(dx) + ld(dy)*ld(dy) + ld(dz)*ld(dz) < ld(threshold)*ld(threshold);
+#endif
+}
 
-    return magnitudeSqr < threshold*threshold;
+/**
+ * @brief is_distance_near for many points against one
+ *
+ * Uses a branch-free loop the compiler can vectorize when threshold <= gc_distanceNearMax64.
+ *
+ * @param points    [in] Vector3l, or narrower vectors such as Vector3i
+ * @param rNearOut  [out] 1 where the point is near, otherwise 0. Same size as points
+ */
+template <typename VEC_T>
+void is_distance_near_batch(
+        ArrayView<VEC_T const>      const points,
+        Vector3l                    const pos,
+        std::uint64_t               const threshold,
+        ArrayView<std::uint8_t>     const rNearOut) noexcept
+{
+    std::size_t const count = points.size();
+    LGRN_ASSERTM(rNearOut.size() == count, "Output must have one element per point");
+
+    if (threshold > gc_distanceNearMax64)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            rNearOut[i] = std::uint8_t(is_distance_near(Vector3l(points[i]), pos, threshold));
+        }
+        return;
+    }
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        rNearOut[i] = std::uint8_t(is_distance_near_64(Vector3l(points[i]), pos, threshold));
+    }
 }
 
 } // namespace osp
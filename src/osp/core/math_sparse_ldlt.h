@@ -0,0 +1,194 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "array_view.h"
+
+#include <longeron/utility/asserts.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace osp
+{
+
+/**
+ * @brief LDLᵀ factorization of a sparse symmetric positive definite matrix, in profile
+ *        (skyline) storage
+ *
+ * Each row stores its entries from its first nonzero column up to the diagonal. Factorization
+ * never fills in outside of this profile, so the storage is fixed as soon as the matrix is
+ * reset. Factorizing costs O(sum of squared row widths) and solving costs O(profile size), so
+ * rows that are connected should be given nearby indices.
+ *
+ * Factorize once when the matrix changes, then solve for any number of right-hand sides.
+ */
+class ProfileLDLT
+{
+public:
+
+    /**
+     * @brief Reset to a zero matrix with the given profile
+     *
+     * @param rowFirst  [in] First stored column of each row, must be <= the row index itself
+     */
+    void reset(std::vector<std::uint32_t> rowFirst)
+    {
+        m_rowFirst = std::move(rowFirst);
+        m_rowStart.resize(m_rowFirst.size() + 1);
+        m_rowStart[0] = 0;
+        for (std::uint32_t row = 0; row < m_rowFirst.size(); ++row)
+        {
+            LGRN_ASSERTM(m_rowFirst[row] <= row, "Profile must start at or before the diagonal");
+            m_rowStart[row + 1] = m_rowStart[row] + (row - m_rowFirst[row] + 1);
+        }
+        m_values.assign(m_rowStart.back(), 0.0);
+    }
+
+    /**
+     * @brief Add to a symmetric pair of entries, (row, col) and (col, row)
+     *
+     * The entry must be within the profile given to reset().
+     */
+    void add(std::uint32_t const row, std::uint32_t const col, double const value) noexcept
+    {
+        std::uint32_t const hi = std::max(row, col);
+        std::uint32_t const lo = std::min(row, col);
+        LGRN_ASSERTM(lo >= m_rowFirst[hi], "Entry outside of matrix profile");
+        m_values[index(hi, lo)] += value;
+    }
+
+    /**
+     * @brief Factorize in place, added values are replaced by L and D
+     *
+     * @return false if the matrix turned out not to be positive definite
+     */
+    bool factorize() noexcept
+    {
+        std::uint32_t const n = size();
+        for (std::uint32_t i = 0; i < n; ++i)
+        {
+            std::uint32_t const fi = m_rowFirst[i];
+            std::size_t const rowI = m_rowStart[i] - fi; // m_values[rowI + k] = L(i, k)
+
+            for (std::uint32_t j = fi; j < i; ++j)
+            {
+                std::uint32_t const fj    = m_rowFirst[j];
+                std::size_t const   rowJ  = m_rowStart[j] - fj;
+
+                double sum = m_values[rowI + j];
+                for (std::uint32_t k = std::max(fi, fj); k < j; ++k)
+                {
+                    sum -= m_values[rowI + k] * diagonal(k) * m_values[rowJ + k];
+                }
+                m_values[rowI + j] = sum / diagonal(j);
+            }
+
+            double d = m_values[rowI + i];
+            for (std::uint32_t k = fi; k < i; ++k)
+            {
+                d -= m_values[rowI + k] * m_values[rowI + k] * diagonal(k);
+            }
+
+            if ( ! (d > 0.0) )
+            {
+                return false;
+            }
+            m_values[rowI + i] = d;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Solve A x = b using the factorization, in place
+     *
+     * @param rhsToX    [in,out] b on input, x on output
+     */
+    void solve(ArrayView<double> const rhsToX) const noexcept
+    {
+        std::uint32_t const n = size();
+        LGRN_ASSERT(rhsToX.size() == n);
+
+        // L y = b
+        for (std::uint32_t i = 0; i < n; ++i)
+        {
+            std::uint32_t const fi    = m_rowFirst[i];
+            std::size_t const   rowI  = m_rowStart[i] - fi;
+            double sum = rhsToX[i];
+            for (std::uint32_t k = fi; k < i; ++k)
+            {
+                sum -= m_values[rowI + k] * rhsToX[k];
+            }
+            rhsToX[i] = sum;
+        }
+
+        // D z = y
+        for (std::uint32_t i = 0; i < n; ++i)
+        {
+            rhsToX[i] /= diagonal(i);
+        }
+
+        // Lᵀ x = z, column by column since only rows of L are stored
+        for (std::uint32_t i = n; i-- > 0; )
+        {
+            std::uint32_t const fi    = m_rowFirst[i];
+            std::size_t const   rowI  = m_rowStart[i] - fi;
+            for (std::uint32_t k = fi; k < i; ++k)
+            {
+                rhsToX[k] -= m_values[rowI + k] * rhsToX[i];
+            }
+        }
+    }
+
+    [[nodiscard]] std::uint32_t size() const noexcept
+    {
+        return static_cast<std::uint32_t>(m_rowFirst.size());
+    }
+
+    /// Number of stored entries, including the diagonal
+    [[nodiscard]] std::size_t profile_size() const noexcept
+    {
+        return m_values.size();
+    }
+
+private:
+
+    [[nodiscard]] std::size_t index(std::uint32_t const row, std::uint32_t const col) const noexcept
+    {
+        return m_rowStart[row] + (col - m_rowFirst[row]);
+    }
+
+    [[nodiscard]] double diagonal(std::uint32_t const row) const noexcept
+    {
+        return m_values[m_rowStart[row + 1] - 1];
+    }
+
+    std::vector<std::uint32_t>  m_rowFirst;
+    std::vector<std::size_t>    m_rowStart;
+    std::vector<double>         m_values;
+};
+
+} // namespace osp
@@ -49,6 +49,8 @@ using Vector2i      = Magnum::Math::Vector2<Magnum::Int>;
 
 using Vector3u      = Magnum::Math::Vector3<Magnum::UnsignedInt>;
 
+using Vector3i      = Magnum::Math::Vector3<Magnum::Int>;
+
 using Vector3l      = Magnum::Math::Vector3<Magnum::Long>;
 
 using Vector2       = Magnum::Math::Vector2<Magnum::Float>;
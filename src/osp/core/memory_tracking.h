@@ -0,0 +1,192 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace osp
+{
+
+/**
+ * @brief Live and peak heap bytes of one subsystem, updated by allocators that track it
+ *
+ * Safe to update from any thread. See memory_category and TrackingAllocator.
+ */
+class MemoryCategory
+{
+public:
+
+    void on_alloc(std::size_t const bytes) noexcept
+    {
+        std::size_t const live = m_live.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        std::size_t peak = m_peak.load(std::memory_order_relaxed);
+        while (live > peak && ! m_peak.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+        { }
+        m_allocCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void on_free(std::size_t const bytes) noexcept
+    {
+        m_live.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    /// Start a new high-water mark from the current live bytes, such as after loading a scene
+    void reset_peak() noexcept
+    {
+        m_peak.store(m_live.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] std::size_t live() const noexcept { return m_live.load(std::memory_order_relaxed); }
+    [[nodiscard]] std::size_t peak() const noexcept { return m_peak.load(std::memory_order_relaxed); }
+    [[nodiscard]] std::uint64_t alloc_count() const noexcept { return m_allocCount.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<std::size_t>    m_live          {0};
+    std::atomic<std::size_t>    m_peak          {0};
+    std::atomic<std::uint64_t>  m_allocCount    {0};
+};
+
+struct MemoryCategoryStats
+{
+    std::string_view    name;
+    std::size_t         live;
+    std::size_t         peak;
+    std::uint64_t       allocCount;
+};
+
+namespace detail
+{
+
+struct MemoryCategories
+{
+    std::mutex  mutex;
+    std::map< std::string, std::unique_ptr<MemoryCategory>, std::less<> > categories;
+};
+
+inline MemoryCategories& memory_categories() noexcept
+{
+    static MemoryCategories s_categories;
+    return s_categories;
+}
+
+} // namespace detail
+
+/**
+ * @brief Get or create the process-wide MemoryCategory of a name
+ *
+ * The returned reference stays valid until the program exits; cache it to skip the lookup.
+ */
+inline MemoryCategory& memory_category(std::string_view const name)
+{
+    detail::MemoryCategories &rReg = detail::memory_categories();
+    std::lock_guard const lock{rReg.mutex};
+
+    auto found = rReg.categories.find(name);
+    if (found == rReg.categories.end())
+    {
+        found = rReg.categories.emplace(std::string{name}, std::make_unique<MemoryCategory>()).first;
+    }
+    return *found->second;
+}
+
+/**
+ * @brief Read every MemoryCategory created so far, sorted by name
+ */
+[[nodiscard]] inline std::vector<MemoryCategoryStats> memory_category_stats()
+{
+    detail::MemoryCategories &rReg = detail::memory_categories();
+    std::lock_guard const lock{rReg.mutex};
+
+    std::vector<MemoryCategoryStats> out;
+    out.reserve(rReg.categories.size());
+    for (auto const& [name, pCategory] : rReg.categories)
+    {
+        out.push_back({name, pCategory->live(), pCategory->peak(), pCategory->alloc_count()});
+    }
+    return out;
+}
+
+/**
+ * @brief Standard allocator that counts its allocations in the MemoryCategory named by TAG_T
+ *
+ * TAG_T is any type with a `static constexpr std::string_view smc_name`. Opt-in for containers
+ * suspected of growing, e.g. `KeyedVec<ID, T, TrackingAllocator<T, MyTag>>`; untracked
+ * containers cost nothing.
+ */
+template <typename T, typename TAG_T>
+struct TrackingAllocator
+{
+    using value_type = T;
+
+    template <typename U>
+    struct rebind
+    {
+        using other = TrackingAllocator<U, TAG_T>;
+    };
+
+    constexpr TrackingAllocator() noexcept = default;
+
+    template <typename U>
+    constexpr TrackingAllocator(TrackingAllocator<U, TAG_T> const&) noexcept { }
+
+    static MemoryCategory& category()
+    {
+        static MemoryCategory &rCategory = memory_category(TAG_T::smc_name);
+        return rCategory;
+    }
+
+    [[nodiscard]] T* allocate(std::size_t const count)
+    {
+        if (count > std::numeric_limits<std::size_t>::max() / sizeof(T))
+        {
+            throw std::bad_array_new_length();
+        }
+        T *const pData = std::allocator<T>{}.allocate(count);
+        category().on_alloc(count * sizeof(T));
+        return pData;
+    }
+
+    void deallocate(T* const pData, std::size_t const count) noexcept
+    {
+        category().on_free(count * sizeof(T));
+        std::allocator<T>{}.deallocate(pData, count);
+    }
+
+    template <typename U>
+    constexpr bool operator==(TrackingAllocator<U, TAG_T> const&) const noexcept { return true; }
+};
+
+} // namespace osp
@@ -0,0 +1,105 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "id_map.h"
+#include "paged_keyed_vector.h"
+
+#include <longeron/id_management/registry_stl.hpp>
+
+#include <concepts>
+#include <cstddef>
+#include <vector>
+
+namespace osp
+{
+
+/**
+ * @brief Specialize to report the heap memory owned by a type, such as a TopData struct
+ *
+ * Specializations provide `static std::size_t heap_bytes(T const&) noexcept`, usually the sum of
+ * the heap_bytes overloads below for each member. Counts are from container capacities, so they
+ * are estimates, but they grow with the real thing; that's what finding leaks needs.
+ *
+ * TopData types that specialize this are counted by top_memory_bytes.
+ */
+template <typename T>
+struct MemoryUsage;
+
+template <typename T>
+concept HasMemoryUsage = requires(T const& value)
+{
+    { MemoryUsage<T>::heap_bytes(value) } -> std::convertible_to<std::size_t>;
+};
+
+template <HasMemoryUsage T>
+[[nodiscard]] std::size_t heap_bytes(T const& value) noexcept
+{
+    return MemoryUsage<T>::heap_bytes(value);
+}
+
+/// Also covers KeyedVec and AlignedKeyedVec, and elements that own heap memory themselves
+template <typename T, typename ALLOC_T>
+[[nodiscard]] std::size_t heap_bytes(std::vector<T, ALLOC_T> const& vec) noexcept
+{
+    std::size_t bytes = vec.capacity() * sizeof(T);
+    if constexpr (requires(T const& elem) { heap_bytes(elem); })
+    {
+        for (T const& elem : vec)
+        {
+            bytes += heap_bytes(elem);
+        }
+    }
+    return bytes;
+}
+
+template <typename ID_T, typename DATA_T, std::size_t PAGE_SIZE>
+[[nodiscard]] std::size_t heap_bytes(PagedKeyedVec<ID_T, DATA_T, PAGE_SIZE> const& vec) noexcept
+{
+    return vec.page_count() * (PAGE_SIZE * sizeof(DATA_T) + sizeof(void*));
+}
+
+/// Registries are bitsets of free IDs, one bit per ID of capacity
+template <typename ID_T, bool NO_AUTO_RESIZE>
+[[nodiscard]] std::size_t heap_bytes(lgrn::IdRegistryStl<ID_T, NO_AUTO_RESIZE> const& ids) noexcept
+{
+    return (ids.capacity() + 63) / 64 * sizeof(std::uint64_t);
+}
+
+/// Dense maps keep key-value pairs packed, plus one index per bucket
+template <typename KEY_T, typename VALUE_T, typename HASH_T, typename EQ_T, typename ALLOC_T>
+[[nodiscard]] std::size_t heap_bytes(entt::dense_map<KEY_T, VALUE_T, HASH_T, EQ_T, ALLOC_T> const& map) noexcept
+{
+    return map.size() * (sizeof(std::size_t) + sizeof(KEY_T) + sizeof(VALUE_T))
+         + map.bucket_count() * sizeof(std::size_t);
+}
+
+template <typename ... T>
+[[nodiscard]] std::size_t heap_bytes_sum(T const& ... values) noexcept
+{
+    return (std::size_t{0} + ... + heap_bytes(values));
+}
+
+} // namespace osp
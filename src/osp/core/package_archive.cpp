@@ -0,0 +1,271 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "package_archive.h"
+#include "byte_stream.h"
+
+#include <Corrade/Containers/Optional.h>
+#include <Corrade/Containers/String.h>
+#include <Corrade/Containers/StringStlView.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <sys/mman.h>
+    #include <unistd.h>
+    #define OSP_PACKAGE_ARCHIVE_MADVISE
+#endif
+
+using Corrade::Containers::Array;
+using Corrade::Containers::Optional;
+
+namespace Path = Corrade::Utility::Path;
+
+namespace osp
+{
+
+namespace
+{
+
+constexpr std::array<char, 4>   gc_packageArchiveMagic  {'O', 'S', 'P', 'K'};
+
+// Same as the asset cache, so meshes and images read straight out of the mapping are aligned
+constexpr std::size_t           gc_fileAlignment        = 16;
+
+struct PackageArchiveHeader
+{
+    std::array<char, 4>     magic;
+    std::uint32_t           version;
+    std::uint64_t           entryCount;
+};
+
+constexpr std::size_t align_up(std::size_t const value) noexcept
+{
+    return (value + gc_fileAlignment - 1) / gc_fileAlignment * gc_fileAlignment;
+}
+
+void advise_will_need([[maybe_unused]] char const* pData, [[maybe_unused]] std::size_t const size) noexcept
+{
+#ifdef OSP_PACKAGE_ARCHIVE_MADVISE
+    // madvise needs a page-aligned start
+    static std::uintptr_t const pageMask = std::uintptr_t(sysconf(_SC_PAGESIZE)) - 1;
+    auto const start = reinterpret_cast<std::uintptr_t>(pData) & ~pageMask;
+    auto const end   = reinterpret_cast<std::uintptr_t>(pData) + size;
+    posix_madvise(reinterpret_cast<void*>(start), end - start, POSIX_MADV_WILLNEED);
+#endif
+    // Elsewhere there's no equivalent without platform headers, pages are read on first access
+}
+
+} // namespace
+
+std::optional<PackageArchive> PackageArchive::open(std::string_view const archivePath)
+{
+    if ( ! Path::exists(archivePath) )
+    {
+        return std::nullopt;
+    }
+
+    Optional<Array<char const, Path::MapDeleter>> mapping = Path::mapRead(archivePath);
+    if ( ! bool(mapping) )
+    {
+        return std::nullopt;
+    }
+
+    auto const bytes = ArrayView<std::byte const>{reinterpret_cast<std::byte const*>(mapping->data()), mapping->size()};
+    ByteReader reader{bytes};
+
+    PackageArchiveHeader header;
+    if (   ! reader.read(header)
+        || header.magic   != gc_packageArchiveMagic
+        || header.version != gc_packageArchiveVersion
+        || header.entryCount > reader.remaining().size() / sizeof(Entry))
+    {
+        return std::nullopt;
+    }
+
+    ArrayView<std::byte const> entryBytes;
+    if ( ! reader.read_view(header.entryCount * sizeof(Entry), entryBytes) )
+    {
+        return std::nullopt;
+    }
+
+    PackageArchive out;
+    out.m_entries = {reinterpret_cast<Entry const*>(entryBytes.data()), std::size_t(header.entryCount)};
+
+    // Validate everything up front, so lookups don't need to
+    for (Entry const& entry : out.m_entries)
+    {
+        if (   entry.pathOffset > bytes.size() || entry.pathSize > bytes.size() - entry.pathOffset
+            || entry.dataOffset > bytes.size() || entry.dataSize > bytes.size() - entry.dataOffset)
+        {
+            return std::nullopt;
+        }
+    }
+
+    out.m_mapping = std::move(*mapping);
+
+    for (std::size_t i = 1; i < out.m_entries.size(); ++i)
+    {
+        if ( ! (out.path_at(i - 1) < out.path_at(i)) )
+        {
+            return std::nullopt; // Not sorted, binary search in find wouldn't work
+        }
+    }
+
+    return out;
+}
+
+std::string_view PackageArchive::path_at(std::size_t const index) const noexcept
+{
+    Entry const& entry = m_entries[index];
+    return {m_mapping.data() + entry.pathOffset, std::size_t(entry.pathSize)};
+}
+
+std::optional< ArrayView<char const> > PackageArchive::find(std::string_view const path) const noexcept
+{
+    auto const found = std::lower_bound(m_entries.begin(), m_entries.end(), path,
+            [this] (Entry const& entry, std::string_view const value) noexcept
+    {
+        return std::string_view{m_mapping.data() + entry.pathOffset, std::size_t(entry.pathSize)} < value;
+    });
+
+    if (found == m_entries.end() || path_at(std::size_t(found - m_entries.begin())) != path)
+    {
+        return std::nullopt;
+    }
+
+    return ArrayView<char const>{m_mapping.data() + found->dataOffset, std::size_t(found->dataSize)};
+}
+
+void PackageArchive::prefetch() const noexcept
+{
+    advise_will_need(m_mapping.data(), m_mapping.size());
+}
+
+void PackageArchive::prefetch(std::string_view const path) const noexcept
+{
+    if (std::optional< ArrayView<char const> > const data = find(path);
+        data.has_value())
+    {
+        advise_will_need(data->data(), data->size());
+    }
+}
+
+bool write_package_archive(
+        std::string_view                    archivePath,
+        std::string_view                    baseDir,
+        ArrayView<std::string_view const>   files)
+{
+    std::vector<std::string_view> sorted(files.begin(), files.end());
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+    std::size_t const entryCount = sorted.size();
+
+    std::vector<std::byte> paths;
+    std::vector<std::byte> contents;
+    std::vector<std::array<std::uint64_t, 4>> entries(entryCount);
+
+    std::size_t const pathsStart = sizeof(PackageArchiveHeader) + entryCount * sizeof(entries[0]);
+
+    for (std::size_t i = 0; i < entryCount; ++i)
+    {
+        std::string_view const file = sorted[i];
+
+        Optional<Array<char>> const data = Path::read(Path::join(baseDir, file));
+        if ( ! bool(data) )
+        {
+            return false;
+        }
+
+        contents.resize(align_up(contents.size()));
+        entries[i] = {pathsStart + paths.size(), file.size(), contents.size(), data->size()};
+        append_bytes(paths,     file.data(),    file.size());
+        append_bytes(contents,  data->data(),   data->size());
+    }
+
+    // File contents are offset by all the parts before them
+    std::size_t const contentsStart = align_up(pathsStart + paths.size());
+    for (auto &rEntry : entries)
+    {
+        rEntry[2] += contentsStart;
+    }
+
+    std::vector<std::byte> out;
+    out.reserve(contentsStart + contents.size());
+    append_bytes(out, PackageArchiveHeader{gc_packageArchiveMagic, gc_packageArchiveVersion, entryCount});
+    append_bytes(out, entries.data(), entries.size() * sizeof(entries[0]));
+    append_bytes(out, paths.data(), paths.size());
+    out.resize(contentsStart);
+    append_bytes(out, contents.data(), contents.size());
+
+    return Path::write(archivePath, Corrade::Containers::ArrayView<void const>{out.data(), out.size()});
+}
+
+bool PackageArchives::mount(PkgId const pkg, std::string_view const archivePath)
+{
+    std::optional<PackageArchive> archive = PackageArchive::open(archivePath);
+    if ( ! archive.has_value() )
+    {
+        return false;
+    }
+
+    if (std::size_t(pkg) >= m_archives.size())
+    {
+        m_archives.resize(std::size_t(pkg) + 1);
+    }
+    m_archives[pkg] = std::move(archive);
+    return true;
+}
+
+void PackageArchives::unmount(PkgId const pkg) noexcept
+{
+    if (std::size_t(pkg) < m_archives.size())
+    {
+        m_archives[pkg].reset();
+    }
+}
+
+PackageArchive const* PackageArchives::find(PkgId const pkg) const noexcept
+{
+    if (std::size_t(pkg) >= m_archives.size() || ! m_archives[pkg].has_value())
+    {
+        return nullptr;
+    }
+    return &*m_archives[pkg];
+}
+
+void PackageArchives::prefetch(PkgId const pkg) const noexcept
+{
+    if (PackageArchive const *pArchive = find(pkg);
+        pArchive != nullptr)
+    {
+        pArchive->prefetch();
+    }
+}
+
+} // namespace osp
@@ -0,0 +1,152 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "array_view.h"
+#include "keyed_vector.h"
+#include "resourcetypes.h"
+
+#include <Corrade/Containers/Array.h>
+#include <Corrade/Utility/Path.h>
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace osp
+{
+
+/**
+ * @brief Version of the package archive format, archives of other versions fail to open
+ */
+constexpr std::uint32_t gc_packageArchiveVersion = 1;
+
+/**
+ * @brief A single file holding every asset of a package, read through a memory mapping
+ *
+ * Layout is a header, a table of entries sorted by path, the path strings, then the contents of
+ * each file aligned to 16 bytes. Paths are relative to the directory the archive was written
+ * from, with '/' separators.
+ *
+ * Nothing is read from disk until it's accessed, so opening is cheap regardless of size; see
+ * prefetch() to warm up the page cache ahead of time.
+ */
+class PackageArchive
+{
+public:
+
+    /**
+     * @return Archive, or nullopt if the file is missing, corrupt, or a different version
+     */
+    [[nodiscard]] static std::optional<PackageArchive> open(std::string_view archivePath);
+
+    /**
+     * @return Contents of a file within the archive, or nullopt if there's no such file. Valid
+     *         for as long as the archive exists
+     */
+    [[nodiscard]] std::optional< ArrayView<char const> > find(std::string_view path) const noexcept;
+
+    [[nodiscard]] std::size_t size() const noexcept { return m_entries.size(); }
+
+    [[nodiscard]] std::string_view path_at(std::size_t const index) const noexcept;
+
+    /**
+     * @brief Hint that the whole archive will be read soon
+     *
+     * Returns immediately; the OS reads ahead in the background where supported.
+     */
+    void prefetch() const noexcept;
+
+    /**
+     * @brief Hint that a single file in the archive will be read soon
+     */
+    void prefetch(std::string_view path) const noexcept;
+
+private:
+
+    struct Entry
+    {
+        std::uint64_t pathOffset;
+        std::uint64_t pathSize;
+        std::uint64_t dataOffset;
+        std::uint64_t dataSize;
+    };
+
+    PackageArchive() = default;
+
+    Corrade::Containers::Array<char const, Corrade::Utility::Path::MapDeleter> m_mapping;
+    ArrayView<Entry const> m_entries;
+
+}; // class PackageArchive
+
+/**
+ * @brief Pack files into a package archive
+ *
+ * @param archivePath   [in] Archive file to write
+ * @param baseDir       [in] Directory that files are relative to
+ * @param files         [in] Paths to store, relative to baseDir
+ *
+ * @return true if every file was read and the archive was written
+ */
+bool write_package_archive(
+        std::string_view                    archivePath,
+        std::string_view                    baseDir,
+        ArrayView<std::string_view const>   files);
+
+/**
+ * @brief Package archives mounted for each PkgId
+ *
+ * Resources leaves package metadata to be stored externally; this is where a package's files
+ * come from. At most one archive is mounted per package.
+ */
+class PackageArchives
+{
+public:
+
+    /**
+     * @return true if the archive was opened. Replaces any archive already mounted for pkg
+     */
+    bool mount(PkgId pkg, std::string_view archivePath);
+
+    void unmount(PkgId pkg) noexcept;
+
+    /**
+     * @return Archive mounted for pkg, or nullptr if there's none
+     */
+    [[nodiscard]] PackageArchive const* find(PkgId pkg) const noexcept;
+
+    /**
+     * @brief Hint that assets of a package will be needed soon, such as before a scene or
+     *        universe region using it is loaded. Does nothing if no archive is mounted for pkg
+     */
+    void prefetch(PkgId pkg) const noexcept;
+
+private:
+    KeyedVec< PkgId, std::optional<PackageArchive> > m_archives;
+
+}; // class PackageArchives
+
+} // namespace osp
@@ -0,0 +1,86 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "page_snapshot.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace osp
+{
+
+PageSnapshot PageSnapshot::capture(ArrayView<std::byte const> data, PageSnapshot const* pPrevious)
+{
+    PageSnapshot out;
+    out.m_size = data.size();
+
+    std::size_t const pageCount = (data.size() + smc_pageSize - 1) / smc_pageSize;
+    out.m_pages.reserve(pageCount);
+
+    for (std::size_t i = 0; i < pageCount; ++i)
+    {
+        std::size_t const pos   = i * smc_pageSize;
+        std::size_t const size  = std::min(smc_pageSize, data.size() - pos);
+        std::byte const   *pSrc = data.data() + pos;
+
+        // Share the previous page if it has the same size and contents. Only the last page can
+        // have a different size, in which case the buffer was resized and it's copied anyway.
+        if (   pPrevious != nullptr
+            && i < pPrevious->page_count()
+            && pPrevious->page(i).size() == size
+            && std::memcmp(pPrevious->m_pages[i].get(), pSrc, size) == 0 )
+        {
+            out.m_pages.push_back(pPrevious->m_pages[i]);
+            continue;
+        }
+
+        std::shared_ptr<std::byte[]> page{new std::byte[size]};
+        std::memcpy(page.get(), pSrc, size);
+        out.m_pages.emplace_back(std::move(page));
+    }
+
+    return out;
+}
+
+std::size_t PageSnapshot::shared_page_count(PageSnapshot const& other) const noexcept
+{
+    std::size_t const count = std::min(m_pages.size(), other.m_pages.size());
+    std::size_t shared = 0;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        shared += (m_pages[i] == other.m_pages[i]) ? 1 : 0;
+    }
+    return shared;
+}
+
+void PageSnapshot::copy_to(std::byte* pOut) const noexcept
+{
+    for (std::size_t i = 0; i < m_pages.size(); ++i)
+    {
+        ArrayView<std::byte const> const bytes = page(i);
+        std::memcpy(pOut + i * smc_pageSize, bytes.data(), bytes.size());
+    }
+}
+
+} // namespace osp
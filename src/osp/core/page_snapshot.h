@@ -0,0 +1,91 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "array_view.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace osp
+{
+
+/**
+ * @brief Immutable copy of a buffer, split into reference-counted pages
+ *
+ * Meant for capturing large buffers at a frame boundary so they can be serialized on another
+ * thread while the original keeps changing. Capturing against the previous snapshot of the same
+ * buffer only copies pages that changed since; unchanged pages are shared between both
+ * snapshots instead of being allocated and copied again. Buffers that rarely change, such as
+ * terrain skeletons, then only cost a compare per page.
+ *
+ * Snapshots are never modified after capture, so copies can be read from any thread.
+ */
+class PageSnapshot
+{
+public:
+
+    static constexpr std::size_t smc_pageSize = 65536;
+
+    using Page_t = std::shared_ptr<std::byte const[]>;
+
+    /**
+     * @param data      [in] Buffer to copy
+     * @param pPrevious [in] Optional earlier snapshot of the same buffer to share pages with
+     */
+    [[nodiscard]] static PageSnapshot capture(ArrayView<std::byte const> data, PageSnapshot const* pPrevious = nullptr);
+
+    template <typename T>
+    [[nodiscard]] static PageSnapshot capture_of(ArrayView<T const> data, PageSnapshot const* pPrevious = nullptr)
+    {
+        return capture({reinterpret_cast<std::byte const*>(data.data()), data.size() * sizeof(T)}, pPrevious);
+    }
+
+    /// Size of the captured buffer in bytes
+    [[nodiscard]] std::size_t size() const noexcept { return m_size; }
+
+    [[nodiscard]] std::size_t page_count() const noexcept { return m_pages.size(); }
+
+    /// @return Bytes of a page, the last page may be smaller than smc_pageSize
+    [[nodiscard]] ArrayView<std::byte const> page(std::size_t const index) const noexcept
+    {
+        std::size_t const pos = index * smc_pageSize;
+        return {m_pages[index].get(), std::min(smc_pageSize, m_size - pos)};
+    }
+
+    /// @return Number of pages shared with other, for metrics
+    [[nodiscard]] std::size_t shared_page_count(PageSnapshot const& other) const noexcept;
+
+    /// Copy the captured buffer to pOut, which must fit size() bytes
+    void copy_to(std::byte* pOut) const noexcept;
+
+private:
+    std::vector<Page_t> m_pages;
+    std::size_t         m_size{0};
+};
+
+} // namespace osp
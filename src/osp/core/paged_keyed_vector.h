@@ -0,0 +1,236 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "array_view.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include <longeron/utility/asserts.hpp>
+
+namespace osp
+{
+
+/**
+ * @brief KeyedVec-like container made of fixed-size pages, accessed using an ID
+ *
+ * Growing only allocates the new pages, so it costs O(new pages) instead of moving every element
+ * like a KeyedVec does. Pages never move, so pointers and references to elements stay valid
+ * across resizes (except for elements removed by shrinking). Growing still must not overlap
+ * with element access from other threads, since the page table itself may reallocate.
+ *
+ * Use KeyedVec instead for data that needs to be contiguous, such as data passed around as an
+ * ArrayView or uploaded to the GPU. Each page can be viewed separately with page().
+ *
+ * @tparam PAGE_SIZE Elements per page, must be a power of two
+ */
+template <typename ID_T, typename DATA_T, std::size_t PAGE_SIZE = 1024>
+class PagedKeyedVec
+{
+    static_assert(PAGE_SIZE != 0 && (PAGE_SIZE & (PAGE_SIZE - 1)) == 0, "PAGE_SIZE must be a power of two");
+
+    using page_t = std::unique_ptr<DATA_T[]>;
+
+    template <typename PARENT_T, typename VALUE_T>
+    class IteratorBase
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using difference_type   = std::ptrdiff_t;
+        using value_type        = std::remove_const_t<VALUE_T>;
+        using pointer           = VALUE_T*;
+        using reference         = VALUE_T&;
+
+        IteratorBase() = default;
+        IteratorBase(PARENT_T *pParent, std::size_t index) noexcept : m_pParent{pParent}, m_index{index} { }
+
+        reference operator*() const noexcept { return m_pParent->get(m_index); }
+        pointer operator->() const noexcept { return std::addressof(m_pParent->get(m_index)); }
+
+        IteratorBase& operator++() noexcept { ++m_index; return *this; }
+        IteratorBase operator++(int) noexcept { IteratorBase copy{*this}; ++m_index; return copy; }
+
+        friend bool operator==(IteratorBase const& lhs, IteratorBase const& rhs) noexcept
+        {
+            return lhs.m_index == rhs.m_index;
+        }
+
+    private:
+        PARENT_T        *m_pParent{nullptr};
+        std::size_t     m_index{0};
+    };
+
+public:
+
+    static constexpr std::size_t smc_pageSize = PAGE_SIZE;
+
+    using value_type        = DATA_T;
+    using size_type         = std::size_t;
+    using reference         = DATA_T&;
+    using const_reference   = DATA_T const&;
+    using iterator          = IteratorBase<PagedKeyedVec, DATA_T>;
+    using const_iterator    = IteratorBase<PagedKeyedVec const, DATA_T const>;
+
+    PagedKeyedVec() = default;
+    PagedKeyedVec(PagedKeyedVec&& move) noexcept = default;
+    PagedKeyedVec& operator=(PagedKeyedVec&& move) noexcept = default;
+
+    PagedKeyedVec(PagedKeyedVec const& copy)
+     : m_size{copy.m_size}
+    {
+        m_pages.reserve(copy.m_pages.size());
+        for (page_t const& page : copy.m_pages)
+        {
+            m_pages.emplace_back(std::make_unique<DATA_T[]>(PAGE_SIZE));
+            std::copy_n(page.get(), PAGE_SIZE, m_pages.back().get());
+        }
+    }
+
+    PagedKeyedVec& operator=(PagedKeyedVec const& copy)
+    {
+        if (this != &copy)
+        {
+            *this = PagedKeyedVec{copy};
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Resize to fit size elements, new elements are set to value
+     *
+     * Only allocates pages that aren't already allocated. Shrinking frees pages past the new size.
+     */
+    void resize(std::size_t const size, DATA_T const& value = DATA_T{})
+    {
+        std::size_t const pagesNeeded = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+
+        // Elements past m_size in the last used page may hold stale values from shrinking
+        for (std::size_t i = m_size; i < std::min(size, m_pages.size() * PAGE_SIZE); ++i)
+        {
+            get(i) = value;
+        }
+
+        if (pagesNeeded < m_pages.size())
+        {
+            m_pages.resize(pagesNeeded);
+        }
+        else
+        {
+            m_pages.reserve(pagesNeeded);
+            while (m_pages.size() < pagesNeeded)
+            {
+                page_t &rPage = m_pages.emplace_back(std::make_unique<DATA_T[]>(PAGE_SIZE));
+                std::fill_n(rPage.get(), PAGE_SIZE, value);
+            }
+        }
+
+        m_size = size;
+    }
+
+    void clear() noexcept
+    {
+        m_pages.clear();
+        m_size = 0;
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept { return m_size; }
+    [[nodiscard]] bool empty() const noexcept { return m_size == 0; }
+    [[nodiscard]] std::size_t page_count() const noexcept { return m_pages.size(); }
+
+    /**
+     * @return Contiguous view of a single page, cut short to size() for the last page
+     */
+    [[nodiscard]] ArrayView<DATA_T> page(std::size_t const pageIndex) noexcept
+    {
+        LGRN_ASSERTM(pageIndex < m_pages.size(), "Page out of range");
+        return {m_pages[pageIndex].get(), std::min(PAGE_SIZE, m_size - pageIndex * PAGE_SIZE)};
+    }
+
+    [[nodiscard]] ArrayView<DATA_T const> page(std::size_t const pageIndex) const noexcept
+    {
+        LGRN_ASSERTM(pageIndex < m_pages.size(), "Page out of range");
+        return {m_pages[pageIndex].get(), std::min(PAGE_SIZE, m_size - pageIndex * PAGE_SIZE)};
+    }
+
+    reference at(ID_T const id)
+    {
+        check_range(std::size_t(id));
+        return get(std::size_t(id));
+    }
+
+    const_reference at(ID_T const id) const
+    {
+        check_range(std::size_t(id));
+        return get(std::size_t(id));
+    }
+
+    reference operator[] (ID_T const id) noexcept
+    {
+        LGRN_ASSERTM(std::size_t(id) < m_size, "ID out of range");
+        return get(std::size_t(id));
+    }
+
+    const_reference operator[] (ID_T const id) const noexcept
+    {
+        LGRN_ASSERTM(std::size_t(id) < m_size, "ID out of range");
+        return get(std::size_t(id));
+    }
+
+    iterator        begin() noexcept        { return {this, 0}; }
+    iterator        end() noexcept          { return {this, m_size}; }
+    const_iterator  begin() const noexcept  { return {this, 0}; }
+    const_iterator  end() const noexcept    { return {this, m_size}; }
+
+private:
+
+    reference get(std::size_t const index) noexcept
+    {
+        return m_pages[index / PAGE_SIZE][index % PAGE_SIZE];
+    }
+
+    const_reference get(std::size_t const index) const noexcept
+    {
+        return m_pages[index / PAGE_SIZE][index % PAGE_SIZE];
+    }
+
+    void check_range(std::size_t const index) const
+    {
+        if (index >= m_size)
+        {
+            throw std::out_of_range("PagedKeyedVec: ID out of range");
+        }
+    }
+
+    std::vector<page_t>     m_pages;
+    std::size_t             m_size{0};
+
+}; // class PagedKeyedVec
+
+} // namespace osp
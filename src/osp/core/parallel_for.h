@@ -0,0 +1,82 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+namespace osp
+{
+
+/**
+ * @brief Runs a loop in ranges, some of them on other threads, for whoever owns the threads
+ *
+ * Lets code outside of the task system split up a large loop without starting threads of its
+ * own. TopWorkerPool gives one to every task through WorkerContext::m_parallelFor, so idle
+ * workers help with ranges the task would otherwise run by itself.
+ *
+ * A default-constructed ParallelFor runs everything on the calling thread.
+ */
+struct ParallelFor
+{
+    using RangeFunc_t = void (*)(void const* pFunc, std::size_t first, std::size_t last);
+
+    /// Must call rangeFunc once for each of ranges pieces of [0, count), and return only once
+    /// all of them are done. The calling thread may run any number of them itself.
+    using Func_t = void (*)(void* pUserData, std::size_t count, std::size_t ranges, RangeFunc_t rangeFunc, void const* pFunc);
+
+    /**
+     * @brief Call func(first, last) for ranges of [0, count), returning once all are done
+     *
+     * @param maxRanges [in] Most ranges to split into, such as to keep each range worth its
+     *                       overhead. Capped to m_threads.
+     */
+    template <typename FUNC_T>
+    void operator()(std::size_t const count, std::size_t const maxRanges, FUNC_T const& func) const
+    {
+        std::size_t const ranges = std::min({maxRanges, m_threads, count});
+        if (m_func == nullptr || ranges <= 1)
+        {
+            if (count != 0)
+            {
+                func(std::size_t(0), count);
+            }
+            return;
+        }
+
+        m_func(m_pUserData, count, ranges, [] (void const* pFunc, std::size_t const first, std::size_t const last)
+        {
+            (*static_cast<FUNC_T const*>(pFunc))(first, last);
+        }, &func);
+    }
+
+    Func_t          m_func      {nullptr};
+    void            *m_pUserData{nullptr};
+
+    /// Threads that may run ranges at once, including the calling thread
+    std::size_t     m_threads   {1};
+};
+
+} // namespace osp
@@ -0,0 +1,135 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include <longeron/utility/asserts.hpp>
+
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+namespace osp
+{
+
+/**
+ * @brief Fixed-capacity FIFO that overwrites its oldest element once full
+ *
+ * Never allocates after set_capacity(). Iterates from oldest to newest.
+ */
+template <typename T>
+class RingBuffer
+{
+public:
+
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = T;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = T const*;
+        using reference         = T const&;
+
+        const_iterator() = default;
+        const_iterator(RingBuffer const* pRing, std::size_t pos) noexcept : m_pRing{pRing}, m_pos{pos} { }
+
+        reference operator*() const noexcept { return m_pRing->m_data[m_pRing->wrap(m_pRing->m_first + m_pos)]; }
+        pointer operator->() const noexcept { return &**this; }
+
+        const_iterator& operator++() noexcept { ++m_pos; return *this; }
+        const_iterator operator++(int) noexcept { const_iterator copy{*this}; ++m_pos; return copy; }
+
+        friend bool operator==(const_iterator const& lhs, const_iterator const& rhs) noexcept = default;
+
+    private:
+        RingBuffer const    *m_pRing    { nullptr };
+        std::size_t         m_pos       { 0 };
+    };
+
+    RingBuffer() = default;
+    explicit RingBuffer(std::size_t capacity) { set_capacity(capacity); }
+
+    /**
+     * @brief Set max number of elements stored, clearing all existing elements
+     */
+    void set_capacity(std::size_t const capacity)
+    {
+        m_data.clear();
+        m_data.resize(capacity);
+        clear();
+    }
+
+    void push_back(T value) noexcept
+    {
+        LGRN_ASSERTM( ! m_data.empty(), "RingBuffer has no capacity, call set_capacity first");
+
+        if (m_size == m_data.size())
+        {
+            // Full, overwrite oldest
+            m_data[m_first] = std::move(value);
+            m_first = wrap(m_first + 1);
+            ++ m_dropped;
+        }
+        else
+        {
+            m_data[wrap(m_first + m_size)] = std::move(value);
+            ++ m_size;
+        }
+    }
+
+    void clear() noexcept
+    {
+        m_first     = 0;
+        m_size      = 0;
+        m_dropped   = 0;
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept     { return m_size; }
+    [[nodiscard]] std::size_t capacity() const noexcept { return m_data.size(); }
+    [[nodiscard]] bool empty() const noexcept           { return m_size == 0; }
+
+    /**
+     * @return Number of elements overwritten since the last clear()
+     */
+    [[nodiscard]] std::size_t dropped() const noexcept  { return m_dropped; }
+
+    [[nodiscard]] const_iterator begin() const noexcept { return {this, 0}; }
+    [[nodiscard]] const_iterator end() const noexcept   { return {this, m_size}; }
+
+private:
+
+    [[nodiscard]] std::size_t wrap(std::size_t const index) const noexcept
+    {
+        return (index >= m_data.size()) ? (index - m_data.size()) : index;
+    }
+
+    std::vector<T>  m_data;
+    std::size_t     m_first     { 0 };
+    std::size_t     m_size      { 0 };
+    std::size_t     m_dropped   { 0 };
+
+}; // class RingBuffer
+
+} // namespace osp
@@ -0,0 +1,114 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "string_pool.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace osp;
+
+std::uint64_t StringPool::hash_string(std::string_view const str) noexcept
+{
+    // FNV-1a
+    std::uint64_t hash = 14695981039346656037ull;
+    for (char const c : str)
+    {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+    }
+    return hash;
+}
+
+std::size_t StringPool::slot_of(std::string_view const str, std::uint64_t const hash) const noexcept
+{
+    std::size_t const mask = m_slots.size() - 1;
+    std::size_t slot = hash & mask;
+    while (true)
+    {
+        StrId const id = m_slots[slot];
+        if (   id == lgrn::id_null<StrId>()
+            || (m_hashes[std::size_t(id)] == hash && m_views[std::size_t(id)] == str))
+        {
+            return slot;
+        }
+        slot = (slot + 1) & mask;
+    }
+}
+
+void StringPool::rehash(std::size_t const slotCount)
+{
+    m_slots.assign(slotCount, lgrn::id_null<StrId>());
+    std::size_t const mask = slotCount - 1;
+    for (std::size_t i = 0; i < m_views.size(); ++i)
+    {
+        std::size_t slot = m_hashes[i] & mask;
+        while (m_slots[slot] != lgrn::id_null<StrId>())
+        {
+            slot = (slot + 1) & mask;
+        }
+        m_slots[slot] = StrId(i);
+    }
+}
+
+StrId StringPool::find(std::string_view const str) const noexcept
+{
+    if (m_slots.empty())
+    {
+        return lgrn::id_null<StrId>();
+    }
+    return m_slots[slot_of(str, hash_string(str))];
+}
+
+StrId StringPool::intern(std::string_view const str)
+{
+    // Keep load factor at or below 1/2
+    if ((m_views.size() + 1) * 2 > m_slots.size())
+    {
+        rehash(std::max<std::size_t>(16, m_slots.size() * 2));
+    }
+
+    std::uint64_t const hash = hash_string(str);
+    std::size_t const   slot = slot_of(str, hash);
+    if (m_slots[slot] != lgrn::id_null<StrId>())
+    {
+        return m_slots[slot];
+    }
+
+    // Copy into the current block, or a new one if it doesn't fit. Strings larger than a block
+    // get a block of their own.
+    if (m_blocks.empty() || str.size() > smc_blockSize - m_blockUsed)
+    {
+        m_blocks.emplace_back(new char[std::max(smc_blockSize, str.size())]);
+        m_blockUsed = 0;
+    }
+    char *pData = m_blocks.back().get() + m_blockUsed;
+    std::memcpy(pData, str.data(), str.size());
+    m_blockUsed = (str.size() > smc_blockSize) ? smc_blockSize : m_blockUsed + str.size();
+
+    StrId const id = StrId(m_views.size());
+    m_views .emplace_back(pData, str.size());
+    m_hashes.push_back(hash);
+    m_slots[slot] = id;
+    return id;
+}
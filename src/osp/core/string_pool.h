@@ -0,0 +1,100 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include <longeron/id_management/null.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace osp
+{
+
+/**
+ * @brief Handle to a string interned in a StringPool. Equal strings have equal handles.
+ */
+enum class StrId : std::uint32_t { };
+
+/**
+ * @brief Interns strings, giving each unique string a 32-bit handle
+ *
+ * Strings are copied into large blocks that are never moved or freed until the pool is
+ * destroyed, so views returned by view() stay valid for the pool's lifetime. Each string is
+ * hashed once when interned; comparing interned strings only needs comparing handles.
+ *
+ * Not thread-safe; synchronize externally.
+ */
+class StringPool
+{
+public:
+
+    [[nodiscard]] static std::uint64_t hash_string(std::string_view str) noexcept;
+
+    /**
+     * @return Handle of an equal string already in the pool, or of a newly added copy of str
+     */
+    StrId intern(std::string_view str);
+
+    /**
+     * @return Handle of an equal string in the pool, or null if there isn't one
+     */
+    [[nodiscard]] StrId find(std::string_view str) const noexcept;
+
+    [[nodiscard]] std::string_view view(StrId const id) const noexcept
+    {
+        return m_views[std::size_t(id)];
+    }
+
+    [[nodiscard]] std::uint64_t hash(StrId const id) const noexcept
+    {
+        return m_hashes[std::size_t(id)];
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept
+    {
+        return m_views.size();
+    }
+
+private:
+
+    static constexpr std::size_t smc_blockSize = 64 * 1024;
+
+    [[nodiscard]] std::size_t slot_of(std::string_view str, std::uint64_t hash) const noexcept;
+
+    void rehash(std::size_t slotCount);
+
+    std::vector< std::unique_ptr<char[]> >  m_blocks;
+    std::size_t                             m_blockUsed{smc_blockSize};
+
+    std::vector<std::string_view>           m_views;
+    std::vector<std::uint64_t>              m_hashes;
+
+    // Open addressing with linear probing, size is a power of two. Empty slots are null.
+    std::vector<StrId>                      m_slots;
+};
+
+} // namespace osp
@@ -0,0 +1,379 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "culling.h"
+#include "drawing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace osp;
+using namespace osp::draw;
+
+Frustum SysCulling::frustum_from_view_proj(Matrix4 const& viewProj) noexcept
+{
+    Vector4 const row0 = viewProj.row(0);
+    Vector4 const row1 = viewProj.row(1);
+    Vector4 const row2 = viewProj.row(2);
+    Vector4 const row3 = viewProj.row(3);
+
+    Frustum out{{ row3 + row0, row3 - row0,
+                  row3 + row1, row3 - row1,
+                  row3 + row2, row3 - row2 }};
+
+    for (Vector4 &rPlane : out.m_planes)
+    {
+        rPlane /= rPlane.xyz().length();
+    }
+
+    return out;
+}
+
+BoundingSphere SysCulling::sphere_from_points(Corrade::Containers::StridedArrayView1D<Vector3 const> points) noexcept
+{
+    if (points.isEmpty())
+    {
+        return {};
+    }
+
+    Vector3 min = points[0];
+    Vector3 max = points[0];
+    for (Vector3 const& point : points)
+    {
+        min = Magnum::Math::min(min, point);
+        max = Magnum::Math::max(max, point);
+    }
+
+    Vector3 const center = (min + max) * 0.5f;
+    float radiusSqr = 0.0f;
+    for (Vector3 const& point : points)
+    {
+        radiusSqr = std::max(radiusSqr, (point - center).dot());
+    }
+
+    return {center, std::sqrt(radiusSqr)};
+}
+
+bool SysCulling::sphere_in_frustum(Frustum const& frustum, BoundingSphere const& sphere) noexcept
+{
+    if (sphere.m_radius < 0.0f)
+    {
+        return true;
+    }
+
+    return std::all_of(frustum.m_planes.begin(), frustum.m_planes.end(), [&sphere] (Vector4 const& plane)
+    {
+        return Magnum::Math::dot(plane.xyz(), sphere.m_center) + plane.w() >= -sphere.m_radius;
+    });
+}
+
+std::size_t SysCulling::cull(
+        Frustum const&                              frustum,
+        lgrn::IdSetStl<DrawEnt> const&              visibleIn,
+        DrawEntBounds_t const&                      bounds,
+        AlignedKeyedVec<DrawEnt, Matrix4> const&    drawTf,
+        CullScratch&                                rScratch,
+        lgrn::IdSetStl<DrawEnt>&                    rVisibleOut) noexcept
+{
+    rVisibleOut.clear();
+    rVisibleOut.resize(bounds.size());
+
+    rScratch.m_ents  .clear();
+    rScratch.m_x     .clear();
+    rScratch.m_y     .clear();
+    rScratch.m_z     .clear();
+    rScratch.m_radius.clear();
+
+    // Gather world-space spheres. DrawEnts without bounds skip the test entirely.
+    for (DrawEnt const drawEnt : visibleIn)
+    {
+        BoundingSphere const& sphere = bounds[drawEnt];
+        if (sphere.m_radius < 0.0f)
+        {
+            rVisibleOut.insert(drawEnt);
+            continue;
+        }
+
+        Matrix4 const& tf      = drawTf[drawEnt];
+        Vector3 const  center  = tf.transformPoint(sphere.m_center);
+        float const    scaleSqr = std::max({tf[0].xyz().dot(), tf[1].xyz().dot(), tf[2].xyz().dot()});
+
+        rScratch.m_ents  .push_back(drawEnt);
+        rScratch.m_x     .push_back(center.x());
+        rScratch.m_y     .push_back(center.y());
+        rScratch.m_z     .push_back(center.z());
+        rScratch.m_radius.push_back(sphere.m_radius * std::sqrt(scaleSqr));
+    }
+
+    std::size_t const count = rScratch.m_ents.size();
+    rScratch.m_inside.assign(count, 1);
+
+    float const* const pX      = rScratch.m_x.data();
+    float const* const pY      = rScratch.m_y.data();
+    float const* const pZ      = rScratch.m_z.data();
+    float const* const pRadius = rScratch.m_radius.data();
+    uint8_t*     const pInside = rScratch.m_inside.data();
+
+    // One plane at a time over all spheres; no branches so this vectorizes
+    for (Vector4 const& plane : frustum.m_planes)
+    {
+        float const nx = plane.x();
+        float const ny = plane.y();
+        float const nz = plane.z();
+        float const d  = plane.w();
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            float const dist = nx * pX[i] + ny * pY[i] + nz * pZ[i] + d;
+            pInside[i] &= uint8_t(dist >= -pRadius[i]);
+        }
+    }
+
+    std::size_t culled = 0;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (pInside[i] != 0)
+        {
+            rVisibleOut.insert(rScratch.m_ents[i]);
+        }
+        else
+        {
+            ++culled;
+        }
+    }
+
+    return culled;
+}
+
+void SysCulling::build_depth_pyramid(
+        DepthPyramid&                                           rPyramid,
+        Corrade::Containers::StridedArrayView2D<float const>    depth,
+        Matrix4 const&                                          viewProj) noexcept
+{
+    int width  = int(depth.size()[1]);
+    int height = int(depth.size()[0]);
+
+    rPyramid.m_viewProj = viewProj;
+
+    if (width == 0 || height == 0)
+    {
+        rPyramid.m_levels.clear();
+        return;
+    }
+
+    // Level count so that the last one is 1x1
+    std::size_t levelCount = 1;
+    for (int size = std::max(width, height); size > 1; size = (size + 1) / 2)
+    {
+        ++levelCount;
+    }
+    rPyramid.m_levels.resize(levelCount);
+
+    DepthPyramid::Level &rFirst = rPyramid.m_levels[0];
+    rFirst.m_width  = width;
+    rFirst.m_height = height;
+    rFirst.m_depth.resize(std::size_t(width) * std::size_t(height));
+    for (int y = 0; y < height; ++y)
+    {
+        std::copy(depth[std::size_t(y)].begin(), depth[std::size_t(y)].end(), rFirst.m_depth.begin() + std::ptrdiff_t(y) * width);
+    }
+
+    for (std::size_t level = 1; level < levelCount; ++level)
+    {
+        DepthPyramid::Level const   &rPrev = rPyramid.m_levels[level - 1];
+        DepthPyramid::Level         &rNext = rPyramid.m_levels[level];
+
+        rNext.m_width  = (rPrev.m_width  + 1) / 2;
+        rNext.m_height = (rPrev.m_height + 1) / 2;
+        rNext.m_depth.resize(std::size_t(rNext.m_width) * std::size_t(rNext.m_height));
+
+        for (int y = 0; y < rNext.m_height; ++y)
+        {
+            // Clamp to the last row/column, for odd sizes
+            float const *pRow0 = &rPrev.m_depth[std::size_t(2 * y) * rPrev.m_width];
+            float const *pRow1 = &rPrev.m_depth[std::size_t(std::min(2 * y + 1, rPrev.m_height - 1)) * rPrev.m_width];
+            float       *pOut  = &rNext.m_depth[std::size_t(y) * rNext.m_width];
+
+            for (int x = 0; x < rNext.m_width; ++x)
+            {
+                int const x0 = 2 * x;
+                int const x1 = std::min(2 * x + 1, rPrev.m_width - 1);
+                pOut[x] = std::max({pRow0[x0], pRow0[x1], pRow1[x0], pRow1[x1]});
+            }
+        }
+    }
+}
+
+std::size_t SysCulling::occlusion_cull(
+        DepthPyramid const&                         pyramid,
+        CullScratch const&                          scratch,
+        lgrn::IdSetStl<DrawEnt>&                    rVisible) noexcept
+{
+    if (pyramid.m_levels.empty())
+    {
+        return 0;
+    }
+
+    DepthPyramid::Level const &rFirst = pyramid.m_levels[0];
+    float const width  = float(rFirst.m_width);
+    float const height = float(rFirst.m_height);
+
+    std::size_t culled = 0;
+    for (std::size_t i = 0; i < scratch.m_ents.size(); ++i)
+    {
+        if (scratch.m_inside[i] == 0)
+        {
+            continue; // Already culled by the frustum
+        }
+
+        // Project corners of the sphere's bounding box. The box contains the sphere, so its
+        // screen rectangle and nearest depth are conservative.
+        Vector3 const center {scratch.m_x[i], scratch.m_y[i], scratch.m_z[i]};
+        float const   radius = scratch.m_radius[i];
+
+        Vector2 min  {std::numeric_limits<float>::max()};
+        Vector2 max  {std::numeric_limits<float>::lowest()};
+        float nearest = std::numeric_limits<float>::max();
+        bool  behind  = false;
+
+        for (int corner = 0; corner < 8; ++corner)
+        {
+            Vector3 const offset{(corner & 1) ? radius : -radius,
+                                 (corner & 2) ? radius : -radius,
+                                 (corner & 4) ? radius : -radius};
+            Vector4 const clip = pyramid.m_viewProj * Vector4{center + offset, 1.0f};
+            if (clip.w() <= 1e-5f)
+            {
+                behind = true; // Crosses the camera plane, can't project
+                break;
+            }
+            Vector3 const ndc = clip.xyz() / clip.w();
+            min     = Magnum::Math::min(min, ndc.xy());
+            max     = Magnum::Math::max(max, ndc.xy());
+            nearest = std::min(nearest, ndc.z());
+        }
+
+        if (behind || min.x() < -1.0f || min.y() < -1.0f || max.x() > 1.0f || max.y() > 1.0f)
+        {
+            continue; // Depth outside of the pyramid's viewport is unknown
+        }
+
+        // NDC to level 0 texels and window-space depth
+        float const minX = (min.x() * 0.5f + 0.5f) * width;
+        float const minY = (min.y() * 0.5f + 0.5f) * height;
+        float const maxX = (max.x() * 0.5f + 0.5f) * width;
+        float const maxY = (max.y() * 0.5f + 0.5f) * height;
+        float const nearestDepth = nearest * 0.5f + 0.5f;
+
+        // Pick the level where the rectangle covers at most 2 texels along its longest side,
+        // so no more than 3x3 texels are read
+        float const   extent = std::max(maxX - minX, maxY - minY);
+        std::size_t   level  = 0;
+        while (level + 1 < pyramid.m_levels.size() && extent > float(2u << level))
+        {
+            ++level;
+        }
+
+        DepthPyramid::Level const &rLevel = pyramid.m_levels[level];
+        float const scale = 1.0f / float(1u << level);
+
+        int const x0 = std::clamp(int(minX * scale), 0, rLevel.m_width  - 1);
+        int const y0 = std::clamp(int(minY * scale), 0, rLevel.m_height - 1);
+        int const x1 = std::clamp(int(maxX * scale), 0, rLevel.m_width  - 1);
+        int const y1 = std::clamp(int(maxY * scale), 0, rLevel.m_height - 1);
+
+        float farthest = 0.0f;
+        for (int y = y0; y <= y1; ++y)
+        {
+            for (int x = x0; x <= x1; ++x)
+            {
+                farthest = std::max(farthest, rLevel.m_depth[std::size_t(y) * rLevel.m_width + x]);
+            }
+        }
+
+        if (nearestDepth > farthest)
+        {
+            rVisible.erase(scratch.m_ents[i]);
+            ++culled;
+        }
+    }
+
+    return culled;
+}
+
+/**
+ * @brief Diameter of a DrawEnt's bounds over its distance, relative to the 2 unit tall NDC viewport
+ */
+static float screen_size(BoundingSphere const& sphere, Matrix4 const& tf, Matrix4 const& view, float const projScaleY) noexcept
+{
+    Vector3 const center   = view.transformPoint(tf.transformPoint(sphere.m_center));
+    float const   scaleSqr = std::max({tf[0].xyz().dot(), tf[1].xyz().dot(), tf[2].xyz().dot()});
+    float const   radius   = sphere.m_radius * std::sqrt(scaleSqr);
+
+    // Camera looks down -Z
+    float const distance = std::max(-center.z(), 1e-4f);
+    return radius * projScaleY / distance;
+}
+
+void SysCulling::select_lods(
+        ACtxSceneRender&                rScnRender,
+        lgrn::IdSetStl<DrawEnt> const&  visible,
+        Matrix4 const&                  view,
+        float const                     projScaleY) noexcept
+{
+    for (auto && [drawEnt, rLods] : rScnRender.m_lods)
+    {
+        BoundingSphere const& sphere = rScnRender.m_bounds[drawEnt];
+        if ( ! visible.contains(drawEnt) || sphere.m_radius < 0.0f )
+        {
+            continue;
+        }
+
+        float const screenSize = screen_size(sphere, rScnRender.m_drawTransform[drawEnt], view, projScaleY);
+
+        std::uint8_t level = 0;
+        while (level < rLods.m_count && screenSize < rLods.m_maxScreenSize[level])
+        {
+            ++level;
+        }
+
+        rLods.m_current = level;
+    }
+}
+
+void SysCulling::screen_sizes(
+        ACtxSceneRender&                rScnRender,
+        lgrn::IdSetStl<DrawEnt> const&  visible,
+        Matrix4 const&                  view,
+        float const                     projScaleY) noexcept
+{
+    for (DrawEnt const drawEnt : visible)
+    {
+        BoundingSphere const& sphere = rScnRender.m_bounds[drawEnt];
+        rScnRender.m_screenSize[drawEnt] = (sphere.m_radius < 0.0f)
+                ? -1.0f
+                : screen_size(sphere, rScnRender.m_drawTransform[drawEnt], view, projScaleY);
+    }
+}
@@ -0,0 +1,220 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "draw_ent.h"
+
+#include "../core/keyed_vector.h"
+#include "../core/math_types.h"
+
+#include <Corrade/Containers/StridedArrayView.h>
+
+#include <longeron/id_management/id_set_stl.hpp>
+
+#include <array>
+#include <vector>
+
+namespace osp::draw
+{
+
+struct ACtxSceneRender;
+
+/**
+ * @brief Bounding sphere of a DrawEnt in its local (mesh) space
+ *
+ * A negative radius means the bounds are unknown; such DrawEnts are never culled.
+ */
+struct BoundingSphere
+{
+    Vector3 m_center    {0.0f};
+    float   m_radius    {-1.0f};
+};
+
+using DrawEntBounds_t = KeyedVec<DrawEnt, BoundingSphere>;
+
+/**
+ * @brief 6 planes of a view frustum, normals pointing inwards
+ *
+ * Each plane is (normal.x, normal.y, normal.z, distance), normalized so that
+ * dot(normal, point) + distance is the signed distance of a point to the plane.
+ */
+struct Frustum
+{
+    std::array<Vector4, 6> m_planes;
+};
+
+/**
+ * @brief Scratch buffers for SysCulling::cull, kept between frames to avoid reallocating
+ *
+ * World-space spheres are stored as structure-of-arrays so that the plane tests compile into
+ * a branchless loop the compiler can vectorize.
+ */
+struct CullScratch
+{
+    std::vector<DrawEnt>    m_ents;
+    std::vector<float>      m_x;
+    std::vector<float>      m_y;
+    std::vector<float>      m_z;
+    std::vector<float>      m_radius;
+    std::vector<uint8_t>    m_inside;
+};
+
+/**
+ * @brief Hierarchical depth buffer for SysCulling::occlusion_cull
+ *
+ * Level 0 is the depth buffer it was built from, bottom row first. Each level after is half the
+ * size (rounded up) and keeps the farthest depth of the 2x2 texels below it. Depths are in
+ * window space, 0 (near) to 1 (far).
+ */
+struct DepthPyramid
+{
+    struct Level
+    {
+        std::vector<float>  m_depth;
+        int                 m_width     {0};
+        int                 m_height    {0};
+    };
+
+    /// Empty if there is no depth to test against, such as on the first frame
+    std::vector<Level>      m_levels;
+
+    /// Projection * view matrix of the frame the depth buffer was rendered with
+    Matrix4                 m_viewProj;
+};
+
+class SysCulling
+{
+public:
+
+    /**
+     * @brief Extract frustum planes from a combined projection * view matrix
+     *
+     * Expects OpenGL-style clip space, where -w <= z <= w.
+     */
+    static Frustum frustum_from_view_proj(Matrix4 const& viewProj) noexcept;
+
+    /**
+     * @brief Calculate a bounding sphere that contains all given points
+     *
+     * Uses the center of the axis-aligned bounding box; not minimal, but cheap and good enough
+     * for culling. Intended to be called once per mesh, e.g. with MeshData positions.
+     */
+    static BoundingSphere sphere_from_points(Corrade::Containers::StridedArrayView1D<Vector3 const> points) noexcept;
+
+    /**
+     * @brief Test if a sphere overlaps a frustum, for things that aren't DrawEnts
+     *
+     * Spheres with a negative radius (unknown bounds) always pass.
+     */
+    [[nodiscard]] static bool sphere_in_frustum(Frustum const& frustum, BoundingSphere const& sphere) noexcept;
+
+    /**
+     * @brief Write DrawEnts of visibleIn that overlap the frustum into rVisibleOut
+     *
+     * @param frustum       [in] View frustum to test against
+     * @param visibleIn     [in] DrawEnts to test, usually ACtxSceneRender::m_visible
+     * @param bounds        [in] Local-space bounding spheres of DrawEnts
+     * @param drawTf        [in] Draw transforms of DrawEnts
+     * @param rScratch      [ref] Scratch buffers
+     * @param rVisibleOut   [out] Cleared then filled with DrawEnts that should be drawn
+     *
+     * @return Number of DrawEnts culled
+     */
+    static std::size_t cull(
+            Frustum const&                              frustum,
+            lgrn::IdSetStl<DrawEnt> const&              visibleIn,
+            DrawEntBounds_t const&                      bounds,
+            AlignedKeyedVec<DrawEnt, Matrix4> const&    drawTf,
+            CullScratch&                                rScratch,
+            lgrn::IdSetStl<DrawEnt>&                    rVisibleOut) noexcept;
+
+    /**
+     * @brief Build a depth pyramid from a depth buffer, reusing its allocations
+     *
+     * @param rPyramid  [out] Pyramid to overwrite
+     * @param depth     [in] Window-space depth, indexed [y][x] with the bottom row first
+     * @param viewProj  [in] Projection * view matrix the depth was rendered with
+     */
+    static void build_depth_pyramid(
+            DepthPyramid&                                           rPyramid,
+            Corrade::Containers::StridedArrayView2D<float const>    depth,
+            Matrix4 const&                                          viewProj) noexcept;
+
+    /**
+     * @brief Remove DrawEnts hidden behind what's in a depth pyramid from rVisible
+     *
+     * Intended to run right after cull, reusing the world-space spheres it left in rScratch.
+     * Bounds are projected with the pyramid's own view-projection, so a pyramid built from the
+     * previous frame's depth works as long as the camera moves little between frames. DrawEnts
+     * that are near the camera or leave the pyramid's viewport are kept.
+     *
+     * @param pyramid   [in] Depth to test against; nothing is culled if it's empty
+     * @param scratch   [in] Scratch buffers from the cull call that wrote rVisible
+     * @param rVisible  [ref] DrawEnts that passed cull, occluded ones are erased
+     *
+     * @return Number of DrawEnts culled
+     */
+    static std::size_t occlusion_cull(
+            DepthPyramid const&                         pyramid,
+            CullScratch const&                          scratch,
+            lgrn::IdSetStl<DrawEnt>&                    rVisible) noexcept;
+
+    /**
+     * @brief Choose the level of detail of visible DrawEnts with ACtxSceneRender::m_lods
+     *
+     * Intended to run right after cull, on its output. Results are written to
+     * MeshLods::m_current; see SysRenderGL::sync_drawent_lods to apply them.
+     *
+     * @param rScnRender    [ref] Scene render state with bounds, draw transforms and LODs
+     * @param visible       [in] DrawEnts to update, usually ACtxSceneRender::m_visibleCulled
+     * @param view          [in] Camera view matrix
+     * @param projScaleY    [in] Vertical scale of the projection matrix, proj[1][1]
+     */
+    static void select_lods(
+            ACtxSceneRender&                rScnRender,
+            lgrn::IdSetStl<DrawEnt> const&  visible,
+            Matrix4 const&                  view,
+            float                           projScaleY) noexcept;
+
+    /**
+     * @brief Write the size on screen of visible DrawEnts to ACtxSceneRender::m_screenSize
+     *
+     * Same measure as select_lods: bounding sphere diameter relative to the viewport height.
+     * DrawEnts without bounds get a negative size. Used to pick texture mip levels, see
+     * SysRenderGL::estimate_texture_mips.
+     *
+     * @param rScnRender    [ref] Scene render state with bounds and draw transforms
+     * @param visible       [in] DrawEnts to update, usually ACtxSceneRender::m_visibleCulled
+     * @param view          [in] Camera view matrix
+     * @param projScaleY    [in] Vertical scale of the projection matrix, proj[1][1]
+     */
+    static void screen_sizes(
+            ACtxSceneRender&                rScnRender,
+            lgrn::IdSetStl<DrawEnt> const&  visible,
+            Matrix4 const&                  view,
+            float                           projScaleY) noexcept;
+};
+
+} // namespace osp::draw
@@ -24,11 +24,14 @@
  */
 #pragma once
 
+#include "culling.h"
 #include "draw_ent.h"
 
 #include "../core/copymove_macros.h"
 #include "../core/id_map.h"
 #include "../core/keyed_vector.h"
+#include "../core/memory_usage.h"
+#include "../core/paged_keyed_vector.h"
 #include "../core/math_types.h"
 #include "../core/resourcetypes.h"
 #include "../core/storage.h"
@@ -43,16 +46,24 @@
 #include <longeron/id_management/registry_stl.hpp>
 #include <longeron/id_management/id_set_stl.hpp>
 
+#include <algorithm>
+#include <array>
+
 namespace osp::draw
 {
 
-using DrawEntVec_t  = std::vector<DrawEnt>;
-using DrawEntSet_t  = lgrn::IdSetStl<DrawEnt>;
+using DrawEntVec_t    = std::vector<DrawEnt>;
+using DrawEntSet_t    = lgrn::IdSetStl<DrawEnt>;
+using ActiveToDraw_t  = PagedKeyedVec<active::ActiveEnt, DrawEnt>;
 
 struct Material
 {
     DrawEntSet_t m_ents;
     DrawEntVec_t m_dirty;
+
+    /// m_ents densely packed for iteration, kept up to date by SysRender::update_material_list
+    DrawEntVec_t                    m_list;
+    IdMap_t<DrawEnt, std::uint32_t> m_listIndex;
 };
 
 /**
@@ -110,27 +121,102 @@ struct ACtxDrawingRes
     IdMap_t<MeshId, ResIdOwner_t>           m_meshToRes;
 };
 
+/**
+ * @brief Less detailed meshes to switch to as a DrawEnt gets smaller on screen
+ *
+ * ACtxSceneRender::m_mesh is level 0, the most detailed. Levels are selected by
+ * SysCulling::select_lods using the DrawEnt's ACtxSceneRender::m_bounds.
+ */
+struct MeshLods
+{
+    static constexpr std::size_t smc_maxLevels = 4;
+
+    /// Meshes for levels 1 to m_count, each less detailed than the last
+    std::array<MeshIdOwner_t, smc_maxLevels>    m_meshes;
+
+    /// Use level i+1 once the projected diameter is below m_maxScreenSize[i] of the viewport height
+    std::array<float, smc_maxLevels>            m_maxScreenSize{};
+
+    std::uint8_t                                m_count{0};
+
+    /// Level chosen by the last SysCulling::select_lods
+    std::uint8_t                                m_current{0};
+};
+
 using DrawEntColors_t = KeyedVec<DrawEnt, Magnum::Color4>;
 using DrawEntTextures_t = KeyedVec<DrawEnt, TexIdOwner_t>;
-using DrawTransforms_t = KeyedVec<DrawEnt, Matrix4>;
+using DrawTransforms_t = AlignedKeyedVec<DrawEnt, Matrix4>;
+
+/**
+ * @brief World transforms of scene graph entities by TreePos_t, kept between frames so
+ *        unchanged subtrees can be skipped
+ */
+struct TreeWorldTransforms
+{
+    KeyedVec<active::TreePos_t, Matrix4>    m_worldTf;
+
+    /// Non-zero if m_worldTf is up to date for a tree position
+    KeyedVec<active::TreePos_t, uint8_t>    m_valid;
+
+    /// ACtxSceneGraph::m_treeVersion that m_valid refers to
+    uint32_t                                m_treeVersion{~uint32_t(0)};
+
+    /// Number of entities recalculated and skipped by the last update, for profiling
+    std::size_t                             m_lastUpdated{0};
+    std::size_t                             m_lastSkipped{0};
+};
 
 struct ACtxSceneRender
 {
     ACtxSceneRender() = default;
     OSP_MOVE_ONLY_CTOR_ASSIGN(ACtxSceneRender);
 
+    /// DrawEnt containers are sized in multiples of this, keeping DrawEntSet_t word-aligned
+    static constexpr std::size_t smc_drawPageSize = 256;
+
+    /**
+     * @brief Grow m_drawCapacity to fit m_drawIds.capacity(), with headroom
+     *
+     * Grows by at least half each time, so a steady stream of new DrawEnts only reallocates
+     * containers O(log n) times instead of on every frame that adds some.
+     *
+     * @return True if m_drawCapacity changed, and containers need resize_draw
+     */
+    bool grow_draw_capacity() noexcept
+    {
+        std::size_t const required = m_drawIds.capacity();
+        if (required <= m_drawCapacity)
+        {
+            return false;
+        }
+
+        std::size_t const grown = std::max(required, m_drawCapacity + m_drawCapacity / 2);
+        m_drawCapacity = (grown + smc_drawPageSize - 1) / smc_drawPageSize * smc_drawPageSize;
+        return true;
+    }
+
+    /**
+     * @brief Resize all containers indexed by DrawEnt to m_drawCapacity, growing it if needed
+     *
+     * Materials created afterwards must resize their m_ents to m_drawCapacity themselves.
+     */
     void resize_draw()
     {
-        std::size_t const size = m_drawIds.capacity();
+        grow_draw_capacity();
+        std::size_t const size = m_drawCapacity;
 
         m_opaque.resize(size);
         m_transparent.resize(size);
         m_visible.resize(size);
+        m_visibleCulled.resize(size);
+        m_drawDeleted.resize(size);
 
         m_drawTransform .resize(size);
         m_color         .resize(size, {1.0f, 1.0f, 1.0f, 1.0f}); // Default white
         m_diffuseTex    .resize(size);
         m_mesh          .resize(size);
+        m_bounds        .resize(size);
+        m_screenSize    .resize(size, -1.0f);
 
         for (MaterialId matId : m_materialIds)
         {
@@ -147,17 +233,34 @@ struct ACtxSceneRender
 
     lgrn::IdRegistryStl<DrawEnt>            m_drawIds;
 
+    /// Size of containers indexed by DrawEnt, at least m_drawIds.capacity(). See resize_draw
+    std::size_t                             m_drawCapacity{0};
+
     DrawEntSet_t                            m_opaque;
     DrawEntSet_t                            m_transparent;
     DrawEntSet_t                            m_visible;
+
+    /// Subset of m_visible that overlaps the camera frustum, written by SysCulling::cull
+    DrawEntSet_t                            m_visibleCulled;
+
+    /// DrawEnts being deleted this frame, mirrors the DrawEnt delete vector
+    DrawEntSet_t                            m_drawDeleted;
+    CullScratch                             m_cullScratch;
+
+    /// Depth of the last frame for SysCulling::occlusion_cull, empty if it isn't used
+    DepthPyramid                            m_depthPyramid;
     DrawEntColors_t                         m_color;
 
     active::ActiveEntSet_t                  m_needDrawTf;
-    KeyedVec<active::ActiveEnt, DrawEnt>    m_activeToDraw;
+    /// Paged so ActiveEnt growth doesn't move existing entries, see PagedKeyedVec
+    ActiveToDraw_t                          m_activeToDraw;
 
     KeyedVec<active::ActiveEnt, uint16_t>   drawTfObserverEnable;
     DrawTransforms_t                        m_drawTransform;
 
+    /// World transforms in scene graph order, written by SysRender::update_draw_transforms_linear
+    TreeWorldTransforms                     m_treeWorldTf;
+
     // Meshes and textures assigned to DrawEnts
     KeyedVec<DrawEnt, TexIdOwner_t>         m_diffuseTex;
     DrawEntVec_t                            m_diffuseDirty;
@@ -165,6 +268,16 @@ struct ACtxSceneRender
     KeyedVec<DrawEnt, MeshIdOwner_t>        m_mesh;
     DrawEntVec_t                            m_meshDirty;
 
+    /// Local-space bounds of m_mesh. Unset (negative radius) bounds are never culled.
+    DrawEntBounds_t                         m_bounds;
+
+    /// Bounds diameter relative to viewport height, written by SysCulling::screen_sizes for
+    /// visible DrawEnts only. Negative if unknown.
+    KeyedVec<DrawEnt, float>                m_screenSize;
+
+    /// Optional levels of detail, for DrawEnts that have them
+    IdMap_t<DrawEnt, MeshLods>              m_lods;
+
     lgrn::IdRegistryStl<MaterialId>         m_materialIds;
     KeyedVec<MaterialId, Material>          m_materials;
 };
@@ -178,6 +291,10 @@ struct Camera
     float   m_aspectRatio   { 1.0f };
     Deg     m_fov           { 45.0f };
 
+    /// Added to m_fov for culling, so that turning the camera after culling (late latching)
+    /// doesn't reveal missing DrawEnts at the edges
+    Deg     m_cullMargin    { 0.0f };
+
     constexpr void set_aspect_ratio(Vector2 const viewport) noexcept
     {
         m_aspectRatio = viewport.x() / viewport.y();
@@ -187,7 +304,66 @@ struct Camera
     {
         return Matrix4::perspectiveProjection(m_fov, m_aspectRatio, m_near, m_far);
     }
+
+    [[nodiscard]] Matrix4 cull_perspective() const noexcept
+    {
+        return Matrix4::perspectiveProjection(m_fov + m_cullMargin, m_aspectRatio, m_near, m_far);
+    }
 };
 
 } // namespace osp::draw
 
+namespace osp
+{
+
+template <>
+struct MemoryUsage<draw::Material>
+{
+    static std::size_t heap_bytes(draw::Material const& mat) noexcept
+    {
+        return heap_bytes_sum(mat.m_dirty, mat.m_list, mat.m_listIndex);
+    }
+};
+
+template <>
+struct MemoryUsage<draw::ACtxSceneRender>
+{
+    static std::size_t heap_bytes(draw::ACtxSceneRender const& scnRender) noexcept
+    {
+        // DrawEnt sets are bitsets sized by resize_draw, 5 in the context and 1 per material
+        std::size_t const drawSetBytes  = (scnRender.m_drawCapacity + 7) / 8;
+        std::size_t const activeSetBytes = (scnRender.drawTfObserverEnable.size() + 7) / 8;
+
+        std::size_t depthBytes = 0;
+        for (draw::DepthPyramid::Level const& level : scnRender.m_depthPyramid.m_levels)
+        {
+            depthBytes += level.m_depth.capacity() * sizeof(float);
+        }
+
+        draw::CullScratch const &cull = scnRender.m_cullScratch;
+
+        return drawSetBytes * (5 + scnRender.m_materials.size()) + activeSetBytes + depthBytes
+             + heap_bytes_sum(
+                    scnRender.m_drawIds,
+                    cull.m_ents, cull.m_x, cull.m_y, cull.m_z, cull.m_radius, cull.m_inside,
+                    scnRender.m_depthPyramid.m_levels,
+                    scnRender.m_color,
+                    scnRender.m_activeToDraw,
+                    scnRender.drawTfObserverEnable,
+                    scnRender.m_drawTransform,
+                    scnRender.m_treeWorldTf.m_worldTf,
+                    scnRender.m_treeWorldTf.m_valid,
+                    scnRender.m_diffuseTex,
+                    scnRender.m_diffuseDirty,
+                    scnRender.m_mesh,
+                    scnRender.m_meshDirty,
+                    scnRender.m_bounds,
+                    scnRender.m_screenSize,
+                    scnRender.m_lods,
+                    scnRender.m_materialIds,
+                    scnRender.m_materials);
+    }
+};
+
+} // namespace osp
+
@@ -26,6 +26,7 @@
 #include "own_restypes.h"
 
 #include "../core/Resources.h"
+#include "../core/bitvector.h"
 
 using namespace osp;
 using namespace osp::active;
@@ -76,6 +77,84 @@ void SysRender::clear_owners(ACtxSceneRender& rCtxScnRdr, ACtxDrawing& rCtxDrawi
             rCtxDrawing.m_meshRefCounts.ref_release(std::move(rOwner));
         }
     }
+
+    for ([[maybe_unused]] auto && [_, rLods] : std::exchange(rCtxScnRdr.m_lods, {}))
+    {
+        for (MeshIdOwner_t &rOwner : rLods.m_meshes)
+        {
+            if (rOwner.has_value())
+            {
+                rCtxDrawing.m_meshRefCounts.ref_release(std::move(rOwner));
+            }
+        }
+    }
+}
+
+void SysRender::update_material_list(Material& rMat)
+{
+    for (DrawEnt const drawEnt : rMat.m_dirty)
+    {
+        bool const inMaterial =    std::size_t(drawEnt) < rMat.m_ents.size()
+                                && rMat.m_ents.contains(drawEnt);
+
+        if (inMaterial)
+        {
+            auto const [it, success] = rMat.m_listIndex.try_emplace(drawEnt, std::uint32_t(rMat.m_list.size()));
+            if (success)
+            {
+                rMat.m_list.push_back(drawEnt);
+            }
+        }
+        else
+        {
+            material_list_remove(rMat, drawEnt);
+        }
+    }
+}
+
+void SysRender::material_list_remove(Material& rMat, DrawEnt const drawEnt)
+{
+    auto const foundIt = rMat.m_listIndex.find(drawEnt);
+    if (foundIt == rMat.m_listIndex.end())
+    {
+        return;
+    }
+
+    // Swap with last
+    std::uint32_t const index = foundIt->second;
+    DrawEnt const last = rMat.m_list.back();
+    rMat.m_list[index] = last;
+    rMat.m_listIndex[last] = index;
+
+    rMat.m_list.pop_back();
+    rMat.m_listIndex.erase(drawEnt);
+}
+
+void SysRender::update_delete_materials(ACtxSceneRender& rCtxScnRdr, DrawEntSet_t const& deleted)
+{
+    auto const deletedWords = bit_words(deleted);
+
+    for (MaterialId const matId : rCtxScnRdr.m_materialIds)
+    {
+        Material &rMat = rCtxScnRdr.m_materials[matId];
+
+        // m_list is always a subset of m_ents
+        for (DrawEnt const drawEnt : bit_ones_and<DrawEnt>(bit_words(rMat.m_ents), deletedWords))
+        {
+            material_list_remove(rMat, drawEnt);
+        }
+
+        bit_andnot_assign(bit_words(rMat.m_ents), deletedWords);
+    }
+}
+
+void SysRender::apply_group_writes(RenderGroup::DrawEnts_t& rStorage, RenderGroupWrites& rWrites)
+{
+    for (auto &[drawEnt, value] : rWrites.changes)
+    {
+        storage_assign(rStorage, drawEnt, std::move(value));
+    }
+    rWrites.changes.clear();
 }
 
 void SysRender::clear_resource_owners(ACtxDrawingRes& rCtxDrawingRes, Resources &rResources)
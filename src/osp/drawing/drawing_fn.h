@@ -29,6 +29,15 @@
 #include "../activescene/basic.h"
 #include "../activescene/basic_fn.h"
 
+#include "../core/math_affine.h"
+#include "../core/parallel_for.h"
+#include "../util/profiling.h"
+
+#include <algorithm>
+#include <optional>
+#include <utility>
+#include <vector>
+
 namespace osp::draw
 {
 
@@ -64,18 +73,57 @@ struct DrawTfObservers
 
 /**
  * @brief View and Projection matrix
+ *
+ * For camera-relative rendering, use model_view or origin_relative instead of multiplying with
+ * m_view or m_viewProj. Those subtract the camera position from the model's translation before
+ * rotating into view space. view * model instead cancels out two large translations in float,
+ * so everything near the camera jitters once it's far from the scene origin.
  */
 struct ViewProjMatrix
 {
     ViewProjMatrix(Matrix4 const& view, Matrix4 const& proj)
+     : ViewProjMatrix{view, proj, view.inverted().translation()}
+    { }
+
+    /**
+     * @param origin    [in] Camera position; same as view.inverted().translation(), but exact
+     */
+    ViewProjMatrix(Matrix4 const& view, Matrix4 const& proj, Vector3 const& origin)
      : m_viewProj{proj * view}
      , m_view{view}
      , m_proj{proj}
+     , m_origin{origin}
+     , m_viewRotation{Matrix4::from(view.rotationScaling(), {})}
+     , m_viewProjRotation{proj * m_viewRotation}
     { }
 
+    /**
+     * @brief Model matrix translated so the camera is at the origin, for m_viewRotation
+     */
+    [[nodiscard]] Matrix4 origin_relative(Matrix4 model) const noexcept
+    {
+        model.translation() -= m_origin;
+        return model;
+    }
+
+    /**
+     * @brief Camera-relative equivalent of m_view * model
+     */
+    [[nodiscard]] Matrix4 model_view(Matrix4 const& model) const noexcept
+    {
+        return m_viewRotation * origin_relative(model);
+    }
+
     Matrix4 m_viewProj;
     Matrix4 m_view;
     Matrix4 m_proj;
+
+    /// Camera position that origin_relative subtracts
+    Vector3 m_origin;
+
+    /// m_view and m_viewProj without the camera translation, for origin_relative matrices
+    Matrix4 m_viewRotation;
+    Matrix4 m_viewProjRotation;
 };
 
 /**
@@ -110,14 +158,63 @@ struct EntityToDraw
  *
  * This also works with game-specific modes like Thermal Imaging.
  */
+/**
+ * @brief Stores a draw function that draws many entities at once, such as with GPU instancing
+ *
+ * The entities drawn are tracked by the shader's own data instead of RenderGroup::entities.
+ */
+struct InstancedToDraw
+{
+    using UserData_t = std::array<void*, 4>;
+
+    /**
+     * @brief A function pointer to a Shader's instanced draw function
+     *
+     * @param DrawEntSet_t      [in] Entities allowed to be drawn
+     * @param ViewProjMatrix    [in] View and projection matrix
+     * @param UserData_t        [in] Non-owning user data
+     */
+    using ShaderDrawFnc_t = void (*)(
+            DrawEntSet_t const&, ViewProjMatrix const&, UserData_t) noexcept;
+
+    ShaderDrawFnc_t draw;
+
+    // Non-owning user data passed to draw function, such as the shader
+    UserData_t data;
+
+}; // struct InstancedToDraw
+
 struct RenderGroup
 {
     using DrawEnts_t = Storage_t<DrawEnt, EntityToDraw>;
 
     DrawEnts_t entities;
 
+    std::vector<InstancedToDraw> instanced;
+
 }; // struct RenderGroup
 
+/**
+ * @brief Changes to RenderGroup::entities, recorded to be applied all at once later
+ *
+ * Each shader syncs its DrawEnts into its own RenderGroupWrites instead of into the shared
+ * RenderGroup, so shaders of different materials can sync in parallel.
+ * See SysRender::apply_group_writes.
+ */
+struct RenderGroupWrites
+{
+    /**
+     * @brief Record an emplace or reassign (value), or a remove (std::nullopt)
+     */
+    void assign(DrawEnt const ent, std::optional<EntityToDraw> value)
+    {
+        changes.emplace_back(ent, std::move(value));
+    }
+
+    std::vector< std::pair<DrawEnt, std::optional<EntityToDraw>> > changes;
+
+}; // struct RenderGroupWrites
+
 class SysRender
 {
     struct UpdDrawTransformNoOp
@@ -154,6 +251,38 @@ public:
      */
     static void clear_owners(ACtxSceneRender& rCtxScnRdr, ACtxDrawing& rCtxDrawing);
 
+    /**
+     * @brief Add or remove DrawEnts in Material::m_dirty to/from Material::m_list, matching m_ents
+     *
+     * Only touches dirty DrawEnts, so the cost doesn't depend on DrawEnt capacity. Safe to call
+     * more than once with the same m_dirty.
+     */
+    static void update_material_list(Material& rMat);
+
+    /**
+     * @brief Remove a DrawEnt from Material::m_list, if present. Does not modify m_ents.
+     */
+    static void material_list_remove(Material& rMat, DrawEnt drawEnt);
+
+    /**
+     * @brief Remove deleted DrawEnts from every material's m_ents and m_list
+     *
+     * Each material is handled with one word-parallel pass over its m_ents, instead of one lookup
+     * per material per deleted DrawEnt.
+     *
+     * @param rCtxScnRdr    [ref] Scene render data, only materials are modified
+     * @param deleted       [in] DrawEnts to remove, usually ACtxSceneRender::m_drawDeleted
+     */
+    static void update_delete_materials(ACtxSceneRender& rCtxScnRdr, DrawEntSet_t const& deleted);
+
+    /**
+     * @brief Apply and clear changes recorded by shader syncs, in the order they were recorded
+     *
+     * @param rStorage      [ref] RenderGroup entities to modify
+     * @param rWrites       [ref] Changes to apply, cleared afterwards
+     */
+    static void apply_group_writes(RenderGroup::DrawEnts_t& rStorage, RenderGroupWrites& rWrites);
+
     /**
      * @brief Dissociate resources from the scene's meshes and textures
      *
@@ -173,9 +302,19 @@ public:
     {
         active::ACtxSceneGraph const&               scnGraph;
         active::ACompTransformStorage_t const&      transforms;
-        KeyedVec<active::ActiveEnt, DrawEnt> const& activeToDraw;
+        ActiveToDraw_t const&                       activeToDraw;
         active::ActiveEntSet_t const&               needDrawTf;
         DrawTransforms_t&                           rDrawTf;
+
+        /// Only used by update_draw_transforms_linear. If given, entities that aren't dirty (and
+        /// have no dirty ancestors) are skipped, and flags of visited entities are cleared.
+        KeyedVec<active::ActiveEnt, uint8_t>*       pTfDirty{nullptr};
+    };
+
+    struct DrawTfStats
+    {
+        std::size_t updated{0};
+        std::size_t skipped{0};
     };
 
     template<typename IT_T, typename ITB_T, typename FUNC_T = UpdDrawTransformNoOp>
@@ -185,6 +324,35 @@ public:
             ITB_T const&                last,
             FUNC_T                      func = {});
 
+    /**
+     * @brief Calculate draw transforms of all entities in needDrawTf with a linear pass over the
+     *        scene graph, instead of recursing from each root
+     *
+     * World transforms are kept in rWorld in TreePos_t order, where each parent comes before its
+     * descendants. Subtrees of the root's children are independent, so they can be split across
+     * threads.
+     *
+     * If args.pTfDirty is given, entities are only recalculated if they or an ancestor are dirty,
+     * or their tree position changed since the last call. func is not called for skipped
+     * entities.
+     *
+     * @param rWorld        [ref] World transforms, resized to fit the scene graph
+     * @param parallelFor   [in] Splits subtrees across threads, such as a task's
+     *                           WorkerContext::m_parallelFor. func must be safe to call
+     *                           concurrently (for different entities) if it has more than 1.
+     *
+     * @return Number of entities recalculated and skipped, also stored in rWorld
+     */
+    template<typename FUNC_T = UpdDrawTransformNoOp>
+    static DrawTfStats update_draw_transforms_linear(
+            ArgsForUpdDrawTransform                 args,
+            TreeWorldTransforms&                    rWorld,
+            ParallelFor const&                      parallelFor = {},
+            FUNC_T                                  func = {});
+
+    /// Scene graphs smaller than this are not split across threads
+    static constexpr std::size_t smc_drawTfMinEntsPerThread = 256;
+
     template<typename IT_T>
     static void update_delete_drawing(
             ACtxSceneRender& rCtxScnRdr, ACtxDrawing& rCtxDrawing, IT_T const& first, IT_T const& last);
@@ -195,6 +363,14 @@ public:
 
 private:
 
+    template<typename FUNC_T>
+    static DrawTfStats update_draw_transforms_range(
+            ArgsForUpdDrawTransform     args,
+            TreeWorldTransforms&        rWorld,
+            active::TreePos_t           first,
+            active::TreePos_t           last,
+            FUNC_T&                     func);
+
     template<typename FUNC_T>
     static void update_draw_transforms_recurse(
             ArgsForUpdDrawTransform     args,
@@ -228,6 +404,8 @@ void SysRender::update_draw_transforms(
         ITB_T const&                last,
         FUNC_T                      func)
 {
+    OSP_PROFILE_ZONE("SysRender::update_draw_transforms");
+
     static constexpr Matrix4 const identity{};
 
     while (first != last)
@@ -254,7 +432,7 @@ void SysRender::update_draw_transforms_recurse(
     using namespace osp::active;
 
     Matrix4 const& entTf        = args.transforms.get(ent).m_transform;
-    Matrix4 const& entDrawTf    = (depth == 0) ? (entTf) : (parentTf * entTf);
+    Matrix4 const  entDrawTf    = (depth == 0) ? (entTf) : math::affine_multiply(parentTf, entTf);
 
     func(entDrawTf, ent, depth);
 
@@ -273,6 +451,158 @@ void SysRender::update_draw_transforms_recurse(
     }
 }
 
+template<typename FUNC_T>
+SysRender::DrawTfStats SysRender::update_draw_transforms_linear(
+        ArgsForUpdDrawTransform                 args,
+        TreeWorldTransforms&                    rWorld,
+        ParallelFor const&                      parallelFor,
+        FUNC_T                                  func)
+{
+    OSP_PROFILE_ZONE("SysRender::update_draw_transforms_linear");
+
+    using namespace osp::active;
+
+    // TreePos 0 is the root, which isn't an entity. Its children's subtrees follow.
+    TreePos_t const treeSize = TreePos_t(args.scnGraph.m_treeToEnt.size());
+    rWorld.m_worldTf.resize(treeSize);
+
+    // Tree positions moved around, so none of the old world transforms can be reused
+    if (rWorld.m_treeVersion != args.scnGraph.m_treeVersion || rWorld.m_valid.size() != treeSize)
+    {
+        rWorld.m_valid.assign(treeSize, 0);
+        rWorld.m_treeVersion = args.scnGraph.m_treeVersion;
+    }
+
+    std::size_t const maxThreads = std::max<std::size_t>(1, treeSize / smc_drawTfMinEntsPerThread);
+    std::size_t const useThreads = std::min<std::size_t>(parallelFor.m_threads, maxThreads);
+
+    DrawTfStats total;
+
+    if (useThreads == 1)
+    {
+        total = update_draw_transforms_range(args, rWorld, 1, treeSize, func);
+    }
+    else
+    {
+        // Split into ranges of whole root-child subtrees, each roughly treeSize / useThreads long
+        std::vector<TreePos_t> splits;
+        splits.reserve(useThreads + 1);
+        splits.push_back(1);
+
+        std::size_t const targetSize = treeSize / useThreads;
+        for (TreePos_t pos = 1; pos < treeSize; pos += args.scnGraph.m_treeDescendants[pos] + 1)
+        {
+            if (pos - splits.back() >= targetSize && splits.size() < useThreads)
+            {
+                splits.push_back(pos);
+            }
+        }
+        splits.push_back(treeSize);
+
+        std::size_t const ranges = splits.size() - 1;
+        std::vector<DrawTfStats> stats(ranges);
+        parallelFor(ranges, ranges, [args, &rWorld, &splits, &stats, &func] (std::size_t const first, std::size_t const last)
+        {
+            for (std::size_t i = first; i < last; ++i)
+            {
+                stats[i] = update_draw_transforms_range(args, rWorld, splits[i], splits[i + 1], func);
+            }
+        });
+
+        for (DrawTfStats const& rangeStats : stats)
+        {
+            total.updated += rangeStats.updated;
+            total.skipped += rangeStats.skipped;
+        }
+    }
+
+    rWorld.m_lastUpdated = total.updated;
+    rWorld.m_lastSkipped = total.skipped;
+    return total;
+}
+
+template<typename FUNC_T>
+SysRender::DrawTfStats SysRender::update_draw_transforms_range(
+        ArgsForUpdDrawTransform     args,
+        TreeWorldTransforms&        rWorld,
+        active::TreePos_t const     first,
+        active::TreePos_t const     last,
+        FUNC_T&                     func)
+{
+    OSP_PROFILE_ZONE("SysRender::update_draw_transforms_range");
+
+    using namespace osp::active;
+
+    // Ancestors of the current position; parent is at the back
+    struct Ancestor
+    {
+        TreePos_t   pos;
+        TreePos_t   end;
+        bool        updated;
+    };
+    std::vector<Ancestor> ancestors;
+
+    DrawTfStats stats;
+
+    TreePos_t pos = first;
+    while (pos < last)
+    {
+        while ( ! ancestors.empty() && pos >= ancestors.back().end )
+        {
+            ancestors.pop_back();
+        }
+
+        ActiveEnt const ent         = args.scnGraph.m_treeToEnt[pos];
+        uint32_t const  descendants = args.scnGraph.m_treeDescendants[pos];
+
+        if ( ! args.needDrawTf.contains(ent) )
+        {
+            // Subtree's world transforms aren't kept up to date from here
+            std::fill_n(rWorld.m_valid.begin() + pos, descendants + 1, uint8_t(0));
+            pos += descendants + 1;
+            continue;
+        }
+
+        bool const parentUpdated = ! ancestors.empty() && ancestors.back().updated;
+        bool const dirty         = (args.pTfDirty == nullptr) || (*args.pTfDirty)[ent] != 0;
+        bool const update        = dirty || parentUpdated || rWorld.m_valid[pos] == 0;
+
+        if (update)
+        {
+            Matrix4 const& entTf = args.transforms.get(ent).m_transform;
+            Matrix4 &rEntDrawTf  = rWorld.m_worldTf[pos];
+            rEntDrawTf = ancestors.empty() ? entTf : math::affine_multiply(rWorld.m_worldTf[ancestors.back().pos], entTf);
+            rWorld.m_valid[pos] = 1;
+
+            // Depth starts at 1 for the root's children, same as update_draw_transforms
+            func(static_cast<Matrix4 const&>(rEntDrawTf), ent, int(ancestors.size()) + 1);
+
+            DrawEnt const drawEnt = args.activeToDraw[ent];
+            if (drawEnt != lgrn::id_null<DrawEnt>())
+            {
+                args.rDrawTf[drawEnt] = rEntDrawTf;
+            }
+            ++stats.updated;
+        }
+        else
+        {
+            ++stats.skipped;
+        }
+
+        if (args.pTfDirty != nullptr)
+        {
+            (*args.pTfDirty)[ent] = 0;
+        }
+
+        if (descendants != 0)
+        {
+            ancestors.push_back({pos, pos + descendants + 1, update});
+        }
+        ++pos;
+    }
+
+    return stats;
+}
 
 template<typename STORAGE_T, typename REFCOUNT_T>
 void remove_refcounted(
@@ -295,6 +625,20 @@ void SysRender::update_delete_drawing(
 
         remove_refcounted(drawEnt, rCtxScnRdr.m_diffuseTex, rCtxDrawing.m_texRefCounts);
         remove_refcounted(drawEnt, rCtxScnRdr.m_mesh,       rCtxDrawing.m_meshRefCounts);
+        rCtxScnRdr.m_bounds[drawEnt] = {};
+
+        if (auto const foundIt = rCtxScnRdr.m_lods.find(drawEnt);
+            foundIt != rCtxScnRdr.m_lods.end())
+        {
+            for (MeshIdOwner_t &rOwner : foundIt->second.m_meshes)
+            {
+                if (rOwner.has_value())
+                {
+                    rCtxDrawing.m_meshRefCounts.ref_release(std::move(rOwner));
+                }
+            }
+            rCtxScnRdr.m_lods.erase(foundIt);
+        }
     }
 }
 
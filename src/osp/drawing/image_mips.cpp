@@ -0,0 +1,124 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "image_mips.h"
+
+#include <Magnum/PixelFormat.h>
+#include <Magnum/Math/Functions.h>
+
+#include <Corrade/Containers/StridedArrayView.h>
+
+#include <algorithm>
+
+using Magnum::PixelFormat;
+using Magnum::PixelStorage;
+using Magnum::Trade::ImageData2D;
+
+using Corrade::Containers::Array;
+using Corrade::Containers::StridedArrayView3D;
+
+int osp::mip_level_count(Vector2i const size) noexcept
+{
+    int levels = 1;
+    for (int extent = std::max(size.x(), size.y()); extent > 1; extent /= 2)
+    {
+        ++levels;
+    }
+    return levels;
+}
+
+bool osp::mip_chain_supported(ImageData2D const& image) noexcept
+{
+    if (image.isCompressed())
+    {
+        return false;
+    }
+
+    switch (image.format())
+    {
+    case PixelFormat::R8Unorm:
+    case PixelFormat::RG8Unorm:
+    case PixelFormat::RGB8Unorm:
+    case PixelFormat::RGBA8Unorm:
+    case PixelFormat::R8Srgb:
+    case PixelFormat::RG8Srgb:
+    case PixelFormat::RGB8Srgb:
+    case PixelFormat::RGBA8Srgb:
+        return true;
+    default:
+        return false;
+    }
+}
+
+osp::ImageMipChain osp::make_mip_chain(ImageData2D const& image)
+{
+    ImageMipChain out;
+
+    if ( ! mip_chain_supported(image) )
+    {
+        return out;
+    }
+
+    int const levels = mip_level_count(image.size());
+    out.m_levels.reserve(std::size_t(std::max(levels - 1, 0)));
+
+    // [y][x][channel] bytes of the level being downsampled
+    StridedArrayView3D<char const> src = image.pixels();
+    Vector2i srcSize = image.size();
+
+    for (int level = 1; level < levels; ++level)
+    {
+        Vector2i const    size      = Magnum::Math::max(srcSize / 2, Vector2i{1});
+        std::size_t const channels  = src.size()[2];
+
+        Array<char> data{Corrade::NoInit, std::size_t(size.product()) * channels};
+
+        for (int y = 0; y < size.y(); ++y)
+        {
+            std::size_t const y0 = std::size_t(std::min(y * 2,     srcSize.y() - 1));
+            std::size_t const y1 = std::size_t(std::min(y * 2 + 1, srcSize.y() - 1));
+            for (int x = 0; x < size.x(); ++x)
+            {
+                std::size_t const x0 = std::size_t(std::min(x * 2,     srcSize.x() - 1));
+                std::size_t const x1 = std::size_t(std::min(x * 2 + 1, srcSize.x() - 1));
+                char *pOut = data.data() + (std::size_t(y) * std::size_t(size.x()) + std::size_t(x)) * channels;
+                for (std::size_t c = 0; c < channels; ++c)
+                {
+                    unsigned const sum = unsigned(static_cast<unsigned char>(src[y0][x0][c]))
+                                       + unsigned(static_cast<unsigned char>(src[y0][x1][c]))
+                                       + unsigned(static_cast<unsigned char>(src[y1][x0][c]))
+                                       + unsigned(static_cast<unsigned char>(src[y1][x1][c]));
+                    pOut[c] = static_cast<char>((sum + 2) / 4);
+                }
+            }
+        }
+
+        ImageData2D &rLevel = out.m_levels.emplace_back(
+                PixelStorage{}.setAlignment(1), image.format(), size, std::move(data));
+        src     = rLevel.pixels();
+        srcSize = size;
+    }
+
+    return out;
+}
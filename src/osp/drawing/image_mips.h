@@ -0,0 +1,74 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+/**
+ * @file
+ * @brief CPU-side mip chains of image resources, used to stream texture mip levels
+ */
+#pragma once
+
+#include "../core/math_types.h"
+
+#include <Magnum/Trade/ImageData.h>
+
+#include <vector>
+
+namespace osp
+{
+
+/**
+ * @brief Mip levels 1 and onwards of an ImageData2D resource, stored next to it on gc_image
+ *
+ * Level n is half the size of level n - 1 per axis, rounded down but at least 1. Levels are
+ * tightly packed (alignment 1), and may be views into a memory-mapped asset cache.
+ */
+struct ImageMipChain
+{
+    std::vector<Magnum::Trade::ImageData2D> m_levels;
+};
+
+/**
+ * @return Number of mip levels down to 1x1, including level 0
+ */
+[[nodiscard]] int mip_level_count(Vector2i size) noexcept;
+
+/**
+ * @brief Check if make_mip_chain can downsample an image
+ *
+ * Only uncompressed formats with 8-bit normalized channels are supported. Compressed images,
+ * such as transcoded Basis images, are uploaded without streaming.
+ */
+[[nodiscard]] bool mip_chain_supported(Magnum::Trade::ImageData2D const& image) noexcept;
+
+/**
+ * @brief Downsample an image into all of its mip levels with a 2x2 box filter
+ *
+ * sRGB channels are averaged as-is, which is slightly darker than averaging linear values but
+ * good enough for textures seen from afar.
+ *
+ * @return Levels 1 and onwards, empty if unsupported or the image is already 1x1
+ */
+[[nodiscard]] ImageMipChain make_mip_chain(Magnum::Trade::ImageData2D const& image);
+
+} // namespace osp
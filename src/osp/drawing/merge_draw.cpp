@@ -0,0 +1,244 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "merge_draw.h"
+#include "drawing_fn.h"
+
+#include "../activescene/basic_fn.h"
+#include "../core/Resources.h"
+
+#include <Magnum/MeshTools/Concatenate.h>
+#include <Magnum/MeshTools/Transform.h>
+#include <Magnum/Trade/MeshData.h>
+
+#include <Corrade/Containers/Iterable.h>
+
+#include <string>
+
+using Magnum::Trade::MeshData;
+using Magnum::MeshPrimitive;
+
+using namespace osp;
+using namespace osp::active;
+using namespace osp::draw;
+
+namespace
+{
+
+/// DrawEnts that can be drawn together, as they only differ by mesh
+struct MergeGroup
+{
+    MaterialId              material;
+    TexId                   diffuse;
+    Magnum::Color4          color;
+
+    std::vector<DrawEnt>    drawEnts;
+
+    /// Transform of each of drawEnts' ActiveEnt relative to the subtree root
+    std::vector<Matrix4>    toRoot;
+};
+
+Matrix4 transform_to_root(ACtxBasic const& rBasic, ActiveEnt ent, ActiveEnt const root)
+{
+    Matrix4 out;
+    while (ent != root)
+    {
+        if (rBasic.m_transform.contains(ent))
+        {
+            out = rBasic.m_transform.get(ent).m_transform * out;
+        }
+        ent = rBasic.m_scnGraph.m_entParent[ent];
+    }
+    return out;
+}
+
+bool same_attributes(MeshData const& a, MeshData const& b)
+{
+    if (a.attributeCount() != b.attributeCount())
+    {
+        return false;
+    }
+    for (Magnum::UnsignedInt i = 0; i < a.attributeCount(); ++i)
+    {
+        if (   a.attributeName(i)   != b.attributeName(i)
+            || a.attributeFormat(i) != b.attributeFormat(i))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+MergedDraw SysMergeDraw::merge(
+        ACtxSceneRender&            rScnRender,
+        ACtxDrawing&                rDrawing,
+        ACtxDrawingRes&             rDrawingRes,
+        Resources&                  rResources,
+        ACtxBasic const&            rBasic,
+        ActiveEnt const             root,
+        PkgId const                 pkg,
+        std::string_view const      name)
+{
+    std::vector<MergeGroup> groups;
+
+    auto const add_drawent = [&] (ActiveEnt const ent)
+    {
+        if (std::size_t(ent) >= rScnRender.m_activeToDraw.size())
+        {
+            return;
+        }
+        DrawEnt const drawEnt = rScnRender.m_activeToDraw[ent];
+        if (   drawEnt == lgrn::id_null<DrawEnt>()
+            || ! rScnRender.m_visible.contains(drawEnt)
+            || ! rScnRender.m_opaque.contains(drawEnt)
+            || ! rScnRender.m_mesh[drawEnt].has_value()
+            || rScnRender.m_lods.contains(drawEnt))
+        {
+            return;
+        }
+
+        MaterialId material = lgrn::id_null<MaterialId>();
+        for (MaterialId const matId : rScnRender.m_materialIds)
+        {
+            if (rScnRender.m_materials[matId].m_ents.contains(drawEnt))
+            {
+                material = matId;
+                break;
+            }
+        }
+
+        TexIdOwner_t const& diffuseOwner = rScnRender.m_diffuseTex[drawEnt];
+        TexId const diffuse = diffuseOwner.has_value() ? diffuseOwner.value() : lgrn::id_null<TexId>();
+        Magnum::Color4 const& color = rScnRender.m_color[drawEnt];
+
+        auto groupIt = std::find_if(groups.begin(), groups.end(), [&] (MergeGroup const& group)
+        {
+            return group.material == material && group.diffuse == diffuse && group.color == color;
+        });
+        if (groupIt == groups.end())
+        {
+            groupIt = groups.insert(groups.end(), MergeGroup{material, diffuse, color, {}, {}});
+        }
+        groupIt->drawEnts.push_back(drawEnt);
+        groupIt->toRoot  .push_back(transform_to_root(rBasic, ent, root));
+    };
+
+    add_drawent(root);
+    for (ActiveEnt const ent : SysSceneGraph::descendants(rBasic.m_scnGraph, root))
+    {
+        add_drawent(ent);
+    }
+
+    MergedDraw out;
+    std::vector<MeshData> transformed;
+
+    for (MergeGroup const& group : groups)
+    {
+        if (group.drawEnts.size() < 2)
+        {
+            continue; // Nothing to gain
+        }
+
+        DrawEnt const   batchEnt    = group.drawEnts[0];
+        Matrix4 const   rootToBatch = group.toRoot[0].inverted();
+
+        transformed.clear();
+        transformed.reserve(group.drawEnts.size());
+
+        bool compatible = true;
+        for (std::size_t i = 0; i < group.drawEnts.size() && compatible; ++i)
+        {
+            MeshId const    meshId  = rScnRender.m_mesh[group.drawEnts[i]].value();
+            ResId const     meshRes = rDrawingRes.m_meshToRes.at(meshId).value();
+            auto const      &mesh   = rResources.data_get<MeshData>(restypes::gc_mesh, meshRes);
+
+            if (mesh.primitive() != MeshPrimitive::Triangles || ! mesh.hasAttribute(Magnum::Trade::MeshAttribute::Position))
+            {
+                compatible = false;
+                break;
+            }
+
+            transformed.push_back(Magnum::MeshTools::transform3D(mesh, rootToBatch * group.toRoot[i]));
+            compatible = same_attributes(transformed.front(), transformed.back());
+        }
+
+        if ( ! compatible )
+        {
+            continue;
+        }
+
+        ResId const mergedRes = rResources.create(restypes::gc_mesh, pkg,
+                SharedString::create_from_parts(name, ":", std::to_string(out.batches.size())));
+        rResources.data_add<MeshData>(restypes::gc_mesh, mergedRes,
+                Magnum::MeshTools::concatenate(Corrade::Containers::ArrayView<MeshData const>{transformed.data(), transformed.size()}));
+        MeshId const mergedMesh = SysRender::own_mesh_resource(rDrawing, rDrawingRes, rResources, mergedRes);
+
+        // Merged meshes are bigger than the original, leave bounds unset so they're never culled
+        out.batches.push_back({
+            .drawEnt        = batchEnt,
+            .original       = std::exchange(rScnRender.m_mesh[batchEnt], rDrawing.m_meshRefCounts.ref_add(mergedMesh)),
+            .originalBounds = std::exchange(rScnRender.m_bounds[batchEnt], {})
+        });
+        rScnRender.m_meshDirty.push_back(batchEnt);
+
+        for (std::size_t i = 1; i < group.drawEnts.size(); ++i)
+        {
+            rScnRender.m_visible.erase(group.drawEnts[i]);
+            out.hidden.push_back(group.drawEnts[i]);
+        }
+    }
+
+    return out;
+}
+
+void SysMergeDraw::unmerge(
+        MergedDraw&                 rMerged,
+        ACtxSceneRender&            rScnRender,
+        ACtxDrawing&                rDrawing)
+{
+    for (MergedDraw::Batch &rBatch : rMerged.batches)
+    {
+        MeshIdOwner_t &rMesh = rScnRender.m_mesh[rBatch.drawEnt];
+        if (rMesh.has_value())
+        {
+            rDrawing.m_meshRefCounts.ref_release(std::move(rMesh));
+        }
+        rMesh = std::move(rBatch.original);
+        rScnRender.m_bounds[rBatch.drawEnt] = rBatch.originalBounds;
+        rScnRender.m_meshDirty.push_back(rBatch.drawEnt);
+    }
+
+    for (DrawEnt const drawEnt : rMerged.hidden)
+    {
+        if ( ! rScnRender.m_drawDeleted.contains(drawEnt) )
+        {
+            rScnRender.m_visible.insert(drawEnt);
+        }
+    }
+
+    rMerged.batches.clear();
+    rMerged.hidden.clear();
+}
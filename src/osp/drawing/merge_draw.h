@@ -0,0 +1,103 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "drawing.h"
+
+#include "../core/resourcetypes.h"
+
+#include <string_view>
+#include <vector>
+
+namespace osp::draw
+{
+
+/**
+ * @brief DrawEnts of a subtree folded into fewer draw calls by SysMergeDraw::merge
+ */
+struct MergedDraw
+{
+    struct Batch
+    {
+        /// DrawEnt that now draws the merged mesh
+        DrawEnt         drawEnt;
+
+        /// Mesh and bounds the DrawEnt had before merging, restored by SysMergeDraw::unmerge
+        MeshIdOwner_t   original;
+        BoundingSphere  originalBounds;
+    };
+
+    std::vector<Batch>      batches;
+
+    /// DrawEnts folded into a batch, hidden from m_visible until unmerged
+    std::vector<DrawEnt>    hidden;
+
+    [[nodiscard]] bool empty() const noexcept { return batches.empty(); }
+};
+
+class SysMergeDraw
+{
+public:
+
+    /**
+     * @brief Merge the meshes of a subtree's DrawEnts that share a material, diffuse texture,
+     *        and color into one mesh each
+     *
+     * The first DrawEnt of each group is kept to draw the merged mesh, with the other meshes
+     * transformed into its space. Only do this for subtrees that don't move relative to their
+     * root, such as the parts of a weld. Transparent DrawEnts, DrawEnts with levels of detail,
+     * and meshes that aren't triangles or don't share the same attributes are left alone.
+     *
+     * Merged meshes are added as new resources to pkg, and live until the scene's resources
+     * are cleaned up.
+     *
+     * @param root      [in] Subtree root, its DrawEnts and those of all descendants are merged
+     * @param name      [in] Prefix of the names of merged mesh resources, must be unique
+     *
+     * @return Batches made, empty if nothing could be merged
+     */
+    [[nodiscard]] static MergedDraw merge(
+            ACtxSceneRender&            rScnRender,
+            ACtxDrawing&                rDrawing,
+            ACtxDrawingRes&             rDrawingRes,
+            Resources&                  rResources,
+            active::ACtxBasic const&    rBasic,
+            active::ActiveEnt           root,
+            PkgId                       pkg,
+            std::string_view            name);
+
+    /**
+     * @brief Restore the original meshes of merged DrawEnts and show the hidden ones again
+     *
+     * DrawEnts in ACtxSceneRender::m_drawDeleted are not shown again.
+     */
+    static void unmerge(
+            MergedDraw&                 rMerged,
+            ACtxSceneRender&            rScnRender,
+            ACtxDrawing&                rDrawing);
+
+}; // class SysMergeDraw
+
+} // namespace osp::draw
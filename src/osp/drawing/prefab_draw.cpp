@@ -49,15 +49,12 @@ void SysPrefabDraw::init_drawents(
 
     for (TmpPrefabRequest const& request : rPrefabs.spawnRequest)
     {
-        auto const &rImportData = rResources.data_get<osp::ImporterData const>(gc_importer, request.m_importerRes);
-        auto const &rPrefabData = rResources.data_get<osp::Prefabs const>     (gc_importer, request.m_importerRes);
-        auto const objects      = rPrefabData.m_prefabs[request.m_prefabId];
-        auto const ents         = ArrayView<ActiveEnt const>{*itPfEnts};
+        PrefabTemplate const &rTemplate = SysPrefabInit::template_of(request, rResources);
+        auto const ents                 = ArrayView<ActiveEnt const>{*itPfEnts};
 
-        for (std::size_t i = 0; i < objects.size(); ++i)
+        for (std::size_t i = 0; i < ents.size(); ++i)
         {
-            int const meshImportId = rImportData.m_objMeshes[objects[i]];
-            if (meshImportId == -1)
+            if (rTemplate.meshes[i] == lgrn::id_null<ResId>())
             {
                 continue;
             }
@@ -117,61 +114,50 @@ void SysPrefabDraw::init_mesh_texture_material(
 
     for (TmpPrefabRequest const& request : rPrefabs.spawnRequest)
     {
-        auto const &rImportData = rResources.data_get<osp::ImporterData const>(gc_importer, request.m_importerRes);
-        auto const &rPrefabData = rResources.data_get<osp::Prefabs const>     (gc_importer, request.m_importerRes);
-        auto const objects  = lgrn::Span<int const>{rPrefabData.m_prefabs[request.m_prefabId]};
-        auto const parents  = lgrn::Span<int const>{rPrefabData.m_prefabParents[request.m_prefabId]};
-        auto const ents     = ArrayView<ActiveEnt const>{*itPfEnts};
+        PrefabTemplate const &rTemplate = SysPrefabInit::template_of(request, rResources);
+        auto const parents              = ArrayView<int32_t const>{rTemplate.parents.data(), rTemplate.parents.size()};
+        auto const ents                 = ArrayView<ActiveEnt const>{*itPfEnts};
 
         // All ancestors of each entity that has a mesh
         auto const needs_draw_transform
-            = [&parents, &ents, &rDrawing, &needDrawTf = rScnRender.m_needDrawTf]
-              (auto&& self, int const object, ActiveEnt const ent) noexcept -> void
+            = [&parents, &ents, &needDrawTf = rScnRender.m_needDrawTf]
+              (auto&& self, int const index, ActiveEnt const ent) noexcept -> void
         {
             needDrawTf.insert(ent);
 
-            int const parentObj = parents[object];
+            int const parentIndex = parents[index];
 
-            if (parentObj != -1)
+            if (parentIndex != -1)
             {
-                self(self, parentObj, ents[parentObj]);
+                self(self, parentIndex, ents[parentIndex]);
             }
         };
 
-        for (std::size_t i = 0; i < objects.size(); ++i)
+        for (std::size_t i = 0; i < ents.size(); ++i)
         {
-            ActiveEnt const ent = ents[i];
+            ActiveEnt const ent     = ents[i];
+            ResId const     meshRes = rTemplate.meshes[i];
 
             // Check if object has mesh
-            int const meshImportId = rImportData.m_objMeshes[objects[i]];
-            if (meshImportId == -1)
+            if (meshRes == lgrn::id_null<ResId>())
             {
                 continue;
             }
 
-            needs_draw_transform(needs_draw_transform, objects[i], ent);
+            needs_draw_transform(needs_draw_transform, int(i), ent);
 
             DrawEnt const drawEnt = rScnRender.m_activeToDraw[ent];
 
-            osp::ResId const meshRes = rImportData.m_meshes[meshImportId];
             MeshId const meshId = SysRender::own_mesh_resource(rDrawing, rDrawingRes, rResources, meshRes);
             rScnRender.m_mesh[drawEnt] = rDrawing.m_meshRefCounts.ref_add(meshId);
             rScnRender.m_meshDirty.push_back(drawEnt);
 
-            int const matImportId = rImportData.m_objMaterials[objects[i]];
-
-            if (Magnum::Trade::MaterialData const &mat = *rImportData.m_materials.at(matImportId);
-                mat.types() & Magnum::Trade::MaterialType::PbrMetallicRoughness)
+            if (ResId const texRes = rTemplate.baseColorTex[i];
+                texRes != lgrn::id_null<ResId>())
             {
-                auto const& matPbr = mat.as<Magnum::Trade::PbrMetallicRoughnessMaterialData>();
-                if (auto const baseColor = matPbr.baseColorTexture();
-                    baseColor != -1)
-                {
-                    osp::ResId const texRes = rImportData.m_textures[baseColor];
-                    TexId const texId = SysRender::own_texture_resource(rDrawing, rDrawingRes, rResources, texRes);
-                    rScnRender.m_diffuseTex[drawEnt] = rDrawing.m_texRefCounts.ref_add(texId);
-                    rScnRender.m_diffuseDirty.push_back(drawEnt);
-                }
+                TexId const texId = SysRender::own_texture_resource(rDrawing, rDrawingRes, rResources, texRes);
+                rScnRender.m_diffuseTex[drawEnt] = rDrawing.m_texRefCounts.ref_add(texId);
+                rScnRender.m_diffuseDirty.push_back(drawEnt);
             }
 
             rScnRender.m_opaque.insert(drawEnt);
@@ -0,0 +1,185 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "render_commands.h"
+#include "drawing.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <utility>
+
+using namespace osp;
+using namespace osp::draw;
+
+/**
+ * @brief Map a non-negative float to 16 bits that sort in the same order
+ *
+ * Positive IEEE 754 floats compare the same as their bit patterns as integers, so the top bits
+ * are a coarse but monotonic depth.
+ */
+static std::uint64_t depth_bits(float const depth) noexcept
+{
+    std::uint32_t bits;
+    float const clamped = std::max(depth, 0.0f);
+    std::memcpy(&bits, &clamped, sizeof(bits));
+    return bits >> 16;
+}
+
+/**
+ * @brief LSD radix sort of RenderCmds by key, 8 bits per pass
+ *
+ * Passes where all keys share the same digit are skipped, which is common for the high bits.
+ */
+static void radix_sort(std::vector<RenderCmd>& rCmds, std::vector<RenderCmd>& rTemp)
+{
+    std::size_t const count = rCmds.size();
+    rTemp.resize(count);
+
+    for (int shift = 0; shift < 64; shift += 8)
+    {
+        std::array<std::size_t, 256> histogram{};
+        for (RenderCmd const& cmd : rCmds)
+        {
+            ++histogram[(cmd.key >> shift) & 0xFF];
+        }
+
+        if (histogram[(rCmds.front().key >> shift) & 0xFF] == count)
+        {
+            continue;
+        }
+
+        std::size_t offset = 0;
+        for (std::size_t &rBucket : histogram)
+        {
+            offset += std::exchange(rBucket, offset);
+        }
+
+        for (RenderCmd const& cmd : rCmds)
+        {
+            rTemp[histogram[(cmd.key >> shift) & 0xFF]++] = cmd;
+        }
+
+        std::swap(rCmds, rTemp);
+    }
+}
+
+static MeshIdOwner_t const& current_mesh(ACtxSceneRender const& scnRender, DrawEnt const ent)
+{
+    auto const lodIt = scnRender.m_lods.find(ent);
+    if (lodIt != scnRender.m_lods.end() && lodIt->second.m_current != 0)
+    {
+        return lodIt->second.m_meshes[lodIt->second.m_current - 1];
+    }
+    return scnRender.m_mesh[ent];
+}
+
+void SysRenderCmd::record(
+        RenderCmdBuffer&            rCmds,
+        RenderGroup const&          group,
+        DrawEntSet_t const&         visible,
+        ACtxSceneRender const&      scnRender,
+        ViewProjMatrix const&       viewProj,
+        bool const                  backToFront)
+{
+    rCmds.m_cmds.clear();
+    rCmds.m_shaders.clear();
+    rCmds.m_instanced = group.instanced;
+    rCmds.m_view = viewProj.m_view;
+    rCmds.m_proj = viewProj.m_proj;
+    rCmds.m_origin = viewProj.m_origin;
+
+    // Key layout, most significant first:
+    //   opaque:       [shader 12][mesh 20][texture 16][depth 16]
+    //   transparent:  [depth 16][shader 12][mesh 20][texture 16]
+    // Shaders are told apart by their draw function and user data, which includes the material.
+
+    auto const shader_index = [&rCmds] (EntityToDraw const& toDraw) -> std::uint64_t
+    {
+        auto const sameShader = [&toDraw] (EntityToDraw const* pOther)
+        {
+            return pOther->draw == toDraw.draw && pOther->data == toDraw.data;
+        };
+
+        auto const found = std::find_if(rCmds.m_shaders.begin(), rCmds.m_shaders.end(), sameShader);
+        if (found != rCmds.m_shaders.end())
+        {
+            return std::uint64_t(std::distance(rCmds.m_shaders.begin(), found));
+        }
+        rCmds.m_shaders.push_back(&toDraw);
+        return rCmds.m_shaders.size() - 1;
+    };
+
+    for (auto const& [ent, toDraw] : entt::basic_view{group.entities}.each())
+    {
+        if ( ! visible.contains(ent) )
+        {
+            continue;
+        }
+
+        MeshIdOwner_t const& meshOwner = current_mesh(scnRender, ent);
+        TexIdOwner_t const&  texOwner  = scnRender.m_diffuseTex[ent];
+
+        std::uint64_t const shader  = shader_index(toDraw) & 0xFFF;
+        std::uint64_t const mesh    = meshOwner.has_value()
+                                    ? std::uint64_t(meshOwner.value()) & 0xFFFFF
+                                    : 0xFFFFF;
+        std::uint64_t const tex     = texOwner.has_value()
+                                    ? std::uint64_t(texOwner.value()) & 0xFFFF
+                                    : 0xFFFF;
+
+        // Distance in front of the camera, which looks down -Z in view space
+        float const viewZ = -viewProj.m_view.transformPoint(scnRender.m_drawTransform[ent].translation()).z();
+        std::uint64_t const depth = depth_bits(viewZ);
+
+        std::uint64_t const key = backToFront
+                ? ((0xFFFF - depth) << 48) | (shader << 36) | (mesh << 16) | tex
+                : (shader << 52) | (mesh << 32) | (tex << 16) | depth;
+
+        rCmds.m_cmds.push_back({key, ent, &toDraw});
+    }
+
+    rCmds.m_shaderChanges  = 0;
+    rCmds.m_meshChanges    = 0;
+    rCmds.m_textureChanges = 0;
+
+    if (rCmds.m_cmds.empty())
+    {
+        return;
+    }
+
+    radix_sort(rCmds.m_cmds, rCmds.m_temp);
+
+    // Count transitions. Bit positions depend on the key layout above.
+    int const shaderShift   = backToFront ? 36 : 52;
+    int const meshShift     = backToFront ? 16 : 32;
+    int const texShift      = backToFront ? 0  : 16;
+    for (std::size_t i = 1; i < rCmds.m_cmds.size(); ++i)
+    {
+        std::uint64_t const changed = rCmds.m_cmds[i - 1].key ^ rCmds.m_cmds[i].key;
+        rCmds.m_shaderChanges  += ((changed >> shaderShift) & 0xFFF)    != 0;
+        rCmds.m_meshChanges    += ((changed >> meshShift)   & 0xFFFFF)  != 0;
+        rCmds.m_textureChanges += ((changed >> texShift)    & 0xFFFF)   != 0;
+    }
+}
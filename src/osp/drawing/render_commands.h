@@ -0,0 +1,104 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "drawing_fn.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace osp::draw
+{
+
+/**
+ * @brief A single draw of a visible entity in a RenderGroup
+ *
+ * Only refers to scene-level data (DrawEnts, scene Mesh and Texture Ids, and draw functions), so
+ * commands can be recorded without knowing which graphics API draws them.
+ */
+struct RenderCmd
+{
+    std::uint64_t       key;
+    DrawEnt             ent;
+    EntityToDraw const  *pToDraw;
+};
+
+/**
+ * @brief Sorted draws of a RenderGroup for a single view, recorded by SysRenderCmd::record
+ *
+ * Opaque keys are ordered by shader, mesh, texture, then front-to-back depth. Transparent keys
+ * are ordered back-to-front first, since correct blending matters more than state changes.
+ *
+ * Recording only reads scene data and writes to this buffer, so it doesn't need to run on the
+ * thread owning the graphics context. A backend only has to walk m_cmds and m_instanced in order.
+ */
+struct RenderCmdBuffer
+{
+    std::vector<RenderCmd>          m_cmds;
+
+    /// Draw functions of RenderGroup::instanced, called after m_cmds
+    std::vector<InstancedToDraw>    m_instanced;
+
+    /// View and projection matrix the commands were recorded with, see ViewProjMatrix
+    Matrix4                         m_view;
+    Matrix4                         m_proj;
+    Vector3                         m_origin;
+
+    /// Number of times shader, mesh, or texture differ between consecutive commands
+    std::uint32_t                   m_shaderChanges     {0};
+    std::uint32_t                   m_meshChanges       {0};
+    std::uint32_t                   m_textureChanges    {0};
+
+    // Scratch buffers for sorting
+    std::vector<RenderCmd>          m_temp;
+    std::vector<EntityToDraw const*> m_shaders;
+};
+
+class SysRenderCmd
+{
+public:
+
+    /**
+     * @brief Fill a RenderCmdBuffer with the visible entities of a RenderGroup, then sort it
+     *
+     * Mesh keys use the level of detail currently selected by SysCulling::select_lods.
+     *
+     * @param rCmds         [out] Buffer to fill, previous contents are cleared
+     * @param group         [in] RenderGroup to draw
+     * @param visible       [in] Storage for visible components
+     * @param scnRender     [in] Scene Mesh, Texture, LOD, and draw transforms of entities
+     * @param viewProj      [in] View and projection matrix
+     * @param backToFront   [in] Sort by depth first, farthest first. Use for transparent objects.
+     */
+    static void record(
+            RenderCmdBuffer&            rCmds,
+            RenderGroup const&          group,
+            DrawEntSet_t const&         visible,
+            ACtxSceneRender const&      scnRender,
+            ViewProjMatrix const&       viewProj,
+            bool                        backToFront);
+};
+
+} // namespace osp::draw
@@ -23,6 +23,7 @@
  * SOFTWARE.
  */
 #include "FullscreenTriShader.h"
+#include "program_cache.h"
 
 #include <Magnum/GL/Version.h>
 #include <Magnum/GL/Shader.h>
@@ -40,26 +41,42 @@
 using namespace osp;
 using namespace Magnum;
 
-FullscreenTriShader::FullscreenTriShader()
+FullscreenTriShader::FullscreenTriShader(draw::ProgramBinaryCacheGL const* pCache)
 {
-    GL::Shader vert{GL::Version::GL430, GL::Shader::Type::Vertex};
-    GL::Shader frag{GL::Version::GL430, GL::Shader::Type::Fragment};
     std::filesystem::path appPath = std::filesystem::path{osp::filefunctions::s_exe_dir};
-    if ( ! std::filesystem::exists(appPath / "OSPData/adera/Shaders/FullscreenTri.vert")
-    || ! std::filesystem::exists(appPath / "OSPData/adera/Shaders/FullscreenTri.frag"))
+    std::filesystem::path const vertPath = appPath / "OSPData/adera/Shaders/FullscreenTri.vert";
+    std::filesystem::path const fragPath = appPath / "OSPData/adera/Shaders/FullscreenTri.frag";
+    if ( ! std::filesystem::exists(vertPath) || ! std::filesystem::exists(fragPath))
     {
         OSP_LOG_ERROR("Failed to find OSPData/adera/Shaders/FullscreenTri.vert or OSPData/adera/Shaders/FullscreenTri.frag");
         return;
     }
-    vert.addFile(appPath.string() + "OSPData/adera/Shaders/FullscreenTri.vert");
-    frag.addFile(appPath.string() + "OSPData/adera/Shaders/FullscreenTri.frag");
 
-    CORRADE_INTERNAL_ASSERT_OUTPUT(vert.compile() && frag.compile());
-    attachShaders({vert, frag});
-    CORRADE_INTERNAL_ASSERT_OUTPUT(link());
+    std::uint64_t const cacheKey = (pCache != nullptr) ? pCache->key({vertPath, fragPath}) : 0;
+    if (pCache == nullptr || ! pCache->load(*this, cacheKey))
+    {
+        GL::Shader vert{GL::Version::GL430, GL::Shader::Type::Vertex};
+        GL::Shader frag{GL::Version::GL430, GL::Shader::Type::Fragment};
+        vert.addFile(vertPath.string());
+        frag.addFile(fragPath.string());
+
+        CORRADE_INTERNAL_ASSERT_OUTPUT(vert.compile() && frag.compile());
+        attachShaders({vert, frag});
+
+        if (pCache != nullptr)
+        {
+            pCache->prepare(*this);
+        }
+        CORRADE_INTERNAL_ASSERT_OUTPUT(link());
+        if (pCache != nullptr)
+        {
+            pCache->store(*this, cacheKey);
+        }
+    }
 
     setUniform(static_cast<Int>(EUniformPos::FramebufferSampler),
         static_cast<Int>(ETextureSlot::Framebuffer));
+    set_uv_range(Vector2{1.0f}, Vector2{1.0f});
 }
 
 void FullscreenTriShader::display_texure(GL::Mesh& surface, GL::Texture2D& texture)
@@ -68,6 +85,13 @@ void FullscreenTriShader::display_texure(GL::Mesh& surface, GL::Texture2D& textu
     draw(surface);
 }
 
+FullscreenTriShader& FullscreenTriShader::set_uv_range(Vector2 const scale, Vector2 const max)
+{
+    setUniform(static_cast<Int>(EUniformPos::UvScale), scale);
+    setUniform(static_cast<Int>(EUniformPos::UvMax), max);
+    return *this;
+}
+
 FullscreenTriShader& FullscreenTriShader::set_framebuffer(GL::Texture2D& rTex)
 {
     rTex.bind(static_cast<Int>(ETextureSlot::Framebuffer));
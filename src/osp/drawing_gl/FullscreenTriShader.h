@@ -27,6 +27,8 @@
 #include <Magnum/GL/AbstractShaderProgram.h>
 #include <Magnum/GL/Attribute.h>
 
+namespace osp::draw { class ProgramBinaryCacheGL; }
+
 namespace osp
 {
 
@@ -43,7 +45,10 @@ public:
         ColorOutput = 0
     };
 
-    FullscreenTriShader();
+    /**
+     * @param pCache - Optional program binary cache to load from and store to
+     */
+    explicit FullscreenTriShader(draw::ProgramBinaryCacheGL const* pCache = nullptr);
 
     using AbstractShaderProgram::AbstractShaderProgram;
 
@@ -54,11 +59,21 @@ public:
      * @param texture - The texture to display
      */
     void display_texure(Magnum::GL::Mesh& surface, Magnum::GL::Texture2D& texture);
+
+    /**
+     * Only display the bottom left part of textures, such as when rendering at a lower resolution
+     *
+     * @param scale - Fraction of the texture's width and height to stretch over the screen
+     * @param max   - Highest UV to sample, keeps linear filtering inside of that part
+     */
+    FullscreenTriShader& set_uv_range(Magnum::Vector2 scale, Magnum::Vector2 max);
 private:
     // Uniforms
     enum class EUniformPos : Magnum::Int
     {
-        FramebufferSampler = 0
+        FramebufferSampler = 0,
+        UvScale = 1,
+        UvMax = 2
     };
 
     // Texture2D slots
@@ -0,0 +1,93 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+/**
+ * @file
+ * @brief OpenGL GPU zones, compiled out entirely unless OSP_PROFILE_TRACY is non-zero
+ *
+ * GPU zones measure with GL timestamp queries, read back a few frames later by
+ * OSP_PROFILE_GPU_COLLECT. Only use them on the thread that owns the GL context, after
+ * OSP_PROFILE_GPU_CONTEXT was called once. See osp/util/profiling.h for CPU zones.
+ */
+#pragma once
+
+#include "../util/profiling.h"
+
+#if OSP_PROFILE_TRACY
+
+// Tracy's GL zones call GL functions directly, which Magnum loads through flextGL
+#include <Magnum/GL/OpenGL.h>
+#include <tracy/TracyOpenGL.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+/// Set up GPU profiling for the current GL context, call once after the context is created
+#define OSP_PROFILE_GPU_CONTEXT() TracyGpuContext
+
+/// Read back finished GPU zones, call once per frame after swapping buffers
+#define OSP_PROFILE_GPU_COLLECT() TracyGpuCollect
+
+/// GPU zone from here to the end of the enclosing scope, name must be a string literal
+#define OSP_PROFILE_GPU_ZONE(name) TracyGpuZone(name)
+
+namespace osp::draw
+{
+
+/**
+ * @brief GPU zone that begins and ends in different functions, see OSP_PROFILE_GPU_SPLIT_BEGIN
+ *
+ * Held by pointer, as GpuCtxScope can't be moved and structs holding this still need to be.
+ */
+struct GpuProfileSplitZoneGL
+{
+    std::unique_ptr<tracy::GpuCtxScope> m_pScope;
+};
+
+} // namespace osp::draw
+
+#define OSP_PROFILE_GPU_SPLIT_BEGIN(rZone, name) \
+    (rZone).m_pScope = std::make_unique<::tracy::GpuCtxScope>( \
+            std::uint32_t(__LINE__), __FILE__, sizeof(__FILE__) - 1, __func__, sizeof(__func__) - 1, \
+            std::string_view{name}.data(), std::string_view{name}.size(), true)
+
+#define OSP_PROFILE_GPU_SPLIT_END(rZone) (rZone).m_pScope.reset()
+
+#else // OSP_PROFILE_TRACY
+
+#define OSP_PROFILE_GPU_CONTEXT()
+#define OSP_PROFILE_GPU_COLLECT()
+#define OSP_PROFILE_GPU_ZONE(name)
+#define OSP_PROFILE_GPU_SPLIT_BEGIN(rZone, name) ((void)(rZone))
+#define OSP_PROFILE_GPU_SPLIT_END(rZone) ((void)(rZone))
+
+namespace osp::draw
+{
+
+struct GpuProfileSplitZoneGL { };
+
+} // namespace osp::draw
+
+#endif // OSP_PROFILE_TRACY
@@ -0,0 +1,185 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "program_cache.h"
+
+#include "../util/logging.h"
+
+#include <Magnum/GL/OpenGL.h>
+
+#include <array>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <system_error>
+#include <vector>
+
+using osp::draw::ProgramBinaryCacheGL;
+
+namespace
+{
+
+constexpr std::uint64_t gc_fnvOffset = 14695981039346656037ull;
+constexpr std::uint64_t gc_fnvPrime  = 1099511628211ull;
+
+void fnv1a(std::uint64_t& rHash, char const* pData, std::size_t const size) noexcept
+{
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        rHash ^= std::uint8_t(pData[i]);
+        rHash *= gc_fnvPrime;
+    }
+}
+
+std::string gl_string(GLenum const name)
+{
+    auto const* pStr = reinterpret_cast<char const*>(glGetString(name));
+    return (pStr != nullptr) ? std::string{pStr} : std::string{};
+}
+
+} // namespace
+
+void ProgramBinaryCacheGL::open(std::filesystem::path directory)
+{
+    m_directory.clear();
+
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    if (formatCount == 0)
+    {
+        OSP_LOG_INFO("GL driver can't store program binaries, shader cache is off");
+        return;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error)
+    {
+        OSP_LOG_WARN("Can't create shader cache directory {}: {}", directory.string(), error.message());
+        return;
+    }
+
+    m_driver = gl_string(GL_VENDOR) + '\n' + gl_string(GL_RENDERER) + '\n' + gl_string(GL_VERSION);
+    m_directory = std::move(directory);
+}
+
+std::uint64_t ProgramBinaryCacheGL::key(std::initializer_list<std::filesystem::path> sourceFiles) const
+{
+    std::uint64_t hash = gc_fnvOffset;
+    fnv1a(hash, m_driver.data(), m_driver.size());
+
+    for (std::filesystem::path const& path : sourceFiles)
+    {
+        std::ifstream file{path, std::ios::binary};
+        std::string const source{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+
+        // Include the size, so moving text between files changes the key
+        std::uint64_t const size = source.size();
+        fnv1a(hash, reinterpret_cast<char const*>(&size), sizeof(size));
+        fnv1a(hash, source.data(), source.size());
+    }
+
+    return hash;
+}
+
+std::filesystem::path ProgramBinaryCacheGL::path_of(std::uint64_t const key) const
+{
+    std::array<char, 24> name{};
+    std::snprintf(name.data(), name.size(), "%016llx.bin", static_cast<unsigned long long>(key));
+    return m_directory / name.data();
+}
+
+bool ProgramBinaryCacheGL::load(Magnum::GL::AbstractShaderProgram& rProgram, std::uint64_t const key) const
+{
+    if ( ! is_open())
+    {
+        return false;
+    }
+
+    std::filesystem::path const path = path_of(key);
+    std::ifstream file{path, std::ios::binary};
+    if ( ! file)
+    {
+        return false; // Not cached yet
+    }
+
+    // GLenum binary format, followed by the binary
+    GLenum format = 0;
+    file.read(reinterpret_cast<char*>(&format), sizeof(format));
+    std::vector<char> const binary{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+    file.close();
+
+    GLint linked = GL_FALSE;
+    if ( ! binary.empty())
+    {
+        glProgramBinary(rProgram.id(), format, binary.data(), GLsizei(binary.size()));
+        glGetProgramiv(rProgram.id(), GL_LINK_STATUS, &linked);
+    }
+
+    if (linked != GL_TRUE)
+    {
+        // Usually a driver update; compiling again will replace it
+        OSP_LOG_INFO("Cached program binary {} rejected, compiling from source", path.filename().string());
+        std::error_code error;
+        std::filesystem::remove(path, error);
+        return false;
+    }
+
+    return true;
+}
+
+void ProgramBinaryCacheGL::prepare(Magnum::GL::AbstractShaderProgram& rProgram) const
+{
+    if (is_open())
+    {
+        glProgramParameteri(rProgram.id(), GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+}
+
+void ProgramBinaryCacheGL::store(Magnum::GL::AbstractShaderProgram& rProgram, std::uint64_t const key) const
+{
+    if ( ! is_open())
+    {
+        return;
+    }
+
+    GLint length = 0;
+    glGetProgramiv(rProgram.id(), GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+    {
+        return;
+    }
+
+    std::vector<char> binary(static_cast<std::size_t>(length));
+    GLenum format = 0;
+    glGetProgramBinary(rProgram.id(), length, &length, &format, binary.data());
+
+    std::ofstream file{path_of(key), std::ios::binary | std::ios::trunc};
+    file.write(reinterpret_cast<char const*>(&format), sizeof(format));
+    file.write(binary.data(), length);
+    if ( ! file)
+    {
+        OSP_LOG_WARN("Failed to write program binary to shader cache {}", m_directory.string());
+    }
+}
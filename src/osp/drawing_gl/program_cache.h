@@ -0,0 +1,93 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include <Magnum/GL/AbstractShaderProgram.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <initializer_list>
+#include <string>
+
+namespace osp::draw
+{
+
+/**
+ * @brief Stores linked GL program binaries on disk, to skip compiling shaders on later launches
+ *
+ * Binaries are keyed by a hash of the shader source files and the GL vendor, renderer, and
+ * version strings, as drivers only accept binaries they made themselves. A binary that is still
+ * rejected is deleted, and the program is compiled from source and stored again.
+ *
+ * Only usable by our own shader programs; Magnum's built-in shaders compile and link inside of
+ * their constructors.
+ */
+class ProgramBinaryCacheGL
+{
+public:
+
+    /**
+     * @brief Start caching binaries in a directory, created if needed
+     *
+     * Needs a current GL context. Caching stays off if the directory can't be created or the
+     * driver can't store binaries.
+     */
+    void open(std::filesystem::path directory);
+
+    [[nodiscard]] bool is_open() const noexcept { return ! m_directory.empty(); }
+
+    /**
+     * @brief Cache key of a program made from the given shader source files
+     */
+    [[nodiscard]] std::uint64_t key(std::initializer_list<std::filesystem::path> sourceFiles) const;
+
+    /**
+     * @brief Link rProgram from a stored binary
+     *
+     * @return true if rProgram is linked, false if it still needs to be compiled and linked
+     */
+    bool load(Magnum::GL::AbstractShaderProgram& rProgram, std::uint64_t key) const;
+
+    /**
+     * @brief Ask the driver to keep rProgram retrievable, call before linking it
+     */
+    void prepare(Magnum::GL::AbstractShaderProgram& rProgram) const;
+
+    /**
+     * @brief Store the binary of a linked rProgram
+     */
+    void store(Magnum::GL::AbstractShaderProgram& rProgram, std::uint64_t key) const;
+
+private:
+
+    [[nodiscard]] std::filesystem::path path_of(std::uint64_t key) const;
+
+    std::filesystem::path   m_directory;
+
+    /// GL vendor, renderer, and version strings
+    std::string             m_driver;
+};
+
+} // namespace osp::draw
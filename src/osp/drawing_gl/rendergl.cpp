@@ -27,25 +27,42 @@
 #include "FullscreenTriShader.h"
 
 #include "../core/Resources.h"
+#include "../drawing/image_mips.h"
 #include "../drawing/own_restypes.h"
 #include "../util/logging.h"
 
 #include <Magnum/ImageView.h>
+#include <Magnum/PixelFormat.h>
 
 #include <Magnum/GL/Buffer.h>
+#include <Magnum/GL/BufferImage.h>
+#include <Magnum/GL/Context.h>
+#include <Magnum/GL/Extensions.h>
+#include <Magnum/GL/PixelFormat.h>
 #include <Magnum/GL/DefaultFramebuffer.h>
 #include <Magnum/GL/Renderer.h>
+#include <Magnum/GL/Sampler.h>
 #include <Magnum/GL/TextureFormat.h>
 #include <Magnum/GL/RenderbufferFormat.h>
 
 #include <Corrade/Containers/ArrayViewStl.h>
 
+#include <longeron/utility/asserts.hpp>
+
 #include <Magnum/Trade/MeshData.h>
 #include <Magnum/Trade/ImageData.h>
 #include <Magnum/Trade/TextureData.h>
 
 #include <Magnum/Mesh.h>
 #include <Magnum/MeshTools/Compile.h>
+#include <Magnum/Shaders/GenericGL.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <string_view>
+#include <utility>
 
 using Magnum::Trade::MeshData;
 using Magnum::Trade::TextureData;
@@ -61,13 +78,25 @@ using osp::draw::RenderGL;
 
 using osp::draw::TexGlId;
 using osp::draw::MeshGlId;
+using osp::draw::GpuMemoryGL;
+using osp::draw::TextureMipsGL;
+using osp::draw::TextureArraysGL;
+
+/// Profiler zone names of each ERenderPass
+[[maybe_unused]] constexpr std::array<std::string_view, std::size_t(osp::draw::ERenderPass::Count)> gc_passZoneNames
+{
+    "Depth prepass", "Opaque pass", "Transparent pass", "Blit pass", "Plume pass", "Terrain pass", "Satellite pass", "Orbit trail pass"
+};
 
 void SysRenderGL::setup_context(RenderGL& rCtxGl)
 {
     using namespace Magnum;
 
+    OSP_PROFILE_GPU_CONTEXT();
+
     // Initialize with GL context object, previously initialized using NoCreate
-    rCtxGl.m_fullscreenTriShader = {};
+    rCtxGl.m_fullscreenTriShader = FullscreenTriShader{&rCtxGl.m_programCache};
+    rCtxGl.m_depthPrepassShader = Magnum::Shaders::FlatGL3D{};
 
     /* Generate fullscreen tri for texture rendering */
     {
@@ -98,7 +127,10 @@ void SysRenderGL::setup_context(RenderGL& rCtxGl)
 
         rCtxGl.m_fboColor = rCtxGl.m_texIds.create();
         GL::Texture2D &rFboColor = rCtxGl.m_texGl.emplace(rCtxGl.m_fboColor);
-        rFboColor.setStorage(1, GL::TextureFormat::RGB8, viewSize);
+        rFboColor.setStorage(1, GL::TextureFormat::RGB8, viewSize)
+                 .setMinificationFilter(GL::SamplerFilter::Linear)
+                 .setMagnificationFilter(GL::SamplerFilter::Linear)
+                 .setWrapping(GL::SamplerWrapping::ClampToEdge);
 
         rCtxGl.m_fboDepthStencil = Magnum::GL::Renderbuffer{};
         rCtxGl.m_fboDepthStencil.setStorage(GL::RenderbufferFormat::Depth24Stencil8, viewSize);
@@ -106,7 +138,390 @@ void SysRenderGL::setup_context(RenderGL& rCtxGl)
         rCtxGl.m_fbo = GL::Framebuffer{ Range2Di{{0, 0}, viewSize} };
         rCtxGl.m_fbo.attachTexture(GL::Framebuffer::ColorAttachment{0}, rFboColor, 0);
         rCtxGl.m_fbo.attachRenderbuffer(GL::Framebuffer::BufferAttachment::DepthStencil, rCtxGl.m_fboDepthStencil);
+
+        rCtxGl.m_renderScale.m_fullSize     = viewSize;
+        rCtxGl.m_renderScale.m_renderedSize = viewSize;
+
+        rCtxGl.m_depthReadback.m_image = GL::BufferImage2D{GL::PixelFormat::DepthComponent, GL::PixelType::Float};
+    }
+}
+
+/**
+ * @brief Record that a mesh or texture now holds its full data on the GPU
+ */
+template <typename ID_T>
+static void set_resident(GpuMemoryGL& rGpuMem, osp::IdMap_t<ID_T, GpuMemoryGL::Entry>& rEntries, ID_T const id, std::size_t const bytes)
+{
+    GpuMemoryGL::Entry &rEntry = rEntries[id];
+    if (rEntry.state == GpuMemoryGL::EState::Resident)
+    {
+        rGpuMem.m_residentBytes -= rEntry.bytes;
+    }
+    rEntry.bytes    = bytes;
+    rEntry.lastUsed = rGpuMem.m_frame;
+    rEntry.state    = GpuMemoryGL::EState::Resident;
+    rGpuMem.m_residentBytes += bytes;
+}
+
+/**
+ * @brief 1x1 white texture to stand in for one that isn't uploaded
+ */
+static Texture2D placeholder_texture()
+{
+    static constexpr std::array<std::uint8_t, 4> white{0xFF, 0xFF, 0xFF, 0xFF};
+    Texture2D texture;
+    texture .setStorage(1, Magnum::GL::TextureFormat::RGBA8, {1, 1})
+            .setSubImage(0, {}, Magnum::ImageView2D{Magnum::PixelFormat::RGBA8Unorm, {1, 1}, white});
+    return texture;
+}
+
+/**
+ * @brief Forget instance attributes attached to a mesh that is being replaced, so they're
+ *        attached again on next use
+ */
+static void detach_instances(RenderGL& rRenderGl, MeshGlId const meshId)
+{
+    rRenderGl.m_meshInstanceBuf.remove(meshId);
+    auto &rRingMeshes = rRenderGl.m_frameRingMeshes;
+    rRingMeshes.erase(std::remove(rRingMeshes.begin(), rRingMeshes.end(), meshId), rRingMeshes.end());
+}
+
+/**
+ * @brief Check if the current context can sample a compressed format, such as ones Basis
+ *        Universal images are transcoded to while importing
+ */
+static bool compressed_format_supported(Magnum::CompressedPixelFormat const format)
+{
+    using namespace Magnum;
+
+    if ( ! GL::hasTextureFormat(format) )
+    {
+        return false;
+    }
+
+    GL::Context &rContext = GL::Context::current();
+    switch (format)
+    {
+    case CompressedPixelFormat::Bc1RGBUnorm:
+    case CompressedPixelFormat::Bc1RGBAUnorm:
+    case CompressedPixelFormat::Bc2RGBAUnorm:
+    case CompressedPixelFormat::Bc3RGBAUnorm:
+        return rContext.isExtensionSupported<GL::Extensions::EXT::texture_compression_s3tc>();
+    case CompressedPixelFormat::Bc7RGBAUnorm:
+    case CompressedPixelFormat::Bc7RGBASrgb:
+        return rContext.isExtensionSupported<GL::Extensions::ARB::texture_compression_bptc>();
+    case CompressedPixelFormat::Etc2RGB8Unorm:
+    case CompressedPixelFormat::Etc2RGBA8Unorm:
+        return rContext.isExtensionSupported<GL::Extensions::ARB::ES3_compatibility>();
+    case CompressedPixelFormat::Astc4x4RGBAUnorm:
+        return rContext.isExtensionSupported<GL::Extensions::KHR::texture_compression_astc_ldr>();
+    default:
+        return true;
+    }
+}
+
+static void store_texture(RenderGL& rRenderGl, TexGlId const texId, Texture2D&& texture)
+{
+    if (rRenderGl.m_texGl.contains(texId))
+    {
+        rRenderGl.m_texGl.get(texId) = std::move(texture);
+    }
+    else
+    {
+        rRenderGl.m_texGl.emplace(texId, std::move(texture));
+    }
+}
+
+/**
+ * @brief Pixels of a mip level of an image resource, making its ImageMipChain if it has none
+ */
+static Magnum::ImageView2D mip_level_view(osp::Resources& rResources, ResId const imgRes, ImageData2D const& imgData, int const level)
+{
+    if (level == 0)
+    {
+        return imgData;
+    }
+
+    auto const *pMips = rResources.data_try_get<osp::ImageMipChain const>(osp::restypes::gc_image, imgRes);
+    if (pMips == nullptr)
+    {
+        pMips = &rResources.data_add<osp::ImageMipChain>(osp::restypes::gc_image, imgRes, osp::make_mip_chain(imgData));
+    }
+    return pMips->m_levels[std::size_t(level) - 1];
+}
+
+/**
+ * @brief Define one mip level of a texture with mutable storage, through a pixel buffer
+ *
+ * @return Bytes uploaded
+ */
+static std::size_t set_level_image(Texture2D& rTexture, int const level, Magnum::ImageView2D const& pixels)
+{
+    using Magnum::GL::BufferImage2D;
+    using Magnum::GL::BufferUsage;
+
+    BufferImage2D buffer{pixels.storage(), pixels.format(), pixels.size(), pixels.data(), BufferUsage::StreamDraw};
+    rTexture.setImage(level, Magnum::GL::textureFormat(pixels.format()), buffer);
+    return pixels.data().size();
+}
+
+/**
+ * @brief Replace a streamed texture with one holding only mip level base and coarser
+ *
+ * The texture must have a TextureMipsGL entry. Also used to trim levels that are no longer needed.
+ *
+ * @return Bytes uploaded
+ */
+static std::size_t upload_texture_levels(RenderGL& rRenderGl, osp::Resources& rResources, TexGlId const texId, ResId const texRes, int const base)
+{
+    ResId const imgRes = rResources.data_get<osp::TextureImgSource>(osp::restypes::gc_texture, texRes);
+    auto const &texData = rResources.data_get<TextureData>(osp::restypes::gc_texture, texRes);
+    auto const &imgData = rResources.data_get<ImageData2D>(osp::restypes::gc_image, imgRes);
+
+    TextureMipsGL::Entry &rEntry = rRenderGl.m_texMips.m_textures.at(texId);
+    int const coarsest = rEntry.levels - 1;
+
+    Texture2D texture;
+    texture .setMinificationFilter(texData.minificationFilter(), texData.mipmapFilter())
+            .setMagnificationFilter(texData.magnificationFilter())
+            .setWrapping(texData.wrapping().xy());
+
+    std::size_t bytes = 0;
+    for (int level = coarsest; level >= base; --level)
+    {
+        bytes += set_level_image(texture, level, mip_level_view(rResources, imgRes, imgData, level));
+    }
+
+    // Sampling is clamped to defined levels, coarser ones are used for anything finer
+    texture .setBaseLevel(base)
+            .setMaxLevel(coarsest);
+
+    store_texture(rRenderGl, texId, std::move(texture));
+    rEntry.residentBase = std::uint8_t(base);
+
+    set_resident(rRenderGl.m_gpuMemory, rRenderGl.m_gpuMemory.m_textures, texId, bytes);
+    return bytes;
+}
+
+/**
+ * @brief Add the next finer mip level to a resident streamed texture
+ *
+ * @return Bytes uploaded
+ */
+static std::size_t stream_finer_level(RenderGL& rRenderGl, osp::Resources& rResources, TexGlId const texId, ResId const texRes)
+{
+    ResId const imgRes = rResources.data_get<osp::TextureImgSource>(osp::restypes::gc_texture, texRes);
+    auto const &imgData = rResources.data_get<ImageData2D>(osp::restypes::gc_image, imgRes);
+
+    TextureMipsGL::Entry &rEntry = rRenderGl.m_texMips.m_textures.at(texId);
+    int const level = rEntry.residentBase - 1;
+
+    Texture2D &rTexture = rRenderGl.m_texGl.get(texId);
+    std::size_t const bytes = set_level_image(rTexture, level, mip_level_view(rResources, imgRes, imgData, level));
+    rTexture.setBaseLevel(level);
+    rEntry.residentBase = std::uint8_t(level);
+
+    std::size_t const total = rRenderGl.m_gpuMemory.m_textures.at(texId).bytes + bytes;
+    set_resident(rRenderGl.m_gpuMemory, rRenderGl.m_gpuMemory.m_textures, texId, total);
+    return bytes;
+}
+
+/**
+ * @brief Copy a texture into a layer of a TextureArraysGL array, if it fits one
+ *
+ * Done once per TexGlId, re-uploads after eviction keep the existing layer.
+ *
+ * @return Bytes uploaded
+ */
+static std::size_t pack_texture_layer(RenderGL& rRenderGl, osp::Resources& rResources, TexGlId const texId, ResId const texRes)
+{
+    TextureArraysGL &rArrays = rRenderGl.m_texArrays;
+    if (rArrays.m_layersPerArray == 0 || rArrays.m_layers.contains(texId))
+    {
+        return 0;
+    }
+
+    ResId const imgRes = rResources.data_get<osp::TextureImgSource>(osp::restypes::gc_texture, texRes);
+    auto const &texData = rResources.data_get<TextureData>(osp::restypes::gc_texture, texRes);
+    auto const &imgData = rResources.data_get<ImageData2D>(osp::restypes::gc_image, imgRes);
+
+    if (std::max(imgData.size().x(), imgData.size().y()) > rArrays.m_maxSize)
+    {
+        return 0;
+    }
+
+    TextureArraysGL::Key const key
+    {
+        .size           = imgData.size(),
+        .format         = imgData.isCompressed() ? Magnum::UnsignedInt(imgData.compressedFormat())
+                                                 : Magnum::UnsignedInt(imgData.format()),
+        .compressed     = imgData.isCompressed(),
+        .minFilter      = texData.minificationFilter(),
+        .magFilter      = texData.magnificationFilter(),
+        .mipmapFilter   = texData.mipmapFilter(),
+        .wrapX          = texData.wrapping().x(),
+        .wrapY          = texData.wrapping().y()
+    };
+
+    // Only uncompressed images have mip chains to fill the other levels with
+    int const levels = ( ! imgData.isCompressed() && osp::mip_chain_supported(imgData) )
+                     ? osp::mip_level_count(imgData.size()) : 1;
+
+    auto const found = std::find_if(rArrays.m_arrays.begin(), rArrays.m_arrays.end(),
+                                    [&key, &rArrays] (TextureArraysGL::Array const& array)
+    {
+        return array.key == key && array.used < rArrays.m_layersPerArray;
+    });
+
+    auto const arrayIndex = std::uint32_t(std::distance(rArrays.m_arrays.begin(), found));
+    if (found == rArrays.m_arrays.end())
+    {
+        Magnum::GL::Texture2DArray texture;
+        texture .setMinificationFilter(key.minFilter, key.mipmapFilter)
+                .setMagnificationFilter(key.magFilter)
+                .setWrapping(Magnum::Math::Vector2<Magnum::SamplerWrapping>{key.wrapX, key.wrapY})
+                .setStorage(levels,
+                            imgData.isCompressed() ? Magnum::GL::textureFormat(imgData.compressedFormat())
+                                                   : Magnum::GL::textureFormat(imgData.format()),
+                            {key.size, rArrays.m_layersPerArray});
+        rArrays.m_arrays.push_back({key, std::move(texture), 0});
+    }
+
+    TextureArraysGL::Array &rArray = rArrays.m_arrays[arrayIndex];
+    int const layer = rArray.used ++;
+
+    std::size_t bytes = 0;
+    if (imgData.isCompressed())
+    {
+        Magnum::CompressedImageView3D const pixels{imgData.compressedStorage(), imgData.compressedFormat(),
+                                                   {imgData.size(), 1}, imgData.data()};
+        rArray.texture.setCompressedSubImage(0, {0, 0, layer}, pixels);
+        bytes = imgData.data().size();
+    }
+    else
+    {
+        for (int level = 0; level < levels; ++level)
+        {
+            Magnum::ImageView2D const view = mip_level_view(rResources, imgRes, imgData, level);
+            Magnum::ImageView3D const pixels{view.storage(), view.format(), {view.size(), 1}, view.data()};
+            rArray.texture.setSubImage(level, {0, 0, layer}, pixels);
+            bytes += view.data().size();
+        }
+    }
+
+    rArrays.m_layers.emplace(texId, TextureArraysGL::Layer{arrayIndex, layer});
+    return bytes;
+}
+
+/**
+ * @brief Upload a texture resource to a TexGlId through a pixel buffer, replacing any placeholder
+ *
+ * @return Bytes uploaded
+ */
+static std::size_t upload_texture(RenderGL& rRenderGl, osp::Resources& rResources, TexGlId const texId, ResId const texRes)
+{
+    using Magnum::GL::BufferImage2D;
+    using Magnum::GL::CompressedBufferImage2D;
+    using Magnum::GL::BufferUsage;
+    using Magnum::GL::textureFormat;
+
+    ResId const imgRes = rResources.data_get<osp::TextureImgSource>(osp::restypes::gc_texture, texRes);
+    auto const &texData = rResources.data_get<TextureData>(osp::restypes::gc_texture, texRes);
+    auto const &imgData = rResources.data_get<ImageData2D>(osp::restypes::gc_image, imgRes);
+
+    if (texData.type() != Magnum::Trade::TextureType::Texture2D)
+    {
+
+        OSP_LOG_WARN("Unsupported texture type for texture resource: {}",
+                     rResources.name(osp::restypes::gc_texture, texRes));
+
+        // Counted as resident to not retry every frame
+        set_resident(rRenderGl.m_gpuMemory, rRenderGl.m_gpuMemory.m_textures, texId, 0);
+        return 0;
+    }
+
+    if (imgData.isCompressed() && ! compressed_format_supported(imgData.compressedFormat()))
+    {
+        OSP_LOG_WARN("Compressed format of texture resource {} not supported by the GPU, "
+                     "import Basis images with a different target format",
+                     rResources.name(osp::restypes::gc_texture, texRes));
+
+        // Placeholder stays, counted as resident to not retry every frame
+        set_resident(rRenderGl.m_gpuMemory, rRenderGl.m_gpuMemory.m_textures, texId, 0);
+        return 0;
+    }
+
+    std::size_t const packedBytes = pack_texture_layer(rRenderGl, rResources, texId, texRes);
+
+    TextureMipsGL &rMips = rRenderGl.m_texMips;
+    int const maxExtent = std::max(imgData.size().x(), imgData.size().y());
+    if (rMips.m_minSize != 0 && maxExtent >= rMips.m_minSize && osp::mip_chain_supported(imgData))
+    {
+        TextureMipsGL::Entry &rEntry = rMips.m_textures[texId];
+        rEntry.levels = std::uint8_t(osp::mip_level_count(imgData.size()));
+
+        // Start with the coarse tail, finer levels are streamed in once they're known to be needed
+        int base = 0;
+        while (base + 1 < rEntry.levels && (maxExtent >> base) > rMips.m_initialSize)
+        {
+            ++base;
+        }
+        return packedBytes + upload_texture_levels(rRenderGl, rResources, texId, texRes, base);
+    }
+
+    Texture2D texture;
+    texture .setMinificationFilter(texData.minificationFilter(), texData.mipmapFilter())
+            .setMagnificationFilter(texData.magnificationFilter())
+            .setWrapping(texData.wrapping().xy());
+
+    // Pixel data is copied into a buffer first, letting the driver transfer it to the texture
+    // asynchronously instead of stalling on glTexSubImage
+    if (imgData.isCompressed())
+    {
+        // Blocks are uploaded as-is, already transcoded to a GPU format while importing
+        CompressedBufferImage2D pixels{imgData.compressedStorage(), imgData.compressedFormat(),
+                                       imgData.size(), imgData.data(), BufferUsage::StreamDraw};
+        texture .setStorage(1, textureFormat(imgData.compressedFormat()), imgData.size())
+                .setCompressedSubImage(0, {}, pixels);
+    }
+    else
+    {
+        BufferImage2D pixels{imgData.storage(), imgData.format(), imgData.size(), imgData.data(), BufferUsage::StreamDraw};
+        texture .setStorage(1, textureFormat(imgData.format()), imgData.size())
+                .setSubImage(0, {}, pixels);
     }
+
+    store_texture(rRenderGl, texId, std::move(texture));
+
+    std::size_t const bytes = imgData.data().size();
+    set_resident(rRenderGl.m_gpuMemory, rRenderGl.m_gpuMemory.m_textures, texId, bytes);
+    return packedBytes + bytes;
+}
+
+/**
+ * @brief Compile a mesh resource to a MeshGlId, replacing any placeholder
+ *
+ * @return Bytes uploaded
+ */
+static std::size_t upload_mesh(RenderGL& rRenderGl, osp::Resources& rResources, MeshGlId const meshId, ResId const meshRes)
+{
+    auto const &meshData = rResources.data_get<MeshData>(osp::restypes::gc_mesh, meshRes);
+
+    if (rRenderGl.m_meshGl.contains(meshId))
+    {
+        rRenderGl.m_meshGl.get(meshId) = Magnum::MeshTools::compile(meshData);
+
+        // Instance attributes were attached to the placeholder
+        detach_instances(rRenderGl, meshId);
+    }
+    else
+    {
+        rRenderGl.m_meshGl.emplace(meshId, Magnum::MeshTools::compile(meshData));
+    }
+
+    std::size_t const bytes = meshData.vertexData().size() + meshData.indexData().size();
+    set_resident(rRenderGl.m_gpuMemory, rRenderGl.m_gpuMemory.m_meshes, meshId, bytes);
+    return bytes;
 }
 
 void SysRenderGL::compile_resource_textures(
@@ -130,10 +545,6 @@ void SysRenderGL::compile_resource_textures(
         // New element emplaced, this means we've just found a resource that
         // isn't synchronized yet.
 
-        using Magnum::GL::SamplerWrapping;
-        using Magnum::GL::SamplerFilter;
-        using Magnum::GL::textureFormat;
-
         // Create new Texture GL Id
         TexGlId const newId = rRenderGl.m_texIds.create();
 
@@ -145,25 +556,17 @@ void SysRenderGL::compile_resource_textures(
         rRenderGl.m_texToRes.emplace(newId, std::move(renderOwner));
         it->second = newId;
 
-        ResId const imgRes = rResources.data_get<TextureImgSource>(restypes::gc_texture, texRes);
-        auto const &texData = rResources.data_get<TextureData>(restypes::gc_texture, texRes);
-        auto const &imgData = rResources.data_get<ImageData2D>(restypes::gc_image, imgRes);
-
-        if (texData.type() != Magnum::Trade::TextureType::Texture2D)
+        if (rRenderGl.m_uploads.m_budgetBytes == 0)
         {
-
-            OSP_LOG_WARN("Unsupported texture type for texture resource: {}",
-                         rResources.name(restypes::gc_texture, texRes));
-            continue;
+            upload_texture(rRenderGl, rResources, newId, texRes);
+        }
+        else
+        {
+            // Placeholder until the upload queue gets to it
+            rRenderGl.m_texGl.emplace(newId, placeholder_texture());
+            rRenderGl.m_uploads.m_textures.push_back(newId);
+            rRenderGl.m_gpuMemory.m_textures[newId].state = GpuMemoryGL::EState::Queued;
         }
-
-        rRenderGl.m_texGl.emplace(newId)
-                .setMinificationFilter(texData.minificationFilter(),
-                                       texData.mipmapFilter())
-                .setMagnificationFilter(texData.magnificationFilter())
-                .setWrapping(texData.wrapping().xy())
-                .setStorage(1, textureFormat(imgData.format()), imgData.size())
-                .setSubImage(0, {}, imgData);
     }
 }
 
@@ -172,6 +575,8 @@ void SysRenderGL::compile_resource_meshes(
         Resources&              rResources,
         RenderGL&               rRenderGl)
 {
+    OSP_PROFILE_ZONE("SysRenderGL::compile_resource_meshes");
+
     // TODO: Eventually have dirty flags instead of checking every entry.
 
     for ([[maybe_unused]] auto const & [_, scnOwner] : rCtxDrawRes.m_meshToRes)
@@ -199,116 +604,428 @@ void SysRenderGL::compile_resource_meshes(
         rRenderGl.m_meshToRes.emplace(newId, std::move(renderOwner));
         it->second = newId;
 
-        // Get mesh data
-        auto const &meshData = rResources.data_get<MeshData>(restypes::gc_mesh, meshRes);
-
-        // Compile and store mesh
-        rRenderGl.m_meshGl.emplace(newId, Magnum::MeshTools::compile(meshData));
+        if (rRenderGl.m_uploads.m_budgetBytes == 0)
+        {
+            upload_mesh(rRenderGl, rResources, newId, meshRes);
+        }
+        else
+        {
+            // Empty placeholder draws nothing until the upload queue gets to it
+            rRenderGl.m_meshGl.emplace(newId);
+            rRenderGl.m_uploads.m_meshes.push_back(newId);
+            rRenderGl.m_gpuMemory.m_meshes[newId].state = GpuMemoryGL::EState::Queued;
+        }
     }
 }
 
-void SysRenderGL::sync_drawent_mesh(
-        DrawEnt const                               ent,
-        KeyedVec<DrawEnt, MeshIdOwner_t> const&     cmpMeshIds,
-        IdMap_t<MeshId, ResIdOwner_t> const&        meshToRes,
-        MeshGlEntStorage_t&                         rCmpMeshGl,
-        RenderGL&                                   rRenderGl)
+void SysRenderGL::process_uploads(RenderGL& rRenderGl, Resources& rResources)
 {
-    ACompMeshGl &rEntMeshGl = rCmpMeshGl[ent];
-    MeshIdOwner_t const& entMeshScnId = cmpMeshIds[ent];
+    UploadQueueGL &rUploads = rRenderGl.m_uploads;
 
-    // Make sure dirty entity has a MeshId component
-    if (entMeshScnId.has_value())
+    std::size_t budgetLeft = rUploads.m_budgetBytes;
+    rUploads.m_lastUploadedBytes = 0;
+
+    // Always upload at least one item per frame, even if it's bigger than the budget
+    auto const process = [&] (auto& rQueue, auto& rIdToRes, auto const& upload_func)
     {
-        // Check if scene mesh ID is properly synchronized
-        if (rEntMeshGl.m_scnId == entMeshScnId)
+        std::size_t done = 0;
+        while (done < rQueue.size() && (budgetLeft != 0 || rUploads.m_lastUploadedBytes == 0))
         {
-            return; // No changes needed
+            auto const glId = rQueue[done];
+            ++done;
+
+            auto const foundIt = rIdToRes.find(glId);
+            if (foundIt == rIdToRes.end())
+            {
+                continue; // Resource owner was cleared before it could be uploaded
+            }
+
+            std::size_t const bytes = upload_func(rRenderGl, rResources, glId, foundIt->second.value());
+            rUploads.m_lastUploadedBytes += bytes;
+            budgetLeft -= std::min(budgetLeft, bytes);
         }
+        rQueue.erase(rQueue.begin(), rQueue.begin() + std::ptrdiff_t(done));
+    };
 
-        rEntMeshGl.m_scnId = entMeshScnId;
-
-        // Check if MeshId is associated with a resource
-        if (auto const& foundIt = meshToRes.find(entMeshScnId);
-            foundIt != meshToRes.end())
-        {
-            ResId const meshResId = foundIt->second;
+    process(rUploads.m_meshes,   rRenderGl.m_meshToRes, upload_mesh);
+    process(rUploads.m_textures, rRenderGl.m_texToRes,  upload_texture);
 
-            // Mesh should have been loaded beforehand, assign it!
-            rEntMeshGl.m_glId = rRenderGl.m_resToMesh.at(meshResId);
-        }
-        else
+    // Leftover budget streams finer mip levels. Without a budget, all needed levels go at once.
+    TextureMipsGL &rMips = rRenderGl.m_texMips;
+    bool const unlimited = rUploads.m_budgetBytes == 0;
+    std::size_t kept = 0;
+    for (TexGlId const texId : rMips.m_queue)
+    {
+        auto const mipIt = rMips.m_textures.find(texId);
+        auto const resIt = rRenderGl.m_texToRes.find(texId);
+        auto const memIt = rRenderGl.m_gpuMemory.m_textures.find(texId);
+        if (   mipIt == rMips.m_textures.end() || resIt == rRenderGl.m_texToRes.end()
+            || memIt == rRenderGl.m_gpuMemory.m_textures.end()
+            || memIt->second.state != GpuMemoryGL::EState::Resident)
         {
-            OSP_LOG_WARN("No mesh data found for Mesh {} from Entity {}",
-                         std::size_t(entMeshScnId.value()), std::size_t(ent));
+            if (mipIt != rMips.m_textures.end())
+            {
+                mipIt->second.queued = false; // Cleared or evicted, queued again once re-uploaded
+            }
+            continue;
         }
-    }
-    else
-    {
-        if (rEntMeshGl.m_glId != lgrn::id_null<MeshGlId>())
+
+        TextureMipsGL::Entry &rEntry = mipIt->second;
+        while (rEntry.wantedBase < rEntry.residentBase && (unlimited || budgetLeft != 0))
         {
-            // ACompMesh removed, remove ACompMeshGL too
-            rEntMeshGl = {};
+            std::size_t const bytes = stream_finer_level(rRenderGl, rResources, texId, resIt->second.value());
+            rUploads.m_lastUploadedBytes += bytes;
+            budgetLeft -= std::min(budgetLeft, bytes);
         }
-        else
+
+        rEntry.queued = rEntry.wantedBase < rEntry.residentBase;
+        if (rEntry.queued)
         {
-            // Why is this entity here?
+            rMips.m_queue[kept] = texId;
+            ++kept;
         }
     }
+    rMips.m_queue.resize(kept);
 }
 
-void SysRenderGL::sync_drawent_texture(
-        DrawEnt const                               ent,
-        KeyedVec<DrawEnt, TexIdOwner_t> const&      cmpTexIds,
-        IdMap_t<TexId, ResIdOwner_t> const&         texToRes,
-        TexGlEntStorage_t&                          rCmpTexGl,
-        RenderGL&                                   rRenderGl)
+void SysRenderGL::update_gpu_memory(
+        RenderGL&                           rRenderGl,
+        Resources&                          rResources,
+        ACtxSceneRenderGL const&            scnRenderGl,
+        lgrn::IdRegistryStl<DrawEnt> const& drawIds)
 {
-    ACompTexGl &rEntTexGl = rCmpTexGl[ent];
-    TexIdOwner_t const& entTexScnId = cmpTexIds[ent];
+    GpuMemoryGL &rGpuMem = rRenderGl.m_gpuMemory;
+    rGpuMem.m_lastEvicted = 0;
 
-    // Make sure dirty entity has a MeshId component
-    if (entTexScnId.has_value())
+    if (rGpuMem.m_budgetBytes == 0)
     {
-        // Check if scene mesh ID is properly synchronized
-        if (rEntTexGl.m_scnId == entTexScnId)
+        return;
+    }
+
+    ++rGpuMem.m_frame;
+
+    bool const uploadNow = rRenderGl.m_uploads.m_budgetBytes == 0;
+
+    auto const use = [&] (auto& rEntries, auto const glId, auto& rQueue, auto const& idToRes, auto const& upload_func)
+    {
+        auto const foundIt = rEntries.find(glId);
+        if (foundIt == rEntries.end())
         {
-            return; // No changes needed
+            return;
         }
 
-        rEntTexGl.m_scnId = entTexScnId;
+        GpuMemoryGL::Entry &rEntry = foundIt->second;
+        rEntry.lastUsed = rGpuMem.m_frame;
 
-        // Check if MeshId is associated with a resource
-        if (auto const& foundIt = texToRes.find(entTexScnId);
-            foundIt != texToRes.end())
+        if (rEntry.state == GpuMemoryGL::EState::Evicted)
         {
-            ResId const texResId = foundIt->second;
+            if (uploadNow)
+            {
+                upload_func(rRenderGl, rResources, glId, idToRes.at(glId).value());
+            }
+            else
+            {
+                rEntry.state = GpuMemoryGL::EState::Queued;
+                rQueue.push_back(glId);
+            }
+        }
+    };
 
-            // Mesh should have been loaded beforehand, assign it!
-            rEntTexGl.m_glId = rRenderGl.m_resToTex.at(texResId);
+    for (DrawEnt const drawEnt : drawIds)
+    {
+        if (scnRenderGl.m_meshId.size() > std::size_t(drawEnt))
+        {
+            MeshGlId const meshId = scnRenderGl.m_meshId[drawEnt].m_glId;
+            if (meshId != lgrn::id_null<MeshGlId>())
+            {
+                use(rGpuMem.m_meshes, meshId, rRenderGl.m_uploads.m_meshes, rRenderGl.m_meshToRes, upload_mesh);
+            }
         }
-        else
+
+        if (scnRenderGl.m_diffuseTexId.size() > std::size_t(drawEnt))
         {
-            OSP_LOG_WARN("No mesh data found for Mesh {} from Entity {}",
-                         std::size_t(entTexScnId.value()), std::size_t(ent));
+            TexGlId const texId = scnRenderGl.m_diffuseTexId[drawEnt].m_glId;
+            if (texId != lgrn::id_null<TexGlId>())
+            {
+                use(rGpuMem.m_textures, texId, rRenderGl.m_uploads.m_textures, rRenderGl.m_texToRes, upload_texture);
+            }
         }
     }
-    else
+
+    if (rGpuMem.m_residentBytes <= rGpuMem.m_budgetBytes)
     {
-        if (rEntTexGl.m_glId != lgrn::id_null<TexGlId>())
+        return;
+    }
+
+    // Over budget, first drop mip levels finer than what streamed textures need right now
+    TextureMipsGL &rMips = rRenderGl.m_texMips;
+    for (auto const& [texId, mip] : rMips.m_textures)
+    {
+        if (rGpuMem.m_residentBytes <= rGpuMem.m_budgetBytes)
         {
-            // ACompMesh removed, remove ACompMeshGL too
-            rEntTexGl = {};
+            return;
         }
-        else
+
+        GpuMemoryGL::Entry const &rEntry = rGpuMem.m_textures.at(texId);
+        if (   rEntry.state == GpuMemoryGL::EState::Resident
+            && mip.wantedFrame == rMips.m_frame && mip.residentBase < mip.wantedBase)
+        {
+            std::size_t const before = rEntry.bytes;
+            upload_texture_levels(rRenderGl, rResources, texId, rRenderGl.m_texToRes.at(texId).value(), mip.wantedBase);
+            rGpuMem.m_lastEvicted += before - std::min(before, rEntry.bytes);
+        }
+    }
+
+    // Still over budget, evict least recently used resources that nothing uses this frame
+
+    rGpuMem.m_candidates.clear();
+    for (auto const& [meshId, entry] : rGpuMem.m_meshes)
+    {
+        if (entry.state == GpuMemoryGL::EState::Resident && entry.lastUsed != rGpuMem.m_frame)
+        {
+            rGpuMem.m_candidates.push_back({entry.lastUsed, std::uint32_t(meshId), false});
+        }
+    }
+    for (auto const& [texId, entry] : rGpuMem.m_textures)
+    {
+        if (entry.state == GpuMemoryGL::EState::Resident && entry.lastUsed != rGpuMem.m_frame)
+        {
+            rGpuMem.m_candidates.push_back({entry.lastUsed, std::uint32_t(texId), true});
+        }
+    }
+
+    std::sort(rGpuMem.m_candidates.begin(), rGpuMem.m_candidates.end(),
+              [] (GpuMemoryGL::Candidate const& lhs, GpuMemoryGL::Candidate const& rhs)
+    {
+        return lhs.lastUsed < rhs.lastUsed;
+    });
+
+    for (GpuMemoryGL::Candidate const& candidate : rGpuMem.m_candidates)
+    {
+        if (rGpuMem.m_residentBytes <= rGpuMem.m_budgetBytes)
+        {
+            break;
+        }
+
+        GpuMemoryGL::Entry *pEntry;
+        if (candidate.isTexture)
+        {
+            auto const texId = TexGlId(candidate.id);
+            rRenderGl.m_texGl.get(texId) = placeholder_texture();
+            pEntry = &rGpuMem.m_textures.at(texId);
+
+            if (auto const mipIt = rMips.m_textures.find(texId);
+                mipIt != rMips.m_textures.end())
+            {
+                mipIt->second.residentBase = mipIt->second.levels;
+            }
+        }
+        else
+        {
+            auto const meshId = MeshGlId(candidate.id);
+            rRenderGl.m_meshGl.get(meshId) = Mesh{};
+            detach_instances(rRenderGl, meshId);
+            pEntry = &rGpuMem.m_meshes.at(meshId);
+        }
+
+        rGpuMem.m_residentBytes -= pEntry->bytes;
+        rGpuMem.m_lastEvicted   += pEntry->bytes;
+        pEntry->bytes = 0;
+        pEntry->state = GpuMemoryGL::EState::Evicted;
+    }
+}
+
+void SysRenderGL::estimate_texture_mips(
+        RenderGL&                           rRenderGl,
+        ACtxSceneRenderGL const&            scnRenderGl,
+        lgrn::IdSetStl<DrawEnt> const&      visible,
+        KeyedVec<DrawEnt, float> const&     screenSize,
+        int const                           viewHeight)
+{
+    TextureMipsGL &rMips = rRenderGl.m_texMips;
+    if (rMips.m_minSize == 0)
+    {
+        return;
+    }
+
+    ++rMips.m_frame;
+
+    for (DrawEnt const drawEnt : visible)
+    {
+        if (   scnRenderGl.m_diffuseTexId.size() <= std::size_t(drawEnt)
+            || screenSize.size() <= std::size_t(drawEnt))
+        {
+            continue;
+        }
+
+        auto const mipIt = rMips.m_textures.find(scnRenderGl.m_diffuseTexId[drawEnt].m_glId);
+        if (mipIt == rMips.m_textures.end())
+        {
+            continue;
+        }
+
+        TextureMipsGL::Entry &rEntry = mipIt->second;
+        int const coarsest = rEntry.levels - 1;
+
+        // Level 0 spans about 2^coarsest texels. Unknown bounds need full resolution.
+        int level = 0;
+        if (float const pixels = screenSize[drawEnt] * float(viewHeight);
+            pixels > 0.0f)
+        {
+            float const fine = float(coarsest) - std::log2(std::max(pixels, 1.0f)) + rMips.m_bias;
+            level = std::clamp(int(std::floor(fine)), 0, coarsest);
+        }
+
+        if (rEntry.wantedFrame != rMips.m_frame)
+        {
+            rEntry.wantedFrame = rMips.m_frame;
+            rEntry.wantedBase  = std::uint8_t(level);
+        }
+        else
+        {
+            rEntry.wantedBase  = std::min(rEntry.wantedBase, std::uint8_t(level));
+        }
+
+        if ( ! rEntry.queued && rEntry.wantedBase < rEntry.residentBase && rEntry.residentBase < rEntry.levels )
+        {
+            rEntry.queued = true;
+            rMips.m_queue.push_back(mipIt->first);
+        }
+    }
+}
+
+void SysRenderGL::sync_drawent_mesh(
+        DrawEnt const                               ent,
+        KeyedVec<DrawEnt, MeshIdOwner_t> const&     cmpMeshIds,
+        IdMap_t<MeshId, ResIdOwner_t> const&        meshToRes,
+        MeshGlEntStorage_t&                         rCmpMeshGl,
+        RenderGL&                                   rRenderGl)
+{
+    ACompMeshGl &rEntMeshGl = rCmpMeshGl[ent];
+    MeshIdOwner_t const& entMeshScnId = cmpMeshIds[ent];
+
+    // Make sure dirty entity has a MeshId component
+    if (entMeshScnId.has_value())
+    {
+        // Check if scene mesh ID is properly synchronized
+        if (rEntMeshGl.m_scnId == entMeshScnId)
+        {
+            return; // No changes needed
+        }
+
+        rEntMeshGl.m_scnId = entMeshScnId;
+
+        // Check if MeshId is associated with a resource
+        if (auto const& foundIt = meshToRes.find(entMeshScnId);
+            foundIt != meshToRes.end())
+        {
+            ResId const meshResId = foundIt->second;
+
+            // Mesh should have been loaded beforehand, assign it!
+            rEntMeshGl.m_glId = rRenderGl.m_resToMesh.at(meshResId);
+        }
+        else
+        {
+            OSP_LOG_WARN("No mesh data found for Mesh {} from Entity {}",
+                         std::size_t(entMeshScnId.value()), std::size_t(ent));
+        }
+    }
+    else
+    {
+        if (rEntMeshGl.m_glId != lgrn::id_null<MeshGlId>())
+        {
+            // ACompMesh removed, remove ACompMeshGL too
+            rEntMeshGl = {};
+        }
+        else
+        {
+            // Why is this entity here?
+        }
+    }
+}
+
+void SysRenderGL::sync_drawent_texture(
+        DrawEnt const                               ent,
+        KeyedVec<DrawEnt, TexIdOwner_t> const&      cmpTexIds,
+        IdMap_t<TexId, ResIdOwner_t> const&         texToRes,
+        TexGlEntStorage_t&                          rCmpTexGl,
+        RenderGL&                                   rRenderGl)
+{
+    ACompTexGl &rEntTexGl = rCmpTexGl[ent];
+    TexIdOwner_t const& entTexScnId = cmpTexIds[ent];
+
+    // Make sure dirty entity has a MeshId component
+    if (entTexScnId.has_value())
+    {
+        // Check if scene mesh ID is properly synchronized
+        if (rEntTexGl.m_scnId == entTexScnId)
+        {
+            return; // No changes needed
+        }
+
+        rEntTexGl.m_scnId = entTexScnId;
+
+        // Check if MeshId is associated with a resource
+        if (auto const& foundIt = texToRes.find(entTexScnId);
+            foundIt != texToRes.end())
+        {
+            ResId const texResId = foundIt->second;
+
+            // Mesh should have been loaded beforehand, assign it!
+            rEntTexGl.m_glId = rRenderGl.m_resToTex.at(texResId);
+        }
+        else
+        {
+            OSP_LOG_WARN("No mesh data found for Mesh {} from Entity {}",
+                         std::size_t(entTexScnId.value()), std::size_t(ent));
+        }
+    }
+    else
+    {
+        if (rEntTexGl.m_glId != lgrn::id_null<TexGlId>())
+        {
+            // ACompMesh removed, remove ACompMeshGL too
+            rEntTexGl = {};
+        }
+        else
         {
             // Why is this entity here?
         }
     }
 }
 
+void SysRenderGL::sync_drawent_lods(
+        ACtxSceneRender const&                      scnRender,
+        IdMap_t<MeshId, ResIdOwner_t> const&        meshToRes,
+        MeshGlEntStorage_t&                         rCmpMeshGl,
+        RenderGL const&                             rRenderGl)
+{
+    for (auto const& [drawEnt, lods] : scnRender.m_lods)
+    {
+        MeshIdOwner_t const& owner = (lods.m_current == 0)
+                                   ? scnRender.m_mesh[drawEnt]
+                                   : lods.m_meshes[lods.m_current - 1];
+        if ( ! owner.has_value() )
+        {
+            continue;
+        }
+
+        auto const resIt = meshToRes.find(owner.value());
+        if (resIt == meshToRes.end())
+        {
+            continue;
+        }
+
+        auto const glIt = rRenderGl.m_resToMesh.find(resIt->second.value());
+        if (glIt != rRenderGl.m_resToMesh.end())
+        {
+            rCmpMeshGl[drawEnt].m_glId = glIt->second;
+        }
+    }
+}
+
 void SysRenderGL::display_texture(
-        RenderGL& rRenderGl, Magnum::GL::Texture2D& rTex)
+        RenderGL& rRenderGl, Magnum::GL::Texture2D& rTex, Magnum::Vector2i const rendered)
 {
     using Magnum::GL::Renderer;
     using Magnum::GL::Framebuffer;
@@ -322,6 +1039,20 @@ void SysRenderGL::display_texture(
     Renderer::disable(Renderer::Feature::Blending);
     Renderer::setDepthMask(GL_TRUE);
 
+    Magnum::Vector2 const fullSize{rRenderGl.m_renderScale.m_fullSize};
+    if (rendered == Magnum::Vector2i{} || fullSize.isZero())
+    {
+        rRenderGl.m_fullscreenTriShader.set_uv_range(Magnum::Vector2{1.0f}, Magnum::Vector2{1.0f});
+    }
+    else
+    {
+        // Stop half a texel short of the edge, as linear filtering would blend in texels outside
+        // of the rendered part
+        Magnum::Vector2 const renderedSize{rendered};
+        rRenderGl.m_fullscreenTriShader.set_uv_range(renderedSize / fullSize,
+                                                     (renderedSize - Magnum::Vector2{0.5f}) / fullSize);
+    }
+
     rRenderGl.m_fullscreenTriShader.display_texure(
             rRenderGl.m_meshGl.get(rRenderGl.m_fullscreenTri),
             rRenderGl.m_texGl.get(rRenderGl.m_fboColor));
@@ -340,12 +1071,16 @@ void SysRenderGL::clear_resource_owners(RenderGL& rRenderGl, Resources& rResourc
         rResources.owner_destroy(restypes::gc_mesh, std::move(rOwner));
     }
     rRenderGl.m_resToMesh.clear();
+
+    rRenderGl.m_gpuMemory.m_meshes.clear();
+    rRenderGl.m_gpuMemory.m_textures.clear();
+    rRenderGl.m_gpuMemory.m_residentBytes = 0;
+
+    rRenderGl.m_texMips.m_textures.clear();
+    rRenderGl.m_texMips.m_queue.clear();
 }
 
-void SysRenderGL::render_opaque(
-        RenderGroup const& group,
-        DrawEntSet_t const& visible,
-        ViewProjMatrix const& viewProj)
+static void set_state_opaque()
 {
     using Magnum::GL::Renderer;
 
@@ -353,14 +1088,10 @@ void SysRenderGL::render_opaque(
     Renderer::enable(Renderer::Feature::FaceCulling);
     Renderer::disable(Renderer::Feature::Blending);
     Renderer::setDepthMask(GL_TRUE);
-
-    draw_group(group, visible, viewProj);
+    Renderer::setDepthFunction(Renderer::DepthFunction::Less);
 }
 
-void SysRenderGL::render_transparent(
-        RenderGroup const& group,
-        DrawEntSet_t const& visible,
-        ViewProjMatrix const& viewProj)
+static void set_state_transparent()
 {
     using Magnum::GL::Renderer;
 
@@ -374,10 +1105,109 @@ void SysRenderGL::render_transparent(
     // temporary: disabled depth writing makes the plumes look nice, but
     //            can mess up other transparent objects once added
     //Renderer::setDepthMask(GL_FALSE);
+}
+
+void SysRenderGL::render_opaque(
+        RenderGroup const& group,
+        DrawEntSet_t const& visible,
+        ViewProjMatrix const& viewProj)
+{
+    set_state_opaque();
+    draw_group(group, visible, viewProj);
+}
 
+void SysRenderGL::render_transparent(
+        RenderGroup const& group,
+        DrawEntSet_t const& visible,
+        ViewProjMatrix const& viewProj)
+{
+    set_state_transparent();
     draw_group(group, visible, viewProj);
 }
 
+void SysRenderGL::render_depth_prepass(
+        RenderGL&                   rRenderGl,
+        RenderCmdBuffer const&      cmds,
+        ACtxSceneRenderGL const&    scnRenderGl,
+        DrawTransforms_t const&     drawTf)
+{
+    using Magnum::GL::Renderer;
+
+    set_state_opaque();
+    Renderer::setColorMask(false, false, false, false);
+
+    // The main pass uses different shaders, which don't produce bit-identical depth. Pushing the
+    // prepass back a little lets the main pass use LessOrEqual without dropping visible pixels.
+    Renderer::enable(Renderer::Feature::PolygonOffsetFill);
+    Renderer::setPolygonOffset(1.0f, 1.0f);
+
+    ViewProjMatrix const viewProj{cmds.m_view, cmds.m_proj, cmds.m_origin};
+    Magnum::Shaders::FlatGL3D &rShader = rRenderGl.m_depthPrepassShader;
+
+    for (RenderCmd const& cmd : cmds.m_cmds)
+    {
+        if (scnRenderGl.m_meshId.size() <= std::size_t(cmd.ent))
+        {
+            continue;
+        }
+
+        MeshGlId const meshId = scnRenderGl.m_meshId[cmd.ent].m_glId;
+        if (meshId == lgrn::id_null<MeshGlId>())
+        {
+            continue;
+        }
+
+        Mesh &rMesh = rRenderGl.m_meshGl.get(meshId);
+        rShader.setTransformationProjectionMatrix(viewProj.m_viewProjRotation * viewProj.origin_relative(drawTf[cmd.ent]))
+               .draw(rMesh);
+        count_draw(rRenderGl, rMesh);
+    }
+
+    Renderer::disable(Renderer::Feature::PolygonOffsetFill);
+    Renderer::setColorMask(true, true, true, true);
+}
+
+void SysRenderGL::render_opaque(
+        RenderCmdBuffer const&  cmds,
+        DrawEntSet_t const&     visible,
+        bool const              depthPrepassDone)
+{
+    using Magnum::GL::Renderer;
+
+    set_state_opaque();
+
+    if ( ! depthPrepassDone )
+    {
+        draw_cmds(cmds, visible);
+        return;
+    }
+
+    ViewProjMatrix const viewProj{cmds.m_view, cmds.m_proj, cmds.m_origin};
+
+    Renderer::setDepthFunction(Renderer::DepthFunction::LessOrEqual);
+    Renderer::setDepthMask(GL_FALSE);
+
+    for (RenderCmd const& cmd : cmds.m_cmds)
+    {
+        cmd.pToDraw->draw(cmd.ent, viewProj, cmd.pToDraw->data);
+    }
+
+    // Instanced entities weren't in the prepass
+    set_state_opaque();
+    for (InstancedToDraw const& toDraw : cmds.m_instanced)
+    {
+        toDraw.draw(visible, viewProj, toDraw.data);
+    }
+}
+
+void SysRenderGL::render_transparent(
+        RenderCmdBuffer const&  cmds,
+        DrawEntSet_t const&     visible)
+{
+    set_state_transparent();
+    draw_cmds(cmds, visible);
+}
+
 void SysRenderGL::draw_group(
         RenderGroup const& group,
         DrawEntSet_t const& visible,
@@ -390,4 +1220,422 @@ void SysRenderGL::draw_group(
             toDraw.draw(ent, viewProj, toDraw.data);
         }
     }
+
+    for (InstancedToDraw const& toDraw : group.instanced)
+    {
+        toDraw.draw(visible, viewProj, toDraw.data);
+    }
+}
+
+void SysRenderGL::draw_cmds(
+        RenderCmdBuffer const&  cmds,
+        DrawEntSet_t const&     visible)
+{
+    ViewProjMatrix const viewProj{cmds.m_view, cmds.m_proj, cmds.m_origin};
+
+    for (RenderCmd const& cmd : cmds.m_cmds)
+    {
+        cmd.pToDraw->draw(cmd.ent, viewProj, cmd.pToDraw->data);
+    }
+
+    for (InstancedToDraw const& toDraw : cmds.m_instanced)
+    {
+        toDraw.draw(visible, viewProj, toDraw.data);
+    }
+}
+
+void SysRenderGL::pass_begin(RenderGL& rRenderGl, ERenderPass const pass, RenderStats& rStats)
+{
+    using Magnum::GL::TimeQuery;
+
+    GpuPassTimerGL &rTimer = rRenderGl.m_passTimers[std::size_t(pass)];
+    TimeQuery &rQuery = rTimer.m_queries[rTimer.m_next];
+
+    if (rQuery.id() == 0)
+    {
+        rQuery = TimeQuery{TimeQuery::Target::TimeElapsed};
+    }
+    else if (rTimer.m_pending[rTimer.m_next])
+    {
+        rStats.passes[std::size_t(pass)].gpuTimeNs = rQuery.result<Magnum::UnsignedLong>();
+        rTimer.m_pending[rTimer.m_next] = false;
+    }
+
+    rRenderGl.m_passCounters = {};
+    rQuery.begin();
+
+    OSP_PROFILE_SPLIT_BEGIN(rTimer.m_cpuZone, gc_passZoneNames[std::size_t(pass)]);
+    OSP_PROFILE_GPU_SPLIT_BEGIN(rTimer.m_gpuZone, gc_passZoneNames[std::size_t(pass)]);
+}
+
+void SysRenderGL::pass_end(RenderGL& rRenderGl, ERenderPass const pass, RenderStats& rStats, RenderCmdBuffer const* pCmds)
+{
+    GpuPassTimerGL &rTimer = rRenderGl.m_passTimers[std::size_t(pass)];
+
+    OSP_PROFILE_GPU_SPLIT_END(rTimer.m_gpuZone);
+    OSP_PROFILE_SPLIT_END(rTimer.m_cpuZone);
+
+    rTimer.m_queries[rTimer.m_next].end();
+    rTimer.m_pending[rTimer.m_next] = true;
+    rTimer.m_next = (rTimer.m_next + 1) % GpuPassTimerGL::smc_latency;
+
+    RenderPassStats &rPass = rStats.passes[std::size_t(pass)];
+    std::uint64_t const gpuTimeNs = rPass.gpuTimeNs;
+    rPass = rRenderGl.m_passCounters;
+    rPass.gpuTimeNs = gpuTimeNs;
+
+    if (pCmds != nullptr)
+    {
+        rPass.shaderChanges     = pCmds->m_shaderChanges;
+        rPass.meshChanges       = pCmds->m_meshChanges;
+        rPass.textureChanges    = pCmds->m_textureChanges;
+    }
+}
+
+void SysRenderGL::update_render_scale(RenderScaleGL& rScale, RenderStats const& stats)
+{
+    if ( ! rScale.m_dynamic)
+    {
+        return;
+    }
+
+    ++ rScale.m_framesSinceChange;
+    if (rScale.m_framesSinceChange <= GpuPassTimerGL::smc_latency)
+    {
+        return; // Timer results don't include the last change yet
+    }
+
+    std::uint64_t gpuTimeNs = 0;
+    for (std::size_t i = 0; i < stats.passes.size(); ++i)
+    {
+        if (ERenderPass(i) != ERenderPass::Blit)
+        {
+            gpuTimeNs += stats.passes[i].gpuTimeNs;
+        }
+    }
+
+    if (gpuTimeNs == 0)
+    {
+        return; // No timer results yet
+    }
+
+    float const ratio = float(rScale.m_targetGpuTimeNs) / float(gpuTimeNs);
+    if (std::abs(ratio - 1.0f) <= rScale.m_tolerance)
+    {
+        return;
+    }
+
+    float const wanted  = rScale.m_scale * std::sqrt(ratio);
+    float const limited = std::clamp(wanted, rScale.m_scale - rScale.m_maxStep, rScale.m_scale + rScale.m_maxStep);
+    float const next    = std::clamp(limited, rScale.m_minScale, 1.0f);
+
+    if (next != rScale.m_scale)
+    {
+        rScale.m_scale              = next;
+        rScale.m_framesSinceChange  = 0;
+    }
+}
+
+Magnum::Vector2i SysRenderGL::render_scale_size(RenderScaleGL const& scale) noexcept
+{
+    Magnum::Vector2i const size{Magnum::Vector2{scale.m_fullSize} * std::clamp(scale.m_scale, 0.0f, 1.0f)};
+    return Magnum::Math::max(size, Magnum::Vector2i{1});
+}
+
+void SysRenderGL::depth_readback_begin(RenderGL& rRenderGl, Matrix4 const& viewProj)
+{
+    using namespace Magnum;
+
+    DepthReadbackGL &rReadback = rRenderGl.m_depthReadback;
+
+    // Into a pixel pack buffer, so this returns before the GPU is done
+    rRenderGl.m_fbo.read(Range2Di{{0, 0}, rRenderGl.m_renderScale.m_renderedSize},
+                         rReadback.m_image, GL::BufferUsage::StreamRead);
+    rReadback.m_viewProj = viewProj;
+    rReadback.m_pending  = true;
+}
+
+bool SysRenderGL::depth_readback_end(RenderGL& rRenderGl, DepthPyramid& rPyramid)
+{
+    using namespace Magnum;
+
+    DepthReadbackGL &rReadback = rRenderGl.m_depthReadback;
+
+    if ( ! std::exchange(rReadback.m_pending, false) )
+    {
+        rPyramid.m_levels.clear();
+        return false;
+    }
+
+    Vector2i const      size    = rReadback.m_image.size();
+    std::size_t const   count   = std::size_t(size.x()) * std::size_t(size.y());
+    GL::Buffer          &rBuf   = rReadback.m_image.buffer();
+
+    Corrade::Containers::ArrayView<char> const mapped = rBuf.map(0, GLsizeiptr(count * sizeof(float)), GL::Buffer::MapFlag::Read);
+    if (mapped.data() == nullptr)
+    {
+        rPyramid.m_levels.clear();
+        return false;
+    }
+
+    // Rows are tightly packed, as floats satisfy the default pack alignment of 4
+    Corrade::Containers::ArrayView<float const> const depth{reinterpret_cast<float const*>(mapped.data()), count};
+    Corrade::Containers::StridedArrayView2D<float const> const rows{depth, {std::size_t(size.y()), std::size_t(size.x())}};
+    SysCulling::build_depth_pyramid(rPyramid, rows, rReadback.m_viewProj);
+
+    rBuf.unmap();
+    return true;
+}
+
+static void attach_instance_attributes(Magnum::GL::Mesh& rMesh, Magnum::GL::Buffer& rBuffer)
+{
+    using Magnum::Shaders::GenericGL3D;
+
+    // Same layout for all shaders; attributes a shader doesn't declare are ignored
+    rMesh.addVertexBufferInstanced(
+            rBuffer, 1, 0,
+            GenericGL3D::TransformationMatrix{},
+            GenericGL3D::NormalMatrix{},
+            GenericGL3D::Color4{},
+            GenericGL3D::TextureOffsetLayer{});
+}
+
+static void frame_ring_create(osp::draw::FrameRingBufferGL& rRing, std::size_t const frameSize)
+{
+    using Magnum::GL::Buffer;
+
+    std::size_t const totalSize = frameSize * osp::draw::FrameRingBufferGL::smc_frames;
+
+    rRing.m_buffer = Buffer{};
+    rRing.m_buffer.setStorage(totalSize, Buffer::StorageFlag::MapWrite
+                                       | Buffer::StorageFlag::MapPersistent
+                                       | Buffer::StorageFlag::MapCoherent);
+    rRing.m_mapped = rRing.m_buffer.map(0, totalSize, Buffer::MapFlag::Write
+                                                    | Buffer::MapFlag::Persistent
+                                                    | Buffer::MapFlag::Coherent);
+    rRing.m_frameSize = frameSize;
+}
+
+void SysRenderGL::setup_frame_ring(RenderGL& rRenderGl, std::size_t const frameSize)
+{
+    using namespace Magnum;
+
+    GL::Context &rContext = GL::Context::current();
+    if (   ! rContext.isExtensionSupported<GL::Extensions::ARB::buffer_storage>()
+        || ! rContext.isExtensionSupported<GL::Extensions::ARB::base_instance>() )
+    {
+        OSP_LOG_INFO("Persistent mapped buffers not supported, streaming with glBufferData instead");
+        return;
+    }
+
+    frame_ring_create(rRenderGl.m_frameRing, frameSize);
+    rRenderGl.m_frameRing.m_enabled = true;
+}
+
+void SysRenderGL::frame_ring_begin(RenderGL& rRenderGl)
+{
+    FrameRingBufferGL &rRing = rRenderGl.m_frameRing;
+    if ( ! rRing.m_enabled )
+    {
+        return;
+    }
+
+    rRing.m_frame = (rRing.m_frame + 1) % FrameRingBufferGL::smc_frames;
+    rRing.m_used  = 0;
+
+    GLsync &rFence = rRing.m_fences[rRing.m_frame];
+    if (rFence != nullptr)
+    {
+        // Usually already signaled; the GPU rarely lags 3 frames behind
+        while (glClientWaitSync(rFence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED)
+        { }
+        glDeleteSync(rFence);
+        rFence = nullptr;
+    }
+}
+
+void SysRenderGL::multi_draw_indirect(
+        RenderGL&                               rRenderGl,
+        Magnum::GL::AbstractShaderProgram&      rShader,
+        Mesh&                                   rMesh,
+        Magnum::GL::Buffer&                     rCmds,
+        std::uint32_t const                     cmdCount,
+        std::uint64_t const                     triangles)
+{
+    using Magnum::GL::Context;
+
+    if (cmdCount == 0)
+    {
+        return;
+    }
+
+    // Buffers, the program and VAO bound here are not known to Magnum. EnterExternal unbinds the
+    // current VAO so these calls can't modify it, and ExitExternal forgets all cached bindings.
+    Context::current().resetState(Context::State::EnterExternal);
+
+    glUseProgram(rShader.id());
+    glBindVertexArray(rMesh.id());
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, rCmds.id());
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, GLsizei(cmdCount), 0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glBindVertexArray(0);
+
+    Context::current().resetState(Context::State::ExitExternal);
+
+    rRenderGl.m_passCounters.drawCalls += 1;
+    rRenderGl.m_passCounters.instances += cmdCount;
+    rRenderGl.m_passCounters.triangles += triangles;
+}
+
+void SysRenderGL::frame_ring_end(RenderGL& rRenderGl)
+{
+    FrameRingBufferGL &rRing = rRenderGl.m_frameRing;
+    if ( ! rRing.m_enabled )
+    {
+        return;
+    }
+
+    rRing.m_fences[rRing.m_frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+std::size_t SysRenderGL::frame_ring_alloc(RenderGL& rRenderGl, std::size_t const size, std::size_t const alignment)
+{
+    FrameRingBufferGL &rRing = rRenderGl.m_frameRing;
+    LGRN_ASSERTM(rRing.m_enabled, "Frame ring not enabled");
+
+    std::size_t aligned = (rRing.m_used + alignment - 1) / alignment * alignment;
+
+    if (aligned + size > rRing.m_frameSize)
+    {
+        // Grow. Fences refer to the old buffer, which is freed by the driver once unused.
+        for (GLsync &rFence : rRing.m_fences)
+        {
+            if (rFence != nullptr)
+            {
+                glDeleteSync(std::exchange(rFence, nullptr));
+            }
+        }
+
+        std::size_t newSize = rRing.m_frameSize * 2;
+        while (newSize < size + alignment)
+        {
+            newSize *= 2;
+        }
+        frame_ring_create(rRing, newSize);
+        rRing.m_frame = 0;
+        aligned = 0;
+
+        // Meshes must now point to the new buffer
+        for (MeshGlId const meshId : rRenderGl.m_frameRingMeshes)
+        {
+            attach_instance_attributes(rRenderGl.m_meshGl.get(meshId), rRing.m_buffer);
+        }
+    }
+
+    rRing.m_used = aligned + size;
+    return rRing.m_frame * rRing.m_frameSize + aligned;
+}
+
+Magnum::GL::Buffer& SysRenderGL::mesh_instance_buffer(RenderGL& rRenderGl, MeshGlId const meshId)
+{
+    if (rRenderGl.m_meshInstanceBuf.contains(meshId))
+    {
+        return rRenderGl.m_meshInstanceBuf.get(meshId);
+    }
+
+    Magnum::GL::Buffer &rBuffer = rRenderGl.m_meshInstanceBuf.emplace(meshId);
+    attach_instance_attributes(rRenderGl.m_meshGl.get(meshId), rBuffer);
+    return rBuffer;
+}
+
+void SysRenderGL::mesh_attach_frame_ring(RenderGL& rRenderGl, MeshGlId const meshId)
+{
+    auto &rMeshes = rRenderGl.m_frameRingMeshes;
+    if (std::find(rMeshes.begin(), rMeshes.end(), meshId) != rMeshes.end())
+    {
+        return;
+    }
+
+    rMeshes.push_back(meshId);
+    attach_instance_attributes(rRenderGl.m_meshGl.get(meshId), rRenderGl.m_frameRing.m_buffer);
+}
+
+void SysRenderGL::group_instances(
+        InstanceScratchGL&          rScratch,
+        DrawEntSet_t const&         ents,
+        DrawEntSet_t const&         visible,
+        DrawEntSet_t const&         hasMaterial,
+        MeshGlEntStorage_t const&   meshIds,
+        TexGlEntStorage_t const&    texIds,
+        TextureArraysGL const*      pTexArrays)
+{
+    // Set in the texture half of a key if it's an array index instead of a TexGlId
+    constexpr std::uint64_t c_arrayBit = 1u << 31u;
+
+    rScratch.m_sorted.clear();
+    rScratch.m_groups.clear();
+
+    for (DrawEnt const ent : ents)
+    {
+        if ( ! visible.contains(ent) || ! hasMaterial.contains(ent) )
+        {
+            continue;
+        }
+
+        MeshGlId const meshId = meshIds[ent].m_glId;
+        if (meshId == lgrn::id_null<MeshGlId>())
+        {
+            continue; // mesh not compiled yet
+        }
+
+        TexGlId const texId = (texIds.size() > std::size_t(ent))
+                            ? texIds[ent].m_glId
+                            : lgrn::id_null<TexGlId>();
+
+        std::uint64_t texKey = std::uint64_t(texId);
+        if (pTexArrays != nullptr && texId != lgrn::id_null<TexGlId>())
+        {
+            auto const layerIt = pTexArrays->m_layers.find(texId);
+            if (layerIt != pTexArrays->m_layers.end())
+            {
+                texKey = c_arrayBit | layerIt->second.array;
+            }
+        }
+
+        std::uint64_t const key = (std::uint64_t(meshId) << 32) | texKey;
+        rScratch.m_sorted.push_back({key, ent});
+    }
+
+    std::sort(rScratch.m_sorted.begin(), rScratch.m_sorted.end(),
+              [] (InstanceScratchGL::Entry const& lhs, InstanceScratchGL::Entry const& rhs)
+    {
+        return lhs.key < rhs.key;
+    });
+
+    for (std::size_t i = 0; i < rScratch.m_sorted.size(); )
+    {
+        std::size_t const first = i;
+        std::uint64_t const key = rScratch.m_sorted[i].key;
+        while (i < rScratch.m_sorted.size() && rScratch.m_sorted[i].key == key)
+        {
+            ++i;
+        }
+
+        std::uint64_t const texKey  = key & 0xFFFFFFFFu;
+        bool const          isArray = texKey != std::uint64_t(lgrn::id_null<TexGlId>())
+                                   && (texKey & c_arrayBit) != 0;
+
+        rScratch.m_groups.push_back({
+            .meshId     = MeshGlId(key >> 32),
+            .texId      = isArray ? lgrn::id_null<TexGlId>() : TexGlId(texKey),
+            .texArray   = isArray ? std::uint32_t(texKey & ~c_arrayBit) : lgrn::id_null<std::uint32_t>(),
+            .first      = first,
+            .count      = i - first});
+    }
+}
+
+float SysRenderGL::texture_layer(TextureArraysGL const& texArrays, TexGlEntStorage_t const& texIds, DrawEnt const ent) noexcept
+{
+    auto const layerIt = texArrays.m_layers.find(texIds[ent].m_glId);
+    return (layerIt != texArrays.m_layers.end()) ? float(layerIt->second.layer) : 0.0f;
 }
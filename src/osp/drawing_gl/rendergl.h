@@ -25,19 +25,35 @@
 #pragma once
 
 #include "FullscreenTriShader.h"
+#include "profiling_gl.h"
+#include "program_cache.h"
 
 #include "../drawing/drawing_fn.h"
+#include "../drawing/render_commands.h"
 
+#include <Magnum/GL/AbstractShaderProgram.h>
+#include <Magnum/GL/Buffer.h>
+#include <Magnum/GL/BufferImage.h>
+#include <Magnum/GL/OpenGL.h>
 #include <Magnum/GL/Mesh.h>
+#include <Magnum/GL/TimeQuery.h>
 #include <Magnum/GL/Texture.h>
+#include <Magnum/GL/TextureArray.h>
 #include <Magnum/GL/Framebuffer.h>
 #include <Magnum/GL/Renderbuffer.h>
 
+#include <Magnum/Shaders/FlatGL.h>
+
+#include <Magnum/Sampler.h>
+
 #include <Magnum/Trade/MeshData.h>
 #include <Magnum/Trade/ImageData.h>
 
 #include <longeron/id_management/registry_stl.hpp>
 
+#include <array>
+#include <cstring>
+
 namespace osp::draw
 {
 
@@ -46,6 +62,368 @@ enum class MeshGlId : uint32_t { };
 
 using TexGlStorage_t    = Storage_t<TexGlId, Magnum::GL::Texture2D>;
 using MeshGlStorage_t   = Storage_t<MeshGlId, Magnum::GL::Mesh>;
+using BufferGlStorage_t = Storage_t<MeshGlId, Magnum::GL::Buffer>;
+
+/**
+ * @brief Per-instance vertex attributes for instanced shaders
+ *
+ * All instanced shaders share this layout, so each mesh needs only one instance buffer.
+ */
+struct InstanceDataGL
+{
+    Magnum::Matrix4     transformation;
+    Magnum::Matrix3x3   normalMatrix;
+    Magnum::Color4      color;
+
+    /// Texture offset (always 0) and layer in a TextureArraysGL array, used by shaders with
+    /// TextureArrays and InstancedTextureOffset flags
+    Magnum::Vector3     textureOffsetLayer;
+};
+
+/**
+ * @brief One command of SysRenderGL::multi_draw_indirect, laid out as GL's
+ *        DrawElementsIndirectCommand
+ *
+ * A command with a count of 0 draws nothing and costs almost nothing.
+ */
+struct DrawElementsIndirectGL
+{
+    std::uint32_t   count           {0};
+    std::uint32_t   instanceCount   {1};
+    std::uint32_t   firstIndex      {0};
+    std::int32_t    baseVertex      {0};
+    std::uint32_t   baseInstance    {0};
+};
+
+static_assert(sizeof(DrawElementsIndirectGL) == 20);
+
+/**
+ * @brief Scratch buffers used to sort entities into instanced draw calls
+ */
+struct InstanceScratchGL
+{
+    struct Entry
+    {
+        std::uint64_t   key;
+        DrawEnt         ent;
+    };
+
+    /// Entities that share a mesh and texture, m_sorted[first] to m_sorted[first + count - 1]
+    struct Group
+    {
+        MeshGlId        meshId;
+        TexGlId         texId;
+
+        /// Index of a TextureArraysGL array if entities' textures are layers of it, in which
+        /// case texId is null and each entity can have a different texture
+        std::uint32_t   texArray;
+
+        std::size_t     first;
+        std::size_t     count;
+    };
+
+    std::vector<Entry>          m_sorted;
+    std::vector<Group>          m_groups;
+    std::vector<InstanceDataGL> m_data;
+};
+
+/**
+ * @brief Triple-buffered, persistently mapped ring buffer for data streamed every frame
+ *
+ * Each frame writes into its own third of the buffer. A fence is placed at the end of a frame,
+ * and waited on before that third is written again, 3 frames later. The buffer stays mapped, so
+ * writing is a plain memcpy with no driver calls.
+ *
+ * Requires ARB_buffer_storage and ARB_base_instance. m_enabled is false if unsupported, and
+ * users fall back to uploading with Buffer::setData.
+ */
+struct FrameRingBufferGL
+{
+    static constexpr std::size_t smc_frames = 3;
+
+    Magnum::GL::Buffer                      m_buffer{Corrade::NoCreate};
+    Corrade::Containers::ArrayView<char>    m_mapped;
+
+    std::array<GLsync, smc_frames>          m_fences{};
+
+    std::size_t                             m_frameSize{0};
+    std::size_t                             m_frame{0};
+    std::size_t                             m_used{0};
+
+    bool                                    m_enabled{false};
+};
+
+/**
+ * @brief Meshes and textures waiting to be uploaded, limited to a number of bytes per frame
+ *
+ * Queued Ids already exist and hold a placeholder (empty mesh or 1x1 white texture), so entities
+ * can be synchronized to them right away. The placeholder is replaced in place once uploaded.
+ */
+struct UploadQueueGL
+{
+    std::vector<MeshGlId>   m_meshes;
+    std::vector<TexGlId>    m_textures;
+
+    /// Bytes to upload per SysRenderGL::process_uploads call. 0 uploads immediately instead.
+    std::size_t             m_budgetBytes{0};
+
+    std::size_t             m_lastUploadedBytes{0};
+};
+
+/**
+ * @brief Approximate GPU memory used by meshes and textures, and LRU eviction state
+ *
+ * Evicted resources keep their GL Id and resource owner, but hold a placeholder like ones waiting
+ * in UploadQueueGL. They're queued for upload again once a DrawEnt uses them.
+ */
+struct GpuMemoryGL
+{
+    enum class EState : std::uint8_t
+    {
+        Queued,     ///< Waiting in UploadQueueGL, holds a placeholder
+        Resident,
+        Evicted     ///< Holds a placeholder, not queued
+    };
+
+    struct Entry
+    {
+        std::size_t     bytes       {0};
+
+        /// Value of m_frame when a DrawEnt last used this
+        std::uint64_t   lastUsed    {0};
+
+        EState          state       {EState::Queued};
+    };
+
+    struct Candidate
+    {
+        std::uint64_t   lastUsed;
+        std::uint32_t   id;
+        bool            isTexture;
+    };
+
+    IdMap_t<MeshGlId, Entry>    m_meshes;
+    IdMap_t<TexGlId, Entry>     m_textures;
+
+    /// Evict unused resources while m_residentBytes is above this. 0 disables eviction.
+    std::size_t                 m_budgetBytes   {0};
+
+    std::size_t                 m_residentBytes {0};
+    std::size_t                 m_lastEvicted   {0};
+    std::uint64_t               m_frame         {0};
+
+    std::vector<Candidate>      m_candidates;
+};
+
+/**
+ * @brief Streamed mip levels of textures, keeping only the finest level needed on the GPU
+ *
+ * Streamed textures use mutable storage with only Entry::residentBase and coarser levels
+ * defined, and GL_TEXTURE_BASE_LEVEL clamped to it, so missing finer levels take no memory. They
+ * start with their coarse tail, then SysRenderGL::process_uploads adds finer levels as the
+ * upload budget allows until Entry::wantedBase is reached. Level data is read from each image's
+ * ImageMipChain, baked into asset caches or made on first use.
+ */
+struct TextureMipsGL
+{
+    struct Entry
+    {
+        /// Mip levels of the full image
+        std::uint8_t    levels          {1};
+
+        /// Finest level on the GPU, equal to levels while it only holds a placeholder
+        std::uint8_t    residentBase    {0};
+
+        /// Finest level needed by visible DrawEnts, see SysRenderGL::estimate_texture_mips
+        std::uint8_t    wantedBase      {0};
+
+        /// Value of m_frame when wantedBase was last estimated
+        std::uint64_t   wantedFrame     {0};
+
+        bool            queued          {false};
+    };
+
+    IdMap_t<TexGlId, Entry>     m_textures;
+
+    /// Textures that want a finer level than they have, streamed in by process_uploads
+    std::vector<TexGlId>        m_queue;
+
+    /// Stream textures at least this many texels on their longest side. 0 disables streaming.
+    int                         m_minSize       {0};
+
+    /// Size of the coarsest level uploaded first, before anything is known about its use
+    int                         m_initialSize   {64};
+
+    /// Added to estimated levels; positive values pick coarser levels to save memory
+    float                       m_bias          {0.0f};
+
+    std::uint64_t               m_frame         {0};
+};
+
+/**
+ * @brief Textures of the same size, format and sampler state packed into layers of array
+ *        textures, so instanced draws can mix them without binding a texture per group
+ *
+ * compile_resource_textures adds new textures to a layer, in addition to their Texture2D in
+ * RenderGL::m_texGl used by non-instanced shaders. Each array has a fixed number of layers; once
+ * one is full, another is made for the same key. All mip levels of a layer are uploaded at once,
+ * layers are never streamed or evicted.
+ */
+struct TextureArraysGL
+{
+    struct Key
+    {
+        Magnum::Vector2i        size;
+
+        /// Magnum::PixelFormat, or Magnum::CompressedPixelFormat if compressed
+        Magnum::UnsignedInt     format;
+        bool                    compressed;
+
+        Magnum::SamplerFilter   minFilter;
+        Magnum::SamplerFilter   magFilter;
+        Magnum::SamplerMipmap   mipmapFilter;
+        Magnum::SamplerWrapping wrapX;
+        Magnum::SamplerWrapping wrapY;
+
+        bool operator==(Key const& rhs) const noexcept = default;
+    };
+
+    struct Array
+    {
+        Key                         key;
+        Magnum::GL::Texture2DArray  texture;
+        int                         used    {0};
+    };
+
+    struct Layer
+    {
+        std::uint32_t   array;
+        int             layer;
+    };
+
+    std::vector<Array>          m_arrays;
+    IdMap_t<TexGlId, Layer>     m_layers;
+
+    /// Layers per array texture. 0 disables texture arrays.
+    int                         m_layersPerArray    {0};
+
+    /// Textures larger than this on their longest side aren't packed
+    int                         m_maxSize           {1024};
+};
+
+enum class ERenderPass : std::uint8_t
+{
+    DepthPrepass,
+    Opaque,
+    Transparent,
+    Blit,
+    Plume,
+    Terrain,
+    Satellites,
+    OrbitTrails,
+    Count
+};
+
+/**
+ * @brief Counters for a single render pass
+ */
+struct RenderPassStats
+{
+    /// GPU time of the pass from a few frames ago, as timer queries are read back without waiting
+    std::uint64_t   gpuTimeNs       {0};
+
+    std::uint32_t   drawCalls       {0};
+    std::uint32_t   instances       {0};
+    std::uint64_t   triangles       {0};
+
+    /// Estimated from consecutive RenderCmds with different shader, mesh, or texture
+    std::uint32_t   shaderChanges   {0};
+    std::uint32_t   meshChanges     {0};
+    std::uint32_t   textureChanges  {0};
+};
+
+/**
+ * @brief Per-pass statistics of the last completed frame, intended for overlays and logging
+ */
+struct RenderStats
+{
+    std::array<RenderPassStats, std::size_t(ERenderPass::Count)> passes;
+
+    std::uint64_t   frames  {0};
+};
+
+/**
+ * @brief Ring of GL timer queries for one render pass
+ *
+ * A query is reused only after smc_latency frames, by which time its result is almost always
+ * available, so reading it never stalls the pipeline in practice.
+ */
+struct GpuPassTimerGL
+{
+    static constexpr std::size_t smc_latency = 3;
+
+    std::array<Magnum::GL::TimeQuery, smc_latency> m_queries
+    {
+        Magnum::GL::TimeQuery{Corrade::NoCreate},
+        Magnum::GL::TimeQuery{Corrade::NoCreate},
+        Magnum::GL::TimeQuery{Corrade::NoCreate}
+    };
+    std::array<bool, smc_latency>   m_pending{};
+    std::size_t                     m_next{0};
+
+    /// Profiler zones of the pass, open between SysRenderGL::pass_begin and pass_end
+    ProfileSplitZone                m_cpuZone;
+    GpuProfileSplitZoneGL           m_gpuZone;
+};
+
+/**
+ * @brief Resolution of the offscreen framebuffer relative to the window
+ *
+ * The offscreen attachments are allocated once at full size. Lower scales render to only the
+ * bottom left part of them, which SysRenderGL::display_texture then stretches over the window, so
+ * changing the scale never reallocates anything.
+ */
+struct RenderScaleGL
+{
+    /// Fraction of full width and height to render, within [m_minScale, 1]
+    float               m_scale             {1.0f};
+
+    /// Let SysRenderGL::update_render_scale adjust m_scale from GPU frame time
+    bool                m_dynamic           {false};
+
+    /// GPU time of all scaled passes to aim for
+    std::uint64_t       m_targetGpuTimeNs   {12'000'000};
+
+    /// Fraction of m_targetGpuTimeNs above or below it that is left alone, to avoid oscillating
+    float               m_tolerance         {0.1f};
+    float               m_minScale          {0.5f};
+    float               m_maxStep           {0.1f};
+
+    /// Size of the offscreen attachments, the window size at SysRenderGL::setup_context
+    Magnum::Vector2i    m_fullSize;
+
+    /// Size of the part of the attachments that is currently rendered to
+    Magnum::Vector2i    m_renderedSize;
+
+    std::uint32_t       m_framesSinceChange {0};
+};
+
+/**
+ * @brief Offscreen framebuffer depth read back for occlusion culling, without stalling
+ *
+ * Depth is copied into a pixel buffer once a frame is drawn, then mapped at the start of the next
+ * frame when the copy has most likely finished. See SysRenderGL::depth_readback_begin.
+ */
+struct DepthReadbackGL
+{
+    Magnum::GL::BufferImage2D   m_image{Corrade::NoCreate};
+
+    /// Projection * view matrix of the frame that was copied
+    Matrix4                     m_viewProj;
+
+    /// A copy was started and not mapped yet
+    bool                        m_pending{false};
+};
 
 /**
  * @brief Main renderer state and essential GL resources
@@ -59,10 +437,18 @@ struct RenderGL
     MeshGlId                            m_fullscreenTri;
     FullscreenTriShader                 m_fullscreenTriShader{Corrade::NoCreate};
 
+    // Linked binaries of our own shader programs, open it before setup_context to use it
+    ProgramBinaryCacheGL                m_programCache;
+
+    // Position-only shader for SysRenderGL::render_depth_prepass
+    Magnum::Shaders::FlatGL3D           m_depthPrepassShader{Corrade::NoCreate};
+
     // Offscreen Framebuffer
     TexGlId                             m_fboColor;
     Magnum::GL::Renderbuffer            m_fboDepthStencil{Corrade::NoCreate};
     Magnum::GL::Framebuffer             m_fbo{Corrade::NoCreate};
+    RenderScaleGL                       m_renderScale;
+    DepthReadbackGL                     m_depthReadback;
 
     // Renderer-space GL Textures
     lgrn::IdRegistryStl<TexGlId>        m_texIds;
@@ -72,6 +458,30 @@ struct RenderGL
     lgrn::IdRegistryStl<MeshGlId>       m_meshIds;
     MeshGlStorage_t                     m_meshGl;
 
+    // Per-instance attribute buffers of GL Meshes, added on first instanced draw.
+    // Unused if m_frameRing is enabled.
+    BufferGlStorage_t                   m_meshInstanceBuf;
+
+    // GPU timing and counters of the pass between pass_begin and pass_end
+    std::array<GpuPassTimerGL, std::size_t(ERenderPass::Count)> m_passTimers;
+    RenderPassStats                     m_passCounters;
+
+    // Meshes and textures to upload over the next few frames
+    UploadQueueGL                       m_uploads;
+
+    // Byte tracking and eviction of meshes and textures
+    GpuMemoryGL                         m_gpuMemory;
+
+    // Partial residency of texture mip levels
+    TextureMipsGL                       m_texMips;
+
+    // Same-sized textures packed into array layers for instanced draws
+    TextureArraysGL                     m_texArrays;
+
+    // Streamed per-frame instance data, shared by all meshes
+    FrameRingBufferGL                   m_frameRing;
+    std::vector<MeshGlId>               m_frameRingMeshes;
+
     // Associate GL Texture Ids with resources
     IdMap_t<ResId, TexGlId>             m_resToTex;
     IdMap_t<TexGlId, ResIdOwner_t>      m_texToRes;
@@ -104,6 +514,12 @@ struct ACtxSceneRenderGL
 {
     MeshGlEntStorage_t      m_meshId;
     TexGlEntStorage_t       m_diffuseTexId;
+
+    /// Lay down depth of opaque objects first, so the main pass shades each pixel about once
+    bool                    m_depthPrepass{false};
+
+    /// Cull DrawEnts hidden behind the last frame's depth, see SysCulling::occlusion_cull
+    bool                    m_occlusionCull{false};
 };
 
 /**
@@ -128,15 +544,22 @@ public:
      *
      * @param rRenderGl [ref] Renderer state including fullscreen triangle
      * @param rTex      [in] Texture to display
+     * @param rendered  [in] Size of the bottom left part of the texture to stretch over the screen,
+     *                       or {0, 0} for all of it
      */
     static void display_texture(
-            RenderGL& rRenderGl, Magnum::GL::Texture2D& rTex);
+            RenderGL& rRenderGl, Magnum::GL::Texture2D& rTex, Magnum::Vector2i rendered = {});
 
     static void clear_resource_owners(RenderGL& rRenderGl, Resources& rResources);
 
     /**
      * @brief Compile GPU-side TexGlIds for textures loaded from a Resource (TexId + ResId)
      *
+     * If RenderGL::m_uploads has a budget, new textures are queued for process_uploads instead.
+     * If RenderGL::m_texMips streaming is enabled, large textures start with only coarse levels.
+     * If RenderGL::m_texArrays is enabled, textures are also copied into an array layer once
+     * uploaded.
+     *
      * @param rCtxDrawRes   [in] Resources used by the scene
      * @param rResources    [ref] Application Resources shared with the scene. New resource owners may be created.
      * @param rRenderGl     [ref] Renderer state
@@ -149,6 +572,8 @@ public:
     /**
      * @brief Compile GPU-side MeshGlIds for meshes loaded from a Resource (MeshId + ResId)
      *
+     * If RenderGL::m_uploads has a budget, new meshes are queued for process_uploads instead
+     *
      * @param rCtxDrawRes   [in] Resources used by the scene
      * @param rResources    [ref] Application Resources shared with the scene. New resource owners may be created.
      * @param rRenderGl     [ref] Renderer state
@@ -158,6 +583,62 @@ public:
             Resources& rResources,
             RenderGL& rRenderGl);
 
+    /**
+     * @brief Upload queued meshes and textures until RenderGL::m_uploads's byte budget is used
+     *
+     * Call once per frame. At least one item is uploaded per call, even if it exceeds the budget.
+     * Whatever budget is left streams finer mip levels into textures of RenderGL::m_texMips
+     * that want them.
+     *
+     * @param rRenderGl     [ref] Renderer state
+     * @param rResources    [ref] Application Resources to read mesh and image data from
+     */
+    static void process_uploads(RenderGL& rRenderGl, Resources& rResources);
+
+    /**
+     * @brief Mark meshes and textures used by live DrawEnts, then evict the least recently used
+     *        unused ones until RenderGL::m_gpuMemory is within budget
+     *
+     * Evicted resources used again are queued for upload through RenderGL::m_uploads. Call once
+     * per frame before process_uploads. Only the current level of detail of each DrawEnt counts
+     * as used. Does nothing if RenderGL::m_gpuMemory has no budget.
+     *
+     * Before evicting anything, streamed textures holding finer mip levels than they need are
+     * trimmed down to their wanted level.
+     *
+     * @param rRenderGl     [ref] Renderer state
+     * @param rResources    [ref] Application Resources, for immediate re-uploads without an upload budget
+     * @param scnRenderGl   [in] GL Mesh and Texture Ids of entities
+     * @param drawIds       [in] Live DrawEnts
+     */
+    static void update_gpu_memory(
+            RenderGL&                           rRenderGl,
+            Resources&                          rResources,
+            ACtxSceneRenderGL const&            scnRenderGl,
+            lgrn::IdRegistryStl<DrawEnt> const& drawIds);
+
+    /**
+     * @brief Pick the finest mip level each streamed texture needs, from the size on screen of
+     *        the DrawEnts that use it
+     *
+     * A texture is assumed to span its DrawEnt's bounds once, so the level is chosen to map
+     * about one texel to one pixel across the bounds' diameter. Textures that want a finer level
+     * than they have are queued for process_uploads. Call once per frame after
+     * SysCulling::screen_sizes, before update_gpu_memory.
+     *
+     * @param rRenderGl     [ref] Renderer state
+     * @param scnRenderGl   [in] GL Texture Ids of entities
+     * @param visible       [in] DrawEnts to consider, usually ACtxSceneRender::m_visibleCulled
+     * @param screenSize    [in] ACtxSceneRender::m_screenSize
+     * @param viewHeight    [in] Height in pixels of what's rendered, such as RenderScaleGL::m_renderedSize
+     */
+    static void estimate_texture_mips(
+            RenderGL&                           rRenderGl,
+            ACtxSceneRenderGL const&            scnRenderGl,
+            lgrn::IdSetStl<DrawEnt> const&      visible,
+            KeyedVec<DrawEnt, float> const&     screenSize,
+            int                                 viewHeight);
+
     /**
      * @brief Synchronize an entity's MeshId component to an ACompMeshGl
      *
@@ -189,6 +670,24 @@ public:
         });
     }
 
+    /**
+     * @brief Point ACompMeshGl of DrawEnts with levels of detail to their current level's mesh
+     *
+     * Only MeshGlIds are changed; ACompMeshGl::m_scnId still refers to the level 0 mesh, so
+     * sync_drawent_mesh sees nothing to do and m_meshDirty is left alone. Run every frame after
+     * SysCulling::select_lods.
+     *
+     * @param scnRender     [in] Scene render state with LODs
+     * @param meshToRes     [in] Scene's Mesh Id to Resource Id
+     * @param rCmpMeshGl    [ref] Renderer-side ACompMeshGl components
+     * @param rRenderGl     [in] Renderer state
+     */
+    static void sync_drawent_lods(
+            ACtxSceneRender const&                      scnRender,
+            IdMap_t<MeshId, ResIdOwner_t> const&        meshToRes,
+            MeshGlEntStorage_t&                         rCmpMeshGl,
+            RenderGL const&                             rRenderGl);
+
     /**
      * @brief Synchronize entities with a TexId component to an ACompTexGl
      *
@@ -251,6 +750,252 @@ public:
             DrawEntSet_t const& visible,
             ViewProjMatrix const& viewProj);
 
+    /**
+     * @brief Submit a RenderCmdBuffer to GL, in order, then its instanced draws
+     *
+     * Consecutive commands share shader, mesh, and texture where possible, so the GL state
+     * tracker can skip redundant program, mesh, and texture binds.
+     *
+     * @param cmds      [in] Commands recorded by SysRenderCmd::record
+     * @param visible   [in] Storage for visible components, passed to instanced draws
+     */
+    static void draw_cmds(
+            RenderCmdBuffer const&      cmds,
+            DrawEntSet_t const&         visible);
+
+    /**
+     * @brief Write only depth of a RenderCmdBuffer of opaque objects, using a position-only shader
+     *
+     * Depth is pushed slightly back with a polygon offset. Follow with render_opaque and
+     * depthPrepassDone = true to only shade the front-most fragments. Instanced draws are skipped
+     * and drawn with regular depth testing in the main pass.
+     *
+     * @param rRenderGl     [ref] GL resources, for meshes and the prepass shader
+     * @param cmds          [in] Commands recorded by SysRenderCmd::record
+     * @param scnRenderGl   [in] GL Mesh Ids of entities
+     * @param drawTf        [in] Draw transforms of entities
+     */
+    static void render_depth_prepass(
+            RenderGL&                   rRenderGl,
+            RenderCmdBuffer const&      cmds,
+            ACtxSceneRenderGL const&    scnRenderGl,
+            DrawTransforms_t const&     drawTf);
+
+    /**
+     * @copydoc render_opaque, submitting a RenderCmdBuffer instead
+     *
+     * @param depthPrepassDone  [in] render_depth_prepass was called for these commands. Depth
+     *                               writes are disabled and only fragments at the prepass depth
+     *                               are shaded.
+     */
+    static void render_opaque(
+            RenderCmdBuffer const&      cmds,
+            DrawEntSet_t const&         visible,
+            bool                        depthPrepassDone = false);
+
+    /// @copydoc render_transparent, submitting a RenderCmdBuffer instead
+    static void render_transparent(
+            RenderCmdBuffer const&      cmds,
+            DrawEntSet_t const&         visible);
+
+    /**
+     * @brief Start timing and counting a render pass
+     *
+     * Reads back the pass's timer query from GpuPassTimerGL::smc_latency frames ago. Also opens
+     * CPU and GPU profiler zones named after the pass, closed by pass_end.
+     */
+    static void pass_begin(RenderGL& rRenderGl, ERenderPass pass, RenderStats& rStats);
+
+    /**
+     * @brief Stop timing a render pass, and write its counters to rStats
+     *
+     * @param pCmds     [in] Optional RenderCmdBuffer drawn in this pass, to count state changes
+     */
+    static void pass_end(RenderGL& rRenderGl, ERenderPass pass, RenderStats& rStats, RenderCmdBuffer const* pCmds = nullptr);
+
+    /**
+     * @brief Adjust RenderScaleGL::m_scale towards the resolution that keeps GPU time on target
+     *
+     * Fill-rate-limited GPU time is about proportional to pixel count, so the scale is multiplied
+     * by the square root of target over measured time, limited to m_maxStep per change. As timer
+     * results lag behind, the scale is only changed again once the last change shows up in them.
+     * Does nothing if RenderScaleGL::m_dynamic is off.
+     *
+     * @param rScale    [ref] Render scale to adjust
+     * @param stats     [in] Pass GPU times, everything but ERenderPass::Blit is scaled
+     */
+    static void update_render_scale(RenderScaleGL& rScale, RenderStats const& stats);
+
+    /**
+     * @brief Size of the offscreen framebuffer part to render to, from RenderScaleGL::m_scale
+     */
+    [[nodiscard]] static Magnum::Vector2i render_scale_size(RenderScaleGL const& scale) noexcept;
+
+    /**
+     * @brief Start copying the rendered part of the offscreen framebuffer's depth, without waiting
+     *
+     * Call once everything that occludes is drawn. The copy is picked up by depth_readback_end.
+     *
+     * @param rRenderGl [ref] Renderer state with the offscreen framebuffer
+     * @param viewProj  [in] Projection * view matrix the frame was drawn with
+     */
+    static void depth_readback_begin(RenderGL& rRenderGl, Matrix4 const& viewProj);
+
+    /**
+     * @brief Build a depth pyramid from the depth copied by the last depth_readback_begin
+     *
+     * @param rRenderGl [ref] Renderer state with the copied depth
+     * @param rPyramid  [out] Overwritten, or cleared if there is no copy to use
+     *
+     * @return True if rPyramid was built
+     */
+    static bool depth_readback_end(RenderGL& rRenderGl, DepthPyramid& rPyramid);
+
+    /**
+     * @brief Count a draw call towards the current pass
+     */
+    static void count_draw(RenderGL& rRenderGl, Magnum::GL::Mesh const& mesh, std::uint32_t instances = 1) noexcept
+    {
+        rRenderGl.m_passCounters.drawCalls += 1;
+        rRenderGl.m_passCounters.instances += instances;
+        rRenderGl.m_passCounters.triangles += std::uint64_t(mesh.count() / 3) * instances;
+    }
+
+    /**
+     * @brief Draw ranges of a mesh's index buffer with one glMultiDrawElementsIndirect call
+     *
+     * Magnum has no wrapper for indirect draws, so the shader and mesh are bound directly and
+     * Magnum's state tracker is reset afterwards. Set uniforms before calling this. The mesh
+     * must be indexed with UnsignedInt triangles; its count is ignored. Requires OpenGL 4.3.
+     *
+     * @param rRenderGl [ref] Renderer state, for draw counters
+     * @param rShader   [ref] Shader to draw with
+     * @param rMesh     [ref] Mesh with vertex and index buffers set
+     * @param rCmds     [ref] Buffer holding DrawElementsIndirectGL commands
+     * @param cmdCount  [in] Number of commands to read from the start of rCmds
+     * @param triangles [in] Triangles drawn by all commands, only counted towards stats
+     */
+    static void multi_draw_indirect(
+            RenderGL&                               rRenderGl,
+            Magnum::GL::AbstractShaderProgram&      rShader,
+            Magnum::GL::Mesh&                       rMesh,
+            Magnum::GL::Buffer&                     rCmds,
+            std::uint32_t                           cmdCount,
+            std::uint64_t                           triangles);
+
+    /**
+     * @brief Create RenderGL::m_frameRing, if supported by the GL context
+     *
+     * @param rRenderGl     [ref] Renderer state
+     * @param frameSize     [in] Initial bytes available per frame. Grows if exceeded.
+     */
+    static void setup_frame_ring(RenderGL& rRenderGl, std::size_t frameSize);
+
+    /**
+     * @brief Wait until the GPU is done with the next third of the frame ring, then select it
+     *
+     * Call once at the start of a frame, before any frame_ring_alloc.
+     */
+    static void frame_ring_begin(RenderGL& rRenderGl);
+
+    /**
+     * @brief Place a fence after all commands using the current third of the frame ring
+     */
+    static void frame_ring_end(RenderGL& rRenderGl);
+
+    /**
+     * @brief Allocate bytes from the current frame's third of the ring
+     *
+     * Grows the ring to fit if needed. Commands already issued keep using the old buffer, which
+     * the driver frees once they complete.
+     *
+     * @return Offset in bytes from the start of the ring buffer
+     */
+    static std::size_t frame_ring_alloc(RenderGL& rRenderGl, std::size_t size, std::size_t alignment);
+
+    /**
+     * @brief Get a mesh's per-instance attribute buffer, creating and attaching it if needed
+     *
+     * @param rRenderGl [ref] Renderer state
+     * @param meshId    [in] GL Mesh to get instance buffer for
+     */
+    static Magnum::GL::Buffer& mesh_instance_buffer(RenderGL& rRenderGl, MeshGlId meshId);
+
+    /**
+     * @brief Attach RenderGL::m_frameRing as a mesh's per-instance attribute buffer if needed
+     */
+    static void mesh_attach_frame_ring(RenderGL& rRenderGl, MeshGlId meshId);
+
+    /**
+     * @brief Sort visible entities into groups that share the same mesh and texture
+     *
+     * Results are written to rScratch.m_sorted and rScratch.m_groups. If pTexArrays is given,
+     * entities with textures packed into the same array are put into one group regardless of
+     * which layer they use. Such groups have texArray set, read each entity's layer with
+     * texture_layer.
+     *
+     * @param rScratch      [ref] Scratch buffers
+     * @param ents          [in] Entities to group
+     * @param visible       [in] Entities allowed to be drawn
+     * @param hasMaterial   [in] Entities in the shader's material
+     * @param meshIds       [in] GL Mesh Ids of entities
+     * @param texIds        [in] GL Texture Ids of entities
+     * @param pTexArrays    [in] Optional, for shaders that can draw array textures
+     */
+    static void group_instances(
+            InstanceScratchGL&          rScratch,
+            DrawEntSet_t const&         ents,
+            DrawEntSet_t const&         visible,
+            DrawEntSet_t const&         hasMaterial,
+            MeshGlEntStorage_t const&   meshIds,
+            TexGlEntStorage_t const&    texIds,
+            TextureArraysGL const*      pTexArrays = nullptr);
+
+    /**
+     * @brief Layer of an entity's texture in a TextureArraysGL array, as a float for
+     *        InstanceDataGL::textureOffsetLayer
+     */
+    static float texture_layer(TextureArraysGL const& texArrays, TexGlEntStorage_t const& texIds, DrawEnt ent) noexcept;
+
+    /**
+     * @brief Upload instance data and draw a mesh once per instance
+     *
+     * @param rRenderGl [ref] Renderer state
+     * @param meshId    [in] GL Mesh to draw
+     * @param data      [in] Per-instance attributes
+     * @param rShader   [ref] Shader with instanced attributes enabled
+     */
+    template <typename SHADER_T>
+    static void draw_instances(
+            RenderGL&                                           rRenderGl,
+            MeshGlId                                            meshId,
+            Corrade::Containers::ArrayView<InstanceDataGL const> data,
+            SHADER_T&                                           rShader)
+    {
+        Magnum::GL::Mesh &rMesh = rRenderGl.m_meshGl.get(meshId);
+
+        if (rRenderGl.m_frameRing.m_enabled)
+        {
+            // Write straight into mapped memory, and point the draw at it with base instance
+            std::size_t const bytes  = data.size() * sizeof(InstanceDataGL);
+            std::size_t const offset = frame_ring_alloc(rRenderGl, bytes, sizeof(InstanceDataGL));
+            mesh_attach_frame_ring(rRenderGl, meshId);
+            std::memcpy(rRenderGl.m_frameRing.m_mapped.data() + offset, data.data(), bytes);
+            rMesh.setBaseInstance(Magnum::UnsignedInt(offset / sizeof(InstanceDataGL)));
+        }
+        else
+        {
+            mesh_instance_buffer(rRenderGl, meshId).setData(data, Magnum::GL::BufferUsage::StreamDraw);
+        }
+
+        rMesh.setInstanceCount(Magnum::Int(data.size()));
+        rShader.draw(rMesh);
+        count_draw(rRenderGl, rMesh, std::uint32_t(data.size()));
+
+        // Meshes are shared with non-instanced shaders
+        rMesh.setInstanceCount(1);
+    }
+
 };
 
 } // namespace osp::draw
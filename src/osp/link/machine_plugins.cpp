@@ -0,0 +1,201 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "machine_plugins.h"
+
+#include <longeron/utility/asserts.hpp>
+
+#include <algorithm>
+
+namespace osp::link
+{
+
+namespace
+{
+
+std::vector<MachPlugin>& plugins_mut() noexcept
+{
+    static std::vector<MachPlugin> s_plugins;
+    return s_plugins;
+}
+
+} // namespace
+
+MachTypeId register_machine_plugin(MachPluginDesc desc)
+{
+    LGRN_ASSERTMV(desc.abiVersion == gc_machPluginAbiVersion, "Machine plugin built for a different ABI version",
+                  desc.name, desc.abiVersion, gc_machPluginAbiVersion);
+    LGRN_ASSERTMV(desc.update != nullptr, "Machine plugin has no update function", desc.name);
+
+    auto const is_port = [] (JuncCustom const custom)
+    {
+        return [custom] (PortEntry const& entry)
+        {
+            return entry.type == gc_ntSigFloat && entry.custom == custom;
+        };
+    };
+    LGRN_ASSERTMV(std::all_of(desc.inputs.begin(),  desc.inputs.end(),  is_port(gc_sigIn)),
+                  "Machine plugin inputs must be float signal inputs", desc.name);
+    LGRN_ASSERTMV(std::all_of(desc.outputs.begin(), desc.outputs.end(), is_port(gc_sigOut)),
+                  "Machine plugin outputs must be float signal outputs", desc.name);
+
+    MachTypeId const type = MachTypeReg_t::create();
+    plugins_mut().push_back({std::move(desc), type});
+    return type;
+}
+
+std::vector<MachPlugin> const& registered_machine_plugins() noexcept
+{
+    return plugins_mut();
+}
+
+void mach_plugin_reconnect(MachPluginInstance& rInst, PerMachType const& perType, Nodes const& floatNodes)
+{
+    MachPluginDesc const &desc      = rInst.plugin.desc;
+    std::size_t const   inputCount  = desc.inputs.size();
+    std::size_t const   portCount   = inputCount + desc.outputs.size();
+    std::size_t const   capacity    = perType.localIds.capacity();
+
+    rInst.state.resize(desc.stateDefaults.size());
+    for (std::size_t col = 0; col < rInst.state.size(); ++col)
+    {
+        std::vector<float> &rColumn = rInst.state[col];
+        rColumn.resize(capacity, desc.stateDefaults[col]);
+
+        for (MachLocalId local = 0; local < capacity; ++local)
+        {
+            if ( ! perType.localIds.exists(local) )
+            {
+                rColumn[local] = desc.stateDefaults[col];
+            }
+        }
+    }
+
+    rInst.localToNodes.assign(capacity * portCount, lgrn::id_null<NodeId>());
+
+    for (MachLocalId const local : perType.localIds)
+    {
+        auto const portSpan = lgrn::Span<NodeId const>{floatNodes.machToNode[perType.localToAny[local]]};
+        NodeId *pNodes      = &rInst.localToNodes[local * portCount];
+
+        for (std::size_t i = 0; i < inputCount; ++i)
+        {
+            pNodes[i] = connected_node(portSpan, desc.inputs[i].port);
+        }
+        for (std::size_t i = 0; i < desc.outputs.size(); ++i)
+        {
+            pNodes[inputCount + i] = connected_node(portSpan, desc.outputs[i].port);
+        }
+    }
+}
+
+bool mach_plugin_update(
+        MachPluginInstance&                 rInst,
+        lgrn::IdSetStl<MachLocalId> const&  dirty,
+        SignalValues_t<float> const&        sigVal,
+        UpdateNodes<float>&                 rSigUpd)
+{
+    MachPluginDesc const &desc      = rInst.plugin.desc;
+    std::size_t const   inputCount  = desc.inputs.size();
+    std::size_t const   outputCount = desc.outputs.size();
+    std::size_t const   portCount   = inputCount + outputCount;
+
+    rInst.batchLocals.assign(dirty.begin(), dirty.end());
+    std::vector<MachLocalId> const &rLocals = rInst.batchLocals;
+    std::size_t const rows = rLocals.size();
+    if (rows == 0)
+    {
+        return false;
+    }
+
+    auto const node_value = [&sigVal] (NodeId const node) -> float
+    {
+        return (node != lgrn::id_null<NodeId>()) ? sigVal[node] : 0.0f;
+    };
+
+    // Gather inputs and current output values, one column at a time
+    rInst.inputColumns .resize(inputCount);
+    rInst.outputColumns.resize(outputCount);
+    rInst.inputPtrs    .resize(inputCount);
+    rInst.outputPtrs   .resize(outputCount);
+
+    for (std::size_t port = 0; port < portCount; ++port)
+    {
+        bool const          isInput = port < inputCount;
+        std::vector<float>  &rColumn = isInput ? rInst.inputColumns[port]
+                                               : rInst.outputColumns[port - inputCount];
+        rColumn.resize(rows);
+        for (std::size_t i = 0; i < rows; ++i)
+        {
+            rColumn[i] = node_value(rInst.localToNodes[rLocals[i] * portCount + port]);
+        }
+
+        if (isInput)
+        {
+            rInst.inputPtrs[port] = rColumn.data();
+        }
+        else
+        {
+            rInst.outputPtrs[port - inputCount] = rColumn.data();
+        }
+    }
+
+    rInst.statePtrs.resize(rInst.state.size());
+    for (std::size_t col = 0; col < rInst.state.size(); ++col)
+    {
+        rInst.statePtrs[col] = rInst.state[col].data();
+    }
+
+    MachPluginBatch const batch
+    {
+        .pLocals        = rLocals.data(),
+        .rows           = rows,
+        .ppInputs       = rInst.inputPtrs.data(),
+        .ppOutputs      = rInst.outputPtrs.data(),
+        .ppState        = rInst.statePtrs.data(),
+        .stateCapacity  = rInst.state.empty() ? 0 : rInst.state.front().size()
+    };
+
+    desc.update(batch, desc.pUserData);
+
+    // Scatter outputs that changed
+    bool changed = false;
+    for (std::size_t output = 0; output < outputCount; ++output)
+    {
+        std::vector<float> const &column = rInst.outputColumns[output];
+        for (std::size_t i = 0; i < rows; ++i)
+        {
+            NodeId const node = rInst.localToNodes[rLocals[i] * portCount + inputCount + output];
+            if (node != lgrn::id_null<NodeId>() && sigVal[node] != column[i])
+            {
+                rSigUpd.assign(node, column[i]);
+                changed = true;
+            }
+        }
+    }
+
+    return changed;
+}
+
+} // namespace osp::link
@@ -0,0 +1,160 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "machines.h"
+#include "signal.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace osp::link
+{
+
+/// Incremented whenever MachPluginBatch or MachPluginDesc change layout
+constexpr uint32_t gc_machPluginAbiVersion = 1;
+
+/**
+ * @brief Everything a plugin machine type's update function gets to work with
+ *
+ * Data is in columns, one row per dirty machine being updated. Only plain pointers and counts
+ * are used, so plugins don't depend on the engine's container types.
+ */
+struct MachPluginBatch
+{
+    /// [row] -> MachLocalId of each machine being updated
+    MachLocalId const   *pLocals;
+    std::size_t         rows;
+
+    /// [input index][row], in order of MachPluginDesc::inputs. Unconnected inputs read as 0.
+    float const* const  *ppInputs;
+
+    /// [output index][row], in order of MachPluginDesc::outputs. Filled with the current node
+    /// values beforehand; only values that are changed get written back to their nodes.
+    float* const        *ppOutputs;
+
+    /// [state column][MachLocalId], persistent state of all machines of this type.
+    /// Indexed by MachLocalId, not row.
+    float* const        *ppState;
+    std::size_t         stateCapacity;
+};
+
+/**
+ * @brief Update all dirty machines of a type at once
+ *
+ * Runs in parallel with other machine types' updates, so it must only touch the batch and its
+ * own user data.
+ */
+using MachPluginUpdateFunc_t = void(*)(MachPluginBatch const& batch, void *pUserData) noexcept;
+
+/**
+ * @brief Declares a machine type added from outside the engine, such as by a mod
+ *
+ * Only float signal ports (gc_ntSigFloat) are supported.
+ */
+struct MachPluginDesc
+{
+    uint32_t                abiVersion  {gc_machPluginAbiVersion};
+
+    std::string             name;
+
+    /// Ports with gc_sigIn, port numbers can be in any order
+    std::vector<PortEntry>  inputs;
+
+    /// Ports with gc_sigOut
+    std::vector<PortEntry>  outputs;
+
+    /// Initial value of each state column, which also sets the number of state columns
+    std::vector<float>      stateDefaults;
+
+    MachPluginUpdateFunc_t  update      {nullptr};
+    void                    *pUserData  {nullptr};
+};
+
+struct MachPlugin
+{
+    MachPluginDesc  desc;
+    MachTypeId      type {lgrn::id_null<MachTypeId>()};
+};
+
+/**
+ * @brief Register a plugin machine type, creating a new MachTypeId for it
+ *
+ * Must be called before any scenes are set up, as containers indexed by MachTypeId are sized
+ * to MachTypeReg_t::size() then.
+ */
+MachTypeId register_machine_plugin(MachPluginDesc desc);
+
+/**
+ * @brief All plugins registered so far, in order of registration
+ */
+std::vector<MachPlugin> const& registered_machine_plugins() noexcept;
+
+/**
+ * @brief Per-scene data of a plugin machine type: cached port nodes, machine state, and
+ *        reusable batch buffers
+ */
+struct MachPluginInstance
+{
+    MachPlugin                      plugin;
+
+    /// [MachLocalId * portCount + port index] -> NodeId, inputs then outputs
+    std::vector<NodeId>             localToNodes;
+
+    /// [state column][MachLocalId]
+    std::vector<std::vector<float>> state;
+
+    std::vector<MachLocalId>        batchLocals;
+    std::vector<std::vector<float>> inputColumns;
+    std::vector<std::vector<float>> outputColumns;
+    std::vector<float const*>       inputPtrs;
+    std::vector<float*>             outputPtrs;
+    std::vector<float*>             statePtrs;
+
+    uint32_t                        connectRevision{~uint32_t(0)};
+};
+
+/**
+ * @brief Resize state and re-cache port nodes after machines or wiring changed
+ *
+ * State of machines that no longer exist is reset to MachPluginDesc::stateDefaults, so reused
+ * local IDs start fresh.
+ */
+void mach_plugin_reconnect(MachPluginInstance& rInst, PerMachType const& perType, Nodes const& floatNodes);
+
+/**
+ * @brief Gather inputs of dirty machines, call the plugin's update function, and write changed
+ *        outputs to rSigUpd
+ *
+ * @return true if any output changed, and the machine update loop must run again
+ */
+bool mach_plugin_update(
+        MachPluginInstance&                 rInst,
+        lgrn::IdSetStl<MachLocalId> const&  dirty,
+        SignalValues_t<float> const&        sigVal,
+        UpdateNodes<float>&                 rSigUpd);
+
+} // namespace osp::link
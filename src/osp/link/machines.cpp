@@ -24,9 +24,59 @@
  */
 #include "machines.h"
 
+#include <algorithm>
+#include <functional>
+
 namespace osp::link
 {
 
+void copy_machines(
+        Machines const &rSrc,
+        Machines &rDst,
+        ArrayView<MachAnyId> remapMachOut)
+{
+    // Create all new MachAnyIds at once
+    std::vector<MachAnyId> newIds(rSrc.ids.size());
+    rDst.ids.create(newIds.begin(), newIds.end());
+
+    std::size_t const capacity = rDst.ids.capacity();
+    rDst.machTypes  .resize(capacity);
+    rDst.machToLocal.resize(capacity);
+    rDst.perType    .resize(std::max(rDst.perType.size(), rSrc.perType.size()));
+
+    auto itNewId = newIds.cbegin();
+    for (MachAnyId const srcMach : rSrc.ids)
+    {
+        remapMachOut[srcMach] = *itNewId;
+        ++itNewId;
+    }
+
+    // Create MachLocalIds at once for each type. Going through local IDs in order keeps each
+    // type's machines in the same relative order they were in rSrc.
+    std::vector<MachLocalId> newLocals;
+    for (std::size_t type = 0; type < rSrc.perType.size(); ++type)
+    {
+        PerMachType const   &rSrcPerType = rSrc.perType[type];
+        PerMachType         &rDstPerType = rDst.perType[type];
+
+        newLocals.resize(rSrcPerType.localIds.size());
+        rDstPerType.localIds.create(newLocals.begin(), newLocals.end());
+        rDstPerType.localToAny.resize(rDstPerType.localIds.capacity());
+
+        auto itNewLocal = newLocals.cbegin();
+        for (MachLocalId const srcLocal : rSrcPerType.localIds)
+        {
+            MachLocalId const   dstLocal    = *itNewLocal;
+            MachAnyId const     dstMach     = remapMachOut[rSrcPerType.localToAny[srcLocal]];
+            ++itNewLocal;
+
+            rDstPerType.localToAny[dstLocal]    = dstMach;
+            rDst.machTypes[dstMach]             = MachTypeId(type);
+            rDst.machToLocal[dstMach]           = dstLocal;
+        }
+    }
+}
+
 void copy_nodes(
         Nodes const &rSrcNodes,
         Machines const &rSrcMach,
@@ -37,64 +87,103 @@ void copy_nodes(
 {
     using lgrn::Span;
 
-    // Create new node IDs
+    // Create all new node IDs at once
+    std::vector<NodeId> newIds(rSrcNodes.nodeIds.size());
+    rDstNodes.nodeIds.create(newIds.begin(), newIds.end());
+
+    auto itNewId = newIds.cbegin();
     for (NodeId const srcNode : rSrcNodes.nodeIds)
     {
-        NodeId const dstNode = rDstNodes.nodeIds.create();
-        remapNode[srcNode] = dstNode;
+        remapNode[srcNode] = *itNewId;
+        ++itNewId;
     }
 
+    // Only reallocate if the caller didn't reserve enough already, see reserve_nodes
+    reserve_nodes(rDstNodes, rDstMach.ids.capacity(),
+                  rSrcNodes.nodeToMach.data_size(), rSrcNodes.machToNode.data_size());
+
     // Copy node-to-machine connections
-    rDstNodes.nodeToMach.ids_reserve(rDstNodes.nodeIds.capacity());
-    rDstNodes.nodeToMach.data_reserve(rDstNodes.nodeToMach.data_size()
-                                        + rSrcNodes.nodeToMach.data_size());
     for (NodeId const srcNode : rSrcNodes.nodeIds)
     {
-        NodeId const dstNode = remapNode[srcNode];
-        Span<Junction const> srcJunction = rSrcNodes.nodeToMach[srcNode];
-        rDstNodes.nodeToMach.emplace(dstNode, srcJunction.size());
-        Span<Junction> dstJuncton = rDstNodes.nodeToMach[dstNode];
+        Span<Junction const> const  srcJunctions    = rSrcNodes.nodeToMach[srcNode];
+        Junction                    *pDstJunction   = rDstNodes.nodeToMach.emplace(remapNode[srcNode], srcJunctions.size());
 
-        auto dstJuncIt = std::begin(dstJuncton);
-        for (Junction const& srcJunc : srcJunction)
+        std::transform(std::begin(srcJunctions), std::end(srcJunctions), pDstJunction,
+                       [&rSrcMach, &rDstMach, remapMach] (Junction const& srcJunc) -> Junction
         {
-            MachTypeId const machType = srcJunc.type;
-            MachAnyId const srcMach = rSrcMach.perType[machType].localToAny[srcJunc.local];
-            MachAnyId const dstMach = remapMach[srcMach];
-            MachLocalId const dstLocal = rDstMach.machToLocal[dstMach];
-
-            dstJuncIt->local  = dstLocal;
-            dstJuncIt->type   = machType;
-            dstJuncIt->custom = srcJunc.custom;
-
-            std::advance(dstJuncIt, 1);
-        }
+            MachAnyId const srcMach = rSrcMach.perType[srcJunc.type].localToAny[srcJunc.local];
+            return { .local  = rDstMach.machToLocal[remapMach[srcMach]],
+                     .type   = srcJunc.type,
+                     .custom = srcJunc.custom };
+        });
     }
 
-    // copy mach-to-node connections
-    rDstNodes.machToNode.ids_reserve(rDstMach.ids.capacity());
-    rDstNodes.machToNode.data_reserve(rDstNodes.machToNode.data_size()
-                                        + rSrcNodes.machToNode.data_size());
+    // Copy mach-to-node connections
     for (MachAnyId const srcMach : rSrcMach.ids)
     {
         if (rSrcNodes.machToNode.contains(srcMach))
         {
-            Span<NodeId const> srcPorts = rSrcNodes.machToNode[srcMach];
-            MachAnyId const dstMach = remapMach[srcMach];
-            rDstNodes.machToNode.emplace(dstMach, srcPorts.size());
-            Span<NodeId> dstPorts = rDstNodes.machToNode[dstMach];
+            Span<NodeId const> const    srcPorts    = rSrcNodes.machToNode[srcMach];
+            NodeId                      *pDstPorts  = rDstNodes.machToNode.emplace(remapMach[srcMach], srcPorts.size());
 
-            auto dstPortIt = std::begin(dstPorts);
-            for (NodeId const srcNode : srcPorts)
+            std::transform(std::begin(srcPorts), std::end(srcPorts), pDstPorts,
+                           [remapNode] (NodeId const srcNode) -> NodeId
             {
-                *dstPortIt = (srcNode != lgrn::id_null<NodeId>())
-                           ? remapNode[srcNode]
-                           : lgrn::id_null<NodeId>();
+                return (srcNode != lgrn::id_null<NodeId>()) ? remapNode[srcNode] : lgrn::id_null<NodeId>();
+            });
+        }
+    }
+}
 
-                std::advance(dstPortIt, 1);
-            }
+void reserve_nodes(
+        Nodes &rNodes,
+        std::size_t const machCapacity,
+        std::size_t const moreNodeToMach,
+        std::size_t const moreMachToNode)
+{
+    rNodes.nodeToMach.ids_reserve(rNodes.nodeIds.capacity());
+    rNodes.machToNode.ids_reserve(machCapacity);
+
+    std::size_t const nodeToMachNeeded = rNodes.nodeToMach.data_size() + moreNodeToMach;
+    if (rNodes.nodeToMach.data_capacity() < nodeToMachNeeded)
+    {
+        rNodes.nodeToMach.data_reserve(nodeToMachNeeded);
+    }
+
+    std::size_t const machToNodeNeeded = rNodes.machToNode.data_size() + moreMachToNode;
+    if (rNodes.machToNode.data_capacity() < machToNodeNeeded)
+    {
+        rNodes.machToNode.data_reserve(machToNodeNeeded);
+    }
+}
+
+bool update_wake_timers(MachineUpdater& rUpdMach, float const deltaTime)
+{
+    std::vector<MachineUpdater::WakeTimer> &rTimers = rUpdMach.wakeTimers;
+    auto const later = std::greater<MachineUpdater::WakeTimer>{};
+
+    for (std::vector<MachineUpdater::WakeTimer> &rRequests : rUpdMach.wakeRequests)
+    {
+        for (MachineUpdater::WakeTimer const& timer : rRequests)
+        {
+            rTimers.push_back(timer);
+            std::push_heap(rTimers.begin(), rTimers.end(), later);
         }
+        rRequests.clear();
     }
+
+    rUpdMach.time += deltaTime;
+
+    bool anyWoke = false;
+    while ( ! rTimers.empty() && rTimers.front().time <= rUpdMach.time )
+    {
+        wake_machine(rUpdMach, rTimers.front().mach);
+        std::pop_heap(rTimers.begin(), rTimers.end(), later);
+        rTimers.pop_back();
+        anyWoke = true;
+    }
+
+    return anyWoke;
 }
 
 } // namespace osp::link
@@ -77,16 +77,85 @@ struct Machines
     std::vector<PerMachType>            perType;
 };
 
+/**
+ * @brief Keeps track of which machines need to update
+ *
+ * Machines sleep until woken up, either by one of their input nodes changing (see
+ * update_signal_nodes), or by a timer they requested running out (see wake_machine_after).
+ * Machines that don't need to do anything shouldn't request a timer, so the cost of an update
+ * scales with the number of awake machines, not all machines.
+ */
 struct MachineUpdater
 {
+    struct WakeTimer
+    {
+        double      time;
+        MachAnyId   mach;
+
+        constexpr bool operator>(WakeTimer const& rhs) const noexcept
+        {
+            return (time != rhs.time) ? (time > rhs.time) : (mach > rhs.mach);
+        }
+    };
+
     alignas(64) std::atomic<bool> requestMachineUpdateLoop {false};
 
     lgrn::IdSetStl<MachTypeId> machTypesDirty;
 
     // [MachTypeId][MachLocalId]
     osp::KeyedVec<MachTypeId, lgrn::IdSetStl<MachLocalId>> localDirty;
+
+    // Compiled by compile_signal_levels, machines update in order of level
+    // [MachAnyId] -> level
+    std::vector<uint16_t> machLevel;
+    uint16_t levelCount{0};
+    uint32_t levelsRevision{~uint32_t(0)}; // Revision of wiring the levels were compiled from
+
+    // Machines notified of new input values, waiting for their level to update
+    // [level][index] -> MachAnyId
+    std::vector<std::vector<MachAnyId>> levelPending = std::vector<std::vector<MachAnyId>>(1);
+
+    // Timers requested by machine update tasks, one vector per type so types can update in
+    // parallel. Moved into wakeTimers by update_wake_timers.
+    // [MachTypeId][index]
+    osp::KeyedVec<MachTypeId, std::vector<WakeTimer>> wakeRequests;
+
+    // Min-heap of timers for sleeping machines, ordered by time
+    std::vector<WakeTimer> wakeTimers;
+
+    double time{0.0};
 };
 
+/**
+ * @brief Wake up a machine so it updates within the next link update, as if an input changed
+ *
+ * Not thread-safe, only call this from tasks with exclusive access to rUpdMach.
+ */
+inline void wake_machine(MachineUpdater& rUpdMach, MachAnyId const mach)
+{
+    // Machines not sorted into levels yet (if added since wiring was compiled) update first
+    uint16_t const level = (mach < rUpdMach.machLevel.size()) ? rUpdMach.machLevel[mach] : 0;
+    rUpdMach.levelPending[level].push_back(mach);
+}
+
+/**
+ * @brief Request to wake up a machine after some time, eg. for a sequencer or a timed valve
+ *
+ * Safe to call from a machine update task running in parallel with other machine types, as
+ * long as type is the machine's own type.
+ */
+inline void wake_machine_after(MachineUpdater& rUpdMach, MachTypeId const type, MachAnyId const mach, float const delay)
+{
+    rUpdMach.wakeRequests[type].push_back({rUpdMach.time + delay, mach});
+}
+
+/**
+ * @brief Advance time, and wake up machines of timers that ran out
+ *
+ * @return true if any machine woke up, and link update must run
+ */
+bool update_wake_timers(MachineUpdater& rUpdMach, float deltaTime);
+
 struct MachinePair
 {
     MachLocalId     local   {lgrn::id_null<MachLocalId>()};
@@ -133,11 +202,23 @@ inline NodeId connected_node(lgrn::Span<NodeId const> portSpan, PortId port) noe
     return (portSpan.size() > port) ? portSpan[port] : lgrn::id_null<NodeId>();
 }
 
+/**
+ * @brief Copy all machines of rSrc into rDst
+ *
+ * IDs are created in bulk, one create per machine type.
+ */
 void copy_machines(
         Machines const &rSrc,
         Machines &rDst,
         ArrayView<MachAnyId> remapMachOut);
 
+/**
+ * @brief Copy nodes and their connections from rSrcNodes into rDstNodes
+ *
+ * Machines must already be copied, with remapMach mapping rSrcMach IDs to rDstMach IDs.
+ * Connections are copied span by span into the multimaps. When copying many times, call
+ * reserve_nodes first with the totals so the multimaps only reallocate once.
+ */
 void copy_nodes(
         Nodes const &rSrcNodes,
         Machines const &rSrcMach,
@@ -146,5 +227,18 @@ void copy_nodes(
         Machines &rDstMach,
         ArrayView<NodeId> remapNodeOut);
 
+/**
+ * @brief Reserve space for connections of more nodes, only reallocating if needed
+ *
+ * @param machCapacity      [in] Capacity of machine IDs that connect to these nodes
+ * @param moreNodeToMach    [in] Number of Junctions to be added to nodeToMach
+ * @param moreMachToNode    [in] Number of NodeIds to be added to machToNode
+ */
+void reserve_nodes(
+        Nodes &rNodes,
+        std::size_t machCapacity,
+        std::size_t moreNodeToMach,
+        std::size_t moreMachToNode);
+
 
 } // namespace osp::wire
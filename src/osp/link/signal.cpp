@@ -0,0 +1,179 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "signal.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace osp::link
+{
+
+void compile_signal_levels(
+        Machines const&                 machines,
+        ArrayView<Nodes const>          nodePerType,
+        MachineUpdater&                 rUpdMach)
+{
+    std::size_t const machCapacity = machines.ids.capacity();
+
+    // Collect writer -> reader edges between machines, sorted by writer
+    std::vector<std::pair<MachAnyId, MachAnyId>> edges;
+    std::vector<MachAnyId> writers;
+    for (Nodes const& rNodes : nodePerType)
+    {
+        for (NodeId const node : rNodes.nodeIds)
+        {
+            if ( ! rNodes.nodeToMach.contains(node) )
+            {
+                continue;
+            }
+
+            auto const junctions = rNodes.nodeToMach[node];
+
+            writers.clear();
+            for (Junction const& junc : junctions)
+            {
+                if (junc.custom == gc_sigOut)
+                {
+                    writers.push_back(machines.perType[junc.type].localToAny[junc.local]);
+                }
+            }
+            for (Junction const& junc : junctions)
+            {
+                if (junc.custom != gc_sigIn)
+                {
+                    continue;
+                }
+                MachAnyId const reader = machines.perType[junc.type].localToAny[junc.local];
+                for (MachAnyId const writer : writers)
+                {
+                    edges.emplace_back(writer, reader);
+                }
+            }
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    // Kahn's algorithm, with each machine's level being the longest path to it
+    std::vector<uint32_t> inCount(machCapacity, 0);
+    std::vector<uint32_t> firstEdge(machCapacity + 1, 0);
+    for (auto const [writer, reader] : edges)
+    {
+        ++inCount[reader];
+        ++firstEdge[writer + 1];
+    }
+    std::partial_sum(firstEdge.begin(), firstEdge.end(), firstEdge.begin());
+
+    std::vector<uint16_t> &rLevel = rUpdMach.machLevel;
+    rLevel.assign(machCapacity, 0);
+
+    std::vector<MachAnyId> ready;
+    std::size_t machCount = 0;
+    for (MachAnyId const mach : machines.ids)
+    {
+        ++machCount;
+        if (inCount[mach] == 0)
+        {
+            ready.push_back(mach);
+        }
+    }
+
+    uint16_t    maxLevel    = 0;
+    std::size_t sorted      = 0;
+    while ( ! ready.empty() )
+    {
+        MachAnyId const writer = ready.back();
+        ready.pop_back();
+        ++sorted;
+        maxLevel = std::max(maxLevel, rLevel[writer]);
+
+        for (uint32_t i = firstEdge[writer]; i < firstEdge[writer + 1]; ++i)
+        {
+            MachAnyId const reader = edges[i].second;
+            rLevel[reader] = std::max<uint16_t>(rLevel[reader], rLevel[writer] + 1);
+            if (--inCount[reader] == 0)
+            {
+                ready.push_back(reader);
+            }
+        }
+    }
+
+    rUpdMach.levelCount = maxLevel + 1;
+
+    if (sorted != machCount)
+    {
+        // Remaining machines are in or downstream of feedback loops. These update together in
+        // one extra level that may loop on itself, same as without levels
+        for (MachAnyId const mach : machines.ids)
+        {
+            if (inCount[mach] != 0)
+            {
+                rLevel[mach] = rUpdMach.levelCount;
+            }
+        }
+        ++rUpdMach.levelCount;
+    }
+
+    // Move machines still pending from before into their new levels
+    std::vector<MachAnyId> stillPending;
+    for (std::vector<MachAnyId> &rPending : rUpdMach.levelPending)
+    {
+        stillPending.insert(stillPending.end(), rPending.begin(), rPending.end());
+        rPending.clear();
+    }
+    rUpdMach.levelPending.resize(rUpdMach.levelCount);
+    for (MachAnyId const mach : stillPending)
+    {
+        rUpdMach.levelPending[rLevel[mach]].push_back(mach);
+    }
+}
+
+bool release_signal_level(
+        Machines const&                 machines,
+        MachineUpdater&                 rUpdMach)
+{
+    auto const itFirst = std::find_if(rUpdMach.levelPending.begin(), rUpdMach.levelPending.end(),
+                                      [] (std::vector<MachAnyId> const& rPending)
+    {
+        return ! rPending.empty();
+    });
+
+    if (itFirst == rUpdMach.levelPending.end())
+    {
+        return false;
+    }
+
+    for (MachAnyId const mach : *itFirst)
+    {
+        MachTypeId const type = machines.machTypes[mach];
+        rUpdMach.machTypesDirty.insert(type);
+        rUpdMach.localDirty[type].insert(machines.machToLocal[mach]);
+    }
+    itFirst->clear();
+
+    return signal_levels_pending(rUpdMach);
+}
+
+} // namespace osp::link
@@ -26,12 +26,67 @@
 
 #include "machines.h"
 
+#include "../core/math_types.h"
+
+#include <algorithm>
+#include <string_view>
+
 namespace osp::link
 {
 
 constexpr JuncCustom gc_sigIn  = 0;
 constexpr JuncCustom gc_sigOut = 1;
 
+inline NodeTypeId const gc_ntSigInt     = NodeTypeReg_t::create();
+inline NodeTypeId const gc_ntSigMask    = NodeTypeReg_t::create();
+inline NodeTypeId const gc_ntSigVec3    = NodeTypeReg_t::create();
+
+/**
+ * @brief Bits of a bitmask signal, used for booleans
+ *
+ * A plain bool signal would be stored in a packed std::vector<bool>, which can't be viewed as an
+ * array. Up to 32 booleans (eg. switches or valve states) fit into one node instead.
+ */
+using SigMask_t = uint32_t;
+
+/**
+ * @brief Associates a value type with its signal node type
+ *
+ * Signal storage, update code, and VehicleBuilder copy logic are all templated on the value type,
+ * so adding a new signal type only requires a specialization here. Values must be trivially
+ * copyable.
+ */
+template <typename VALUE_T>
+struct SignalType;
+
+template <>
+struct SignalType<float>
+{
+    static NodeTypeId node_type() noexcept { return gc_ntSigFloat; }
+    static constexpr std::string_view smc_name = "float";
+};
+
+template <>
+struct SignalType<int32_t>
+{
+    static NodeTypeId node_type() noexcept { return gc_ntSigInt; }
+    static constexpr std::string_view smc_name = "int";
+};
+
+template <>
+struct SignalType<SigMask_t>
+{
+    static NodeTypeId node_type() noexcept { return gc_ntSigMask; }
+    static constexpr std::string_view smc_name = "mask";
+};
+
+template <>
+struct SignalType<Vector3>
+{
+    static NodeTypeId node_type() noexcept { return gc_ntSigVec3; }
+    static constexpr std::string_view smc_name = "Vector3";
+};
+
 template <typename VALUE_T>
 using SignalValues_t = std::vector<VALUE_T>;
 
@@ -51,6 +106,99 @@ struct UpdateNodes
     }
 };
 
+/**
+ * @brief Separate UpdateNodes for each writer, so writers can run in parallel without locks
+ *
+ * Writers are given a fixed index, such as their MachTypeId, and only ever touch their own
+ * UpdateNodes. merge_into applies them in index order, so if two writers assign the same node,
+ * the higher index wins no matter which thread finished first.
+ */
+template <typename VALUE_T>
+struct UpdateNodesPerWriter
+{
+    // Aligned to keep writers on different cores from sharing cache lines
+    struct alignas(64) Writer
+    {
+        UpdateNodes<VALUE_T> upd;
+    };
+
+    void resize(std::size_t const writerCount, std::size_t const nodeCapacity)
+    {
+        writers.resize(writerCount);
+        for (Writer &rWriter : writers)
+        {
+            rWriter.upd.nodeDirty.resize(nodeCapacity);
+            rWriter.upd.nodeNewValues.resize(nodeCapacity);
+        }
+    }
+
+    UpdateNodes<VALUE_T>& operator[](std::size_t const writer) noexcept
+    {
+        return writers[writer].upd;
+    }
+
+    /**
+     * @brief Move all writers' assigned values into rDst, then clear the writers
+     *
+     * Must not run in parallel with any writer.
+     */
+    void merge_into(UpdateNodes<VALUE_T> &rDst)
+    {
+        for (Writer &rWriter : writers)
+        {
+            UpdateNodes<VALUE_T> &rSrc = rWriter.upd;
+            if ( ! rSrc.dirty )
+            {
+                continue;
+            }
+
+            for (NodeId const node : rSrc.nodeDirty)
+            {
+                rDst.assign(node, rSrc.nodeNewValues[node]);
+            }
+            rSrc.nodeDirty.clear();
+            rSrc.dirty = false;
+        }
+    }
+
+    std::vector<Writer> writers;
+};
+
+/**
+ * @brief Sort machines into levels by the signals connecting them
+ *
+ * A machine's level is one higher than the level of any machine writing to its inputs. Machines
+ * that are part of a feedback loop can't be sorted, and are all put into the last level.
+ *
+ * Run this whenever wiring changes. update_signal_nodes will then defer notified machines to
+ * their level, and release_signal_level lets each level update only after all levels below it
+ * are done. This way, a machine updates at most once per wave of changes, with all of its
+ * inputs already final.
+ *
+ * @param machines      [in] All machines
+ * @param nodePerType   [in] Nodes of each node type connecting the machines
+ * @param rUpdMach      [out] Machine levels are written to here
+ */
+void compile_signal_levels(
+        Machines const&                 machines,
+        ArrayView<Nodes const>          nodePerType,
+        MachineUpdater&                 rUpdMach);
+
+[[nodiscard]] inline bool signal_levels_pending(MachineUpdater const& updMach) noexcept
+{
+    return std::any_of(updMach.levelPending.begin(), updMach.levelPending.end(),
+                       [] (std::vector<MachAnyId> const& pending) { return ! pending.empty(); });
+}
+
+/**
+ * @brief Mark machines of the lowest pending level as dirty, see compile_signal_levels
+ *
+ * @return true if higher levels are still pending and the update loop must run again
+ */
+bool release_signal_level(
+        Machines const&                 machines,
+        MachineUpdater&                 rUpdMach);
+
 template <typename VALUE_T, typename RANGE_T>
 bool update_signal_nodes(
         RANGE_T const&                  toUpdate,
@@ -74,11 +222,9 @@ bool update_signal_nodes(
             {
                 somethingNotified = true;
 
-                // A machine of type "junc.m_type" has new values to read
-                rUpdMach.machTypesDirty.insert(junc.type);
-
-                // Specify using local Id on which machine needs to update
-                rUpdMach.localDirty[junc.type].insert(junc.local);
+                // A machine of type "junc.m_type" has new values to read. It updates after all
+                // levels below it are done, see release_signal_level
+                wake_machine(rUpdMach, machines.perType[junc.type].localToAny[junc.local]);
             }
         }
     }
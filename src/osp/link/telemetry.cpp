@@ -0,0 +1,218 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "telemetry.h"
+
+#include <algorithm>
+#include <new>
+
+#if defined(__linux__) || defined(__APPLE__)
+    #define OSP_TELEMETRY_SHM 1
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <unistd.h>
+#else
+    #define OSP_TELEMETRY_SHM 0
+#endif
+
+namespace osp::link
+{
+
+namespace
+{
+
+constexpr char gc_magic[8] = {'O', 'S', 'P', 'T', 'L', 'M', 'T', '\0'};
+
+constexpr std::uint64_t align8(std::uint64_t const value) noexcept
+{
+    return (value + 7u) & ~std::uint64_t(7u);
+}
+
+#if OSP_TELEMETRY_SHM
+void munmap_deleter(unsigned char* pData, std::size_t size)
+{
+    ::munmap(pData, size);
+}
+#endif
+
+} // namespace
+
+SignalTelemetry::~SignalTelemetry()
+{
+    release();
+}
+
+void SignalTelemetry::release() noexcept
+{
+#if OSP_TELEMETRY_SHM
+    // Moved-from instances have no block, and must not remove the name used by the new owner
+    if ( ! m_sharedName.empty() && ! m_block.isEmpty() )
+    {
+        ::shm_unlink(m_sharedName.c_str());
+    }
+#endif
+    m_block = {};
+    m_sharedName.clear();
+    m_columns.clear();
+    m_writing = false;
+}
+
+ETelemetryExport SignalTelemetry::allocate(std::uint32_t const frameCapacity, char const* sharedName)
+{
+    LGRN_ASSERTM(frameCapacity != 0, "Need at least one frame");
+    release();
+
+    // Sort by type then node, so consecutive nodes can be merged into columns
+    std::sort(m_selected.begin(), m_selected.end(), [] (Selected const& lhs, Selected const& rhs)
+    {
+        return (lhs.nodeType != rhs.nodeType) ? (lhs.nodeType < rhs.nodeType) : (lhs.node < rhs.node);
+    });
+    m_selected.erase(std::unique(m_selected.begin(), m_selected.end(), [] (Selected const& lhs, Selected const& rhs)
+    {
+        return lhs.nodeType == rhs.nodeType && lhs.node == rhs.node;
+    }), m_selected.end());
+
+    for (Selected const& selected : m_selected)
+    {
+        if (   ! m_columns.empty()
+            && m_columns.back().nodeType == selected.nodeType
+            && m_columns.back().firstNode + m_columns.back().nodeCount == selected.node )
+        {
+            ++m_columns.back().nodeCount;
+            continue;
+        }
+
+        TelemetryColumn column{};
+        std::copy_n(selected.typeName.data(), std::min<std::size_t>(selected.typeName.size(), sizeof(column.typeName) - 1), column.typeName);
+        column.nodeType  = selected.nodeType;
+        column.valueSize = selected.valueSize;
+        column.firstNode = selected.node;
+        column.nodeCount = 1;
+        m_columns.push_back(column);
+    }
+
+    // Lay out the block
+    std::uint64_t const timeOffset = align8(sizeof(TelemetryHeader) + sizeof(TelemetryColumn) * m_columns.size());
+    std::uint64_t       blockSize  = timeOffset + sizeof(double) * frameCapacity;
+    for (TelemetryColumn &rColumn : m_columns)
+    {
+        rColumn.dataOffset = blockSize;
+        blockSize = align8(blockSize + std::uint64_t(rColumn.valueSize) * rColumn.nodeCount * frameCapacity);
+    }
+
+    ETelemetryExport status = ETelemetryExport::Private;
+
+#if OSP_TELEMETRY_SHM
+    if (sharedName != nullptr)
+    {
+        status = ETelemetryExport::SharedFailed;
+
+        int const fd = ::shm_open(sharedName, O_CREAT | O_RDWR, 0600);
+        if (fd != -1)
+        {
+            void *pMapped = MAP_FAILED;
+            if (::ftruncate(fd, off_t(blockSize)) == 0)
+            {
+                pMapped = ::mmap(nullptr, std::size_t(blockSize), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            }
+            ::close(fd); // Mapping stays valid
+
+            if (pMapped != MAP_FAILED)
+            {
+                // Possibly left over from a previous run
+                std::memset(pMapped, 0, std::size_t(blockSize));
+                m_block = Corrade::Containers::Array<unsigned char>{
+                        static_cast<unsigned char*>(pMapped), std::size_t(blockSize), munmap_deleter};
+                m_sharedName = sharedName;
+                status = ETelemetryExport::Shared;
+            }
+            else
+            {
+                ::shm_unlink(sharedName);
+            }
+        }
+    }
+#else
+    if (sharedName != nullptr)
+    {
+        status = ETelemetryExport::SharedFailed;
+    }
+#endif
+
+    if (m_block.isEmpty())
+    {
+        m_block = Corrade::Containers::Array<unsigned char>{Corrade::ValueInit, std::size_t(blockSize)};
+    }
+
+    TelemetryHeader *const pHeader = new (m_block.data()) TelemetryHeader{};
+    std::copy_n(gc_magic, sizeof(gc_magic), pHeader->magic);
+    pHeader->version        = gc_telemetryVersion;
+    pHeader->columnCount    = std::uint32_t(m_columns.size());
+    pHeader->frameCapacity  = frameCapacity;
+    pHeader->blockSize      = blockSize;
+    pHeader->frameCount     = 0;
+    pHeader->timeOffset     = timeOffset;
+    pHeader->sequence.store(0, std::memory_order_relaxed);
+
+    std::memcpy(m_block.data() + sizeof(TelemetryHeader), m_columns.data(), sizeof(TelemetryColumn) * m_columns.size());
+
+    // Publish the layout
+    std::atomic_thread_fence(std::memory_order_release);
+
+    return status;
+}
+
+bool telemetry_copy(ArrayView<unsigned char const> const block, std::vector<unsigned char> &rOut, int const attempts)
+{
+    if (block.size() < sizeof(TelemetryHeader))
+    {
+        return false;
+    }
+
+    auto const &header = *reinterpret_cast<TelemetryHeader const*>(block.data());
+    if (std::memcmp(header.magic, gc_magic, sizeof(gc_magic)) != 0 || header.version != gc_telemetryVersion)
+    {
+        return false;
+    }
+
+    for (int i = 0; i < attempts; ++i)
+    {
+        std::uint64_t const before = header.sequence.load(std::memory_order_acquire);
+        if ((before & 1u) != 0)
+        {
+            continue; // Frame being written
+        }
+
+        rOut.assign(block.begin(), block.end());
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (header.sequence.load(std::memory_order_relaxed) == before)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace osp::link
@@ -0,0 +1,282 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+/**
+ * @file
+ * @brief Columnar ring buffer of signal node values, optionally exported through shared memory
+ */
+#pragma once
+
+#include "signal.h"
+
+#include "../core/copymove_macros.h"
+
+#include <Corrade/Containers/Array.h>
+
+#include <longeron/utility/asserts.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace osp::link
+{
+
+/**
+ * @brief Version of the block layout written by SignalTelemetry
+ *
+ * Increment whenever TelemetryHeader, TelemetryColumn, or the data layout changes.
+ */
+constexpr std::uint32_t gc_telemetryVersion = 1;
+
+/**
+ * @brief Start of a telemetry block
+ *
+ * Guarded by a seqlock: sequence is odd while a frame is being written, and increases by 2 for
+ * each frame. Readers copy what they need between two reads of sequence, and retry if it was odd
+ * or changed in between. See telemetry_copy.
+ */
+struct TelemetryHeader
+{
+    char                        magic[8];
+    std::uint32_t               version;
+    std::uint32_t               columnCount;
+    std::uint32_t               frameCapacity;
+    std::uint32_t               reserved;
+
+    /// Size of the whole block in bytes
+    std::uint64_t               blockSize;
+
+    /// Total frames recorded. The latest is at index (frameCount - 1) % frameCapacity.
+    std::uint64_t               frameCount;
+
+    /// Offset in bytes to the time column, frameCapacity doubles
+    std::uint64_t               timeOffset;
+
+    std::atomic<std::uint64_t>  sequence;
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+              "Seqlock in shared memory needs a lock-free 64-bit atomic");
+
+/**
+ * @brief Describes one column, a run of consecutive signal nodes of the same type
+ *
+ * Column data is frameCapacity frames of nodeCount values each, so values of a frame are
+ * contiguous and can be recorded with a single copy.
+ */
+struct TelemetryColumn
+{
+    /// Value type name such as "float", see SignalType::smc_name. Null-terminated.
+    char                        typeName[8];
+    NodeTypeId                  nodeType;
+    std::uint16_t               valueSize;
+    NodeId                      firstNode;
+    std::uint32_t               nodeCount;
+    std::uint32_t               reserved;
+
+    /// Offset in bytes from the start of the block to frame 0
+    std::uint64_t               dataOffset;
+};
+
+enum class ETelemetryExport : std::uint8_t
+{
+    /// Only in this process's memory
+    Private,
+
+    /// Exported to shared memory under the requested name
+    Shared,
+
+    /// Shared memory was requested but couldn't be created, fell back to Private
+    SharedFailed
+};
+
+/**
+ * @brief Records selected signal node values each tick into a preallocated columnar ring buffer
+ *
+ * Intended for flight analysis, where values such as throttle and RCS commands are wanted every
+ * frame without formatting strings in hot tasks. Usage:
+ *
+ * 1. select or select_port nodes of any signal type
+ * 2. allocate, optionally with a shared memory name for external readers such as dashboards
+ * 3. Each tick: begin_frame, record for each signal type used, then end_frame
+ *
+ * Selected nodes are sorted and merged into columns of consecutive NodeIds, so recording a frame
+ * is one memcpy per column straight out of SignalValues_t. Nothing is allocated after allocate.
+ *
+ * The block is laid out as TelemetryHeader, TelemetryColumn[columnCount], then the time column
+ * and column data, each 8-byte aligned. Readers must have the same endianness and float format.
+ *
+ * Not thread-safe; a single task should record.
+ */
+class SignalTelemetry
+{
+public:
+
+    SignalTelemetry() = default;
+    OSP_MOVE_ONLY_CTOR(SignalTelemetry);
+    ~SignalTelemetry();
+
+    /**
+     * @brief Select a node to record. Must be called before allocate.
+     */
+    template <typename VALUE_T>
+    void select(NodeId const node)
+    {
+        static_assert(std::is_trivially_copyable_v<VALUE_T>);
+        m_selected.push_back({SignalType<VALUE_T>::node_type(), node,
+                              std::uint16_t(sizeof(VALUE_T)), SignalType<VALUE_T>::smc_name});
+    }
+
+    /**
+     * @brief Select the node connected to a machine's port. Does nothing if unconnected.
+     */
+    template <typename VALUE_T>
+    void select_port(Nodes const& nodes, MachAnyId const mach, PortId const port)
+    {
+        NodeId const node = connected_node(nodes.machToNode[mach], port);
+        if (node != lgrn::id_null<NodeId>())
+        {
+            select<VALUE_T>(node);
+        }
+    }
+
+    /**
+     * @brief Lay out and allocate the block for the selected nodes, discarding any previous one
+     *
+     * @param frameCapacity [in] Frames kept before the oldest is overwritten
+     * @param sharedName    [in] Shared memory object name such as "/osp_telemetry", or nullptr
+     *                           to keep it private. Removed again when this is destroyed.
+     */
+    ETelemetryExport allocate(std::uint32_t frameCapacity, char const* sharedName = nullptr);
+
+    /**
+     * @brief Start writing a frame; readers retry until end_frame
+     *
+     * @param time [in] Stored in the time column, such as seconds since the scene started
+     */
+    void begin_frame(double const time) noexcept
+    {
+        LGRN_ASSERTM( ! m_block.isEmpty(), "allocate must be called first");
+        LGRN_ASSERTM( ! m_writing, "end_frame not called");
+        m_writing = true;
+
+        TelemetryHeader &rHeader = header();
+        rHeader.sequence.store(rHeader.sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        m_frame = std::uint32_t(rHeader.frameCount % rHeader.frameCapacity);
+        std::memcpy(m_block.data() + rHeader.timeOffset + sizeof(double) * m_frame, &time, sizeof(double));
+    }
+
+    /**
+     * @brief Copy all selected nodes of one signal type into the current frame
+     *
+     * @param values [in] All node values of VALUE_T's node type
+     */
+    template <typename VALUE_T>
+    void record(SignalValues_t<VALUE_T> const& values) noexcept
+    {
+        LGRN_ASSERTM(m_writing, "begin_frame not called");
+        NodeTypeId const nodeType = SignalType<VALUE_T>::node_type();
+        for (TelemetryColumn const& column : m_columns)
+        {
+            if (column.nodeType != nodeType)
+            {
+                continue;
+            }
+            LGRN_ASSERTM(column.firstNode + column.nodeCount <= values.size(), "Selected node out of range");
+
+            std::size_t const frameBytes = sizeof(VALUE_T) * column.nodeCount;
+            std::memcpy(m_block.data() + column.dataOffset + frameBytes * m_frame,
+                        values.data() + column.firstNode, frameBytes);
+        }
+    }
+
+    /**
+     * @brief Publish the current frame to readers
+     */
+    void end_frame() noexcept
+    {
+        LGRN_ASSERTM(m_writing, "begin_frame not called");
+        m_writing = false;
+
+        TelemetryHeader &rHeader = header();
+        rHeader.frameCount += 1;
+        rHeader.sequence.store(rHeader.sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    [[nodiscard]] std::vector<TelemetryColumn> const& columns() const noexcept { return m_columns; }
+
+    /// Whole block, header included. Readers in another process see the same bytes.
+    [[nodiscard]] ArrayView<unsigned char const> block() const noexcept { return m_block; }
+
+    [[nodiscard]] bool is_shared() const noexcept { return ! m_sharedName.empty(); }
+
+private:
+
+    struct Selected
+    {
+        NodeTypeId          nodeType;
+        NodeId              node;
+        std::uint16_t       valueSize;
+        std::string_view    typeName;
+    };
+
+    TelemetryHeader& header() noexcept
+    {
+        return *reinterpret_cast<TelemetryHeader*>(m_block.data());
+    }
+
+    void release() noexcept;
+
+    std::vector<Selected>                       m_selected;
+
+    /// Copy of the columns in the block, so recording doesn't read from shared memory
+    std::vector<TelemetryColumn>                m_columns;
+
+    Corrade::Containers::Array<unsigned char>   m_block;
+
+    /// Name of the shared memory object, empty if private
+    std::string                                 m_sharedName;
+
+    std::uint32_t                               m_frame     {0};
+    bool                                        m_writing   {false};
+
+}; // class SignalTelemetry
+
+/**
+ * @brief Copy a telemetry block consistently, such as one mapped from shared memory by a reader
+ *
+ * @param block     [in] Whole block, starting with the TelemetryHeader
+ * @param rOut      [out] Resized to and filled with a copy of the block
+ * @param attempts  [in] Times to retry if a frame was being written meanwhile
+ *
+ * @return true if the copy is consistent. rOut is left in an unspecified state if not.
+ */
+bool telemetry_copy(ArrayView<unsigned char const> block, std::vector<unsigned char> &rOut, int attempts = 16);
+
+} // namespace osp::link
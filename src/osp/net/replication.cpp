@@ -0,0 +1,741 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "replication.h"
+
+#include "../core/byte_stream.h"
+
+#include <longeron/utility/asserts.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+using namespace osp;
+using namespace osp::net;
+
+namespace
+{
+
+enum EReplField : std::uint8_t
+{
+    Position        = 1u << 0u,
+    Rotation        = 1u << 1u,
+    Velocity        = 1u << 2u,
+    AngVelocity     = 1u << 3u,
+    Structure       = 1u << 4u,
+    Signals         = 1u << 5u,
+    New             = 1u << 6u  ///< Encoded against a zeroed object instead of the baseline
+};
+
+constexpr ReplFrame     gc_noBaseline   = std::numeric_limits<ReplFrame>::max();
+constexpr double        gc_sqrt2        = 1.41421356237309504880;
+constexpr std::int32_t  gc_rotationMax  = (1 << (gc_replRotationBits - 1)) - 1;
+
+/// Added to the priority of objects the client doesn't know about yet, so they appear first
+constexpr float         gc_newPriority  = 1000.0f;
+
+// Header size in bytes: type, version, frame, baseline frame, record count
+constexpr std::size_t   gc_headerSize   = 1 + 1 + 4 + 4 + 2;
+constexpr std::size_t   gc_recordCountPos = gc_headerSize - 2;
+
+std::int32_t quantize(double const value, double const step) noexcept
+{
+    double const steps = std::round(value / step);
+    return std::int32_t(std::clamp<double>(steps, std::numeric_limits<std::int32_t>::min(),
+                                                  std::numeric_limits<std::int32_t>::max()));
+}
+
+void write_varint(std::vector<std::byte> &rOut, std::uint64_t value)
+{
+    while (value >= 0x80u)
+    {
+        rOut.push_back(std::byte(std::uint8_t(value) | 0x80u));
+        value >>= 7u;
+    }
+    rOut.push_back(std::byte(value));
+}
+
+void write_zigzag(std::vector<std::byte> &rOut, std::int64_t const value)
+{
+    write_varint(rOut, (std::uint64_t(value) << 1u) ^ std::uint64_t(value >> 63));
+}
+
+[[nodiscard]] bool read_varint(ByteReader &rReader, std::uint64_t &rOut) noexcept
+{
+    rOut = 0;
+    for (unsigned int shift = 0; shift < 64; shift += 7)
+    {
+        std::uint8_t byte;
+        if ( ! rReader.read(byte) )
+        {
+            return false;
+        }
+        rOut |= std::uint64_t(byte & 0x7Fu) << shift;
+        if ((byte & 0x80u) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+[[nodiscard]] bool read_zigzag(ByteReader &rReader, std::int64_t &rOut) noexcept
+{
+    std::uint64_t raw;
+    if ( ! read_varint(rReader, raw) )
+    {
+        return false;
+    }
+    rOut = std::int64_t(raw >> 1u) ^ -std::int64_t(raw & 1u);
+    return true;
+}
+
+template <std::size_t N>
+void write_deltas(std::vector<std::byte> &rOut, std::array<std::int32_t, N> const& value, std::array<std::int32_t, N> const& base)
+{
+    for (std::size_t i = 0; i < N; ++i)
+    {
+        write_zigzag(rOut, std::int64_t(value[i]) - std::int64_t(base[i]));
+    }
+}
+
+template <std::size_t N>
+[[nodiscard]] bool read_deltas(ByteReader &rReader, std::array<std::int32_t, N> &rValue, std::array<std::int32_t, N> const& base) noexcept
+{
+    for (std::size_t i = 0; i < N; ++i)
+    {
+        std::int64_t delta;
+        if ( ! read_zigzag(rReader, delta) )
+        {
+            return false;
+        }
+        rValue[i] = std::int32_t(std::int64_t(base[i]) + delta);
+    }
+    return true;
+}
+
+/**
+ * @brief Smallest three: the largest component is omitted and recalculated from the others
+ */
+std::array<std::int32_t, 4> quantize_rotation(Quaternion const& rot) noexcept
+{
+    Quaternion const q = rot.normalized();
+    std::array<float, 4> const comp{q.vector().x(), q.vector().y(), q.vector().z(), q.scalar()};
+
+    std::size_t largest = 0;
+    for (std::size_t i = 1; i < 4; ++i)
+    {
+        if (std::abs(comp[i]) > std::abs(comp[largest]))
+        {
+            largest = i;
+        }
+    }
+
+    // q and -q are the same rotation, keep the omitted component positive
+    float const sign = (comp[largest] < 0.0f) ? -1.0f : 1.0f;
+
+    std::array<std::int32_t, 4> out{std::int32_t(largest), 0, 0, 0};
+    std::size_t j = 1;
+    for (std::size_t i = 0; i < 4; ++i)
+    {
+        if (i != largest)
+        {
+            out[j++] = quantize(sign * comp[i] * gc_sqrt2, 1.0 / gc_rotationMax);
+        }
+    }
+    return out;
+}
+
+Quaternion dequantize_rotation(std::array<std::int32_t, 4> const& rot) noexcept
+{
+    auto const largest = std::size_t(std::clamp(rot[0], 0, 3));
+
+    std::array<float, 4> comp{};
+    float sumSq = 0.0f;
+    std::size_t j = 1;
+    for (std::size_t i = 0; i < 4; ++i)
+    {
+        if (i != largest)
+        {
+            comp[i] = float(double(rot[j++]) / gc_rotationMax / gc_sqrt2);
+            sumSq += comp[i] * comp[i];
+        }
+    }
+    comp[largest] = std::sqrt(std::max(0.0f, 1.0f - sumSq));
+
+    return Quaternion{{comp[0], comp[1], comp[2]}, comp[3]}.normalized();
+}
+
+Vector3 dequantize_position(ReplObject const& obj) noexcept
+{
+    return Vector3{float(obj.position[0] * gc_replPositionStep),
+                   float(obj.position[1] * gc_replPositionStep),
+                   float(obj.position[2] * gc_replPositionStep)};
+}
+
+/**
+ * @brief Copy an object into another snapshot, along with its structure and signals
+ */
+void copy_object(ReplSnapshot &rDst, ReplObjId const id, ReplSnapshot const& src, ReplObject obj)
+{
+    auto const structure = repl_object_structure(src, obj);
+    auto const signals   = ArrayView<std::uint32_t const>{src.signals.data() + obj.signalsOffset, obj.signalsCount};
+
+    obj.structureOffset = std::uint32_t(rDst.structures.size());
+    obj.signalsOffset   = std::uint32_t(rDst.signals.size());
+    rDst.structures .insert(rDst.structures.end(), structure.begin(), structure.end());
+    rDst.signals    .insert(rDst.signals.end(),    signals.begin(),   signals.end());
+
+    LGRN_ASSERTM(rDst.ids.empty() || rDst.ids.back() < id, "Objects must be added in ascending ID order");
+    rDst.ids    .push_back(id);
+    rDst.objects.push_back(obj);
+}
+
+/**
+ * @brief Write an object if its quantized state differs from base
+ *
+ * @param pBaseSnap [in] Snapshot containing pBase, or nullptr if it's a new object
+ *
+ * @return false if there's nothing to write
+ */
+bool write_record(
+        std::vector<std::byte>  &rOut,
+        ReplObjId               const id,
+        ReplSnapshot            const &current,
+        ReplObject              const &obj,
+        ReplSnapshot            const *pBaseSnap,
+        ReplObject              const *pBase)
+{
+    static constexpr ReplObject const sc_zero{};
+    ReplObject const &base = (pBase != nullptr) ? *pBase : sc_zero;
+
+    auto const signals     = ArrayView<std::uint32_t const>{current.signals.data() + obj.signalsOffset, obj.signalsCount};
+    auto const baseSignals = (pBase != nullptr)
+                           ? ArrayView<std::uint32_t const>{pBaseSnap->signals.data() + base.signalsOffset, base.signalsCount}
+                           : ArrayView<std::uint32_t const>{};
+
+    std::uint8_t mask = (pBase == nullptr) ? New : 0;
+    if (obj.position    != base.position)       { mask |= Position; }
+    if (obj.rotation    != base.rotation)       { mask |= Rotation; }
+    if (obj.velocity    != base.velocity)       { mask |= Velocity; }
+    if (obj.angVelocity != base.angVelocity)    { mask |= AngVelocity; }
+    if (pBase == nullptr || obj.structureRev != base.structureRev) { mask |= Structure; }
+    if (   signals.size() != baseSignals.size()
+        || ! std::equal(signals.begin(), signals.end(), baseSignals.begin()))
+    {
+        mask |= Signals;
+    }
+
+    if (mask == 0)
+    {
+        return false;
+    }
+
+    write_varint(rOut, id.value);
+    rOut.push_back(std::byte(mask));
+
+    if (mask & Position)    { write_deltas(rOut, obj.position,    base.position); }
+    if (mask & Rotation)    { write_deltas(rOut, obj.rotation,    base.rotation); }
+    if (mask & Velocity)    { write_deltas(rOut, obj.velocity,    base.velocity); }
+    if (mask & AngVelocity) { write_deltas(rOut, obj.angVelocity, base.angVelocity); }
+    if (mask & Structure)
+    {
+        auto const structure = repl_object_structure(current, obj);
+        write_varint(rOut, obj.structureRev);
+        write_varint(rOut, structure.size());
+        append_bytes(rOut, structure.data(), structure.size());
+    }
+    if (mask & Signals)
+    {
+        // Count, then (index gap, value) of each value that changed
+        write_varint(rOut, signals.size());
+
+        std::size_t changed = 0;
+        for (std::size_t i = 0; i < signals.size(); ++i)
+        {
+            changed += (i >= baseSignals.size() || signals[i] != baseSignals[i]) ? 1 : 0;
+        }
+        write_varint(rOut, changed);
+
+        std::size_t prev = 0;
+        for (std::size_t i = 0; i < signals.size(); ++i)
+        {
+            if (i >= baseSignals.size() || signals[i] != baseSignals[i])
+            {
+                write_varint(rOut, i - prev);
+                append_bytes(rOut, signals[i]);
+                prev = i;
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+std::size_t ReplSnapshot::find(ReplObjId const id) const noexcept
+{
+    auto const it = std::lower_bound(ids.begin(), ids.end(), id);
+    return (it != ids.end() && *it == id) ? std::size_t(it - ids.begin()) : ids.size();
+}
+
+void osp::net::repl_snapshot_add(
+        ReplSnapshot                &rSnapshot,
+        ReplObjId                   const id,
+        Matrix4                     const &transform,
+        Vector3                     const velocity,
+        Vector3                     const angVelocity,
+        std::uint32_t               const structureRev,
+        ArrayView<std::byte const>  const structure,
+        ArrayView<float const>      const signals)
+{
+    LGRN_ASSERTM(rSnapshot.ids.empty() || rSnapshot.ids.back() < id, "Objects must be added in ascending ID order");
+
+    Vector3 const pos = transform.translation();
+
+    ReplObject &rObj = rSnapshot.objects.emplace_back();
+    rSnapshot.ids.push_back(id);
+
+    for (int i = 0; i < 3; ++i)
+    {
+        rObj.position[i]    = quantize(pos[i],          gc_replPositionStep);
+        rObj.velocity[i]    = quantize(velocity[i],     gc_replVelocityStep);
+        rObj.angVelocity[i] = quantize(angVelocity[i],  gc_replAngVelocityStep);
+    }
+    rObj.rotation = quantize_rotation(Quaternion::fromMatrix(transform.rotation()));
+
+    rObj.structureRev       = structureRev;
+    rObj.structureOffset    = std::uint32_t(rSnapshot.structures.size());
+    rObj.structureSize      = std::uint32_t(structure.size());
+    rSnapshot.structures.insert(rSnapshot.structures.end(), structure.begin(), structure.end());
+
+    rObj.signalsOffset      = std::uint32_t(rSnapshot.signals.size());
+    rObj.signalsCount       = std::uint32_t(signals.size());
+    for (float const value : signals)
+    {
+        rSnapshot.signals.push_back(std::bit_cast<std::uint32_t>(value));
+    }
+}
+
+ReplObjectState osp::net::repl_object_state(ReplObject const& obj) noexcept
+{
+    return {
+        .transform      = Matrix4::from(dequantize_rotation(obj.rotation).toMatrix(), dequantize_position(obj)),
+        .velocity       = Vector3{float(obj.velocity[0]),    float(obj.velocity[1]),    float(obj.velocity[2])}    * gc_replVelocityStep,
+        .angVelocity    = Vector3{float(obj.angVelocity[0]), float(obj.angVelocity[1]), float(obj.angVelocity[2])} * gc_replAngVelocityStep };
+}
+
+ArrayView<std::byte const> osp::net::repl_object_structure(ReplSnapshot const& snapshot, ReplObject const& obj) noexcept
+{
+    return {snapshot.structures.data() + obj.structureOffset, obj.structureSize};
+}
+
+ArrayView<float const> osp::net::repl_object_signals(ReplSnapshot const& snapshot, ReplObject const& obj) noexcept
+{
+    static_assert(sizeof(float) == sizeof(std::uint32_t));
+    return {reinterpret_cast<float const*>(snapshot.signals.data() + obj.signalsOffset), obj.signalsCount};
+}
+
+void osp::net::repl_encode(
+        ReplClient                  &rClient,
+        ReplSnapshot                const &current,
+        ReplConfig                  const &config,
+        std::vector<std::byte>      &rOut)
+{
+    static ReplSnapshot const sc_empty{};
+
+    // Snapshots older than the acked one will never be used as a baseline again
+    ReplSnapshot const *pBase = &sc_empty;
+    if (rClient.acked.has_value())
+    {
+        while ( ! rClient.sent.empty() && rClient.sent.front().frame < *rClient.acked )
+        {
+            rClient.sent.pop_front();
+        }
+        if ( ! rClient.sent.empty() && rClient.sent.front().frame == *rClient.acked )
+        {
+            pBase = &rClient.sent.front();
+        }
+    }
+    ReplSnapshot const &base = *pBase;
+
+    // Objects in range of the client's focus
+    float const radiusSq = config.interestRadius * config.interestRadius;
+    rClient.candidates.clear();
+    rClient.priority.resize(std::max(rClient.priority.size(), current.ids.empty() ? 0 : std::size_t(current.ids.back().value) + 1));
+    for (std::uint32_t i = 0; i < current.ids.size(); ++i)
+    {
+        float const distSq = (dequantize_position(current.objects[i]) - rClient.focus).dot();
+        if (distSq > radiusSq)
+        {
+            continue;
+        }
+
+        // Nearer objects are updated more often
+        float &rPriority = rClient.priority[current.ids[i]];
+        rPriority += 1.0f - 0.9f * std::sqrt(distSq / radiusSq);
+        if (base.find(current.ids[i]) == base.ids.size())
+        {
+            rPriority += gc_newPriority;
+        }
+        rClient.candidates.push_back(i);
+    }
+
+    rOut.clear();
+    rOut.reserve(config.packetBudget);
+    append_bytes(rOut, EReplPacket::Snapshot);
+    append_bytes(rOut, gc_replVersion);
+    append_bytes(rOut, current.frame);
+    append_bytes(rOut, (pBase == &sc_empty) ? gc_noBaseline : base.frame);
+    append_bytes(rOut, std::uint16_t(0)); // Record count, written afterwards
+
+    // Baseline objects that left the area of interest or no longer exist. Both lists are
+    // ascending, so removed IDs are delta-encoded.
+    {
+        std::vector<ReplObjId> removed;
+        auto itCand = rClient.candidates.begin();
+        for (ReplObjId const id : base.ids)
+        {
+            while (itCand != rClient.candidates.end() && current.ids[*itCand] < id)
+            {
+                ++itCand;
+            }
+            if (itCand == rClient.candidates.end() || current.ids[*itCand] != id)
+            {
+                removed.push_back(id);
+            }
+        }
+
+        write_varint(rOut, removed.size());
+        std::uint32_t prev = 0;
+        for (ReplObjId const id : removed)
+        {
+            write_varint(rOut, id.value - prev);
+            prev = id.value;
+        }
+    }
+
+    // Write highest priority first until the packet is full
+    std::vector<std::uint32_t> order = rClient.candidates;
+    std::sort(order.begin(), order.end(), [&rClient, &current] (std::uint32_t const lhs, std::uint32_t const rhs)
+    {
+        return rClient.priority[current.ids[lhs]] > rClient.priority[current.ids[rhs]];
+    });
+
+    std::vector<bool> written(current.ids.size(), false);
+    std::uint16_t recordCount = 0;
+    for (std::uint32_t const i : order)
+    {
+        ReplObjId    const id      = current.ids[i];
+        std::size_t  const baseIdx = base.find(id);
+        ReplObject   const *pBaseObj = (baseIdx != base.ids.size()) ? &base.objects[baseIdx] : nullptr;
+
+        rClient.record.clear();
+        if ( ! write_record(rClient.record, id, current, current.objects[i], &base, pBaseObj) )
+        {
+            // Unchanged, the client already has it
+            written[i] = true;
+            rClient.priority[id] = 0.0f;
+            continue;
+        }
+
+        if (   rOut.size() + rClient.record.size() > config.packetBudget
+            || recordCount == std::numeric_limits<std::uint16_t>::max() )
+        {
+            continue;
+        }
+
+        rOut.insert(rOut.end(), rClient.record.begin(), rClient.record.end());
+        written[i] = true;
+        rClient.priority[id] = 0.0f;
+        ++recordCount;
+    }
+    std::memcpy(rOut.data() + gc_recordCountPos, &recordCount, sizeof(recordCount));
+
+    // Record what the client will know once it receives this packet; the current state of
+    // written objects, and the baseline state of objects that didn't fit
+    ReplSnapshot view;
+    view.frame = current.frame;
+    for (std::uint32_t const i : rClient.candidates)
+    {
+        ReplObjId const id = current.ids[i];
+        if (written[i])
+        {
+            copy_object(view, id, current, current.objects[i]);
+        }
+        else if (std::size_t const baseIdx = base.find(id);
+                 baseIdx != base.ids.size())
+        {
+            copy_object(view, id, base, base.objects[baseIdx]);
+        }
+    }
+
+    rClient.sent.push_back(std::move(view));
+    while (rClient.sent.size() > config.historySize)
+    {
+        rClient.sent.pop_front();
+    }
+}
+
+bool osp::net::repl_read_ack(ReplClient &rClient, ArrayView<std::byte const> const packet)
+{
+    ByteReader reader{packet};
+
+    EReplPacket         type;
+    std::uint8_t        version;
+    ReplFrame           frame;
+    std::array<float, 3> focus;
+    if (   ! reader.read(type) || type != EReplPacket::Ack
+        || ! reader.read(version) || version != gc_replVersion
+        || ! reader.read(frame)
+        || ! reader.read(focus) )
+    {
+        return false;
+    }
+
+    rClient.focus = Vector3{focus[0], focus[1], focus[2]};
+
+    // Acks can arrive out of order, only move forward
+    if (frame != gc_noBaseline && ( ! rClient.acked.has_value() || frame > *rClient.acked ))
+    {
+        rClient.acked = frame;
+    }
+    return true;
+}
+
+EReplDecode osp::net::repl_decode(ReplReceiver &rReceiver, ArrayView<std::byte const> const packet)
+{
+    ByteReader reader{packet};
+
+    EReplPacket     type;
+    std::uint8_t    version;
+    ReplFrame       frame;
+    ReplFrame       baseFrame;
+    std::uint16_t   recordCount;
+    if ( ! reader.read(type) || type != EReplPacket::Snapshot || ! reader.read(version) )
+    {
+        return EReplDecode::Malformed;
+    }
+    if (version != gc_replVersion)
+    {
+        return EReplDecode::WrongVersion;
+    }
+    if ( ! reader.read(frame) || ! reader.read(baseFrame) || ! reader.read(recordCount) )
+    {
+        return EReplDecode::Malformed;
+    }
+
+    if (rReceiver.latest() != nullptr && frame <= rReceiver.latest()->frame)
+    {
+        return EReplDecode::Outdated;
+    }
+
+    static ReplSnapshot const sc_empty{};
+    ReplSnapshot const *pBase = &sc_empty;
+    if (baseFrame != gc_noBaseline)
+    {
+        auto const itBase = std::find_if(rReceiver.received.begin(), rReceiver.received.end(),
+                                         [baseFrame] (ReplSnapshot const& snap) { return snap.frame == baseFrame; });
+        if (itBase == rReceiver.received.end())
+        {
+            return EReplDecode::MissingBaseline;
+        }
+        pBase = &*itBase;
+    }
+    ReplSnapshot const &base = *pBase;
+
+    std::uint64_t removedCount;
+    if ( ! read_varint(reader, removedCount) || removedCount > base.ids.size() )
+    {
+        return EReplDecode::Malformed;
+    }
+    std::vector<ReplObjId> removed;
+    removed.reserve(removedCount);
+    std::uint64_t id = 0;
+    for (std::uint64_t i = 0; i < removedCount; ++i)
+    {
+        std::uint64_t gap;
+        if ( ! read_varint(reader, gap) )
+        {
+            return EReplDecode::Malformed;
+        }
+        id += gap;
+        removed.push_back(ReplObjId(std::uint32_t(id)));
+    }
+
+    // Decode records into their own snapshot, then merge with the baseline
+    ReplSnapshot records;
+    std::vector<ReplObjId> recordIds;
+    std::vector<std::uint32_t> signals;
+    for (std::uint16_t i = 0; i < recordCount; ++i)
+    {
+        std::uint64_t idInt;
+        std::uint8_t  mask;
+        if ( ! read_varint(reader, idInt) || ! reader.read(mask) )
+        {
+            return EReplDecode::Malformed;
+        }
+        auto const recId = ReplObjId(std::uint32_t(idInt));
+
+        std::size_t const baseIdx = (mask & New) ? base.ids.size() : base.find(recId);
+        bool        const hasBase = baseIdx != base.ids.size();
+        if ( ! (mask & New) && ! hasBase )
+        {
+            return EReplDecode::Malformed;
+        }
+
+        ReplObject obj = hasBase ? base.objects[baseIdx] : ReplObject{};
+        ReplObject const baseObj = obj;
+
+        bool ok = true;
+        if (mask & Position)    { ok = ok && read_deltas(reader, obj.position,    baseObj.position); }
+        if (mask & Rotation)    { ok = ok && read_deltas(reader, obj.rotation,    baseObj.rotation); }
+        if (mask & Velocity)    { ok = ok && read_deltas(reader, obj.velocity,    baseObj.velocity); }
+        if (mask & AngVelocity) { ok = ok && read_deltas(reader, obj.angVelocity, baseObj.angVelocity); }
+        if ( ! ok )
+        {
+            return EReplDecode::Malformed;
+        }
+
+        ArrayView<std::byte const> structure = hasBase ? repl_object_structure(base, baseObj) : ArrayView<std::byte const>{};
+        if (mask & Structure)
+        {
+            std::uint64_t rev;
+            std::uint64_t size;
+            if (   ! read_varint(reader, rev) || ! read_varint(reader, size)
+                || ! reader.read_view(size, structure) )
+            {
+                return EReplDecode::Malformed;
+            }
+            obj.structureRev = std::uint32_t(rev);
+        }
+
+        signals.assign(base.signals.begin() + (hasBase ? baseObj.signalsOffset : 0),
+                       base.signals.begin() + (hasBase ? baseObj.signalsOffset + baseObj.signalsCount : 0));
+        if (mask & Signals)
+        {
+            std::uint64_t count;
+            std::uint64_t changed;
+            // Values past the end of the baseline's are always sent
+            if (   ! read_varint(reader, count) || ! read_varint(reader, changed)
+                || changed > count || count > signals.size() + changed )
+            {
+                return EReplDecode::Malformed;
+            }
+            signals.resize(count, 0);
+
+            std::uint64_t index = 0;
+            for (std::uint64_t j = 0; j < changed; ++j)
+            {
+                std::uint64_t gap;
+                if ( ! read_varint(reader, gap) || (index += gap) >= count || ! reader.read(signals[index]) )
+                {
+                    return EReplDecode::Malformed;
+                }
+            }
+        }
+
+        obj.structureOffset = std::uint32_t(records.structures.size());
+        obj.structureSize   = std::uint32_t(structure.size());
+        obj.signalsOffset   = std::uint32_t(records.signals.size());
+        obj.signalsCount    = std::uint32_t(signals.size());
+        records.structures  .insert(records.structures.end(), structure.begin(), structure.end());
+        records.signals     .insert(records.signals.end(), signals.begin(), signals.end());
+        records.objects     .push_back(obj);
+        recordIds           .push_back(recId);
+    }
+
+    if ( ! reader.remaining().empty() )
+    {
+        return EReplDecode::Malformed;
+    }
+
+    // Records are in priority order, sort them by ID to merge
+    std::vector<std::uint32_t> recordOrder(recordIds.size());
+    for (std::uint32_t i = 0; i < recordOrder.size(); ++i)
+    {
+        recordOrder[i] = i;
+    }
+    std::sort(recordOrder.begin(), recordOrder.end(), [&recordIds] (std::uint32_t const lhs, std::uint32_t const rhs)
+    {
+        return recordIds[lhs] < recordIds[rhs];
+    });
+    for (std::size_t i = 1; i < recordOrder.size(); ++i)
+    {
+        if (recordIds[recordOrder[i - 1]] == recordIds[recordOrder[i]])
+        {
+            return EReplDecode::Malformed;
+        }
+    }
+
+    ReplSnapshot out;
+    out.frame = frame;
+
+    auto itRec     = recordOrder.begin();
+    auto itRemoved = removed.begin();
+    for (std::size_t i = 0; i < base.ids.size(); ++i)
+    {
+        ReplObjId const baseId = base.ids[i];
+        for (; itRec != recordOrder.end() && recordIds[*itRec] < baseId; ++itRec)
+        {
+            copy_object(out, recordIds[*itRec], records, records.objects[*itRec]);
+        }
+        if (itRec != recordOrder.end() && recordIds[*itRec] == baseId)
+        {
+            continue; // Written below, with the next baseline ID or after the loop
+        }
+
+        while (itRemoved != removed.end() && *itRemoved < baseId)
+        {
+            ++itRemoved;
+        }
+        if (itRemoved == removed.end() || *itRemoved != baseId)
+        {
+            copy_object(out, baseId, base, base.objects[i]);
+        }
+    }
+    for (; itRec != recordOrder.end(); ++itRec)
+    {
+        copy_object(out, recordIds[*itRec], records, records.objects[*itRec]);
+    }
+
+    rReceiver.received.push_back(std::move(out));
+    while (rReceiver.received.size() > rReceiver.historySize)
+    {
+        rReceiver.received.pop_front();
+    }
+    return EReplDecode::Ok;
+}
+
+void osp::net::repl_write_ack(ReplReceiver const &receiver, Vector3 const focus, std::vector<std::byte> &rOut)
+{
+    rOut.clear();
+    append_bytes(rOut, EReplPacket::Ack);
+    append_bytes(rOut, gc_replVersion);
+    append_bytes(rOut, (receiver.latest() != nullptr) ? receiver.latest()->frame : gc_noBaseline);
+    append_bytes(rOut, std::array<float, 3>{focus.x(), focus.y(), focus.z()});
+}
@@ -0,0 +1,245 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "../core/array_view.h"
+#include "../core/keyed_vector.h"
+#include "../core/math_types.h"
+#include "../core/strong_id.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <vector>
+
+namespace osp::net
+{
+
+/**
+ * @brief Version of the replication packet format, packets of other versions are ignored
+ */
+constexpr std::uint8_t gc_replVersion = 1;
+
+/// Position quantization step in meters
+constexpr double gc_replPositionStep        = 1.0 / 1024.0;
+
+/// Velocity quantization step in meters per second
+constexpr float gc_replVelocityStep         = 1.0f / 256.0f;
+
+/// Angular velocity quantization step in radians per second
+constexpr float gc_replAngVelocityStep      = 1.0f / 1024.0f;
+
+/// Rotations are sent as the 3 smallest quaternion components, each with this many bits
+constexpr int gc_replRotationBits           = 20;
+
+using ReplObjId = StrongId<std::uint32_t, struct DummyForReplObjId>;
+using ReplFrame = std::uint32_t;
+
+enum class EReplPacket : std::uint8_t { Snapshot = 1, Ack = 2 };
+
+/**
+ * @brief Quantized state of a replicated object, such as a vehicle weld
+ *
+ * Quantized values are compared and delta-encoded as integers, so a value the server sent is
+ * reconstructed exactly by the client.
+ */
+struct ReplObject
+{
+    std::array<std::int32_t, 3> position        {};
+    std::array<std::int32_t, 4> rotation        {}; ///< Index of omitted component, then the other 3
+    std::array<std::int32_t, 3> velocity        {};
+    std::array<std::int32_t, 3> angVelocity     {};
+
+    /// Changes whenever structure changes, such as parts being added or removed
+    std::uint32_t               structureRev    {0};
+
+    /// Range in ReplSnapshot::structures, opaque to replication
+    std::uint32_t               structureOffset {0};
+    std::uint32_t               structureSize   {0};
+
+    /// Range in ReplSnapshot::signals
+    std::uint32_t               signalsOffset   {0};
+    std::uint32_t               signalsCount    {0};
+};
+
+/**
+ * @brief State of all replicated objects for one frame
+ *
+ * The server builds one per frame with repl_snapshot_add. Clients get their own, with only the
+ * objects they're interested in, from repl_decode.
+ */
+struct ReplSnapshot
+{
+    void clear() noexcept
+    {
+        ids         .clear();
+        objects     .clear();
+        signals     .clear();
+        structures  .clear();
+    }
+
+    [[nodiscard]] std::size_t find(ReplObjId id) const noexcept;
+
+    ReplFrame                   frame{0};
+
+    /// Ascending, parallel to objects
+    std::vector<ReplObjId>      ids;
+    std::vector<ReplObject>     objects;
+
+    /// Bit patterns of float signal values
+    std::vector<std::uint32_t>  signals;
+    std::vector<std::byte>      structures;
+};
+
+/**
+ * @brief Dequantized transform and velocities of a ReplObject
+ */
+struct ReplObjectState
+{
+    Matrix4     transform;
+    Vector3     velocity;
+    Vector3     angVelocity;
+};
+
+/**
+ * @brief Quantize and add an object to a snapshot, in ascending ID order
+ *
+ * @param transform [in] Rigid transform without scale
+ * @param structure [in] Serialized structure, only sent to clients if structureRev changed
+ * @param signals   [in] Signal values of the object, only changed values are sent
+ */
+void repl_snapshot_add(
+        ReplSnapshot                &rSnapshot,
+        ReplObjId                   id,
+        Matrix4              const  &transform,
+        Vector3                     velocity,
+        Vector3                     angVelocity,
+        std::uint32_t               structureRev,
+        ArrayView<std::byte const>  structure,
+        ArrayView<float const>      signals);
+
+[[nodiscard]] ReplObjectState repl_object_state(ReplObject const& obj) noexcept;
+
+[[nodiscard]] ArrayView<std::byte const> repl_object_structure(ReplSnapshot const& snapshot, ReplObject const& obj) noexcept;
+
+[[nodiscard]] ArrayView<float const> repl_object_signals(ReplSnapshot const& snapshot, ReplObject const& obj) noexcept;
+
+struct ReplConfig
+{
+    /// Objects further than this from a client's focus aren't sent to it, in meters
+    float           interestRadius  {5000.0f};
+
+    /// Packets are kept below this size, to avoid IP fragmentation
+    std::size_t     packetBudget    {1200};
+
+    /// Snapshots kept per client to delta-encode against once acknowledged
+    std::size_t     historySize     {32};
+};
+
+/**
+ * @brief Server-side state of one client
+ */
+struct ReplClient
+{
+    /// Position the client is interested in, in scene space. Sent by the client with acks.
+    Vector3                     focus;
+
+    /// Latest frame the client acknowledged, its baseline for the next packet
+    std::optional<ReplFrame>    acked;
+
+    /// What the client will know after receiving each frame, oldest first
+    std::deque<ReplSnapshot>    sent;
+
+    /// Grows each frame an object isn't sent, so far objects still get updates under load
+    KeyedVec<ReplObjId, float>  priority;
+
+    /// Scratch
+    std::vector<std::uint32_t>  candidates;
+    std::vector<std::byte>      record;
+};
+
+/**
+ * @brief Write a snapshot packet for one client, delta-encoded against the client's latest
+ *        acknowledged snapshot
+ *
+ * Objects within ReplConfig::interestRadius of the client's focus are written in order of
+ * priority until ReplConfig::packetBudget is used up. Objects that don't fit keep their
+ * baseline state for the client, and are more likely to fit the next packet. Objects whose
+ * quantized state didn't change cost nothing.
+ *
+ * @param rOut  [out] Cleared, then the packet
+ */
+void repl_encode(
+        ReplClient                  &rClient,
+        ReplSnapshot    const       &current,
+        ReplConfig      const       &config,
+        std::vector<std::byte>      &rOut);
+
+/**
+ * @brief Read an ack packet from a client
+ *
+ * @return false if the packet is malformed
+ */
+bool repl_read_ack(ReplClient &rClient, ArrayView<std::byte const> packet);
+
+/**
+ * @brief Client-side state, keeps received snapshots to decode deltas against
+ */
+struct ReplReceiver
+{
+    [[nodiscard]] ReplSnapshot const* latest() const noexcept
+    {
+        return received.empty() ? nullptr : &received.back();
+    }
+
+    /// Newest last
+    std::deque<ReplSnapshot>    received;
+    std::size_t                 historySize{32};
+};
+
+enum class EReplDecode : std::uint8_t
+{
+    Ok,
+    Malformed,
+    WrongVersion,
+    MissingBaseline,    ///< Baseline was already dropped, wait for the server to catch up
+    Outdated            ///< Older than the latest snapshot received
+};
+
+/**
+ * @brief Decode a snapshot packet and add it to ReplReceiver::received
+ */
+EReplDecode repl_decode(ReplReceiver &rReceiver, ArrayView<std::byte const> packet);
+
+/**
+ * @brief Write an ack packet, acknowledging the latest received snapshot
+ *
+ * @param focus [in] Position the client is interested in
+ */
+void repl_write_ack(ReplReceiver const &receiver, Vector3 focus, std::vector<std::byte> &rOut);
+
+} // namespace osp::net
@@ -0,0 +1,162 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "udp_socket.h"
+
+#include <utility>
+
+#if defined(__linux__) || defined(__APPLE__)
+    #define OSP_UDP_POSIX 1
+    #include <arpa/inet.h>
+    #include <fcntl.h>
+    #include <netinet/in.h>
+    #include <sys/socket.h>
+    #include <unistd.h>
+#else
+    #define OSP_UDP_POSIX 0
+#endif
+
+using namespace osp::net;
+
+UdpSocket::UdpSocket(UdpSocket&& move) noexcept
+ : m_fd{std::exchange(move.m_fd, -1)}
+{ }
+
+UdpSocket& UdpSocket::operator=(UdpSocket&& move) noexcept
+{
+    close();
+    m_fd = std::exchange(move.m_fd, -1);
+    return *this;
+}
+
+UdpSocket::~UdpSocket()
+{
+    close();
+}
+
+#if OSP_UDP_POSIX
+
+bool UdpSocket::open(std::uint16_t const port)
+{
+    close();
+
+    int const fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd == -1)
+    {
+        return false;
+    }
+
+    sockaddr_in addr{};
+    addr.sin_family         = AF_INET;
+    addr.sin_addr.s_addr    = htonl(INADDR_ANY);
+    addr.sin_port           = htons(port);
+
+    int const flags = ::fcntl(fd, F_GETFL, 0);
+    if (   flags == -1
+        || ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1
+        || ::bind(fd, reinterpret_cast<sockaddr const*>(&addr), sizeof(addr)) == -1 )
+    {
+        ::close(fd);
+        return false;
+    }
+
+    m_fd = fd;
+    return true;
+}
+
+void UdpSocket::close() noexcept
+{
+    if (m_fd != -1)
+    {
+        ::close(std::exchange(m_fd, -1));
+    }
+}
+
+std::uint16_t UdpSocket::port() const noexcept
+{
+    sockaddr_in addr{};
+    socklen_t   len = sizeof(addr);
+    if (m_fd == -1 || ::getsockname(m_fd, reinterpret_cast<sockaddr*>(&addr), &len) == -1)
+    {
+        return 0;
+    }
+    return ntohs(addr.sin_port);
+}
+
+bool UdpSocket::send_to(UdpAddress const to, ArrayView<std::byte const> const packet) noexcept
+{
+    sockaddr_in addr{};
+    addr.sin_family         = AF_INET;
+    addr.sin_addr.s_addr    = htonl(to.ipv4);
+    addr.sin_port           = htons(to.port);
+
+    auto const sent = ::sendto(m_fd, packet.data(), packet.size(), 0,
+                               reinterpret_cast<sockaddr const*>(&addr), sizeof(addr));
+    return sent == static_cast<decltype(sent)>(packet.size());
+}
+
+std::optional<std::size_t> UdpSocket::receive(ArrayView<std::byte> const buffer, UdpAddress &rFrom) noexcept
+{
+    sockaddr_in addr{};
+    socklen_t   len = sizeof(addr);
+
+    auto const received = ::recvfrom(m_fd, buffer.data(), buffer.size(), 0,
+                                     reinterpret_cast<sockaddr*>(&addr), &len);
+    if (received < 0)
+    {
+        return std::nullopt;
+    }
+
+    rFrom = {.ipv4 = ntohl(addr.sin_addr.s_addr), .port = ntohs(addr.sin_port)};
+    return std::size_t(received);
+}
+
+#else // !OSP_UDP_POSIX
+
+bool UdpSocket::open(std::uint16_t)
+{
+    return false;
+}
+
+void UdpSocket::close() noexcept
+{
+    m_fd = -1;
+}
+
+std::uint16_t UdpSocket::port() const noexcept
+{
+    return 0;
+}
+
+bool UdpSocket::send_to(UdpAddress, ArrayView<std::byte const>) noexcept
+{
+    return false;
+}
+
+std::optional<std::size_t> UdpSocket::receive(ArrayView<std::byte>, UdpAddress&) noexcept
+{
+    return std::nullopt;
+}
+
+#endif // OSP_UDP_POSIX
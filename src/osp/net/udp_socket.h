@@ -0,0 +1,89 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "../core/array_view.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace osp::net
+{
+
+struct UdpAddress
+{
+    constexpr bool operator==(UdpAddress const&) const noexcept = default;
+
+    std::uint32_t   ipv4{0};    ///< Host byte order
+    std::uint16_t   port{0};
+};
+
+/**
+ * @brief Non-blocking IPv4 UDP socket
+ *
+ * Only implemented on Linux and macOS for now, open fails elsewhere.
+ */
+class UdpSocket
+{
+public:
+    UdpSocket() = default;
+    UdpSocket(UdpSocket const& copy) = delete;
+    UdpSocket(UdpSocket&& move) noexcept;
+    UdpSocket& operator=(UdpSocket const& copy) = delete;
+    UdpSocket& operator=(UdpSocket&& move) noexcept;
+    ~UdpSocket();
+
+    /**
+     * @brief Bind to a port on all interfaces, 0 for any free port
+     *
+     * @return true on success
+     */
+    bool open(std::uint16_t port);
+
+    void close() noexcept;
+
+    [[nodiscard]] bool is_open() const noexcept { return m_fd != -1; }
+
+    /// @return Port bound to, useful after opening with port 0
+    [[nodiscard]] std::uint16_t port() const noexcept;
+
+    /// @return true if the whole packet was sent
+    bool send_to(UdpAddress to, ArrayView<std::byte const> packet) noexcept;
+
+    /**
+     * @brief Receive one packet if any is waiting
+     *
+     * Packets larger than buffer are truncated.
+     *
+     * @return Size of the packet, or nullopt if there are none
+     */
+    std::optional<std::size_t> receive(ArrayView<std::byte> buffer, UdpAddress &rFrom) noexcept;
+
+private:
+    int m_fd{-1};
+};
+
+} // namespace osp::net
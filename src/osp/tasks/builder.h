@@ -80,6 +80,21 @@ struct TaskBuilderBase
         };
     }
 
+    /**
+     * @brief Create a Semaphore that limits how many of its acquiring Tasks can run at once
+     *
+     * @param limit [in] Max number of Tasks that can hold the Semaphore at the same time
+     */
+    [[nodiscard]] SemaphoreId create_semaphore(unsigned int const limit)
+    {
+        LGRN_ASSERTM(limit != 0, "Semaphore with limit of 0 can never be acquired");
+
+        SemaphoreId const sema = m_rTasks.m_semaIds.create();
+        m_rTasks.m_semaLimits.resize(m_rTasks.m_semaIds.capacity(), 0);
+        m_rTasks.m_semaLimits[sema] = limit;
+        return sema;
+    }
+
     template<typename TGT_STRUCT_T>
     TGT_STRUCT_T create_pipelines(osp::ArrayView<PipelineId> const pipelinesOut)
     {
@@ -196,6 +211,18 @@ struct TaskRefBase
         return add_edges(m_rBuilder.m_rEdges.m_syncWith, specs);
     }
 
+    TaskRef_t& acquire(std::initializer_list<SemaphoreId const> semas) noexcept
+    {
+        for (SemaphoreId const sema : semas)
+        {
+            m_rBuilder.m_rEdges.m_semaphoreEdges.push_back({
+                .task      = m_taskId,
+                .semaphore = sema
+            });
+        }
+        return static_cast<TaskRef_t&>(*this);
+    }
+
     TaskId          m_taskId;
     Builder_t       & m_rBuilder;
 
@@ -250,6 +277,18 @@ struct PipelineRefBase
         return static_cast<PipelineRef_t&>(*this);
     }
 
+    /**
+     * @brief Only run once every runEvery times the pipeline's scheduler task allows it to
+     *
+     * For low-priority pipelines that don't need to update every frame. Tasks of the pipeline
+     * should not assume a fixed time step between runs. See PipelineControl::runEvery.
+     */
+    PipelineRef_t& run_every(std::uint32_t const runEvery)
+    {
+        m_rBuilder.m_rTasks.m_pipelineControl[m_pipelineId].runEvery = runEvery;
+        return static_cast<PipelineRef_t&>(*this);
+    }
+
     PipelineId      m_pipelineId;
     Builder_t       & m_rBuilder;
 
@@ -26,16 +26,20 @@
 #include "execute.h"
 
 #include <Corrade/Containers/ArrayViewStl.h>
+
+#include <algorithm>
 #include <iterator>
 
 namespace osp
 {
 
-static void exec_log(ExecContext &rExec, ExecContext::LogMsg_t msg) noexcept;
+static inline void exec_log(ExecContext &rExec, ExecContext::LogMsg_t msg) noexcept;
 
 static void pipeline_run_root(Tasks const& tasks, TaskGraph const& graph, ExecContext &rExec, PipelineId pipeline) noexcept;
 
-static int pipeline_run(Tasks const& tasks, TaskGraph const& graph, ExecContext &rExec, bool rerunLoop, PipelineId pipeline, PipelineTreePos_t treePos, uint32_t descendents, bool isLoopScope, bool insideLoopScope);
+static void pipeline_run(Tasks const& tasks, TaskGraph const& graph, ExecContext &rExec, bool rerunLoop, PipelineTreePos_t root);
+
+static void pipeline_run_single(TaskGraph const& graph, ExecContext &rExec, bool rerunLoop, PipelineId pipeline, bool loop);
 
 static void pipeline_advance_stage(Tasks const& tasks, TaskGraph const& graph, ExecContext &rExec, PipelineId pipeline) noexcept;
 
@@ -49,6 +53,14 @@ static void pipeline_try_advance(ExecContext &rExec, ExecPipeline &rExecPl, Pipe
 
 static void pipeline_cancel(Tasks const& tasks, TaskGraph const& graph, ExecContext& rExec, ExecPipeline& rExecPl, PipelineId pipeline) noexcept;
 
+static void task_enqueue_run(Tasks const& tasks, TaskGraph const& graph, ExecContext &rExec, TaskId task) noexcept;
+
+static bool task_try_acquire(Tasks const& tasks, TaskGraph const& graph, ExecContext &rExec, TaskId task) noexcept;
+
+static void task_release(Tasks const& tasks, TaskGraph const& graph, ExecContext &rExec, TaskId task) noexcept;
+
+static bool is_task_queued_sema(ExecContext const& exec, TaskId task) noexcept;
+
 struct ArgsForIsPipelineInLoop
 {
     PipelineId viewedFrom;
@@ -76,14 +88,11 @@ void exec_update(Tasks const& tasks, TaskGraph const& graph, ExecContext &rExec)
 
     if (rExec.hasRequestRun)
     {
-        for (ExecPipeline const& rExecPl : rExec.plData)
-        {
-            LGRN_ASSERTM( ! rExecPl.running, "Running new pipelines while already running is not yet supported ROFL! "
-                                             "Make sure all pipelines are finished running.");
-        }
-
         for (PipelineId const plId : rExec.plRequestRun)
         {
+            // Other pipeline trees may still be running, eg. held by a suspended coroutine task
+            LGRN_ASSERTM( ! rExec.plData[plId].running, "Running a pipeline while it's already running is not yet supported ROFL! "
+                                                        "Make sure it finished running.");
             pipeline_run_root(tasks, graph, rExec, plId);
         }
         rExec.plRequestRun.clear();
@@ -91,9 +100,12 @@ void exec_update(Tasks const& tasks, TaskGraph const& graph, ExecContext &rExec)
     }
 
 
+    uint32_t cycles = 0;
+
     while (rExec.hasPlAdvanceOrLoop)
     {
         exec_log(rExec, ExecContext::UpdateCycle{});
+        ++ cycles;
 
         rExec.hasPlAdvanceOrLoop = false;
 
@@ -108,6 +120,7 @@ void exec_update(Tasks const& tasks, TaskGraph const& graph, ExecContext &rExec)
         for (PipelineId const plId : rExec.plAdvance)
         {
             pipeline_advance_stage(tasks, graph, rExec, plId);
+            ++ rExec.stats.pipelinesAdvanced;
         }
 
         for (PipelineId const plId : rExec.plAdvance)
@@ -120,11 +133,13 @@ void exec_update(Tasks const& tasks, TaskGraph const& graph, ExecContext &rExec)
             pipeline_advance_run(tasks, graph, rExec, plId);
         }
         rExec.plAdvance.clear();
-        
-        rExec.plAdvance.insert(rExec.plAdvanceNext.begin(), rExec.plAdvanceNext.end());
-        rExec.plAdvanceNext.clear();
+        rExec.plAdvance.take(rExec.plAdvanceNext);
     }
 
+    ++ rExec.stats.updates;
+    rExec.stats.cycles += cycles;
+    rExec.stats.maxCyclesPerUpdate = std::max(rExec.stats.maxCyclesPerUpdate, cycles);
+
     exec_log(rExec, ExecContext::UpdateEnd{});
 }
 
@@ -135,6 +150,8 @@ void complete_task(Tasks const& tasks, TaskGraph const& graph, ExecContext &rExe
 
     exec_log(rExec, ExecContext::CompleteTask{task});
 
+    task_release(tasks, graph, rExec, task);
+
     auto const [pipeline, stage] = tasks.m_taskRunOn[task];
     ExecPipeline &rExecPl = rExec.plData[pipeline];
 
@@ -142,6 +159,24 @@ void complete_task(Tasks const& tasks, TaskGraph const& graph, ExecContext &rExe
 
     pipeline_try_advance(rExec, rExecPl, pipeline);
 
+    // Runs skipped for PipelineControl::runEvery are canceled the same way the scheduler would.
+    // The first run allowed by the scheduler goes through, then the next runEvery-1 are skipped.
+    if (tasks.m_pipelineControl[pipeline].scheduler == task && ! (actions & TaskAction::Cancel))
+    {
+        std::uint32_t const maxSkip = std::max(rExecPl.runEvery, 1u) - 1;
+        std::uint32_t const skip    = std::min(rExecPl.runsToSkip, maxSkip);
+
+        if (skip == 0)
+        {
+            rExecPl.runsToSkip = maxSkip;
+        }
+        else
+        {
+            rExecPl.runsToSkip = skip - 1;
+            actions |= TaskAction::Cancel;
+        }
+    }
+
     if (actions & TaskAction::Cancel)
     {
         LGRN_ASSERTMV(rExecPl.tasksQueuedRun == 0 && rExecPl.tasksQueuedBlocked == 0,
@@ -221,83 +256,89 @@ static void pipeline_run_root(Tasks const& tasks, TaskGraph const& graph, ExecCo
 
     PipelineTreePos_t const treePos = graph.pipelineToPltree[pipeline];
 
-    bool const isLoopScope = tasks.m_pipelineControl[pipeline].isLoopScope;
-
-    uint32_t const descendents = (treePos != lgrn::id_null<PipelineTreePos_t>())
-                               ? graph.pltreeDescendantCounts[treePos]
-                               : 0;
-
-    pipeline_run(tasks, graph, rExec, false, pipeline, treePos, descendents, isLoopScope, false);
+    if (treePos != lgrn::id_null<PipelineTreePos_t>())
+    {
+        pipeline_run(tasks, graph, rExec, false, treePos);
+    }
+    else if (rExec.plData[pipeline].stage == lgrn::id_null<StageId>())
+    {
+        // No parent and no children
+        pipeline_run_single(graph, rExec, false, pipeline, tasks.m_pipelineControl[pipeline].isLoopScope);
+    }
 }
 
-static int pipeline_run(Tasks const& tasks, TaskGraph const& graph, ExecContext &rExec, bool const rerunLoop, PipelineId const pipeline, PipelineTreePos_t const treePos, uint32_t const descendents, bool const isLoopScope, bool const insideLoopScope)
+/**
+ * @brief Run a pipeline and all of its descendants
+ *
+ * Walks the subtree in tree order, skipping subtrees of pipelines that are already on a stage.
+ * Every pipeline visited counts towards the loopChildrenLeft of its outer loop scope, as long as
+ * that loop scope is part of this subtree.
+ */
+static void pipeline_run(Tasks const& tasks, TaskGraph const& graph, ExecContext &rExec, bool const rerunLoop, PipelineTreePos_t const root)
 {
-    auto const stageCount = fanout_size(graph.pipelineToFirstAnystg, pipeline);
-    ExecPipeline &rExecPl = rExec.plData[pipeline];
+    PipelineTreePos_t const lastPos = root + 1 + graph.pltreeDescendantCounts[root];
+    PipelineTreePos_t       pos     = root;
 
-    if (rExecPl.stage != lgrn::id_null<StageId>())
+    while (pos != lastPos)
     {
-        return 0;
-    }
+        PipelineId const        pipeline    = graph.pltreeToPipeline[pos];
+        PipelineTreePos_t const outerScope  = graph.pltreeOuterLoopScope[pos];
+        ExecPipeline            &rExecPl    = rExec.plData[pipeline];
 
-    if (stageCount != 0)
-    {
-        if ( ! rExecPl.running )
+        if (pos != root && outerScope != lgrn::id_null<PipelineTreePos_t>() && outerScope >= root)
         {
-            rExecPl.running  = true;
-            rExecPl.loop     = isLoopScope || insideLoopScope;
-
-            ++ rExec.pipelinesRunning;
-
-            rExec.plAdvance.insert(pipeline);
-            exec_log(rExec, ExecContext::PipelineRun{pipeline});
+            ++ rExec.plData[graph.pltreeToPipeline[outerScope]].loopChildrenLeft;
         }
 
-        if (rerunLoop)
+        if (rExecPl.stage != lgrn::id_null<StageId>())
         {
-            rExecPl.canceled = false;
+            pos += 1 + graph.pltreeDescendantCounts[pos];
+            continue; // Already running, leave it and its descendants alone
+        }
 
-            rExec.plAdvanceNext.insert(pipeline);
-            exec_log(rExec, ExecContext::PipelineLoop{pipeline});
+        if (tasks.m_pipelineControl[pipeline].isLoopScope)
+        {
+            LGRN_ASSERT(rExecPl.loopChildrenLeft == 0);
         }
 
-        rExec.hasPlAdvanceOrLoop = true;
+        // Loop scopes include themselves, see TaskGraph::pipelineToLoopScope
+        PipelineTreePos_t const scope = graph.pipelineToLoopScope[pipeline];
+
+        pipeline_run_single(graph, rExec, rerunLoop, pipeline, scope != lgrn::id_null<PipelineTreePos_t>() && scope >= root);
+
+        ++ pos;
     }
+}
 
-    if (descendents == 0)
+static void pipeline_run_single(TaskGraph const& graph, ExecContext &rExec, bool const rerunLoop, PipelineId const pipeline, bool const loop)
+{
+    if (fanout_size(graph.pipelineToFirstAnystg, pipeline) == 0)
     {
-        return 0;
+        return;
     }
 
-    PipelineTreePos_t const childPosLast = treePos + 1 + descendents;
-    PipelineTreePos_t       childPos     = treePos + 1;
-
-    int scopeChildCount = 0;
+    ExecPipeline &rExecPl = rExec.plData[pipeline];
 
-    while (childPos != childPosLast)
+    if ( ! rExecPl.running )
     {
-        uint32_t const      childDescendents    = graph.pltreeDescendantCounts[childPos];
-        PipelineId const    childPl             = graph.pltreeToPipeline[childPos];
-        bool const          childIsLoopScope    = tasks.m_pipelineControl[childPl].isLoopScope;
-
-        int const childChildCount = pipeline_run(tasks, graph, rExec, rerunLoop, childPl, childPos, childDescendents, childIsLoopScope, isLoopScope || insideLoopScope);
+        rExecPl.running  = true;
+        rExecPl.loop     = loop;
 
-        scopeChildCount += childChildCount + 1; // + 1 for child itself
+        ++ rExec.pipelinesRunning;
 
-        childPos += 1 + childDescendents;
+        rExec.plAdvance.insert(pipeline);
+        exec_log(rExec, ExecContext::PipelineRun{pipeline});
     }
 
-    if (isLoopScope)
+    if (rerunLoop)
     {
-        LGRN_ASSERT(rExecPl.loopChildrenLeft == 0);
-        rExecPl.loopChildrenLeft = scopeChildCount;
+        rExecPl.canceled = false;
 
-        return 0;
-    }
-    else
-    {
-        return scopeChildCount;
+        rExec.plAdvanceNext.insert(pipeline);
+        exec_log(rExec, ExecContext::PipelineLoop{pipeline});
     }
+
+    rExec.hasPlAdvanceOrLoop = true;
 }
 
 
@@ -307,8 +348,7 @@ static void loop_scope_done(Tasks const& tasks, TaskGraph const& graph, ExecCont
     {
         // Loop more
 
-        uint32_t const descendents = graph.pltreeDescendantCounts[treePos];
-        pipeline_run(tasks, graph, rExec, true, pipeline, treePos, descendents, true,  /* dont-care */ false);
+        pipeline_run(tasks, graph, rExec, true, treePos);
     }
     else
     {
@@ -341,16 +381,10 @@ static void loop_scope_done(Tasks const& tasks, TaskGraph const& graph, ExecCont
 
         // If this is a nested loop, decrement parent loop scope's loopChildrenLeft
 
-        PipelineId const parentPl = tasks.m_pipelineParents[pipeline];
-        if (parentPl == lgrn::id_null<PipelineId>())
-        {
-            return; // Loop is in the root
-        }
-
-        PipelineTreePos_t const parentScopeTreePos = graph.pipelineToLoopScope[parentPl];
+        PipelineTreePos_t const parentScopeTreePos = graph.pltreeOuterLoopScope[treePos];
         if (parentScopeTreePos == lgrn::id_null<PipelineTreePos_t>())
         {
-            return; // Parent does not loop
+            return; // Loop is not nested in another
         }
 
         PipelineId const parentScopePl = graph.pltreeToPipeline[parentScopeTreePos];
@@ -465,8 +499,8 @@ static void pipeline_advance_reqs(Tasks const& tasks, TaskGraph const& graph, Ex
                 ExecPipeline &rTaskPlExec = rExec.plData[rBlocked.pipeline];
                 -- rTaskPlExec.tasksQueuedBlocked;
                 ++ rTaskPlExec.tasksQueuedRun;
-                rExec.tasksQueuedRun.push(task);
                 rExec.tasksQueuedBlocked.erase(task);
+                task_enqueue_run(tasks, graph, rExec, task);
             }
         }
         else
@@ -517,7 +551,8 @@ static void pipeline_advance_reqs(Tasks const& tasks, TaskGraph const& graph, Ex
                 return false; // Required tasks not queued yet
             }
             else if (   rExec.tasksQueuedBlocked.contains(stgreqtask.reqTask)
-                     || rExec.tasksQueuedRun    .contains(stgreqtask.reqTask))
+                     || rExec.tasksQueuedRun    .contains(stgreqtask.reqTask)
+                     || is_task_queued_sema(rExec, stgreqtask.reqTask))
             {
                 return false; // Required task is queued and not yet finished running
             }
@@ -557,6 +592,7 @@ static void pipeline_advance_run(Tasks const& tasks, TaskGraph const& graph, Exe
         {
             LGRN_ASSERTM( ! rExec.tasksQueuedBlocked.contains(task), "Impossible to queue a task that's already queued");
             LGRN_ASSERTM( ! rExec.tasksQueuedRun    .contains(task), "Impossible to queue a task that's already queued");
+            LGRN_ASSERTM( ! is_task_queued_sema(rExec, task),        "Impossible to queue a task that's already queued");
 
             // Evaluate Task-requires-Stages
             // Some requirements may already be satisfied
@@ -584,12 +620,12 @@ static void pipeline_advance_run(Tasks const& tasks, TaskGraph const& graph, Exe
             }
             else
             {
-                rExec.tasksQueuedRun.push(task);
                 ++ rExecPl.tasksQueuedRun;
+                task_enqueue_run(tasks, graph, rExec, task);
             }
 
             exec_log(rExec, ExecContext::EnqueueTask{pipeline, rExecPl.stage, task, blocked});
-            if (rExec.doLogging)
+            if (OSP_EXEC_LOG && rExec.doLogging)
             {
                 for (TaskRequiresStage const& req : taskreqstageView)
                 {
@@ -764,6 +800,86 @@ static void pipeline_cancel(Tasks const& tasks, TaskGraph const& graph, ExecCont
     });
 }
 
+//-----------------------------------------------------------------------------
+
+// Semaphores
+
+static void task_enqueue_run(Tasks const& tasks, TaskGraph const& graph, ExecContext &rExec, TaskId const task) noexcept
+{
+    if (task_try_acquire(tasks, graph, rExec, task))
+    {
+        rExec.tasksQueuedRun.push(task);
+    }
+    else
+    {
+        // Task's ExecPipeline::tasksQueuedRun is still incremented, as it is ready to run
+        rExec.tasksQueuedSema.push_back(task);
+        exec_log(rExec, ExecContext::SemaphoreWait{task});
+    }
+}
+
+static bool task_try_acquire(Tasks const& tasks, TaskGraph const& graph, ExecContext &rExec, TaskId const task) noexcept
+{
+    auto const semas = ArrayView<SemaphoreId const>{fanout_view(graph.taskToFirstSemaacq, graph.semaacqToSema, task)};
+
+    for (SemaphoreId const sema : semas)
+    {
+        if (rExec.semaAcquired[sema] >= tasks.m_semaLimits[sema])
+        {
+            return false;
+        }
+    }
+
+    for (SemaphoreId const sema : semas)
+    {
+        ++ rExec.semaAcquired[sema];
+    }
+
+    return true;
+}
+
+static void task_release(Tasks const& tasks, TaskGraph const& graph, ExecContext &rExec, TaskId const task) noexcept
+{
+    auto const semas = ArrayView<SemaphoreId const>{fanout_view(graph.taskToFirstSemaacq, graph.semaacqToSema, task)};
+
+    if (semas.isEmpty())
+    {
+        return;
+    }
+
+    for (SemaphoreId const sema : semas)
+    {
+        LGRN_ASSERT(rExec.semaAcquired[sema] != 0);
+        -- rExec.semaAcquired[sema];
+    }
+
+    // Give released semaphores to waiting tasks, first come first serve. Tasks that still can't
+    // acquire are moved down over the ones that did, keeping their order.
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < rExec.tasksQueuedSema.size(); ++i)
+    {
+        TaskId const waiting = rExec.tasksQueuedSema[i];
+        if (task_try_acquire(tasks, graph, rExec, waiting))
+        {
+            rExec.tasksQueuedRun.push(waiting);
+            exec_log(rExec, ExecContext::SemaphoreAcquire{waiting});
+        }
+        else
+        {
+            rExec.tasksQueuedSema[kept] = waiting;
+            ++ kept;
+        }
+    }
+    rExec.tasksQueuedSema.resize(kept);
+}
+
+static bool is_task_queued_sema(ExecContext const& exec, TaskId const task) noexcept
+{
+    return std::find(exec.tasksQueuedSema.begin(), exec.tasksQueuedSema.end(), task) != exec.tasksQueuedSema.end();
+}
+
+//-----------------------------------------------------------------------------
+
 static void pipeline_try_advance(ExecContext &rExec, ExecPipeline &rExecPl, PipelineId const pipeline) noexcept
 {
     if (pipeline_can_advance(rExecPl))
@@ -899,19 +1015,28 @@ void exec_conform(Tasks const& tasks, ExecContext &rOut)
     rOut.plAdvance.resize(maxPipeline);
     rOut.plAdvanceNext.resize(maxPipeline);
     rOut.plRequestRun.resize(maxPipeline);
+    rOut.tasksQueuedSema.reserve(maxTasks);
+    rOut.semaAcquired.resize(tasks.m_semaIds.capacity(), 0);
 
     for (PipelineId const pipeline : tasks.m_pipelineIds)
     {
         rOut.plData[pipeline].waitStage = tasks.m_pipelineControl[pipeline].waitStage;
+        rOut.plData[pipeline].runEvery  = tasks.m_pipelineControl[pipeline].runEvery;
     }
 }
 
-static void exec_log(ExecContext &rExec, ExecContext::LogMsg_t msg) noexcept
+static inline void exec_log([[maybe_unused]] ExecContext &rExec, [[maybe_unused]] ExecContext::LogMsg_t msg) noexcept
 {
+#if OSP_EXEC_LOG
     if (rExec.doLogging)
     {
+        if (rExec.logMsg.capacity() == 0)
+        {
+            rExec.logMsg.set_capacity(ExecContext::smc_defaultLogCapacity);
+        }
         rExec.logMsg.push_back(msg);
     }
+#endif
 }
 
 template <typename FUNC_T>
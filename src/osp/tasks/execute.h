@@ -27,6 +27,9 @@
 #include "tasks.h"
 #include "worker.h"
 
+#include "../core/id_bitset.h"
+#include "../core/ring_buffer.h"
+
 #include <longeron/id_management/id_set_stl.hpp>
 
 
@@ -36,6 +39,13 @@
 #include <variant>
 #include <vector>
 
+/**
+ * Set to 0 to compile out all ExecLog messages. ExecLog::logMsg will always be empty.
+ */
+#ifndef OSP_EXEC_LOG
+    #define OSP_EXEC_LOG 1
+#endif
+
 namespace osp
 {
 
@@ -75,6 +85,12 @@ struct ExecPipeline
     StageId         waitStage               { lgrn::id_null<StageId>() };
     bool            waitSignaled            { false };
 
+    /// Copied from PipelineControl::runEvery by exec_conform, see exec_set_run_every
+    std::uint32_t   runEvery                { 1 };
+
+    /// Runs allowed by the scheduler that are still to be skipped before the next one goes through
+    std::uint32_t   runsToSkip              { 0 };
+
     bool            tasksQueueDone          { false };
     bool            loop                    { false };
     bool            running                 { false };
@@ -96,6 +112,10 @@ struct LoopRequestRun
 
 /**
  * @brief Fast plain-old-data log for ExecContext state changes
+ *
+ * Messages are kept in a fixed-size ring buffer; the oldest messages are dropped if logMsg isn't
+ * cleared often enough. Only the coordinator thread modifies ExecContext, so there is no need for
+ * locks or per-thread buffers.
  */
 struct ExecLog
 {
@@ -161,6 +181,16 @@ struct ExecLog
         TaskId      task;
     };
 
+    struct SemaphoreWait
+    {
+        TaskId      task;
+    };
+
+    struct SemaphoreAcquire
+    {
+        TaskId      task;
+    };
+
     struct ExternalRunRequest
     {
         PipelineId  pipeline;
@@ -186,13 +216,34 @@ struct ExecLog
             EnqueueTaskReq,
             UnblockTask,
             CompleteTask,
+            SemaphoreWait,
+            SemaphoreAcquire,
             ExternalRunRequest,
             ExternalSignal>;
 
-    std::vector<LogMsg_t>           logMsg;
+    static constexpr std::size_t    smc_defaultLogCapacity = 4096;
+
+    /// Empty until the first message is logged, then given smc_defaultLogCapacity unless
+    /// set_capacity was called before. Contexts with doLogging off never allocate it.
+    RingBuffer<LogMsg_t>            logMsg;
     bool                            doLogging{true};
 }; // struct ExecLog
 
+struct ExecStats
+{
+    /// Number of exec_update calls
+    uint32_t updates            {0};
+
+    /// Total number of times exec_update looped to advance pipelines. Ideally close to updates.
+    uint32_t cycles             {0};
+
+    /// Most cycles needed by a single exec_update call
+    uint32_t maxCyclesPerUpdate {0};
+
+    /// Number of times pipelines were advanced, summed over all cycles
+    uint32_t pipelinesAdvanced  {0};
+};
+
 /**
  * @brief State for executing Tasks and TaskGraph
  */
@@ -203,24 +254,28 @@ struct ExecContext : public ExecLog
     entt::basic_sparse_set<TaskId>              tasksQueuedRun;
     entt::basic_storage<BlockedTask, TaskId>    tasksQueuedBlocked;
 
-    lgrn::IdSetStl<PipelineId>          plAdvance;
-    lgrn::IdSetStl<PipelineId>          plAdvanceNext;
+    /// Tasks ready to run, but waiting for Semaphores to be released. In order of arrival.
+    std::vector<TaskId>                         tasksQueuedSema;
+
+    /// Number of running tasks holding each Semaphore, limited by Tasks::m_semaLimits
+    KeyedVec<SemaphoreId, unsigned int>         semaAcquired;
+
+    IdBitSet<PipelineId>                plAdvance;
+    IdBitSet<PipelineId>                plAdvanceNext;
     bool                                hasPlAdvanceOrLoop  {false};
 
-    lgrn::IdSetStl<PipelineId>          plRequestRun;
+    IdBitSet<PipelineId>                plRequestRun;
     std::vector<LoopRequestRun>         requestLoop;
     bool                                hasRequestRun {false};
 
     int                                 pipelinesRunning {0};
 
-    // TODO: Consider multithreading. something something work stealing...
-    //  * Allow multiple threads to search for and execute tasks. Atomic access
-    //    for ExecContext? Might be messy to implement.
-    //  * Only allow one thread to search for tasks, assign tasks to other
-    //    threads if they're available before running own task. Another thread
-    //    can take over once it completes its task. May be faster as only one
-    //    thread is modifying ExecContext, and easier to implement.
-    //  * Plug into an existing work queue library?
+    /// Counters to measure how much work exec_update does. Reset to {} at the start of a frame.
+    ExecStats                           stats;
+
+    // Multithreading: Only one thread (the coordinator) is allowed to modify ExecContext.
+    // Queued tasks can be handed off to other threads, which must report back to the coordinator
+    // so it can call complete_task. See top_run_parallel and TopWorkerPool.
 
 }; // struct ExecContext
 
@@ -234,6 +289,18 @@ inline void exec_request_run(ExecContext &rExec, PipelineId pipeline) noexcept
 
 void exec_signal(ExecContext &rExec, PipelineId pipeline) noexcept;
 
+/**
+ * @brief Change how often a pipeline runs, overriding PipelineControl::runEvery
+ *
+ * Intended to adapt update rates while running, such as slowing down low-priority pipelines
+ * when frames take too long. Takes effect the next time the pipeline's scheduler task completes.
+ * 0 is treated as 1. exec_conform resets this back to PipelineControl::runEvery.
+ */
+inline void exec_set_run_every(ExecContext &rExec, PipelineId pipeline, std::uint32_t runEvery) noexcept
+{
+    rExec.plData[pipeline].runEvery = runEvery;
+}
+
 void exec_update(Tasks const& tasks, TaskGraph const& graph, ExecContext &rExec) noexcept;
 
 void complete_task(Tasks const& tasks, TaskGraph const& graph, ExecContext &rExec, TaskId task, TaskActions actions) noexcept;
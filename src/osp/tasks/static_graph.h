@@ -0,0 +1,415 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "tasks.h"
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * @file
+ * @brief Pipelines, tasks and sync edges of a fixed Session written as constexpr data
+ *
+ * Sessions that always create the same tasks can describe them with a StaticTaskGraph instead of
+ * a sequence of builder calls. The description is checked at compile time with
+ * check_static_graph, and instantiate_static_graph adds it to Tasks and TaskEdges in a single
+ * pass with one allocation per container.
+ *
+ * Stage counts and schedule stages come from OSP_DECLARE_STAGE_NAMES and
+ * OSP_DECLARE_STAGE_SCHEDULE of each pipeline's stage enum:
+ *
+ * @code{.cpp}
+ * constexpr StaticPl<EStgCont> plVec{0};
+ *
+ * constexpr StaticTaskGraph<1, 0, 2, 1> sc_graph
+ * {
+ *     .pipelines  = {{ static_pipeline<EStgCont>("vec") }},
+ *     .tasks      = {{ {.runOn = plVec(Modify)}, {.runOn = plVec(Ready)} }},
+ *     .syncWith   = {{ {.task = 1, .with = plVec(Clear)} }}
+ * };
+ * static_assert(check_static_graph(sc_graph).error == EStaticGraphError::None);
+ * @endcode
+ */
+
+namespace osp
+{
+
+/// Null pipeline index within a StaticTaskGraph
+constexpr std::uint32_t gc_staticNone = 0xFFFFFFFFu;
+
+/**
+ * @brief Pipeline stage within a StaticTaskGraph, the pipeline being an index into its pipelines
+ */
+struct StaticPlStage
+{
+    std::uint32_t   pipeline    { gc_staticNone };
+    StageId         stage       { lgrn::id_null<StageId>() };
+};
+
+/**
+ * @brief Typed pipeline index for writing StaticPlStages like PipelineDef::operator()
+ */
+template <typename ENUM_T>
+struct StaticPl
+{
+    constexpr StaticPlStage operator()(ENUM_T const stage) const noexcept { return { index, StageId(stage) }; }
+
+    std::uint32_t index;
+};
+
+struct StaticPipelineDesc
+{
+    std::string_view                name;
+
+    /// Returns PipelineInfo::stageType; the entt family value isn't known at compile time
+    PipelineInfo::stage_type_t      (*stageType)() noexcept     { nullptr };
+
+    std::size_t                     stageCount                  { 0 };
+    StageId                         scheduleStage               { lgrn::id_null<StageId>() };
+
+    /// Index of the parent pipeline, or null for none
+    std::uint32_t                   parent                      { gc_staticNone };
+
+    /// Sync the parent's scheduler task with this pipeline's schedule stage, as in
+    /// PipelineRefBase::parent_with_schedule
+    bool                            parentWithSchedule          { false };
+    bool                            loops                       { false };
+    StageId                         waitStage                   { lgrn::id_null<StageId>() };
+
+    /// See PipelineControl::runEvery. Needs a scheduler task if not 1.
+    std::uint32_t                   runEvery                    { 1 };
+};
+
+struct StaticTaskDesc
+{
+    StaticPlStage   runOn;
+
+    /// Task is the scheduler of its runOn pipeline, as in TaskRefBase::schedules
+    bool            schedules   { false };
+};
+
+struct StaticSyncEdge
+{
+    std::uint32_t   task;
+    StaticPlStage   with;
+};
+
+template <typename ENUM_T>
+PipelineInfo::stage_type_t static_stage_type() noexcept
+{
+    return PipelineInfo::stage_type_family_t::value<ENUM_T>;
+}
+
+/**
+ * @brief Make a StaticPipelineDesc using the stage names and schedule declared for ENUM_T
+ */
+template <typename ENUM_T>
+constexpr StaticPipelineDesc static_pipeline(std::string_view const name) noexcept
+{
+    constexpr auto schedule = stage_schedule(ENUM_T{0});
+
+    return {
+        .name           = name,
+        .stageType      = &static_stage_type<ENUM_T>,
+        .stageCount     = stage_count(ENUM_T{0}),
+        .scheduleStage  = (schedule == lgrn::id_null<ENUM_T>()) ? lgrn::id_null<StageId>() : StageId(schedule)
+    };
+}
+
+/**
+ * @brief Fixed set of pipelines, tasks and sync edges
+ *
+ * The last EXTERN_N pipelines are owned by other Sessions, such as ones passed to a setup
+ * function. Only their stage types are described here; their IDs are given when instantiated.
+ */
+template <std::size_t PIPELINE_N, std::size_t EXTERN_N, std::size_t TASK_N, std::size_t EDGE_N>
+struct StaticTaskGraph
+{
+    static constexpr std::size_t smc_pipelines  = PIPELINE_N;
+    static constexpr std::size_t smc_externs    = EXTERN_N;
+    static constexpr std::size_t smc_tasks      = TASK_N;
+    static constexpr std::size_t smc_edges      = EDGE_N;
+
+    std::array<StaticPipelineDesc, PIPELINE_N + EXTERN_N>   pipelines;
+    std::array<StaticTaskDesc, TASK_N>                      tasks;
+    std::array<StaticSyncEdge, EDGE_N>                      syncWith;
+};
+
+enum class EStaticGraphError : std::uint8_t
+{
+    None,
+    BadPipeline,        ///< Pipeline index out of range
+    BadStage,           ///< Stage out of range for its pipeline
+    BadTask,            ///< Sync edge refers to a task out of range
+    ParentCycle,        ///< Pipeline is its own ancestor
+    ExternModified,     ///< Extern pipeline has a parent, loop, wait stage or runEvery set
+    SchedulerStage,     ///< Scheduler task isn't on its pipeline's schedule stage
+    MultipleSchedulers, ///< More than one task schedules a pipeline
+    NoParentScheduler,  ///< parentWithSchedule with a local parent that has no scheduler task
+    NoScheduler         ///< runEvery set on a pipeline that has no scheduler task
+};
+
+struct StaticGraphCheck
+{
+    EStaticGraphError   error   { EStaticGraphError::None };
+
+    /// Index of the offending pipeline, task or edge
+    std::uint32_t       index   { 0 };
+};
+
+/**
+ * @brief Validate a StaticTaskGraph, meant to be used in a static_assert
+ */
+template <std::size_t PIPELINE_N, std::size_t EXTERN_N, std::size_t TASK_N, std::size_t EDGE_N>
+constexpr StaticGraphCheck check_static_graph(StaticTaskGraph<PIPELINE_N, EXTERN_N, TASK_N, EDGE_N> const& graph) noexcept
+{
+    constexpr std::uint32_t plCount = PIPELINE_N + EXTERN_N;
+
+    auto const bad_stage = [&graph] (StaticPlStage const plStg) -> EStaticGraphError
+    {
+        if (plStg.pipeline >= plCount)
+        {
+            return EStaticGraphError::BadPipeline;
+        }
+        if (std::size_t(plStg.stage) >= graph.pipelines[plStg.pipeline].stageCount)
+        {
+            return EStaticGraphError::BadStage;
+        }
+        return EStaticGraphError::None;
+    };
+
+    for (std::uint32_t i = 0; i < plCount; ++i)
+    {
+        StaticPipelineDesc const& pl = graph.pipelines[i];
+
+        if (i >= PIPELINE_N)
+        {
+            if (   pl.parent != gc_staticNone || pl.parentWithSchedule || pl.loops
+                || pl.waitStage != lgrn::id_null<StageId>() || pl.runEvery != 1 )
+            {
+                return { EStaticGraphError::ExternModified, i };
+            }
+            continue;
+        }
+
+        if (   pl.waitStage != lgrn::id_null<StageId>()
+            && std::size_t(pl.waitStage) >= pl.stageCount )
+        {
+            return { EStaticGraphError::BadStage, i };
+        }
+
+        if (pl.parent == gc_staticNone)
+        {
+            if (pl.parentWithSchedule)
+            {
+                return { EStaticGraphError::BadPipeline, i };
+            }
+            continue;
+        }
+
+        // Walking up more than plCount parents means there's a loop
+        std::uint32_t ancestor = pl.parent;
+        for (std::uint32_t depth = 0; ancestor != gc_staticNone; ++depth)
+        {
+            if (ancestor >= plCount)
+            {
+                return { EStaticGraphError::BadPipeline, i };
+            }
+            if (ancestor == i || depth == plCount)
+            {
+                return { EStaticGraphError::ParentCycle, i };
+            }
+            ancestor = graph.pipelines[ancestor].parent;
+        }
+
+        if (pl.parentWithSchedule && pl.scheduleStage == lgrn::id_null<StageId>())
+        {
+            return { EStaticGraphError::BadStage, i };
+        }
+    }
+
+    std::array<std::uint32_t, plCount> schedulers{};
+
+    for (std::uint32_t i = 0; i < TASK_N; ++i)
+    {
+        StaticTaskDesc const& task = graph.tasks[i];
+
+        if (EStaticGraphError const error = bad_stage(task.runOn); error != EStaticGraphError::None)
+        {
+            return { error, i };
+        }
+
+        if (task.schedules)
+        {
+            StaticPipelineDesc const& pl = graph.pipelines[task.runOn.pipeline];
+            if (pl.scheduleStage != lgrn::id_null<StageId>() && pl.scheduleStage != task.runOn.stage)
+            {
+                return { EStaticGraphError::SchedulerStage, i };
+            }
+            if (++schedulers[task.runOn.pipeline] > 1)
+            {
+                return { EStaticGraphError::MultipleSchedulers, i };
+            }
+        }
+    }
+
+    for (std::uint32_t i = 0; i < PIPELINE_N; ++i)
+    {
+        StaticPipelineDesc const& pl = graph.pipelines[i];
+
+        // Extern parents are checked for schedulers when instantiated
+        if (pl.parentWithSchedule && pl.parent < PIPELINE_N && schedulers[pl.parent] == 0)
+        {
+            return { EStaticGraphError::NoParentScheduler, i };
+        }
+
+        if (pl.runEvery != 1 && schedulers[i] == 0)
+        {
+            return { EStaticGraphError::NoScheduler, i };
+        }
+    }
+
+    for (std::uint32_t i = 0; i < EDGE_N; ++i)
+    {
+        StaticSyncEdge const& edge = graph.syncWith[i];
+
+        if (edge.task >= TASK_N)
+        {
+            return { EStaticGraphError::BadTask, i };
+        }
+        if (EStaticGraphError const error = bad_stage(edge.with); error != EStaticGraphError::None)
+        {
+            return { error, i };
+        }
+    }
+
+    return {};
+}
+
+template <std::size_t PIPELINE_N, std::size_t TASK_N>
+struct StaticGraphIds
+{
+    std::array<PipelineId, PIPELINE_N>  pipelines;
+    std::array<TaskId, TASK_N>          tasks;
+};
+
+/**
+ * @brief Add pipelines, tasks and sync edges of a StaticTaskGraph
+ *
+ * Graphs are expected to have passed check_static_graph. Task functions and data are not part
+ * of the description, set them afterwards through a builder's task(TaskId).
+ *
+ * @param externs   [in] IDs of the graph's extern pipelines, in order
+ *
+ * @return IDs of the created pipelines and tasks, in the graph's order
+ */
+template <std::size_t PIPELINE_N, std::size_t EXTERN_N, std::size_t TASK_N, std::size_t EDGE_N>
+StaticGraphIds<PIPELINE_N, TASK_N> instantiate_static_graph(
+        StaticTaskGraph<PIPELINE_N, EXTERN_N, TASK_N, EDGE_N> const&    graph,
+        Tasks&                                                          rTasks,
+        TaskEdges&                                                      rEdges,
+        std::array<PipelineId, EXTERN_N> const&                         externs = {})
+{
+    StaticGraphIds<PIPELINE_N, TASK_N> out;
+
+    rTasks.m_pipelineIds.create(out.pipelines.begin(), out.pipelines.end());
+    rTasks.m_taskIds    .create(out.tasks.begin(),     out.tasks.end());
+
+    std::size_t const plCapacity = rTasks.m_pipelineIds.capacity();
+    rTasks.m_pipelineInfo   .resize(plCapacity);
+    rTasks.m_pipelineControl.resize(plCapacity);
+    rTasks.m_pipelineParents.resize(plCapacity, lgrn::id_null<PipelineId>());
+    rTasks.m_taskRunOn      .resize(rTasks.m_taskIds.capacity());
+
+    auto const pipeline_id = [&out, &externs] (std::uint32_t const index) noexcept -> PipelineId
+    {
+        if (index == gc_staticNone)
+        {
+            return lgrn::id_null<PipelineId>();
+        }
+        return (index < PIPELINE_N) ? out.pipelines[index] : externs[index - PIPELINE_N];
+    };
+
+    for (std::uint32_t i = 0; i < PIPELINE_N; ++i)
+    {
+        StaticPipelineDesc const&   desc    = graph.pipelines[i];
+        PipelineId const            pl      = out.pipelines[i];
+
+        rTasks.m_pipelineInfo[pl].name          = desc.name;
+        rTasks.m_pipelineInfo[pl].stageType     = desc.stageType();
+        rTasks.m_pipelineParents[pl]            = pipeline_id(desc.parent);
+        rTasks.m_pipelineControl[pl].waitStage  = desc.waitStage;
+        rTasks.m_pipelineControl[pl].isLoopScope= desc.loops;
+        rTasks.m_pipelineControl[pl].runEvery   = desc.runEvery;
+    }
+
+    for (std::uint32_t i = 0; i < TASK_N; ++i)
+    {
+        StaticTaskDesc const&   desc    = graph.tasks[i];
+        TaskId const            task    = out.tasks[i];
+        PipelineId const        pl      = pipeline_id(desc.runOn.pipeline);
+
+        rTasks.m_taskRunOn[task] = { pl, desc.runOn.stage };
+        if (desc.schedules)
+        {
+            rTasks.m_pipelineControl[pl].scheduler = task;
+        }
+    }
+
+    rEdges.m_syncWith.reserve(rEdges.m_syncWith.size() + EDGE_N + PIPELINE_N);
+
+    for (StaticSyncEdge const& edge : graph.syncWith)
+    {
+        rEdges.m_syncWith.push_back({
+            .task     = out.tasks[edge.task],
+            .pipeline = pipeline_id(edge.with.pipeline),
+            .stage    = edge.with.stage
+        });
+    }
+
+    for (std::uint32_t i = 0; i < PIPELINE_N; ++i)
+    {
+        StaticPipelineDesc const& desc = graph.pipelines[i];
+        if ( ! desc.parentWithSchedule )
+        {
+            continue;
+        }
+
+        TaskId const scheduler = rTasks.m_pipelineControl[pipeline_id(desc.parent)].scheduler;
+        LGRN_ASSERTM(scheduler != lgrn::id_null<TaskId>(), "Parent Pipeline has no scheduler task");
+
+        rEdges.m_syncWith.push_back({
+            .task     = scheduler,
+            .pipeline = out.pipelines[i],
+            .stage    = desc.scheduleStage
+        });
+    }
+
+    return out;
+}
+
+} // namespace osp
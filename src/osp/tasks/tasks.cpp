@@ -35,6 +35,7 @@ struct TaskCounts
 {
     uint16_t requiresStages     {0};
     uint16_t requiredByStages   {0};
+    uint16_t acquiresSemas      {0};
 };
 
 struct StageCounts
@@ -58,23 +59,32 @@ struct PipelineCounts
 TaskGraph make_exec_graph(Tasks const& tasks, ArrayView<TaskEdges const* const> const data)
 {
     TaskGraph out;
+    rebuild_exec_graph(tasks, data, out);
+    return out;
+}
+
+void rebuild_exec_graph(Tasks const& tasks, ArrayView<TaskEdges const* const> const data, TaskGraph& out)
+{
 
     std::size_t const maxPipelines  = tasks.m_pipelineIds.capacity();
     std::size_t const maxTasks      = tasks.m_taskIds.capacity();
+    std::size_t const maxSemas      = tasks.m_semaIds.capacity();
 
     KeyedVec<PipelineId, PipelineCounts>    plCounts;
     KeyedVec<TaskId, TaskCounts>            taskCounts;
+    KeyedVec<SemaphoreId, uint16_t>         semaAcqCounts;
     lgrn::IdSetStl<PipelineId>              plInTree;
 
-    out.pipelineToFirstAnystg .resize(maxPipelines);
     plInTree.resize(maxPipelines);
     plCounts        .resize(maxPipelines+1);
     taskCounts      .resize(maxTasks+1);
+    semaAcqCounts   .resize(maxSemas+1, 0);
 
     std::size_t totalTasksReqStage  = 0;
     std::size_t totalStageReqTasks  = 0;
     std::size_t totalRunTasks       = 0;
     std::size_t totalStages         = 0;
+    std::size_t totalSemaAcq        = 0;
 
     // 1. Count total number of stages
 
@@ -136,6 +146,15 @@ TaskGraph make_exec_graph(Tasks const& tasks, ArrayView<TaskEdges const* const>
         }
         totalTasksReqStage += pEdges->m_syncWith.size();
         totalStageReqTasks += pEdges->m_syncWith.size();
+
+        for (auto const [task, sema] : pEdges->m_semaphoreEdges)
+        {
+            LGRN_ASSERTMV(tasks.m_semaIds.exists(sema) && tasks.m_semaLimits[sema] != 0,
+                          "Semaphores must exist and have a non-zero limit", TaskInt(task), SemaphoreInt(sema));
+            ++ taskCounts[task].acquiresSemas;
+            ++ semaAcqCounts[sema];
+        }
+        totalSemaAcq += pEdges->m_semaphoreEdges.size();
     }
 
     // 3. Map out children and siblings in tree
@@ -165,25 +184,33 @@ TaskGraph make_exec_graph(Tasks const& tasks, ArrayView<TaskEdges const* const>
 
     // 4. Allocate
 
+    // assign(...) instead of resize(...) to reset all values while reusing allocations from any
+    // previous graph in out.
+
     // The +1 is needed for 1-to-many connections to store the total number of other elements they
     // index. This also simplifies logic in fanout_view(...)
 
-    out.pipelineToFirstAnystg       .resize(maxPipelines+1,     lgrn::id_null<AnyStageId>());
-    out.anystgToPipeline            .resize(totalStages+1,      lgrn::id_null<PipelineId>());
-    out.anystgToFirstRuntask        .resize(totalStages+1,      lgrn::id_null<RunTaskId>());
-    out.runtaskToTask               .resize(totalRunTasks,      lgrn::id_null<TaskId>());
-    out.anystgToFirstStgreqtask     .resize(totalStages+1,      lgrn::id_null<StageReqTaskId>());
-    out.stgreqtaskData              .resize(totalStageReqTasks, {});
-    out.taskToFirstRevStgreqtask    .resize(maxTasks+1,         lgrn::id_null<ReverseStageReqTaskId>());
-    out.revStgreqtaskToStage        .resize(totalStageReqTasks, lgrn::id_null<AnyStageId>());
-    out.taskToFirstTaskreqstg       .resize(maxTasks+1,         lgrn::id_null<TaskReqStageId>());
-    out.taskreqstgData              .resize(totalTasksReqStage, {});
-    out.anystgToFirstRevTaskreqstg  .resize(totalStages+1,      lgrn::id_null<ReverseTaskReqStageId>());
-    out.revTaskreqstgToTask         .resize(totalTasksReqStage, lgrn::id_null<TaskId>());
-    out.pltreeDescendantCounts      .resize(treeSize,           0);
-    out.pltreeToPipeline            .resize(treeSize,           lgrn::id_null<PipelineId>());
-    out.pipelineToPltree            .resize(maxPipelines,       lgrn::id_null<PipelineTreePos_t>());
-    out.pipelineToLoopScope         .resize(maxPipelines,       lgrn::id_null<PipelineTreePos_t>());
+    out.pipelineToFirstAnystg       .assign(maxPipelines+1,     lgrn::id_null<AnyStageId>());
+    out.anystgToPipeline            .assign(totalStages+1,      lgrn::id_null<PipelineId>());
+    out.anystgToFirstRuntask        .assign(totalStages+1,      lgrn::id_null<RunTaskId>());
+    out.runtaskToTask               .assign(totalRunTasks,      lgrn::id_null<TaskId>());
+    out.anystgToFirstStgreqtask     .assign(totalStages+1,      lgrn::id_null<StageReqTaskId>());
+    out.stgreqtaskData              .assign(totalStageReqTasks, {});
+    out.taskToFirstRevStgreqtask    .assign(maxTasks+1,         lgrn::id_null<ReverseStageReqTaskId>());
+    out.revStgreqtaskToStage        .assign(totalStageReqTasks, lgrn::id_null<AnyStageId>());
+    out.taskToFirstTaskreqstg       .assign(maxTasks+1,         lgrn::id_null<TaskReqStageId>());
+    out.taskreqstgData              .assign(totalTasksReqStage, {});
+    out.anystgToFirstRevTaskreqstg  .assign(totalStages+1,      lgrn::id_null<ReverseTaskReqStageId>());
+    out.revTaskreqstgToTask         .assign(totalTasksReqStage, lgrn::id_null<TaskId>());
+    out.pltreeDescendantCounts      .assign(treeSize,           0);
+    out.pltreeToPipeline            .assign(treeSize,           lgrn::id_null<PipelineId>());
+    out.pipelineToPltree            .assign(maxPipelines,       lgrn::id_null<PipelineTreePos_t>());
+    out.pipelineToLoopScope         .assign(maxPipelines,       lgrn::id_null<PipelineTreePos_t>());
+    out.pltreeOuterLoopScope        .assign(treeSize,           lgrn::id_null<PipelineTreePos_t>());
+    out.taskToFirstSemaacq          .assign(maxTasks+1,         lgrn::id_null<TaskAcqSemaId>());
+    out.semaacqToSema               .assign(totalSemaAcq,       lgrn::id_null<SemaphoreId>());
+    out.semaToFirstRevSemaacq       .assign(maxSemas+1,         lgrn::id_null<ReverseTaskAcqSemaId>());
+    out.revSemaacqToTask            .assign(totalSemaAcq,       lgrn::id_null<TaskId>());
 
     // 5. Calculate one-to-many partitions
 
@@ -242,6 +269,15 @@ TaskGraph make_exec_graph(Tasks const& tasks, ArrayView<TaskEdges const* const>
         },
         [&out] (AnyStageId, ReverseTaskReqStageId) { });
 
+    fanout_partition(
+        out.taskToFirstSemaacq,
+        [&taskCounts] (TaskId task)                 { return taskCounts[task].acquiresSemas; },
+        [] (TaskId, TaskAcqSemaId) { });
+    fanout_partition(
+        out.semaToFirstRevSemaacq,
+        [&semaAcqCounts] (SemaphoreId sema)         { return semaAcqCounts[sema]; },
+        [] (SemaphoreId, ReverseTaskAcqSemaId) { });
+
     // 6. Push
 
     for (TaskId const task : tasks.m_taskIds)
@@ -299,11 +335,30 @@ TaskGraph make_exec_graph(Tasks const& tasks, ArrayView<TaskEdges const* const>
         }
     }
 
+    for (TaskEdges const* pEdges : data)
+    {
+        for (auto const [task, sema] : pEdges->m_semaphoreEdges)
+        {
+            TaskCounts &rTaskCounts = taskCounts[task];
+
+            TaskAcqSemaId const         acqId       = id_from_count(out.taskToFirstSemaacq, task, rTaskCounts.acquiresSemas);
+            ReverseTaskAcqSemaId const  revAcqId    = id_from_count(out.semaToFirstRevSemaacq, sema, semaAcqCounts[sema]);
+
+            out.semaacqToSema[acqId]        = sema;
+            out.revSemaacqToTask[revAcqId]  = task;
+
+            -- rTaskCounts.acquiresSemas;
+            -- semaAcqCounts[sema];
+            -- totalSemaAcq;
+        }
+    }
+
     // NOLINTBEGIN(readability-use-anyofallof)
     [[maybe_unused]] auto const all_counts_zero = [&] ()
     {
         if (   totalStageReqTasks   != 0
-            || totalTasksReqStage   != 0 )
+            || totalTasksReqStage   != 0
+            || totalSemaAcq         != 0 )
         {
             return false;
         }
@@ -321,7 +376,15 @@ TaskGraph make_exec_graph(Tasks const& tasks, ArrayView<TaskEdges const* const>
         for (TaskCounts const& taskCount : taskCounts)
         {
             if (   taskCount.requiredByStages != 0
-                || taskCount.requiresStages != 0 )
+                || taskCount.requiresStages != 0
+                || taskCount.acquiresSemas != 0 )
+            {
+                return false;
+            }
+        }
+        for (uint16_t const semaCount : semaAcqCounts)
+        {
+            if (semaCount != 0)
             {
                 return false;
             }
@@ -344,6 +407,7 @@ TaskGraph make_exec_graph(Tasks const& tasks, ArrayView<TaskEdges const* const>
         out.pltreeToPipeline[pos]     = root;
         out.pipelineToPltree[root]    = pos;
         out.pipelineToLoopScope[root] = newLoopScope;
+        out.pltreeOuterLoopScope[pos] = loopScope;
 
         uint32_t descendantCount = 0;
 
@@ -384,8 +448,6 @@ TaskGraph make_exec_graph(Tasks const& tasks, ArrayView<TaskEdges const* const>
 
         rootPos += 1 + rootDescendantCount;
     }
-
-    return out;
 }
 
 } // namespace osp
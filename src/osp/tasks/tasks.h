@@ -32,7 +32,9 @@
 
 #include <entt/core/family.hpp>
 
+#include <cstddef>
 #include <cstdint>
+#include <initializer_list>
 #include <ostream>
 #include <string_view>
 #include <variant>
@@ -43,6 +45,10 @@
     {                                                                                                       \
         static auto const arr = std::initializer_list<std::string_view>{__VA_ARGS__};                       \
         return osp::arrayView(arr);                                                                         \
+    }                                                                                                       \
+    constexpr inline std::size_t stage_count([[maybe_unused]] type _) noexcept                              \
+    {                                                                                                       \
+        return std::initializer_list<std::string_view>{__VA_ARGS__}.size();                                 \
     }
 
 #define OSP_DECLARE_STAGE_SCHEDULE(type, schedule_enum)                     \
@@ -97,9 +103,13 @@ struct PipelineInfo
 
 struct PipelineControl
 {
-    TaskId      scheduler   { lgrn::id_null<TaskId>() };
-    StageId     waitStage   { lgrn::id_null<StageId>() };
-    bool        isLoopScope { false };
+    TaskId          scheduler   { lgrn::id_null<TaskId>() };
+    StageId         waitStage   { lgrn::id_null<StageId>() };
+
+    /// Only 1 of every runEvery runs allowed by the scheduler task goes through; the others are
+    /// canceled as if the scheduler returned TaskAction::Cancel. Needs a scheduler task.
+    std::uint32_t   runEvery    { 1 };
+    bool            isLoopScope { false };
 };
 
 struct TplTaskPipelineStage
@@ -142,7 +152,8 @@ struct TaskEdges
 {
     std::vector<TplTaskPipelineStage>   m_syncWith;
 
-    //std::vector<TplTaskSemaphore>       m_semaphoreEdges;
+    /// Task acquires Semaphore while running, see Tasks::m_semaLimits
+    std::vector<TplTaskSemaphore>       m_semaphoreEdges;
 };
 
 using PipelineTreePos_t = uint32_t;
@@ -158,6 +169,9 @@ enum class ReverseStageReqTaskId    : uint32_t { };
 enum class TaskReqStageId           : uint32_t { };
 enum class ReverseTaskReqStageId    : uint32_t { };
 
+enum class TaskAcqSemaId            : uint32_t { };
+enum class ReverseTaskAcqSemaId     : uint32_t { };
+
 struct StageRequiresTask
 {
     AnyStageId  ownStage    { lgrn::id_null<AnyStageId>() };
@@ -216,11 +230,21 @@ struct TaskGraph
     KeyedVec<PipelineTreePos_t, uint32_t>           pltreeDescendantCounts;
     KeyedVec<PipelineTreePos_t, PipelineId>         pltreeToPipeline;
     KeyedVec<PipelineId, PipelineTreePos_t>         pipelineToPltree;
+    // Nearest loop scope enclosing each pipeline, including itself if it is a loop scope.
+    // Null if not in any loop.
     KeyedVec<PipelineId, PipelineTreePos_t>         pipelineToLoopScope;
-
-    // not yet used
-    //lgrn::IntArrayMultiMap<TaskInt, SemaphoreId>    taskAcquire;      /// Tasks acquire (n) Semaphores
-    //lgrn::IntArrayMultiMap<SemaphoreInt, TaskId>    semaAcquiredBy;   /// Semaphores are acquired by (n) Tasks
+    // Nearest loop scope strictly above each tree position; the scope it counts towards as a
+    // loop child. Null if none.
+    KeyedVec<PipelineTreePos_t, PipelineTreePos_t>  pltreeOuterLoopScope;
+
+    // Tasks acquire many Semaphores while running
+    // TaskId --> TaskAcqSemaId --> many SemaphoreId
+    KeyedVec<TaskId, TaskAcqSemaId>                 taskToFirstSemaacq;
+    KeyedVec<TaskAcqSemaId, SemaphoreId>            semaacqToSema;
+    // Semaphores are acquired by many Tasks
+    // SemaphoreId --> ReverseTaskAcqSemaId --> many TaskId
+    KeyedVec<SemaphoreId, ReverseTaskAcqSemaId>     semaToFirstRevSemaacq;
+    KeyedVec<ReverseTaskAcqSemaId, TaskId>          revSemaacqToTask;
 
 }; // struct TaskGraph
 
@@ -232,6 +256,21 @@ inline TaskGraph make_exec_graph(Tasks const& tasks, std::initializer_list<TaskE
     return make_exec_graph(tasks, arrayView(data));
 }
 
+/**
+ * @brief Rebuild an existing TaskGraph from scratch, reusing its allocations
+ *
+ * The whole graph is recalculated, same as make_exec_graph; this is not an incremental update
+ * of the Sessions that changed. Only the vectors' storage is kept, which avoids reallocating
+ * when tasks and pipelines are frequently added or removed, such as when opening and closing
+ * Sessions. exec_conform can be called afterwards on an existing ExecContext.
+ */
+void rebuild_exec_graph(Tasks const& tasks, ArrayView<TaskEdges const* const> data, TaskGraph& rOut);
+
+inline void rebuild_exec_graph(Tasks const& tasks, std::initializer_list<TaskEdges const* const> data, TaskGraph& rOut)
+{
+    rebuild_exec_graph(tasks, arrayView(data), rOut);
+}
+
 template <typename KEY_T, typename VALUE_T, typename GETSIZE_T, typename CLAIM_T>
 inline void fanout_partition(KeyedVec<KEY_T, VALUE_T>& rVec, GETSIZE_T&& get_size, CLAIM_T&& claim) noexcept
 {
@@ -0,0 +1,138 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "top_worker.h"
+#include "worker.h"
+
+#include <coroutine>
+#include <exception>
+#include <utility>
+
+namespace osp
+{
+
+/**
+ * @brief Coroutine returned by long-running TopTasks that are spread over multiple frames
+ *
+ * The coroutine starts suspended, and is resumed by top_run_blocking (the TopTaskDispatch
+ * overload) at most once per call, or by top_run_parallel on its calling thread. Use
+ * `co_await top_yield();` to give up the rest of the frame, and `co_return TaskActions{...};` to
+ * finish.
+ *
+ * While suspended, the task stays in ExecContext::tasksQueuedRun and is not completed, so
+ * its pipeline is held at the task's stage, similar to a waitStage that isn't signaled yet.
+ */
+class TopCoro
+{
+public:
+
+    struct promise_type
+    {
+        TopCoro get_return_object() noexcept
+        {
+            return TopCoro{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+
+        void return_value(TaskActions actions) noexcept { m_actions = actions; }
+
+        void unhandled_exception() noexcept { std::terminate(); }
+
+        TaskActions m_actions;
+    };
+
+    using Handle_t = std::coroutine_handle<promise_type>;
+
+    constexpr TopCoro() noexcept = default;
+    explicit TopCoro(Handle_t handle) noexcept : m_handle{handle} { }
+    TopCoro(TopCoro const& copy) = delete;
+    TopCoro(TopCoro&& move) noexcept : m_handle{std::exchange(move.m_handle, {})} { }
+
+    TopCoro& operator=(TopCoro const& copy) = delete;
+    TopCoro& operator=(TopCoro&& move) noexcept
+    {
+        if (this != &move)
+        {
+            destroy();
+            m_handle = std::exchange(move.m_handle, {});
+        }
+        return *this;
+    }
+
+    ~TopCoro() { destroy(); }
+
+    [[nodiscard]] bool has_value() const noexcept { return bool(m_handle); }
+
+    [[nodiscard]] bool done() const noexcept { return m_handle.done(); }
+
+    /**
+     * @brief Run the coroutine until it yields or returns
+     *
+     * @return True if the coroutine has finished
+     */
+    bool resume()
+    {
+        m_handle.resume();
+        return m_handle.done();
+    }
+
+    /// TaskActions given to co_return. Only valid once done() is true.
+    [[nodiscard]] TaskActions result() const noexcept { return m_handle.promise().m_actions; }
+
+private:
+
+    void destroy() noexcept
+    {
+        if (m_handle)
+        {
+            m_handle.destroy();
+            m_handle = {};
+        }
+    }
+
+    Handle_t m_handle;
+};
+
+/**
+ * @brief Awaitable that suspends a TopCoro until the next frame
+ */
+[[nodiscard]] constexpr std::suspend_always top_yield() noexcept
+{
+    return {};
+}
+
+/**
+ * @brief Function that creates a TopCoro
+ *
+ * Only called once per task run; the coroutine outlives the call. The ArrayView of arguments is
+ * only guaranteed to be valid until the first suspension, so copy what's needed to local
+ * variables first. wrap_coro_args does this automatically.
+ */
+using TopTaskCoroFunc_t = TopCoro(*)(WorkerContext, ArrayView<entt::any>) noexcept;
+
+} // namespace osp
@@ -0,0 +1,64 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "top_dispatch.h"
+
+namespace osp
+{
+
+void top_dispatch_build(TopTaskDispatch& rOut, TopTaskDataVec_t const& taskData, ArrayView<entt::any> const topData)
+{
+    std::size_t const taskCount = taskData.size();
+
+    rOut.taskToFirstArg.resize(taskCount + 1);
+    rOut.coroutines    .resize(taskCount);
+    rOut.coroYielded   .resize(taskCount);
+    rOut.args     .clear();
+    rOut.argToData.clear();
+
+    uint32_t argCount = 0;
+    for (TopTask const& topTask : taskData)
+    {
+        argCount += uint32_t(topTask.m_dataUsed.size());
+    }
+    rOut.args     .reserve(argCount);
+    rOut.argToData.reserve(argCount);
+
+    for (std::size_t task = 0; task < taskCount; ++task)
+    {
+        rOut.taskToFirstArg[TaskId(task)] = uint32_t(rOut.args.size());
+
+        for (TopDataId const dataId : taskData[TaskId(task)].m_dataUsed)
+        {
+            rOut.argToData.push_back(dataId);
+            rOut.args.push_back((dataId != lgrn::id_null<TopDataId>())
+                                ? topData[dataId].as_ref()
+                                : entt::any{});
+        }
+    }
+
+    rOut.taskToFirstArg[TaskId(taskCount)] = uint32_t(rOut.args.size());
+}
+
+} // namespace osp
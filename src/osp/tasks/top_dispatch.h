@@ -0,0 +1,108 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "top_coro.h"
+#include "top_tasks.h"
+
+#include "../core/id_bitset.h"
+
+#include <entt/core/any.hpp>
+
+#include <Corrade/Containers/ArrayView.h>
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace osp
+{
+
+/**
+ * @brief Pre-resolved TopData references for each TopTask, so tasks can be run without
+ *        rebuilding their argument list every time
+ *
+ * Arguments of all tasks are stored contiguously, ordered by TaskId, in the same order as
+ * TopTask::m_dataUsed. Build with top_dispatch_build after make_exec_graph, or whenever tasks are
+ * added or removed.
+ *
+ * References stay usable if topData slots are re-emplaced with top_emplace or resized;
+ * top_dispatch_args re-resolves references whose address or type no longer match.
+ *
+ * Also holds suspended coroutines of tasks using TopTask::m_coroFunc, which are kept across
+ * rebuilds.
+ */
+struct TopTaskDispatch
+{
+    KeyedVec<TaskId, uint32_t>  taskToFirstArg;
+    std::vector<entt::any>      args;
+    std::vector<TopDataId>      argToData;
+
+    /// Suspended coroutine of each task, or empty if not started
+    KeyedVec<TaskId, TopCoro>   coroutines;
+
+    /// Coroutines that already ran during the current top_run_blocking call, or the current frame
+    /// of a TopRunInstance
+    IdBitSet<TaskId>            coroYielded;
+
+    /// Time that coroutines are allowed to run per frame, summed over all of them
+    std::chrono::nanoseconds    coroBudget{std::chrono::milliseconds{4}};
+
+    /// TopTask::m_cheap tasks run by top_run_blocking in one go, reused to not allocate
+    std::vector<TaskId>         cheapBatch;
+};
+
+void top_dispatch_build(TopTaskDispatch& rOut, TopTaskDataVec_t const& taskData, ArrayView<entt::any> topData);
+
+/**
+ * @brief Get arguments to pass to a task's TopTaskFunc_t
+ *
+ * Does not allocate. Checks each argument against topData in case it was re-emplaced.
+ */
+[[nodiscard]] inline ArrayView<entt::any> top_dispatch_args(TopTaskDispatch& rDispatch, ArrayView<entt::any> const topData, TaskId const task) noexcept
+{
+    uint32_t const first = rDispatch.taskToFirstArg[task];
+    uint32_t const last  = rDispatch.taskToFirstArg[TaskId(TaskInt(task) + 1)];
+
+    for (uint32_t i = first; i < last; ++i)
+    {
+        TopDataId const id = rDispatch.argToData[i];
+        if (id == lgrn::id_null<TopDataId>())
+        {
+            continue;
+        }
+
+        entt::any       &rArg  = rDispatch.args[i];
+        entt::any const &data  = topData[id];
+        if (rArg.data() != data.data() || rArg.type() != data.type())
+        {
+            rArg = topData[id].as_ref();
+        }
+    }
+
+    return arrayView(rDispatch.args.data(), rDispatch.args.size()).slice(first, last);
+}
+
+} // namespace osp
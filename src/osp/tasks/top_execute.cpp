@@ -26,21 +26,48 @@
 #include "top_worker.h"
 #include "execute.h"
 
+#include "../util/profiling.h"
+
 #include <Corrade/Containers/ArrayViewStl.h>
 
 #include <entt/core/any.hpp>
 
 #include <algorithm>
+#include <chrono>
 #include <iomanip>
 #include <vector>
 
 namespace osp
 {
 
-void top_run_blocking(Tasks const& tasks, TaskGraph const& graph, TopTaskDataVec_t& rTaskData, ArrayView<entt::any> topData, ExecContext& rExec, WorkerContext worker)
+/**
+ * @brief Order that ready tasks are started in, see TopTask::m_priority
+ *
+ * ExecContext::tasksQueuedRun is unordered, so this keeps the order the same every frame.
+ */
+static bool runs_before(TopTaskDataVec_t const& taskData, TaskId const lhs, TaskId const rhs) noexcept
 {
+    int const lhsPriority = taskData[lhs].m_priority;
+    int const rhsPriority = taskData[rhs].m_priority;
+    return (lhsPriority != rhsPriority) ? (lhsPriority > rhsPriority) : (lhs < rhs);
+}
+
+void top_run_blocking(Tasks const& tasks, TaskGraph const& graph, TopTaskDataVec_t& rTaskData, ArrayView<entt::any> topData, ExecContext& rExec, WorkerContext worker, TopExecTrace *pTrace)
+{
+    if (pTrace != nullptr)
+    {
+        top_trace_stages(*pTrace, tasks, rExec);
+    }
+
     std::vector<entt::any> topDataRefs;
 
+    // Buffered metrics and logs are lost on return if no WorkerLocal was given
+    WorkerLocal fallbackLocal;
+    if (worker.m_pLocal == nullptr)
+    {
+        worker.m_pLocal = &fallbackLocal;
+    }
+
     // Run until there's no tasks left to run
     while (true)
     {
@@ -49,9 +76,18 @@ void top_run_blocking(Tasks const& tasks, TaskGraph const& graph, TopTaskDataVec
 
         if (runTasksLeft != 0)
         {
-            TaskId const task = rExec.tasksQueuedRun[0];
+            TaskId task = rExec.tasksQueuedRun[0];
+            for (TaskId const queued : rExec.tasksQueuedRun)
+            {
+                if (runs_before(rTaskData, queued, task))
+                {
+                    task = queued;
+                }
+            }
             TopTask &rTopTask = rTaskData[task];
 
+            LGRN_ASSERTM(rTopTask.m_coroFunc == nullptr, "Coroutine tasks require the TopTaskDispatch overload of top_run_blocking");
+
             topDataRefs.clear();
             topDataRefs.reserve(rTopTask.m_dataUsed.size());
             for (TopDataId const dataId : rTopTask.m_dataUsed)
@@ -63,8 +99,22 @@ void top_run_blocking(Tasks const& tasks, TaskGraph const& graph, TopTaskDataVec
 
             bool const shouldRun = (rTopTask.m_func != nullptr);
 
+            TopExecTrace::TimePoint_t const start = (pTrace != nullptr) ? TopExecTrace::Clock_t::now() : TopExecTrace::TimePoint_t{};
+
             // Task function is called here
-            TaskActions const status = shouldRun ? rTopTask.m_func(worker, topDataRefs) : TaskActions{};
+            TaskActions status;
+            if (shouldRun)
+            {
+                OSP_PROFILE_ZONE_DYNAMIC(rTopTask.m_debugName);
+                status = rTopTask.m_func(worker, topDataRefs);
+            }
+
+            worker.m_pLocal->scratch.reset();
+
+            if (pTrace != nullptr)
+            {
+                top_trace_task(*pTrace, task, TopExecTrace::smc_coordinatorThread, start, TopExecTrace::Clock_t::now());
+            }
 
             complete_task(tasks, graph, rExec, task, status);
         }
@@ -74,6 +124,659 @@ void top_run_blocking(Tasks const& tasks, TaskGraph const& graph, TopTaskDataVec
         }
 
         exec_update(tasks, graph, rExec);
+
+        if (pTrace != nullptr)
+        {
+            top_trace_stages(*pTrace, tasks, rExec);
+        }
+    }
+}
+
+void top_run_blocking(Tasks const& tasks, TaskGraph const& graph, TopTaskDataVec_t& rTaskData, TopTaskDispatch& rDispatch, ArrayView<entt::any> topData, ExecContext& rExec, WorkerContext worker, TopExecTrace *pTrace)
+{
+    if (pTrace != nullptr)
+    {
+        top_trace_stages(*pTrace, tasks, rExec);
+    }
+
+    LGRN_ASSERTM(rDispatch.taskToFirstArg.size() == rTaskData.size() + 1, "TopTaskDispatch is out of date, call top_dispatch_build");
+
+    using Clock_t = std::chrono::steady_clock;
+
+    // Time spent running coroutines during this call, limited by rDispatch.coroBudget
+    Clock_t::duration coroSpent{0};
+
+    rDispatch.coroYielded.clear();
+
+    WorkerLocal fallbackLocal;
+    if (worker.m_pLocal == nullptr)
+    {
+        worker.m_pLocal = &fallbackLocal;
+    }
+
+    // Suspended coroutines stay in tasksQueuedRun, skip over them
+    auto const next_task = [&rExec, &rDispatch, &rTaskData] () noexcept -> TaskId
+    {
+        TaskId best = lgrn::id_null<TaskId>();
+        for (TaskId const task : rExec.tasksQueuedRun)
+        {
+            if ( ! rDispatch.coroYielded.contains(task)
+                && (best == lgrn::id_null<TaskId>() || runs_before(rTaskData, task, best)) )
+            {
+                best = task;
+            }
+        }
+        return best;
+    };
+
+    auto const run_func = [&rTaskData, &rDispatch, topData, worker, pTrace] (TaskId const task, TopExecTrace::TimePoint_t const start) noexcept -> TaskActions
+    {
+        TopTask &rTopTask = rTaskData[task];
+        TaskActions status;
+
+        // Task function is called here
+        if (rTopTask.m_func != nullptr)
+        {
+            OSP_PROFILE_ZONE_DYNAMIC(rTopTask.m_debugName);
+            status = rTopTask.m_func(worker, top_dispatch_args(rDispatch, topData, task));
+            worker.m_pLocal->scratch.reset();
+        }
+
+        if (pTrace != nullptr)
+        {
+            top_trace_task(*pTrace, task, TopExecTrace::smc_coordinatorThread, start, TopExecTrace::Clock_t::now());
+        }
+        return status;
+    };
+
+    // Run until there's no tasks left to run
+    for (TaskId task = next_task(); task != lgrn::id_null<TaskId>(); task = next_task())
+    {
+        TopTask &rTopTask = rTaskData[task];
+
+        TaskActions status;
+
+        TopExecTrace::TimePoint_t const start = (pTrace != nullptr) ? TopExecTrace::Clock_t::now() : TopExecTrace::TimePoint_t{};
+
+        if (rTopTask.m_coroFunc != nullptr)
+        {
+            rDispatch.coroYielded.insert(task);
+
+            if (coroSpent >= rDispatch.coroBudget)
+            {
+                continue; // Out of time, try again next call
+            }
+
+            TopCoro &rCoro = rDispatch.coroutines[task];
+            if ( ! rCoro.has_value() )
+            {
+                rCoro = rTopTask.m_coroFunc(worker, top_dispatch_args(rDispatch, topData, task));
+            }
+
+            Clock_t::time_point const coroStart = Clock_t::now();
+            bool done;
+            {
+                OSP_PROFILE_ZONE_DYNAMIC(rTopTask.m_debugName);
+                done = rCoro.resume();
+            }
+            coroSpent += Clock_t::now() - coroStart;
+
+            worker.m_pLocal->scratch.reset();
+
+            if (pTrace != nullptr)
+            {
+                top_trace_task(*pTrace, task, TopExecTrace::smc_coordinatorThread, start, TopExecTrace::Clock_t::now());
+            }
+
+            if ( ! done )
+            {
+                continue; // Suspended, task stays queued and holds its stage
+            }
+
+            status = rCoro.result();
+            rCoro = {};
+        }
+        else
+        {
+            status = run_func(task, start);
+        }
+
+        complete_task(tasks, graph, rExec, task, status);
+
+        // Run all other cheap tasks queued right now before the next exec_update, instead of
+        // paying for an update after each of them. Check again before running each one, in case
+        // an earlier one cancelled its pipeline.
+        if (rTopTask.m_cheap)
+        {
+            rDispatch.cheapBatch.clear();
+            for (TaskId const queued : rExec.tasksQueuedRun)
+            {
+                TopTask const &rQueued = rTaskData[queued];
+                if (rQueued.m_cheap && rQueued.m_coroFunc == nullptr)
+                {
+                    rDispatch.cheapBatch.push_back(queued);
+                }
+            }
+            std::sort(rDispatch.cheapBatch.begin(), rDispatch.cheapBatch.end(), [&rTaskData] (TaskId const lhs, TaskId const rhs)
+            {
+                return runs_before(rTaskData, lhs, rhs);
+            });
+
+            for (TaskId const cheap : rDispatch.cheapBatch)
+            {
+                if (rExec.tasksQueuedRun.contains(cheap))
+                {
+                    TopExecTrace::TimePoint_t const cheapStart = (pTrace != nullptr) ? TopExecTrace::Clock_t::now() : TopExecTrace::TimePoint_t{};
+                    complete_task(tasks, graph, rExec, cheap, run_func(cheap, cheapStart));
+                }
+            }
+        }
+
+        exec_update(tasks, graph, rExec);
+
+        if (pTrace != nullptr)
+        {
+            top_trace_stages(*pTrace, tasks, rExec);
+        }
+    }
+}
+
+namespace
+{
+
+/// Coordinator state of one TopRunInstance, see top_run_parallel
+struct ParallelRunState
+{
+    // For each TopDataId: -1 if written to by an in-flight task, otherwise the number of in-flight
+    // tasks reading it.
+    std::vector<int>        dataInUse;
+
+    // Tasks in ExecContext::tasksQueuedRun that were already handed to the pool
+    std::vector<bool>       dispatched;
+
+    std::vector<bool>       pinned;
+
+    // TopTask::m_cheap tasks run right on the coordinator instead of going through the pool,
+    // which would cost far more than running them
+    std::vector<TaskId>     cheapTasks;
+
+    // Coroutine tasks to resume on the coordinator, see TopRunInstance::pDispatch
+    std::vector<TaskId>     coroTasks;
+
+    // Time spent in coroutines since the instance last went idle, limited by
+    // TopTaskDispatch::coroBudget
+    std::chrono::steady_clock::duration coroSpent { 0 };
+
+    // Copy of ExecContext::tasksQueuedRun sorted by runs_before, so higher priority tasks get
+    // their data and a worker first
+    std::vector<TaskId>     ready;
+    std::size_t             readyPos        { 0 };
+
+    TaskId                  coordinatorTask { lgrn::id_null<TaskId>() };
+    std::size_t             inFlight        { 0 };
+    bool                    finished        { false };
+};
+
+} // namespace
+
+/**
+ * @brief Access to a task's TopData at index, merged with every other time the task lists it
+ *
+ * A task may take the same TopData as more than one argument. Counting each of them separately
+ * would let a read's +1 undo a write's -1 in dataInUse, so only the first listing is counted.
+ *
+ * @return Merged access, or false if the same TopData is listed before index
+ */
+static bool merged_access(TopTask const& topTask, std::size_t const index, TopDataAccess& rAccess) noexcept
+{
+    TopDataId const id = topTask.m_dataUsed[index];
+    for (std::size_t i = 0; i < index; ++i)
+    {
+        if (topTask.m_dataUsed[i] == id)
+        {
+            return false;
+        }
+    }
+
+    rAccess = top_data_access(topTask, index);
+    for (std::size_t i = index + 1; i < topTask.m_dataUsed.size(); ++i)
+    {
+        if (topTask.m_dataUsed[i] == id)
+        {
+            rAccess = std::max(rAccess, top_data_access(topTask, i));
+        }
+    }
+    return true;
+}
+
+static bool data_available(std::vector<int> const& dataInUse, TopTask const& topTask) noexcept
+{
+    for (std::size_t i = 0; i < topTask.m_dataUsed.size(); ++i)
+    {
+        TopDataId const id = topTask.m_dataUsed[i];
+        TopDataAccess   access  { TopDataAccess::Read };
+        if (   id == lgrn::id_null<TopDataId>() || dataInUse[id] == 0
+            || ! merged_access(topTask, i, access))
+        {
+            continue;
+        }
+
+        // Only reads can be shared
+        if (dataInUse[id] < 0 || access == TopDataAccess::Write)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void mark_data_used(std::vector<int>& rDataInUse, TopTask const& topTask, bool const use) noexcept
+{
+    for (std::size_t i = 0; i < topTask.m_dataUsed.size(); ++i)
+    {
+        TopDataId const id = topTask.m_dataUsed[i];
+        TopDataAccess   access  { TopDataAccess::Read };
+        if (id == lgrn::id_null<TopDataId>() || ! merged_access(topTask, i, access))
+        {
+            continue;
+        }
+
+        if (access == TopDataAccess::Write)
+        {
+            rDataInUse[id] = use ? -1 : 0;
+        }
+        else
+        {
+            rDataInUse[id] += use ? 1 : -1;
+        }
+    }
+}
+
+static bool uses_pinned(std::vector<bool> const& pinned, TopTask const& topTask) noexcept
+{
+    if (topTask.m_affinity == TopTaskAffinity::Main)
+    {
+        return true;
+    }
+    return std::any_of(topTask.m_dataUsed.begin(), topTask.m_dataUsed.end(), [&pinned] (TopDataId const id)
+    {
+        return id != lgrn::id_null<TopDataId>() && pinned[id];
+    });
+}
+
+void top_run_parallel(Tasks const& tasks, TaskGraph const& graph, TopTaskDataVec_t& rTaskData, ArrayView<entt::any> topData, ExecContext& rExec, TopWorkerPool& rPool, TopExecTrace *pTrace, ArrayView<TopDataId const> coordinatorData, TopTaskDispatch *pDispatch)
+{
+    TopRunInstance instance{
+        .pTasks             = &tasks,
+        .pGraph             = &graph,
+        .pTaskData          = &rTaskData,
+        .topData            = topData,
+        .pExec              = &rExec,
+        .pTrace             = pTrace,
+        .coordinatorData    = coordinatorData,
+        .pDispatch          = pDispatch };
+
+    top_run_parallel(ArrayView<TopRunInstance>{&instance, 1}, rPool);
+}
+
+void top_run_parallel(ArrayView<TopRunInstance> const instances, TopWorkerPool& rPool)
+{
+    using Clock_t = TopWorkerPool::Clock_t;
+
+    std::vector<ParallelRunState> states(instances.size());
+
+    for (std::size_t i = 0; i < instances.size(); ++i)
+    {
+        TopRunInstance const &rInst  = instances[i];
+        ParallelRunState     &rState = states[i];
+
+        if (rInst.pTrace != nullptr)
+        {
+            top_trace_stages(*rInst.pTrace, *rInst.pTasks, *rInst.pExec);
+        }
+
+        rState.dataInUse .assign(rInst.topData.size(), 0);
+        rState.dispatched.assign(rInst.pTasks->m_taskIds.capacity(), false);
+        rState.pinned    .assign(rInst.topData.size(), false);
+        for (TopDataId const id : rInst.coordinatorData)
+        {
+            rState.pinned[id] = true;
+        }
+
+        if (rInst.pDispatch != nullptr)
+        {
+            LGRN_ASSERTM(rInst.pDispatch->taskToFirstArg.size() == rInst.pTaskData->size() + 1, "TopTaskDispatch is out of date, call top_dispatch_build");
+            rInst.pDispatch->coroYielded.clear();
+        }
+
+        rPool.bind(*rInst.pTaskData, rInst.topData, uint32_t(i));
+    }
+
+    std::vector<TopWorkerPool::Completed> completed;
+
+    std::vector<entt::any> topDataRefs;
+
+    // Run a task on the calling thread
+    auto const run_here = [&topDataRefs, &rPool] (TopRunInstance& rInst, TaskId const task) noexcept -> TaskActions
+    {
+        TopTask &rTopTask = (*rInst.pTaskData)[task];
+
+        topDataRefs.clear();
+        topDataRefs.reserve(rTopTask.m_dataUsed.size());
+        for (TopDataId const dataId : rTopTask.m_dataUsed)
+        {
+            topDataRefs.push_back((dataId != lgrn::id_null<TopDataId>())
+                                   ? rInst.topData[dataId].as_ref()
+                                   : entt::any{});
+        }
+
+        Clock_t::time_point const start = Clock_t::now();
+
+        WorkerContext const ctx{.m_pLocal = &rPool.worker_local(0), .m_workerIndex = TopExecTrace::smc_coordinatorThread, .m_parallelFor = rPool.parallel_for()};
+        TaskActions status;
+        if (rTopTask.m_func != nullptr)
+        {
+            OSP_PROFILE_ZONE_DYNAMIC(rTopTask.m_debugName);
+            status = rTopTask.m_func(ctx, topDataRefs);
+        }
+
+        ctx.m_pLocal->scratch.reset();
+
+        Clock_t::time_point const end = Clock_t::now();
+
+        ++ rInst.tasksRun;
+        rInst.taskTime += end - start;
+
+        if (rInst.pTrace != nullptr)
+        {
+            top_trace_task(*rInst.pTrace, task, TopExecTrace::smc_coordinatorThread, start, end);
+        }
+        return status;
+    };
+
+    // Resume a coroutine task on the calling thread, at most once until the instance goes idle.
+    // Returns true and writes rStatus once the coroutine has finished.
+    auto const resume_here = [&rPool] (TopRunInstance& rInst, ParallelRunState& rState, TaskId const task, TaskActions& rStatus) noexcept -> bool
+    {
+        TopTaskDispatch &rDispatch = *rInst.pDispatch;
+        TopTask         &rTopTask  = (*rInst.pTaskData)[task];
+
+        rDispatch.coroYielded.insert(task);
+
+        if (rState.coroSpent >= rDispatch.coroBudget)
+        {
+            return false; // Out of time, try again once the instance goes idle
+        }
+
+        // Arguments come from rDispatch, which keeps them valid while the coroutine is suspended
+        WorkerContext const ctx{.m_pLocal = &rPool.worker_local(0), .m_workerIndex = TopExecTrace::smc_coordinatorThread, .m_parallelFor = rPool.parallel_for()};
+        TopCoro &rCoro = rDispatch.coroutines[task];
+        if ( ! rCoro.has_value() )
+        {
+            rCoro = rTopTask.m_coroFunc(ctx, top_dispatch_args(rDispatch, rInst.topData, task));
+        }
+
+        Clock_t::time_point const start = Clock_t::now();
+        bool done;
+        {
+            OSP_PROFILE_ZONE_DYNAMIC(rTopTask.m_debugName);
+            done = rCoro.resume();
+        }
+        Clock_t::time_point const end = Clock_t::now();
+
+        ctx.m_pLocal->scratch.reset();
+
+        rState.coroSpent += end - start;
+        rInst.taskTime   += end - start;
+
+        if (rInst.pTrace != nullptr)
+        {
+            top_trace_task(*rInst.pTrace, task, TopExecTrace::smc_coordinatorThread, start, end);
+        }
+
+        if ( ! done )
+        {
+            return false; // Suspended, task stays queued and holds its stage
+        }
+
+        ++ rInst.tasksRun;
+        rStatus = rCoro.result();
+        rCoro = {};
+        return true;
+    };
+
+    // Try to start one ready task of an instance. Returns false once none are left to try.
+    auto const dispatch_next = [&rPool] (TopRunInstance const& rInst, ParallelRunState& rState, uint32_t const index) -> bool
+    {
+        TopTaskDataVec_t const &rTaskData = *rInst.pTaskData;
+
+        while (rState.readyPos < rState.ready.size())
+        {
+            TaskId const    task        = rState.ready[rState.readyPos ++];
+            TopTask const   &rTopTask   = rTaskData[task];
+
+            if (rState.dispatched[std::size_t(task)] || ! data_available(rState.dataInUse, rTopTask))
+            {
+                continue;
+            }
+
+            if (rTopTask.m_coroFunc != nullptr)
+            {
+                LGRN_ASSERTM(rInst.pDispatch != nullptr, "Coroutine tasks require TopRunInstance::pDispatch");
+
+                // Always resumed on the coordinator, and skipped once yielded
+                if ( ! rInst.pDispatch->coroYielded.contains(task) )
+                {
+                    rState.dispatched[std::size_t(task)] = true;
+                    mark_data_used(rState.dataInUse, rTopTask, true);
+                    rState.coroTasks.push_back(task);
+                }
+                continue;
+            }
+
+            if (rTopTask.m_cheap && rTopTask.m_affinity != TopTaskAffinity::Dedicated)
+            {
+                // Reserve its data, so nothing dispatched after it in this loop conflicts
+                rState.dispatched[std::size_t(task)] = true;
+                mark_data_used(rState.dataInUse, rTopTask, true);
+                rState.cheapTasks.push_back(task);
+                continue;
+            }
+
+            if (uses_pinned(rState.pinned, rTopTask))
+            {
+                if (rState.coordinatorTask == lgrn::id_null<TaskId>())
+                {
+                    // Reserve its data too, it's not running yet but tasks after it could conflict
+                    rState.coordinatorTask = task;
+                    mark_data_used(rState.dataInUse, rTopTask, true);
+                }
+                continue;
+            }
+
+            rState.dispatched[std::size_t(task)] = true;
+            mark_data_used(rState.dataInUse, rTopTask, true);
+            ++ rState.inFlight;
+
+            rPool.push(task, rTopTask.m_affinity == TopTaskAffinity::Dedicated, index);
+            return true;
+        }
+        return false;
+    };
+
+    // Instance that gets to push first, rotated every pass so none always takes workers first
+    std::size_t firstInstance = 0;
+
+    // Run until there's no tasks left to run
+    while (true)
+    {
+        std::size_t active = 0;
+
+        for (std::size_t i = 0; i < instances.size(); ++i)
+        {
+            ParallelRunState &rState = states[i];
+            if (rState.finished)
+            {
+                continue;
+            }
+
+            ExecContext const &rExec = *instances[i].pExec;
+            rState.coordinatorTask = lgrn::id_null<TaskId>();
+            rState.cheapTasks.clear();
+            rState.coroTasks.clear();
+            rState.readyPos = 0;
+            rState.ready.assign(rExec.tasksQueuedRun.begin(), rExec.tasksQueuedRun.end());
+
+            TopTaskDataVec_t const &rTaskData = *instances[i].pTaskData;
+            std::sort(rState.ready.begin(), rState.ready.end(), [&rTaskData] (TaskId const lhs, TaskId const rhs)
+            {
+                return runs_before(rTaskData, lhs, rhs);
+            });
+            ++ active;
+        }
+
+        if (active == 0)
+        {
+            break;
+        }
+
+        // Push one task from each instance in turn, so an instance with a lot of ready tasks
+        // doesn't fill up every worker's queue ahead of the others
+        for (bool pushedAny = true; pushedAny; )
+        {
+            pushedAny = false;
+            for (std::size_t n = 0; n < instances.size(); ++n)
+            {
+                std::size_t const i = (firstInstance + n) % instances.size();
+                if ( ! states[i].finished )
+                {
+                    pushedAny |= dispatch_next(instances[i], states[i], uint32_t(i));
+                }
+            }
+        }
+        firstInstance = (firstInstance + 1) % instances.size();
+
+        bool ranHere = false;
+        bool anyInFlight = false;
+
+        for (std::size_t i = 0; i < instances.size(); ++i)
+        {
+            TopRunInstance      &rInst  = instances[i];
+            ParallelRunState    &rState = states[i];
+            if (rState.finished)
+            {
+                continue;
+            }
+
+            for (TaskId const task : rState.cheapTasks)
+            {
+                TaskActions const status = run_here(rInst, task);
+
+                rState.dispatched[std::size_t(task)] = false;
+                mark_data_used(rState.dataInUse, (*rInst.pTaskData)[task], false);
+
+                complete_task(*rInst.pTasks, *rInst.pGraph, *rInst.pExec, task, status);
+            }
+
+            for (TaskId const task : rState.coroTasks)
+            {
+                TaskActions status;
+                bool const done = resume_here(rInst, rState, task, status);
+
+                rState.dispatched[std::size_t(task)] = false;
+                mark_data_used(rState.dataInUse, (*rInst.pTaskData)[task], false);
+
+                if (done)
+                {
+                    complete_task(*rInst.pTasks, *rInst.pGraph, *rInst.pExec, task, status);
+                }
+            }
+
+            if (rState.coordinatorTask != lgrn::id_null<TaskId>())
+            {
+                // Run pinned task right here. Its data was checked to be free, and nothing else
+                // of this instance is dispatched until it's done
+                TaskActions const status = run_here(rInst, rState.coordinatorTask);
+                mark_data_used(rState.dataInUse, (*rInst.pTaskData)[rState.coordinatorTask], false);
+
+                complete_task(*rInst.pTasks, *rInst.pGraph, *rInst.pExec, rState.coordinatorTask, status);
+            }
+
+            bool const instRanHere =    ( ! rState.cheapTasks.empty() ) || ( ! rState.coroTasks.empty() )
+                                     || (rState.coordinatorTask != lgrn::id_null<TaskId>());
+            ranHere     = ranHere || instRanHere;
+            anyInFlight = anyInFlight || (rState.inFlight != 0);
+
+            if ( ! instRanHere && rState.inFlight == 0 )
+            {
+                // Nothing running means nothing holds TopData, so any queued task would have been
+                // dispatched above. Only coroutines that already yielded can be left.
+                LGRN_ASSERT(std::all_of(rInst.pExec->tasksQueuedRun.begin(), rInst.pExec->tasksQueuedRun.end(), [&rInst] (TaskId const task)
+                {
+                    return rInst.pDispatch != nullptr && rInst.pDispatch->coroYielded.contains(task);
+                }));
+
+                // Nothing of this instance is in flight, so onIdle is free to touch its TopData
+                rState.finished = ! (rInst.onIdle && rInst.onIdle());
+
+                if ( ! rState.finished && rInst.pDispatch != nullptr )
+                {
+                    // Next frame of the instance, suspended coroutines get to run again
+                    rInst.pDispatch->coroYielded.clear();
+                    rState.coroSpent = {};
+                }
+            }
+        }
+
+        if (ranHere)
+        {
+            // Pick up whatever workers finished in the meantime, without waiting for more
+            rPool.take_completed(completed);
+        }
+        else if (anyInFlight)
+        {
+            rPool.wait_completed(completed);
+        }
+        else
+        {
+            completed.clear();
+        }
+
+        for (TopWorkerPool::Completed const& done : completed)
+        {
+            TopRunInstance      &rInst  = instances[done.instance];
+            ParallelRunState    &rState = states[done.instance];
+
+            rState.dispatched[std::size_t(done.task)] = false;
+            mark_data_used(rState.dataInUse, (*rInst.pTaskData)[done.task], false);
+            -- rState.inFlight;
+
+            ++ rInst.tasksRun;
+            rInst.taskTime += done.end - done.start;
+
+            if (rInst.pTrace != nullptr)
+            {
+                top_trace_task(*rInst.pTrace, done.task, done.worker + 1, done.start, done.end);
+            }
+
+            complete_task(*rInst.pTasks, *rInst.pGraph, *rInst.pExec, done.task, done.actions);
+        }
+
+        for (std::size_t i = 0; i < instances.size(); ++i)
+        {
+            if (states[i].finished)
+            {
+                continue;
+            }
+
+            TopRunInstance const &rInst = instances[i];
+            exec_update(*rInst.pTasks, *rInst.pGraph, *rInst.pExec);
+
+            if (rInst.pTrace != nullptr)
+            {
+                top_trace_stages(*rInst.pTrace, *rInst.pTasks, *rInst.pExec);
+            }
+        }
     }
 }
 
@@ -193,6 +896,9 @@ std::ostream& operator<<(std::ostream& rStream, TopExecWriteState const& write)
         }
     }
 
+    rStream << "Updates: " << exec.stats.updates << "  Update cycles: " << exec.stats.cycles
+            << "  Max cycles per update: " << exec.stats.maxCyclesPerUpdate << "\n";
+
     rStream << "*Status: [R: Running]  [L: Looping] [O: Looping Children] [C: Canceled] [S: Signal Blocked] [Q: Has Queued Tasks To Run] [B: Queued Tasks Blocked]\n";
 
 
@@ -203,6 +909,17 @@ std::ostream& operator<<(std::ostream& rStream, TopExecWriteState const& write)
         write_task_requirements(rStream, tasks, graph, exec, task);
     }
 
+    for (SemaphoreId const sema : tasks.m_semaIds)
+    {
+        rStream << "Semaphore SEMA" << SemaphoreInt(sema) << ": "
+                << exec.semaAcquired[sema] << "/" << tasks.m_semaLimits[sema] << " acquired\n";
+    }
+
+    for (TaskId const task : exec.tasksQueuedSema)
+    {
+        rStream << "Task Waiting on Semaphore: " << "TASK" << TaskInt(task) << " - " << taskData[task].m_debugName << "\n";
+    }
+
     return rStream;
 }
 
@@ -286,6 +1003,14 @@ std::ostream& operator<<(std::ostream& rStream, TopExecWriteLog const& write)
         {
             rStream << "Complete TASK" << TaskInt(msg.task) << " - " << taskData[msg.task].m_debugName << "\n";
         }
+        else if constexpr (std::is_same_v<MSG_T, ExecContext::SemaphoreWait>)
+        {
+            rStream << "    * Wait on Semaphore TASK" << TaskInt(msg.task) << "\n";
+        }
+        else if constexpr (std::is_same_v<MSG_T, ExecContext::SemaphoreAcquire>)
+        {
+            rStream << "SemaphoreAcquire TASK" << TaskInt(msg.task) << " - " << taskData[msg.task].m_debugName << "\n";
+        }
         else if constexpr (std::is_same_v<MSG_T, ExecContext::ExternalRunRequest>)
         {
             rStream << "ExternalRunRequest PL" << std::setw(3) << std::left << PipelineInt(msg.pipeline) << "\n";
@@ -296,6 +1021,11 @@ std::ostream& operator<<(std::ostream& rStream, TopExecWriteLog const& write)
         }
     };
 
+    if (exec.logMsg.dropped() != 0)
+    {
+        rStream << "(" << exec.logMsg.dropped() << " older messages dropped)\n";
+    }
+
     for (ExecContext::LogMsg_t const& msg : exec.logMsg)
     {
         std::visit(visitMsg, msg);
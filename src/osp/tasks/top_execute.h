@@ -26,14 +26,123 @@
 
 #include "execute.h"
 #include "tasks.h"
+#include "top_dispatch.h"
 #include "top_tasks.h"
+#include "top_trace.h"
+#include "top_worker_pool.h"
 
+#include <chrono>
+#include <cstdint>
+#include <functional>
 #include <vector>
 
 namespace osp
 {
 
-void top_run_blocking(Tasks const& tasks, TaskGraph const& graph, TopTaskDataVec_t& rTaskData, ArrayView<entt::any> topData, ExecContext& rExec, WorkerContext worker = {});
+/**
+ * @brief Run until there's no tasks left to run, on the calling thread
+ *
+ * @param worker [in] Passed to each task. Give it a WorkerLocal that outlives this call to keep
+ *                    metrics and log messages that tasks buffer into it.
+ */
+void top_run_blocking(Tasks const& tasks, TaskGraph const& graph, TopTaskDataVec_t& rTaskData, ArrayView<entt::any> topData, ExecContext& rExec, WorkerContext worker = {}, TopExecTrace *pTrace = nullptr);
+
+/**
+ * @brief Run until there's no tasks left to run, using arguments pre-resolved in rDispatch
+ *
+ * Same as the above, but doesn't allocate or rebuild argument lists per task.
+ *
+ * TopTask::m_cheap tasks queued at the same time run back to back, with a single exec_update
+ * after all of them.
+ *
+ * Also runs tasks with a TopTask::m_coroFunc. Each coroutine is resumed at most once per call,
+ * and only while the total time spent in coroutines is below TopTaskDispatch::coroBudget.
+ * Returns once only suspended coroutines are left to run; their pipelines keep running until
+ * they finish in a later call.
+ */
+void top_run_blocking(Tasks const& tasks, TaskGraph const& graph, TopTaskDataVec_t& rTaskData, TopTaskDispatch& rDispatch, ArrayView<entt::any> topData, ExecContext& rExec, WorkerContext worker = {}, TopExecTrace *pTrace = nullptr);
+
+/**
+ * @brief Run until there's no tasks left to run, handing queued tasks to a pool of worker threads
+ *
+ * The calling thread acts as the coordinator; it is the only thread that modifies rExec. Queued
+ * tasks are dispatched to rPool as long as they don't conflict with any task already in flight;
+ * multiple tasks can read the same TopData, but writes are exclusive. See TopTask::m_dataAccess.
+ *
+ * TopTaskAffinity::Main tasks run on the calling thread, and TopTaskAffinity::Dedicated tasks on
+ * the pool's dedicated workers. top_run_blocking runs everything on one thread and ignores this.
+ *
+ * TopTask::m_cheap tasks are not worth a trip through the pool; they run on the calling thread as
+ * soon as their data is free, all those queued at once in a single batch.
+ *
+ * If pTrace is given, task and stage timings are recorded into it. Same for top_run_blocking.
+ *
+ * Tasks on the calling thread use rPool.worker_local(0), tasks on workers use their own.
+ *
+ * Tasks with a TopTask::m_coroFunc are resumed on the calling thread, the same way as the
+ * TopTaskDispatch overload of top_run_blocking. Their TopData is only reserved while they run, not
+ * while suspended.
+ *
+ * @param coordinatorData [in] TopData that must only be touched by the calling thread, such as GL
+ *                             objects. Tasks using any of them run on the calling thread, while
+ *                             workers keep running other tasks.
+ * @param pDispatch       [ref] Holds suspended coroutines across calls, see
+ *                              TopRunInstance::pDispatch
+ */
+void top_run_parallel(Tasks const& tasks, TaskGraph const& graph, TopTaskDataVec_t& rTaskData, ArrayView<entt::any> topData, ExecContext& rExec, TopWorkerPool& rPool, TopExecTrace *pTrace = nullptr, ArrayView<TopDataId const> coordinatorData = {}, TopTaskDispatch *pDispatch = nullptr);
+
+/**
+ * @brief One independent set of Tasks, TopData, and ExecContext to run with top_run_parallel
+ */
+struct TopRunInstance
+{
+    Tasks const                 *pTasks     { nullptr };
+    TaskGraph const             *pGraph     { nullptr };
+    TopTaskDataVec_t            *pTaskData  { nullptr };
+    ArrayView<entt::any>        topData;
+    ExecContext                 *pExec      { nullptr };
+    TopExecTrace                *pTrace     { nullptr };
+    ArrayView<TopDataId const>  coordinatorData;
+
+    /**
+     * @brief Suspended coroutines and their arguments, required if any coroutine task is queued
+     *
+     * Must be built with top_dispatch_build. Each coroutine is resumed at most once per frame
+     * within TopTaskDispatch::coroBudget, where a frame ends each time the instance goes idle. Once
+     * only suspended coroutines are left, onIdle is called as usual, while their pipelines keep
+     * running.
+     */
+    TopTaskDispatch             *pDispatch  { nullptr };
+
+    /**
+     * @brief Called on the coordinator once the instance has nothing left to run
+     *
+     * None of the instance's tasks are in flight, so it may freely touch its TopData and signal
+     * or request pipelines to run. Return true to keep running the instance, which then must have
+     * tasks queued after the next exec_update. The instance is done if empty or if it returns
+     * false.
+     */
+    std::function<bool()>       onIdle;
+
+    /// Number of tasks run, added to by top_run_parallel
+    std::uint64_t               tasksRun    { 0 };
+
+    /// Total time spent in task functions on any thread, added to by top_run_parallel
+    std::chrono::steady_clock::duration taskTime { };
+};
+
+/**
+ * @brief Run several instances at once on a shared pool, until none have tasks left to run
+ *
+ * Each instance is scheduled as in the overload above, with its own TopData conflicts and
+ * coordinator-only data. Instances never conflict with each other. Ready tasks are handed to rPool
+ * one instance at a time in turn, starting from a different instance every pass, so workers are
+ * split between instances instead of going to whichever has the most ready tasks.
+ *
+ * Instances keep running independently; one doesn't wait for the others to finish a frame. Use
+ * TopRunInstance::onIdle to start the next frame of an instance as soon as it is done.
+ */
+void top_run_parallel(ArrayView<TopRunInstance> instances, TopWorkerPool& rPool);
 
 struct TopExecWriteState
 {
@@ -0,0 +1,102 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "top_memory.h"
+
+#include <mutex>
+#include <unordered_map>
+
+namespace osp
+{
+
+namespace
+{
+
+struct TopMemoryRegistry
+{
+    std::mutex                                              mutex;
+    std::unordered_map<entt::id_type, TopMemoryFunc_t>      funcs;
+};
+
+TopMemoryRegistry& registry() noexcept
+{
+    static TopMemoryRegistry s_registry;
+    return s_registry;
+}
+
+} // namespace
+
+void top_memory_register(entt::id_type const type, TopMemoryFunc_t const func)
+{
+    TopMemoryRegistry &rReg = registry();
+    std::lock_guard const lock{rReg.mutex};
+    rReg.funcs[type] = func;
+}
+
+std::optional<std::size_t> top_memory_bytes(entt::any const& data)
+{
+    TopMemoryFunc_t func = nullptr;
+    {
+        TopMemoryRegistry &rReg = registry();
+        std::lock_guard const lock{rReg.mutex};
+        auto const found = rReg.funcs.find(data.type().hash());
+        if (found == rReg.funcs.end())
+        {
+            return std::nullopt;
+        }
+        func = found->second;
+    }
+    return func(data);
+}
+
+TopMemory top_memory_bytes(ArrayView<entt::any const> const topData, ArrayView<TopDataId const> const ids)
+{
+    TopMemory out;
+    for (TopDataId const id : ids)
+    {
+        if (std::size_t(id) >= topData.size())
+        {
+            continue; // null or not yet reserved
+        }
+
+        entt::any const &data = topData[std::size_t(id)];
+        if ( ! bool(data) || data.type() == entt::type_id<Reserved>() )
+        {
+            continue;
+        }
+
+        if (std::optional<std::size_t> const bytes = top_memory_bytes(data))
+        {
+            out.bytes += *bytes;
+            ++out.tracked;
+        }
+        else
+        {
+            ++out.untracked;
+        }
+    }
+    return out;
+}
+
+} // namespace osp
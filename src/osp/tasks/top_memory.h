@@ -0,0 +1,88 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "top_worker.h"
+
+#include "../core/array_view.h"
+#include "../core/memory_usage.h"
+
+#include <entt/core/any.hpp>
+#include <entt/core/type_info.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace osp
+{
+
+using TopMemoryFunc_t = std::size_t (*)(entt::any const& data) noexcept;
+
+/**
+ * @brief Register how to count the bytes of TopData of a type, see MemoryUsage
+ *
+ * Called by top_emplace for every type that has a MemoryUsage specialization, so this rarely
+ * needs to be called directly.
+ */
+void top_memory_register(entt::id_type type, TopMemoryFunc_t func);
+
+template <HasMemoryUsage T>
+void top_memory_register()
+{
+    [[maybe_unused]] static bool const registered = ( top_memory_register(
+            entt::type_hash<T>::value(),
+            [] (entt::any const& data) noexcept -> std::size_t
+    {
+        T const &value = entt::any_cast<T const&>(data);
+        return sizeof(T) + MemoryUsage<T>::heap_bytes(value);
+    }), true );
+}
+
+/**
+ * @return Bytes held by a TopData including its heap memory, or nullopt if its type isn't
+ *         registered with top_memory_register
+ */
+[[nodiscard]] std::optional<std::size_t> top_memory_bytes(entt::any const& data);
+
+struct TopMemory
+{
+    std::size_t     bytes       {0};
+
+    /// TopData counted in bytes
+    std::uint32_t   tracked     {0};
+
+    /// Non-empty TopData of types without a MemoryUsage specialization, not counted in bytes
+    std::uint32_t   untracked   {0};
+};
+
+/**
+ * @brief Sum the bytes of several TopData, such as all of a Session's m_data
+ *
+ * Reads the TopData, so don't call while tasks that write them are running.
+ */
+[[nodiscard]] TopMemory top_memory_bytes(ArrayView<entt::any const> topData, ArrayView<TopDataId const> ids);
+
+} // namespace osp
@@ -32,6 +32,7 @@
 
 #include <entt/core/any.hpp>
 
+#include <algorithm>
 #include <cassert>
 #include <type_traits>
 #include <typeinfo>
@@ -156,5 +157,25 @@ struct SessionGroup
     TaskEdges               m_edges;
 };
 
+/**
+ * @brief Remove all edges that involve a Session's tasks
+ *
+ * Allows closing a single Session without clearing the edges of the rest of its SessionGroup.
+ * Rebuild the TaskGraph afterwards, see rebuild_exec_graph.
+ */
+inline void session_remove_edges(TaskEdges& rEdges, Session const& session)
+{
+    std::vector<TaskId> sorted = session.m_tasks;
+    std::sort(sorted.begin(), sorted.end());
+
+    auto const owned = [&sorted] (TaskId const task) noexcept -> bool
+    {
+        return std::binary_search(sorted.begin(), sorted.end(), task);
+    };
+
+    std::erase_if(rEdges.m_syncWith,       [&owned] (TplTaskPipelineStage const& edge) { return owned(edge.task); });
+    std::erase_if(rEdges.m_semaphoreEdges, [&owned] (TplTaskSemaphore const& edge)     { return owned(edge.task); });
+}
+
 
 } // namespace osp
@@ -25,21 +25,118 @@
 #pragma once
 
 #include "tasks.h"
+#include "top_coro.h"
 #include "top_worker.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <string>
 #include <vector>
 
 namespace osp
 {
 
+/**
+ * @brief How a TopTask accesses one of its TopData
+ *
+ * Ordered so that the stricter access compares greater.
+ */
+enum class TopDataAccess : uint8_t
+{
+    Read,
+    Write
+};
+
+struct TopDataUse
+{
+    TopDataId       id;
+    TopDataAccess   access;
+};
+
+/**
+ * @brief Which threads a TopTask may run on, see top_run_parallel
+ */
+enum class TopTaskAffinity : uint8_t
+{
+    /// Any worker thread, or the coordinator
+    Any,
+
+    /// Only the coordinator thread, such as for tasks making GL calls
+    Main,
+
+    /// Only a dedicated TopWorkerPool worker, for long tasks that would hold up short ones
+    Dedicated
+};
+
 struct TopTask
 {
-    std::string             m_debugName;
-    std::vector<TopDataId>  m_dataUsed;
-    TopTaskFunc_t           m_func              { nullptr };
+    std::string                 m_debugName;
+    std::vector<TopDataId>      m_dataUsed;
+
+    /// Access mode for each of m_dataUsed. Missing entries are assumed to be written to.
+    std::vector<TopDataAccess>  m_dataAccess;
+
+    TopTaskAffinity             m_affinity          { TopTaskAffinity::Any };
+
+    /// One-line bookkeeping, such as clearing a vector. Cheap tasks queued at the same time run
+    /// as one batch, see top_run_blocking and top_run_parallel.
+    bool                        m_cheap             { false };
+
+    /// Tasks that are ready to run at the same time start in order of highest priority first,
+    /// then lowest TaskId. Raise for tasks that unblock long chains of other tasks.
+    int                         m_priority          { 0 };
+
+    TopTaskFunc_t               m_func              { nullptr };
+
+    /// Used instead of m_func for long-running tasks that can be suspended across frames
+    TopTaskCoroFunc_t           m_coroFunc          { nullptr };
 };
 
 using TopTaskDataVec_t = KeyedVec<TaskId, TopTask>;
 
+[[nodiscard]] inline TopDataAccess top_data_access(TopTask const& task, std::size_t const index) noexcept
+{
+    return (index < task.m_dataAccess.size()) ? task.m_dataAccess[index] : TopDataAccess::Write;
+}
+
+/**
+ * @brief Raise access mode of one of a TopTask's TopData, never lowering it
+ */
+inline void top_merge_access(TopTask& rTask, std::size_t const index, TopDataAccess const access)
+{
+    if (rTask.m_dataAccess.size() <= index)
+    {
+        rTask.m_dataAccess.resize(index + 1, TopDataAccess::Read);
+    }
+    rTask.m_dataAccess[index] = std::max(rTask.m_dataAccess[index], access);
+}
+
+/**
+ * @brief Check if two TopTasks can't safely run at the same time
+ *
+ * @return True if both tasks use the same TopData and at least one of them writes to it
+ */
+[[nodiscard]] inline bool top_tasks_conflict(TopTask const& a, TopTask const& b) noexcept
+{
+    for (std::size_t i = 0; i < a.m_dataUsed.size(); ++i)
+    {
+        TopDataId const id = a.m_dataUsed[i];
+        if (id == lgrn::id_null<TopDataId>())
+        {
+            continue;
+        }
+
+        for (std::size_t j = 0; j < b.m_dataUsed.size(); ++j)
+        {
+            if (   b.m_dataUsed[j] == id
+                && (   top_data_access(a, i) == TopDataAccess::Write
+                    || top_data_access(b, j) == TopDataAccess::Write))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
 } // namespace osp
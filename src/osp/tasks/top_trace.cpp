@@ -0,0 +1,515 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "top_trace.h"
+
+#include <Corrade/Containers/ArrayViewStl.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <numeric>
+#include <ostream>
+#include <string_view>
+
+namespace osp
+{
+
+void top_trace_task(TopExecTrace& rTrace, TaskId const task, uint32_t const thread, TopExecTrace::TimePoint_t const start, TopExecTrace::TimePoint_t const end)
+{
+    if ( ! rTrace.full() )
+    {
+        rTrace.taskEvents.push_back({task, thread, start, end});
+    }
+}
+
+void top_trace_stages(TopExecTrace& rTrace, Tasks const& tasks, ExecContext const& exec)
+{
+    TopExecTrace::TimePoint_t const now = TopExecTrace::Clock_t::now();
+
+    rTrace.lastStage.resize(exec.plData.size(), lgrn::id_null<StageId>());
+
+    for (PipelineId const pipeline : tasks.m_pipelineIds)
+    {
+        StageId const stage = exec.plData[pipeline].stage;
+        if (rTrace.lastStage[pipeline] != stage)
+        {
+            rTrace.lastStage[pipeline] = stage;
+            if ( ! rTrace.full() )
+            {
+                rTrace.stageEvents.push_back({pipeline, stage, now});
+            }
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+namespace
+{
+
+struct JsonString
+{
+    std::string_view str;
+};
+
+std::ostream& operator<<(std::ostream& rStream, JsonString const& write)
+{
+    rStream << '"';
+    for (char const c : write.str)
+    {
+        switch (c)
+        {
+        case '"':  rStream << "\\\""; break;
+        case '\\': rStream << "\\\\"; break;
+        case '\n': rStream << "\\n";  break;
+        case '\t': rStream << "\\t";  break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+            {
+                rStream << ' ';
+            }
+            else
+            {
+                rStream << c;
+            }
+        }
+    }
+    return rStream << '"';
+}
+
+} // namespace
+
+std::ostream& operator<<(std::ostream& rStream, TopExecWriteChromeTrace const& write)
+{
+    auto const& [tasks, taskData, trace] = write;
+
+    // Process IDs used to group tracks in the viewer
+    static constexpr int sc_pidThreads   = 0;
+    static constexpr int sc_pidPipelines = 1;
+
+    auto const micros = [origin = trace.origin] (TopExecTrace::TimePoint_t const time) -> double
+    {
+        return std::chrono::duration<double, std::micro>(time - origin).count();
+    };
+
+    auto const stage_name = [&tasks=tasks] (PipelineId const pl, StageId const stg) -> std::string_view
+    {
+        PipelineInfo const& info = tasks.m_pipelineInfo[pl];
+        if (stg == lgrn::id_null<StageId>() || info.stageType == lgrn::id_null<PipelineInfo::stage_type_t>())
+        {
+            return "NULL";
+        }
+        auto const stageNames = ArrayView<std::string_view const>{PipelineInfo::sm_stageNames[info.stageType]};
+        return (std::size_t(stg) < stageNames.size()) ? stageNames[std::size_t(stg)] : "?";
+    };
+
+    bool first = true;
+    auto const next = [&rStream, &first] () -> std::ostream&
+    {
+        rStream << (first ? "\n" : ",\n");
+        first = false;
+        return rStream;
+    };
+
+    rStream << std::fixed << std::setprecision(3);
+    rStream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    next() << R"({"name":"process_name","ph":"M","pid":)" << sc_pidThreads   << R"(,"args":{"name":"Threads"}})";
+    next() << R"({"name":"process_name","ph":"M","pid":)" << sc_pidPipelines << R"(,"args":{"name":"Pipelines"}})";
+
+    // Tasks
+
+    uint32_t maxThread = 0;
+    for (TopExecTrace::TaskEvent const& event : trace.taskEvents)
+    {
+        maxThread = std::max(maxThread, event.thread);
+
+        std::string_view const name = (std::size_t(event.task) < taskData.size())
+                                    ? std::string_view{taskData[event.task].m_debugName}
+                                    : std::string_view{};
+
+        next() << R"({"name":)" << JsonString{name.empty() ? "untitled" : name}
+               << R"(,"cat":"task","ph":"X","pid":)" << sc_pidThreads
+               << R"(,"tid":)" << event.thread
+               << R"(,"ts":)"  << micros(event.start)
+               << R"(,"dur":)" << micros(event.end) - micros(event.start)
+               << R"(,"args":{"task":)" << TaskInt(event.task) << "}}";
+    }
+
+    for (uint32_t thread = 0; thread <= maxThread; ++thread)
+    {
+        next() << R"({"name":"thread_name","ph":"M","pid":)" << sc_pidThreads << R"(,"tid":)" << thread
+               << R"(,"args":{"name":)"
+               << JsonString{(thread == TopExecTrace::smc_coordinatorThread) ? "coordinator" : "worker"}
+               << "}}";
+    }
+
+    // Pipeline stages, each shown as a slice lasting until the pipeline's next stage change
+
+    KeyedVec<PipelineId, std::size_t> lastEvent;
+    lastEvent.resize(tasks.m_pipelineIds.capacity(), trace.stageEvents.size());
+
+    auto const write_stage = [&] (TopExecTrace::StageEvent const& event, TopExecTrace::TimePoint_t const end)
+    {
+        if (event.stage == lgrn::id_null<StageId>())
+        {
+            return; // not running
+        }
+
+        next() << R"({"name":)" << JsonString{stage_name(event.pipeline, event.stage)}
+               << R"(,"cat":"stage","ph":"X","pid":)" << sc_pidPipelines
+               << R"(,"tid":)" << PipelineInt(event.pipeline)
+               << R"(,"ts":)"  << micros(event.time)
+               << R"(,"dur":)" << micros(end) - micros(event.time) << "}";
+    };
+
+    TopExecTrace::TimePoint_t lastTime = trace.origin;
+    for (TopExecTrace::TaskEvent const& event : trace.taskEvents)
+    {
+        lastTime = std::max(lastTime, event.end);
+    }
+
+    for (std::size_t i = 0; i < trace.stageEvents.size(); ++i)
+    {
+        TopExecTrace::StageEvent const& event = trace.stageEvents[i];
+        lastTime = std::max(lastTime, event.time);
+
+        std::size_t &rLast = lastEvent[event.pipeline];
+        if (rLast != trace.stageEvents.size())
+        {
+            write_stage(trace.stageEvents[rLast], event.time);
+        }
+        rLast = i;
+    }
+
+    for (PipelineId const pipeline : tasks.m_pipelineIds)
+    {
+        if (lastEvent[pipeline] != trace.stageEvents.size())
+        {
+            write_stage(trace.stageEvents[lastEvent[pipeline]], lastTime);
+        }
+
+        PipelineInfo const& info = tasks.m_pipelineInfo[pipeline];
+        next() << R"({"name":"thread_name","ph":"M","pid":)" << sc_pidPipelines << R"(,"tid":)" << PipelineInt(pipeline)
+               << R"(,"args":{"name":)" << JsonString{info.name.empty() ? "untitled" : info.name} << "}}";
+    }
+
+    rStream << "\n]}\n";
+
+    return rStream;
+}
+
+//-----------------------------------------------------------------------------
+
+TopTraceCriticalPath top_trace_critical_path(Tasks const& tasks, TaskGraph const& graph, TopExecTrace const& trace, std::size_t const firstFrame)
+{
+    TopTraceCriticalPath out;
+
+    std::size_t const maxTasks      = tasks.m_taskIds.capacity();
+    std::size_t const maxPipelines  = tasks.m_pipelineIds.capacity();
+
+    out.taskPathMs.resize(maxTasks, 0.0);
+    out.taskWorkMs.resize(maxTasks, 0.0);
+
+    // Tasks that advance each pipeline
+    KeyedVec<PipelineId, std::vector<TaskId>> advancers;
+    advancers.resize(maxPipelines);
+    for (TaskId const task : tasks.m_taskIds)
+    {
+        if (std::size_t(task) >= tasks.m_taskRunOn.size())
+        {
+            continue;
+        }
+        PipelineId const runOn = tasks.m_taskRunOn[task].pipeline;
+        if (runOn != lgrn::id_null<PipelineId>())
+        {
+            advancers[runOn].push_back(task);
+        }
+        for (AnyStageId const& reqTaskAnystg : fanout_view(graph.taskToFirstRevStgreqtask, graph.revStgreqtaskToStage, task))
+        {
+            advancers[graph.anystgToPipeline[reqTaskAnystg]].push_back(task);
+        }
+    }
+
+    // Pipelines each task waits on
+    KeyedVec<TaskId, std::vector<PipelineId>> waitsOn;
+    waitsOn.resize(maxTasks);
+    for (TaskId const task : tasks.m_taskIds)
+    {
+        if (std::size_t(task) >= tasks.m_taskRunOn.size())
+        {
+            continue;
+        }
+        std::vector<PipelineId> &rWaits = waitsOn[task];
+        for (PipelineId pl = tasks.m_taskRunOn[task].pipeline;
+             pl != lgrn::id_null<PipelineId>();
+             pl = tasks.m_pipelineParents[pl])
+        {
+            rWaits.push_back(pl);
+        }
+        for (TaskRequiresStage const& req : fanout_view(graph.taskToFirstTaskreqstg, graph.taskreqstgData, task))
+        {
+            rWaits.push_back(req.reqPipeline);
+        }
+        std::sort(rWaits.begin(), rWaits.end());
+        rWaits.erase(std::unique(rWaits.begin(), rWaits.end()), rWaits.end());
+    }
+
+    auto const millis = [] (TopExecTrace::TimePoint_t const a, TopExecTrace::TimePoint_t const b) -> double
+    {
+        return std::chrono::duration<double, std::milli>(b - a).count();
+    };
+
+    // Finished instances of a task within the current frame, in order of when they ended.
+    // best is the longest path ending at or before this instance, and bestEvent is where it ends
+    struct Finished
+    {
+        TopExecTrace::TimePoint_t   end;
+        double                      best;
+        std::size_t                 bestEvent;
+    };
+    KeyedVec<TaskId, std::vector<Finished>> finished;
+    finished.resize(maxTasks);
+
+    std::vector<std::size_t>    order;
+    std::vector<double>         pathEnd;
+    std::vector<std::size_t>    pred;
+
+    std::size_t const noEvent = trace.taskEvents.size();
+
+    auto const do_frame = [&] (std::size_t const first, std::size_t const last)
+    {
+        if (first == last)
+        {
+            return;
+        }
+
+        // Events are recorded when tasks end, so sort by start
+        order.resize(last - first);
+        std::iota(order.begin(), order.end(), first);
+        std::sort(order.begin(), order.end(), [&trace] (std::size_t const a, std::size_t const b)
+        {
+            return trace.taskEvents[a].start < trace.taskEvents[b].start;
+        });
+
+        pathEnd .assign(last - first, 0.0);
+        pred    .assign(last - first, noEvent);
+
+        TopTraceCriticalPath::Frame &rFrame = out.frames.emplace_back();
+        rFrame.taskCount = uint32_t(last - first);
+
+        TopExecTrace::TimePoint_t frameStart = trace.taskEvents[order.front()].start;
+        TopExecTrace::TimePoint_t frameEnd   = frameStart;
+        std::size_t longest = noEvent;
+
+        for (std::size_t const i : order)
+        {
+            TopExecTrace::TaskEvent const &event = trace.taskEvents[i];
+            double const duration = millis(event.start, event.end);
+
+            rFrame.workMs += duration;
+            frameEnd = std::max(frameEnd, event.end);
+
+            if (std::size_t(event.task) >= maxTasks)
+            {
+                continue;
+            }
+
+            out.taskWorkMs[event.task] += duration;
+
+            double      best        = 0.0;
+            std::size_t bestEvent   = noEvent;
+            for (PipelineId const pipeline : waitsOn[event.task])
+            {
+                for (TaskId const candidate : advancers[pipeline])
+                {
+                    std::vector<Finished> const &rDone = finished[candidate];
+                    auto const it = std::upper_bound(rDone.begin(), rDone.end(), event.start,
+                            [] (TopExecTrace::TimePoint_t const time, Finished const& done)
+                    {
+                        return time < done.end;
+                    });
+                    if (it != rDone.begin() && std::prev(it)->best > best)
+                    {
+                        best        = std::prev(it)->best;
+                        bestEvent   = std::prev(it)->bestEvent;
+                    }
+                }
+            }
+
+            std::size_t const local = i - first;
+            pathEnd[local]  = best + duration;
+            pred[local]     = bestEvent;
+
+            // Instances of the same task don't overlap, so this stays sorted by end
+            std::vector<Finished> &rOwn = finished[event.task];
+            bool const isBest = rOwn.empty() || pathEnd[local] > rOwn.back().best;
+            rOwn.push_back({
+                .end        = event.end,
+                .best       = isBest ? pathEnd[local] : rOwn.back().best,
+                .bestEvent  = isBest ? i              : rOwn.back().bestEvent });
+
+            if (longest == noEvent || pathEnd[local] > pathEnd[longest - first])
+            {
+                longest = i;
+            }
+        }
+
+        rFrame.wallMs = millis(frameStart, frameEnd);
+
+        if (longest != noEvent)
+        {
+            rFrame.pathMs = pathEnd[longest - first];
+            for (std::size_t i = longest; i != noEvent; i = pred[i - first])
+            {
+                TopExecTrace::TaskEvent const &event = trace.taskEvents[i];
+                out.taskPathMs[event.task] += millis(event.start, event.end);
+            }
+        }
+
+        for (std::size_t i = first; i < last; ++i)
+        {
+            if (std::size_t(trace.taskEvents[i].task) < maxTasks)
+            {
+                finished[trace.taskEvents[i].task].clear();
+            }
+        }
+    };
+
+    if (trace.frameStarts.empty())
+    {
+        do_frame(0, trace.taskEvents.size());
+    }
+    else
+    {
+        for (std::size_t i = firstFrame; i < trace.frameStarts.size(); ++i)
+        {
+            std::size_t const last = (i + 1 < trace.frameStarts.size()) ? trace.frameStarts[i + 1] : trace.taskEvents.size();
+            do_frame(std::min(trace.frameStarts[i], last), last);
+        }
+    }
+
+    return out;
+}
+
+std::ostream& operator<<(std::ostream& rStream, TopExecWriteCriticalPath const& write)
+{
+    auto const& [taskData, path, taskGroup, groupNames, topTasks] = write;
+
+    double      workMs          = 0.0;
+    double      pathMs          = 0.0;
+    double      wallMs          = 0.0;
+    double      parallelismSum  = 0.0;
+    std::size_t parallelFrames  = 0;
+    for (TopTraceCriticalPath::Frame const& frame : path.frames)
+    {
+        workMs += frame.workMs;
+        pathMs += frame.pathMs;
+        wallMs += frame.wallMs;
+        if (frame.pathMs > 0.0)
+        {
+            parallelismSum += frame.workMs / frame.pathMs;
+            ++ parallelFrames;
+        }
+    }
+
+    double const frameCount = std::max<double>(double(path.frames.size()), 1.0);
+
+    rStream << std::fixed << std::setprecision(3);
+    rStream << "Critical path over " << path.frames.size() << " frames\n"
+            << "  Total work:       " << workMs / frameCount << " ms/frame\n"
+            << "  Critical path:    " << pathMs / frameCount << " ms/frame\n"
+            << "  Wall time:        " << wallMs / frameCount << " ms/frame\n"
+            << "  Parallelism:      " << ((parallelFrames != 0) ? parallelismSum / double(parallelFrames) : 0.0) << " average per frame\n";
+
+    // Groups sorted by time on the critical path. Last group is for tasks without one
+    std::size_t const otherGroup = groupNames.size();
+    std::vector<double> groupPathMs(otherGroup + 1, 0.0);
+    std::vector<double> groupWorkMs(otherGroup + 1, 0.0);
+    std::vector<std::vector<TaskId>> groupTasks(otherGroup + 1);
+
+    auto const group_of = [&taskGroup = taskGroup, otherGroup] (TaskId const task) -> std::size_t
+    {
+        return (std::size_t(task) < taskGroup.size() && taskGroup[task] < otherGroup)
+             ? std::size_t(taskGroup[task]) : otherGroup;
+    };
+
+    for (std::size_t i = 0; i < path.taskWorkMs.size(); ++i)
+    {
+        auto const task = TaskId(i);
+        if (path.taskWorkMs[task] == 0.0)
+        {
+            continue;
+        }
+        std::size_t const group = group_of(task);
+        groupPathMs[group] += path.taskPathMs[task];
+        groupWorkMs[group] += path.taskWorkMs[task];
+        if (path.taskPathMs[task] != 0.0)
+        {
+            groupTasks[group].push_back(task);
+        }
+    }
+
+    std::vector<std::size_t> groups(otherGroup + 1);
+    std::iota(groups.begin(), groups.end(), 0);
+    std::stable_sort(groups.begin(), groups.end(), [&groupPathMs] (std::size_t const a, std::size_t const b)
+    {
+        return groupPathMs[a] > groupPathMs[b];
+    });
+
+    rStream << "Critical path by group (ms/frame on path, ms/frame of work):\n";
+    for (std::size_t const group : groups)
+    {
+        if (groupWorkMs[group] == 0.0)
+        {
+            continue;
+        }
+
+        std::string_view const name = (group == otherGroup) ? std::string_view{"other"} : std::string_view{groupNames[group]};
+        rStream << "  " << name << ": "
+                << groupPathMs[group] / frameCount << " on path ("
+                << ((pathMs != 0.0) ? 100.0 * groupPathMs[group] / pathMs : 0.0) << "%), "
+                << groupWorkMs[group] / frameCount << " work\n";
+
+        std::vector<TaskId> &rTasks = groupTasks[group];
+        std::stable_sort(rTasks.begin(), rTasks.end(), [&path = path] (TaskId const a, TaskId const b)
+        {
+            return path.taskPathMs[a] > path.taskPathMs[b];
+        });
+
+        for (std::size_t i = 0; i < std::min(topTasks, rTasks.size()); ++i)
+        {
+            TaskId const task = rTasks[i];
+            std::string_view const taskName = (std::size_t(task) < taskData.size())
+                                            ? std::string_view{taskData[task].m_debugName}
+                                            : std::string_view{};
+            rStream << "    " << path.taskPathMs[task] / frameCount << "  "
+                    << (taskName.empty() ? "untitled" : taskName) << " (TaskId " << TaskInt(task) << ")\n";
+        }
+    }
+
+    return rStream;
+}
+
+} // namespace osp
@@ -0,0 +1,184 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "execute.h"
+#include "tasks.h"
+#include "top_tasks.h"
+
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace osp
+{
+
+/**
+ * @brief Start and end times of TopTasks and pipeline stage changes, for profiling
+ *
+ * Pass to top_run_blocking or top_run_parallel to record into, then write out with
+ * TopExecWriteChromeTrace. Recording stops once maxEvents is reached.
+ */
+struct TopExecTrace
+{
+    using Clock_t       = std::chrono::steady_clock;
+    using TimePoint_t   = Clock_t::time_point;
+
+    /// Thread index used for the coordinator (or the single thread of top_run_blocking)
+    static constexpr uint32_t smc_coordinatorThread = 0;
+
+    struct TaskEvent
+    {
+        TaskId          task;
+        uint32_t        thread;     ///< 0 for coordinator, 1+ for TopWorkerPool workers
+        TimePoint_t     start;
+        TimePoint_t     end;
+    };
+
+    struct StageEvent
+    {
+        PipelineId      pipeline;
+        StageId         stage;
+        TimePoint_t     time;
+    };
+
+    [[nodiscard]] bool full() const noexcept
+    {
+        return taskEvents.size() + stageEvents.size() >= maxEvents;
+    }
+
+    TimePoint_t                     origin      { Clock_t::now() };
+    std::size_t                     maxEvents   { 1u << 20u };
+
+    std::vector<TaskEvent>          taskEvents;
+    std::vector<StageEvent>         stageEvents;
+
+    /// Index of the first TaskEvent of each frame, see top_trace_frame
+    std::vector<std::size_t>        frameStarts;
+
+    /// Stages seen by the last top_trace_stages call
+    KeyedVec<PipelineId, StageId>   lastStage;
+};
+
+void top_trace_task(TopExecTrace& rTrace, TaskId task, uint32_t thread, TopExecTrace::TimePoint_t start, TopExecTrace::TimePoint_t end);
+
+/**
+ * @brief Record stage changes of all pipelines since the last call
+ */
+void top_trace_stages(TopExecTrace& rTrace, Tasks const& tasks, ExecContext const& exec);
+
+/**
+ * @brief Mark the start of a frame, such as one wait() of an executor
+ *
+ * Task events recorded until the next call belong to this frame, see top_trace_critical_path.
+ */
+inline void top_trace_frame(TopExecTrace& rTrace)
+{
+    rTrace.frameStarts.push_back(rTrace.taskEvents.size());
+}
+
+/**
+ * @brief Write a TopExecTrace as Chrome trace-event JSON, which can be opened in Perfetto or
+ *        chrome://tracing
+ *
+ * Tasks are shown per-thread using their m_debugName. Each pipeline gets its own track, with a
+ * slice for the time spent in each stage.
+ */
+struct TopExecWriteChromeTrace
+{
+    Tasks const             &tasks;
+    TopTaskDataVec_t const  &taskData;
+    TopExecTrace const      &trace;
+};
+
+std::ostream& operator<<(std::ostream& rStream, TopExecWriteChromeTrace const& write);
+
+//-----------------------------------------------------------------------------
+
+/**
+ * @brief Critical path and available parallelism of each frame of a TopExecTrace
+ *
+ * The critical path of a frame is the longest chain of recorded tasks that each had to wait for
+ * the previous one. That is, the frame's run time if there were infinite threads and no
+ * scheduling overhead. Total work divided by the critical path is the average parallelism
+ * available to use.
+ */
+struct TopTraceCriticalPath
+{
+    struct Frame
+    {
+        double      workMs  { 0.0 };    ///< Sum of all task durations
+        double      pathMs  { 0.0 };    ///< Sum of task durations along the critical path
+        double      wallMs  { 0.0 };    ///< First task start to last task end
+        uint32_t    taskCount{ 0 };
+    };
+
+    std::vector<Frame>          frames;
+
+    /// Time each task spent on a critical path, summed over all frames
+    KeyedVec<TaskId, double>    taskPathMs;
+
+    /// Time each task ran for, summed over all frames
+    KeyedVec<TaskId, double>    taskWorkMs;
+};
+
+/**
+ * @brief Find the critical path of each frame of a trace
+ *
+ * Dependencies are taken from the graph: a task can wait for earlier tasks that advance a
+ * pipeline it waits on. That is its run-on pipeline and that pipeline's parents, and the
+ * pipelines of its TaskRequiresStage. A task advances the pipeline it runs on, and pipelines with
+ * stages that require it. Of the candidates that ended before a task started, the one with the
+ * longest path leading up to it is picked.
+ *
+ * Frames are split by TopExecTrace::frameStarts. The whole trace is one frame if there are none.
+ * Frames before firstFrame are skipped, for traces that span graphs that were rebuilt.
+ */
+[[nodiscard]] TopTraceCriticalPath top_trace_critical_path(Tasks const& tasks, TaskGraph const& graph, TopExecTrace const& trace, std::size_t firstFrame = 0);
+
+/**
+ * @brief Write a readable summary of a TopTraceCriticalPath
+ *
+ * Tasks are grouped by taskGroup (usually the Session they belong to), and groups are listed
+ * in order of time spent on the critical path, each with their top tasks.
+ */
+struct TopExecWriteCriticalPath
+{
+    TopTaskDataVec_t const          &taskData;
+    TopTraceCriticalPath const      &path;
+
+    /// Group index of each task, tasks that are out of range or ~0 are shown under "other"
+    KeyedVec<TaskId, uint32_t> const &taskGroup;
+    ArrayView<std::string const>    groupNames;
+
+    /// Number of tasks to list per group
+    std::size_t                     topTasks    { 5 };
+};
+
+std::ostream& operator<<(std::ostream& rStream, TopExecWriteCriticalPath const& write);
+
+} // namespace osp
@@ -26,6 +26,7 @@
 
 #include "tasks.h"
 #include "builder.h"
+#include "top_memory.h"
 #include "top_tasks.h"
 #include "top_worker.h"
 
@@ -33,14 +34,27 @@
 
 #include <Corrade/Containers/ArrayViewStl.h>
 
+#include <array>
 #include <cassert>
 #include <functional>
 #include <type_traits>
 #include <utility>
 
+/**
+ * If enabled, functions wrapped with wrap_args cast their TopData arguments without type checks.
+ * Enabled by default for release builds.
+ */
+#ifndef OSP_TOP_TASK_UNCHECKED_ARGS
+    #ifdef NDEBUG
+        #define OSP_TOP_TASK_UNCHECKED_ARGS 1
+    #else
+        #define OSP_TOP_TASK_UNCHECKED_ARGS 0
+    #endif
+#endif
+
 namespace osp
 {
-    
+
 /**
  * @brief Reserves the first available space in topData after the indicated index.
  * 
@@ -97,6 +111,8 @@ TopDataId top_reserve(
 /**
  * @brief Constructs an object of type T at the indicated index.
  *
+ * Types with a MemoryUsage specialization are registered for top_memory_bytes.
+ *
  * @return A reference to the newly constructed value
  */
 template <typename T, typename ... ARGS_T>
@@ -104,6 +120,10 @@ T& top_emplace(ArrayView<entt::any> const topData, TopDataId id, ARGS_T&& ... ar
 {
     entt::any &rData = topData[std::size_t(id)];
     rData.emplace<T>(std::forward<ARGS_T>(args) ...);
+    if constexpr (HasMemoryUsage<T>)
+    {
+        top_memory_register<T>();
+    }
     return entt::any_cast<T&>(rData);
 }
 
@@ -144,7 +164,13 @@ struct wrap_args_trait
         else
         {
             LGRN_ASSERTMV(topData.size() > argIndex, "Task function has more arguments than TopDataIds provided", topData.size(), argIndex);
+#if OSP_TOP_TASK_UNCHECKED_ARGS
+            // Skip type checks, topData[argIndex] is expected to always be a reference
+            using Value_t = std::remove_reference_t<T>;
+            return *static_cast<Value_t*>(const_cast<void*>(std::as_const(topData[argIndex]).data()));
+#else
             return entt::any_cast<T&>(topData[argIndex]);
+#endif
         }
     }
 
@@ -168,12 +194,39 @@ struct wrap_args_trait
         }
     }
 
+    // Only creates the coroutine. Its arguments are already cast, so topData isn't needed later.
+    template<typename ... ARGS_T>
+    static TopCoro wrapped_coro([[maybe_unused]] WorkerContext ctx, ArrayView<entt::any> topData) noexcept
+    {
+        return cast_args<ARGS_T ...>(topData, ctx, std::make_index_sequence<sizeof...(ARGS_T)>{});
+    }
+
+    template<typename ... ARGS_T>
+    static constexpr TopTaskCoroFunc_t unpack_coro([[maybe_unused]] TopCoro(*func)(ARGS_T...))
+    {
+        return &wrapped_coro<ARGS_T ...>;
+    }
+
     // Extract arguments and return type from function pointer
     template<typename RETURN_T, typename ... ARGS_T>
     static constexpr TopTaskFunc_t unpack([[maybe_unused]] RETURN_T(*func)(ARGS_T...))
     {
         return &wrapped_task<RETURN_T, ARGS_T ...>;
     }
+
+    // Only mutable references can write. Values and const references are copied or only read.
+    template<typename T>
+    static constexpr TopDataAccess arg_access() noexcept
+    {
+        return (std::is_lvalue_reference_v<T> && ! std::is_const_v<std::remove_reference_t<T>>)
+             ? TopDataAccess::Write : TopDataAccess::Read;
+    }
+
+    template<typename RETURN_T, typename ... ARGS_T>
+    static constexpr std::array<TopDataAccess, sizeof...(ARGS_T)> unpack_access([[maybe_unused]] RETURN_T(*func)(ARGS_T...)) noexcept
+    {
+        return { arg_access<ARGS_T>() ... };
+    }
 };
 
 /**
@@ -204,6 +257,32 @@ constexpr TopTaskFunc_t wrap_args(FUNC_T funcArg)
     return wrap_args_trait<FUNC_T>::unpack(functionPtr);
 }
 
+/**
+ * @brief Wrap a coroutine lambda with arbitrary arguments into a TopTaskCoroFunc_t
+ *
+ * Same as wrap_args, but for lambdas that return TopCoro. Arguments are cast once when the
+ * coroutine is created, and stay referenced by the coroutine until it finishes.
+ */
+template<typename FUNC_T>
+constexpr TopTaskCoroFunc_t wrap_coro_args(FUNC_T funcArg)
+{
+    static_assert ( ! std::is_function_v<FUNC_T>, "Support for function pointers not yet implemented");
+
+    return wrap_args_trait<FUNC_T>::unpack_coro(+funcArg);
+}
+
+/**
+ * @brief Infer how a function given to wrap_args accesses each of its TopData
+ *
+ * Parameters that are mutable references are considered writes, everything else are reads. One
+ * element is returned per parameter, matching the TopDataIds passed to the task.
+ */
+template<typename FUNC_T>
+constexpr auto wrap_args_access(FUNC_T funcArg) noexcept
+{
+    return wrap_args_trait<FUNC_T>::unpack_access(+funcArg);
+}
+
 //-----------------------------------------------------------------------------
 
 struct TopTaskBuilder;
@@ -240,11 +319,19 @@ struct TopTaskTaskRef : public TaskRefBase<TopTaskBuilderTraits>
 {
     inline TopTaskTaskRef& name(std::string_view debugName);
     inline TopTaskTaskRef& args(std::initializer_list<TopDataId> dataUsed);
+    inline TopTaskTaskRef& args(std::initializer_list<TopDataUse> dataUsed);
+    inline TopTaskTaskRef& affinity(TopTaskAffinity value);
+    inline TopTaskTaskRef& cheap(bool value = true);
+    inline TopTaskTaskRef& priority(int value);
 
     template<typename FUNC_T>
     TopTaskTaskRef& func(FUNC_T&& funcArg);
     inline TopTaskTaskRef& func_raw(TopTaskFunc_t func);
 
+    template<typename FUNC_T>
+    TopTaskTaskRef& coro(FUNC_T&& funcArg);
+    inline TopTaskTaskRef& coro_raw(TopTaskCoroFunc_t func);
+
     inline TopTaskTaskRef& important_deps_count(int value);
 
     template<typename CONTAINER_T>
@@ -265,11 +352,54 @@ TopTaskTaskRef& TopTaskTaskRef::args(std::initializer_list<TopDataId> dataUsed)
     return *this;
 }
 
+TopTaskTaskRef& TopTaskTaskRef::args(std::initializer_list<TopDataUse> dataUsed)
+{
+    m_rBuilder.m_rData.resize(m_rBuilder.m_rTasks.m_taskIds.capacity());
+    TopTask &rTask = m_rBuilder.m_rData[m_taskId];
+
+    rTask.m_dataUsed.clear();
+    for (TopDataUse const& use : dataUsed)
+    {
+        top_merge_access(rTask, rTask.m_dataUsed.size(), use.access);
+        rTask.m_dataUsed.push_back(use.id);
+    }
+    return *this;
+}
+
+TopTaskTaskRef& TopTaskTaskRef::affinity(TopTaskAffinity const value)
+{
+    m_rBuilder.m_rData.resize(m_rBuilder.m_rTasks.m_taskIds.capacity());
+    m_rBuilder.m_rData[m_taskId].m_affinity = value;
+    return *this;
+}
+
+TopTaskTaskRef& TopTaskTaskRef::cheap(bool const value)
+{
+    m_rBuilder.m_rData.resize(m_rBuilder.m_rTasks.m_taskIds.capacity());
+    m_rBuilder.m_rData[m_taskId].m_cheap = value;
+    return *this;
+}
+
+TopTaskTaskRef& TopTaskTaskRef::priority(int const value)
+{
+    m_rBuilder.m_rData.resize(m_rBuilder.m_rTasks.m_taskIds.capacity());
+    m_rBuilder.m_rData[m_taskId].m_priority = value;
+    return *this;
+}
+
 template<typename FUNC_T>
 TopTaskTaskRef& TopTaskTaskRef::func(FUNC_T&& funcArg)
 {
     m_rBuilder.m_rData.resize(m_rBuilder.m_rTasks.m_taskIds.capacity());
-    m_rBuilder.m_rData[m_taskId].m_func = wrap_args(funcArg);
+    TopTask &rTask = m_rBuilder.m_rData[m_taskId];
+
+    rTask.m_func = wrap_args(funcArg);
+
+    auto const access = wrap_args_access(funcArg);
+    for (std::size_t i = 0; i < access.size(); ++i)
+    {
+        top_merge_access(rTask, i, access[i]);
+    }
     return *this;
 }
 
@@ -280,6 +410,29 @@ TopTaskTaskRef& TopTaskTaskRef::func_raw(TopTaskFunc_t func)
     return *this;
 }
 
+template<typename FUNC_T>
+TopTaskTaskRef& TopTaskTaskRef::coro(FUNC_T&& funcArg)
+{
+    m_rBuilder.m_rData.resize(m_rBuilder.m_rTasks.m_taskIds.capacity());
+    TopTask &rTask = m_rBuilder.m_rData[m_taskId];
+
+    rTask.m_coroFunc = wrap_coro_args(funcArg);
+
+    auto const access = wrap_args_access(funcArg);
+    for (std::size_t i = 0; i < access.size(); ++i)
+    {
+        top_merge_access(rTask, i, access[i]);
+    }
+    return *this;
+}
+
+TopTaskTaskRef& TopTaskTaskRef::coro_raw(TopTaskCoroFunc_t func)
+{
+    m_rBuilder.m_rData.resize(m_rBuilder.m_rTasks.m_taskIds.capacity());
+    m_rBuilder.m_rData[m_taskId].m_coroFunc = func;
+    return *this;
+}
+
 //TopTaskRef& TopTaskRef::aware_of_dirty_depends(bool value)
 //{
 //    m_rBuilder.m_rData.resize(m_rBuilder.m_rTasks.m_taskIds.capacity());
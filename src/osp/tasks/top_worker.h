@@ -27,6 +27,8 @@
 #include "worker.h"
 
 #include "../core/array_view.h"
+#include "../core/frame_arena.h"
+#include "../core/parallel_for.h"
 
 #include <entt/core/fwd.hpp>
 
@@ -34,6 +36,10 @@
 
 #include <array>
 #include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 namespace osp
 {
@@ -43,9 +49,78 @@ using TopDataIds_t  = std::initializer_list<TopDataId>;
 
 struct Reserved {};
 
+/**
+ * @brief Metric recorded by a task, buffered until the executor hands it to a Metrics registry
+ */
+struct WorkerMetric
+{
+    enum class EKind : std::uint8_t { Counter, Gauge, Histogram };
+
+    std::string_view    name;   ///< Must outlive the buffer, such as a string literal
+    double              value;
+    EKind               kind;
+};
+
+/**
+ * @brief State owned by a single thread running tasks
+ *
+ * Only tasks running on that thread touch it, so nothing here needs locking. The executor
+ * resets scratch after each task, and takes metrics and logMsgs once no tasks are running.
+ */
+struct WorkerLocal
+{
+    /// Temporary memory for the task currently running, reset once it returns. All workers
+    /// share the "worker_scratch" MemoryCategory
+    FrameArena                  scratch{0, &memory_category("worker_scratch")};
+
+    std::vector<WorkerMetric>   metrics;
+    std::vector<std::string>    logMsgs;
+};
+
+/**
+ * @brief Passed to each TopTask function, giving access to the thread it runs on
+ */
 struct WorkerContext
 {
-    //DependOnDirty_t m_dependOnDirty;
+    /**
+     * @brief Allocate temporary memory, only valid until the task returns
+     *
+     * Coroutine tasks must not keep allocations across a suspend.
+     */
+    template <typename T>
+    [[nodiscard]] ArrayView<T> scratch(std::size_t const count) const
+    {
+        return m_pLocal->scratch.allocate<T>(count);
+    }
+
+    void counter_add(std::string_view const name, std::int64_t const amount = 1) const
+    {
+        m_pLocal->metrics.push_back({name, double(amount), WorkerMetric::EKind::Counter});
+    }
+
+    void gauge_set(std::string_view const name, double const value) const
+    {
+        m_pLocal->metrics.push_back({name, value, WorkerMetric::EKind::Gauge});
+    }
+
+    void histogram_record(std::string_view const name, double const value) const
+    {
+        m_pLocal->metrics.push_back({name, value, WorkerMetric::EKind::Histogram});
+    }
+
+    void log(std::string msg) const
+    {
+        m_pLocal->logMsgs.push_back(std::move(msg));
+    }
+
+    WorkerLocal     *m_pLocal       {nullptr};
+
+    /// 0 for the coordinator or calling thread, 1+ for TopWorkerPool workers. Same as TopExecTrace.
+    uint32_t        m_workerIndex   {0};
+
+    /// Splits loops of the task across idle workers. Runs them on this thread for executors
+    /// without workers to spare.
+    ParallelFor     m_parallelFor;
 };
 
 using TopTaskFunc_t = TaskActions(*)(WorkerContext, ArrayView<entt::any>) noexcept;
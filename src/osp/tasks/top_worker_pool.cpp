@@ -0,0 +1,319 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "top_worker_pool.h"
+
+#include "../util/profiling.h"
+
+#include <longeron/utility/asserts.hpp>
+
+#include <algorithm>
+#include <utility>
+
+namespace osp
+{
+
+TopWorkerPool::TopWorkerPool(std::size_t const threadCount, ThreadInitFunc_t threadInit, std::size_t const dedicatedCount)
+ : m_threadInit{std::move(threadInit)}
+ , m_dedicatedCount{dedicatedCount}
+{
+    LGRN_ASSERTM(threadCount != 0, "TopWorkerPool needs at least one thread");
+
+    std::size_t const total = threadCount + dedicatedCount;
+
+    m_workers.reserve(total);
+    for (std::size_t i = 0; i < total; ++i)
+    {
+        m_workers.emplace_back(std::make_unique<Worker>());
+        m_workers.back()->dedicated = (i >= threadCount);
+    }
+
+    // Start threads only after all workers exist, since workers steal from each other
+    for (std::size_t i = 0; i < total; ++i)
+    {
+        m_workers[i]->thread = std::thread([this, i] () { worker_main(i); });
+    }
+}
+
+TopWorkerPool::~TopWorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_stop = true;
+    }
+    m_wakeCv.notify_all();
+    m_wakeDedicatedCv.notify_all();
+
+    for (std::unique_ptr<Worker> &rpWorker : m_workers)
+    {
+        rpWorker->thread.join();
+    }
+}
+
+std::size_t TopWorkerPool::default_thread_count() noexcept
+{
+    unsigned int const hardware = std::thread::hardware_concurrency();
+    return std::max<std::size_t>(1, (hardware > 1) ? (hardware - 1) : 1);
+}
+
+void TopWorkerPool::bind(TopTaskDataVec_t const& taskData, ArrayView<entt::any> const topData, uint32_t const instance)
+{
+    if (m_bindings.size() <= instance)
+    {
+        m_bindings.resize(instance + 1);
+    }
+    m_bindings[instance] = {.pTaskData = &taskData, .topData = topData};
+}
+
+std::pair<std::size_t, std::size_t> TopWorkerPool::group_of(bool const dedicated) const noexcept
+{
+    std::size_t const split = m_workers.size() - m_dedicatedCount;
+    return dedicated ? std::make_pair(split, m_workers.size()) : std::make_pair(std::size_t(0), split);
+}
+
+void TopWorkerPool::push(TaskId const task, bool dedicated, uint32_t const instance)
+{
+    LGRN_ASSERTM(instance < m_bindings.size() && m_bindings[instance].pTaskData != nullptr,
+                 "Call bind() before pushing tasks");
+
+    push_queued({.task = task, .instance = instance}, dedicated && (m_dedicatedCount != 0));
+}
+
+void TopWorkerPool::push_queued(Queued queued, bool const dedicated)
+{
+    // Round-robin initial placement. Idle workers will steal to balance things out.
+    // Count before pushing, so m_queued never underflows if a worker takes the task right away
+    Worker *pWorker;
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+
+        auto const [first, last] = group_of(dedicated);
+        std::size_t &rNextPush = dedicated ? m_nextPushDedicated : m_nextPush;
+        pWorker = m_workers[first + rNextPush].get();
+        rNextPush = (rNextPush + 1) % (last - first);
+
+        ++ (dedicated ? m_queuedDedicated : m_queued);
+    }
+    {
+        std::lock_guard<std::mutex> lock(pWorker->mutex);
+        pWorker->queue.push_back(std::move(queued));
+    }
+    (dedicated ? m_wakeDedicatedCv : m_wakeCv).notify_one();
+}
+
+ParallelFor TopWorkerPool::parallel_for() noexcept
+{
+    return {
+        .m_func         = &TopWorkerPool::run_ranges,
+        .m_pUserData    = this,
+        .m_threads      = m_workers.size() - m_dedicatedCount + 1 };
+}
+
+void TopWorkerPool::run_ranges(void* const pUserData, std::size_t const count, std::size_t const ranges, ParallelFor::RangeFunc_t const rangeFunc, void const* const pFunc)
+{
+    auto &rPool = *static_cast<TopWorkerPool*>(pUserData);
+
+    auto pJob = std::make_shared<RangeJob>();
+    pJob->rangeFunc = rangeFunc;
+    pJob->pFunc     = pFunc;
+    pJob->count     = count;
+    pJob->ranges    = ranges;
+
+    // Helpers that only get to run after all ranges are taken return right away, the job is
+    // kept alive for them by pRanges
+    for (std::size_t i = 1; i < ranges; ++i)
+    {
+        rPool.push_queued({.task = lgrn::id_null<TaskId>(), .instance = 0, .pRanges = pJob}, false);
+    }
+
+    help_ranges(*pJob);
+
+    // pFunc is only valid until this returns, wait for ranges other threads took
+    std::unique_lock<std::mutex> lock(pJob->mutex);
+    pJob->doneCv.wait(lock, [&rJob = *pJob] () { return rJob.rangesDone.load() == rJob.ranges; });
+}
+
+void TopWorkerPool::help_ranges(RangeJob& rJob)
+{
+    for (std::size_t range = rJob.nextRange.fetch_add(1); range < rJob.ranges; range = rJob.nextRange.fetch_add(1))
+    {
+        rJob.rangeFunc(rJob.pFunc, rJob.count * range / rJob.ranges, rJob.count * (range + 1) / rJob.ranges);
+
+        if (rJob.rangesDone.fetch_add(1) + 1 == rJob.ranges)
+        {
+            std::lock_guard<std::mutex> lock(rJob.mutex);
+            rJob.doneCv.notify_all();
+        }
+    }
+}
+
+void TopWorkerPool::wait_completed(std::vector<Completed>& rOut)
+{
+    rOut.clear();
+
+    std::unique_lock<std::mutex> lock(m_doneMutex);
+    m_doneCv.wait(lock, [this] () { return ! m_done.empty(); });
+
+    std::swap(rOut, m_done);
+}
+
+void TopWorkerPool::take_completed(std::vector<Completed>& rOut)
+{
+    rOut.clear();
+
+    std::lock_guard<std::mutex> lock(m_doneMutex);
+    std::swap(rOut, m_done);
+}
+
+void TopWorkerPool::worker_main(std::size_t const index)
+{
+    Worker &rWorker = *m_workers[index];
+
+    if (m_threadInit)
+    {
+        m_threadInit(index);
+    }
+
+    std::condition_variable &rWakeCv = rWorker.dedicated ? m_wakeDedicatedCv : m_wakeCv;
+    std::size_t const       &rQueued = rWorker.dedicated ? m_queuedDedicated : m_queued;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_wakeMutex);
+            rWakeCv.wait(lock, [this, &rQueued] () { return m_stop || rQueued != 0; });
+
+            if (m_stop)
+            {
+                return;
+            }
+        }
+
+        Queued queued;
+        if ( ! try_pop(index, queued) )
+        {
+            continue; // another worker took it first
+        }
+
+        if (queued.pRanges != nullptr)
+        {
+            help_ranges(*queued.pRanges);
+        }
+        else
+        {
+            run_task(rWorker, uint32_t(index), std::move(queued));
+        }
+    }
+}
+
+bool TopWorkerPool::try_pop(std::size_t const index, Queued& rOut)
+{
+    bool const dedicated = m_workers[index]->dedicated;
+
+    auto const take_from = [this, &rOut, dedicated] (Worker& rVictim, bool const front) -> bool
+    {
+        {
+            std::lock_guard<std::mutex> lock(rVictim.mutex);
+            if (rVictim.queue.empty())
+            {
+                return false;
+            }
+
+            if (front)
+            {
+                rOut = std::move(rVictim.queue.front());
+                rVictim.queue.pop_front();
+            }
+            else
+            {
+                rOut = std::move(rVictim.queue.back());
+                rVictim.queue.pop_back();
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        -- (dedicated ? m_queuedDedicated : m_queued);
+        return true;
+    };
+
+    // Own queue first
+    if (take_from(*m_workers[index], true))
+    {
+        return true;
+    }
+
+    // Steal from others in the same group, starting from the next worker over to spread out
+    // contention
+    auto const [first, last] = group_of(dedicated);
+    std::size_t const count = last - first;
+    for (std::size_t i = 1; i < count; ++i)
+    {
+        if (take_from(*m_workers[first + (index - first + i) % count], false))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void TopWorkerPool::run_task(Worker& rWorker, uint32_t const index, Queued const queued)
+{
+    Clock_t::time_point const start = Clock_t::now();
+
+    Binding const &rBinding = m_bindings[queued.instance];
+    TopTask const &rTopTask = (*rBinding.pTaskData)[queued.task];
+
+    rWorker.topDataRefs.clear();
+    rWorker.topDataRefs.reserve(rTopTask.m_dataUsed.size());
+    for (TopDataId const dataId : rTopTask.m_dataUsed)
+    {
+        rWorker.topDataRefs.push_back((dataId != lgrn::id_null<TopDataId>())
+                                      ? rBinding.topData[dataId].as_ref()
+                                      : entt::any{});
+    }
+
+    bool const shouldRun = (rTopTask.m_func != nullptr);
+
+    // Task function is called here
+    WorkerContext const ctx{.m_pLocal = &rWorker.local, .m_workerIndex = index + 1, .m_parallelFor = parallel_for()};
+    TaskActions status;
+    if (shouldRun)
+    {
+        OSP_PROFILE_ZONE_DYNAMIC(rTopTask.m_debugName);
+        status = rTopTask.m_func(ctx, rWorker.topDataRefs);
+    }
+
+    rWorker.local.scratch.reset();
+
+    Clock_t::time_point const end = Clock_t::now();
+
+    {
+        std::lock_guard<std::mutex> lock(m_doneMutex);
+        m_done.push_back({queued.task, status, queued.instance, index, start, end});
+    }
+    m_doneCv.notify_one();
+}
+
+} // namespace osp
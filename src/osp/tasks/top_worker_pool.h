@@ -0,0 +1,256 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "top_tasks.h"
+#include "top_worker.h"
+
+#include "../core/parallel_for.h"
+
+#include <entt/core/any.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace osp
+{
+
+/**
+ * @brief Pool of worker threads that run TopTasks handed to them by a coordinator thread
+ *
+ * Each worker owns a queue. Workers pop tasks from the front of their own queue, and steal from
+ * the back of other workers' queues once their own runs dry.
+ *
+ * Dedicated workers are kept apart for long tasks; they only run tasks pushed as dedicated, and
+ * only steal from each other. Other workers never take dedicated tasks, so short tasks never wait
+ * behind a long one.
+ *
+ * Workers never touch ExecContext. They only call TopTask functions and report results back
+ * through wait_completed(), leaving the coordinator (see top_run_parallel) as the only thread that
+ * calls complete_task and exec_update.
+ *
+ * Tasks from several independent sets of TopTasks and TopData can be in flight at once. Each set
+ * is bound to its own instance index, and tasks are pushed and completed along with it.
+ *
+ * Tasks can also split up their own loops with parallel_for(); idle workers pick up the ranges.
+ */
+class TopWorkerPool
+{
+public:
+
+    using Clock_t = std::chrono::steady_clock;
+
+    struct Completed
+    {
+        TaskId              task;
+        TaskActions         actions;
+
+        /// Instance the task was pushed with, see bind()
+        uint32_t            instance;
+
+        /// Index of the worker that ran the task, in [0, thread_count())
+        uint32_t            worker;
+        Clock_t::time_point start;
+        Clock_t::time_point end;
+    };
+
+    /// Called at the start of each worker thread, such as to set thread-local loggers
+    using ThreadInitFunc_t = std::function<void(std::size_t workerIndex)>;
+
+    /**
+     * @param threadCount     [in] Number of worker threads to start, see default_thread_count()
+     * @param threadInit      [in] Optional function each worker thread calls before running tasks
+     * @param dedicatedCount  [in] Number of dedicated workers to start on top of threadCount
+     */
+    explicit TopWorkerPool(std::size_t threadCount = default_thread_count(), ThreadInitFunc_t threadInit = {}, std::size_t dedicatedCount = 0);
+    TopWorkerPool(TopWorkerPool const& copy) = delete;
+    TopWorkerPool(TopWorkerPool&& move) = delete;
+    TopWorkerPool& operator=(TopWorkerPool const& copy) = delete;
+    TopWorkerPool& operator=(TopWorkerPool&& move) = delete;
+    ~TopWorkerPool();
+
+    /**
+     * @return One less than the number of hardware threads, leaving a core for the coordinator.
+     *         Always at least 1.
+     */
+    [[nodiscard]] static std::size_t default_thread_count() noexcept;
+
+    /// Total number of workers, including dedicated ones. Dedicated workers come last.
+    [[nodiscard]] std::size_t thread_count() const noexcept { return m_workers.size(); }
+
+    [[nodiscard]] std::size_t dedicated_count() const noexcept { return m_dedicatedCount; }
+
+    /**
+     * @brief Per-thread state given to tasks through WorkerContext
+     *
+     * Index 0 is used by the coordinator thread, and index i + 1 by worker i. Only access while
+     * no tasks are in flight, such as to take buffered metrics and log messages.
+     *
+     * @param index [in] In [0, thread_count()]
+     */
+    [[nodiscard]] WorkerLocal& worker_local(std::size_t const index) noexcept
+    {
+        return (index == 0) ? m_coordinatorLocal : m_workers[index - 1]->local;
+    }
+
+    /**
+     * @brief Set TopTask data and TopData to use for tasks pushed with the same instance
+     *
+     * Must not be called while tasks are in flight.
+     */
+    void bind(TopTaskDataVec_t const& taskData, ArrayView<entt::any> topData, uint32_t instance = 0);
+
+    /**
+     * @brief Queue a task to run on any worker
+     *
+     * @param dedicated [in] Run on a dedicated worker instead. Same as false if there are none.
+     * @param instance  [in] Which bind() call's TopTask data and TopData the task belongs to
+     */
+    void push(TaskId task, bool dedicated = false, uint32_t instance = 0);
+
+    /**
+     * @brief Block until at least one task completes, then move all completed tasks into rOut
+     *
+     * rOut is cleared first.
+     */
+    void wait_completed(std::vector<Completed>& rOut);
+
+    /**
+     * @brief Move all tasks completed so far into rOut without blocking
+     *
+     * rOut is cleared first, and left empty if nothing completed.
+     */
+    void take_completed(std::vector<Completed>& rOut);
+
+    /**
+     * @brief Get a ParallelFor that hands ranges to the pool's workers, other than dedicated ones
+     *
+     * Safe to call from inside tasks running on the pool. The calling thread keeps taking ranges
+     * until none are left, so it never waits on a range that no thread has started, even if
+     * every worker is busy.
+     */
+    [[nodiscard]] ParallelFor parallel_for() noexcept;
+
+private:
+
+    /// Loop split up by a ParallelFor from parallel_for(), shared by every thread helping with it
+    struct RangeJob
+    {
+        ParallelFor::RangeFunc_t    rangeFunc   { nullptr };
+        void const                  *pFunc      { nullptr };
+        std::size_t                 count       { 0 };
+        std::size_t                 ranges      { 0 };
+
+        std::atomic<std::size_t>    nextRange   { 0 };
+        std::atomic<std::size_t>    rangesDone  { 0 };
+
+        std::mutex                  mutex;
+        std::condition_variable     doneCv;
+    };
+
+    struct Queued
+    {
+        TaskId                      task;
+        uint32_t                    instance;
+
+        /// If set, this is a helper for a RangeJob instead of a task
+        std::shared_ptr<RangeJob>   pRanges;
+    };
+
+    struct Binding
+    {
+        TopTaskDataVec_t const  *pTaskData  { nullptr };
+        ArrayView<entt::any>    topData;
+    };
+
+    struct Worker
+    {
+        std::mutex              mutex;
+        std::deque<Queued>      queue;
+
+        /// Reused for resolving TopDataIds into references of topData
+        std::vector<entt::any>  topDataRefs;
+
+        WorkerLocal             local;
+
+        std::thread             thread;
+
+        bool                    dedicated   { false };
+    };
+
+    void worker_main(std::size_t index);
+
+    /// Place on a worker's queue in round-robin order and wake a worker up. Thread-safe.
+    void push_queued(Queued queued, bool dedicated);
+
+    static void run_ranges(void* pUserData, std::size_t count, std::size_t ranges, ParallelFor::RangeFunc_t rangeFunc, void const* pFunc);
+
+    /// Run ranges of a RangeJob until none are left to take
+    static void help_ranges(RangeJob& rJob);
+
+    bool try_pop(std::size_t index, Queued& rOut);
+
+    /// Index range [first, last) of either the dedicated or the other workers in m_workers
+    [[nodiscard]] std::pair<std::size_t, std::size_t> group_of(bool dedicated) const noexcept;
+
+    void run_task(Worker& rWorker, uint32_t index, Queued queued);
+
+    std::vector< std::unique_ptr<Worker> >  m_workers;
+    ThreadInitFunc_t                        m_threadInit;
+    WorkerLocal                             m_coordinatorLocal;
+
+    std::vector<Binding>                    m_bindings;
+
+    std::size_t                             m_dedicatedCount    { 0 };
+
+    // Wakes up sleeping workers when new tasks are pushed. Dedicated workers and the rest each
+    // have their own count and condition variable, so neither is woken up for the other's tasks.
+    // Also guards m_nextPush*, since tasks push RangeJob helpers from worker threads.
+    std::mutex                              m_wakeMutex;
+    std::condition_variable                 m_wakeCv;
+    std::condition_variable                 m_wakeDedicatedCv;
+    std::size_t                             m_queued            { 0 };
+    std::size_t                             m_queuedDedicated   { 0 };
+    std::size_t                             m_nextPush          { 0 };
+    std::size_t                             m_nextPushDedicated { 0 };
+    bool                                    m_stop              { false };
+
+    // Workers report finished tasks to the coordinator
+    std::mutex                              m_doneMutex;
+    std::condition_variable                 m_doneCv;
+    std::vector<Completed>                  m_done;
+
+}; // class TopWorkerPool
+
+} // namespace osp
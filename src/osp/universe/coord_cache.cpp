@@ -0,0 +1,210 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "coord_cache.h"
+
+#include <longeron/utility/asserts.hpp>
+
+#include <algorithm>
+
+namespace osp::universe
+{
+
+namespace
+{
+
+constexpr uint64_t pair_key(CoSpaceId const from, CoSpaceId const to) noexcept
+{
+    return (uint64_t(from) << 32) | uint64_t(to);
+}
+
+/**
+ * @brief Call func(space) for each space from [space, ancestor), walking towards the root
+ */
+template <typename FUNC_T>
+void for_each_up_to(Universe const& universe, CoSpaceId space, CoSpaceId const ancestor, FUNC_T&& func)
+{
+    while (space != ancestor)
+    {
+        func(space);
+        space = universe.m_coordCommon[space].m_parent;
+    }
+}
+
+CoSpaceId common_ancestor(Universe const& universe, CoSpaceId a, CoSpaceId b)
+{
+    auto const depth_of = [&universe] (CoSpaceId space)
+    {
+        int depth = 0;
+        while (universe.m_coordCommon[space].m_parent != lgrn::id_null<CoSpaceId>())
+        {
+            space = universe.m_coordCommon[space].m_parent;
+            ++ depth;
+        }
+        return depth;
+    };
+
+    int depthA = depth_of(a);
+    int depthB = depth_of(b);
+
+    for (; depthA > depthB; --depthA) { a = universe.m_coordCommon[a].m_parent; }
+    for (; depthB > depthA; --depthB) { b = universe.m_coordCommon[b].m_parent; }
+
+    while (a != b)
+    {
+        a = universe.m_coordCommon[a].m_parent;
+        b = universe.m_coordCommon[b].m_parent;
+        LGRN_ASSERTM(a != lgrn::id_null<CoSpaceId>() && b != lgrn::id_null<CoSpaceId>(),
+                     "Coordinate spaces are not in the same tree");
+    }
+    return a;
+}
+
+CoSpaceTransform transform_in_parent(Universe const& universe, CoSpaceId const child)
+{
+    CoSpaceCommon const &rChild  = universe.m_coordCommon[child];
+    CoSpaceCommon const &rParent = universe.m_coordCommon[rChild.m_parent];
+
+    if (rChild.m_parentSat == lgrn::id_null<SatId>())
+    {
+        return rChild;
+    }
+
+    auto const rotations = sat_views(rParent.m_satRotations, rParent.m_data, rParent.m_satCount);
+
+    return visit_sat_positions(rParent, rParent.m_satCount, [&rChild, &rotations] (auto const& x, auto const& y, auto const& z)
+    {
+        auto const& [qx, qy, qz, qw] = rotations;
+        return coord_get_transform(rChild, rChild, x, y, z, qx, qy, qz, qw);
+    });
+}
+
+} // namespace
+
+CoordTransformer coord_child_to_parent(Universe const& universe, CoSpaceId const child)
+{
+    CoSpaceId const parent = universe.m_coordCommon[child].m_parent;
+    LGRN_ASSERTM(parent != lgrn::id_null<CoSpaceId>(), "Coordinate space has no parent");
+
+    return coord_child_to_parent(universe.m_coordCommon[parent], transform_in_parent(universe, child));
+}
+
+CoordTransformer coord_transformer_between(Universe const& universe, CoSpaceId const from, CoSpaceId const to)
+{
+    CoSpaceId const ancestor = common_ancestor(universe, from, to);
+
+    CoordTransformer up;
+    for_each_up_to(universe, from, ancestor, [&universe, &up] (CoSpaceId const space)
+    {
+        up = coord_composite(coord_child_to_parent(universe, space), up);
+    });
+
+    // Walking up from the destination, so compose on the inner side
+    CoordTransformer down;
+    for_each_up_to(universe, to, ancestor, [&universe, &down] (CoSpaceId const space)
+    {
+        CoSpaceId const parent = universe.m_coordCommon[space].m_parent;
+        down = coord_composite(down, coord_parent_to_child(universe.m_coordCommon[parent], transform_in_parent(universe, space)));
+    });
+
+    return coord_composite(down, up);
+}
+
+CoordTransformer const& coord_cache_get(CoordTransformCache& rCache, Universe const& universe, CoSpaceId const from, CoSpaceId const to)
+{
+    auto const [it, inserted] = rCache.m_pairToEntry.try_emplace(pair_key(from, to), uint32_t(rCache.m_entries.size()));
+    if (inserted)
+    {
+        rCache.m_entries.emplace_back();
+    }
+
+    uint32_t const entryIdx = it->second;
+    CoordTransformCache::Entry &rEntry = rCache.m_entries[entryIdx];
+
+    if (rEntry.valid)
+    {
+        return rEntry.transformer;
+    }
+
+    rEntry.transformer  = coord_transformer_between(universe, from, to);
+    rEntry.valid        = true;
+    ++ rEntry.generation;
+
+    // Register with every space along the path, excluding the common ancestor
+    rCache.m_spaceToEntries.resize(std::max(rCache.m_spaceToEntries.size(), universe.m_coordCommon.size()));
+
+    CoSpaceId const ancestor = common_ancestor(universe, from, to);
+    auto const add = [&rCache, ref = CoordTransformCache::EntryRef{entryIdx, rEntry.generation}] (CoSpaceId const space)
+    {
+        rCache.m_spaceToEntries[space].push_back(ref);
+    };
+    for_each_up_to(universe, from, ancestor, add);
+    for_each_up_to(universe, to,   ancestor, add);
+
+    return rEntry.transformer;
+}
+
+void coord_cache_invalidate(CoordTransformCache& rCache, CoSpaceId const space)
+{
+    if (space >= rCache.m_spaceToEntries.size())
+    {
+        return;
+    }
+
+    for (CoordTransformCache::EntryRef const ref : rCache.m_spaceToEntries[space])
+    {
+        CoordTransformCache::Entry &rEntry = rCache.m_entries[ref.entry];
+        if (rEntry.generation == ref.generation)
+        {
+            rEntry.valid = false;
+        }
+    }
+    rCache.m_spaceToEntries[space].clear();
+}
+
+void coord_cache_invalidate_sat_children(CoordTransformCache& rCache, Universe const& universe, CoSpaceId const parent)
+{
+    for (CoSpaceId space = 0; space < universe.m_coordCommon.size(); ++space)
+    {
+        if ( ! universe.m_coordIds.exists(space) )
+        {
+            continue;
+        }
+
+        CoSpaceCommon const &rCommon = universe.m_coordCommon[space];
+        if (rCommon.m_parent == parent && rCommon.m_parentSat != lgrn::id_null<SatId>())
+        {
+            coord_cache_invalidate(rCache, space);
+        }
+    }
+}
+
+void coord_cache_clear(CoordTransformCache& rCache) noexcept
+{
+    rCache.m_pairToEntry.clear();
+    rCache.m_entries.clear();
+    rCache.m_spaceToEntries.clear();
+}
+
+} // namespace osp::universe
@@ -0,0 +1,98 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "coordinates.h"
+#include "universe.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace osp::universe
+{
+
+/**
+ * @brief Get transform of a coordinate space relative to its parent, accounting for m_parentSat
+ */
+CoordTransformer coord_child_to_parent(Universe const& universe, CoSpaceId child);
+
+/**
+ * @brief Compose a transform between any two coordinate spaces in the same tree
+ *
+ * Walks up the CoSpaceHierarchy from both spaces to their common ancestor.
+ */
+CoordTransformer coord_transformer_between(Universe const& universe, CoSpaceId from, CoSpaceId to);
+
+/**
+ * @brief Cache of composed CoordTransformers between pairs of coordinate spaces
+ *
+ * Entries are recomputed lazily by coord_cache_get after any space along their path is marked
+ * dirty with coord_cache_invalidate. Mark a space dirty when its CoSpaceTransform or its
+ * parent satellite changes.
+ */
+struct CoordTransformCache
+{
+    struct Entry
+    {
+        CoordTransformer    transformer;
+        uint32_t            generation  {0};
+        bool                valid       {false};
+    };
+
+    struct EntryRef
+    {
+        uint32_t            entry;
+        uint32_t            generation;
+    };
+
+    /// (from << 32 | to) to index in m_entries
+    std::unordered_map<uint64_t, uint32_t>      m_pairToEntry;
+    std::vector<Entry>                          m_entries;
+
+    /// Entries that depend on each space's transform relative to its parent
+    std::vector< std::vector<EntryRef> >        m_spaceToEntries;
+};
+
+/**
+ * @brief Get the CoordTransformer from one space to another, composing it if not cached
+ */
+CoordTransformer const& coord_cache_get(CoordTransformCache& rCache, Universe const& universe, CoSpaceId from, CoSpaceId to);
+
+/**
+ * @brief Mark that a space moved relative to its parent, invalidating entries across it
+ */
+void coord_cache_invalidate(CoordTransformCache& rCache, CoSpaceId space);
+
+/**
+ * @brief Invalidate all child spaces that are parented to satellites of a space
+ *
+ * Call when satellites of parent were moved.
+ */
+void coord_cache_invalidate_sat_children(CoordTransformCache& rCache, Universe const& universe, CoSpaceId parent);
+
+void coord_cache_clear(CoordTransformCache& rCache) noexcept;
+
+} // namespace osp::universe
@@ -28,9 +28,18 @@
 
 #include "../core/math_2pow.h"
 
+#include <Magnum/Math/Matrix3.h>
+
+#include <longeron/utility/asserts.hpp>
+
+#include <type_traits>
+
 namespace osp::universe
 {
 
+using SpaceIntView_t        = Corrade::Containers::StridedArrayView1D<spaceint_t>;
+using SpaceIntViewConst_t   = Corrade::Containers::StridedArrayView1D<spaceint_t const>;
+
 inline Vector3g rotate_vector3g(Vector3g const in, Quaterniond const rot) noexcept
 {
     // transformVector isn't constexpr.
@@ -138,6 +147,133 @@ struct CoordTransformer
     }
 };
 
+/**
+ * @brief Transform many positions at once, such as satellite position columns from sat_views
+ *
+ * Does the same as calling CoordTransformer::transform_position on each position, but branches
+ * and the constant c*2^m term are only evaluated once for the whole batch. Rotations are converted
+ * to a single 3x3 matrix, so results may differ from transform_position by rounding (1 unit).
+ *
+ * The loops are written to be auto-vectorized; input and output views may be the same.
+ *
+ * Positions can be read and written as spaceint32_t for local spaces, such as
+ * coord_transform_positions<spaceint32_t, spaceint_t> from a local space to its parent. Math is
+ * done in spaceint_t either way. The output must fit OUT_T; it isn't clamped.
+ *
+ * @param tf        [in] Transform to apply
+ * @param x,y,z     [in] Input position components, all the same size
+ * @param outX,outY,outZ [out] Output position components, same size as input
+ */
+template <typename IN_T = spaceint_t, typename OUT_T = spaceint_t>
+void coord_transform_positions(
+        CoordTransformer const& tf,
+        Corrade::Containers::StridedArrayView1D<std::type_identity_t<IN_T> const> const& x,
+        Corrade::Containers::StridedArrayView1D<std::type_identity_t<IN_T> const> const& y,
+        Corrade::Containers::StridedArrayView1D<std::type_identity_t<IN_T> const> const& z,
+        Corrade::Containers::StridedArrayView1D<std::type_identity_t<OUT_T>> const& outX,
+        Corrade::Containers::StridedArrayView1D<std::type_identity_t<OUT_T>> const& outY,
+        Corrade::Containers::StridedArrayView1D<std::type_identity_t<OUT_T>> const& outZ) noexcept
+{
+    static_assert(std::is_signed_v<IN_T> && std::is_signed_v<OUT_T> && sizeof(IN_T) <= sizeof(spaceint_t));
+
+    std::size_t const count = x.size();
+
+    LGRN_ASSERT(   y.size() == count && z.size() == count
+                && outX.size() == count && outY.size() == count && outZ.size() == count);
+
+    bool const rotIn = quat_non_zero(tf.m_rotIn);
+
+    // Rotating in place first would store unscaled positions in the narrower output, which may
+    // not fit. Rare enough (global to local with an inner rotation) to not need a fast path.
+    if constexpr (sizeof(OUT_T) < sizeof(IN_T))
+    {
+        if (rotIn)
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                Vector3g const out = tf.transform_position({x[i], y[i], z[i]});
+                outX[i] = OUT_T(out.x());
+                outY[i] = OUT_T(out.y());
+                outZ[i] = OUT_T(out.z());
+            }
+            return;
+        }
+    }
+
+    Vector3g const c = math::mul_2pow<Vector3g, spaceint_t>(tf.m_c, tf.m_m);
+
+    auto const rotate_all = [count, &outX, &outY, &outZ] (Quaterniond const rot) noexcept
+    {
+        Magnum::Math::Matrix3x3<double> const mat = rot.toMatrix();
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            double const px = double(outX[i]);
+            double const py = double(outY[i]);
+            double const pz = double(outZ[i]);
+            outX[i] = OUT_T(mat[0][0] * px + mat[1][0] * py + mat[2][0] * pz);
+            outY[i] = OUT_T(mat[0][1] * px + mat[1][1] * py + mat[2][1] * pz);
+            outZ[i] = OUT_T(mat[0][2] * px + mat[1][2] * py + mat[2][2] * pz);
+        }
+    };
+
+    if (rotIn)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            outX[i] = x[i];
+            outY[i] = y[i];
+            outZ[i] = z[i];
+        }
+        rotate_all(tf.m_rotIn);
+    }
+
+    // Multiply by 2^n as in math::mul_2pow. Division rounds towards zero, so a bias is added to
+    // negative values before shifting right. Input is either IN_T or, after rotating, OUT_T.
+    auto const scale_all = [count, c, n = tf.m_n] (
+            auto const& in,
+            Corrade::Containers::StridedArrayView1D<OUT_T> const& out,
+            int const component) noexcept
+    {
+        spaceint_t const add = c[component];
+
+        if (n >= 0)
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                out[i] = OUT_T((spaceint_t(in[i]) << n) + add);
+            }
+        }
+        else
+        {
+            int const        shift = -n;
+            spaceint_t const bias  = math::int_2pow<spaceint_t>(shift) - 1;
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                spaceint_t const value = in[i];
+                out[i] = OUT_T(((value + ((value >> 63) & bias)) >> shift) + add);
+            }
+        }
+    };
+
+    if (rotIn)
+    {
+        scale_all(outX, outX, 0);
+        scale_all(outY, outY, 1);
+        scale_all(outZ, outZ, 2);
+    }
+    else
+    {
+        scale_all(x, outX, 0);
+        scale_all(y, outY, 1);
+        scale_all(z, outZ, 2);
+    }
+
+    if (quat_non_zero(tf.m_rotOut))
+    {
+        rotate_all(tf.m_rotOut);
+    }
+}
+
 /**
  * @brief Composite together two CoordTransformers
  *
@@ -0,0 +1,317 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "kepler.h"
+
+#include "../core/math_2pow.h"
+
+#include <Magnum/Math/Constants.h>
+
+#include <longeron/utility/asserts.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace osp::universe
+{
+
+namespace
+{
+
+// Orbits this close to parabolic have a huge or infinite semi-major axis
+constexpr double gc_parabolicEpsilon    = 1.0e-8;
+constexpr double gc_solveTolerance      = 1.0e-13;
+constexpr int    gc_solveMaxIterations  = 32;
+
+} // namespace
+
+
+double kepler_solve_elliptic(double const meanAnomaly, double const eccentricity) noexcept
+{
+    // Wrap to [-pi, pi] for a good initial guess and to avoid precision loss for large times
+    double const M = std::remainder(meanAnomaly, 2.0 * Magnum::Math::Constants<double>::pi());
+
+    double E = (eccentricity < 0.8) ? M : Magnum::Math::Constants<double>::pi() * (M < 0.0 ? -1.0 : 1.0);
+
+    for (int i = 0; i < gc_solveMaxIterations; ++i)
+    {
+        double const f  = E - eccentricity * std::sin(E) - M;
+        double const df = 1.0 - eccentricity * std::cos(E);
+        double const step = f / df;
+        E -= step;
+        if (std::abs(step) < gc_solveTolerance)
+        {
+            break;
+        }
+    }
+
+    // Add back full revolutions removed by the wrap
+    return E + (meanAnomaly - M);
+}
+
+double kepler_solve_hyperbolic(double const meanAnomaly, double const eccentricity) noexcept
+{
+    double F = std::asinh(meanAnomaly / eccentricity);
+
+    for (int i = 0; i < gc_solveMaxIterations; ++i)
+    {
+        double const f  = eccentricity * std::sinh(F) - F - meanAnomaly;
+        double const df = eccentricity * std::cosh(F) - 1.0;
+        double const step = f / df;
+        F -= step;
+        if (std::abs(step) < gc_solveTolerance * std::max(1.0, std::abs(F)))
+        {
+            break;
+        }
+    }
+
+    return F;
+}
+
+bool kepler_from_state(KeplerOrbit& rOut, KeplerState const& state, double const gm, double const time) noexcept
+{
+    Vector3d const& r = state.position;
+    Vector3d const& v = state.velocity;
+
+    double const rLen   = r.length();
+    Vector3d const h    = Magnum::Math::cross(r, v);
+    double const hLen   = h.length();
+
+    if (rLen == 0.0 || hLen <= rLen * v.length() * 1.0e-12)
+    {
+        return false; // Radial or degenerate
+    }
+
+    Vector3d const eccVec = Magnum::Math::cross(v, h) / gm - r / rLen;
+    double const e        = eccVec.length();
+    double const energy   = v.dot() * 0.5 - gm / rLen;
+
+    if (std::abs(e - 1.0) < gc_parabolicEpsilon || energy == 0.0)
+    {
+        return false;
+    }
+
+    double const a = -gm / (2.0 * energy);
+
+    // Circular orbits have no periapsis; measure from the current position instead
+    Vector3d const periapsisDir = (e > gc_parabolicEpsilon) ? eccVec / e : r / rLen;
+    Vector3d const prograde     = Magnum::Math::cross(h / hLen, periapsisDir);
+
+    double const x = Magnum::Math::dot(r, periapsisDir);
+    double const y = Magnum::Math::dot(r, prograde);
+
+    double meanAnomaly;
+    if (e < 1.0)
+    {
+        double const cosE = x / a + e;
+        double const sinE = y / (a * std::sqrt(1.0 - e * e));
+        double const E    = std::atan2(sinE, cosE);
+        meanAnomaly = E - e * std::sin(E);
+    }
+    else
+    {
+        double const sinhF = y / (-a * std::sqrt(e * e - 1.0));
+        double const F     = std::asinh(sinhF);
+        meanAnomaly = e * sinhF - F;
+    }
+
+    double const absA = std::abs(a);
+
+    rOut.periapsisDir       = periapsisDir;
+    rOut.prograde           = prograde;
+    rOut.semiMajorAxis      = a;
+    rOut.eccentricity       = e;
+    rOut.meanMotion         = std::sqrt(gm / (absA * absA * absA));
+    rOut.meanAnomalyAtEpoch = meanAnomaly;
+    rOut.epoch              = time;
+
+    return true;
+}
+
+KeplerState kepler_to_state(KeplerOrbit const& orbit, double const time) noexcept
+{
+    double const e = orbit.eccentricity;
+    double const M = orbit.meanAnomalyAtEpoch + orbit.meanMotion * (time - orbit.epoch);
+
+    double x, y, vx, vy;
+
+    if (e < 1.0)
+    {
+        double const a      = orbit.semiMajorAxis;
+        double const b      = a * std::sqrt(1.0 - e * e);
+        double const E      = kepler_solve_elliptic(M, e);
+        double const cosE   = std::cos(E);
+        double const sinE   = std::sin(E);
+        double const dE     = orbit.meanMotion / (1.0 - e * cosE);
+
+        x  = a * (cosE - e);
+        y  = b * sinE;
+        vx = -a * sinE * dE;
+        vy = b * cosE * dE;
+    }
+    else
+    {
+        double const a      = -orbit.semiMajorAxis;
+        double const b      = a * std::sqrt(e * e - 1.0);
+        double const F      = kepler_solve_hyperbolic(M, e);
+        double const coshF  = std::cosh(F);
+        double const sinhF  = std::sinh(F);
+        double const dF     = orbit.meanMotion / (e * coshF - 1.0);
+
+        x  = a * (e - coshF);
+        y  = b * sinhF;
+        vx = -a * sinhF * dF;
+        vy = b * coshF * dF;
+    }
+
+    return { orbit.periapsisDir * x  + orbit.prograde * y,
+             orbit.periapsisDir * vx + orbit.prograde * vy };
+}
+
+bool rails_enter(SatRails& rRails, CoSpaceCommon const& space, SatId const sat)
+{
+    LGRN_ASSERTMV(sat < space.m_satCount, "Satellite out of range", sat, space.m_satCount);
+    LGRN_ASSERTM(sat != rRails.attractor, "Attractor can't be on rails");
+
+    std::size_t const count = space.m_satCount;
+
+    if (rRails.orbits.size() < count)
+    {
+        rRails.orbits.resize(count);
+        rRails.onRails.resize(count, 0);
+    }
+
+    LGRN_ASSERTM( ! space.positions_32bit(), "Orbits need 64-bit positions");
+
+    auto const [x, y, z]    = sat_views(space.m_satPositions,  space.m_data, count);
+    auto const [vx, vy, vz] = sat_views(space.m_satVelocities, space.m_data, count);
+
+    double const scale  = math::mul_2pow<double, int>(1.0, -space.m_precision);
+    SatId const  att    = rRails.attractor;
+
+    KeplerState const state
+    {
+        Vector3d{double(x[sat] - x[att]), double(y[sat] - y[att]), double(z[sat] - z[att])} * scale,
+        Vector3d{vx[sat] - vx[att], vy[sat] - vy[att], vz[sat] - vz[att]}
+    };
+
+    bool const ok = kepler_from_state(rRails.orbits[sat], state, rRails.gm, rRails.time);
+    rRails.onRails[sat] = ok ? 1 : 0;
+    return ok;
+}
+
+void rails_leave(SatRails& rRails, SatId const sat) noexcept
+{
+    if (sat < rRails.onRails.size())
+    {
+        rRails.onRails[sat] = 0;
+    }
+}
+
+void rails_update(SatRails& rRails, CoSpaceCommon& rSpace, double const deltaTime)
+{
+    rRails.time += deltaTime;
+
+    std::size_t const count = std::min<std::size_t>(rSpace.m_satCount, rRails.onRails.size());
+    if (count == 0)
+    {
+        return;
+    }
+
+    LGRN_ASSERTM( ! rSpace.positions_32bit(), "Orbits need 64-bit positions");
+
+    auto const [x, y, z]    = sat_views(rSpace.m_satPositions,  rSpace.m_data, rSpace.m_satCount);
+    auto const [vx, vy, vz] = sat_views(rSpace.m_satVelocities, rSpace.m_data, rSpace.m_satCount);
+
+    double const invScale   = math::mul_2pow<double, int>(1.0, rSpace.m_precision);
+    SatId const  att        = rRails.attractor;
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (rRails.onRails[i] == 0)
+        {
+            continue;
+        }
+
+        KeplerState const state = kepler_to_state(rRails.orbits[i], rRails.time);
+
+        x[i] = x[att] + spaceint_t(std::llround(state.position.x() * invScale));
+        y[i] = y[att] + spaceint_t(std::llround(state.position.y() * invScale));
+        z[i] = z[att] + spaceint_t(std::llround(state.position.z() * invScale));
+
+        vx[i] = vx[att] + state.velocity.x();
+        vy[i] = vy[att] + state.velocity.y();
+        vz[i] = vz[att] + state.velocity.z();
+    }
+}
+
+void rails_check_perturbations(SatRails& rRails, CoSpaceCommon const& space, NBodyState const& nbody)
+{
+    std::size_t const count = std::min<std::size_t>(space.m_satCount, nbody.accelX.size());
+    SatId const       att   = rRails.attractor;
+
+    if (count == 0 || att >= count)
+    {
+        return;
+    }
+
+    for (SatId sat = 0; sat < count; ++sat)
+    {
+        if (sat == att)
+        {
+            continue;
+        }
+
+        // Two-body acceleration relative to the attractor, compared to the actual relative
+        // acceleration. The difference is caused by everything else.
+        Vector3d const r{nbody.posX[sat] - nbody.posX[att],
+                         nbody.posY[sat] - nbody.posY[att],
+                         nbody.posZ[sat] - nbody.posZ[att]};
+        double const   rLenSq = r.dot();
+        if (rLenSq == 0.0)
+        {
+            continue;
+        }
+
+        Vector3d const twoBody  = r * (-rRails.gm / (rLenSq * std::sqrt(rLenSq)));
+        Vector3d const relative{nbody.accelX[sat] - nbody.accelX[att],
+                                nbody.accelY[sat] - nbody.accelY[att],
+                                nbody.accelZ[sat] - nbody.accelZ[att]};
+
+        double const ratio = (relative - twoBody).length() / twoBody.length();
+
+        bool const onRails = sat < rRails.onRails.size() && rRails.onRails[sat] != 0;
+
+        if (onRails && ratio > rRails.leaveThreshold)
+        {
+            rails_leave(rRails, sat);
+        }
+        else if ( ! onRails && ratio < rRails.enterThreshold)
+        {
+            rails_enter(rRails, space, sat);
+        }
+    }
+}
+
+} // namespace osp::universe
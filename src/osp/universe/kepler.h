@@ -0,0 +1,149 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "nbody.h"
+#include "universe.h"
+
+#include "../core/math_types.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace osp::universe
+{
+
+/**
+ * @brief Elliptic or hyperbolic two-body orbit, evaluated analytically for any time
+ *
+ * Stored with the orbit's perifocal basis vectors instead of angles (inclination, longitude of
+ * ascending node...), which avoids special cases for equatorial and circular orbits.
+ */
+struct KeplerOrbit
+{
+    /// Unit vector towards periapsis
+    Vector3d    periapsisDir;
+
+    /// Unit vector 90 degrees ahead of periapsisDir in the direction of motion
+    Vector3d    prograde;
+
+    /// Negative for hyperbolic orbits, in meters
+    double      semiMajorAxis       {0.0};
+    double      eccentricity        {0.0};
+
+    /// Radians per second
+    double      meanMotion          {0.0};
+    double      meanAnomalyAtEpoch  {0.0};
+    double      epoch               {0.0};
+};
+
+struct KeplerState
+{
+    Vector3d    position;
+    Vector3d    velocity;
+};
+
+/**
+ * @brief Calculate orbital elements from a position and velocity relative to the attractor
+ *
+ * @param gm    [in] Gravitational parameter of the attractor (G * M)
+ * @param time  [in] Time of the given state, stored as the epoch
+ *
+ * @return False if the orbit is (nearly) parabolic or radial, which isn't supported
+ */
+bool kepler_from_state(KeplerOrbit& rOut, KeplerState const& state, double gm, double time) noexcept;
+
+/**
+ * @brief Evaluate position and velocity relative to the attractor at any time
+ */
+KeplerState kepler_to_state(KeplerOrbit const& orbit, double time) noexcept;
+
+/**
+ * @brief Solve Kepler's equation M = E - e*sin(E) for the eccentric anomaly E
+ */
+double kepler_solve_elliptic(double meanAnomaly, double eccentricity) noexcept;
+
+/**
+ * @brief Solve the hyperbolic Kepler's equation M = e*sinh(F) - F for F
+ */
+double kepler_solve_hyperbolic(double meanAnomaly, double eccentricity) noexcept;
+
+/**
+ * @brief Satellites of a coordinate space that can be moved along fixed orbits around one
+ *        attractor satellite, instead of being integrated
+ *
+ * Satellites on rails cost O(1) each to update for any time step, making time warp cheap.
+ * rails_check_perturbations switches satellites on and off rails depending on how much other
+ * bodies disturb their orbit.
+ */
+struct SatRails
+{
+    std::vector<KeplerOrbit>    orbits;
+
+    /// Non-zero if a satellite is on rails. Attractor is never on rails.
+    std::vector<uint8_t>        onRails;
+
+    SatId                       attractor   {lgrn::id_null<SatId>()};
+
+    /// Gravitational parameter of the attractor
+    double                      gm          {0.0};
+
+    /// Current time, advanced by rails_update
+    double                      time        {0.0};
+
+    /// Leave rails if acceleration not caused by the attractor is above this fraction
+    double                      leaveThreshold  {1.0e-3};
+
+    /// Enter rails if acceleration not caused by the attractor is below this fraction
+    double                      enterThreshold  {1.0e-4};
+};
+
+/**
+ * @brief Put a satellite on rails, using its current position and velocity
+ *
+ * @return False if the orbit can't be represented, the satellite stays integrated
+ */
+bool rails_enter(SatRails& rRails, CoSpaceCommon const& space, SatId sat);
+
+void rails_leave(SatRails& rRails, SatId sat) noexcept;
+
+/**
+ * @brief Advance time and move all satellites on rails to their analytic positions
+ *
+ * Velocities are updated too, so satellites can leave rails at any time and continue being
+ * integrated. Run after integrating the other satellites (e.g. nbody_step), so the
+ * attractor's position is up to date.
+ */
+void rails_update(SatRails& rRails, CoSpaceCommon& rSpace, double deltaTime);
+
+/**
+ * @brief Move satellites on or off rails depending on perturbations
+ *
+ * Compares total accelerations from the last nbody_accelerations call against acceleration
+ * from the attractor alone.
+ */
+void rails_check_perturbations(SatRails& rRails, CoSpaceCommon const& space, NBodyState const& nbody);
+
+} // namespace osp::universe
@@ -0,0 +1,427 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "nbody.h"
+
+#include "../core/math_2pow.h"
+#include "../core/parallel_for.h"
+
+#include <longeron/utility/asserts.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace osp::universe
+{
+
+namespace
+{
+
+// Bodies processed at once by the direct kernel. Inner loops over lanes are fixed-size so
+// compilers can vectorize them without needing -ffast-math for the sums.
+constexpr std::size_t gc_lanes = 4;
+
+// Bodies per range handed to a ParallelFor, fewer aren't worth another thread
+constexpr std::size_t gc_parallelMinBodies = 256;
+
+// Stop subdividing the octree past this depth, in case bodies are at the same position
+constexpr int gc_octreeMaxDepth = 32;
+
+} // namespace
+
+void nbody_resize(NBodyState& rState, std::size_t const bodyCount)
+{
+    rState.posX     .resize(bodyCount);
+    rState.posY     .resize(bodyCount);
+    rState.posZ     .resize(bodyCount);
+    rState.mass     .resize(bodyCount);
+    rState.accelX   .resize(bodyCount);
+    rState.accelY   .resize(bodyCount);
+    rState.accelZ   .resize(bodyCount);
+}
+
+void nbody_accelerations(NBodyState& rState, NBodyParams const& params, ParallelFor const& parallelFor)
+{
+    LGRN_ASSERTMV(rState.proxyCount <= rState.posX.size(), "More proxies than bodies", rState.proxyCount, rState.posX.size());
+
+    std::size_t const count = rState.posX.size() - rState.proxyCount;
+    std::size_t const total = rState.posX.size();
+
+    bool const useOctree =    params.mode == ENBodyMode::BarnesHut
+                           || (params.barnesHutMinBodies != 0 && total >= params.barnesHutMinBodies);
+
+    std::size_t const maxRanges = count / gc_parallelMinBodies;
+
+    if (useOctree)
+    {
+        nbody_build_octree(rState);
+        parallelFor(count, maxRanges, [&rState, &params] (std::size_t first, std::size_t last)
+        {
+            nbody_accelerations_octree(rState, params, first, last);
+        });
+    }
+    else
+    {
+        parallelFor(count, maxRanges, [&rState, &params] (std::size_t first, std::size_t last)
+        {
+            nbody_accelerations_direct(rState, params, first, last);
+        });
+    }
+}
+
+void nbody_accelerations_direct(NBodyState& rState, NBodyParams const& params, std::size_t const first, std::size_t const last) noexcept
+{
+    std::size_t const count = rState.posX.size();
+    double const eps2 = params.softening * params.softening;
+
+    double const* const pPosX = rState.posX.data();
+    double const* const pPosY = rState.posY.data();
+    double const* const pPosZ = rState.posZ.data();
+    double const* const pMass = rState.mass.data();
+
+    for (std::size_t i = first; i < last; i += gc_lanes)
+    {
+        std::size_t const lanes = std::min(gc_lanes, last - i);
+
+        std::array<double, gc_lanes> x, y, z;
+        std::array<double, gc_lanes> ax{}, ay{}, az{};
+
+        for (std::size_t l = 0; l < gc_lanes; ++l)
+        {
+            // Pad unused lanes with the first body, results are discarded
+            std::size_t const body = i + ((l < lanes) ? l : 0);
+            x[l] = pPosX[body];
+            y[l] = pPosY[body];
+            z[l] = pPosZ[body];
+        }
+
+        for (std::size_t j = 0; j < count; ++j)
+        {
+            double const jx = pPosX[j];
+            double const jy = pPosY[j];
+            double const jz = pPosZ[j];
+            double const jm = pMass[j];
+
+            for (std::size_t l = 0; l < gc_lanes; ++l)
+            {
+                double const dx = jx - x[l];
+                double const dy = jy - y[l];
+                double const dz = jz - z[l];
+                double const r2 = dx*dx + dy*dy + dz*dz + eps2;
+
+                // r2 is only zero between a body and itself, if there's no softening
+                double const s = (r2 > 0.0) ? jm / (r2 * std::sqrt(r2)) : 0.0;
+
+                ax[l] += dx * s;
+                ay[l] += dy * s;
+                az[l] += dz * s;
+            }
+        }
+
+        for (std::size_t l = 0; l < lanes; ++l)
+        {
+            rState.accelX[i + l] = ax[l] * params.gravConstant;
+            rState.accelY[i + l] = ay[l] * params.gravConstant;
+            rState.accelZ[i + l] = az[l] * params.gravConstant;
+        }
+    }
+}
+
+void nbody_build_octree(NBodyState& rState)
+{
+    using Node_t = NBodyOctreeNode;
+
+    std::size_t const count = rState.posX.size();
+
+    rState.octree.clear();
+
+    if (count == 0)
+    {
+        return;
+    }
+
+    // Bounding cube of all bodies
+    auto const [minX, maxX] = std::minmax_element(rState.posX.begin(), rState.posX.end());
+    auto const [minY, maxY] = std::minmax_element(rState.posY.begin(), rState.posY.end());
+    auto const [minZ, maxZ] = std::minmax_element(rState.posZ.begin(), rState.posZ.end());
+
+    double const halfSize = 0.5 * std::max({*maxX - *minX, *maxY - *minY, *maxZ - *minZ, 1.0});
+
+    rState.octree.reserve(count * 2);
+    rState.octree.push_back(Node_t{
+        .centerX    = 0.5 * (*minX + *maxX),
+        .centerY    = 0.5 * (*minY + *maxY),
+        .centerZ    = 0.5 * (*minZ + *maxZ),
+        .halfSize   = halfSize * 1.0001 });
+
+    auto const child_for = [&rState] (Node_t const& node, std::size_t const body) noexcept -> int32_t
+    {
+        return node.firstChild
+             + int32_t(rState.posX[body] >= node.centerX)
+             + int32_t(rState.posY[body] >= node.centerY) * 2
+             + int32_t(rState.posZ[body] >= node.centerZ) * 4;
+    };
+
+    auto const accumulate = [&rState] (Node_t& rNode, std::size_t const body) noexcept
+    {
+        double const m = rState.mass[body];
+        rNode.comX += rState.posX[body] * m;
+        rNode.comY += rState.posY[body] * m;
+        rNode.comZ += rState.posZ[body] * m;
+        rNode.mass += m;
+    };
+
+    for (std::size_t body = 0; body < count; ++body)
+    {
+        int32_t node  = 0;
+        int     depth = 0;
+
+        while (true)
+        {
+            accumulate(rState.octree[std::size_t(node)], body);
+
+            Node_t &rNode = rState.octree[std::size_t(node)];
+
+            if (rNode.firstChild == Node_t::smc_empty)
+            {
+                if (rNode.body == Node_t::smc_empty)
+                {
+                    rNode.body = int32_t(body);
+                    break;
+                }
+
+                if (rNode.body == Node_t::smc_aggregate || depth == gc_octreeMaxDepth)
+                {
+                    rNode.body = Node_t::smc_aggregate;
+                    break;
+                }
+
+                // Subdivide, and move the existing body into its child
+                int32_t const first = int32_t(rState.octree.size());
+                int32_t const other = rNode.body;
+
+                rNode.firstChild = first;
+                rNode.body       = Node_t::smc_empty;
+
+                Node_t const parent = rNode; // rNode is invalidated by push_back
+                double const quarter = parent.halfSize * 0.5;
+                for (int i = 0; i < 8; ++i)
+                {
+                    rState.octree.push_back(Node_t{
+                        .centerX    = parent.centerX + ((i & 1) ? quarter : -quarter),
+                        .centerY    = parent.centerY + ((i & 2) ? quarter : -quarter),
+                        .centerZ    = parent.centerZ + ((i & 4) ? quarter : -quarter),
+                        .halfSize   = quarter });
+                }
+
+                Node_t &rOtherChild = rState.octree[std::size_t(child_for(parent, std::size_t(other)))];
+                accumulate(rOtherChild, std::size_t(other));
+                rOtherChild.body = other;
+            }
+
+            node = child_for(rState.octree[std::size_t(node)], body);
+            ++ depth;
+        }
+    }
+
+    for (Node_t &rNode : rState.octree)
+    {
+        if (rNode.mass > 0.0)
+        {
+            rNode.comX /= rNode.mass;
+            rNode.comY /= rNode.mass;
+            rNode.comZ /= rNode.mass;
+        }
+    }
+}
+
+void nbody_accelerations_octree(NBodyState& rState, NBodyParams const& params, std::size_t const first, std::size_t const last) noexcept
+{
+    using Node_t = NBodyOctreeNode;
+
+    double const eps2   = params.softening * params.softening;
+    double const theta2 = params.theta * params.theta;
+
+    // Depth is limited, so 7 siblings per level is enough
+    std::array<int32_t, gc_octreeMaxDepth * 7 + 8> stack;
+
+    for (std::size_t i = first; i < last; ++i)
+    {
+        double const x = rState.posX[i];
+        double const y = rState.posY[i];
+        double const z = rState.posZ[i];
+
+        double ax = 0.0;
+        double ay = 0.0;
+        double az = 0.0;
+
+        std::size_t stackSize = 0;
+        if ( ! rState.octree.empty() )
+        {
+            stack[stackSize++] = 0;
+        }
+
+        while (stackSize != 0)
+        {
+            Node_t const &node = rState.octree[std::size_t(stack[--stackSize])];
+
+            if (node.mass == 0.0 || node.body == int32_t(i))
+            {
+                continue;
+            }
+
+            double const dx = node.comX - x;
+            double const dy = node.comY - y;
+            double const dz = node.comZ - z;
+            double const r2 = dx*dx + dy*dy + dz*dz + eps2;
+
+            double const size = node.halfSize * 2.0;
+            bool const farEnough = (size * size) < (theta2 * r2);
+
+            if (node.firstChild == Node_t::smc_empty || farEnough)
+            {
+                double const s = (r2 > 0.0) ? node.mass / (r2 * std::sqrt(r2)) : 0.0;
+                ax += dx * s;
+                ay += dy * s;
+                az += dz * s;
+            }
+            else
+            {
+                for (int32_t child = node.firstChild; child < node.firstChild + 8; ++child)
+                {
+                    stack[stackSize++] = child;
+                }
+            }
+        }
+
+        rState.accelX[i] = ax * params.gravConstant;
+        rState.accelY[i] = ay * params.gravConstant;
+        rState.accelZ[i] = az * params.gravConstant;
+    }
+}
+
+void nbody_step(NBodyState& rState, NBodyParams const& params, CoSpaceCommon& rSpace, NBodyMassView_t const mass, double const deltaTime,
+                Corrade::Containers::ArrayView<NBodyProxy const> const proxies, ParallelFor const& parallelFor,
+                Corrade::Containers::ArrayView<std::uint8_t const> const onRails)
+{
+    std::size_t const count = rSpace.m_satCount;
+
+    LGRN_ASSERTMV(mass.size() >= count, "Not enough masses given", mass.size(), count);
+    LGRN_ASSERTM( ! rSpace.positions_32bit(), "N-body spaces need 64-bit positions");
+
+    auto const [x, y, z]    = sat_views(rSpace.m_satPositions,  rSpace.m_data, count);
+    auto const [vx, vy, vz] = sat_views(rSpace.m_satVelocities, rSpace.m_data, count);
+
+    double const scale      = math::mul_2pow<double, int>(1.0, -rSpace.m_precision);
+    double const halfDelta  = deltaTime * 0.5;
+
+    nbody_resize(rState, count + proxies.size());
+    rState.proxyCount = proxies.size();
+
+    // Drift half a step
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        rState.posX[i] = double(x[i]) * scale + vx[i] * halfDelta;
+        rState.posY[i] = double(y[i]) * scale + vy[i] * halfDelta;
+        rState.posZ[i] = double(z[i]) * scale + vz[i] * halfDelta;
+        rState.mass[i] = mass[i];
+    }
+
+    for (std::size_t i = 0; i < proxies.size(); ++i)
+    {
+        NBodyProxy const& proxy = proxies[i];
+        rState.posX[count + i] = proxy.position.x() + proxy.velocity.x() * halfDelta;
+        rState.posY[count + i] = proxy.position.y() + proxy.velocity.y() * halfDelta;
+        rState.posZ[count + i] = proxy.position.z() + proxy.velocity.z() * halfDelta;
+        rState.mass[count + i] = proxy.mass;
+    }
+
+    std::size_t const total = count + proxies.size();
+    NBodyOffload &rOffload  = rState.offload;
+    rOffload.accelUsed      =    rOffload.enabled
+                              && rOffload.accelValid
+                              && rOffload.accelCount == total
+                              && rOffload.step + 1 - rOffload.accelStep <= rOffload.maxLag;
+
+    if (rOffload.accelUsed)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            rState.accelX[i] = rOffload.accel[i * 4 + 0];
+            rState.accelY[i] = rOffload.accel[i * 4 + 1];
+            rState.accelZ[i] = rOffload.accel[i * 4 + 2];
+        }
+    }
+    else
+    {
+        nbody_accelerations(rState, params, parallelFor);
+    }
+
+    if (rOffload.enabled)
+    {
+        // Hand this step's positions to the backend, relative to the center of mass
+        Vector3d    weighted{0.0};
+        double      massSum = 0.0;
+        for (std::size_t i = 0; i < total; ++i)
+        {
+            weighted += Vector3d{rState.posX[i], rState.posY[i], rState.posZ[i]} * rState.mass[i];
+            massSum  += rState.mass[i];
+        }
+        rOffload.origin = (massSum > 0.0) ? weighted / massSum : Vector3d{0.0};
+
+        rOffload.bodies.resize(total * 4);
+        for (std::size_t i = 0; i < total; ++i)
+        {
+            rOffload.bodies[i * 4 + 0] = float(rState.posX[i] - rOffload.origin.x());
+            rOffload.bodies[i * 4 + 1] = float(rState.posY[i] - rOffload.origin.y());
+            rOffload.bodies[i * 4 + 2] = float(rState.posZ[i] - rOffload.origin.z());
+            rOffload.bodies[i * 4 + 3] = float(rState.mass[i]);
+        }
+        ++rOffload.step;
+    }
+
+    // Kick, then drift the other half with the new velocity
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (i < onRails.size() && onRails[i] != 0)
+        {
+            continue;
+        }
+
+        double const newVx = vx[i] + rState.accelX[i] * deltaTime;
+        double const newVy = vy[i] + rState.accelY[i] * deltaTime;
+        double const newVz = vz[i] + rState.accelZ[i] * deltaTime;
+
+        x[i] += spaceint_t(std::llround((vx[i] + newVx) * halfDelta / scale));
+        y[i] += spaceint_t(std::llround((vy[i] + newVy) * halfDelta / scale));
+        z[i] += spaceint_t(std::llround((vz[i] + newVz) * halfDelta / scale));
+
+        vx[i] = newVx;
+        vy[i] = newVy;
+        vz[i] = newVz;
+    }
+}
+
+} // namespace osp::universe
@@ -0,0 +1,226 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "universe.h"
+
+#include "../core/parallel_for.h"
+
+#include <Corrade/Containers/ArrayView.h>
+#include <Corrade/Containers/StridedArrayView.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace osp::universe
+{
+
+enum class ENBodyMode : uint8_t
+{
+    /// Sum forces between every pair of bodies, O(n^2)
+    Direct,
+
+    /// Approximate far away groups of bodies with an octree, O(n log n)
+    BarnesHut
+};
+
+struct NBodyParams
+{
+    /// Gravitational constant in meters, kilograms (or whatever mass units), and seconds
+    double          gravConstant        {1.0};
+
+    /// Added to distances to avoid huge forces from close encounters, in meters
+    double          softening           {0.0};
+
+    /// Barnes-Hut opening angle; groups with (size / distance) < theta are approximated
+    double          theta               {0.5};
+
+    ENBodyMode      mode                {ENBodyMode::Direct};
+
+    /// Use Barnes-Hut regardless of mode once there are at least this many bodies. 0 to disable.
+    std::size_t     barnesHutMinBodies  {0};
+};
+
+struct NBodyOctreeNode
+{
+    static constexpr int32_t smc_empty      = -1;
+    static constexpr int32_t smc_aggregate  = -2;
+
+    // Mass-weighted position sum while building, center of mass after
+    double      comX{0.0};
+    double      comY{0.0};
+    double      comZ{0.0};
+    double      mass{0.0};
+
+    double      centerX;
+    double      centerY;
+    double      centerZ;
+    double      halfSize;
+
+    /// Index of first of 8 consecutive children, or smc_empty for leaves
+    int32_t     firstChild{smc_empty};
+
+    /// Body in this leaf, smc_empty, or smc_aggregate if bodies are too close to subdivide
+    int32_t     body{smc_empty};
+};
+
+/**
+ * @brief Positions and accelerations exchanged with a backend that calculates accelerations
+ *        asynchronously, such as a GPU compute shader
+ *
+ * When enabled, nbody_step writes single-precision positions of each step into bodies. Some
+ * time later, the backend writes accelerations of those positions into accel, along with the
+ * step they were calculated from. nbody_step uses them if they lag behind by at most maxLag
+ * steps, and falls back to nbody_accelerations otherwise.
+ *
+ * Positions are relative to origin, which is the center of mass of the bodies, keeping floats
+ * most precise where most of the mass is.
+ */
+struct NBodyOffload
+{
+    /// x, y, z, mass per body. Positions in meters relative to origin.
+    std::vector<float>  bodies;
+
+    /// x, y, z, unused per body, in meters per second squared
+    std::vector<float>  accel;
+
+    Vector3d            origin;
+
+    /// Step of bodies, incremented each time nbody_step writes them
+    std::uint64_t       step        {0};
+
+    /// Step of the bodies accel was calculated from, and their count
+    std::uint64_t       accelStep   {0};
+    std::size_t         accelCount  {0};
+
+    /// Steps accel may lag behind. Accelerations of the previous step's positions are off by
+    /// about velocity * deltaTime in position, fine if bodies move little per step.
+    std::uint64_t       maxLag      {1};
+
+    /// Set by the backend once it's able to run
+    bool                enabled     {false};
+    bool                accelValid  {false};
+
+    /// Set by nbody_step when accel was used, for stats
+    bool                accelUsed   {false};
+};
+
+/**
+ * @brief Scratch data for N-body calculations, kept between steps to avoid reallocating
+ *
+ * Positions and masses are copied into SoA arrays of doubles, in meters relative to the
+ * coordinate space origin.
+ */
+struct NBodyState
+{
+    std::vector<double>             posX;
+    std::vector<double>             posY;
+    std::vector<double>             posZ;
+    std::vector<double>             mass;
+
+    std::vector<double>             accelX;
+    std::vector<double>             accelY;
+    std::vector<double>             accelZ;
+
+    std::vector<NBodyOctreeNode>    octree;
+
+    NBodyOffload                    offload;
+
+    /// Last proxyCount bodies only attract others, their accelerations aren't calculated
+    std::size_t                     proxyCount{0};
+};
+
+/**
+ * @brief Body that attracts satellites in nbody_step without being moved by it, such as an
+ *        aggregate of satellites simulated by another shard, see sharding.h
+ */
+struct NBodyProxy
+{
+    Vector3d    position;   ///< Meters, relative to the coordinate space origin
+    Vector3d    velocity;   ///< Meters per second, used to predict its position mid-step
+    double      mass        {0.0};
+};
+
+using NBodyMassView_t = Corrade::Containers::StridedArrayView1D<float const>;
+
+/**
+ * @brief Resize NBodyState arrays for a number of bodies
+ */
+void nbody_resize(NBodyState& rState, std::size_t bodyCount);
+
+/**
+ * @brief Calculate accelerations of all bodies in rState from posX/Y/Z and mass, except for
+ *        the last rState.proxyCount
+ *
+ * Large body counts are split into ranges run through parallelFor, such as a task's
+ * WorkerContext::m_parallelFor to use the executor's workers.
+ */
+void nbody_accelerations(NBodyState& rState, NBodyParams const& params, ParallelFor const& parallelFor = {});
+
+/**
+ * @brief Calculate accelerations for bodies [first, last) by summing all pairs
+ *
+ * Safe to call from multiple threads at once for non-overlapping ranges.
+ */
+void nbody_accelerations_direct(NBodyState& rState, NBodyParams const& params, std::size_t first, std::size_t last) noexcept;
+
+/**
+ * @brief Build rState.octree from the current positions, used by nbody_accelerations_octree
+ */
+void nbody_build_octree(NBodyState& rState);
+
+/**
+ * @brief Calculate accelerations for bodies [first, last) using rState.octree
+ *
+ * Safe to call from multiple threads at once for non-overlapping ranges.
+ */
+void nbody_accelerations_octree(NBodyState& rState, NBodyParams const& params, std::size_t first, std::size_t last) noexcept;
+
+/**
+ * @brief Advance satellites of a coordinate space by one step of N-body gravity
+ *
+ * Uses a drift-kick-drift leapfrog integrator, which is symplectic and keeps orbits stable
+ * over long periods. Velocities are in meters per second. Positions are moved in integer
+ * space units, so they only accumulate rounding from their change per step.
+ *
+ * If rState.offload is enabled, accelerations are taken from it when recent enough, see
+ * NBodyOffload.
+ *
+ * Satellites flagged in onRails still attract others and get accelerations calculated, for
+ * rails_check_perturbations, but are left for rails_update to move.
+ *
+ * @param rSpace        [ref] Coordinate space with positions and velocities to update
+ * @param mass          [in] Mass of each satellite in rSpace
+ * @param deltaTime     [in] Time step in seconds
+ * @param proxies       [in] Extra bodies that attract satellites but aren't moved
+ * @param parallelFor   [in] Splits up calculating accelerations, see nbody_accelerations
+ * @param onRails       [in] Non-zero for satellites on rails, such as SatRails::onRails. May be
+ *                           shorter than the satellite count.
+ */
+void nbody_step(NBodyState& rState, NBodyParams const& params, CoSpaceCommon& rSpace, NBodyMassView_t mass, double deltaTime,
+                Corrade::Containers::ArrayView<NBodyProxy const> proxies = {}, ParallelFor const& parallelFor = {},
+                Corrade::Containers::ArrayView<std::uint8_t const> onRails = {});
+
+} // namespace osp::universe
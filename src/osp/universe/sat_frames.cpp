@@ -0,0 +1,192 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "sat_frames.h"
+
+#include <longeron/utility/asserts.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace osp::universe
+{
+
+namespace
+{
+
+/**
+ * @brief Get previous frame and interpolation factor from it to the latest frame
+ *
+ * @return Previous frame, or nullptr if there's nothing to interpolate from
+ */
+CoSpaceSatData const* interp_from(SatDataFrames const& frames, double const time, double& rAlpha) noexcept
+{
+    rAlpha = 1.0;
+
+    if (frames.frameCount < 3 || frames.published < 2)
+    {
+        return nullptr;
+    }
+
+    uint32_t const prev     = (frames.latest + frames.frameCount - 1) % frames.frameCount;
+    double const   prevTime = frames.times[prev];
+    double const   span     = frames.times[frames.latest] - prevTime;
+
+    if (span <= 0.0)
+    {
+        return nullptr;
+    }
+
+    rAlpha = std::clamp((time - prevTime) / span, 0.0, 1.0);
+    return &frames.frames[prev];
+}
+
+} // namespace
+
+void sat_frames_publish(SatDataFrames& rFrames, CoSpaceSatData const& space, double const time)
+{
+    LGRN_ASSERTMV(rFrames.frameCount >= 2 && rFrames.frameCount <= SatDataFrames::smc_maxFrames,
+                  "Invalid frame count", rFrames.frameCount);
+
+    uint32_t const next = (rFrames.published == 0) ? 0 : (rFrames.latest + 1) % rFrames.frameCount;
+
+    CoSpaceSatData &rFrame = rFrames.frames[next];
+
+    if (rFrame.m_data.size() != space.m_data.size())
+    {
+        rFrame.m_data = sat_data_alloc(space.m_data.size());
+    }
+
+    if ( ! space.m_data.isEmpty() )
+    {
+        std::memcpy(rFrame.m_data.data(), space.m_data.data(), space.m_data.size());
+    }
+
+    rFrame.m_satCount       = space.m_satCount;
+    rFrame.m_satCapacity    = space.m_satCapacity;
+    rFrame.m_satPositions   = space.m_satPositions;
+    rFrame.m_satPositions32 = space.m_satPositions32;
+    rFrame.m_satVelocities  = space.m_satVelocities;
+    rFrame.m_satRotations   = space.m_satRotations;
+
+    rFrames.times[next] = time;
+    rFrames.latest      = next;
+    ++rFrames.published;
+}
+
+void sat_frames_interpolate_positions(
+        SatDataFrames const&    frames,
+        double const            time,
+        SpaceIntView_t const    outX,
+        SpaceIntView_t const    outY,
+        SpaceIntView_t const    outZ) noexcept
+{
+    CoSpaceSatData const &latest = sat_frames_latest(frames);
+    std::size_t const     count  = latest.m_satCount;
+
+    LGRN_ASSERTMV(outX.size() >= count && outY.size() >= count && outZ.size() >= count,
+                  "Output views too small", outX.size(), count);
+
+    double alpha;
+    CoSpaceSatData const *pPrev = interp_from(frames, time, alpha);
+
+    std::size_t const interpCount = (pPrev != nullptr) ? std::min<std::size_t>(pPrev->m_satCount, count) : 0;
+
+    // Output is always spaceint_t, 32-bit local spaces are widened
+    visit_sat_positions(latest, count, [&] (auto const& x, auto const& y, auto const& z)
+    {
+        if (interpCount != 0)
+        {
+            visit_sat_positions(*pPrev, pPrev->m_satCount, [&] (auto const& px, auto const& py, auto const& pz)
+            {
+                // Lerp the difference only, so large positions don't lose precision as doubles
+                for (std::size_t i = 0; i < interpCount; ++i)
+                {
+                    outX[i] = px[i] + spaceint_t(std::llround(double(spaceint_t(x[i]) - px[i]) * alpha));
+                    outY[i] = py[i] + spaceint_t(std::llround(double(spaceint_t(y[i]) - py[i]) * alpha));
+                    outZ[i] = pz[i] + spaceint_t(std::llround(double(spaceint_t(z[i]) - pz[i]) * alpha));
+                }
+            });
+        }
+
+        for (std::size_t i = interpCount; i < count; ++i)
+        {
+            outX[i] = x[i];
+            outY[i] = y[i];
+            outZ[i] = z[i];
+        }
+    });
+}
+
+void sat_frames_interpolate_rotations(
+        SatDataFrames const& frames,
+        double const time,
+        std::array<Corrade::Containers::StridedArrayView1D<double>, 4> const& out) noexcept
+{
+    CoSpaceSatData const &latest = sat_frames_latest(frames);
+    std::size_t const     count  = latest.m_satCount;
+
+    for (auto const& view : out)
+    {
+        LGRN_ASSERTMV(view.size() >= count, "Output views too small", view.size(), count);
+    }
+
+    auto const q = sat_views(latest.m_satRotations, latest.m_data, count);
+
+    double alpha;
+    CoSpaceSatData const *pPrev = interp_from(frames, time, alpha);
+
+    std::size_t const interpCount = (pPrev != nullptr) ? std::min<std::size_t>(pPrev->m_satCount, count) : 0;
+
+    if (interpCount != 0)
+    {
+        auto const p = sat_views(pPrev->m_satRotations, pPrev->m_data, pPrev->m_satCount);
+
+        for (std::size_t i = 0; i < interpCount; ++i)
+        {
+            Quaterniond const from{{p[0][i], p[1][i], p[2][i]}, p[3][i]};
+            Quaterniond const to  {{q[0][i], q[1][i], q[2][i]}, q[3][i]};
+
+            // Take the shortest path; q and -q are the same rotation
+            Quaterniond const toNear = (Magnum::Math::dot(from, to) < 0.0) ? -to : to;
+            Quaterniond const result = (from * (1.0 - alpha) + toNear * alpha).normalized();
+
+            out[0][i] = result.vector().x();
+            out[1][i] = result.vector().y();
+            out[2][i] = result.vector().z();
+            out[3][i] = result.scalar();
+        }
+    }
+
+    for (std::size_t i = interpCount; i < count; ++i)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            out[c][i] = q[c][i];
+        }
+    }
+}
+
+} // namespace osp::universe
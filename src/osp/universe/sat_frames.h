@@ -0,0 +1,112 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "coordinates.h"
+#include "universe.h"
+
+#include <array>
+#include <cstdint>
+
+namespace osp::universe
+{
+
+/**
+ * @brief Published copies of a coordinate space's satellite data, for readers such as rendering
+ *
+ * The simulation keeps modifying CoSpaceCommon::m_data in place, then publishes it as a new frame
+ * once per tick. Readers use the latest frame (or interpolate between the latest two) instead of
+ * m_data, so they don't need to wait for the simulation to finish its tick, and can run at a
+ * different rate.
+ *
+ * Frames are kept in a ring. Publishing overwrites the oldest frame, so a reader that started
+ * before a publish can keep using the frames it got, as long as no second publish happens before
+ * it finishes. Publishing itself must still be ordered with readers (e.g. a short pipeline stage);
+ * there is no locking.
+ */
+struct SatDataFrames
+{
+    static constexpr uint32_t smc_maxFrames = 3;
+
+    /// Each frame is a complete copy of CoSpaceSatData, including its layout
+    std::array<CoSpaceSatData, smc_maxFrames>   frames{};
+    std::array<double, smc_maxFrames>           times{};
+
+    /// 2 for double buffering (latest frame only), 3 to also interpolate from the previous frame
+    uint32_t                                    frameCount{2};
+
+    /// Index of most recently published frame
+    uint32_t                                    latest{0};
+
+    /// Total number of frames published; 0 means no frames are valid yet
+    uint64_t                                    published{0};
+};
+
+/**
+ * @brief Get most recently published frame. Only valid if published != 0
+ */
+constexpr CoSpaceSatData const& sat_frames_latest(SatDataFrames const& frames) noexcept
+{
+    return frames.frames[frames.latest];
+}
+
+constexpr double sat_frames_latest_time(SatDataFrames const& frames) noexcept
+{
+    return frames.times[frames.latest];
+}
+
+/**
+ * @brief Copy a coordinate space's current satellite data into a new frame
+ *
+ * @param time  [in] Simulation time of the data, used for interpolation
+ */
+void sat_frames_publish(SatDataFrames& rFrames, CoSpaceSatData const& space, double time);
+
+/**
+ * @brief Interpolate satellite positions between the two latest frames
+ *
+ * Satellites only present in the latest frame aren't interpolated. Times outside of the two
+ * frames are clamped; there is no extrapolation.
+ *
+ * @param outX/Y/Z  [out] Positions for each satellite in the latest frame
+ */
+void sat_frames_interpolate_positions(
+        SatDataFrames const& frames,
+        double time,
+        SpaceIntView_t outX,
+        SpaceIntView_t outY,
+        SpaceIntView_t outZ) noexcept;
+
+/**
+ * @brief Interpolate satellite rotations between the two latest frames, using nlerp
+ *
+ * @param outX/Y/Z/W [out] Rotation components for each satellite in the latest frame
+ */
+void sat_frames_interpolate_rotations(
+        SatDataFrames const& frames,
+        double time,
+        std::array<Corrade::Containers::StridedArrayView1D<double>, 4> const& out) noexcept;
+
+} // namespace osp::universe
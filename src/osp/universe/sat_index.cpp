@@ -0,0 +1,366 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "sat_index.h"
+
+#include <Magnum/Math/Functions.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+
+namespace osp::universe
+{
+
+namespace
+{
+
+using Entry = SatSpatialIndex::Entry;
+
+constexpr uint32_t gc_cellMax = (uint32_t(1) << SatSpatialIndex::smc_bits) - 1;
+
+/// Spread the lower 21 bits of a value to every third bit
+constexpr uint64_t morton_spread(uint64_t v) noexcept
+{
+    v &= 0x1fffff;
+    v = (v | v << 32) & 0x1f00000000ffff;
+    v = (v | v << 16) & 0x1f0000ff0000ff;
+    v = (v | v << 8)  & 0x100f00f00f00f00f;
+    v = (v | v << 4)  & 0x10c30c30c30c30c3;
+    v = (v | v << 2)  & 0x1249249249249249;
+    return v;
+}
+
+struct Cell
+{
+    uint64_t x;
+    uint64_t y;
+    uint64_t z;
+    bool     inBounds;
+};
+
+Cell to_cell(SatSpatialIndex const& index, Vector3g const pos) noexcept
+{
+    // Unsigned differences so positions below the origin wrap to large (out of bounds) values
+    uint64_t const x = (uint64_t(pos.x()) - uint64_t(index.origin.x())) >> index.shift;
+    uint64_t const y = (uint64_t(pos.y()) - uint64_t(index.origin.y())) >> index.shift;
+    uint64_t const z = (uint64_t(pos.z()) - uint64_t(index.origin.z())) >> index.shift;
+    return { x, y, z, x <= gc_cellMax && y <= gc_cellMax && z <= gc_cellMax };
+}
+
+constexpr uint64_t cell_code(Cell const& cell) noexcept
+{
+    return morton_spread(cell.x) | (morton_spread(cell.y) << 1) | (morton_spread(cell.z) << 2);
+}
+
+constexpr bool code_less(Entry const& lhs, Entry const& rhs) noexcept
+{
+    return lhs.code < rhs.code;
+}
+
+double distance_sq(Vector3g const a, Vector3g const b) noexcept
+{
+    Vector3d const d{double(a.x() - b.x()), double(a.y() - b.y()), double(a.z() - b.z())};
+    return d.dot();
+}
+
+/**
+ * @brief Octree node of the implicit octree; a range of entries sharing a code prefix
+ */
+struct Node
+{
+    // Minimum corner in grid cell units
+    uint32_t    cellX;
+    uint32_t    cellY;
+    uint32_t    cellZ;
+
+    /// Node covers 2^level grid cells on each axis
+    int         level;
+
+    uint32_t    begin;
+    uint32_t    end;
+};
+
+double node_distance_sq(SatSpatialIndex const& index, Node const& node, Vector3g const point) noexcept
+{
+    double const size = std::ldexp(1.0, node.level + index.shift);
+
+    auto const axis = [size, shift = index.shift] (spaceint_t origin, uint32_t cell, spaceint_t p)
+    {
+        double const min = double(origin) + std::ldexp(double(cell), shift);
+        double const pd  = double(p);
+        double const d   = std::max({min - pd, 0.0, pd - (min + size)});
+        return d * d;
+    };
+
+    return   axis(index.origin.x(), node.cellX, point.x())
+           + axis(index.origin.y(), node.cellY, point.y())
+           + axis(index.origin.z(), node.cellZ, point.z());
+}
+
+/**
+ * @brief Call func(Node const&) for each non-empty child of a node
+ */
+template <typename FUNC_T>
+void for_each_child(SatSpatialIndex const& index, Node const& node, FUNC_T&& func)
+{
+    int const      childLevel = node.level - 1;
+    uint32_t const half       = uint32_t(1) << childLevel;
+    auto const     first      = index.entries.begin();
+
+    // Entries of a node are sorted by their child index, found in the code bits just below
+    // the node's prefix
+    uint32_t begin = node.begin;
+    for (uint32_t child = 0; child < 8 && begin < node.end; ++child)
+    {
+        Cell const childCell
+        {
+            node.cellX + ((child & 1) != 0 ? half : 0),
+            node.cellY + ((child & 2) != 0 ? half : 0),
+            node.cellZ + ((child & 4) != 0 ? half : 0),
+            true
+        };
+        uint64_t const childEnd = cell_code(childCell) + (uint64_t(1) << (3 * childLevel));
+
+        auto const endIt = std::lower_bound(first + begin, first + node.end, childEnd,
+                                            [] (Entry const& entry, uint64_t code) { return entry.code < code; });
+        uint32_t const end = uint32_t(endIt - first);
+
+        if (begin != end)
+        {
+            func(Node{uint32_t(childCell.x), uint32_t(childCell.y), uint32_t(childCell.z), childLevel, begin, end});
+        }
+        begin = end;
+    }
+}
+
+Node root_node(SatSpatialIndex const& index) noexcept
+{
+    return {0, 0, 0, SatSpatialIndex::smc_bits, 0, uint32_t(index.entries.size())};
+}
+
+void query_radius_recurse(SatSpatialIndex const& index, Node const& node, Vector3g const center, double const radiusSq, std::vector<SatId>& rOut)
+{
+    if (node_distance_sq(index, node, center) > radiusSq)
+    {
+        return;
+    }
+
+    if (node.end - node.begin <= SatSpatialIndex::smc_leafSize || node.level == 0)
+    {
+        for (uint32_t i = node.begin; i < node.end; ++i)
+        {
+            Entry const& entry = index.entries[i];
+            if (distance_sq(entry.position, center) <= radiusSq)
+            {
+                rOut.push_back(entry.sat);
+            }
+        }
+        return;
+    }
+
+    for_each_child(index, node, [&] (Node const& child)
+    {
+        query_radius_recurse(index, child, center, radiusSq, rOut);
+    });
+}
+
+} // namespace
+
+
+void sat_index_rebuild(SatSpatialIndex& rIndex, CoSpaceCommon const& space)
+{
+    std::size_t const count = space.m_satCount;
+
+    rIndex.entries.resize(count);
+    ++rIndex.rebuilds;
+
+    if (count == 0)
+    {
+        return;
+    }
+
+    visit_sat_positions(space, count, [&rIndex, count] (auto const& x, auto const& y, auto const& z)
+    {
+        Vector3g min{x[0], y[0], z[0]};
+        Vector3g max = min;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            min = Magnum::Math::min(min, Vector3g{x[i], y[i], z[i]});
+            max = Magnum::Math::max(max, Vector3g{x[i], y[i], z[i]});
+        }
+
+        // Loose bounds: add a margin of half the extent on each side, so satellites can move a bit
+        // before the index needs to be rebuilt
+        uint64_t extent = 1;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            extent = std::max<uint64_t>(extent, uint64_t(max[axis]) - uint64_t(min[axis]));
+        }
+        uint64_t const margin = extent / 2 + 1;
+
+        rIndex.shift = 0;
+        while (((extent + 2 * margin) >> rIndex.shift) > gc_cellMax)
+        {
+            ++rIndex.shift;
+        }
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            rIndex.origin[axis] = spaceint_t(uint64_t(min[axis]) - margin);
+        }
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            Entry &rEntry   = rIndex.entries[i];
+            rEntry.position = {x[i], y[i], z[i]};
+            rEntry.sat      = SatId(i);
+            rEntry.code     = cell_code(to_cell(rIndex, rEntry.position));
+        }
+
+        std::sort(rIndex.entries.begin(), rIndex.entries.end(), code_less);
+    });
+}
+
+void sat_index_update(SatSpatialIndex& rIndex, CoSpaceCommon const& space)
+{
+    std::size_t const count = space.m_satCount;
+
+    if (count != rIndex.entries.size() || (count != 0 && rIndex.rebuilds == 0))
+    {
+        sat_index_rebuild(rIndex, space);
+        return;
+    }
+
+    std::size_t changed     = 0;
+    bool        outOfBounds = false;
+    visit_sat_positions(space, count, [&] (auto const& x, auto const& y, auto const& z)
+    {
+        for (Entry &rEntry : rIndex.entries)
+        {
+            rEntry.position = {x[rEntry.sat], y[rEntry.sat], z[rEntry.sat]};
+
+            Cell const cell = to_cell(rIndex, rEntry.position);
+            if ( ! cell.inBounds )
+            {
+                outOfBounds = true;
+                return;
+            }
+
+            uint64_t const code = cell_code(cell);
+            changed += (code != rEntry.code) ? 1 : 0;
+            rEntry.code = code;
+        }
+    });
+
+    if (outOfBounds)
+    {
+        sat_index_rebuild(rIndex, space);
+        return;
+    }
+
+    if (changed == 0)
+    {
+        return;
+    }
+
+    // Insertion sort is close to linear if only a few entries are out of place
+    if (changed * 64 < count)
+    {
+        for (auto it = rIndex.entries.begin() + 1; it != rIndex.entries.end(); ++it)
+        {
+            std::rotate(std::upper_bound(rIndex.entries.begin(), it, *it, code_less), it, it + 1);
+        }
+    }
+    else
+    {
+        std::sort(rIndex.entries.begin(), rIndex.entries.end(), code_less);
+    }
+}
+
+void sat_index_query_radius(SatSpatialIndex const& index, Vector3g const center, double const radius, std::vector<SatId>& rOut)
+{
+    if (index.entries.empty())
+    {
+        return;
+    }
+
+    query_radius_recurse(index, root_node(index), center, radius * radius, rOut);
+}
+
+void sat_index_query_nearest(SatSpatialIndex const& index, Vector3g const center, std::size_t const k, std::vector<SatId>& rOut)
+{
+    if (index.entries.empty() || k == 0)
+    {
+        return;
+    }
+
+    // Best-first search. Candidates are either nodes (distance to their bounds) or single
+    // entries (exact distance); an entry popped first is closer than everything remaining.
+    struct Candidate
+    {
+        double      distanceSq;
+        Node        node;
+        bool        isEntry;
+
+        constexpr bool operator>(Candidate const& rhs) const noexcept { return distanceSq > rhs.distanceSq; }
+    };
+
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<>> queue;
+
+    Node const root = root_node(index);
+    queue.push({node_distance_sq(index, root, center), root, false});
+
+    std::size_t found = 0;
+    while ( ! queue.empty() && found < k )
+    {
+        Candidate const top = queue.top();
+        queue.pop();
+
+        if (top.isEntry)
+        {
+            rOut.push_back(index.entries[top.node.begin].sat);
+            ++found;
+        }
+        else if (top.node.end - top.node.begin <= SatSpatialIndex::smc_leafSize || top.node.level == 0)
+        {
+            for (uint32_t i = top.node.begin; i < top.node.end; ++i)
+            {
+                Node entryNode = top.node;
+                entryNode.begin = i;
+                queue.push({distance_sq(index.entries[i].position, center), entryNode, true});
+            }
+        }
+        else
+        {
+            for_each_child(index, top.node, [&] (Node const& child)
+            {
+                queue.push({node_distance_sq(index, child, center), child, false});
+            });
+        }
+    }
+}
+
+} // namespace osp::universe
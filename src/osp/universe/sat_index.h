@@ -0,0 +1,102 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "universe.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace osp::universe
+{
+
+/**
+ * @brief Spatial index over satellite positions of a coordinate space, for range queries
+ *
+ * Satellites are sorted by the Morton code (Z-order) of their position quantized to a loose
+ * grid, forming an implicit octree: each octree node is a contiguous range of entries. Grid
+ * bounds have a margin around the satellites, so the index only has to be rebuilt from scratch
+ * once a satellite moves out of them or satellites are added or removed.
+ *
+ * Used to find satellites near a point of interest (e.g. near the SceneFrame) without scanning
+ * all positions.
+ */
+struct SatSpatialIndex
+{
+    struct Entry
+    {
+        uint64_t    code;
+        Vector3g    position;
+        SatId       sat;
+    };
+
+    /// Bits per axis in a Morton code
+    static constexpr int smc_bits = 21;
+
+    /// Nodes with this many entries or less are tested entry-by-entry instead of subdivided
+    static constexpr std::size_t smc_leafSize = 16;
+
+    /// Sorted by code
+    std::vector<Entry>  entries;
+
+    /// Position of grid cell (0, 0, 0)
+    Vector3g            origin;
+
+    /// Grid cell size is 2^shift space units
+    int                 shift{0};
+
+    /// Number of from-scratch rebuilds, for profiling
+    uint32_t            rebuilds{0};
+};
+
+/**
+ * @brief Update index after satellites moved
+ *
+ * Only re-sorts entries that changed grid cells if few did. Rebuilds if satellite count changed
+ * or a satellite left the grid bounds.
+ */
+void sat_index_update(SatSpatialIndex& rIndex, CoSpaceCommon const& space);
+
+/**
+ * @brief Rebuild index from scratch, recalculating grid bounds
+ */
+void sat_index_rebuild(SatSpatialIndex& rIndex, CoSpaceCommon const& space);
+
+/**
+ * @brief Find all satellites within a radius of a point
+ *
+ * @param radius    [in] Radius in space units
+ * @param rOut      [out] Satellites found are appended, in no particular order
+ */
+void sat_index_query_radius(SatSpatialIndex const& index, Vector3g center, double radius, std::vector<SatId>& rOut);
+
+/**
+ * @brief Find the k nearest satellites to a point
+ *
+ * @param rOut      [out] Up to k satellites are appended, nearest first
+ */
+void sat_index_query_nearest(SatSpatialIndex const& index, Vector3g center, std::size_t k, std::vector<SatId>& rOut);
+
+} // namespace osp::universe
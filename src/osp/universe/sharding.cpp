@@ -0,0 +1,709 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "sharding.h"
+
+#include "../core/byte_stream.h"
+#include "../core/math_2pow.h"
+
+#include <longeron/utility/asserts.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <initializer_list>
+#include <limits>
+#include <type_traits>
+
+namespace osp::universe
+{
+
+namespace
+{
+
+struct ShardMsgHeader
+{
+    EShardMsg   type;
+    uint8_t     version;
+    uint16_t    reserved;
+    ShardId     from;
+    double      time;
+};
+
+static_assert(std::is_trivially_copyable_v<ShardMsgHeader>);
+
+// Columns present for a space in a boundary message
+enum : uint8_t
+{
+    gc_colPositions     = 1 << 0,
+    gc_colVelocities    = 1 << 1,
+    gc_colRotations     = 1 << 2
+};
+
+void write_header(std::vector<std::byte>& rOut, EShardMsg const type, ShardId const from, double const time)
+{
+    append_bytes(rOut, ShardMsgHeader{ .type = type, .version = gc_shardMsgVersion, .reserved = 0,
+                                       .from = from, .time = time });
+}
+
+EShardRead read_header(ByteReader& rReader, EShardMsg const type, ShardMsgHeader& rHeader)
+{
+    if ( ! rReader.read(rHeader) )
+    {
+        return EShardRead::Malformed;
+    }
+    if (rHeader.version != gc_shardMsgVersion)
+    {
+        return EShardRead::WrongVersion;
+    }
+    if (rHeader.type != type)
+    {
+        return EShardRead::WrongType;
+    }
+    if (rHeader.from == lgrn::id_null<ShardId>())
+    {
+        return EShardRead::Malformed;
+    }
+    return EShardRead::Ok;
+}
+
+uint8_t used_columns(CoSpaceSatData const& data) noexcept
+{
+    bool const hasPositions = ! data.m_satPositions[0].not_used() || data.positions_32bit();
+    return uint8_t(  (hasPositions                       ? gc_colPositions : 0)
+                   | (data.m_satVelocities[0].not_used() ? 0 : gc_colVelocities)
+                   | (data.m_satRotations[0] .not_used() ? 0 : gc_colRotations));
+}
+
+constexpr std::size_t sat_record_size(uint8_t const columns) noexcept
+{
+    return   ((columns & gc_colPositions)  ? sizeof(spaceint_t) * 3 : 0)
+           + ((columns & gc_colVelocities) ? sizeof(double) * 3     : 0)
+           + ((columns & gc_colRotations)  ? sizeof(double) * 4     : 0);
+}
+
+template <typename T, std::size_t N>
+void append_columns(std::vector<std::byte>& rOut, std::array<Corrade::Containers::StridedArrayView1D<T const>, N> const& views)
+{
+    for (auto const& view : views)
+    {
+        for (T const value : view)
+        {
+            append_bytes(rOut, value);
+        }
+    }
+}
+
+template <typename T, std::size_t N>
+void read_columns(ByteReader& rReader, std::array<Corrade::Containers::StridedArrayView1D<T>, N> const& views)
+{
+    for (auto const& view : views)
+    {
+        for (T &rValue : view)
+        {
+            // Can't fail, sizes are checked before
+            [[maybe_unused]] bool const ok = rReader.read(rValue);
+            LGRN_ASSERT(ok);
+        }
+    }
+}
+
+/**
+ * @brief Append x of all satellites, then y, then z. Always sent as spaceint_t, so the owner and
+ *        mirrors of a space don't need to use the same position width.
+ */
+void append_positions(std::vector<std::byte>& rOut, CoSpaceSatData const& space, std::size_t const count)
+{
+    visit_sat_positions(space, count, [&rOut] (auto const& x, auto const& y, auto const& z)
+    {
+        for (auto const *pView : {&x, &y, &z})
+        {
+            for (auto const value : *pView)
+            {
+                append_bytes(rOut, spaceint_t(value));
+            }
+        }
+    });
+}
+
+/**
+ * @brief Read positions written by append_positions, narrowing them if the space uses
+ *        m_satPositions32
+ */
+void read_positions(ByteReader& rReader, CoSpaceSatData& rSpace, std::size_t const count)
+{
+    visit_sat_positions(rSpace, count, [&rReader] (auto const& x, auto const& y, auto const& z)
+    {
+        for (auto const *pView : {&x, &y, &z})
+        {
+            for (auto &rValue : *pView)
+            {
+                spaceint_t value = 0;
+
+                // Can't fail, sizes are checked before
+                [[maybe_unused]] bool const ok = rReader.read(value);
+                LGRN_ASSERT(ok);
+                rValue = std::remove_reference_t<decltype(rValue)>(value);
+            }
+        }
+    });
+}
+
+template <typename T, std::size_t N>
+void skip_columns(ByteReader& rReader, std::size_t const count)
+{
+    ArrayView<std::byte const> skipped;
+    [[maybe_unused]] bool const ok = rReader.read_view(sizeof(T) * N * count, skipped);
+    LGRN_ASSERT(ok);
+}
+
+void queue_migration(ShardCtx& rCtx, ShardMigration const& migration)
+{
+    ShardId const owner = rCtx.map.owner(migration.dest);
+    LGRN_ASSERTMV(owner != lgrn::id_null<ShardId>(), "Destination space has no owner", migration.dest);
+
+    if (rCtx.migrationsOut.size() <= owner)
+    {
+        rCtx.migrationsOut.resize(std::size_t(owner) + 1);
+    }
+
+    std::vector<std::byte> &rOut = rCtx.migrationsOut[owner];
+    if (rOut.empty())
+    {
+        write_header(rOut, EShardMsg::Migration, rCtx.map.local, rCtx.time);
+    }
+
+    append_bytes(rOut, migration.dest);
+    append_bytes(rOut, migration.position);
+    append_bytes(rOut, migration.velocity);
+    append_bytes(rOut, migration.rotation);
+    append_bytes(rOut, uint32_t(migration.extra.size()));
+    append_bytes(rOut, migration.extra.data(), migration.extra.size());
+}
+
+} // namespace
+
+void shard_assign(ShardMap& rMap, CoSpaceId const space, ShardId const shard)
+{
+    if (rMap.spaceOwner.size() <= space)
+    {
+        rMap.spaceOwner.resize(std::size_t(space) + 1, lgrn::id_null<ShardId>());
+    }
+    rMap.spaceOwner[space] = shard;
+}
+
+bool shard_step(ShardCtx& rCtx, double const deltaTime) noexcept
+{
+    rCtx.time           += deltaTime;
+    rCtx.sinceExchange  += deltaTime;
+
+    if (rCtx.sinceExchange < rCtx.config.exchangeInterval)
+    {
+        return false;
+    }
+
+    // Keep the remainder so the rate stays constant, but don't catch up on missed exchanges
+    rCtx.sinceExchange = (rCtx.config.exchangeInterval > 0.0)
+                       ? std::fmod(rCtx.sinceExchange, rCtx.config.exchangeInterval)
+                       : 0.0;
+    return true;
+}
+
+void shard_mass_proxies(
+        CoSpaceCommon const&            space,
+        CoSpaceId const                 spaceId,
+        NBodyMassView_t const           mass,
+        double const                    cellSize,
+        std::vector<ShardMassProxy>&    rOut)
+{
+    std::size_t const count = space.m_satCount;
+
+    LGRN_ASSERTMV(mass.size() >= count, "Not enough masses given", mass.size(), count);
+
+    if (count == 0)
+    {
+        return;
+    }
+
+    bool const hasVelocities = ! space.m_satVelocities[0].not_used();
+
+    // Velocity views are only read if hasVelocities
+    auto const velocities = sat_views(space.m_satVelocities, space.m_data, count);
+
+    // Limited so cell indices and offsets within a cell can't overflow
+    double const     cellUnitsF = cellSize * math::mul_2pow<double, int>(1.0, space.m_precision);
+    spaceint_t const cellUnits  = spaceint_t(std::clamp(cellUnitsF, 1.0, double(math::int_2pow<spaceint_t>(48))));
+
+    auto const cell_of = [cellUnits] (spaceint_t const pos) noexcept
+    {
+        // Round towards negative infinity
+        spaceint_t const div = pos / cellUnits;
+        return (pos % cellUnits < 0) ? div - 1 : div;
+    };
+
+    struct Entry
+    {
+        std::array<spaceint_t, 3>   cell;
+        SatId                       sat;
+    };
+
+    visit_sat_positions(space, count, [&] (auto const& x, auto const& y, auto const& z)
+    {
+        auto const& [vx, vy, vz] = velocities;
+
+        std::vector<Entry> entries;
+        entries.reserve(count);
+        for (SatId sat = 0; sat < count; ++sat)
+        {
+            if (mass[sat] > 0.0f)
+            {
+                entries.push_back({ {cell_of(x[sat]), cell_of(y[sat]), cell_of(z[sat])}, sat });
+            }
+        }
+
+        std::sort(entries.begin(), entries.end(), [] (Entry const& lhs, Entry const& rhs) noexcept
+        {
+            return lhs.cell < rhs.cell;
+        });
+
+        for (auto itFirst = entries.begin(); itFirst != entries.end(); )
+        {
+            auto const itLast = std::find_if(itFirst, entries.end(), [&itFirst] (Entry const& entry) noexcept
+            {
+                return entry.cell != itFirst->cell;
+            });
+
+            // Sum offsets from the first satellite, so large positions don't lose precision
+            SatId const ref = itFirst->sat;
+            Vector3g const refPos{x[ref], y[ref], z[ref]};
+
+            Vector3d offsetSum{0.0};
+            Vector3d momentum{0.0};
+            double   massSum = 0.0;
+
+            for (auto it = itFirst; it != itLast; ++it)
+            {
+                SatId const  sat = it->sat;
+                double const m   = mass[sat];
+                offsetSum += Vector3d(Vector3g{x[sat], y[sat], z[sat]} - refPos) * m;
+                if (hasVelocities)
+                {
+                    momentum += Vector3d{vx[sat], vy[sat], vz[sat]} * m;
+                }
+                massSum += m;
+            }
+
+            Vector3d const offset = offsetSum / massSum;
+            rOut.push_back({
+                .space      = spaceId,
+                .position   = refPos + Vector3g{std::llround(offset.x()), std::llround(offset.y()), std::llround(offset.z())},
+                .velocity   = momentum / massSum,
+                .mass       = massSum });
+
+            itFirst = itLast;
+        }
+    });
+}
+
+void shard_proxies_to_nbody(
+        ArrayView<ShardMassProxy const> const   proxies,
+        CoSpaceId const                         from,
+        CoordTransformer const&                 fromToTarget,
+        int const                               precision,
+        std::vector<NBodyProxy>&                rOut)
+{
+    double const      scale     = math::mul_2pow<double, int>(1.0, -precision);
+    Quaterniond const rotation  = fromToTarget.rotation();
+
+    for (ShardMassProxy const& proxy : proxies)
+    {
+        if (proxy.space != from)
+        {
+            continue;
+        }
+
+        rOut.push_back({
+            .position   = Vector3d(fromToTarget.transform_position(proxy.position)) * scale,
+            .velocity   = quat_non_zero(rotation) ? rotation.transformVector(proxy.velocity) : proxy.velocity,
+            .mass       = proxy.mass });
+    }
+}
+
+void shard_write_boundary(
+        ShardCtx const&                         ctx,
+        Universe const&                         universe,
+        ShardId const                           peer,
+        ArrayView<ShardMassProxy const> const   proxies,
+        std::vector<std::byte>&                 rOut)
+{
+    rOut.clear();
+    write_header(rOut, EShardMsg::Boundary, ctx.map.local, ctx.time);
+
+    ArrayView<CoSpaceId const> const spaces = (peer < ctx.peerSpaces.size())
+                                            ? ArrayView<CoSpaceId const>{ctx.peerSpaces[peer].data(), ctx.peerSpaces[peer].size()}
+                                            : ArrayView<CoSpaceId const>{};
+
+    append_bytes(rOut, uint32_t(spaces.size()));
+
+    for (CoSpaceId const spaceId : spaces)
+    {
+        LGRN_ASSERTMV(ctx.map.owns(spaceId), "Mirrored space must be owned by this shard", spaceId);
+
+        CoSpaceCommon const &rSpace  = universe.m_coordCommon[spaceId];
+        std::size_t const   count    = rSpace.m_satCount;
+        uint8_t const       columns  = used_columns(rSpace);
+
+        append_bytes(rOut, spaceId);
+        append_bytes(rOut, uint32_t(count));
+        append_bytes(rOut, columns);
+
+        rOut.reserve(rOut.size() + count * sat_record_size(columns));
+
+        // Column by column, x of all satellites, then y...
+        if (columns & gc_colPositions)
+        {
+            append_positions(rOut, rSpace, count);
+        }
+        if (columns & gc_colVelocities)
+        {
+            append_columns(rOut, sat_views(rSpace.m_satVelocities, rSpace.m_data, count));
+        }
+        if (columns & gc_colRotations)
+        {
+            append_columns(rOut, sat_views(rSpace.m_satRotations, rSpace.m_data, count));
+        }
+    }
+
+    append_bytes(rOut, uint32_t(proxies.size()));
+    for (ShardMassProxy const& proxy : proxies)
+    {
+        append_bytes(rOut, proxy.space);
+        append_bytes(rOut, proxy.position);
+        append_bytes(rOut, proxy.velocity);
+        append_bytes(rOut, proxy.mass);
+    }
+}
+
+EShardRead shard_read_boundary(ShardCtx& rCtx, Universe& rUniverse, ArrayView<std::byte const> const message)
+{
+    ByteReader reader{message};
+
+    ShardMsgHeader header;
+    if (EShardRead const status = read_header(reader, EShardMsg::Boundary, header);
+        status != EShardRead::Ok)
+    {
+        return status;
+    }
+
+    // Read everything first, so nothing is applied from a malformed message
+
+    struct SpaceBlock
+    {
+        CoSpaceId                   space;
+        uint32_t                    count;
+        uint8_t                     columns;
+        ArrayView<std::byte const>  data;
+    };
+
+    std::vector<SpaceBlock> blocks;
+
+    uint32_t spaceCount;
+    if ( ! reader.read(spaceCount) )
+    {
+        return EShardRead::Malformed;
+    }
+
+    for (uint32_t i = 0; i < spaceCount; ++i)
+    {
+        SpaceBlock &rBlock = blocks.emplace_back();
+        if (   ! reader.read(rBlock.space)
+            || ! reader.read(rBlock.count)
+            || ! reader.read(rBlock.columns)
+            || ! reader.read_view(std::size_t(rBlock.count) * sat_record_size(rBlock.columns), rBlock.data))
+        {
+            return EShardRead::Malformed;
+        }
+    }
+
+    uint32_t proxyCount;
+    if ( ! reader.read(proxyCount) || proxyCount > reader.remaining().size() )
+    {
+        return EShardRead::Malformed;
+    }
+
+    std::vector<ShardMassProxy> proxies(proxyCount);
+    for (ShardMassProxy &rProxy : proxies)
+    {
+        if (   ! reader.read(rProxy.space)
+            || ! reader.read(rProxy.position)
+            || ! reader.read(rProxy.velocity)
+            || ! reader.read(rProxy.mass))
+        {
+            return EShardRead::Malformed;
+        }
+    }
+
+    if ( ! reader.remaining().isEmpty() )
+    {
+        return EShardRead::Malformed;
+    }
+
+    // Apply
+
+    rCtx.mirrorTime.resize(rUniverse.m_coordCommon.size(), -std::numeric_limits<double>::infinity());
+
+    for (SpaceBlock const& block : blocks)
+    {
+        if (   block.space >= rUniverse.m_coordCommon.size()
+            || ! rUniverse.m_coordIds.exists(block.space)
+            || rCtx.map.owner(block.space) != header.from
+            || rCtx.map.owns(block.space)
+            || rCtx.mirrorTime[block.space] >= header.time)
+        {
+            continue;
+        }
+
+        CoSpaceCommon &rSpace = rUniverse.m_coordCommon[block.space];
+
+        if (block.count > rSpace.m_satCapacity)
+        {
+            if (rSpace.m_satCapacity == 0)
+            {
+                continue; // Not partitioned, can't be mirrored
+            }
+            sat_reserve(rSpace, block.count);
+        }
+
+        rSpace.m_satCount = block.count;
+
+        // Columns the mirror uses but the owner doesn't are left zeroed, or identity for rotations
+
+        uint8_t const local = used_columns(rSpace);
+        ByteReader satReader{block.data};
+        std::size_t const count = block.count;
+
+        if (local & gc_colPositions)
+        {
+            if (block.columns & gc_colPositions)
+            {
+                read_positions(satReader, rSpace, count);
+            }
+            else
+            {
+                visit_sat_positions(rSpace, count, [] (auto const& x, auto const& y, auto const& z)
+                {
+                    for (auto const *pView : {&x, &y, &z}) { for (auto &rValue : *pView) { rValue = 0; } }
+                });
+            }
+        }
+        else if (block.columns & gc_colPositions)
+        {
+            skip_columns<spaceint_t, 3>(satReader, count);
+        }
+
+        if (local & gc_colVelocities)
+        {
+            auto const views = sat_views(rSpace.m_satVelocities, rSpace.m_data, count);
+            if (block.columns & gc_colVelocities)
+            {
+                read_columns(satReader, views);
+            }
+            else
+            {
+                for (auto const& view : views) { for (double &rValue : view) { rValue = 0.0; } }
+            }
+        }
+        else if (block.columns & gc_colVelocities)
+        {
+            skip_columns<double, 3>(satReader, count);
+        }
+
+        if (local & gc_colRotations)
+        {
+            auto const views = sat_views(rSpace.m_satRotations, rSpace.m_data, count);
+            if (block.columns & gc_colRotations)
+            {
+                read_columns(satReader, views);
+            }
+            else
+            {
+                for (auto const& view : views) { for (double &rValue : view) { rValue = 0.0; } }
+                for (double &rValue : views[3]) { rValue = 1.0; }
+            }
+        }
+
+        rCtx.mirrorTime[block.space] = header.time;
+    }
+
+    if (rCtx.peerProxies.size() <= header.from)
+    {
+        rCtx.peerProxies.resize(std::size_t(header.from) + 1);
+    }
+    rCtx.peerProxies[header.from] = std::move(proxies);
+
+    return EShardRead::Ok;
+}
+
+void shard_migrate_out(
+        ShardCtx&                           rCtx,
+        Universe&                           rUniverse,
+        CoSpaceId const                     from,
+        SatId const                         sat,
+        CoSpaceId const                     dest,
+        CoordTransformer const&             fromToDest,
+        ArrayView<std::byte const> const    extra,
+        std::vector<SatRemap>&              rMoved,
+        SatExtraColumns_t const             extraColumns)
+{
+    LGRN_ASSERTMV(rCtx.map.owns(from), "Satellites can only migrate out of spaces this shard owns", from);
+
+    CoSpaceCommon &rSpace = rUniverse.m_coordCommon[from];
+    std::size_t const count = rSpace.m_satCount;
+
+    LGRN_ASSERTMV(sat < count, "Satellite doesn't exist", sat, count);
+
+    uint8_t const columns = used_columns(rSpace);
+
+    Vector3g    position;
+    Vector3d    velocity{0.0};
+    Quaterniond rotation;
+
+    if (columns & gc_colPositions)
+    {
+        position = visit_sat_positions(rSpace, count, [sat] (auto const& x, auto const& y, auto const& z)
+        {
+            return Vector3g{x[sat], y[sat], z[sat]};
+        });
+    }
+    if (columns & gc_colVelocities)
+    {
+        auto const [vx, vy, vz] = sat_views(rSpace.m_satVelocities, rSpace.m_data, count);
+        velocity = {vx[sat], vy[sat], vz[sat]};
+    }
+    if (columns & gc_colRotations)
+    {
+        auto const [qx, qy, qz, qw] = sat_views(rSpace.m_satRotations, rSpace.m_data, count);
+        rotation = {{qx[sat], qy[sat], qz[sat]}, qw[sat]};
+    }
+
+    Quaterniond const tfRot = fromToDest.rotation();
+    bool const rotated = quat_non_zero(tfRot);
+
+    queue_migration(rCtx, ShardMigration{
+        .dest       = dest,
+        .position   = fromToDest.transform_position(position),
+        .velocity   = rotated ? tfRot.transformVector(velocity) : velocity,
+        .rotation   = rotated ? tfRot * rotation : rotation,
+        .extra      = extra });
+
+    sat_remove(rSpace, sat, rMoved, extraColumns);
+}
+
+EShardRead shard_read_migrations(ShardCtx& rCtx, ArrayView<std::byte const> const message, std::vector<ShardMigration>& rOut)
+{
+    ByteReader reader{message};
+
+    ShardMsgHeader header;
+    if (EShardRead const status = read_header(reader, EShardMsg::Migration, header);
+        status != EShardRead::Ok)
+    {
+        return status;
+    }
+
+    std::size_t const outBefore = rOut.size();
+    std::vector<ShardMigration> forward;
+
+    while ( ! reader.remaining().isEmpty() )
+    {
+        ShardMigration migration;
+        uint32_t       extraSize;
+        if (   ! reader.read(migration.dest)
+            || ! reader.read(migration.position)
+            || ! reader.read(migration.velocity)
+            || ! reader.read(migration.rotation)
+            || ! reader.read(extraSize)
+            || ! reader.read_view(extraSize, migration.extra))
+        {
+            rOut.resize(outBefore);
+            return EShardRead::Malformed;
+        }
+
+        if (rCtx.map.owns(migration.dest))
+        {
+            rOut.push_back(migration);
+        }
+        else if (rCtx.map.owner(migration.dest) != lgrn::id_null<ShardId>())
+        {
+            forward.push_back(migration);
+        }
+        // else the destination space no longer exists, the satellite is lost with it
+    }
+
+    for (ShardMigration const& migration : forward)
+    {
+        queue_migration(rCtx, migration);
+    }
+
+    return EShardRead::Ok;
+}
+
+SatId shard_accept_migration(Universe& rUniverse, ShardMigration const& migration, SatExtraColumns_t const extraColumns)
+{
+    CoSpaceCommon &rSpace = rUniverse.m_coordCommon[migration.dest];
+
+    SatId const sat = sat_create(rSpace, extraColumns);
+    std::size_t const count = rSpace.m_satCount;
+
+    uint8_t const columns = used_columns(rSpace);
+
+    if (columns & gc_colPositions)
+    {
+        visit_sat_positions(rSpace, count, [sat, &migration] (auto const& x, auto const& y, auto const& z)
+        {
+            using Int_t = std::remove_reference_t<decltype(x[sat])>;
+            x[sat] = Int_t(migration.position.x());
+            y[sat] = Int_t(migration.position.y());
+            z[sat] = Int_t(migration.position.z());
+        });
+    }
+    if (columns & gc_colVelocities)
+    {
+        auto const [vx, vy, vz] = sat_views(rSpace.m_satVelocities, rSpace.m_data, count);
+        vx[sat] = migration.velocity.x();
+        vy[sat] = migration.velocity.y();
+        vz[sat] = migration.velocity.z();
+    }
+    if (columns & gc_colRotations)
+    {
+        auto const [qx, qy, qz, qw] = sat_views(rSpace.m_satRotations, rSpace.m_data, count);
+        qx[sat] = migration.rotation.vector().x();
+        qy[sat] = migration.rotation.vector().y();
+        qz[sat] = migration.rotation.vector().z();
+        qw[sat] = migration.rotation.scalar();
+    }
+
+    return sat;
+}
+
+} // namespace osp::universe
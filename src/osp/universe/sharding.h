@@ -0,0 +1,247 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "coordinates.h"
+#include "nbody.h"
+#include "universe.h"
+
+#include "../core/array_view.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace osp::universe
+{
+
+using ShardId = uint32_t;
+
+/**
+ * @brief Version of boundary and migration messages
+ *
+ * Increment whenever their layout changes.
+ */
+constexpr uint8_t gc_shardMsgVersion = 1;
+
+enum class EShardMsg : uint8_t { Boundary = 1, Migration = 2 };
+
+enum class EShardRead : uint8_t
+{
+    Ok,
+    Malformed,
+    WrongVersion,
+    WrongType
+};
+
+/**
+ * @brief Which shard owns each coordinate space
+ *
+ * Every shard keeps an identical copy. A shard only steps the spaces it owns, other spaces it
+ * needs are kept as mirrors updated by boundary messages from their owners.
+ *
+ * To move a whole space to a different shard, send the new owner a boundary message with the
+ * space, then shard_assign it on every shard.
+ */
+struct ShardMap
+{
+    [[nodiscard]] ShardId owner(CoSpaceId const space) const noexcept
+    {
+        return (space < spaceOwner.size()) ? spaceOwner[space] : lgrn::id_null<ShardId>();
+    }
+
+    [[nodiscard]] bool owns(CoSpaceId const space) const noexcept
+    {
+        return owner(space) == local;
+    }
+
+    /// Indexed by CoSpaceId, null for unassigned spaces
+    std::vector<ShardId>    spaceOwner;
+
+    /// Shard this process is
+    ShardId                 local{lgrn::id_null<ShardId>()};
+};
+
+void shard_assign(ShardMap& rMap, CoSpaceId space, ShardId shard);
+
+/**
+ * @brief Satellites of a coordinate space aggregated into one attracting body, for gravity
+ *        from satellites simulated by another shard
+ */
+struct ShardMassProxy
+{
+    CoSpaceId   space;
+    Vector3g    position;   ///< Center of mass, in space units of space
+    Vector3d    velocity;   ///< Mass-weighted mean, meters per second
+    double      mass;
+};
+
+struct ShardConfig
+{
+    /// Simulated seconds between boundary exchanges, 0 to exchange every step
+    double      exchangeInterval    {1.0};
+
+    /// Satellites are aggregated into mass proxies per cube of this size, in meters
+    double      proxyCellSize       {1.0e9};
+};
+
+/**
+ * @brief State of one shard of a Universe split across processes or machines
+ *
+ * Messages are byte buffers in native byte order, to be sent to other shards over any reliable
+ * transport. Boundary messages can be large, as they hold all satellites of mirrored spaces.
+ */
+struct ShardCtx
+{
+    ShardMap                                    map;
+    ShardConfig                                 config;
+
+    /// Simulated time, sent with boundary messages so outdated ones are dropped
+    double                                      time            {0.0};
+    double                                      sinceExchange   {0.0};
+
+    /// Spaces owned by this shard that each other shard mirrors, indexed by ShardId
+    std::vector< std::vector<CoSpaceId> >       peerSpaces;
+
+    /// Time of the latest boundary state applied to each mirrored space, indexed by CoSpaceId
+    std::vector<double>                         mirrorTime;
+
+    /// Latest mass proxies received from each other shard, indexed by ShardId
+    std::vector< std::vector<ShardMassProxy> >  peerProxies;
+
+    /// Migration messages waiting to be sent to each other shard, indexed by ShardId.
+    /// Send and clear non-empty ones after each step.
+    std::vector< std::vector<std::byte> >       migrationsOut;
+};
+
+/**
+ * @brief Advance ShardCtx::time by one step
+ *
+ * @return true if boundary messages are due to be sent this step
+ */
+bool shard_step(ShardCtx& rCtx, double deltaTime) noexcept;
+
+/**
+ * @brief Aggregate satellites of a coordinate space into mass proxies, one per occupied cube of
+ *        cellSize meters
+ *
+ * @param rOut  [out] Proxies are appended
+ */
+void shard_mass_proxies(
+        CoSpaceCommon const&            space,
+        CoSpaceId                       spaceId,
+        NBodyMassView_t                 mass,
+        double                          cellSize,
+        std::vector<ShardMassProxy>&    rOut);
+
+/**
+ * @brief Convert proxies of one coordinate space into bodies for nbody_step of another
+ *
+ * @param from          [in] Only proxies of this space are converted
+ * @param fromToTarget  [in] Transform from space units of from to the target space
+ * @param precision     [in] Precision of the target space
+ * @param rOut          [out] Bodies are appended, relative to the target space origin
+ */
+void shard_proxies_to_nbody(
+        ArrayView<ShardMassProxy const> proxies,
+        CoSpaceId                       from,
+        CoordTransformer const&         fromToTarget,
+        int                             precision,
+        std::vector<NBodyProxy>&        rOut);
+
+/**
+ * @brief Write a boundary message for a peer, with all satellites of the spaces it mirrors
+ *        (ShardCtx::peerSpaces) and mass proxies of this shard's satellites
+ *
+ * @param rOut  [out] Cleared, then the message
+ */
+void shard_write_boundary(
+        ShardCtx const&                 ctx,
+        Universe const&                 universe,
+        ShardId                         peer,
+        ArrayView<ShardMassProxy const> proxies,
+        std::vector<std::byte>&         rOut);
+
+/**
+ * @brief Apply a boundary message from another shard to mirrored spaces
+ *
+ * Spaces that aren't owned by the sender, are owned by this shard, or already have newer state
+ * are skipped. Mirrors grow with sat_reserve, so mirrored spaces need to be partitioned already
+ * and can't have columns described outside of CoSpaceSatData.
+ */
+EShardRead shard_read_boundary(ShardCtx& rCtx, Universe& rUniverse, ArrayView<std::byte const> message);
+
+/**
+ * @brief Remove a satellite from a space this shard owns, and queue it in
+ *        ShardCtx::migrationsOut for the shard that owns its destination
+ *
+ * @param fromToDest    [in] Transform from space units of from to dest
+ * @param extra         [in] Other data of the satellite, such as its mass
+ * @param rMoved        [out] See sat_remove
+ */
+void shard_migrate_out(
+        ShardCtx&                       rCtx,
+        Universe&                       rUniverse,
+        CoSpaceId                       from,
+        SatId                           sat,
+        CoSpaceId                       dest,
+        CoordTransformer const&         fromToDest,
+        ArrayView<std::byte const>      extra,
+        std::vector<SatRemap>&          rMoved,
+        SatExtraColumns_t               extraColumns = {});
+
+/**
+ * @brief Satellite arriving from another shard, read by shard_read_migrations
+ */
+struct ShardMigration
+{
+    CoSpaceId                   dest;
+    Vector3g                    position;
+    Vector3d                    velocity;
+    Quaterniond                 rotation;
+
+    /// Points into the message
+    ArrayView<std::byte const>  extra;
+};
+
+/**
+ * @brief Read satellites migrating to this shard from a migration message
+ *
+ * Migrations to spaces that changed owner since they were sent are queued in
+ * ShardCtx::migrationsOut for their new owner instead.
+ *
+ * @param rOut  [out] Migrations are appended, add them with shard_accept_migration
+ */
+EShardRead shard_read_migrations(ShardCtx& rCtx, ArrayView<std::byte const> message, std::vector<ShardMigration>& rOut);
+
+/**
+ * @brief Add a migrated satellite to its destination space
+ *
+ * @return SatId of the new satellite. Columns in extraColumns are left for the caller to fill
+ *         from ShardMigration::extra.
+ */
+SatId shard_accept_migration(Universe& rUniverse, ShardMigration const& migration, SatExtraColumns_t extraColumns = {});
+
+} // namespace osp::universe
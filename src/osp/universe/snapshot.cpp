@@ -0,0 +1,356 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "snapshot.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#if defined(__linux__) || defined(__APPLE__)
+    #define OSP_SNAPSHOT_MMAP 1
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <unistd.h>
+#else
+    #define OSP_SNAPSHOT_MMAP 0
+#endif
+
+namespace osp::universe
+{
+
+static_assert(std::is_trivially_copyable_v<SnapshotHeader>);
+static_assert(std::is_trivially_copyable_v<SnapshotSpace>);
+
+namespace
+{
+
+constexpr char     gc_magic[8]  = {'O', 'S', 'P', 'U', 'N', 'I', 'V', '\0'};
+constexpr uint32_t gc_endian    = 0x01020304;
+
+struct FileCloser
+{
+    void operator()(std::FILE* pFile) const noexcept { std::fclose(pFile); }
+};
+
+using File_t = std::unique_ptr<std::FILE, FileCloser>;
+
+constexpr uint64_t align_blob(uint64_t const pos) noexcept
+{
+    return (pos + gc_snapshotBlobAlignment - 1) & ~(gc_snapshotBlobAlignment - 1);
+}
+
+template <typename T, std::size_t N>
+void write_strides(SnapshotStride (&rOut)[N], StrideDescArray_t<T, N> const& descs) noexcept
+{
+    for (std::size_t i = 0; i < N; ++i)
+    {
+        rOut[i] = {descs[i].m_offset, int64_t(descs[i].m_stride)};
+    }
+}
+
+template <typename T, std::size_t N>
+void read_strides(StrideDescArray_t<T, N>& rOut, SnapshotStride const (&in)[N]) noexcept
+{
+    for (std::size_t i = 0; i < N; ++i)
+    {
+        rOut[i].m_offset = std::size_t(in[i].offset);
+        rOut[i].m_stride = std::ptrdiff_t(in[i].stride);
+    }
+}
+
+#if OSP_SNAPSHOT_MMAP
+void munmap_deleter(unsigned char* pData, std::size_t size)
+{
+    ::munmap(pData, size);
+}
+#endif
+
+/**
+ * @brief Fill the header and a SnapshotSpace per CoSpaceId, laying out data blobs in the file
+ */
+void make_records(Universe const& universe, SnapshotHeader& rHeader, std::vector<SnapshotSpace>& rSpaces)
+{
+    std::size_t const spaceCapacity = universe.m_coordCommon.size();
+
+    rHeader = {};
+    std::memcpy(rHeader.magic, gc_magic, sizeof(gc_magic));
+    rHeader.version          = gc_snapshotVersion;
+    rHeader.endianCheck      = gc_endian;
+    rHeader.spaceCapacity    = uint32_t(spaceCapacity);
+
+    rSpaces.assign(spaceCapacity, SnapshotSpace{});
+
+    uint64_t pos = sizeof(SnapshotHeader) + sizeof(SnapshotSpace) * spaceCapacity;
+
+    for (CoSpaceId id = 0; id < spaceCapacity; ++id)
+    {
+        CoSpaceCommon const &rCommon = universe.m_coordCommon[id];
+        SnapshotSpace &rOut = rSpaces[id];
+
+        rOut.exists = universe.m_coordIds.exists(id) ? 1 : 0;
+
+        rOut.rotation[0] = rCommon.m_rotation.vector().x();
+        rOut.rotation[1] = rCommon.m_rotation.vector().y();
+        rOut.rotation[2] = rCommon.m_rotation.vector().z();
+        rOut.rotation[3] = rCommon.m_rotation.scalar();
+        rOut.position[0] = rCommon.m_position.x();
+        rOut.position[1] = rCommon.m_position.y();
+        rOut.position[2] = rCommon.m_position.z();
+        rOut.precision   = rCommon.m_precision;
+        rOut.parent      = rCommon.m_parent;
+        rOut.parentSat   = rCommon.m_parentSat;
+
+        // Satellite data may be left uninitialized for spaces that don't use it
+        bool const hasData  = ! rCommon.m_data.isEmpty();
+        rOut.satCount       = hasData ? rCommon.m_satCount    : 0;
+        rOut.satCapacity    = hasData ? rCommon.m_satCapacity : 0;
+
+        write_strides(rOut.satPositions,  rCommon.m_satPositions);
+        write_strides(rOut.satVelocities, rCommon.m_satVelocities);
+        write_strides(rOut.satRotations,  rCommon.m_satRotations);
+        write_strides(rOut.satPositions32, rCommon.m_satPositions32);
+
+        rOut.dataSize   = rCommon.m_data.size();
+        rOut.dataOffset = hasData ? align_blob(pos) : 0;
+        if (hasData)
+        {
+            pos = rOut.dataOffset + rOut.dataSize;
+        }
+    }
+}
+
+/**
+ * @param writeData [in] Called as writeData(CoSpaceId, std::FILE*) -> bool to write each blob
+ */
+template <typename FUNC_T>
+ESnapshotStatus write_file(SnapshotHeader const& header, std::vector<SnapshotSpace> const& spaces, char const* const path, FUNC_T&& writeData)
+{
+    File_t const pFile{std::fopen(path, "wb")};
+    if (pFile == nullptr)
+    {
+        return ESnapshotStatus::CantOpen;
+    }
+
+    std::size_t const spaceCapacity = spaces.size();
+
+    bool ok =  std::fwrite(&header, sizeof(header), 1, pFile.get()) == 1
+            && std::fwrite(spaces.data(), sizeof(SnapshotSpace), spaceCapacity, pFile.get()) == spaceCapacity;
+
+    uint64_t pos = sizeof(SnapshotHeader) + sizeof(SnapshotSpace) * spaceCapacity;
+
+    for (CoSpaceId id = 0; ok && id < spaceCapacity; ++id)
+    {
+        SnapshotSpace const &rSpace = spaces[id];
+        if (rSpace.dataSize == 0)
+        {
+            continue;
+        }
+
+        // Zero padding up to the aligned blob offset
+        static constexpr unsigned char const sc_zeros[4096]{};
+        while (ok && pos < rSpace.dataOffset)
+        {
+            std::size_t const pad = std::size_t(std::min<uint64_t>(sizeof(sc_zeros), rSpace.dataOffset - pos));
+            ok = std::fwrite(sc_zeros, 1, pad, pFile.get()) == pad;
+            pos += pad;
+        }
+
+        ok = ok && writeData(id, pFile.get());
+        pos += rSpace.dataSize;
+    }
+
+    return ok ? ESnapshotStatus::Ok : ESnapshotStatus::WriteFailed;
+}
+
+} // namespace
+
+ESnapshotStatus universe_snapshot_write(Universe const& universe, char const* const path)
+{
+    SnapshotHeader              header;
+    std::vector<SnapshotSpace>  spaces;
+    make_records(universe, header, spaces);
+
+    return write_file(header, spaces, path, [&universe, &spaces] (CoSpaceId const id, std::FILE* pFile)
+    {
+        std::size_t const size = std::size_t(spaces[id].dataSize);
+        return std::fwrite(universe.m_coordCommon[id].m_data.data(), 1, size, pFile) == size;
+    });
+}
+
+UniverseCapture universe_snapshot_capture(Universe const& universe, UniverseCapture const* pPrevious)
+{
+    UniverseCapture out;
+    make_records(universe, out.header, out.spaces);
+
+    out.data.resize(out.spaces.size());
+    for (CoSpaceId id = 0; id < out.spaces.size(); ++id)
+    {
+        if (out.spaces[id].dataSize == 0)
+        {
+            continue;
+        }
+
+        PageSnapshot const *pPrevData = (pPrevious != nullptr && id < pPrevious->data.size())
+                                      ? &pPrevious->data[id] : nullptr;
+        out.data[id] = PageSnapshot::capture_of(ArrayView<unsigned char const>{universe.m_coordCommon[id].m_data}, pPrevData);
+    }
+
+    return out;
+}
+
+ESnapshotStatus universe_snapshot_write(UniverseCapture const& capture, char const* const path)
+{
+    return write_file(capture.header, capture.spaces, path, [&capture] (CoSpaceId const id, std::FILE* pFile)
+    {
+        PageSnapshot const &data = capture.data[id];
+        for (std::size_t i = 0; i < data.page_count(); ++i)
+        {
+            ArrayView<std::byte const> const page = data.page(i);
+            if (std::fwrite(page.data(), 1, page.size(), pFile) != page.size())
+            {
+                return false;
+            }
+        }
+        return true;
+    });
+}
+
+ESnapshotStatus universe_snapshot_read(Universe& rOut, char const* const path)
+{
+    File_t const pFile{std::fopen(path, "rb")};
+    if (pFile == nullptr)
+    {
+        return ESnapshotStatus::CantOpen;
+    }
+
+    SnapshotHeader header;
+    if (std::fread(&header, sizeof(header), 1, pFile.get()) != 1)
+    {
+        return ESnapshotStatus::Truncated;
+    }
+    if (std::memcmp(header.magic, gc_magic, sizeof(gc_magic)) != 0)
+    {
+        return ESnapshotStatus::NotASnapshot;
+    }
+    if (header.version != gc_snapshotVersion || header.endianCheck != gc_endian)
+    {
+        return ESnapshotStatus::WrongVersion;
+    }
+
+    std::vector<SnapshotSpace> spaces(header.spaceCapacity);
+    if (std::fread(spaces.data(), sizeof(SnapshotSpace), spaces.size(), pFile.get()) != spaces.size())
+    {
+        return ESnapshotStatus::Truncated;
+    }
+
+    // Check blob bounds against the file size before mapping anything
+    std::fseek(pFile.get(), 0, SEEK_END);
+    uint64_t const fileSize = uint64_t(std::ftell(pFile.get()));
+    for (SnapshotSpace const& space : spaces)
+    {
+        if (space.dataSize != 0 && space.dataOffset + space.dataSize > fileSize)
+        {
+            return ESnapshotStatus::Truncated;
+        }
+    }
+
+    Universe universe;
+    universe.m_coordCommon.resize(spaces.size());
+
+#if OSP_SNAPSHOT_MMAP
+    int const fd = ::fileno(pFile.get());
+    bool const canMap = (gc_snapshotBlobAlignment % uint64_t(::sysconf(_SC_PAGESIZE))) == 0;
+#endif
+
+    for (CoSpaceId id = 0; id < spaces.size(); ++id)
+    {
+        SnapshotSpace const &rSpace = spaces[id];
+        CoSpaceCommon &rCommon = universe.m_coordCommon[id];
+
+        rCommon.m_rotation      = Quaterniond{{rSpace.rotation[0], rSpace.rotation[1], rSpace.rotation[2]}, rSpace.rotation[3]};
+        rCommon.m_position      = {rSpace.position[0], rSpace.position[1], rSpace.position[2]};
+        rCommon.m_precision     = rSpace.precision;
+        rCommon.m_parent        = rSpace.parent;
+        rCommon.m_parentSat     = rSpace.parentSat;
+        rCommon.m_satCount      = rSpace.satCount;
+        rCommon.m_satCapacity   = rSpace.satCapacity;
+
+        read_strides(rCommon.m_satPositions,  rSpace.satPositions);
+        read_strides(rCommon.m_satVelocities, rSpace.satVelocities);
+        read_strides(rCommon.m_satRotations,  rSpace.satRotations);
+        read_strides(rCommon.m_satPositions32, rSpace.satPositions32);
+
+        if (rSpace.dataSize == 0)
+        {
+            continue;
+        }
+
+        std::size_t const size = std::size_t(rSpace.dataSize);
+
+#if OSP_SNAPSHOT_MMAP
+        if (canMap)
+        {
+            // Private mapping: writes by the simulation never go back to the file
+            void *const pMapped = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                                         fd, off_t(rSpace.dataOffset));
+            if (pMapped != MAP_FAILED)
+            {
+                rCommon.m_data = Corrade::Containers::Array<unsigned char>{
+                        static_cast<unsigned char*>(pMapped), size, munmap_deleter};
+                continue;
+            }
+        }
+#endif
+
+        rCommon.m_data = sat_data_alloc(size);
+        if (   std::fseek(pFile.get(), long(rSpace.dataOffset), SEEK_SET) != 0
+            || std::fread(rCommon.m_data.data(), 1, size, pFile.get()) != size)
+        {
+            return ESnapshotStatus::Truncated;
+        }
+    }
+
+    // Recreate the same CoSpaceIds
+    if ( ! spaces.empty() )
+    {
+        std::vector<CoSpaceId> ids(spaces.size());
+        universe.m_coordIds.create(ids.begin(), ids.end());
+        for (CoSpaceId const id : ids)
+        {
+            if (spaces[id].exists == 0)
+            {
+                universe.m_coordIds.remove(id);
+            }
+        }
+    }
+
+    rOut = std::move(universe);
+    return ESnapshotStatus::Ok;
+}
+
+} // namespace osp::universe
@@ -0,0 +1,149 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "universe.h"
+
+#include "../core/page_snapshot.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace osp::universe
+{
+
+/**
+ * @brief Version of the snapshot format written by universe_snapshot_write
+ *
+ * Increment whenever the layout of SnapshotHeader or SnapshotSpace changes.
+ */
+constexpr uint32_t gc_snapshotVersion = 2;
+
+/**
+ * @brief Satellite data blobs are placed at multiples of this in the file, so they can be
+ *        memory-mapped individually. Large enough for any common page size.
+ */
+constexpr uint64_t gc_snapshotBlobAlignment = 65536;
+
+enum class ESnapshotStatus : uint8_t
+{
+    Ok,
+    CantOpen,
+    WriteFailed,
+    NotASnapshot,
+    WrongVersion,
+    Truncated
+};
+
+struct SnapshotHeader
+{
+    char        magic[8];
+    uint32_t    version;
+    uint32_t    endianCheck;    ///< 0x01020304 as written by the machine that saved it
+    uint32_t    spaceCapacity;  ///< Number of SnapshotSpace that follow, one per CoSpaceId
+    uint32_t    reserved;
+};
+
+struct SnapshotStride
+{
+    uint64_t    offset;
+    int64_t     stride;
+};
+
+/**
+ * @brief Fixed-size record of a CoSpaceCommon header, written verbatim
+ */
+struct SnapshotSpace
+{
+    double          rotation[4];    ///< x, y, z, w
+    int64_t         position[3];
+    int32_t         precision;
+    uint32_t        exists;
+
+    uint32_t        parent;
+    uint32_t        parentSat;
+
+    uint32_t        satCount;
+    uint32_t        satCapacity;
+
+    SnapshotStride  satPositions[3];
+    SnapshotStride  satVelocities[3];
+    SnapshotStride  satRotations[4];
+    SnapshotStride  satPositions32[3];
+
+    uint64_t        dataOffset;     ///< Position of m_data in the file, aligned to gc_snapshotBlobAlignment
+    uint64_t        dataSize;
+};
+
+/**
+ * @brief Write all coordinate spaces of a Universe to a binary snapshot file
+ *
+ * Each CoSpaceCommon::m_data buffer is written verbatim, so StrideDescs stored elsewhere (such
+ * as CoSpaceNBody) that describe the same buffer stay valid once the snapshot is loaded.
+ *
+ * The format is a SnapshotHeader, followed by a SnapshotSpace per CoSpaceId, then the data
+ * blobs. It is only readable by machines with the same endianness.
+ */
+ESnapshotStatus universe_snapshot_write(Universe const& universe, char const* path);
+
+/**
+ * @brief Copy of everything universe_snapshot_write needs from a Universe, taken at a frame
+ *        boundary so the file can be written on another thread while the simulation continues
+ */
+struct UniverseCapture
+{
+    SnapshotHeader              header;
+    std::vector<SnapshotSpace>  spaces;     ///< dataOffset is already laid out for the file
+    std::vector<PageSnapshot>   data;       ///< CoSpaceCommon::m_data of each space
+};
+
+/**
+ * @brief Capture a Universe to write later with universe_snapshot_write
+ *
+ * Only copies pages of m_data that changed since pPrevious, see PageSnapshot.
+ *
+ * @param pPrevious [in] Optional earlier capture of the same universe, to share pages with
+ */
+[[nodiscard]] UniverseCapture universe_snapshot_capture(Universe const& universe, UniverseCapture const* pPrevious = nullptr);
+
+/**
+ * @brief Write a capture to a snapshot file, identical to writing the universe it was taken of
+ *
+ * Safe to call from any thread, the capture isn't modified.
+ */
+ESnapshotStatus universe_snapshot_write(UniverseCapture const& capture, char const* path);
+
+/**
+ * @brief Load a Universe from a snapshot written by universe_snapshot_write
+ *
+ * Satellite data is memory-mapped copy-on-write where supported, so loading does no
+ * per-satellite work and only touches pages that are used. Elsewhere, data is read into
+ * buffers from sat_data_alloc.
+ *
+ * @param rOut  [out] Replaced with the loaded universe on success, untouched otherwise
+ */
+ESnapshotStatus universe_snapshot_read(Universe& rOut, char const* path);
+
+} // namespace osp::universe
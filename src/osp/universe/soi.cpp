@@ -0,0 +1,302 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "soi.h"
+
+#include "../core/math_2pow.h"
+
+#include <Magnum/Math/Constants.h>
+
+#include <longeron/utility/asserts.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+namespace osp::universe
+{
+
+namespace
+{
+
+// Orbits that are just past their crossing due to rounding count as crossing now, instead of
+// one revolution later
+constexpr double gc_crossingTolerance = 1.0e-6;
+
+constexpr double gc_inf = std::numeric_limits<double>::infinity();
+
+/**
+ * @brief Lower bound of time needed to travel a distance, starting at a speed and
+ *        accelerating at most accel
+ */
+double reach_time(double const gap, double const speed, double const accel) noexcept
+{
+    if (gap <= 0.0)
+    {
+        return 0.0;
+    }
+    if (accel <= 0.0)
+    {
+        return (speed > 0.0) ? gap / speed : gc_inf;
+    }
+
+    // Positive root of 0.5*accel*t^2 + speed*t - gap = 0, arranged to not cancel out
+    return 2.0 * gap / (speed + std::sqrt(speed * speed + 2.0 * accel * gap));
+}
+
+template <typename VIEW_T>
+Vector3d relative_position(VIEW_T const& x, VIEW_T const& y, VIEW_T const& z, double const scale, SatId const sat, SatId const base) noexcept
+{
+    // Subtract as 64-bit, 32-bit positions far apart could overflow
+    return Vector3d{double(spaceint_t(x[sat]) - spaceint_t(x[base])),
+                    double(spaceint_t(y[sat]) - spaceint_t(y[base])),
+                    double(spaceint_t(z[sat]) - spaceint_t(z[base]))} * scale;
+}
+
+double relative_speed(CoSpaceCommon const& space, SatId const sat, SatId const base) noexcept
+{
+    if (space.m_satVelocities[0].not_used())
+    {
+        return 0.0;
+    }
+
+    auto const [vx, vy, vz] = sat_views(space.m_satVelocities, space.m_data, space.m_satCount);
+    return Vector3d{vx[sat] - vx[base], vy[sat] - vy[base], vz[sat] - vz[base]}.length();
+}
+
+bool is_body(SoiPredictor const& pred, SatId const sat) noexcept
+{
+    return std::any_of(pred.bodies.begin(), pred.bodies.end(),
+                       [sat] (SoiBody const& body) { return body.sat == sat; });
+}
+
+/**
+ * @brief Brute-force search for the innermost SOI a satellite is in
+ */
+uint32_t find_parent(SoiPredictor const& pred, CoSpaceCommon const& space, SatId const sat)
+{
+    double const scale = math::mul_2pow<double, int>(1.0, -space.m_precision);
+
+    return visit_sat_positions(space, space.m_satCount, [&] (auto const& x, auto const& y, auto const& z)
+    {
+        uint32_t found       = SoiPredictor::smc_none;
+        double   foundRadius = gc_inf;
+
+        for (uint32_t i = 0; i < pred.bodies.size(); ++i)
+        {
+            SoiBody const& body = pred.bodies[i];
+            if (body.sat == sat || body.sat >= space.m_satCount || body.radius >= foundRadius)
+            {
+                continue;
+            }
+
+            Vector3d const rel = relative_position(x, y, z, scale, sat, body.sat);
+            if (rel.dot() < body.radius * body.radius)
+            {
+                found       = i;
+                foundRadius = body.radius;
+            }
+        }
+
+        return found;
+    });
+}
+
+void schedule(SoiPredictor& rPred, CoSpaceCommon const& space, SatRails const* pRails, SatId const sat, double const time)
+{
+    ++ rPred.generation[sat];
+
+    if (is_body(rPred, sat))
+    {
+        return;
+    }
+
+    double const scale   = math::mul_2pow<double, int>(1.0, -space.m_precision);
+    bool const   onRails =    pRails != nullptr
+                           && sat < pRails->onRails.size()
+                           && pRails->onRails[sat] != 0;
+
+    double next = time + rPred.maxInterval;
+
+    visit_sat_positions(space, space.m_satCount, [&] (auto const& x, auto const& y, auto const& z)
+    {
+        for (uint32_t i = 0; i < rPred.bodies.size(); ++i)
+        {
+            SoiBody const& body = rPred.bodies[i];
+            if (body.sat >= space.m_satCount)
+            {
+                continue;
+            }
+
+            double crossing;
+            if (onRails && i == rPred.parent[sat] && pRails->attractor == body.sat)
+            {
+                crossing = kepler_time_outbound(pRails->orbits[sat], body.radius, time);
+            }
+            else
+            {
+                // Distance to the boundary, either from inside or outside
+                double const distance = relative_position(x, y, z, scale, sat, body.sat).length();
+                double const gap      = std::abs(distance - body.radius);
+                crossing = time + reach_time(gap, relative_speed(space, sat, body.sat), rPred.maxAccel);
+            }
+
+            next = std::min(next, crossing);
+        }
+    });
+
+    // Never schedule for now or earlier, soi_update would loop forever
+    next = std::max(next, time + rPred.minInterval);
+
+    rPred.events.push_back({next, sat, rPred.generation[sat]});
+    std::push_heap(rPred.events.begin(), rPred.events.end(), std::greater<SoiPredictor::Event>{});
+}
+
+} // namespace
+
+
+double kepler_time_outbound(KeplerOrbit const& orbit, double const radius, double const time) noexcept
+{
+    double const e = orbit.eccentricity;
+    double const n = orbit.meanMotion;
+
+    if (e < 1.0)
+    {
+        double const a = orbit.semiMajorAxis;
+        if (a * (1.0 + e) <= radius)
+        {
+            return gc_inf; // Apoapsis is inside
+        }
+        if (a * (1.0 - e) >= radius)
+        {
+            return time; // Periapsis is outside, never inside to begin with
+        }
+
+        // r = a(1 - e*cos(E)), outbound half is E in (0, pi)
+        double const E      = std::acos((1.0 - radius / a) / e);
+        double const M      = E - e * std::sin(E);
+        double const twoPi  = 2.0 * Magnum::Math::Constants<double>::pi();
+        double const Mnow   = orbit.meanAnomalyAtEpoch + n * (time - orbit.epoch);
+
+        double delta = std::fmod(M - Mnow, twoPi);
+        if (delta < 0.0)
+        {
+            delta += twoPi;
+        }
+        if (delta > twoPi * (1.0 - gc_crossingTolerance))
+        {
+            delta = 0.0;
+        }
+
+        return time + delta / n;
+    }
+
+    // r = a(e*cosh(F) - 1) with a positive
+    double const a     = -orbit.semiMajorAxis;
+    double const coshF = (radius / a + 1.0) / e;
+    if (coshF <= 1.0)
+    {
+        return time; // Periapsis is outside
+    }
+
+    double const F = std::acosh(coshF);
+    double const M = e * std::sinh(F) - F;
+
+    return std::max(time, orbit.epoch + (M - orbit.meanAnomalyAtEpoch) / n);
+}
+
+void soi_reset(SoiPredictor& rPred, CoSpaceCommon const& space, SatRails const* pRails, double const time)
+{
+    std::size_t const count = space.m_satCount;
+
+    rPred.events.clear();
+    rPred.parent.assign(count, SoiPredictor::smc_none);
+    rPred.generation.assign(count, 0);
+
+    for (SatId sat = 0; sat < count; ++sat)
+    {
+        if ( ! is_body(rPred, sat) )
+        {
+            rPred.parent[sat] = find_parent(rPred, space, sat);
+        }
+        schedule(rPred, space, pRails, sat, time);
+    }
+}
+
+void soi_invalidate(SoiPredictor& rPred, CoSpaceCommon const& space, SatRails const* pRails, SatId const sat, double const time)
+{
+    LGRN_ASSERTMV(sat < rPred.parent.size(), "Satellite not tracked yet", sat, rPred.parent.size());
+    schedule(rPred, space, pRails, sat, time);
+}
+
+void soi_update(SoiPredictor& rPred, CoSpaceCommon const& space, SatRails const* pRails, double const time, std::vector<SoiTransition>& rOut)
+{
+    std::size_t const count   = space.m_satCount;
+    std::size_t const tracked = rPred.parent.size();
+
+    // Start tracking new satellites
+    if (tracked < count)
+    {
+        rPred.parent.resize(count, SoiPredictor::smc_none);
+        rPred.generation.resize(count, 0);
+
+        for (SatId sat = SatId(tracked); sat < count; ++sat)
+        {
+            if ( ! is_body(rPred, sat) )
+            {
+                rPred.parent[sat] = find_parent(rPred, space, sat);
+            }
+            schedule(rPred, space, pRails, sat, time);
+        }
+    }
+
+    auto const later = std::greater<SoiPredictor::Event>{};
+
+    while ( ! rPred.events.empty() && rPred.events.front().time <= time )
+    {
+        SoiPredictor::Event const event = rPred.events.front();
+        std::pop_heap(rPred.events.begin(), rPred.events.end(), later);
+        rPred.events.pop_back();
+
+        if (event.sat >= count || event.generation != rPred.generation[event.sat])
+        {
+            continue; // Removed or rescheduled
+        }
+
+        ++ rPred.checks;
+
+        uint32_t const from = rPred.parent[event.sat];
+        uint32_t const to   = find_parent(rPred, space, event.sat);
+        if (from != to)
+        {
+            rPred.parent[event.sat] = to;
+            rOut.push_back({event.sat, from, to});
+        }
+
+        schedule(rPred, space, pRails, event.sat, time);
+    }
+}
+
+} // namespace osp::universe
@@ -0,0 +1,154 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "kepler.h"
+#include "universe.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace osp::universe
+{
+
+/**
+ * @brief Satellite with a sphere of influence that captures other satellites of the same
+ *        coordinate space, such as a planet
+ */
+struct SoiBody
+{
+    SatId       sat;
+
+    /// In meters
+    double      radius  {0.0};
+
+    /// Body's own coordinate space that captured satellites are moved to, e.g. its surface space
+    CoSpaceId   space   {lgrn::id_null<CoSpaceId>()};
+};
+
+/**
+ * @brief A satellite crossed a sphere of influence boundary
+ *
+ * from and to are indices into SoiPredictor::bodies, or SoiPredictor::smc_none for none.
+ */
+struct SoiTransition
+{
+    SatId       sat;
+    uint32_t    from;
+    uint32_t    to;
+};
+
+/**
+ * @brief Predicts when satellites cross sphere of influence boundaries, so only satellites that
+ *        are due have to be checked each update
+ *
+ * Each tracked satellite has one event in a min-heap, scheduled at the earliest time it could
+ * possibly enter or leave a sphere of influence:
+ *
+ * * Leaving the SOI of a body that is the SatRails attractor while on rails is solved
+ *   analytically from the orbit.
+ * * Everything else uses a conservative bound: the time needed to close the gap to the
+ *   boundary at the current relative speed, accelerating at maxAccel the whole way.
+ *
+ * soi_update only pops events that are due, checks those satellites' actual positions, and
+ * reschedules them. Per-update cost is O(due events × bodies) instead of O(satellites × bodies).
+ *
+ * Bodies are never tracked themselves. Call soi_reset after bodies change or satellites are
+ * removed or remapped, and soi_invalidate after a satellite's velocity changed other than by
+ * gravity (thrust, rails_leave...).
+ */
+struct SoiPredictor
+{
+    static constexpr uint32_t smc_none = ~uint32_t(0);
+
+    struct Event
+    {
+        double      time;
+        SatId       sat;
+
+        /// Must match SoiPredictor::generation[sat], otherwise the event is stale and ignored
+        uint32_t    generation;
+
+        constexpr bool operator>(Event const& rhs) const noexcept
+        {
+            return (time != rhs.time) ? (time > rhs.time) : (sat > rhs.sat);
+        }
+    };
+
+    std::vector<SoiBody>    bodies;
+
+    /// [SatId] -> index into bodies of the innermost SOI the satellite is in, or smc_none
+    std::vector<uint32_t>   parent;
+
+    /// [SatId] -> incremented each time the satellite is rescheduled
+    std::vector<uint32_t>   generation;
+
+    /// Min-heap of events, ordered by time
+    std::vector<Event>      events;
+
+    /// Upper bound of acceleration between a satellite and a body, in m/s^2. Bounds that are
+    /// too low make crossings get noticed late.
+    double                  maxAccel        {50.0};
+
+    /// Satellites are re-checked at least this often, in seconds
+    double                  maxInterval     {600.0};
+
+    /// Satellites are never rescheduled sooner than this, in seconds
+    double                  minInterval     {1.0e-3};
+
+    /// Number of events processed, for profiling
+    uint32_t                checks          {0};
+};
+
+/**
+ * @brief Find the innermost SOI of all satellites and schedule their first events
+ *
+ * @param pRails [in] Optional, allows solving exits analytically for satellites on rails
+ * @param time   [in] Current time, on the same clock as SatRails::time
+ */
+void soi_reset(SoiPredictor& rPred, CoSpaceCommon const& space, SatRails const* pRails, double time);
+
+/**
+ * @brief Reschedule a satellite, discarding its current event
+ */
+void soi_invalidate(SoiPredictor& rPred, CoSpaceCommon const& space, SatRails const* pRails, SatId sat, double time);
+
+/**
+ * @brief Process due events, writing satellites that changed SOI to rOut
+ *
+ * Satellites added to the space since the last call start being tracked. The caller moves
+ * transitioned satellites to the body's coordinate space (or back) as needed.
+ */
+void soi_update(SoiPredictor& rPred, CoSpaceCommon const& space, SatRails const* pRails, double time, std::vector<SoiTransition>& rOut);
+
+/**
+ * @brief Earliest time after a time that an orbit reaches a distance from its attractor
+ *        while moving away from it
+ *
+ * @return Infinity if the orbit never gets that far
+ */
+double kepler_time_outbound(KeplerOrbit const& orbit, double radius, double time) noexcept;
+
+} // namespace osp::universe
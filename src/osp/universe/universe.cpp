@@ -0,0 +1,179 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "universe.h"
+
+#include <longeron/utility/asserts.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace osp::universe
+{
+
+namespace
+{
+
+/**
+ * @brief Contiguous region of m_data holding one or more interleaved columns
+ */
+struct SatBlock
+{
+    std::size_t     offset;
+    std::size_t     stride;
+    std::size_t     firstColumn;
+};
+
+struct SatLayout
+{
+    // Sorted by offset
+    std::vector<StrideDesc*>    columns;
+    std::vector<SatBlock>       blocks;
+};
+
+SatLayout sat_layout(CoSpaceSatData& rData, SatExtraColumns_t const extraColumns)
+{
+    SatLayout out;
+    out.columns.reserve(rData.m_satPositions.size() + rData.m_satPositions32.size()
+                        + rData.m_satVelocities.size() + rData.m_satRotations.size()
+                        + extraColumns.size());
+
+    auto const add = [&out] (StrideDesc &rDesc)
+    {
+        if ( ! rDesc.not_used() )
+        {
+            out.columns.push_back(&rDesc);
+        }
+    };
+
+    std::for_each(rData.m_satPositions .begin(), rData.m_satPositions .end(), add);
+    std::for_each(rData.m_satPositions32.begin(), rData.m_satPositions32.end(), add);
+    std::for_each(rData.m_satVelocities.begin(), rData.m_satVelocities.end(), add);
+    std::for_each(rData.m_satRotations .begin(), rData.m_satRotations .end(), add);
+    for (StrideDesc *pDesc : extraColumns)
+    {
+        add(*pDesc);
+    }
+
+    std::sort(out.columns.begin(), out.columns.end(), [] (StrideDesc const* lhs, StrideDesc const* rhs)
+    {
+        return lhs->m_offset < rhs->m_offset;
+    });
+
+    // Interleaved columns all start within the first stride of their block
+    for (std::size_t i = 0; i < out.columns.size(); ++i)
+    {
+        StrideDesc const &rDesc = *out.columns[i];
+        if (   out.blocks.empty()
+            || rDesc.m_offset >= out.blocks.back().offset + out.blocks.back().stride)
+        {
+            out.blocks.push_back({rDesc.m_offset, std::size_t(rDesc.m_stride), i});
+        }
+        else
+        {
+            LGRN_ASSERTM(std::size_t(rDesc.m_stride) == out.blocks.back().stride,
+                         "Interleaved columns must have the same stride");
+        }
+    }
+
+    return out;
+}
+
+} // namespace
+
+void sat_reserve(CoSpaceSatData& rData, std::size_t const capacity, SatExtraColumns_t const extraColumns)
+{
+    if (capacity <= rData.m_satCapacity)
+    {
+        return;
+    }
+
+    LGRN_ASSERTM(rData.m_satCapacity != 0, "Columns must be partitioned with a non-zero capacity first");
+
+    SatLayout const layout = sat_layout(rData, extraColumns);
+
+    std::size_t bytesUsed = 0;
+    std::vector<std::size_t> newOffsets(layout.blocks.size());
+    for (std::size_t i = 0; i < layout.blocks.size(); ++i)
+    {
+        bytesUsed = (bytesUsed + gc_satDataAlignment - 1) & ~(gc_satDataAlignment - 1);
+        newOffsets[i] = bytesUsed;
+        bytesUsed += layout.blocks[i].stride * capacity;
+    }
+
+    Corrade::Containers::Array<unsigned char> newData = sat_data_alloc(bytesUsed);
+
+    for (std::size_t i = 0; i < layout.blocks.size(); ++i)
+    {
+        SatBlock const &block = layout.blocks[i];
+
+        std::memcpy(&newData[newOffsets[i]], &rData.m_data[block.offset], block.stride * rData.m_satCount);
+
+        std::size_t const lastColumn = (i + 1 < layout.blocks.size())
+                                     ? layout.blocks[i + 1].firstColumn
+                                     : layout.columns.size();
+        for (std::size_t j = block.firstColumn; j < lastColumn; ++j)
+        {
+            layout.columns[j]->m_offset = layout.columns[j]->m_offset - block.offset + newOffsets[i];
+        }
+    }
+
+    rData.m_data        = std::move(newData);
+    rData.m_satCapacity = uint32_t(capacity);
+}
+
+SatId sat_create(CoSpaceSatData& rData, SatExtraColumns_t const extraColumns)
+{
+    if (rData.m_satCount == rData.m_satCapacity)
+    {
+        sat_reserve(rData, std::size_t(rData.m_satCapacity) * 2, extraColumns);
+    }
+
+    return SatId(rData.m_satCount ++);
+}
+
+void sat_remove(CoSpaceSatData& rData, SatId const sat, std::vector<SatRemap>& rMoved, SatExtraColumns_t const extraColumns)
+{
+    LGRN_ASSERTMV(sat < rData.m_satCount, "Satellite does not exist", sat, rData.m_satCount);
+
+    SatId const last = SatId(rData.m_satCount - 1);
+
+    if (sat != last)
+    {
+        SatLayout const layout = sat_layout(rData, extraColumns);
+
+        for (SatBlock const& block : layout.blocks)
+        {
+            std::memcpy(&rData.m_data[block.offset + block.stride * sat],
+                        &rData.m_data[block.offset + block.stride * last],
+                        block.stride);
+        }
+
+        rMoved.push_back({.from = last, .to = sat});
+    }
+
+    -- rData.m_satCount;
+}
+
+} // namespace osp::universe
@@ -24,16 +24,20 @@
  */
 #pragma once
 
+#include "../core/large_alloc.h"
 #include "../core/math_types.h"
+#include "../core/memory_usage.h"
 #include "universetypes.h"
 
 #include <longeron/id_management/registry_stl.hpp>
 
 #include <Corrade/Containers/Array.h>
 #include <Corrade/Containers/StridedArrayView.h>
+#include <Corrade/Utility/allocateAligned.h>
 
 #include <array>
 #include <cstdint>
+#include <vector>
 
 namespace osp::universe
 {
@@ -98,6 +102,12 @@ struct CoSpaceSatData
     StrideDescArray_t<spaceint_t, 3>            m_satPositions;
     StrideDescArray_t<double, 3>                m_satVelocities;
     StrideDescArray_t<double, 4>                m_satRotations;
+
+    /// Used instead of m_satPositions by local spaces whose positions fit in 32 bits; partition
+    /// one or the other, never both. Read either with visit_sat_positions.
+    StrideDescArray_t<spaceint32_t, 3>          m_satPositions32;
+
+    constexpr bool positions_32bit() const noexcept { return ! m_satPositions32[0].not_used(); }
 };
 
 
@@ -108,6 +118,8 @@ struct Universe
     Universe() = default;
     Universe(Universe const&) = delete;
     Universe(Universe&& move) = default;
+    Universe& operator=(Universe const&) = delete;
+    Universe& operator=(Universe&& move) = default;
 
     lgrn::IdRegistryStl<CoSpaceId>   m_coordIds;
 
@@ -142,6 +154,93 @@ constexpr void partition(std::size_t& rPos, std::size_t count, TypedStrideDesc<T
     rPos += stride * count;
 }
 
+/**
+ * @brief Alignment of each column in CoSpaceSatData::m_data, enough for AVX-512 and cache lines
+ */
+constexpr std::size_t gc_satDataAlignment = 64;
+
+/**
+ * @brief Same as partition, but rounds rPos up to ALIGN_T first
+ *
+ * Use this for each column, and allocate with sat_data_alloc, so that vectorized code can use
+ * aligned loads. For interleaved data, only the first element of each stride is aligned.
+ */
+template <std::size_t ALIGN_T = gc_satDataAlignment, typename ... T>
+constexpr void partition_aligned(std::size_t& rPos, std::size_t count, TypedStrideDesc<T>& ... rInterleve)
+{
+    static_assert((ALIGN_T & (ALIGN_T - 1)) == 0, "Alignment must be a power of two");
+
+    rPos = (rPos + ALIGN_T - 1) & ~(ALIGN_T - 1);
+
+    partition(rPos, count, rInterleve ...);
+}
+
+/// Subsystem of CoSpaceSatData::m_data buffers, see large_alloc_policy_set
+constexpr std::string_view gc_satDataSubsystem = "universe_sat_data";
+
+/**
+ * @brief Allocate a buffer for CoSpaceSatData::m_data, aligned to ALIGN_T
+ *
+ * Buffers at or above the gc_satDataSubsystem policy's threshold are mapped with large_map,
+ * everything else is allocated from the heap. Contents are left uninitialized.
+ */
+template <std::size_t ALIGN_T = gc_satDataAlignment>
+Corrade::Containers::Array<unsigned char> sat_data_alloc(std::size_t size)
+{
+    // Mappings are page aligned, which covers any ALIGN_T up to the page size
+    if (void *const pMapped = large_map(size, gc_satDataSubsystem);
+        pMapped != nullptr)
+    {
+        return Corrade::Containers::Array<unsigned char>{
+                static_cast<unsigned char*>(pMapped), size,
+                [] (unsigned char *pData, std::size_t) { large_unmap(pData); } };
+    }
+    return Corrade::Utility::allocateAligned<unsigned char, ALIGN_T>(Corrade::NoInit, size);
+}
+
+/**
+ * @brief Record of a satellite moved to a different SatId by sat_remove
+ */
+struct SatRemap
+{
+    SatId from;
+    SatId to;
+};
+
+/**
+ * @brief Columns in CoSpaceSatData::m_data described outside of CoSpaceSatData itself, such as
+ *        the CoSpaceNBody mass column
+ */
+using SatExtraColumns_t = Corrade::Containers::ArrayView<StrideDesc* const>;
+
+/**
+ * @brief Grow m_data to hold at least capacity satellites, keeping existing satellites
+ *
+ * All used columns are re-partitioned in one pass, in the same order and with the same
+ * interleaving as they were laid out originally. m_satCapacity must be non-zero, as columns
+ * need to be partitioned once (with partition_aligned) to describe the layout.
+ *
+ * @param rData         [ref] Satellite data to grow
+ * @param capacity      [in] Minimum number of satellites to fit
+ * @param extraColumns  [ref] Other StrideDescs that describe rData.m_data, updated as well
+ */
+void sat_reserve(CoSpaceSatData& rData, std::size_t capacity, SatExtraColumns_t extraColumns = {});
+
+/**
+ * @brief Add a satellite, growing m_data by doubling its capacity if needed
+ *
+ * @return SatId of the new satellite, its data is left uninitialized
+ */
+SatId sat_create(CoSpaceSatData& rData, SatExtraColumns_t extraColumns = {});
+
+/**
+ * @brief Remove a satellite, moving the last satellite into its place to keep data packed
+ *
+ * @param rMoved    [out] Appended with a SatRemap if a satellite was moved. Systems storing
+ *                        SatIds of this coordinate space should follow these.
+ */
+void sat_remove(CoSpaceSatData& rData, SatId sat, std::vector<SatRemap>& rMoved, SatExtraColumns_t extraColumns = {});
+
 // INDEX_T is a template parameter to allow passing in "strong typedef" types,
 // like enum classes and having them converted without warning to size_t.
 // This is a limitation of the enum class feature in C++, in that
@@ -181,6 +280,29 @@ constexpr auto sat_views(
     }
 }
 
+/**
+ * @brief Call func with x, y, and z position views of a coordinate space, from whichever of
+ *        m_satPositions or m_satPositions32 it uses
+ *
+ * @param rData     [in] CoSpaceSatData, optionally const
+ * @param satCount  [in] Range of valid satellites
+ * @param func      [in] Called as func(x, y, z). Usually a generic lambda, so the same code
+ *                       runs on either width without converting.
+ *
+ * @return Whatever func returns
+ */
+template <typename SATDATA_T, typename FUNC_T>
+constexpr decltype(auto) visit_sat_positions(SATDATA_T &rData, std::size_t satCount, FUNC_T&& func)
+{
+    if (rData.positions_32bit())
+    {
+        auto const [x, y, z] = sat_views(rData.m_satPositions32, rData.m_data, satCount);
+        return func(x, y, z);
+    }
+    auto const [x, y, z] = sat_views(rData.m_satPositions, rData.m_data, satCount);
+    return func(x, y, z);
+}
+
 /**
  * @brief Get transform of a coordinate space, but if a parent satellite exists,
  *        use parent satellite's transform instead.
@@ -201,3 +323,26 @@ constexpr CoSpaceTransform coord_get_transform(
 }
 
 } // namespace osp::universe
+
+namespace osp
+{
+
+template <>
+struct MemoryUsage<universe::CoSpaceCommon>
+{
+    static std::size_t heap_bytes(universe::CoSpaceCommon const& space) noexcept
+    {
+        return space.m_data.size();
+    }
+};
+
+template <>
+struct MemoryUsage<universe::Universe>
+{
+    static std::size_t heap_bytes(universe::Universe const& uni) noexcept
+    {
+        return heap_bytes_sum(uni.m_coordIds, uni.m_coordCommon);
+    }
+};
+
+} // namespace osp
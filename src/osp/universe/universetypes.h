@@ -51,6 +51,15 @@ namespace osp::universe
 
 using spaceint_t = int64_t;
 
+/**
+ * @brief Narrower satellite position type for local coordinate spaces, see
+ *        CoSpaceSatData::m_satPositions32
+ *
+ * At 1024 units per meter this reaches about 2000 km in each direction, plenty for the space
+ * around a landing site but not for orbits.
+ */
+using spaceint32_t = int32_t;
+
 // 1024 space units = 1 meter
 // TODO: this should vary by trajectory, but for now it's global
 constexpr float gc_units_per_meter = 1024.0f;
@@ -29,6 +29,8 @@
 
 #include <Magnum/Math/Functions.h>
 
+#include <algorithm>
+
 namespace osp::input
 {
 
@@ -38,6 +40,7 @@ UserInputHandler::UserInputHandler(std::size_t deviceCount)
 
 bool UserInputHandler::eval_button_expression(
         ControlExpr_t const& expression,
+        ArrayView<ButtonRaw const> const buttons,
         ControlExpr_t* pReleaseExpr)
 {
 
@@ -51,7 +54,7 @@ bool UserInputHandler::eval_button_expression(
     for (auto it =  expression.begin(); it != expression.end(); it ++)
     {
         ControlTerm const& var = *it;
-        ButtonRaw const& btnRaw = var.m_button->second;
+        ButtonRaw const& btnRaw = buttons[var.m_button];
 
         bool varOn;
 
@@ -116,6 +119,7 @@ bool UserInputHandler::eval_button_expression(
                     {
                         continue;
                     }
+                    // Doesn't allocate, see ButtonControl::m_exprRelease
                     pReleaseExpr->emplace_back(
                             ControlTerm{itB->m_button, EVarTrigger::Pressed,
                                         EVarOperator::Or, !(itB->m_invert)});
@@ -181,6 +185,10 @@ EButtonControlIndex UserInputHandler::button_subscribe(std::string_view name)
         rControl.m_holdable = (cfgIt->second.m_holdable);
 
         rControl.m_exprPress.reserve(varConfigs.size());
+        rControl.m_exprRelease.reserve(std::count_if(
+                varConfigs.begin(), varConfigs.end(),
+                [] (ControlTermConfig const& varCfg)
+                { return varCfg.m_trigger == EVarTrigger::Pressed; }));
 
         for (ControlTermConfig const &varCfg : varConfigs)
         {
@@ -191,31 +199,36 @@ EButtonControlIndex UserInputHandler::button_subscribe(std::string_view name)
             ButtonMap_t &btnMap = m_deviceToButtonRaw[varCfg.m_device];
 
             // try inserting a new button index
-            auto btnInsert = btnMap.insert(std::make_pair(varCfg.m_devEnum,
-                                                          ButtonRaw()));
-            ButtonRaw &btnRaw = btnInsert.first->second;
+            auto btnInsert = btnMap.insert(std::make_pair(
+                    varCfg.m_devEnum, ButtonRawIndex(m_buttonRaw.size())));
+            ButtonRawIndex const btnIndex = btnInsert.first->second;
 
             // Either a new ButtonRaw was inserted into btnMap, or an existing
             // one was chosen
             if (btnInsert.second)
             {
                 // new ButtonRaw created
-                //btnRaw.m_pressed = 0;
-                btnRaw.m_referenceCount = 1;
+                m_buttonRaw.emplace_back(ButtonRaw{false, false, false, 1});
+
+                // Each button is in these at most once per frame
+                m_btnPressed.reserve(m_buttonRaw.size());
+                m_btnReleased.reserve(m_buttonRaw.size());
             }
             else
             {
                 // ButtonRaw already exists, add reference count
-                btnRaw.m_referenceCount ++;
+                m_buttonRaw[btnIndex].m_referenceCount ++;
             }
 
             //uint8_t bits = (uint8_t(varCfg.m_trigger) << 0)
             //             | (uint8_t(varCfg.m_invert) << 1)
             //             | (uint8_t(varCfg.m_nextOp) << 2);
 
-            rControl.m_exprPress.emplace_back(varCfg.create(btnInsert.first));
+            rControl.m_exprPress.emplace_back(varCfg.create(btnIndex));
         }
 
+        m_btnControlEvents.reserve(m_btnControls.size() * 2);
+
         // New control has been created, now return a pointer to it
 
         return EButtonControlIndex(m_btnControls.size() - 1);
@@ -237,14 +250,14 @@ void UserInputHandler::clear_events()
 {
     // remove any just pressed / just released flags
 
-    for (ButtonMap_t::iterator btnIt : m_btnPressed)
+    for (ButtonRawIndex const btnIndex : m_btnPressed)
     {
-        btnIt->second.m_justPressed = false;
+        m_buttonRaw[btnIndex].m_justPressed = false;
     }
 
-    for (ButtonMap_t::iterator btnIt : m_btnReleased)
+    for (ButtonRawIndex const btnIndex : m_btnReleased)
     {
-        btnIt->second.m_justReleased = false;
+        m_buttonRaw[btnIndex].m_justReleased = false;
     }
 
     // Clear the button pressed and released events
@@ -273,20 +286,29 @@ void UserInputHandler::event_raw(DeviceId deviceId, int buttonEnum,
     }
 
     OSP_LOG_TRACE("sensitive button pressed");
-        
-    ButtonRaw &btnRaw = btnIt->second;
 
+    ButtonRawIndex const btnIndex = btnIt->second;
+    ButtonRaw &btnRaw = m_buttonRaw[btnIndex];
+
+    // Only add to m_btnPressed/Released once per frame, so they never exceed their reserved
+    // capacity no matter how many events arrive
     switch (dir)
     {
     case EButtonEvent::Pressed:
         btnRaw.m_pressed = true;
-        btnRaw.m_justPressed = true;
-        m_btnPressed.push_back(btnIt);
+        if ( ! btnRaw.m_justPressed )
+        {
+            btnRaw.m_justPressed = true;
+            m_btnPressed.push_back(btnIndex);
+        }
         break;
     case EButtonEvent::Released:
         btnRaw.m_pressed = false;
-        btnRaw.m_justReleased = true;
-        m_btnReleased.push_back(btnIt);
+        if ( ! btnRaw.m_justReleased )
+        {
+            btnRaw.m_justReleased = true;
+            m_btnReleased.push_back(btnIndex);
+        }
         break;
     }
 }
@@ -294,6 +316,8 @@ void UserInputHandler::event_raw(DeviceId deviceId, int buttonEnum,
 void UserInputHandler::update_controls()
 {
 
+    ArrayView<ButtonRaw const> const buttons{m_buttonRaw.data(), m_buttonRaw.size()};
+
     // Loop through controls and see which ones are triggered
 
     for (auto it = std::begin(m_btnControls); it != std::end(m_btnControls);
@@ -313,7 +337,7 @@ void UserInputHandler::update_controls()
         }
 
         rControl.m_triggered = eval_button_expression(rControl.m_exprPress,
-                                                     pExprRelease);
+                                                     buttons, pExprRelease);
 
         if (rControl.m_triggered)
         {
@@ -329,7 +353,7 @@ void UserInputHandler::update_controls()
         if (rControl.m_held)
         {
             // if currently held, evaluate the release expression
-            rControl.m_held = !eval_button_expression(rControl.m_exprRelease);
+            rControl.m_held = !eval_button_expression(rControl.m_exprRelease, buttons);
 
             // if just released
             if (!rControl.m_held)
@@ -60,7 +60,11 @@ struct ButtonRaw
     uint8_t m_referenceCount;
 };
 
-using ButtonMap_t = std::map<int, ButtonRaw, std::less<>>;
+/// Index of a ButtonRaw, shared by all devices. Stable once a button is registered
+using ButtonRawIndex = uint32_t;
+
+/// Device enum -> ButtonRaw, for buttons that are listened to
+using ButtonMap_t = std::map<int, ButtonRawIndex, std::less<>>;
 
 /**
  * @brief Mouse motion state
@@ -100,7 +104,7 @@ enum class EVarOperator : uint8_t { Or = 0, And = 1 };
  */
 struct ControlTerm
 {
-    ButtonMap_t::iterator m_button;
+    ButtonRawIndex m_button;
     EVarTrigger m_trigger;
     EVarOperator m_nextOp;
     bool m_invert;
@@ -112,7 +116,7 @@ struct ControlTerm
 struct ControlTermConfig
 {
 
-    ControlTerm create(ButtonMap_t::iterator button) const
+    ControlTerm create(ButtonRawIndex button) const
     {
         return ControlTerm{button, m_trigger, m_nextOp, m_invert};
     }
@@ -152,6 +156,8 @@ struct ButtonControl
     bool m_triggered{false};
 
     ControlExpr_t m_exprPress{};
+
+    /// Generated when triggered. Capacity for every Pressed term is reserved on creation
     ControlExpr_t m_exprRelease{};
 };
 
@@ -236,6 +242,11 @@ struct ButtonControlEvent
  *
  * more info here later
  *
+ *
+ * Per-frame functions (event_raw, update_controls, clear_events) don't allocate. Controls refer
+ * to raw buttons by index, and all per-frame buffers are reserved to their maximum size when
+ * controls are subscribed.
+ *
  */
 class UserInputHandler
 {
@@ -259,11 +270,13 @@ public:
      * that evaluated
      *
      * @param expression [in] Expression to evaluate
+     * @param buttons [in] Raw button states, indexed by ControlTerm::m_button
      * @param pReleaseExpr [out] optional Release Expression to generate
      * @return result of expression
      */
     static bool eval_button_expression(
             ControlExpr_t const& expression,
+            ArrayView<ButtonRaw const> buttons,
             ControlExpr_t* pReleaseExpr = nullptr);
 
     /**
@@ -331,18 +344,21 @@ public:
 private:
 
     std::vector<ButtonMap_t> m_deviceToButtonRaw;
+    std::vector<ButtonRaw> m_buttonRaw;
     std::map<std::string, ButtonControlConfig, std::less<> > m_btnControlCfg;
 
     // Mouse inputs
     MouseMotion m_mouseMotion;
     ScrollRaw m_scrollOffset;
 
-    std::vector<ButtonMap_t::iterator> m_btnPressed;
-    std::vector<ButtonMap_t::iterator> m_btnReleased;
+    // Buttons with m_justPressed or m_justReleased set, each at most once
+    std::vector<ButtonRawIndex> m_btnPressed;
+    std::vector<ButtonRawIndex> m_btnReleased;
 
     // Currently active controls being listened to
     std::vector<ButtonControl> m_btnControls;
 
+    // At most a Triggered and a Released event per control each frame
     std::vector<ButtonControlEvent> m_btnControlEvents;
 
 }; // class UserInputHandler
@@ -0,0 +1,94 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "background_worker.h"
+
+#include <utility>
+
+namespace osp
+{
+
+BackgroundWorker::BackgroundWorker()
+ : m_thread{[this] { run(); }}
+{ }
+
+BackgroundWorker::~BackgroundWorker()
+{
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    m_thread.join();
+}
+
+bool BackgroundWorker::push(Job_t job)
+{
+    bool replaced;
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        replaced  = static_cast<bool>(m_pending);
+        m_pending = std::move(job);
+    }
+    m_cv.notify_all();
+    return replaced;
+}
+
+bool BackgroundWorker::idle() const
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    return ! m_running && ! m_pending;
+}
+
+void BackgroundWorker::wait_idle()
+{
+    std::unique_lock<std::mutex> lock{m_mutex};
+    m_cv.wait(lock, [this] { return ! m_running && ! m_pending; });
+}
+
+void BackgroundWorker::run()
+{
+    std::unique_lock<std::mutex> lock{m_mutex};
+    while (true)
+    {
+        m_cv.wait(lock, [this] { return m_stop || m_pending; });
+        if ( ! m_pending )
+        {
+            return; // Stopped with nothing left to run
+        }
+
+        Job_t job = std::exchange(m_pending, Job_t{});
+        m_running = true;
+        lock.unlock();
+
+        job();
+        job = {}; // Release whatever the job captured before reporting idle
+
+        lock.lock();
+        m_running = false;
+        m_cv.notify_all();
+    }
+}
+
+} // namespace osp
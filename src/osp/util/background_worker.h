@@ -0,0 +1,84 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace osp
+{
+
+/**
+ * @brief Single thread that runs long jobs spanning many frames, such as writing autosaves
+ *
+ * TopWorkerPool tasks have to finish within the frame they're run in, so jobs that may take
+ * longer run here instead. A job holds everything it needs (such as PageSnapshots captured on
+ * the main thread), so it never touches data the simulation is still using.
+ *
+ * One job runs at a time. Pushing a job while another is still waiting to run replaces the
+ * waiting one, so a slow disk only ever delays the latest save instead of building a backlog.
+ */
+class BackgroundWorker
+{
+public:
+
+    using Job_t = std::function<void()>;
+
+    BackgroundWorker();
+    BackgroundWorker(BackgroundWorker const& copy) = delete;
+    BackgroundWorker(BackgroundWorker&& move) = delete;
+    BackgroundWorker& operator=(BackgroundWorker const& copy) = delete;
+    BackgroundWorker& operator=(BackgroundWorker&& move) = delete;
+
+    /// Finishes the running job and the waiting one, if any, before joining the thread
+    ~BackgroundWorker();
+
+    /**
+     * @return true if this replaced a job that was still waiting to run
+     */
+    bool push(Job_t job);
+
+    /// @return true if no job is running or waiting
+    [[nodiscard]] bool idle() const;
+
+    /// Block until no job is running or waiting
+    void wait_idle();
+
+private:
+    void run();
+
+    mutable std::mutex          m_mutex;
+    std::condition_variable     m_cv;
+    Job_t                       m_pending;
+    bool                        m_running{false};
+    bool                        m_stop{false};
+
+    // Declared last so it starts after everything it uses is constructed
+    std::thread                 m_thread;
+};
+
+} // namespace osp
@@ -0,0 +1,253 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "input_recording.h"
+
+#include "../core/byte_stream.h"
+
+#include <longeron/utility/asserts.hpp>
+
+#include <array>
+#include <cstdio>
+#include <memory>
+
+namespace osp::input
+{
+
+namespace
+{
+
+constexpr std::array<char, 4> gc_inputRecordingMagic {'O', 'S', 'P', 'I'};
+
+struct InputRecordingHeader
+{
+    std::array<char, 4>     magic;
+    std::uint32_t           version;
+    std::uint32_t           frameCount;
+};
+
+struct FrameHeader
+{
+    float                   delta;
+    std::uint32_t           eventCount;
+};
+
+struct ButtonRecord
+{
+    std::uint32_t           deviceId;
+    std::int32_t            buttonEnum;
+    EButtonEvent            dir;
+};
+
+struct DeltaRecord
+{
+    std::int32_t            x;
+    std::int32_t            y;
+};
+
+struct FileCloser
+{
+    void operator()(std::FILE* pFile) const noexcept { std::fclose(pFile); }
+};
+
+using File_t = std::unique_ptr<std::FILE, FileCloser>;
+
+/**
+ * @brief Read one frame, passing each event to func
+ *
+ * @return Delta time of the frame, or nullopt if the data is truncated or has unknown events
+ */
+template <typename FUNC_T>
+std::optional<float> read_frame(ByteReader& rReader, FUNC_T&& func)
+{
+    FrameHeader frame;
+    if ( ! rReader.read(frame) )
+    {
+        return std::nullopt;
+    }
+
+    for (std::uint32_t i = 0; i < frame.eventCount; ++i)
+    {
+        ERecordedEvent kind;
+        if ( ! rReader.read(kind) )
+        {
+            return std::nullopt;
+        }
+
+        switch (kind)
+        {
+        case ERecordedEvent::Button:
+        {
+            ButtonRecord button;
+            if (   ! rReader.read(button)
+                || (button.dir != EButtonEvent::Pressed && button.dir != EButtonEvent::Released))
+            {
+                return std::nullopt;
+            }
+            func(kind, button, DeltaRecord{});
+            break;
+        }
+        case ERecordedEvent::MouseDelta:
+        case ERecordedEvent::ScrollDelta:
+        {
+            DeltaRecord delta;
+            if ( ! rReader.read(delta) )
+            {
+                return std::nullopt;
+            }
+            func(kind, ButtonRecord{}, delta);
+            break;
+        }
+        default:
+            return std::nullopt;
+        }
+    }
+
+    return frame.delta;
+}
+
+} // namespace
+
+void InputRecorder::button(UserInputHandler::DeviceId const deviceId, int const buttonEnum, EButtonEvent const dir)
+{
+    append_bytes(m_currentEvents, ERecordedEvent::Button);
+    append_bytes(m_currentEvents, ButtonRecord{deviceId, std::int32_t(buttonEnum), dir});
+    ++m_currentEventCount;
+}
+
+void InputRecorder::mouse_delta(Vector2i const delta)
+{
+    append_bytes(m_currentEvents, ERecordedEvent::MouseDelta);
+    append_bytes(m_currentEvents, DeltaRecord{delta.x(), delta.y()});
+    ++m_currentEventCount;
+}
+
+void InputRecorder::scroll_delta(Vector2i const offset)
+{
+    append_bytes(m_currentEvents, ERecordedEvent::ScrollDelta);
+    append_bytes(m_currentEvents, DeltaRecord{offset.x(), offset.y()});
+    ++m_currentEventCount;
+}
+
+void InputRecorder::end_frame(float const delta)
+{
+    append_bytes(m_frames, FrameHeader{delta, m_currentEventCount});
+    m_frames.insert(m_frames.end(), m_currentEvents.begin(), m_currentEvents.end());
+    m_currentEvents.clear();
+    m_currentEventCount = 0;
+    ++m_frameCount;
+}
+
+bool InputRecorder::save(char const* const path) const
+{
+    File_t const pFile{std::fopen(path, "wb")};
+    if (pFile == nullptr)
+    {
+        return false;
+    }
+
+    InputRecordingHeader const header
+    {
+        .magic      = gc_inputRecordingMagic,
+        .version    = gc_inputRecordingVersion,
+        .frameCount = m_frameCount
+    };
+
+    return     std::fwrite(&header, sizeof(header), 1, pFile.get()) == 1
+            && std::fwrite(m_frames.data(), 1, m_frames.size(), pFile.get()) == m_frames.size();
+}
+
+std::optional<InputPlayback> InputPlayback::load(char const* const path)
+{
+    File_t const pFile{std::fopen(path, "rb")};
+    if (pFile == nullptr)
+    {
+        return std::nullopt;
+    }
+
+    InputRecordingHeader header;
+    if (   std::fread(&header, sizeof(header), 1, pFile.get()) != 1
+        || header.magic   != gc_inputRecordingMagic
+        || header.version != gc_inputRecordingVersion)
+    {
+        return std::nullopt;
+    }
+
+    InputPlayback out;
+    out.m_frameCount = header.frameCount;
+
+    std::array<std::byte, 4096> buffer;
+    std::size_t readCount;
+    while ((readCount = std::fread(buffer.data(), 1, buffer.size(), pFile.get())) != 0)
+    {
+        out.m_data.insert(out.m_data.end(), buffer.begin(), buffer.begin() + readCount);
+    }
+
+    // Validate every frame up front, so play_frame doesn't need to
+    ByteReader reader{{out.m_data.data(), out.m_data.size()}};
+    for (std::uint32_t i = 0; i < header.frameCount; ++i)
+    {
+        if ( ! read_frame(reader, [] (ERecordedEvent, ButtonRecord const&, DeltaRecord const&) { }) )
+        {
+            return std::nullopt;
+        }
+    }
+
+    return out;
+}
+
+std::optional<float> InputPlayback::play_frame(UserInputHandler& rUserInput)
+{
+    if (m_framesPlayed == m_frameCount)
+    {
+        return std::nullopt;
+    }
+
+    ByteReader reader{{m_data.data() + m_pos, m_data.size() - m_pos}};
+
+    std::optional<float> const delta = read_frame(reader,
+            [&rUserInput] (ERecordedEvent const kind, ButtonRecord const& button, DeltaRecord const& motion)
+    {
+        switch (kind)
+        {
+        case ERecordedEvent::Button:
+            rUserInput.event_raw(button.deviceId, button.buttonEnum, button.dir);
+            break;
+        case ERecordedEvent::MouseDelta:
+            rUserInput.mouse_delta({motion.x, motion.y});
+            break;
+        case ERecordedEvent::ScrollDelta:
+            rUserInput.scroll_delta({motion.x, motion.y});
+            break;
+        }
+    });
+
+    LGRN_ASSERTM(delta.has_value(), "Recording was validated on load");
+
+    m_pos = m_data.size() - reader.remaining().size();
+    ++m_framesPlayed;
+    return delta;
+}
+
+} // namespace osp::input
@@ -0,0 +1,118 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "UserInputHandler.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace osp::input
+{
+
+/**
+ * @brief Version of the input recording format, recordings of other versions fail to load
+ */
+constexpr std::uint32_t gc_inputRecordingVersion = 1;
+
+enum class ERecordedEvent : std::uint8_t { Button = 0, MouseDelta = 1, ScrollDelta = 2 };
+
+/**
+ * @brief Records raw input events and the delta time of each frame, to be replayed with
+ *        InputPlayback
+ *
+ * Feed it the same calls made to UserInputHandler, then call end_frame once per frame. Values
+ * are stored in native byte order, recordings are meant to be replayed on the same platform.
+ */
+class InputRecorder
+{
+public:
+
+    void button(UserInputHandler::DeviceId deviceId, int buttonEnum, EButtonEvent dir);
+
+    void mouse_delta(Vector2i delta);
+
+    void scroll_delta(Vector2i offset);
+
+    /**
+     * @brief Finish the current frame, events recorded after this belong to the next frame
+     *
+     * @param delta [in] Delta time passed to the scene this frame
+     */
+    void end_frame(float delta);
+
+    [[nodiscard]] std::size_t frame_count() const noexcept { return m_frameCount; }
+
+    /**
+     * @brief Write all finished frames to a file
+     *
+     * @return true on success
+     */
+    bool save(char const* path) const;
+
+private:
+    std::vector<std::byte>  m_frames;
+    std::vector<std::byte>  m_currentEvents;
+    std::uint32_t           m_currentEventCount {0};
+    std::uint32_t           m_frameCount        {0};
+};
+
+/**
+ * @brief Plays back a recording made by InputRecorder into a UserInputHandler, one frame at a
+ *        time
+ */
+class InputPlayback
+{
+public:
+
+    /**
+     * @return Playback from the first frame, or nullopt if the file is missing, corrupt, or a
+     *         different version
+     */
+    [[nodiscard]] static std::optional<InputPlayback> load(char const* path);
+
+    /**
+     * @brief Feed the next frame's events into rUserInput
+     *
+     * Call at the same point of the frame as the events were recorded, before update_controls.
+     *
+     * @return Delta time of the frame, or nullopt if all frames were played
+     */
+    std::optional<float> play_frame(UserInputHandler& rUserInput);
+
+    [[nodiscard]] std::size_t frame_count() const noexcept { return m_frameCount; }
+
+    [[nodiscard]] std::size_t frames_played() const noexcept { return m_framesPlayed; }
+
+private:
+    std::vector<std::byte>  m_data;
+    std::size_t             m_pos           {0};
+    std::uint32_t           m_frameCount    {0};
+    std::uint32_t           m_framesPlayed  {0};
+};
+
+} // namespace osp::input
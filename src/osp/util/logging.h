@@ -27,6 +27,11 @@
 #define SPDLOG_ACTIVE_LEVEL SPDLOG_LEVEL_INFO
 #include <spdlog/spdlog.h>
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
 namespace osp
 {
 using Logger_t = std::shared_ptr<spdlog::logger>;
@@ -38,6 +43,45 @@ inline void set_thread_logger(Logger_t logger)
     t_logger = std::move(logger);
 }
 
+/**
+ * @brief Lets through at most one message per interval, see OSP_LOG_RATE_LIMITED
+ *
+ * Lock-free, so one limiter can be shared by all threads logging the same category.
+ */
+class LogRateLimiter
+{
+    using Clock_t = std::chrono::steady_clock;
+
+public:
+
+    /**
+     * @param rSuppressedOut [out] Set to the number of messages held back since the last one
+     *                             that passed, only if this returns true
+     *
+     * @return true if a message may be logged now
+     */
+    bool pass(float const intervalSeconds, std::uint32_t& rSuppressedOut) noexcept
+    {
+        std::int64_t const now      = Clock_t::now().time_since_epoch().count();
+        std::int64_t const interval = std::chrono::duration_cast<Clock_t::duration>(
+                std::chrono::duration<float>(intervalSeconds)).count();
+
+        std::int64_t next = m_next.load(std::memory_order_relaxed);
+        if (now < next || ! m_next.compare_exchange_strong(next, now + interval, std::memory_order_relaxed))
+        {
+            m_suppressed.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        rSuppressedOut = m_suppressed.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+
+private:
+    std::atomic<std::int64_t>   m_next{std::numeric_limits<std::int64_t>::min()};
+    std::atomic<std::uint32_t>  m_suppressed{0};
+};
+
 } // namespace osp
 
 #define OSP_LOG_TRACE(...) SPDLOG_LOGGER_TRACE(osp::t_logger, __VA_ARGS__)
@@ -46,3 +90,27 @@ inline void set_thread_logger(Logger_t logger)
 #define OSP_LOG_WARN(...) SPDLOG_LOGGER_TRACE(osp::t_logger, __VA_ARGS__)
 #define OSP_LOG_ERROR(...) SPDLOG_LOGGER_ERROR(osp::t_logger, __VA_ARGS__)
 #define OSP_LOG_CRITICAL(...) SPDLOG_LOGGER_CRITICAL(osp::t_logger, __VA_ARGS__)
+
+/**
+ * @brief Log with one of the OSP_LOG_* macros at most once every intervalSeconds
+ *
+ * Each use is its own category with its own limit. Messages held back are counted and reported
+ * along with the next message that gets through, so chatty diagnostics can be left in code
+ * that runs every frame.
+ *
+ * Usage: OSP_LOG_RATE_LIMITED(OSP_LOG_INFO, 1.0f, "Spawned {} vehicles", count);
+ */
+#define OSP_LOG_RATE_LIMITED(LOG_MACRO, intervalSeconds, ...)                                      \
+    do                                                                                              \
+    {                                                                                               \
+        static ::osp::LogRateLimiter s_ospLogLimiter;                                               \
+        std::uint32_t ospLogSuppressed = 0;                                                         \
+        if (s_ospLogLimiter.pass(intervalSeconds, ospLogSuppressed))                                \
+        {                                                                                           \
+            if (ospLogSuppressed != 0)                                                              \
+            {                                                                                       \
+                LOG_MACRO("({} similar messages suppressed)", ospLogSuppressed);                    \
+            }                                                                                       \
+            LOG_MACRO(__VA_ARGS__);                                                                 \
+        }                                                                                           \
+    } while (false)
@@ -0,0 +1,195 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "metrics.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace osp
+{
+
+void MetricHistogram::record(double const value) const
+{
+    std::lock_guard const lock{m_mutex};
+
+    if (m_samples.size() < smc_window)
+    {
+        m_samples.push_back(value);
+    }
+    else
+    {
+        m_samples[m_next] = value;
+        m_next = (m_next + 1) % smc_window;
+    }
+
+    m_max = (m_count == 0) ? value : std::max(m_max, value);
+    m_sum += value;
+    ++ m_count;
+}
+
+MetricHistogram::Summary MetricHistogram::summary() const
+{
+    std::vector<double> sorted;
+    Summary out;
+    {
+        std::lock_guard const lock{m_mutex};
+        sorted      = m_samples;
+        out.count   = m_count;
+        out.mean    = (m_count == 0) ? 0.0 : m_sum / double(m_count);
+        out.max     = m_max;
+    }
+
+    if (sorted.empty())
+    {
+        return out;
+    }
+
+    // Nearest-rank percentiles
+    auto const rank = [&sorted] (double const p) -> double
+    {
+        std::size_t const index = std::min(sorted.size() - 1,
+                                           std::size_t(std::ceil(p * double(sorted.size()))) - 1);
+        std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+        return sorted[index];
+    };
+
+    out.p50 = rank(0.50);
+    out.p99 = rank(0.99);
+
+    return out;
+}
+
+template <typename T>
+static T& get_or_create(std::mutex& rMutex, std::map< std::string, std::unique_ptr<T>, std::less<> >& rMap, std::string_view const name)
+{
+    std::lock_guard const lock{rMutex};
+
+    auto it = rMap.find(name);
+    if (it == rMap.end())
+    {
+        it = rMap.emplace(std::string{name}, std::make_unique<T>()).first;
+    }
+    return *it->second;
+}
+
+std::atomic<std::int64_t>& Metrics::counter(std::string_view const name) const
+{
+    return get_or_create(m_mutex, m_counters, name);
+}
+
+std::atomic<double>& Metrics::gauge(std::string_view const name) const
+{
+    return get_or_create(m_mutex, m_gauges, name);
+}
+
+MetricHistogram const& Metrics::histogram(std::string_view const name) const
+{
+    return get_or_create(m_mutex, m_histograms, name);
+}
+
+std::ostream& operator<<(std::ostream& rStream, MetricsWriteCsv const& write)
+{
+    Metrics const &rMetrics = write.metrics;
+    std::lock_guard const lock{rMetrics.m_mutex};
+
+    if (write.header)
+    {
+        rStream << "name,kind,value,count,mean,p50,p99,max\n";
+    }
+
+    auto const matches = [&write] (std::string_view const name) noexcept
+    {
+        return name.starts_with(write.prefix);
+    };
+
+    for (auto const& [name, pValue] : rMetrics.m_counters)
+    {
+        if ( ! matches(name) )
+        {
+            continue;
+        }
+        rStream << name << ",counter," << pValue->load(std::memory_order_relaxed) << ",,,,,\n";
+    }
+
+    for (auto const& [name, pValue] : rMetrics.m_gauges)
+    {
+        if ( ! matches(name) )
+        {
+            continue;
+        }
+        rStream << name << ",gauge," << pValue->load(std::memory_order_relaxed) << ",,,,,\n";
+    }
+
+    for (auto const& [name, pHistogram] : rMetrics.m_histograms)
+    {
+        if ( ! matches(name) )
+        {
+            continue;
+        }
+        MetricHistogram::Summary const s = pHistogram->summary();
+        rStream << name << ",histogram,," << s.count << ',' << s.mean << ',' << s.p50 << ',' << s.p99 << ',' << s.max << '\n';
+    }
+
+    return rStream;
+}
+
+std::ostream& operator<<(std::ostream& rStream, MetricsWriteJson const& write)
+{
+    Metrics const &rMetrics = write.metrics;
+    std::lock_guard const lock{rMetrics.m_mutex};
+
+    // Metric names are chosen by code, not users; they're assumed to not need escaping
+    auto const write_values = [&rStream] (auto const& map)
+    {
+        char const *separator = "";
+        for (auto const& [name, pValue] : map)
+        {
+            rStream << separator << "\n    \"" << name << "\": " << pValue->load(std::memory_order_relaxed);
+            separator = ",";
+        }
+    };
+
+    rStream << "{\n  \"counters\": {";
+    write_values(rMetrics.m_counters);
+    rStream << "\n  },\n  \"gauges\": {";
+    write_values(rMetrics.m_gauges);
+    rStream << "\n  },\n  \"histograms\": {";
+
+    char const *separator = "";
+    for (auto const& [name, pHistogram] : rMetrics.m_histograms)
+    {
+        MetricHistogram::Summary const s = pHistogram->summary();
+        rStream << separator << "\n    \"" << name << "\": {"
+                << "\"count\": " << s.count << ", \"mean\": " << s.mean
+                << ", \"p50\": " << s.p50   << ", \"p99\": "  << s.p99
+                << ", \"max\": " << s.max   << '}';
+        separator = ",";
+    }
+    rStream << "\n  }\n}\n";
+
+    return rStream;
+}
+
+} // namespace osp
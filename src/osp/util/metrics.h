@@ -0,0 +1,153 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace osp
+{
+
+struct MetricsWriteCsv;
+struct MetricsWriteJson;
+
+/**
+ * @brief Thread-safe distribution of recent samples, for percentiles
+ *
+ * Percentiles are over the last smc_window samples only, so they follow the current state
+ * instead of being dominated by startup. Count, sum and max cover all samples.
+ */
+class MetricHistogram
+{
+public:
+    static constexpr std::size_t smc_window = 1024;
+
+    struct Summary
+    {
+        std::uint64_t   count   {0};
+        double          mean    {0.0};
+        double          p50     {0.0};
+        double          p99     {0.0};
+        double          max     {0.0};
+    };
+
+    void record(double value) const;
+
+    [[nodiscard]] Summary summary() const;
+
+private:
+    mutable std::mutex              m_mutex;
+    mutable std::vector<double>     m_samples;
+    mutable std::size_t             m_next  {0};
+    mutable std::uint64_t           m_count {0};
+    mutable double                  m_sum   {0.0};
+    mutable double                  m_max   {0.0};
+};
+
+/**
+ * @brief Registry of named counters, gauges, and histograms
+ *
+ * Metrics are created on first use, and references returned stay valid for the lifetime of the
+ * registry; cache them to skip the name lookup. Everything is safe to use from multiple threads.
+ *
+ * All functions are const so that tasks can take a Metrics const& argument. Tasks that only read
+ * a TopData can run in parallel, which would otherwise not be possible for a registry every task
+ * writes to.
+ */
+class Metrics
+{
+public:
+    /// Monotonic count of events, such as exec_update calls
+    std::atomic<std::int64_t>& counter(std::string_view name) const;
+
+    /// Last value of something, such as the number of draw calls in the last frame
+    std::atomic<double>& gauge(std::string_view name) const;
+
+    /// Distribution of a value, such as frame time in milliseconds
+    MetricHistogram const& histogram(std::string_view name) const;
+
+    void counter_add(std::string_view name, std::int64_t amount = 1) const
+    {
+        counter(name).fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    void gauge_set(std::string_view name, double value) const
+    {
+        gauge(name).store(value, std::memory_order_relaxed);
+    }
+
+    void histogram_record(std::string_view name, double value) const
+    {
+        histogram(name).record(value);
+    }
+
+private:
+    template <typename T>
+    using Map_t = std::map< std::string, std::unique_ptr<T>, std::less<> >;
+
+    mutable std::mutex                          m_mutex;
+    mutable Map_t<std::atomic<std::int64_t>>    m_counters;
+    mutable Map_t<std::atomic<double>>          m_gauges;
+    mutable Map_t<MetricHistogram>              m_histograms;
+
+    friend std::ostream& operator<<(std::ostream& rStream, MetricsWriteCsv const& write);
+    friend std::ostream& operator<<(std::ostream& rStream, MetricsWriteJson const& write);
+};
+
+/**
+ * @brief Write all metrics as CSV, one row per metric
+ *
+ * Columns: name, kind, value, count, mean, p50, p99, max. Counters and gauges only fill value;
+ * histograms fill everything but value.
+ */
+struct MetricsWriteCsv
+{
+    Metrics const       &metrics;
+    bool                header{true};
+
+    /// Only write metrics with names that start with this, such as "mem_"
+    std::string_view    prefix{};
+};
+
+/**
+ * @brief Write all metrics as a single JSON object with "counters", "gauges", and "histograms"
+ */
+struct MetricsWriteJson
+{
+    Metrics const   &metrics;
+};
+
+std::ostream& operator<<(std::ostream& rStream, MetricsWriteCsv const& write);
+
+std::ostream& operator<<(std::ostream& rStream, MetricsWriteJson const& write);
+
+} // namespace osp
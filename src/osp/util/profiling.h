@@ -0,0 +1,105 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+/**
+ * @file
+ * @brief Profiler zones, compiled out entirely unless OSP_PROFILE_TRACY is non-zero
+ *
+ * Zones are sent to Tracy (https://github.com/wolfpld/tracy) when built with the
+ * OSP_ENABLE_TRACY CMake option. Otherwise every macro here expands to nothing, so zones can be
+ * left in hot loops and Tracy isn't needed to build. GPU zones are in drawing_gl/profiling_gl.h.
+ */
+#pragma once
+
+#ifndef OSP_PROFILE_TRACY
+    #define OSP_PROFILE_TRACY 0
+#endif
+
+#if OSP_PROFILE_TRACY
+
+#include <tracy/Tracy.hpp>
+#include <tracy/TracyC.h>
+
+#include <cstdint>
+#include <string_view>
+
+#define OSP_PROFILE_CONCAT_B(a, b) a##b
+#define OSP_PROFILE_CONCAT_A(a, b) OSP_PROFILE_CONCAT_B(a, b)
+
+/// Zone from here to the end of the enclosing scope, name must be a string literal
+#define OSP_PROFILE_ZONE(name) ZoneScopedN(name)
+
+/// Zone from here to the end of the enclosing scope, named at runtime such as after a TopTask
+#define OSP_PROFILE_ZONE_DYNAMIC(name) \
+    ::tracy::ScopedZone OSP_PROFILE_CONCAT_A(ospProfileZone, __LINE__){ \
+        std::uint32_t(__LINE__), __FILE__, sizeof(__FILE__) - 1, __func__, sizeof(__func__) - 1, \
+        std::string_view{name}.data(), std::string_view{name}.size(), true }
+
+/// Mark the end of a frame, call once per frame
+#define OSP_PROFILE_FRAME() FrameMark
+
+/// Name the calling thread, the name is copied
+#define OSP_PROFILE_THREAD_NAME(name) ::tracy::SetThreadName(name)
+
+namespace osp
+{
+
+/**
+ * @brief Zone that begins and ends in different functions, see OSP_PROFILE_SPLIT_BEGIN
+ *
+ * Split zones must still nest properly with other zones of the same thread.
+ */
+struct ProfileSplitZone
+{
+    TracyCZoneCtx ctx{};
+};
+
+} // namespace osp
+
+#define OSP_PROFILE_SPLIT_BEGIN(rZone, name) \
+    do { \
+        TracyCZone(ospProfileCtx, 1); \
+        TracyCZoneName(ospProfileCtx, std::string_view{name}.data(), std::string_view{name}.size()); \
+        (rZone).ctx = ospProfileCtx; \
+    } while (false)
+
+#define OSP_PROFILE_SPLIT_END(rZone) TracyCZoneEnd((rZone).ctx)
+
+#else // OSP_PROFILE_TRACY
+
+#define OSP_PROFILE_ZONE(name)
+#define OSP_PROFILE_ZONE_DYNAMIC(name)
+#define OSP_PROFILE_FRAME()
+#define OSP_PROFILE_THREAD_NAME(name)
+#define OSP_PROFILE_SPLIT_BEGIN(rZone, name) ((void)(rZone))
+#define OSP_PROFILE_SPLIT_END(rZone) ((void)(rZone))
+
+namespace osp
+{
+
+struct ProfileSplitZone { };
+
+} // namespace osp
+
+#endif // OSP_PROFILE_TRACY
@@ -0,0 +1,101 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "ImporterData.h"
+
+#include <Magnum/Trade/PbrMetallicRoughnessMaterialData.h>
+
+namespace osp
+{
+
+void compile_prefab_templates(Prefabs &rPrefabs, ImporterData const& rImportData)
+{
+    std::size_t const prefabCount = rPrefabs.m_prefabNames.size();
+
+    rPrefabs.m_templates.clear();
+    rPrefabs.m_templates.resize(prefabCount);
+
+    for (PrefabId prefab = 0; prefab < prefabCount; ++prefab)
+    {
+        auto const objects          = rPrefabs.m_prefabs[prefab];
+        auto const parents          = rPrefabs.m_prefabParents[prefab];
+        std::size_t const count     = objects.size();
+        PrefabTemplate &rTemplate   = rPrefabs.m_templates[prefab];
+
+        rTemplate.descendants   .resize(count);
+        rTemplate.parents       .assign(parents.begin(), parents.end());
+        rTemplate.transforms    .resize(count);
+        rTemplate.meshes        .resize(count, lgrn::id_null<ResId>());
+        rTemplate.baseColorTex  .resize(count, lgrn::id_null<ResId>());
+        rTemplate.shapes        .resize(count);
+        rTemplate.masses        .resize(count);
+        rTemplate.inertias      .resize(count);
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            ObjId const obj = objects[i];
+
+            rTemplate.descendants[i]    = static_cast<uint32_t>(rImportData.m_objDescendants[obj]);
+            rTemplate.transforms[i]     = rImportData.m_objTransforms[obj];
+            rTemplate.shapes[i]         = rPrefabs.m_objShape[obj];
+            rTemplate.masses[i]         = rPrefabs.m_objMass[obj];
+
+            if (float const mass = rTemplate.masses[i];
+                mass != 0.0f)
+            {
+                rTemplate.inertias[i] = collider_inertia_tensor(
+                        rTemplate.shapes[i], rTemplate.transforms[i].scaling(), mass);
+            }
+
+            int const meshImportId = rImportData.m_objMeshes[obj];
+            if (meshImportId == -1)
+            {
+                continue;
+            }
+
+            rTemplate.meshes[i] = rImportData.m_meshes[meshImportId];
+
+            int const matImportId = rImportData.m_objMaterials[obj];
+            if (   matImportId < 0
+                || std::size_t(matImportId) >= rImportData.m_materials.size()
+                || ! bool(rImportData.m_materials[matImportId]))
+            {
+                continue;
+            }
+
+            if (Magnum::Trade::MaterialData const &mat = *rImportData.m_materials[matImportId];
+                mat.types() & Magnum::Trade::MaterialType::PbrMetallicRoughness)
+            {
+                auto const& matPbr = mat.as<Magnum::Trade::PbrMetallicRoughnessMaterialData>();
+                if (auto const baseColor = matPbr.baseColorTexture();
+                    baseColor != -1)
+                {
+                    rTemplate.baseColorTex[i] = rImportData.m_textures[baseColor];
+                }
+            }
+        }
+    }
+}
+
+} // namespace osp
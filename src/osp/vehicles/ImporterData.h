@@ -80,6 +80,33 @@ struct ImporterData
     std::vector<int>                        m_objMaterials;
 };
 
+/**
+ * @brief Per-object data of a single prefab, precomputed so instantiating it is mostly bulk copies
+ *
+ * Objects are in the same depth-first order as Prefabs::m_prefabs, which is also the order they're
+ * laid out in a ACtxSceneGraph subtree.
+ */
+struct PrefabTemplate
+{
+    std::vector<uint32_t>   descendants;
+
+    // Index of parent within this prefab, -1 for the root
+    std::vector<int32_t>    parents;
+
+    // Local transforms. The root's is replaced with the spawn transform
+    std::vector<Matrix4>    transforms;
+
+    // Null if object has no mesh or base color texture
+    std::vector<ResId>      meshes;
+    std::vector<ResId>      baseColorTex;
+
+    std::vector<EShape>     shapes;
+    std::vector<float>      masses;
+    std::vector<Vector3>    inertias;
+
+    [[nodiscard]] std::size_t size() const noexcept { return descendants.size(); }
+};
+
 /**
  * @brief Groups objects in an ImporterData intended to make them instantiable
  */
@@ -94,6 +121,17 @@ struct Prefabs
 
     std::vector<EShape>                     m_objShape;
     std::vector<float>                      m_objMass;
+
+    // [prefab Id], see compile_prefab_templates
+    std::vector<PrefabTemplate>             m_templates;
 };
 
+/**
+ * @brief Fill Prefabs::m_templates from its prefabs and the ImporterData they refer to
+ *
+ * Call after m_prefabs, m_prefabParents, m_objShape and m_objMass are populated, and again if
+ * any of them change.
+ */
+void compile_prefab_templates(Prefabs &rPrefabs, ImporterData const& rImportData);
+
 } // namespace osp
@@ -0,0 +1,855 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "asset_cache.h"
+#include "ImporterData.h"
+
+#include "../core/byte_stream.h"
+#include "../core/Resources.h"
+#include "../drawing/image_mips.h"
+#include "../drawing/own_restypes.h"
+#include "../util/logging.h"
+
+#include <Magnum/Math/Color.h>
+#include <Magnum/Mesh.h>
+#include <Magnum/PixelFormat.h>
+#include <Magnum/VertexFormat.h>
+#include <Magnum/Trade/Data.h>
+#include <Magnum/Trade/ImageData.h>
+#include <Magnum/Trade/MeshData.h>
+#include <Magnum/Trade/PbrMetallicRoughnessMaterialData.h>
+#include <Magnum/Trade/TextureData.h>
+
+#include <Corrade/Containers/Array.h>
+#include <Corrade/Containers/Optional.h>
+#include <Corrade/Containers/StridedArrayView.h>
+#include <Corrade/Containers/StringStlView.h>
+#include <Corrade/Utility/Path.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+using namespace osp;
+
+using Magnum::Trade::DataFlags;
+using Magnum::Trade::ImageData2D;
+using Magnum::Trade::MaterialAttribute;
+using Magnum::Trade::MaterialData;
+using Magnum::Trade::MaterialType;
+using Magnum::Trade::MaterialTypes;
+using Magnum::Trade::MeshAttributeData;
+using Magnum::Trade::MeshData;
+using Magnum::Trade::MeshIndexData;
+using Magnum::Trade::PbrMetallicRoughnessMaterialData;
+using Magnum::Trade::TextureData;
+
+using Magnum::Int;
+using Magnum::UnsignedInt;
+using Magnum::UnsignedShort;
+using Magnum::Vector2i;
+using Magnum::Vector3i;
+
+using Corrade::Containers::Array;
+using Corrade::Containers::Optional;
+using Corrade::Containers::StridedArrayView1D;
+
+namespace Path = Corrade::Utility::Path;
+
+namespace
+{
+
+/**
+ * @brief Keeps a cache file mapped for as long as the importer resource loaded from it exists
+ */
+struct AssetCacheMapping
+{
+    Array<char const, Path::MapDeleter> m_data;
+};
+
+constexpr std::array<char, 4>   gc_assetCacheMagic      {'O', 'S', 'P', 'A'};
+
+// Payloads are aligned so mesh and image views into the mapping are aligned for any vertex or
+// pixel format. Mappings themselves start on a page boundary.
+constexpr std::size_t           gc_payloadAlignment     = 16;
+
+struct AssetCacheHeader
+{
+    std::array<char, 4>     magic;
+    std::uint32_t           version;
+    std::uint64_t           sourceHash;
+    std::uint64_t           metaSize;
+};
+
+constexpr std::size_t align_up(std::size_t const value) noexcept
+{
+    return (value + gc_payloadAlignment - 1) / gc_payloadAlignment * gc_payloadAlignment;
+}
+
+/**
+ * @brief Location of a mesh or image payload, relative to the start of the payload section
+ */
+struct PayloadRef
+{
+    std::uint64_t offset;
+    std::uint64_t size;
+};
+
+PayloadRef append_payload(std::vector<std::byte> &rPayload, void const* pData, std::size_t const size)
+{
+    rPayload.resize(align_up(rPayload.size()));
+    PayloadRef const out{rPayload.size(), size};
+    append_bytes(rPayload, pData, size);
+    return out;
+}
+
+void append_string(std::vector<std::byte> &rOut, std::string_view const str)
+{
+    append_bytes(rOut, std::uint32_t(str.size()));
+    append_bytes(rOut, str.data(), str.size());
+}
+
+template <typename MAP_T>
+void append_span(std::vector<std::byte> &rOut, MAP_T const& map, std::size_t const id)
+{
+    if ( ! map.contains(id) )
+    {
+        append_bytes(rOut, std::uint32_t(0));
+        return;
+    }
+    auto const span = map[id];
+    append_bytes(rOut, std::uint32_t(span.size()));
+    append_bytes(rOut, span.data(), span.size() * sizeof(span[0]));
+}
+
+/**
+ * @brief Reads the metadata section, with views into the payload section
+ */
+class CacheReader : public ByteReader
+{
+public:
+    CacheReader(ArrayView<std::byte const> meta, ArrayView<std::byte const> payload) noexcept
+     : ByteReader{meta}
+     , m_payload{payload}
+    { }
+
+    [[nodiscard]] bool read_string(std::string_view &rOut) noexcept
+    {
+        std::uint32_t size;
+        ArrayView<std::byte const> bytes;
+        if ( ! read(size) || ! read_view(size, bytes) )
+        {
+            return false;
+        }
+        rOut = {reinterpret_cast<char const*>(bytes.data()), bytes.size()};
+        return true;
+    }
+
+    [[nodiscard]] bool read_payload(ArrayView<std::byte const> &rOut) noexcept
+    {
+        PayloadRef ref;
+        if ( ! read(ref) || ref.offset > m_payload.size() || ref.size > m_payload.size() - ref.offset )
+        {
+            return false;
+        }
+        rOut = {m_payload.data() + ref.offset, std::size_t(ref.size)};
+        return true;
+    }
+
+    /// @brief Read a count followed by that many values, into a span of a multimap
+    template <typename MAP_T>
+    [[nodiscard]] bool read_span(MAP_T &rMap, std::size_t const id, std::size_t const maxCount)
+    {
+        using Value_t = std::remove_reference_t<decltype(rMap[id][0])>;
+        std::uint32_t count;
+        if ( ! read(count) || count > maxCount )
+        {
+            return false;
+        }
+        Value_t *pValues = rMap.emplace(id, count);
+        return read(pValues, count * sizeof(Value_t));
+    }
+
+private:
+    ArrayView<std::byte const> m_payload;
+};
+
+} // namespace
+
+void osp::register_asset_cache_resources(Resources &rResources)
+{
+    rResources.data_register<AssetCacheMapping>(restypes::gc_importer);
+}
+
+std::uint64_t osp::asset_source_hash(std::string_view const filepath, std::uint32_t const importOptions)
+{
+    Optional<Array<char>> const data = Path::read(filepath);
+    if ( ! bool(data) )
+    {
+        return 0;
+    }
+
+    // FNV-1a
+    std::uint64_t hash = 14695981039346656037ull;
+    auto const add = [&hash] (unsigned char const byte)
+    {
+        hash = (hash ^ byte) * 1099511628211ull;
+    };
+    for (char const c : *data)
+    {
+        add(static_cast<unsigned char>(c));
+    }
+    for (std::size_t i = 0; i < sizeof(importOptions); ++i)
+    {
+        add(static_cast<unsigned char>(importOptions >> (i * 8)));
+    }
+    return hash;
+}
+
+bool osp::bake_asset_cache(
+        std::string_view    cachePath,
+        std::uint64_t       sourceHash,
+        Resources const     &rResources,
+        ResId               importer)
+{
+    using namespace restypes;
+
+    auto const *pImportData = rResources.data_try_get<ImporterData const>(gc_importer, importer);
+    auto const *pPrefabs    = rResources.data_try_get<Prefabs const>(gc_importer, importer);
+
+    if (pImportData == nullptr || pPrefabs == nullptr || sourceHash == 0)
+    {
+        return false;
+    }
+
+    ImporterData const  &rImportData    = *pImportData;
+    Prefabs const       &rPrefabs       = *pPrefabs;
+
+    std::vector<std::byte> meta;
+    std::vector<std::byte> payload;
+
+    std::size_t const objCount = rImportData.m_objParents.size();
+
+    append_bytes(meta, std::uint32_t(rImportData.m_images.size()));
+    append_bytes(meta, std::uint32_t(rImportData.m_textures.size()));
+    append_bytes(meta, std::uint32_t(rImportData.m_meshes.size()));
+    append_bytes(meta, std::uint32_t(rImportData.m_materials.size()));
+    append_bytes(meta, std::uint32_t(objCount));
+    append_bytes(meta, std::uint32_t(rImportData.m_scnTopLevel.ids_count()));
+
+    for (ResIdOwner_t const& imgRes : rImportData.m_images)
+    {
+        auto const *pImg = imgRes.has_value()
+                         ? rResources.data_try_get<ImageData2D const>(gc_image, imgRes)
+                         : nullptr;
+        append_bytes(meta, std::uint8_t(pImg != nullptr));
+        if (pImg == nullptr)
+        {
+            continue;
+        }
+
+        bool const isCompressed = pImg->isCompressed();
+        if (isCompressed
+                ? Magnum::isCompressedPixelFormatImplementationSpecific(pImg->compressedFormat())
+                : Magnum::isPixelFormatImplementationSpecific(pImg->format()))
+        {
+            OSP_LOG_INFO("Not caching {}: image can't be stored", rResources.name(gc_importer, importer));
+            return false;
+        }
+
+        append_string(meta, rResources.name(gc_image, imgRes));
+        append_bytes(meta, std::uint8_t(isCompressed));
+        if (isCompressed)
+        {
+            // Compressed blocks are tightly packed when transcoded from Basis
+            append_bytes(meta, pImg->compressedFormat());
+            append_bytes(meta, pImg->size());
+            append_bytes(meta, append_payload(payload, pImg->data().data(), pImg->data().size()));
+            continue;
+        }
+
+        append_bytes(meta, pImg->format());
+        append_bytes(meta, pImg->size());
+        append_bytes(meta, pImg->storage().alignment());
+        append_bytes(meta, pImg->storage().rowLength());
+        append_bytes(meta, pImg->storage().skip());
+        append_bytes(meta, append_payload(payload, pImg->data().data(), pImg->data().size()));
+
+        // Mip levels are baked too, so streaming them in later doesn't need to downsample
+        auto const *pMips = rResources.data_try_get<ImageMipChain const>(gc_image, imgRes);
+        ImageMipChain const generated = (pMips == nullptr) ? make_mip_chain(*pImg) : ImageMipChain{};
+        ImageMipChain const &rMips = (pMips == nullptr) ? generated : *pMips;
+
+        append_bytes(meta, std::uint8_t(rMips.m_levels.size()));
+        for (ImageData2D const& level : rMips.m_levels)
+        {
+            append_bytes(meta, level.size());
+            append_bytes(meta, append_payload(payload, level.data().data(), level.data().size()));
+        }
+    }
+
+    for (ResIdOwner_t const& texRes : rImportData.m_textures)
+    {
+        auto const *pTex = texRes.has_value()
+                         ? rResources.data_try_get<TextureData const>(gc_texture, texRes)
+                         : nullptr;
+        append_bytes(meta, std::uint8_t(pTex != nullptr));
+        if (pTex == nullptr)
+        {
+            continue;
+        }
+
+        append_string(meta, rResources.name(gc_texture, texRes));
+        append_bytes(meta, pTex->type());
+        append_bytes(meta, pTex->minificationFilter());
+        append_bytes(meta, pTex->magnificationFilter());
+        append_bytes(meta, pTex->mipmapFilter());
+        append_bytes(meta, pTex->wrapping());
+        append_bytes(meta, pTex->image());
+    }
+
+    for (ResIdOwner_t const& meshRes : rImportData.m_meshes)
+    {
+        auto const *pMesh = meshRes.has_value()
+                          ? rResources.data_try_get<MeshData const>(gc_mesh, meshRes)
+                          : nullptr;
+        append_bytes(meta, std::uint8_t(pMesh != nullptr));
+        if (pMesh == nullptr)
+        {
+            continue;
+        }
+
+        MeshData const &rMesh = *pMesh;
+
+        bool storable = ! Magnum::isMeshPrimitiveImplementationSpecific(rMesh.primitive());
+        for (UnsignedInt i = 0; i < rMesh.attributeCount(); ++i)
+        {
+            storable = storable
+                    && ! Magnum::isVertexFormatImplementationSpecific(rMesh.attributeFormat(i))
+                    && rMesh.attributeStride(i) >= 0;
+        }
+        if ( ! storable )
+        {
+            OSP_LOG_INFO("Not caching {}: mesh can't be stored", rResources.name(gc_importer, importer));
+            return false;
+        }
+
+        append_string(meta, rResources.name(gc_mesh, meshRes));
+        append_bytes(meta, rMesh.primitive());
+        append_bytes(meta, rMesh.vertexCount());
+        append_bytes(meta, std::uint8_t(rMesh.isIndexed()));
+        if (rMesh.isIndexed())
+        {
+            append_bytes(meta, rMesh.indexType());
+            append_bytes(meta, std::uint64_t(rMesh.indexOffset()));
+            append_bytes(meta, rMesh.indexCount());
+            append_bytes(meta, append_payload(payload, rMesh.indexData().data(), rMesh.indexData().size()));
+        }
+        append_bytes(meta, append_payload(payload, rMesh.vertexData().data(), rMesh.vertexData().size()));
+
+        append_bytes(meta, rMesh.attributeCount());
+        for (UnsignedInt i = 0; i < rMesh.attributeCount(); ++i)
+        {
+            append_bytes(meta, rMesh.attributeName(i));
+            append_bytes(meta, rMesh.attributeFormat(i));
+            append_bytes(meta, std::uint64_t(rMesh.attributeOffset(i)));
+            append_bytes(meta, Int(rMesh.attributeStride(i)));
+            append_bytes(meta, rMesh.attributeArraySize(i));
+        }
+    }
+
+    // Only what prefab drawing reads from materials is stored
+    for (ImporterData::OptMaterialData_t const& mat : rImportData.m_materials)
+    {
+        bool const isPbr = bool(mat) && (mat->types() & MaterialType::PbrMetallicRoughness);
+        append_bytes(meta, std::uint8_t(bool(mat)));
+        append_bytes(meta, std::uint8_t(isPbr));
+        if (isPbr)
+        {
+            auto const &matPbr = mat->as<PbrMetallicRoughnessMaterialData>();
+            bool const hasTex = matPbr.hasAttribute(MaterialAttribute::BaseColorTexture);
+            append_bytes(meta, matPbr.baseColor());
+            append_bytes(meta, std::uint8_t(hasTex));
+            append_bytes(meta, hasTex ? matPbr.baseColorTexture() : UnsignedInt(0));
+        }
+    }
+
+    for (std::size_t obj = 0; obj < objCount; ++obj)
+    {
+        append_string(meta, rImportData.m_objNames[obj]);
+        append_bytes(meta, rImportData.m_objParents[obj]);
+        append_bytes(meta, std::uint64_t(rImportData.m_objDescendants[obj]));
+        append_bytes(meta, rImportData.m_objTransforms[obj]);
+        append_bytes(meta, rImportData.m_objMeshes[obj]);
+        append_bytes(meta, rImportData.m_objMaterials[obj]);
+        append_span(meta, rImportData.m_objChildren, obj);
+    }
+
+    for (std::size_t scn = 0; scn < rImportData.m_scnTopLevel.ids_count(); ++scn)
+    {
+        append_span(meta, rImportData.m_scnTopLevel, scn);
+    }
+
+    append_bytes(meta, rPrefabs.m_objShape.data(),  objCount * sizeof(EShape));
+    append_bytes(meta, rPrefabs.m_objMass.data(),   objCount * sizeof(float));
+
+    append_bytes(meta, std::uint32_t(rPrefabs.m_prefabNames.size()));
+    for (PrefabId prefab = 0; prefab < rPrefabs.m_prefabNames.size(); ++prefab)
+    {
+        append_span(meta, rPrefabs.m_prefabs,       prefab);
+        append_span(meta, rPrefabs.m_prefabParents, prefab);
+    }
+
+    AssetCacheHeader const header{gc_assetCacheMagic, gc_assetCacheVersion, sourceHash, meta.size()};
+
+    std::vector<std::byte> file;
+    file.reserve(align_up(sizeof(header) + meta.size()) + payload.size());
+    append_bytes(file, header);
+    file.insert(file.end(), meta.begin(), meta.end());
+    file.resize(align_up(file.size()));
+    file.insert(file.end(), payload.begin(), payload.end());
+
+    return Path::write(cachePath, Corrade::Containers::ArrayView<void const>{file.data(), file.size()});
+}
+
+ResId osp::load_asset_cache(
+        std::string_view    cachePath,
+        std::uint64_t       sourceHash,
+        std::string_view    name,
+        Resources           &rResources,
+        PkgId               pkg)
+{
+    using namespace restypes;
+
+    if ( ! Path::exists(cachePath) )
+    {
+        return lgrn::id_null<ResId>();
+    }
+
+    Optional<Array<char const, Path::MapDeleter>> mapping = Path::mapRead(cachePath);
+    if ( ! bool(mapping) )
+    {
+        return lgrn::id_null<ResId>();
+    }
+
+    ArrayView<std::byte const> const file{reinterpret_cast<std::byte const*>(mapping->data()), mapping->size()};
+
+    AssetCacheHeader header;
+    if (   ! ByteReader{file}.read(header)
+        || header.magic         != gc_assetCacheMagic
+        || header.version       != gc_assetCacheVersion
+        || header.sourceHash    != sourceHash
+        || header.metaSize      >  file.size() - sizeof(header))
+    {
+        return lgrn::id_null<ResId>();
+    }
+
+    std::size_t const payloadStart = align_up(sizeof(header) + header.metaSize);
+    if (payloadStart > file.size())
+    {
+        return lgrn::id_null<ResId>();
+    }
+
+    CacheReader reader{{file.data() + sizeof(header),   std::size_t(header.metaSize)},
+                       {file.data() + payloadStart,     file.size() - payloadStart}};
+
+    // Everything is read and checked before any resources are created
+
+    std::uint32_t imageCount, textureCount, meshCount, materialCount, objCount, sceneCount;
+    if (   ! reader.read(imageCount)    || ! reader.read(textureCount)  || ! reader.read(meshCount)
+        || ! reader.read(materialCount) || ! reader.read(objCount)      || ! reader.read(sceneCount))
+    {
+        return lgrn::id_null<ResId>();
+    }
+
+    // Every count is followed by at least one byte per element, which bounds allocations below
+    // by the size of the file
+    if (std::size_t(imageCount) + textureCount + meshCount + materialCount + objCount + sceneCount
+            > header.metaSize)
+    {
+        return lgrn::id_null<ResId>();
+    }
+
+    std::vector< Optional<ImageData2D> >    images(imageCount);
+    std::vector<std::string_view>           imageNames(imageCount);
+    std::vector<ImageMipChain>              imageMips(imageCount);
+    for (UnsignedInt i = 0; i < imageCount; ++i)
+    {
+        std::uint8_t present;
+        if ( ! reader.read(present) )
+        {
+            return lgrn::id_null<ResId>();
+        }
+        if ( ! present )
+        {
+            continue;
+        }
+
+        std::uint8_t                isCompressed;
+        Vector2i                    size;
+        ArrayView<std::byte const>  data;
+        if ( ! reader.read_string(imageNames[i]) || ! reader.read(isCompressed) )
+        {
+            return lgrn::id_null<ResId>();
+        }
+
+        if (isCompressed)
+        {
+            Magnum::CompressedPixelFormat compressedFormat;
+            if ( ! reader.read(compressedFormat) || ! reader.read(size) || ! reader.read_payload(data) )
+            {
+                return lgrn::id_null<ResId>();
+            }
+            images[i] = ImageData2D{compressedFormat, size, DataFlags{}, data};
+            continue;
+        }
+
+        Magnum::PixelFormat         format;
+        Int                         alignment;
+        Int                         rowLength;
+        Vector3i                    skip;
+        if (   ! reader.read(format) || ! reader.read(size)
+            || ! reader.read(alignment) || ! reader.read(rowLength) || ! reader.read(skip)
+            || ! reader.read_payload(data))
+        {
+            return lgrn::id_null<ResId>();
+        }
+
+        Magnum::PixelStorage storage;
+        storage.setAlignment(alignment).setRowLength(rowLength).setSkip(skip);
+
+        // Payload contents aren't checked beyond their bounds, only bake_asset_cache writes these
+        images[i] = ImageData2D{storage, format, size, DataFlags{}, data};
+
+        std::uint8_t mipCount;
+        if ( ! reader.read(mipCount) || mipCount >= 32 )
+        {
+            return lgrn::id_null<ResId>();
+        }
+        imageMips[i].m_levels.reserve(mipCount);
+        for (std::uint8_t level = 0; level < mipCount; ++level)
+        {
+            Vector2i                    mipSize;
+            ArrayView<std::byte const>  mipData;
+            if (   ! reader.read(mipSize) || ! reader.read_payload(mipData)
+                || mipSize.x() <= 0 || mipSize.y() <= 0
+                || mipData.size() < std::size_t(mipSize.product()) * Magnum::pixelFormatSize(format))
+            {
+                return lgrn::id_null<ResId>();
+            }
+            imageMips[i].m_levels.emplace_back(Magnum::PixelStorage{}.setAlignment(1), format, mipSize, DataFlags{}, mipData);
+        }
+    }
+
+    std::vector< Optional<TextureData> >    textures(textureCount);
+    std::vector<std::string_view>           textureNames(textureCount);
+    for (UnsignedInt i = 0; i < textureCount; ++i)
+    {
+        std::uint8_t present;
+        if ( ! reader.read(present) )
+        {
+            return lgrn::id_null<ResId>();
+        }
+        if ( ! present )
+        {
+            continue;
+        }
+
+        Magnum::Trade::TextureType              type;
+        Magnum::SamplerFilter                   minFilter;
+        Magnum::SamplerFilter                   magFilter;
+        Magnum::SamplerMipmap                   mipmap;
+        Magnum::Math::Vector3<Magnum::SamplerWrapping> wrapping;
+        UnsignedInt                             image;
+        if (   ! reader.read_string(textureNames[i]) || ! reader.read(type)
+            || ! reader.read(minFilter) || ! reader.read(magFilter) || ! reader.read(mipmap)
+            || ! reader.read(wrapping) || ! reader.read(image) || image >= imageCount)
+        {
+            return lgrn::id_null<ResId>();
+        }
+
+        textures[i] = TextureData{type, minFilter, magFilter, mipmap, wrapping, image};
+    }
+
+    std::vector< Optional<MeshData> >       meshes(meshCount);
+    std::vector<std::string_view>           meshNames(meshCount);
+    for (UnsignedInt i = 0; i < meshCount; ++i)
+    {
+        std::uint8_t present;
+        if ( ! reader.read(present) )
+        {
+            return lgrn::id_null<ResId>();
+        }
+        if ( ! present )
+        {
+            continue;
+        }
+
+        Magnum::MeshPrimitive       primitive;
+        UnsignedInt                 vertexCount;
+        std::uint8_t                indexed;
+        Magnum::MeshIndexType       indexType{};
+        std::uint64_t               indexOffset{};
+        UnsignedInt                 indexCount{};
+        ArrayView<std::byte const>  indexData;
+        ArrayView<std::byte const>  vertexData;
+        UnsignedInt                 attribCount;
+
+        if (   ! reader.read_string(meshNames[i]) || ! reader.read(primitive)
+            || ! reader.read(vertexCount) || ! reader.read(indexed))
+        {
+            return lgrn::id_null<ResId>();
+        }
+        if (indexed)
+        {
+            if (   ! reader.read(indexType) || ! reader.read(indexOffset) || ! reader.read(indexCount)
+                || ! reader.read_payload(indexData)
+                || indexOffset > indexData.size()
+                || std::uint64_t(indexCount) * Magnum::meshIndexTypeSize(indexType) > indexData.size() - indexOffset)
+            {
+                return lgrn::id_null<ResId>();
+            }
+        }
+        if (   ! reader.read_payload(vertexData) || ! reader.read(attribCount)
+            || attribCount > header.metaSize)
+        {
+            return lgrn::id_null<ResId>();
+        }
+
+        Array<MeshAttributeData> attribs{Corrade::ValueInit, attribCount};
+        for (MeshAttributeData &rAttrib : attribs)
+        {
+            Magnum::Trade::MeshAttribute    attribName;
+            Magnum::VertexFormat            format;
+            std::uint64_t                   offset;
+            Int                             stride;
+            UnsignedShort                   arraySize;
+            if (   ! reader.read(attribName) || ! reader.read(format) || ! reader.read(offset)
+                || ! reader.read(stride) || ! reader.read(arraySize) || stride < 0)
+            {
+                return lgrn::id_null<ResId>();
+            }
+
+            // Last vertex must end within the vertex data
+            std::uint64_t const elementSize = std::uint64_t(Magnum::vertexFormatSize(format)) * std::max<UnsignedShort>(arraySize, 1);
+            std::uint64_t const end = (vertexCount == 0)
+                                    ? offset
+                                    : offset + std::uint64_t(vertexCount - 1) * stride + elementSize;
+            if (end > vertexData.size())
+            {
+                return lgrn::id_null<ResId>();
+            }
+
+            rAttrib = MeshAttributeData{attribName, format,
+                    StridedArrayView1D<void const>{vertexData, vertexData.data() + offset, vertexCount, stride},
+                    arraySize};
+        }
+
+        if (indexed)
+        {
+            MeshIndexData const indices{indexType,
+                    ArrayView<std::byte const>{indexData.data() + indexOffset,
+                                               indexCount * Magnum::meshIndexTypeSize(indexType)}};
+            meshes[i] = MeshData{primitive, DataFlags{}, indexData, indices,
+                                 DataFlags{}, vertexData, std::move(attribs), vertexCount};
+        }
+        else
+        {
+            meshes[i] = MeshData{primitive, DataFlags{}, vertexData, std::move(attribs), vertexCount};
+        }
+    }
+
+    ImporterData importData;
+
+    importData.m_materials.resize(materialCount);
+    for (UnsignedInt i = 0; i < materialCount; ++i)
+    {
+        std::uint8_t present;
+        std::uint8_t isPbr;
+        if ( ! reader.read(present) || ! reader.read(isPbr) )
+        {
+            return lgrn::id_null<ResId>();
+        }
+
+        if (isPbr)
+        {
+            Magnum::Color4  baseColor;
+            std::uint8_t    hasTex;
+            UnsignedInt     tex;
+            if ( ! reader.read(baseColor) || ! reader.read(hasTex) || ! reader.read(tex) )
+            {
+                return lgrn::id_null<ResId>();
+            }
+
+            if (hasTex)
+            {
+                importData.m_materials[i] = MaterialData{MaterialType::PbrMetallicRoughness, {
+                    {MaterialAttribute::BaseColor,          baseColor},
+                    {MaterialAttribute::BaseColorTexture,   tex}
+                }};
+            }
+            else
+            {
+                importData.m_materials[i] = MaterialData{MaterialType::PbrMetallicRoughness, {
+                    {MaterialAttribute::BaseColor,          baseColor}
+                }};
+            }
+        }
+        else if (present)
+        {
+            importData.m_materials[i] = MaterialData{MaterialTypes{}, Array<Magnum::Trade::MaterialAttributeData>{}};
+        }
+    }
+
+    importData.m_objNames       .resize(objCount);
+    importData.m_objParents     .resize(objCount);
+    importData.m_objDescendants .resize(objCount);
+    importData.m_objTransforms  .resize(objCount);
+    importData.m_objMeshes      .resize(objCount);
+    importData.m_objMaterials   .resize(objCount);
+    importData.m_objChildren    .ids_reserve(objCount);
+    importData.m_objChildren    .data_reserve(objCount);
+    importData.m_scnTopLevel    .ids_reserve(sceneCount);
+    importData.m_scnTopLevel    .data_reserve(objCount);
+
+    for (UnsignedInt obj = 0; obj < objCount; ++obj)
+    {
+        std::string_view    objName;
+        std::uint64_t       descendants;
+        if (   ! reader.read_string(objName)
+            || ! reader.read(importData.m_objParents[obj])
+            || ! reader.read(descendants)
+            || ! reader.read(importData.m_objTransforms[obj])
+            || ! reader.read(importData.m_objMeshes[obj])
+            || ! reader.read(importData.m_objMaterials[obj])
+            || ! reader.read_span(importData.m_objChildren, obj, objCount))
+        {
+            return lgrn::id_null<ResId>();
+        }
+        importData.m_objNames[obj]          = Corrade::Containers::String{objName.data(), objName.size()};
+        importData.m_objDescendants[obj]    = descendants;
+    }
+
+    for (UnsignedInt scn = 0; scn < sceneCount; ++scn)
+    {
+        if ( ! reader.read_span(importData.m_scnTopLevel, scn, objCount) )
+        {
+            return lgrn::id_null<ResId>();
+        }
+    }
+
+    Prefabs prefabs;
+    prefabs.m_objShape  .resize(objCount);
+    prefabs.m_objMass   .resize(objCount);
+
+    std::uint32_t prefabCount;
+    if (   ! reader.read(prefabs.m_objShape.data(), objCount * sizeof(EShape))
+        || ! reader.read(prefabs.m_objMass.data(),  objCount * sizeof(float))
+        || ! reader.read(prefabCount)
+        || prefabCount > objCount)
+    {
+        return lgrn::id_null<ResId>();
+    }
+
+    prefabs.m_prefabs       .ids_reserve(prefabCount);
+    prefabs.m_prefabs       .data_reserve(objCount);
+    prefabs.m_prefabParents .ids_reserve(prefabCount);
+    prefabs.m_prefabParents .data_reserve(objCount);
+    for (PrefabId prefab = 0; prefab < prefabCount; ++prefab)
+    {
+        if (   ! reader.read_span(prefabs.m_prefabs,        prefab, objCount)
+            || ! reader.read_span(prefabs.m_prefabParents,  prefab, objCount)
+            || prefabs.m_prefabs[prefab].empty()
+            || std::size_t(prefabs.m_prefabs[prefab][0]) >= objCount)
+        {
+            return lgrn::id_null<ResId>();
+        }
+    }
+
+    // Add everything to Resources, same as load_tinygltf_file and assigns_prefabs_tinygltf
+
+    ResId const res = rResources.create(gc_importer, pkg, SharedString::create(name));
+
+    importData.m_images.resize(imageCount);
+    for (UnsignedInt i = 0; i < imageCount; ++i)
+    {
+        if (bool(images[i]))
+        {
+            ResId const imgRes = rResources.create(gc_image, pkg, SharedString::create(imageNames[i]));
+            importData.m_images[i] = rResources.owner_create(gc_image, imgRes);
+            rResources.data_add<ImageData2D>(gc_image, imgRes, std::move(*images[i]));
+            if ( ! imageMips[i].m_levels.empty() )
+            {
+                rResources.data_add<ImageMipChain>(gc_image, imgRes, std::move(imageMips[i]));
+            }
+        }
+    }
+
+    importData.m_textures.resize(textureCount);
+    for (UnsignedInt i = 0; i < textureCount; ++i)
+    {
+        if (bool(textures[i]))
+        {
+            UnsignedInt const texImage = textures[i]->image();
+
+            ResId const texRes = rResources.create(gc_texture, pkg, SharedString::create(textureNames[i]));
+            importData.m_textures[i] = rResources.owner_create(gc_texture, texRes);
+            rResources.data_add<TextureData>(gc_texture, texRes, std::move(*textures[i]));
+
+            if (ResIdOwner_t const& imgRes = importData.m_images[texImage];
+                imgRes.has_value())
+            {
+                ResIdOwner_t imgOwner = rResources.owner_create(gc_image, imgRes);
+                rResources.data_add<TextureImgSource>(gc_texture, texRes, TextureImgSource{std::move(imgOwner)} );
+            }
+        }
+    }
+
+    importData.m_meshes.resize(meshCount);
+    for (UnsignedInt i = 0; i < meshCount; ++i)
+    {
+        if (bool(meshes[i]))
+        {
+            ResId const meshRes = rResources.create(gc_mesh, pkg, SharedString::create(meshNames[i]));
+            rResources.data_add<MeshData>(gc_mesh, meshRes, std::move(*meshes[i]));
+            importData.m_meshes[i] = rResources.owner_create(gc_mesh, meshRes);
+        }
+    }
+
+    auto const &rImportData = rResources.data_add<ImporterData>(gc_importer, res, std::move(importData));
+
+    // Prefab names point into the stored ImporterData's object names
+    prefabs.m_prefabNames.reserve(prefabCount);
+    for (PrefabId prefab = 0; prefab < prefabCount; ++prefab)
+    {
+        auto const &rRootName = rImportData.m_objNames[prefabs.m_prefabs[prefab][0]];
+        prefabs.m_prefabNames.emplace_back(rRootName.hasPrefix("part_") ? rRootName.exceptPrefix("part_") : Corrade::Containers::StringView{rRootName});
+    }
+
+    compile_prefab_templates(prefabs, rImportData);
+    rResources.data_add<Prefabs>(gc_importer, res, std::move(prefabs));
+    rResources.data_add<AssetCacheMapping>(gc_importer, res, AssetCacheMapping{std::move(*mapping)});
+
+    return res;
+}
@@ -0,0 +1,99 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+/**
+ * @file
+ * @brief Baked binary cache of an importer's ImporterData, Prefabs, meshes, images and textures
+ *
+ * Loading a cache skips glTF parsing and image decoding. The cache file is memory-mapped, and
+ * mesh and image data added to Resources are views into the mapping instead of copies.
+ */
+#pragma once
+
+#include "../core/resourcetypes.h"
+
+#include <cstdint>
+#include <string_view>
+
+namespace osp
+{
+
+/**
+ * @brief Version of the asset cache format
+ *
+ * Increment whenever the layout changes, old caches are then rebaked.
+ */
+constexpr std::uint32_t gc_assetCacheVersion = 3;
+
+void register_asset_cache_resources(Resources &rResources);
+
+/**
+ * @brief Hash the contents of a source file, used to tell if a cache is out of date
+ *
+ * Only the file itself is hashed, not external buffers or images it refers to.
+ *
+ * @param importOptions [in] Anything else that changes what gets imported, such as the
+ *                           EBasisTarget that Basis images are transcoded to
+ *
+ * @return 0 if the file can't be read
+ */
+[[nodiscard]] std::uint64_t asset_source_hash(std::string_view filepath, std::uint32_t importOptions = 0);
+
+/**
+ * @brief Write an importer resource loaded with load_tinygltf_file and assigns_prefabs_tinygltf
+ *        to a cache file
+ *
+ * Fails if anything can't be stored, such as implementation-specific formats; the source file
+ * should be loaded the usual way every time instead. Compressed images, such as transcoded
+ * Basis images, are stored as-is. Uncompressed images are stored with their ImageMipChain,
+ * which is generated if the image doesn't have one yet.
+ *
+ * @return true if the cache was written
+ */
+bool bake_asset_cache(
+        std::string_view    cachePath,
+        std::uint64_t       sourceHash,
+        Resources const     &rResources,
+        ResId               importer);
+
+/**
+ * @brief Load an importer resource from a cache file written by bake_asset_cache
+ *
+ * The importer resource gets ImporterData and Prefabs, and owns the mapping of the file, which
+ * its meshes and images point into. Images get an ImageMipChain if they have one, which must be
+ * registered on gc_image.
+ *
+ * @param name          [in] Name of the new importer resource, usually the source file path
+ *
+ * @return New importer resource, or null if the cache is missing, corrupt, or its version or
+ *         source hash don't match. No resources are created on failure.
+ */
+[[nodiscard]] ResId load_asset_cache(
+        std::string_view    cachePath,
+        std::uint64_t       sourceHash,
+        std::string_view    name,
+        Resources           &rResources,
+        PkgId               pkg);
+
+} // namespace osp
@@ -26,6 +26,7 @@
 #include "load_tinygltf.h"
 #include "ImporterData.h"
 
+#include "../core/package_archive.h"
 #include "../core/Resources.h"
 #include "../drawing/own_restypes.h"
 #include "../util/logging.h"
@@ -33,16 +34,26 @@
 #include <MagnumPlugins/TinyGltfImporter/TinyGltfImporter.h>
 #include <MagnumExternal/TinyGltf/tiny_gltf.h>
 
+#include <Magnum/FileCallback.h>
 #include <Magnum/Trade/ImageData.h>
 #include <Magnum/Trade/TextureData.h>
 #include <Magnum/Trade/MeshData.h>
 #include <Magnum/Trade/SceneData.h>
 
 #include <Corrade/PluginManager/Manager.h>
+#include <Corrade/PluginManager/PluginMetadata.h>
+#include <Corrade/Utility/Configuration.h>
+#include <Corrade/Containers/ArrayViewStl.h>
 #include <Corrade/Containers/StringStlView.h>
 #include <Corrade/Containers/Pair.h>
 #include <Corrade/Containers/PairStl.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <thread>
+
 using namespace osp;
 
 using Magnum::Trade::TinyGltfImporter;
@@ -66,34 +77,86 @@ using Corrade::Containers::Pair;
 
 using TinyGltfNodeExtras_t = std::vector<tinygltf::Value>;
 
+namespace
+{
+
+// Same order as EBasisTarget, values of BasisImporter's "format" configuration option
+constexpr std::array<std::string_view, 6> gc_basisFormatNames
+{
+    "RGBA8", "Bc1RGB", "Bc3RGBA", "Bc7RGBA", "Etc2RGBA", "Astc4x4RGBA"
+};
+
+} // namespace
+
+EBasisTarget osp::default_basis_target() noexcept
+{
+#ifdef MAGNUM_TARGET_GLES
+    return EBasisTarget::Astc4x4RGBA;
+#else
+    // BPTC is core since OpenGL 4.2
+    return EBasisTarget::Bc7RGBA;
+#endif
+}
+
+std::optional<EBasisTarget> osp::basis_target_from_name(std::string_view const name) noexcept
+{
+    auto const found = std::find(gc_basisFormatNames.begin(), gc_basisFormatNames.end(), name);
+    if (found == gc_basisFormatNames.end())
+    {
+        return std::nullopt;
+    }
+    return EBasisTarget(std::distance(gc_basisFormatNames.begin(), found));
+}
+
+/**
+ * @brief Make image importers loaded by this plugin manager transcode Basis images to a target
+ *
+ * Settings are per-manager, each loading thread has its own.
+ */
+static void configure_basis_importer(PluginManager &rPluginManager, EBasisTarget const target)
+{
+    if (Corrade::PluginManager::PluginMetadata *pMetadata = rPluginManager.metadata("BasisImporter");
+        pMetadata != nullptr)
+    {
+        pMetadata->configuration().setValue("format", std::string{gc_basisFormatNames[std::size_t(target)]});
+    }
+}
+
 void osp::register_tinygltf_resources(Resources &rResources)
 {
     rResources.data_register<TinyGltfNodeExtras_t>(restypes::gc_importer);
 }
 
-static void load_gltf(TinyGltfImporter &rImporter, ResId res, std::string_view name, Resources &rResources, PkgId pkg)
+namespace
 {
-    using namespace restypes;
 
-    // Combine resource names. Maybe make this customizable
-    // ie: name = "dir/file.gltf" and resName = "mytexture"
-    // "dir/file.gltf:mytexture"
-    // "unnamed-[id]" is used as the resource name if it's empty
-    auto format_name = [name](std::string_view resName, UnsignedInt id)
-    {
-        if ( ! resName.empty())
-        {
-            return SharedString::create_from_parts(name, ":", resName);
-        }
-        else
-        {
-            // i don't like std::to_string but screw it, fix it later
-            return SharedString::create_from_parts(name, ":unnamed-", std::to_string(id));
-        }
-    };
+/**
+ * @brief Everything read out of a glTF file, before any of it is added to Resources
+ *
+ * Decoding doesn't touch Resources at all, so files can be decoded on worker threads, each with
+ * its own importer. ImporterData's owned resources are left empty until register_gltf.
+ */
+struct DecodedGltf
+{
+    using String = Corrade::Containers::String;
 
-    auto &rImportData = rResources.data_add<ImporterData>(restypes::gc_importer, res);
-    auto &rNodeExtras = rResources.data_add<TinyGltfNodeExtras_t>(restypes::gc_importer, res);
+    std::vector< Optional<ImageData2D> >    m_images;
+    std::vector<String>                     m_imageNames;
+    std::vector< Optional<TextureData> >    m_textures;
+    std::vector<String>                     m_textureNames;
+    std::vector< Optional<MeshData> >       m_meshes;
+    std::vector<String>                     m_meshNames;
+
+    ImporterData                            m_importData;
+    TinyGltfNodeExtras_t                    m_nodeExtras;
+};
+
+} // namespace
+
+static void decode_gltf(TinyGltfImporter &rImporter, DecodedGltf &rOut)
+{
+    auto &rImportData = rOut.m_importData;
+    auto &rNodeExtras = rOut.m_nodeExtras;
 
     // Allocate various data
     rImportData.m_images        .resize(rImporter.image2DCount());
@@ -119,63 +182,31 @@ static void load_gltf(TinyGltfImporter &rImporter, ResId res, std::string_view n
     rImportData.m_scnTopLevel.ids_reserve(rImporter.sceneCount());
     rImportData.m_scnTopLevel.data_reserve(rImporter.objectCount());
 
-    // Store images
+    // Decode images
+    rOut.m_images       .reserve(rImporter.image2DCount());
+    rOut.m_imageNames   .reserve(rImporter.image2DCount());
     for (UnsignedInt i = 0; i < rImporter.image2DCount(); i ++)
     {
-        Optional<ImageData2D> img = rImporter.image2D(i);
-
-        if ( ! bool(img) )
-        {
-            continue;
-        }
-
-        // Create and keep track of resource Id
-        ResId const imgRes = rResources.create(gc_image, pkg, format_name(rImporter.image2DName(i), i));
-        rImportData.m_images[i] = rResources.owner_create(gc_image, imgRes);
-
-        // Add image data to resource
-        rResources.data_add<ImageData2D>(gc_image, imgRes, std::move(*img));
+        rOut.m_images       .push_back(rImporter.image2D(i));
+        rOut.m_imageNames   .push_back(rImporter.image2DName(i));
     }
 
-    // Store textures
+    // Read textures
+    rOut.m_textures     .reserve(rImporter.textureCount());
+    rOut.m_textureNames .reserve(rImporter.textureCount());
     for (UnsignedInt i = 0; i < rImporter.textureCount(); i ++)
     {
-        Optional<TextureData> tex = rImporter.texture(i);
-
-        if ( ! bool(tex) )
-        {
-            continue;
-        }
-
-        // Create and keep track of resource Id
-        ResId const texRes = rResources.create(gc_texture, pkg, format_name(rImporter.textureName(i), i));
-        rImportData.m_textures[i] = rResources.owner_create(gc_texture, texRes);
-
-        // Add data to resource
-        rResources.data_add<TextureData>(gc_texture, texRes, std::move(*tex));
-
-        // Keep track of which image this texture uses
-        if (ResIdOwner_t const& imgRes = rImportData.m_images.at(tex->image());
-            imgRes.has_value())
-        {
-            ResIdOwner_t imgOwner = rResources.owner_create(gc_image, imgRes);
-            rResources.data_add<TextureImgSource>(gc_texture, texRes, TextureImgSource{std::move(imgOwner)} );
-        }
+        rOut.m_textures     .push_back(rImporter.texture(i));
+        rOut.m_textureNames .push_back(rImporter.textureName(i));
     }
 
-    // Store meshes
+    // Extract meshes
+    rOut.m_meshes       .reserve(rImporter.meshCount());
+    rOut.m_meshNames    .reserve(rImporter.meshCount());
     for (UnsignedInt i = 0; i < rImporter.meshCount(); i ++)
     {
-        Optional<MeshData> mesh = rImporter.mesh(i);
-
-        if ( ! bool(mesh) )
-        {
-            continue;
-        }
-
-        ResId const meshRes = rResources.create(gc_mesh, pkg, format_name(rImporter.meshName(i), i));
-        rResources.data_add<MeshData>(gc_mesh, meshRes, std::move(*mesh));
-        rImportData.m_meshes[i] = rResources.owner_create(gc_mesh, meshRes);
+        rOut.m_meshes       .push_back(rImporter.mesh(i));
+        rOut.m_meshNames    .push_back(rImporter.meshName(i));
     }
 
     // Store materials
@@ -324,30 +355,227 @@ static void load_gltf(TinyGltfImporter &rImporter, ResId res, std::string_view n
     }
 }
 
-
-ResId osp::load_tinygltf_file(std::string_view filepath, Resources &rResources, PkgId pkg)
+static ResId register_gltf(DecodedGltf &&rDecoded, std::string_view name, Resources &rResources, PkgId pkg)
 {
-    PluginManager pluginManager;
+    using namespace restypes;
 
+    // Combine resource names. Maybe make this customizable
+    // ie: name = "dir/file.gltf" and resName = "mytexture"
+    // "dir/file.gltf:mytexture"
+    // "unnamed-[id]" is used as the resource name if it's empty
+    auto format_name = [name](std::string_view resName, UnsignedInt id)
+    {
+        if ( ! resName.empty())
+        {
+            return SharedString::create_from_parts(name, ":", resName);
+        }
+        else
+        {
+            // i don't like std::to_string but screw it, fix it later
+            return SharedString::create_from_parts(name, ":unnamed-", std::to_string(id));
+        }
+    };
 
     // Create Importer resource
-    ResId const res = rResources.create(restypes::gc_importer, pkg, SharedString::create(filepath));
-    TinyGltfImporter importer{pluginManager};
+    ResId const res = rResources.create(gc_importer, pkg, SharedString::create(name));
+
+    ImporterData &rImportData = rDecoded.m_importData;
+
+    // Store images
+    for (UnsignedInt i = 0; i < rDecoded.m_images.size(); i ++)
+    {
+        Optional<ImageData2D> &rImg = rDecoded.m_images[i];
+
+        if ( ! bool(rImg) )
+        {
+            continue;
+        }
+
+        // Create and keep track of resource Id
+        ResId const imgRes = rResources.create(gc_image, pkg, format_name(rDecoded.m_imageNames[i], i));
+        rImportData.m_images[i] = rResources.owner_create(gc_image, imgRes);
+
+        // Add image data to resource
+        rResources.data_add<ImageData2D>(gc_image, imgRes, std::move(*rImg));
+    }
+
+    // Store textures
+    for (UnsignedInt i = 0; i < rDecoded.m_textures.size(); i ++)
+    {
+        Optional<TextureData> &rTex = rDecoded.m_textures[i];
+
+        if ( ! bool(rTex) )
+        {
+            continue;
+        }
+
+        UnsignedInt const texImage = rTex->image();
+
+        // Create and keep track of resource Id
+        ResId const texRes = rResources.create(gc_texture, pkg, format_name(rDecoded.m_textureNames[i], i));
+        rImportData.m_textures[i] = rResources.owner_create(gc_texture, texRes);
+
+        // Add data to resource
+        rResources.data_add<TextureData>(gc_texture, texRes, std::move(*rTex));
+
+        // Keep track of which image this texture uses
+        if (ResIdOwner_t const& imgRes = rImportData.m_images.at(texImage);
+            imgRes.has_value())
+        {
+            ResIdOwner_t imgOwner = rResources.owner_create(gc_image, imgRes);
+            rResources.data_add<TextureImgSource>(gc_texture, texRes, TextureImgSource{std::move(imgOwner)} );
+        }
+    }
+
+    // Store meshes
+    for (UnsignedInt i = 0; i < rDecoded.m_meshes.size(); i ++)
+    {
+        Optional<MeshData> &rMesh = rDecoded.m_meshes[i];
+
+        if ( ! bool(rMesh) )
+        {
+            continue;
+        }
+
+        ResId const meshRes = rResources.create(gc_mesh, pkg, format_name(rDecoded.m_meshNames[i], i));
+        rResources.data_add<MeshData>(gc_mesh, meshRes, std::move(*rMesh));
+        rImportData.m_meshes[i] = rResources.owner_create(gc_mesh, meshRes);
+    }
+
+    rResources.data_add<ImporterData>(gc_importer, res, std::move(rImportData));
+    rResources.data_add<TinyGltfNodeExtras_t>(gc_importer, res, std::move(rDecoded.m_nodeExtras));
+
+    return res;
+}
+
+/**
+ * @brief Serve files the importer asks for from a package archive, without copying them
+ */
+static Optional< Corrade::Containers::ArrayView<char const> > archive_file_callback(
+        Corrade::Containers::StringView const   filename,
+        Magnum::InputFileCallbackPolicy         policy,
+        PackageArchive const&                   rArchive)
+{
+    if (policy == Magnum::InputFileCallbackPolicy::Close)
+    {
+        return {}; // Mapping stays alive with the archive, nothing to free
+    }
+
+    std::optional< ArrayView<char const> > const data = rArchive.find(std::string_view{filename});
+    if ( ! data.has_value() )
+    {
+        return {};
+    }
+    return *data;
+}
+
+/**
+ * @brief Open and decode a glTF file
+ *
+ * @param pArchive  [in] Archive to read files from, or nullptr to read loose files
+ *
+ * @return false if the file could not be opened
+ */
+static bool open_and_decode_gltf(std::string_view filepath, PluginManager &rPluginManager, DecodedGltf &rOut, PackageArchive const* pArchive)
+{
+    TinyGltfImporter importer{rPluginManager};
+
+    if (pArchive != nullptr)
+    {
+        importer.setFileCallback(archive_file_callback, *pArchive);
+    }
 
     importer.openFile(filepath);
 
     if (!importer.isOpened() || importer.defaultScene() == -1)
     {
-        // TODO: delete resource (not yet implemented)
         OSP_LOG_ERROR("Could not open file {}", filepath);
-        return lgrn::id_null<ResId>();
+        return false;
     }
 
-    load_gltf(importer, res, filepath, rResources, pkg);
+    decode_gltf(importer, rOut);
 
     importer.close();
 
-    return res;
+    return true;
+}
+
+ResId osp::load_tinygltf_file(std::string_view filepath, Resources &rResources, PkgId pkg, EBasisTarget basisTarget, MeshOptimizeFlags meshOptimize, PackageArchive const* pArchive)
+{
+    PluginManager pluginManager;
+    configure_basis_importer(pluginManager, basisTarget);
+    DecodedGltf decoded;
+
+    if ( ! open_and_decode_gltf(filepath, pluginManager, decoded, pArchive) )
+    {
+        return lgrn::id_null<ResId>();
+    }
+
+    optimize_meshes(Corrade::Containers::arrayView(decoded.m_meshes), meshOptimize);
+
+    return register_gltf(std::move(decoded), filepath, rResources, pkg);
+}
+
+std::vector<ResId> osp::load_tinygltf_files(
+        ArrayView<std::string_view const>   filepaths,
+        Resources                           &rResources,
+        PkgId                               pkg,
+        std::size_t                         threads,
+        EBasisTarget                        basisTarget,
+        MeshOptimizeFlags                   meshOptimize,
+        PackageArchive const*               pArchive)
+{
+    std::size_t const fileCount = filepaths.size();
+
+    std::vector<DecodedGltf>    decoded(fileCount);
+    std::unique_ptr<bool[]>     opened{new bool[fileCount]{}};
+    std::atomic<std::size_t>    nextFile{0};
+
+    // Workers take the next file not yet claimed, as file sizes vary a lot between part packs.
+    // TinyGltfImporter and the plugin manager aren't thread-safe, so each worker has its own
+    auto const decode_worker = [&, logger = t_logger] ()
+    {
+        set_thread_logger(logger);
+
+        PluginManager pluginManager;
+        configure_basis_importer(pluginManager, basisTarget);
+        for (std::size_t i = nextFile++; i < fileCount; i = nextFile++)
+        {
+            opened[i] = open_and_decode_gltf(filepaths[i], pluginManager, decoded[i], pArchive);
+            if (opened[i])
+            {
+                optimize_meshes(Corrade::Containers::arrayView(decoded[i].m_meshes), meshOptimize);
+            }
+        }
+    };
+
+    std::size_t const workerCount = std::clamp<std::size_t>(threads, 1, std::max<std::size_t>(fileCount, 1));
+
+    std::vector<std::thread> workers;
+    workers.reserve(workerCount - 1);
+    for (std::size_t i = 1; i < workerCount; ++i)
+    {
+        workers.emplace_back(decode_worker);
+    }
+
+    decode_worker();
+
+    for (std::thread &rWorker : workers)
+    {
+        rWorker.join();
+    }
+
+    // Register in file order, so resource IDs don't depend on which worker finished first
+    std::vector<ResId> out(fileCount, lgrn::id_null<ResId>());
+    for (std::size_t i = 0; i < fileCount; ++i)
+    {
+        if (opened[i])
+        {
+            out[i] = register_gltf(std::move(decoded[i]), filepaths[i], rResources, pkg);
+        }
+    }
+
+    return out;
 }
 
 static EShape shape_from_name(std::string_view name) noexcept
@@ -467,4 +695,6 @@ void osp::assigns_prefabs_tinygltf(Resources &rResources, ResId importer)
         prefabObjs.clear();
         prefabParents.clear();
     }
+
+    compile_prefab_templates(rPrefabs, *pImportData);
 }
@@ -24,15 +24,76 @@
  */
 #pragma once
 
+#include "mesh_optimize.h"
+
+#include "../core/array_view.h"
 #include "../core/resourcetypes.h"
 
+#include <cstdint>
+#include <optional>
 #include <string_view>
+#include <vector>
 
 namespace osp
 {
 
+class PackageArchive;
+
+/**
+ * @brief GPU format that Basis Universal images (.basis, or KTX2 with Basis supercompression)
+ *        are transcoded to while importing
+ *
+ * Transcoding happens once on import, so compressed blocks can be uploaded to the GPU as-is.
+ * Images in other formats, such as PNG, are imported uncompressed regardless.
+ */
+enum class EBasisTarget : std::uint8_t
+{
+    RGBA8,          ///< Uncompressed, works everywhere
+    Bc1RGB,
+    Bc3RGBA,
+    Bc7RGBA,
+    Etc2RGBA,
+    Astc4x4RGBA
+};
+
+/**
+ * @brief Target most GPUs of the graphics API being built for support, for when there's no
+ *        context to ask yet at load time
+ */
+[[nodiscard]] EBasisTarget default_basis_target() noexcept;
+
+/**
+ * @return Target named the same as BasisImporter's "format" option, such as "Bc7RGBA"
+ */
+[[nodiscard]] std::optional<EBasisTarget> basis_target_from_name(std::string_view name) noexcept;
+
 void register_tinygltf_resources(Resources &rResources);
-ResId load_tinygltf_file(std::string_view filepath, Resources &rResources, PkgId pkg);
+ResId load_tinygltf_file(std::string_view filepath, Resources &rResources, PkgId pkg,
+                         EBasisTarget basisTarget = EBasisTarget::RGBA8,
+                         MeshOptimizeFlags meshOptimize = gc_defaultMeshOptimize,
+                         PackageArchive const* pArchive = nullptr);
+
+/**
+ * @brief Load many glTF files, decoding them on multiple threads
+ *
+ * Files are opened and decoded on up to \c threads threads, each with its own importer. Only
+ * adding the results to Resources is done serially on the calling thread, in the same order as
+ * filepaths, so resource IDs are the same as calling load_tinygltf_file for each file. Meshes
+ * are optimized on the same threads, see optimize_meshes.
+ *
+ * If pArchive is given, filepaths and the buffers and images they refer to are read from that
+ * archive's mapping instead of from loose files.
+ *
+ * @return Importer resource of each file, or null for files that failed to open
+ */
+std::vector<ResId> load_tinygltf_files(
+        ArrayView<std::string_view const>   filepaths,
+        Resources                           &rResources,
+        PkgId                               pkg,
+        std::size_t                         threads,
+        EBasisTarget                        basisTarget = EBasisTarget::RGBA8,
+        MeshOptimizeFlags                   meshOptimize = gc_defaultMeshOptimize,
+        PackageArchive const*               pArchive = nullptr);
 
 /**
  * @brief Assign prefabs (potentially Parts) and add physical properties to an
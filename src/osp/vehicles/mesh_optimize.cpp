@@ -0,0 +1,240 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "mesh_optimize.h"
+
+#include "../util/logging.h"
+
+#include <Magnum/Math/Packing.h>
+#include <Magnum/Math/Vector3.h>
+#include <Magnum/MeshTools/RemoveDuplicates.h>
+#include <Magnum/Trade/AbstractSceneConverter.h>
+#include <Magnum/Trade/MeshData.h>
+#include <Magnum/VertexFormat.h>
+
+#include <Corrade/Containers/Optional.h>
+#include <Corrade/Containers/Pointer.h>
+#include <Corrade/Containers/StridedArrayView.h>
+#include <Corrade/PluginManager/Manager.h>
+#include <Corrade/Utility/Algorithms.h>
+
+#include <algorithm>
+#include <cstring>
+
+using Magnum::Trade::AbstractSceneConverter;
+using Magnum::Trade::MeshAttribute;
+using Magnum::Trade::MeshAttributeData;
+using Magnum::Trade::MeshData;
+using Magnum::Trade::MeshIndexData;
+using Magnum::MeshPrimitive;
+using Magnum::VertexFormat;
+using Magnum::UnsignedInt;
+using Magnum::Vector2;
+using Magnum::Vector3;
+using Magnum::Vector2us;
+using Magnum::Vector3s;
+
+using Corrade::Containers::Array;
+using Corrade::Containers::Optional;
+using Corrade::Containers::Pointer;
+using Corrade::Containers::StridedArrayView1D;
+
+using SceneConverterManager = Corrade::PluginManager::Manager<AbstractSceneConverter>;
+
+namespace
+{
+
+[[nodiscard]] bool has_only_float_attributes(MeshData const& mesh) noexcept
+{
+    bool hasPosition = false;
+    for (UnsignedInt i = 0; i < mesh.attributeCount(); ++i)
+    {
+        MeshAttribute const name    = mesh.attributeName(i);
+        VertexFormat const  format  = mesh.attributeFormat(i);
+
+        if (mesh.attributeCount(name) != 1 || mesh.attributeArraySize(i) != 0)
+        {
+            return false;
+        }
+
+        switch (name)
+        {
+        case MeshAttribute::Position:
+            hasPosition = true;
+            [[fallthrough]];
+        case MeshAttribute::Normal:
+            if (format != VertexFormat::Vector3) { return false; }
+            break;
+        case MeshAttribute::TextureCoordinates:
+            if (format != VertexFormat::Vector2) { return false; }
+            break;
+        default:
+            return false;
+        }
+    }
+    return hasPosition;
+}
+
+/**
+ * @brief Repack into one interleaved buffer with smaller normals and texture coordinates
+ *
+ * Positions are left as 32-bit floats, as 16-bit positions need a per-mesh dequantization scale
+ * that our shaders don't have.
+ */
+[[nodiscard]] Optional<MeshData> quantize(MeshData const& mesh)
+{
+    if ( ! mesh.isIndexed() || ! has_only_float_attributes(mesh) )
+    {
+        return {};
+    }
+
+    UnsignedInt const   vertexCount = mesh.vertexCount();
+    bool const          hasNormals  = mesh.hasAttribute(MeshAttribute::Normal);
+    bool const          hasUvs      = mesh.hasAttribute(MeshAttribute::TextureCoordinates);
+
+    Array<Vector3> const positions  = mesh.positions3DAsArray();
+    Array<Vector3> const normals    = hasNormals ? mesh.normalsAsArray()               : Array<Vector3>{};
+    Array<Vector2> const uvs        = hasUvs     ? mesh.textureCoordinates2DAsArray()  : Array<Vector2>{};
+
+    // Tiling texture coordinates outside of [0, 1] can't be normalized, keep them as floats
+    bool const uvsFit = std::all_of(uvs.begin(), uvs.end(), [] (Vector2 const uv)
+    {
+        return uv.x() >= 0.0f && uv.x() <= 1.0f && uv.y() >= 0.0f && uv.y() <= 1.0f;
+    });
+
+    std::size_t const normalOffset  = sizeof(Vector3);
+    std::size_t const uvOffset      = normalOffset + (hasNormals ? sizeof(Vector3s) + 2 : 0); // padded to 4
+    std::size_t const stride        = uvOffset + (hasUvs ? (uvsFit ? sizeof(Vector2us) : sizeof(Vector2)) : 0);
+
+    Array<char> vertexData{Corrade::ValueInit, vertexCount * stride};
+    Array<MeshAttributeData> attribs{Corrade::ValueInit, 1 + std::size_t(hasNormals) + std::size_t(hasUvs)};
+    std::size_t attribOut = 0;
+
+    StridedArrayView1D<Vector3> const positionsOut{vertexData,
+            reinterpret_cast<Vector3*>(vertexData.data()), vertexCount, std::ptrdiff_t(stride)};
+    Corrade::Utility::copy(Corrade::Containers::stridedArrayView(positions), positionsOut);
+    attribs[attribOut++] = MeshAttributeData{MeshAttribute::Position, positionsOut};
+
+    if (hasNormals)
+    {
+        StridedArrayView1D<Vector3s> const normalsOut{vertexData,
+                reinterpret_cast<Vector3s*>(vertexData.data() + normalOffset), vertexCount, std::ptrdiff_t(stride)};
+        for (UnsignedInt i = 0; i < vertexCount; ++i)
+        {
+            normalsOut[i] = Magnum::Math::pack<Vector3s>(normals[i]);
+        }
+        attribs[attribOut++] = MeshAttributeData{MeshAttribute::Normal, VertexFormat::Vector3sNormalized, normalsOut};
+    }
+
+    if (hasUvs && uvsFit)
+    {
+        StridedArrayView1D<Vector2us> const uvsOut{vertexData,
+                reinterpret_cast<Vector2us*>(vertexData.data() + uvOffset), vertexCount, std::ptrdiff_t(stride)};
+        for (UnsignedInt i = 0; i < vertexCount; ++i)
+        {
+            uvsOut[i] = Magnum::Math::pack<Vector2us>(uvs[i]);
+        }
+        attribs[attribOut++] = MeshAttributeData{MeshAttribute::TextureCoordinates, VertexFormat::Vector2usNormalized, uvsOut};
+    }
+    else if (hasUvs)
+    {
+        StridedArrayView1D<Vector2> const uvsOut{vertexData,
+                reinterpret_cast<Vector2*>(vertexData.data() + uvOffset), vertexCount, std::ptrdiff_t(stride)};
+        Corrade::Utility::copy(Corrade::Containers::stridedArrayView(uvs), uvsOut);
+        attribs[attribOut++] = MeshAttributeData{MeshAttribute::TextureCoordinates, uvsOut};
+    }
+
+    std::size_t const indexBytes = mesh.indexCount() * Magnum::meshIndexTypeSize(mesh.indexType());
+    Array<char> indexData{Corrade::NoInit, indexBytes};
+    std::memcpy(indexData.data(), mesh.indexData().data() + mesh.indexOffset(), indexBytes);
+    MeshIndexData const indices{mesh.indexType(), Corrade::Containers::arrayView(indexData)};
+
+    return MeshData{mesh.primitive(), std::move(indexData), indices,
+                    std::move(vertexData), std::move(attribs), vertexCount};
+}
+
+} // namespace
+
+void osp::optimize_meshes(ArrayView< Optional<MeshData> > const meshes, MeshOptimizeFlags const flags)
+{
+    SceneConverterManager   converterManager;
+    Pointer<AbstractSceneConverter> pMeshOpt;
+
+    if (flags & MeshOptimizeFlag::Reorder)
+    {
+        pMeshOpt = converterManager.loadAndInstantiate("MeshOptimizerSceneConverter");
+        if ( ! pMeshOpt )
+        {
+            OSP_LOG_WARN("MeshOptimizerSceneConverter not available, meshes won't be reordered");
+        }
+    }
+
+    for (Optional<MeshData> &rMesh : meshes)
+    {
+        if ( ! rMesh || rMesh->primitive() != MeshPrimitive::Triangles || rMesh->vertexCount() == 0 )
+        {
+            continue;
+        }
+
+        if (flags & MeshOptimizeFlag::Deduplicate)
+        {
+            bool const canDedup = [&mesh = *rMesh] ()
+            {
+                for (UnsignedInt i = 0; i < mesh.attributeCount(); ++i)
+                {
+                    if (Magnum::isVertexFormatImplementationSpecific(mesh.attributeFormat(i)))
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            }();
+
+            if (canDedup)
+            {
+                rMesh = Magnum::MeshTools::removeDuplicates(*rMesh);
+            }
+        }
+
+        // Reordering is done in-place, so both buffers need to be owned
+        if (pMeshOpt && rMesh->isIndexed()
+            && (rMesh->indexDataFlags()  & Magnum::Trade::DataFlag::Mutable)
+            && (rMesh->vertexDataFlags() & Magnum::Trade::DataFlag::Mutable))
+        {
+            if ( ! pMeshOpt->convertInPlace(*rMesh) )
+            {
+                OSP_LOG_WARN("Failed to reorder a mesh with {} vertices", rMesh->vertexCount());
+            }
+        }
+
+        if (flags & MeshOptimizeFlag::Quantize)
+        {
+            if (Optional<MeshData> quantized = quantize(*rMesh);
+                bool(quantized))
+            {
+                rMesh = std::move(quantized);
+            }
+        }
+    }
+}
@@ -0,0 +1,75 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "../core/array_view.h"
+
+#include <Magnum/Trade/Trade.h>
+
+#include <Corrade/Containers/EnumSet.h>
+#include <Corrade/Containers/Containers.h>
+
+#include <cstdint>
+
+namespace osp
+{
+
+/**
+ * @brief Processing done to each mesh as it's imported
+ *
+ * Results are stored in the baked asset cache along with the rest of the import, so include
+ * these in the options passed to asset_source_hash.
+ */
+enum class MeshOptimizeFlag : std::uint8_t
+{
+    /// Merge vertices with identical attributes, making the mesh indexed
+    Deduplicate = 1 << 0,
+
+    /// Reorder triangles for the post-transform vertex cache and to reduce overdraw, then
+    /// vertices for fetch locality. Needs MeshOptimizerSceneConverter, skipped if unavailable
+    Reorder     = 1 << 1,
+
+    /// Store normals as 16-bit normalized, and texture coordinates in [0, 1] as 16-bit unsigned
+    /// normalized. Only applies to meshes with nothing but positions, normals and texture coords
+    Quantize    = 1 << 2
+};
+
+using MeshOptimizeFlags = Corrade::Containers::EnumSet<MeshOptimizeFlag>;
+CORRADE_ENUMSET_OPERATORS(MeshOptimizeFlags)
+
+inline constexpr MeshOptimizeFlags gc_defaultMeshOptimize = MeshOptimizeFlag::Deduplicate | MeshOptimizeFlag::Reorder;
+
+/**
+ * @brief Optimize freshly imported meshes in-place
+ *
+ * Meshes that aren't triangles, or that fail a step, are left as they were for that step.
+ * Safe to call from multiple threads at once, each call loads its own converter plugin.
+ *
+ * @param meshes    [ref] Meshes to optimize, empty Optionals are skipped
+ * @param flags     [in] Steps to apply
+ */
+void optimize_meshes(ArrayView< Corrade::Containers::Optional<Magnum::Trade::MeshData> > meshes, MeshOptimizeFlags flags);
+
+} // namespace osp
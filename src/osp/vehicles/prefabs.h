@@ -41,6 +41,8 @@ inline ResTypeId const gc_importer      = ResTypeIdReg_t::create();
 using ObjId     = int32_t;
 using PrefabId  = uint32_t;
 
+struct PrefabTemplate;
+
 struct PrefabPair
 {
     ResIdOwner_t m_importer;
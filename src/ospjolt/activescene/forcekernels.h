@@ -0,0 +1,136 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "joltinteg.h"
+
+#include <cstdint>
+#include <utility>
+
+/**
+ * @file
+ * @brief Force factors written as kernels, which can be fused into a single loop
+ *
+ * A kernel is a type with a function evaluating one body of a ForceFactorBatch:
+ *
+ * @code{.cpp}
+ * static void apply(ForceFactorBatch const& batch, std::uint32_t index,
+ *                   ACtxJoltWorld const& rCtx, ACtxJoltWorld::ForceFactorFunc::UserData_t const& data) noexcept;
+ * @endcode
+ *
+ * Register each kernel by itself with make_kernel_factor. Common combinations can then be added
+ * with add_fused_factor, so bodies using all of them are evaluated by one loop with the kernels
+ * inlined, instead of once per factor through a function pointer. Factors that aren't kernels,
+ * such as ones added by mods, are still evaluated on their own.
+ */
+
+namespace ospjolt
+{
+
+/**
+ * @brief ForceFactorFunc::BatchFunc_t evaluating a single kernel
+ */
+template <typename KERNEL_T>
+void kernel_batch(ForceFactorBatch const& batch, ACtxJoltWorld const& rCtx, ACtxJoltWorld::ForceFactorFunc::UserData_t data) noexcept
+{
+    for (std::uint32_t const index : batch.m_indices)
+    {
+        KERNEL_T::apply(batch, index, rCtx, data);
+    }
+}
+
+/**
+ * @brief FusedForceFactor::Func_t evaluating all kernels per body, in one pass
+ */
+template <typename ... KERNEL_T>
+void fused_kernel_batch(ForceFactorBatch const& batch, ACtxJoltWorld const& rCtx,
+                        osp::ArrayView<ACtxJoltWorld::ForceFactorFunc::UserData_t const> data) noexcept
+{
+    [&batch, &rCtx, data] <std::size_t ... I> (std::index_sequence<I...>)
+    {
+        for (std::uint32_t const index : batch.m_indices)
+        {
+            (KERNEL_T::apply(batch, index, rCtx, data[I]), ...);
+        }
+    }(std::index_sequence_for<KERNEL_T...>{});
+}
+
+template <typename KERNEL_T>
+[[nodiscard]] ACtxJoltWorld::ForceFactorFunc make_kernel_factor(ACtxJoltWorld::ForceFactorFunc::UserData_t data) noexcept
+{
+    return { .m_batchFunc = &kernel_batch<KERNEL_T>, .m_userData = data };
+}
+
+/**
+ * @brief Fuse kernels already registered through make_kernel_factor
+ *
+ * The first factor in m_factors registered for each kernel is used.
+ *
+ * @return False if a kernel isn't registered, leaving m_fusedFactors unchanged
+ */
+template <typename ... KERNEL_T>
+bool add_fused_factor(ACtxJoltWorld& rCtx)
+{
+    ACtxJoltWorld::FusedForceFactor fused{ .m_func = &fused_kernel_batch<KERNEL_T...> };
+    bool foundAll = true;
+
+    auto const find = [&rCtx, &fused, &foundAll] (ACtxJoltWorld::ForceFactorFunc::BatchFunc_t const func)
+    {
+        for (std::size_t i = 0; i < rCtx.m_factors.size(); ++i)
+        {
+            if (rCtx.m_factors[i].m_batchFunc == func)
+            {
+                fused.m_mask[i / 64] |= std::uint64_t(1) << (i % 64);
+                fused.m_userData.push_back(rCtx.m_factors[i].m_userData);
+                return;
+            }
+        }
+        foundAll = false;
+    };
+    (find(&kernel_batch<KERNEL_T>), ...);
+
+    if (foundAll)
+    {
+        rCtx.m_fusedFactors.push_back(std::move(fused));
+    }
+    return foundAll;
+}
+
+/**
+ * @brief Constant acceleration, such as uniform gravity
+ *
+ * User data: [0] osp::Vector3 const* acceleration
+ */
+struct ForceAccelKernel
+{
+    static void apply(ForceFactorBatch const& batch, std::uint32_t const index,
+                      ACtxJoltWorld const& rCtx, ACtxJoltWorld::ForceFactorFunc::UserData_t const& data) noexcept
+    {
+        auto const& accel = *static_cast<osp::Vector3 const*>(data[0]);
+        batch.m_forces[index] += accel * batch.m_masses[index];
+    }
+};
+
+} // namespace ospjolt
@@ -27,7 +27,13 @@
 #include "forcefactors.h"
 
 #include <osp/activescene/basic.h>
+#include <osp/activescene/physics.h>
+#include <osp/core/array_view.h>
 #include <osp/core/id_map.h>
+#include <osp/core/large_alloc.h>
+#include <osp/core/memory_usage.h>
+#include <osp/core/resourcetypes.h>
+#include <osp/scientific/shapes.h>
 
 
 #include <Jolt/Jolt.h>
@@ -42,6 +48,8 @@ JPH_SUPPRESS_WARNINGS
 #include <Jolt/Physics/Collision/Shape/BoxShape.h>
 #include <Jolt/Physics/Collision/Shape/SphereShape.h>
 #include <Jolt/Physics/Collision/Shape/CylinderShape.h>
+#include <Jolt/Physics/Collision/Shape/CapsuleShape.h>
+#include <Jolt/Physics/Collision/Shape/ConvexHullShape.h>
 #include <Jolt/Physics/Collision/Shape/RotatedTranslatedShape.h>
 #include <Jolt/Physics/Body/BodyCreationSettings.h>
 #include <Jolt/Core/TempAllocator.h>
@@ -49,6 +57,11 @@ JPH_SUPPRESS_WARNINGS
 #include <Jolt/Physics/Collision/Shape/ScaledShape.h>
 #include <Jolt/Physics/Collision/Shape/MutableCompoundShape.h>
 #include <Jolt/Physics/PhysicsStepListener.h>
+#include <Jolt/Physics/Body/BodyActivationListener.h>
+#include <Jolt/Physics/Body/BodyFilter.h>
+#include <Jolt/Physics/Collision/CastResult.h>
+#include <Jolt/Physics/Collision/ContactListener.h>
+#include <Jolt/Physics/Collision/RayCast.h>
 
 JPH_SUPPRESS_WARNING_POP
 
@@ -60,7 +73,13 @@ JPH_SUPPRESS_WARNING_POP
 #include <spdlog/spdlog.h>
 
 #include <iostream>
+#include <array>
+#include <bit>
 #include <cstdarg>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <osp/util/logging.h>
 
 #include "osp/core/strong_id.h"
@@ -128,41 +147,106 @@ static void TraceImpl(const char *inFMT, ...)
 
 /**
  * @brief The different physics layers for the simulation
+ *
+ * Which layers collide with each other is set per world, see JoltCollisionMatrix.
  */
 namespace Layers
 {
-    static constexpr ObjectLayer NON_MOVING = 0;
-    static constexpr ObjectLayer MOVING = 1;
-    static constexpr ObjectLayer NUM_LAYERS = 2;
+    static constexpr ObjectLayer NON_MOVING = 0; ///< Static bodies that aren't terrain
+    static constexpr ObjectLayer MOVING     = 1; ///< General dynamic bodies, such as dropped shapes
+    static constexpr ObjectLayer VEHICLE    = 2; ///< Vehicles welded into rigid bodies
+    static constexpr ObjectLayer DEBRIS     = 3; ///< Dynamic bodies that only hit static world
+    static constexpr ObjectLayer TERRAIN    = 4; ///< Streamed static terrain chunks
+    static constexpr ObjectLayer SENSOR     = 5; ///< Sensors only detect other bodies
+    static constexpr ObjectLayer NUM_LAYERS = 6;
 };
+
+/**
+ * @brief Which object layers collide with each other
+ *
+ * Stored as one bitmask of other layers per layer, and always kept symmetric.
+ */
+class JoltCollisionMatrix
+{
+public:
+    /**
+     * @brief Matrix used unless a scenario asks for something else
+     *
+     * Static bodies and terrain don't collide with each other, debris only collides with static
+     * bodies and terrain, and sensors only detect general bodies and vehicles.
+     */
+    [[nodiscard]] static JoltCollisionMatrix make_default() noexcept
+    {
+        using namespace Layers;
+        JoltCollisionMatrix out;
+        for (ObjectLayer const layer : {MOVING, VEHICLE})
+        {
+            out.set(layer, NON_MOVING,  true);
+            out.set(layer, MOVING,      true);
+            out.set(layer, VEHICLE,     true);
+            out.set(layer, TERRAIN,     true);
+            out.set(layer, SENSOR,      true);
+        }
+        out.set(DEBRIS, NON_MOVING, true);
+        out.set(DEBRIS, TERRAIN,    true);
+        return out;
+    }
+
+    void set(ObjectLayer const a, ObjectLayer const b, bool const collide) noexcept
+    {
+        JPH_ASSERT(a < Layers::NUM_LAYERS && b < Layers::NUM_LAYERS);
+        if (collide)
+        {
+            m_masks[a] |= (1u << b);
+            m_masks[b] |= (1u << a);
+        }
+        else
+        {
+            m_masks[a] &= ~(1u << b);
+            m_masks[b] &= ~(1u << a);
+        }
+    }
+
+    [[nodiscard]] bool collides(ObjectLayer const a, ObjectLayer const b) const noexcept
+    {
+        JPH_ASSERT(a < Layers::NUM_LAYERS && b < Layers::NUM_LAYERS);
+        return (m_masks[a] & (1u << b)) != 0;
+    }
+
+private:
+    std::array<std::uint32_t, Layers::NUM_LAYERS> m_masks{};
+};
+
 /**
  * @brief Class that determines if two object layers can collide
  */
 class ObjectLayerPairFilterImpl : public ObjectLayerPairFilter
 {
 public:
+    explicit ObjectLayerPairFilterImpl(JoltCollisionMatrix const& matrix) : m_matrix{matrix} {};
+
     bool ShouldCollide(ObjectLayer inObject1, ObjectLayer inObject2) const override
     {
-        switch (inObject1)
-        {
-        case Layers::NON_MOVING:
-            return inObject2 == Layers::MOVING; // Non moving only collides with moving
-        case Layers::MOVING:
-            return true; // Moving collides with everything
-        default:
-            JPH_ASSERT(false);
-            return false;
-        }
+        return m_matrix.collides(inObject1, inObject2);
     }
+
+private:
+    JoltCollisionMatrix m_matrix;
 };
 /**
- * @brief The different broad phase layers (currently identical to physics Layers, but might change in the future)
+ * @brief The different broad phase layers. Each one is a separate tree.
+ *
+ * Terrain has its own tree so streaming chunks in and out doesn't disturb the trees that dynamic
+ * bodies are queried against every step.
  */
 namespace BroadPhaseLayers
 {
     static constexpr BroadPhaseLayer NON_MOVING(0);
     static constexpr BroadPhaseLayer MOVING(1);
-    static constexpr uint NUM_LAYERS(2);
+    static constexpr BroadPhaseLayer DEBRIS(2);
+    static constexpr BroadPhaseLayer TERRAIN(3);
+    static constexpr BroadPhaseLayer SENSOR(4);
+    static constexpr uint NUM_LAYERS(5);
 };
 
 /**
@@ -175,7 +259,11 @@ public:
     {
         // Create a mapping table from object to broad phase layer
         mObjectToBroadPhase[Layers::NON_MOVING] = BroadPhaseLayers::NON_MOVING;
-        mObjectToBroadPhase[Layers::MOVING] = BroadPhaseLayers::MOVING;
+        mObjectToBroadPhase[Layers::MOVING]     = BroadPhaseLayers::MOVING;
+        mObjectToBroadPhase[Layers::VEHICLE]    = BroadPhaseLayers::MOVING;
+        mObjectToBroadPhase[Layers::DEBRIS]     = BroadPhaseLayers::DEBRIS;
+        mObjectToBroadPhase[Layers::TERRAIN]    = BroadPhaseLayers::TERRAIN;
+        mObjectToBroadPhase[Layers::SENSOR]     = BroadPhaseLayers::SENSOR;
     }
 
     uint GetNumBroadPhaseLayers() const override
@@ -193,11 +281,14 @@ public:
     /// Get the user readable name of a broadphase layer (debugging purposes)
     const char * GetBroadPhaseLayerName(BroadPhaseLayer inLayer) const override
     {
-        if (inLayer == BroadPhaseLayers::NON_MOVING) {
-            return "NON_MOVING";
-        }
-        else {
-            return "MOVING";
+        switch (static_cast<BroadPhaseLayer::Type>(inLayer))
+        {
+        case static_cast<BroadPhaseLayer::Type>(BroadPhaseLayers::NON_MOVING):  return "NON_MOVING";
+        case static_cast<BroadPhaseLayer::Type>(BroadPhaseLayers::MOVING):      return "MOVING";
+        case static_cast<BroadPhaseLayer::Type>(BroadPhaseLayers::DEBRIS):      return "DEBRIS";
+        case static_cast<BroadPhaseLayer::Type>(BroadPhaseLayers::TERRAIN):     return "TERRAIN";
+        case static_cast<BroadPhaseLayer::Type>(BroadPhaseLayers::SENSOR):      return "SENSOR";
+        default:                                                                return "INVALID";
         }
     }
 #endif // JPH_EXTERNAL_PROFILE || JPH_PROFILE_ENABLED
@@ -207,23 +298,36 @@ private:
 };
 /**
  * @brief Class that determines if an object layer can collide with a broadphase layer
+ *
+ * An object layer collides with a broadphase layer if it collides with any object layer mapped
+ * to it. This is precalculated into a bitmask per object layer.
  */
 class ObjectVsBroadPhaseLayerFilterImpl : public ObjectVsBroadPhaseLayerFilter
 {
 public:
-    bool ShouldCollide(ObjectLayer inLayer1, BroadPhaseLayer inLayer2) const override
+    ObjectVsBroadPhaseLayerFilterImpl(JoltCollisionMatrix const& matrix, BPLayerInterfaceImpl const& bpLayers)
     {
-        switch (inLayer1)
+        for (ObjectLayer a = 0; a < Layers::NUM_LAYERS; ++a)
         {
-        case Layers::NON_MOVING:
-            return inLayer2 == BroadPhaseLayers::MOVING;
-        case Layers::MOVING:
-            return true;
-        default:
-            JPH_ASSERT(false);
-            return false;
+            for (ObjectLayer b = 0; b < Layers::NUM_LAYERS; ++b)
+            {
+                if (matrix.collides(a, b))
+                {
+                    auto const bp = static_cast<BroadPhaseLayer::Type>(bpLayers.GetBroadPhaseLayer(b));
+                    m_bpMasks[a] |= (1u << bp);
+                }
+            }
         }
     }
+
+    bool ShouldCollide(ObjectLayer inLayer1, BroadPhaseLayer inLayer2) const override
+    {
+        JPH_ASSERT(inLayer1 < Layers::NUM_LAYERS);
+        return (m_bpMasks[inLayer1] & (1u << static_cast<BroadPhaseLayer::Type>(inLayer2))) != 0;
+    }
+
+private:
+    std::array<std::uint32_t, Layers::NUM_LAYERS> m_bpMasks{};
 };
 
 struct ACtxJoltWorld;
@@ -235,12 +339,192 @@ public:
     PhysicsStepListenerImpl(ACtxJoltWorld* pContext) : m_context(pContext) {};
     void OnStep(float inDeltaTime, PhysicsSystem& rPhysicsSystem) override;
 
+    /// Fewest bodies worth handing to a separate job
+    static constexpr std::size_t smc_minBodiesPerRange = 64;
+
+private:
+    /**
+     * @brief Evaluate force factors and apply forces for one disjoint range of bodies
+     *
+     * Ranges may run in parallel, each only writes to its own bodies and its own elements of
+     * ACtxJoltWorld::m_forceBatch.
+     */
+    void accumulate_range(PhysicsSystem& rPhysicsSystem, std::size_t range, std::size_t rangeCount) noexcept;
+
+    ACtxJoltWorld* m_context;
+};
+
+/**
+ * @brief Records bodies waking up and falling asleep, applied to ACtxJoltWorld::m_awakeBodies
+ *        by SysJolt::update_world
+ *
+ * Jolt calls these from any thread while bodies are locked, so events are only queued here.
+ */
+class BodyActivationListenerImpl : public BodyActivationListener
+{
+public:
+    BodyActivationListenerImpl(ACtxJoltWorld* pContext) : m_context(pContext) {};
+    void OnBodyActivated(BodyID const& inBodyID, uint64 inBodyUserData) override;
+    void OnBodyDeactivated(BodyID const& inBodyID, uint64 inBodyUserData) override;
+
+private:
+    ACtxJoltWorld* m_context;
+};
+
+/**
+ * @brief Reports new contacts to ACtxJoltWorld::m_pContacts
+ *
+ * Jolt calls this from its job threads during PhysicsSystem::Update.
+ */
+class ContactListenerImpl : public ContactListener
+{
+public:
+    ContactListenerImpl(ACtxJoltWorld* pContext) : m_context(pContext) {};
+    void OnContactAdded(Body const& inBody1, Body const& inBody2, ContactManifold const& inManifold, ContactSettings& ioSettings) override;
+
 private:
     ACtxJoltWorld* m_context;
 };
 
 using ShapeStorage_t = osp::Storage_t<osp::active::ActiveEnt, Ref<Shape>>;
 
+/**
+ * @brief Identifies a shared shape in ACtxJoltWorld::m_shapeCache
+ *
+ * Scale is compared exactly, so only identically sized parts share a shape. m_mesh is only used
+ * by convex hulls (EShape::Custom).
+ */
+struct ShapeCacheKey
+{
+    osp::EShape             m_shape;
+    std::array<float, 3>    m_scale;
+    osp::ResId              m_mesh{lgrn::id_null<osp::ResId>()};
+
+    bool operator==(ShapeCacheKey const& rhs) const noexcept = default;
+};
+
+struct ShapeCacheKeyHash
+{
+    std::size_t operator()(ShapeCacheKey const& key) const noexcept
+    {
+        // FNV-1a over the bits of each field
+        std::uint64_t hash = 14695981039346656037ull;
+        auto const combine = [&hash] (std::uint32_t const value)
+        {
+            hash = (hash ^ value) * 1099511628211ull;
+        };
+        combine(static_cast<std::uint32_t>(key.m_shape));
+        for (float const component : key.m_scale)
+        {
+            combine(std::bit_cast<std::uint32_t>(component));
+        }
+        combine(static_cast<std::uint32_t>(key.m_mesh));
+        return static_cast<std::size_t>(hash);
+    }
+};
+
+using ShapeCache_t = std::unordered_map<ShapeCacheKey, Ref<Shape>, ShapeCacheKeyHash>;
+
+/**
+ * @brief A body made of a MutableCompoundShape, tracked so it can be updated in place
+ *
+ * See SysJolt::update_compound
+ */
+struct CompoundBody
+{
+    Ref<MutableCompoundShape>               m_shape;
+
+    /// Entity of each sub-shape, in the same order as sub-shapes of m_shape
+    std::vector<osp::active::ActiveEnt>     m_subShapeEnts;
+
+    /// Transform of each sub-shape relative to the body's entity, parallel with m_subShapeEnts
+    std::vector<osp::Matrix4>               m_subShapeTransforms;
+};
+
+/**
+ * @brief Dynamic bodies passed to ForceFactorFunc::m_batchFunc, in SoA form
+ *
+ * All arrays except m_indices have one element per dynamic body in the world. A factor only
+ * evaluates bodies listed in m_indices, and adds to their m_forces and m_torques.
+ */
+struct ForceFactorBatch
+{
+    /// Indices into the arrays below of bodies that use this factor, ascending
+    osp::ArrayView<std::uint32_t const>     m_indices;
+
+    osp::ArrayView<BodyId const>            m_bodies;
+
+    /// Center of mass positions
+    osp::ArrayView<osp::Vector3 const>      m_positions;
+    osp::ArrayView<osp::Vector3 const>      m_velocities;
+    osp::ArrayView<float const>             m_masses;
+
+    osp::ArrayView<osp::Vector3>            m_forces;
+    osp::ArrayView<osp::Vector3>            m_torques;
+};
+
+/**
+ * @brief Jolt TempAllocator with its buffer from osp::large_alloc
+ *
+ * Same as Jolt's TempAllocatorImpl: allocations are bumped from one fixed buffer and freed in
+ * reverse order. The buffer follows the smc_subsystem policy, see osp::large_alloc_policy_set.
+ * Allocations that don't fit fall back to Jolt's heap instead of crashing.
+ */
+class TempAllocatorLarge final : public TempAllocator
+{
+public:
+    static constexpr std::string_view smc_subsystem = "jolt_temp";
+
+    explicit TempAllocatorLarge(uint size);
+    TempAllocatorLarge(TempAllocatorLarge const& copy) = delete;
+    TempAllocatorLarge& operator=(TempAllocatorLarge const& copy) = delete;
+    ~TempAllocatorLarge() override;
+
+    void* Allocate(uint inSize) override;
+    void Free(void* inAddress, uint inSize) override;
+
+private:
+    std::uint8_t    *m_pBase    {nullptr};
+    uint            m_size      {0};
+    uint            m_top       {0};
+};
+
+/**
+ * @brief Sizes and shared resources used to construct an ACtxJoltWorld
+ *
+ * The default sizes are the ones suggested in the Jolt hello world example for a "real" project.
+ */
+struct JoltWorldConfig
+{
+    /// Optional; job system shared with other worlds, see SysJolt::shared_job_system.
+    /// If null, the world creates its own JobSystemThreadPool with m_threadCount threads.
+    std::shared_ptr<JobSystem>  m_pJobSystem;
+
+    /// Worker threads for a world-owned job system. -1 for one less than the hardware threads.
+    int                         m_threadCount               {-1};
+
+    uint                        m_tempAllocatorSize         {10 * 1024 * 1024};
+    uint                        m_maxBodies                 {65536};
+    uint                        m_numBodyMutexes            {0};
+    uint                        m_maxBodyPairs              {65536};
+    uint                        m_maxContactConstraints     {10240};
+
+    JoltCollisionMatrix         m_collisions{JoltCollisionMatrix::make_default()};
+
+    /// Fixed physics steps per second. 0 steps once per update with the frame's delta time.
+    float                       m_fixedRate                 {0.0f};
+
+    /// Most fixed steps taken in one SysJolt::update_world; time beyond this is dropped so a
+    /// slow frame can't snowball into even more steps.
+    int                         m_maxSubsteps               {4};
+
+    /// Collision steps per fixed step, passed to PhysicsSystem::Update
+    int                         m_collisionSteps            {1};
+
+    /// Write transforms blended between the last two fixed steps, instead of the latest one
+    bool                        m_interpolate               {true};
+};
+
 /**
  * @brief Represents an instance of a Jolt physics world in the scene
  */
@@ -251,25 +535,67 @@ public:
     {
         using UserData_t = std::array<void*, 6u>;
         using Func_t = void (*)(BodyId bodyId, ACtxJoltWorld const&, UserData_t, osp::Vector3&, osp::Vector3&) noexcept;
+        using BatchFunc_t = void (*)(ForceFactorBatch const&, ACtxJoltWorld const&, UserData_t) noexcept;
 
+        /// Evaluates a single body, only used if m_batchFunc is null
         Func_t      m_func{nullptr};
+
+        /// Optional; evaluates all bodies that use this factor in one call.
+        /// Called concurrently for disjoint ranges of bodies, see PhysicsStepListenerImpl
+        BatchFunc_t m_batchFunc{nullptr};
         UserData_t  m_userData{nullptr};
     };
-    // The default values are the one suggested in the Jolt hello world exemple for a "real" project.
-    // It might be overkill here.
-    ACtxJoltWorld(  int threadCount = 2,
-                    uint maxBodies = 65536, 
-                    uint numBodyMutexes = 0, 
-                    uint maxBodyPairs = 65536, 
-                    uint maxContactConstraints = 10240
-                ) : m_pPhysicsSystem(std::make_unique<PhysicsSystem>()), 
-                    m_temp_allocator(10 * 1024 * 1024),
-                    m_joltJobSystem(std::make_unique<JobSystemThreadPool>(cMaxPhysicsJobs, cMaxPhysicsBarriers, threadCount))
+
+    /**
+     * @brief Several factors of m_factors evaluated together in one loop, for bodies that use
+     *        all of them. See add_fused_factor in forcekernels.h
+     */
+    struct FusedForceFactor
     {
-        m_pPhysicsSystem->Init(maxBodies, 
-                    numBodyMutexes, 
-                    maxBodyPairs, 
-                    maxContactConstraints, 
+        using Func_t = void (*)(ForceFactorBatch const&, ACtxJoltWorld const&, osp::ArrayView<ForceFactorFunc::UserData_t const>) noexcept;
+
+        /// Factors in m_factors this evaluates in their place
+        ForceFactors_t                              m_mask{};
+        Func_t                                      m_func{nullptr};
+
+        /// User data of each fused factor, in the order m_func expects
+        std::vector<ForceFactorFunc::UserData_t>    m_userData;
+    };
+
+    /**
+     * @brief Buffers reused by PhysicsStepListenerImpl::OnStep to build ForceFactorBatch
+     */
+    struct ForceBatchBuffers
+    {
+        std::vector<BodyId>                     m_bodies;
+        std::vector<osp::Vector3>               m_positions;
+        std::vector<osp::Vector3>               m_velocities;
+        std::vector<float>                      m_masses;
+        std::vector<osp::Vector3>               m_forces;
+        std::vector<osp::Vector3>               m_torques;
+
+        /// Indices into the arrays above for each body range, and each factor in m_factors then
+        /// each in m_fusedFactors, as [range * (m_factors.size() + m_fusedFactors.size()) + factor]
+        std::vector< std::vector<std::uint32_t> > m_factorIndices;
+    };
+
+    explicit ACtxJoltWorld(JoltWorldConfig const& config = {})
+                  : m_temp_allocator(config.m_tempAllocatorSize),
+                    m_objectLayerFilter(config.m_collisions),
+                    m_objectVsBPLFilter(config.m_collisions, m_bPLInterface),
+                    m_joltJobSystem( (config.m_pJobSystem != nullptr)
+                                     ? config.m_pJobSystem
+                                     : std::make_shared<JobSystemThreadPool>(cMaxPhysicsJobs, cMaxPhysicsBarriers, config.m_threadCount)),
+                    m_pPhysicsSystem(std::make_unique<PhysicsSystem>()),
+                    m_fixedStep( (config.m_fixedRate > 0.0f) ? 1.0f / config.m_fixedRate : 0.0f ),
+                    m_maxSubsteps(config.m_maxSubsteps),
+                    m_collisionSteps(config.m_collisionSteps),
+                    m_interpolate(config.m_interpolate)
+    {
+        m_pPhysicsSystem->Init(config.m_maxBodies, 
+                    config.m_numBodyMutexes, 
+                    config.m_maxBodyPairs, 
+                    config.m_maxContactConstraints, 
                     m_bPLInterface, 	
                     m_objectVsBPLFilter, 
                     m_objectLayerFilter);
@@ -277,6 +603,10 @@ public:
         m_pPhysicsSystem->SetGravity(Vec3Arg::sZero());
         m_listener = std::make_unique<PhysicsStepListenerImpl>(this);
         m_pPhysicsSystem->AddStepListener(m_listener.get());
+        m_activationListener = std::make_unique<BodyActivationListenerImpl>(this);
+        m_pPhysicsSystem->SetBodyActivationListener(m_activationListener.get());
+        m_contactListener = std::make_unique<ContactListenerImpl>(this);
+        m_pPhysicsSystem->SetContactListener(m_contactListener.get());
     }
 
     //mandatory jolt initialization steps
@@ -288,28 +618,82 @@ public:
 
     
 
-    TempAllocatorImpl                                   m_temp_allocator;
+    TempAllocatorLarge                                  m_temp_allocator;
     ObjectLayerPairFilterImpl                           m_objectLayerFilter;
     BPLayerInterfaceImpl                                m_bPLInterface;
     ObjectVsBroadPhaseLayerFilterImpl                   m_objectVsBPLFilter;
-    std::unique_ptr<JobSystem>                          m_joltJobSystem;
+    /// May be shared with other worlds, see JoltWorldConfig::m_pJobSystem
+    std::shared_ptr<JobSystem>                          m_joltJobSystem;
 
     std::unique_ptr<PhysicsSystem>                      m_pPhysicsSystem;
 
     std::unique_ptr<PhysicsStepListenerImpl>		    m_listener;
+    std::unique_ptr<BodyActivationListenerImpl>         m_activationListener;
+    std::unique_ptr<ContactListenerImpl>                m_contactListener;
 
     lgrn::IdRegistryStl<BodyId>                         m_bodyIds;
     osp::IdMap_t<BodyId, ForceFactors_t>                m_bodyFactors;
     lgrn::IdSetStl<BodyId>                              m_bodyDirty;
 
-    osp::IdMap_t<BodyId, osp::active::ActiveEnt>        m_bodyToEnt;
-    osp::IdMap_t<osp::active::ActiveEnt, BodyId>        m_entToBody;
+    /// Null for unused IDs. Sized by SysJolt::resize_body_data
+    osp::KeyedVec<BodyId, osp::active::ActiveEnt>       m_bodyToEnt;
+
+    /// Null for entities without a body. Grows in SysJolt::set_body_ent
+    osp::KeyedVec<osp::active::ActiveEnt, BodyId>       m_entToBody;
 
     std::vector<ForceFactorFunc>                        m_factors;
+
+    /// Checked in order, bodies use the first whose factors they all have
+    std::vector<FusedForceFactor>                       m_fusedFactors;
+    ForceBatchBuffers                                   m_forceBatch;
     ShapeStorage_t                                      m_shapes;
 
+    /// Shapes shared between bodies and entities, see SysJolt::create_primitive
+    ShapeCache_t                                        m_shapeCache;
+
+    /// Bodies that can have sub-shapes added or removed without being recreated
+    osp::IdMap_t<BodyId, CompoundBody>                  m_compounds;
+
     osp::active::ACompTransformStorage_t                *m_pTransform{nullptr};
 
+    /// Optional; bodies that moved are marked here. See ACtxSceneGraph::m_transformDirty
+    osp::KeyedVec<osp::active::ActiveEnt, uint8_t>      *m_pTransformDirty{nullptr};
+
+    /// Contacts are appended here while updating, set from ACtxPhysics::m_contacts
+    osp::active::ContactStream                          *m_pContacts{nullptr};
+
+    /// Active dynamic bodies after the last SysJolt::update_world, sorted by ID
+    BodyIDVector                                        m_activeBodies;
+
+    /// World transforms of m_activeBodies, in the same order
+    std::vector<Mat44>                                  m_activeTransforms;
+
+    /// Active dynamic bodies and their transforms from before the last fixed step, sorted by ID.
+    /// Blended with m_activeTransforms when interpolating, see SysJolt::update_world.
+    BodyIDVector                                        m_prevActiveBodies;
+    std::vector<Mat44>                                  m_prevActiveTransforms;
+
+    /// Seconds per fixed step, 0 if stepping with the frame's delta time
+    float                                               m_fixedStep         {0.0f};
+    int                                                 m_maxSubsteps       {4};
+    int                                                 m_collisionSteps    {1};
+    bool                                                m_interpolate       {true};
+
+    /// Time not yet simulated, always less than m_fixedStep after update_world
+    float                                               m_timeAccumulator   {0.0f};
+
+    /// Bodies that are awake as of the last SysJolt::update_world. Sleeping bodies don't move,
+    /// so tasks that only care about moving bodies can skip everything else.
+    lgrn::IdSetStl<BodyId>                              m_awakeBodies;
+
+    /// Bodies that fell asleep during the last SysJolt::update_world
+    std::vector<BodyId>                                 m_fellAsleep;
+
+    /// Activation events queued by BodyActivationListenerImpl in the order they happened,
+    /// true for waking up
+    std::vector< std::pair<BodyID, bool> >              m_activationEvents;
+    std::mutex                                          m_activationMutex;
+
 private:
 
     static void initJoltGlobalInternal() 
@@ -340,3 +724,40 @@ private:
 
 } //namespace ospjolt
 
+namespace osp
+{
+
+/**
+ * Counts OSP-side bookkeeping only. Jolt's own bodies, contacts and broadphase are allocated up
+ * front by PhysicsSystem::Init from JoltWorldConfig, so they don't grow over time. The temp
+ * allocator is counted in the "jolt_temp" MemoryCategory instead.
+ */
+template <>
+struct MemoryUsage<ospjolt::ACtxJoltWorld>
+{
+    static std::size_t heap_bytes(ospjolt::ACtxJoltWorld const& world) noexcept
+    {
+        using ospjolt::ACtxJoltWorld;
+        ACtxJoltWorld::ForceBatchBuffers const &batch = world.m_forceBatch;
+
+        return    (world.m_activeBodies.capacity() + world.m_prevActiveBodies.capacity()) * sizeof(JPH::BodyID)
+                + world.m_shapeCache.size() * sizeof(ospjolt::ShapeCache_t::value_type)
+                + heap_bytes_sum(
+                        world.m_bodyIds,
+                        world.m_bodyFactors,
+                        world.m_bodyToEnt,
+                        world.m_entToBody,
+                        world.m_factors,
+                        world.m_fusedFactors,
+                        batch.m_bodies, batch.m_positions, batch.m_velocities, batch.m_masses,
+                        batch.m_forces, batch.m_torques, batch.m_factorIndices,
+                        world.m_compounds,
+                        world.m_activeTransforms,
+                        world.m_prevActiveTransforms,
+                        world.m_fellAsleep,
+                        world.m_activationEvents);
+    }
+};
+
+} // namespace osp
+
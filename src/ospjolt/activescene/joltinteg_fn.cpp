@@ -25,8 +25,27 @@
 
 #include "joltinteg_fn.h"          // IWYU pragma: associated
 #include <osp/activescene/basic_fn.h>
+#include <osp/activescene/physics_fn.h>
+#include <osp/drawing/own_restypes.h>
 
+#include <osp/core/byte_stream.h>
+#include <osp/util/profiling.h>
+
+#include <Magnum/Trade/MeshData.h>
+
+#include <Jolt/Physics/StateRecorderImpl.h>
+
+#include <longeron/utility/asserts.hpp>
+
+#include <algorithm>                 // for std::sort, std::lower_bound
+#include <bit>                       // for std::countr_zero
+#include <cmath>                     // for std::abs
+#include <limits>                    // for std::numeric_limits
+#include <memory>                    // for std::shared_ptr
+#include <mutex>                     // for std::mutex
+#include <string>                    // for std::string
 #include <utility>                   // for std::exchange
+#include <vector>                    // for std::vector
 #include <cassert>                   // for assert
 
 // IWYU pragma: no_include <cstddef>
@@ -41,105 +60,873 @@ using osp::EShape;
 
 using osp::active::ActiveEnt;
 using osp::active::ACtxPhysics;
+using osp::active::ACtxSceneGraph;
+using osp::active::RaycastQueries;
+using osp::active::SysPhysics;
 using osp::active::SysSceneGraph;
 
 using osp::Matrix3;
 using osp::Matrix4;
 using osp::Vector3;
 
-void SysJolt::resize_body_data(ACtxJoltWorld& rCtxWorld)
+void SysJolt::resize_body_data(ACtxJoltWorld& rCtxWorld)
+{
+    std::size_t const capacity = rCtxWorld.m_bodyIds.capacity();
+    rCtxWorld.m_bodyToEnt.resize(capacity, lgrn::id_null<ActiveEnt>());
+}
+
+void SysJolt::set_body_ent(ACtxJoltWorld& rCtxWorld, BodyId const bodyId, ActiveEnt const ent)
+{
+    if (std::size_t(ent) >= rCtxWorld.m_entToBody.size())
+    {
+        // Grow geometrically, entities are created one at a time
+        std::size_t const size = std::max(std::size_t(ent) + 1, rCtxWorld.m_entToBody.size() * 2);
+        rCtxWorld.m_entToBody.resize(size, lgrn::id_null<BodyId>());
+    }
+    rCtxWorld.m_entToBody[ent]      = bodyId;
+    rCtxWorld.m_bodyToEnt[bodyId]   = ent;
+}
+
+namespace
+{
+
+struct SharedJobPool
+{
+    std::weak_ptr<JobSystem>    pJobSystem;
+
+    /// Handles given out by SysJolt::shared_job_system that are still alive
+    int                         worlds      { 0 };
+};
+
+struct SharedJobPools
+{
+    std::mutex                  mutex;
+
+    // Never shrinks, handles refer to their pool by index
+    std::vector<SharedJobPool>  pools;
+};
+
+SharedJobPools& shared_job_pools()
+{
+    static SharedJobPools s_pools;
+    return s_pools;
+}
+
+} // namespace
+
+std::shared_ptr<JobSystem> SysJolt::shared_job_system(int const threadCount)
+{
+    SharedJobPools &rShared = shared_job_pools();
+    std::lock_guard const lock{rShared.mutex};
+
+    std::shared_ptr<JobSystem>  pJobSystem;
+    std::size_t                 index       = rShared.pools.size();
+
+    // Each world holds at most one barrier at a time (PhysicsSystem::Update or update_raycasts),
+    // so a pool can't step more worlds at once than it has barriers
+    for (std::size_t i = 0; i < rShared.pools.size(); ++i)
+    {
+        SharedJobPool &rPool = rShared.pools[i];
+        if (rPool.worlds < cMaxPhysicsBarriers)
+        {
+            if (pJobSystem = rPool.pJobSystem.lock(); pJobSystem != nullptr)
+            {
+                index = i;
+                break;
+            }
+            if (index == rShared.pools.size())
+            {
+                index = i; // expired, reuse the slot if no live pool has room
+            }
+        }
+    }
+
+    if (pJobSystem == nullptr)
+    {
+        if (index == rShared.pools.size())
+        {
+            rShared.pools.emplace_back();
+        }
+        pJobSystem = std::make_shared<JobSystemThreadPool>(cMaxPhysicsJobs, cMaxPhysicsBarriers, threadCount);
+        rShared.pools[index] = SharedJobPool{ .pJobSystem = pJobSystem, .worlds = 0 };
+    }
+
+    ++ rShared.pools[index].worlds;
+
+    // Handle that counts one world for as long as any copy of it is alive
+    JobSystem *pRaw = pJobSystem.get();
+    return std::shared_ptr<JobSystem>(pRaw, [pJobSystem = std::move(pJobSystem), index] (JobSystem*) mutable
+    {
+        SharedJobPools &rShared = shared_job_pools();
+        {
+            std::lock_guard const lock{rShared.mutex};
+            -- rShared.pools[index].worlds;
+        }
+        pJobSystem.reset(); // may destroy the pool, outside of the lock
+    });
+}
+
+
+void SysJolt::update_translate(
+        ACtxPhysics&                        rCtxPhys,
+        ACtxJoltWorld&                      rCtxWorld,
+        ACompTransformStorage_t&            rTf,
+        osp::KeyedVec<ActiveEnt, uint8_t>*  pTfDirty) noexcept
+{
+
+    // Origin translation
+    if (Vector3 const translate = std::exchange(rCtxPhys.m_originTranslate, {});
+        ! translate.isZero())
+    {
+        PhysicsSystem* pJoltWorld = rCtxWorld.m_pPhysicsSystem.get();
+
+        // This runs outside of PhysicsSystem::Update and nothing else accesses the bodies, so
+        // locking each one is unnecessary. Our own body IDs are iterated directly instead of
+        // copying them out with GetBodies.
+        BodyInterface &bodyInterface = pJoltWorld->GetBodyInterfaceNoLock();
+
+        Vec3 const joltTranslate = Vec3MagnumToJolt(translate);
+
+        // Translate every jolt body
+        for (BodyId const bodyId : rCtxWorld.m_bodyIds)
+        {
+            JPH::BodyID const joltBodyId = BToJolt(bodyId);
+            RVec3 const position = bodyInterface.GetPosition(joltBodyId) + joltTranslate;
+            //As we are translating the whole world, we don't need to wake up asleep bodies. 
+            bodyInterface.SetPosition(joltBodyId, position, EActivation::DontActivate);
+
+            // Active bodies are read back by update_world, but sleeping ones aren't
+            if (bodyInterface.IsActive(joltBodyId))
+            {
+                continue;
+            }
+
+            ActiveEnt const ent = rCtxWorld.m_bodyToEnt[bodyId];
+            if (ent == lgrn::id_null<ActiveEnt>() || ! rTf.contains(ent))
+            {
+                continue;
+            }
+
+            rTf.get(ent).m_transform.translation() += translate;
+
+            if (pTfDirty != nullptr)
+            {
+                (*pTfDirty)[ent] = 1;
+            }
+        }
+    }
+}
+
+using Corrade::Containers::ArrayView;
+
+/**
+ * @brief Get active dynamic bodies sorted by ID, and their world transforms in the same order
+ */
+static void gather_active_transforms(PhysicsSystem& rJoltWorld, BodyIDVector& rBodies, std::vector<Mat44>& rTransforms) noexcept
+{
+#if JPH_VERSION_MAJOR >= 4
+    rJoltWorld.GetActiveBodies(EBodyType::RigidBody, rBodies);
+#else
+    rJoltWorld.GetActiveBodies(rBodies);
+#endif
+    std::sort(rBodies.begin(), rBodies.end());
+
+    // No lock needed, nothing else accesses the world while it's being updated
+    BodyInterface &bodyInterfaceNoLock = rJoltWorld.GetBodyInterfaceNoLock();
+
+    rTransforms.clear();
+    std::size_t dynamicCount = 0;
+    for (JPH::BodyID const joltBodyId : rBodies)
+    {
+        if (bodyInterfaceNoLock.GetMotionType(joltBodyId) == EMotionType::Dynamic)
+        {
+            rBodies[dynamicCount] = joltBodyId;
+            rTransforms.push_back(bodyInterfaceNoLock.GetWorldTransform(joltBodyId));
+            ++dynamicCount;
+        }
+    }
+    rBodies.resize(dynamicCount);
+}
+
+void SysJolt::update_world(
+        ACtxPhysics&                rCtxPhys,
+        ACtxJoltWorld&              rCtxWorld,
+        float                       timestep,
+        ACompTransformStorage_t&    rTf,
+        osp::KeyedVec<ActiveEnt, uint8_t>* pTfDirty) noexcept
+{
+    OSP_PROFILE_ZONE("SysJolt::update_world");
+
+    PhysicsSystem *pJoltWorld = rCtxWorld.m_pPhysicsSystem.get();
+    BodyInterface &bodyInterface = pJoltWorld->GetBodyInterface();
+
+    // Apply changed velocities
+    for (auto const& [ent, vel] : std::exchange(rCtxPhys.m_setVelocity, {}))
+    {
+        LGRN_ASSERTM(find_body(rCtxWorld, ent) != lgrn::id_null<BodyId>(), "Entity has no body");
+        JPH::BodyID const bodyId     = BToJolt(rCtxWorld.m_entToBody[ent]);
+
+        bodyInterface.SetLinearVelocity(bodyId, Vec3MagnumToJolt(vel));
+    }
+
+    rCtxWorld.m_pTransform      = std::addressof(rTf);
+    rCtxWorld.m_pTransformDirty = pTfDirty;
+    rCtxWorld.m_pContacts       = &rCtxPhys.m_contacts;
+
+    // Step count and size for this update. With a fixed rate, steps are always the same size so
+    // results don't depend on the frame rate, and leftover time carries over to the next update.
+    int   steps     = 1;
+    float stepTime  = timestep;
+    bool  blend     = false;
+    if (rCtxWorld.m_fixedStep > 0.0f)
+    {
+        rCtxWorld.m_timeAccumulator += timestep;
+        steps = static_cast<int>(rCtxWorld.m_timeAccumulator / rCtxWorld.m_fixedStep);
+        if (steps > rCtxWorld.m_maxSubsteps)
+        {
+            // Fall behind instead of taking ever more steps to catch up
+            steps = rCtxWorld.m_maxSubsteps;
+            rCtxWorld.m_timeAccumulator = float(steps) * rCtxWorld.m_fixedStep;
+        }
+        rCtxWorld.m_timeAccumulator -= float(steps) * rCtxWorld.m_fixedStep;
+        stepTime = rCtxWorld.m_fixedStep;
+        blend    = rCtxWorld.m_interpolate;
+    }
+
+    for (int i = 0; i < steps; ++i)
+    {
+        if (blend && i == steps - 1)
+        {
+            gather_active_transforms(*pJoltWorld, rCtxWorld.m_prevActiveBodies, rCtxWorld.m_prevActiveTransforms);
+        }
+        pJoltWorld->Update(stepTime, rCtxWorld.m_collisionSteps, &rCtxWorld.m_temp_allocator, rCtxWorld.m_joltJobSystem.get());
+    }
+
+    BodyInterface &bodyInterfaceNoLock = pJoltWorld->GetBodyInterfaceNoLock();
+
+    update_awake(rCtxWorld);
+
+    // Bodies that fell asleep aren't in the active list anymore. Write their final transform,
+    // since the last one written may have been blended with an older one.
+    for (BodyId const bodyId : rCtxWorld.m_fellAsleep)
+    {
+        ActiveEnt const ent = rCtxWorld.m_bodyToEnt[bodyId];
+        if (ent == lgrn::id_null<ActiveEnt>() || ! rTf.contains(ent))
+        {
+            continue;
+        }
+
+        Mat44 const worldTransform = bodyInterfaceNoLock.GetWorldTransform(BToJolt(bodyId));
+        osp::Matrix4 &rEntTf = rTf.get(ent).m_transform;
+        for (int col = 0; col < 4; ++col)
+        {
+            worldTransform.GetColumn3(col).StoreFloat3(reinterpret_cast<Float3*>(rEntTf[col].data()));
+        }
+
+        if (pTfDirty != nullptr)
+        {
+            (*pTfDirty)[ent] = 1;
+        }
+    }
+
+    if (steps == 0 && ! blend)
+    {
+        return; // Nothing moved
+    }
+
+    // Transform jolt -> osp
+    // Jolt keeps a dense list of active bodies, so sleeping and static bodies cost nothing here.
+    // Transforms are gathered in body order first, then scattered into rTf in one pass.
+    if (steps != 0)
+    {
+        gather_active_transforms(*pJoltWorld, rCtxWorld.m_activeBodies, rCtxWorld.m_activeTransforms);
+    }
+
+    // Fraction of a fixed step between the previous and latest state to show
+    float const alpha = blend ? (rCtxWorld.m_timeAccumulator / rCtxWorld.m_fixedStep) : 1.0f;
+
+    BodyIDVector const& prevBodies = rCtxWorld.m_prevActiveBodies;
+
+    for (std::size_t i = 0; i < rCtxWorld.m_activeBodies.size(); ++i)
+    {
+        JPH::BodyID const joltBodyId = rCtxWorld.m_activeBodies[i];
+
+        ActiveEnt const ent = find_ent(rCtxWorld, BodyId{joltBodyId.GetIndex()});
+        if (ent == lgrn::id_null<ActiveEnt>() || ! rTf.contains(ent))
+        {
+            continue; // Body not owned by an entity
+        }
+
+        Mat44 worldTransform = rCtxWorld.m_activeTransforms[i];
+
+        if (alpha < 1.0f)
+        {
+            // Bodies that just woke up have no previous transform, and are shown as is
+            auto const itPrev = std::lower_bound(prevBodies.begin(), prevBodies.end(), joltBodyId);
+            if (itPrev != prevBodies.end() && *itPrev == joltBodyId)
+            {
+                Mat44 const &prev = rCtxWorld.m_prevActiveTransforms[std::size_t(itPrev - prevBodies.begin())];
+                Quat const rotation = prev.GetQuaternion().SLERP(worldTransform.GetQuaternion(), alpha);
+                Vec3 const position = prev.GetTranslation() * (1.0f - alpha) + worldTransform.GetTranslation() * alpha;
+                worldTransform = Mat44::sRotationTranslation(rotation, position);
+            }
+        }
+
+        // Only write the affine part; the last row of ACompTransform is always (0, 0, 0, 1)
+        osp::Matrix4 &rEntTf = rTf.get(ent).m_transform;
+        for (int col = 0; col < 4; ++col)
+        {
+            worldTransform.GetColumn3(col).StoreFloat3(reinterpret_cast<Float3*>(rEntTf[col].data()));
+        }
+
+        if (pTfDirty != nullptr)
+        {
+            (*pTfDirty)[ent] = 1;
+        }
+    }
+}
+
+void SysJolt::update_awake(ACtxJoltWorld& rCtxWorld) noexcept
+{
+    rCtxWorld.m_fellAsleep.clear();
+    rCtxWorld.m_awakeBodies.resize(rCtxWorld.m_bodyIds.capacity());
+
+    std::lock_guard<std::mutex> lock{rCtxWorld.m_activationMutex};
+
+    // Applied in order, a body may have woken up and fallen asleep during one update
+    for (auto const& [joltBodyId, awake] : std::exchange(rCtxWorld.m_activationEvents, {}))
+    {
+        BodyId const bodyId = BodyId{joltBodyId.GetIndex()};
+        if (awake)
+        {
+            rCtxWorld.m_awakeBodies.insert(bodyId);
+        }
+        else if (rCtxWorld.m_awakeBodies.contains(bodyId))
+        {
+            rCtxWorld.m_awakeBodies.erase(bodyId);
+            rCtxWorld.m_fellAsleep.push_back(bodyId);
+        }
+    }
+}
+
+/**
+ * @brief Cast one range of rays, writing only to their own elements of rRays
+ */
+static void raycast_range(ACtxJoltWorld const& rCtxWorld, RaycastQueries& rRays, std::size_t const first, std::size_t const last) noexcept
+{
+    PhysicsSystem const &rJoltWorld = *rCtxWorld.m_pPhysicsSystem;
+    NarrowPhaseQuery const &rQuery  = rJoltWorld.GetNarrowPhaseQuery();
+
+    for (std::size_t i = first; i < last; ++i)
+    {
+        RRayCast const ray{Vec3MagnumToJolt(rRays.m_origins[i]), Vec3MagnumToJolt(rRays.m_directions[i])};
+        RayCastResult hit;
+
+        bool found;
+        ActiveEnt const ignore = rRays.m_ignore[i];
+        BodyId const ignoreBody = (ignore != lgrn::id_null<ActiveEnt>()) ? find_body(rCtxWorld, ignore)
+                                                                          : lgrn::id_null<BodyId>();
+        if (ignoreBody != lgrn::id_null<BodyId>())
+        {
+            IgnoreSingleBodyFilter const filter{BToJolt(ignoreBody)};
+            found = rQuery.CastRay(ray, hit, {}, {}, filter);
+        }
+        else
+        {
+            found = rQuery.CastRay(ray, hit);
+        }
+
+        if ( ! found )
+        {
+            continue;
+        }
+
+        rRays.m_hitFraction[i] = hit.mFraction;
+
+        // Read locks only block writers, and nothing writes to bodies while rays are cast
+        BodyLockRead lock{rJoltWorld.GetBodyLockInterface(), hit.mBodyID};
+        if (lock.Succeeded())
+        {
+            Vec3 const normal = lock.GetBody().GetWorldSpaceSurfaceNormal(hit.mSubShapeID2, ray.GetPointOnRay(hit.mFraction));
+            rRays.m_hitNormal[i] = Vec3JoltToMagnum(normal);
+        }
+
+        rRays.m_hitEnt[i] = find_ent(rCtxWorld, BodyId{hit.mBodyID.GetIndex()});
+    }
+}
+
+void SysJolt::update_raycasts(ACtxJoltWorld& rCtxWorld, RaycastQueries& rRays) noexcept
+{
+    SysPhysics::raycast_prepare_results(rRays);
+
+    std::size_t const count = rRays.size();
+    if (count == 0)
+    {
+        return;
+    }
+
+    JobSystem &rJobSystem = *rCtxWorld.m_joltJobSystem;
+
+    std::size_t const maxRanges  = std::max(rJobSystem.GetMaxConcurrency(), 1);
+    std::size_t const rangeCount = std::clamp<std::size_t>(count / smc_minRaysPerRange, 1, maxRanges);
+
+    if (rangeCount == 1)
+    {
+        raycast_range(rCtxWorld, rRays, 0, count);
+        return;
+    }
+
+    JobSystem::Barrier *pBarrier = rJobSystem.CreateBarrier();
+    for (std::size_t range = 1; range < rangeCount; ++range)
+    {
+        JobHandle handle = rJobSystem.CreateJob("OSP Raycasts", Color::sGreen,
+                [&rCtxWorld, &rRays, range, rangeCount, count] ()
+        {
+            raycast_range(rCtxWorld, rRays, count * range / rangeCount, count * (range + 1) / rangeCount);
+        });
+        pBarrier->AddJob(handle);
+    }
+
+    raycast_range(rCtxWorld, rRays, 0, count / rangeCount);
+
+    rJobSystem.WaitForJobs(pBarrier);
+    rJobSystem.DestroyBarrier(pBarrier);
+}
+
+void SysJolt::remove_components(ACtxJoltWorld& rCtxWorld, ActiveEnt ent) noexcept
+{
+    BodyId const bodyId = find_body(rCtxWorld, ent);
+    BodyInterface &bodyInterface = rCtxWorld.m_pPhysicsSystem->GetBodyInterface();
+
+    if (bodyId != lgrn::id_null<BodyId>())
+    {
+        JPH::BodyID joltBodyId = BToJolt(bodyId);
+        if (bodyInterface.IsAdded(joltBodyId)) // Not added while parked, see setup_phys_shapes_jolt
+        {
+            bodyInterface.RemoveBody(joltBodyId);
+        }
+        bodyInterface.DestroyBody(joltBodyId);
+        rCtxWorld.m_bodyIds.remove(bodyId);
+        rCtxWorld.m_bodyToEnt[bodyId] = lgrn::id_null<ActiveEnt>();
+        rCtxWorld.m_entToBody[ent]    = lgrn::id_null<BodyId>();
+        rCtxWorld.m_compounds.erase(bodyId);
+
+        // Forget activation state, so a body that reuses this BodyId doesn't start out awake
+        std::lock_guard<std::mutex> lock{rCtxWorld.m_activationMutex};
+        std::erase_if(rCtxWorld.m_activationEvents, [joltBodyId] (auto const& event)
+        {
+            return event.first == joltBodyId;
+        });
+        rCtxWorld.m_awakeBodies.resize(rCtxWorld.m_bodyIds.capacity());
+        if (rCtxWorld.m_awakeBodies.contains(bodyId))
+        {
+            rCtxWorld.m_awakeBodies.erase(bodyId);
+        }
+    }
+
+}
+
+ForceFactors_t SysJolt::remap_factors(
+        ForceFactors_t const                                    factors,
+        std::vector<ACtxJoltWorld::ForceFactorFunc> const&      from,
+        std::vector<ACtxJoltWorld::ForceFactorFunc> const&      to) noexcept
+{
+    using ForceFactorFunc = ACtxJoltWorld::ForceFactorFunc;
+
+    auto const same_funcs = [] (ForceFactorFunc const& lhs, ForceFactorFunc const& rhs) noexcept
+    {
+        return lhs.m_func == rhs.m_func && lhs.m_batchFunc == rhs.m_batchFunc;
+    };
+
+    constexpr std::size_t c_wordBits = std::numeric_limits<ForceFactors_t::value_type>::digits;
+
+    ForceFactors_t out{};
+    for (std::size_t word = 0; word < factors.size(); ++word)
+    {
+        for (auto bits = factors[word]; bits != 0; bits &= bits - 1)
+        {
+            std::size_t const index = word * c_wordBits + std::size_t(std::countr_zero(bits));
+            if (index >= from.size())
+            {
+                break;
+            }
+            ForceFactorFunc const &factor = from[index];
+
+            // Prefer the exact same factor, otherwise the same functions with the destination
+            // world's own user data, eg. another scene's gravity
+            auto itMatch = std::find_if(to.begin(), to.end(), [&factor, &same_funcs] (ForceFactorFunc const& other)
+            {
+                return same_funcs(factor, other) && factor.m_userData == other.m_userData;
+            });
+            if (itMatch == to.end())
+            {
+                itMatch = std::find_if(to.begin(), to.end(), [&factor, &same_funcs] (ForceFactorFunc const& other)
+                {
+                    return same_funcs(factor, other);
+                });
+            }
+
+            if (itMatch != to.end())
+            {
+                std::size_t const toIndex = std::size_t(std::distance(to.begin(), itMatch));
+                out[toIndex / c_wordBits] |= ForceFactors_t::value_type(1) << (toIndex % c_wordBits);
+            }
+        }
+    }
+    return out;
+}
+
+BodyId SysJolt::transfer_body(
+        ACtxJoltWorld&                  rFrom,
+        ACtxJoltWorld&                  rTo,
+        ActiveEnt const                 ent,
+        osp::ArrayView<ActiveEnt const> entRemap,
+        Vector3 const                   offset)
+{
+    BodyId const fromBodyId = find_body(rFrom, ent);
+    if (fromBodyId == lgrn::id_null<BodyId>())
+    {
+        return lgrn::id_null<BodyId>();
+    }
+
+    // Creation settings carry the shape, motion type, layer, and mass properties. Shapes aren't
+    // owned by a PhysicsSystem, so the new body shares them.
+    BodyCreationSettings settings;
+    {
+        BodyLockRead lock{rFrom.m_pPhysicsSystem->GetBodyLockInterface(), BToJolt(fromBodyId)};
+        LGRN_ASSERT(lock.Succeeded());
+        Body const &body = lock.GetBody();
+
+        settings                    = body.GetBodyCreationSettings();
+        settings.mPosition          = body.GetPosition() + Vec3MagnumToJolt(offset);
+        settings.mRotation          = body.GetRotation();
+        settings.mLinearVelocity    = body.GetLinearVelocity();
+        settings.mAngularVelocity   = body.GetAngularVelocity();
+    }
+
+    ActiveEnt const toEnt = entRemap[std::size_t(ent)];
+
+    BodyId const toBodyId = rTo.m_bodyIds.create();
+    resize_body_data(rTo);
+
+    set_body_ent(rTo, toBodyId, toEnt);
+    if (auto const itFactors = rFrom.m_bodyFactors.find(fromBodyId);
+        itFactors != rFrom.m_bodyFactors.end())
+    {
+        rTo.m_bodyFactors[toBodyId] = remap_factors(itFactors->second, rFrom.m_factors, rTo.m_factors);
+    }
+
+    auto const move_shape = [&rFrom, &rTo, entRemap] (ActiveEnt const colliderEnt)
+    {
+        if (rFrom.m_shapes.contains(colliderEnt))
+        {
+            rTo.m_shapes.emplace(entRemap[std::size_t(colliderEnt)], std::move(rFrom.m_shapes.get(colliderEnt)));
+            rFrom.m_shapes.remove(colliderEnt);
+        }
+    };
+
+    move_shape(ent);
+
+    if (auto itCompound = rFrom.m_compounds.find(fromBodyId);
+        itCompound != rFrom.m_compounds.end())
+    {
+        CompoundBody compound = std::move(itCompound->second);
+        for (ActiveEnt &rSubShapeEnt : compound.m_subShapeEnts)
+        {
+            move_shape(rSubShapeEnt);
+            rSubShapeEnt = entRemap[std::size_t(rSubShapeEnt)];
+        }
+        rTo.m_compounds.emplace(toBodyId, std::move(compound));
+    }
+
+    remove_components(rFrom, ent);
+
+    BodyInterface &bodyInterface = rTo.m_pPhysicsSystem->GetBodyInterface();
+    bodyInterface.CreateBodyWithID(BToJolt(toBodyId), settings);
+    bodyInterface.AddBody(BToJolt(toBodyId), EActivation::Activate);
+
+    return toBodyId;
+}
+
+// Snapshot blob: header, then per body its ID, entity, and force factors, then Jolt's own state
+static constexpr std::uint32_t gc_snapshotMagic     = 0x4A50534F; // "OSPJ"
+static constexpr std::uint32_t gc_snapshotVersion   = 1;
+
+std::vector<std::byte> SysJolt::save_snapshot(ACtxJoltWorld const& rCtxWorld)
+{
+    std::vector<std::byte> out;
+
+    auto const bodyCount = static_cast<std::uint32_t>(rCtxWorld.m_bodyIds.size());
+    osp::append_bytes(out, gc_snapshotMagic);
+    osp::append_bytes(out, gc_snapshotVersion);
+    osp::append_bytes(out, bodyCount);
+    osp::append_bytes(out, rCtxWorld.m_timeAccumulator);
+
+    for (BodyId const bodyId : rCtxWorld.m_bodyIds)
+    {
+        auto const itFactors = rCtxWorld.m_bodyFactors.find(bodyId);
+        osp::append_bytes(out, bodyId);
+        osp::append_bytes(out, rCtxWorld.m_bodyToEnt[bodyId]);
+        osp::append_bytes(out, (itFactors != rCtxWorld.m_bodyFactors.end()) ? itFactors->second : ForceFactors_t{});
+    }
+
+    StateRecorderImpl recorder;
+    rCtxWorld.m_pPhysicsSystem->SaveState(recorder);
+    std::string const joltState = recorder.GetData();
+
+    osp::append_bytes(out, static_cast<std::uint64_t>(joltState.size()));
+    osp::append_bytes(out, joltState.data(), joltState.size());
+    return out;
+}
+
+bool SysJolt::restore_snapshot(
+        ACtxJoltWorld&                      rCtxWorld,
+        osp::ArrayView<std::byte const>     data,
+        ACompTransformStorage_t&            rTf,
+        osp::KeyedVec<ActiveEnt, uint8_t>*  pTfDirty)
+{
+    osp::ByteReader reader{data};
+
+    std::uint32_t   magic       = 0;
+    std::uint32_t   version     = 0;
+    std::uint32_t   bodyCount   = 0;
+    float           accumulator = 0.0f;
+    if (   ! reader.read(magic)    || magic     != gc_snapshotMagic
+        || ! reader.read(version)  || version   != gc_snapshotVersion
+        || ! reader.read(bodyCount) || bodyCount != rCtxWorld.m_bodyIds.size()
+        || ! reader.read(accumulator))
+    {
+        return false;
+    }
+
+    struct SavedBody
+    {
+        BodyId          id;
+        ActiveEnt       ent;
+        ForceFactors_t  factors;
+    };
+
+    // Read everything before modifying the world, so a bad blob changes nothing
+    std::vector<SavedBody> saved(bodyCount);
+    for (SavedBody &rSaved : saved)
+    {
+        if (   ! reader.read(rSaved.id) || ! reader.read(rSaved.ent) || ! reader.read(rSaved.factors)
+            || ! rCtxWorld.m_bodyIds.exists(rSaved.id))
+        {
+            return false; // Body was removed since the snapshot
+        }
+    }
+
+    std::uint64_t joltSize = 0;
+    if ( ! reader.read(joltSize) || joltSize != reader.remaining().size())
+    {
+        return false;
+    }
+
+    StateRecorderImpl recorder;
+    recorder.WriteBytes(reader.remaining().data(), reader.remaining().size());
+    recorder.Rewind();
+    if ( ! rCtxWorld.m_pPhysicsSystem->RestoreState(recorder) )
+    {
+        return false;
+    }
+
+    rCtxWorld.m_timeAccumulator = accumulator;
+
+    for (SavedBody const& rSaved : saved)
+    {
+        ActiveEnt const oldEnt = rCtxWorld.m_bodyToEnt[rSaved.id];
+        if (oldEnt != lgrn::id_null<ActiveEnt>())
+        {
+            rCtxWorld.m_entToBody[oldEnt] = lgrn::id_null<BodyId>();
+        }
+    }
+
+    BodyInterface &bodyInterface = rCtxWorld.m_pPhysicsSystem->GetBodyInterface();
+
+    for (SavedBody const& rSaved : saved)
+    {
+        rCtxWorld.m_bodyToEnt[rSaved.id] = lgrn::id_null<ActiveEnt>();
+        if (rSaved.ent != lgrn::id_null<ActiveEnt>())
+        {
+            set_body_ent(rCtxWorld, rSaved.id, rSaved.ent);
+        }
+        rCtxWorld.m_bodyFactors[rSaved.id] = rSaved.factors;
+
+        if (rSaved.ent == lgrn::id_null<ActiveEnt>() || ! rTf.contains(rSaved.ent))
+        {
+            continue;
+        }
+
+        Mat44 const worldTransform = bodyInterface.GetWorldTransform(BToJolt(rSaved.id));
+        osp::Matrix4 &rEntTf = rTf.get(rSaved.ent).m_transform;
+        for (int col = 0; col < 4; ++col)
+        {
+            worldTransform.GetColumn3(col).StoreFloat3(reinterpret_cast<Float3*>(rEntTf[col].data()));
+        }
+
+        if (pTfDirty != nullptr)
+        {
+            (*pTfDirty)[rSaved.ent] = 1;
+        }
+    }
+
+    // Activation events from restoring are superseded by reading the restored state directly
+    {
+        std::lock_guard<std::mutex> lock{rCtxWorld.m_activationMutex};
+        rCtxWorld.m_activationEvents.clear();
+    }
+    rCtxWorld.m_awakeBodies = {};
+    rCtxWorld.m_awakeBodies.resize(rCtxWorld.m_bodyIds.capacity());
+    for (SavedBody const& rSaved : saved)
+    {
+        if (bodyInterface.IsActive(BToJolt(rSaved.id)))
+        {
+            rCtxWorld.m_awakeBodies.insert(rSaved.id);
+        }
+    }
+    rCtxWorld.m_fellAsleep.clear();
+
+    // Don't blend from transforms before the restore
+    gather_active_transforms(*rCtxWorld.m_pPhysicsSystem, rCtxWorld.m_activeBodies, rCtxWorld.m_activeTransforms);
+    rCtxWorld.m_prevActiveBodies        = rCtxWorld.m_activeBodies;
+    rCtxWorld.m_prevActiveTransforms    = rCtxWorld.m_activeTransforms;
+
+    return true;
+}
+
+static ShapeCacheKey make_shape_key(osp::EShape const shape, Vec3Arg scale, osp::ResId const mesh) noexcept
+{
+    // + 0.0f turns -0.0f into 0.0f, they're equal but have different bits for the hash
+    return { .m_shape = shape,
+             .m_scale = {scale.GetX() + 0.0f, scale.GetY() + 0.0f, scale.GetZ() + 0.0f},
+             .m_mesh  = mesh };
+}
+
+Ref<Shape> SysJolt::create_primitive(ShapeCache_t &rCache, osp::EShape shape, Vec3Arg scale)
+{
+    auto const [it, inserted] = rCache.try_emplace(
+            make_shape_key(shape, scale, lgrn::id_null<osp::ResId>()));
+
+    if ( ! inserted )
+    {
+        return it->second;
+    }
+
+    Ref<Shape> &rShape = it->second;
+
+    switch (shape)
+    {
+    case EShape::Sphere:
+    //Sphere only support uniform shape
+        rShape = SphereShapeSettings(1.0f * scale.GetX()).Create().Get();
+        break;
+    case EShape::Box:
+        rShape = BoxShapeSettings(scale).Create().Get();
+        break;
+    case EShape::Cylinder:
+        //cylinder needs to be internally rotated 90° to match with graphics
+        rShape = RotatedTranslatedShapeSettings(
+                    Vec3Arg::sZero(), 
+                    Quat::sRotation(Vec3::sAxisX(), JPH_PI/2), 
+                    new CylinderShapeSettings(scale.GetZ(), 2.0f * scale.GetX())
+                ).Create().Get();
+        break;
+    case EShape::Capsule:
+        //same as cylinder, aligned along Z. Capsules only support a uniform radius
+        rShape = RotatedTranslatedShapeSettings(
+                    Vec3Arg::sZero(),
+                    Quat::sRotation(Vec3::sAxisX(), JPH_PI/2),
+                    new CapsuleShapeSettings(scale.GetZ(), scale.GetX())
+                ).Create().Get();
+        break;
+    default:
+        rShape = SphereShapeSettings(1.0f * scale.GetX()).Create().Get();
+        break;
+    }
+
+    return rShape;
+}
+
+Ref<Shape> SysJolt::create_convex_hull(
+        ShapeCache_t                                                &rCache,
+        osp::ResId const                                            mesh,
+        Corrade::Containers::StridedArrayView1D<osp::Vector3 const> points,
+        Vec3Arg                                                     scale)
 {
-    std::size_t const capacity = rCtxWorld.m_bodyIds.capacity();
-}
+    LGRN_ASSERTM(mesh != lgrn::id_null<osp::ResId>(), "Convex hulls are cached by mesh");
 
+    Vec3 const unitScale = Vec3::sReplicate(1.0f);
 
-void SysJolt::update_translate(ACtxPhysics& rCtxPhys, ACtxJoltWorld& rCtxWorld) noexcept
-{
+    auto const [itScaled, insertedScaled] = rCache.try_emplace(
+            make_shape_key(EShape::Custom, scale, mesh));
 
-    // Origin translation
-    if (Vector3 const translate = std::exchange(rCtxPhys.m_originTranslate, {});
-        ! translate.isZero())
+    if ( ! insertedScaled )
     {
-        PhysicsSystem* pJoltWorld = rCtxWorld.m_pPhysicsSystem.get();
-        BodyIDVector allBodiesIds;
-        pJoltWorld->GetBodies(allBodiesIds);
+        return itScaled->second;
+    }
 
-        BodyInterface &bodyInterface = pJoltWorld->GetBodyInterface();
+    // The unscaled hull is shared by all scales of the same mesh. Note that itScaled stays valid,
+    // unordered_map iterators are only invalidated by erase.
+    auto const [itHull, insertedHull] = rCache.try_emplace(
+            make_shape_key(EShape::Custom, unitScale, mesh));
 
-        // Translate every jolt body
-        for (BodyID bodyId : allBodiesIds)
+    if (insertedHull)
+    {
+        std::vector<Vec3> joltPoints;
+        joltPoints.reserve(points.size());
+        for (osp::Vector3 const& point : points)
         {
-            RVec3 position = bodyInterface.GetPosition(bodyId);
-            Matrix4 matrix;
-            position += Vec3MagnumToJolt(translate);
-            //As we are translating the whole world, we don't need to wake up asleep bodies. 
-            bodyInterface.SetPosition(bodyId, position, EActivation::DontActivate);
+            joltPoints.push_back(Vec3MagnumToJolt(point));
         }
-    }
-}
-
-using Corrade::Containers::ArrayView;
 
-void SysJolt::update_world(
-        ACtxPhysics&                rCtxPhys,
-        ACtxJoltWorld&              rCtxWorld,
-        float                       timestep,
-        ACompTransformStorage_t&    rTf) noexcept
-{
-    PhysicsSystem *pJoltWorld = rCtxWorld.m_pPhysicsSystem.get();
-    BodyInterface &bodyInterface = pJoltWorld->GetBodyInterface();
-
-    // Apply changed velocities
-    for (auto const& [ent, vel] : std::exchange(rCtxPhys.m_setVelocity, {}))
-    {
-        JPH::BodyID const bodyId     = BToJolt(rCtxWorld.m_entToBody.at(ent));
+        ShapeSettings::ShapeResult const result
+            = ConvexHullShapeSettings(joltPoints.data(), int(joltPoints.size())).Create();
 
-        bodyInterface.SetLinearVelocity(bodyId, Vec3MagnumToJolt(vel));
+        if (result.HasError())
+        {
+            OSP_LOG_WARN("Failed to build convex hull for mesh {}: {}", std::uint32_t(mesh), result.GetError().c_str());
+            itHull->second = SphereShapeSettings(1.0f).Create().Get();
+        }
+        else
+        {
+            itHull->second = result.Get();
+        }
     }
 
-    rCtxWorld.m_pTransform = std::addressof(rTf);
+    itScaled->second = (scale == unitScale) ? itHull->second : Ref<Shape>{new ScaledShape(itHull->second, scale)};
 
-    int collisionSteps = 1;
-    pJoltWorld->Update(timestep, collisionSteps, &rCtxWorld.m_temp_allocator, rCtxWorld.m_joltJobSystem.get());
+    return itScaled->second;
 }
 
-void SysJolt::remove_components(ACtxJoltWorld& rCtxWorld, ActiveEnt ent) noexcept
+Ref<Shape> SysJolt::create_convex_hull(
+        ShapeCache_t                                                &rCache,
+        osp::Resources const                                        &rResources,
+        osp::ResId const                                            mesh,
+        Vec3Arg                                                     scale)
 {
-    auto itBodyId = rCtxWorld.m_entToBody.find(ent);
-    BodyInterface &bodyInterface = rCtxWorld.m_pPhysicsSystem->GetBodyInterface();
+    auto const &meshData = rResources.data_get<Magnum::Trade::MeshData>(osp::restypes::gc_mesh, mesh);
 
-    if (itBodyId != rCtxWorld.m_entToBody.end())
+    // Only converted if the hull isn't cached yet
+    Corrade::Containers::Array<osp::Vector3> positions;
+    if ( ! rCache.contains(make_shape_key(EShape::Custom, Vec3::sReplicate(1.0f), mesh)) )
     {
-        BodyId const bodyId = itBodyId->second;
-        JPH::BodyID joltBodyId = BToJolt(bodyId);
-        bodyInterface.RemoveBody(joltBodyId);
-        bodyInterface.DestroyBody(joltBodyId);
-        rCtxWorld.m_bodyIds.remove(bodyId);
-        rCtxWorld.m_bodyToEnt[bodyId] = lgrn::id_null<ActiveEnt>();
-        rCtxWorld.m_entToBody.erase(itBodyId);
+        positions = meshData.positions3DAsArray();
     }
 
+    return create_convex_hull(rCache, mesh, osp::ArrayView<osp::Vector3 const>{positions.data(), positions.size()}, scale);
 }
 
-Ref<Shape> SysJolt::create_primitive(ACtxJoltWorld &rCtxWorld, osp::EShape shape, Vec3Arg scale)
+void SysJolt::shape_cache_prune(ACtxJoltWorld &rCtxWorld) noexcept
 {
-    switch (shape)
+    // Scaled hulls hold a reference to their unscaled hull, so repeat until nothing changes
+    bool pruned = true;
+    while (pruned)
     {
-    case EShape::Sphere:
-    //Sphere only support uniform shape
-        return SphereShapeSettings(1.0f * scale.GetX()).Create().Get();
-    case EShape::Box:
-        return BoxShapeSettings(scale).Create().Get();
-    case EShape::Cylinder:
-        //cylinder needs to be internally rotated 90° to match with graphics
-        return  RotatedTranslatedShapeSettings(
-                    Vec3Arg::sZero(), 
-                    Quat::sRotation(Vec3::sAxisX(), JPH_PI/2), 
-                    new CylinderShapeSettings(scale.GetZ(), 2.0f * scale.GetX())
-                ).Create().Get();
-        
-    default:
-        return SphereShapeSettings(1.0f * scale.GetX()).Create().Get();
+        pruned = 0 != std::erase_if(rCtxWorld.m_shapeCache, [] (auto const& entry)
+        {
+            return entry.second == nullptr || entry.second->GetRefCount() == 1;
+        });
     }
 }
 
@@ -173,6 +960,206 @@ float SysJolt::get_inverse_mass_no_lock(PhysicsSystem &physicsSystem,
   return 0.0f;
 }
 
+static Ref<Shape> collider_shape(
+        ACtxPhysics const&  rCtxPhys,
+        ACtxJoltWorld&      rCtxWorld,
+        ActiveEnt const     ent,
+        Matrix4 const&      transform)
+{
+    if (rCtxWorld.m_shapes.contains(ent))
+    {
+        return rCtxWorld.m_shapes.get(ent);
+    }
+
+    Ref<Shape> &rShape = rCtxWorld.m_shapes.emplace(ent);
+    rShape = SysJolt::create_primitive(rCtxWorld, rCtxPhys.m_shape[ent], Vec3MagnumToJolt(transform.scaling()));
+    return rShape;
+}
+
+static void collect_colliders_recurse(
+        ACtxPhysics const&                              rCtxPhys,
+        ACtxSceneGraph const&                           rScnGraph,
+        osp::active::ACompTransformStorage_t const&     rTf,
+        ActiveEnt const                                 ent,
+        Matrix4 const&                                  transform,
+        std::vector< std::pair<ActiveEnt, Matrix4> >&   rOut)
+{
+    if (rCtxPhys.m_shape[ent] != EShape::None)
+    {
+        rOut.emplace_back(ent, transform);
+    }
+
+    if ( ! rCtxPhys.m_hasColliders.contains(ent) )
+    {
+        return;
+    }
+
+    for (ActiveEnt child : SysSceneGraph::children(rScnGraph, ent))
+    {
+        if (rTf.contains(child))
+        {
+            collect_colliders_recurse(rCtxPhys, rScnGraph, rTf, child,
+                                      transform * rTf.get(child).m_transform, rOut);
+        }
+    }
+}
+
+void SysJolt::compound_add_collider(
+        ACtxPhysics const&                      rCtxPhys,
+        ACtxJoltWorld&                          rCtxWorld,
+        ActiveEnt const                         ent,
+        Matrix4 const&                          transform,
+        MutableCompoundShapeSettings&           rCompound,
+        CompoundBody&                           rBody)
+{
+    rCompound.AddShape( Vec3MagnumToJolt(transform.translation()),
+                        QuatMagnumToJolt(osp::Quaternion::fromMatrix(transform.rotation())),
+                        collider_shape(rCtxPhys, rCtxWorld, ent, transform));
+
+    rBody.m_subShapeEnts        .push_back(ent);
+    rBody.m_subShapeTransforms  .push_back(transform);
+}
+
+void SysJolt::update_compound(
+        ACtxPhysics&                            rCtxPhys,
+        ACtxJoltWorld&                          rCtxWorld,
+        ACtxSceneGraph&                         rScnGraph,
+        ACompTransformStorage_t const&          rTf,
+        ActiveEnt const                         ent) noexcept
+{
+    BodyId const bodyId = find_body(rCtxWorld, ent);
+    if (bodyId == lgrn::id_null<BodyId>())
+    {
+        return;
+    }
+
+    auto const itCompound = rCtxWorld.m_compounds.find(bodyId);
+    if (itCompound == rCtxWorld.m_compounds.end())
+    {
+        return;
+    }
+
+    CompoundBody            &rBody      = itCompound->second;
+    MutableCompoundShape    &rCompound  = *rBody.m_shape;
+    Vec3 const              previousCOM = rCompound.GetCenterOfMass();
+
+    std::vector< std::pair<ActiveEnt, Matrix4> > colliders;
+    collect_colliders_recurse(rCtxPhys, rScnGraph, rTf, ent, Matrix4{}, colliders);
+
+    if (colliders.empty())
+    {
+        remove_components(rCtxWorld, ent);
+        return;
+    }
+
+    osp::IdMap_t<ActiveEnt, std::size_t> colliderIdx;
+    colliderIdx.reserve(colliders.size());
+    for (std::size_t i = 0; i < colliders.size(); ++i)
+    {
+        colliderIdx.emplace(colliders[i].first, i);
+    }
+
+    bool changed = false;
+
+    // Remove sub-shapes of colliders that are gone. Back to front, since removing a sub-shape
+    // shifts down the indices of all sub-shapes after it.
+    for (std::size_t i = rBody.m_subShapeEnts.size(); i-- != 0; )
+    {
+        if ( ! colliderIdx.contains(rBody.m_subShapeEnts[i]) )
+        {
+            rCompound.RemoveShape(static_cast<uint>(i));
+            rBody.m_subShapeEnts        .erase(rBody.m_subShapeEnts.begin()       + std::ptrdiff_t(i));
+            rBody.m_subShapeTransforms  .erase(rBody.m_subShapeTransforms.begin() + std::ptrdiff_t(i));
+            changed = true;
+        }
+    }
+
+    osp::IdMap_t<ActiveEnt, std::size_t> subShapeIdx;
+    subShapeIdx.reserve(rBody.m_subShapeEnts.size());
+    for (std::size_t i = 0; i < rBody.m_subShapeEnts.size(); ++i)
+    {
+        subShapeIdx.emplace(rBody.m_subShapeEnts[i], i);
+    }
+
+    // Modify moved sub-shapes, add new ones
+    for (auto const& [colliderEnt, transform] : colliders)
+    {
+        Vec3 const position = Vec3MagnumToJolt(transform.translation());
+        Quat const rotation = QuatMagnumToJolt(osp::Quaternion::fromMatrix(transform.rotation()));
+
+        auto const itSubShape = subShapeIdx.find(colliderEnt);
+        if (itSubShape == subShapeIdx.end())
+        {
+            rCompound.AddShape(position, rotation, collider_shape(rCtxPhys, rCtxWorld, colliderEnt, transform));
+            rBody.m_subShapeEnts        .push_back(colliderEnt);
+            rBody.m_subShapeTransforms  .push_back(transform);
+            changed = true;
+            continue;
+        }
+
+        std::size_t const index = itSubShape->second;
+        Matrix4 &rOldTransform = rBody.m_subShapeTransforms[index];
+        if (rOldTransform == transform)
+        {
+            continue;
+        }
+
+        if (rOldTransform.scaling() != transform.scaling())
+        {
+            // Scaled shapes are shared, so get a new one instead of changing it
+            Ref<Shape> &rShape = rCtxWorld.m_shapes.get(colliderEnt);
+            rShape = create_primitive(rCtxWorld, rCtxPhys.m_shape[colliderEnt], Vec3MagnumToJolt(transform.scaling()));
+            rCompound.ModifyShape(static_cast<uint>(index), position, rotation, rShape);
+        }
+        else
+        {
+            rCompound.ModifyShape(static_cast<uint>(index), position, rotation);
+        }
+        rOldTransform = transform;
+        changed = true;
+    }
+
+    if ( ! changed )
+    {
+        return;
+    }
+
+    PhysicsSystem *pJoltWorld = rCtxWorld.m_pPhysicsSystem.get();
+    JPH::BodyID const joltBodyId = BToJolt(bodyId);
+
+    pJoltWorld->GetBodyInterface().NotifyShapeChanged(joltBodyId, previousCOM, false, EActivation::Activate);
+
+    // Recalculate mass properties the same way as when the body was created.
+    float   totalMass = 0.0f;
+    Vector3 massPos{0.0f};
+    SysPhysics::calculate_subtree_mass_center(rTf, rCtxPhys, rScnGraph, ent, massPos, totalMass);
+
+    if (totalMass <= 0.0f)
+    {
+        return;
+    }
+
+    Vector3 const com = massPos / totalMass;
+    Matrix3 inertiaTensor{0.0f};
+    SysPhysics::calculate_subtree_mass_inertia(rTf, rCtxPhys, rScnGraph, ent, inertiaTensor, Matrix4::translation(-com));
+
+    Matrix4 const inertiaTensorMat4{inertiaTensor};
+
+    MassProperties massProp;
+    massProp.mMass = totalMass;
+    massProp.mInertia = Mat44::sLoadFloat4x4((Float4*) inertiaTensorMat4.data());
+
+    BodyLockWrite lock(pJoltWorld->GetBodyLockInterface(), joltBodyId);
+    if (lock.Succeeded())
+    {
+#if JPH_VERSION_MAJOR >= 4
+        lock.GetBody().GetMotionProperties()->SetMassProperties(EAllowedDOFs::All, massProp);
+#else
+        lock.GetBody().GetMotionProperties()->SetMassProperties(massProp);
+#endif
+    }
+}
+
 void SysJolt::find_shapes_recurse(
         ACtxPhysics const&                      rCtxPhys,
         ACtxJoltWorld&                          rCtxWorld,
@@ -217,41 +1204,303 @@ void SysJolt::find_shapes_recurse(
 
 }
 
-//TODO this is locking on all bodies. Is it bad ?
-//The easy fix is to provide multiple step listeners for disjoint sets of bodies, which can then run in parallel.
-//It might not be worth it considering this function should be quite fast.
+void BodyActivationListenerImpl::OnBodyActivated(BodyID const& inBodyID, uint64 inBodyUserData)
+{
+    std::lock_guard<std::mutex> lock{m_context->m_activationMutex};
+    m_context->m_activationEvents.emplace_back(inBodyID, true);
+}
+
+void BodyActivationListenerImpl::OnBodyDeactivated(BodyID const& inBodyID, uint64 inBodyUserData)
+{
+    std::lock_guard<std::mutex> lock{m_context->m_activationMutex};
+    m_context->m_activationEvents.emplace_back(inBodyID, false);
+}
+
+static float inverse_mass(Body const& body) noexcept
+{
+    return body.IsDynamic() ? body.GetMotionProperties()->GetInverseMass() : 0.0f;
+}
+
+TempAllocatorLarge::TempAllocatorLarge(uint const size)
+ : m_pBase{static_cast<std::uint8_t*>(osp::large_alloc(size, JPH_RVECTOR_ALIGNMENT, smc_subsystem))}
+ , m_size{size}
+{ }
+
+TempAllocatorLarge::~TempAllocatorLarge()
+{
+    LGRN_ASSERTM(m_top == 0, "Jolt temp allocations still in use");
+    osp::large_free(m_pBase, m_size, JPH_RVECTOR_ALIGNMENT, smc_subsystem);
+}
+
+void* TempAllocatorLarge::Allocate(uint const inSize)
+{
+    if (inSize == 0)
+    {
+        return nullptr;
+    }
+
+    uint const newTop = m_top + AlignUp(inSize, JPH_RVECTOR_ALIGNMENT);
+    if (newTop > m_size)
+    {
+        // More than JoltWorldConfig::m_tempAllocatorSize is needed this step
+        return AlignedAllocate(inSize, JPH_RVECTOR_ALIGNMENT);
+    }
+
+    void *const pData = m_pBase + m_top;
+    m_top = newTop;
+    return pData;
+}
+
+void TempAllocatorLarge::Free(void* const inAddress, uint const inSize)
+{
+    if (inAddress == nullptr)
+    {
+        return;
+    }
+
+    auto *const pBytes = static_cast<std::uint8_t*>(inAddress);
+    if (pBytes < m_pBase || pBytes >= m_pBase + m_size)
+    {
+        AlignedFree(inAddress);
+        return;
+    }
+
+    m_top -= AlignUp(inSize, JPH_RVECTOR_ALIGNMENT);
+    LGRN_ASSERTM(m_pBase + m_top == pBytes, "Jolt temp allocations must be freed in reverse order");
+}
+
+void ContactListenerImpl::OnContactAdded(Body const& inBody1, Body const& inBody2, ContactManifold const& inManifold, ContactSettings& ioSettings)
+{
+    osp::active::ContactStream *pContacts = m_context->m_pContacts;
+    if (pContacts == nullptr)
+    {
+        return;
+    }
+
+#if JPH_VERSION_MAJOR >= 3
+    if (inManifold.mRelativeContactPointsOn1.empty())
+    {
+        return;
+    }
+    RVec3 const point = inManifold.GetWorldSpaceContactPointOn1(0);
+#else
+    if (inManifold.mWorldSpaceContactPointsOn1.empty())
+    {
+        return;
+    }
+    RVec3 const point = inManifold.mWorldSpaceContactPointsOn1[0];
+#endif
+
+    // Impulse that would stop the bodies approaching each other along the normal
+    Vec3  const relVelocity = inBody1.GetPointVelocity(point) - inBody2.GetPointVelocity(point);
+    float const speed       = std::abs(relVelocity.Dot(inManifold.mWorldSpaceNormal));
+    float const invMassSum  = inverse_mass(inBody1) + inverse_mass(inBody2);
+    if (speed < osp::active::ContactStream::smc_minSpeed || invMassSum == 0.0f)
+    {
+        return;
+    }
+
+    // Oppose body 1's approach
+    Vec3 const normal = (relVelocity.Dot(inManifold.mWorldSpaceNormal) > 0.0f) ? -inManifold.mWorldSpaceNormal
+                                                                                :  inManifold.mWorldSpaceNormal;
+
+    // No lock needed, bodies aren't added or removed while updating
+    auto const ent_of = [this] (Body const& body)
+    {
+        return SysJolt::find_ent(*m_context, BodyId{body.GetID().GetIndex()});
+    };
+
+    pContacts->append({
+        .m_entA     = ent_of(inBody1),
+        .m_entB     = ent_of(inBody2),
+        .m_point    = Vec3JoltToMagnum(Vec3(point)),
+        .m_impulse  = Vec3JoltToMagnum(normal * (speed / invMassSum)) });
+}
+
+// All bodies are locked while step listeners run. Bodies are split into disjoint ranges that are
+// processed as jobs on our own job system, each range only touching its own bodies through the
+// no-lock body interface.
 void PhysicsStepListenerImpl::OnStep(float inDeltaTime, PhysicsSystem &rPhysicsSystem)
 {
+    OSP_PROFILE_ZONE("PhysicsStepListenerImpl::OnStep");
+
+    ACtxJoltWorld &rCtx = *m_context;
+    ACtxJoltWorld::ForceBatchBuffers &rBuf = rCtx.m_forceBatch;
+
     //no lock as all bodies are already locked
     BodyInterface &bodyInterface = rPhysicsSystem.GetBodyInterfaceNoLock();
-    for (BodyId bodyId : m_context->m_bodyIds)
+
+    // Only dynamic bodies are affected by forces
+    rBuf.m_bodies.clear();
+    for (BodyId bodyId : rCtx.m_bodyIds)
     {
-        JPH::BodyID joltBodyId = BToJolt(bodyId);
-        if (bodyInterface.GetMotionType(joltBodyId) != EMotionType::Dynamic) 
+        // Bodies can be taken out of the world without being destroyed
+        if (   bodyInterface.IsAdded(BToJolt(bodyId))
+            && bodyInterface.GetMotionType(BToJolt(bodyId)) == EMotionType::Dynamic)
         {
-            continue;
+            rBuf.m_bodies.push_back(bodyId);
         }
+    }
+
+    std::size_t const count = rBuf.m_bodies.size();
+    rBuf.m_positions    .resize(count);
+    rBuf.m_velocities   .resize(count);
+    rBuf.m_masses       .resize(count);
+    rBuf.m_forces       .assign(count, Vector3{0.0f});
+    rBuf.m_torques      .assign(count, Vector3{0.0f});
+
+    JobSystem &rJobSystem = *rCtx.m_joltJobSystem;
+
+    std::size_t const maxRanges  = std::max(rJobSystem.GetMaxConcurrency(), 1);
+    std::size_t const rangeCount = std::clamp<std::size_t>(count / smc_minBodiesPerRange, 1, maxRanges);
+
+    rBuf.m_factorIndices.resize(rangeCount * (rCtx.m_factors.size() + rCtx.m_fusedFactors.size()));
+
+    if (rangeCount == 1)
+    {
+        accumulate_range(rPhysicsSystem, 0, 1);
+        return;
+    }
+
+    // Barrier::Wait runs queued jobs of this barrier itself, so waiting from within a physics
+    // job can't starve the pool
+    JobSystem::Barrier *pBarrier = rJobSystem.CreateBarrier();
+    for (std::size_t range = 1; range < rangeCount; ++range)
+    {
+        JobHandle handle = rJobSystem.CreateJob("OSP Force Factors", Color::sGreen,
+                [this, &rPhysicsSystem, range, rangeCount] ()
+        {
+            accumulate_range(rPhysicsSystem, range, rangeCount);
+        });
+        pBarrier->AddJob(handle);
+    }
+
+    accumulate_range(rPhysicsSystem, 0, rangeCount);
+
+    rJobSystem.WaitForJobs(pBarrier);
+    rJobSystem.DestroyBarrier(pBarrier);
+}
+
+void PhysicsStepListenerImpl::accumulate_range(PhysicsSystem &rPhysicsSystem, std::size_t const range, std::size_t const rangeCount) noexcept
+{
+    ACtxJoltWorld &rCtx = *m_context;
+    ACtxJoltWorld::ForceBatchBuffers &rBuf = rCtx.m_forceBatch;
+
+    BodyInterface &bodyInterface = rPhysicsSystem.GetBodyInterfaceNoLock();
 
-        //Transform jolt -> osp
+    std::size_t const count         = rBuf.m_bodies.size();
+    std::size_t const first         = count * range / rangeCount;
+    std::size_t const last          = count * (range + 1) / rangeCount;
+    std::size_t const factorCount   = rCtx.m_factors.size();
+    std::size_t const fusedCount    = rCtx.m_fusedFactors.size();
 
+    // Per factor in m_factors, followed by per fused factor in m_fusedFactors
+    osp::ArrayView< std::vector<std::uint32_t> > const rangeIndices
+            {rBuf.m_factorIndices.data() + range * (factorCount + fusedCount), factorCount + fusedCount};
+    for (std::vector<std::uint32_t> &rIndices : rangeIndices)
+    {
+        rIndices.clear();
+    }
+
+    // Gather body state into the SoA arrays, and sort bodies into each factor they use.
+    // Transforms are read back after the update, see SysJolt::update_world
+    for (std::size_t i = first; i < last; ++i)
+    {
+        BodyId const        bodyId      = rBuf.m_bodies[i];
+        JPH::BodyID const   joltBodyId  = BToJolt(bodyId);
+        float const         invMass     = SysJolt::get_inverse_mass_no_lock(rPhysicsSystem, bodyId);
 
-        ActiveEnt const ent = m_context->m_bodyToEnt[bodyId];
-        Mat44 worldTranform = bodyInterface.GetWorldTransform(joltBodyId);
+        rBuf.m_positions[i]     = Vec3JoltToMagnum(bodyInterface.GetCenterOfMassPosition(joltBodyId));
+        rBuf.m_velocities[i]    = Vec3JoltToMagnum(bodyInterface.GetLinearVelocity(joltBodyId));
+        rBuf.m_masses[i]        = (invMass == 0.0f) ? 0.0f : 1.0f / invMass;
+
+        // find, not operator[]; other ranges read m_bodyFactors concurrently
+        auto const itFactors = rCtx.m_bodyFactors.find(bodyId);
+        if (itFactors == rCtx.m_bodyFactors.end())
+        {
+            continue;
+        }
 
-        worldTranform.StoreFloat4x4((Float4*)m_context->m_pTransform->get(ent).m_transform.data());
+        ForceFactors_t remaining = itFactors->second;
 
-        //Force and torque osp -> jolt
-        Vector3 force{0.0f};
-        Vector3 torque{0.0f};
+        // Bodies using all factors of a fused factor are evaluated by it instead
+        for (std::size_t fusedIdx = 0; fusedIdx < fusedCount; ++fusedIdx)
+        {
+            ForceFactors_t const& mask = rCtx.m_fusedFactors[fusedIdx].m_mask;
+            bool const hasAll = std::equal(mask.begin(), mask.end(), remaining.begin(),
+                                           [] (std::uint64_t const m, std::uint64_t const r) { return (m & r) == m; });
+            if (hasAll)
+            {
+                rangeIndices[factorCount + fusedIdx].push_back(static_cast<std::uint32_t>(i));
+                for (std::size_t word = 0; word < remaining.size(); ++word)
+                {
+                    remaining[word] &= ~mask[word];
+                }
+                break;
+            }
+        }
 
-        auto factorBits = lgrn::bit_view(m_context->m_bodyFactors[bodyId]);
+        auto factorBits = lgrn::bit_view(remaining);
         for (std::size_t const factorIdx : factorBits.ones())
-        {   
-            ACtxJoltWorld::ForceFactorFunc const& factor = m_context->m_factors[factorIdx];
-            factor.m_func(bodyId, *m_context, factor.m_userData, force, torque);
+        {
+            rangeIndices[factorIdx].push_back(static_cast<std::uint32_t>(i));
+        }
+    }
+
+    auto const make_batch = [&rBuf, count] (std::vector<std::uint32_t> const &rIndices) -> ForceFactorBatch
+    {
+        return {
+            .m_indices      = {rIndices.data(),             rIndices.size()},
+            .m_bodies       = {rBuf.m_bodies.data(),        count},
+            .m_positions    = {rBuf.m_positions.data(),     count},
+            .m_velocities   = {rBuf.m_velocities.data(),    count},
+            .m_masses       = {rBuf.m_masses.data(),        count},
+            .m_forces       = {rBuf.m_forces.data(),        count},
+            .m_torques      = {rBuf.m_torques.data(),       count}
+        };
+    };
+
+    for (std::size_t fusedIdx = 0; fusedIdx < fusedCount; ++fusedIdx)
+    {
+        std::vector<std::uint32_t> const &rIndices = rangeIndices[factorCount + fusedIdx];
+        if ( ! rIndices.empty() )
+        {
+            ACtxJoltWorld::FusedForceFactor const& fused = rCtx.m_fusedFactors[fusedIdx];
+            fused.m_func(make_batch(rIndices), rCtx, {fused.m_userData.data(), fused.m_userData.size()});
+        }
+    }
+
+    // Evaluate each factor once over all of its bodies in this range
+    for (std::size_t factorIdx = 0; factorIdx < factorCount; ++factorIdx)
+    {
+        std::vector<std::uint32_t> const &rIndices = rangeIndices[factorIdx];
+        if (rIndices.empty())
+        {
+            continue;
         }
-        Vec3 vel = bodyInterface.GetLinearVelocity(joltBodyId);
 
-        bodyInterface.AddForceAndTorque(joltBodyId, Vec3MagnumToJolt(force), Vec3MagnumToJolt(torque));
+        ACtxJoltWorld::ForceFactorFunc const& factor = rCtx.m_factors[factorIdx];
+
+        if (factor.m_batchFunc != nullptr)
+        {
+            factor.m_batchFunc(make_batch(rIndices), rCtx, factor.m_userData);
+        }
+        else
+        {
+            // Fallback for factors that only provide a per-body function
+            for (std::uint32_t const index : rIndices)
+            {
+                factor.m_func(rBuf.m_bodies[index], rCtx, factor.m_userData,
+                              rBuf.m_forces[index], rBuf.m_torques[index]);
+            }
+        }
+    }
+
+    //Force and torque osp -> jolt
+    for (std::size_t i = first; i < last; ++i)
+    {
+        bodyInterface.AddForceAndTorque(BToJolt(rBuf.m_bodies[i]),
+                                        Vec3MagnumToJolt(rBuf.m_forces[i]),
+                                        Vec3MagnumToJolt(rBuf.m_torques[i]));
     }
 }
\ No newline at end of file
@@ -30,7 +30,13 @@
 #include <osp/activescene/basic.h>
 #include <osp/activescene/physics.h>
 
+#include <osp/core/Resources.h>
+
+#include <cstddef>
+#include <vector>
+
 #include <Corrade/Containers/ArrayView.h>
+#include <Corrade/Containers/StridedArrayView.h>
 
 // IWYU pragma: no_include <cstdint>
 // IWYU pragma: no_include <stdint.h>
@@ -50,43 +56,191 @@ public:
 
     static void resize_body_data(ACtxJoltWorld& rCtxWorld);
 
+    /**
+     * @brief Associate a body and an entity with each other
+     *
+     * Call resize_body_data first after creating the BodyId.
+     */
+    static void set_body_ent(ACtxJoltWorld& rCtxWorld, BodyId bodyId, ActiveEnt ent);
+
+    /**
+     * @return Body of an entity, or null if it has none
+     */
+    [[nodiscard]] static BodyId find_body(ACtxJoltWorld const& rCtxWorld, ActiveEnt const ent) noexcept
+    {
+        return (std::size_t(ent) < rCtxWorld.m_entToBody.size()) ? rCtxWorld.m_entToBody[ent]
+                                                                  : lgrn::id_null<BodyId>();
+    }
+
+    /**
+     * @return Entity of a body, or null if it has none
+     */
+    [[nodiscard]] static ActiveEnt find_ent(ACtxJoltWorld const& rCtxWorld, BodyId const bodyId) noexcept
+    {
+        return (std::size_t(bodyId) < rCtxWorld.m_bodyToEnt.size()) ? rCtxWorld.m_bodyToEnt[bodyId]
+                                                                     : lgrn::id_null<ActiveEnt>();
+    }
+
+    /**
+     * @brief Get a JobSystemThreadPool to share between all worlds that are given it
+     *
+     * The pool is created on first use and kept alive by the worlds holding it, so multiple
+     * worlds can step in parallel without each starting its own set of threads.
+     *
+     * Each call counts as one world. Every world stepping at once takes one of the pool's
+     * cMaxPhysicsBarriers barriers, so once that many worlds hold a pool, the next call starts
+     * another pool instead of letting concurrent PhysicsSystem::Update calls run out of barriers.
+     *
+     * @param threadCount   [in] Worker threads if a new pool is created, -1 for one less than
+     *                           the hardware threads
+     */
+    [[nodiscard]] static std::shared_ptr<JobSystem> shared_job_system(int threadCount = -1);
+
     /**
      * @brief Respond to scene origin shifts by translating all rigid bodies
      *
+     * Sleeping bodies are not woken up, and are left out of the transforms read back by
+     * update_world. Their transforms in rTf are translated here instead.
+     *
      * @param rCtxPhys      [ref] Generic physics context with m_originTranslate
      * @param rCtxWorld     [ref] Jolt World
+     * @param rTf           [ref] Relative transforms used by rigid bodies
+     * @param pTfDirty      [out] Optional transform dirty flags, set for translated sleeping bodies
      */
     static void update_translate(
-            ACtxPhysics& rCtxPhys,
-            ACtxJoltWorld& rCtxWorld) noexcept;
+            ACtxPhysics&                            rCtxPhys,
+            ACtxJoltWorld&                          rCtxWorld,
+            osp::active::ACompTransformStorage_t&   rTf,
+            osp::KeyedVec<ActiveEnt, uint8_t>*      pTfDirty = nullptr) noexcept;
 
     /**
      * @brief Step the entire Jolt World forward in time
      *
+     * With a fixed rate set in JoltWorldConfig, timestep is accumulated and the world is stepped
+     * in fixed steps, up to a limit per call. Transforms are then interpolated between the last
+     * two steps by the time left over, if enabled.
+     *
      * @param rCtxPhys      [ref] Generic Physics context. Updates linear and angular velocity.
      * @param rCtxWorld     [ref] Jolt world to update
-     * @param timestep      [in] Time to step world, passed to Jolt update
+     * @param timestep      [in] Time to step world, or time passed if using a fixed rate
      * @param rTf           [ref] Relative transforms used by rigid bodies
+     * @param pTfDirty      [out] Optional transform dirty flags, set for bodies that moved
      */
     static void update_world(
             ACtxPhysics&                            rCtxPhys,
             ACtxJoltWorld&                          rCtxWorld,
             float                                   timestep,
-            osp::active::ACompTransformStorage_t&   rTf) noexcept;
+            osp::active::ACompTransformStorage_t&   rTf,
+            osp::KeyedVec<ActiveEnt, uint8_t>*      pTfDirty = nullptr) noexcept;
+
+    /**
+     * @brief Apply queued activation events to ACtxJoltWorld::m_awakeBodies, and list bodies that
+     *        fell asleep in ACtxJoltWorld::m_fellAsleep. Called by update_world.
+     */
+    static void update_awake(ACtxJoltWorld& rCtxWorld) noexcept;
+
+    /**
+     * @brief Answer all rays in ACtxPhysics::m_rays with the narrow phase query
+     *
+     * Rays are split into ranges cast in parallel on the world's job system. Must not be called
+     * while the world is updating.
+     */
+    static void update_raycasts(ACtxJoltWorld& rCtxWorld, osp::active::RaycastQueries& rRays) noexcept;
+
+    /// Fewest rays worth handing to a separate job
+    static constexpr std::size_t smc_minRaysPerRange = 32;
+
+    /**
+     * @return True if a body was awake as of the last update_world
+     *
+     * Only valid for bodies that existed during the last update_world.
+     */
+    [[nodiscard]] static bool is_awake(ACtxJoltWorld const& rCtxWorld, BodyId const bodyId) noexcept
+    {
+        return rCtxWorld.m_awakeBodies.contains(bodyId);
+    }
 
     static void remove_components(
             ACtxJoltWorld& rCtxWorld, ActiveEnt ent) noexcept;
 
-    static Ref<Shape> create_primitive(ACtxJoltWorld &rCtxWorld, osp::EShape shape, Vec3Arg scale);
+    /**
+     * @brief Get a primitive shape of a certain scale, shared with all other users of the same
+     *        shape and scale
+     *
+     * Shapes are created on first use and kept in ACtxJoltWorld::m_shapeCache.
+     */
+    static Ref<Shape> create_primitive(ACtxJoltWorld &rCtxWorld, osp::EShape shape, Vec3Arg scale)
+    {
+        return create_primitive(rCtxWorld.m_shapeCache, shape, scale);
+    }
+
+    /**
+     * @brief Get a primitive shape from any shape cache, such as one being baked into
+     *        PrefabShapes before a world exists
+     */
+    static Ref<Shape> create_primitive(ShapeCache_t &rCache, osp::EShape shape, Vec3Arg scale);
+
+    /**
+     * @brief Get a convex hull around a mesh's vertex positions, shared with all other users of
+     *        the same mesh and scale
+     *
+     * @param mesh      [in] Mesh resource the points are from, identifies the hull in the cache
+     * @param points    [in] Vertex positions, only read if the hull isn't cached yet
+     * @param scale     [in] Scale applied on top of the hull
+     */
+    static Ref<Shape> create_convex_hull(
+            ShapeCache_t                                                &rCache,
+            osp::ResId                                                  mesh,
+            Corrade::Containers::StridedArrayView1D<osp::Vector3 const> points,
+            Vec3Arg                                                     scale);
+
+    /**
+     * @brief Get a convex hull around a mesh resource, such as one of ImporterData::m_meshes
+     */
+    static Ref<Shape> create_convex_hull(
+            ShapeCache_t                                                &rCache,
+            osp::Resources const                                        &rResources,
+            osp::ResId                                                  mesh,
+            Vec3Arg                                                     scale);
+
+    static Ref<Shape> create_convex_hull(
+            ACtxJoltWorld                                               &rCtxWorld,
+            osp::ResId                                                  mesh,
+            Corrade::Containers::StridedArrayView1D<osp::Vector3 const> points,
+            Vec3Arg                                                     scale)
+    {
+        return create_convex_hull(rCtxWorld.m_shapeCache, mesh, points, scale);
+    }
+
+    static Ref<Shape> create_convex_hull(
+            ACtxJoltWorld                                               &rCtxWorld,
+            osp::Resources const                                        &rResources,
+            osp::ResId                                                  mesh,
+            Vec3Arg                                                     scale)
+    {
+        return create_convex_hull(rCtxWorld.m_shapeCache, rResources, mesh, scale);
+    }
+
+    /**
+     * @brief Release cached shapes that are no longer used by any body or entity
+     */
+    static void shape_cache_prune(ACtxJoltWorld &rCtxWorld) noexcept;
 
     template<typename IT_T>
     static void update_delete(
             ACtxJoltWorld &rCtxWorld, IT_T first, IT_T const& last) noexcept
     {
+        bool removed = false;
         while (first != last)
         {
             remove_components(rCtxWorld, *first);
             std::advance(first, 1);
+            removed = true;
+        }
+
+        if (removed)
+        {
+            shape_cache_prune(rCtxWorld);
         }
     }
     //Apply a scale to a shape.
@@ -94,9 +248,107 @@ public:
 
     //Get the inverse mass of a jolt body
     static float get_inverse_mass_no_lock(PhysicsSystem& physicsSystem, BodyId bodyId);
-    
+
+    /**
+     * @brief Update a compound body in place to match the colliders currently in its entity's
+     *        hierarchy
+     *
+     * Sub-shapes of entities that left the hierarchy are removed, new colliders are added, and
+     * moved ones are modified. The body and all other sub-shapes are kept, so a part breaking
+     * off a large vehicle doesn't rebuild it. If anything changed, mass and inertia are
+     * recalculated from ACtxPhysics::m_mass. Bodies left without colliders are removed.
+     *
+     * Does nothing for entities without a body in ACtxJoltWorld::m_compounds.
+     */
+    static void update_compound(
+            ACtxPhysics&                            rCtxPhys,
+            ACtxJoltWorld&                          rCtxWorld,
+            ACtxSceneGraph&                         rScnGraph,
+            ACompTransformStorage_t const&          rTf,
+            ActiveEnt                               ent) noexcept;
+
+    /**
+     * @brief Translate a body's force factors from one world's m_factors to another's
+     *
+     * Factor indices differ between worlds, so factors are matched by their functions, preferring
+     * one that also has the same user data. Factors with no match in the destination are dropped.
+     *
+     * @param factors   [in] Factors of a body, indexing into from
+     * @param from      [in] Factors of the world the body is from
+     * @param to        [in] Factors of the world the body is going to
+     *
+     * @return Factors indexing into to
+     */
+    [[nodiscard]] static ForceFactors_t remap_factors(
+            ForceFactors_t                                      factors,
+            std::vector<ACtxJoltWorld::ForceFactorFunc> const&  from,
+            std::vector<ACtxJoltWorld::ForceFactorFunc> const&  to) noexcept;
+
+    /**
+     * @brief Move an entity's body into another world, keeping its shape, mass, velocity, and
+     *        force factors
+     *
+     * For physics scenes with their own floating origins, such as vehicle clusters far apart.
+     * The entities themselves are moved by the caller; entRemap maps each entity in the
+     * source scene to its copy in the destination scene, for the body's entity and the
+     * entities of its colliders. Force factors are matched between worlds with remap_factors.
+     *
+     * @param rFrom     [ref] World the body is removed from
+     * @param rTo       [ref] World the body is added to
+     * @param ent       [in] Entity of the body in the source scene
+     * @param entRemap  [in] Source scene entity to destination scene entity
+     * @param offset    [in] Source scene origin minus destination scene origin
+     *
+     * @return Body in rTo, or null if ent had no body
+     */
+    static BodyId transfer_body(
+            ACtxJoltWorld&                          rFrom,
+            ACtxJoltWorld&                          rTo,
+            ActiveEnt                               ent,
+            osp::ArrayView<ActiveEnt const>         entRemap,
+            osp::Vector3                            offset);
+
+    /**
+     * @brief Save the state of all bodies and the OSP-side body data to a binary blob
+     *
+     * Bodies and shapes are not recreated by restore_snapshot; the world must have the same
+     * bodies when restoring. Entities are not saved, see SysPrefabInit::init_physics for
+     * rebuilding bodies after entities changed.
+     */
+    [[nodiscard]] static std::vector<std::byte> save_snapshot(ACtxJoltWorld const& rCtxWorld);
+
+    /**
+     * @brief Restore a blob written by save_snapshot
+     *
+     * Transforms of entities with bodies are written to rTf and marked in pTfDirty, since an
+     * update_world would only write transforms of bodies that are awake.
+     *
+     * @return False, leaving the world untouched, if the blob is invalid or the world's bodies
+     *         don't match the ones saved
+     */
+    [[nodiscard]] static bool restore_snapshot(
+            ACtxJoltWorld&                          rCtxWorld,
+            osp::ArrayView<std::byte const>         data,
+            ACompTransformStorage_t&                rTf,
+            osp::KeyedVec<ActiveEnt, uint8_t>*      pTfDirty = nullptr);
+
 private:
 
+    /**
+     * @brief Add a sub-shape for a collider entity to a compound body being built, using its
+     *        shape from ACtxJoltWorld::m_shapes or creating one
+     *
+     * @param rCompound     [ref] Settings the compound shape will be created from
+     * @param rBody         [ref] Records the sub-shape, see SysJolt::update_compound
+     */
+    static void compound_add_collider(
+            ACtxPhysics const&                      rCtxPhys,
+            ACtxJoltWorld&                          rCtxWorld,
+            ActiveEnt                               ent,
+            osp::Matrix4 const&                     transform,
+            MutableCompoundShapeSettings&           rCompound,
+            CompoundBody&                           rBody);
+
     /**
      * @brief Find shapes in an entity and its hierarchy, and add them to
      *        a Jolt Compound Shape
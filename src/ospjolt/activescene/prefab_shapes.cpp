@@ -0,0 +1,322 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "prefab_shapes.h"          // IWYU pragma: associated
+#include "joltinteg_fn.h"
+
+#include <osp/core/byte_stream.h>
+#include <osp/core/Resources.h>
+#include <osp/drawing/own_restypes.h>
+#include <osp/util/logging.h>
+#include <osp/vehicles/ImporterData.h>
+
+#include <Jolt/Core/StreamIn.h>
+#include <Jolt/Core/StreamOut.h>
+
+#include <Corrade/Containers/Array.h>
+#include <Corrade/Containers/Optional.h>
+#include <Corrade/Containers/StringStlView.h>
+#include <Corrade/Utility/Path.h>
+
+#include <array>
+#include <cstring>
+#include <string>
+
+using namespace ospjolt;
+
+using osp::EShape;
+using osp::Matrix4;
+using osp::PkgId;
+using osp::PrefabTemplate;
+using osp::Resources;
+using osp::ResId;
+using osp::restypes::gc_importer;
+using osp::restypes::gc_mesh;
+
+using Corrade::Containers::Array;
+using Corrade::Containers::Optional;
+
+namespace Path = Corrade::Utility::Path;
+
+namespace
+{
+
+constexpr std::array<char, 4>   gc_shapeCacheMagic  {'O', 'S', 'P', 'J'};
+
+constexpr std::uint32_t         gc_joltVersion      = (JPH_VERSION_MAJOR << 16) | (JPH_VERSION_MINOR << 8) | JPH_VERSION_PATCH;
+
+struct ShapeCacheHeader
+{
+    std::array<char, 4>     magic;
+    std::uint32_t           version;
+    std::uint32_t           joltVersion;
+    std::uint32_t           shapeCount;
+    std::uint64_t           sourceHash;
+};
+
+/**
+ * @brief Appends everything Jolt writes to a byte vector, the same way osp::append_bytes does
+ */
+class ByteStreamOut final : public StreamOut
+{
+public:
+    explicit ByteStreamOut(std::vector<std::byte> &rOut) noexcept : m_rOut{rOut} { }
+
+    void WriteBytes(void const *inData, size_t inNumBytes) override
+    {
+        osp::append_bytes(m_rOut, inData, inNumBytes);
+    }
+
+    bool IsFailed() const override { return false; }
+
+private:
+    std::vector<std::byte> &m_rOut;
+};
+
+/**
+ * @brief Lets Jolt read from an osp::ByteReader; reads past the end fail the stream
+ */
+class ByteStreamIn final : public StreamIn
+{
+public:
+    explicit ByteStreamIn(osp::ByteReader &rReader) noexcept : m_rReader{rReader} { }
+
+    void ReadBytes(void *outData, size_t inNumBytes) override
+    {
+        if ( ! m_rReader.read(outData, inNumBytes) )
+        {
+            std::memset(outData, 0, inNumBytes);
+            m_failed = true;
+        }
+    }
+
+    bool IsEOF() const override { return m_rReader.remaining().empty(); }
+
+    bool IsFailed() const override { return m_failed; }
+
+private:
+    osp::ByteReader &m_rReader;
+    bool            m_failed{false};
+};
+
+} // namespace
+
+void ospjolt::register_prefab_shapes_resources(Resources &rResources)
+{
+    rResources.data_register<PrefabShapes>(gc_importer);
+}
+
+bool ospjolt::build_prefab_shapes(Resources &rResources, ResId const importer)
+{
+    ACtxJoltWorld::initJoltGlobal();
+
+    auto const *pPrefabs = rResources.data_try_get<osp::Prefabs>(gc_importer, importer);
+    if (pPrefabs == nullptr)
+    {
+        return false;
+    }
+
+    ShapeCache_t cache;
+    std::vector<Matrix4> rootRelative;
+
+    for (PrefabTemplate const& prefab : pPrefabs->m_templates)
+    {
+        // Parents come before their children. The root's transform is where the prefab is
+        // spawned, so colliders are relative to it and the root itself is identity.
+        rootRelative.assign(prefab.size(), Matrix4{});
+        for (std::size_t i = 0; i < prefab.size(); ++i)
+        {
+            int32_t const parent = prefab.parents[i];
+            if (parent != -1)
+            {
+                rootRelative[i] = rootRelative[std::size_t(parent)] * prefab.transforms[i];
+            }
+
+            EShape const shape = prefab.shapes[i];
+            Vec3 const   scale = Vec3MagnumToJolt(rootRelative[i].scaling());
+            if (shape == EShape::Custom)
+            {
+                if (prefab.meshes[i] != lgrn::id_null<ResId>())
+                {
+                    SysJolt::create_convex_hull(cache, rResources, prefab.meshes[i], scale);
+                }
+            }
+            else if (shape != EShape::None)
+            {
+                SysJolt::create_primitive(cache, shape, scale);
+            }
+        }
+    }
+
+    if (cache.empty())
+    {
+        return false;
+    }
+
+    PrefabShapes &rShapes = rResources.data_add<PrefabShapes>(gc_importer, importer);
+    rShapes.m_shapes.assign(cache.begin(), cache.end());
+    return true;
+}
+
+bool ospjolt::save_prefab_shapes(
+        std::string_view        cachePath,
+        std::uint64_t const     sourceHash,
+        Resources const         &rResources,
+        ResId const             importer)
+{
+    auto const *pShapes = rResources.data_try_get<PrefabShapes>(gc_importer, importer);
+    if (pShapes == nullptr)
+    {
+        return false;
+    }
+
+    ShapeCacheHeader const header{
+            gc_shapeCacheMagic, gc_shapeCacheVersion, gc_joltVersion,
+            std::uint32_t(pShapes->m_shapes.size()), sourceHash};
+
+    std::vector<std::byte> file;
+    osp::append_bytes(file, header);
+
+    // Keys first, meshes by name since resource IDs differ between runs
+    for (auto const& [key, pShape] : pShapes->m_shapes)
+    {
+        std::string_view const meshName = (key.m_mesh != lgrn::id_null<ResId>())
+                                        ? std::string_view{rResources.name(gc_mesh, key.m_mesh)}
+                                        : std::string_view{};
+        osp::append_bytes(file, key.m_shape);
+        osp::append_bytes(file, key.m_scale);
+        osp::append_bytes(file, std::uint32_t(meshName.size()));
+        osp::append_bytes(file, meshName.data(), meshName.size());
+    }
+
+    ByteStreamOut stream{file};
+    Shape::ShapeToIDMap     shapeMap;
+    Shape::MaterialToIDMap  materialMap;
+    for (auto const& [key, pShape] : pShapes->m_shapes)
+    {
+        pShape->SaveWithChildren(stream, shapeMap, materialMap);
+    }
+
+    return Path::write(cachePath, Corrade::Containers::ArrayView<void const>{file.data(), file.size()});
+}
+
+bool ospjolt::load_prefab_shapes(
+        std::string_view        cachePath,
+        std::uint64_t const     sourceHash,
+        Resources               &rResources,
+        ResId const             importer,
+        PkgId const             pkg)
+{
+    if ( ! Path::exists(cachePath) )
+    {
+        return false;
+    }
+
+    Optional<Array<char>> const data = Path::read(cachePath);
+    if ( ! bool(data) )
+    {
+        return false;
+    }
+
+    ACtxJoltWorld::initJoltGlobal();
+
+    osp::ByteReader reader{{reinterpret_cast<std::byte const*>(data->data()), data->size()}};
+
+    ShapeCacheHeader header;
+    if (   ! reader.read(header)
+        || header.magic         != gc_shapeCacheMagic
+        || header.version       != gc_shapeCacheVersion
+        || header.joltVersion   != gc_joltVersion
+        || header.sourceHash    != sourceHash)
+    {
+        return false;
+    }
+
+    PrefabShapes shapes;
+    shapes.m_shapes.resize(header.shapeCount);
+
+    std::string meshName;
+    for (auto& [rKey, rShape] : shapes.m_shapes)
+    {
+        std::uint32_t nameSize = 0;
+        if (   ! reader.read(rKey.m_shape)
+            || ! reader.read(rKey.m_scale)
+            || ! reader.read(nameSize)
+            || nameSize > reader.remaining().size() )
+        {
+            return false;
+        }
+
+        meshName.resize(nameSize);
+        if ( ! reader.read(meshName.data(), nameSize) )
+        {
+            return false;
+        }
+
+        if (nameSize != 0)
+        {
+            rKey.m_mesh = rResources.find(gc_mesh, pkg, meshName);
+            if (rKey.m_mesh == lgrn::id_null<ResId>())
+            {
+                OSP_LOG_INFO("Not using shape cache {}: mesh {} not found", cachePath, meshName);
+                return false;
+            }
+        }
+    }
+
+    ByteStreamIn stream{reader};
+    Shape::IDToShapeMap     shapeMap;
+    Shape::IDToMaterialMap  materialMap;
+    for (auto& [rKey, rShape] : shapes.m_shapes)
+    {
+        Shape::ShapeResult const result = Shape::sRestoreWithChildren(stream, shapeMap, materialMap);
+        if (result.HasError() || stream.IsFailed())
+        {
+            OSP_LOG_WARN("Failed to restore shape from {}: {}", cachePath,
+                         result.HasError() ? result.GetError().c_str() : "unexpected end of file");
+            return false;
+        }
+        rShape = result.Get();
+    }
+
+    rResources.data_add<PrefabShapes>(gc_importer, importer, std::move(shapes));
+    return true;
+}
+
+void ospjolt::seed_shape_cache(ACtxJoltWorld &rCtxWorld, Resources const &rResources)
+{
+    for (ResId const importer : rResources.ids(gc_importer))
+    {
+        auto const *pShapes = rResources.data_try_get<PrefabShapes>(gc_importer, importer);
+        if (pShapes == nullptr)
+        {
+            continue;
+        }
+
+        for (auto const& [key, pShape] : pShapes->m_shapes)
+        {
+            rCtxWorld.m_shapeCache.try_emplace(key, pShape);
+        }
+    }
+}
@@ -0,0 +1,120 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+/**
+ * @file
+ * @brief Collision shapes of an importer's prefabs, created before anything is spawned and kept
+ *        in a binary cache file beside the source
+ *
+ * Spawning a prefab otherwise creates its shapes on the frame thread the first time each shape
+ * and scale is seen, which is noticeable for convex hulls. Shapes in PrefabShapes are put into
+ * each ACtxJoltWorld::m_shapeCache by seed_shape_cache, so spawning only ever hits the cache.
+ */
+#pragma once
+
+#include "joltinteg.h"
+
+#include <osp/core/resourcetypes.h>
+
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace ospjolt
+{
+
+/**
+ * @brief Version of the shape cache format
+ *
+ * Increment whenever the layout changes, old caches are then rebaked. The Jolt version is
+ * checked separately, since shapes are stored in the binary state format of the Jolt they were
+ * saved with.
+ */
+constexpr std::uint32_t gc_shapeCacheVersion = 1;
+
+/**
+ * @brief Shapes used by an importer's prefabs, added to the importer resource
+ *
+ * Holding a reference to each shape keeps them from being released by
+ * SysJolt::shape_cache_prune while no body uses them.
+ */
+struct PrefabShapes
+{
+    std::vector< std::pair<ShapeCacheKey, Ref<Shape>> > m_shapes;
+};
+
+void register_prefab_shapes_resources(osp::Resources &rResources);
+
+/**
+ * @brief Create the shapes of every collider in an importer's prefabs
+ *
+ * Each collider gets the scale it has relative to its prefab's root, which is what a body sees
+ * when the prefab is spawned at unit scale. Prefabs spawned scaled still create their shapes on
+ * first use. Convex hulls (EShape::Custom) are made around the object's mesh.
+ *
+ * Calls ACtxJoltWorld::initJoltGlobal, since no world may exist yet.
+ *
+ * @return true if PrefabShapes was added to the importer, false if it has no prefabs with shapes
+ */
+bool build_prefab_shapes(osp::Resources &rResources, osp::ResId importer);
+
+/**
+ * @brief Write an importer's PrefabShapes to a cache file, with Shape::SaveWithChildren
+ *
+ * Children such as the hull inside each scaled hull are stored once and shared again on load.
+ *
+ * @param sourceHash    [in] Hash of the importer's source, see osp::asset_source_hash
+ *
+ * @return true if the cache was written
+ */
+bool save_prefab_shapes(
+        std::string_view        cachePath,
+        std::uint64_t           sourceHash,
+        osp::Resources const    &rResources,
+        osp::ResId              importer);
+
+/**
+ * @brief Add PrefabShapes to an importer resource from a cache file written by save_prefab_shapes
+ *
+ * Hulls are matched back to their meshes by name, looked up in pkg.
+ *
+ * @return false if the cache is missing, corrupt, its versions or source hash don't match, or
+ *         one of its meshes can't be found. Nothing is added on failure.
+ */
+[[nodiscard]] bool load_prefab_shapes(
+        std::string_view        cachePath,
+        std::uint64_t           sourceHash,
+        osp::Resources          &rResources,
+        osp::ResId              importer,
+        osp::PkgId              pkg);
+
+/**
+ * @brief Add the PrefabShapes of every importer to a world's shape cache
+ *
+ * Call once after the world is created. Safe to call again, shapes already cached are kept.
+ */
+void seed_shape_cache(ACtxJoltWorld &rCtxWorld, osp::Resources const &rResources);
+
+} // namespace ospjolt
@@ -27,6 +27,8 @@
 #include "forcefactors.h"
 
 #include <osp/activescene/basic.h>
+#include <osp/activescene/physics.h>
+#include <osp/core/array_view.h>
 #include <osp/core/id_map.h>
 
 #include <Newton.h>
@@ -60,6 +62,28 @@ using BodyId = uint32_t;
 
 using ColliderStorage_t = osp::Storage_t<osp::active::ActiveEnt, NwtColliderPtr_t>;
 
+/**
+ * @brief Dynamic bodies passed to ForceFactorFunc::m_batchFunc, in SoA form
+ *
+ * All arrays except m_indices have one element per dynamic body in the world. A factor only
+ * evaluates bodies listed in m_indices, and adds to their m_forces and m_torques.
+ */
+struct ForceFactorBatch
+{
+    /// Indices into the arrays below of bodies that use this factor, ascending
+    osp::ArrayView<std::uint32_t const>     m_indices;
+
+    osp::ArrayView<BodyId const>            m_bodies;
+
+    /// Center of mass positions
+    osp::ArrayView<osp::Vector3 const>      m_positions;
+    osp::ArrayView<osp::Vector3 const>      m_velocities;
+    osp::ArrayView<float const>             m_masses;
+
+    osp::ArrayView<osp::Vector3>            m_forces;
+    osp::ArrayView<osp::Vector3>            m_torques;
+};
+
 /**
  * @brief Represents an instance of a Newton physics world in the scane
  */
@@ -70,9 +94,38 @@ struct ACtxNwtWorld
     {
         using UserData_t = std::array<void*, 6u>;
         using Func_t = void (*)(NewtonBody const* pBody, BodyId BodyId, ACtxNwtWorld const&, UserData_t, osp::Vector3&, osp::Vector3&) noexcept;
+        using BatchFunc_t = void (*)(ForceFactorBatch const&, ACtxNwtWorld const&, UserData_t) noexcept;
 
-        Func_t      m_func;
-        UserData_t  m_userData;
+        /// Evaluates a single body, only used if m_batchFunc is null
+        Func_t      m_func{nullptr};
+
+        /// Optional; evaluates all bodies that use this factor in one call
+        BatchFunc_t m_batchFunc{nullptr};
+        UserData_t  m_userData{nullptr};
+    };
+
+    /**
+     * @brief Buffers reused by SysNewton::update_world to build ForceFactorBatch
+     *
+     * Forces are evaluated before NewtonUpdate, then SysNewton::cb_force_torque only looks up
+     * the results of its body through m_bodyToBatch.
+     */
+    struct ForceBatchBuffers
+    {
+        std::vector<BodyId>                     m_bodies;
+        std::vector<osp::Vector3>               m_positions;
+        std::vector<osp::Vector3>               m_velocities;
+        std::vector<float>                      m_masses;
+        std::vector<osp::Vector3>               m_forces;
+        std::vector<osp::Vector3>               m_torques;
+
+        /// Indices into the arrays above for each factor in m_factors
+        std::vector< std::vector<std::uint32_t> > m_factorIndices;
+
+        /// Index into the arrays above for each BodyId, or smc_noBatch if not gathered
+        std::vector<std::uint32_t>              m_bodyToBatch;
+
+        static constexpr std::uint32_t          smc_noBatch = ~std::uint32_t(0);
     };
 
     struct Deleter
@@ -80,11 +133,11 @@ struct ACtxNwtWorld
         void operator() (NewtonWorld* pNwtWorld) { NewtonDestroy(pNwtWorld); }
     };
 
-    ACtxNwtWorld(int threadCount)
-     : m_world(NewtonCreate())
-    {
-        NewtonWorldSetUserData(m_world.get(), this);
-    }
+    /**
+     * @param threadCount [in] Threads Newton solves with. Less than 1 for one less than the
+     *                         hardware threads, leaving one for the rest of the frame.
+     */
+    explicit ACtxNwtWorld(int threadCount);
 
     // note: important that m_nwtBodies and m_nwtColliders are destructed
     //       before m_nwtWorld
@@ -95,14 +148,24 @@ struct ACtxNwtWorld
     std::vector<ForceFactors_t>                     m_bodyFactors;
     lgrn::IdSetStl<BodyId>                          m_bodyDirty;
 
+    /// Null for unused IDs. Sized by SysNewton::resize_body_data
     std::vector<osp::active::ActiveEnt>             m_bodyToEnt;
-    osp::IdMap_t<osp::active::ActiveEnt, BodyId>    m_entToBody;
+
+    /// Null for entities without a body. Grows in SysNewton::set_body_ent
+    osp::KeyedVec<osp::active::ActiveEnt, BodyId>   m_entToBody;
 
     std::vector<ForceFactorFunc>                    m_factors;
+    ForceBatchBuffers                               m_forceBatch;
 
     ColliderStorage_t                               m_colliders;
 
     osp::active::ACompTransformStorage_t            *m_pTransform;
+
+    /// Optional; bodies that moved are marked here. See ACtxSceneGraph::m_transformDirty
+    osp::KeyedVec<osp::active::ActiveEnt, uint8_t>  *m_pTransformDirty{nullptr};
+
+    /// Contacts are appended here while updating, set from ACtxPhysics::m_contacts
+    osp::active::ContactStream                      *m_pContacts{nullptr};
 };
 
 
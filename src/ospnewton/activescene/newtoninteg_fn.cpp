@@ -26,9 +26,15 @@
 #include "newtoninteg_fn.h"          // IWYU pragma: associated
 
 #include <osp/activescene/basic_fn.h>
+#include <osp/activescene/physics_fn.h>
+#include <osp/core/byte_stream.h>
+#include <osp/util/profiling.h>
 
 #include <Newton.h>                  // for NewtonBodySetCollision
 
+#include <algorithm>                 // for std::max
+#include <cmath>                     // for std::abs
+#include <thread>                    // for std::thread::hardware_concurrency
 #include <utility>                   // for std::exchange
 #include <cassert>                   // for assert
 
@@ -44,6 +50,8 @@ using osp::EShape;
 
 using osp::active::ActiveEnt;
 using osp::active::ACtxPhysics;
+using osp::active::RaycastQueries;
+using osp::active::SysPhysics;
 using osp::active::SysSceneGraph;
 
 using osp::Matrix3;
@@ -58,19 +66,20 @@ void SysNewton::cb_force_torque(
     ACtxNwtWorld &rWorldCtx = SysNewton::context_from_nwtbody(pBody);
     BodyId const bodyId     = SysNewton::get_userdata_bodyid(pBody);
 
-    Vector3 force{0.0f};
-    Vector3 torque{0.0f};
+    // Forces were already evaluated for all bodies by update_world
+    ACtxNwtWorld::ForceBatchBuffers const &rBuf = rWorldCtx.m_forceBatch;
 
-    auto factorBits = lgrn::bit_view(rWorldCtx.m_bodyFactors[bodyId]);
-    for (std::size_t const factorIdx : factorBits.ones())
+    std::uint32_t const index = rBuf.m_bodyToBatch[bodyId];
+    if (index == ACtxNwtWorld::ForceBatchBuffers::smc_noBatch)
     {
-        ACtxNwtWorld::ForceFactorFunc const& factor = rWorldCtx.m_factors[factorIdx];
-
-        factor.m_func(pBody, bodyId, rWorldCtx, factor.m_userData, force, torque);
+        Vector3 const zero{0.0f};
+        NewtonBodySetForce(pBody, zero.data());
+        NewtonBodySetTorque(pBody, zero.data());
+        return;
     }
 
-    NewtonBodySetForce(pBody, force.data());
-    NewtonBodySetTorque(pBody, torque.data());
+    NewtonBodySetForce(pBody, rBuf.m_forces[index].data());
+    NewtonBodySetTorque(pBody, rBuf.m_torques[index].data());
 } // cb_force_torque()
 
 void SysNewton::cb_set_transform(
@@ -82,17 +91,218 @@ void SysNewton::cb_set_transform(
     ActiveEnt const ent = rWorldCtx.m_bodyToEnt[bodyId];
 
     NewtonBodyGetMatrix(pBody, rWorldCtx.m_pTransform->get(ent).m_transform.data());
+
+    // Newton only calls this for bodies that moved. Callbacks from different threads are for
+    // different bodies, so writing separate bytes is safe.
+    if (rWorldCtx.m_pTransformDirty != nullptr)
+    {
+        (*rWorldCtx.m_pTransformDirty)[ent] = 1;
+    }
 } // cb_set_transform()
 
 
+void SysNewton::cb_contacts(
+        NewtonJoint const* pContactJoint, dFloat const timestep, NwtThreadIndex_t const thread)
+{
+    NewtonBody const *pBodyA = NewtonJointGetBody0(pContactJoint);
+    NewtonBody const *pBodyB = NewtonJointGetBody1(pContactJoint);
+
+    ACtxNwtWorld &rWorldCtx = SysNewton::context_from_nwtbody(pBodyA);
+    if (rWorldCtx.m_pContacts == nullptr)
+    {
+        return;
+    }
+
+    Vector3 velA;
+    Vector3 velB;
+    NewtonBodyGetVelocity(pBodyA, velA.data());
+    NewtonBodyGetVelocity(pBodyB, velB.data());
+
+    // Pick the fastest approaching point, one contact is reported per pair of bodies
+    float   bestSpeed = osp::active::ContactStream::smc_minSpeed;
+    Vector3 bestPoint;
+    Vector3 bestNormal;
+    bool    found = false;
+    for (void *pContact = NewtonContactJointGetFirstContact(pContactJoint);
+         pContact != nullptr;
+         pContact = NewtonContactJointGetNextContact(pContactJoint, pContact))
+    {
+        NewtonMaterial const *pMaterial = NewtonContactGetMaterial(pContact);
+        float const speed = std::abs(NewtonMaterialGetContactNormalSpeed(pMaterial));
+        if (speed >= bestSpeed)
+        {
+            NewtonMaterialGetContactPositionAndNormal(pMaterial, pBodyA, bestPoint.data(), bestNormal.data());
+            bestSpeed   = speed;
+            found       = true;
+        }
+    }
+
+    if ( ! found )
+    {
+        return;
+    }
+
+    // Impulse that would stop the bodies approaching each other along the normal
+    float invMassA;
+    float invMassB;
+    float ixx, iyy, izz;
+    NewtonBodyGetInvMass(pBodyA, &invMassA, &ixx, &iyy, &izz);
+    NewtonBodyGetInvMass(pBodyB, &invMassB, &ixx, &iyy, &izz);
+    float const invMassSum = invMassA + invMassB;
+    if (invMassSum == 0.0f)
+    {
+        return;
+    }
+
+    // Oppose A's approach
+    Vector3 const normal = (Magnum::Math::dot(velA - velB, bestNormal) > 0.0f) ? -bestNormal : bestNormal;
+
+    rWorldCtx.m_pContacts->append({
+        .m_entA     = rWorldCtx.m_bodyToEnt[get_userdata_bodyid(pBodyA)],
+        .m_entB     = rWorldCtx.m_bodyToEnt[get_userdata_bodyid(pBodyB)],
+        .m_point    = bestPoint,
+        .m_impulse  = normal * (bestSpeed / invMassSum) });
+} // cb_contacts()
+
+ACtxNwtWorld::ACtxNwtWorld(int threadCount)
+ : m_world(NewtonCreate())
+{
+    NewtonWorldSetUserData(m_world.get(), this);
+
+    if (threadCount < 1)
+    {
+        threadCount = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+    }
+
+    // Callbacks may now be called from any of these threads
+    NewtonSetThreadsCount(m_world.get(), threadCount);
+
+    int const defaultGroup = NewtonMaterialGetDefaultGroupID(m_world.get());
+    NewtonMaterialSetCollisionCallback(m_world.get(), defaultGroup, defaultGroup, nullptr, &SysNewton::cb_contacts);
+}
+
 void SysNewton::resize_body_data(ACtxNwtWorld& rCtxWorld)
 {
     std::size_t const capacity = rCtxWorld.m_bodyIds.capacity();
     rCtxWorld.m_bodyPtrs    .resize(capacity);
-    rCtxWorld.m_bodyToEnt   .resize(capacity);
+    rCtxWorld.m_bodyToEnt   .resize(capacity, lgrn::id_null<ActiveEnt>());
     rCtxWorld.m_bodyFactors .resize(capacity);
+    rCtxWorld.m_forceBatch.m_bodyToBatch.resize(capacity, ACtxNwtWorld::ForceBatchBuffers::smc_noBatch);
+}
+
+void SysNewton::set_body_ent(ACtxNwtWorld& rCtxWorld, BodyId const bodyId, ActiveEnt const ent)
+{
+    if (std::size_t(ent) >= rCtxWorld.m_entToBody.size())
+    {
+        // Grow geometrically, entities are created one at a time
+        std::size_t const size = std::max(std::size_t(ent) + 1, rCtxWorld.m_entToBody.size() * 2);
+        rCtxWorld.m_entToBody.resize(size, lgrn::id_null<BodyId>());
+    }
+    rCtxWorld.m_entToBody[ent]      = bodyId;
+    rCtxWorld.m_bodyToEnt[bodyId]   = ent;
 }
 
+void SysNewton::evaluate_force_factors(ACtxNwtWorld& rCtxWorld) noexcept
+{
+    ACtxNwtWorld::ForceBatchBuffers &rBuf = rCtxWorld.m_forceBatch;
+
+    // Reset indices of bodies gathered last step
+    for (BodyId const bodyId : rBuf.m_bodies)
+    {
+        rBuf.m_bodyToBatch[bodyId] = ACtxNwtWorld::ForceBatchBuffers::smc_noBatch;
+    }
+
+    rBuf.m_bodies       .clear();
+    rBuf.m_positions    .clear();
+    rBuf.m_velocities   .clear();
+    rBuf.m_masses       .clear();
+    rBuf.m_factorIndices.resize(rCtxWorld.m_factors.size());
+    for (std::vector<std::uint32_t> &rIndices : rBuf.m_factorIndices)
+    {
+        rIndices.clear();
+    }
+
+    // Gather dynamic bodies into SoA arrays, and sort them into each factor they use
+    for (BodyId const bodyId : rCtxWorld.m_bodyIds)
+    {
+        NewtonBody const *pBody = rCtxWorld.m_bodyPtrs[bodyId].get();
+        if (pBody == nullptr)
+        {
+            continue;
+        }
+
+        float mass = 0.0f;
+        float dummy = 0.0f;
+        NewtonBodyGetMass(pBody, &mass, &dummy, &dummy, &dummy);
+        if (mass == 0.0f)
+        {
+            continue; // static body, Newton won't call cb_force_torque for it
+        }
+
+        Matrix4 matrix;
+        Vector3 com;
+        Vector3 velocity;
+        NewtonBodyGetMatrix(pBody, matrix.data());
+        NewtonBodyGetCentreOfMass(pBody, com.data());
+        NewtonBodyGetVelocity(pBody, velocity.data());
+
+        auto const index = static_cast<std::uint32_t>(rBuf.m_bodies.size());
+        rBuf.m_bodyToBatch[bodyId] = index;
+
+        rBuf.m_bodies       .push_back(bodyId);
+        rBuf.m_positions    .push_back(matrix.transformPoint(com));
+        rBuf.m_velocities   .push_back(velocity);
+        rBuf.m_masses       .push_back(mass);
+
+        auto factorBits = lgrn::bit_view(rCtxWorld.m_bodyFactors[bodyId]);
+        for (std::size_t const factorIdx : factorBits.ones())
+        {
+            rBuf.m_factorIndices[factorIdx].push_back(index);
+        }
+    }
+
+    std::size_t const count = rBuf.m_bodies.size();
+    rBuf.m_forces   .assign(count, Vector3{0.0f});
+    rBuf.m_torques  .assign(count, Vector3{0.0f});
+
+    // Evaluate each factor once over all of its bodies
+    for (std::size_t factorIdx = 0; factorIdx < rCtxWorld.m_factors.size(); ++factorIdx)
+    {
+        std::vector<std::uint32_t> const &rIndices = rBuf.m_factorIndices[factorIdx];
+        if (rIndices.empty())
+        {
+            continue;
+        }
+
+        ACtxNwtWorld::ForceFactorFunc const& factor = rCtxWorld.m_factors[factorIdx];
+
+        if (factor.m_batchFunc != nullptr)
+        {
+            ForceFactorBatch const batch
+            {
+                .m_indices      = {rIndices.data(),             rIndices.size()},
+                .m_bodies       = {rBuf.m_bodies.data(),        count},
+                .m_positions    = {rBuf.m_positions.data(),     count},
+                .m_velocities   = {rBuf.m_velocities.data(),    count},
+                .m_masses       = {rBuf.m_masses.data(),        count},
+                .m_forces       = {rBuf.m_forces.data(),        count},
+                .m_torques      = {rBuf.m_torques.data(),       count}
+            };
+            factor.m_batchFunc(batch, rCtxWorld, factor.m_userData);
+        }
+        else
+        {
+            // Fallback for factors that only provide a per-body function
+            for (std::uint32_t const index : rIndices)
+            {
+                BodyId const bodyId = rBuf.m_bodies[index];
+                factor.m_func(rCtxWorld.m_bodyPtrs[bodyId].get(), bodyId, rCtxWorld,
+                              factor.m_userData, rBuf.m_forces[index], rBuf.m_torques[index]);
+            }
+        }
+    }
+} // evaluate_force_factors()
+
 NwtColliderPtr_t SysNewton::create_primative(
         ACtxNwtWorld&   rCtxWorld,
         EShape          shape)
@@ -161,7 +371,9 @@ void SysNewton::update_translate(ACtxPhysics& rCtxPhys, ACtxNwtWorld& rCtxWorld)
             Matrix4 matrix;
             NewtonBodyGetMatrix(pBody, matrix.data());
             matrix.translation() += translate;
-            NewtonBodySetMatrix(pBody, matrix.data());
+
+            // Translating the whole world shouldn't wake up sleeping bodies
+            NewtonBodySetMatrixNoSleep(pBody, matrix.data());
         }
     }
 }
@@ -173,35 +385,239 @@ void SysNewton::update_world(
         ACtxNwtWorld&               rCtxWorld,
         float                       timestep,
         ACtxSceneGraph const&       rScnGraph,
-        ACompTransformStorage_t&    rTf) noexcept
+        ACompTransformStorage_t&    rTf,
+        osp::KeyedVec<ActiveEnt, uint8_t>* pTfDirty) noexcept
 {
+    OSP_PROFILE_ZONE("SysNewton::update_world");
+
     NewtonWorld const* pNwtWorld = rCtxWorld.m_world.get();
 
     // Apply changed velocities
     for (auto const& [ent, vel] : std::exchange(rCtxPhys.m_setVelocity, {}))
     {
-        BodyId const bodyId     = rCtxWorld.m_entToBody.at(ent);
+        LGRN_ASSERTM(find_body(rCtxWorld, ent) != lgrn::id_null<BodyId>(), "Entity has no body");
+        BodyId const bodyId     = rCtxWorld.m_entToBody[ent];
         NewtonBody const *pBody = rCtxWorld.m_bodyPtrs[bodyId].get();
 
         NewtonBodySetVelocity(pBody, vel.data());
     }
 
-    rCtxWorld.m_pTransform = std::addressof(rTf);
+    rCtxWorld.m_pTransform      = std::addressof(rTf);
+    rCtxWorld.m_pTransformDirty = pTfDirty;
+    rCtxWorld.m_pContacts       = &rCtxPhys.m_contacts;
+
+    evaluate_force_factors(rCtxWorld);
 
     // Update the world
     NewtonUpdate(pNwtWorld, timestep);
 }
 
+namespace
+{
+
+/**
+ * @brief Closest hit of a single ray, passed as user data to Newton's ray callbacks
+ */
+struct RayHit
+{
+    NewtonBody const*   m_pIgnore{nullptr};
+    NewtonBody const*   m_pBody{nullptr};
+    Vector3             m_normal{0.0f};
+    float               m_fraction{2.0f};
+};
+
+unsigned cb_ray_prefilter(NewtonBody const* const pBody, NewtonCollision const* const /*pCollision*/, void* const pUserData)
+{
+    return (pBody == static_cast<RayHit*>(pUserData)->m_pIgnore) ? 0 : 1;
+}
+
+dFloat cb_ray_filter(
+        NewtonBody const* const         pBody,
+        NewtonCollision const* const    /*pShapeHit*/,
+        dFloat const* const             /*pHitContact*/,
+        dFloat const* const             pHitNormal,
+        dLong                           /*collisionId*/,
+        void* const                     pUserData,
+        dFloat const                    intersectParam)
+{
+    RayHit &rHit = *static_cast<RayHit*>(pUserData);
+    if (intersectParam < rHit.m_fraction)
+    {
+        rHit.m_pBody    = pBody;
+        rHit.m_fraction = intersectParam;
+        rHit.m_normal   = {pHitNormal[0], pHitNormal[1], pHitNormal[2]};
+    }
+
+    // Returning the hit's parameter clips the ray to it, so only closer bodies are tested after
+    return intersectParam;
+}
+
+} // namespace
+
+void SysNewton::update_raycasts(ACtxNwtWorld& rCtxWorld, RaycastQueries& rRays) noexcept
+{
+    SysPhysics::raycast_prepare_results(rRays);
+
+    NewtonWorld const* pNwtWorld = rCtxWorld.m_world.get();
+
+    for (std::size_t i = 0; i < rRays.size(); ++i)
+    {
+        RayHit hit;
+
+        ActiveEnt const ignore = rRays.m_ignore[i];
+        if (ignore != lgrn::id_null<ActiveEnt>())
+        {
+            BodyId const ignoreBody = find_body(rCtxWorld, ignore);
+            if (ignoreBody != lgrn::id_null<BodyId>())
+            {
+                hit.m_pIgnore = rCtxWorld.m_bodyPtrs[ignoreBody].get();
+            }
+        }
+
+        Vector3 const start = rRays.m_origins[i];
+        Vector3 const end   = start + rRays.m_directions[i];
+        NewtonWorldRayCast(pNwtWorld, start.data(), end.data(), &cb_ray_filter, &hit, &cb_ray_prefilter, 0);
+
+        if (hit.m_pBody == nullptr)
+        {
+            continue;
+        }
+
+        rRays.m_hitFraction[i]  = hit.m_fraction;
+        rRays.m_hitNormal[i]    = hit.m_normal;
+        rRays.m_hitEnt[i]       = rCtxWorld.m_bodyToEnt[get_userdata_bodyid(hit.m_pBody)];
+    }
+}
+
+// Snapshot blob: header, then per body its ID, entity, force factors, and Newton state
+static constexpr std::uint32_t gc_snapshotMagic     = 0x4E50534F; // "OSPN"
+static constexpr std::uint32_t gc_snapshotVersion   = 1;
+
+namespace
+{
+
+struct SavedBody
+{
+    BodyId          id;
+    ActiveEnt       ent;
+    ForceFactors_t  factors;
+    Matrix4         transform;
+    Vector3         velocity;
+    Vector3         omega;
+    int             sleeping;
+};
+
+} // namespace
+
+std::vector<std::byte> SysNewton::save_snapshot(ACtxNwtWorld const& rCtxWorld)
+{
+    std::vector<std::byte> out;
+
+    osp::append_bytes(out, gc_snapshotMagic);
+    osp::append_bytes(out, gc_snapshotVersion);
+    osp::append_bytes(out, static_cast<std::uint32_t>(rCtxWorld.m_bodyIds.size()));
+
+    for (BodyId const bodyId : rCtxWorld.m_bodyIds)
+    {
+        NewtonBody const *pBody = rCtxWorld.m_bodyPtrs[bodyId].get();
+
+        SavedBody saved
+        {
+            .id         = bodyId,
+            .ent        = rCtxWorld.m_bodyToEnt[bodyId],
+            .factors    = rCtxWorld.m_bodyFactors[bodyId],
+            .sleeping   = NewtonBodyGetSleepState(pBody)
+        };
+        NewtonBodyGetMatrix(pBody, saved.transform.data());
+        NewtonBodyGetVelocity(pBody, saved.velocity.data());
+        NewtonBodyGetOmega(pBody, saved.omega.data());
+
+        osp::append_bytes(out, saved);
+    }
+
+    return out;
+}
+
+bool SysNewton::restore_snapshot(
+        ACtxNwtWorld&                       rCtxWorld,
+        osp::ArrayView<std::byte const>     data,
+        ACompTransformStorage_t&            rTf,
+        osp::KeyedVec<ActiveEnt, uint8_t>*  pTfDirty)
+{
+    osp::ByteReader reader{data};
+
+    std::uint32_t magic     = 0;
+    std::uint32_t version   = 0;
+    std::uint32_t bodyCount = 0;
+    if (   ! reader.read(magic)     || magic     != gc_snapshotMagic
+        || ! reader.read(version)   || version   != gc_snapshotVersion
+        || ! reader.read(bodyCount) || bodyCount != rCtxWorld.m_bodyIds.size())
+    {
+        return false;
+    }
+
+    // Read everything before modifying the world, so a bad blob changes nothing
+    std::vector<SavedBody> saved(bodyCount);
+    for (SavedBody &rSaved : saved)
+    {
+        if ( ! reader.read(rSaved) || ! rCtxWorld.m_bodyIds.exists(rSaved.id) )
+        {
+            return false; // Body was removed since the snapshot
+        }
+    }
+    if (reader.remaining().size() != 0)
+    {
+        return false;
+    }
+
+    for (SavedBody const& rSaved : saved)
+    {
+        ActiveEnt const oldEnt = rCtxWorld.m_bodyToEnt[rSaved.id];
+        if (oldEnt != lgrn::id_null<ActiveEnt>())
+        {
+            rCtxWorld.m_entToBody[oldEnt] = lgrn::id_null<BodyId>();
+        }
+    }
+
+    for (SavedBody const& rSaved : saved)
+    {
+        NewtonBody *pBody = rCtxWorld.m_bodyPtrs[rSaved.id].get();
+
+        NewtonBodySetMatrix(pBody, rSaved.transform.data());
+        NewtonBodySetVelocity(pBody, rSaved.velocity.data());
+        NewtonBodySetOmega(pBody, rSaved.omega.data());
+        NewtonBodySetSleepState(pBody, rSaved.sleeping);
+
+        rCtxWorld.m_bodyToEnt[rSaved.id] = lgrn::id_null<ActiveEnt>();
+        if (rSaved.ent != lgrn::id_null<ActiveEnt>())
+        {
+            set_body_ent(rCtxWorld, rSaved.id, rSaved.ent);
+        }
+        rCtxWorld.m_bodyFactors[rSaved.id] = rSaved.factors;
+
+        // Newton doesn't call cb_set_transform for bodies moved by hand
+        if (rSaved.ent != lgrn::id_null<ActiveEnt>() && rTf.contains(rSaved.ent))
+        {
+            rTf.get(rSaved.ent).m_transform = rSaved.transform;
+            if (pTfDirty != nullptr)
+            {
+                (*pTfDirty)[rSaved.ent] = 1;
+            }
+        }
+    }
+
+    return true;
+}
+
 void SysNewton::remove_components(ACtxNwtWorld& rCtxWorld, ActiveEnt ent) noexcept
 {
-    auto itBodyId = rCtxWorld.m_entToBody.find(ent);
+    BodyId const bodyId = find_body(rCtxWorld, ent);
 
-    if (itBodyId != rCtxWorld.m_entToBody.end())
+    if (bodyId != lgrn::id_null<BodyId>())
     {
-        BodyId const bodyId = itBodyId->second;
         rCtxWorld.m_bodyPtrs[bodyId].reset();
         rCtxWorld.m_bodyToEnt[bodyId] = lgrn::id_null<ActiveEnt>();
-        rCtxWorld.m_entToBody.erase(itBodyId);
+        rCtxWorld.m_entToBody[ent]    = lgrn::id_null<BodyId>();
     }
 
     rCtxWorld.m_colliders.remove(ent);
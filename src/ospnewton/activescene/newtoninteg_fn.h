@@ -33,6 +33,9 @@
 
 #include <Newton.h>
 
+#include <cstddef>
+#include <vector>
+
 // IWYU pragma: no_include <cstdint>
 // IWYU pragma: no_include <stdint.h>
 // IWYU pragma: no_include <type_traits>
@@ -51,12 +54,41 @@ public:
 
     using NwtThreadIndex_t = int;
 
+    /// Called from Newton's worker threads. Only reads results of evaluate_force_factors.
     static void cb_force_torque(const NewtonBody* pBody, dFloat timestep, NwtThreadIndex_t thread);
 
+    /// Called from Newton's worker threads, once per moved body. Only writes to that body's own
+    /// entity's transform and dirty flag, storages must not be resized during NewtonUpdate.
     static void cb_set_transform(NewtonBody const* pBody, dFloat const* pMatrix, NwtThreadIndex_t thread);
 
+    /// Called from Newton's worker threads for each pair of touching bodies, before solving.
+    /// Appends the fastest approaching contact point to ACtxNwtWorld::m_pContacts.
+    static void cb_contacts(NewtonJoint const* pContactJoint, dFloat timestep, NwtThreadIndex_t thread);
+
     static void resize_body_data(ACtxNwtWorld& rCtxWorld);
 
+    /**
+     * @brief Associate a body and an entity with each other
+     *
+     * Call resize_body_data first after creating the BodyId.
+     */
+    static void set_body_ent(ACtxNwtWorld& rCtxWorld, BodyId bodyId, ActiveEnt ent);
+
+    /**
+     * @return Body of an entity, or null if it has none
+     */
+    [[nodiscard]] static BodyId find_body(ACtxNwtWorld const& rCtxWorld, ActiveEnt const ent) noexcept
+    {
+        return (std::size_t(ent) < rCtxWorld.m_entToBody.size()) ? rCtxWorld.m_entToBody[ent]
+                                                                  : lgrn::id_null<BodyId>();
+    }
+
+    /**
+     * @brief Evaluate all force factors for all dynamic bodies, results are applied by
+     *        cb_force_torque
+     */
+    static void evaluate_force_factors(ACtxNwtWorld& rCtxWorld) noexcept;
+
     [[nodiscard]] static NwtColliderPtr_t create_primative(
             ACtxNwtWorld&           rCtxWorld,
             osp::EShape       shape);
@@ -102,13 +134,45 @@ public:
      * @param rTf           [ref] Relative transforms used by rigid bodies
      * @param rTfControlled [ref] Flags for controlled transforms
      * @param rTfMutable    [ref] Flags for mutable transforms
+     * @param pTfDirty      [out] Optional transform dirty flags, set for bodies that moved
      */
     static void update_world(
             ACtxPhysics&                            rCtxPhys,
             ACtxNwtWorld&                           rCtxWorld,
             float                                   timestep,
             ACtxSceneGraph const&                   rScnGraph,
-            osp::active::ACompTransformStorage_t&   rTf) noexcept;
+            osp::active::ACompTransformStorage_t&   rTf,
+            osp::KeyedVec<ActiveEnt, uint8_t>*      pTfDirty = nullptr) noexcept;
+
+    /**
+     * @brief Answer all rays in ACtxPhysics::m_rays with NewtonWorldRayCast
+     *
+     * Must not be called while the world is updating.
+     */
+    static void update_raycasts(ACtxNwtWorld& rCtxWorld, osp::active::RaycastQueries& rRays) noexcept;
+
+    /**
+     * @brief Save transforms, velocities, and sleep states of all bodies, along with the
+     *        OSP-side body data, to a binary blob
+     *
+     * Newton doesn't expose its contact cache, so stepping from a restored snapshot may
+     * diverge slightly from the original run. Bodies aren't recreated, see
+     * SysJolt::save_snapshot.
+     */
+    [[nodiscard]] static std::vector<std::byte> save_snapshot(ACtxNwtWorld const& rCtxWorld);
+
+    /**
+     * @brief Restore a blob written by save_snapshot, writing the transforms of entities with
+     *        bodies to rTf
+     *
+     * @return False, leaving the world untouched, if the blob is invalid or the world's bodies
+     *         don't match the ones saved
+     */
+    [[nodiscard]] static bool restore_snapshot(
+            ACtxNwtWorld&                           rCtxWorld,
+            osp::ArrayView<std::byte const>         data,
+            ACompTransformStorage_t&                rTf,
+            osp::KeyedVec<ActiveEnt, uint8_t>*      pTfDirty = nullptr);
 
     static void remove_components(
             ACtxNwtWorld& rCtxWorld, ActiveEnt ent) noexcept;
@@ -24,8 +24,13 @@
  */
 #include "chunk_generate.h"
 
+#include <osp/util/profiling.h>
+
 #include <Corrade/Containers/ArrayViewStl.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <ostream>
 
 using osp::ArrayView;
@@ -44,9 +49,127 @@ void ChunkScratchpad::resize(ChunkSkeleton const& rChSk)
 
     edgeVertices        .resize((rChSk.m_chunkEdgeVrtxCount - 1) * 3);
     stitchCmds          .resize(rChSk.m_chunkIds.capacity(), {});
+    reductions          .resize(rChSk.m_chunkIds.capacity(), 0);
     sharedAdded         .resize(maxSharedVrtx);
     sharedRemoved       .resize(maxSharedVrtx);
     sharedNormalsDirty  .resize(maxSharedVrtx);
+    chunksDirty         .resize(rChSk.m_chunkIds.capacity());
+}
+
+std::size_t ChunkFillCache::KeyHash::operator()(Key const& key) const noexcept
+{
+    // FNV-1a over the bits of all corner coordinates
+    std::size_t hash = 14695981039346656037ull;
+    for (std::uint32_t const bits : key.cornerBits)
+    {
+        hash = (hash ^ bits) * 1099511628211ull;
+    }
+    return hash;
+}
+
+void ChunkFillCache::resize(std::uint32_t const capacity, std::uint32_t const fillCount)
+{
+    fillVrtxCount = fillCount;
+    positions   .assign(std::size_t(capacity) * fillCount, Vector3{ZeroInit});
+    slotKeys    .assign(capacity, Key{});
+    slotPrev    .assign(capacity, smc_null);
+    slotNext    .assign(capacity, smc_null);
+    oldest      = smc_null;
+    newest      = smc_null;
+    keyToSlot   .clear();
+    keyToSlot   .reserve(capacity);
+
+    freeSlots.resize(capacity);
+    for (std::uint32_t i = 0; i < capacity; ++i)
+    {
+        freeSlots[i] = capacity - 1 - i;
+    }
+}
+
+static void cache_unlink(ChunkFillCache &rCache, std::uint32_t const slot) noexcept
+{
+    std::uint32_t const prev = rCache.slotPrev[slot];
+    std::uint32_t const next = rCache.slotNext[slot];
+    (prev != ChunkFillCache::smc_null ? rCache.slotNext[prev] : rCache.oldest) = next;
+    (next != ChunkFillCache::smc_null ? rCache.slotPrev[next] : rCache.newest) = prev;
+    rCache.keyToSlot.erase(rCache.slotKeys[slot]);
+    rCache.freeSlots.push_back(slot);
+}
+
+ChunkFillCache::Key chunk_fill_cache_key(
+        ChunkId                const chunkId,
+        BasicChunkMeshGeometry const &rGeom,
+        ChunkMeshBufferInfo    const &rChInfo,
+        ChunkSkeleton          const &rSkCh)
+{
+    // Corners are at (0, 0), (0, width), and (width, width), see coord_to_shared
+    auto const sharedUsed = rSkCh.shared_vertices_used(chunkId);
+    auto const width      = rSkCh.m_chunkEdgeVrtxCount;
+
+    ChunkFillCache::Key key;
+    std::uint32_t const corners[3] = { 0u, width, 2u * width };
+    for (int i = 0; i < 3; ++i)
+    {
+        Vector3 const pos = rGeom.chunkVbufPos[rChInfo.vbufSharedOffset + sharedUsed[corners[i]].value().value];
+        std::memcpy(&key.cornerBits[std::size_t(i) * 3], pos.data(), sizeof(Vector3));
+    }
+    return key;
+}
+
+void chunk_fill_cache_store(
+        ChunkFillCache::Key    const &key,
+        ChunkId                const chunkId,
+        BasicChunkMeshGeometry const &rGeom,
+        ChunkMeshBufferInfo    const &rChInfo,
+        ChunkFillCache               &rCache)
+{
+    if (rCache.slotKeys.empty() || rCache.keyToSlot.contains(key))
+    {
+        return;
+    }
+
+    if (rCache.freeSlots.empty())
+    {
+        cache_unlink(rCache, rCache.oldest);
+        ++rCache.stats.evictions;
+    }
+
+    std::uint32_t const slot = rCache.freeSlots.back();
+    rCache.freeSlots.pop_back();
+
+    rCache.slotKeys[slot] = key;
+    rCache.slotPrev[slot] = rCache.newest;
+    rCache.slotNext[slot] = ChunkFillCache::smc_null;
+    (rCache.newest != ChunkFillCache::smc_null ? rCache.slotNext[rCache.newest] : rCache.oldest) = slot;
+    rCache.newest = slot;
+    rCache.keyToSlot.emplace(key, slot);
+
+    auto const src = rGeom.chunkVbufPos.begin() + rChInfo.vbufFillOffset + std::size_t(chunkId.value) * rChInfo.fillVrtxCount;
+    std::copy(src, src + rChInfo.fillVrtxCount, rCache.positions.begin() + std::size_t(slot) * rCache.fillVrtxCount);
+}
+
+bool chunk_fill_cache_take(
+        ChunkFillCache::Key    const &key,
+        ChunkId                const chunkId,
+        BasicChunkMeshGeometry       &rGeom,
+        ChunkMeshBufferInfo    const &rChInfo,
+        ChunkFillCache               &rCache)
+{
+    auto const found = rCache.keyToSlot.find(key);
+    if (found == rCache.keyToSlot.end())
+    {
+        ++rCache.stats.misses;
+        return false;
+    }
+
+    std::uint32_t const slot = found->second;
+
+    auto const src = rCache.positions.begin() + std::size_t(slot) * rCache.fillVrtxCount;
+    std::copy(src, src + rCache.fillVrtxCount, rGeom.chunkVbufPos.begin() + rChInfo.vbufFillOffset + std::size_t(chunkId.value) * rChInfo.fillVrtxCount);
+
+    cache_unlink(rCache, slot);
+    ++rCache.stats.hits;
+    return true;
 }
 
 void restitch_check(
@@ -183,13 +306,33 @@ void update_faces(
         ChunkScratchpad              &rChSP,
         ChunkSkeleton                &rSkCh)
 {
-    ChunkStitch const cmd = rChSP.stitchCmds[chunkId];
+    ChunkStitch  const cmd              = rChSP.stitchCmds[chunkId];
+    std::uint8_t const reduction        = rChSP.reductions[chunkId];
+    bool         const reductionChanged = ! newlyAdded && reduction != rGeom.chunkReduction[chunkId];
 
-    if ( ! newlyAdded && ! cmd.enabled )
+    if ( ! newlyAdded && ! cmd.enabled && ! reductionChanged )
     {
         return; // Nothing to do
     }
 
+    OSP_PROFILE_ZONE("planeta::update_faces");
+
+    rChSP.chunksDirty.insert(chunkId);
+
+    // Fan triangles of reduced chunks are mixed in with the rest, so restitching them also
+    // rewrites all of their faces
+    bool const rewriteAll = newlyAdded || reductionChanged || reduction != 0;
+    if (rewriteAll && ! newlyAdded)
+    {
+        subtract_normal_contrib(chunkId, false, rGeom, rChInfo, rChSP, rSkCh);
+        rChSP.chunksRefaced.push_back(chunkId);
+    }
+    rGeom.chunkReduction[chunkId] = reduction;
+
+    // Chunks only being refaced keep their current stitch
+    ChunkStitch const stitch      = cmd.enabled ? cmd : rSkCh.m_chunkStitch[chunkId];
+    bool        const writeFans   = rewriteAll ? stitch.enabled : cmd.enabled;
+
     auto const ibufSlice         = as_2d(arrayView(rGeom.chunkIbuf),              rChInfo.chunkMaxFaceCount).row(chunkId.value);
     auto const fanNormalContrib  = as_2d(arrayView(rGeom.chunkFanNormalContrib),  rChInfo.fanMaxSharedCount).row(chunkId.value);
     auto const fillNormalContrib = as_2d(arrayView(rGeom.chunkFillSharedNormals), rSkCh.m_chunkSharedCount) .row(chunkId.value);
@@ -207,8 +350,7 @@ void update_faces(
         .rSharedNormalsDirty = rChSP.sharedNormalsDirty
     };
 
-    // Create triangle fill for newly added triangles
-    if (newlyAdded)
+    if (rewriteAll)
     {
         // Reset fill normals to zero, as values are left over from a previously deleted chunk
         auto const chunkVbufFillNormals2D = as_2d(arrayView(rGeom.chunkVbufNrm).exceptPrefix(rChInfo.vbufFillOffset), rChInfo.fillVrtxCount);
@@ -218,94 +360,287 @@ void update_faces(
         std::fill(vbufFillNormals  .begin(), vbufFillNormals  .end(), Vector3{ZeroInit});
         std::fill(fillNormalContrib.begin(), fillNormalContrib.end(), Vector3{ZeroInit});
         std::fill(fanNormalContrib .begin(), fanNormalContrib .end(), FanNormalContrib{});
+    }
+
+    ArrayView<SharedVrtxOwner_t const> detailX2Edge0;
+    ArrayView<SharedVrtxOwner_t const> detailX2Edge1;
+
+    // For detailX2 stitches, get the 2 neighboring higher detail triangles,
+    // and get the rows of shared vertices along the edge in contact.
+    if (writeFans && stitch.detailX2)
+    {
+        SkTriId          const  neighborId = rSkel.tri_at(sktriId).neighbors[stitch.x2ownEdge];
+        SkeletonTriangle const& neighbor   = rSkel.tri_at(neighborId);
+
+        auto const child_chunk_edge = [&rSkCh, children = neighbor.children, edgeIdx = std::uint32_t(stitch.x2neighborEdge)]
+                                      (std::uint8_t siblingIdx) -> ArrayView<SharedVrtxOwner_t const>
+        {
+            ChunkId const chunk = rSkCh.m_triToChunk[tri_id(children, siblingIdx)];
+            return as_2d(rSkCh.shared_vertices_used(chunk), rSkCh.m_chunkEdgeVrtxCount).row(edgeIdx);
+        };
+
+        detailX2Edge0 = child_chunk_edge(stitch.x2neighborEdge);
+        detailX2Edge1 = child_chunk_edge((stitch.x2neighborEdge + 1) % 3);
+    }
+
+    if (reduction != 0)
+    {
+        LGRN_ASSERTM(writeFans, "Reduced chunks are written all at once, and need a stitch");
 
-        auto const add_fill_tri = [&rSkCh, &rChInfo, &writer, chunkId]
-                (std::uint16_t const aX, std::uint16_t const aY,
-                 std::uint16_t const bX, std::uint16_t const bY,
-                 std::uint16_t const cX, std::uint16_t const cY)
+        int           const detailEdge = stitch.detailX2 ? int(stitch.x2ownEdge) : -1;
+        std::uint16_t const width      = rSkCh.m_chunkEdgeVrtxCount;
+
+        struct ReducedVrtx
         {
-            auto const [shLocalA, vrtxA] = chunk_coord_to_vrtx(rSkCh, rChInfo, chunkId, aX, aY);
-            auto const [shLocalB, vrtxB] = chunk_coord_to_vrtx(rSkCh, rChInfo, chunkId, bX, bY);
-            auto const [shLocalC, vrtxC] = chunk_coord_to_vrtx(rSkCh, rChInfo, chunkId, cX, cY);
-
-            writer.fill_add_face(vrtxA, vrtxB, vrtxC);
-
-            shLocalA.has_value() ? writer.fill_add_normal_shared(vrtxA, shLocalA)
-                                 : writer.fill_add_normal_filled(vrtxA);
-            shLocalB.has_value() ? writer.fill_add_normal_shared(vrtxB, shLocalB)
-                                 : writer.fill_add_normal_filled(vrtxB);
-            shLocalC.has_value() ? writer.fill_add_normal_shared(vrtxC, shLocalC)
-                                 : writer.fill_add_normal_filled(vrtxC);
+            VertexIdx           vertex;
+            ChunkLocalSharedId  local;      ///< Own shared vertex if set
+            SharedVrtxId        detailX2;   ///< Shared vertex of a higher detail neighbor if set
         };
 
-        for (unsigned int y = 0; y < rSkCh.m_chunkEdgeVrtxCount; ++y)
+        auto const resolve = [&] (ChunkHalfCoord const half) -> ReducedVrtx
         {
-            for (unsigned int x = 0; x < y; ++x)
+            if (half.x % 2 == 0 && half.y % 2 == 0)
             {
-                // down-pointing
-                //                ( aX   aY )    ( aX   aY )    ( aX   aY )
-                add_fill_tri(      x+1, y+1,      x+1,  y,         x,  y      );
+                auto const [local, vertex] = chunk_coord_to_vrtx(rSkCh, rChInfo, chunkId, std::uint16_t(half.x / 2), std::uint16_t(half.y / 2));
+                return { .vertex = vertex, .local = local, .detailX2 = {} };
+            }
 
-                // up pointing
-                bool const onEdge = (x == y-1) || y == rSkCh.m_chunkEdgeVrtxCount - 1;
-                if ( ! onEdge )
+            // Odd coordinates are between own shared vertices along the detailX2 edge, where
+            // detailX2Edge1 then detailX2Edge0 run in the opposite direction
+            int const along = (detailEdge == 0) ? half.y
+                            : (detailEdge == 1) ? half.x
+                            :                     2*width - half.x;
+            SharedVrtxId const shared = (along < width) ? detailX2Edge1[width - along].value()
+                                                        : detailX2Edge0[2*width - along].value();
+            return { .vertex = rChInfo.vbufSharedOffset + shared.value, .local = {}, .detailX2 = shared };
+        };
+
+        reduced_chunk_faces(width, reduction, detailEdge,
+                            [&writer, &resolve] (ChunkHalfCoord const a, ChunkHalfCoord const b, ChunkHalfCoord const c)
+        {
+            std::array<ReducedVrtx, 3> const tri{ resolve(a), resolve(b), resolve(c) };
+
+            writer.fill_add_face(tri[0].vertex, tri[1].vertex, tri[2].vertex);
+
+            for (ReducedVrtx const& vrtx : tri)
+            {
+                if (vrtx.local.has_value())
+                {
+                    writer.fill_add_normal_shared(vrtx.vertex, vrtx.local);
+                }
+                else if (vrtx.detailX2.has_value())
                 {
+                    // Recorded as a fan contribution, as it's not one of this chunk's own
+                    writer.fan_add_normal_shared(vrtx.vertex, vrtx.detailX2);
+                }
+                else
+                {
+                    writer.fill_add_normal_filled(vrtx.vertex);
+                }
+            }
+        });
+
+        LGRN_ASSERTM(writer.currentFace == std::next(ibufSlice.begin(), reduced_chunk_face_count(width, reduction, stitch.detailX2)),
+                     "Code above must always add a known number of faces");
+
+        rSkCh.m_chunkStitch[chunkId] = stitch;
+    }
+    else
+    {
+        // Create triangle fill for newly added or refaced chunks
+        if (rewriteAll)
+        {
+            auto const add_fill_tri = [&rSkCh, &rChInfo, &writer, chunkId]
+                    (std::uint16_t const aX, std::uint16_t const aY,
+                     std::uint16_t const bX, std::uint16_t const bY,
+                     std::uint16_t const cX, std::uint16_t const cY)
+            {
+                auto const [shLocalA, vrtxA] = chunk_coord_to_vrtx(rSkCh, rChInfo, chunkId, aX, aY);
+                auto const [shLocalB, vrtxB] = chunk_coord_to_vrtx(rSkCh, rChInfo, chunkId, bX, bY);
+                auto const [shLocalC, vrtxC] = chunk_coord_to_vrtx(rSkCh, rChInfo, chunkId, cX, cY);
+
+                writer.fill_add_face(vrtxA, vrtxB, vrtxC);
+
+                shLocalA.has_value() ? writer.fill_add_normal_shared(vrtxA, shLocalA)
+                                     : writer.fill_add_normal_filled(vrtxA);
+                shLocalB.has_value() ? writer.fill_add_normal_shared(vrtxB, shLocalB)
+                                     : writer.fill_add_normal_filled(vrtxB);
+                shLocalC.has_value() ? writer.fill_add_normal_shared(vrtxC, shLocalC)
+                                     : writer.fill_add_normal_filled(vrtxC);
+            };
+
+            for (unsigned int y = 0; y < rSkCh.m_chunkEdgeVrtxCount; ++y)
+            {
+                for (unsigned int x = 0; x < y; ++x)
+                {
+                    // down-pointing
                     //                ( aX   aY )    ( aX   aY )    ( aX   aY )
-                    add_fill_tri(      x+1,  y,       x+1,  y+1,     x+2,  y+1   );
+                    add_fill_tri(      x+1, y+1,      x+1,  y,         x,  y      );
+
+                    // up pointing
+                    bool const onEdge = (x == y-1) || y == rSkCh.m_chunkEdgeVrtxCount - 1;
+                    if ( ! onEdge )
+                    {
+                        //                ( aX   aY )    ( aX   aY )    ( aX   aY )
+                        add_fill_tri(      x+1,  y,       x+1,  y+1,     x+2,  y+1   );
+                    }
                 }
             }
+
+            LGRN_ASSERTM(writer.currentFace == std::next(ibufSlice.begin(), rChInfo.fillFaceCount),
+                         "Code above must always add a known number of faces");
+
+            // Fill normals are normalized later by finalize_normals
         }
 
-        LGRN_ASSERTM(writer.currentFace == std::next(ibufSlice.begin(), rChInfo.fillFaceCount),
-                     "Code above must always add a known number of faces");
+        writer.currentFace = std::next(ibufSlice.begin(), rChInfo.fillFaceCount);
 
-        for (Vector3 &rNormal : vbufFillNormals)
+        // Add or replace Fan triangles
+        if (writeFans)
         {
-            rNormal = rNormal.normalized();
+            ChunkStitch &rCurrentStitch = rSkCh.m_chunkStitch[chunkId];
+            if ( ! rewriteAll && rCurrentStitch.enabled )
+            {
+                // Delete previous fan stitch, Subtract normal contributions
+                subtract_normal_contrib(chunkId, true, rGeom, rChInfo, rChSP, rSkCh);
+            }
+            rCurrentStitch = stitch;
+
+            auto const stitcher = make_chunk_fan_stitcher<TerrainFaceWriter&>(writer, chunkId, detailX2Edge0, detailX2Edge1, rSkCh, rChInfo);
+
+            stitcher.stitch(stitch);
         }
     }
 
-    writer.currentFace = std::next(ibufSlice.begin(), rChInfo.fillFaceCount);
+    // Fill remaining with zeros to indicate an early end if the full range isn't used
+    std::fill(writer.currentFace, ibufSlice.end(), Vector3u{ZeroInit});
+
+}
+
+namespace
+{
+
+/**
+ * @brief Normalize a contiguous range of normals in place
+ *
+ * Written over plain floats without branches so compilers can vectorize it.
+ */
+void normalize_contiguous(ArrayView<Vector3> const normals) noexcept
+{
+    float *const pData = normals.data()->data();
+    std::size_t const count = normals.size();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        float const x = pData[i*3 + 0];
+        float const y = pData[i*3 + 1];
+        float const z = pData[i*3 + 2];
+        float const invLength = 1.0f / std::sqrt(x*x + y*y + z*z);
+        pData[i*3 + 0] = x * invLength;
+        pData[i*3 + 1] = y * invLength;
+        pData[i*3 + 2] = z * invLength;
+    }
+}
+
+} // namespace
+
+void finalize_normals(
+        BasicChunkMeshGeometry       &rGeom,
+        ChunkMeshBufferInfo    const &rChInfo,
+        ChunkScratchpad              &rChSP,
+        osp::ParallelFor       const &parallelFor)
+{
+    rChSP.sharedNormalsDirtyList.assign(rChSP.sharedNormalsDirty.begin(), rChSP.sharedNormalsDirty.end());
+
+    auto const fillNormals2D = as_2d(arrayView(rGeom.chunkVbufNrm).exceptPrefix(rChInfo.vbufFillOffset), rChInfo.fillVrtxCount);
+    std::size_t const addedCount  = rChSP.chunksAdded.size();
+    std::size_t const chunkCount  = addedCount + rChSP.chunksRefaced.size();
+    std::size_t const sharedCount = rChSP.sharedNormalsDirtyList.size();
 
-    // Add or replace Fan triangles
-    if (cmd.enabled)
+    // Each part processes the same fraction of both chunks and shared vertices
+    auto const finalize_part = [&rGeom, &rChInfo, &rChSP, fillNormals2D, addedCount, chunkCount, sharedCount]
+            (std::size_t const part, std::size_t const parts) noexcept
     {
-        ChunkStitch &rCurrentStitch = rSkCh.m_chunkStitch[chunkId];
-        if (rCurrentStitch.enabled)
+        for (std::size_t i = chunkCount * part / parts; i < chunkCount * (part + 1) / parts; ++i)
         {
-            // Delete previous fan stitch, Subtract normal contributions
-            subtract_normal_contrib(chunkId, true, rGeom, rChInfo, rChSP, rSkCh);
+            ChunkId const chunkId = (i < addedCount) ? rChSP.chunksAdded[i] : rChSP.chunksRefaced[i - addedCount];
+            normalize_contiguous(fillNormals2D.row(chunkId.value));
         }
-        rSkCh.m_chunkStitch[chunkId] = cmd;
-        ArrayView<SharedVrtxOwner_t const> detailX2Edge0;
-        ArrayView<SharedVrtxOwner_t const> detailX2Edge1;
 
-        // For detailX2 stitches, get the 2 neighboring higher detail triangles,
-        // and get the rows of shared vertices along the edge in contact.
-        if (cmd.detailX2)
+        for (std::size_t i = sharedCount * part / parts; i < sharedCount * (part + 1) / parts; ++i)
         {
-            SkTriId          const  neighborId = rSkel.tri_at(sktriId).neighbors[cmd.x2ownEdge];
-            SkeletonTriangle const& neighbor   = rSkel.tri_at(neighborId);
+            SharedVrtxId const sharedId = rChSP.sharedNormalsDirtyList[i];
+            rGeom.chunkVbufNrm[rChInfo.vbufSharedOffset + sharedId.value] = rGeom.sharedNormalSum[sharedId].normalized();
+        }
+    };
 
-            auto const child_chunk_edge = [&rSkCh, children = neighbor.children, edgeIdx = std::uint32_t(cmd.x2neighborEdge)]
-                                          (std::uint8_t siblingIdx) -> ArrayView<SharedVrtxOwner_t const>
-            {
-                ChunkId const chunk = rSkCh.m_triToChunk[tri_id(children, siblingIdx)];
-                return as_2d(rSkCh.shared_vertices_used(chunk), rSkCh.m_chunkEdgeVrtxCount).row(edgeIdx);
-            };
+    std::size_t const maxParts = std::max<std::size_t>({1, chunkCount  / ChunkScratchpad::smc_minChunksPerThread,
+                                                           sharedCount / ChunkScratchpad::smc_minSharedPerThread});
+    std::size_t const parts    = std::clamp<std::size_t>(parallelFor.m_threads, 1, maxParts);
 
-            detailX2Edge0 = child_chunk_edge(cmd.x2neighborEdge);
-            detailX2Edge1 = child_chunk_edge((cmd.x2neighborEdge + 1) % 3);
+    parallelFor(parts, parts, [&finalize_part, parts] (std::size_t const first, std::size_t const last)
+    {
+        for (std::size_t part = first; part < last; ++part)
+        {
+            finalize_part(part, parts);
         }
+    });
+}
 
-        auto const stitcher = make_chunk_fan_stitcher<TerrainFaceWriter&>(writer, chunkId, detailX2Edge0, detailX2Edge1, rSkCh, rChInfo);
+void find_dirty_ranges(
+        ChunkScratchpad        const &rChSP,
+        ChunkMeshBufferInfo    const &rChInfo,
+        ChunkMeshDirtyRanges         &rOut)
+{
+    rOut.clear();
 
-        stitcher.stitch(cmd);
+    auto const add_range = [] (std::vector<ChunkBufferRange> &rRanges, std::size_t const first, std::size_t const count)
+    {
+        if ( ! rRanges.empty() && rRanges.back().first + rRanges.back().count == first )
+        {
+            rRanges.back().count += count; // Merge with previous
+        }
+        else
+        {
+            rRanges.push_back({first, count});
+        }
+    };
+
+    // Shared vertices are after fill vertices in the vertex buffer, so add them last to keep
+    // vbuf sorted. Both ID sets iterate in ascending order.
+    for (ChunkId const chunkId : rChSP.chunksDirty)
+    {
+        add_range(rOut.ibuf, std::size_t(chunkId.value) * rChInfo.chunkMaxFaceCount, rChInfo.chunkMaxFaceCount);
+        add_range(rOut.vbuf, rChInfo.vbufFillOffset + std::size_t(chunkId.value) * rChInfo.fillVrtxCount, rChInfo.fillVrtxCount);
     }
 
-    // Fill remaining with zeros to indicate an early end if the full range isn't used
-    std::fill(writer.currentFace, ibufSlice.end(), Vector3u{ZeroInit});
+    // Merge sharedAdded and sharedNormalsDirty, as a shared vertex may be in both
+    auto       itAdded    = rChSP.sharedAdded.begin();
+    auto const addedEnd   = rChSP.sharedAdded.end();
+    auto       itNormal   = rChSP.sharedNormalsDirty.begin();
+    auto const normalEnd  = rChSP.sharedNormalsDirty.end();
+    while (itAdded != addedEnd || itNormal != normalEnd)
+    {
+        SharedVrtxId const added  = (itAdded  != addedEnd)  ? SharedVrtxId(*itAdded)  : SharedVrtxId{};
+        SharedVrtxId const normal = (itNormal != normalEnd) ? SharedVrtxId(*itNormal) : SharedVrtxId{};
+
+        SharedVrtxId shared;
+        if ( ! normal.has_value() || (added.has_value() && added.value <= normal.value) )
+        {
+            shared = added;
+            ++itAdded;
+            if (normal == added)
+            {
+                ++itNormal; // In both sets
+            }
+        }
+        else
+        {
+            shared = normal;
+            ++itNormal;
+        }
 
+        add_range(rOut.vbuf, rChInfo.vbufSharedOffset + shared.value, 1);
+    }
 }
 
 void subtract_normal_contrib(
@@ -389,6 +724,27 @@ void debug_check_invariants(
         VertexIdx const first = rChInfo.vbufFillOffset + std::size_t(chunkId) * rChInfo.fillVrtxCount;
         VertexIdx const last  = first + rChInfo.fillVrtxCount;
 
+        if (rGeom.chunkReduction[chunkId] != 0)
+        {
+            // Reduced chunks leave fill vertices unused; only check the ones their faces use
+            auto const ibufSlice = as_2d(arrayView(rGeom.chunkIbuf), rChInfo.chunkMaxFaceCount).row(chunkId.value);
+            for (osp::Vector3u const face : ibufSlice)
+            {
+                if (face.isZero())
+                {
+                    break; // Early end of faces
+                }
+                for (VertexIdx const vertex : {face.x(), face.y(), face.z()})
+                {
+                    if (first <= vertex && vertex < last)
+                    {
+                        check_vertex(vertex, {}, chunkId);
+                    }
+                }
+            }
+            continue;
+        }
+
         for (VertexIdx vertex = first; vertex < last; ++vertex)
         {
             check_vertex(vertex, {}, chunkId);
@@ -31,6 +31,12 @@
 #include "skeleton.h"
 #include "geometry.h"
 
+#include <osp/core/parallel_for.h>
+
+#include <array>
+#include <memory>
+#include <unordered_map>
+
 namespace planeta
 {
 
@@ -38,8 +44,22 @@ struct ChunkScratchpad
 {
     void resize(ChunkSkeleton const& rChSk);
 
-    /// Lookup table to help calculate 'Fill' vertices for chunks
-    ChunkFillSubdivLUT lut;
+    /// Lookup table to help calculate 'Fill' vertices for chunks. Immutable, so it can be shared
+    /// by all terrains with the same chunk subdiv level.
+    std::shared_ptr<ChunkFillSubdivLUT const> lut;
+
+    /// LUTs that only calculate fill vertices used at each reduced resolution, from 1 to
+    /// max_chunk_reduction. Index is reduction-1. Empty if reductions aren't used.
+    std::vector< std::shared_ptr<ChunkFillSubdivLUT const> > reducedLuts;
+
+    /// Resolution reduction wanted for each chunk, applied by update_faces. Set by the caller
+    /// before calculating fill vertices; stays at 0 (full resolution) if unused.
+    osp::KeyedVec<ChunkId, std::uint8_t> reductions;
+
+    ChunkFillSubdivLUT const& lut_for(std::uint8_t const reduction) const noexcept
+    {
+        return (reduction == 0) ? *lut : *reducedLuts[reduction - 1u];
+    }
 
     /// Temporary vector for storing sections of shared vertices
     std::vector< osp::MaybeNewId<SkVrtxId> > edgeVertices;
@@ -50,6 +70,14 @@ struct ChunkScratchpad
     /// Newly added chunks
     std::vector<ChunkId> chunksAdded;
 
+    /// Chunks that need fill vertices calculated. Includes chunksAdded that were not in a
+    /// ChunkFillCache, and existing chunks that need more fill vertices for a lower reduction.
+    std::vector<ChunkId> chunksToFill;
+
+    /// Existing chunks that had all of their faces rewritten by update_faces, as their reduction
+    /// changed or they're reduced and were restitched
+    std::vector<ChunkId> chunksRefaced;
+
     /// Recently added shared vertices, position needs to be copied from skeleton
     lgrn::IdSetStl<SharedVrtxId> sharedAdded;
 
@@ -58,8 +86,138 @@ struct ChunkScratchpad
 
     /// Shared vertices that need to recalculate normals
     lgrn::IdSetStl<SharedVrtxId> sharedNormalsDirty;
+
+    /// Chunks with faces or fill vertices modified since last cleared. Together with sharedAdded
+    /// and sharedNormalsDirty, this is enough to know which parts of the mesh buffers changed.
+    lgrn::IdSetStl<ChunkId> chunksDirty;
+
+    /// Chunks per-thread below which per-chunk work is done serially
+    static constexpr std::size_t smc_minChunksPerThread = 16;
+
+    /// Shared vertices per-thread below which normals are finalized serially
+    static constexpr std::size_t smc_minSharedPerThread = 4096;
+
+    /// sharedNormalsDirty copied into a vector, so it can be split across threads
+    std::vector<SharedVrtxId> sharedNormalsDirtyList;
+};
+
+/**
+ * @brief Element range within a chunk mesh vertex or index buffer
+ */
+struct ChunkBufferRange
+{
+    std::size_t first;
+    std::size_t count;
+};
+
+/**
+ * @brief Parts of BasicChunkMeshGeometry buffers that need to be re-uploaded to a GPU
+ */
+struct ChunkMeshDirtyRanges
+{
+    void clear()
+    {
+        vbuf.clear();
+        ibuf.clear();
+    }
+
+    /// Ranges in chunkVbufPos and chunkVbufNrm, in vertices, sorted and non-overlapping
+    std::vector<ChunkBufferRange> vbuf;
+
+    /// Ranges in chunkIbuf, in faces, sorted and non-overlapping
+    std::vector<ChunkBufferRange> ibuf;
+};
+
+/**
+ * @brief Bounded cache of fill vertex positions of recently removed chunks
+ *
+ * When the camera hovers around a subdivision threshold, the same chunks get removed and re-added
+ * repeatedly. Chunks are keyed by the positions of their 3 corners, which are deterministic
+ * regardless of which SkTriId or ChunkId ends up being used for the same area.
+ *
+ * Entries are removed when taken, and the least recently stored entry is evicted when full.
+ */
+struct ChunkFillCache
+{
+    struct Key
+    {
+        /// Exact bits of the corner positions' coordinates. Magnum's float comparisons are fuzzy
+        std::array<std::uint32_t, 9> cornerBits;
+
+        constexpr bool operator==(Key const&) const noexcept = default;
+    };
+
+    struct KeyHash
+    {
+        std::size_t operator()(Key const& key) const noexcept;
+    };
+
+    struct Stats
+    {
+        /// Chunks added that reused cached fill vertices
+        std::uint64_t hits      {0};
+        /// Chunks added that had to calculate fill vertices
+        std::uint64_t misses    {0};
+        /// Cached chunks dropped to make room for new ones
+        std::uint64_t evictions {0};
+    };
+
+    static constexpr std::uint32_t smc_null = ~std::uint32_t(0);
+
+    /**
+     * @brief Allocate space for up to capacity chunks, discarding all entries
+     */
+    void resize(std::uint32_t capacity, std::uint32_t fillVrtxCount);
+
+    std::vector<osp::Vector3>       positions;
+    std::vector<Key>                slotKeys;
+
+    /// Doubly-linked list of used slots in order of when they were stored, oldest first
+    std::vector<std::uint32_t>      slotPrev;
+    std::vector<std::uint32_t>      slotNext;
+    std::uint32_t                   oldest      {smc_null};
+    std::uint32_t                   newest      {smc_null};
+
+    std::vector<std::uint32_t>      freeSlots;
+
+    std::unordered_map<Key, std::uint32_t, KeyHash> keyToSlot;
+
+    std::uint32_t                   fillVrtxCount{0};
+
+    Stats                           stats;
 };
 
+/**
+ * @return Cache key of a chunk, requires its corner shared vertex positions to be written to rGeom
+ */
+ChunkFillCache::Key chunk_fill_cache_key(
+        ChunkId                         chunkId,
+        BasicChunkMeshGeometry    const &rGeom,
+        ChunkMeshBufferInfo       const &rChInfo,
+        ChunkSkeleton             const &rSkCh);
+
+/**
+ * @brief Copy a chunk's fill vertex positions into the cache, evicting the oldest if full
+ */
+void chunk_fill_cache_store(
+        ChunkFillCache::Key       const &key,
+        ChunkId                         chunkId,
+        BasicChunkMeshGeometry    const &rGeom,
+        ChunkMeshBufferInfo       const &rChInfo,
+        ChunkFillCache                  &rCache);
+
+/**
+ * @brief Copy cached fill vertex positions into a chunk, and remove them from the cache
+ *
+ * @return true if the key was cached, false if fill vertices need to be calculated
+ */
+bool chunk_fill_cache_take(
+        ChunkFillCache::Key       const &key,
+        ChunkId                         chunkId,
+        BasicChunkMeshGeometry          &rGeom,
+        ChunkMeshBufferInfo       const &rChInfo,
+        ChunkFillCache                  &rCache);
+
 /**
  * @brief Check a chunk and its neighbors if their stitches (fan triangles) need to be updated.
  *
@@ -78,6 +236,10 @@ void restitch_check(
  *
  * Fan triangles will be generated for newly added chunks. Fan triangles will be added or replaced
  * if a chunk command is enabled.
+ *
+ * Chunks are written at their ChunkScratchpad::reductions resolution. All faces of a chunk are
+ * rewritten if its reduction changed, or on any restitch of a reduced chunk, since its fan
+ * triangles aren't separate from the rest. Its fill vertices must already be calculated for it.
  */
 void update_faces(
         ChunkId                         chunkId,
@@ -90,6 +252,33 @@ void update_faces(
         ChunkScratchpad                 &rChSP,
         ChunkSkeleton                   &rSkCh);
 
+/**
+ * @brief Normalize fill vertex normals of ChunkScratchpad::chunksAdded and chunksRefaced, and
+ *        write normalized BasicChunkMeshGeometry::sharedNormalSum of sharedNormalsDirty to the
+ *        vertex buffer
+ *
+ * Call after update_faces for all chunks. Work is split into ranges by parallelFor, such as a
+ * task's WorkerContext::m_parallelFor, as each chunk and shared vertex only writes to its own
+ * normals.
+ */
+void finalize_normals(
+        BasicChunkMeshGeometry          &rGeom,
+        ChunkMeshBufferInfo       const &rChInfo,
+        ChunkScratchpad                 &rChSP,
+        osp::ParallelFor          const &parallelFor = {});
+
+/**
+ * @brief Calculate ranges of buffers modified since ChunkScratchpad::chunksDirty, sharedAdded,
+ *        and sharedNormalsDirty were last cleared
+ *
+ * Ranges of adjacent chunks and shared vertices are merged, so renderers can upload only what
+ * changed instead of the whole buffer.
+ */
+void find_dirty_ranges(
+        ChunkScratchpad           const &rChSP,
+        ChunkMeshBufferInfo       const &rChInfo,
+        ChunkMeshDirtyRanges            &rOut);
+
 /**
  * @brief Subtract normals from connected shared vertices when removing a chunk, or fan triangles
  *        only if fans are being redone.
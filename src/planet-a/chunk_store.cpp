@@ -0,0 +1,253 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "chunk_store.h"
+
+#include <filesystem>
+#include <system_error>
+
+#if defined(__linux__) || defined(__APPLE__)
+    #define OSP_CHUNK_STORE_MMAP 1
+    #include <sys/mman.h>
+    #include <unistd.h>
+#else
+    #define OSP_CHUNK_STORE_MMAP 0
+#endif
+
+using osp::ArrayView;
+using osp::Vector3;
+
+namespace planeta
+{
+
+namespace
+{
+
+constexpr char          gc_magic[8] = {'O', 'S', 'P', 'C', 'H', 'N', 'K', '\0'};
+constexpr std::uint32_t gc_endian   = 0x01020304;
+
+struct ChunkStoreHeader
+{
+    char            magic[8];
+    std::uint32_t   version;
+    std::uint32_t   endianCheck;
+    std::uint32_t   fillVrtxCount;
+    std::uint32_t   reserved;
+    std::uint64_t   paramsHash;
+};
+
+static_assert(std::is_trivially_copyable_v<ChunkStoreHeader>);
+static_assert(std::is_trivially_copyable_v<Vector3>);
+
+#if OSP_CHUNK_STORE_MMAP
+void munmap_deleter(unsigned char* pData, std::size_t size)
+{
+    ::munmap(pData, size);
+}
+#endif
+
+} // namespace
+
+ChunkStoreKey_t chunk_store_key(SkTriId const sktriId, SubdivTriangleSkeleton const& skel)
+{
+    std::uint32_t path  = 0;
+    std::uint32_t depth = 0;
+    SkTriId       tri   = sktriId;
+
+    // Walk up to the root triangle, collecting the sibling index at each level
+    while (true)
+    {
+        SkTriGroup const &rGroup = skel.tri_group_at(tri_group_id(tri));
+        if ( ! rGroup.parent.has_value() )
+        {
+            break;
+        }
+
+        path |= std::uint32_t(tri_sibling_index(tri)) << (2u * depth);
+        ++depth;
+        tri = rGroup.parent;
+    }
+    LGRN_ASSERTM(depth <= gc_maxSubdivLevels, "Subdivision path too deep");
+
+    // Reverse so paths read from the root downwards, keeping sibling order stable across depths
+    std::uint32_t rootFirst = 0;
+    for (std::uint32_t i = 0; i < depth; ++i)
+    {
+        rootFirst |= ((path >> (2u * i)) & 3u) << (2u * (depth - 1u - i));
+    }
+
+    return (ChunkStoreKey_t(tri.value) << 32) | (ChunkStoreKey_t(depth) << 24) | rootFirst;
+}
+
+EChunkStoreStatus ChunkDiskStore::open(
+        char          const* path,
+        std::uint64_t const  paramsHash,
+        std::uint32_t const  fillVrtxCount)
+{
+    close();
+    m_fillVrtxCount = fillVrtxCount;
+
+    ChunkStoreHeader const expectHeader
+    {
+        .magic          = {gc_magic[0], gc_magic[1], gc_magic[2], gc_magic[3],
+                           gc_magic[4], gc_magic[5], gc_magic[6], gc_magic[7]},
+        .version        = gc_chunkStoreVersion,
+        .endianCheck    = gc_endian,
+        .fillVrtxCount  = fillVrtxCount,
+        .reserved       = 0,
+        .paramsHash     = paramsHash
+    };
+
+    // Validate the header and index all complete records
+    std::uint64_t validEnd = 0;
+    {
+        decltype(m_pFile) pFile{std::fopen(path, "rb")};
+        ChunkStoreHeader header;
+        if (   pFile != nullptr
+            && std::fread(&header, sizeof(header), 1, pFile.get()) == 1
+            && std::memcmp(&header, &expectHeader, sizeof(header)) == 0)
+        {
+            std::fseek(pFile.get(), 0, SEEK_END);
+            std::uint64_t const fileSize = std::uint64_t(std::ftell(pFile.get()));
+
+            // A trailing partial record from a crash is ignored
+            validEnd = sizeof(header);
+            while (validEnd + record_size() <= fileSize)
+            {
+                ChunkStoreKey_t key;
+                if (   std::fseek(pFile.get(), long(validEnd), SEEK_SET) != 0
+                    || std::fread(&key, sizeof(key), 1, pFile.get()) != 1)
+                {
+                    break;
+                }
+
+                m_offsets.insert_or_assign(key, validEnd + sizeof(key));
+                validEnd += record_size();
+            }
+        }
+    }
+
+    if (validEnd == 0)
+    {
+        // Missing, corrupt, or made with different parameters
+        m_offsets.clear();
+        m_pFile.reset(std::fopen(path, "w+b"));
+        if (m_pFile == nullptr || std::fwrite(&expectHeader, sizeof(expectHeader), 1, m_pFile.get()) != 1)
+        {
+            m_pFile.reset();
+            return EChunkStoreStatus::CantOpen;
+        }
+        return EChunkStoreStatus::Created;
+    }
+
+    // Drop a partially written record left by a crash, so new records are appended after the
+    // last complete one
+    std::error_code error;
+    if (std::filesystem::file_size(path, error) != validEnd)
+    {
+        std::filesystem::resize_file(path, validEnd, error);
+        if (error)
+        {
+            m_offsets.clear();
+            return EChunkStoreStatus::CantOpen;
+        }
+    }
+
+    m_pFile.reset(std::fopen(path, "r+b"));
+    if (m_pFile == nullptr)
+    {
+        m_offsets.clear();
+        return EChunkStoreStatus::CantOpen;
+    }
+
+#if OSP_CHUNK_STORE_MMAP
+    void *const pMapped = ::mmap(nullptr, std::size_t(validEnd), PROT_READ, MAP_SHARED,
+                                 ::fileno(m_pFile.get()), 0);
+    if (pMapped != MAP_FAILED)
+    {
+        m_mapped = Corrade::Containers::Array<unsigned char>{
+                static_cast<unsigned char*>(pMapped), std::size_t(validEnd), munmap_deleter};
+    }
+#endif
+
+    return EChunkStoreStatus::Ok;
+}
+
+void ChunkDiskStore::close() noexcept
+{
+    m_mapped = {};
+    m_pFile.reset();
+    m_offsets.clear();
+}
+
+bool ChunkDiskStore::read(ChunkStoreKey_t const key, ArrayView<Vector3> const rOut)
+{
+    LGRN_ASSERT(rOut.size() == m_fillVrtxCount);
+
+    auto const found = m_offsets.find(key);
+    if (found == m_offsets.end())
+    {
+        ++m_stats.misses;
+        return false;
+    }
+
+    std::uint64_t const offset = found->second;
+    std::size_t   const size   = sizeof(Vector3) * m_fillVrtxCount;
+
+    if (offset + size <= m_mapped.size())
+    {
+        std::memcpy(rOut.data(), m_mapped.data() + offset, size);
+    }
+    else if (   std::fseek(m_pFile.get(), long(offset), SEEK_SET) != 0
+             || std::fread(rOut.data(), size, 1, m_pFile.get()) != 1)
+    {
+        ++m_stats.misses;
+        return false;
+    }
+
+    ++m_stats.hits;
+    return true;
+}
+
+void ChunkDiskStore::append(ChunkStoreKey_t const key, ArrayView<Vector3 const> const positions)
+{
+    LGRN_ASSERT(positions.size() == m_fillVrtxCount);
+
+    if ( ! is_open() || m_offsets.contains(key) )
+    {
+        return;
+    }
+
+    std::fseek(m_pFile.get(), 0, SEEK_END);
+    std::uint64_t const dataPos = std::uint64_t(std::ftell(m_pFile.get())) + sizeof(key);
+
+    if (   std::fwrite(&key, sizeof(key), 1, m_pFile.get()) == 1
+        && std::fwrite(positions.data(), sizeof(Vector3) * m_fillVrtxCount, 1, m_pFile.get()) == 1)
+    {
+        m_offsets.emplace(key, dataPos);
+        ++m_stats.appended;
+    }
+}
+
+} // namespace planeta
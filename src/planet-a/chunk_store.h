@@ -0,0 +1,188 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+/**
+ * @file
+ * @brief Append-only file of generated chunk fill vertices, reused across sessions
+ */
+#pragma once
+
+#include "skeleton.h"
+
+#include <osp/core/array_view.h>
+#include <osp/core/copymove_macros.h>
+#include <osp/core/math_types.h>
+
+#include <Corrade/Containers/Array.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+
+namespace planeta
+{
+
+/**
+ * @brief Version of the format used by ChunkDiskStore
+ *
+ * Increment whenever the layout of the header or records change.
+ */
+constexpr std::uint32_t gc_chunkStoreVersion = 1;
+
+/**
+ * @brief Identifies a skeleton triangle by root icosahedron face and its path of subdivisions
+ *
+ * Bits: [63..32] root SkTriId, [31..24] depth, [23..0] sibling indices, 2 bits per level from
+ * the root downwards. Unlike SkTriId, this is the same every time a planet is generated.
+ */
+using ChunkStoreKey_t = std::uint64_t;
+
+static_assert(gc_maxSubdivLevels * 2 <= 24, "Subdivision path doesn't fit in ChunkStoreKey_t");
+
+/**
+ * @return Key of a skeleton triangle, found by walking up its parents to a root triangle
+ */
+ChunkStoreKey_t chunk_store_key(SkTriId sktriId, SubdivTriangleSkeleton const& skel);
+
+/**
+ * @brief Hash the bytes of any number of trivially copyable values, such as planet parameters
+ */
+template <typename ... T>
+constexpr std::uint64_t chunk_store_params_hash(T const& ... values) noexcept
+{
+    static_assert((std::is_trivially_copyable_v<T> && ...));
+
+    // FNV-1a
+    std::uint64_t hash = 14695981039346656037ull;
+    auto const add = [&hash] (auto const& value)
+    {
+        unsigned char bytes[sizeof(value)];
+        std::memcpy(bytes, &value, sizeof(value));
+        for (unsigned char const byte : bytes)
+        {
+            hash = (hash ^ byte) * 1099511628211ull;
+        }
+    };
+    (add(values), ...);
+    return hash;
+}
+
+enum class EChunkStoreStatus : std::uint8_t
+{
+    /// Existing file opened, its chunks can be read
+    Ok,
+
+    /// No usable file existed, or it was written with different parameters. Now empty.
+    Created,
+
+    CantOpen
+};
+
+/**
+ * @brief Append-only file of chunk fill vertex positions, indexed by ChunkStoreKey_t
+ *
+ * The file is a header followed by records of { ChunkStoreKey_t, fillVrtxCount * Vector3 }.
+ * Records are never modified, so the part of the file that existed when it was opened is
+ * memory-mapped read-only where supported, and chunks are paged in with a single copy. Records
+ * appended during this session are read back with regular file reads.
+ *
+ * Only positions are stored; normals depend on neighboring chunks and stitching. The file is only
+ * readable by machines with the same endianness and float format.
+ *
+ * Not thread-safe.
+ */
+class ChunkDiskStore
+{
+public:
+
+    struct Stats
+    {
+        std::uint64_t hits      {0};
+        std::uint64_t misses    {0};
+        std::uint64_t appended  {0};
+    };
+
+    ChunkDiskStore() = default;
+    OSP_MOVE_ONLY_CTOR_ASSIGN(ChunkDiskStore);
+
+    /**
+     * @brief Open or create a store file, closing any previously opened one
+     *
+     * @param path          [in] File path
+     * @param paramsHash    [in] Hash of everything that affects generated vertices, see
+     *                           chunk_store_params_hash. Files with a different hash are discarded.
+     * @param fillVrtxCount [in] Fill vertices per chunk, ChunkMeshBufferInfo::fillVrtxCount
+     */
+    EChunkStoreStatus open(char const* path, std::uint64_t paramsHash, std::uint32_t fillVrtxCount);
+
+    void close() noexcept;
+
+    [[nodiscard]] bool is_open() const noexcept { return m_pFile != nullptr; }
+
+    /**
+     * @brief Copy a chunk's fill vertex positions from the file
+     *
+     * @param rOut  [out] Exactly fillVrtxCount positions, untouched if not found
+     *
+     * @return true if the key is stored
+     */
+    bool read(ChunkStoreKey_t key, osp::ArrayView<osp::Vector3> rOut);
+
+    /**
+     * @brief Append a chunk's fill vertex positions to the file. Does nothing if already stored.
+     */
+    void append(ChunkStoreKey_t key, osp::ArrayView<osp::Vector3 const> positions);
+
+    [[nodiscard]] Stats const& stats() const noexcept { return m_stats; }
+
+private:
+
+    std::size_t record_size() const noexcept
+    {
+        return sizeof(ChunkStoreKey_t) + sizeof(osp::Vector3) * m_fillVrtxCount;
+    }
+
+    /// Offset of each record's positions within the file
+    std::unordered_map<ChunkStoreKey_t, std::uint64_t>  m_offsets;
+
+    struct FileCloser
+    {
+        void operator()(std::FILE* pFile) const noexcept { std::fclose(pFile); }
+    };
+
+    std::unique_ptr<std::FILE, FileCloser> m_pFile;
+
+    /// Read-only mapping of the records that existed when the file was opened; may be empty
+    Corrade::Containers::Array<unsigned char> m_mapped;
+
+    std::uint32_t               m_fillVrtxCount     {0};
+
+    Stats                       m_stats;
+
+}; // class ChunkDiskStore
+
+} // namespace planeta
@@ -25,77 +25,283 @@
 
 #include "chunk_utils.h"
 
+#include <algorithm>
+#include <array>
+#include <vector>
+
 
 namespace planeta
 {
 
-ChunkFillSubdivLUT make_chunk_vrtx_subdiv_lut(std::uint8_t const subdivLevel)
+namespace
 {
-    ChunkFillSubdivLUT out;
 
-    out.m_edgeVrtxCount = 1u << subdivLevel;
-    out.m_fillVrtxCount = (out.m_edgeVrtxCount-2) * (out.m_edgeVrtxCount-1) / 2;
+using LUTVrtx  = ChunkFillSubdivLUT::LUTVrtx;
+using ToSubdiv = ChunkFillSubdivLUT::ToSubdiv;
+
+/// Position within a chunk, plain struct so generation can run at compile time
+struct LUTCoord
+{
+    std::uint16_t x;
+    std::uint16_t y;
+};
+
+constexpr LUTCoord lut_midpoint(LUTCoord const a, LUTCoord const b) noexcept
+{
+    return { std::uint16_t((a.x + b.x) / 2), std::uint16_t((a.y + b.y) / 2) };
+}
 
-    out.m_data.reserve(out.m_fillVrtxCount);
+/**
+ * @brief Generates ChunkFillSubdivLUT tables, usable both at compile time and at runtime
+ */
+struct LUTGenerator
+{
+    constexpr LUTGenerator(std::uint8_t const subdivLevel)
+     : edgeVrtxCount{std::uint16_t(1u << subdivLevel)}
+     , fillVrtxCount{std::uint16_t((edgeVrtxCount-2) * (edgeVrtxCount-1) / 2)}
+    {
+        data.reserve(fillVrtxCount);
 
-    // Calculate LUT, this fills m_data
-    out.fill_tri_recurse({0,                   0              },
-                         {0,                   out.m_edgeVrtxCount},
-                         {out.m_edgeVrtxCount, out.m_edgeVrtxCount},
+        // Calculate LUT, this fills data
+        fill_tri_recurse({0,             0            },
+                         {0,             edgeVrtxCount},
+                         {edgeVrtxCount, edgeVrtxCount},
                          subdivLevel);
 
-    return out;
+        sort_into_batches();
+    }
 
-    // Future optimization:
-    // m_data can be sorted in a way that slightly improves cache locality
-    // by accessing to fill vertices in a more sequential order.
-}
+    constexpr LUTVrtx id_at(LUTCoord const pos) const noexcept
+    {
+        ChunkLocalSharedId const shared = coord_to_shared(pos.x, pos.y, edgeVrtxCount);
+        if (shared.has_value())
+        {
+            return LUTVrtx(fillVrtxCount + std::uint16_t(shared));
+        }
 
-void ChunkFillSubdivLUT::subdiv_line_recurse(
-        Vector2us const a, Vector2us const b, std::uint8_t const level)
-{
-    Vector2us const mid = (a + b) / 2;
+        return LUTVrtx(xy_to_triangular(pos.x - 1, pos.y - 2));
+    }
+
+    /**
+     * @param a     [in]
+     * @param b     [in]
+     * @param level [in] Number of times this line can be subdivided further
+     */
+    constexpr void subdiv_line_recurse(LUTCoord const a, LUTCoord const b, std::uint8_t const level)
+    {
+        LUTCoord const mid = lut_midpoint(a, b);
+
+        ChunkLocalSharedId const out = ChunkLocalSharedId(xy_to_triangular(mid.x - 1, mid.y - 2));
+
+        data.push_back(ToSubdiv{id_at(a), id_at(b), out});
+
+        if (level > 1)
+        {
+            subdiv_line_recurse(a, mid, level - 1);
+            subdiv_line_recurse(mid, b, level - 1);
+        }
+    }
+
+    constexpr void fill_tri_recurse(LUTCoord const top, LUTCoord const lft, LUTCoord const rte, std::uint8_t const level)
+    {
+        // calculate midpoints
+        std::array<LUTCoord, 3> const mid
+        {{
+            lut_midpoint(top, lft),
+            lut_midpoint(lft, rte),
+            lut_midpoint(rte, top)
+        }};
+
+        std::uint8_t const levelNext = level - 1;
 
-    ChunkLocalSharedId const out = ChunkLocalSharedId(xy_to_triangular(mid.x() - 1, mid.y() - 2));
+        // make lines between them
+        if (level > 1)
+        {
+            subdiv_line_recurse(mid[0], mid[1], levelNext);
+            subdiv_line_recurse(mid[1], mid[2], levelNext);
+            subdiv_line_recurse(mid[2], mid[0], levelNext);
+        }
 
-    m_data.emplace_back(ToSubdiv{id_at(a), id_at(b), out});
+        if (level > 2)
+        {
+            fill_tri_recurse(   top, mid[0], mid[2], levelNext); // top
+            fill_tri_recurse(mid[0],    lft, mid[1], levelNext); // left
+            fill_tri_recurse(mid[1], mid[2], mid[0], levelNext); // center
+            fill_tri_recurse(mid[2], mid[1],    rte, levelNext); // right
+        }
+    }
 
-    if (level > 1)
+    /**
+     * @brief Sort data into batches by dependency depth
+     *
+     * Depth of a fill vertex is 1 + the depth of the deepest fill vertex it's calculated from,
+     * and shared vertices have a depth of 0. Stable sort keeps the recursion order within a
+     * batch. Each vertex is still calculated from the same inputs, so the results don't change.
+     */
+    constexpr void sort_into_batches()
     {
-        subdiv_line_recurse(a, mid, level - 1);
-        subdiv_line_recurse(mid, b, level - 1);
+        std::vector<std::uint8_t> fillDepth(fillVrtxCount + 1u, 0u);
+        auto const depth_of = [this, &fillDepth] (LUTVrtx const vrtx) -> std::uint8_t
+        {
+            auto const vrtxInt = std::uint16_t(vrtx);
+            return (vrtxInt > fillVrtxCount) ? 0u : fillDepth[vrtxInt];
+        };
+
+        std::vector<std::uint8_t> entryDepth;
+        entryDepth.reserve(data.size());
+        std::uint8_t maxDepth = 0;
+        for (ToSubdiv const& toSubdiv : data)
+        {
+            auto const depth = std::uint8_t(1u + std::max(depth_of(toSubdiv.m_vrtxA), depth_of(toSubdiv.m_vrtxB)));
+            fillDepth[toSubdiv.m_fillOut.value] = depth;
+            entryDepth.push_back(depth);
+            maxDepth = std::max(maxDepth, depth);
+        }
+
+        std::vector<ToSubdiv> sorted;
+        sorted.reserve(data.size());
+        for (std::uint8_t depth = 1; depth <= maxDepth; ++depth)
+        {
+            batchOffsets.push_back(std::uint32_t(sorted.size()));
+            for (std::size_t i = 0; i < data.size(); ++i)
+            {
+                if (entryDepth[i] == depth)
+                {
+                    sorted.push_back(data[i]);
+                }
+            }
+        }
+        batchOffsets.push_back(std::uint32_t(sorted.size()));
+        data = std::move(sorted);
     }
 
+    std::vector<ToSubdiv>       data;
+    std::vector<std::uint32_t>  batchOffsets;
+    std::uint16_t               edgeVrtxCount;
+    std::uint16_t               fillVrtxCount;
+};
+
+/**
+ * @brief LUT tables of a subdiv level, generated at compile time
+ *
+ * Static storage duration and constexpr, so they end up in read-only data shared by all terrains,
+ * threads, and processes.
+ */
+template <std::uint8_t LEVEL_T>
+struct BakedLUT
+{
+    static constexpr std::size_t smc_dataSize         = LUTGenerator{LEVEL_T}.data.size();
+    static constexpr std::size_t smc_batchOffsetsSize = LUTGenerator{LEVEL_T}.batchOffsets.size();
+
+    struct Tables
+    {
+        std::array<ToSubdiv,      smc_dataSize>         data{};
+        std::array<std::uint32_t, smc_batchOffsetsSize> batchOffsets{};
+    };
+
+    static constexpr Tables smc_tables = [] ()
+    {
+        LUTGenerator const gen{LEVEL_T};
+        Tables out;
+        std::copy(gen.data.begin(),         gen.data.end(),         out.data.begin());
+        std::copy(gen.batchOffsets.begin(), gen.batchOffsets.end(), out.batchOffsets.begin());
+        return out;
+    }();
+};
+
+template <std::uint8_t LEVEL_T>
+bool assign_baked_lut(
+        std::uint8_t                        const subdivLevel,
+        osp::ArrayView<ToSubdiv const>            &rData,
+        osp::ArrayView<std::uint32_t const>       &rBatchOffsets) noexcept
+{
+    if constexpr (LEVEL_T <= ChunkFillSubdivLUT::smc_bakedMax)
+    {
+        if (subdivLevel != LEVEL_T)
+        {
+            return assign_baked_lut<LEVEL_T + 1>(subdivLevel, rData, rBatchOffsets);
+        }
+
+        auto const &tables = BakedLUT<LEVEL_T>::smc_tables;
+        rData         = {tables.data.data(),         tables.data.size()};
+        rBatchOffsets = {tables.batchOffsets.data(), tables.batchOffsets.size()};
+        return true;
+    }
+    else
+    {
+        return false;
+    }
 }
 
-void ChunkFillSubdivLUT::fill_tri_recurse(
-        Vector2us const top, Vector2us const lft, Vector2us const rte, std::uint8_t const level)
+} // namespace
+
+ChunkFillSubdivLUT make_chunk_vrtx_subdiv_lut(std::uint8_t const subdivLevel, std::uint8_t const reduction)
 {
-    // calculate midpoints
-    std::array<Vector2us, 3> const mid
-    {{
-        (top + lft) / 2,
-        (lft + rte) / 2,
-        (rte + top) / 2
-    }};
-
-    std::uint8_t const levelNext = level - 1;
-
-    // make lines between them
-    if (level > 1)
+    ChunkFillSubdivLUT out;
+
+    out.m_edgeVrtxCount = 1u << subdivLevel;
+    out.m_fillVrtxCount = (out.m_edgeVrtxCount-2) * (out.m_edgeVrtxCount-1) / 2;
+
+    if ( ! assign_baked_lut<ChunkFillSubdivLUT::smc_bakedMin>(subdivLevel, out.m_data, out.m_batchOffsets) )
+    {
+        LUTGenerator gen{subdivLevel};
+        out.m_ownData         = std::move(gen.data);
+        out.m_ownBatchOffsets = std::move(gen.batchOffsets);
+    }
+    else if (reduction != 0)
+    {
+        out.m_ownData        .assign(out.m_data.begin(),         out.m_data.end());
+        out.m_ownBatchOffsets.assign(out.m_batchOffsets.begin(), out.m_batchOffsets.end());
+    }
+
+    if (reduction != 0)
     {
-        subdiv_line_recurse(mid[0], mid[1], levelNext);
-        subdiv_line_recurse(mid[1], mid[2], levelNext);
-        subdiv_line_recurse(mid[2], mid[0], levelNext);
+        LGRN_ASSERTMV(reduction <= max_chunk_reduction(subdivLevel), "Reduction not supported", reduction, subdivLevel);
+
+        // Keep fill vertices on the coarse grid used by reduced_chunk_faces. Vertices of a
+        // subdivision step are midpoints of vertices twice as far apart, so the kept entries only
+        // read shared vertices and other kept fill vertices, and are still in dependency order.
+        std::uint32_t const spacing = 1u << reduction;
+        std::vector<bool> keep(out.m_fillVrtxCount, false);
+        for (std::uint32_t y = 2; y < out.m_edgeVrtxCount; ++y)
+        {
+            for (std::uint32_t x = 1; x < y; ++x)
+            {
+                keep[std::size_t(xy_to_triangular(int(x) - 1, int(y) - 2))] = (x % spacing == 0) && (y % spacing == 0);
+            }
+        }
+
+        std::vector<ToSubdiv>      data;
+        std::vector<std::uint32_t> batchOffsets;
+        for (std::size_t batch = 0; batch + 1 < out.m_ownBatchOffsets.size(); ++batch)
+        {
+            std::size_t const batchFirst = data.size();
+            for (std::uint32_t i = out.m_ownBatchOffsets[batch]; i < out.m_ownBatchOffsets[batch + 1]; ++i)
+            {
+                if (keep[out.m_ownData[i].m_fillOut.value])
+                {
+                    data.push_back(out.m_ownData[i]);
+                }
+            }
+
+            if (data.size() != batchFirst)
+            {
+                batchOffsets.push_back(std::uint32_t(batchFirst));
+            }
+        }
+        batchOffsets.push_back(std::uint32_t(data.size()));
+
+        out.m_ownData         = std::move(data);
+        out.m_ownBatchOffsets = std::move(batchOffsets);
     }
 
-    if (level > 2)
+    if ( ! out.m_ownBatchOffsets.empty() )
     {
-        fill_tri_recurse(   top, mid[0], mid[2], levelNext); // top
-        fill_tri_recurse(mid[0],    lft, mid[1], levelNext); // left
-        fill_tri_recurse(mid[1], mid[2], mid[0], levelNext); // center
-        fill_tri_recurse(mid[2], mid[1],    rte, levelNext); // right
+        out.m_data         = {out.m_ownData.data(),         out.m_ownData.size()};
+        out.m_batchOffsets = {out.m_ownBatchOffsets.data(), out.m_ownBatchOffsets.size()};
     }
+
+    return out;
 }
 
 } // namespace planeta
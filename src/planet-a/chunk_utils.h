@@ -191,12 +191,14 @@ constexpr ReturnThingUvU chunk_coord_to_vrtx(
 /**
  * @brief Stores a procedure on which combinations of vertices need to be
  *        subdivided to calculate chunk fill vertices.
+ *
+ * Tables for subdiv levels smc_bakedMin to smc_bakedMax are generated at compile time and stored
+ * as read-only static arrays shared by all LUTs of the same level. Other levels are generated
+ * when the LUT is made.
  */
 class ChunkFillSubdivLUT
 {
 public:
-    using Vector2us = Magnum::Math::Vector2<std::uint16_t>;
-
     // Can either be a shared vertex or fill vertex
     // Fill vertex if (0 to m_chunkVrtxCount-1)
     // Shared vertex if m_chunkVrtxCount to (m_edgeVrtxCount*3-1)
@@ -223,42 +225,62 @@ public:
                         : fillOffset + lutVrtxInt;
     }
 
-    constexpr std::vector<ToSubdiv> const& data() const noexcept { return m_data; }
+    static constexpr std::uint8_t smc_bakedMin = 2;
+    static constexpr std::uint8_t smc_bakedMax = 6;
 
-    friend ChunkFillSubdivLUT make_chunk_vrtx_subdiv_lut(std::uint8_t subdivLevel);
-
-private:
+    ChunkFillSubdivLUT() = default;
+    ChunkFillSubdivLUT(ChunkFillSubdivLUT const& copy) = delete;
+    ChunkFillSubdivLUT(ChunkFillSubdivLUT&& move) = default;
+    ChunkFillSubdivLUT& operator=(ChunkFillSubdivLUT const& copy) = delete;
+    ChunkFillSubdivLUT& operator=(ChunkFillSubdivLUT&& move) = default;
 
-    constexpr LUTVrtx id_at(Vector2us const pos) const noexcept
-    {
-        ChunkLocalSharedId const shared = coord_to_shared(pos.x(), pos.y(), m_edgeVrtxCount);
-        if (shared.has_value())
-        {
-            return LUTVrtx(m_fillVrtxCount + std::uint16_t(shared));
-        }
+    constexpr osp::ArrayView<ToSubdiv const> data() const noexcept { return m_data; }
 
-        return LUTVrtx(xy_to_triangular(pos.x() - 1, pos.y() - 2));
-    };
+    /// Vertices along each chunk edge, identifies which chunk subdiv level this LUT is for
+    constexpr std::uint16_t edge_vrtx_count() const noexcept { return m_edgeVrtxCount; }
 
     /**
-     * @brief subdiv_edge_recurse
+     * @brief Offsets into data() that split it into batches, last one is data().size()
      *
-     * @param a     [in]
-     * @param b     [in]
-     * @param level [in] Number of times this line can be subdivided further
+     * A ToSubdiv never reads a fill vertex written by another ToSubdiv from the same batch, so
+     * all entries of a batch can be calculated at once.
      */
-    void subdiv_line_recurse(Vector2us a, Vector2us b, std::uint8_t level);
+    constexpr osp::ArrayView<std::uint32_t const> batch_offsets() const noexcept { return m_batchOffsets; }
 
-    void fill_tri_recurse(Vector2us top, Vector2us lft, Vector2us rte, std::uint8_t level);
+    friend ChunkFillSubdivLUT make_chunk_vrtx_subdiv_lut(std::uint8_t subdivLevel, std::uint8_t reduction);
+
+private:
+
+    /// Views either the baked tables or m_ownData and m_ownBatchOffsets
+    osp::ArrayView<ToSubdiv const>      m_data;
+    osp::ArrayView<std::uint32_t const> m_batchOffsets;
+
+    /// Only used for subdiv levels that aren't baked. Moving keeps their buffers in place, so the
+    /// views above stay valid, but copies would not; hence no copy constructor.
+    std::vector<ToSubdiv>               m_ownData;
+    std::vector<std::uint32_t>          m_ownBatchOffsets;
 
-    //std::unique_ptr<ToSubdiv[]> m_data;
-    std::vector<ToSubdiv> m_data;
     std::uint16_t m_fillVrtxCount{0};
     std::uint16_t m_edgeVrtxCount{0};
 
 }; // class ChunkFillSubdivLUT
 
-ChunkFillSubdivLUT make_chunk_vrtx_subdiv_lut(std::uint8_t subdivLevel);
+/**
+ * @brief Make a LUT for chunks of a subdiv level
+ *
+ * @param reduction [in] Only calculate fill vertices used by chunks at this reduced resolution,
+ *                       see reduced_chunk_faces. 0 for all fill vertices.
+ */
+ChunkFillSubdivLUT make_chunk_vrtx_subdiv_lut(std::uint8_t subdivLevel, std::uint8_t reduction = 0);
+
+/**
+ * @return Max resolution reduction supported by chunks of a subdiv level, see reduced_chunk_faces
+ */
+constexpr std::uint8_t max_chunk_reduction(std::uint8_t const chunkSubdivLevel) noexcept
+{
+    // Needs at least a single triangle in the middle, 4 steps of 2^reduction along each edge
+    return (chunkSubdivLevel > 2) ? std::uint8_t(chunkSubdivLevel - 2) : std::uint8_t(0);
+}
 
 
 //-----------------------------------------------------------------------------
@@ -596,4 +618,125 @@ void ChunkFanStitcher<WRITER_T>::edge() const
 }
 
 
+//-----------------------------------------------------------------------------
+
+/**
+ * @brief Position within a chunk in half steps between vertices, see reduced_chunk_faces
+ */
+struct ChunkHalfCoord
+{
+    std::uint16_t x;
+    std::uint16_t y;
+};
+
+/**
+ * @brief Triangulate a chunk with its fill vertices spaced 2^reduction steps apart
+ *
+ * Calls addFace(a, b, c) with ChunkHalfCoords for each triangle, wound the same way as faces of
+ * full resolution chunks.
+ *
+ * Every shared vertex along the chunk's edges is still used, so edges look the same to neighbors
+ * at any reduction, and neighbors don't need to be restitched when it changes. A coarse triangle
+ * grid in the middle is connected to the edges by a ring of triangles. Coordinates are in half
+ * steps so the extra vertices of a detailX2 edge can be addressed; odd coordinates only appear
+ * along that edge.
+ *
+ * @param chunkWidth    [in] ChunkSkeleton::m_chunkEdgeVrtxCount
+ * @param reduction     [in] 1 to max_chunk_reduction
+ * @param detailX2Edge  [in] Own edge with a detailX2 stitch [left, bottom, right], -1 if none
+ */
+template <typename FUNC_T>
+constexpr void reduced_chunk_faces(
+        std::uint16_t   const chunkWidth,
+        std::uint8_t    const reduction,
+        int             const detailX2Edge,
+        FUNC_T          &&addFace)
+{
+    int const n = chunkWidth;
+    int const s = 1 << reduction;
+    int const k = n / s - 3; // Steps along each edge of the coarse triangle in the middle
+
+    LGRN_ASSERTMV(reduction > 0 && k >= 1, "Reduction not supported", reduction, chunkWidth);
+
+    auto const half = [] (int const x, int const y) noexcept
+    {
+        return ChunkHalfCoord{ std::uint16_t(x), std::uint16_t(y) };
+    };
+
+    // Coarse grid in the middle, corners at (s, 2s), (s, n-s), and (n-2s, n-s)
+    auto const inner = [half, s] (int const u, int const v) noexcept
+    {
+        return half(2 * (s + s*u), 2 * (2*s + s*v));
+    };
+
+    for (int v = 0; v < k; ++v)
+    {
+        for (int u = 0; u <= v; ++u)
+        {
+            addFace(inner(u, v), inner(u, v+1), inner(u+1, v+1));
+            if (u < v)
+            {
+                addFace(inner(u, v), inner(u+1, v+1), inner(u+1, v));
+            }
+        }
+    }
+
+    // Ring between each chunk edge and the matching edge of the coarse grid. Each is a trapezoid
+    // with points along its two parallel sides, so zipping them together from one end to the
+    // other never overlaps.
+    for (int edge = 0; edge < 3; ++edge)
+    {
+        int const step      = (edge == detailX2Edge) ? 1 : 2;
+        int const outerSize = 2 * n / step;
+
+        auto const outer_at = [half, edge, step, n] (int const i) noexcept
+        {
+            switch (edge)
+            {
+            case 0:  return half(0,                i * step);
+            case 1:  return half(i * step,         2 * n);
+            default: return half(2*n - i * step,   2*n - i * step);
+            }
+        };
+
+        auto const inner_at = [inner, edge, k] (int const j) noexcept
+        {
+            switch (edge)
+            {
+            case 0:  return inner(0,     j);
+            case 1:  return inner(j,     k);
+            default: return inner(k - j, k - j);
+            }
+        };
+
+        int i = 0;
+        int j = 0;
+        while (i < outerSize || j < k)
+        {
+            // Advance whichever side's next segment has its midpoint closer to the start
+            bool const advanceOuter = (j == k) || (i < outerSize && (2*i + 1) * k <= (2*j + 1) * outerSize);
+            if (advanceOuter)
+            {
+                addFace(outer_at(i), outer_at(i + 1), inner_at(j));
+                ++i;
+            }
+            else
+            {
+                addFace(outer_at(i), inner_at(j + 1), inner_at(j));
+                ++j;
+            }
+        }
+    }
+}
+
+/**
+ * @return Number of faces added by reduced_chunk_faces
+ */
+constexpr std::uint32_t reduced_chunk_face_count(
+        std::uint16_t const chunkWidth, std::uint8_t const reduction, bool const detailX2) noexcept
+{
+    std::uint32_t const k = chunkWidth / (1u << reduction) - 3;
+    return k*k + 3*k + 3*chunkWidth + (detailX2 ? chunkWidth : 0);
+}
+
 } // namespace planeta
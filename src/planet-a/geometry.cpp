@@ -40,6 +40,8 @@ void BasicChunkMeshGeometry::resize(ChunkSkeleton const& skCh, ChunkMeshBufferIn
     chunkFanNormalContrib  .resize(maxChunks * info.fanMaxSharedCount);
     chunkFillSharedNormals .resize(maxChunks * skCh.m_chunkSharedCount, osp::Vector3{osp::ZeroInit});
     sharedNormalSum        .resize(maxSharedVrtx, osp::Vector3{osp::ZeroInit});
+    chunkReduction         .resize(maxChunks, 0);
+    chunkFillReduction     .resize(maxChunks, 0);
 }
 
 } // namespace planeta
@@ -32,11 +32,31 @@
 #include "skeleton.h"
 #include "chunk_utils.h"
 
+#include <osp/core/aligned_allocator.h>
+#include <osp/core/large_alloc.h>
 #include <osp/core/math_int64.h>
 
+#include <cmath>
+#include <string_view>
+#include <vector>
+
 namespace planeta
 {
 
+/**
+ * @brief Subsystem of the biggest terrain buffers, for osp::large_alloc_policy_set
+ */
+struct TerrainGeometryMem
+{
+    static constexpr std::string_view smc_name = "terrain_geometry";
+};
+
+template <typename T>
+using TerrainAlloc_t = osp::LargeAllocator<T, TerrainGeometryMem, osp::gc_simdAlignment>;
+
+template <typename ID_T, typename DATA_T>
+using TerrainKeyedVec_t = osp::KeyedVec<ID_T, DATA_T, TerrainAlloc_t<DATA_T>>;
+
 /**
  * @brief Position and normal data for \c SubdivTriangleSkeleton
  */
@@ -50,16 +70,74 @@ struct SkeletonVertexData
         centers  .resize(triCapacity);
         positions.resize(vrtxCapacity);
         normals  .resize(vrtxCapacity);
+
+        if (compactShift >= 0)
+        {
+            centersCompact.resize(triCapacity);
+        }
     }
 
-    osp::KeyedVec<planeta::SkVrtxId, osp::Vector3l> positions;
-    osp::KeyedVec<planeta::SkVrtxId, osp::Vector3>  normals;
-    osp::KeyedVec<planeta::SkTriId,  osp::Vector3l> centers;
+    /**
+     * @brief Apply a remap from SubdivTriangleSkeleton::tri_group_reorder
+     */
+    void remap_tris(SkTriGroupRemap const& remap)
+    {
+        if (remap.changed)
+        {
+            remap.apply(centers);
+            remap.apply(centersCompact);
+        }
+    }
+
+    /**
+     * @brief Set a triangle center, also writing centersCompact if enabled
+     */
+    void set_center(planeta::SkTriId const sktriId, osp::Vector3l const center) noexcept
+    {
+        centers[sktriId] = center;
+        if (compactShift >= 0)
+        {
+            centersCompact[sktriId] = osp::Vector3i{center >> compactShift};
+        }
+    }
+
+    TerrainKeyedVec_t<planeta::SkVrtxId, osp::Vector3l>  positions;
+    TerrainKeyedVec_t<planeta::SkVrtxId, osp::Vector3>   normals;
+    TerrainKeyedVec_t<planeta::SkTriId,  osp::Vector3l>  centers;
+
+    /// Copy of centers in 32-bit, shifted right by compactShift. Half the size of centers, used
+    /// by distance tests when subdividing and unsubdividing. Mesh output uses full precision.
+    TerrainKeyedVec_t<planeta::SkTriId,  osp::Vector3i>  centersCompact;
+
+    /// Bits dropped from centersCompact, -1 if disabled. See compact_shift_for.
+    int compactShift{-1};
 
     /// For the Vector3l variables used in this struct. 2^precision units = 1 meter
     int precision{};
 };
 
+/**
+ * @brief Pick a SkeletonVertexData::compactShift that fits all positions within maxUnits of the
+ *        origin in 32 bits
+ *
+ * @param maxUnits      [in] Max distance of any center from the origin, in Vector3l units
+ * @param minThreshold  [in] Smallest distance threshold to be tested against
+ *
+ * @return Shift, or -1 if the rounding error would be too large compared to minThreshold
+ */
+constexpr int compact_shift_for(std::uint64_t const maxUnits, std::uint64_t const minThreshold) noexcept
+{
+    // Leave 1 bit of headroom so differences between two compact values stay representable
+    int shift = 0;
+    while ((maxUnits >> shift) >= (std::uint64_t(1) << 30))
+    {
+        ++shift;
+    }
+
+    // Rounding error is under 2^shift per axis. Keep it under ~1% of the threshold.
+    return ((std::uint64_t(1) << shift) * 128 <= minThreshold) ? shift : -1;
+}
+
 /**
  * @brief Contributions to \c BasicChunkMeshGeometry::sharedNormalSum
  *
@@ -83,9 +161,9 @@ struct BasicChunkMeshGeometry
 {
     void resize(ChunkSkeleton const& skCh, ChunkMeshBufferInfo const& info);
 
-    std::vector<osp::Vector3>           chunkVbufPos;
-    std::vector<osp::Vector3>           chunkVbufNrm;
-    std::vector<osp::Vector3u>          chunkIbuf;
+    std::vector<osp::Vector3,  TerrainAlloc_t<osp::Vector3>>    chunkVbufPos;
+    std::vector<osp::Vector3,  TerrainAlloc_t<osp::Vector3>>    chunkVbufNrm;
+    std::vector<osp::Vector3u, TerrainAlloc_t<osp::Vector3u>>   chunkIbuf;
 
     /// See \c FanNormalContrib; 2D, each row is \c ChunkMeshBufferInfo::fanMaxSharedCount
     std::vector<planeta::FanNormalContrib>              chunkFanNormalContrib;
@@ -95,6 +173,13 @@ struct BasicChunkMeshGeometry
 
     /// Non-normalized sum of face normals of connected faces
     osp::KeyedVec<planeta::SharedVrtxId, osp::Vector3>  sharedNormalSum;
+
+    /// Resolution reduction of each chunk's faces, see reduced_chunk_faces. 0 is full resolution.
+    osp::KeyedVec<planeta::ChunkId, std::uint8_t>       chunkReduction;
+
+    /// Lowest reduction each chunk's fill vertex positions are calculated for. Only chunks at 0
+    /// have all of their fill vertices, and can be stored in a ChunkFillCache or ChunkDiskStore.
+    osp::KeyedVec<planeta::ChunkId, std::uint8_t>       chunkFillReduction;
 };
 
 /**
@@ -102,9 +187,10 @@ struct BasicChunkMeshGeometry
  *
  * See \c CFaceWriter
  *
- * TODO: Add vertex angle calculations for more accurate vertex normals. Vertex normals look fine
- *       for the most part, but are actually calculated incorrectly. Face Normals added to
- *       sharedNormalSum should be scaled depending on the vertex angle.
+ * Face normals added to vertices are weighted by the face's angle at that vertex, so vertices
+ * with faces of uneven sizes around them (such as along fan stitches) still get correct normals.
+ * The weighted values are what's recorded in FanNormalContrib and fillNormalContrib, so they
+ * can be subtracted exactly when faces are removed.
  */
 struct TerrainFaceWriter
 {
@@ -122,15 +208,16 @@ struct TerrainFaceWriter
     {
         SharedVrtxId const shared = sharedUsed[local.value];
 
-        fillNormalContrib[local.value]  += selectedFaceNormal;
-        sharedNormalSum  [shared.value] += selectedFaceNormal;
+        osp::Vector3 const weighted = angle_weighted_normal(vertex);
+        fillNormalContrib[local.value]  += weighted;
+        sharedNormalSum  [shared.value] += weighted;
 
         rSharedNormalsDirty.insert(shared);
     }
 
     void fill_add_normal_filled(VertexIdx const vertex)
     {
-        vbufNrm[vertex] += selectedFaceNormal;
+        vbufNrm[vertex] += angle_weighted_normal(vertex);
     }
 
     void fan_add_face(VertexIdx a, VertexIdx b, VertexIdx c) noexcept
@@ -144,7 +231,8 @@ struct TerrainFaceWriter
 
     void fan_add_normal_shared(VertexIdx const vertex, SharedVrtxId const shared)
     {
-        sharedNormalSum[shared.value] += selectedFaceNormal;
+        osp::Vector3 const weighted = angle_weighted_normal(vertex);
+        sharedNormalSum[shared.value] += weighted;
 
         // Record contributions to shared vertex normal, since this needs to be subtracted when
         // the associated chunk is removed or restitched.
@@ -192,7 +280,7 @@ struct TerrainFaceWriter
             LGRN_ASSERT(contribLast != fanNormalContrib.end());
         }
 
-        rContrib.sum += selectedFaceNormal;
+        rContrib.sum += weighted;
     }
 
     void calculate_face_normal(VertexIdx a, VertexIdx b, VertexIdx c)
@@ -202,6 +290,26 @@ struct TerrainFaceWriter
         selectedFaceNormal = Magnum::Math::cross(u, v).normalized();
     }
 
+    /**
+     * @return selectedFaceNormal scaled by the angle (radians) of the selected face at vertex
+     */
+    osp::Vector3 angle_weighted_normal(VertexIdx const vertex) const
+    {
+        // Rotate corners so that 'vertex' is first
+        VertexIdx const a = vertex;
+        VertexIdx const b = (selectedFaceIndx[0] == vertex) ? selectedFaceIndx[1]
+                          : (selectedFaceIndx[1] == vertex) ? selectedFaceIndx[2] : selectedFaceIndx[0];
+        VertexIdx const c = (selectedFaceIndx[0] == vertex) ? selectedFaceIndx[2]
+                          : (selectedFaceIndx[1] == vertex) ? selectedFaceIndx[0] : selectedFaceIndx[1];
+
+        osp::Vector3 const u = vbufPos[b] - vbufPos[a];
+        osp::Vector3 const v = vbufPos[c] - vbufPos[a];
+
+        // atan2 is well-behaved for the very thin triangles found in fan stitches, unlike acos
+        float const angle = std::atan2(Magnum::Math::cross(u, v).length(), Magnum::Math::dot(u, v));
+        return selectedFaceNormal * angle;
+    }
+
     osp::ArrayView<osp::Vector3 const>  vbufPos;
     osp::ArrayView<osp::Vector3>        vbufNrm;
     osp::ArrayView<osp::Vector3>        sharedNormalSum;
@@ -219,3 +327,29 @@ static_assert(CFaceWriter<TerrainFaceWriter>, "TerrainFaceWriter must satisfy co
 
 
 } // namespace planeta
+
+namespace osp
+{
+
+template <>
+struct MemoryUsage<planeta::SkeletonVertexData>
+{
+    static std::size_t heap_bytes(planeta::SkeletonVertexData const& skData) noexcept
+    {
+        return heap_bytes_sum(skData.positions, skData.normals, skData.centers, skData.centersCompact);
+    }
+};
+
+template <>
+struct MemoryUsage<planeta::BasicChunkMeshGeometry>
+{
+    static std::size_t heap_bytes(planeta::BasicChunkMeshGeometry const& geom) noexcept
+    {
+        return heap_bytes_sum(
+                geom.chunkVbufPos, geom.chunkVbufNrm, geom.chunkIbuf, geom.chunkFanNormalContrib,
+                geom.chunkFillSharedNormals, geom.sharedNormalSum, geom.chunkReduction,
+                geom.chunkFillReduction);
+    }
+};
+
+} // namespace osp
@@ -0,0 +1,148 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "height_noise.h"
+
+#include <osp/core/math_2pow.h>
+
+#include <algorithm>
+
+namespace planeta
+{
+
+namespace
+{
+
+// Bits of fraction used for positions within a cell and for noise values
+constexpr int           gc_fracBits = 16;
+constexpr std::int64_t  gc_fracOne  = std::int64_t(1) << gc_fracBits;
+constexpr std::int64_t  gc_fracMask = gc_fracOne - 1;
+
+constexpr std::int64_t lattice_hash(std::int64_t const x, std::int64_t const y, std::int64_t const z, std::uint32_t const seed) noexcept
+{
+    std::uint32_t h = seed;
+    h ^= std::uint32_t(x) * 0x8da6b343u;
+    h ^= std::uint32_t(y) * 0xd8163841u;
+    h ^= std::uint32_t(z) * 0xcb1ab31fu;
+    h ^= h >> 15;
+    h *= 0x2c1b3c6du;
+    h ^= h >> 12;
+    h *= 0x297a2d39u;
+    h ^= h >> 15;
+    return std::int64_t(h >> (32 - gc_fracBits)); // [0, gc_fracOne)
+}
+
+/// Smoothstep 3t^2 - 2t^3 of a [0, gc_fracOne) fraction
+constexpr std::int64_t fade(std::int64_t const t) noexcept
+{
+    return (t * t * (3 * gc_fracOne - 2 * t)) >> (2 * gc_fracBits);
+}
+
+constexpr std::int64_t lerp(std::int64_t const a, std::int64_t const b, std::int64_t const t) noexcept
+{
+    return a + (((b - a) * t) >> gc_fracBits);
+}
+
+/// Split a coordinate into a cell index and a gc_fracBits fraction within the cell
+constexpr void to_cell(std::int64_t const p, int const cellPow, std::int64_t &rCell, std::int64_t &rFrac) noexcept
+{
+    rCell = p >> cellPow;
+    rFrac = (cellPow >= gc_fracBits) ? ((p >> (cellPow - gc_fracBits)) & gc_fracMask)
+                                     : ((p << (gc_fracBits - cellPow)) & gc_fracMask);
+}
+
+} // namespace
+
+void height_noise_batch(
+        osp::ArrayView<SkVrtxId const>  const vertices,
+        HeightNoiseParams               const &params,
+        SkeletonVertexData                    &rSkData,
+        HeightNoiseScratch                    &rScratch)
+{
+    std::size_t const count = vertices.size();
+    if (count == 0 || params.octaves <= 0)
+    {
+        return;
+    }
+
+    rScratch.x  .resize(count);
+    rScratch.y  .resize(count);
+    rScratch.z  .resize(count);
+    rScratch.sum.assign(count, 0);
+
+    std::int64_t *const px  = rScratch.x.data();
+    std::int64_t *const py  = rScratch.y.data();
+    std::int64_t *const pz  = rScratch.z.data();
+    std::int64_t *const sum = rScratch.sum.data();
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        osp::Vector3l const pos = rSkData.positions[vertices[i]];
+        px[i] = pos.x();
+        py[i] = pos.y();
+        pz[i] = pos.z();
+    }
+
+    std::int64_t ampTotal = 0;
+
+    for (int octave = 0; octave < params.octaves; ++octave)
+    {
+        int           const cellPow = std::max(params.cellPow - octave, 1);
+        std::int64_t  const amp     = gc_fracOne >> std::min(octave, gc_fracBits);
+        std::uint32_t const seed    = params.seed + std::uint32_t(octave) * 0x9e3779b9u;
+        ampTotal += amp;
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            std::int64_t cx, cy, cz, fx, fy, fz;
+            to_cell(px[i], cellPow, cx, fx);
+            to_cell(py[i], cellPow, cy, fy);
+            to_cell(pz[i], cellPow, cz, fz);
+
+            std::int64_t const tx = fade(fx);
+            std::int64_t const ty = fade(fy);
+            std::int64_t const tz = fade(fz);
+
+            // Trilinear interpolation between the 8 corners of the cell
+            std::int64_t const x00 = lerp(lattice_hash(cx, cy,   cz,   seed), lattice_hash(cx+1, cy,   cz,   seed), tx);
+            std::int64_t const x10 = lerp(lattice_hash(cx, cy+1, cz,   seed), lattice_hash(cx+1, cy+1, cz,   seed), tx);
+            std::int64_t const x01 = lerp(lattice_hash(cx, cy,   cz+1, seed), lattice_hash(cx+1, cy,   cz+1, seed), tx);
+            std::int64_t const x11 = lerp(lattice_hash(cx, cy+1, cz+1, seed), lattice_hash(cx+1, cy+1, cz+1, seed), tx);
+
+            std::int64_t const value = lerp(lerp(x00, x10, ty), lerp(x01, x11, ty), tz);
+
+            sum[i] += (value * amp) >> gc_fracBits;
+        }
+    }
+
+    // Displace along normals. sum / ampTotal is in [0, 1)
+    float const scale = float(osp::math::int_2pow<std::int64_t>(rSkData.precision)) * params.amplitude / float(ampTotal);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        SkVrtxId const vrtx = vertices[i];
+        rSkData.positions[vrtx] += osp::Vector3l(rSkData.normals[vrtx] * (float(sum[i]) * scale));
+    }
+}
+
+} // namespace planeta
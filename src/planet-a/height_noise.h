@@ -0,0 +1,84 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+/**
+ * @file
+ * @brief Batched fixed-point value noise for displacing skeleton vertices
+ */
+#pragma once
+
+#include "geometry.h"
+
+#include <osp/core/array_view.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace planeta
+{
+
+struct HeightNoiseParams
+{
+    /// Noise cells of the first octave are 2^cellPow Vector3l units wide
+    int             cellPow     {12};
+
+    /// Number of octaves, each half the cell width and half the amplitude of the previous
+    int             octaves     {4};
+
+    /// Max displacement in meters. Output is [0, amplitude) along the vertex normal.
+    float           amplitude   {1.0f};
+
+    std::uint32_t   seed        {0};
+};
+
+/**
+ * @brief Reusable structure-of-arrays buffers for height_noise_batch
+ */
+struct HeightNoiseScratch
+{
+    std::vector<std::int64_t> x, y, z;
+    std::vector<std::int64_t> sum;
+};
+
+/**
+ * @brief Displace vertices outwards along their normals by value noise of their position
+ *
+ * Noise is evaluated entirely in integers on SkeletonVertexData::positions, so results are
+ * deterministic across platforms and precise far from the origin. Vertices are processed in
+ * structure-of-arrays form one octave at a time, which compilers can vectorize.
+ *
+ * Noise is sampled at the current positions, so vertices must not have been displaced already.
+ *
+ * @param vertices  [in] New vertices to displace
+ * @param params    [in] Noise parameters
+ * @param rSkData   [ref] Positions to read and displace, normals to displace along
+ * @param rScratch  [ref] Scratch buffers
+ */
+void height_noise_batch(
+        osp::ArrayView<SkVrtxId const>  vertices,
+        HeightNoiseParams const         &params,
+        SkeletonVertexData              &rSkData,
+        HeightNoiseScratch              &rScratch);
+
+} // namespace planeta
@@ -25,6 +25,8 @@
 
 #include "icosahedron.h"
 
+#include <cmath>
+
 namespace planeta
 {
 
@@ -180,6 +182,70 @@ void ico_calc_chunk_edge(
 }
 
 
+void ico_calc_chunk_fill(
+        double                                  const radius,
+        ChunkFillSubdivLUT                      const &lut,
+        osp::ArrayView<SharedVrtxOwner_t const> const sharedUsed,
+        std::uint32_t                           const fillOffset,
+        std::uint32_t                           const sharedOffset,
+        osp::ArrayView<osp::Vector3>            const vbufPos,
+        ChunkFillScratch                              &rScratch)
+{
+    using ToSubdiv = ChunkFillSubdivLUT::ToSubdiv;
+
+    osp::ArrayView<ToSubdiv const>      const data    = lut.data();
+    osp::ArrayView<std::uint32_t const> const offsets = lut.batch_offsets();
+
+    for (std::size_t batch = 0; batch + 1 < offsets.size(); ++batch)
+    {
+        std::size_t const first = offsets[batch];
+        std::size_t const count = offsets[batch + 1] - first;
+
+        rScratch.ax.resize(count); rScratch.ay.resize(count); rScratch.az.resize(count);
+        rScratch.bx.resize(count); rScratch.by.resize(count); rScratch.bz.resize(count);
+
+        float *const ax = rScratch.ax.data();
+        float *const ay = rScratch.ay.data();
+        float *const az = rScratch.az.data();
+        float *const bx = rScratch.bx.data();
+        float *const by = rScratch.by.data();
+        float *const bz = rScratch.bz.data();
+
+        // Gather
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            ToSubdiv      const &toSubdiv = data[first + i];
+            osp::Vector3  const a = vbufPos[lut.index(sharedUsed, fillOffset, sharedOffset, toSubdiv.m_vrtxA)];
+            osp::Vector3  const b = vbufPos[lut.index(sharedUsed, fillOffset, sharedOffset, toSubdiv.m_vrtxB)];
+            ax[i] = a.x(); ay[i] = a.y(); az[i] = a.z();
+            bx[i] = b.x(); by[i] = b.y(); bz[i] = b.z();
+        }
+
+        // Midpoint, then move it onto the sphere. Results are written back over A.
+        // Heightmap goes here (2)
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            float const mx = (ax[i] + bx[i]) / 2.0f;
+            float const my = (ay[i] + by[i]) / 2.0f;
+            float const mz = (az[i] + bz[i]) / 2.0f;
+
+            // Same as Magnum's Vector3::length(), and radius is subtracted as a double
+            float const len       = std::sqrt(mx*mx + my*my + mz*mz);
+            float const roundness = float(radius - len);
+
+            ax[i] = mx + (mx / len) * roundness;
+            ay[i] = my + (my / len) * roundness;
+            az[i] = mz + (mz / len) * roundness;
+        }
+
+        // Scatter
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            vbufPos[fillOffset + data[first + i].m_fillOut.value] = {ax[i], ay[i], az[i]};
+        }
+    }
+}
+
 void ico_calc_sphere_tri_center(
         SkTriGroupId            const groupId,
         float                   const maxRadius,
@@ -217,7 +283,7 @@ void ico_calc_sphere_tri_center(
         // / 3.0f                           : average from sum of 3 values
         osp::Vector3l const riseToMid = osp::Vector3l(nrmSum * (0.5f * terrainMaxHeight * osp::math::int_2pow<int>(rSkData.precision) / 3.0f));
 
-        rSkData.centers[sktriId] = posAvg + riseToMid;
+        rSkData.set_center(sktriId, posAvg + riseToMid);
     }
 }
 
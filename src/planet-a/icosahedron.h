@@ -172,6 +172,41 @@ void ico_calc_chunk_edge(
         SkeletonVertexData                                      &rSkData);
 
 
+/**
+ * @brief Reusable structure-of-arrays buffers for ico_calc_chunk_fill
+ *
+ * Keep one per thread.
+ */
+struct ChunkFillScratch
+{
+    std::vector<float> ax, ay, az;
+    std::vector<float> bx, by, bz;
+};
+
+/**
+ * @brief Calculate positions of a chunk's fill vertices, projected onto the sphere
+ *
+ * Each batch of ChunkFillSubdivLUT::batch_offsets is gathered into SoA form so the midpoint and
+ * projection math can be vectorized. Operations are the same and in the same order as
+ * calculating each ToSubdiv one at a time, so the results are bit-identical.
+ *
+ * @param radius        [in] Radius of icosahedron in meters
+ * @param lut           [in] Fill vertex LUT for the chunk subdiv level
+ * @param sharedUsed    [in] Shared vertices used by the chunk
+ * @param fillOffset    [in] Index of the chunk's first fill vertex in vbufPos
+ * @param sharedOffset  [in] Index of the first shared vertex in vbufPos
+ * @param vbufPos       [ref] Chunk vertex positions, reads shared and writes fill vertices
+ * @param rScratch      [ref] Scratch buffers
+ */
+void ico_calc_chunk_fill(
+        double                                      radius,
+        ChunkFillSubdivLUT                    const &lut,
+        osp::ArrayView<SharedVrtxOwner_t const>     sharedUsed,
+        std::uint32_t                               fillOffset,
+        std::uint32_t                               sharedOffset,
+        osp::ArrayView<osp::Vector3>                vbufPos,
+        ChunkFillScratch                            &rScratch);
+
 /**
  * @brief Calculate center of a triangle given a spherical terrain mesh, writes to sktriCenter
  *
@@ -277,6 +277,106 @@ void SubdivTriangleSkeleton::tri_unsubdiv(SkTriId triId, SkeletonTriangle &rTri)
     rTri.children = lgrn::id_null<SkTriGroupId>();
 }
 
+SkTriGroupRemap SubdivTriangleSkeleton::tri_group_reorder()
+{
+    SkTriGroupRemap remap;
+    remap.oldToNew.resize(m_triGroupIds.capacity(), lgrn::id_null<SkTriGroupId>());
+
+    // Breadth-first order: roots, then children of each group in the order they're reached
+    std::vector<SkTriGroupId> order;
+    order.reserve(m_triGroupIds.size());
+    for (SkTriGroupId const groupId : m_triGroupIds)
+    {
+        if ( ! m_triGroupData[groupId].parent.has_value() )
+        {
+            order.push_back(groupId);
+        }
+    }
+    for (std::size_t i = 0; i < order.size(); ++i)
+    {
+        for (SkeletonTriangle const& rTri : m_triGroupData[order[i]].triangles)
+        {
+            if (rTri.children.has_value())
+            {
+                order.push_back(rTri.children);
+            }
+        }
+    }
+    LGRN_ASSERTMV(order.size() == m_triGroupIds.size(), "Unreachable triangle groups",
+                  order.size(), m_triGroupIds.size());
+
+    // A fresh registry hands out IDs in ascending order
+    lgrn::IdRegistryStl<SkTriGroupId> newIds;
+    newIds.reserve(m_triGroupIds.capacity());
+    for (SkTriGroupId const oldId : order)
+    {
+        SkTriGroupId const newId = newIds.create();
+        remap.oldToNew[oldId] = newId;
+        remap.changed |= (newId != oldId);
+    }
+
+    if ( ! remap.changed )
+    {
+        return remap;
+    }
+
+    osp::KeyedVec<SkTriGroupId, SkTriGroup> newData;
+    newData.resize(m_triGroupData.size());
+
+    for (SkTriGroupId const oldId : order)
+    {
+        SkTriGroup &rOld = m_triGroupData[oldId];
+        SkTriGroup &rNew = newData[remap(oldId)];
+
+        rNew.depth  = rOld.depth;
+        rNew.parent = rOld.parent.has_value() ? remap(rOld.parent) : lgrn::id_null<SkTriId>();
+
+        for (int i = 0; i < 4; ++i)
+        {
+            SkeletonTriangle &rOldTri = rOld.triangles[i];
+            SkeletonTriangle &rNewTri = rNew.triangles[i];
+
+            rNewTri.vertices = std::move(rOldTri.vertices);
+            rNewTri.children = rOldTri.children.has_value() ? remap(rOldTri.children) : lgrn::id_null<SkTriGroupId>();
+
+            // Owners can't be reassigned, store the new ID then release the old one. Refcounts
+            // end up the same, since every owner is replaced.
+            for (int j = 0; j < 3; ++j)
+            {
+                if (rOldTri.neighbors[j].has_value())
+                {
+                    SkTriId const oldNeighbor = rOldTri.neighbors[j];
+                    rNewTri.neighbors[j] = tri_store(remap(oldNeighbor));
+                    tri_release(std::move(rOldTri.neighbors[j]));
+                }
+            }
+        }
+    }
+
+    m_triGroupIds  = std::move(newIds);
+    m_triGroupData = std::move(newData);
+    tri_group_resize_fit_ids();
+
+    for (Level &rLvl : levels)
+    {
+        remap.apply(rLvl.hasSubdivedNeighbor);
+        remap.apply(rLvl.hasNonSubdivedNeighbor);
+    }
+
+    return remap;
+}
+
+void SkTriGroupRemap::apply(lgrn::IdSetStl<SkTriId> &rSet) const
+{
+    std::vector<SkTriId> const oldIds(rSet.begin(), rSet.end());
+    rSet.clear();
+    for (SkTriId const oldId : oldIds)
+    {
+        LGRN_ASSERTMV(oldToNew[tri_group_id(oldId)].has_value(), "Set contains a deleted triangle", oldId.value);
+        rSet.insert((*this)(oldId));
+    }
+}
+
 
 void SubdivTriangleSkeleton::debug_check_invariants()
 {
@@ -458,6 +558,20 @@ osp::MaybeNewId<SharedVrtxId> ChunkSkeleton::shared_get_or_create(SkVrtxId const
 }
 
 
+void ChunkSkeleton::remap_tris(SkTriGroupRemap const& remap)
+{
+    if ( ! remap.changed )
+    {
+        return;
+    }
+
+    for (ChunkId const chunkId : m_chunkIds)
+    {
+        m_chunkToTri[chunkId] = remap(m_chunkToTri[chunkId]);
+    }
+    remap.apply(m_triToChunk);
+}
+
 void ChunkSkeleton::clear(SubdivTriangleSkeleton& rSkel)
 {
     // Release associated skeleton triangles from chunks
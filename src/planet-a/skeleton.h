@@ -37,6 +37,7 @@
 #include <osp/core/copymove_macros.h>
 #include <osp/core/keyed_vector.h>
 #include <osp/core/math_2pow.h>
+#include <osp/core/memory_usage.h>
 
 #include <longeron/id_management/id_set_stl.hpp>
 
@@ -120,6 +121,60 @@ struct SkTriGroupPair
     SkTriGroup& rGroup;
 };
 
+/**
+ * @brief Old to new Triangle Group IDs, returned by SubdivTriangleSkeleton::tri_group_reorder
+ *
+ * Triangle IDs keep their sibling index, only their group changes.
+ */
+struct SkTriGroupRemap
+{
+    [[nodiscard]] SkTriGroupId operator()(SkTriGroupId const oldId) const noexcept
+    {
+        return oldToNew[oldId];
+    }
+
+    [[nodiscard]] SkTriId operator()(SkTriId const oldId) const noexcept
+    {
+        return tri_id(oldToNew[tri_group_id(oldId)], tri_sibling_index(oldId));
+    }
+
+    /**
+     * @brief Remap all IDs in a set
+     */
+    void apply(lgrn::IdSetStl<SkTriId> &rSet) const;
+
+    /**
+     * @brief Move elements of a container indexed by Triangle ID to their new positions
+     *
+     * Elements of removed triangles are not preserved.
+     */
+    template <typename DATA_T, typename ALLOC_T>
+    void apply(osp::KeyedVec<SkTriId, DATA_T, ALLOC_T> &rVec) const
+    {
+        osp::KeyedVec<SkTriId, DATA_T, ALLOC_T> moved;
+        moved.resize(rVec.size());
+        for (std::size_t oldGroup = 0; oldGroup < oldToNew.size(); ++oldGroup)
+        {
+            SkTriGroupId const newGroup = oldToNew[SkTriGroupId(std::uint32_t(oldGroup))];
+            if ( ! newGroup.has_value() || (oldGroup * 4 + 4) > rVec.size() )
+            {
+                continue;
+            }
+            for (std::uint8_t i = 0; i < 4; ++i)
+            {
+                moved[tri_id(newGroup, i)] = std::move(rVec[tri_id(SkTriGroupId(std::uint32_t(oldGroup)), i)]);
+            }
+        }
+        rVec = std::move(moved);
+    }
+
+    /// Null for IDs that didn't exist
+    osp::KeyedVec<SkTriGroupId, SkTriGroupId> oldToNew;
+
+    /// False if no IDs changed, and nothing needs to be remapped
+    bool changed{false};
+};
+
 /**
  * @brief A subdividable mesh with reference counted triangles and vertices.
  *
@@ -298,6 +353,20 @@ public:
 
     void tri_unsubdiv(SkTriId triId, SkeletonTriangle &rTri);
 
+    /**
+     * @brief Re-index all Triangle Groups breadth-first, starting from the root groups
+     *
+     * After many subdivide/unsubdivide cycles, reused IDs leave siblings and neighbors scattered
+     * in m_triGroupData. Afterwards, groups are sorted by depth, and children of neighboring
+     * triangles are stored close together.
+     *
+     * levels are remapped internally. Everything else holding Triangle or Triangle Group IDs must
+     * be remapped using the returned SkTriGroupRemap, see SkeletonVertexData::remap_tris,
+     * SkeletonSubdivScratchpad::remap_tris, and ChunkSkeleton::remap_tris. Vertex IDs are not
+     * affected.
+     */
+    SkTriGroupRemap tri_group_reorder();
+
     /**
      * @brief Store a Triangle ID in ref-counted long term storage
      *
@@ -412,6 +481,8 @@ private:
 
     // access using SkTriGroupId from m_triGroupIds
     osp::KeyedVec<SkTriGroupId, SkTriGroup> m_triGroupData;
+
+    template <typename> friend struct osp::MemoryUsage;
 }; // class SubdivTriangleSkeleton
 
 
@@ -558,6 +629,11 @@ public:
 
     void clear(SubdivTriangleSkeleton& rSkel);
 
+    /**
+     * @brief Apply a remap from SubdivTriangleSkeleton::tri_group_reorder
+     */
+    void remap_tris(SkTriGroupRemap const& remap);
+
 //private:
 
     lgrn::IdRegistryStl<ChunkId, true>          m_chunkIds;
@@ -590,3 +666,30 @@ inline ChunkSkeleton make_skeleton_chunks(uint8_t const subdivLevels)
 }
 
 }
+
+namespace osp
+{
+
+/// Doesn't count the bitsets of SubdivTriangleSkeleton::levels or refcounts, which are small
+/// next to the triangle groups
+template <>
+struct MemoryUsage<planeta::SubdivTriangleSkeleton>
+{
+    static std::size_t heap_bytes(planeta::SubdivTriangleSkeleton const& skel) noexcept
+    {
+        return heap_bytes_sum(skel.m_vertexIds, skel.m_triGroupIds, skel.m_triGroupData);
+    }
+};
+
+template <>
+struct MemoryUsage<planeta::ChunkSkeleton>
+{
+    static std::size_t heap_bytes(planeta::ChunkSkeleton const& skCh) noexcept
+    {
+        return heap_bytes_sum(
+                skCh.m_chunkIds, skCh.m_chunkSharedUsed, skCh.m_chunkStitch, skCh.m_chunkToTri,
+                skCh.m_triToChunk, skCh.m_sharedIds, skCh.m_sharedToSkVrtx, skCh.m_skVrtxToShared);
+    }
+};
+
+} // namespace osp
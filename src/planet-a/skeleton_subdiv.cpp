@@ -24,12 +24,147 @@
  */
 #include "skeleton_subdiv.h"
 
+#include <osp/core/bitvector.h>
+#include <osp/util/profiling.h>
+
+#include <algorithm>
+#include <array>
+#include <type_traits>
+
 using osp::Vector3;
 using osp::Vector3l;
 
 namespace planeta
 {
 
+namespace
+{
+
+/**
+ * @brief Distance-test each triangle in tris, possibly split into ranges by parallelFor
+ *
+ * Only reads from rSkData, so this is safe to parallelize. Triangles where
+ * is_distance_near(...) == WANT_NEAR are written to rLvlSP.distanceTestPassed[0...return value].
+ * Reading these vectors in order gives the same order as tris.
+ *
+ * @return Number of vectors written to in rLvlSP.distanceTestPassed
+ */
+template <bool WANT_NEAR>
+std::size_t distance_test(
+        Vector3l                    const pos,
+        std::uint64_t               const threshold,
+        std::vector<SkTriId>        const &tris,
+        SkeletonVertexData          const &rSkData,
+        osp::ParallelFor            const &parallelFor,
+        SubdivScratchpadLevel             &rLvlSP)
+{
+    std::size_t const maxChunks = std::max<std::size_t>(1, tris.size() / SkeletonSubdivScratchpad::smc_distanceTestMinPerThread);
+    std::size_t const chunks    = std::clamp<std::size_t>(parallelFor.m_threads, 1, maxChunks);
+
+    if (rLvlSP.distanceTestPassed.size() < chunks)
+    {
+        rLvlSP.distanceTestPassed.resize(chunks);
+    }
+
+    // Centers are gathered into small blocks on the stack, then tested together with
+    // is_distance_near_batch, which vectorizes
+    auto const test_blocks = [&tris] (std::size_t const first, std::size_t const last, auto const& centers, Vector3l const testPos, std::uint64_t const testThreshold, std::vector<SkTriId> &rOut) noexcept
+    {
+        using vec_t = std::remove_cvref_t<decltype(centers[SkTriId{}])>;
+        constexpr std::size_t blockSize = 256;
+
+        std::array<vec_t, blockSize>        block;
+        std::array<std::uint8_t, blockSize> isNear;
+
+        for (std::size_t blockFirst = first; blockFirst < last; blockFirst += blockSize)
+        {
+            std::size_t const count = std::min(blockSize, last - blockFirst);
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                block[i] = centers[tris[blockFirst + i]];
+            }
+
+            osp::is_distance_near_batch<vec_t>({block.data(), count}, testPos, testThreshold, {isNear.data(), count});
+
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                if ((isNear[i] != 0) == WANT_NEAR)
+                {
+                    rOut.push_back(tris[blockFirst + i]);
+                }
+            }
+        }
+    };
+
+    auto const test_range = [pos, threshold, &rSkData, &test_blocks] (std::size_t const first, std::size_t const last, std::vector<SkTriId> &rOut) noexcept
+    {
+        rOut.clear();
+        int const shift = rSkData.compactShift;
+        if (shift >= 0)
+        {
+            // Reads half as much memory. Rounding is under 2^shift per axis, which is small
+            // compared to thresholds, see compact_shift_for.
+            Vector3l      const posCompact       = pos >> shift;
+            std::uint64_t const thresholdCompact = (threshold + (std::uint64_t(1) << shift >> 1)) >> shift;
+            test_blocks(first, last, rSkData.centersCompact, posCompact, thresholdCompact, rOut);
+            return;
+        }
+
+        test_blocks(first, last, rSkData.centers, pos, threshold, rOut);
+    };
+
+    if (chunks == 1)
+    {
+        test_range(0, tris.size(), rLvlSP.distanceTestPassed[0]);
+        return 1;
+    }
+
+    auto const chunk_begin = [count = tris.size(), chunks] (std::size_t const chunk) noexcept
+    {
+        return count * chunk / chunks;
+    };
+
+    parallelFor(chunks, chunks, [&test_range, &chunk_begin, &rLvlSP] (std::size_t const first, std::size_t const last)
+    {
+        for (std::size_t chunk = first; chunk < last; ++chunk)
+        {
+            test_range(chunk_begin(chunk), chunk_begin(chunk + 1), rLvlSP.distanceTestPassed[chunk]);
+        }
+    });
+
+    return chunks;
+}
+
+/**
+ * @brief Merge per-thread distance test results into distanceTestPassed[0], sorted nearest first
+ */
+void sort_passed_by_distance(
+        Vector3l                    const pos,
+        std::size_t                 const chunks,
+        SkeletonVertexData          const &rSkData,
+        SubdivScratchpadLevel             &rLvlSP)
+{
+    std::vector<SkTriId> &rMerged = rLvlSP.distanceTestPassed[0];
+    for (std::size_t chunk = 1; chunk < chunks; ++chunk)
+    {
+        rMerged.insert(rMerged.end(), rLvlSP.distanceTestPassed[chunk].begin(), rLvlSP.distanceTestPassed[chunk].end());
+    }
+
+    // Only ordering matters, so double precision is enough even far from the origin
+    auto const distance_sq = [pos, &rSkData] (SkTriId const sktriId) noexcept
+    {
+        Vector3l const diff = rSkData.centers[sktriId] - pos;
+        return osp::Vector3d(diff).dot();
+    };
+
+    std::stable_sort(rMerged.begin(), rMerged.end(), [&distance_sq] (SkTriId const lhs, SkTriId const rhs)
+    {
+        return distance_sq(lhs) < distance_sq(rhs);
+    });
+}
+
+} // namespace
+
 void SkeletonSubdivScratchpad::resize(SubdivTriangleSkeleton &rSkel)
 {
     auto const triCapacity = rSkel.tri_group_ids().capacity() * 4;
@@ -41,12 +176,28 @@ void SkeletonSubdivScratchpad::resize(SubdivTriangleSkeleton &rSkel)
     surfaceRemoved  .resize(triCapacity);
 }
 
+void SkeletonSubdivScratchpad::remap_tris(SkTriGroupRemap const& remap)
+{
+    LGRN_ASSERTM(surfaceRemoved.begin() == surfaceRemoved.end(),
+                 "surfaceRemoved refers to deleted triangles, use it up first");
+    LGRN_ASSERTM(   distanceTestDone.begin() == distanceTestDone.end()
+                 && tryUnsubdiv     .begin() == tryUnsubdiv     .end()
+                 && cantUnsubdiv    .begin() == cantUnsubdiv    .end(),
+                 "Can't remap while subdividing or unsubdividing");
+
+    if (remap.changed)
+    {
+        remap.apply(surfaceAdded);
+    }
+}
+
 void unsubdivide_select_by_distance(
         std::uint8_t             const lvl,
         osp::Vector3l            const pos,
         SubdivTriangleSkeleton   const &rSkel,
         SkeletonVertexData       const &rSkData,
-        SkeletonSubdivScratchpad       &rSP)
+        SkeletonSubdivScratchpad       &rSP,
+        osp::ParallelFor         const &parallelFor)
 {
     SubdivTriangleSkeleton::Level const& rLvl   = rSkel.levels[lvl];
     SubdivScratchpadLevel&               rLvlSP = rSP  .levels[lvl];
@@ -90,26 +241,26 @@ void unsubdivide_select_by_distance(
         std::swap(rLvlSP.distanceTestProcessing, rLvlSP.distanceTestNext);
         rLvlSP.distanceTestNext.clear();
 
-        for (SkTriId const sktriId : rLvlSP.distanceTestProcessing)
-        {
-            Vector3l const center = rSkData.centers[sktriId];
-            bool const tooFar = ! osp::is_distance_near(pos, center, rSP.distanceThresholdUnsubdiv[lvl]);
+        // Parallel phase: find triangles too far away
+        std::size_t const chunks = distance_test<false>(
+                pos, rSP.distanceThresholdUnsubdiv[lvl], rLvlSP.distanceTestProcessing, rSkData, parallelFor, rLvlSP);
 
+        // Serial phase: select them and floodfill
+        for (std::size_t chunk = 0; chunk < chunks; ++chunk)
+        for (SkTriId const sktriId : rLvlSP.distanceTestPassed[chunk])
+        {
             LGRN_ASSERTM(rSkel.tri_at(sktriId).children.has_value(),
                          "Non-subdivided triangles must not be added to distance test.");
 
-            if (tooFar)
-            {
-                // All checks passed
-                rSP.tryUnsubdiv.insert(sktriId);
+            // All checks passed
+            rSP.tryUnsubdiv.insert(sktriId);
 
-                // Floodfill by checking neighbors next
-                SkeletonTriangle const& sktri = rSkel.tri_at(sktriId);
-                for (SkTriId const neighbor : sktri.neighbors)
-                if (neighbor.has_value())
-                {
-                    maybe_distance_check(neighbor);
-                }
+            // Floodfill by checking neighbors next
+            SkeletonTriangle const& sktri = rSkel.tri_at(sktriId);
+            for (SkTriId const neighbor : sktri.neighbors)
+            if (neighbor.has_value())
+            {
+                maybe_distance_check(neighbor);
             }
         }
     }
@@ -203,6 +354,8 @@ void unsubdivide_level(
         SkeletonVertexData          &rSkData,
         SkeletonSubdivScratchpad    &rSP)
 {
+    OSP_PROFILE_ZONE("planeta::unsubdivide_level");
+
     auto const wont_unsubdivide = [&rSP] (SkTriId const sktriId) -> bool
     {
         return ( ! rSP.tryUnsubdiv.contains(sktriId) || rSP.cantUnsubdiv.contains(sktriId) );
@@ -211,8 +364,9 @@ void unsubdivide_level(
     SubdivTriangleSkeleton::Level   &rLvl   = rSkel.levels[lvl];
     SubdivScratchpadLevel           &rLvlSP = rSP  .levels[lvl];
 
-    for (SkTriId const sktriId : rSP.tryUnsubdiv)
-    if ( ! rSP.cantUnsubdiv.contains(sktriId) )
+    // Neither set is modified in the loop, so walk (tryUnsubdiv & ~cantUnsubdiv) a word at a time
+    for (SkTriId const sktriId : osp::bit_ones_andnot<SkTriId>(osp::bit_words(rSP.tryUnsubdiv),
+                                                              osp::bit_words(rSP.cantUnsubdiv)))
     {
         // All checks passed, 100% confirmed sktri will be unsubdivided
         SkeletonTriangle &rTri = rSkel.tri_at(sktriId);
@@ -319,6 +473,15 @@ SkTriGroupId subdivide(
 
     rSP.onSubdiv(sktriId, groupId, corners, middlesNew, rSkel, rSkData, rSP.onSubdivUserData);
 
+    if (rSP.onVrtxBatch != nullptr)
+    {
+        for (osp::MaybeNewId<SkVrtxId> const middle : middlesNew)
+        if (middle.isNew)
+        {
+            rSP.vrtxBatch.push_back(middle.id);
+        }
+    }
+
     if (hasNextLevel)
     {
         rSP.levels[lvl+1].distanceTestNext.insert(rSP.levels[lvl+1].distanceTestNext.end(), {
@@ -498,13 +661,27 @@ SkTriGroupId subdivide(
 }
 
 
+void flush_vrtx_batch(
+        SkeletonVertexData          &rSkData,
+        SkeletonSubdivScratchpad    &rSP)
+{
+    if (rSP.onVrtxBatch != nullptr && ! rSP.vrtxBatch.empty())
+    {
+        rSP.onVrtxBatch({rSP.vrtxBatch.data(), rSP.vrtxBatch.size()}, rSkData, rSP.onVrtxBatchUserData);
+    }
+    rSP.vrtxBatch.clear();
+}
+
 void subdivide_level_by_distance(
         Vector3l              const pos,
         std::uint8_t          const lvl,
         SubdivTriangleSkeleton      &rSkel,
         SkeletonVertexData          &rSkData,
-        SkeletonSubdivScratchpad    &rSP)
+        SkeletonSubdivScratchpad    &rSP,
+        osp::ParallelFor      const &parallelFor)
 {
+    OSP_PROFILE_ZONE("planeta::subdivide_level_by_distance");
+
     LGRN_ASSERT(lvl == rSP.levelNeedProcess);
 
     SubdivTriangleSkeleton::Level &rLvl   = rSkel.levels[lvl];
@@ -517,38 +694,57 @@ void subdivide_level_by_distance(
         std::swap(rLvlSP.distanceTestProcessing, rLvlSP.distanceTestNext);
         rLvlSP.distanceTestNext.clear();
 
-        for (SkTriId const sktriId : rLvlSP.distanceTestProcessing)
+        // Parallel phase: find nearby triangles. Only reads centers, which don't change for
+        // existing triangles, so results stay valid while subdividing below.
+        std::size_t chunks = distance_test<true>(
+                pos, rSP.distanceThresholdSubdiv[lvl], rLvlSP.distanceTestProcessing, rSkData, parallelFor, rLvlSP);
+        rSP.distanceCheckCount += rLvlSP.distanceTestProcessing.size();
+
+        // With a limited budget, spend it on the nearest triangles first
+        if (rSP.subdivBudgetLeft != SkeletonSubdivScratchpad::smc_unlimited)
         {
-            Vector3l const center = rSkData.centers[sktriId];
+            sort_passed_by_distance(pos, chunks, rSkData, rLvlSP);
+            chunks = 1;
+        }
 
+        // Serial phase: subdivide them. subdivide(...) may recurse and resize rSkData, so this
+        // must not overlap with the parallel phase.
+        for (std::size_t chunk = 0; chunk < chunks; ++chunk)
+        for (SkTriId const sktriId : rLvlSP.distanceTestPassed[chunk])
+        {
             LGRN_ASSERT(rSP.distanceTestDone.contains(sktriId));
-            bool const distanceNear = osp::is_distance_near(pos, center, rSP.distanceThresholdSubdiv[lvl]);
-            ++rSP.distanceCheckCount;
 
-            if (distanceNear)
+            // May already be subdivided, from an earlier frame or an invariant fix earlier in
+            // this wave. Results of the parallel phase are still valid, as centers are unchanged.
+            SkeletonTriangle &rTri = rSkel.tri_at(sktriId);
+            if (rTri.children.has_value())
             {
-                SkeletonTriangle &rTri = rSkel.tri_at(sktriId);
-                if (rTri.children.has_value())
+                if (hasNextLevel)
                 {
-                    if (hasNextLevel)
-                    {
-                        SkTriGroupId const children = rTri.children;
-                        rSP.levels[lvl+1].distanceTestNext.insert(rSP.levels[lvl+1].distanceTestNext.end(), {
-                            tri_id(children, 0),
-                            tri_id(children, 1),
-                            tri_id(children, 2),
-                            tri_id(children, 3),
-                        });
-                        rSP.distanceTestDone.insert(tri_id(children, 0));
-                        rSP.distanceTestDone.insert(tri_id(children, 1));
-                        rSP.distanceTestDone.insert(tri_id(children, 2));
-                        rSP.distanceTestDone.insert(tri_id(children, 3));
-                    }
+                    SkTriGroupId const children = rTri.children;
+                    rSP.levels[lvl+1].distanceTestNext.insert(rSP.levels[lvl+1].distanceTestNext.end(), {
+                        tri_id(children, 0),
+                        tri_id(children, 1),
+                        tri_id(children, 2),
+                        tri_id(children, 3),
+                    });
+                    rSP.distanceTestDone.insert(tri_id(children, 0));
+                    rSP.distanceTestDone.insert(tri_id(children, 1));
+                    rSP.distanceTestDone.insert(tri_id(children, 2));
+                    rSP.distanceTestDone.insert(tri_id(children, 3));
                 }
-                else
+            }
+            else if (rSP.subdivBudgetLeft == 0)
+            {
+                ++rSP.subdivDeferred;
+            }
+            else
+            {
+                if (rSP.subdivBudgetLeft != SkeletonSubdivScratchpad::smc_unlimited)
                 {
-                    subdivide(sktriId, rTri, lvl, hasNextLevel, rSkel, rSkData, rSP);
+                    --rSP.subdivBudgetLeft;
                 }
+                subdivide(sktriId, rTri, lvl, hasNextLevel, rSkel, rSkData, rSP);
             }
 
             // Fix up Invariant B violations
@@ -557,6 +753,8 @@ void subdivide_level_by_distance(
                 subdivide_level_by_distance(pos, rSP.levelNeedProcess, rSkel, rSkData, rSP);
             }
         }
+
+        flush_vrtx_batch(rSkData, rSP);
     }
 
     LGRN_ASSERT(lvl == rSP.levelNeedProcess);
@@ -32,6 +32,8 @@
 #include "skeleton.h"
 #include "geometry.h"
 
+#include <osp/core/parallel_for.h>
+
 namespace planeta
 {
 
@@ -39,6 +41,11 @@ struct SubdivScratchpadLevel
 {
     std::vector<planeta::SkTriId> distanceTestProcessing;
     std::vector<planeta::SkTriId> distanceTestNext;
+
+    /// Per-thread output of the distance test phase; triangles that passed the test in the order
+    /// they appear in distanceTestProcessing. Per-level since subdividing can recurse into
+    /// lower levels while these are being read.
+    std::vector< std::vector<planeta::SkTriId> > distanceTestPassed;
 };
 
 
@@ -52,9 +59,17 @@ struct SkeletonSubdivScratchpad
     using UserData_t = std::array<void*, 4>;
     using OnUnsubdivideFunc_t = void (*)(SkTriId, SkeletonTriangle&, SubdivTriangleSkeleton&, SkeletonVertexData&, UserData_t) noexcept;
     using OnSubdivideFunc_t   = void (*)(SkTriId, SkTriGroupId, std::array<SkVrtxId, 3>, std::array<osp::MaybeNewId<SkVrtxId>, 3>, SubdivTriangleSkeleton&, SkeletonVertexData&, UserData_t) noexcept;
+    using OnVrtxBatchFunc_t   = void (*)(osp::ArrayView<SkVrtxId const>, SkeletonVertexData&, UserData_t) noexcept;
 
     void resize(SubdivTriangleSkeleton &rSkel);
 
+    /**
+     * @brief Apply a remap from SubdivTriangleSkeleton::tri_group_reorder
+     *
+     * Only valid between updates, when surfaceRemoved and all distance test state are empty.
+     */
+    void remap_tris(SkTriGroupRemap const& remap);
+
     std::array<std::uint64_t, gc_maxSubdivLevels> distanceThresholdSubdiv{{}};
     std::array<std::uint64_t, gc_maxSubdivLevels> distanceThresholdUnsubdiv{{}};
 
@@ -82,7 +97,29 @@ struct SkeletonSubdivScratchpad
     OnUnsubdivideFunc_t onUnsubdiv  {nullptr};
     UserData_t onUnsubdivUserData   {{nullptr, nullptr, nullptr, nullptr}};
 
+    /// Optional stage called with all new vertices from each subdivide wave at once, after
+    /// onSubdiv positioned them. Intended for height functions, see flush_vrtx_batch.
+    OnVrtxBatchFunc_t onVrtxBatch   {nullptr};
+    UserData_t onVrtxBatchUserData  {{nullptr, nullptr, nullptr, nullptr}};
+
+    /// New vertices not yet passed to onVrtxBatch
+    std::vector<SkVrtxId> vrtxBatch;
+
     std::uint32_t distanceCheckCount{};
+
+    /// Waves of distanceTestProcessing smaller than this per range are tested serially
+    static constexpr std::size_t smc_distanceTestMinPerThread = 2048;
+
+    static constexpr std::uint32_t smc_unlimited = ~std::uint32_t(0);
+
+    /// Distance-triggered subdivisions subdivide_level_by_distance is still allowed to do. Set
+    /// this every update to limit how much work an update does, such as after the camera moves
+    /// far in one step. Subdivisions needed to keep invariants are not limited.
+    std::uint32_t subdivBudgetLeft  {smc_unlimited};
+
+    /// Triangles near enough to subdivide, but skipped since subdivBudgetLeft ran out. They are
+    /// found again by the next update's distance test.
+    std::uint32_t subdivDeferred    {0};
 };
 
 
@@ -90,13 +127,17 @@ struct SkeletonSubdivScratchpad
  * @brief Selects triangles (within a subdiv level) that are too far away from pos
  *
  * Populates SubdivScratchpad::tryUnsubdiv
+ *
+ * @param parallelFor [in] Splits distance tests across threads, such as a task's
+ *                         WorkerContext::m_parallelFor
  */
 void unsubdivide_select_by_distance(
         std::uint8_t                    lvl,
         osp::Vector3l                   pos,
         SubdivTriangleSkeleton    const &rSkel,
         SkeletonVertexData        const &rSkData,
-        SkeletonSubdivScratchpad        &rSP);
+        SkeletonSubdivScratchpad        &rSP,
+        osp::ParallelFor          const &parallelFor = {});
 
 /**
  * @brief Tests which triangles in SubdivScratchpad::tryUnsubdiv are not allowed to un-subdivide
@@ -132,14 +173,33 @@ SkTriGroupId subdivide(
         SkeletonVertexData              &rSkData,
         SkeletonSubdivScratchpad        &rSP);
 
+/**
+ * @brief Pass SkeletonSubdivScratchpad::vrtxBatch to onVrtxBatch, then clear it
+ *
+ * Called by subdivide_level_by_distance after each wave. Call this too after using subdivide(...)
+ * directly.
+ */
+void flush_vrtx_batch(
+        SkeletonVertexData              &rSkData,
+        SkeletonSubdivScratchpad        &rSP);
+
 /**
  * @brief Subdivide all triangles (within a subdiv level) too close to pos
+ *
+ * Each floodfill wave is done in two phases: distanceTestProcessing is distance-tested in ranges
+ * split by parallelFor without touching the skeleton, then triangles that passed are subdivided
+ * serially in their original order.
+ *
+ * If SkeletonSubdivScratchpad::subdivBudgetLeft is limited, triangles that passed are instead
+ * subdivided nearest-first until the budget runs out. Levels are processed coarsest first, so
+ * the budget goes to the triangles with the largest error on screen.
  */
 void subdivide_level_by_distance(
         osp::Vector3l                   pos,
         std::uint8_t                    lvl,
         SubdivTriangleSkeleton          &rSkel,
         SkeletonVertexData              &rSkData,
-        SkeletonSubdivScratchpad        &rSP);
+        SkeletonSubdivScratchpad        &rSP,
+        osp::ParallelFor          const &parallelFor = {});
 
 } // namespace planeta
@@ -30,6 +30,7 @@
 #pragma once
 
 #include <osp/core/id_utils.h>
+#include <osp/core/memory_usage.h>
 
 #include <longeron/id_management/registry_stl.hpp>
 
@@ -160,6 +161,8 @@ private:
     std::vector<std::uint64_t>                  m_idToParents;
     std::vector<std::uint8_t>                   m_idRefcount;
 
+    template <typename> friend struct osp::MemoryUsage;
+
 }; // class SubdivTree
 
 
@@ -223,3 +226,23 @@ void SubdivIdRegistry<ID_T>::remove(ID_T const x) noexcept
 
 }; // namespace planeta
 
+namespace osp
+{
+
+template <typename ID_T>
+struct MemoryUsage<planeta::SubdivIdRegistry<ID_T>>
+{
+    static std::size_t heap_bytes(planeta::SubdivIdRegistry<ID_T> const& reg) noexcept
+    {
+        // Node based map, count each node's pointer and a pointer per bucket
+        std::size_t const mapBytes
+                = reg.m_parentsToId.size() * (sizeof(std::uint64_t) + sizeof(ID_T) + sizeof(void*))
+                + reg.m_parentsToId.bucket_count() * sizeof(void*);
+
+        return (reg.capacity() + 63) / 64 * sizeof(std::uint64_t) + mapBytes
+             + heap_bytes_sum(reg.m_idToParents, reg.m_idRefcount);
+    }
+};
+
+} // namespace osp
+
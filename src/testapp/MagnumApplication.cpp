@@ -28,9 +28,14 @@
 #include <Magnum/Math/Color.h>
 #include <Magnum/PixelFormat.h>
 
+#include <SDL_events.h>
+
 #include <toml.hpp>
+
+#include <array>
 #include <iostream>
 
+#include "osp/drawing_gl/profiling_gl.h"
 #include "osp/util/ExecutablePath.h"
 
 using namespace testapp;
@@ -65,56 +70,128 @@ MagnumApplication::~MagnumApplication()
     m_ospApp.reset(nullptr);
 }
 
+MagnumApplication::LatchedInput MagnumApplication::latch_input()
+{
+    LatchedInput out;
+
+    if (m_pInputPlayback != nullptr)
+    {
+        return out; // Only recorded input counts, nothing new arrives mid-frame
+    }
+
+    out.elapsed = std::chrono::duration<float>(std::chrono::steady_clock::now() - m_frameStart).count();
+
+    // Peek without removing anything, the events are still handled normally next frame
+    SDL_PumpEvents();
+    std::array<SDL_Event, 64> events;
+    int const count = SDL_PeepEvents(events.data(), int(events.size()), SDL_PEEKEVENT, SDL_MOUSEMOTION, SDL_MOUSEMOTION);
+    for (int i = 0; i < count; ++i)
+    {
+        out.mouseDelta += osp::Vector2i{events[std::size_t(i)].motion.xrel, events[std::size_t(i)].motion.yrel};
+    }
+
+    return out;
+}
+
 void MagnumApplication::drawEvent()
 {
+    m_frameStart = std::chrono::steady_clock::now();
+
+    if (m_betweenFrames)
+    {
+        m_betweenFrames(*this);
+    }
+
+    float delta = m_timeline.previousFrameDuration();
+
+    if (m_pInputPlayback != nullptr)
+    {
+        std::optional<float> const recordedDelta = m_pInputPlayback->play_frame(m_rUserInput);
+        if ( ! recordedDelta.has_value() )
+        {
+            OSP_LOG_INFO("Input playback finished after {} frames", m_pInputPlayback->frames_played());
+            exit();
+            return;
+        }
+        delta = *recordedDelta;
+    }
+
     m_rUserInput.update_controls();
 
     if (m_ospApp != nullptr)
     {
-        m_ospApp->draw(*this, m_timeline.previousFrameDuration());
+        m_ospApp->draw(*this, delta);
     }
 
     m_rUserInput.clear_events();
 
+    if (m_pInputRecorder != nullptr)
+    {
+        m_pInputRecorder->end_frame(delta);
+    }
+
     swapBuffers();
+    OSP_PROFILE_GPU_COLLECT();
+    OSP_PROFILE_FRAME();
     m_timeline.nextFrame();
     redraw();
 }
 
+void MagnumApplication::button_event(UserInputHandler::DeviceId const deviceId, int const buttonEnum, osp::input::EButtonEvent const dir)
+{
+    if (m_pInputPlayback != nullptr) { return; }
+    if (m_pInputRecorder != nullptr)
+    {
+        m_pInputRecorder->button(deviceId, buttonEnum, dir);
+    }
+    m_rUserInput.event_raw(deviceId, buttonEnum, dir);
+}
+
 void MagnumApplication::keyPressEvent(KeyEvent& event)
 {
     if (event.isRepeated()) { return; }
-    m_rUserInput.event_raw(osp::input::sc_keyboard, (int) event.key(),
-                           osp::input::EButtonEvent::Pressed);
+    button_event(osp::input::sc_keyboard, (int) event.key(),
+                 osp::input::EButtonEvent::Pressed);
 }
 
 void MagnumApplication::keyReleaseEvent(KeyEvent& event)
 {
     if (event.isRepeated()) { return; }
-    m_rUserInput.event_raw(osp::input::sc_keyboard, (int) event.key(),
-                           osp::input::EButtonEvent::Released);
+    button_event(osp::input::sc_keyboard, (int) event.key(),
+                 osp::input::EButtonEvent::Released);
 }
 
 void MagnumApplication::mousePressEvent(MouseEvent& event)
 {
-    m_rUserInput.event_raw(osp::input::sc_mouse, (int) event.button(),
-                           osp::input::EButtonEvent::Pressed);
+    button_event(osp::input::sc_mouse, (int) event.button(),
+                 osp::input::EButtonEvent::Pressed);
 }
 
 void MagnumApplication::mouseReleaseEvent(MouseEvent& event)
 {
-    m_rUserInput.event_raw(osp::input::sc_mouse, (int) event.button(),
-                           osp::input::EButtonEvent::Released);
+    button_event(osp::input::sc_mouse, (int) event.button(),
+                 osp::input::EButtonEvent::Released);
 }
 
 void MagnumApplication::mouseMoveEvent(MouseMoveEvent& event)
 {
+    if (m_pInputPlayback != nullptr) { return; }
+    if (m_pInputRecorder != nullptr)
+    {
+        m_pInputRecorder->mouse_delta(event.relativePosition());
+    }
     m_rUserInput.mouse_delta(event.relativePosition());
 }
 
 void MagnumApplication::mouseScrollEvent(MouseScrollEvent & event)
 {
-    m_rUserInput.scroll_delta(static_cast<osp::Vector2i>(event.offset()));
+    if (m_pInputPlayback != nullptr) { return; }
+    auto const offset = static_cast<osp::Vector2i>(event.offset());
+    if (m_pInputRecorder != nullptr)
+    {
+        m_pInputRecorder->scroll_delta(offset);
+    }
+    m_rUserInput.scroll_delta(offset);
 }
 
 void testapp::config_controls(UserInputHandler& rUserInput)
@@ -27,12 +27,15 @@
 #include "scenarios.h"
 
 #include <osp/util/UserInputHandler.h>
+#include <osp/util/input_recording.h>
 
 #include <Magnum/Timeline.h>
 
 #include <cstring> // workaround: memcpy needed by SDL2
 #include <Magnum/Platform/Sdl2Application.h>
 
+#include <chrono>
+#include <functional>
 #include <memory>
 
 namespace testapp
@@ -61,6 +64,9 @@ public:
 
     using AppPtr_t = std::unique_ptr<IOspApplication>;
 
+    /// Called at the start of each frame, outside of IOspApplication::draw
+    using BetweenFramesFunc_t = std::function<void(MagnumApplication&)>;
+
     explicit MagnumApplication(
             const Magnum::Platform::Application::Arguments& arguments,
             osp::input::UserInputHandler& rUserInput);
@@ -92,16 +98,94 @@ public:
         m_ospApp = std::move(ospApp);
     }
 
+    void set_between_frames(BetweenFramesFunc_t func)
+    {
+        m_betweenFrames = std::move(func);
+    }
+
+    /**
+     * @brief Record input events and frame delta times into pRecorder, nullptr to stop
+     *
+     * @param pRecorder [ref] Must outlive the application or be unset first
+     */
+    void set_input_recorder(osp::input::InputRecorder* pRecorder) noexcept
+    {
+        m_pInputRecorder = pRecorder;
+    }
+
+    /**
+     * @brief Take input events and frame delta times from pPlayback instead of the window
+     *
+     * Live input is ignored while playing back, and the application exits after the last
+     * recorded frame.
+     *
+     * @param pPlayback [ref] Must outlive the application or be unset first
+     */
+    void set_input_playback(osp::input::InputPlayback* pPlayback) noexcept
+    {
+        m_pInputPlayback = pPlayback;
+    }
+
+    /**
+     * @brief Input that arrived after this frame's UserInputHandler::update_controls
+     */
+    struct LatchedInput
+    {
+        /// Mouse motion waiting in the window's event queue
+        osp::Vector2i   mouseDelta  {0};
+
+        /// Seconds since the frame started
+        float           elapsed     {0.0f};
+    };
+
+    /**
+     * @brief Sample input that arrived mid-frame, for late latching the camera right before drawing
+     *
+     * Events are peeked, not consumed, so they still reach UserInputHandler next frame as usual.
+     * Only call from the main thread. Returns nothing new while playing back input.
+     */
+    [[nodiscard]] LatchedInput latch_input();
+
+    /**
+     * @brief Exit and destroy the current IOspApplication, then run the one set by rebuild
+     *
+     * Only call between frames, see set_between_frames. The window and GL context are kept, unlike
+     * closing and reopening the application.
+     *
+     * @param rebuild [in] Expected to call set_osp_app
+     */
+    void switch_osp_app(std::function<void()> const& rebuild)
+    {
+        m_ospApp->exit(*this);
+        m_ospApp.reset();
+
+        rebuild();
+
+        if (m_ospApp != nullptr)
+        {
+            m_ospApp->run(*this);
+        }
+    }
+
 private:
 
     void drawEvent() override;
 
+    void button_event(osp::input::UserInputHandler::DeviceId deviceId, int buttonEnum, osp::input::EButtonEvent dir);
+
     AppPtr_t m_ospApp;
 
+    BetweenFramesFunc_t m_betweenFrames;
+
+    osp::input::InputRecorder *m_pInputRecorder{nullptr};
+    osp::input::InputPlayback *m_pInputPlayback{nullptr};
+
     osp::input::UserInputHandler &m_rUserInput;
 
     Magnum::Timeline m_timeline;
 
+    std::chrono::steady_clock::time_point m_frameStart;
+
 };
 
 void config_controls(osp::input::UserInputHandler& rUserInput);
@@ -235,20 +235,22 @@ void sync_test_scene(
     using namespace osp::draw;
     using namespace adera::shader;
 
-    rScene.m_scnRdr.m_drawTransform         .resize(rScene.m_scnRdr.m_drawIds.capacity());
-    rRenderer.m_sceneRenderGL.m_diffuseTexId.resize(rScene.m_scnRdr.m_drawIds.capacity());
-    rRenderer.m_sceneRenderGL.m_meshId      .resize(rScene.m_scnRdr.m_drawIds.capacity());
+    rScene.m_scnRdr.resize_draw();
+    rRenderer.m_sceneRenderGL.m_diffuseTexId.resize(rScene.m_scnRdr.m_drawCapacity);
+    rRenderer.m_sceneRenderGL.m_meshId      .resize(rScene.m_scnRdr.m_drawCapacity);
 
     // Assign or remove phong shaders from entities marked dirty
+    RenderGroupWrites groupFwdWrites;
     sync_drawent_phong(rScene.m_matPhongDirty.cbegin(), rScene.m_matPhongDirty.cend(),
     {
         .hasMaterial    = rScene.m_matPhong,
-        .pStorageOpaque = &rRenderer.m_groupFwdOpaque.entities,
+        .pWritesOpaque  = &groupFwdWrites,
         .opaque         = rScene.m_scnRdr.m_opaque,
         .transparent    = rScene.m_scnRdr.m_transparent,
         .diffuse        = rRenderer.m_sceneRenderGL.m_diffuseTexId,
         .rData          = rRenderer.m_phong
     });
+    SysRender::apply_group_writes(rRenderer.m_groupFwdOpaque.entities, groupFwdWrites);
 
     // Load required meshes and textures into OpenGL
     SysRenderGL::compile_resource_meshes  (rScene.m_drawingRes, *rScene.m_pResources, rRenderGl);
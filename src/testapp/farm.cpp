@@ -0,0 +1,284 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "farm.h"
+#include "identifiers.h"
+#include "scenarios.h"
+
+#include <osp/core/Resources.h>
+#include <osp/tasks/top_execute.h>
+#include <osp/tasks/top_utils.h>
+#include <osp/util/logging.h>
+
+#include <Corrade/Containers/ArrayViewStl.h>
+
+#include <chrono>
+#include <fstream>
+#include <memory>
+
+using namespace osp;
+
+namespace testapp
+{
+
+double FarmResult::fairness() const noexcept
+{
+    double sum          = 0.0;
+    double sumSquares   = 0.0;
+    for (FarmInstanceResult const& instance : instances)
+    {
+        double const rate = instance.steps_per_second();
+        sum         += rate;
+        sumSquares  += rate * rate;
+    }
+    return (sumSquares > 0.0) ? (sum * sum) / (double(instances.size()) * sumSquares) : 0.0;
+}
+
+namespace
+{
+
+using Clock_t = std::chrono::steady_clock;
+
+struct FarmInstance
+{
+    TestApp                 app;
+
+    // Only runs setup and cleanup; steps go through top_run_parallel with its ExecContext
+    SingleThreadedExecutor  executor;
+
+    PipelineId              mainLoop;
+    PipelineId              sceneUpdate;
+    MainLoopControl         *pMainLoopCtrl  { nullptr };
+    Metrics const           *pMetrics       { nullptr };
+
+    FarmInstanceResult      result;
+    Clock_t::time_point     stepStart;
+    bool                    stopping        { false };
+};
+
+/**
+ * @return False if the scene has no pipelines to run headless
+ */
+bool setup_instance(FarmInstance& rInst, TestApp const& rPrimary, Resources const& primaryResources, SceneSetupFunc_t const setup)
+{
+    TestApp &rApp = rInst.app;
+
+    rApp.m_pExecutor        = &rInst.executor;
+    rApp.m_topData.resize(rPrimary.m_topData.size());
+    rApp.m_defaultPkg       = rPrimary.m_defaultPkg;
+    rApp.m_fixedSimStep     = rPrimary.m_fixedSimStep;
+
+    // Instances would all try to serve on the same port
+    rApp.m_replicationPort  = 0;
+
+    rApp.setup_application(primaryResources.share());
+    setup(rApp);
+
+    // Loaded even if not run, close_instance still needs it for cleanup pipelines
+    osp::rebuild_exec_graph(rApp.m_tasks, {&rApp.m_scene.m_edges}, rApp.m_graph);
+    rInst.executor.load(rApp);
+
+    // Scenarios without Pipelines/Tasks (enginetest) are only driven by their renderer
+    if (rApp.m_scene.m_sessions.empty() || rApp.m_scene.m_sessions[0].m_pipelines.empty())
+    {
+        return false;
+    }
+
+    OSP_DECLARE_GET_DATA_IDS(rApp.m_application, TESTAPP_DATA_APPLICATION);
+    rInst.pMainLoopCtrl = &top_get<MainLoopControl>(rApp.m_topData, idMainLoopCtrl);
+    rInst.pMetrics      = &top_get<Metrics>        (rApp.m_topData, idMetrics);
+
+    // First scene session is always from setup_scene
+    rInst.mainLoop      = rApp.m_application       .get_pipelines<PlApplication>() .mainLoop;
+    rInst.sceneUpdate   = rApp.m_scene.m_sessions[0].get_pipelines<PlScene>()      .update;
+
+    return true;
+}
+
+/**
+ * @brief Signal the next step of an instance, same as run_headless. Call while none of its tasks
+ *        are running.
+ */
+void signal_step(FarmInstance& rInst, bool const doUpdate)
+{
+    *rInst.pMainLoopCtrl = MainLoopControl{
+        .doUpdate = doUpdate,
+        .doSync   = false,
+        .doResync = false,
+        .doRender = false,
+    };
+
+    ExecContext &rExec = rInst.executor.m_execContext;
+    exec_signal(rExec, rInst.mainLoop);
+    exec_signal(rExec, rInst.sceneUpdate);
+
+    rInst.stepStart = Clock_t::now();
+}
+
+void close_instance(FarmInstance& rInst)
+{
+    TestApp &rApp = rInst.app;
+    rApp.close_sessions(rApp.m_scene.m_sessions);
+    rApp.m_scene.m_sessions.clear();
+}
+
+} // namespace
+
+FarmResult run_farm(TestApp& rPrimary, SceneSetupFunc_t const setup, TopWorkerPool& rPool, FarmOptions const& options)
+{
+    OSP_DECLARE_GET_DATA_IDS(rPrimary.m_application, TESTAPP_DATA_APPLICATION);
+    auto const &rPrimaryResources = top_get<Resources>(rPrimary.m_topData, idResources);
+
+    std::vector< std::unique_ptr<FarmInstance> > farm;
+    farm.reserve(options.instances);
+
+    for (std::size_t i = 0; i < options.instances; ++i)
+    {
+        FarmInstance &rInst = *farm.emplace_back(std::make_unique<FarmInstance>());
+        if ( ! setup_instance(rInst, rPrimary, rPrimaryResources, setup) )
+        {
+            OSP_LOG_ERROR("Scene has no pipelines to run headless");
+            for (std::unique_ptr<FarmInstance> &rpInst : farm)
+            {
+                close_instance(*rpInst);
+            }
+            return {};
+        }
+    }
+
+    OSP_LOG_INFO("Farm: set up {} instances, running {} steps each on {} workers",
+                 farm.size(), options.steps, rPool.thread_count());
+
+    Clock_t::time_point const start = Clock_t::now();
+
+    std::vector<TopRunInstance> runs(farm.size());
+    for (std::size_t i = 0; i < farm.size(); ++i)
+    {
+        FarmInstance    &rInst  = *farm[i];
+        TestApp         &rApp   = rInst.app;
+        ExecContext     &rExec  = rInst.executor.m_execContext;
+
+        runs[i] = TopRunInstance{
+            .pTasks     = &rApp.m_tasks,
+            .pGraph     = &rApp.m_graph,
+            .pTaskData  = &rApp.m_taskData,
+            .topData    = rApp.m_topData,
+            .pExec      = &rExec,
+            .pDispatch  = &rInst.executor.m_dispatch,
+            .onIdle     = [&rInst, &options, start] () -> bool
+        {
+            if (rInst.stopping)
+            {
+                return false;
+            }
+
+            Clock_t::time_point const now = Clock_t::now();
+            rInst.pMetrics->histogram_record("farm.step_ms", std::chrono::duration<double, std::milli>(now - rInst.stepStart).count());
+
+            if (++ rInst.result.steps == options.steps)
+            {
+                rInst.result.seconds = std::chrono::duration<double>(now - start).count();
+
+                // Stop the main loop, same as CommonMagnumApp::exit
+                rInst.stopping = true;
+                signal_step(rInst, false);
+                return true;
+            }
+
+            signal_step(rInst, true);
+            return true;
+        } };
+
+        rInst.stopping = (options.steps == 0);
+        exec_request_run(rExec, rInst.mainLoop);
+        signal_step(rInst, ! rInst.stopping);
+        exec_update(rApp.m_tasks, rApp.m_graph, rExec);
+    }
+
+    top_run_parallel(runs, rPool);
+
+    FarmResult out;
+    out.seconds = std::chrono::duration<double>(Clock_t::now() - start).count();
+
+    // Nothing is in flight anymore, so worker buffers are safe to take from here
+    for (std::size_t i = 0; i <= rPool.thread_count(); ++i)
+    {
+        WorkerLocal &rLocal = rPool.worker_local(i);
+        rLocal.metrics.clear();
+        for (std::string const& msg : rLocal.logMsgs)
+        {
+            OSP_LOG_INFO("[worker {}] {}", i, msg);
+        }
+        rLocal.logMsgs.clear();
+    }
+
+    out.instances.reserve(farm.size());
+    for (std::size_t i = 0; i < farm.size(); ++i)
+    {
+        FarmInstance &rInst = *farm[i];
+        LGRN_ASSERTM( ! rInst.executor.is_running(rInst.app), "Main loop must have stopped");
+
+        rInst.result.tasksRun       = runs[i].tasksRun;
+        rInst.result.taskSeconds    = std::chrono::duration<double>(runs[i].taskTime).count();
+
+        FarmInstanceResult const &result = rInst.result;
+
+        Metrics const &rMetrics = *rInst.pMetrics;
+        rMetrics.counter_add("farm.steps",          std::int64_t(result.steps));
+        rMetrics.counter_add("farm.tasks",          std::int64_t(result.tasksRun));
+        rMetrics.gauge_set  ("farm.seconds",        result.seconds);
+        rMetrics.gauge_set  ("farm.task_seconds",   result.taskSeconds);
+        rMetrics.gauge_set  ("farm.steps_per_second", result.steps_per_second());
+
+        if ( ! options.outputPrefix.empty() )
+        {
+            std::string const path = fmt::format("{}{}.csv", options.outputPrefix, i);
+            if (std::ofstream file{path}; file)
+            {
+                file << MetricsWriteCsv{rMetrics};
+            }
+            else
+            {
+                OSP_LOG_ERROR("Failed to open farm output: {}", path);
+            }
+        }
+
+        OSP_LOG_INFO("Farm: instance {} ran {} steps in {:.3f}s, {:.1f} steps/s, {} tasks taking {:.3f}s",
+                     i, result.steps, result.seconds, result.steps_per_second(), result.tasksRun, result.taskSeconds);
+
+        out.instances.push_back(result);
+    }
+
+    OSP_LOG_INFO("Farm: {} instances finished in {:.3f}s, fairness {:.3f}",
+                 out.instances.size(), out.seconds, out.fairness());
+
+    for (std::unique_ptr<FarmInstance> &rpInst : farm)
+    {
+        close_instance(*rpInst);
+    }
+
+    return out;
+}
+
+} // namespace testapp
@@ -0,0 +1,99 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "testapp.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace testapp
+{
+
+struct FarmOptions
+{
+    /// Number of scene instances to run at once
+    std::size_t     instances       { 4 };
+
+    /// Number of scene updates each instance runs
+    std::uint64_t   steps           { 600 };
+
+    /// Each instance writes its metrics to "<outputPrefix><index>.csv". Nothing is written if empty.
+    std::string     outputPrefix;
+};
+
+struct FarmInstanceResult
+{
+    std::uint64_t   steps       { 0 };
+
+    /// Seconds from the start of the farm until the instance finished its last step
+    double          seconds     { 0.0 };
+
+    std::uint64_t   tasksRun    { 0 };
+
+    /// Seconds spent in the instance's tasks, summed over all threads
+    double          taskSeconds { 0.0 };
+
+    [[nodiscard]] double steps_per_second() const noexcept
+    {
+        return (seconds > 0.0) ? double(steps) / seconds : 0.0;
+    }
+};
+
+struct FarmResult
+{
+    std::vector<FarmInstanceResult> instances;
+
+    /// Seconds until the last instance finished
+    double                          seconds     { 0.0 };
+
+    /**
+     * @brief Jain's fairness index of each instance's steps per second
+     *
+     * 1 if all instances got the same throughput, down to 1/N if a single instance got all of it.
+     */
+    [[nodiscard]] double fairness() const noexcept;
+};
+
+/**
+ * @brief Run many headless instances of a scene at once, all on the same pool of worker threads
+ *
+ * Each instance is a separate TestApp with its own scene and application sessions. Resources are
+ * shared with rPrimary through osp::Resources::share(), so loaded meshes and textures are not
+ * duplicated. Instances are stepped independently of each other; whichever finishes a step
+ * starts its next one right away, see osp::top_run_parallel.
+ *
+ * The pool must not be in use by anything else until this returns. Metrics and log messages that
+ * tasks buffer in the pool's WorkerLocals can't be told apart between instances, so buffered
+ * metrics are dropped and log messages are logged without an instance.
+ *
+ * @param setup [in] Scene to set up in every instance, its renderer is never set up
+ *
+ * @return Per-instance results, or no instances if the scene has no pipelines to run headless
+ */
+FarmResult run_farm(TestApp& rPrimary, SceneSetupFunc_t setup, osp::TopWorkerPool& rPool, FarmOptions const& options);
+
+} // namespace testapp
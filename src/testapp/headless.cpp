@@ -0,0 +1,125 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "headless.h"
+#include "identifiers.h"
+#include "scenarios.h"
+
+#include <osp/tasks/top_utils.h>
+#include <osp/util/logging.h>
+
+#include <chrono>
+#include <thread>
+
+using namespace osp;
+
+namespace testapp
+{
+
+HeadlessResult run_headless(TestApp& rTestApp, HeadlessOptions const& options)
+{
+    using Clock_t = std::chrono::steady_clock;
+
+    // Scenarios without Pipelines/Tasks (enginetest) are only driven by their renderer
+    if (rTestApp.m_scene.m_sessions.empty() || rTestApp.m_scene.m_sessions[0].m_pipelines.empty())
+    {
+        OSP_LOG_ERROR("Scene has no pipelines to run headless");
+        return {};
+    }
+
+    OSP_DECLARE_GET_DATA_IDS(rTestApp.m_application, TESTAPP_DATA_APPLICATION);
+    auto &rMainLoopCtrl = top_get<MainLoopControl>(rTestApp.m_topData, idMainLoopCtrl);
+
+    // First scene session is always from setup_scene
+    PipelineId const mainLoop    = rTestApp.m_application       .get_pipelines<PlApplication>() .mainLoop;
+    PipelineId const sceneUpdate = rTestApp.m_scene.m_sessions[0].get_pipelines<PlScene>()      .update;
+
+    IExecutor &rExecutor = *rTestApp.m_pExecutor;
+
+    osp::rebuild_exec_graph(rTestApp.m_tasks, {&rTestApp.m_scene.m_edges}, rTestApp.m_graph);
+    rExecutor.label_sessions(rTestApp);
+    rExecutor.load(rTestApp);
+
+    rExecutor.run(rTestApp, mainLoop);
+
+    auto const step = [&] (bool const doUpdate)
+    {
+        rMainLoopCtrl = MainLoopControl{
+            .doUpdate = doUpdate,
+            .doSync   = false,
+            .doResync = false,
+            .doRender = false,
+        };
+        rExecutor.signal(rTestApp, mainLoop);
+        rExecutor.signal(rTestApp, sceneUpdate);
+        rExecutor.wait(rTestApp);
+    };
+
+    auto const stepPeriod = (options.rate > 0.0f)
+                          ? std::chrono::duration_cast<Clock_t::duration>(std::chrono::duration<float>(1.0f / options.rate))
+                          : Clock_t::duration::zero();
+    auto const reportPeriod = std::chrono::duration_cast<Clock_t::duration>(std::chrono::duration<float>(options.reportEvery));
+
+    Clock_t::time_point const   start       = Clock_t::now();
+    Clock_t::time_point         nextStep    = start;
+    Clock_t::time_point         lastReport  = start;
+    std::uint64_t               reportSteps = 0;
+
+    HeadlessResult out;
+
+    for (; out.steps < options.steps; ++out.steps)
+    {
+        if (stepPeriod != Clock_t::duration::zero())
+        {
+            // Fixed rate: schedule from the previous deadline so the average rate doesn't drift
+            std::this_thread::sleep_until(nextStep);
+            nextStep += stepPeriod;
+        }
+
+        step(true);
+        ++ reportSteps;
+
+        if (Clock_t::time_point const now = Clock_t::now();
+            now - lastReport >= reportPeriod)
+        {
+            double const seconds = std::chrono::duration<double>(now - lastReport).count();
+            OSP_LOG_INFO("Headless: {} steps, {:.1f} steps/s", out.steps + 1, double(reportSteps) / seconds);
+            lastReport  = now;
+            reportSteps = 0;
+        }
+    }
+
+    out.seconds = std::chrono::duration<double>(Clock_t::now() - start).count();
+
+    // Stop the main loop, same as CommonMagnumApp::exit
+    step(false);
+    LGRN_ASSERTM( ! rExecutor.is_running(rTestApp), "Main loop must have stopped");
+
+    OSP_LOG_INFO("Headless: ran {} steps in {:.3f}s, {:.1f} steps/s",
+                 out.steps, out.seconds, out.steps_per_second());
+
+    return out;
+}
+
+} // namespace testapp
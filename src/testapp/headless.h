@@ -0,0 +1,70 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include "testapp.h"
+
+#include <cstdint>
+
+namespace testapp
+{
+
+struct HeadlessOptions
+{
+    /// Number of scene updates to run before returning
+    std::uint64_t   steps       { 600 };
+
+    /// Scene updates per second to run at, or 0 to run as fast as possible
+    float           rate        { 0.0f };
+
+    /// Seconds between steps per second reports
+    float           reportEvery { 1.0f };
+};
+
+struct HeadlessResult
+{
+    std::uint64_t   steps       { 0 };
+    double          seconds     { 0.0 };
+
+    [[nodiscard]] double steps_per_second() const noexcept
+    {
+        return (seconds > 0.0) ? double(steps) / seconds : 0.0;
+    }
+};
+
+/**
+ * @brief Run the main loop of an already set up scene without a window or GL context
+ *
+ * Only scene sessions are used; a scenario's RendererSetupFunc_t is never called. Each step runs
+ * the mainLoop and scene update pipelines, the same as CommonMagnumApp::draw without syncing or
+ * rendering. Steps per second are logged every HeadlessOptions::reportEvery seconds.
+ *
+ * rTestApp.m_pExecutor is loaded with a graph made of only the scene's edges.
+ *
+ * @return Steps run and how long they took, or zero steps if the scene has no pipelines to run
+ */
+HeadlessResult run_headless(TestApp& rTestApp, HeadlessOptions const& options);
+
+} // namespace testapp
@@ -142,8 +142,8 @@ using osp::PipelineDef;
 
 //-----------------------------------------------------------------------------
 
-#define TESTAPP_DATA_APPLICATION 2, \
-    idResources, idMainLoopCtrl
+#define TESTAPP_DATA_APPLICATION 3, \
+    idResources, idMainLoopCtrl, idMetrics
 struct PlApplication
 {
     PipelineDef<EStgOptn> mainLoop          {"mainLoop"};
@@ -178,6 +178,12 @@ struct PlPhysics
 {
     PipelineDef<EStgCont> physBody          {"physBody"};
     PipelineDef<EStgOptn> physUpdate        {"physUpdate"};
+
+    /// ACtxPhysics::m_rays; submit at New, the backend casts at Modify, read hits at Ready
+    PipelineDef<EStgCont> raycast           {"raycast"};
+
+    /// ACtxPhysics::m_contacts; written by the backend's world update at Modify
+    PipelineDef<EStgIntr> contacts          {"contacts"};
 };
 
 
@@ -189,12 +195,13 @@ struct PlPhysShapes
     PipelineDef<EStgIntr> spawnRequest      {"spawnRequest      - Spawned shapes"};
     PipelineDef<EStgIntr> spawnedEnts       {"spawnedEnts"};
     PipelineDef<EStgRevd> ownedEnts         {"ownedEnts"};
+    PipelineDef<EStgIntr> parkRequest       {"parkRequest       - Shapes to deactivate into the pool"};
 };
 
 
 
-#define TESTAPP_DATA_PREFABS 1, \
-    idPrefabs
+#define TESTAPP_DATA_PREFABS 2, \
+    idPrefabs, idPrefabArena
 struct PlPrefabs
 {
     PipelineDef<EStgIntr> spawnRequest      {"spawnRequest"};
@@ -242,6 +249,7 @@ struct PlParts
     PipelineDef<EStgCont> machUpdExtIn      {"machUpdExtIn      -"};
 
     PipelineDef<EStgLink> linkLoop          {"linkLoop          - Link update loop"};
+    PipelineDef<EStgCont> machDirty         {"machDirty         - MachineUpdater::localDirty/levelPending"};
 };
 
 
@@ -263,7 +271,7 @@ struct PlVehicleSpawn
     idVehicleSpawnVB
 struct PlVehicleSpawnVB
 {
-    PipelineDef<EStgIntr> dataVB            {"dataVB            - ACtxVehicleSpawnVB::dataVB"};
+    PipelineDef<EStgIntr> dataVB            {"dataVB            - ACtxVehicleSpawnVB::dataVB and blueprints"};
     PipelineDef<EStgIntr> remapParts        {"remapParts        - ACtxVehicleSpawnVB::remapPart*"};
     PipelineDef<EStgIntr> remapWelds        {"remapWelds        - ACtxVehicleSpawnVB::remapWeld*"};
     PipelineDef<EStgIntr> remapMachs        {"remapMachs        - ACtxVehicleSpawnVB::remapMach*"};
@@ -277,15 +285,20 @@ struct PlVehicleSpawnVB
 
 
 
-#define TESTAPP_DATA_SIGNALS_FLOAT 2, \
-    idSigValFloat,      idSigUpdFloat
-struct PlSignalsFloat
+// Same layout for every signal type, see setup_signals
+#define TESTAPP_DATA_SIGNALS 3, \
+    idSigVal,           idSigUpd,           idSigUpdWriters
+struct PlSignals
 {
-    PipelineDef<EStgCont> sigFloatValues    {"sigFloatValues    -"};
-    PipelineDef<EStgCont> sigFloatUpdExtIn  {"sigFloatUpdExtIn  -"};
-    PipelineDef<EStgCont> sigFloatUpdLoop   {"sigFloatUpdLoop   -"};
+    PipelineDef<EStgCont> sigValues         {"sigValues         - SignalValues_t<*>"};
+    PipelineDef<EStgCont> sigUpdExtIn       {"sigUpdExtIn       - UpdateNodes<*> written outside of link loop"};
+    PipelineDef<EStgCont> sigUpdLoop        {"sigUpdLoop        - UpdateNodes<*> within link loop"};
 };
 
+#define TESTAPP_DATA_SIGNALS_FLOAT 3, \
+    idSigValFloat,      idSigUpdFloat,      idSigUpdFloatWriters
+using PlSignalsFloat = PlSignals;
+
 
 
 #define TESTAPP_DATA_NEWTON 1, \
@@ -319,6 +332,13 @@ struct PlJolt
 #define TESTAPP_DATA_JOLT_ACCEL 1, \
     idAcceleration
 
+#define TESTAPP_DATA_JOLT_NBODY_GRAVITY 1, \
+    idGravityField
+
+
+
+#define TESTAPP_DATA_FLUID_NETWORK 1, \
+    idFluidNet
 
 
 #define TESTAPP_DATA_ROCKETS_NWT 1, \
@@ -329,6 +349,19 @@ struct PlJolt
     idRocketsJolt
 
 
+#define TESTAPP_DATA_AERO_JOLT 1, \
+    idAeroJolt
+
+
+#define TESTAPP_DATA_VEHICLE_HANDOFF_JOLT 1, \
+    idVehicleHandoff
+struct PlVehicleHandoff
+{
+    PipelineDef<EStgCont> railSats          {"railSats          - Satellites of vehicles on rails"};
+    PipelineDef<EStgRevd> deactivate        {"deactivate        - Welds to move onto rails"};
+};
+
+
 #define TESTAPP_DATA_TERRAIN 2, \
     idTerrainFrame, idTerrain
 struct PlTerrain
@@ -361,8 +394,11 @@ struct PlUniSceneFrame
     PipelineDef<EStgCont> sceneFrame        {"sceneFrame"};
 };
 
-#define TESTAPP_DATA_UNI_PLANETS 2, \
-    idPlanetMainSpace, idSatSurfaceSpaces
+#define TESTAPP_DATA_UNI_PLANETS 3, \
+    idPlanetMainSpace, idSatSurfaceSpaces, idCoordCache
+
+#define TESTAPP_DATA_UNI_TERRAINS 1, \
+    idUniTerrains
 
 //-----------------------------------------------------------------------------
 
@@ -393,6 +429,8 @@ struct PlWindowApp
     idScnRender, idDrawTfObservers
 struct PlSceneRenderer
 {
+    PipelineDef<EStgEvnt> cleanup           {"cleanup           - Release scene resources before destruction, keeping window and GL context"};
+
     PipelineDef<EStgOptn> render            {"render            - "};
 
     PipelineDef<EStgCont> drawEnt           {"drawEnt           - "};
@@ -421,8 +459,8 @@ struct PlSceneRenderer
 
 
 
-#define TESTAPP_DATA_MAGNUM 2, \
-    idActiveApp, idRenderGl
+#define TESTAPP_DATA_MAGNUM 3, \
+    idActiveApp, idRenderGl, idRenderStats
 struct PlMagnum
 {
     PipelineDef<EStgCont> meshGL            {"meshGL"};
@@ -434,14 +472,18 @@ struct PlMagnum
 
 
 
-#define TESTAPP_DATA_MAGNUM_SCENE 3, \
-    idScnRenderGl, idGroupFwd, idCamera
+#define TESTAPP_DATA_MAGNUM_SCENE 4, \
+    idScnRenderGl, idGroupFwd, idCamera, idCmdFwd
 struct PlMagnumScene
 {
     PipelineDef<EStgFBO>  fbo               {"fboRender"};
 
     PipelineDef<EStgCont> camera            {"camera"};
 
+    PipelineDef<EStgCont> cmdFwd            {"cmdFwd            - Render commands recorded from idGroupFwd"};
+
+    PipelineDef<EStgCont> depthPyramid      {"depthPyramid      - ACtxSceneRender::m_depthPyramid, from last frame's depth"};
+
 };
 
 
@@ -454,18 +496,28 @@ struct PlCameraCtrl
 };
 
 
-#define TESTAPP_DATA_SHADER_VISUALIZER 1, \
-    idDrawShVisual
+#define TESTAPP_DATA_SHADER_VISUALIZER 2, \
+    idDrawShVisual, idShVisualWrites
+
+
+
+#define TESTAPP_DATA_SHADER_PHONG 2, \
+    idDrawShPhong, idShPhongWrites
+
+
+
+#define TESTAPP_DATA_SHADER_FLAT 2, \
+    idDrawShFlat, idShFlatWrites
 
 
 
-#define TESTAPP_DATA_SHADER_PHONG 1, \
-    idDrawShPhong
+#define TESTAPP_DATA_SHADER_PLUME 1, \
+    idDrawShPlume
 
 
 
-#define TESTAPP_DATA_SHADER_FLAT 1, \
-    idDrawShFlat
+#define TESTAPP_DATA_ROCKET_PLUMES 1, \
+    idPlumes
 
 
 
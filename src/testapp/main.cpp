@@ -24,20 +24,29 @@
  */
 
 #include "MagnumApplication.h"
+#include "farm.h"
+#include "headless.h"
 #include "testapp.h"
 #include "scenarios.h"
+#include "setup_profile.h"
 #include "identifiers.h"
 #include "sessions/common.h"
 #include "sessions/magnum.h"
 
 #include <osp/core/Resources.h>
+#include <osp/core/large_alloc.h>
 #include <osp/core/string_concat.h>
+#include <osp/drawing/image_mips.h>
 #include <osp/drawing/own_restypes.h>
 #include <osp/tasks/top_execute.h>
+#include <osp/util/input_recording.h>
 #include <osp/util/logging.h>
 #include <osp/vehicles/ImporterData.h>
+#include <osp/vehicles/asset_cache.h>
 #include <osp/vehicles/load_tinygltf.h>
 
+#include <ospjolt/activescene/prefab_shapes.h>
+
 #include <Magnum/MeshTools/Transform.h>
 #include <Magnum/Primitives/Cone.h>
 #include <Magnum/Primitives/Cylinder.h>
@@ -53,12 +62,18 @@
 
 #include <entt/core/any.hpp>
 
+#include <spdlog/async.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 
 #include <array>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string_view>
 #include <thread>
 #include <unordered_map>
@@ -81,6 +96,20 @@ void cli_loop(int argc, char** argv);
  */
 void start_magnum_async(int argc, char** argv);
 
+/**
+ * @brief Call g_testApp.m_rendererSetup, then rebuild the TaskGraph and load the executor
+ *
+ * Must be called from the Magnum thread.
+ */
+void setup_renderer_sessions();
+
+/**
+ * @brief Replace the open scene and its renderer sessions, keeping the window and GL context
+ *
+ * Must be called from the Magnum thread, between frames. See MagnumApplication::switch_osp_app
+ */
+void switch_scene(SceneSetupFunc_t setup);
+
 /**
  * @brief As the name implies
  *
@@ -91,16 +120,60 @@ void start_magnum_async(int argc, char** argv);
  */
 void load_a_bunch_of_stuff();
 
+/**
+ * @brief Start thread g_metricsThread, which writes osp::Metrics to a file every period
+ *
+ * The file is replaced by renaming a temporary file, so scrapers never read a partial write.
+ */
+void start_metrics_dump(std::filesystem::path path, std::chrono::duration<float> period);
+
+void stop_metrics_dump();
+
+/**
+ * @brief Write the critical path of the open scenario to a file next to g_tracePath
+ *
+ * Only covers frames since the scenario was opened, as the TaskGraph changes between scenarios.
+ * Must be called before the scenario's sessions are closed.
+ */
+void write_critical_path();
+
 // called only from commands to display information
 void print_help();
 void print_resources();
+void print_metrics();
+void print_memory();
 
 TestApp g_testApp;
 
 SingleThreadedExecutor g_executor;
 
+// Only constructed if selected with --executor=pool, as it starts threads
+std::optional<ThreadPoolExecutor> g_poolExecutor;
+
+// Path to write osp::TopExecWriteChromeTrace to, empty if disabled
+std::string g_tracePath;
+
+// Scenario currently open, and the first trace frame recorded with it. See write_critical_path
+SceneSetupFunc_t g_sceneSetup{nullptr};
+std::size_t g_sceneFirstFrame{0};
+
+// GPU format Basis images are transcoded to while loading
+osp::EBasisTarget g_basisTarget = osp::default_basis_target();
+
+// Processing done to meshes while loading
+osp::MeshOptimizeFlags g_meshOptimize = osp::gc_defaultMeshOptimize;
+
+// Paths for --record-input and --replay-input, empty if disabled
+std::string g_recordInputPath;
+std::string g_replayInputPath;
+
 std::thread g_magnumThread;
 
+std::thread             g_metricsThread;
+std::mutex              g_metricsMutex;
+std::condition_variable g_metricsStopCv;
+bool                    g_metricsStop{false};
+
 // Loggers
 osp::Logger_t g_mainThreadLogger;
 osp::Logger_t g_logExecutor;
@@ -114,7 +187,25 @@ int main(int argc, char** argv)
         .addOption("scene", "none")         .setHelp("scene",       "Set the scene to launch")
         .addOption("config")                .setHelp("config",      "path to configuration file to use")
         .addBooleanOption("norepl")         .setHelp("norepl",      "don't enter read, evaluate, print, loop.")
+        .addBooleanOption("headless")       .setHelp("headless",    "Run the scene without a window or rendering, then exit. Requires --scene")
+        .addBooleanOption("fixed-sim-step") .setHelp("fixed-sim-step", "Update the scene at a fixed rate, independent of the frame rate")
+        .addOption("steps", "600")          .setHelp("steps",       "Number of scene updates to run with --headless or --farm")
+        .addOption("farm", "0")             .setHelp("farm",        "Run this many headless instances of --scene at once on one worker pool, then exit")
+        .addOption("farm-out")              .setHelp("farm-out",    "Write metrics of each --farm instance to <farm-out><index>.csv")
+        .addOption("rate", "0")             .setHelp("rate",        "Scene updates per second with --headless, 0 to run as fast as possible")
+        .addOption("record-input")          .setHelp("record-input", "Record input events and frame times to this file while the window is open")
+        .addOption("replay-input")          .setHelp("replay-input", "Play back input recorded with --record-input instead of live input. With --headless, runs one scene update per recorded frame")
         .addBooleanOption("log-exec")       .setHelp("log-exec",    "Log Task/Pipeline Execution (Extremely chatty!)")
+        .addBooleanOption("log-async")      .setHelp("log-async",   "Format and write log messages on a background thread instead of the thread logging them")
+        .addOption("log-queue", "8192")     .setHelp("log-queue",   "Messages queued with --log-async before the oldest are dropped")
+        .addOption("executor", "single").setHelp("executor",    "Task executor to use: single, or pool to run tasks on worker threads")
+        .addOption("metrics-out")           .setHelp("metrics-out", "Periodically write metrics to this file, as JSON if it ends with .json, otherwise CSV")
+        .addOption("metrics-every", "5")    .setHelp("metrics-every", "Seconds between writes to --metrics-out")
+        .addOption("trace-exec")            .setHelp("trace-exec",  "Write Task/Pipeline timings to a Chrome trace JSON file on exit, viewable in Perfetto")
+        .addOption("basis-format", "auto")  .setHelp("basis-format", "GPU format to transcode Basis textures to: auto, RGBA8, Bc1RGB, Bc3RGBA, Bc7RGBA, Etc2RGBA, or Astc4x4RGBA")
+        .addOption("large-alloc")           .setHelp("large-alloc", "Comma-separated subsystem=policy pairs for large buffers, such as terrain_geometry=thp+local. Policies: none, thp, huge, local")
+        .addBooleanOption("quantize-meshes").setHelp("quantize-meshes", "Store imported mesh normals and texture coordinates as 16-bit")
+        .addOption("serve-replication", "0").setHelp("serve-replication", "Serve vehicle state to replication clients on this UDP port, 0 to not serve")
         // TODO .addBooleanOption('v', "verbose")   .setHelp("verbose",     "log verbosely")
         .setGlobalHelp("Helptext goes here.")
         .parse(argc, argv);
@@ -122,23 +213,114 @@ int main(int argc, char** argv)
     // Setup logging
     auto pSink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
     pSink->set_pattern("[%T.%e] [%n] [%^%l%$] [%s:%#] %v");
-    g_mainThreadLogger = std::make_shared<spdlog::logger>("main-thread", pSink);
-    g_logExecutor  = std::make_shared<spdlog::logger>("executor", pSink);
-    g_logMagnumApp = std::make_shared<spdlog::logger>("flight", std::move(pSink));
+
+    bool const logAsync = args.isSet("log-async");
+    if (logAsync)
+    {
+        // One flusher thread keeps messages from each logger in order. Loggers never block when
+        // the queue is full, the oldest messages are dropped instead.
+        spdlog::init_thread_pool(args.value<std::size_t>("log-queue"), 1);
+    }
+
+    auto const make_logger = [&pSink, logAsync] (std::string name) -> osp::Logger_t
+    {
+        if (logAsync)
+        {
+            return std::make_shared<spdlog::async_logger>(std::move(name), pSink, spdlog::thread_pool(),
+                                                          spdlog::async_overflow_policy::overrun_oldest);
+        }
+        return std::make_shared<spdlog::logger>(std::move(name), pSink);
+    };
+
+    g_mainThreadLogger = make_logger("main-thread");
+    g_logExecutor      = make_logger("executor");
+    g_logMagnumApp     = make_logger("flight");
 
     // Set thread-local logger used by OSP_LOG_* macros
     osp::set_thread_logger(g_mainThreadLogger);
 
-    g_testApp.m_pExecutor = &g_executor;
+    // Farm instances share the pool executor's workers
+    if (std::string const executor = args.value("executor");
+        executor == "pool" || args.value<std::size_t>("farm") != 0)
+    {
+        g_poolExecutor.emplace(osp::TopWorkerPool::default_thread_count(), g_logExecutor);
+        g_testApp.m_pExecutor = &*g_poolExecutor;
+    }
+    else
+    {
+        if (executor != "single")
+        {
+            OSP_LOG_WARN("Unknown executor '{}', using single", executor);
+        }
+        g_testApp.m_pExecutor = &g_executor;
+    }
 
     if (args.isSet("log-exec"))
     {
-        g_executor.m_log = g_logExecutor;
+        g_testApp.m_pExecutor->m_log = g_logExecutor;
+    }
+
+    g_tracePath = args.value("trace-exec");
+    if ( ! g_tracePath.empty() )
+    {
+        g_testApp.m_pExecutor->m_pTrace = std::make_unique<osp::TopExecTrace>();
+    }
+
+    if (std::string const basisFormat = args.value("basis-format");
+        basisFormat != "auto")
+    {
+        if (std::optional<osp::EBasisTarget> const target = osp::basis_target_from_name(basisFormat);
+            target.has_value())
+        {
+            g_basisTarget = *target;
+        }
+        else
+        {
+            OSP_LOG_WARN("Unknown Basis format: {}", basisFormat);
+        }
+    }
+
+    // Subsystems are terrain_geometry, universe_sat_data, and jolt_temp
+    for (std::string_view pairs = args.value("large-alloc"); ! pairs.empty(); )
+    {
+        std::size_t const       comma = pairs.find(',');
+        std::string_view const  pair  = pairs.substr(0, comma);
+        pairs = (comma == std::string_view::npos) ? std::string_view{} : pairs.substr(comma + 1);
+
+        std::size_t const equals = pair.find('=');
+        std::optional<osp::LargeAllocPolicy> const policy = (equals != std::string_view::npos)
+                ? osp::large_alloc_policy_from_name(pair.substr(equals + 1))
+                : std::nullopt;
+        if (policy.has_value())
+        {
+            osp::large_alloc_policy_set(pair.substr(0, equals), *policy);
+        }
+        else
+        {
+            OSP_LOG_WARN("Unknown large allocation policy: {}", pair);
+        }
+    }
+
+    g_testApp.m_fixedSimStep = args.isSet("fixed-sim-step");
+    g_testApp.m_replicationPort = args.value<std::uint16_t>("serve-replication");
+
+    g_recordInputPath = args.value("record-input");
+    g_replayInputPath = args.value("replay-input");
+
+    if (args.isSet("quantize-meshes"))
+    {
+        g_meshOptimize |= osp::MeshOptimizeFlag::Quantize;
     }
 
     g_testApp.m_topData.resize(64);
     load_a_bunch_of_stuff();
 
+    if (std::string const metricsOut = args.value("metrics-out");
+        ! metricsOut.empty())
+    {
+        start_metrics_dump(metricsOut, std::chrono::duration<float>(args.value<float>("metrics-every")));
+    }
+
     if(args.value("scene") != "none")
     {
         auto const it = scenarios().find(args.value("scene"));
@@ -149,10 +331,64 @@ int main(int argc, char** argv)
             return 1;
         }
 
+        if (std::size_t const farmSize = args.value<std::size_t>("farm");
+            farmSize != 0)
+        {
+            FarmResult const result = run_farm(g_testApp, it->second.m_setup, g_poolExecutor->pool(), FarmOptions{
+                .instances      = farmSize,
+                .steps          = args.value<std::uint64_t>("steps"),
+                .outputPrefix   = args.value("farm-out") });
+
+            stop_metrics_dump();
+            g_testApp.clear_resource_owners();
+            spdlog::shutdown();
+            return result.instances.empty() ? 1 : 0;
+        }
+
         g_testApp.m_rendererSetup = it->second.m_setup(g_testApp);
+        g_sceneSetup = it->second.m_setup;
+        setup_profile().report("Scene", g_testApp.m_pMetrics);
+
+        if (args.isSet("headless"))
+        {
+            std::uint64_t steps = args.value<std::uint64_t>("steps");
+
+            // Input is only consumed by renderer sessions, which don't exist without a window.
+            // Replaying still reproduces the number of scene updates, which have a fixed delta.
+            if ( ! g_replayInputPath.empty() )
+            {
+                if (std::optional<osp::input::InputPlayback> const playback = osp::input::InputPlayback::load(g_replayInputPath.c_str());
+                    playback.has_value())
+                {
+                    steps = playback->frame_count();
+                }
+                else
+                {
+                    OSP_LOG_ERROR("Failed to load input recording: {}", g_replayInputPath);
+                }
+            }
+
+            HeadlessResult const result = run_headless(g_testApp, HeadlessOptions{
+                .steps = steps,
+                .rate  = args.value<float>("rate") });
+
+            stop_metrics_dump();
+            write_critical_path();
+            g_testApp.close_sessions(g_testApp.m_scene.m_sessions);
+            g_testApp.m_scene.m_sessions.clear();
+            g_testApp.clear_resource_owners();
+            spdlog::shutdown();
+            return (result.steps != 0) ? 0 : 1;
+        }
 
         start_magnum_async(argc, argv);
     }
+    else if (args.isSet("headless"))
+    {
+        OSP_LOG_ERROR("--headless requires --scene");
+        g_testApp.clear_resource_owners();
+        return 1;
+    }
 
     if( ! args.isSet("norepl"))
     {
@@ -165,6 +401,8 @@ int main(int argc, char** argv)
         g_magnumThread.join();
     }
 
+    stop_metrics_dump();
+
     spdlog::shutdown();
     return 0;
 }
@@ -188,11 +426,9 @@ void cli_loop(int argc, char** argv)
         {
             if (magnumOpen)
             {
-                // TODO: Figure out some way to reload the application while
-                //       its still running.
-                //       ie. Message it to destroy its GL resources and draw
-                //           function, then load new scene
-                std::cout << "Close application before opening new scene\n";
+                // Switched by the Magnum thread between frames, see switch_scene
+                std::cout << "Switching to scene: " << it->first << "\n";
+                g_testApp.m_pendingScene.store(it->second.m_setup);
             }
             else
             {
@@ -204,9 +440,12 @@ void cli_loop(int argc, char** argv)
                     g_testApp.close_sessions(g_testApp.m_scene.m_sessions);
                     g_testApp.m_scene.m_sessions.clear();
                     g_testApp.m_scene.m_edges.m_syncWith.clear();
+                    g_testApp.m_scene.m_edges.m_semaphoreEdges.clear();
                 }
 
                 g_testApp.m_rendererSetup = it->second.m_setup(g_testApp);
+                g_sceneSetup = it->second.m_setup;
+                setup_profile().report("Scene", g_testApp.m_pMetrics);
                 start_magnum_async(argc, argv);
             }
         }
@@ -235,6 +474,14 @@ void cli_loop(int argc, char** argv)
             {
                 print_resources();
             }
+            else if (command == "metrics")
+            {
+                print_metrics();
+            }
+            else if (command == "memory")
+            {
+                print_memory();
+            }
             else if (command == "exit") 
             {
                 if (magnumOpen)
@@ -273,17 +520,72 @@ void start_magnum_async(int argc, char** argv)
         OSP_DECLARE_GET_DATA_IDS(g_testApp.m_magnum, TESTAPP_DATA_MAGNUM); // declares idActiveApp
         auto &rActiveApp = osp::top_get<MagnumApplication>(g_testApp.m_topData, idActiveApp);
 
-        // Setup renderer sessions
+        setup_renderer_sessions();
 
-        g_testApp.m_rendererSetup(g_testApp);
+        // Both outlive rActiveApp.exec(), and are unset before the window closes
+        std::optional<osp::input::InputRecorder> inputRecorder;
+        std::optional<osp::input::InputPlayback> inputPlayback;
+        if ( ! g_replayInputPath.empty() )
+        {
+            inputPlayback = osp::input::InputPlayback::load(g_replayInputPath.c_str());
+            if (inputPlayback.has_value())
+            {
+                rActiveApp.set_input_playback(&*inputPlayback);
+                OSP_LOG_INFO("Playing back {} frames of input from {}", inputPlayback->frame_count(), g_replayInputPath);
+            }
+            else
+            {
+                OSP_LOG_ERROR("Failed to load input recording: {}", g_replayInputPath);
+            }
+        }
+        if ( ! g_recordInputPath.empty() )
+        {
+            rActiveApp.set_input_recorder(&inputRecorder.emplace());
+        }
 
-        g_testApp.m_graph = osp::make_exec_graph(g_testApp.m_tasks, {&g_testApp.m_renderer.m_edges, &g_testApp.m_scene.m_edges});
-        g_executor.load(g_testApp);
+        rActiveApp.set_between_frames([] (MagnumApplication& rApp)
+        {
+            if (SceneSetupFunc_t const setup = g_testApp.m_pendingScene.exchange(nullptr);
+                setup != nullptr)
+            {
+                rApp.switch_osp_app([setup] { switch_scene(setup); });
+            }
+        });
 
         // Starts the main loop. This function is blocking, and will only return
         // once the window is closed. See MagnumApplication::drawEvent
         rActiveApp.exec();
 
+        // Window closed before a requested switch could happen
+        g_testApp.m_pendingScene.store(nullptr);
+
+        rActiveApp.set_input_playback(nullptr);
+        rActiveApp.set_input_recorder(nullptr);
+        if (inputRecorder.has_value())
+        {
+            if (inputRecorder->save(g_recordInputPath.c_str()))
+            {
+                OSP_LOG_INFO("Wrote {} frames of input to {}", inputRecorder->frame_count(), g_recordInputPath);
+            }
+            else
+            {
+                OSP_LOG_ERROR("Failed to write input recording: {}", g_recordInputPath);
+            }
+        }
+
+        // Write trace before sessions are closed, as closing clears task names
+        if (std::unique_ptr<osp::TopExecTrace> &rpTrace = g_testApp.m_pExecutor->m_pTrace;
+            rpTrace != nullptr)
+        {
+            write_critical_path();
+            g_sceneFirstFrame = 0;
+
+            std::ofstream file{g_tracePath};
+            file << osp::TopExecWriteChromeTrace{g_testApp.m_tasks, g_testApp.m_taskData, *rpTrace};
+            OSP_LOG_INFO("Wrote execution trace to {}", g_tracePath);
+            *rpTrace = {};
+        }
+
         // Destruct draw function lambda first
         // EngineTest stores the entire renderer in here (if it's active)
         rActiveApp.set_osp_app({});
@@ -293,6 +595,7 @@ void start_magnum_async(int argc, char** argv)
         g_testApp.close_sessions(g_testApp.m_renderer.m_sessions);
         g_testApp.m_renderer.m_sessions.clear();
         g_testApp.m_renderer.m_edges.m_syncWith.clear();
+        g_testApp.m_renderer.m_edges.m_semaphoreEdges.clear();
 
         g_testApp.close_session(g_testApp.m_magnum);
         g_testApp.close_session(g_testApp.m_windowApp);
@@ -302,53 +605,107 @@ void start_magnum_async(int argc, char** argv)
     g_magnumThread.swap(t);
 }
 
-void load_a_bunch_of_stuff()
+void setup_renderer_sessions()
 {
-    using namespace osp::restypes;
-    using namespace Magnum;
-    using Primitives::ConeFlag;
-    using Primitives::CylinderFlag;
+    g_testApp.m_rendererSetup(g_testApp);
 
-    osp::TopTaskBuilder builder{g_testApp.m_tasks, g_testApp.m_applicationGroup.m_edges, g_testApp.m_taskData};
-    auto const plApp = g_testApp.m_application.create_pipelines<PlApplication>(builder);
+    {
+        SetupScope const scope{"rebuild_exec_graph"};
+        osp::rebuild_exec_graph(g_testApp.m_tasks, {&g_testApp.m_renderer.m_edges, &g_testApp.m_scene.m_edges}, g_testApp.m_graph);
+    }
 
-    builder.pipeline(plApp.mainLoop).loops(true).wait_for_signal(EStgOptn::ModifyOrSignal);
+    if (g_poolExecutor.has_value())
+    {
+        // GL objects can only be touched by this thread, which calls wait() from drawEvent
+        std::vector<osp::TopDataId> &rPinned = g_poolExecutor->m_coordinatorData;
+        rPinned.assign(g_testApp.m_windowApp.m_data.begin(), g_testApp.m_windowApp.m_data.end());
+        rPinned.insert(rPinned.end(), g_testApp.m_magnum.m_data.begin(), g_testApp.m_magnum.m_data.end());
+        for (osp::Session const &rSession : g_testApp.m_renderer.m_sessions)
+        {
+            rPinned.insert(rPinned.end(), rSession.m_data.begin(), rSession.m_data.end());
+        }
+    }
 
-    // declares idResources and idMainLoopCtrl
-    OSP_DECLARE_CREATE_DATA_IDS(g_testApp.m_application, g_testApp.m_topData, TESTAPP_DATA_APPLICATION);
+    g_testApp.m_pExecutor->label_sessions(g_testApp);
+    g_testApp.m_pExecutor->load(g_testApp);
 
-    auto &rResources = osp::top_emplace<osp::Resources> (g_testApp.m_topData, idResources);
-    /* unused */       osp::top_emplace<MainLoopControl>(g_testApp.m_topData, idMainLoopCtrl);
+    setup_profile().report("Renderer", g_testApp.m_pMetrics);
+}
 
-    builder.task()
-        .name       ("Schedule Main Loop")
-        .schedules  ({plApp.mainLoop(EStgOptn::Schedule)})
-        .push_to    (g_testApp.m_application.m_tasks)
-        .args       ({                  idMainLoopCtrl})
-        .func([] (MainLoopControl const& rMainLoopCtrl) noexcept -> osp::TaskActions
+void switch_scene(SceneSetupFunc_t const setup)
+{
+    // Only sessions of the scene and its renderer are closed. The window, Magnum application, and
+    // RenderGL stay, so GL meshes and textures of resources shared with the new scene are reused
+    // instead of uploaded again.
+    write_critical_path();
+
+    for (osp::Session const &rSession : g_testApp.m_renderer.m_sessions)
     {
-        if (   ! rMainLoopCtrl.doUpdate
-            && ! rMainLoopCtrl.doSync
-            && ! rMainLoopCtrl.doResync
-            && ! rMainLoopCtrl.doRender)
-        {
-            return osp::TaskAction::Cancel;
-        }
-        else
+        osp::session_remove_edges(g_testApp.m_renderer.m_edges, rSession);
+    }
+    g_testApp.close_sessions(g_testApp.m_renderer.m_sessions);
+    g_testApp.m_renderer.m_sessions.clear();
+
+    g_testApp.close_sessions(g_testApp.m_scene.m_sessions);
+    g_testApp.m_scene.m_sessions.clear();
+    g_testApp.m_scene.m_edges.m_syncWith.clear();
+    g_testApp.m_scene.m_edges.m_semaphoreEdges.clear();
+
+    g_testApp.m_rendererSetup = setup(g_testApp);
+    g_sceneSetup = setup;
+    setup_profile().report("Scene", g_testApp.m_pMetrics);
+    setup_renderer_sessions();
+
+    OSP_LOG_INFO("Switched scene");
+}
+
+void write_critical_path()
+{
+    IExecutor const &rExecutor = *g_testApp.m_pExecutor;
+    if (rExecutor.m_pTrace == nullptr)
+    {
+        return;
+    }
+
+    std::string_view scenario = "scene";
+    for (auto const& [rName, rScenario] : scenarios())
+    {
+        if (rScenario.m_setup == g_sceneSetup)
         {
-            return { };
+            scenario = rName;
         }
-    });
+    }
+
+    std::string const path = osp::string_concat(g_tracePath, ".", scenario, ".critical.txt");
+    std::ofstream file{path};
+    file << "Scenario: " << scenario << "\n";
+    rExecutor.write_critical_path(file, g_testApp, g_sceneFirstFrame);
+    OSP_LOG_INFO("Wrote critical path report to {}", path);
+
+    g_sceneFirstFrame = rExecutor.m_pTrace->frameStarts.size();
+}
+
+void load_a_bunch_of_stuff()
+{
+    using namespace osp::restypes;
+    using namespace Magnum;
+    using Primitives::ConeFlag;
+    using Primitives::CylinderFlag;
+
+    auto &rResources = g_testApp.setup_application({});
 
     rResources.resize_types(osp::ResTypeIdReg_t::size());
 
     rResources.data_register<Trade::ImageData2D>(gc_image);
+    rResources.data_register<osp::ImageMipChain>(gc_image);
     rResources.data_register<Trade::TextureData>(gc_texture);
     rResources.data_register<osp::TextureImgSource>(gc_texture);
     rResources.data_register<Trade::MeshData>(gc_mesh);
     rResources.data_register<osp::ImporterData>(gc_importer);
     rResources.data_register<osp::Prefabs>(gc_importer);
     osp::register_tinygltf_resources(rResources);
+    osp::register_asset_cache_resources(rResources);
+    ospjolt::register_prefab_shapes_resources(rResources);
     g_testApp.m_defaultPkg = rResources.pkg_create();
 
     // Load sturdy glTF files
@@ -365,12 +722,75 @@ void load_a_bunch_of_stuff()
         //"ph_rcs_plume.sturdy.gltf"
     };
 
-    // TODO: Make new gltf loader. This will read gltf files and dump meshes,
-    //       images, textures, and other relevant data into osp::Resources
-    for (auto const& meshName : meshes)
+    // A package archive beside the data directory replaces its loose files
+    if (g_testApp.m_packages.mount(g_testApp.m_defaultPkg, "OSPData/adera.ospkg"))
+    {
+        g_testApp.m_packages.prefetch(g_testApp.m_defaultPkg);
+
+        std::vector<osp::ResId> const loaded = osp::load_tinygltf_files(
+                osp::arrayView(meshes), rResources, g_testApp.m_defaultPkg, std::thread::hardware_concurrency(),
+                g_basisTarget, g_meshOptimize, g_testApp.m_packages.find(g_testApp.m_defaultPkg));
+
+        for (osp::ResId const res : loaded)
+        {
+            if (res != lgrn::id_null<osp::ResId>())
+            {
+                osp::assigns_prefabs_tinygltf(rResources, res);
+                ospjolt::build_prefab_shapes(rResources, res);
+            }
+        }
+    }
+    else
     {
-        osp::ResId res = osp::load_tinygltf_file(osp::string_concat(datapath, meshName), rResources, g_testApp.m_defaultPkg);
-        osp::assigns_prefabs_tinygltf(rResources, res);
+        // TODO: Make new gltf loader. This will read gltf files and dump meshes,
+        //       images, textures, and other relevant data into osp::Resources
+        //       Files with an up-to-date baked cache beside them skip glTF parsing entirely.
+        std::vector<std::string>    paths;
+        std::vector<std::uint64_t>  hashes;
+
+        // Collision shapes of prefabs are cached separately, so shapes are rebaked on their own
+        // when the Jolt version changes
+        auto const load_shapes = [&rResources] (std::string_view const path, std::uint64_t const hash, osp::ResId const importer)
+        {
+            std::string const shapesPath = osp::string_concat(path, ".ospshapes");
+            if (   ! ospjolt::load_prefab_shapes(shapesPath, hash, rResources, importer, g_testApp.m_defaultPkg)
+                &&   ospjolt::build_prefab_shapes(rResources, importer) )
+            {
+                ospjolt::save_prefab_shapes(shapesPath, hash, rResources, importer);
+            }
+        };
+
+        for (auto const& meshName : meshes)
+        {
+            std::string path = osp::string_concat(datapath, meshName);
+            std::uint64_t const hash = osp::asset_source_hash(
+                    path, std::uint32_t(g_basisTarget) | (std::uint32_t(std::uint8_t(g_meshOptimize)) << 8));
+            osp::ResId const cached = osp::load_asset_cache(
+                    osp::string_concat(path, ".ospcache"), hash, path, rResources, g_testApp.m_defaultPkg);
+            if (cached != lgrn::id_null<osp::ResId>())
+            {
+                load_shapes(path, hash, cached);
+            }
+            else
+            {
+                paths.push_back(std::move(path));
+                hashes.push_back(hash);
+            }
+        }
+        std::vector<std::string_view> const pathViews(paths.begin(), paths.end());
+
+        std::vector<osp::ResId> const loaded = osp::load_tinygltf_files(
+                pathViews, rResources, g_testApp.m_defaultPkg, std::thread::hardware_concurrency(), g_basisTarget, g_meshOptimize);
+
+        for (std::size_t i = 0; i < loaded.size(); ++i)
+        {
+            if (loaded[i] != lgrn::id_null<osp::ResId>())
+            {
+                osp::assigns_prefabs_tinygltf(rResources, loaded[i]);
+                osp::bake_asset_cache(osp::string_concat(paths[i], ".ospcache"), hashes[i], rResources, loaded[i]);
+                load_shapes(paths[i], hashes[i], loaded[i]);
+            }
+        }
     }
 
     // Add a default primitives
@@ -386,6 +806,8 @@ void load_a_bunch_of_stuff()
     add_mesh_quick("cube", Primitives::cubeSolid());
     add_mesh_quick("cubewire", Primitives::cubeWireframe());
     add_mesh_quick("sphere", Primitives::icosphereSolid(2));
+    add_mesh_quick("sphere_lod1", Primitives::icosphereSolid(1));
+    add_mesh_quick("sphere_lod2", Primitives::icosphereSolid(0));
     add_mesh_quick("cylinder", std::move(cylinder));
     add_mesh_quick("cone", std::move(cone));
     add_mesh_quick("grid64solid", Primitives::grid3DSolid({63, 63}));
@@ -416,11 +838,83 @@ void print_help()
     std::cout
         << "Other commands:\n"
         << "* list_pkg  - List Packages and Resources\n"
+        << "* metrics   - Show frame time, task time, and other metrics\n"
+        << "* memory    - Show bytes held by each session and peak bytes of tracked allocators\n"
         << "* help      - Show this again\n"
         << "* reopen    - Re-open Magnum Application\n"
         << "* exit      - Deallocate everything and return memory to OS\n";
 }
 
+void start_metrics_dump(std::filesystem::path path, std::chrono::duration<float> const period)
+{
+    OSP_DECLARE_GET_DATA_IDS(g_testApp.m_application, TESTAPP_DATA_APPLICATION);
+    auto const &rMetrics = osp::top_get<osp::Metrics>(g_testApp.m_topData, idMetrics);
+
+    g_metricsThread = std::thread([&rMetrics, path = std::move(path), period] ()
+    {
+        osp::set_thread_logger(g_mainThreadLogger);
+
+        bool const              json    = path.extension() == ".json";
+        std::filesystem::path   tmpPath = path;
+        tmpPath += ".tmp";
+
+        std::unique_lock lock{g_metricsMutex};
+        do
+        {
+            lock.unlock();
+            {
+                std::ofstream file{tmpPath, std::ios::trunc};
+                if (json)
+                {
+                    file << osp::MetricsWriteJson{rMetrics};
+                }
+                else
+                {
+                    file << osp::MetricsWriteCsv{rMetrics};
+                }
+            }
+            std::error_code error;
+            std::filesystem::rename(tmpPath, path, error);
+            if (error)
+            {
+                OSP_LOG_WARN("Failed to write metrics to {}: {}", path.string(), error.message());
+            }
+            lock.lock();
+        }
+        while ( ! g_metricsStopCv.wait_for(lock, period, [] { return g_metricsStop; }) );
+    });
+}
+
+void stop_metrics_dump()
+{
+    if ( ! g_metricsThread.joinable() )
+    {
+        return;
+    }
+
+    {
+        std::lock_guard const lock{g_metricsMutex};
+        g_metricsStop = true;
+    }
+    g_metricsStopCv.notify_all();
+    g_metricsThread.join();
+}
+
+void print_metrics()
+{
+    OSP_DECLARE_GET_DATA_IDS(g_testApp.m_application, TESTAPP_DATA_APPLICATION);
+    std::cout << osp::MetricsWriteCsv{osp::top_get<osp::Metrics>(g_testApp.m_topData, idMetrics)};
+}
+
+void print_memory()
+{
+    // Gauges are set by the executor between frames; reading TopData from here would race
+    OSP_DECLARE_GET_DATA_IDS(g_testApp.m_application, TESTAPP_DATA_APPLICATION);
+    std::cout << osp::MetricsWriteCsv{
+            .metrics = osp::top_get<osp::Metrics>(g_testApp.m_topData, idMetrics),
+            .prefix  = "mem_" };
+}
+
 void print_resources()
 {
     // TODO: Add features to list resources in osp::Resources
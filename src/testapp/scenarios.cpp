@@ -26,6 +26,7 @@
 #include "scenarios.h"
 #include "enginetest.h"
 #include "identifiers.h"
+#include "setup_profile.h"
 
 #include "sessions/common.h"
 #include "sessions/magnum.h"
@@ -67,6 +68,7 @@ static void setup_magnum_draw(TestApp& rTestApp, Session const& scene, Session c
 static constexpr auto   sc_matVisualizer    = draw::MaterialId(0);
 static constexpr auto   sc_matFlat          = draw::MaterialId(1);
 static constexpr auto   sc_matPhong         = draw::MaterialId(2);
+static constexpr auto   sc_matPlume         = draw::MaterialId(3);
 static constexpr int    sc_materialCount    = 4;
 
 static ScenarioMap_t make_scenarios()
@@ -87,7 +89,7 @@ static ScenarioMap_t make_scenarios()
         //
         // This macro expands to:
         //
-        //     auto const [idResources, idMainLoopCtrl] = osp::unpack<2>(rTestApp.m_application.m_data);
+        //     auto const [idResources, idMainLoopCtrl, idMetrics] = osp::unpack<3>(rTestApp.m_application.m_data);
         //
         // TopDataIds can be used to access rTestApp.m_topData. The purpose of TopData is to store
         // all data in a safe, type-erased, and addressable manner that can be easily accessed by
@@ -128,6 +130,23 @@ static ScenarioMap_t make_scenarios()
 
     static constexpr auto sc_gravityForce = Vector3{0.0f, 0.0f, -9.81f};
 
+    // Scenarios with falling shapes and vehicles keep at most a few thousand bodies around.
+    // Terrain adds a body for every collider chunk on top of that.
+    static ospjolt::JoltWorldConfig const sc_joltShapesConfig
+    {
+        .m_maxBodies    = 16384,
+        .m_maxBodyPairs = 32768,
+        .m_fixedRate    = 60.0f
+    };
+
+    static ospjolt::JoltWorldConfig const sc_joltTerrainConfig
+    {
+        .m_tempAllocatorSize    = 32 * 1024 * 1024,
+        .m_maxBodies            = 65536,
+        .m_maxBodyPairs         = 65536,
+        .m_fixedRate            = 60.0f
+    };
+
     add_scenario("physics", "Newton Dynamics integration test scenario",
                  [] (TestApp& rTestApp) -> RendererSetupFunc_t
     {
@@ -145,17 +164,17 @@ static ScenarioMap_t make_scenarios()
         auto & [SCENE_SESSIONS] = resize_then_unpack<10>(rTestApp.m_scene.m_sessions);
 
         // Compose together lots of Sessions
-        scene           = setup_scene               (builder, rTopData, application);
-        commonScene     = setup_common_scene        (builder, rTopData, scene, application, defaultPkg);
-        physics         = setup_physics             (builder, rTopData, scene, commonScene);
-        physShapes      = setup_phys_shapes         (builder, rTopData, scene, commonScene, physics, sc_matPhong);
-        droppers        = setup_droppers            (builder, rTopData, scene, commonScene, physShapes);
-        bounds          = setup_bounds              (builder, rTopData, scene, commonScene, physShapes);
-
-        jolt            = setup_jolt              (builder, rTopData, scene, commonScene, physics);
-        joltGravSet     = setup_jolt_factors      (builder, rTopData);
-        joltGrav        = setup_jolt_force_accel  (builder, rTopData, jolt, joltGravSet, sc_gravityForce);
-        physShapesJolt  = setup_phys_shapes_jolt  (builder, rTopData, commonScene, physics, physShapes, jolt, joltGravSet);
+        scene           = TESTAPP_TIMED(setup_scene)               (builder, rTopData, application);
+        commonScene     = TESTAPP_TIMED(setup_common_scene)        (builder, rTopData, scene, application, defaultPkg);
+        physics         = TESTAPP_TIMED(setup_physics)             (builder, rTopData, scene, commonScene);
+        physShapes      = TESTAPP_TIMED(setup_phys_shapes)         (builder, rTopData, scene, commonScene, physics, sc_matPhong);
+        droppers        = TESTAPP_TIMED(setup_droppers)            (builder, rTopData, scene, commonScene, physShapes);
+        bounds          = TESTAPP_TIMED(setup_bounds)              (builder, rTopData, scene, commonScene, physShapes);
+
+        jolt            = TESTAPP_TIMED(setup_jolt)              (builder, rTopData, application, scene, commonScene, physics, sc_joltShapesConfig);
+        joltGravSet     = TESTAPP_TIMED(setup_jolt_factors)      (builder, rTopData);
+        joltGrav        = TESTAPP_TIMED(setup_jolt_force_accel)  (builder, rTopData, jolt, joltGravSet, sc_gravityForce);
+        physShapesJolt  = TESTAPP_TIMED(setup_phys_shapes_jolt)  (builder, rTopData, commonScene, physics, physShapes, jolt, joltGravSet);
 
         add_floor(rTopData, physShapes, sc_matVisualizer, defaultPkg, 4);
 
@@ -172,20 +191,20 @@ static ScenarioMap_t make_scenarios()
             auto & [SCENE_SESSIONS] = unpack<10>(rTestApp.m_scene.m_sessions);
             auto & [RENDERER_SESSIONS] = resize_then_unpack<10>(rTestApp.m_renderer.m_sessions);
 
-            sceneRenderer   = setup_scene_renderer      (builder, rTopData, application, windowApp, commonScene);
+            sceneRenderer   = TESTAPP_TIMED(setup_scene_renderer)      (builder, rTopData, application, windowApp, commonScene);
             create_materials(rTopData, sceneRenderer, sc_materialCount);
 
-            magnumScene     = setup_magnum_scene        (builder, rTopData, application, windowApp, sceneRenderer, magnum, scene, commonScene);
-            cameraCtrl      = setup_camera_ctrl         (builder, rTopData, windowApp, sceneRenderer, magnumScene);
-            cameraFree      = setup_camera_free         (builder, rTopData, windowApp, scene, cameraCtrl);
-            shVisual        = setup_shader_visualizer   (builder, rTopData, windowApp, sceneRenderer, magnum, magnumScene, sc_matVisualizer);
-            shFlat          = setup_shader_flat         (builder, rTopData, windowApp, sceneRenderer, magnum, magnumScene, sc_matFlat);
-            shPhong         = setup_shader_phong        (builder, rTopData, windowApp, sceneRenderer, magnum, magnumScene, sc_matPhong);
-            camThrow        = setup_thrower             (builder, rTopData, windowApp, cameraCtrl, physShapes);
-            shapeDraw       = setup_phys_shapes_draw    (builder, rTopData, windowApp, sceneRenderer, commonScene, physics, physShapes);
-            cursor          = setup_cursor              (builder, rTopData, application, sceneRenderer, cameraCtrl, commonScene, sc_matFlat, rTestApp.m_defaultPkg);
-
-            setup_magnum_draw(rTestApp, scene, sceneRenderer, magnumScene);
+            magnumScene     = TESTAPP_TIMED(setup_magnum_scene)        (builder, rTopData, application, windowApp, sceneRenderer, magnum, scene, commonScene);
+            cameraCtrl      = TESTAPP_TIMED(setup_camera_ctrl)         (builder, rTopData, windowApp, sceneRenderer, magnum, magnumScene);
+            cameraFree      = TESTAPP_TIMED(setup_camera_free)         (builder, rTopData, windowApp, scene, cameraCtrl);
+            shVisual        = TESTAPP_TIMED(setup_shader_visualizer)   (builder, rTopData, windowApp, sceneRenderer, magnum, magnumScene, sc_matVisualizer);
+            shFlat          = TESTAPP_TIMED(setup_shader_flat)         (builder, rTopData, windowApp, sceneRenderer, magnum, magnumScene, sc_matFlat);
+            shPhong         = TESTAPP_TIMED(setup_shader_phong)        (builder, rTopData, windowApp, sceneRenderer, magnum, magnumScene, sc_matPhong);
+            camThrow        = TESTAPP_TIMED(setup_thrower)             (builder, rTopData, windowApp, cameraCtrl, physShapes);
+            shapeDraw       = TESTAPP_TIMED(setup_phys_shapes_draw)    (builder, rTopData, windowApp, sceneRenderer, commonScene, physics, physShapes);
+            cursor          = TESTAPP_TIMED(setup_cursor)              (builder, rTopData, application, sceneRenderer, cameraCtrl, commonScene, sc_matFlat, rTestApp.m_defaultPkg);
+
+            TESTAPP_TIMED(setup_magnum_draw)(rTestApp, scene, sceneRenderer, magnumScene);
         };
 
         #undef SCENE_SESSIONS
@@ -200,9 +219,10 @@ static ScenarioMap_t make_scenarios()
         #define SCENE_SESSIONS      scene, commonScene, physics, physShapes, droppers, bounds, jolt, joltGravSet, joltGrav, physShapesJolt, \
                                     prefabs, parts, vehicleSpawn, signalsFloat, \
                                     vehicleSpawnVB, vehicleSpawnRgd, vehicleSpawnJolt, \
-                                    testVehicles, machRocket, machRcsDriver, joltRocketSet, rocketsJolt
+                                    testVehicles, machRocket, machRcsDriver, machPlugins, joltRocketSet, rocketsJolt, joltAeroSet, aeroJolt, vehicleRepl, \
+                                    uniCore, uniScnFrame, vehicleHandoff
         #define RENDERER_SESSIONS   sceneRenderer, magnumScene, cameraCtrl, shVisual, shFlat, shPhong, camThrow, shapeDraw, cursor, \
-                                    prefabDraw, vehicleDraw, vehicleCtrl, cameraVehicle, thrustIndicator
+                                    prefabDraw, vehicleDraw, weldMergeDraw, vehicleCtrl, cameraVehicle, thrustIndicator, rocketPlumes, shPlume
 
         using namespace testapp::scenes;
 
@@ -212,32 +232,47 @@ static ScenarioMap_t make_scenarios()
 
         TopTaskBuilder builder{rTestApp.m_tasks, rTestApp.m_scene.m_edges, rTestApp.m_taskData};
 
-        auto & [SCENE_SESSIONS] = resize_then_unpack<22>(rTestApp.m_scene.m_sessions);
-
-        scene            = setup_scene               (builder, rTopData, application);
-        commonScene      = setup_common_scene        (builder, rTopData, scene, application, defaultPkg);
-        physics          = setup_physics             (builder, rTopData, scene, commonScene);
-        physShapes       = setup_phys_shapes         (builder, rTopData, scene, commonScene, physics, sc_matPhong);
-        droppers         = setup_droppers            (builder, rTopData, scene, commonScene, physShapes);
-        bounds           = setup_bounds              (builder, rTopData, scene, commonScene, physShapes);
-
-        prefabs          = setup_prefabs             (builder, rTopData, application, scene, commonScene, physics);
-        parts            = setup_parts               (builder, rTopData, application, scene);
-        signalsFloat     = setup_signals_float       (builder, rTopData, scene, parts);
-        vehicleSpawn     = setup_vehicle_spawn       (builder, rTopData, scene);
-        vehicleSpawnVB   = setup_vehicle_spawn_vb    (builder, rTopData, application, scene, commonScene, prefabs, parts, vehicleSpawn, signalsFloat);
-        testVehicles     = setup_prebuilt_vehicles   (builder, rTopData, application, scene);
-
-        machRocket       = setup_mach_rocket         (builder, rTopData, scene, parts, signalsFloat);
-        machRcsDriver    = setup_mach_rcsdriver      (builder, rTopData, scene, parts, signalsFloat);
-
-        jolt             = setup_jolt              (builder, rTopData, scene, commonScene, physics);
-        joltGravSet      = setup_jolt_factors      (builder, rTopData);
-        joltGrav         = setup_jolt_force_accel  (builder, rTopData, jolt, joltGravSet, sc_gravityForce);
-        physShapesJolt   = setup_phys_shapes_jolt  (builder, rTopData, commonScene, physics, physShapes, jolt, joltGravSet);
-        vehicleSpawnJolt = setup_vehicle_spawn_jolt(builder, rTopData, application, commonScene, physics, prefabs, parts, vehicleSpawn, jolt);
-        joltRocketSet    = setup_jolt_factors      (builder, rTopData);
-        rocketsJolt      = setup_rocket_thrust_jolt(builder, rTopData, scene, commonScene, physics, prefabs, parts, signalsFloat, jolt, joltRocketSet);
+        auto & [SCENE_SESSIONS] = resize_then_unpack<29>(rTestApp.m_scene.m_sessions);
+
+        scene            = TESTAPP_TIMED(setup_scene)               (builder, rTopData, application);
+        commonScene      = TESTAPP_TIMED(setup_common_scene)        (builder, rTopData, scene, application, defaultPkg);
+        physics          = TESTAPP_TIMED(setup_physics)             (builder, rTopData, scene, commonScene);
+        physShapes       = TESTAPP_TIMED(setup_phys_shapes)         (builder, rTopData, scene, commonScene, physics, sc_matPhong);
+        droppers         = TESTAPP_TIMED(setup_droppers)            (builder, rTopData, scene, commonScene, physShapes);
+        bounds           = TESTAPP_TIMED(setup_bounds)              (builder, rTopData, scene, commonScene, physShapes);
+
+        prefabs          = TESTAPP_TIMED(setup_prefabs)             (builder, rTopData, application, scene, commonScene, physics);
+        parts            = TESTAPP_TIMED(setup_parts)               (builder, rTopData, application, scene);
+        signalsFloat     = TESTAPP_TIMED(setup_signals_float)       (builder, rTopData, scene, parts);
+        vehicleSpawn     = TESTAPP_TIMED(setup_vehicle_spawn)       (builder, rTopData, scene);
+        vehicleSpawnVB   = TESTAPP_TIMED(setup_vehicle_spawn_vb)    (builder, rTopData, application, scene, commonScene, prefabs, parts, vehicleSpawn, signalsFloat);
+        testVehicles     = TESTAPP_TIMED(setup_prebuilt_vehicles)   (builder, rTopData, application, scene);
+
+        machRocket       = TESTAPP_TIMED(setup_mach_rocket)         (builder, rTopData, scene, parts, signalsFloat);
+        machRcsDriver    = TESTAPP_TIMED(setup_mach_rcsdriver)      (builder, rTopData, scene, parts, signalsFloat);
+        machPlugins      = TESTAPP_TIMED(setup_mach_plugins)        (builder, rTopData, scene, parts, signalsFloat);
+
+        jolt             = TESTAPP_TIMED(setup_jolt)              (builder, rTopData, application, scene, commonScene, physics, sc_joltShapesConfig);
+        joltGravSet      = TESTAPP_TIMED(setup_jolt_factors)      (builder, rTopData);
+        joltGrav         = TESTAPP_TIMED(setup_jolt_force_accel)  (builder, rTopData, jolt, joltGravSet, sc_gravityForce);
+        physShapesJolt   = TESTAPP_TIMED(setup_phys_shapes_jolt)  (builder, rTopData, commonScene, physics, physShapes, jolt, joltGravSet);
+        vehicleSpawnJolt = TESTAPP_TIMED(setup_vehicle_spawn_jolt)(builder, rTopData, application, commonScene, physics, prefabs, parts, vehicleSpawn, jolt);
+        joltRocketSet    = TESTAPP_TIMED(setup_jolt_factors)      (builder, rTopData);
+        rocketsJolt      = TESTAPP_TIMED(setup_rocket_thrust_jolt)(builder, rTopData, scene, commonScene, physics, prefabs, parts, signalsFloat, jolt, joltRocketSet);
+        joltAeroSet      = TESTAPP_TIMED(setup_jolt_factors)      (builder, rTopData);
+        aeroJolt         = TESTAPP_TIMED(setup_aero_jolt)         (builder, rTopData, scene, commonScene, physics, parts, jolt, joltAeroSet, adera::AeroAtmosphere{});
+
+        if (rTestApp.m_replicationPort != 0)
+        {
+            vehicleRepl  = TESTAPP_TIMED(setup_vehicle_replication_jolt)(builder, rTopData, application, scene, commonScene, parts, signalsFloat, jolt, rTestApp.m_replicationPort);
+        }
+
+        // Vehicles that fly far away continue on rails, orbiting an Earth-sized point mass that
+        // pulls with the same gravity at the origin
+        auto const tgApp = application.get_pipelines< PlApplication >();
+        uniCore          = TESTAPP_TIMED(setup_uni_core)            (builder, rTopData, tgApp.mainLoop);
+        uniScnFrame      = TESTAPP_TIMED(setup_uni_sceneframe)      (builder, rTopData, uniCore);
+        vehicleHandoff   = TESTAPP_TIMED(setup_vehicle_handoff_jolt)(builder, rTopData, application, scene, commonScene, parts, signalsFloat, vehicleSpawn, vehicleSpawnVB, jolt, uniCore, uniScnFrame, defaultPkg, 300.0f, 200.0f, sc_gravityForce, 6.371e6);
 
         OSP_DECLARE_GET_DATA_IDS(vehicleSpawn,   TESTAPP_DATA_VEHICLE_SPAWN);
         OSP_DECLARE_GET_DATA_IDS(vehicleSpawnVB, TESTAPP_DATA_VEHICLE_SPAWN_VB);
@@ -270,27 +305,30 @@ static ScenarioMap_t make_scenarios()
 
             TopTaskBuilder builder{rTestApp.m_tasks, rTestApp.m_renderer.m_edges, rTestApp.m_taskData};
 
-            auto & [SCENE_SESSIONS] = unpack<22>(rTestApp.m_scene.m_sessions);
-            auto & [RENDERER_SESSIONS] = resize_then_unpack<14>(rTestApp.m_renderer.m_sessions);
+            auto & [SCENE_SESSIONS] = unpack<26>(rTestApp.m_scene.m_sessions);
+            auto & [RENDERER_SESSIONS] = resize_then_unpack<17>(rTestApp.m_renderer.m_sessions);
 
-            sceneRenderer   = setup_scene_renderer      (builder, rTopData, application, windowApp, commonScene);
+            sceneRenderer   = TESTAPP_TIMED(setup_scene_renderer)      (builder, rTopData, application, windowApp, commonScene);
             create_materials(rTopData, sceneRenderer, sc_materialCount);
 
-            magnumScene     = setup_magnum_scene        (builder, rTopData, application, windowApp, sceneRenderer, magnum, scene, commonScene);
-            cameraCtrl      = setup_camera_ctrl         (builder, rTopData, windowApp, sceneRenderer, magnumScene);
-            shVisual        = setup_shader_visualizer   (builder, rTopData, windowApp, sceneRenderer, magnum, magnumScene, sc_matVisualizer);
-            shFlat          = setup_shader_flat         (builder, rTopData, windowApp, sceneRenderer, magnum, magnumScene, sc_matFlat);
-            shPhong         = setup_shader_phong        (builder, rTopData, windowApp, sceneRenderer, magnum, magnumScene, sc_matPhong);
-            camThrow        = setup_thrower             (builder, rTopData, windowApp, cameraCtrl, physShapes);
-            shapeDraw       = setup_phys_shapes_draw    (builder, rTopData, windowApp, sceneRenderer, commonScene, physics, physShapes);
-            cursor          = setup_cursor              (builder, rTopData, application, sceneRenderer, cameraCtrl, commonScene, sc_matFlat, rTestApp.m_defaultPkg);
-            prefabDraw      = setup_prefab_draw         (builder, rTopData, application, windowApp, sceneRenderer, commonScene, prefabs, sc_matPhong);
-            vehicleDraw     = setup_vehicle_spawn_draw  (builder, rTopData, sceneRenderer, vehicleSpawn);
-            vehicleCtrl     = setup_vehicle_control     (builder, rTopData, windowApp, scene, parts, signalsFloat);
-            cameraVehicle   = setup_camera_vehicle      (builder, rTopData, windowApp, scene, sceneRenderer, commonScene, physics, parts, cameraCtrl, vehicleCtrl);
-            thrustIndicator = setup_thrust_indicators   (builder, rTopData, application, windowApp, commonScene, parts, signalsFloat, sceneRenderer, defaultPkg, sc_matFlat);
-
-            setup_magnum_draw(rTestApp, scene, sceneRenderer, magnumScene);
+            magnumScene     = TESTAPP_TIMED(setup_magnum_scene)        (builder, rTopData, application, windowApp, sceneRenderer, magnum, scene, commonScene);
+            cameraCtrl      = TESTAPP_TIMED(setup_camera_ctrl)         (builder, rTopData, windowApp, sceneRenderer, magnum, magnumScene);
+            shVisual        = TESTAPP_TIMED(setup_shader_visualizer)   (builder, rTopData, windowApp, sceneRenderer, magnum, magnumScene, sc_matVisualizer);
+            shFlat          = TESTAPP_TIMED(setup_shader_flat)         (builder, rTopData, windowApp, sceneRenderer, magnum, magnumScene, sc_matFlat);
+            shPhong         = TESTAPP_TIMED(setup_shader_phong)        (builder, rTopData, windowApp, sceneRenderer, magnum, magnumScene, sc_matPhong);
+            camThrow        = TESTAPP_TIMED(setup_thrower)             (builder, rTopData, windowApp, cameraCtrl, physShapes);
+            shapeDraw       = TESTAPP_TIMED(setup_phys_shapes_draw)    (builder, rTopData, windowApp, sceneRenderer, commonScene, physics, physShapes);
+            cursor          = TESTAPP_TIMED(setup_cursor)              (builder, rTopData, application, sceneRenderer, cameraCtrl, commonScene, sc_matFlat, rTestApp.m_defaultPkg);
+            prefabDraw      = TESTAPP_TIMED(setup_prefab_draw)         (builder, rTopData, application, windowApp, sceneRenderer, commonScene, prefabs, sc_matPhong);
+            vehicleDraw     = TESTAPP_TIMED(setup_vehicle_spawn_draw)  (builder, rTopData, sceneRenderer, vehicleSpawn);
+            weldMergeDraw   = TESTAPP_TIMED(setup_weld_merge_draw)     (builder, rTopData, application, windowApp, commonScene, parts, sceneRenderer, defaultPkg);
+            vehicleCtrl     = TESTAPP_TIMED(setup_vehicle_control)     (builder, rTopData, windowApp, scene, parts, signalsFloat);
+            cameraVehicle   = TESTAPP_TIMED(setup_camera_vehicle)      (builder, rTopData, windowApp, scene, sceneRenderer, commonScene, physics, parts, cameraCtrl, vehicleCtrl);
+            thrustIndicator = TESTAPP_TIMED(setup_thrust_indicators)   (builder, rTopData, application, windowApp, commonScene, parts, signalsFloat, sceneRenderer, defaultPkg, sc_matFlat);
+            rocketPlumes    = TESTAPP_TIMED(setup_rocket_plumes)       (builder, rTopData, application, windowApp, scene, commonScene, parts, signalsFloat, sceneRenderer, defaultPkg, sc_matPlume);
+            shPlume         = TESTAPP_TIMED(setup_shader_plume)        (builder, rTopData, windowApp, sceneRenderer, magnum, magnumScene, rocketPlumes, sc_matPlume);
+
+            TESTAPP_TIMED(setup_magnum_draw)(rTestApp, scene, sceneRenderer, magnumScene);
         };
 
         #undef SCENE_SESSIONS
@@ -302,8 +340,9 @@ static ScenarioMap_t make_scenarios()
     add_scenario("terrain", "Planet terrain mesh test",
                  [] (TestApp& rTestApp) -> RendererSetupFunc_t
     {
-        #define SCENE_SESSIONS      scene, commonScene, physics, physShapes, terrain, terrainIco, terrainSubdiv
-        #define RENDERER_SESSIONS   sceneRenderer, magnumScene, cameraCtrl, cameraFree, shVisual, shFlat, shPhong, camThrow, shapeDraw, cursor, terrainDraw
+        #define SCENE_SESSIONS      scene, commonScene, physics, physShapes, terrain, terrainIco, terrainSubdiv, \
+                                    jolt, joltGravSet, joltGrav, physShapesJolt, terrainJolt
+        #define RENDERER_SESSIONS   sceneRenderer, magnumScene, cameraCtrl, cameraFree, shVisual, shFlat, shPhong, camThrow, shapeDraw, cursor, terrainDraw, terrainDrawGl
 
         using namespace testapp::scenes;
 
@@ -313,17 +352,22 @@ static ScenarioMap_t make_scenarios()
 
         TopTaskBuilder builder{rTestApp.m_tasks, rTestApp.m_scene.m_edges, rTestApp.m_taskData};
 
-        auto & [SCENE_SESSIONS] = resize_then_unpack<7>(rTestApp.m_scene.m_sessions);
-
-        scene           = setup_scene               (builder, rTopData, application);
-        commonScene     = setup_common_scene        (builder, rTopData, scene, application, defaultPkg);
-        physics         = setup_physics             (builder, rTopData, scene, commonScene);
-        physShapes      = setup_phys_shapes         (builder, rTopData, scene, commonScene, physics, sc_matPhong);
-        terrain         = setup_terrain             (builder, rTopData, scene);
-        terrainIco      = setup_terrain_icosahedron (builder, rTopData, terrain);
-        terrainSubdiv   = setup_terrain_subdiv_dist (builder, rTopData, scene, terrain, terrainIco);
-
-        initialize_ico_terrain(rTopData, terrain, terrainIco, {
+        auto & [SCENE_SESSIONS] = resize_then_unpack<12>(rTestApp.m_scene.m_sessions);
+
+        scene           = TESTAPP_TIMED(setup_scene)               (builder, rTopData, application);
+        commonScene     = TESTAPP_TIMED(setup_common_scene)        (builder, rTopData, scene, application, defaultPkg);
+        physics         = TESTAPP_TIMED(setup_physics)             (builder, rTopData, scene, commonScene);
+        physShapes      = TESTAPP_TIMED(setup_phys_shapes)         (builder, rTopData, scene, commonScene, physics, sc_matPhong);
+        terrain         = TESTAPP_TIMED(setup_terrain)             (builder, rTopData, scene);
+        terrainIco      = TESTAPP_TIMED(setup_terrain_icosahedron) (builder, rTopData, terrain);
+        terrainSubdiv   = TESTAPP_TIMED(setup_terrain_subdiv_dist) (builder, rTopData, scene, terrain, terrainIco);
+        jolt            = TESTAPP_TIMED(setup_jolt)                (builder, rTopData, application, scene, commonScene, physics, sc_joltTerrainConfig);
+        joltGravSet     = TESTAPP_TIMED(setup_jolt_factors)        (builder, rTopData);
+        joltGrav        = TESTAPP_TIMED(setup_jolt_force_accel)    (builder, rTopData, jolt, joltGravSet, sc_gravityForce);
+        physShapesJolt  = TESTAPP_TIMED(setup_phys_shapes_jolt)    (builder, rTopData, commonScene, physics, physShapes, jolt, joltGravSet);
+        terrainJolt     = TESTAPP_TIMED(setup_terrain_collider_jolt)(builder, rTopData, scene, terrain, jolt);
+
+        TESTAPP_TIMED(initialize_ico_terrain)(rTopData, terrain, terrainIco, TerrainTestPlanetSpecs{
             .radius                 = 50.0,
             .height                 = 5.0,
             .skelPrecision          = 10, // 2^10 units = 1024 units = 1 meter
@@ -341,30 +385,35 @@ static ScenarioMap_t make_scenarios()
 
             TopTaskBuilder builder{rTestApp.m_tasks, rTestApp.m_renderer.m_edges, rTestApp.m_taskData};
 
-            auto & [SCENE_SESSIONS] = unpack<7>(rTestApp.m_scene.m_sessions);
-            auto & [RENDERER_SESSIONS] = resize_then_unpack<11>(rTestApp.m_renderer.m_sessions);
+            auto & [SCENE_SESSIONS] = unpack<12>(rTestApp.m_scene.m_sessions);
+            auto & [RENDERER_SESSIONS] = resize_then_unpack<12>(rTestApp.m_renderer.m_sessions);
 
-            sceneRenderer   = setup_scene_renderer      (builder, rTopData, application, windowApp, commonScene);
+            sceneRenderer   = TESTAPP_TIMED(setup_scene_renderer)      (builder, rTopData, application, windowApp, commonScene);
             create_materials(rTopData, sceneRenderer, sc_materialCount);
 
-            magnumScene     = setup_magnum_scene        (builder, rTopData, application, windowApp, sceneRenderer, magnum, scene, commonScene);
-            cameraCtrl      = setup_camera_ctrl         (builder, rTopData, windowApp, sceneRenderer, magnumScene);
-            cameraFree      = setup_camera_free         (builder, rTopData, windowApp, scene, cameraCtrl);
-            shVisual        = setup_shader_visualizer   (builder, rTopData, windowApp, sceneRenderer, magnum, magnumScene, sc_matVisualizer);
-            shFlat          = setup_shader_flat         (builder, rTopData, windowApp, sceneRenderer, magnum, magnumScene, sc_matFlat);
-            shPhong         = setup_shader_phong        (builder, rTopData, windowApp, sceneRenderer, magnum, magnumScene, sc_matPhong);
-            shapeDraw       = setup_phys_shapes_draw    (builder, rTopData, windowApp, sceneRenderer, commonScene, physics, physShapes);
-            cursor          = setup_cursor              (builder, rTopData, application, sceneRenderer, cameraCtrl, commonScene, sc_matFlat, rTestApp.m_defaultPkg);
-            terrainDraw     = setup_terrain_debug_draw  (builder, rTopData, windowApp, sceneRenderer, cameraCtrl, commonScene, terrain, terrainIco, sc_matFlat);
+            magnumScene     = TESTAPP_TIMED(setup_magnum_scene)        (builder, rTopData, application, windowApp, sceneRenderer, magnum, scene, commonScene);
+            cameraCtrl      = TESTAPP_TIMED(setup_camera_ctrl)         (builder, rTopData, windowApp, sceneRenderer, magnum, magnumScene);
+            cameraFree      = TESTAPP_TIMED(setup_camera_free)         (builder, rTopData, windowApp, scene, cameraCtrl);
+            shVisual        = TESTAPP_TIMED(setup_shader_visualizer)   (builder, rTopData, windowApp, sceneRenderer, magnum, magnumScene, sc_matVisualizer);
+            shFlat          = TESTAPP_TIMED(setup_shader_flat)         (builder, rTopData, windowApp, sceneRenderer, magnum, magnumScene, sc_matFlat);
+            shPhong         = TESTAPP_TIMED(setup_shader_phong)        (builder, rTopData, windowApp, sceneRenderer, magnum, magnumScene, sc_matPhong);
+            shapeDraw       = TESTAPP_TIMED(setup_phys_shapes_draw)    (builder, rTopData, windowApp, sceneRenderer, commonScene, physics, physShapes);
+            cursor          = TESTAPP_TIMED(setup_cursor)              (builder, rTopData, application, sceneRenderer, cameraCtrl, commonScene, sc_matFlat, rTestApp.m_defaultPkg);
+            terrainDraw     = TESTAPP_TIMED(setup_terrain_debug_draw)  (builder, rTopData, windowApp, sceneRenderer, cameraCtrl, commonScene, terrain, terrainIco, sc_matFlat);
+            terrainDrawGl   = TESTAPP_TIMED(setup_terrain_draw_magnum) (builder, rTopData, windowApp, sceneRenderer, magnum, magnumScene, shPhong, terrain, terrainIco);
 
             OSP_DECLARE_GET_DATA_IDS(cameraCtrl,   TESTAPP_DATA_CAMERA_CTRL);
+            OSP_DECLARE_GET_DATA_IDS(magnumScene,  TESTAPP_DATA_MAGNUM_SCENE);
 
             auto &rCamCtrl = top_get<ACtxCameraController>(rTopData, idCamCtrl);
             rCamCtrl.m_target = Vector3(0.0f, 0.0f, 50.0f);
             rCamCtrl.m_orbitDistanceMin = 1.0f;
             rCamCtrl.m_moveSpeed = 0.5f;
 
-            setup_magnum_draw(rTestApp, scene, sceneRenderer, magnumScene);
+            // The planet hides most of what's on its far side
+            top_get<draw::ACtxSceneRenderGL>(rTopData, idScnRenderGl).m_occlusionCull = true;
+
+            TESTAPP_TIMED(setup_magnum_draw)(rTestApp, scene, sceneRenderer, magnumScene);
         };
 
         #undef SCENE_SESSIONS
@@ -376,8 +425,8 @@ static ScenarioMap_t make_scenarios()
     add_scenario("universe", "Universe test scenario with very unrealistic planets",
                  [] (TestApp& rTestApp) -> RendererSetupFunc_t
     {
-        #define SCENE_SESSIONS      scene, commonScene, physics, physShapes, droppers, bounds, jolt, joltGravSet, joltGrav, physShapesJolt, uniCore, uniScnFrame, uniTestPlanets
-        #define RENDERER_SESSIONS   sceneRenderer, magnumScene, cameraCtrl, cameraFree, shVisual, shFlat, shPhong, camThrow, shapeDraw, cursor, planetsDraw
+        #define SCENE_SESSIONS      scene, commonScene, physics, physShapes, droppers, bounds, jolt, joltGravSet, joltGrav, physShapesJolt, uniCore, uniScnFrame, uniTestPlanets, uniTerrains
+        #define RENDERER_SESSIONS   sceneRenderer, magnumScene, cameraCtrl, cameraFree, shVisual, shFlat, shPhong, camThrow, shapeDraw, cursor, planetsDraw, planetsDrawGl, planetTrails
 
         using namespace testapp::scenes;
 
@@ -387,26 +436,33 @@ static ScenarioMap_t make_scenarios()
 
         TopTaskBuilder builder{rTestApp.m_tasks, rTestApp.m_scene.m_edges, rTestApp.m_taskData};
 
-        auto & [SCENE_SESSIONS] = resize_then_unpack<13>(rTestApp.m_scene.m_sessions);
+        auto & [SCENE_SESSIONS] = resize_then_unpack<14>(rTestApp.m_scene.m_sessions);
 
         // Compose together lots of Sessions
-        scene           = setup_scene               (builder, rTopData, application);
-        commonScene     = setup_common_scene        (builder, rTopData, scene, application, defaultPkg);
-        physics         = setup_physics             (builder, rTopData, scene, commonScene);
-        physShapes      = setup_phys_shapes         (builder, rTopData, scene, commonScene, physics, sc_matPhong);
-        droppers        = setup_droppers            (builder, rTopData, scene, commonScene, physShapes);
-        bounds          = setup_bounds              (builder, rTopData, scene, commonScene, physShapes);
-
-        jolt            = setup_jolt              (builder, rTopData, scene, commonScene, physics);
-        joltGravSet     = setup_jolt_factors      (builder, rTopData);
-        joltGrav        = setup_jolt_force_accel  (builder, rTopData, jolt, joltGravSet, Vector3{0.0f, 0.0f, -9.81f});
-        physShapesJolt  = setup_phys_shapes_jolt  (builder, rTopData, commonScene, physics, physShapes, jolt, joltGravSet);
+        scene           = TESTAPP_TIMED(setup_scene)               (builder, rTopData, application);
+        commonScene     = TESTAPP_TIMED(setup_common_scene)        (builder, rTopData, scene, application, defaultPkg);
+        physics         = TESTAPP_TIMED(setup_physics)             (builder, rTopData, scene, commonScene);
+        physShapes      = TESTAPP_TIMED(setup_phys_shapes)         (builder, rTopData, scene, commonScene, physics, sc_matPhong);
+        droppers        = TESTAPP_TIMED(setup_droppers)            (builder, rTopData, scene, commonScene, physShapes);
+        bounds          = TESTAPP_TIMED(setup_bounds)              (builder, rTopData, scene, commonScene, physShapes);
+
+        jolt            = TESTAPP_TIMED(setup_jolt)              (builder, rTopData, application, scene, commonScene, physics, sc_joltShapesConfig);
+        joltGravSet     = TESTAPP_TIMED(setup_jolt_factors)      (builder, rTopData);
+        joltGrav        = TESTAPP_TIMED(setup_jolt_force_accel)  (builder, rTopData, jolt, joltGravSet, Vector3{0.0f, 0.0f, -9.81f});
+        physShapesJolt  = TESTAPP_TIMED(setup_phys_shapes_jolt)  (builder, rTopData, commonScene, physics, physShapes, jolt, joltGravSet);
 
         auto const tgApp = application.get_pipelines< PlApplication >();
 
-        uniCore         = setup_uni_core            (builder, rTopData, tgApp.mainLoop);
-        uniScnFrame     = setup_uni_sceneframe      (builder, rTopData, uniCore);
-        uniTestPlanets  = setup_uni_testplanets     (builder, rTopData, uniCore, uniScnFrame);
+        uniCore         = TESTAPP_TIMED(setup_uni_core)            (builder, rTopData, tgApp.mainLoop);
+        uniScnFrame     = TESTAPP_TIMED(setup_uni_sceneframe)      (builder, rTopData, uniCore);
+        uniTestPlanets  = TESTAPP_TIMED(setup_uni_testplanets)     (builder, rTopData, uniCore, uniScnFrame);
+        uniTerrains     = TESTAPP_TIMED(setup_uni_terrains)        (builder, rTopData, uniCore, uniScnFrame, uniTestPlanets, TerrainTestPlanetSpecs{
+            .radius                 = 50.0,
+            .height                 = 5.0,
+            .skelPrecision          = 10,
+            .skelMaxSubdivLevels    = 7,
+            .chunkSubdivLevels      = 4
+        });
 
         add_floor(rTopData, physShapes, sc_matVisualizer, defaultPkg, 0);
 
@@ -420,24 +476,30 @@ static ScenarioMap_t make_scenarios()
 
             TopTaskBuilder builder{rTestApp.m_tasks, rTestApp.m_renderer.m_edges, rTestApp.m_taskData};
 
-            auto & [SCENE_SESSIONS] = unpack<13>(rTestApp.m_scene.m_sessions);
-            auto & [RENDERER_SESSIONS] = resize_then_unpack<11>(rTestApp.m_renderer.m_sessions);
+            auto & [SCENE_SESSIONS] = unpack<14>(rTestApp.m_scene.m_sessions);
+            auto & [RENDERER_SESSIONS] = resize_then_unpack<13>(rTestApp.m_renderer.m_sessions);
 
-            sceneRenderer   = setup_scene_renderer      (builder, rTopData, application, windowApp, commonScene);
+            sceneRenderer   = TESTAPP_TIMED(setup_scene_renderer)      (builder, rTopData, application, windowApp, commonScene);
             create_materials(rTopData, sceneRenderer, sc_materialCount);
 
-            magnumScene     = setup_magnum_scene        (builder, rTopData, application, windowApp, sceneRenderer, magnum, scene, commonScene);
-            cameraCtrl      = setup_camera_ctrl         (builder, rTopData, windowApp, sceneRenderer, magnumScene);
-            cameraFree      = setup_camera_free         (builder, rTopData, windowApp, scene, cameraCtrl);
-            shVisual        = setup_shader_visualizer   (builder, rTopData, windowApp, sceneRenderer, magnum, magnumScene, sc_matVisualizer);
-            shFlat          = setup_shader_flat         (builder, rTopData, windowApp, sceneRenderer, magnum, magnumScene, sc_matFlat);
-            shPhong         = setup_shader_phong        (builder, rTopData, windowApp, sceneRenderer, magnum, magnumScene, sc_matPhong);
-            camThrow        = setup_thrower             (builder, rTopData, windowApp, cameraCtrl, physShapes);
-            shapeDraw       = setup_phys_shapes_draw    (builder, rTopData, windowApp, sceneRenderer, commonScene, physics, physShapes);
-            cursor          = setup_cursor              (builder, rTopData, application, sceneRenderer, cameraCtrl, commonScene, sc_matFlat, rTestApp.m_defaultPkg);
-            planetsDraw     = setup_testplanets_draw    (builder, rTopData, windowApp, sceneRenderer, cameraCtrl, commonScene, uniCore, uniScnFrame, uniTestPlanets, sc_matVisualizer, sc_matFlat);
-
-            setup_magnum_draw(rTestApp, scene, sceneRenderer, magnumScene);
+            magnumScene     = TESTAPP_TIMED(setup_magnum_scene)        (builder, rTopData, application, windowApp, sceneRenderer, magnum, scene, commonScene);
+            cameraCtrl      = TESTAPP_TIMED(setup_camera_ctrl)         (builder, rTopData, windowApp, sceneRenderer, magnum, magnumScene);
+            cameraFree      = TESTAPP_TIMED(setup_camera_free)         (builder, rTopData, windowApp, scene, cameraCtrl);
+            shVisual        = TESTAPP_TIMED(setup_shader_visualizer)   (builder, rTopData, windowApp, sceneRenderer, magnum, magnumScene, sc_matVisualizer);
+            shFlat          = TESTAPP_TIMED(setup_shader_flat)         (builder, rTopData, windowApp, sceneRenderer, magnum, magnumScene, sc_matFlat);
+            shPhong         = TESTAPP_TIMED(setup_shader_phong)        (builder, rTopData, windowApp, sceneRenderer, magnum, magnumScene, sc_matPhong);
+            camThrow        = TESTAPP_TIMED(setup_thrower)             (builder, rTopData, windowApp, cameraCtrl, physShapes);
+            shapeDraw       = TESTAPP_TIMED(setup_phys_shapes_draw)    (builder, rTopData, windowApp, sceneRenderer, commonScene, physics, physShapes);
+            cursor          = TESTAPP_TIMED(setup_cursor)              (builder, rTopData, application, sceneRenderer, cameraCtrl, commonScene, sc_matFlat, rTestApp.m_defaultPkg);
+            planetsDraw     = TESTAPP_TIMED(setup_testplanets_draw)    (builder, rTopData, windowApp, sceneRenderer, cameraCtrl, commonScene, uniCore, uniScnFrame, uniTestPlanets, sc_matVisualizer, sc_matFlat);
+            planetsDrawGl   = TESTAPP_TIMED(setup_testplanets_draw_magnum)(builder, rTopData, windowApp, sceneRenderer, magnum, magnumScene, uniCore, uniScnFrame, uniTestPlanets);
+            planetTrails    = TESTAPP_TIMED(setup_testplanets_trails_magnum)(builder, rTopData, windowApp, sceneRenderer, magnum, magnumScene, uniCore, uniScnFrame, uniTestPlanets);
+
+            // Planets hide most of what's behind them
+            OSP_DECLARE_GET_DATA_IDS(magnumScene, TESTAPP_DATA_MAGNUM_SCENE);
+            top_get<draw::ACtxSceneRenderGL>(rTopData, idScnRenderGl).m_occlusionCull = true;
+
+            TESTAPP_TIMED(setup_magnum_draw)(rTestApp, scene, sceneRenderer, magnumScene);
         };
 
         #undef SCENE_SESSIONS
@@ -450,7 +512,7 @@ static ScenarioMap_t make_scenarios()
         [](TestApp& rTestApp) -> RendererSetupFunc_t
         {
             #define SCENE_SESSIONS      scene, commonScene, solarSystemCore, solarSystemScnFrame, solarSystemTestPlanets
-            #define RENDERER_SESSIONS   sceneRenderer, magnumScene, cameraCtrl, cameraFree, shFlat, planetsDraw
+            #define RENDERER_SESSIONS   sceneRenderer, magnumScene, cameraCtrl, cameraFree, shFlat, planetsDraw, nbodyCompute
 
             using namespace testapp::scenes;
 
@@ -463,14 +525,14 @@ static ScenarioMap_t make_scenarios()
             auto& [SCENE_SESSIONS] = resize_then_unpack<5>(rTestApp.m_scene.m_sessions);
 
             // Compose together lots of Sessions
-            scene = setup_scene(builder, rTopData, application);
-            commonScene = setup_common_scene(builder, rTopData, scene, application, defaultPkg);
+            scene = TESTAPP_TIMED(setup_scene)(builder, rTopData, application);
+            commonScene = TESTAPP_TIMED(setup_common_scene)(builder, rTopData, scene, application, defaultPkg);
 
             auto const tgApp = application.get_pipelines< PlApplication >();
 
-            solarSystemCore = setup_uni_core(builder, rTopData, tgApp.mainLoop);
-            solarSystemScnFrame = setup_uni_sceneframe(builder, rTopData, solarSystemCore);
-            solarSystemTestPlanets = setup_solar_system_testplanets(builder, rTopData, solarSystemCore, solarSystemScnFrame);
+            solarSystemCore = TESTAPP_TIMED(setup_uni_core)(builder, rTopData, tgApp.mainLoop);
+            solarSystemScnFrame = TESTAPP_TIMED(setup_uni_sceneframe)(builder, rTopData, solarSystemCore);
+            solarSystemTestPlanets = TESTAPP_TIMED(setup_solar_system_testplanets)(builder, rTopData, solarSystemCore, solarSystemScnFrame);
 
             RendererSetupFunc_t const setup_renderer = [](TestApp& rTestApp)
             {
@@ -483,13 +545,13 @@ static ScenarioMap_t make_scenarios()
                 TopTaskBuilder builder{ rTestApp.m_tasks, rTestApp.m_renderer.m_edges, rTestApp.m_taskData };
 
                 auto& [SCENE_SESSIONS] = unpack<5>(rTestApp.m_scene.m_sessions);
-                auto& [RENDERER_SESSIONS] = resize_then_unpack<6>(rTestApp.m_renderer.m_sessions);
+                auto& [RENDERER_SESSIONS] = resize_then_unpack<7>(rTestApp.m_renderer.m_sessions);
 
-                sceneRenderer = setup_scene_renderer(builder, rTopData, application, windowApp, commonScene);
+                sceneRenderer = TESTAPP_TIMED(setup_scene_renderer)(builder, rTopData, application, windowApp, commonScene);
                 create_materials(rTopData, sceneRenderer, sc_materialCount);
 
-                magnumScene = setup_magnum_scene(builder, rTopData, application, windowApp, sceneRenderer, magnum, scene, commonScene);
-                cameraCtrl = setup_camera_ctrl(builder, rTopData, windowApp, sceneRenderer, magnumScene);
+                magnumScene = TESTAPP_TIMED(setup_magnum_scene)(builder, rTopData, application, windowApp, sceneRenderer, magnum, scene, commonScene);
+                cameraCtrl = TESTAPP_TIMED(setup_camera_ctrl)(builder, rTopData, windowApp, sceneRenderer, magnum, magnumScene);
 
                 OSP_DECLARE_GET_DATA_IDS(cameraCtrl, TESTAPP_DATA_CAMERA_CTRL);
 
@@ -497,11 +559,12 @@ static ScenarioMap_t make_scenarios()
                 auto& rCameraController = top_get<ACtxCameraController>(rTopData, idCamCtrl);
                 rCameraController.m_orbitDistance += 75000;
 
-                cameraFree = setup_camera_free(builder, rTopData, windowApp, scene, cameraCtrl);
-                shFlat = setup_shader_flat(builder, rTopData, windowApp, sceneRenderer, magnum, magnumScene, sc_matFlat);
-                planetsDraw = setup_solar_system_planets_draw(builder, rTopData, windowApp, sceneRenderer, cameraCtrl, commonScene, solarSystemCore, solarSystemScnFrame, solarSystemTestPlanets, sc_matFlat);
+                cameraFree = TESTAPP_TIMED(setup_camera_free)(builder, rTopData, windowApp, scene, cameraCtrl);
+                shFlat = TESTAPP_TIMED(setup_shader_flat)(builder, rTopData, windowApp, sceneRenderer, magnum, magnumScene, sc_matFlat);
+                planetsDraw = TESTAPP_TIMED(setup_solar_system_planets_draw)(builder, rTopData, windowApp, sceneRenderer, cameraCtrl, commonScene, solarSystemCore, solarSystemScnFrame, solarSystemTestPlanets, sc_matFlat);
+                nbodyCompute = TESTAPP_TIMED(setup_nbody_compute_magnum)(builder, rTopData, windowApp, magnum, solarSystemCore, solarSystemTestPlanets);
 
-                setup_magnum_draw(rTestApp, scene, sceneRenderer, magnumScene);
+                TESTAPP_TIMED(setup_magnum_draw)(rTestApp, scene, sceneRenderer, magnumScene);
             };
 
             #undef SCENE_SESSIONS
@@ -539,10 +602,19 @@ struct MainLoopSignals
 class CommonMagnumApp : public IOspApplication
 {
 public:
-    CommonMagnumApp(TestApp &rTestApp, MainLoopControl &rMainLoopCtrl, MainLoopSignals signals) noexcept
+    CommonMagnumApp(
+            TestApp                         &rTestApp,
+            MainLoopControl                 &rMainLoopCtrl,
+            MainLoopSignals                 signals,
+            input::UserInputHandler         &rUserInput,
+            float const                     &rSimStep,
+            Metrics const                   &rMetrics) noexcept
      : m_rTestApp       { rTestApp }
      , m_rMainLoopCtrl  { rMainLoopCtrl }
      , m_signals        { signals }
+     , m_rUserInput     { rUserInput }
+     , m_rSimStep       { rSimStep }
+     , m_rFrameTime     { rMetrics.histogram("frame_ms") }
     { }
 
     void run(MagnumApplication& rApp) override
@@ -570,6 +642,14 @@ public:
     {
         // Magnum Application's main loop calls this
 
+        m_rFrameTime.record(delta * 1000.0f);
+
+        if (m_rTestApp.m_fixedSimStep)
+        {
+            draw_fixed_step(delta);
+            return;
+        }
+
         m_rMainLoopCtrl = MainLoopControl{
             .doUpdate = true,
             .doSync   = true,
@@ -605,6 +685,64 @@ public:
 
 private:
 
+    /**
+     * @brief Run as many scene updates as fit in the frame time, then render once
+     *
+     * Scene updates always advance by the scene's fixed delta time (idDeltaTimeIn), no matter
+     * how long frames take. Leftover time carries over to the next frame, so the average update
+     * rate stays fixed while rendering runs at whatever rate the window allows. Rendering always
+     * shows the most recently completed update.
+     */
+    void draw_fixed_step(float const delta)
+    {
+        float const step = m_rSimStep;
+
+        // Drop time that can't be caught up on, so a slow update can't keep making the next
+        // frame even slower
+        m_simAccumulator = std::min(m_simAccumulator + delta, step * float(smc_maxSimStepsPerFrame));
+
+        int const updates = int(m_simAccumulator / step);
+        m_simAccumulator -= step * float(updates);
+
+        for (int i = 0; i < updates; ++i)
+        {
+            if (i != 0)
+            {
+                // Input events were already seen by the first update, only held buttons remain
+                m_rUserInput.clear_events();
+                m_rUserInput.update_controls();
+            }
+
+            // Sync every update, as scene changes (new or deleted DrawEnts, dirty meshes) are
+            // only picked up by the renderer within the same update
+            m_rMainLoopCtrl = MainLoopControl{
+                .doUpdate = true,
+                .doSync   = true,
+                .doResync = false,
+                .doRender = i == (updates - 1),
+            };
+
+            signal_all();
+
+            m_rTestApp.m_pExecutor->wait(m_rTestApp);
+        }
+
+        if (updates == 0)
+        {
+            // Nothing new to show from the scene, but the camera may have still moved
+            m_rMainLoopCtrl = MainLoopControl{
+                .doUpdate = false,
+                .doSync   = false,
+                .doResync = false,
+                .doRender = true,
+            };
+
+            signal_all();
+
+            m_rTestApp.m_pExecutor->wait(m_rTestApp);
+        }
+    }
+
     void signal_all()
     {
         m_rTestApp.m_pExecutor->signal(m_rTestApp, m_signals.mainLoop);
@@ -615,10 +753,18 @@ private:
         m_rTestApp.m_pExecutor->signal(m_rTestApp, m_signals.sceneRender);
     }
 
-    TestApp         &m_rTestApp;
-    MainLoopControl &m_rMainLoopCtrl;
+    static constexpr int smc_maxSimStepsPerFrame = 4;
+
+    TestApp                 &m_rTestApp;
+    MainLoopControl         &m_rMainLoopCtrl;
+
+    MainLoopSignals         m_signals;
+
+    input::UserInputHandler &m_rUserInput;
+    float const             &m_rSimStep;
+    float                   m_simAccumulator{0.0f};
 
-    MainLoopSignals m_signals;
+    MetricHistogram const   &m_rFrameTime;
 };
 
 void setup_magnum_draw(TestApp& rTestApp, Session const& scene, Session const& sceneRenderer, Session const& magnumScene)
@@ -627,10 +773,15 @@ void setup_magnum_draw(TestApp& rTestApp, Session const& scene, Session const& s
     OSP_DECLARE_GET_DATA_IDS(sceneRenderer,             TESTAPP_DATA_SCENE_RENDERER);
     OSP_DECLARE_GET_DATA_IDS(rTestApp.m_magnum,         TESTAPP_DATA_MAGNUM);
     OSP_DECLARE_GET_DATA_IDS(magnumScene,               TESTAPP_DATA_MAGNUM_SCENE);
+    OSP_DECLARE_GET_DATA_IDS(rTestApp.m_windowApp,      TESTAPP_DATA_WINDOW_APP);
+    OSP_DECLARE_GET_DATA_IDS(scene,                     TESTAPP_DATA_SCENE);
 
-    auto &rMainLoopCtrl = top_get<MainLoopControl>  (rTestApp.m_topData, idMainLoopCtrl);
-    auto &rActiveApp    = top_get<MagnumApplication>(rTestApp.m_topData, idActiveApp);
-    auto &rCamera       = top_get<draw::Camera>     (rTestApp.m_topData, idCamera);
+    auto &rMainLoopCtrl = top_get<MainLoopControl>          (rTestApp.m_topData, idMainLoopCtrl);
+    auto &rUserInput    = top_get<input::UserInputHandler>  (rTestApp.m_topData, idUserInput);
+    auto &rSimStep      = top_get<float>                    (rTestApp.m_topData, idDeltaTimeIn);
+    auto &rMetrics      = top_get<Metrics>                  (rTestApp.m_topData, idMetrics);
+    auto &rActiveApp    = top_get<MagnumApplication>        (rTestApp.m_topData, idActiveApp);
+    auto &rCamera       = top_get<draw::Camera>             (rTestApp.m_topData, idCamera);
 
     rCamera.set_aspect_ratio(Vector2{Magnum::GL::defaultFramebuffer.viewport().size()});
 
@@ -644,7 +795,7 @@ void setup_magnum_draw(TestApp& rTestApp, Session const& scene, Session const& s
         .sceneRender  = sceneRenderer          .get_pipelines<PlSceneRenderer>() .render,
     };
 
-    rActiveApp.set_osp_app( std::make_unique<CommonMagnumApp>(rTestApp, rMainLoopCtrl, signals) );
+    rActiveApp.set_osp_app( std::make_unique<CommonMagnumApp>(rTestApp, rMainLoopCtrl, signals, rUserInput, rSimStep, rMetrics) );
 }
 
 } // namespace testapp
@@ -111,9 +111,20 @@ Session setup_common_scene(
         .run_on     ({tgCS.activeEntDelete(Schedule_)})
         .push_to    (out.m_tasks)
         .args       ({      idBasic,                      idActiveEntDel })
-        .func([] (ACtxBasic& rBasic, ActiveEntVec_t const& rActiveEntDel) noexcept
+        .func([] (ACtxBasic& rBasic, ActiveEntVec_t const& rActiveEntDel) noexcept -> TaskActions
     {
-        return rActiveEntDel.empty() ? TaskAction::Cancel : TaskActions{};
+        if (rActiveEntDel.empty())
+        {
+            return TaskAction::Cancel;
+        }
+
+        // Single tombstone pass, consumed by delete tasks that filter sets of ActiveEnts
+        rBasic.m_deleted.resize(rBasic.m_activeIds.capacity());
+        for (ActiveEnt const ent : rActiveEntDel)
+        {
+            rBasic.m_deleted.insert(ent);
+        }
+        return {};
     });
 
     rBuilder.task()
@@ -146,12 +157,17 @@ Session setup_common_scene(
 
     rBuilder.task()
         .name       ("Clear ActiveEnt delete vector once we're done with it")
+        .cheap      ()
         .run_on     ({tgCS.activeEntDelete(Clear)})
         .push_to    (out.m_tasks)
-        .args       ({            idActiveEntDel })
-        .func([] (ActiveEntVec_t& idActiveEntDel) noexcept
+        .args       ({      idBasic,                      idActiveEntDel })
+        .func([] (ACtxBasic& rBasic, ActiveEntVec_t& rActiveEntDel) noexcept
     {
-        idActiveEntDel.clear();
+        for (ActiveEnt const ent : rActiveEntDel)
+        {
+            rBasic.m_deleted.erase(ent);
+        }
+        rActiveEntDel.clear();
     });
 
 
@@ -193,6 +209,8 @@ Session setup_common_scene(
     rNMesh.m_shapeToMesh.emplace(EShape::Cylinder,  quick_add_mesh("cylinder"));
     rNMesh.m_shapeToMesh.emplace(EShape::Sphere,    quick_add_mesh("sphere"));
     rNMesh.m_namedMeshs.emplace("floor", quick_add_mesh("grid64solid"));
+    rNMesh.m_namedMeshs.emplace("sphere_lod1", quick_add_mesh("sphere_lod1"));
+    rNMesh.m_namedMeshs.emplace("sphere_lod2", quick_add_mesh("sphere_lod2"));
 
     return out;
 } // setup_common_scene
@@ -288,6 +306,18 @@ Session setup_scene_renderer(
     auto &rScnRender = osp::top_emplace<ACtxSceneRender>(topData, idScnRender);
     /* unused */       osp::top_emplace<DrawTfObservers>(topData, idDrawTfObservers);
 
+    rBuilder.task()
+        .name       ("Schedule resizing DrawEnt containers")
+        .schedules  ({tgScnRdr.drawEntResized(Schedule)})
+        .sync_with  ({tgWin.sync(Run)})
+        .push_to    (out.m_tasks)
+        .args       ({idScnRender})
+        .func       ([] (ACtxSceneRender& rScnRender) noexcept -> TaskActions
+    {
+        // Containers are grown with headroom, so most frames that add DrawEnts skip resizing
+        return rScnRender.grow_draw_capacity() ? TaskActions{} : TaskAction::Cancel;
+    });
+
     rBuilder.task()
         .name       ("Resize ACtxSceneRender containers to fit all DrawEnts")
         .run_on     ({tgScnRdr.drawEntResized(Run)})
@@ -350,19 +380,20 @@ Session setup_scene_renderer(
         .sync_with  ({tgCS.hierarchy(Ready), tgCS.transform(Ready), tgCS.activeEnt(Ready), tgScnRdr.drawTransforms(Modify_), tgScnRdr.drawEnt(Ready), tgScnRdr.drawEntResized(Done), tgCS.activeEntResized(Done)})
         .push_to    (out.m_tasks)
         .args       ({            idBasic,                   idDrawing,                 idScnRender,                 idDrawTfObservers })
-        .func([] (ACtxBasic const& rBasic, ACtxDrawing const& rDrawing, ACtxSceneRender& rScnRender, DrawTfObservers &rDrawTfObservers) noexcept
+        .func([] (ACtxBasic& rBasic, ACtxDrawing const& rDrawing, ACtxSceneRender& rScnRender, DrawTfObservers &rDrawTfObservers) noexcept
     {
-        auto rootChildren = SysSceneGraph::children(rBasic.m_scnGraph);
-        SysRender::update_draw_transforms(
+        // Single-threaded, since draw transform observers may write to shared state
+        SysRender::update_draw_transforms_linear(
                 {
                     .scnGraph     = rBasic    .m_scnGraph,
                     .transforms   = rBasic    .m_transform,
                     .activeToDraw = rScnRender.m_activeToDraw,
                     .needDrawTf   = rScnRender.m_needDrawTf,
-                    .rDrawTf      = rScnRender.m_drawTransform
+                    .rDrawTf      = rScnRender.m_drawTransform,
+                    .pTfDirty     = &rBasic   .m_scnGraph.m_transformDirty
                 },
-                rootChildren.begin(),
-                rootChildren.end(),
+                rScnRender.m_treeWorldTf,
+                {},
                 [&rDrawTfObservers, &rScnRender] (Matrix4 const& transform, active::ActiveEnt ent, int depth)
         {
             auto const enableInt  = std::array{rScnRender.drawTfObserverEnable[ent]};
@@ -390,10 +421,18 @@ Session setup_scene_renderer(
             {
                 continue;
             }
+
+            // Deleted IDs get reused, don't call observers meant for the old entity
+            if (std::size_t(ent) < rScnRender.drawTfObserverEnable.size())
+            {
+                rScnRender.drawTfObserverEnable[ent] = 0;
+            }
+
             DrawEnt const drawEnt = std::exchange(rScnRender.m_activeToDraw[ent], lgrn::id_null<DrawEnt>());
             if (drawEnt != lgrn::id_null<DrawEnt>())
             {
                 rDrawEntDel.push_back(drawEnt);
+                rScnRender.m_drawDeleted.insert(drawEnt);
             }
         }
     });
@@ -434,30 +473,27 @@ Session setup_scene_renderer(
         .args       ({            idScnRender,                    idDrawEntDel })
         .func([] (ACtxSceneRender& rScnRender, DrawEntVec_t const& rDrawEntDel) noexcept
     {
-        for (DrawEnt const ent : rDrawEntDel)
-        {
-            for (Material &rMat : rScnRender.m_materials)
-            {
-                if (std::size_t(ent) < rMat.m_ents.size())
-                {
-                    rMat.m_ents.erase(ent);
-                }
-            }
-        }
+        SysRender::update_delete_materials(rScnRender, rScnRender.m_drawDeleted);
     });
 
     rBuilder.task()
         .name       ("Clear DrawEnt delete vector once we're done with it")
+        .cheap      ()
         .run_on     ({tgScnRdr.drawEntDelete(Clear)})
         .push_to    (out.m_tasks)
-        .args       ({         idDrawEntDel })
-        .func([] (DrawEntVec_t& rDrawEntDel) noexcept
+        .args       ({            idScnRender,              idDrawEntDel })
+        .func([] (ACtxSceneRender& rScnRender, DrawEntVec_t& rDrawEntDel) noexcept
     {
+        for (DrawEnt const drawEnt : rDrawEntDel)
+        {
+            rScnRender.m_drawDeleted.erase(drawEnt);
+        }
         rDrawEntDel.clear();
     });
 
     rBuilder.task()
         .name       ("Clear dirty DrawEnt's textures once we're done with it")
+        .cheap      ()
         .run_on     ({tgScnRdr.entMeshDirty(Clear)})
         .push_to    (out.m_tasks)
         .args       ({            idScnRender})
@@ -468,6 +504,7 @@ Session setup_scene_renderer(
 
     rBuilder.task()
         .name       ("Clear dirty DrawEnt's textures once we're done with it")
+        .cheap      ()
         .run_on     ({tgScnRdr.entTextureDirty(Clear)})
         .push_to    (out.m_tasks)
         .args       ({            idScnRender})
@@ -478,6 +515,7 @@ Session setup_scene_renderer(
 
     rBuilder.task()
         .name       ("Clear dirty materials once we're done with it")
+        .cheap      ()
         .run_on     ({tgScnRdr.materialDirty(Clear)})
         .push_to    (out.m_tasks)
         .args       ({            idScnRender})
@@ -485,13 +523,16 @@ Session setup_scene_renderer(
     {
         for (Material &rMat : rScnRender.m_materials)
         {
+            SysRender::update_material_list(rMat);
             rMat.m_dirty.clear();
         }
     });
 
+    out.m_cleanup = tgScnRdr.cleanup;
+
     rBuilder.task()
         .name       ("Clean up scene owners")
-        .run_on     ({tgWin.cleanup(Run_)})
+        .run_on     ({tgScnRdr.cleanup(Run_)})
         .push_to    (out.m_tasks)
         .args       ({        idDrawing,                 idScnRender})
         .func([] (ACtxDrawing& rDrawing, ACtxSceneRender& rScnRender) noexcept
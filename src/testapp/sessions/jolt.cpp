@@ -25,18 +25,46 @@
 #include "jolt.h"
 #include "physics.h"
 #include "shapes.h"
+#include "terrain.h"
+#include "universe.h"
 
 #include <osp/activescene/basic_fn.h>
 #include <osp/activescene/physics_fn.h>
 #include <osp/activescene/prefab_fn.h>
 #include <osp/activescene/vehicles.h>
+#include <osp/core/byte_stream.h>
+#include <osp/core/math_2pow.h>
 #include <osp/core/Resources.h>
 #include <osp/drawing/drawing.h>
+#include <osp/net/replication.h>
+#include <osp/net/udp_socket.h>
+#include <osp/universe/coordinates.h>
+#include <osp/universe/kepler.h>
+#include <osp/util/logging.h>
 #include <osp/vehicles/ImporterData.h>
 
+#include <adera/activescene/aerodynamics.h>
+#include <adera/activescene/vehicle_blueprint.h>
+#include <adera/activescene/vehicle_handoff.h>
+#include <adera/activescene/vehicles_vb_fn.h>
 #include <adera/machines/links.h>
 
+#include <ospjolt/activescene/forcekernels.h>
 #include <ospjolt/activescene/joltinteg_fn.h>
+#include <ospjolt/activescene/prefab_shapes.h>
+
+#include <Jolt/Physics/Collision/Shape/MeshShape.h>
+
+#include <Corrade/Containers/ArrayViewStl.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <utility>
 
 using namespace osp;
 using namespace osp::active;
@@ -53,15 +81,18 @@ namespace testapp::scenes
 Session setup_jolt(
         TopTaskBuilder&             rBuilder,
         ArrayView<entt::any> const  topData,
+        Session const&              application,
         osp::Session const&         scene,
         Session const&              commonScene,
-        Session const&              physics)
+        Session const&              physics,
+        JoltWorldConfig             config)
 {
     //Mandatory Jolt setup steps (start of program)
     ACtxJoltWorld::initJoltGlobal();
     JPH_IF_ENABLE_ASSERTS(AssertFailed = AssertFailedImpl;)
 
 
+    OSP_DECLARE_GET_DATA_IDS(application,   TESTAPP_DATA_APPLICATION);
     OSP_DECLARE_GET_DATA_IDS(scene,         TESTAPP_DATA_SCENE);
     OSP_DECLARE_GET_DATA_IDS(commonScene,   TESTAPP_DATA_COMMON_SCENE);
     OSP_DECLARE_GET_DATA_IDS(physics,       TESTAPP_DATA_PHYSICS);
@@ -76,10 +107,19 @@ Session setup_jolt(
 
     rBuilder.pipeline(tgJolt.joltBody).parent(tgScn.update);
 
-    top_emplace< ACtxJoltWorld >(topData, idJolt, 2);
-
     using ospjolt::SysJolt;
 
+    // Share worker threads with any other Jolt world
+    if (config.m_pJobSystem == nullptr)
+    {
+        config.m_pJobSystem = SysJolt::shared_job_system(config.m_threadCount);
+    }
+
+    auto &rJolt = top_emplace< ACtxJoltWorld >(topData, idJolt, config);
+
+    // Shapes of loaded prefabs are already made, spawning them only hits the cache
+    seed_shape_cache(rJolt, top_get<Resources>(topData, idResources));
+
     rBuilder.task()
         .name       ("Delete Jolt components")
         .run_on     ({tgCS.activeEntDelete(UseOrRun)})
@@ -91,18 +131,34 @@ Session setup_jolt(
         SysJolt::update_delete (rJolt, rActiveEntDel.cbegin(), rActiveEntDel.cend());
     });
 
+    // Transforms, drawing, and rendering all wait on the physics step
     rBuilder.task()
         .name       ("Update Jolt world")
+        .priority   (1)
         .run_on     ({tgScn.update(Run)})
-        .sync_with  ({tgJolt.joltBody(Prev), tgCS.hierarchy(Prev), tgPhy.physBody(Prev), tgPhy.physUpdate(Run), tgCS.transform(Prev)})
+        .sync_with  ({tgJolt.joltBody(Prev), tgCS.hierarchy(Prev), tgPhy.physBody(Prev), tgPhy.physUpdate(Run), tgCS.transform(Prev), tgPhy.contacts(Modify_)})
         .push_to    (out.m_tasks)
         .args({             idBasic,             idPhys,              idJolt,           idDeltaTimeIn })
         .func([] (ACtxBasic& rBasic, ACtxPhysics& rPhys, ACtxJoltWorld& rJolt, float const deltaTimeIn, WorkerContext ctx) noexcept
     {
-        SysJolt::update_world(rPhys, rJolt, deltaTimeIn, rBasic.m_transform);
+        using Clock_t = std::chrono::steady_clock;
+        Clock_t::time_point const start = Clock_t::now();
+
+        SysJolt::update_world(rPhys, rJolt, deltaTimeIn, rBasic.m_transform, &rBasic.m_scnGraph.m_transformDirty);
+
+        ctx.histogram_record("physics.step_ms", std::chrono::duration<double, std::milli>(Clock_t::now() - start).count());
     });
 
-    top_emplace< ACtxJoltWorld >(topData, idJolt, 2);
+    rBuilder.task()
+        .name       ("Cast rays with Jolt")
+        .run_on     ({tgScn.update(Run)})
+        .sync_with  ({tgPhy.raycast(Modify), tgJolt.joltBody(Ready), tgPhy.physBody(Ready), tgCS.transform(Ready)})
+        .push_to    (out.m_tasks)
+        .args({             idPhys,              idJolt })
+        .func([] (ACtxPhysics& rPhys, ACtxJoltWorld& rJolt) noexcept
+    {
+        SysJolt::update_raycasts(rJolt, rPhys.m_rays);
+    });
 
     return out;
 } // setup_jolt
@@ -145,30 +201,173 @@ osp::Session setup_jolt_force_accel(
 
     auto &rAccel    = top_emplace<Vector3>(topData, idAcceleration, accel);
 
-    ACtxJoltWorld::ForceFactorFunc const factor
+    // A kernel, so it can be fused with other kernels, see setup_rocket_thrust_jolt
+    auto const factor = make_kernel_factor<ForceAccelKernel>(UserData_t{&rAccel});
+
+    // Register force
+
+    std::size_t const index = rJolt.m_factors.size();
+    rJolt.m_factors.emplace_back(factor);
+
+    auto factorBits = lgrn::bit_view(top_get<ForceFactors_t>(topData, idJoltFactors));
+    factorBits.set(index);
+
+    return joltAccel;
+} // setup_jolt_force_accel
+
+
+/**
+ * @brief Point masses in scene space, sampled from the universe once per update
+ *
+ * Stored as separate arrays so the loop over points in NBodyGravityKernel vectorizes.
+ */
+struct GravityField
+{
+    std::vector<float>  x;          ///< Scene space, meters
+    std::vector<float>  y;
+    std::vector<float>  z;
+    std::vector<float>  gm;         ///< Gravitational constant times mass
+
+    float               softening2{0.0f};
+
+    /// Satellites pulling weaker than this at the scene origin are left out, in m/s^2
+    float               minAccel{1e-6f};
+};
+
+struct NBodyGravityKernel
+{
+    static void apply(ForceFactorBatch const& batch, std::uint32_t const index, ACtxJoltWorld const& rJolt,
+                      ACtxJoltWorld::ForceFactorFunc::UserData_t const& data) noexcept
     {
-        .m_func = [] (BodyId const bodyId, ACtxJoltWorld const& rJolt, UserData_t data, Vector3& rForce, Vector3& rTorque) noexcept
+        auto const& field = *static_cast<GravityField const*>(data[0]);
+
+        Vector3 const   pos     = batch.m_positions[index];
+        std::size_t const count = field.gm.size();
+
+        float ax = 0.0f;
+        float ay = 0.0f;
+        float az = 0.0f;
+        for (std::size_t i = 0; i < count; ++i)
         {
-            PhysicsSystem *pJoltWorld = rJolt.m_pPhysicsSystem.get();
+            float const dx      = field.x[i] - pos.x();
+            float const dy      = field.y[i] - pos.y();
+            float const dz      = field.z[i] - pos.z();
+            float const invDist = 1.0f / std::sqrt(dx*dx + dy*dy + dz*dz + field.softening2);
+            float const scale   = field.gm[i] * invDist * invDist * invDist;
+            ax += dx * scale;
+            ay += dy * scale;
+            az += dz * scale;
+        }
 
-            float inv_mass = SysJolt::get_inverse_mass_no_lock(*pJoltWorld, bodyId);
+        batch.m_forces[index] += Vector3{ax, ay, az} * batch.m_masses[index];
+    }
+};
 
-            auto const& force = *reinterpret_cast<Vector3 const*>(data[0]);
-            rForce += force / inv_mass;
-        },
-        .m_userData = {&rAccel}
-    };
+Session setup_jolt_force_nbody_gravity(
+        TopTaskBuilder&             rBuilder,
+        ArrayView<entt::any> const  topData,
+        Session const&              scene,
+        Session const&              physics,
+        Session const&              jolt,
+        Session const&              joltFactors,
+        Session const&              uniCore,
+        Session const&              uniScnFrame,
+        Session const&              solarSystemPlanets)
+{
+    using UserData_t = ACtxJoltWorld::ForceFactorFunc::UserData_t;
+    using namespace osp::universe;
+
+    OSP_DECLARE_GET_DATA_IDS(jolt,                  TESTAPP_DATA_JOLT);
+    OSP_DECLARE_GET_DATA_IDS(joltFactors,           TESTAPP_DATA_JOLT_FORCES);
+    OSP_DECLARE_GET_DATA_IDS(uniCore,               TESTAPP_DATA_UNI_CORE);
+    OSP_DECLARE_GET_DATA_IDS(uniScnFrame,           TESTAPP_DATA_UNI_SCENEFRAME);
+    OSP_DECLARE_GET_DATA_IDS(solarSystemPlanets,    TESTAPP_DATA_SOLAR_SYSTEM_PLANETS);
+    auto const tgScn    = scene         .get_pipelines<PlScene>();
+    auto const tgPhy    = physics       .get_pipelines<PlPhysics>();
+    auto const tgUSFrm  = uniScnFrame   .get_pipelines<PlUniSceneFrame>();
+
+    Session out;
+    OSP_DECLARE_CREATE_DATA_IDS(out, topData, TESTAPP_DATA_JOLT_NBODY_GRAVITY);
+
+    auto &rField = top_emplace<GravityField>(topData, idGravityField);
+
+    rBuilder.task()
+        .name       ("Sample universe gravity into the scene")
+        .run_on     ({tgScn.update(Run)})
+        .sync_with  ({tgUSFrm.sceneFrame(Ready), tgPhy.physUpdate(ModifyOrSignal)})
+        .push_to    (out.m_tasks)
+        .args       ({        idGravityField,                  idUniverse,                  idScnFrame,               idPlanetMainSpace,                                        idCoordNBody })
+        .func([] (GravityField& rField, Universe const& rUniverse, SceneFrame const& rScnFrame, CoSpaceId const planetMainSpace, KeyedVec<CoSpaceId, CoSpaceNBody> const& rCoordNBody) noexcept
+    {
+        rField.x.clear();
+        rField.y.clear();
+        rField.z.clear();
+        rField.gm.clear();
+
+        CoSpaceNBody const& rNBody = rCoordNBody[planetMainSpace];
+        if (rNBody.frames.published == 0)
+        {
+            return;
+        }
+
+        // Read the latest published frame instead of m_data, which the simulation may be writing
+        CoSpaceSatData const& frame         = sat_frames_latest(rNBody.frames);
+        CoSpaceCommon const&  rMainSpace    = rUniverse.m_coordCommon[planetMainSpace];
+        auto const [x, y, z]        = sat_views(frame.m_satPositions, frame.m_data, frame.m_satCount);
+        auto const [qx, qy, qz, qw] = sat_views(frame.m_satRotations, frame.m_data, frame.m_satCount);
+        auto const massView         = rNBody.mass.view(arrayView(frame.m_data), frame.m_satCount);
+
+        // Same as drawing, the SceneFrame is either directly in the main space or landed on
+        // one of its satellites
+        CoordTransformer mainToArea;
+        if (rScnFrame.m_parent == planetMainSpace)
+        {
+            mainToArea = coord_parent_to_child(rMainSpace, rScnFrame);
+        }
+        else
+        {
+            CoSpaceCommon const& rLanded = rUniverse.m_coordCommon[rScnFrame.m_parent];
+
+            CoSpaceTransform const landedTf     = coord_get_transform(rLanded, rLanded, x, y, z, qx, qy, qz, qw);
+            CoordTransformer const mainToLanded = coord_parent_to_child(rMainSpace, landedTf);
+            CoordTransformer const landedToArea = coord_parent_to_child(landedTf, rScnFrame);
+
+            mainToArea = coord_composite(landedToArea, mainToLanded);
+        }
+
+        double const toMeters   = math::mul_2pow<double, int>(1.0, -rScnFrame.m_precision);
+        double const gravConst  = rNBody.params.gravConstant;
+        rField.softening2       = float(rNBody.params.softening * rNBody.params.softening);
+
+        for (std::size_t i = 0; i < frame.m_satCount; ++i)
+        {
+            Vector3d const pos  = Vector3d(mainToArea.transform_position({x[i], y[i], z[i]})) * toMeters;
+            double const gm     = gravConst * double(massView[i]);
+
+            if (gm < double(rField.minAccel) * pos.dot())
+            {
+                continue; // Too weak at the scene origin
+            }
+
+            rField.x .push_back(float(pos.x()));
+            rField.y .push_back(float(pos.y()));
+            rField.z .push_back(float(pos.z()));
+            rField.gm.push_back(float(gm));
+        }
+    });
 
     // Register force
 
+    auto &rJolt = top_get<ACtxJoltWorld>(topData, idJolt);
+
     std::size_t const index = rJolt.m_factors.size();
-    rJolt.m_factors.emplace_back(factor);
+    rJolt.m_factors.emplace_back(make_kernel_factor<NBodyGravityKernel>(UserData_t{&rField}));
 
     auto factorBits = lgrn::bit_view(top_get<ForceFactors_t>(topData, idJoltFactors));
     factorBits.set(index);
 
-    return joltAccel;
-} // setup_jolt_force_accel
+    return out;
+} // setup_jolt_force_nbody_gravity
 
 
 
@@ -195,6 +394,10 @@ Session setup_phys_shapes_jolt(
 
     Session out;
 
+    // Jolt can take bodies out of the world without destroying them, so out-of-bounds shapes
+    // are parked and reused instead of deleted
+    top_get<ACtxPhysShapes>(topData, idPhysShapes).m_pooling = true;
+
     rBuilder.task()
         .name       ("Add Jolt physics to spawned shapes")
         .run_on     ({tgShSp.spawnRequest(UseOrRun)})
@@ -218,6 +421,17 @@ Session setup_phys_shapes_jolt(
             ActiveEnt const root    = rPhysShapes.m_ents[i * 2];
             ActiveEnt const child   = rPhysShapes.m_ents[i * 2 + 1];
 
+            if (rPhysShapes.m_reused[i] != 0)
+            {
+                // Body of a pooled shape was only removed from the world, reset and add it back
+                JPH::BodyID const joltBodyId = BToJolt(SysJolt::find_body(rJolt, root));
+                bodyInterface.SetPositionAndRotation(joltBodyId, Vec3MagnumToJolt(spawn.m_position),
+                                                     Quat::sIdentity(), EActivation::DontActivate);
+                bodyInterface.SetLinearAndAngularVelocity(joltBodyId, Vec3::sZero(), Vec3::sZero());
+                addedBodies.push_back(joltBodyId);
+                continue;
+            }
+
             Ref<Shape> pShape = SysJolt::create_primitive(rJolt, spawn.m_shape, Vec3MagnumToJolt(spawn.m_size));
             
             BodyId const bodyId = rJolt.m_bodyIds.create();
@@ -241,7 +455,7 @@ Session setup_phys_shapes_jolt(
             else
             {   
                 bodyCreation.mMotionType = EMotionType::Static;
-                bodyCreation.mObjectLayer = Layers::MOVING;
+                bodyCreation.mObjectLayer = Layers::NON_MOVING;
             }
             //TODO helper function ? 
             
@@ -249,9 +463,8 @@ Session setup_phys_shapes_jolt(
             bodyInterface.CreateBodyWithID(joltBodyId, bodyCreation);
             addedBodies.push_back(joltBodyId);
 
-            rJolt.m_bodyToEnt[bodyId]    = root;
+            SysJolt::set_body_ent(rJolt, bodyId, root);
             rJolt.m_bodyFactors[bodyId]  = joltFactors;
-            rJolt.m_entToBody.emplace(root, bodyId);
 
         }
         //Bodies are added all at once for performance reasons.
@@ -259,39 +472,48 @@ Session setup_phys_shapes_jolt(
         bodyInterface.AddBodiesFinalize(addedBodies.data(), numBodies, addState, EActivation::Activate);
     });
 
+    rBuilder.task()
+        .name       ("Remove Jolt bodies of parked shapes from the world")
+        .run_on     ({tgShSp.parkRequest(UseOrRun)})
+        .sync_with  ({tgJolt.joltBody(Modify), tgPhy.physUpdate(Done)})
+        .push_to    (out.m_tasks)
+        .args({                   idPhysShapes,              idJolt })
+        .func([] (ACtxPhysShapes const& rPhysShapes, ACtxJoltWorld& rJolt) noexcept
+    {
+        BodyInterface &bodyInterface = rJolt.m_pPhysicsSystem->GetBodyInterface();
+
+        std::vector<JPH::BodyID> removedBodies;
+        removedBodies.reserve(rPhysShapes.m_parkRequest.size());
+
+        for (PooledShape const& parked : rPhysShapes.m_parkRequest)
+        {
+            BodyId const bodyId = SysJolt::find_body(rJolt, parked.m_root);
+            if (bodyId != lgrn::id_null<BodyId>() && bodyInterface.IsAdded(BToJolt(bodyId)))
+            {
+                removedBodies.push_back(BToJolt(bodyId));
+            }
+        }
+
+        // Bodies stay allocated with their shapes, so reuse doesn't go through create_primitive
+        bodyInterface.RemoveBodies(removedBodies.data(), static_cast<int>(removedBodies.size()));
+    });
+
     return out;
 } // setup_phys_shapes_jolt
 
 
 void compound_collect_recurse(
-        ACtxPhysics const&      rCtxPhys,
-        ACtxJoltWorld&          rCtxWorld,
-        ACtxBasic const&        rBasic,
-        ActiveEnt               ent,
-        Matrix4 const&          transform,
-        CompoundShapeSettings&  rCompound)
+        ACtxPhysics const&              rCtxPhys,
+        ACtxJoltWorld&                  rCtxWorld,
+        ACtxBasic const&                rBasic,
+        ActiveEnt                       ent,
+        Matrix4 const&                  transform,
+        MutableCompoundShapeSettings&   rCompound,
+        CompoundBody&                   rBody)
 {
-    EShape const shape = rCtxPhys.m_shape[ent];
-
-    if (shape != EShape::None)
+    if (rCtxPhys.m_shape[ent] != EShape::None)
     {
-        bool entExists = rCtxWorld.m_shapes.contains(ent);
-        Ref<Shape> rShape = entExists
-                               ? rCtxWorld.m_shapes.get(ent)
-                               : rCtxWorld.m_shapes.emplace(ent);
-
-        if (!entExists)
-        {
-            rShape = SysJolt::create_primitive(rCtxWorld, shape, Vec3MagnumToJolt(transform.scaling()));
-        }
-        else 
-        {
-            SysJolt::scale_shape(rShape, Vec3MagnumToJolt(transform.scaling()));
-        }
-
-        rCompound.AddShape( Vec3MagnumToJolt(transform.translation()), 
-                            QuatMagnumToJolt(osp::Quaternion::fromMatrix(transform.rotation())), 
-                            rShape);
+        SysJolt::compound_add_collider(rCtxPhys, rCtxWorld, ent, transform, rCompound, rBody);
     }
 
     if ( ! rCtxPhys.m_hasColliders.contains(ent) )
@@ -309,7 +531,7 @@ void compound_collect_recurse(
             Matrix4 const childMatrix = transform * rChildTransform.m_transform;
 
             compound_collect_recurse(
-                    rCtxPhys, rCtxWorld, rBasic, child, childMatrix, rCompound);
+                    rCtxPhys, rCtxWorld, rBasic, child, childMatrix, rCompound, rBody);
         }
     }
 }
@@ -408,7 +630,8 @@ Session setup_vehicle_spawn_jolt(
 
                 rBasic.m_transform.emplace(weldEnt, Matrix4::from(toInit.rotation.toMatrix(), toInit.position));
 
-                SubtreeBuilder bldRoot = SysSceneGraph::add_descendants(rBasic.m_scnGraph, entCount + 1);
+                // Batched, since adding one subtree at a time shifts the whole tree for each weld
+                SubtreeBuilder bldRoot = SysSceneGraph::batch_add_descendants(rBasic.m_scnGraph, rBasic.m_scnGraphBatch, entCount + 1);
                 SubtreeBuilder bldWeld = bldRoot.add_child(weldEnt, entCount);
 
                 for (PartId const part : rScnParts.weldToParts[weld])
@@ -424,6 +647,8 @@ Session setup_vehicle_spawn_jolt(
 
             itWeldOffsets = itWeldOffsetsNext;
         }
+
+        SysSceneGraph::batch_apply(rBasic.m_scnGraph, rBasic.m_scnGraphBatch);
     });
 
     rBuilder.task()
@@ -461,21 +686,23 @@ Session setup_vehicle_spawn_jolt(
                 ActiveEnt const weldEnt = rScnParts.weldToActive[weld];
 
                 MutableCompoundShapeSettings compound;
+                CompoundBody compoundBody;
 
                 rPhys.m_hasColliders.insert(weldEnt);
 
                 // Collect all colliders from hierarchy.
-                compound_collect_recurse( rPhys, rJolt, rBasic, weldEnt, Matrix4{}, compound );
+                compound_collect_recurse( rPhys, rJolt, rBasic, weldEnt, Matrix4{}, compound, compoundBody );
 
                 Ref<Shape> compoundShape = compound.Create().Get();
-                BodyCreationSettings bodyCreation(compoundShape, Vec3Arg::sZero(), Quat::sZero(), EMotionType::Dynamic, Layers::MOVING);
+                compoundBody.m_shape = static_cast<MutableCompoundShape*>(compoundShape.GetPtr());
+                BodyCreationSettings bodyCreation(compoundShape, Vec3Arg::sZero(), Quat::sZero(), EMotionType::Dynamic, Layers::VEHICLE);
 
                 BodyId const bodyId = rJolt.m_bodyIds.create();
                 SysJolt::resize_body_data(rJolt);
 
-                rJolt.m_bodyToEnt[bodyId] = weldEnt;
+                SysJolt::set_body_ent(rJolt, bodyId, weldEnt);
                 rJolt.m_bodyFactors[bodyId] = {1}; // TODO: temporary
-                rJolt.m_entToBody.emplace(weldEnt, bodyId);
+                rJolt.m_compounds.emplace(bodyId, std::move(compoundBody));
 
                 float   totalMass = 0.0f;
                 Vector3 massPos{0.0f};
@@ -522,6 +749,21 @@ Session setup_vehicle_spawn_jolt(
         bodyInterface.AddBodiesFinalize(addedBodies.data(), numBodies, addState, EActivation::Activate);
     });
 
+    rBuilder.task()
+        .name       ("Update Jolt compound shapes of changed Welds")
+        .run_on     ({tgParts.weldDirty(UseOrRun)})
+        .sync_with  ({tgCS.transform(Ready), tgCS.hierarchy(Ready), tgPhy.physBody(Ready), tgJolt.joltBody(Modify), tgParts.mapWeldActive(Ready)})
+        .push_to    (out.m_tasks)
+        .args       ({      idBasic,             idPhys,              idJolt,                 idScnParts})
+        .func([] (ACtxBasic& rBasic, ACtxPhysics& rPhys, ACtxJoltWorld& rJolt, ACtxParts const& rScnParts) noexcept
+    {
+        // Sub-shapes are added or removed in place; freshly spawned welds have nothing to change
+        for (WeldId const weld : rScnParts.weldDirty)
+        {
+            SysJolt::update_compound(rPhys, rJolt, rBasic.m_scnGraph, rBasic.m_transform, rScnParts.weldToActive[weld]);
+        }
+    });
+
     return out;
 } // setup_vehicle_spawn_jolt
 
@@ -688,6 +930,15 @@ static void rocket_thrust_force(BodyId const bodyId, ACtxJoltWorld const& rJolt,
     }
 }
 
+struct RocketThrustKernel
+{
+    static void apply(ForceFactorBatch const& batch, std::uint32_t const index, ACtxJoltWorld const& rJolt,
+                      ACtxJoltWorld::ForceFactorFunc::UserData_t const& data) noexcept
+    {
+        rocket_thrust_force(batch.m_bodies[index], rJolt, data, batch.m_forces[index], batch.m_torques[index]);
+    }
+};
+
 Session setup_rocket_thrust_jolt(
         TopTaskBuilder&             rBuilder,
         ArrayView<entt::any> const  topData,
@@ -745,11 +996,7 @@ Session setup_rocket_thrust_jolt(
     Machines &rMachines = rScnParts.machines;
 
 
-    ACtxJoltWorld::ForceFactorFunc const factor
-    {
-        .m_func = &rocket_thrust_force,
-        .m_userData = { &rRocketsJolt, &rMachines, &rSigValFloat }
-    };
+    auto const factor = make_kernel_factor<RocketThrustKernel>({ &rRocketsJolt, &rMachines, &rSigValFloat });
 
     auto &rJolt = top_get<ACtxJoltWorld>(topData, idJolt);
 
@@ -759,8 +1006,1009 @@ Session setup_rocket_thrust_jolt(
     auto factorBits = lgrn::bit_view(top_get<ForceFactors_t>(topData, idJoltFactors));
     factorBits.set(index);
 
+    // Rocket-powered vehicles almost always feel gravity too, evaluate both in one loop.
+    // Does nothing if there's no constant acceleration factor.
+    add_fused_factor<ForceAccelKernel, RocketThrustKernel>(rJolt);
+
     return out;
 } // setup_rocket_thrust_jolt
 
 
+struct ACtxAeroJolt
+{
+    /// Parts of each body, kept so m_surfaces can be rebuilt when any weld changes
+    KeyedVec<BodyId, std::vector<adera::AeroPart>>                      m_bodyParts;
+
+    /// {first, count} of each body's parts in m_surfaces
+    KeyedVec<BodyId, std::pair<std::uint32_t, std::uint32_t>>           m_bodySurfaces;
+
+    adera::AeroSurfaces                                                 m_surfaces;
+    adera::AeroAtmosphere                                               m_atmosphere;
+};
+
+struct AeroKernel
+{
+    static void apply(ForceFactorBatch const& batch, std::uint32_t const index, ACtxJoltWorld const& rJolt,
+                      ACtxJoltWorld::ForceFactorFunc::UserData_t const& data) noexcept
+    {
+        auto const& rAeroJolt = *reinterpret_cast<ACtxAeroJolt const*>(data[0]);
+
+        BodyId const bodyId = batch.m_bodies[index];
+        auto const [first, count] = rAeroJolt.m_bodySurfaces[bodyId];
+
+        if (count == 0)
+        {
+            return;
+        }
+
+        //no lock as all bodies are locked in callbacks
+        BodyInterface &bodyInterface = rJolt.m_pPhysicsSystem->GetBodyInterfaceNoLock();
+        JPH::BodyID const joltBodyId = BToJolt(bodyId);
+
+        Quaternion const rot    = QuatJoltToMagnum(bodyInterface.GetRotation(joltBodyId));
+        Quaternion const rotInv = rot.invertedNormalized();
+        Vector3 const comWorld  = Vec3JoltToMagnum(bodyInterface.GetCenterOfMassPosition(joltBodyId) - bodyInterface.GetPosition(joltBodyId));
+
+        adera::AeroFlow const flow
+        {
+            .velocity           = rotInv.transformVector(batch.m_velocities[index] - rAeroJolt.m_atmosphere.wind),
+            .angularVelocity    = rotInv.transformVector(Vec3JoltToMagnum(bodyInterface.GetAngularVelocity(joltBodyId))),
+            .centerOfMass       = rotInv.transformVector(comWorld),
+            .density            = adera::SysAero::density(rAeroJolt.m_atmosphere, batch.m_positions[index])
+        };
+
+        Vector3 force;
+        Vector3 torque;
+        adera::SysAero::forces(rAeroJolt.m_surfaces, first, count, flow, force, torque);
+
+        batch.m_forces[index]  += rot.transformVector(force);
+        batch.m_torques[index] += rot.transformVector(torque);
+    }
+};
+
+Session setup_aero_jolt(
+        TopTaskBuilder&             rBuilder,
+        ArrayView<entt::any> const  topData,
+        Session const&              scene,
+        Session const&              commonScene,
+        Session const&              physics,
+        Session const&              parts,
+        Session const&              jolt,
+        Session const&              joltFactors,
+        adera::AeroAtmosphere const atmosphere)
+{
+    OSP_DECLARE_GET_DATA_IDS(scene,         TESTAPP_DATA_SCENE);
+    OSP_DECLARE_GET_DATA_IDS(commonScene,   TESTAPP_DATA_COMMON_SCENE);
+    OSP_DECLARE_GET_DATA_IDS(physics,       TESTAPP_DATA_PHYSICS);
+    OSP_DECLARE_GET_DATA_IDS(parts,         TESTAPP_DATA_PARTS);
+    OSP_DECLARE_GET_DATA_IDS(jolt,          TESTAPP_DATA_JOLT);
+    OSP_DECLARE_GET_DATA_IDS(joltFactors,   TESTAPP_DATA_JOLT_FORCES);
+    auto const tgScn    = scene         .get_pipelines<PlScene>();
+    auto const tgParts  = parts         .get_pipelines<PlParts>();
+    auto const tgJolt   = jolt          .get_pipelines<PlJolt>();
+
+    Session out;
+    OSP_DECLARE_CREATE_DATA_IDS(out, topData, TESTAPP_DATA_AERO_JOLT);
+
+    auto &rAeroJolt = top_emplace< ACtxAeroJolt >(topData, idAeroJolt);
+    rAeroJolt.m_atmosphere = atmosphere;
+
+    rBuilder.task()
+        .name       ("Assign aerodynamic surfaces to Jolt bodies")
+        .run_on     ({tgScn.update(Run)})
+        .sync_with  ({tgParts.weldIds(Ready), tgJolt.joltBody(Ready)})
+        .push_to    (out.m_tasks)
+        .args       ({      idBasic,                   idPhys,              idJolt,                 idScnParts,             idAeroJolt,                      idJoltFactors})
+        .func([] (ACtxBasic const& rBasic, ACtxPhysics const& rPhys, ACtxJoltWorld& rJolt, ACtxParts const& rScnParts, ACtxAeroJolt& rAeroJolt, ForceFactors_t const& rJoltFactors) noexcept
+    {
+        using adera::SysAero;
+
+        if (rScnParts.weldDirty.empty())
+        {
+            return;
+        }
+
+        std::size_t const capacity = rJolt.m_bodyIds.capacity();
+        rAeroJolt.m_bodyParts   .resize(capacity);
+        rAeroJolt.m_bodySurfaces.resize(capacity);
+
+        // Part surfaces only change along with their weld, evaluating them is the per-step part
+        for (WeldId const weld : rScnParts.weldDirty)
+        {
+            ActiveEnt const weldEnt = rScnParts.weldToActive[weld];
+            BodyId const    body    = rJolt.m_entToBody.at(weldEnt);
+
+            std::vector<adera::AeroPart> &rParts = rAeroJolt.m_bodyParts[body];
+            rParts.clear();
+
+            for (PartId const part : rScnParts.weldToParts[weld])
+            {
+                rParts.push_back(SysAero::part_surface(rBasic, rPhys, rScnParts.partToActive[part],
+                                                       rScnParts.partTransformWeld[part]));
+            }
+
+            // See assign_rockets
+            static_assert(ForceFactors_t{}.size() == 1u);
+            ForceFactors_t &rBodyFactors = rJolt.m_bodyFactors[body];
+            if (rParts.empty())
+            {
+                rBodyFactors[0] &= ~rJoltFactors[0];
+            }
+            else
+            {
+                rBodyFactors[0] |= rJoltFactors[0];
+            }
+        }
+
+        // Lay out all bodies' parts contiguously so each body is a single run in the SoA
+        rAeroJolt.m_surfaces.clear();
+        for (std::size_t i = 0; i < capacity; ++i)
+        {
+            BodyId const body{static_cast<BodyId::entity_type>(i)};
+            std::vector<adera::AeroPart> &rParts = rAeroJolt.m_bodyParts[body];
+
+            if ( ! rJolt.m_bodyIds.exists(body) )
+            {
+                rParts.clear(); // Deleted since its weld was last assigned
+            }
+
+            auto const first = static_cast<std::uint32_t>(rAeroJolt.m_surfaces.size());
+            for (adera::AeroPart const& part : rParts)
+            {
+                rAeroJolt.m_surfaces.push_back(part);
+            }
+            rAeroJolt.m_bodySurfaces[body] = { first, static_cast<std::uint32_t>(rParts.size()) };
+        }
+    });
+
+    auto const factor = make_kernel_factor<AeroKernel>({ &rAeroJolt });
+
+    auto &rJolt = top_get<ACtxJoltWorld>(topData, idJolt);
+
+    std::size_t const index = rJolt.m_factors.size();
+    rJolt.m_factors.emplace_back(factor);
+
+    auto factorBits = lgrn::bit_view(top_get<ForceFactors_t>(topData, idJoltFactors));
+    factorBits.set(index);
+
+    return out;
+} // setup_aero_jolt
+
+
+
+
+struct TerrainColliderJolt
+{
+    struct BuildResult
+    {
+        JPH::TriangleList   triangles;
+        Ref<Shape>          shape;
+        std::atomic<bool>   done{false};
+    };
+
+    struct Pending
+    {
+        planeta::ChunkId                chunk;
+        std::uint32_t                   generation;
+        Vector3                         center;
+        std::shared_ptr<BuildResult>    pResult;
+    };
+
+    KeyedVec<planeta::ChunkId, BodyId>          chunkBody;
+    /// Incremented when a chunk changes, so in-flight builds of old geometry are discarded
+    KeyedVec<planeta::ChunkId, std::uint32_t>   generation;
+    KeyedVec<planeta::ChunkId, std::uint8_t>    building;
+    std::vector<Pending>                        pending;
+
+    /// Scratch positions of dynamic bodies
+    std::vector<Vector3>                        bodyPositions;
+
+    /// Chunks within this distance (meters, plus the chunk's radius) of a dynamic body get
+    /// colliders. Colliders are removed past smc_removeFactor times this, to avoid churn.
+    float                                       range{20.0f};
+    static constexpr float                      smc_removeFactor = 1.5f;
+
+    /// Max new shape builds started per update
+    static constexpr std::size_t                smc_maxBuildsPerUpdate = 32;
+};
+
+Session setup_terrain_collider_jolt(
+        TopTaskBuilder&             rBuilder,
+        ArrayView<entt::any> const  topData,
+        Session const&              scene,
+        Session const&              terrain,
+        Session const&              jolt)
+{
+    OSP_DECLARE_GET_DATA_IDS(terrain,   TESTAPP_DATA_TERRAIN);
+    OSP_DECLARE_GET_DATA_IDS(jolt,      TESTAPP_DATA_JOLT);
+
+    auto const tgScn    = scene     .get_pipelines<PlScene>();
+    auto const tgTrn    = terrain   .get_pipelines<PlTerrain>();
+    auto const tgJolt   = jolt      .get_pipelines<PlJolt>();
+
+    Session out;
+    auto const [idTerrainCollider] = out.acquire_data<1>(topData);
+    top_emplace< TerrainColliderJolt >(topData, idTerrainCollider);
+
+    rBuilder.task()
+        .name       ("Stream terrain chunk colliders into Jolt")
+        .run_on     ({tgScn.update(Run)})
+        .sync_with  ({tgTrn.skeleton(Ready), tgJolt.joltBody(New)})
+        .push_to    (out.m_tasks)
+        .args({                   idTerrain,              idJolt,                     idTerrainCollider })
+        .func([] (ACtxTerrain const& rTerrain, ACtxJoltWorld& rJolt, TerrainColliderJolt& rCollider) noexcept
+    {
+        using planeta::ChunkId;
+
+        planeta::ChunkSkeleton          const &rSkCh    = rTerrain.skChunks;
+        planeta::ChunkMeshBufferInfo    const &rChInfo  = rTerrain.chunkInfo;
+        planeta::BasicChunkMeshGeometry const &rChGeo   = rTerrain.chunkGeom;
+
+        BodyInterface &bodyInterface = rJolt.m_pPhysicsSystem->GetBodyInterface();
+
+        std::size_t const chunkCapacity = rSkCh.m_chunkIds.capacity();
+        rCollider.chunkBody .resize(chunkCapacity, lgrn::id_null<BodyId>());
+        rCollider.generation.resize(chunkCapacity, 0);
+        rCollider.building  .resize(chunkCapacity, 0);
+
+        auto const remove_body = [&rJolt, &rCollider, &bodyInterface] (ChunkId const chunkId)
+        {
+            BodyId &rBodyId = rCollider.chunkBody[chunkId];
+            if (rBodyId.has_value())
+            {
+                bodyInterface.RemoveBody(BToJolt(rBodyId));
+                bodyInterface.DestroyBody(BToJolt(rBodyId));
+                rJolt.m_bodyIds.remove(rBodyId);
+                rBodyId = lgrn::id_null<BodyId>();
+            }
+        };
+
+        // Colliders of changed or deleted chunks are out of date
+        for (ChunkId const chunkId : rTerrain.chunkSP.chunksDirty)
+        {
+            ++rCollider.generation[chunkId];
+            remove_body(chunkId);
+        }
+
+        // Add bodies for finished builds
+        auto const finished = [&] (TerrainColliderJolt::Pending const& rPending) -> bool
+        {
+            if ( ! rPending.pResult->done.load(std::memory_order_acquire) )
+            {
+                return false;
+            }
+
+            rCollider.building[rPending.chunk] = 0;
+            bool const current =    rPending.generation == rCollider.generation[rPending.chunk]
+                                 && rSkCh.m_chunkIds.exists(rPending.chunk);
+            if (current && rPending.pResult->shape != nullptr)
+            {
+                BodyId const bodyId = rJolt.m_bodyIds.create();
+                SysJolt::resize_body_data(rJolt);
+
+                BodyCreationSettings const bodyCreation(rPending.pResult->shape,
+                                                        Vec3MagnumToJolt(rPending.center),
+                                                        Quat::sIdentity(),
+                                                        EMotionType::Static,
+                                                        Layers::TERRAIN);
+                bodyInterface.CreateBodyWithID(BToJolt(bodyId), bodyCreation);
+                bodyInterface.AddBody(BToJolt(bodyId), EActivation::DontActivate);
+                rCollider.chunkBody[rPending.chunk] = bodyId;
+            }
+            return true;
+        };
+        std::erase_if(rCollider.pending, finished);
+
+        // Find where dynamic bodies are. Terrain bodies are static.
+        rCollider.bodyPositions.clear();
+        for (BodyId const bodyId : rJolt.m_bodyIds)
+        {
+            if (bodyInterface.GetMotionType(BToJolt(bodyId)) == EMotionType::Dynamic)
+            {
+                rCollider.bodyPositions.push_back(Vec3JoltToMagnum(bodyInterface.GetCenterOfMassPosition(BToJolt(bodyId))));
+            }
+        }
+
+        std::uint16_t const width   = rSkCh.m_chunkEdgeVrtxCount;
+        std::size_t         started = 0;
+
+        for (ChunkId const chunkId : rSkCh.m_chunkIds)
+        {
+            // Bounding sphere from the chunk's corners
+            auto const sharedUsed = rSkCh.shared_vertices_used(chunkId);
+            std::array<Vector3, 3> corners;
+            for (std::uint32_t i = 0; i < 3; ++i)
+            {
+                corners[i] = rChGeo.chunkVbufPos[rChInfo.vbufSharedOffset + sharedUsed[i * width].value().value];
+            }
+            Vector3 const center = (corners[0] + corners[1] + corners[2]) / 3.0f;
+            float   const radius = std::max({(corners[0] - center).length(),
+                                             (corners[1] - center).length(),
+                                             (corners[2] - center).length()});
+
+            float nearestSqr = std::numeric_limits<float>::max();
+            for (Vector3 const& bodyPos : rCollider.bodyPositions)
+            {
+                nearestSqr = std::min(nearestSqr, (bodyPos - center).dot());
+            }
+
+            float const addDist     = rCollider.range + radius;
+            float const removeDist  = TerrainColliderJolt::smc_removeFactor * addDist;
+
+            if (nearestSqr > removeDist * removeDist)
+            {
+                remove_body(chunkId);
+                continue;
+            }
+
+            if (   nearestSqr > addDist * addDist
+                || rCollider.chunkBody[chunkId].has_value()
+                || rCollider.building[chunkId] != 0
+                || started == TerrainColliderJolt::smc_maxBuildsPerUpdate)
+            {
+                continue;
+            }
+
+            // Copy triangles now, as the chunk may change while the shape is being built
+            auto pResult = std::make_shared<TerrainColliderJolt::BuildResult>();
+            auto const ibufRow = osp::as_2d(osp::arrayView(rChGeo.chunkIbuf), rChInfo.chunkMaxFaceCount).row(chunkId.value);
+            for (Vector3u const face : ibufRow)
+            {
+                if (face[0] == face[1]) // Unused faces are zeroed
+                {
+                    continue;
+                }
+                pResult->triangles.emplace_back(
+                        JPH::Float3{rChGeo.chunkVbufPos[face[0]].x() - center.x(), rChGeo.chunkVbufPos[face[0]].y() - center.y(), rChGeo.chunkVbufPos[face[0]].z() - center.z()},
+                        JPH::Float3{rChGeo.chunkVbufPos[face[1]].x() - center.x(), rChGeo.chunkVbufPos[face[1]].y() - center.y(), rChGeo.chunkVbufPos[face[1]].z() - center.z()},
+                        JPH::Float3{rChGeo.chunkVbufPos[face[2]].x() - center.x(), rChGeo.chunkVbufPos[face[2]].y() - center.y(), rChGeo.chunkVbufPos[face[2]].z() - center.z()});
+            }
+
+            // Handle isn't kept; the job system holds a reference to queued jobs
+            rJolt.m_joltJobSystem->CreateJob("Build terrain chunk collider", JPH::Color::sGreen, [pResult] ()
+            {
+                MeshShapeSettings const settings{pResult->triangles};
+                ShapeSettings::ShapeResult const result = settings.Create();
+                if (result.IsValid())
+                {
+                    pResult->shape = result.Get();
+                }
+                pResult->done.store(true, std::memory_order_release);
+            });
+
+            rCollider.pending.push_back({chunkId, rCollider.generation[chunkId], center, std::move(pResult)});
+            rCollider.building[chunkId] = 1;
+            ++started;
+        }
+    });
+
+    return out;
+} // setup_terrain_collider_jolt
+
+
+
+struct VehicleReplicationJolt
+{
+    osp::net::UdpSocket                 socket;
+    osp::net::ReplConfig                config;
+
+    /// Parallel
+    std::vector<osp::net::UdpAddress>   clientAddrs;
+    std::vector<osp::net::ReplClient>   clients;
+
+    osp::net::ReplSnapshot              snapshot;
+
+    // Scratch
+    std::vector<std::byte>              packet;
+    std::vector<std::byte>              structure;
+    std::vector<float>                  signals;
+
+    static constexpr std::size_t        smc_maxClients = 32;
+};
+
+Session setup_vehicle_replication_jolt(
+        TopTaskBuilder&             rBuilder,
+        ArrayView<entt::any> const  topData,
+        Session const&              application,
+        Session const&              scene,
+        Session const&              commonScene,
+        Session const&              parts,
+        Session const&              signalsFloat,
+        Session const&              jolt,
+        std::uint16_t const         port)
+{
+    OSP_DECLARE_GET_DATA_IDS(application,   TESTAPP_DATA_APPLICATION);
+    OSP_DECLARE_GET_DATA_IDS(commonScene,   TESTAPP_DATA_COMMON_SCENE);
+    OSP_DECLARE_GET_DATA_IDS(parts,         TESTAPP_DATA_PARTS);
+    OSP_DECLARE_GET_DATA_IDS(signalsFloat,  TESTAPP_DATA_SIGNALS_FLOAT)
+    OSP_DECLARE_GET_DATA_IDS(jolt,          TESTAPP_DATA_JOLT);
+    auto const tgScn    = scene         .get_pipelines<PlScene>();
+    auto const tgCS     = commonScene   .get_pipelines<PlCommonScene>();
+    auto const tgParts  = parts         .get_pipelines<PlParts>();
+    auto const tgSgFlt  = signalsFloat  .get_pipelines<PlSignalsFloat>();
+    auto const tgJolt   = jolt          .get_pipelines<PlJolt>();
+
+    Session out;
+    auto const [idVehicleRepl] = out.acquire_data<1>(topData);
+    auto &rRepl = top_emplace< VehicleReplicationJolt >(topData, idVehicleRepl);
+
+    if ( ! rRepl.socket.open(port) )
+    {
+        OSP_LOG_WARN("Failed to open UDP port {} for vehicle replication", port);
+        return out;
+    }
+    OSP_LOG_INFO("Replicating vehicles on UDP port {}", rRepl.socket.port());
+
+    rBuilder.task()
+        .name       ("Send vehicle state to replication clients")
+        .run_on     ({tgScn.update(Run)})
+        .sync_with  ({tgCS.transform(Ready), tgParts.weldIds(Ready), tgParts.mapWeldActive(Ready), tgParts.mapWeldPart(Ready), tgParts.mapPartMach(Ready), tgParts.partPrefabs(Ready), tgParts.partTransformWeld(Ready), tgParts.connect(Ready), tgSgFlt.sigValues(Ready), tgJolt.joltBody(Ready)})
+        .push_to    (out.m_tasks)
+        .args       ({            idResources,                 idBasic,                 idScnParts,                             idSigValFloat,                     idJolt,                 idVehicleRepl})
+        .func([] (Resources const& rResources, ACtxBasic const& rBasic, ACtxParts const& rScnParts, SignalValues_t<float> const& rSigValFloat, ACtxJoltWorld const& rJolt, VehicleReplicationJolt& rRepl) noexcept
+    {
+        using namespace osp::net;
+
+        // Acks also introduce new clients
+
+        std::array<std::byte, 64> ackBuffer;
+        UdpAddress from;
+        while (std::optional<std::size_t> const size = rRepl.socket.receive(arrayView(ackBuffer), from))
+        {
+            auto const itClient = std::find(rRepl.clientAddrs.begin(), rRepl.clientAddrs.end(), from);
+            if (itClient == rRepl.clientAddrs.end())
+            {
+                if (rRepl.clients.size() == VehicleReplicationJolt::smc_maxClients)
+                {
+                    continue;
+                }
+                ReplClient client;
+                if (repl_read_ack(client, arrayView(ackBuffer).prefix(*size)))
+                {
+                    rRepl.clientAddrs.push_back(from);
+                    rRepl.clients.push_back(std::move(client));
+                }
+            }
+            else
+            {
+                std::size_t const index = std::distance(rRepl.clientAddrs.begin(), itClient);
+                repl_read_ack(rRepl.clients[index], arrayView(ackBuffer).prefix(*size));
+            }
+        }
+
+        if (rRepl.clients.empty())
+        {
+            return;
+        }
+
+        // One object per weld, weld IDs are ascending as required by repl_snapshot_add
+
+        Nodes const &rFloatNodes = rScnParts.nodePerType[gc_ntSigFloat];
+        BodyInterface const &bodyInterface = rJolt.m_pPhysicsSystem->GetBodyInterface();
+
+        ReplSnapshot &rSnapshot = rRepl.snapshot;
+        rSnapshot.clear();
+        ++rSnapshot.frame;
+
+        for (WeldId const weld : rScnParts.weldIds)
+        {
+            ActiveEnt const weldEnt = rScnParts.weldToActive[weld];
+            if (weldEnt == lgrn::id_null<ActiveEnt>() || ! rBasic.m_transform.contains(weldEnt))
+            {
+                continue;
+            }
+
+            Vector3 velocity{0.0f};
+            Vector3 angVelocity{0.0f};
+            BodyId const body = SysJolt::find_body(rJolt, weldEnt);
+            if (body != lgrn::id_null<BodyId>())
+            {
+                velocity    = Vec3JoltToMagnum(bodyInterface.GetLinearVelocity(BToJolt(body)));
+                angVelocity = Vec3JoltToMagnum(bodyInterface.GetAngularVelocity(BToJolt(body)));
+            }
+
+            // Structure: per part, importer name, prefab, and transform relative to the weld.
+            // Connections change connectRevision, which is enough to notice parts moving
+            // between welds too.
+            rRepl.structure.clear();
+            rRepl.signals.clear();
+            std::uint32_t structureRev = rScnParts.connectRevision;
+
+            for (PartId const part : rScnParts.weldToParts[weld])
+            {
+                structureRev = structureRev * 31u + part;
+
+                PrefabPair const& prefab    = rScnParts.partPrefabs[part];
+                ResId const       importer  = prefab.m_importer;
+                std::string_view name;
+                if (importer != lgrn::id_null<ResId>())
+                {
+                    name = rResources.name(gc_importer, importer);
+                }
+                append_bytes(rRepl.structure, static_cast<std::uint32_t>(name.size()));
+                append_bytes(rRepl.structure, name.data(), name.size());
+                append_bytes(rRepl.structure, prefab.m_prefabId);
+                append_bytes(rRepl.structure, rScnParts.partTransformWeld[part]);
+
+                // Signals: values of all float nodes connected to the part's machines, in
+                // port order
+                for (MachinePair const pair : rScnParts.partToMachines[part])
+                {
+                    MachAnyId const mach = rScnParts.machines.perType[pair.type].localToAny[pair.local];
+                    if ( ! rFloatNodes.machToNode.contains(mach) )
+                    {
+                        continue;
+                    }
+                    for (NodeId const node : rFloatNodes.machToNode[mach])
+                    {
+                        rRepl.signals.push_back(node != lgrn::id_null<NodeId>() ? rSigValFloat[node] : 0.0f);
+                    }
+                }
+            }
+
+            repl_snapshot_add(rSnapshot, ReplObjId{weld},
+                              rBasic.m_transform.get(weldEnt).m_transform, velocity, angVelocity,
+                              structureRev, arrayView(std::as_const(rRepl.structure)),
+                              arrayView(std::as_const(rRepl.signals)));
+        }
+
+        for (std::size_t i = 0; i < rRepl.clients.size(); ++i)
+        {
+            repl_encode(rRepl.clients[i], rSnapshot, rRepl.config, rRepl.packet);
+            rRepl.socket.send_to(rRepl.clientAddrs[i], arrayView(std::as_const(rRepl.packet)));
+        }
+    });
+
+    return out;
+} // setup_vehicle_replication_jolt
+
+
+
+
+struct VehicleHandoffJolt
+{
+    struct ToDeactivate
+    {
+        WeldId      weld;
+        Vector3     position;
+        Vector3     velocity;
+        Quaternion  rotation;
+    };
+
+    std::vector<ToDeactivate>                       deactivate;
+
+    /// Compact vehicle state of each satellite in railSpace, parallel with its SatIds. Empty for
+    /// the attractor.
+    std::vector< std::vector<std::byte> >           satBlueprints;
+
+    /// Loaded for the previous spawn, kept until the spawn pipeline is done reading them
+    std::vector< std::unique_ptr<adera::VehicleData> > activated;
+
+    universe::CoSpaceId                             railSpace;
+
+    /// Coordinate space the SceneFrame must be in for handoff. Rail satellites use the same
+    /// coordinates as this space.
+    universe::CoSpaceId                             anchorSpace;
+
+    PkgId                                           pkg;
+    float                                           deactivateDistance;
+    float                                           activateDistance;
+
+    /// Orbits of satellites in railSpace around its attractor satellite
+    universe::SatRails                              rails;
+
+    // Scratch
+    std::vector<WeldId>                             welds;
+    std::vector<ActiveEnt>                          weldEnts;
+    KeyedVec<NodeTypeId, std::vector<NodeId>>       nodesRemoved;
+    std::vector<universe::SatRemap>                 satMoved;
+};
+
+Session setup_vehicle_handoff_jolt(
+        TopTaskBuilder&             rBuilder,
+        ArrayView<entt::any> const  topData,
+        Session const&              application,
+        Session const&              scene,
+        Session const&              commonScene,
+        Session const&              parts,
+        Session const&              signalsFloat,
+        Session const&              vehicleSpawn,
+        Session const&              vehicleSpawnVB,
+        Session const&              jolt,
+        Session const&              uniCore,
+        Session const&              uniScnFrame,
+        PkgId const                 pkg,
+        float const                 deactivateDistance,
+        float const                 activateDistance,
+        Vector3 const               railsGravity,
+        double const                railsRadius)
+{
+    using namespace osp::universe;
+    using adera::ACtxVehicleSpawnVB;
+    using adera::SysVehicleBlueprint;
+    using adera::SysVehicleHandoff;
+    using adera::VehicleData;
+
+    OSP_DECLARE_GET_DATA_IDS(application,       TESTAPP_DATA_APPLICATION);
+    OSP_DECLARE_GET_DATA_IDS(scene,             TESTAPP_DATA_SCENE);
+    OSP_DECLARE_GET_DATA_IDS(commonScene,       TESTAPP_DATA_COMMON_SCENE);
+    OSP_DECLARE_GET_DATA_IDS(parts,             TESTAPP_DATA_PARTS);
+    OSP_DECLARE_GET_DATA_IDS(signalsFloat,      TESTAPP_DATA_SIGNALS_FLOAT);
+    OSP_DECLARE_GET_DATA_IDS(vehicleSpawn,      TESTAPP_DATA_VEHICLE_SPAWN);
+    OSP_DECLARE_GET_DATA_IDS(vehicleSpawnVB,    TESTAPP_DATA_VEHICLE_SPAWN_VB);
+    OSP_DECLARE_GET_DATA_IDS(jolt,              TESTAPP_DATA_JOLT);
+    OSP_DECLARE_GET_DATA_IDS(uniCore,           TESTAPP_DATA_UNI_CORE);
+    OSP_DECLARE_GET_DATA_IDS(uniScnFrame,       TESTAPP_DATA_UNI_SCENEFRAME);
+    auto const tgScn    = scene         .get_pipelines<PlScene>();
+    auto const tgCS     = commonScene   .get_pipelines<PlCommonScene>();
+    auto const tgParts  = parts         .get_pipelines<PlParts>();
+    auto const tgSgFlt  = signalsFloat  .get_pipelines<PlSignalsFloat>();
+    auto const tgVhSp   = vehicleSpawn  .get_pipelines<PlVehicleSpawn>();
+    auto const tgVhSpVB = vehicleSpawnVB.get_pipelines<PlVehicleSpawnVB>();
+    auto const tgJolt   = jolt          .get_pipelines<PlJolt>();
+    auto const tgUSFrm  = uniScnFrame   .get_pipelines<PlUniSceneFrame>();
+
+    LGRN_ASSERTM(activateDistance < deactivateDistance,
+                 "Vehicles would be handed back and forth every update without a gap between distances");
+
+    Session out;
+    OSP_DECLARE_CREATE_DATA_IDS(out, topData, TESTAPP_DATA_VEHICLE_HANDOFF_JOLT);
+    auto const tgHnd = out.create_pipelines<PlVehicleHandoff>(rBuilder);
+
+    out.m_cleanup = tgScn.cleanup;
+
+    rBuilder.pipeline(tgHnd.railSats)   .parent(tgScn.update);
+    rBuilder.pipeline(tgHnd.deactivate) .parent(tgScn.update);
+
+    auto &rHandoff = top_emplace< VehicleHandoffJolt >(topData, idVehicleHandoff);
+    rHandoff.pkg                = pkg;
+    rHandoff.deactivateDistance = deactivateDistance;
+    rHandoff.activateDistance   = activateDistance;
+    rHandoff.rails.gm           = double(railsGravity.length()) * railsRadius * railsRadius;
+
+    // Rails get their own coordinate space, as other spaces (such as the planets' main space)
+    // may expect their satellites to stay in the order they made them. It's aligned with the
+    // SceneFrame's parent, or becomes the parent if the SceneFrame has none.
+
+    auto &rUniverse = top_get< Universe >   (topData, idUniverse);
+    auto &rScnFrame = top_get< SceneFrame > (topData, idScnFrame);
+
+    rHandoff.railSpace = rUniverse.m_coordIds.create();
+    rUniverse.m_coordCommon.resize(rUniverse.m_coordIds.capacity());
+
+    CoSpaceCommon &rRails = rUniverse.m_coordCommon[rHandoff.railSpace];
+    if (rScnFrame.m_parent == lgrn::id_null<CoSpaceId>())
+    {
+        rRails.m_precision      = rScnFrame.m_precision;
+        rScnFrame.m_parent      = rHandoff.railSpace;
+        rHandoff.anchorSpace    = rHandoff.railSpace;
+    }
+    else
+    {
+        rRails.m_parent         = rScnFrame.m_parent;
+        rRails.m_precision      = rUniverse.m_coordCommon[rScnFrame.m_parent].m_precision;
+        rHandoff.anchorSpace    = rScnFrame.m_parent;
+    }
+
+    // Same layout as the planets, grown by sat_create as vehicles are put on rails
+    constexpr std::size_t initialCapacity = 16;
+    rRails.m_satCount       = 0;
+    rRails.m_satCapacity    = initialCapacity;
+
+    std::size_t bytesUsed = 0;
+    partition_aligned(bytesUsed, initialCapacity, rRails.m_satPositions[0]);
+    partition_aligned(bytesUsed, initialCapacity, rRails.m_satPositions[1]);
+    partition_aligned(bytesUsed, initialCapacity, rRails.m_satPositions[2]);
+    partition_aligned(bytesUsed, initialCapacity, rRails.m_satVelocities[0]);
+    partition_aligned(bytesUsed, initialCapacity, rRails.m_satVelocities[1]);
+    partition_aligned(bytesUsed, initialCapacity, rRails.m_satVelocities[2]);
+    partition_aligned(bytesUsed, initialCapacity, rRails.m_satRotations[0],
+                                                  rRails.m_satRotations[1],
+                                                  rRails.m_satRotations[2],
+                                                  rRails.m_satRotations[3]);
+    rRails.m_data = sat_data_alloc(bytesUsed);
+
+    // The attractor is a point mass that pulls with railsGravity at the SceneFrame origin. It
+    // stays in place, vehicles put on rails orbit around it.
+    {
+        Vector3d const attractorScene = Vector3d(railsGravity.normalized()) * railsRadius;
+        Vector3g const attractorPos   = coord_child_to_parent(rRails, rScnFrame).transform_position(
+                Vector3g(math::mul_2pow<Vector3d, int>(attractorScene, rScnFrame.m_precision)));
+
+        SatId const att = sat_create(rRails);
+        auto const [x, y, z]        = sat_views(rRails.m_satPositions,  rRails.m_data, rRails.m_satCount);
+        auto const [vx, vy, vz]     = sat_views(rRails.m_satVelocities, rRails.m_data, rRails.m_satCount);
+        auto const [qx, qy, qz, qw] = sat_views(rRails.m_satRotations,  rRails.m_data, rRails.m_satCount);
+
+        x[att]  = attractorPos.x(); y[att]  = attractorPos.y(); z[att]  = attractorPos.z();
+        vx[att] = 0.0;              vy[att] = 0.0;              vz[att] = 0.0;
+        qx[att] = 0.0;              qy[att] = 0.0;              qz[att] = 0.0;
+        qw[att] = 1.0;
+
+        rHandoff.rails.attractor = att;
+        rHandoff.satBlueprints.emplace_back();
+    }
+
+    rBuilder.task()
+        .name       ("Find welds far enough from the SceneFrame to put on rails")
+        .run_on     ({tgScn.update(Run)})
+        .sync_with  ({tgCS.transform(Ready), tgParts.weldIds(Ready), tgParts.mapWeldActive(Ready), tgJolt.joltBody(Ready), tgUSFrm.sceneFrame(Ready), tgHnd.deactivate(Modify__)})
+        .push_to    (out.m_tasks)
+        .args       ({            idBasic,                 idScnParts,                     idJolt,                  idScnFrame,                   idVehicleHandoff})
+        .func([] (ACtxBasic const& rBasic, ACtxParts const& rScnParts, ACtxJoltWorld const& rJolt, SceneFrame const& rScnFrame, VehicleHandoffJolt& rHandoff) noexcept
+    {
+        if (rScnFrame.m_parent != rHandoff.anchorSpace)
+        {
+            return;
+        }
+
+        Vector3 const center = math::mul_2pow<Vector3, int>(Vector3(rScnFrame.m_scenePosition), -rScnFrame.m_precision);
+        float const   maxDistSqr = rHandoff.deactivateDistance * rHandoff.deactivateDistance;
+        BodyInterface const &bodyInterface = rJolt.m_pPhysicsSystem->GetBodyInterface();
+
+        for (WeldId const weld : rScnParts.weldIds)
+        {
+            ActiveEnt const weldEnt = rScnParts.weldToActive[weld];
+            if (weldEnt == lgrn::id_null<ActiveEnt>() || ! rBasic.m_transform.contains(weldEnt))
+            {
+                continue;
+            }
+
+            Matrix4 const &transform = rBasic.m_transform.get(weldEnt).m_transform;
+            if ((transform.translation() - center).dot() < maxDistSqr)
+            {
+                continue;
+            }
+
+            Vector3 velocity{0.0f};
+            BodyId const body = SysJolt::find_body(rJolt, weldEnt);
+            if (body != lgrn::id_null<BodyId>())
+            {
+                velocity = Vec3JoltToMagnum(bodyInterface.GetLinearVelocity(BToJolt(body)));
+            }
+
+            rHandoff.deactivate.push_back({
+                .weld       = weld,
+                .position   = transform.translation(),
+                .velocity   = velocity,
+                .rotation   = Quaternion::fromMatrix(transform.rotation())
+            });
+        }
+    });
+
+    rBuilder.task()
+        .name       ("Move welds onto rails as satellites, and delete their entities")
+        .run_on     ({tgHnd.deactivate(UseOrRun_)})
+        .sync_with  ({tgCS.activeEntDelete(Modify_), tgCS.hierarchy(Delete), tgHnd.railSats(New), tgUSFrm.sceneFrame(Ready),
+                      tgParts.partIds(Delete), tgParts.partPrefabs(Delete), tgParts.partTransformWeld(Delete), tgParts.weldIds(Delete),
+                      tgParts.machIds(Delete), tgParts.nodeIds(Delete), tgParts.connect(Delete), tgParts.mapWeldPart(Delete),
+                      tgParts.mapPartMach(Delete), tgParts.mapPartActive(Delete), tgParts.mapWeldActive(Delete),
+                      tgParts.machUpdExtIn(Delete), tgSgFlt.sigValues(Prev), tgSgFlt.sigUpdExtIn(Delete)})
+        .push_to    (out.m_tasks)
+        .args       ({      idBasic,                idActiveEntDel,           idScnParts,                idUpdMach,                             idSigValFloat,                    idSigUpdFloat,           idResources,           idUniverse,                  idScnFrame,                   idVehicleHandoff})
+        .func([] (ACtxBasic& rBasic, ActiveEntVec_t& rActiveEntDel, ACtxParts& rScnParts, MachineUpdater& rUpdMach, SignalValues_t<float> const& rSigValFloat, UpdateNodes<float>& rSigUpdFloat, Resources& rResources, Universe& rUniverse, SceneFrame const& rScnFrame, VehicleHandoffJolt& rHandoff) noexcept
+    {
+        CoSpaceCommon &rRails = rUniverse.m_coordCommon[rHandoff.railSpace];
+        CoordTransformer const sceneToRails = coord_child_to_parent(rRails, rScnFrame);
+
+        rHandoff.welds.clear();
+        rHandoff.weldEnts.clear();
+
+        for (VehicleHandoffJolt::ToDeactivate const& toDeactivate : rHandoff.deactivate)
+        {
+            WeldId const weld = toDeactivate.weld;
+            if ( ! rScnParts.weldIds.exists(weld) )
+            {
+                continue;
+            }
+
+            // Only the blueprint is kept, prefab owners of the temporary VehicleData are released
+            VehicleData data = SysVehicleHandoff::extract_weld(rScnParts, rSigValFloat, rResources, weld);
+            rHandoff.satBlueprints.emplace_back(SysVehicleBlueprint::save(data, rResources));
+            SysVehicleHandoff::release_owners(data, rResources);
+
+            SatId const sat = sat_create(rRails);
+            auto const [x, y, z]        = sat_views(rRails.m_satPositions,  rRails.m_data, rRails.m_satCount);
+            auto const [vx, vy, vz]     = sat_views(rRails.m_satVelocities, rRails.m_data, rRails.m_satCount);
+            auto const [qx, qy, qz, qw] = sat_views(rRails.m_satRotations,  rRails.m_data, rRails.m_satCount);
+
+            Vector3g const    scenePos  = Vector3g(math::mul_2pow<Vector3d, int>(Vector3d(toDeactivate.position), rScnFrame.m_precision));
+            Vector3g const    pos       = sceneToRails.transform_position(scenePos);
+            Vector3d const    vel       = rScnFrame.m_rotation.transformVector(Vector3d(toDeactivate.velocity));
+            Quaterniond const rot       = rScnFrame.m_rotation * Quaterniond(toDeactivate.rotation);
+
+            x[sat]  = pos.x();          y[sat]  = pos.y();          z[sat]  = pos.z();
+            vx[sat] = vel.x();          vy[sat] = vel.y();          vz[sat] = vel.z();
+            qx[sat] = rot.vector().x(); qy[sat] = rot.vector().y(); qz[sat] = rot.vector().z();
+            qw[sat] = rot.scalar();
+
+            // Orbit from the body's velocity. Radial or parabolic ones can't be put on rails,
+            // these satellites are integrated instead.
+            rails_enter(rHandoff.rails, rRails, sat);
+
+            rHandoff.welds   .push_back(weld);
+            rHandoff.weldEnts.push_back(rScnParts.weldToActive[weld]);
+        }
+
+        if (rHandoff.welds.empty())
+        {
+            return;
+        }
+
+        SysVehicleHandoff::remove_welds(rScnParts, rUpdMach, rResources, arrayView(std::as_const(rHandoff.welds)), rHandoff.nodesRemoved);
+
+        for (NodeId const node : rHandoff.nodesRemoved[gc_ntSigFloat])
+        {
+            if (rSigUpdFloat.nodeDirty.contains(node))
+            {
+                rSigUpdFloat.nodeDirty.erase(node);
+            }
+        }
+        for (std::vector<NodeId> &rRemoved : rHandoff.nodesRemoved)
+        {
+            rRemoved.clear();
+        }
+
+        // Part entities are descendants of the weld roots
+        SysSceneGraph::queue_delete_entities(rBasic.m_scnGraph, rActiveEntDel, rHandoff.weldEnts.begin(), rHandoff.weldEnts.end());
+
+        OSP_LOG_RATE_LIMITED(OSP_LOG_INFO, 1.0f, "Moved {} welds onto rails, {} vehicles are now on rails", rHandoff.welds.size(), rRails.m_satCount - 1);
+    });
+
+    rBuilder.task()
+        .name       ("Clear welds to move onto rails once we're done with them")
+        .cheap      ()
+        .run_on     ({tgHnd.deactivate(Clear_)})
+        .push_to    (out.m_tasks)
+        .args       ({               idVehicleHandoff })
+        .func([] (VehicleHandoffJolt& rHandoff) noexcept
+    {
+        rHandoff.deactivate.clear();
+    });
+
+    rBuilder.task()
+        .name       ("Move vehicles on rails")
+        .run_on     ({tgScn.update(Run)})
+        .sync_with  ({tgHnd.railSats(Modify)})
+        .push_to    (out.m_tasks)
+        .args       ({           idDeltaTimeIn,           idUniverse,                   idVehicleHandoff})
+        .func([] (float const deltaTimeIn, Universe& rUniverse, VehicleHandoffJolt& rHandoff) noexcept
+    {
+        CoSpaceCommon &rRails   = rUniverse.m_coordCommon[rHandoff.railSpace];
+        SatRails      &rOrbits  = rHandoff.rails;
+        SatId const   att       = rOrbits.attractor;
+
+        auto const [x, y, z]        = sat_views(rRails.m_satPositions,  rRails.m_data, rRails.m_satCount);
+        auto const [vx, vy, vz]     = sat_views(rRails.m_satVelocities, rRails.m_data, rRails.m_satCount);
+
+        double const dt         = deltaTimeIn;
+        double const scale      = math::mul_2pow<double, int>(1.0, -rRails.m_precision);
+        double const invScale   = math::mul_2pow<double, int>(1.0, rRails.m_precision);
+
+        // Satellites without an orbit fall towards the attractor, integrated with the same gravity
+        for (SatId sat = 0; sat < rRails.m_satCount; ++sat)
+        {
+            if (sat == att || (sat < rOrbits.onRails.size() && rOrbits.onRails[sat] != 0))
+            {
+                continue;
+            }
+
+            Vector3d const r      = Vector3d{double(x[sat] - x[att]), double(y[sat] - y[att]), double(z[sat] - z[att])} * scale;
+            double const   rLenSq = r.dot();
+            if (rLenSq == 0.0)
+            {
+                continue;
+            }
+
+            Vector3d const accel = r * (-rOrbits.gm / (rLenSq * std::sqrt(rLenSq)));
+
+            vx[sat] += accel.x() * dt;
+            vy[sat] += accel.y() * dt;
+            vz[sat] += accel.z() * dt;
+
+            x[sat] += spaceint_t(std::llround(vx[sat] * dt * invScale));
+            y[sat] += spaceint_t(std::llround(vy[sat] * dt * invScale));
+            z[sat] += spaceint_t(std::llround(vz[sat] * dt * invScale));
+        }
+
+        rails_update(rOrbits, rRails, dt);
+    });
+
+    rBuilder.task()
+        .name       ("Spawn vehicles on rails that came close to the SceneFrame")
+        .run_on     ({tgScn.update(Run)})
+        .sync_with  ({tgHnd.railSats(Delete), tgUSFrm.sceneFrame(Ready), tgVhSp.spawnRequest(Modify_), tgVhSpVB.dataVB(Modify_)})
+        .push_to    (out.m_tasks)
+        .args       ({           idResources,           idUniverse,                  idScnFrame,                  idVehicleSpawn,                    idVehicleSpawnVB,                   idVehicleHandoff})
+        .func([] (Resources& rResources, Universe& rUniverse, SceneFrame const& rScnFrame, ACtxVehicleSpawn& rVehicleSpawn, ACtxVehicleSpawnVB& rVehicleSpawnVB, VehicleHandoffJolt& rHandoff) noexcept
+    {
+        // Spawning from the previous update is done by now
+        for (std::unique_ptr<VehicleData> &rpData : rHandoff.activated)
+        {
+            SysVehicleHandoff::release_owners(*rpData, rResources);
+        }
+        rHandoff.activated.clear();
+
+        if (rScnFrame.m_parent != rHandoff.anchorSpace)
+        {
+            return;
+        }
+
+        CoSpaceCommon &rRails = rUniverse.m_coordCommon[rHandoff.railSpace];
+        CoordTransformer const railsToScene = coord_parent_to_child(rRails, rScnFrame);
+        Quaterniond const      toSceneRot   = rScnFrame.m_rotation.inverted();
+
+        Vector3 const center = math::mul_2pow<Vector3, int>(Vector3(rScnFrame.m_scenePosition), -rScnFrame.m_precision);
+        float const   minDistSqr = rHandoff.activateDistance * rHandoff.activateDistance;
+
+        // Descending, so satellites moved into removed slots were already checked
+        for (std::size_t i = rRails.m_satCount; i-- != 0; )
+        {
+            if (SatId(i) == rHandoff.rails.attractor)
+            {
+                continue;
+            }
+
+            auto const [x, y, z]        = sat_views(rRails.m_satPositions,  rRails.m_data, rRails.m_satCount);
+            auto const [vx, vy, vz]     = sat_views(rRails.m_satVelocities, rRails.m_data, rRails.m_satCount);
+            auto const [qx, qy, qz, qw] = sat_views(rRails.m_satRotations,  rRails.m_data, rRails.m_satCount);
+
+            Vector3g const scenePos = railsToScene.transform_position({x[i], y[i], z[i]});
+            Vector3 const  pos      = Vector3(math::mul_2pow<Vector3d, int>(Vector3d(scenePos), -rScnFrame.m_precision));
+            if ((pos - center).dot() > minDistSqr)
+            {
+                continue;
+            }
+
+            std::optional<VehicleData> loaded = SysVehicleBlueprint::load(rHandoff.satBlueprints[i], rResources, rHandoff.pkg);
+            if (loaded.has_value())
+            {
+                Quaterniond const rot{{qx[i], qy[i], qz[i]}, qw[i]};
+
+                rVehicleSpawn.spawnRequest.push_back({
+                    .position = pos,
+                    .velocity = Vector3(toSceneRot.transformVector({vx[i], vy[i], vz[i]})),
+                    .rotation = Quaternion((toSceneRot * rot).normalized())
+                });
+                rHandoff.activated.emplace_back(std::make_unique<VehicleData>(std::move(*loaded)));
+                rVehicleSpawnVB.dataVB.push_back(rHandoff.activated.back().get());
+            }
+            else
+            {
+                OSP_LOG_WARN("Vehicle on rails has an invalid blueprint, removing it");
+            }
+
+            rHandoff.satMoved.clear();
+            sat_remove(rRails, SatId(i), rHandoff.satMoved);
+            for (SatRemap const remap : rHandoff.satMoved)
+            {
+                rHandoff.satBlueprints[remap.to] = std::move(rHandoff.satBlueprints[remap.from]);
+                if (remap.from < rHandoff.rails.onRails.size())
+                {
+                    rHandoff.rails.orbits [remap.to] = rHandoff.rails.orbits [remap.from];
+                    rHandoff.rails.onRails[remap.to] = rHandoff.rails.onRails[remap.from];
+                }
+            }
+            rHandoff.satBlueprints.pop_back();
+            rails_leave(rHandoff.rails, SatId(rRails.m_satCount));
+        }
+    });
+
+    rBuilder.task()
+        .name       ("Clear VehicleData of vehicles taken off rails")
+        .run_on     ({tgScn.cleanup(Run_)})
+        .push_to    (out.m_tasks)
+        .args       ({           idResources,                   idVehicleHandoff})
+        .func([] (Resources& rResources, VehicleHandoffJolt& rHandoff) noexcept
+    {
+        for (std::unique_ptr<VehicleData> &rpData : rHandoff.activated)
+        {
+            SysVehicleHandoff::release_owners(*rpData, rResources);
+        }
+        rHandoff.activated.clear();
+    });
+
+    return out;
+} // setup_vehicle_handoff_jolt
+
 } // namespace testapp::scenes
@@ -26,6 +26,8 @@
 
 #include "../scenarios.h"
 
+#include <adera/activescene/aerodynamics.h>
+
 #include <osp/core/math_types.h>
 #include <osp/tasks/builder.h>
 #include <osp/tasks/tasks.h>
@@ -33,6 +35,7 @@
 #include <osp/tasks/top_tasks.h>
 
 #include <ospjolt/activescene/forcefactors.h>
+#include <ospjolt/activescene/joltinteg.h>
 
 #include <longeron/id_management/registry_stl.hpp>
 
@@ -41,13 +44,18 @@ namespace testapp::scenes
 
 /**
  * @brief Jolt physics integration
+ *
+ * @param config [in] World sizes for the scenario. Worlds without a job system set share
+ *                    SysJolt::shared_job_system
  */
 osp::Session setup_jolt(
         osp::TopTaskBuilder&        rBuilder,
         osp::ArrayView<entt::any>   topData,
+        osp::Session const&         application,
         osp::Session const&         scene,
         osp::Session const&         commonScene,
-        osp::Session const&         physics);
+        osp::Session const&         physics,
+        ospjolt::JoltWorldConfig    config);
 
 /**
  * @brief Create a single empty force factor bitset
@@ -69,6 +77,24 @@ osp::Session setup_jolt_force_accel(
         osp::Session const&         joltFactors,
         osp::Vector3                accel);
 
+/**
+ * @brief Gravity from the CoSpaceNBody satellites of setup_solar_system_testplanets, add to a
+ *        force factor bitset
+ *
+ * Satellites are transformed into the SceneFrame once per update, then each body sums the pull
+ * of all of them. Satellites too far away to matter are left out.
+ */
+osp::Session setup_jolt_force_nbody_gravity(
+        osp::TopTaskBuilder&        rBuilder,
+        osp::ArrayView<entt::any>   topData,
+        osp::Session const&         scene,
+        osp::Session const&         physics,
+        osp::Session const&         jolt,
+        osp::Session const&         joltFactors,
+        osp::Session const&         uniCore,
+        osp::Session const&         uniScnFrame,
+        osp::Session const&         solarSystemPlanets);
+
 /**
  * @brief Support for Shape Spawner physics using Jolt Physics
  */
@@ -110,4 +136,91 @@ osp::Session setup_rocket_thrust_jolt(
         osp::Session const&         jolt,
         osp::Session const&         joltFactors);
 
+/**
+ * @brief Aerodynamic drag and lift on vehicle welds
+ *
+ * Part surfaces are computed from their colliders when a weld changes. Each step, all parts of a
+ * body are evaluated together, see adera::SysAero::forces.
+ */
+osp::Session setup_aero_jolt(
+        osp::TopTaskBuilder&        rBuilder,
+        osp::ArrayView<entt::any>   topData,
+        osp::Session const&         scene,
+        osp::Session const&         commonScene,
+        osp::Session const&         physics,
+        osp::Session const&         parts,
+        osp::Session const&         jolt,
+        osp::Session const&         joltFactors,
+        adera::AeroAtmosphere       atmosphere);
+
+/**
+ * @brief Static Jolt mesh colliders for terrain chunks near dynamic bodies
+ *
+ * Collision shapes are built on the Jolt job system, and bodies are added once they finish in a
+ * later update. Changed chunks have their colliders rebuilt.
+ */
+osp::Session setup_terrain_collider_jolt(
+        osp::TopTaskBuilder&        rBuilder,
+        osp::ArrayView<entt::any>   topData,
+        osp::Session const&         scene,
+        osp::Session const&         terrain,
+        osp::Session const&         jolt);
+
+/**
+ * @brief Serve vehicle state to replication clients over UDP, see osp/net/replication.h
+ *
+ * Each weld is replicated as one object with its transform, velocities from Jolt, structure
+ * (prefabs and part transforms) and the values of float signals connected to its machines.
+ * Clients connect by sending an ack packet.
+ *
+ * @param port  [in] UDP port to listen on
+ */
+osp::Session setup_vehicle_replication_jolt(
+        osp::TopTaskBuilder&        rBuilder,
+        osp::ArrayView<entt::any>   topData,
+        osp::Session const&         application,
+        osp::Session const&         scene,
+        osp::Session const&         commonScene,
+        osp::Session const&         parts,
+        osp::Session const&         signalsFloat,
+        osp::Session const&         jolt,
+        std::uint16_t               port);
+
+/**
+ * @brief Put welds far from the SceneFrame on rails as universe satellites, and spawn them back
+ *        through the vehicle spawner once they come close again
+ *
+ * Each weld is kept as a vehicle blueprint (see adera::SysVehicleBlueprint), its parts,
+ * machines and Jolt body are removed from the scene. Satellites follow Kepler orbits (see
+ * osp::universe::SatRails) around a point mass attractor, in a coordinate space of their own
+ * aligned with the SceneFrame's parent. Handoff pauses while the SceneFrame is in a different
+ * coordinate space.
+ *
+ * @param deactivateDistance    [in] Welds further than this from the SceneFrame center (meters)
+ *                                   are put on rails
+ * @param activateDistance      [in] Satellites closer than this are spawned, must be less than
+ *                                   deactivateDistance
+ * @param railsGravity          [in] Gravity at the SceneFrame origin in SceneFrame axes. The
+ *                                   attractor is placed railsRadius away in its direction.
+ * @param railsRadius           [in] Distance from the SceneFrame origin to the attractor (meters)
+ */
+osp::Session setup_vehicle_handoff_jolt(
+        osp::TopTaskBuilder&        rBuilder,
+        osp::ArrayView<entt::any>   topData,
+        osp::Session const&         application,
+        osp::Session const&         scene,
+        osp::Session const&         commonScene,
+        osp::Session const&         parts,
+        osp::Session const&         signalsFloat,
+        osp::Session const&         vehicleSpawn,
+        osp::Session const&         vehicleSpawnVB,
+        osp::Session const&         jolt,
+        osp::Session const&         uniCore,
+        osp::Session const&         uniScnFrame,
+        osp::PkgId                  pkg,
+        float                       deactivateDistance,
+        float                       activateDistance,
+        osp::Vector3                railsGravity,
+        double                      railsRadius);
+
 } // namespace testapp::scenes
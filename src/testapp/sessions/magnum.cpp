@@ -24,24 +24,46 @@
  */
 #include "magnum.h"
 #include "common.h"
+#include "terrain.h"
+#include "universe.h"
 
 #include "../MagnumApplication.h"
 
+#include <Corrade/Containers/ArrayViewStl.h>
+#include <Magnum/GL/Buffer.h>
+#include <Magnum/GL/Context.h>
 #include <Magnum/GL/DefaultFramebuffer.h>
 #include <Magnum/GL/Renderer.h>
+#include <Magnum/GL/Version.h>
 
 #include <adera/drawing/CameraController.h>
 #include <adera/drawing_gl/flat_shader.h>
+#include <adera/drawing_gl/nbody_shader.h>
+#include <adera/drawing_gl/orbit_trail_shader.h>
 #include <adera/drawing_gl/phong_shader.h>
+#include <adera/drawing_gl/plume_shader.h>
+#include <adera/drawing_gl/satellite_shader.h>
+#include <adera/drawing_gl/terrain_fill_shader.h>
 #include <adera/drawing_gl/visualizer_shader.h>
 #include <osp/activescene/basic_fn.h>
+#include <osp/drawing/culling.h>
 #include <osp/drawing/drawing.h>
+#include <osp/drawing/render_commands.h>
 #include <osp/drawing_gl/rendergl.h>
 #include <osp/universe/coordinates.h>
 #include <osp/universe/universe.h>
+#include <osp/util/ExecutablePath.h>
+#include <osp/util/metrics.h>
 
 #include <adera/machines/links.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <utility>
+
 
 // for the 0xrrggbb_rgbf and angle literals
 using namespace Magnum::Math::Literals;
@@ -87,11 +109,32 @@ Session setup_magnum(
     // Order-dependent; MagnumApplication construction starts OpenGL context, needed by RenderGL
     /* unused */      top_emplace<MagnumApplication>(topData, idActiveApp, args, rUserInput);
     auto &rRenderGl = top_emplace<RenderGL>         (topData, idRenderGl);
+    /* unused */      top_emplace<RenderStats>      (topData, idRenderStats);
+
+    // Skip compiling our own shaders on later launches
+    rRenderGl.m_programCache.open(std::filesystem::path{osp::filefunctions::s_exe_dir} / "shadercache");
 
     SysRenderGL::setup_context(rRenderGl);
+    SysRenderGL::setup_frame_ring(rRenderGl, 1u << 20u);
+
+    // Spread large mesh and texture uploads (e.g. vehicle glTFs) across frames
+    rRenderGl.m_uploads.m_budgetBytes = 8u << 20u;
+
+    // Evict meshes and textures no longer used by any DrawEnt beyond this, e.g. old vehicles
+    rRenderGl.m_gpuMemory.m_budgetBytes = std::size_t(512u) << 20u;
+
+    // Only upload the mip levels of part textures that are big enough on screen to need them
+    rRenderGl.m_texMips.m_minSize = 256;
+
+    // Pack same-sized part textures into array layers, so instanced draws don't split by texture
+    rRenderGl.m_texArrays.m_layersPerArray = 64;
+
+    // Render at a lower resolution when the GPU can't keep up, e.g. looking over lots of terrain
+    rRenderGl.m_renderScale.m_dynamic = true;
 
     rBuilder.task()
         .name       ("Clean up Magnum renderer")
+        .affinity   (TopTaskAffinity::Main)
         .run_on     ({tgWin.cleanup(Run_)})
         .push_to    (out.m_tasks)
         .args       ({      idResources,          idRenderGl})
@@ -133,9 +176,12 @@ Session setup_magnum_scene(
 
     rBuilder.pipeline(tgMgnScn.fbo)             .parent(tgScnRdr.render);
     rBuilder.pipeline(tgMgnScn.camera)          .parent(tgScnRdr.render);
+    rBuilder.pipeline(tgMgnScn.cmdFwd)          .parent(tgScnRdr.render);
+    rBuilder.pipeline(tgMgnScn.depthPyramid)    .parent(tgScnRdr.render);
 
     top_emplace< ACtxSceneRenderGL >    (topData, idScnRenderGl);
     top_emplace< RenderGroup >          (topData, idGroupFwd);
+    top_emplace< RenderCmdBuffer >      (topData, idCmdFwd);
 
     auto &rCamera = top_emplace< Camera >(topData, idCamera);
 
@@ -145,19 +191,21 @@ Session setup_magnum_scene(
 
     rBuilder.task()
         .name       ("Resize ACtxSceneRenderGL (OpenGL) to fit all DrawEnts")
+        .affinity   (TopTaskAffinity::Main)
         .run_on     ({tgScnRdr.drawEntResized(Run)})
         .sync_with  ({})
         .push_to    (out.m_tasks)
         .args       ({ idScnRender, idScnRenderGl })
         .func       ([] (ACtxSceneRender const& rScnRender, ACtxSceneRenderGL& rScnRenderGl) noexcept
     {
-        std::size_t const capacity = rScnRender.m_drawIds.capacity();
+        std::size_t const capacity = rScnRender.m_drawCapacity;
         rScnRenderGl.m_diffuseTexId   .resize(capacity);
         rScnRenderGl.m_meshId         .resize(capacity);
     });
 
     rBuilder.task()
         .name       ("Compile Resource Meshes to GL")
+        .affinity   (TopTaskAffinity::Main)
         .run_on     ({tgScnRdr.meshResDirty(UseOrRun)})
         .sync_with  ({tgScnRdr.mesh(Ready), tgMgn.meshGL(New), tgScnRdr.entMeshDirty(UseOrRun)})
         .push_to    (out.m_tasks)
@@ -169,6 +217,7 @@ Session setup_magnum_scene(
 
     rBuilder.task()
         .name       ("Compile Resource Textures to GL")
+        .affinity   (TopTaskAffinity::Main)
         .run_on     ({tgScnRdr.textureResDirty(UseOrRun)})
         .sync_with  ({tgScnRdr.texture(Ready), tgMgn.textureGL(New)})
         .push_to    (out.m_tasks)
@@ -180,6 +229,7 @@ Session setup_magnum_scene(
 
     rBuilder.task()
         .name       ("Sync GL textures to entities with scene textures")
+        .affinity   (TopTaskAffinity::Main)
         .run_on     ({tgScnRdr.entTextureDirty(UseOrRun)})
         .sync_with  ({tgScnRdr.texture(Ready), tgScnRdr.entTexture(Ready), tgMgn.textureGL(Ready), tgMgn.entTextureGL(Modify), tgScnRdr.drawEntResized(Done)})
         .push_to    (out.m_tasks)
@@ -197,6 +247,7 @@ Session setup_magnum_scene(
 
     rBuilder.task()
         .name       ("Resync GL textures")
+        .affinity   (TopTaskAffinity::Main)
         .run_on     ({tgWin.resync(Run)})
         .sync_with  ({tgScnRdr.texture(Ready), tgMgn.textureGL(Ready), tgMgn.entTextureGL(Modify), tgScnRdr.drawEntResized(Done)})
         .push_to    (out.m_tasks)
@@ -216,6 +267,7 @@ Session setup_magnum_scene(
 
     rBuilder.task()
         .name       ("Sync GL meshes to entities with scene meshes")
+        .affinity   (TopTaskAffinity::Main)
         .run_on     ({tgScnRdr.entMeshDirty(UseOrRun)})
         .sync_with  ({tgScnRdr.mesh(Ready), tgScnRdr.entMesh(Ready), tgMgn.meshGL(Ready), tgMgn.entMeshGL(Modify), tgScnRdr.drawEntResized(Done)})
         .push_to    (out.m_tasks)
@@ -233,6 +285,7 @@ Session setup_magnum_scene(
 
     rBuilder.task()
         .name       ("Resync GL meshes")
+        .affinity   (TopTaskAffinity::Main)
         .run_on     ({tgWin.resync(Run)})
         .sync_with  ({tgScnRdr.mesh(Ready), tgMgn.meshGL(Ready), tgMgn.entMeshGL(Modify), tgScnRdr.drawEntResized(Done)})
         .push_to    (out.m_tasks)
@@ -252,11 +305,12 @@ Session setup_magnum_scene(
 
     rBuilder.task()
         .name       ("Bind and display off-screen FBO")
+        .affinity   (TopTaskAffinity::Main)
         .run_on     ({tgScnRdr.render(Run)})
         .sync_with  ({tgMgnScn.fbo(EStgFBO::Bind)})
         .push_to    (out.m_tasks)
-        .args       ({              idDrawing,          idRenderGl,                   idGroupFwd,              idCamera })
-        .func([] (ACtxDrawing const& rDrawing, RenderGL& rRenderGl, RenderGroup const& rGroupFwd, Camera const& rCamera) noexcept
+        .args       ({              idDrawing,          idRenderGl,                   idGroupFwd,              idCamera,             idRenderStats,                idMetrics })
+        .func([] (ACtxDrawing const& rDrawing, RenderGL& rRenderGl, RenderGroup const& rGroupFwd, Camera const& rCamera, RenderStats& rRenderStats, Metrics const& rMetrics) noexcept
     {
         using Magnum::GL::Framebuffer;
         using Magnum::GL::FramebufferClear;
@@ -265,26 +319,132 @@ Session setup_magnum_scene(
         rFbo.bind();
 
         Magnum::GL::Texture2D &rFboColor = rRenderGl.m_texGl.get(rRenderGl.m_fboColor);
-        SysRenderGL::display_texture(rRenderGl, rFboColor);
+        SysRenderGL::pass_begin(rRenderGl, ERenderPass::Blit, rRenderStats);
+        SysRenderGL::display_texture(rRenderGl, rFboColor, rRenderGl.m_renderScale.m_renderedSize);
+        SysRenderGL::pass_end(rRenderGl, ERenderPass::Blit, rRenderStats);
+        ++rRenderStats.frames;
+
+        std::uint64_t drawCalls = 0;
+        std::uint64_t triangles = 0;
+        for (RenderPassStats const& pass : rRenderStats.passes)
+        {
+            drawCalls += pass.drawCalls;
+            triangles += pass.triangles;
+        }
+        rMetrics.gauge_set("render.draw_calls", double(drawCalls));
+        rMetrics.gauge_set("render.triangles",  double(triangles));
 
+        // Last frame is displayed, pick the resolution of the next one
+        RenderScaleGL &rScale = rRenderGl.m_renderScale;
+        SysRenderGL::update_render_scale(rScale, rRenderStats);
+        rScale.m_renderedSize = SysRenderGL::render_scale_size(rScale);
+        rMetrics.gauge_set("render.scale", double(rScale.m_scale));
+
+        rFbo.setViewport({{0, 0}, rScale.m_renderedSize});
+        rFbo.bind();
         rFbo.clear(   FramebufferClear::Color | FramebufferClear::Depth
                     | FramebufferClear::Stencil);
     });
 
     rBuilder.task()
-        .name       ("Render Entities")
+        .name       ("Build depth pyramid from last frame's depth")
+        .affinity   (TopTaskAffinity::Main)
+        .run_on     ({tgScnRdr.render(Run)})
+        .sync_with  ({tgMgnScn.depthPyramid(Modify)})
+        .push_to    (out.m_tasks)
+        .args       ({            idScnRender,                         idScnRenderGl,          idRenderGl })
+        .func([] (ACtxSceneRender& rScnRender, ACtxSceneRenderGL const& rScnRenderGl, RenderGL& rRenderGl) noexcept
+    {
+        if (rScnRenderGl.m_occlusionCull)
+        {
+            SysRenderGL::depth_readback_end(rRenderGl, rScnRender.m_depthPyramid);
+        }
+        else
+        {
+            rScnRender.m_depthPyramid.m_levels.clear();
+        }
+    });
+
+    rBuilder.task()
+        .name       ("Cull, select LODs, and record render commands for forward group")
         .run_on     ({tgScnRdr.render(Run)})
         .sync_with  ({tgScnRdr.group(Ready), tgScnRdr.groupEnts(Ready), tgMgnScn.camera(Ready), tgScnRdr.drawTransforms(UseOrRun), tgScnRdr.entMesh(Ready), tgScnRdr.entTexture(Ready),
-                      tgMgn.entMeshGL(Ready), tgMgn.entTextureGL(Ready),
-                      tgScnRdr.drawEnt(Ready)})
+                      tgScnRdr.drawEnt(Ready), tgMgnScn.cmdFwd(New), tgMgnScn.depthPyramid(Ready)})
+        .push_to    (out.m_tasks)
+        .args       ({            idScnRender,                   idGroupFwd,              idCamera,                 idCmdFwd })
+        .func([] (ACtxSceneRender& rScnRender, RenderGroup const& rGroupFwd, Camera const& rCamera, RenderCmdBuffer& rCmdFwd) noexcept
+    {
+        // No GL calls here, only scene data is read
+
+        ViewProjMatrix viewProj{rCamera.m_transform.inverted(), rCamera.perspective(), rCamera.m_transform.translation()};
+
+        // Skip DrawEnts outside of the camera's view, widened in case the view is late-latched.
+        // Commands may be modified with a newer view before they're drawn, see cmdFwd(Modify).
+        Frustum const frustum = SysCulling::frustum_from_view_proj(rCamera.cull_perspective() * viewProj.m_view);
+        SysCulling::cull(frustum, rScnRender.m_visible, rScnRender.m_bounds, rScnRender.m_drawTransform,
+                         rScnRender.m_cullScratch, rScnRender.m_visibleCulled);
+
+        // Skip what was hidden behind other things last frame. Empty if occlusion culling is off
+        SysCulling::occlusion_cull(rScnRender.m_depthPyramid, rScnRender.m_cullScratch, rScnRender.m_visibleCulled);
+
+        // Pick levels of detail of what's left, by size on screen
+        SysCulling::select_lods(rScnRender, rScnRender.m_visibleCulled, viewProj.m_view, viewProj.m_proj[1][1]);
+
+        // Sizes on screen pick which texture mip levels to stream in
+        SysCulling::screen_sizes(rScnRender, rScnRender.m_visibleCulled, viewProj.m_view, viewProj.m_proj[1][1]);
+
+        // Sort by shader, mesh, and texture to reduce state changes
+        SysRenderCmd::record(rCmdFwd, rGroupFwd, rScnRender.m_visibleCulled, rScnRender, viewProj, false);
+    });
+
+    rBuilder.task()
+        .name       ("Render Entities")
+        .affinity   (TopTaskAffinity::Main)
+        .run_on     ({tgScnRdr.render(Run)})
+        .sync_with  ({tgScnRdr.entMesh(Ready), tgScnRdr.entTexture(Ready), tgMgn.entMeshGL(Ready), tgMgn.entTextureGL(Ready),
+                      tgScnRdr.drawEnt(Ready), tgMgnScn.cmdFwd(Ready), tgMgnScn.fbo(EStgFBO::Draw)})
         .push_to    (out.m_tasks)
-        .args       ({            idScnRender,          idRenderGl,                   idGroupFwd,              idCamera })
-        .func([] (ACtxSceneRender& rScnRender, RenderGL& rRenderGl, RenderGroup const& rGroupFwd, Camera const& rCamera, WorkerContext ctx) noexcept
+        .args       ({            idScnRender,                   idScnRenderGl,          idRenderGl,                 idCmdFwd,                idResources,                 idDrawingRes,             idRenderStats })
+        .func([] (ACtxSceneRender& rScnRender, ACtxSceneRenderGL& rScnRenderGl, RenderGL& rRenderGl, RenderCmdBuffer const& rCmdFwd, osp::Resources& rResources, ACtxDrawingRes const& rDrawingRes, RenderStats& rRenderStats) noexcept
     {
-        ViewProjMatrix viewProj{rCamera.m_transform.inverted(), rCamera.perspective()};
+        SysRenderGL::estimate_texture_mips(rRenderGl, rScnRenderGl, rScnRender.m_visibleCulled,
+                                           rScnRender.m_screenSize, rRenderGl.m_renderScale.m_renderedSize.y());
+        SysRenderGL::update_gpu_memory(rRenderGl, rResources, rScnRenderGl, rScnRender.m_drawIds);
+        SysRenderGL::process_uploads(rRenderGl, rResources);
+
+        // GL meshes for LODs picked while recording commands
+        SysRenderGL::sync_drawent_lods(rScnRender, rDrawingRes.m_meshToRes, rScnRenderGl.m_meshId, rRenderGl);
 
         // Forward Render fwd_opaque group to FBO
-        SysRenderGL::render_opaque(rGroupFwd, rScnRender.m_visible, viewProj);
+        SysRenderGL::frame_ring_begin(rRenderGl);
+        if (rScnRenderGl.m_depthPrepass)
+        {
+            SysRenderGL::pass_begin(rRenderGl, ERenderPass::DepthPrepass, rRenderStats);
+            SysRenderGL::render_depth_prepass(rRenderGl, rCmdFwd, rScnRenderGl, rScnRender.m_drawTransform);
+            SysRenderGL::pass_end(rRenderGl, ERenderPass::DepthPrepass, rRenderStats);
+        }
+
+        SysRenderGL::pass_begin(rRenderGl, ERenderPass::Opaque, rRenderStats);
+        SysRenderGL::render_opaque(rCmdFwd, rScnRender.m_visibleCulled, rScnRenderGl.m_depthPrepass);
+        SysRenderGL::pass_end(rRenderGl, ERenderPass::Opaque, rRenderStats, &rCmdFwd);
+        SysRenderGL::frame_ring_end(rRenderGl);
+    });
+
+    rBuilder.task()
+        .name       ("Read back depth for next frame's occlusion culling")
+        .affinity   (TopTaskAffinity::Main)
+        .run_on     ({tgScnRdr.render(Run)})
+        .sync_with  ({tgMgnScn.fbo(EStgFBO::Unbind), tgMgnScn.cmdFwd(Ready), tgMgnScn.depthPyramid(Ready)})
+        .push_to    (out.m_tasks)
+        .args       ({                   idScnRenderGl,          idRenderGl,                 idCmdFwd })
+        .func([] (ACtxSceneRenderGL const& rScnRenderGl, RenderGL& rRenderGl, RenderCmdBuffer const& rCmdFwd) noexcept
+    {
+        if (rScnRenderGl.m_occlusionCull)
+        {
+            // View the depth was actually drawn with, which may have been late-latched
+            ViewProjMatrix const viewProj{rCmdFwd.m_view, rCmdFwd.m_proj, rCmdFwd.m_origin};
+            SysRenderGL::depth_readback_begin(rRenderGl, viewProj.m_viewProj);
+        }
     });
 
     rBuilder.task()
@@ -331,6 +491,7 @@ Session setup_shader_visualizer(
     OSP_DECLARE_CREATE_DATA_IDS(out, topData, TESTAPP_DATA_SHADER_VISUALIZER)
 
     auto &rDrawVisual = top_emplace< ACtxDrawMeshVisualizer >(topData, idDrawShVisual);
+    top_emplace< RenderGroupWrites >(topData, idShVisualWrites);
 
     rDrawVisual.m_materialId = materialId;
     rDrawVisual.m_shader = MeshVisualizer{ MeshVisualizer::Configuration{}.setFlags(MeshVisualizer::Flag::Wireframe) };
@@ -348,30 +509,41 @@ Session setup_shader_visualizer(
     rBuilder.task()
         .name       ("Sync MeshVisualizer shader DrawEnts")
         .run_on     ({tgWin.sync(Run)})
-        .sync_with  ({tgScnRdr.materialDirty(UseOrRun), tgMgn.textureGL(Ready), tgScnRdr.groupEnts(Modify)})
+        .sync_with  ({tgScnRdr.materialDirty(UseOrRun), tgMgn.textureGL(Ready), tgScnRdr.groupEnts(New)})
         .push_to    (out.m_tasks)
-        .args       ({            idScnRender,             idGroupFwd,                        idDrawShVisual})
-        .func([] (ACtxSceneRender& rScnRender, RenderGroup& rGroupFwd, ACtxDrawMeshVisualizer& rDrawShVisual) noexcept
+        .args       ({                  idScnRender,                   idShVisualWrites,                        idDrawShVisual})
+        .func([] (ACtxSceneRender const& rScnRender, RenderGroupWrites& rShVisualWrites, ACtxDrawMeshVisualizer& rDrawShVisual) noexcept
     {
         Material const &rMat = rScnRender.m_materials[rDrawShVisual.m_materialId];
-        sync_drawent_visualizer(rMat.m_dirty.begin(), rMat.m_dirty.end(), rMat.m_ents, rGroupFwd.entities, rDrawShVisual);
+        sync_drawent_visualizer(rMat.m_dirty.begin(), rMat.m_dirty.end(), rMat.m_ents, rShVisualWrites, rDrawShVisual);
     });
 
     rBuilder.task()
         .name       ("Resync MeshVisualizer shader DrawEnts")
         .run_on     ({tgWin.resync(Run)})
-        .sync_with  ({tgScnRdr.groupEnts(Modify), tgScnRdr.group(Modify)})
+        .sync_with  ({tgScnRdr.groupEnts(New), tgScnRdr.group(Modify)})
         .push_to    (out.m_tasks)
-        .args       ({            idScnRender,             idGroupFwd,                        idDrawShVisual})
-        .func([] (ACtxSceneRender& rScnRender, RenderGroup& rGroupFwd, ACtxDrawMeshVisualizer& rDrawShVisual) noexcept
+        .args       ({                  idScnRender,                   idShVisualWrites,                        idDrawShVisual})
+        .func([] (ACtxSceneRender const& rScnRender, RenderGroupWrites& rShVisualWrites, ACtxDrawMeshVisualizer& rDrawShVisual) noexcept
     {
         Material const &rMat = rScnRender.m_materials[rDrawShVisual.m_materialId];
         for (DrawEnt const drawEnt : rMat.m_ents)
         {
-            sync_drawent_visualizer(drawEnt, rMat.m_ents, rGroupFwd.entities, rDrawShVisual);
+            sync_drawent_visualizer(drawEnt, rMat.m_ents, rShVisualWrites, rDrawShVisual);
         }
     });
 
+    rBuilder.task()
+        .name       ("Apply MeshVisualizer shader changes to forward RenderGroup")
+        .run_on     ({tgWin.sync(Run)})
+        .sync_with  ({tgScnRdr.groupEnts(Modify), tgScnRdr.group(Modify)})
+        .push_to    (out.m_tasks)
+        .args       ({             idGroupFwd,                   idShVisualWrites})
+        .func([] (RenderGroup& rGroupFwd, RenderGroupWrites& rShVisualWrites) noexcept
+    {
+        SysRender::apply_group_writes(rGroupFwd.entities, rShVisualWrites);
+    });
+
     return out;
 } // setup_shader_visualizer
 
@@ -401,6 +573,7 @@ Session setup_shader_flat(
     Session out;
     OSP_DECLARE_CREATE_DATA_IDS(out, topData, TESTAPP_DATA_SHADER_FLAT)
     auto &rDrawFlat = top_emplace< ACtxDrawFlat >(topData, idDrawShFlat);
+    top_emplace< RenderGroupWrites >(topData, idShFlatWrites);
 
     rDrawFlat.shaderDiffuse       = FlatGL3D{FlatGL3D::Configuration{}.setFlags(FlatGL3D::Flag::Textured)};
     rDrawFlat.shaderUntextured    = FlatGL3D{FlatGL3D::Configuration{}};
@@ -412,20 +585,32 @@ Session setup_shader_flat(
         return out;
     }
 
+    // Draw opaque entities with instancing, one draw call per mesh and texture
+    auto const instancedFlags           = FlatGL3D::Flag::InstancedTransformation | FlatGL3D::Flag::VertexColor;
+    rDrawFlat.shaderInstancedDiffuse    = FlatGL3D{FlatGL3D::Configuration{}.setFlags(instancedFlags | FlatGL3D::Flag::Textured)};
+    rDrawFlat.shaderInstancedUntextured = FlatGL3D{FlatGL3D::Configuration{}.setFlags(instancedFlags)};
+    if (rRenderGl.m_texArrays.m_layersPerArray != 0)
+    {
+        auto const arrayFlags = FlatGL3D::Flag::TextureArrays | FlatGL3D::Flag::InstancedTextureOffset;
+        rDrawFlat.shaderInstancedDiffuseArray = FlatGL3D{FlatGL3D::Configuration{}.setFlags(instancedFlags | FlatGL3D::Flag::Textured | arrayFlags)};
+    }
+    rDrawFlat.instancing                = true;
+    top_get< RenderGroup >(topData, idGroupFwd).instanced.push_back({&draw_instanced_flat, {&rDrawFlat}});
+
     rBuilder.task()
         .name       ("Sync Flat shader DrawEnts")
         .run_on     ({tgWin.sync(Run)})
-        .sync_with  ({tgScnRdr.groupEnts(Modify), tgScnRdr.group(Modify), tgScnRdr.materialDirty(UseOrRun)})
+        .sync_with  ({tgScnRdr.groupEnts(New), tgScnRdr.group(Modify), tgScnRdr.materialDirty(UseOrRun)})
         .push_to    (out.m_tasks)
-        .args       ({            idScnRender,             idGroupFwd,                         idScnRenderGl,              idDrawShFlat})
-        .func([] (ACtxSceneRender& rScnRender, RenderGroup& rGroupFwd, ACtxSceneRenderGL const& rScnRenderGl, ACtxDrawFlat& rDrawShFlat) noexcept
+        .args       ({                  idScnRender,                   idShFlatWrites,                         idScnRenderGl,              idDrawShFlat})
+        .func([] (ACtxSceneRender const& rScnRender, RenderGroupWrites& rShFlatWrites, ACtxSceneRenderGL const& rScnRenderGl, ACtxDrawFlat& rDrawShFlat) noexcept
     {
         Material const &rMat = rScnRender.m_materials[rDrawShFlat.materialId];
         sync_drawent_flat(rMat.m_dirty.begin(), rMat.m_dirty.end(),
         {
             .hasMaterial    = rMat.m_ents,
-            .pStorageOpaque = &rGroupFwd.entities,
-            /* TODO: set .pStorageTransparent */
+            .pWritesOpaque  = &rShFlatWrites,
+            /* TODO: set .pWritesTransparent */
             .opaque         = rScnRender.m_opaque,
             .transparent    = rScnRender.m_transparent,
             .diffuse        = rScnRenderGl.m_diffuseTexId,
@@ -436,10 +621,10 @@ Session setup_shader_flat(
     rBuilder.task()
         .name       ("Resync Flat shader DrawEnts")
         .run_on     ({tgWin.resync(Run)})
-        .sync_with  ({tgScnRdr.materialDirty(UseOrRun), tgMgn.textureGL(Ready), tgScnRdr.groupEnts(Modify), tgScnRdr.group(Modify)})
+        .sync_with  ({tgScnRdr.materialDirty(UseOrRun), tgMgn.textureGL(Ready), tgScnRdr.groupEnts(New), tgScnRdr.group(Modify)})
         .push_to    (out.m_tasks)
-        .args       ({            idScnRender,             idGroupFwd,                         idScnRenderGl,              idDrawShFlat})
-        .func([] (ACtxSceneRender& rScnRender, RenderGroup& rGroupFwd, ACtxSceneRenderGL const& rScnRenderGl, ACtxDrawFlat& rDrawShFlat) noexcept
+        .args       ({                  idScnRender,                   idShFlatWrites,                         idScnRenderGl,              idDrawShFlat})
+        .func([] (ACtxSceneRender const& rScnRender, RenderGroupWrites& rShFlatWrites, ACtxSceneRenderGL const& rScnRenderGl, ACtxDrawFlat& rDrawShFlat) noexcept
     {
         Material const &rMat = rScnRender.m_materials[rDrawShFlat.materialId];
         for (DrawEnt const drawEnt : rMat.m_ents)
@@ -447,8 +632,8 @@ Session setup_shader_flat(
             sync_drawent_flat(drawEnt,
             {
                 .hasMaterial    = rMat.m_ents,
-                .pStorageOpaque = &rGroupFwd.entities,
-                /* TODO: set .pStorageTransparent */
+                .pWritesOpaque  = &rShFlatWrites,
+                /* TODO: set .pWritesTransparent */
                 .opaque         = rScnRender.m_opaque,
                 .transparent    = rScnRender.m_transparent,
                 .diffuse        = rScnRenderGl.m_diffuseTexId,
@@ -457,12 +642,78 @@ Session setup_shader_flat(
         }
     });
 
+    rBuilder.task()
+        .name       ("Apply Flat shader changes to forward RenderGroup")
+        .run_on     ({tgWin.sync(Run)})
+        .sync_with  ({tgScnRdr.groupEnts(Modify), tgScnRdr.group(Modify)})
+        .push_to    (out.m_tasks)
+        .args       ({             idGroupFwd,                   idShFlatWrites})
+        .func([] (RenderGroup& rGroupFwd, RenderGroupWrites& rShFlatWrites) noexcept
+    {
+        SysRender::apply_group_writes(rGroupFwd.entities, rShFlatWrites);
+    });
+
     return out;
 } // setup_shader_flat
 
 
 
 
+Session setup_shader_plume(
+        TopTaskBuilder&             rBuilder,
+        ArrayView<entt::any> const  topData,
+        Session const&              windowApp,
+        Session const&              sceneRenderer,
+        Session const&              magnum,
+        Session const&              magnumScene,
+        Session const&              rocketPlumes,
+        MaterialId const            materialId)
+{
+    OSP_DECLARE_GET_DATA_IDS(sceneRenderer, TESTAPP_DATA_SCENE_RENDERER);
+    OSP_DECLARE_GET_DATA_IDS(magnumScene,   TESTAPP_DATA_MAGNUM_SCENE);
+    OSP_DECLARE_GET_DATA_IDS(magnum,        TESTAPP_DATA_MAGNUM);
+    OSP_DECLARE_GET_DATA_IDS(rocketPlumes,  TESTAPP_DATA_ROCKET_PLUMES);
+    auto const tgScnRdr = sceneRenderer .get_pipelines< PlSceneRenderer >();
+    auto const tgMgn    = magnum        .get_pipelines< PlMagnum >();
+    auto const tgMgnScn = magnumScene   .get_pipelines< PlMagnumScene >();
+
+    auto &rScnRender    = top_get< ACtxSceneRender >        (topData, idScnRender);
+    auto &rScnRenderGl  = top_get< ACtxSceneRenderGL >      (topData, idScnRenderGl);
+    auto &rRenderGl     = top_get< RenderGL >               (topData, idRenderGl);
+    auto &rPlumes       = top_get< ACtxPlumes >             (topData, idPlumes);
+
+    Session out;
+    OSP_DECLARE_CREATE_DATA_IDS(out, topData, TESTAPP_DATA_SHADER_PLUME)
+    auto &rDrawPlume = top_emplace< ACtxDrawPlume >(topData, idDrawShPlume);
+
+    setup_plume_shader(rDrawPlume, &rRenderGl.m_programCache);
+    rDrawPlume.materialId = materialId;
+    rDrawPlume.assign_pointers(rScnRender, rScnRenderGl, rRenderGl, rPlumes);
+
+    // Plumes are blended over everything opaque, so they're drawn after the forward group
+    rBuilder.task()
+        .name       ("Render exhaust plumes")
+        .affinity   (TopTaskAffinity::Main)
+        .run_on     ({tgScnRdr.render(Run)})
+        .sync_with  ({tgMgnScn.fbo(EStgFBO::Unbind), tgMgnScn.cmdFwd(Ready), tgScnRdr.drawTransforms(UseOrRun),
+                      tgScnRdr.drawEnt(Ready), tgScnRdr.entMesh(Ready), tgMgn.entMeshGL(Ready)})
+        .push_to    (out.m_tasks)
+        .args       ({            idScnRender,          idRenderGl,                       idCmdFwd,               idDrawShPlume,             idRenderStats })
+        .func([] (ACtxSceneRender& rScnRender, RenderGL& rRenderGl, RenderCmdBuffer const& rCmdFwd, ACtxDrawPlume& rDrawPlume, RenderStats& rRenderStats) noexcept
+    {
+        ViewProjMatrix const viewProj{rCmdFwd.m_view, rCmdFwd.m_proj, rCmdFwd.m_origin};
+
+        SysRenderGL::pass_begin(rRenderGl, ERenderPass::Plume, rRenderStats);
+        draw_plumes(rDrawPlume, rScnRender.m_visibleCulled, viewProj);
+        SysRenderGL::pass_end(rRenderGl, ERenderPass::Plume, rRenderStats);
+    });
+
+    return out;
+} // setup_shader_plume
+
+
+
+
 Session setup_shader_phong(
         TopTaskBuilder&             rBuilder,
         ArrayView<entt::any> const  topData,
@@ -486,6 +737,7 @@ Session setup_shader_phong(
     Session out;
     OSP_DECLARE_CREATE_DATA_IDS(out, topData, TESTAPP_DATA_SHADER_PHONG)
     auto &rDrawPhong = top_emplace< ACtxDrawPhong >(topData, idDrawShPhong);
+    top_emplace< RenderGroupWrites >(topData, idShPhongWrites);
 
     auto const texturedFlags    = PhongGL::Flag::DiffuseTexture | PhongGL::Flag::AlphaMask | PhongGL::Flag::AmbientTexture;
     rDrawPhong.shaderDiffuse    = PhongGL{PhongGL::Configuration{}.setFlags(texturedFlags).setLightCount(2)};
@@ -498,20 +750,32 @@ Session setup_shader_phong(
         return out;
     }
 
+    // Draw opaque entities with instancing, one draw call per mesh and texture
+    auto const instancedFlags               = PhongGL::Flag::InstancedTransformation | PhongGL::Flag::VertexColor;
+    rDrawPhong.shaderInstancedDiffuse       = PhongGL{PhongGL::Configuration{}.setFlags(instancedFlags | texturedFlags).setLightCount(2)};
+    rDrawPhong.shaderInstancedUntextured    = PhongGL{PhongGL::Configuration{}.setFlags(instancedFlags).setLightCount(2)};
+    if (rRenderGl.m_texArrays.m_layersPerArray != 0)
+    {
+        auto const arrayFlags                   = PhongGL::Flag::TextureArrays | PhongGL::Flag::InstancedTextureOffset;
+        rDrawPhong.shaderInstancedDiffuseArray  = PhongGL{PhongGL::Configuration{}.setFlags(instancedFlags | texturedFlags | arrayFlags).setLightCount(2)};
+    }
+    rDrawPhong.instancing                   = true;
+    top_get< RenderGroup >(topData, idGroupFwd).instanced.push_back({&draw_instanced_phong, {&rDrawPhong}});
+
     rBuilder.task()
         .name       ("Sync Phong shader DrawEnts")
         .run_on     ({tgWin.sync(Run)})
-        .sync_with  ({tgScnRdr.materialDirty(UseOrRun), tgMgn.entTextureGL(Ready), tgScnRdr.groupEnts(Modify), tgScnRdr.group(Modify)})
+        .sync_with  ({tgScnRdr.materialDirty(UseOrRun), tgMgn.entTextureGL(Ready), tgScnRdr.groupEnts(New), tgScnRdr.group(Modify)})
         .push_to    (out.m_tasks)
-        .args       ({            idScnRender,             idGroupFwd,                         idScnRenderGl,               idDrawShPhong})
-        .func([] (ACtxSceneRender& rScnRender, RenderGroup& rGroupFwd, ACtxSceneRenderGL const& rScnRenderGl, ACtxDrawPhong& rDrawShPhong) noexcept
+        .args       ({                  idScnRender,                   idShPhongWrites,                         idScnRenderGl,              idDrawShPhong})
+        .func([] (ACtxSceneRender const& rScnRender, RenderGroupWrites& rShPhongWrites, ACtxSceneRenderGL const& rScnRenderGl, ACtxDrawPhong& rDrawShPhong) noexcept
     {
         Material const &rMat = rScnRender.m_materials[rDrawShPhong.materialId];
         sync_drawent_phong(rMat.m_dirty.begin(), rMat.m_dirty.end(),
         {
             .hasMaterial    = rMat.m_ents,
-            .pStorageOpaque = &rGroupFwd.entities,
-            /* TODO: set .pStorageTransparent */
+            .pWritesOpaque  = &rShPhongWrites,
+            /* TODO: set .pWritesTransparent */
             .opaque         = rScnRender.m_opaque,
             .transparent    = rScnRender.m_transparent,
             .diffuse        = rScnRenderGl.m_diffuseTexId,
@@ -522,10 +786,10 @@ Session setup_shader_phong(
     rBuilder.task()
         .name       ("Resync Phong shader DrawEnts")
         .run_on     ({tgWin.resync(Run)})
-        .sync_with  ({tgScnRdr.materialDirty(UseOrRun), tgMgn.entTextureGL(Ready), tgScnRdr.groupEnts(Modify), tgScnRdr.group(Modify)})
+        .sync_with  ({tgScnRdr.materialDirty(UseOrRun), tgMgn.entTextureGL(Ready), tgScnRdr.groupEnts(New), tgScnRdr.group(Modify)})
         .push_to    (out.m_tasks)
-        .args       ({            idScnRender,             idGroupFwd,                         idScnRenderGl,               idDrawShPhong})
-        .func([] (ACtxSceneRender& rScnRender, RenderGroup& rGroupFwd, ACtxSceneRenderGL const& rScnRenderGl, ACtxDrawPhong& rDrawShPhong) noexcept
+        .args       ({                  idScnRender,                   idShPhongWrites,                         idScnRenderGl,              idDrawShPhong})
+        .func([] (ACtxSceneRender const& rScnRender, RenderGroupWrites& rShPhongWrites, ACtxSceneRenderGL const& rScnRenderGl, ACtxDrawPhong& rDrawShPhong) noexcept
     {
         Material const &rMat = rScnRender.m_materials[rDrawShPhong.materialId];
         for (DrawEnt const drawEnt : rMat.m_ents)
@@ -533,7 +797,7 @@ Session setup_shader_phong(
             sync_drawent_phong(drawEnt,
             {
                 .hasMaterial    = rMat.m_ents,
-                .pStorageOpaque = &rGroupFwd.entities,
+                .pWritesOpaque  = &rShPhongWrites,
                 .opaque         = rScnRender.m_opaque,
                 .transparent    = rScnRender.m_transparent,
                 .diffuse        = rScnRenderGl.m_diffuseTexId,
@@ -542,8 +806,671 @@ Session setup_shader_phong(
         }
     });
 
+    rBuilder.task()
+        .name       ("Apply Phong shader changes to forward RenderGroup")
+        .run_on     ({tgWin.sync(Run)})
+        .sync_with  ({tgScnRdr.groupEnts(Modify), tgScnRdr.group(Modify)})
+        .push_to    (out.m_tasks)
+        .args       ({             idGroupFwd,                   idShPhongWrites})
+        .func([] (RenderGroup& rGroupFwd, RenderGroupWrites& rShPhongWrites) noexcept
+    {
+        SysRender::apply_group_writes(rGroupFwd.entities, rShPhongWrites);
+    });
+
     return out;
 } // setup_shader_phong
 
 
+struct TerrainDrawGL
+{
+    Magnum::GL::Buffer  vbufPos {Corrade::NoCreate};
+    Magnum::GL::Buffer  vbufNrm {Corrade::NoCreate};
+    Magnum::GL::Buffer  ibuf    {Corrade::NoCreate};
+    Magnum::GL::Mesh    mesh    {Corrade::NoCreate};
+
+    // Calculates fill vertex positions of chunks in ChunkScratchpad::chunksToFill, so only their
+    // shared vertices and normals are uploaded. chunkVbufPos is still uploaded as-is if not
+    // supported, or for chunks taken from the fill cache or chunk store.
+    adera::shader::TerrainFillShader    fillShader  {Corrade::NoCreate};
+    Magnum::GL::Buffer                  fillSubdiv  {Corrade::NoCreate};
+    Magnum::GL::Buffer                  fillBatches {Corrade::NoCreate};
+    Magnum::GL::Buffer                  fillJobs    {Corrade::NoCreate};
+    std::vector<std::uint32_t>          jobs;
+
+    /// First fill vertex of each chunk in fillJobs, sorted
+    std::vector<std::size_t>            fillBlocks;
+    bool                                gpuFill{false};
+
+    /// Bytes sent to the GPU by the last upload
+    std::size_t         uploadedBytes{0};
+
+    // Chunks are culled separately and drawn with one glMultiDrawElementsIndirect, with a command
+    // per visible chunk pointing at its row of the index buffer. Requires OpenGL 4.3; the whole
+    // mesh is drawn at once if not supported.
+    Magnum::GL::Buffer                                          indirect    {Corrade::NoCreate};
+    std::vector<DrawElementsIndirectGL>                         cmds;
+    osp::KeyedVec<planeta::ChunkId, BoundingSphere>             chunkBounds;
+
+    /// Chunks that currently exist, copied from ChunkSkeleton::m_chunkIds by the upload task
+    std::vector<planeta::ChunkId>                               drawChunks;
+    std::uint32_t                                               chunkIndexCount{0};
+    bool                                                        multiDraw{false};
+
+    /// Chunks culled by the last draw
+    std::size_t                                                 chunksCulled{0};
+};
+
+/**
+ * @brief Bounding sphere of a terrain chunk, from its shared vertices
+ *
+ * Fill vertices skipped by chunks with a reduction may hold stale positions, so only the shared
+ * vertices along the chunk's edges are used. The surface between them bulges outwards from the
+ * sphere by at most its sagitta, which is added to the radius.
+ */
+static BoundingSphere terrain_chunk_bounds(
+        ACtxTerrain         const&  rTerrain,
+        planeta::ChunkId    const   chunkId,
+        double              const   planetRadius) noexcept
+{
+    planeta::ChunkMeshBufferInfo const &rChInfo = rTerrain.chunkInfo;
+    auto const sharedUsed = rTerrain.skChunks.shared_vertices_used(chunkId);
+
+    Vector3 min{std::numeric_limits<float>::max()};
+    Vector3 max{-std::numeric_limits<float>::max()};
+    for (planeta::SharedVrtxOwner_t const& shared : sharedUsed)
+    {
+        Vector3 const pos = rTerrain.chunkGeom.chunkVbufPos[rChInfo.vbufSharedOffset + shared.value().value];
+        min = Magnum::Math::min(min, pos);
+        max = Magnum::Math::max(max, pos);
+    }
+
+    Vector3 const center = (min + max) * 0.5f;
+    float radiusSqr = 0.0f;
+    for (planeta::SharedVrtxOwner_t const& shared : sharedUsed)
+    {
+        Vector3 const pos = rTerrain.chunkGeom.chunkVbufPos[rChInfo.vbufSharedOffset + shared.value().value];
+        radiusSqr = std::max(radiusSqr, (pos - center).dot());
+    }
+
+    double const radius  = std::sqrt(double(radiusSqr));
+    double const sagitta = (radius < planetRadius)
+                         ? planetRadius - std::sqrt(planetRadius*planetRadius - radius*radius)
+                         : radius;
+
+    return {center, float(radius + sagitta)};
+}
+
+Session setup_terrain_draw_magnum(
+        TopTaskBuilder&             rBuilder,
+        ArrayView<entt::any> const  topData,
+        Session const&              windowApp,
+        Session const&              sceneRenderer,
+        Session const&              magnum,
+        Session const&              magnumScene,
+        Session const&              shPhong,
+        Session const&              terrain,
+        Session const&              terrainIco)
+{
+    OSP_DECLARE_GET_DATA_IDS(sceneRenderer, TESTAPP_DATA_SCENE_RENDERER);
+    OSP_DECLARE_GET_DATA_IDS(magnumScene,   TESTAPP_DATA_MAGNUM_SCENE);
+    OSP_DECLARE_GET_DATA_IDS(magnum,        TESTAPP_DATA_MAGNUM);
+    OSP_DECLARE_GET_DATA_IDS(shPhong,       TESTAPP_DATA_SHADER_PHONG);
+    OSP_DECLARE_GET_DATA_IDS(terrain,       TESTAPP_DATA_TERRAIN);
+    OSP_DECLARE_GET_DATA_IDS(terrainIco,    TESTAPP_DATA_TERRAIN_ICO);
+    auto const tgScnRdr = sceneRenderer .get_pipelines< PlSceneRenderer >();
+    auto const tgMgnScn = magnumScene   .get_pipelines< PlMagnumScene >();
+    auto const tgTrn    = terrain       .get_pipelines< PlTerrain >();
+
+    Session out;
+    auto const [idTerrainDrawGl] = out.acquire_data<1>(topData);
+    auto &rTrnGl = top_emplace< TerrainDrawGL >(topData, idTerrainDrawGl);
+
+    if (Magnum::GL::Context::current().isVersionSupported(Magnum::GL::Version::GL430))
+    {
+        auto &rRenderGl     = top_get< RenderGL >(topData, idRenderGl);
+        rTrnGl.fillShader   = adera::shader::TerrainFillShader{&rRenderGl.m_programCache};
+        rTrnGl.gpuFill      = true;
+        rTrnGl.indirect     = Magnum::GL::Buffer{Magnum::GL::Buffer::TargetHint::DrawIndirect};
+        rTrnGl.multiDraw    = true;
+    }
+
+    rBuilder.task()
+        .name       ("Upload changed terrain chunk buffer ranges")
+        .affinity   (TopTaskAffinity::Main)
+        .run_on     ({tgScnRdr.render(Run)})
+        .sync_with  ({tgTrn.skeleton(Ready), tgMgnScn.fbo(EStgFBO::Bind)})
+        .push_to    (out.m_tasks)
+        .args       ({                 idTerrain,                       idTerrainIco,               idTerrainDrawGl })
+        .func([] (ACtxTerrain const& rTerrain, ACtxTerrainIco const& rTerrainIco, TerrainDrawGL& rTrnGl) noexcept
+    {
+        using Magnum::GL::Buffer;
+        using Corrade::Containers::arrayView;
+
+        planeta::BasicChunkMeshGeometry const &rChGeo   = rTerrain.chunkGeom;
+        planeta::ChunkMeshBufferInfo    const &rChInfo  = rTerrain.chunkInfo;
+        planeta::ChunkScratchpad        const &rChSP    = rTerrain.chunkSP;
+
+        bool const firstUpload = rTrnGl.mesh.id() == 0;
+
+        // Shared vertices don't move while chunks use them, so only bounds of changed chunks
+        // need to be recalculated
+        if (rTrnGl.multiDraw && (firstUpload || ! rChSP.chunksDirty.empty()))
+        {
+            planeta::ChunkSkeleton const &rSkCh = rTerrain.skChunks;
+            rTrnGl.chunkBounds.resize(rSkCh.m_chunkIds.capacity());
+            rTrnGl.chunkIndexCount = rChInfo.chunkMaxFaceCount * 3;
+
+            rTrnGl.drawChunks.clear();
+            for (planeta::ChunkId const chunkId : rSkCh.m_chunkIds)
+            {
+                if (firstUpload || rChSP.chunksDirty.contains(chunkId))
+                {
+                    rTrnGl.chunkBounds[chunkId] = terrain_chunk_bounds(rTerrain, chunkId, rTerrainIco.radius);
+                }
+                rTrnGl.drawChunks.push_back(chunkId);
+            }
+        }
+
+        if (firstUpload)
+        {
+            // First upload, allocate and copy the whole buffers
+            rTrnGl.vbufPos  = Buffer{};
+            rTrnGl.vbufNrm  = Buffer{};
+            rTrnGl.ibuf     = Buffer{Buffer::TargetHint::ElementArray};
+            rTrnGl.vbufPos.setData(rChGeo.chunkVbufPos, Magnum::GL::BufferUsage::DynamicDraw);
+            rTrnGl.vbufNrm.setData(rChGeo.chunkVbufNrm, Magnum::GL::BufferUsage::DynamicDraw);
+            rTrnGl.ibuf   .setData(rChGeo.chunkIbuf,    Magnum::GL::BufferUsage::DynamicDraw);
+
+            rTrnGl.mesh = Mesh{Magnum::MeshPrimitive::Triangles};
+            rTrnGl.mesh
+                .addVertexBuffer(rTrnGl.vbufPos, 0, PhongGL::Position{})
+                .addVertexBuffer(rTrnGl.vbufNrm, 0, PhongGL::Normal{})
+                .setIndexBuffer (rTrnGl.ibuf,    0, Magnum::MeshIndexType::UnsignedInt)
+                .setCount(Magnum::Int(rChGeo.chunkIbuf.size() * 3));
+
+            rTrnGl.uploadedBytes =   rChGeo.chunkVbufPos.size() * sizeof(Vector3) * 2
+                                   + rChGeo.chunkIbuf.size()    * sizeof(Vector3u);
+
+            if (rTrnGl.gpuFill)
+            {
+                // The LUT is the same for every chunk, upload it once
+                std::vector<std::uint32_t> subdiv;
+                subdiv.reserve(rChSP.lut->data().size() * 2);
+                for (planeta::ChunkFillSubdivLUT::ToSubdiv const& toSubdiv : rChSP.lut->data())
+                {
+                    subdiv.push_back(std::uint32_t(toSubdiv.m_vrtxA) | (std::uint32_t(toSubdiv.m_vrtxB) << 16u));
+                    subdiv.push_back(toSubdiv.m_fillOut.value);
+                }
+
+                rTrnGl.fillSubdiv   = Buffer{};
+                rTrnGl.fillBatches  = Buffer{};
+                rTrnGl.fillJobs     = Buffer{};
+                rTrnGl.fillSubdiv .setData(subdiv,                       Magnum::GL::BufferUsage::StaticDraw);
+                rTrnGl.fillBatches.setData(rChSP.lut->batch_offsets(),   Magnum::GL::BufferUsage::StaticDraw);
+            }
+            return;
+        }
+
+        // Afterwards, only upload ranges of chunks and shared vertices that changed
+        rTrnGl.uploadedBytes = 0;
+
+        auto const upload_pos = [&rTrnGl, &rChGeo] (std::size_t const first, std::size_t const count)
+        {
+            rTrnGl.vbufPos.setSubData(first * sizeof(Vector3), arrayView(&rChGeo.chunkVbufPos[first], count));
+            rTrnGl.uploadedBytes += count * sizeof(Vector3);
+        };
+
+        // Fill vertex positions of these chunks are calculated on the GPU instead
+        rTrnGl.fillBlocks.clear();
+        if (rTrnGl.gpuFill)
+        {
+            for (planeta::ChunkId const chunkId : rChSP.chunksToFill)
+            {
+                rTrnGl.fillBlocks.push_back(rChInfo.vbufFillOffset + std::size_t(chunkId.value) * rChInfo.fillVrtxCount);
+            }
+            std::sort(rTrnGl.fillBlocks.begin(), rTrnGl.fillBlocks.end());
+        }
+
+        for (planeta::ChunkBufferRange const range : rTerrain.chunkDirty.vbuf)
+        {
+            rTrnGl.vbufNrm.setSubData(range.first * sizeof(Vector3), arrayView(&rChGeo.chunkVbufNrm[range.first], range.count));
+            rTrnGl.uploadedBytes += range.count * sizeof(Vector3);
+
+            // Upload positions of the range, skipping over fill blocks
+            std::size_t       pos = range.first;
+            std::size_t const end = range.first + range.count;
+            auto itBlock = std::upper_bound(rTrnGl.fillBlocks.begin(), rTrnGl.fillBlocks.end(), pos);
+            if (itBlock != rTrnGl.fillBlocks.begin() && *std::prev(itBlock) + rChInfo.fillVrtxCount > pos)
+            {
+                --itBlock;
+            }
+            while (pos < end)
+            {
+                if (itBlock != rTrnGl.fillBlocks.end() && *itBlock < end)
+                {
+                    if (*itBlock > pos)
+                    {
+                        upload_pos(pos, *itBlock - pos);
+                    }
+                    pos = std::max(pos, *itBlock + rChInfo.fillVrtxCount);
+                    ++itBlock;
+                }
+                else
+                {
+                    upload_pos(pos, end - pos);
+                    pos = end;
+                }
+            }
+        }
+
+        if ( ! rChSP.chunksToFill.empty() && rTrnGl.gpuFill )
+        {
+            // Shared vertices uploaded above are the only inputs
+            planeta::ChunkSkeleton const &rSkCh = rTerrain.skChunks;
+            rTrnGl.jobs.clear();
+            for (planeta::ChunkId const chunkId : rChSP.chunksToFill)
+            {
+                rTrnGl.jobs.push_back(rChInfo.vbufFillOffset + std::uint32_t(chunkId.value) * rChInfo.fillVrtxCount);
+                for (planeta::SharedVrtxOwner_t const& shared : rSkCh.shared_vertices_used(chunkId))
+                {
+                    rTrnGl.jobs.push_back(rChInfo.vbufSharedOffset + shared.value().value);
+                }
+            }
+            rTrnGl.fillJobs.setData(rTrnGl.jobs, Magnum::GL::BufferUsage::StreamDraw);
+            rTrnGl.uploadedBytes += rTrnGl.jobs.size() * sizeof(std::uint32_t);
+
+            rTrnGl.fillShader
+                .setFillVertexCount (rChInfo.fillVrtxCount)
+                .setSharedCount     (rSkCh.m_chunkSharedCount)
+                .setBatchCount      (Magnum::UnsignedInt(rChSP.lut->batch_offsets().size() - 1))
+                .setRadius          (float(rTerrainIco.radius))
+                .bindBuffers        (rTrnGl.vbufPos, rTrnGl.fillSubdiv, rTrnGl.fillBatches, rTrnGl.fillJobs)
+                .fill               (Magnum::UnsignedInt(rChSP.chunksToFill.size()));
+        }
+        for (planeta::ChunkBufferRange const range : rTerrain.chunkDirty.ibuf)
+        {
+            rTrnGl.ibuf.setSubData(range.first * sizeof(Vector3u), arrayView(&rChGeo.chunkIbuf[range.first], range.count));
+            rTrnGl.uploadedBytes += range.count * sizeof(Vector3u);
+        }
+    });
+
+    rBuilder.task()
+        .name       ("Render terrain chunks")
+        .affinity   (TopTaskAffinity::Main)
+        .run_on     ({tgScnRdr.render(Run)})
+        .sync_with  ({tgMgnScn.fbo(EStgFBO::Draw), tgMgnScn.cmdFwd(Ready)})
+        .push_to    (out.m_tasks)
+        .args       ({      idRenderGl,                       idCmdFwd,               idDrawShPhong,                idTerrainDrawGl,          idRenderStats })
+        .func([] (RenderGL& rRenderGl, RenderCmdBuffer const& rCmdFwd, ACtxDrawPhong& rDrawPhong, TerrainDrawGL& rTrnGl, RenderStats& rRenderStats) noexcept
+    {
+        using Magnum::GL::Renderer;
+
+        if (rTrnGl.mesh.id() == 0)
+        {
+            return;
+        }
+
+        ViewProjMatrix const viewProj{rCmdFwd.m_view, rCmdFwd.m_proj, rCmdFwd.m_origin};
+
+        // Chunk positions are relative to the planet center, which is the scene origin
+        Renderer::enable(Renderer::Feature::DepthTest);
+        Renderer::disable(Renderer::Feature::Blending);
+        Renderer::setDepthMask(GL_TRUE);
+        Renderer::setDepthFunction(Renderer::DepthFunction::Less);
+
+        SysRenderGL::pass_begin(rRenderGl, ERenderPass::Terrain, rRenderStats);
+
+        PhongGL &rShader = rDrawPhong.shaderUntextured;
+        set_phong_lights(rShader, viewProj);
+        rShader
+            .setDiffuseColor(0x8c8c7aff_rgbaf)
+            .setTransformationMatrix(viewProj.m_view)
+            .setProjectionMatrix(viewProj.m_proj)
+            .setNormalMatrix(viewProj.m_view.normalMatrix());
+
+        if (rTrnGl.multiDraw)
+        {
+            // Culled and deleted chunks get no command at all, so they cost nothing. The index
+            // buffer is never modified for visibility.
+            Frustum const frustum = SysCulling::frustum_from_view_proj(viewProj.m_viewProj);
+
+            rTrnGl.cmds.clear();
+            for (planeta::ChunkId const chunkId : rTrnGl.drawChunks)
+            {
+                if (SysCulling::sphere_in_frustum(frustum, rTrnGl.chunkBounds[chunkId]))
+                {
+                    rTrnGl.cmds.push_back(DrawElementsIndirectGL{
+                        .count      = rTrnGl.chunkIndexCount,
+                        .firstIndex = std::uint32_t(chunkId.value) * rTrnGl.chunkIndexCount });
+                }
+            }
+            rTrnGl.chunksCulled = rTrnGl.drawChunks.size() - rTrnGl.cmds.size();
+
+            if ( ! rTrnGl.cmds.empty() )
+            {
+                rTrnGl.indirect.setData(rTrnGl.cmds, Magnum::GL::BufferUsage::StreamDraw);
+                SysRenderGL::multi_draw_indirect(rRenderGl, rShader, rTrnGl.mesh, rTrnGl.indirect,
+                                                 std::uint32_t(rTrnGl.cmds.size()),
+                                                 std::uint64_t(rTrnGl.cmds.size()) * (rTrnGl.chunkIndexCount / 3));
+            }
+        }
+        else
+        {
+            rShader.draw(rTrnGl.mesh);
+            SysRenderGL::count_draw(rRenderGl, rTrnGl.mesh);
+        }
+
+        SysRenderGL::pass_end(rRenderGl, ERenderPass::Terrain, rRenderStats);
+    });
+
+    return out;
+} // setup_terrain_draw_magnum
+
+
+Session setup_testplanets_draw_magnum(
+        TopTaskBuilder&             rBuilder,
+        ArrayView<entt::any> const  topData,
+        Session const&              windowApp,
+        Session const&              sceneRenderer,
+        Session const&              magnum,
+        Session const&              magnumScene,
+        Session const&              uniCore,
+        Session const&              uniScnFrame,
+        Session const&              uniTestPlanets)
+{
+    OSP_DECLARE_GET_DATA_IDS(magnum,         TESTAPP_DATA_MAGNUM);
+    OSP_DECLARE_GET_DATA_IDS(magnumScene,    TESTAPP_DATA_MAGNUM_SCENE);
+    OSP_DECLARE_GET_DATA_IDS(uniCore,        TESTAPP_DATA_UNI_CORE);
+    OSP_DECLARE_GET_DATA_IDS(uniScnFrame,    TESTAPP_DATA_UNI_SCENEFRAME);
+    OSP_DECLARE_GET_DATA_IDS(uniTestPlanets, TESTAPP_DATA_UNI_PLANETS);
+    auto const tgWin    = windowApp     .get_pipelines< PlWindowApp >();
+    auto const tgScnRdr = sceneRenderer .get_pipelines< PlSceneRenderer >();
+    auto const tgMgnScn = magnumScene   .get_pipelines< PlMagnumScene >();
+    auto const tgUSFrm  = uniScnFrame   .get_pipelines< PlUniSceneFrame >();
+
+    Session out;
+    auto const [idDrawSats] = out.acquire_data<1>(topData);
+    auto &rDrawSats = top_emplace< ACtxDrawSatellites >(topData, idDrawSats);
+
+    auto &rRenderGl = top_get< RenderGL >(topData, idRenderGl);
+    setup_satellite_shader(rDrawSats, &rRenderGl.m_programCache);
+
+    rBuilder.task()
+        .name       ("Render test planets as impostors")
+        .affinity   (TopTaskAffinity::Main)
+        .run_on     ({tgScnRdr.render(Run)})
+        .sync_with  ({tgMgnScn.fbo(EStgFBO::Draw), tgMgnScn.cmdFwd(Ready), tgUSFrm.sceneFrame(Modify)})
+        .push_to    (out.m_tasks)
+        .args       ({      idRenderGl,                       idCmdFwd,                    idDrawSats,          idUniverse,                  idScnFrame,               idPlanetMainSpace,             idRenderStats,                   idCoordCache })
+        .func([] (RenderGL& rRenderGl, RenderCmdBuffer const& rCmdFwd, ACtxDrawSatellites& rDrawSats, Universe& rUniverse, SceneFrame const& rScnFrame, CoSpaceId const planetMainSpace, RenderStats& rRenderStats, CoordTransformCache &rCoordCache) noexcept
+    {
+        CoSpaceCommon &rMainSpace = rUniverse.m_coordCommon[planetMainSpace];
+        auto const [x, y, z] = sat_views(rMainSpace.m_satPositions, rMainSpace.m_data, rMainSpace.m_satCount);
+
+        ViewProjMatrix const viewProj{rCmdFwd.m_view, rCmdFwd.m_proj, rCmdFwd.m_origin};
+
+        // Same size the planet DrawEnts used to be scaled to
+        write_satellite_instances(rDrawSats, testplanets_main_to_scene(rCoordCache, rUniverse, planetMainSpace, rScnFrame),
+                                  x, y, z, rScnFrame.m_precision, viewProj.m_origin, {}, {}, 200.0f);
+
+        SysRenderGL::pass_begin(rRenderGl, ERenderPass::Satellites, rRenderStats);
+        draw_satellites(rDrawSats, rRenderGl, viewProj, rRenderGl.m_renderScale.m_renderedSize.y());
+        SysRenderGL::pass_end(rRenderGl, ERenderPass::Satellites, rRenderStats);
+    });
+
+    rBuilder.task()
+        .name       ("Clean up satellite impostors")
+        .affinity   (TopTaskAffinity::Main)
+        .run_on     ({tgWin.cleanup(Run_)})
+        .push_to    (out.m_tasks)
+        .args       ({                idDrawSats })
+        .func([] (ACtxDrawSatellites& rDrawSats) noexcept
+    {
+        rDrawSats = {}; // Needs the OpenGL thread for destruction
+    });
+
+    return out;
+} // setup_testplanets_draw_magnum
+
+
+Session setup_testplanets_trails_magnum(
+        TopTaskBuilder&             rBuilder,
+        ArrayView<entt::any> const  topData,
+        Session const&              windowApp,
+        Session const&              sceneRenderer,
+        Session const&              magnum,
+        Session const&              magnumScene,
+        Session const&              uniCore,
+        Session const&              uniScnFrame,
+        Session const&              uniTestPlanets)
+{
+    OSP_DECLARE_GET_DATA_IDS(magnum,         TESTAPP_DATA_MAGNUM);
+    OSP_DECLARE_GET_DATA_IDS(magnumScene,    TESTAPP_DATA_MAGNUM_SCENE);
+    OSP_DECLARE_GET_DATA_IDS(uniCore,        TESTAPP_DATA_UNI_CORE);
+    OSP_DECLARE_GET_DATA_IDS(uniScnFrame,    TESTAPP_DATA_UNI_SCENEFRAME);
+    OSP_DECLARE_GET_DATA_IDS(uniTestPlanets, TESTAPP_DATA_UNI_PLANETS);
+    auto const tgWin    = windowApp     .get_pipelines< PlWindowApp >();
+    auto const tgScnRdr = sceneRenderer .get_pipelines< PlSceneRenderer >();
+    auto const tgMgnScn = magnumScene   .get_pipelines< PlMagnumScene >();
+    auto const tgUCore  = uniCore       .get_pipelines< PlUniCore >();
+    auto const tgUSFrm  = uniScnFrame   .get_pipelines< PlUniSceneFrame >();
+
+    Session out;
+    auto const [idDrawTrails] = out.acquire_data<1>(topData);
+    auto &rDrawTrails = top_emplace< ACtxDrawOrbitTrails >(topData, idDrawTrails);
+
+    auto &rRenderGl = top_get< RenderGL >(topData, idRenderGl);
+    setup_orbit_trail_shader(rDrawTrails, 512, &rRenderGl.m_programCache);
+
+    rBuilder.task()
+        .name       ("Append test planet positions to orbit trails")
+        .affinity   (TopTaskAffinity::Main)
+        .run_on     ({tgWin.sync(Run)})
+        .sync_with  ({tgUCore.update(Done)})
+        .push_to    (out.m_tasks)
+        .args       ({               idDrawTrails,          idUniverse,                  idPlanetMainSpace })
+        .func([] (ACtxDrawOrbitTrails& rDrawTrails, Universe& rUniverse, CoSpaceId const planetMainSpace) noexcept
+    {
+        CoSpaceCommon &rMainSpace = rUniverse.m_coordCommon[planetMainSpace];
+        auto const [x, y, z] = sat_views(rMainSpace.m_satPositions, rMainSpace.m_data, rMainSpace.m_satCount);
+
+        append_orbit_trail_samples(rDrawTrails, x, y, z, rMainSpace.m_precision);
+    });
+
+    rBuilder.task()
+        .name       ("Render test planet orbit trails")
+        .affinity   (TopTaskAffinity::Main)
+        .run_on     ({tgScnRdr.render(Run)})
+        .sync_with  ({tgMgnScn.fbo(EStgFBO::Draw), tgMgnScn.cmdFwd(Ready), tgUSFrm.sceneFrame(Modify)})
+        .push_to    (out.m_tasks)
+        .args       ({      idRenderGl,                       idCmdFwd,                     idDrawTrails,          idUniverse,                  idScnFrame,               idPlanetMainSpace,             idRenderStats,                   idCoordCache })
+        .func([] (RenderGL& rRenderGl, RenderCmdBuffer const& rCmdFwd, ACtxDrawOrbitTrails& rDrawTrails, Universe& rUniverse, SceneFrame const& rScnFrame, CoSpaceId const planetMainSpace, RenderStats& rRenderStats, CoordTransformCache &rCoordCache) noexcept
+    {
+        ViewProjMatrix const viewProj{rCmdFwd.m_view, rCmdFwd.m_proj, rCmdFwd.m_origin};
+
+        SysRenderGL::pass_begin(rRenderGl, ERenderPass::OrbitTrails, rRenderStats);
+        draw_orbit_trails(rDrawTrails, rRenderGl, viewProj, testplanets_main_to_scene(rCoordCache, rUniverse, planetMainSpace, rScnFrame),
+                          rScnFrame.m_precision);
+        SysRenderGL::pass_end(rRenderGl, ERenderPass::OrbitTrails, rRenderStats);
+    });
+
+    rBuilder.task()
+        .name       ("Clean up orbit trails")
+        .affinity   (TopTaskAffinity::Main)
+        .run_on     ({tgWin.cleanup(Run_)})
+        .push_to    (out.m_tasks)
+        .args       ({                 idDrawTrails })
+        .func([] (ACtxDrawOrbitTrails& rDrawTrails) noexcept
+    {
+        rDrawTrails = {}; // Needs the OpenGL thread for destruction
+    });
+
+    return out;
+} // setup_testplanets_trails_magnum
+
+
+struct NBodyComputeGL
+{
+    adera::shader::NBodyShader  shader      {Corrade::NoCreate};
+    Magnum::GL::Buffer          bodies      {Corrade::NoCreate};
+    Magnum::GL::Buffer          accel       {Corrade::NoCreate};
+    Magnum::GL::Buffer          readback    {Corrade::NoCreate};
+
+    /// Signaled once accelerations of pendingStep are copied into readback
+    GLsync                      fence       {nullptr};
+    std::uint64_t               pendingStep {0};
+    std::size_t                 pendingCount{0};
+
+    /// Bodies that accel and readback are allocated for
+    std::size_t                 capacity    {0};
+};
+
+Session setup_nbody_compute_magnum(
+        TopTaskBuilder&             rBuilder,
+        ArrayView<entt::any> const  topData,
+        Session const&              windowApp,
+        Session const&              magnum,
+        Session const&              uniCore,
+        Session const&              solarSystemPlanets)
+{
+    OSP_DECLARE_GET_DATA_IDS(magnum,             TESTAPP_DATA_MAGNUM);
+    OSP_DECLARE_GET_DATA_IDS(solarSystemPlanets, TESTAPP_DATA_SOLAR_SYSTEM_PLANETS);
+    auto const tgWin    = windowApp .get_pipelines< PlWindowApp >();
+    auto const tgUCore  = uniCore   .get_pipelines< PlUniCore >();
+
+    Session out;
+
+    if ( ! Magnum::GL::Context::current().isVersionSupported(Magnum::GL::Version::GL430) )
+    {
+        return out; // Accelerations stay on the CPU
+    }
+
+    auto const [idNBodyGl] = out.acquire_data<1>(topData);
+    auto &rNBodyGl = top_emplace< NBodyComputeGL >(topData, idNBodyGl);
+
+    auto &rRenderGl     = top_get< RenderGL >(topData, idRenderGl);
+    rNBodyGl.shader     = adera::shader::NBodyShader{&rRenderGl.m_programCache};
+
+    auto const  mainSpace   = top_get< CoSpaceId >(topData, idPlanetMainSpace);
+    auto        &rCoordNBody = top_get< osp::KeyedVec<CoSpaceId, CoSpaceNBody> >(topData, idCoordNBody);
+    rCoordNBody[mainSpace].scratch.offload.enabled = true;
+
+    // Read back before the universe update so it can use them this frame, one step late
+    rBuilder.task()
+        .name       ("Read back N-body accelerations from the GPU")
+        .affinity   (TopTaskAffinity::Main)
+        .run_on     ({tgWin.inputs(Run)})
+        .sync_with  ({tgUCore.update(ModifyOrSignal)})
+        .push_to    (out.m_tasks)
+        .args       ({             idPlanetMainSpace,                                        idCoordNBody,                idNBodyGl })
+        .func([] (CoSpaceId const mainSpace, osp::KeyedVec<CoSpaceId, CoSpaceNBody>& rCoordNBody, NBodyComputeGL& rNBodyGl) noexcept
+    {
+        if (rNBodyGl.fence == nullptr)
+        {
+            return;
+        }
+
+        // Don't wait, try again next frame if the GPU isn't done
+        GLenum const status = glClientWaitSync(rNBodyGl.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        if (status == GL_TIMEOUT_EXPIRED)
+        {
+            return;
+        }
+        glDeleteSync(std::exchange(rNBodyGl.fence, nullptr));
+        if (status == GL_WAIT_FAILED)
+        {
+            return;
+        }
+
+        NBodyOffload &rOffload = rCoordNBody[mainSpace].scratch.offload;
+
+        std::size_t const floats = rNBodyGl.pendingCount * 4;
+        Corrade::Containers::ArrayView<char> const mapped
+                = rNBodyGl.readback.map(0, GLsizeiptr(floats * sizeof(float)), Magnum::GL::Buffer::MapFlag::Read);
+        if (mapped.data() == nullptr)
+        {
+            return;
+        }
+
+        rOffload.accel.resize(floats);
+        std::memcpy(rOffload.accel.data(), mapped.data(), floats * sizeof(float));
+        rNBodyGl.readback.unmap();
+
+        rOffload.accelStep  = rNBodyGl.pendingStep;
+        rOffload.accelCount = rNBodyGl.pendingCount;
+        rOffload.accelValid = true;
+    });
+
+    rBuilder.task()
+        .name       ("Dispatch N-body acceleration compute shader")
+        .affinity   (TopTaskAffinity::Main)
+        .run_on     ({tgWin.sync(Run)})
+        .sync_with  ({tgUCore.update(Done)})
+        .push_to    (out.m_tasks)
+        .args       ({             idPlanetMainSpace,                                        idCoordNBody,                idNBodyGl })
+        .func([] (CoSpaceId const mainSpace, osp::KeyedVec<CoSpaceId, CoSpaceNBody>& rCoordNBody, NBodyComputeGL& rNBodyGl) noexcept
+    {
+        using Magnum::GL::Buffer;
+        using Magnum::GL::BufferUsage;
+
+        CoSpaceNBody const  &rNBody     = rCoordNBody[mainSpace];
+        NBodyOffload const  &rOffload   = rNBody.scratch.offload;
+        std::size_t const   count       = rOffload.bodies.size() / 4;
+
+        // One calculation in flight at a time, and only for new positions
+        if (rNBodyGl.fence != nullptr || rOffload.step == rNBodyGl.pendingStep || count == 0)
+        {
+            return;
+        }
+
+        GLsizeiptr const bytes = GLsizeiptr(count * 4 * sizeof(float));
+        if (count > rNBodyGl.capacity)
+        {
+            rNBodyGl.bodies     = Buffer{};
+            rNBodyGl.accel      = Buffer{};
+            rNBodyGl.readback   = Buffer{};
+            rNBodyGl.accel   .setData({nullptr, std::size_t(bytes)}, BufferUsage::DynamicCopy);
+            rNBodyGl.readback.setData({nullptr, std::size_t(bytes)}, BufferUsage::StreamRead);
+            rNBodyGl.capacity = count;
+        }
+        rNBodyGl.bodies.setData(rOffload.bodies, BufferUsage::StreamDraw);
+
+        rNBodyGl.shader
+            .setGravConstant(float(rNBody.params.gravConstant))
+            .setSoftening   (float(rNBody.params.softening))
+            .bindBuffers    (rNBodyGl.bodies, rNBodyGl.accel)
+            .calculate      (Magnum::UnsignedInt(count));
+
+        // Copy into a separate buffer, so mapping it later doesn't stall on the shader
+        Buffer::copy(rNBodyGl.accel, rNBodyGl.readback, 0, 0, bytes);
+        rNBodyGl.fence          = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        rNBodyGl.pendingStep    = rOffload.step;
+        rNBodyGl.pendingCount   = count;
+    });
+
+    rBuilder.task()
+        .name       ("Clean up N-body compute")
+        .affinity   (TopTaskAffinity::Main)
+        .run_on     ({tgWin.cleanup(Run_)})
+        .push_to    (out.m_tasks)
+        .args       ({             idPlanetMainSpace,                                        idCoordNBody,                idNBodyGl })
+        .func([] (CoSpaceId const mainSpace, osp::KeyedVec<CoSpaceId, CoSpaceNBody>& rCoordNBody, NBodyComputeGL& rNBodyGl) noexcept
+    {
+        // Back to the CPU once the window closes
+        NBodyOffload &rOffload = rCoordNBody[mainSpace].scratch.offload;
+        rOffload.enabled    = false;
+        rOffload.accelValid = false;
+
+        if (rNBodyGl.fence != nullptr)
+        {
+            glDeleteSync(rNBodyGl.fence);
+        }
+        rNBodyGl = {}; // Needs the OpenGL thread for destruction
+    });
+
+    return out;
+} // setup_nbody_compute_magnum
+
+
+
 } // namespace testapp::scenes
@@ -77,6 +77,19 @@ osp::Session setup_shader_flat(
         osp::Session const&         magnumScene,
         osp::draw::MaterialId       materialId = lgrn::id_null<osp::draw::MaterialId>());
 
+/**
+ * @brief Instanced exhaust plume shader and material for drawing plumes of setup_rocket_plumes
+ */
+osp::Session setup_shader_plume(
+        osp::TopTaskBuilder&        rBuilder,
+        osp::ArrayView<entt::any>   topData,
+        osp::Session const&         windowApp,
+        osp::Session const&         sceneRenderer,
+        osp::Session const&         magnum,
+        osp::Session const&         magnumScene,
+        osp::Session const&         rocketPlumes,
+        osp::draw::MaterialId       materialId);
+
 /**
  * @brief Magnum Phong shader and optional material for drawing ActiveEnts with it
  */
@@ -89,4 +102,71 @@ osp::Session setup_shader_phong(
         osp::Session const&         magnumScene,
         osp::draw::MaterialId       materialId = lgrn::id_null<osp::draw::MaterialId>());
 
+/**
+ * @brief Upload terrain chunk meshes of a terrain session with partial updates and draw them
+ *        with the Phong shader
+ *
+ * Fill vertex positions of newly calculated chunks are recalculated by a compute shader instead
+ * of being uploaded if OpenGL 4.3 is available. With 4.3, chunks outside of the view are also
+ * culled individually, and the rest are drawn with a single multi-draw-indirect call.
+ */
+osp::Session setup_terrain_draw_magnum(
+        osp::TopTaskBuilder&        rBuilder,
+        osp::ArrayView<entt::any>   topData,
+        osp::Session const&         windowApp,
+        osp::Session const&         sceneRenderer,
+        osp::Session const&         magnum,
+        osp::Session const&         magnumScene,
+        osp::Session const&         shPhong,
+        osp::Session const&         terrain,
+        osp::Session const&         terrainIco);
+
+/**
+ * @brief Draw the planets of setup_uni_testplanets as sphere impostors with one instanced draw
+ *        call, with no DrawEnt per planet
+ */
+osp::Session setup_testplanets_draw_magnum(
+        osp::TopTaskBuilder&        rBuilder,
+        osp::ArrayView<entt::any>   topData,
+        osp::Session const&         windowApp,
+        osp::Session const&         sceneRenderer,
+        osp::Session const&         magnum,
+        osp::Session const&         magnumScene,
+        osp::Session const&         uniCore,
+        osp::Session const&         uniScnFrame,
+        osp::Session const&         uniTestPlanets);
+
+/**
+ * @brief Draw a fading trail of past positions behind each planet of setup_uni_testplanets
+ *
+ * Positions are appended to a GPU ring buffer once per universe update, so the cost per update
+ * doesn't depend on trail length. All trails are drawn with one instanced draw call.
+ */
+osp::Session setup_testplanets_trails_magnum(
+        osp::TopTaskBuilder&        rBuilder,
+        osp::ArrayView<entt::any>   topData,
+        osp::Session const&         windowApp,
+        osp::Session const&         sceneRenderer,
+        osp::Session const&         magnum,
+        osp::Session const&         magnumScene,
+        osp::Session const&         uniCore,
+        osp::Session const&         uniScnFrame,
+        osp::Session const&         uniTestPlanets);
+
+/**
+ * @brief Calculate N-body accelerations of setup_solar_system_testplanets with a compute shader
+ *
+ * Positions written by nbody_step are uploaded after the universe update, and accelerations are
+ * read back without waiting before the next one, so they're used one step late. nbody_step
+ * calculates them on the CPU if they aren't ready in time. Does nothing if OpenGL 4.3 isn't
+ * available.
+ */
+osp::Session setup_nbody_compute_magnum(
+        osp::TopTaskBuilder&        rBuilder,
+        osp::ArrayView<entt::any>   topData,
+        osp::Session const&         windowApp,
+        osp::Session const&         magnum,
+        osp::Session const&         uniCore,
+        osp::Session const&         solarSystemPlanets);
+
 }
@@ -25,11 +25,14 @@
 #include "misc.h"
 #include "physics.h"
 
+#include "../MagnumApplication.h"
+
 #include <adera/drawing/CameraController.h>
 #include <osp/activescene/basic_fn.h>
 #include <osp/core/Resources.h>
 #include <osp/core/unpack.h>
 #include <osp/drawing/drawing_fn.h>
+#include <osp/drawing/render_commands.h>
 
 
 using namespace adera;
@@ -69,9 +72,11 @@ Session setup_camera_ctrl(
         ArrayView<entt::any> const  topData,
         Session const&              windowApp,
         Session const&              sceneRenderer,
+        Session const&              magnum,
         Session const&              magnumScene)
 {
     OSP_DECLARE_GET_DATA_IDS(windowApp,     TESTAPP_DATA_WINDOW_APP);
+    OSP_DECLARE_GET_DATA_IDS(magnum,        TESTAPP_DATA_MAGNUM);
     OSP_DECLARE_GET_DATA_IDS(magnumScene,   TESTAPP_DATA_MAGNUM_SCENE);
     auto const tgScnRdr = sceneRenderer .get_pipelines<PlSceneRenderer>();
     auto const tgSR     = magnumScene   .get_pipelines<PlMagnumScene>();
@@ -85,6 +90,9 @@ Session setup_camera_ctrl(
 
     top_emplace< ACtxCameraController > (topData, idCamCtrl, rUserInput);
 
+    // Covers a few degrees of turning between culling and late latching
+    top_get< Camera >(topData, idCamera).m_cullMargin = Deg{5.0f};
+
     rBuilder.pipeline(tgCmCt.camCtrl).parent(tgWin.sync);
 
     rBuilder.task()
@@ -98,6 +106,23 @@ Session setup_camera_ctrl(
         rCamera.m_transform = rCamCtrl.m_transform;
     });
 
+    rBuilder.task()
+        .name       ("Late-latch rendered view to input that arrived during the frame")
+        .affinity   (TopTaskAffinity::Main)
+        .run_on     ({tgScnRdr.render(Run)})
+        .sync_with  ({tgCmCt.camCtrl(Ready), tgSR.cmdFwd(Modify)})
+        .push_to    (out.m_tasks)
+        .args       ({                  idActiveApp,                            idCamCtrl,                 idCmdFwd })
+        .func([] (MagnumApplication& rActiveApp, ACtxCameraController const& rCamCtrl, RenderCmdBuffer& rCmdFwd) noexcept
+    {
+        // Commands are already culled and sorted; only the view they're drawn with changes
+        MagnumApplication::LatchedInput const latched = rActiveApp.latch_input();
+        Matrix4 const transform = SysCameraController::latched_transform(rCamCtrl, latched.mouseDelta, latched.elapsed);
+
+        rCmdFwd.m_view   = transform.inverted();
+        rCmdFwd.m_origin = transform.translation();
+    });
+
     return out;
 } // setup_camera_ctrl
 
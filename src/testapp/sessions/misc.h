@@ -39,12 +39,16 @@ void create_materials(
 
 /**
  * @brief Create CameraController connected to an app's UserInputHandler
+ *
+ * The rendered view is late-latched to input that arrives while the frame is being prepared, see
+ * MagnumApplication::latch_input.
  */
 osp::Session setup_camera_ctrl(
         osp::TopTaskBuilder&        rBuilder,
         osp::ArrayView<entt::any>   topData,
         osp::Session const&         windowApp,
         osp::Session const&         sceneRenderer,
+        osp::Session const&         magnum,
         osp::Session const&         magnumScene);
 
 /**
@@ -71,7 +71,8 @@ Session setup_newton(
 
     rBuilder.pipeline(tgNwt.nwtBody).parent(tgScn.update);
 
-    top_emplace< ACtxNwtWorld >(topData, idNwt, 2);
+    // Solve on all but one hardware thread
+    top_emplace< ACtxNwtWorld >(topData, idNwt, -1);
 
     using ospnewton::SysNewton;
 
@@ -86,18 +87,29 @@ Session setup_newton(
         SysNewton::update_delete (rNwt, rActiveEntDel.cbegin(), rActiveEntDel.cend());
     });
 
+    // Transforms, drawing, and rendering all wait on the physics step
     rBuilder.task()
         .name       ("Update Newton world")
+        .priority   (1)
         .run_on     ({tgScn.update(Run)})
-        .sync_with  ({tgNwt.nwtBody(Prev), tgCS.hierarchy(Prev), tgPhy.physBody(Prev), tgPhy.physUpdate(Run), tgCS.transform(Prev)})
+        .sync_with  ({tgNwt.nwtBody(Prev), tgCS.hierarchy(Prev), tgPhy.physBody(Prev), tgPhy.physUpdate(Run), tgCS.transform(Prev), tgPhy.contacts(Modify_)})
         .push_to    (out.m_tasks)
         .args({             idBasic,             idPhys,              idNwt,           idDeltaTimeIn })
         .func([] (ACtxBasic& rBasic, ACtxPhysics& rPhys, ACtxNwtWorld& rNwt, float const deltaTimeIn, WorkerContext ctx) noexcept
     {
-        SysNewton::update_world(rPhys, rNwt, deltaTimeIn, rBasic.m_scnGraph, rBasic.m_transform);
+        SysNewton::update_world(rPhys, rNwt, deltaTimeIn, rBasic.m_scnGraph, rBasic.m_transform, &rBasic.m_scnGraph.m_transformDirty);
     });
 
-    top_emplace< ACtxNwtWorld >(topData, idNwt, 2);
+    rBuilder.task()
+        .name       ("Cast rays with Newton")
+        .run_on     ({tgScn.update(Run)})
+        .sync_with  ({tgPhy.raycast(Modify), tgNwt.nwtBody(Ready), tgPhy.physBody(Ready), tgCS.transform(Ready)})
+        .push_to    (out.m_tasks)
+        .args({             idPhys,              idNwt })
+        .func([] (ACtxPhysics& rPhys, ACtxNwtWorld& rNwt) noexcept
+    {
+        SysNewton::update_raycasts(rNwt, rPhys.m_rays);
+    });
 
     return out;
 } // setup_newton
@@ -142,14 +154,14 @@ osp::Session setup_newton_force_accel(
 
     ACtxNwtWorld::ForceFactorFunc const factor
     {
-        .m_func = [] (NewtonBody const* pBody, BodyId const bodyID, ACtxNwtWorld const& rNwt, UserData_t data, Vector3& rForce, Vector3& rTorque) noexcept
+        .m_batchFunc = [] (ForceFactorBatch const& batch, ACtxNwtWorld const& rNwt, UserData_t data) noexcept
         {
-            float mass = 0.0f;
-            float dummy = 0.0f;
-            NewtonBodyGetMass(pBody, &mass, &dummy, &dummy, &dummy);
+            auto const& accel = *reinterpret_cast<Vector3 const*>(data[0]);
 
-            auto const& force = *reinterpret_cast<Vector3 const*>(data[0]);
-            rForce += force * mass;
+            for (std::uint32_t const index : batch.m_indices)
+            {
+                batch.m_forces[index] += accel * batch.m_masses[index];
+            }
         },
         .m_userData = {&rAccel}
     };
@@ -198,6 +210,8 @@ Session setup_phys_shapes_newton(
         .args({                   idBasic,                idPhysShapes,             idPhys,              idNwt,              idNwtFactors })
         .func([] (ACtxBasic const &rBasic, ACtxPhysShapes& rPhysShapes, ACtxPhysics& rPhys, ACtxNwtWorld& rNwt, ForceFactors_t nwtFactors) noexcept
     {
+        LGRN_ASSERTM(!rPhysShapes.m_pooling, "Shape pooling is not supported with Newton");
+
         for (std::size_t i = 0; i < rPhysShapes.m_spawnRequest.size(); ++i)
         {
             SpawnShape const &spawn = rPhysShapes.m_spawnRequest[i];
@@ -213,9 +227,8 @@ Session setup_phys_shapes_newton(
 
             rNwt.m_bodyPtrs[bodyId].reset(pBody);
 
-            rNwt.m_bodyToEnt[bodyId]    = root;
+            SysNewton::set_body_ent(rNwt, bodyId, root);
             rNwt.m_bodyFactors[bodyId]  = nwtFactors;
-            rNwt.m_entToBody.emplace(root, bodyId);
 
             Vector3 const inertia = collider_inertia_tensor(spawn.m_shape, spawn.m_size, spawn.m_mass);
 
@@ -374,7 +387,8 @@ Session setup_vehicle_spawn_newton(
 
                 rBasic.m_transform.emplace(weldEnt, Matrix4::from(toInit.rotation.toMatrix(), toInit.position));
 
-                SubtreeBuilder bldRoot = SysSceneGraph::add_descendants(rBasic.m_scnGraph, entCount + 1);
+                // Batched, since adding one subtree at a time shifts the whole tree for each weld
+                SubtreeBuilder bldRoot = SysSceneGraph::batch_add_descendants(rBasic.m_scnGraph, rBasic.m_scnGraphBatch, entCount + 1);
                 SubtreeBuilder bldWeld = bldRoot.add_child(weldEnt, entCount);
 
                 for (PartId const part : rScnParts.weldToParts[weld])
@@ -390,6 +404,8 @@ Session setup_vehicle_spawn_newton(
 
             itWeldOffsets = itWeldOffsetsNext;
         }
+
+        SysSceneGraph::batch_apply(rBasic.m_scnGraph, rBasic.m_scnGraphBatch);
     });
 
     rBuilder.task()
@@ -438,9 +454,8 @@ Session setup_vehicle_spawn_newton(
 
 
                 rNwt.m_bodyPtrs[bodyId].reset(pBody);
-                rNwt.m_bodyToEnt[bodyId] = weldEnt;
+                SysNewton::set_body_ent(rNwt, bodyId, weldEnt);
                 rNwt.m_bodyFactors[bodyId] = {1}; // TODO: temporary
-                rNwt.m_entToBody.emplace(weldEnt, bodyId);
 
                 float   totalMass = 0.0f;
                 Vector3 massPos{0.0f};
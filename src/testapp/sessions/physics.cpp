@@ -64,6 +64,8 @@ Session setup_physics(
 
     rBuilder.pipeline(tgPhy.physBody)  .parent(tgScn.update);
     rBuilder.pipeline(tgPhy.physUpdate).parent(tgScn.update);
+    rBuilder.pipeline(tgPhy.raycast)   .parent(tgScn.update);
+    rBuilder.pipeline(tgPhy.contacts)  .parent(tgScn.update);
 
     top_emplace< ACtxPhysics >  (topData, idPhys);
 
@@ -78,6 +80,30 @@ Session setup_physics(
         SysPhysics::update_delete_phys(rPhys, rActiveEntDel.cbegin(), rActiveEntDel.cend());
     });
 
+    rBuilder.task()
+        .name       ("Clear last frame's raycasts")
+        .cheap      ()
+        .run_on     ({tgScn.update(Run)})
+        .sync_with  ({tgPhy.raycast(Delete)})
+        .push_to    (out.m_tasks)
+        .args       ({        idPhys })
+        .func([] (ACtxPhysics& rPhys) noexcept
+    {
+        SysPhysics::raycast_clear(rPhys.m_rays);
+    });
+
+    rBuilder.task()
+        .name       ("Clear physics contacts")
+        .cheap      ()
+        .run_on     ({tgScn.update(Run)})
+        .sync_with  ({tgPhy.contacts(Clear)})
+        .push_to    (out.m_tasks)
+        .args       ({        idPhys })
+        .func([] (ACtxPhysics& rPhys) noexcept
+    {
+        rPhys.m_contacts.clear();
+    });
+
     return out;
 } // setup_physics
 
@@ -111,6 +137,7 @@ Session setup_prefabs(
     rBuilder.pipeline(tgPf.inSubtree)   .parent(tgScn.update);
 
     top_emplace< ACtxPrefabs > (topData, idPrefabs);
+    top_emplace< FrameArena >  (topData, idPrefabArena);
 
     rBuilder.task()
         .name       ("Schedule Prefab spawn")
@@ -128,10 +155,10 @@ Session setup_prefabs(
         .run_on     ({tgPf.spawnRequest(UseOrRun)})
         .sync_with  ({tgCS.activeEnt(New), tgCS.activeEntResized(Schedule), tgPf.spawnedEnts(Resize)})
         .push_to    (out.m_tasks)
-        .args       ({        idPrefabs,           idBasic,           idResources})
-        .func([] (ACtxPrefabs& rPrefabs, ACtxBasic& rBasic, Resources& rResources) noexcept
+        .args       ({        idPrefabs,           idBasic,           idResources,            idPrefabArena})
+        .func([] (ACtxPrefabs& rPrefabs, ACtxBasic& rBasic, Resources& rResources, FrameArena& rArena) noexcept
     {
-        SysPrefabInit::create_activeents(rPrefabs, rBasic, rResources);
+        SysPrefabInit::create_activeents(rPrefabs, rBasic, rResources, rArena);
     });
 
     rBuilder.task()
@@ -173,13 +200,32 @@ Session setup_prefabs(
     });
 
     rBuilder.task()
-        .name       ("Clear Prefab vector")
+        .name       ("Delete Prefab instance info of deleted ActiveEnts")
+        .run_on     ({tgCS.activeEntDelete(UseOrRun)})
+        .sync_with  ({tgPf.instanceInfo(Delete)})
+        .push_to    (out.m_tasks)
+        .args       ({        idPrefabs,                      idActiveEntDel })
+        .func([] (ACtxPrefabs& rPrefabs, ActiveEntVec_t const& rActiveEntDel) noexcept
+    {
+        for (ActiveEnt const ent : rActiveEntDel)
+        {
+            if (std::size_t(ent) < rPrefabs.instanceInfo.size())
+            {
+                rPrefabs.instanceInfo[ent] = PrefabInstanceInfo{.prefab = lgrn::id_null<PrefabId>()};
+                rPrefabs.roots.erase(ent);
+            }
+        }
+    });
+
+    rBuilder.task()
+        .name       ("Clear Prefab requests and reset arena")
+        .cheap      ()
         .run_on     ({tgPf.spawnRequest(Clear)})
         .push_to    (out.m_tasks)
-        .args       ({        idPrefabs})
-        .func([] (ACtxPrefabs& rPrefabs) noexcept
+        .args       ({        idPrefabs,            idPrefabArena})
+        .func([] (ACtxPrefabs& rPrefabs, FrameArena& rArena) noexcept
     {
-        rPrefabs.spawnRequest.clear();
+        SysPrefabInit::clear_requests(rPrefabs, rArena);
     });
 
     return out;
@@ -29,9 +29,13 @@
 
 #include <osp/activescene/basic.h>
 #include <osp/activescene/physics_fn.h>
+#include <osp/activescene/region_trigger_fn.h>
+#include <osp/core/bitvector.h>
 #include <osp/drawing/drawing_fn.h>
 #include <osp/drawing/prefab_draw.h>
 
+#include <algorithm>
+#include <limits>
 #include <random>
 
 using namespace adera;
@@ -41,6 +45,30 @@ using namespace osp::draw;
 
 using osp::input::EButtonControlIndex;
 
+/**
+ * @brief Local bounds of the unit meshes in NamedMeshes::m_shapeToMesh, which span -1 to 1
+ */
+static BoundingSphere shape_mesh_bounds(EShape const shape) noexcept
+{
+    switch (shape)
+    {
+    case EShape::Sphere:    return {{}, 1.0f};
+    case EShape::Box:       return {{}, Magnum::Constants::sqrt3()};
+    case EShape::Cylinder:  return {{}, Magnum::Constants::sqrt2()};
+    case EShape::Capsule:   return {{}, 2.0f};
+    default:                return {};
+    }
+}
+
+/**
+ * @return True if a pooled shape can be reused for a spawn request without changing its
+ *         collider or mass
+ */
+static bool is_same_kind(PooledShape const& pooled, SpawnShape const& spawn) noexcept
+{
+    return pooled.m_shape == spawn.m_shape && pooled.m_mass == spawn.m_mass && pooled.m_size == spawn.m_size;
+}
+
 namespace testapp::scenes
 {
 
@@ -101,6 +129,7 @@ Session setup_phys_shapes(
     rBuilder.pipeline(tgShSp.spawnRequest)  .parent(tgScn.update);
     rBuilder.pipeline(tgShSp.spawnedEnts)   .parent(tgScn.update);
     rBuilder.pipeline(tgShSp.ownedEnts)     .parent(tgScn.update);
+    rBuilder.pipeline(tgShSp.parkRequest)   .parent(tgScn.update);
 
     top_emplace< ACtxPhysShapes > (topData, idPhysShapes, ACtxPhysShapes{ .m_materialId = materialId });
 
@@ -125,8 +154,38 @@ Session setup_phys_shapes(
     {
         LGRN_ASSERTM(!rPhysShapes.m_spawnRequest.empty(), "spawnRequest Use_ shouldn't run if rPhysShapes.m_spawnRequest is empty!");
 
-        rPhysShapes.m_ents.resize(rPhysShapes.m_spawnRequest.size() * 2);
-        rBasic.m_activeIds.create(rPhysShapes.m_ents.begin(), rPhysShapes.m_ents.end());
+        std::size_t const count = rPhysShapes.m_spawnRequest.size();
+        rPhysShapes.m_ents.resize(count * 2);
+        rPhysShapes.m_reused.assign(count, 0);
+
+        if ( ! rPhysShapes.m_pooling )
+        {
+            rBasic.m_activeIds.create(rPhysShapes.m_ents.begin(), rPhysShapes.m_ents.end());
+            return;
+        }
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            SpawnShape const &spawn = rPhysShapes.m_spawnRequest[i];
+
+            auto const itPooled = std::find_if(rPhysShapes.m_pool.begin(), rPhysShapes.m_pool.end(),
+                                               [&spawn] (PooledShape const& pooled) { return is_same_kind(pooled, spawn); });
+            if (itPooled != rPhysShapes.m_pool.end())
+            {
+                rPhysShapes.m_ents[i * 2]       = itPooled->m_root;
+                rPhysShapes.m_ents[i * 2 + 1]   = itPooled->m_child;
+                rPhysShapes.m_reused[i]         = 1;
+                rPhysShapes.m_parked.erase(itPooled->m_root);
+
+                *itPooled = rPhysShapes.m_pool.back();
+                rPhysShapes.m_pool.pop_back();
+            }
+            else
+            {
+                rPhysShapes.m_ents[i * 2]       = rBasic.m_activeIds.create();
+                rPhysShapes.m_ents[i * 2 + 1]   = rBasic.m_activeIds.create();
+            }
+        }
     });
 
     rBuilder.task()
@@ -137,10 +196,17 @@ Session setup_phys_shapes(
         .args       ({      idBasic,                idPhysShapes })
         .func([] (ACtxBasic& rBasic, ACtxPhysShapes& rPhysShapes) noexcept
     {
-        rPhysShapes.ownedEnts.resize(rBasic.m_activeIds.capacity());
-        rBasic.m_scnGraph.resize(rBasic.m_activeIds.capacity());
+        std::size_t const capacity = rBasic.m_activeIds.capacity();
+        rPhysShapes.ownedEnts.resize(capacity);
+        rBasic.m_scnGraph.resize(capacity);
+        if (rPhysShapes.m_pooling)
+        {
+            rPhysShapes.m_parked    .resize(capacity);
+            rPhysShapes.m_spawnedAs .resize(capacity);
+        }
 
-        SubtreeBuilder bldScnRoot = SysSceneGraph::add_descendants(rBasic.m_scnGraph, rPhysShapes.m_spawnRequest.size() * 2);
+        auto const reusedCount = std::size_t(std::count(rPhysShapes.m_reused.begin(), rPhysShapes.m_reused.end(), 1));
+        SubtreeBuilder bldScnRoot = SysSceneGraph::add_descendants(rBasic.m_scnGraph, (rPhysShapes.m_spawnRequest.size() - reusedCount) * 2);
 
         for (std::size_t i = 0; i < rPhysShapes.m_spawnRequest.size(); ++i)
         {
@@ -148,7 +214,20 @@ Session setup_phys_shapes(
             ActiveEnt const root    = rPhysShapes.m_ents[i * 2];
             ActiveEnt const child   = rPhysShapes.m_ents[i * 2 + 1];
 
+            if (rPhysShapes.m_reused[i] != 0)
+            {
+                // Already in the scene graph, and the child's scale is the same
+                rBasic.m_transform.get(root).m_transform = Matrix4::translation(spawn.m_position);
+                SysSceneGraph::mark_transform_dirty(rBasic.m_scnGraph, root);
+                SysSceneGraph::mark_transform_dirty(rBasic.m_scnGraph, child);
+                continue;
+            }
+
             rPhysShapes.ownedEnts.insert(root);
+            if (rPhysShapes.m_pooling)
+            {
+                rPhysShapes.m_spawnedAs[root] = spawn;
+            }
 
             rBasic.m_transform.emplace(root, ACompTransform{osp::Matrix4::translation(spawn.m_position)});
             rBasic.m_transform.emplace(child, ACompTransform{Matrix4::scaling(spawn.m_size)});
@@ -174,6 +253,16 @@ Session setup_phys_shapes(
             ActiveEnt const root    = rPhysShapes.m_ents[i * 2];
             ActiveEnt const child   = rPhysShapes.m_ents[i * 2 + 1];
 
+            if (rPhysShapes.m_reused[i] != 0)
+            {
+                // Colliders and mass are kept by pooled shapes
+                if (spawn.m_mass != 0.0f)
+                {
+                    rPhys.m_setVelocity.emplace_back(root, spawn.m_velocity);
+                }
+                continue;
+            }
+
             rPhys.m_hasColliders.insert(root);
             if (spawn.m_mass != 0.0f)
             {
@@ -202,6 +291,7 @@ Session setup_phys_shapes(
 
     rBuilder.task()
         .name       ("Clear Shape Spawning vector after use")
+        .cheap      ()
         .run_on     ({tgShSp.spawnRequest(Clear)})
         .push_to    (out.m_tasks)
         .args       ({           idPhysShapes })
@@ -210,6 +300,58 @@ Session setup_phys_shapes(
         rPhysShapes.m_spawnRequest.clear();
     });
 
+    rBuilder.task()
+        .name       ("Schedule Shape parking")
+        .schedules  ({tgShSp.parkRequest(Schedule_)})
+        .sync_with  ({tgScn.update(Run)})
+        .push_to    (out.m_tasks)
+        .args       ({           idPhysShapes })
+        .func([] (ACtxPhysShapes& rPhysShapes) noexcept -> TaskActions
+    {
+        return rPhysShapes.m_parkRequest.empty() ? TaskAction::Cancel : TaskActions{};
+    });
+
+    rBuilder.task()
+        .name       ("Move parked shapes into the pool")
+        .run_on     ({tgShSp.parkRequest(UseOrRun)})
+        .sync_with  ({tgShSp.spawnRequest(Clear)})
+        .push_to    (out.m_tasks)
+        .args       ({           idPhysShapes })
+        .func([] (ACtxPhysShapes& rPhysShapes) noexcept
+    {
+        for (PooledShape const& parked : rPhysShapes.m_parkRequest)
+        {
+            rPhysShapes.m_parked.insert(parked.m_root);
+            rPhysShapes.m_pool.push_back(parked);
+        }
+    });
+
+    rBuilder.task()
+        .name       ("Clear Shape parking vector after use")
+        .cheap      ()
+        .run_on     ({tgShSp.parkRequest(Clear)})
+        .push_to    (out.m_tasks)
+        .args       ({           idPhysShapes })
+        .func([] (ACtxPhysShapes& rPhysShapes) noexcept
+    {
+        rPhysShapes.m_parkRequest.clear();
+    });
+
+    rBuilder.task()
+        .name       ("Remove deleted ActiveEnts from the Shape pool")
+        .run_on     ({tgCS.activeEntDelete(UseOrRun)})
+        .sync_with  ({tgShSp.ownedEnts(Modify__), tgShSp.spawnRequest(Clear)})
+        .push_to    (out.m_tasks)
+        .args       ({      idBasic,                idPhysShapes })
+        .func([] (ACtxBasic const& rBasic, ACtxPhysShapes& rPhysShapes) noexcept
+    {
+        std::erase_if(rPhysShapes.m_pool, [&rBasic] (PooledShape const& pooled)
+        {
+            return rBasic.m_deleted.contains(pooled.m_root);
+        });
+        bit_andnot_assign(bit_words(rPhysShapes.m_parked), bit_words(rBasic.m_deleted));
+    });
+
 
     return out;
 } // setup_phys_shapes
@@ -247,6 +389,10 @@ Session setup_phys_shapes_draw(
     {
         for (std::size_t i = 0; i < rPhysShapes.m_spawnRequest.size(); ++i)
         {
+            if (rPhysShapes.m_reused[i] != 0)
+            {
+                continue; // Pooled shapes keep their DrawEnt
+            }
             ActiveEnt const child            = rPhysShapes.m_ents[i * 2 + 1];
             rScnRender.m_activeToDraw[child] = rScnRender.m_drawIds.create();
         }
@@ -271,11 +417,19 @@ Session setup_phys_shapes_draw(
             ActiveEnt const child   = rPhysShapes.m_ents[i * 2 + 1];
             DrawEnt const drawEnt   = rScnRender.m_activeToDraw[child];
 
+            if (rPhysShapes.m_reused[i] != 0)
+            {
+                // Mesh and material are kept, only hidden while pooled
+                rScnRender.m_visible.insert(drawEnt);
+                continue;
+            }
+
             rScnRender.m_needDrawTf.insert(root);
             rScnRender.m_needDrawTf.insert(child);
 
             rScnRender.m_mesh[drawEnt] = rDrawing.m_meshRefCounts.ref_add(rNMesh.m_shapeToMesh.at(spawn.m_shape));
             rScnRender.m_meshDirty.push_back(drawEnt);
+            rScnRender.m_bounds[drawEnt] = shape_mesh_bounds(spawn.m_shape);
 
             rMat.m_ents.insert(drawEnt);
             rMat.m_dirty.push_back(drawEnt);
@@ -327,15 +481,37 @@ Session setup_phys_shapes_draw(
             EShape const shape = rPhys.m_shape.at(child);
             rScnRender.m_mesh[drawEnt] = rDrawing.m_meshRefCounts.ref_add(rNMesh.m_shapeToMesh.at(shape));
             rScnRender.m_meshDirty.push_back(drawEnt);
+            rScnRender.m_bounds[drawEnt] = shape_mesh_bounds(shape);
 
             rMat.m_ents.insert(drawEnt);
             rMat.m_dirty.push_back(drawEnt);
 
-            rScnRender.m_visible.insert(drawEnt);
+            if ( ! (rPhysShapes.m_pooling && rPhysShapes.m_parked.contains(root)) )
+            {
+                rScnRender.m_visible.insert(drawEnt);
+            }
             rScnRender.m_opaque.insert(drawEnt);
         }
     });
 
+    rBuilder.task()
+        .name       ("Hide parked shapes")
+        .run_on     ({tgShSp.parkRequest(UseOrRun)})
+        .sync_with  ({tgScnRdr.drawEnt(Modify)})
+        .push_to    (out.m_tasks)
+        .args       ({                   idScnRender,                      idPhysShapes })
+        .func([] (ACtxSceneRender& rScnRender, ACtxPhysShapes const& rPhysShapes) noexcept
+    {
+        for (PooledShape const& parked : rPhysShapes.m_parkRequest)
+        {
+            DrawEnt const drawEnt = rScnRender.m_activeToDraw[parked.m_child];
+            if (drawEnt != lgrn::id_null<DrawEnt>())
+            {
+                rScnRender.m_visible.erase(drawEnt);
+            }
+        }
+    });
+
     rBuilder.task()
         .name       ("Remove deleted ActiveEnts from ACtxPhysShapeser")
         .run_on     ({tgCS.activeEntDelete(UseOrRun)})
@@ -506,8 +682,12 @@ Session setup_bounds(
     rBuilder.pipeline(tgBnds.boundsSet)     .parent(tgScn.update);
     rBuilder.pipeline(tgBnds.outOfBounds)   .parent(tgScn.update);
 
-    top_emplace< ActiveEntSet_t >       (topData, idBounds);
-    top_emplace< ActiveEntVec_t >       (topData, idOutOfBounds);
+    auto &rBounds = top_emplace< ACtxRegionTriggers >   (topData, idBounds);
+    top_emplace< ActiveEntVec_t >                       (topData, idOutOfBounds);
+
+    // Region 0: everything below the world
+    constexpr float inf = std::numeric_limits<float>::infinity();
+    rBounds.m_regions.push_back({.m_min = {-inf, -inf, -inf}, .m_max = {inf, inf, -10.0f}});
 
     rBuilder.task()
         .name       ("Check for out-of-bounds entities")
@@ -515,31 +695,57 @@ Session setup_bounds(
         .sync_with  ({tgCS.transform(Ready), tgBnds.boundsSet(Ready), tgBnds.outOfBounds(Modify__)})
         .push_to    (out.m_tasks)
         .args       ({            idBasic,                      idBounds,                idOutOfBounds })
-        .func([] (ACtxBasic const& rBasic, ActiveEntSet_t const& rBounds, ActiveEntVec_t& rOutOfBounds) noexcept
+        .func([] (ACtxBasic const& rBasic, ACtxRegionTriggers& rBounds, ActiveEntVec_t& rOutOfBounds) noexcept
     {
-        for (ActiveEnt const ent : rBounds)
+        // Only entities that moved are retested, and each is only reported once as it crosses
+        SysRegionTrigger::update(rBounds, rBasic.m_scnGraph, rBasic.m_transform);
+
+        for (RegionTriggerEvent const& event : rBounds.m_events)
         {
-            ACompTransform const &entTf = rBasic.m_transform.get(ent);
-            if (entTf.m_transform.translation().z() < -10)
+            if (event.m_entered)
             {
-                rOutOfBounds.push_back(ent);
+                rOutOfBounds.push_back(event.m_ent);
             }
         }
+        rBounds.m_events.clear();
     });
 
     rBuilder.task()
         .name       ("Queue-Delete out-of-bounds entities")
         .run_on     ({tgBnds.outOfBounds(UseOrRun_)})
-        .sync_with  ({tgCS.activeEntDelete(Modify_), tgCS.hierarchy(Delete)})
+        .sync_with  ({tgCS.activeEntDelete(Modify_), tgCS.hierarchy(Delete), tgShSp.ownedEnts(UseOrRun_), tgShSp.parkRequest(Modify_)})
         .push_to    (out.m_tasks)
-        .args       ({      idBasic,                idActiveEntDel,                idOutOfBounds })
-        .func([] (ACtxBasic& rBasic, ActiveEntVec_t& rActiveEntDel, ActiveEntVec_t& rOutOfBounds) noexcept
+        .args       ({      idBasic,                idActiveEntDel,                idOutOfBounds,                idPhysShapes })
+        .func([] (ACtxBasic& rBasic, ActiveEntVec_t& rActiveEntDel, ActiveEntVec_t& rOutOfBounds, ACtxPhysShapes& rPhysShapes) noexcept
     {
+        if (rPhysShapes.m_pooling)
+        {
+            // Park shapes instead of deleting them, so they can be reused by later spawns
+            std::erase_if(rOutOfBounds, [&rBasic, &rPhysShapes] (ActiveEnt const root)
+            {
+                if ( ! rPhysShapes.ownedEnts.contains(root) )
+                {
+                    return false;
+                }
+
+                SpawnShape const &spawnedAs = rPhysShapes.m_spawnedAs[root];
+                rPhysShapes.m_parkRequest.push_back({
+                    .m_root     = root,
+                    .m_child    = *SysSceneGraph::children(rBasic.m_scnGraph, root).begin(),
+                    .m_size     = spawnedAs.m_size,
+                    .m_mass     = spawnedAs.m_mass,
+                    .m_shape    = spawnedAs.m_shape
+                });
+                return true;
+            });
+        }
+
         SysSceneGraph::queue_delete_entities(rBasic.m_scnGraph, rActiveEntDel, rOutOfBounds.begin(), rOutOfBounds.end());
     });
 
     rBuilder.task()
         .name       ("Clear out-of-bounds vector once we're done with it")
+        .cheap      ()
         .run_on     ({tgBnds.outOfBounds(Clear_)})
         .push_to    (out.m_tasks)
         .args       ({           idOutOfBounds })
@@ -554,10 +760,8 @@ Session setup_bounds(
         .sync_with  ({tgShSp.spawnedEnts(UseOrRun), tgBnds.boundsSet(Modify)})
         .push_to    (out.m_tasks)
         .args       ({      idBasic,                idPhysShapes,                idBounds })
-        .func([] (ACtxBasic& rBasic, ACtxPhysShapes& rPhysShapes, ActiveEntSet_t& rBounds) noexcept
+        .func([] (ACtxBasic& rBasic, ACtxPhysShapes& rPhysShapes, ACtxRegionTriggers& rBounds) noexcept
     {
-        rBounds.resize(rBasic.m_activeIds.capacity());
-
         for (std::size_t i = 0; i < rPhysShapes.m_spawnRequest.size(); ++i)
         {
             SpawnShape const &spawn = rPhysShapes.m_spawnRequest[i];
@@ -568,7 +772,7 @@ Session setup_bounds(
 
             ActiveEnt const root    = rPhysShapes.m_ents[i * 2];
 
-            rBounds.insert(root);
+            SysRegionTrigger::track(rBounds, root, rBasic.m_activeIds.capacity());
         }
     });
 
@@ -577,13 +781,10 @@ Session setup_bounds(
         .run_on     ({tgCS.activeEntDelete(UseOrRun)})
         .sync_with  ({tgBnds.boundsSet(Delete)})
         .push_to    (out.m_tasks)
-        .args       ({                 idActiveEntDel,                idBounds })
-        .func([] (ActiveEntVec_t const& rActiveEntDel, ActiveEntSet_t& rBounds) noexcept
+        .args       ({      idBasic,                idBounds })
+        .func([] (ACtxBasic const& rBasic, ACtxRegionTriggers& rBounds) noexcept
     {
-        for (osp::active::ActiveEnt const ent : rActiveEntDel)
-        {
-            rBounds.erase(ent);
-        }
+        SysRegionTrigger::remove_deleted(rBounds, rBasic.m_deleted);
     });
 
     return out;
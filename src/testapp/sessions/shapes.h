@@ -42,6 +42,21 @@ struct SpawnShape
     osp::EShape     m_shape;
 };
 
+/**
+ * @brief A deactivated shape kept to be reused by a later spawn of the same kind
+ *
+ * The entities keep their IDs, components, DrawEnt and physics body. The body is only removed
+ * from the physics world, and the DrawEnt is hidden.
+ */
+struct PooledShape
+{
+    osp::active::ActiveEnt          m_root;
+    osp::active::ActiveEnt          m_child;
+    osp::Vector3                    m_size;
+    float                           m_mass;
+    osp::EShape                     m_shape;
+};
+
 struct ACtxPhysShapes
 {
     osp::active::ActiveEntSet_t     ownedEnts;
@@ -49,6 +64,25 @@ struct ACtxPhysShapes
     std::vector<SpawnShape>         m_spawnRequest;
     osp::active::ActiveEntVec_t     m_ents;
     osp::draw::MaterialId           m_materialId;
+
+    /// If true, out-of-bounds shapes are parked in m_pool instead of deleted. Only enable if
+    /// the physics engine session handles parkRequest (currently Jolt).
+    bool                            m_pooling{false};
+
+    /// Non-zero for each of m_spawnRequest that reuses a pooled shape instead of new entities
+    std::vector<std::uint8_t>       m_reused;
+
+    /// Shapes to deactivate this frame, see PlPhysShapes::parkRequest
+    std::vector<PooledShape>        m_parkRequest;
+
+    /// Deactivated shapes waiting to be reused
+    std::vector<PooledShape>        m_pool;
+
+    /// Roots of shapes in m_pool or m_parkRequest
+    osp::active::ActiveEntSet_t     m_parked;
+
+    /// What each owned root was spawned as, to know which pooled shapes can be reused for what
+    osp::KeyedVec<osp::active::ActiveEnt, SpawnShape> m_spawnedAs;
 };
 
 void add_floor(
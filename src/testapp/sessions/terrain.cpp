@@ -24,9 +24,11 @@
  */
 #include "terrain.h"
 #include "common.h"
+#include "../setup_profile.h"
 
 #include <planet-a/chunk_generate.h>
 #include <planet-a/chunk_utils.h>
+#include <planet-a/height_noise.h>
 #include <planet-a/icosahedron.h>
 
 #include <adera/drawing/CameraController.h>
@@ -34,9 +36,13 @@
 #include <osp/core/math_2pow.h>
 #include <osp/core/math_int64.h>
 #include <osp/drawing/drawing.h>
+#include <osp/util/UserInputHandler.h>
 
 #include <longeron/utility/asserts.hpp>
 
+#include <Corrade/Containers/ArrayViewStl.h>
+
+#include <algorithm>
 #include <chrono>
 #include <fstream>
 
@@ -70,6 +76,7 @@ Session setup_terrain(
 
     rBuilder.task()
         .name       ("Clear surfaceAdded & surfaceRemoved once we're done with it")
+        .cheap      ()
         .run_on     ({tgTrn.surfaceChanges(Clear)})
         .push_to    (out.m_tasks)
         .args({               idTerrain })
@@ -108,243 +115,410 @@ Session setup_terrain_icosahedron(
     return out;
 }
 
-Session setup_terrain_subdiv_dist(
-        TopTaskBuilder&             rBuilder,
-        ArrayView<entt::any>  const topData,
-        Session               const &scene,
-        Session               const &terrain,
-        Session               const &terrainIco)
+void update_terrain_skeleton(
+        ACtxTerrainFrame    const &rTerrainFrame,
+        ACtxTerrain               &rTerrain,
+        ACtxTerrainIco            &rTerrainIco,
+        ParallelFor         const &parallelFor)
 {
-    OSP_DECLARE_GET_DATA_IDS(terrain,    TESTAPP_DATA_TERRAIN);
-    OSP_DECLARE_GET_DATA_IDS(terrainIco, TESTAPP_DATA_TERRAIN_ICO);
+    SubdivTriangleSkeleton     &rSkel      = rTerrain.skeleton;
+    SkeletonVertexData         &rSkData    = rTerrain.skData;
+    BasicChunkMeshGeometry     &rChGeo     = rTerrain.chunkGeom;
+    SkeletonSubdivScratchpad   &rSkSP      = rTerrain.scratchpad;
 
-    auto const tgTrn = terrain  .get_pipelines<PlTerrain>();
-    auto const tgScn = scene    .get_pipelines<PlScene>();
-
-    Session out;
+    // ## Restore memory order of triangle groups scattered by ID reuse
 
-    rBuilder.task()
-        .name       ("Subdivide triangle skeleton")
-        .run_on     ({tgScn.update(Run)})
-        .sync_with  ({tgTrn.terrainFrame(Ready), tgTrn.skeleton(New), tgTrn.surfaceChanges(Resize)})
-        .push_to    (out.m_tasks)
-        .args({                    idTerrainFrame,             idTerrain,                idTerrainIco })
-        .func([] (ACtxTerrainFrame &rTerrainFrame, ACtxTerrain &rTerrain, ACtxTerrainIco &rTerrainIco) noexcept
+    // surfaceRemoved was used up by the previous update, so only surfaceAdded and the chunk
+    // triangle IDs need to follow the remap.
+    if (rTerrain.reorderPeriod != 0 && ++rTerrain.updatesSinceReorder >= rTerrain.reorderPeriod)
     {
-        if ( ! rTerrainFrame.active )
+        rTerrain.updatesSinceReorder = 0;
+
+        SkTriGroupRemap const remap = rSkel.tri_group_reorder();
+        if (remap.changed)
         {
-            return;
-        }
+            rSkData.remap_tris(remap);
+            rSkSP.remap_tris(remap);
+            rTerrain.skChunks.remap_tris(remap);
 
-        SubdivTriangleSkeleton     &rSkel      = rTerrain.skeleton;
-        SkeletonVertexData         &rSkData    = rTerrain.skData;
-        BasicChunkMeshGeometry     &rChGeo     = rTerrain.chunkGeom;
-        SkeletonSubdivScratchpad   &rSkSP      = rTerrain.scratchpad;
+            for (SkTriGroupId &rGroupId : rTerrainIco.icoGroups)
+            {
+                rGroupId = remap(rGroupId);
+            }
+            for (SkTriId &rTriId : rTerrainIco.icoTri)
+            {
+                rTriId = remap(rTriId);
+            }
+        }
+    }
 
-        // ## Unsubdivide triangles that are too far away
+    // ## Unsubdivide triangles that are too far away
 
-        // Unsubdivide is performed first, since it's better to remove stuff before adding new
-        // stuff; this reduces peak memory requirements.
+    // Unsubdivide is performed first, since it's better to remove stuff before adding new
+    // stuff; this reduces peak memory requirements.
 
-        // Unsubdividing is performed per-level, starting from the highest detail. In order to
-        // respect invariants, triangles must be removed in groups (removing triangles 1-by-1 can
-        // violate invariants mid-way).
-        for (int level = rSkel.levelMax-1; level >= 0; --level)
-        {
-            // Select and deselect only modifies rSkSP
-            unsubdivide_select_by_distance(level, rTerrainFrame.position, rSkel, rSkData, rSkSP);
-            unsubdivide_deselect_invariant_violations(level, rSkel, rSkData, rSkSP);
+    // Unsubdividing is performed per-level, starting from the highest detail. In order to
+    // respect invariants, triangles must be removed in groups (removing triangles 1-by-1 can
+    // violate invariants mid-way).
+    for (int level = rSkel.levelMax-1; level >= 0; --level)
+    {
+        // Select and deselect only modifies rSkSP
+        unsubdivide_select_by_distance(level, rTerrainFrame.position, rSkel, rSkData, rSkSP, parallelFor);
+        unsubdivide_deselect_invariant_violations(level, rSkel, rSkData, rSkSP);
 
-            // Perform changes on skeleton, delete selected triangles
-            unsubdivide_level(level, rSkel, rSkData, rSkSP);
-        }
-        rSkSP.distanceTestDone.clear();
+        // Perform changes on skeleton, delete selected triangles
+        unsubdivide_level(level, rSkel, rSkData, rSkSP);
+    }
+    rSkSP.distanceTestDone.clear();
 
-        // ## Subdivide nearby triangles
+    // ## Subdivide nearby triangles
 
-        // Distance testing is performed 'recursively' per level. A triangle within the subdivision
-        // threshold and needs to be subdivided, will trigger a subdivision check for its children
-        // on the next level. To start, we seed the distance checker with the root triangles.
-        if (rSkel.levelMax > 0)
+    // Distance testing is performed 'recursively' per level. A triangle within the subdivision
+    // threshold and needs to be subdivided, will trigger a subdivision check for its children
+    // on the next level. To start, we seed the distance checker with the root triangles.
+    if (rSkel.levelMax > 0)
+    {
+        for (SkTriId const sktriId : rTerrainIco.icoTri)
         {
-            for (SkTriId const sktriId : rTerrainIco.icoTri)
-            {
-                rSkSP.levels[0].distanceTestNext.push_back(sktriId);
-                rSkSP.distanceTestDone.insert(sktriId);
-            }
-            rSkSP.levelNeedProcess = 0;
+            rSkSP.levels[0].distanceTestNext.push_back(sktriId);
+            rSkSP.distanceTestDone.insert(sktriId);
         }
+        rSkSP.levelNeedProcess = 0;
+    }
 
-        // Do the subdivide for real
-        for (int level = 0; level < rSkel.levelMax; ++level)
-        {
-            subdivide_level_by_distance(rTerrainFrame.position, level, rSkel, rSkData, rSkSP);
-        }
-        rSkSP.distanceTestDone.clear();
+    // Do the subdivide for real
+    rSkSP.subdivBudgetLeft = rTerrain.subdivBudget;
+    rSkSP.subdivDeferred   = 0;
+    for (int level = 0; level < rSkel.levelMax; ++level)
+    {
+        subdivide_level_by_distance(rTerrainFrame.position, level, rSkel, rSkData, rSkSP, parallelFor);
+    }
+    rSkSP.distanceTestDone.clear();
 
-        // Uncomment these if some new change breaks something
-        //rSkel.debug_check_invariants();
-    });
+    // Uncomment these if some new change breaks something
+    //rSkel.debug_check_invariants();
+}
 
-    rBuilder.task()
-        .name       ("Update Terrain Chunks")
-        .run_on     ({tgScn.update(Run)})
-        .sync_with  ({tgTrn.terrainFrame(Ready), tgTrn.skeleton(New), tgTrn.surfaceChanges(UseOrRun)})
-        .push_to    (out.m_tasks)
-        .args({                    idTerrainFrame,             idTerrain,                idTerrainIco })
-        .func([] (ACtxTerrainFrame &rTerrainFrame, ACtxTerrain &rTerrain, ACtxTerrainIco &rTerrainIco) noexcept
+void update_terrain_chunks(
+        ACtxTerrainFrame    const &terrainFrame,
+        ACtxTerrain               &rTerrain,
+        ACtxTerrainIco      const &rTerrainIco,
+        ParallelFor         const &parallelFor)
+{
+    SubdivTriangleSkeleton     &rSkel      = rTerrain.skeleton;
+    SkeletonVertexData         &rSkData    = rTerrain.skData;
+    ChunkSkeleton              &rSkCh      = rTerrain.skChunks;
+    ChunkMeshBufferInfo        &rChInfo    = rTerrain.chunkInfo;
+    BasicChunkMeshGeometry     &rChGeo     = rTerrain.chunkGeom;
+    ChunkScratchpad            &rChSP      = rTerrain.chunkSP;
+    SkeletonSubdivScratchpad   &rSkSP      = rTerrain.scratchpad;
+
+    rChSP.chunksAdded       .clear();
+    rChSP.sharedNormalsDirty.clear();
+    rChSP.sharedAdded       .clear();
+    rChSP.sharedRemoved     .clear();
+    rChSP.chunksDirty       .clear();
+    rChSP.chunksToFill      .clear();
+    rChSP.chunksRefaced     .clear();
+
+    // Delete chunks of now-deleted Skeleton Triangles
+    for (SkTriId const sktriId : rSkSP.surfaceRemoved)
     {
-        if ( ! rTerrainFrame.active )
-        {
-            return;
-        }
+        ChunkId const chunkId = rSkCh.m_triToChunk[sktriId];
 
-        SubdivTriangleSkeleton     &rSkel      = rTerrain.skeleton;
-        SkeletonVertexData         &rSkData    = rTerrain.skData;
-        ChunkSkeleton              &rSkCh      = rTerrain.skChunks;
-        ChunkMeshBufferInfo        &rChInfo    = rTerrain.chunkInfo;
-        BasicChunkMeshGeometry     &rChGeo     = rTerrain.chunkGeom;
-        ChunkScratchpad            &rChSP      = rTerrain.chunkSP;
-        SkeletonSubdivScratchpad   &rSkSP      = rTerrain.scratchpad;
-
-        rChSP.chunksAdded       .clear();
-        rChSP.sharedNormalsDirty.clear();
-        rChSP.sharedAdded       .clear();
-        rChSP.sharedRemoved     .clear();
-
-        // Delete chunks of now-deleted Skeleton Triangles
-        for (SkTriId const sktriId : rSkSP.surfaceRemoved)
-        {
-            ChunkId const chunkId = rSkCh.m_triToChunk[sktriId];
+        subtract_normal_contrib(chunkId, false, rChGeo, rChInfo, rChSP, rSkCh);
 
-            subtract_normal_contrib(chunkId, false, rChGeo, rChInfo, rChSP, rSkCh);
+        // Clear faces so GPU copies of the index buffer don't keep drawing deleted chunks
+        auto const ibufSlice = osp::as_2d(osp::arrayView(rChGeo.chunkIbuf), rChInfo.chunkMaxFaceCount).row(chunkId.value);
+        std::fill(ibufSlice.begin(), ibufSlice.end(), Vector3u{ZeroInit});
+        rChSP.chunksDirty.insert(chunkId);
 
-            rSkCh.chunk_remove(chunkId, sktriId, rChSP.sharedRemoved, rSkel);
+        // Shared vertex positions are still intact here. Chunks with reduced fill vertices are
+        // missing some, so aren't worth keeping
+        if (rChGeo.chunkFillReduction[chunkId] == 0)
+        {
+            chunk_fill_cache_store(chunk_fill_cache_key(chunkId, rChGeo, rChInfo, rSkCh),
+                                   chunkId, rChGeo, rChInfo, rTerrain.fillCache);
         }
 
-        auto const chLevel  = rSkCh.m_chunkSubdivLevel;
-        auto const edgeSize = rSkCh.m_chunkEdgeVrtxCount-1;
+        rSkCh.chunk_remove(chunkId, sktriId, rChSP.sharedRemoved, rSkel);
+    }
 
-        // Create new chunks for each new surface Skeleton Triangle added
-        rSkCh.m_triToChunk.resize(rSkel.tri_group_ids().capacity() * 4);
-        for (SkTriId const sktriId : rSkSP.surfaceAdded)
-        {
-            auto const &corners = rSkel.tri_at(sktriId).vertices;
+    auto const chLevel  = rSkCh.m_chunkSubdivLevel;
+    auto const edgeSize = rSkCh.m_chunkEdgeVrtxCount-1;
 
-            ArrayView< MaybeNewId<SkVrtxId> > const edgeVrtxView = rChSP.edgeVertices;
-            ArrayView< MaybeNewId<SkVrtxId> > const edgeLft = edgeVrtxView.sliceSize(edgeSize * 0, edgeSize);
-            ArrayView< MaybeNewId<SkVrtxId> > const edgeBtm = edgeVrtxView.sliceSize(edgeSize * 1, edgeSize);
-            ArrayView< MaybeNewId<SkVrtxId> > const edgeRte = edgeVrtxView.sliceSize(edgeSize * 2, edgeSize);
+    // Create new chunks for each new surface Skeleton Triangle added
+    rSkCh.m_triToChunk.resize(rSkel.tri_group_ids().capacity() * 4);
+    for (SkTriId const sktriId : rSkSP.surfaceAdded)
+    {
+        auto const &corners = rSkel.tri_at(sktriId).vertices;
 
-            rSkel.vrtx_create_chunk_edge_recurse(chLevel, corners[0], corners[1], edgeLft);
-            rSkel.vrtx_create_chunk_edge_recurse(chLevel, corners[1], corners[2], edgeBtm);
-            rSkel.vrtx_create_chunk_edge_recurse(chLevel, corners[2], corners[0], edgeRte);
+        ArrayView< MaybeNewId<SkVrtxId> > const edgeVrtxView = rChSP.edgeVertices;
+        ArrayView< MaybeNewId<SkVrtxId> > const edgeLft = edgeVrtxView.sliceSize(edgeSize * 0, edgeSize);
+        ArrayView< MaybeNewId<SkVrtxId> > const edgeBtm = edgeVrtxView.sliceSize(edgeSize * 1, edgeSize);
+        ArrayView< MaybeNewId<SkVrtxId> > const edgeRte = edgeVrtxView.sliceSize(edgeSize * 2, edgeSize);
 
-            ChunkId const chunkId = rSkCh.chunk_create(sktriId, rSkel, rChSP.sharedAdded, edgeLft, edgeBtm, edgeRte);
-            rChSP.chunksAdded.push_back(chunkId);
+        rSkel.vrtx_create_chunk_edge_recurse(chLevel, corners[0], corners[1], edgeLft);
+        rSkel.vrtx_create_chunk_edge_recurse(chLevel, corners[1], corners[2], edgeBtm);
+        rSkel.vrtx_create_chunk_edge_recurse(chLevel, corners[2], corners[0], edgeRte);
 
-            // chunk_create creates new Skeleton Vertices. Resize is needed after each call
-            rSkData.resize(rSkel);
-            rSkSP.resize(rSkel);
+        ChunkId const chunkId = rSkCh.chunk_create(sktriId, rSkel, rChSP.sharedAdded, edgeLft, edgeBtm, edgeRte);
+        rChSP.chunksAdded.push_back(chunkId);
 
-            // Calculates positions and normals with spherical curvature
-            ico_calc_chunk_edge(rTerrainIco.radius, chLevel, corners[0], corners[1], edgeLft, rSkData);
-            ico_calc_chunk_edge(rTerrainIco.radius, chLevel, corners[1], corners[2], edgeBtm, rSkData);
-            ico_calc_chunk_edge(rTerrainIco.radius, chLevel, corners[2], corners[0], edgeRte, rSkData);
-        }
+        // chunk_create creates new Skeleton Vertices. Resize is needed after each call
+        rSkData.resize(rSkel);
+        rSkSP.resize(rSkel);
 
-        for (SkTriId const sktriId : rSkSP.surfaceAdded)
+        // Calculates positions and normals with spherical curvature
+        ico_calc_chunk_edge(rTerrainIco.radius, chLevel, corners[0], corners[1], edgeLft, rSkData);
+        ico_calc_chunk_edge(rTerrainIco.radius, chLevel, corners[1], corners[2], edgeBtm, rSkData);
+        ico_calc_chunk_edge(rTerrainIco.radius, chLevel, corners[2], corners[0], edgeRte, rSkData);
+
+        if (rSkSP.onVrtxBatch != nullptr)
         {
-            auto const chunkId = rSkCh.m_triToChunk[sktriId];
-            restitch_check(chunkId, sktriId, rSkCh, rSkel, rSkData, rChSP);
+            for (MaybeNewId<SkVrtxId> const edgeVrtx : edgeVrtxView)
+            if (edgeVrtx.isNew)
+            {
+                rSkSP.vrtxBatch.push_back(edgeVrtx.id);
+            }
         }
+    }
+    flush_vrtx_batch(rSkData, rSkSP);
 
-        // Calculate positions for newly added shared vertex
-        float const scalepow = std::pow(2.0f, -rSkData.precision);
-        for (SharedVrtxId const sharedVrtxId : rChSP.sharedAdded)
-        {
-            SkVrtxId const skelVrtx     = rSkCh.m_sharedToSkVrtx[sharedVrtxId];
+    for (SkTriId const sktriId : rSkSP.surfaceAdded)
+    {
+        auto const chunkId = rSkCh.m_triToChunk[sktriId];
+        restitch_check(chunkId, sktriId, rSkCh, rSkel, rSkData, rChSP);
+    }
+
+    // Calculate positions for newly added shared vertex
+    float const scalepow = std::pow(2.0f, -rSkData.precision);
+    for (SharedVrtxId const sharedVrtxId : rChSP.sharedAdded)
+    {
+        SkVrtxId const skelVrtx     = rSkCh.m_sharedToSkVrtx[sharedVrtxId];
 
-            // Normal is not cleaned up by the previous user. Normal is initially set to zero, and
-            // face normals added in update_faces(...) will accumulate here.
-            rChGeo.sharedNormalSum[sharedVrtxId] = Vector3{ZeroInit};
+        // Normal is not cleaned up by the previous user. Normal is initially set to zero, and
+        // face normals added in update_faces(...) will accumulate here.
+        rChGeo.sharedNormalSum[sharedVrtxId] = Vector3{ZeroInit};
 
-            //Vector3l const translated = positions[size_t(skelId)] + translaton;
-            Vector3d  const scaled = Vector3d(rSkData.positions[skelVrtx]) * scalepow;
-            VertexIdx const vertex = rChInfo.vbufSharedOffset + sharedVrtxId.value;
+        //Vector3l const translated = positions[size_t(skelId)] + translaton;
+        Vector3d  const scaled = Vector3d(rSkData.positions[skelVrtx]) * scalepow;
+        VertexIdx const vertex = rChInfo.vbufSharedOffset + sharedVrtxId.value;
 
-            // Heightmap goes here (1)
-            rChGeo.chunkVbufPos[vertex] = Vector3(scaled);
-        }
+        // Heightmap goes here (1)
+        rChGeo.chunkVbufPos[vertex] = Vector3(scaled);
+    }
 
-        // Calculate fill vertex positions
-        for (SkTriId const sktriId : rSkSP.surfaceAdded)
-        {
-            auto        const chunk      = rSkCh.m_triToChunk[sktriId];
-            auto        const chunkIdInt = std::size_t(chunk);
-            std::size_t const fillOffset = rChInfo.vbufFillOffset + chunkIdInt*rChInfo.fillVrtxCount;
+    auto const fill_positions = [&rChGeo, &rChInfo] (ChunkId const chunkId) -> ArrayView<Vector3>
+    {
+        return osp::arrayView(rChGeo.chunkVbufPos).sliceSize(
+                rChInfo.vbufFillOffset + std::size_t(chunkId.value) * rChInfo.fillVrtxCount,
+                rChInfo.fillVrtxCount);
+    };
 
-            osp::ArrayView<SharedVrtxOwner_t const> sharedUsed = rSkCh.shared_vertices_used(chunk);
+    // Choose a resolution reduction for each chunk from its distance, relative to the distance
+    // its triangle unsubdivides at. Chunks only this far away are usually ones that can't
+    // unsubdivide any further, such as the root triangles seen from orbit. Reducing resolution
+    // again needs a bit more distance than increasing it, so chunks don't flicker between them.
+    auto const maxReduction = std::uint8_t(rChSP.reducedLuts.size());
+    if (maxReduction != 0)
+    {
+        for (ChunkId const chunkId : rSkCh.m_chunkIds)
+        {
+            SkTriId      const sktriId = rSkCh.m_chunkToTri[chunkId];
+            std::uint8_t const level   = rSkel.tri_group_at(tri_group_id(sktriId)).depth;
+            double       const base    = double(rSkSP.distanceThresholdUnsubdiv[std::min<std::size_t>(level, gc_maxSubdivLevels - 1)]);
+            double       const dist    = Vector3d(rSkData.centers[sktriId] - terrainFrame.position).length();
 
-            for (ChunkFillSubdivLUT::ToSubdiv const& toSubdiv : rChSP.lut.data())
+            auto const reduction_at = [maxReduction, base] (double const distance) -> std::uint8_t
             {
-                std::size_t const vrtxA = rChSP.lut.index(sharedUsed, fillOffset, rChInfo.vbufSharedOffset, toSubdiv.m_vrtxA);
-                std::size_t const vrtxB = rChSP.lut.index(sharedUsed, fillOffset, rChInfo.vbufSharedOffset, toSubdiv.m_vrtxB);
-                std::size_t const vrtxC = rChInfo.vbufFillOffset + rChInfo.fillVrtxCount*chunkIdInt + toSubdiv.m_fillOut.value;
+                std::uint8_t reduction = 0;
+                while (reduction < maxReduction && base != 0.0 && distance > base * double(2u << reduction))
+                {
+                    ++reduction;
+                }
+                return reduction;
+            };
 
-                Vector3 &rPosC = rChGeo.chunkVbufPos[vrtxC];
+            std::uint8_t const up      = reduction_at(dist);
+            std::uint8_t const down    = reduction_at(dist * 1.25);
+            std::uint8_t const current = rChGeo.chunkReduction[chunkId];
 
-                // Heightmap goes here (2)
-                Vector3 const avg       = (rChGeo.chunkVbufPos[vrtxA] + rChGeo.chunkVbufPos[vrtxB]) / 2.0f;
-                float   const avgLen    = avg.length();
-                float   const roundness = rTerrainIco.radius - avgLen;
+            rChSP.reductions[chunkId] = rSkSP.surfaceAdded.contains(sktriId) ? up
+                                      : (up > current)                       ? up
+                                      :                                        std::min(current, down);
+        }
+    }
 
-                rPosC = avg + (avg / avgLen) * roundness;
-            }
+    // Reuse fill vertices of chunks that were removed recently, such as when the camera moves
+    // back and forth across a subdivision threshold
+    for (ChunkId const chunkId : rChSP.chunksAdded)
+    {
+        if (chunk_fill_cache_take(chunk_fill_cache_key(chunkId, rChGeo, rChInfo, rSkCh),
+                                  chunkId, rChGeo, rChInfo, rTerrain.fillCache))
+        {
+            rChGeo.chunkFillReduction[chunkId] = 0;
+            continue;
         }
 
-        // Add or remove faces according to chunk changes. This also calculates normals.
-        // Vertex normals are calculated from a weighted sum of face normals of connected faces.
-        // For shared vertices, we add or subtract face normals from rChGeo.sharedNormalSum.
-        for (ChunkId const chunkId : rSkCh.m_chunkIds)
+        // Page in chunks generated in previous runs
+        if (   rTerrain.chunkStore.is_open()
+            && rTerrain.chunkStore.read(chunk_store_key(rSkCh.m_chunkToTri[chunkId], rSkel),
+                                        fill_positions(chunkId)) )
         {
-            SkTriId const sktriId    = rSkCh.m_chunkToTri[chunkId];
-            bool    const newlyAdded = rSkSP.surfaceAdded.contains(sktriId);
+            rChGeo.chunkFillReduction[chunkId] = 0;
+            continue;
+        }
+
+        rChGeo.chunkFillReduction[chunkId] = rChSP.reductions[chunkId];
+        rChSP.chunksToFill.push_back(chunkId);
+    }
 
-            update_faces(chunkId, sktriId, newlyAdded, rSkel, rSkData, rChGeo, rChInfo, rChSP, rSkCh);
+    // Existing chunks going to a finer resolution need the fill vertices they skipped
+    if (maxReduction != 0)
+    {
+        for (ChunkId const chunkId : rSkCh.m_chunkIds)
+        {
+            if (   ! rSkSP.surfaceAdded.contains(rSkCh.m_chunkToTri[chunkId])
+                && rChSP.reductions[chunkId] < rChGeo.chunkFillReduction[chunkId] )
+            {
+                rChGeo.chunkFillReduction[chunkId] = rChSP.reductions[chunkId];
+                rChSP.chunksToFill.push_back(chunkId);
+            }
         }
-        std::fill(rChSP.stitchCmds.begin(), rChSP.stitchCmds.end(), ChunkStitch{});
+    }
 
-        // Update vertex buffer normals of shared vertices, as rChGeo.sharedNormalSum was modified.
-        for (SharedVrtxId const sharedId : rChSP.sharedNormalsDirty)
+    // Calculate remaining fill vertex positions. Each chunk only writes to its own fill vertices and
+    // reads shared vertices calculated above, so chunks can be split across threads by parallelFor.
+    auto const calc_fill = [&rSkCh, &rChInfo, &rChGeo, &rChSP, radius = rTerrainIco.radius]
+            (std::size_t const first, std::size_t const last) noexcept
+    {
+        ChunkFillScratch scratch;
+        for (std::size_t i = first; i < last; ++i)
         {
-            Vector3 const normalSum = rChGeo.sharedNormalSum[sharedId];
-            rChGeo.chunkVbufNrm[rChInfo.vbufSharedOffset + sharedId.value] = normalSum.normalized();
+            auto          const chunk      = rChSP.chunksToFill[i];
+            std::uint32_t const fillOffset = rChInfo.vbufFillOffset + std::uint32_t(chunk.value)*rChInfo.fillVrtxCount;
+
+            ico_calc_chunk_fill(radius, rChSP.lut_for(rChGeo.chunkFillReduction[chunk]),
+                                rSkCh.shared_vertices_used(chunk), fillOffset,
+                                rChInfo.vbufSharedOffset, osp::arrayView(rChGeo.chunkVbufPos), scratch);
         }
+    };
 
-        // Uncomment these if some new change breaks something
-        //debug_check_invariants(rChGeo, rChInfo, rSkCh);
+    std::size_t const addedCount = rChSP.chunksToFill.size();
+    parallelFor(addedCount, addedCount / ChunkScratchpad::smc_minChunksPerThread, calc_fill);
 
-        // TODO: temporary, write debug obj file every ~10 seconds
-        static int fish = 0;
-        ++fish;
-        if (fish == 60*10)
+    if (rTerrain.chunkStore.is_open())
+    {
+        for (ChunkId const chunkId : rChSP.chunksToFill)
+        if (rChGeo.chunkFillReduction[chunkId] == 0)
         {
-            fish = 0;
+            rTerrain.chunkStore.append(chunk_store_key(rSkCh.m_chunkToTri[chunkId], rSkel),
+                                       fill_positions(chunkId));
+        }
+    }
+
+    // Add or remove faces according to chunk changes. This also calculates normals.
+    // Vertex normals are calculated from a weighted sum of face normals of connected faces.
+    // For shared vertices, we add or subtract face normals from rChGeo.sharedNormalSum.
+    for (ChunkId const chunkId : rSkCh.m_chunkIds)
+    {
+        SkTriId const sktriId    = rSkCh.m_chunkToTri[chunkId];
+        bool    const newlyAdded = rSkSP.surfaceAdded.contains(sktriId);
+
+        update_faces(chunkId, sktriId, newlyAdded, rSkel, rSkData, rChGeo, rChInfo, rChSP, rSkCh);
+    }
+    std::fill(rChSP.stitchCmds.begin(), rChSP.stitchCmds.end(), ChunkStitch{});
 
-            auto        const time     = std::chrono::system_clock::now().time_since_epoch().count();
-            std::string const filename = fmt::format("planetdebug_{}.obj", time);
+    // Normalize fill normals of new and refaced chunks, and update vertex buffer normals of shared
+    // vertices, as rChGeo.sharedNormalSum was modified.
+    finalize_normals(rChGeo, rChInfo, rChSP, parallelFor);
 
-            OSP_LOG_INFO("Writing planet terrain obj: {}\n"
-                         "* Chunks:          {}/{}\n"
-                         "* Shared Vertices: {}/{}\n",
-                         filename,
-                         rSkCh.m_chunkIds.size(), rSkCh.m_chunkIds.capacity(),
-                         rSkCh.m_sharedIds.size(), rSkCh.m_sharedIds.capacity() );
+    // Record which parts of the mesh changed, so renderers can upload only these
+    find_dirty_ranges(rChSP, rChInfo, rTerrain.chunkDirty);
 
-            std::ofstream objfile;
-            objfile.open(filename);
-            write_obj(objfile, rTerrain.chunkGeom, rChInfo, rSkCh);
+    // Uncomment these if some new change breaks something
+    //debug_check_invariants(rChGeo, rChInfo, rSkCh);
+
+    // TODO: temporary, write debug obj file every ~10 seconds
+    static int fish = 0;
+    ++fish;
+    if (fish == 60*10)
+    {
+        fish = 0;
+
+        auto        const time     = std::chrono::system_clock::now().time_since_epoch().count();
+        std::string const filename = fmt::format("planetdebug_{}.obj", time);
+
+        // Many cache hits means chunks are churning across the distance thresholds; the gap
+        // between subdivide and unsubdivide thresholds (hysteresis) may be too small.
+        ChunkFillCache::Stats const &cacheStats = rTerrain.fillCache.stats;
+        std::uint64_t         const lookups     = cacheStats.hits + cacheStats.misses;
+
+        OSP_LOG_INFO("Writing planet terrain obj: {}\n"
+                     "* Chunks:          {}/{}\n"
+                     "* Shared Vertices: {}/{}\n"
+                     "* Fill cache:      {}/{} hits, {} evictions ({:.1f}% reused)\n"
+                     "* Chunk store:     {} hits, {} misses, {} appended\n"
+                     "* Unsubdivide/subdivide distance ratio: {:.2f}\n",
+                     filename,
+                     rSkCh.m_chunkIds.size(), rSkCh.m_chunkIds.capacity(),
+                     rSkCh.m_sharedIds.size(), rSkCh.m_sharedIds.capacity(),
+                     cacheStats.hits, lookups, cacheStats.evictions,
+                     lookups == 0 ? 0.0 : 100.0 * double(cacheStats.hits) / double(lookups),
+                     rTerrain.chunkStore.stats().hits, rTerrain.chunkStore.stats().misses,
+                     rTerrain.chunkStore.stats().appended,
+                     rSkSP.distanceThresholdSubdiv[0] == 0 ? 0.0
+                             : double(rSkSP.distanceThresholdUnsubdiv[0]) / double(rSkSP.distanceThresholdSubdiv[0]) );
+
+        std::ofstream objfile;
+        objfile.open(filename);
+        write_obj(objfile, rTerrain.chunkGeom, rChInfo, rSkCh);
+    }
+}
+
+Session setup_terrain_subdiv_dist(
+        TopTaskBuilder&             rBuilder,
+        ArrayView<entt::any>  const topData,
+        Session               const &scene,
+        Session               const &terrain,
+        Session               const &terrainIco)
+{
+    OSP_DECLARE_GET_DATA_IDS(terrain,    TESTAPP_DATA_TERRAIN);
+    OSP_DECLARE_GET_DATA_IDS(terrainIco, TESTAPP_DATA_TERRAIN_ICO);
+
+    auto const tgTrn = terrain  .get_pipelines<PlTerrain>();
+    auto const tgScn = scene    .get_pipelines<PlScene>();
+
+    Session out;
+
+    rBuilder.task()
+        .name       ("Subdivide triangle skeleton")
+        .affinity   (TopTaskAffinity::Dedicated)
+        .run_on     ({tgScn.update(Run)})
+        .sync_with  ({tgTrn.terrainFrame(Ready), tgTrn.skeleton(New), tgTrn.surfaceChanges(Resize)})
+        .push_to    (out.m_tasks)
+        .args({                    idTerrainFrame,             idTerrain,                idTerrainIco })
+        .func([] (ACtxTerrainFrame &rTerrainFrame, ACtxTerrain &rTerrain, ACtxTerrainIco &rTerrainIco, WorkerContext ctx) noexcept
+    {
+        if (rTerrainFrame.active)
+        {
+            update_terrain_skeleton(rTerrainFrame, rTerrain, rTerrainIco, ctx.m_parallelFor);
+        }
+    });
+
+    rBuilder.task()
+        .name       ("Update Terrain Chunks")
+        .affinity   (TopTaskAffinity::Dedicated)
+        .run_on     ({tgScn.update(Run)})
+        .sync_with  ({tgTrn.terrainFrame(Ready), tgTrn.skeleton(New), tgTrn.surfaceChanges(UseOrRun)})
+        .push_to    (out.m_tasks)
+        .args({                    idTerrainFrame,             idTerrain,                idTerrainIco })
+        .func([] (ACtxTerrainFrame &rTerrainFrame, ACtxTerrain &rTerrain, ACtxTerrainIco &rTerrainIco, WorkerContext ctx) noexcept
+    {
+        if (rTerrainFrame.active)
+        {
+            update_terrain_chunks(rTerrainFrame, rTerrain, rTerrainIco, ctx.m_parallelFor);
         }
     });
 
@@ -366,6 +540,15 @@ void initialize_ico_terrain(
 
     rTerrainFrame.active = true;
 
+    initialize_ico_terrain(rTerrain, rTerrainIco, specs, {});
+}
+
+void initialize_ico_terrain(
+        ACtxTerrain                                 &rTerrain,
+        ACtxTerrainIco                              &rTerrainIco,
+        TerrainTestPlanetSpecs                const specs,
+        std::shared_ptr<ChunkFillSubdivLUT const>   lut)
+{
     // ## Create initial icosahedron skeleton
 
     rTerrainIco.radius          = specs.radius;
@@ -382,11 +565,20 @@ void initialize_ico_terrain(
 
     // ## Assign skeleton icosahedron position data
 
-    rTerrain.skData.resize(rTerrain.skeleton);
-
     double const scale = std::pow(2.0, rTerrain.skData.precision);
     double const maxRadius = rTerrainIco.radius + rTerrainIco.height;
 
+    // Distance test with 32-bit centers if precise enough for the smallest subdiv threshold
+    // calculated below. Centers rise above the surface, so leave 2x room.
+    if (specs.skelMaxSubdivLevels > 0)
+    {
+        double const minThreshold = 0.75 * gc_icoMaxEdgeVsLevel[specs.skelMaxSubdivLevels-1] * rTerrainIco.radius * scale;
+        rTerrain.skData.compactShift = compact_shift_for(std::uint64_t(2.0 * maxRadius * scale),
+                                                         std::uint64_t(minThreshold));
+    }
+
+    rTerrain.skData.resize(rTerrain.skeleton);
+
     for (SkTriGroupId const groupId : rTerrainIco.icoGroups)
     {
         ico_calc_sphere_tri_center(groupId, maxRadius, rTerrainIco.height, rTerrain.skeleton, rTerrain.skData);
@@ -406,6 +598,12 @@ void initialize_ico_terrain(
         rSP.surfaceAdded.insert(tri_id(groupId, 3));
     }
 
+    // Roughly a few milliseconds of subdividing per update
+    rTerrain.subdivBudget = 512;
+
+    // Defragment triangle groups roughly every 10 seconds
+    rTerrain.reorderPeriod = 600;
+
     // Set function pointer to apply spherical curvature to the skeleton on subdivision.
     // Spherical planets are not hard-coded into subdivision logic, it's intended to work
     // to work for non-spherical shapes too.
@@ -424,6 +622,25 @@ void initialize_ico_terrain(
         ico_calc_sphere_tri_center(groupId, rTerrainIco.radius + rTerrainIco.height, rTerrainIco.height, rSkel, rSkData);
     };
 
+    if (specs.noiseAmplitude > 0.0f)
+    {
+        // Centers calculated by ico_calc_sphere_tri_center assume vertices are within height
+        rTerrain.heightNoise = {
+            .cellPow    = rTerrain.skData.precision + 3, // 8 meter features
+            .octaves    = 4,
+            .amplitude  = std::min(specs.noiseAmplitude, float(specs.height))
+        };
+        rSP.onVrtxBatchUserData[0] = &rTerrain;
+        rSP.onVrtxBatch = [] (
+                ArrayView<SkVrtxId const>               vertices,
+                SkeletonVertexData                      &rSkData,
+                SkeletonSubdivScratchpad::UserData_t    userData) noexcept
+        {
+            auto &rTerrain = *reinterpret_cast<ACtxTerrain*>(userData[0]);
+            height_noise_batch(vertices, rTerrain.heightNoise, rSkData, rTerrain.heightNoiseScratch);
+        };
+    }
+
     // Nothing to do on un-subdivide
     rSP.onUnsubdiv = [] (
             SkTriId                         tri,
@@ -475,9 +692,40 @@ void initialize_ico_terrain(
 
     // ## Prepare Chunk scratchpad
 
-    rTerrain.chunkSP.lut = make_chunk_vrtx_subdiv_lut(chunkSubdivLevels);
+    if (lut != nullptr && lut->edge_vrtx_count() == rTerrain.skChunks.m_chunkEdgeVrtxCount)
+    {
+        rTerrain.chunkSP.lut = std::move(lut);
+    }
+    else
+    {
+        rTerrain.chunkSP.lut = std::make_shared<ChunkFillSubdivLUT const>(make_chunk_vrtx_subdiv_lut(chunkSubdivLevels));
+    }
+    // Smaller LUTs for chunks drawn at reduced resolution, which only need some fill vertices
+    rTerrain.chunkSP.reducedLuts.clear();
+    for (std::uint8_t reduction = 1; reduction <= max_chunk_reduction(chunkSubdivLevels); ++reduction)
+    {
+        rTerrain.chunkSP.reducedLuts.push_back(std::make_shared<ChunkFillSubdivLUT const>(
+                make_chunk_vrtx_subdiv_lut(chunkSubdivLevels, reduction)));
+    }
     rTerrain.chunkSP.resize(rTerrain.skChunks);
 
+    // Enough to hold a few waves of chunks removed by moving back and forth
+    rTerrain.fillCache.resize(rTerrain.skChunks.m_chunkIds.capacity() / 4, rTerrain.chunkInfo.fillVrtxCount);
+
+    if (specs.chunkStorePath != nullptr)
+    {
+        std::uint64_t const paramsHash = chunk_store_params_hash(
+                specs.radius, specs.height, specs.skelPrecision, specs.skelMaxSubdivLevels,
+                specs.chunkSubdivLevels, specs.noiseAmplitude, rTerrain.heightNoise);
+
+        EChunkStoreStatus const status = rTerrain.chunkStore.open(
+                specs.chunkStorePath, paramsHash, rTerrain.chunkInfo.fillVrtxCount);
+        if (status == EChunkStoreStatus::CantOpen)
+        {
+            OSP_LOG_WARN("Can't open terrain chunk store: {}", specs.chunkStorePath);
+        }
+    }
+
     OSP_LOG_INFO("Terrain Chunk Properties:\n"
                  "* MaxChunks: {}\n"
                  "* FillVerticesPerChunk: {}\n"
@@ -500,8 +748,19 @@ void initialize_ico_terrain(
 
 struct TerrainDebugDraw
 {
-    KeyedVec<SkVrtxId, osp::draw::DrawEnt> verts;
+    /// Tiny cube for each shared vertex
+    KeyedVec<SharedVrtxId, osp::draw::DrawEnt> verts;
+
+    /// Shared vertices with new DrawEnts or positions, placed once drawEntResized is done
+    std::vector<SharedVrtxId> toPlace;
+
     MaterialId mat;
+
+    input::EButtonControlIndex btnToggle;
+    bool enabled{true};
+
+    /// If verts matches all shared vertices, only sharedAdded and sharedRemoved need to be applied
+    bool built{false};
 };
 
 Session setup_terrain_debug_draw(
@@ -520,6 +779,7 @@ Session setup_terrain_debug_draw(
     OSP_DECLARE_GET_DATA_IDS(cameraCtrl,     TESTAPP_DATA_CAMERA_CTRL);
     OSP_DECLARE_GET_DATA_IDS(terrain,        TESTAPP_DATA_TERRAIN);
     OSP_DECLARE_GET_DATA_IDS(terrainIco,     TESTAPP_DATA_TERRAIN_ICO);
+    OSP_DECLARE_GET_DATA_IDS(windowApp,      TESTAPP_DATA_WINDOW_APP);
 
     auto const tgWin    = windowApp     .get_pipelines<PlWindowApp>();
     auto const tgScnRdr = sceneRenderer .get_pipelines<PlSceneRenderer>();
@@ -529,8 +789,24 @@ Session setup_terrain_debug_draw(
     Session out;
     auto const [idTrnDbgDraw] = out.acquire_data<1>(topData);
 
-    auto &rTrnDbgDraw = top_emplace< TerrainDebugDraw > (topData, idTrnDbgDraw,
-                                                         TerrainDebugDraw{.mat = mat});
+    auto &rUserInput = top_get< input::UserInputHandler >(topData, idUserInput);
+
+    top_emplace< TerrainDebugDraw > (topData, idTrnDbgDraw, TerrainDebugDraw{
+        .mat        = mat,
+        .btnToggle  = rUserInput.button_subscribe("debug_terrain_draw") });
+
+    rBuilder.task()
+        .name       ("Toggle terrain debug draw")
+        .run_on     ({tgWin.inputs(Run)})
+        .push_to    (out.m_tasks)
+        .args       ({                         idUserInput,                  idTrnDbgDraw })
+        .func([] (input::UserInputHandler const& rUserInput, TerrainDebugDraw& rTrnDbgDraw) noexcept
+    {
+        if (rUserInput.button_state(rTrnDbgDraw.btnToggle).m_triggered)
+        {
+            rTrnDbgDraw.enabled = ! rTrnDbgDraw.enabled;
+        }
+    });
 
     rBuilder.task()
         .name       ("Position SceneFrame center to Camera Controller target")
@@ -556,74 +832,119 @@ Session setup_terrain_debug_draw(
         rTerrainFrame.position = Vector3l(camPos * int_2pow<int>(rTerrain.skData.precision));
     });
 
-    // Setup skeleton vertex visualizer
+    // Setup shared vertex visualizer
 
     rBuilder.task()
-        .name       ("Create or delete DrawEnts for each SkVrtxId in the terrain skeleton")
+        .name       ("Create or delete DrawEnts for changed terrain shared vertices")
         .run_on     ({tgScnRdr.render(Run)})
         .sync_with  ({tgTrn.skeleton(Ready), tgScnRdr.drawEnt(Delete), tgScnRdr.entMeshDirty(Modify_), tgScnRdr.materialDirty(Modify_), tgScnRdr.drawEntResized(ModifyOrSignal)})
         .push_to    (out.m_tasks)
-        .args       ({        idDrawing,                 idScnRender,             idNMesh,                  idTrnDbgDraw,                   idTerrain,                      idTerrainIco })
-        .func([] (ACtxDrawing& rDrawing, ACtxSceneRender& rScnRender, NamedMeshes& rNMesh, TerrainDebugDraw& rTrnDbgDraw, ACtxTerrain const &rTerrain, ACtxTerrainIco const &rTerrainIco) noexcept
+        .args       ({        idDrawing,                 idScnRender,                  idTrnDbgDraw,                   idTerrain })
+        .func([] (ACtxDrawing& rDrawing, ACtxSceneRender& rScnRender, TerrainDebugDraw& rTrnDbgDraw, ACtxTerrain const &rTerrain) noexcept
     {
+        if ( ! rTrnDbgDraw.enabled && ! rTrnDbgDraw.built )
+        {
+            return;
+        }
+
         Material &rMatPlanet = rScnRender.m_materials[rTrnDbgDraw.mat];
-        SubdivIdRegistry<SkVrtxId> const& vrtxIds = rTerrain.skeleton.vrtx_ids();
-        rTrnDbgDraw.verts.resize(vrtxIds.capacity());
 
-        // Iterate all existing and non-existing SkVrtxIDs. Create or delete a DrawEnt for it
-        // accordingly. This is probably very inefficient :)
-        for (std::size_t skVertInt = 0; skVertInt < vrtxIds.capacity(); ++skVertInt)
+        auto const delete_draw_ent = [&rDrawing, &rScnRender, &rMatPlanet] (DrawEnt &rDrawEnt)
         {
-            auto    const skVert    = SkVrtxId(skVertInt);
-            DrawEnt       &rDrawEnt = rTrnDbgDraw.verts[skVert];
-
-            if (vrtxIds.exists(skVert))
+            if (rScnRender.m_mesh[rDrawEnt].has_value())
             {
-                if ( ! rDrawEnt.has_value())
-                {
-                    rDrawEnt = rScnRender.m_drawIds.create();
-                }
+                rDrawing.m_meshRefCounts.ref_release(std::exchange(rScnRender.m_mesh[rDrawEnt], {}));
             }
-            else
+            rScnRender.m_meshDirty  .push_back  (rDrawEnt);
+            rScnRender.m_visible    .erase      (rDrawEnt);
+            rScnRender.m_opaque     .erase      (rDrawEnt);
+            rMatPlanet.m_ents       .erase      (rDrawEnt);
+            rMatPlanet.m_dirty      .push_back  (rDrawEnt);
+
+            rScnRender.m_drawIds.remove(std::exchange(rDrawEnt, {}));
+        };
+
+        rTrnDbgDraw.toPlace.clear();
+
+        if ( ! rTrnDbgDraw.enabled )
+        {
+            for (DrawEnt &rDrawEnt : rTrnDbgDraw.verts)
             {
                 if (rDrawEnt.has_value())
                 {
-                    if (rScnRender.m_mesh[rDrawEnt].has_value())
-                    {
-                        rDrawing.m_meshRefCounts.ref_release(std::exchange(rScnRender.m_mesh[rDrawEnt], {}));
-                    }
-                    rScnRender.m_meshDirty  .push_back  (rDrawEnt);
-                    rScnRender.m_visible    .erase      (rDrawEnt);
-                    rMatPlanet.m_ents       .erase      (rDrawEnt);
-                    rMatPlanet.m_dirty      .push_back  (rDrawEnt);
-
-                    rScnRender.m_drawIds.remove(std::exchange(rDrawEnt, {}));
+                    delete_draw_ent(rDrawEnt);
                 }
             }
+            rTrnDbgDraw.built = false;
+            return;
+        }
+
+        ChunkSkeleton const &rSkCh = rTerrain.skChunks;
+        rTrnDbgDraw.verts.resize(rSkCh.m_sharedIds.capacity());
+
+        auto const add_draw_ent = [&rScnRender, &rTrnDbgDraw] (SharedVrtxId const sharedVrtx)
+        {
+            DrawEnt &rDrawEnt = rTrnDbgDraw.verts[sharedVrtx];
+            if ( ! rDrawEnt.has_value() )
+            {
+                rDrawEnt = rScnRender.m_drawIds.create();
+            }
+            rTrnDbgDraw.toPlace.push_back(sharedVrtx);
+        };
+
+        if ( ! rTrnDbgDraw.built )
+        {
+            for (SharedVrtxId const sharedVrtx : rSkCh.m_sharedIds)
+            {
+                add_draw_ent(sharedVrtx);
+            }
+            rTrnDbgDraw.built = true;
+            return;
+        }
+
+        // Deltas stay around until the next update, so these can be applied again if there was
+        // no update since. Removed IDs may have been reused by sharedAdded.
+        ChunkScratchpad const &rChSP = rTerrain.chunkSP;
+        for (SharedVrtxId const sharedVrtx : rChSP.sharedRemoved)
+        {
+            if (   ! rSkCh.m_sharedIds.exists(sharedVrtx)
+                && rTrnDbgDraw.verts[sharedVrtx].has_value() )
+            {
+                delete_draw_ent(rTrnDbgDraw.verts[sharedVrtx]);
+            }
+        }
+        for (SharedVrtxId const sharedVrtx : rChSP.sharedAdded)
+        {
+            add_draw_ent(sharedVrtx);
         }
 
         // New DrawEnts may have been created. We can't access rScnRender's members with the new
         // entities yet, since they have not yet been resized.
         //
         // rScnRender will be resized afterwards by a task with tgScnRdr.drawEntResized(Run),
-        // before moving on to "Manage DrawEnts for each terrain SkVrtxId"
+        // before moving on to "Arrange shared vertex DrawEnts as tiny cubes"
     });
 
     rBuilder.task()
-        .name       ("Arrange SkVrtxId DrawEnts as tiny cubes")
+        .name       ("Arrange shared vertex DrawEnts as tiny cubes")
         .run_on     ({tgScnRdr.render(Run)})
         .sync_with  ({tgTrn.skeleton(Ready), tgScnRdr.drawEnt(Ready), tgScnRdr.drawTransforms(Modify_), tgScnRdr.entMeshDirty(Modify_), tgScnRdr.materialDirty(Modify_), tgScnRdr.drawEntResized(Done)})
         .push_to    (out.m_tasks)
-        .args       ({        idDrawing,                 idScnRender,             idNMesh,                        idTrnDbgDraw,                   idTerrain,                      idTerrainIco })
-        .func([] (ACtxDrawing& rDrawing, ACtxSceneRender& rScnRender, NamedMeshes& rNMesh, TerrainDebugDraw const& rTrnDbgDraw, ACtxTerrain const &rTerrain, ACtxTerrainIco const &rTerrainIco) noexcept
+        .args       ({        idDrawing,                 idScnRender,             idNMesh,                  idTrnDbgDraw,                   idTerrain })
+        .func([] (ACtxDrawing& rDrawing, ACtxSceneRender& rScnRender, NamedMeshes& rNMesh, TerrainDebugDraw& rTrnDbgDraw, ACtxTerrain const &rTerrain) noexcept
     {
-        Material                         &rMatPlanet = rScnRender.m_materials[rTrnDbgDraw.mat];
-        MeshId                     const cubeMeshId  = rNMesh.m_shapeToMesh.at(EShape::Box);
-        SubdivIdRegistry<SkVrtxId> const &vrtxIds    = rTerrain.skeleton.vrtx_ids();
+        if (rTrnDbgDraw.toPlace.empty())
+        {
+            return;
+        }
 
-        for (SkVrtxId const skVert : vrtxIds)
+        Material                  &rMatPlanet = rScnRender.m_materials[rTrnDbgDraw.mat];
+        MeshId              const cubeMeshId  = rNMesh.m_shapeToMesh.at(EShape::Box);
+        ChunkMeshBufferInfo const &rChInfo    = rTerrain.chunkInfo;
+
+        for (SharedVrtxId const sharedVrtx : rTrnDbgDraw.toPlace)
         {
-            DrawEnt  const drawEnt = rTrnDbgDraw.verts[skVert];
+            DrawEnt const drawEnt = rTrnDbgDraw.verts[sharedVrtx];
 
             if ( ! rScnRender.m_mesh[drawEnt].has_value() )
             {
@@ -635,14 +956,128 @@ Session setup_terrain_debug_draw(
                 rMatPlanet.m_dirty.push_back(drawEnt);
             }
 
+            // Scaled shared vertex positions are already in the chunk vertex buffer
             rScnRender.m_drawTransform[drawEnt]
-                = Matrix4::translation(Vector3(rTerrain.skData.positions[skVert]) / int_2pow<int>(rTerrain.skData.precision))
+                = Matrix4::translation(rTerrain.chunkGeom.chunkVbufPos[rChInfo.vbufSharedOffset + sharedVrtx.value])
                 * Matrix4::scaling({0.05f, 0.05f, 0.05f});
         }
+        rTrnDbgDraw.toPlace.clear();
     });
 
     return out;
 }
 
+Session setup_uni_terrains(
+        TopTaskBuilder&             rBuilder,
+        ArrayView<entt::any>  const topData,
+        Session               const &uniCore,
+        Session               const &uniScnFrame,
+        Session               const &uniTestPlanets,
+        TerrainTestPlanetSpecs const specs)
+{
+    using namespace osp::universe;
+
+    OSP_DECLARE_GET_DATA_IDS(uniCore,        TESTAPP_DATA_UNI_CORE);
+    OSP_DECLARE_GET_DATA_IDS(uniScnFrame,    TESTAPP_DATA_UNI_SCENEFRAME);
+    OSP_DECLARE_GET_DATA_IDS(uniTestPlanets, TESTAPP_DATA_UNI_PLANETS);
+
+    auto const tgUCore = uniCore    .get_pipelines<PlUniCore>();
+    auto const tgUSFrm = uniScnFrame.get_pipelines<PlUniSceneFrame>();
+
+    auto const &rUniverse         = top_get< Universe >              (topData, idUniverse);
+    auto const &rSatSurfaceSpaces = top_get< std::vector<CoSpaceId> >(topData, idSatSurfaceSpaces);
+
+    Session out;
+    OSP_DECLARE_CREATE_DATA_IDS(out, topData, TESTAPP_DATA_UNI_TERRAINS);
+
+    auto &rUniTerrains = top_emplace< ACtxUniTerrains >(topData, idUniTerrains);
+    rUniTerrains.surfaces       = rSatSurfaceSpaces;
+    rUniTerrains.specs          = specs;
+    rUniTerrains.updateDistance = 4.0 * (specs.radius + specs.height);
+    rUniTerrains.terrains.resize(rUniverse.m_coordIds.capacity());
+
+    // The LUT only depends on the chunk subdiv level, so generate it while the rest of the
+    // scenario is set up instead of stalling the first update that comes near a planet
+    rUniTerrains.lutPending = setup_async("make_chunk_vrtx_subdiv_lut", [levels = specs.chunkSubdivLevels] ()
+    {
+        return std::make_shared<ChunkFillSubdivLUT const>(make_chunk_vrtx_subdiv_lut(levels));
+    });
+
+    rBuilder.task()
+        .name       ("Update terrains near the SceneFrame")
+        .run_on     ({tgUCore.update(Run)})
+        .sync_with  ({tgUSFrm.sceneFrame(Ready)})
+        .push_to    (out.m_tasks)
+        .args       ({             idScnFrame,                idUniTerrains })
+        .coro([] (SceneFrame const& rScnFrame, ACtxUniTerrains &rUniTerrains, WorkerContext ctx) noexcept -> TopCoro
+    {
+        // SceneFrame position is only relative to the planet center while it's in the planet's
+        // surface coordinate space
+        auto const near_surface = [&rScnFrame, &rUniTerrains] (CoSpaceId const surface, Vector3d &rPosMeters) noexcept -> bool
+        {
+            if (rScnFrame.m_parent != surface)
+            {
+                return false;
+            }
+            Vector3d const cameraPos = rScnFrame.m_rotation.transformVector(Vector3d(rScnFrame.m_scenePosition));
+            rPosMeters = (Vector3d(rScnFrame.m_position) + cameraPos) * mul_2pow<double, int>(1.0, -rScnFrame.m_precision);
+            return rPosMeters.length() < rUniTerrains.updateDistance;
+        };
+
+        for (CoSpaceId const surface : rUniTerrains.surfaces)
+        {
+            std::unique_ptr<UniTerrain> &rpUniTerrain = rUniTerrains.terrains[surface];
+
+            Vector3d posMeters;
+            if ( ! near_surface(surface, posMeters) )
+            {
+                if (rpUniTerrain != nullptr)
+                {
+                    rpUniTerrain->frame.active = false;
+                }
+                continue;
+            }
+
+            if (rpUniTerrain == nullptr)
+            {
+                rpUniTerrain = std::make_unique<UniTerrain>();
+                if (rUniTerrains.lut == nullptr && rUniTerrains.lutPending.valid())
+                {
+                    rUniTerrains.lut = rUniTerrains.lutPending.get();
+                    rUniTerrains.lutPending = {};
+                }
+                initialize_ico_terrain(rpUniTerrain->terrain, rpUniTerrain->ico, rUniTerrains.specs, rUniTerrains.lut);
+                rUniTerrains.lut = rpUniTerrain->terrain.chunkSP.lut;
+
+                // Creating the skeleton already took a good part of the frame, leave the first
+                // subdivide for the next one. The universe update is held here until then.
+                co_await top_yield();
+
+                if ( ! near_surface(surface, posMeters) )
+                {
+                    rpUniTerrain->frame.active = false;
+                    continue;
+                }
+            }
+
+            UniTerrain &rUniTerrain = *rpUniTerrain;
+            rUniTerrain.frame.active   = true;
+            rUniTerrain.frame.position = Vector3l(posMeters * mul_2pow<double, int>(1.0, rUniTerrain.terrain.skData.precision));
+            rUniTerrain.frame.rotation = rScnFrame.m_rotation;
+
+            update_terrain_skeleton(rUniTerrain.frame, rUniTerrain.terrain, rUniTerrain.ico, ctx.m_parallelFor);
+            update_terrain_chunks(rUniTerrain.frame, rUniTerrain.terrain, rUniTerrain.ico, ctx.m_parallelFor);
+
+            // Nothing else reads surface changes of universe terrains yet
+            rUniTerrain.terrain.scratchpad.surfaceAdded  .clear();
+            rUniTerrain.terrain.scratchpad.surfaceRemoved.clear();
+        }
+
+        co_return TaskActions{};
+    });
+
+    return out;
+} // setup_uni_terrains
+
 
 } // namespace testapp::scenes
@@ -29,10 +29,17 @@
 
 #include <osp/core/math_types.h>
 #include <osp/drawing/draw_ent.h>
+#include <osp/universe/universe.h>
 
 #include <planet-a/skeleton.h>
 #include <planet-a/skeleton_subdiv.h>
 #include <planet-a/chunk_generate.h>
+#include <planet-a/chunk_store.h>
+#include <planet-a/height_noise.h>
+
+#include <future>
+#include <memory>
+#include <vector>
 
 namespace testapp::scenes
 {
@@ -61,8 +68,30 @@ struct ACtxTerrain
     planeta::ChunkMeshBufferInfo        chunkInfo{};
     planeta::BasicChunkMeshGeometry     chunkGeom;
 
+    /// Parts of chunkGeom modified by the last chunk update
+    planeta::ChunkMeshDirtyRanges       chunkDirty;
+
+    /// Fill vertices of recently removed chunks, reused if the same chunks are added back soon
+    planeta::ChunkFillCache             fillCache;
+
+    /// Fill vertices of chunks generated in previous sessions, not open if unused
+    planeta::ChunkDiskStore             chunkStore;
+
     planeta::ChunkScratchpad            chunkSP;
     planeta::SkeletonSubdivScratchpad   scratchpad;
+
+    /// Max distance-triggered skeleton subdivisions per update, see
+    /// SkeletonSubdivScratchpad::subdivBudgetLeft. Detail fills in over several updates after
+    /// large camera jumps instead of in one long update.
+    std::uint32_t                       subdivBudget{planeta::SkeletonSubdivScratchpad::smc_unlimited};
+
+    /// Updates between SubdivTriangleSkeleton::tri_group_reorder calls, 0 to never reorder
+    std::uint32_t                       reorderPeriod{0};
+    std::uint32_t                       updatesSinceReorder{0};
+
+    // Displacement applied to new skeleton vertices through SkeletonSubdivScratchpad::onVrtxBatch
+    planeta::HeightNoiseParams          heightNoise;
+    planeta::HeightNoiseScratch         heightNoiseScratch;
 };
 
 struct ACtxTerrainIco
@@ -123,6 +152,13 @@ struct TerrainTestPlanetSpecs
     /// Number of times an initial triangle is subdivided to form a chunk.
     /// Due to bugs (LOL XD): Minimum is 2, Maximum is 8.
     std::uint8_t    chunkSubdivLevels   {};
+
+    /// Max height noise displacement of skeleton vertices in meters, limited to height.
+    /// 0 to disable.
+    float           noiseAmplitude      {0.0f};
+
+    /// File to store generated chunks in and load them from in later runs. nullptr to disable.
+    char const*     chunkStorePath      {nullptr};
 };
 
 
@@ -137,7 +173,51 @@ void initialize_ico_terrain(
 
 
 /**
- * @brief Uses camera target as position relative to planet, and visualizes terrain skeleton.
+ * @brief Allocate and set parameters for a icosahedron planet not tied to a Session
+ *
+ * @param lut [in] LUT from another terrain to share, a new one is made if null or for a different
+ *                 chunk subdiv level
+ */
+void initialize_ico_terrain(
+        ACtxTerrain                                         &rTerrain,
+        ACtxTerrainIco                                      &rTerrainIco,
+        TerrainTestPlanetSpecs                              params,
+        std::shared_ptr<planeta::ChunkFillSubdivLUT const>  lut);
+
+/**
+ * @brief Unsubdivide and subdivide a terrain's skeleton around its ACtxTerrainFrame::position
+ *
+ * @param parallelFor [in] Splits distance tests across threads, such as a task's
+ *                         WorkerContext::m_parallelFor
+ */
+void update_terrain_skeleton(
+        ACtxTerrainFrame    const &terrainFrame,
+        ACtxTerrain               &rTerrain,
+        ACtxTerrainIco            &rTerrainIco,
+        osp::ParallelFor    const &parallelFor = {});
+
+/**
+ * @brief Create and remove chunks following skeleton surface changes, then update chunk meshes
+ *
+ * SkeletonSubdivScratchpad::surfaceAdded and surfaceRemoved are left for other users to read,
+ * and must be cleared before the next update_terrain_skeleton. Chunks far enough from
+ * terrainFrame's position past their unsubdivide distance are drawn at a reduced resolution.
+ *
+ * @param parallelFor [in] Splits per-chunk work across threads, such as a task's
+ *                         WorkerContext::m_parallelFor
+ */
+void update_terrain_chunks(
+        ACtxTerrainFrame    const &terrainFrame,
+        ACtxTerrain               &rTerrain,
+        ACtxTerrainIco      const &terrainIco,
+        osp::ParallelFor    const &parallelFor = {});
+
+/**
+ * @brief Uses camera target as position relative to planet, and visualizes vertices shared
+ *        between terrain chunks.
+ *
+ * The visualization is patched from each update's sharedAdded and sharedRemoved, and can be
+ * toggled with the "debug_terrain_draw" button. Nothing is done while it's off.
  */
 osp::Session setup_terrain_debug_draw(
         osp::TopTaskBuilder&        rBuilder,
@@ -150,4 +230,67 @@ osp::Session setup_terrain_debug_draw(
         osp::Session          const &terrainIco,
         osp::draw::MaterialId       mat);
 
+
+/**
+ * @brief Terrain of a planet in a Universe, bound to the planet's surface coordinate space
+ */
+struct UniTerrain
+{
+    ACtxTerrainFrame                    frame;
+    ACtxTerrain                         terrain;
+    ACtxTerrainIco                      ico;
+};
+
+/**
+ * @brief Terrains for many planets, sharing what can be shared
+ *
+ * A planet's terrain is allocated the first time the SceneFrame comes near, and is only updated
+ * while the SceneFrame is within updateDistance in its surface coordinate space.
+ */
+struct ACtxUniTerrains
+{
+    /// Surface coordinate spaces that get terrains
+    std::vector<osp::universe::CoSpaceId>                               surfaces;
+
+    /// Null until first needed
+    osp::KeyedVec<osp::universe::CoSpaceId, std::unique_ptr<UniTerrain>> terrains;
+
+    /// Chunk fill LUT shared by all terrains
+    std::shared_ptr<planeta::ChunkFillSubdivLUT const>                  lut;
+
+    /// LUT being generated on another thread during setup, taken as lut when first needed
+    std::shared_future<std::shared_ptr<planeta::ChunkFillSubdivLUT const>> lutPending;
+
+    TerrainTestPlanetSpecs                                              specs;
+
+    /// Max distance in meters from the planet center to update its terrain
+    double                                                              updateDistance{};
+};
+
+/**
+ * @brief Icosahedron terrains for each planet of setup_uni_testplanets
+ */
+osp::Session setup_uni_terrains(
+        osp::TopTaskBuilder&        rBuilder,
+        osp::ArrayView<entt::any>   topData,
+        osp::Session          const &uniCore,
+        osp::Session          const &uniScnFrame,
+        osp::Session          const &uniTestPlanets,
+        TerrainTestPlanetSpecs      specs);
+
 } // namespace testapp::scenes
+
+namespace osp
+{
+
+/// Skeleton and chunk mesh data; the fill cache and scratchpads are bounded by their capacity
+template <>
+struct MemoryUsage<testapp::scenes::ACtxTerrain>
+{
+    static std::size_t heap_bytes(testapp::scenes::ACtxTerrain const& terrain) noexcept
+    {
+        return heap_bytes_sum(terrain.skeleton, terrain.skData, terrain.skChunks, terrain.chunkGeom);
+    }
+};
+
+} // namespace osp
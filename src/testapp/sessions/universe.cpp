@@ -30,10 +30,16 @@
 
 #include <osp/core/math_2pow.h>
 #include <osp/drawing/drawing.h>
+#include <osp/universe/coord_cache.h>
 #include <osp/universe/coordinates.h>
+#include <osp/universe/kepler.h>
+#include <osp/universe/nbody.h>
+#include <osp/universe/sat_frames.h>
 #include <osp/universe/universe.h>
 #include <osp/util/logging.h>
 
+#include <Corrade/Containers/ArrayViewStl.h>
+
 #include <random>
 
 using namespace adera;
@@ -44,6 +50,27 @@ using namespace osp;
 namespace testapp::scenes
 {
 
+/**
+ * @brief Give a planet DrawEnt unit sphere bounds and lower detail spheres for when it's small
+ */
+static void add_planet_lods(ACtxDrawing& rDrawing, ACtxSceneRender& rScnRender, NamedMeshes& rNMesh, DrawEnt const drawEnt)
+{
+    rScnRender.m_bounds[drawEnt] = {{}, 1.0f};
+
+    auto const [it, success] = rScnRender.m_lods.try_emplace(drawEnt);
+    if ( ! success )
+    {
+        return; // Already added by a previous resync
+    }
+
+    MeshLods &rLods = it->second;
+    rLods.m_meshes[0]           = rDrawing.m_meshRefCounts.ref_add(rNMesh.m_namedMeshs.at("sphere_lod1"));
+    rLods.m_meshes[1]           = rDrawing.m_meshRefCounts.ref_add(rNMesh.m_namedMeshs.at("sphere_lod2"));
+    rLods.m_maxScreenSize[0]    = 0.1f;
+    rLods.m_maxScreenSize[1]    = 0.02f;
+    rLods.m_count               = 2;
+}
+
 // Universe Scenario
 
 Session setup_uni_core(
@@ -134,27 +161,26 @@ Session setup_uni_testplanets(
     }
 
     // Coordinate space data is a single allocation partitioned to hold positions, velocities, and
-    // rotations.
-    // TODO: Alignment is needed for SIMD (not yet implemented). see Corrade alignedAlloc
+    // rotations. Each column is aligned to gc_satDataAlignment for SIMD.
 
     std::size_t bytesUsed = 0;
 
     // Positions and velocities are arranged as XXXX... YYYY... ZZZZ...
-    partition(bytesUsed, planetCount, rMainSpaceCommon.m_satPositions[0]);
-    partition(bytesUsed, planetCount, rMainSpaceCommon.m_satPositions[1]);
-    partition(bytesUsed, planetCount, rMainSpaceCommon.m_satPositions[2]);
-    partition(bytesUsed, planetCount, rMainSpaceCommon.m_satVelocities[0]);
-    partition(bytesUsed, planetCount, rMainSpaceCommon.m_satVelocities[1]);
-    partition(bytesUsed, planetCount, rMainSpaceCommon.m_satVelocities[2]);
+    partition_aligned(bytesUsed, planetCount, rMainSpaceCommon.m_satPositions[0]);
+    partition_aligned(bytesUsed, planetCount, rMainSpaceCommon.m_satPositions[1]);
+    partition_aligned(bytesUsed, planetCount, rMainSpaceCommon.m_satPositions[2]);
+    partition_aligned(bytesUsed, planetCount, rMainSpaceCommon.m_satVelocities[0]);
+    partition_aligned(bytesUsed, planetCount, rMainSpaceCommon.m_satVelocities[1]);
+    partition_aligned(bytesUsed, planetCount, rMainSpaceCommon.m_satVelocities[2]);
 
     // Rotations use XYZWXYZWXYZWXYZW...
-    partition(bytesUsed, planetCount, rMainSpaceCommon.m_satRotations[0],
-                                      rMainSpaceCommon.m_satRotations[1],
-                                      rMainSpaceCommon.m_satRotations[2],
-                                      rMainSpaceCommon.m_satRotations[3]);
+    partition_aligned(bytesUsed, planetCount, rMainSpaceCommon.m_satRotations[0],
+                                              rMainSpaceCommon.m_satRotations[1],
+                                              rMainSpaceCommon.m_satRotations[2],
+                                              rMainSpaceCommon.m_satRotations[3]);
 
     // Allocate data for all planets
-    rMainSpaceCommon.m_data = Array<unsigned char>{Corrade::NoInit, bytesUsed};
+    rMainSpaceCommon.m_data = sat_data_alloc(bytesUsed);
 
     // Create easily accessible array views for each component
     auto const [x, y, z]        = sat_views(rMainSpaceCommon.m_satPositions,  rMainSpaceCommon.m_data, planetCount);
@@ -194,14 +220,15 @@ Session setup_uni_testplanets(
     top_emplace< CoSpaceId >        (topData, idPlanetMainSpace, mainSpace);
     top_emplace< float >            (topData, tgUniDeltaTimeIn, 1.0f / 60.0f);
     top_emplace< CoSpaceIdVec_t >   (topData, idSatSurfaceSpaces, std::move(satSurfaceSpaces));
+    top_emplace< CoordTransformCache >(topData, idCoordCache);
 
     rBuilder.task()
         .name       ("Update planets")
         .run_on     (tgUCore.update(Run))
         .sync_with  ({tgUSFrm.sceneFrame(Modify)})
         .push_to    (out.m_tasks)
-        .args       ({     idUniverse,               idPlanetMainSpace,            idScnFrame,                      idSatSurfaceSpaces,           tgUniDeltaTimeIn })
-        .func([] (Universe& rUniverse, CoSpaceId const planetMainSpace, SceneFrame &rScnFrame, CoSpaceIdVec_t const& rSatSurfaceSpaces, float const uniDeltaTimeIn) noexcept
+        .args       ({     idUniverse,               idPlanetMainSpace,            idScnFrame,                      idSatSurfaceSpaces,           tgUniDeltaTimeIn,                    idCoordCache })
+        .func([] (Universe& rUniverse, CoSpaceId const planetMainSpace, SceneFrame &rScnFrame, CoSpaceIdVec_t const& rSatSurfaceSpaces, float const uniDeltaTimeIn, CoordTransformCache &rCoordCache) noexcept
     {
         CoSpaceCommon &rMainSpaceCommon = rUniverse.m_coordCommon[planetMainSpace];
 
@@ -242,6 +269,9 @@ Session setup_uni_testplanets(
             qw[i] = rot.scalar();
         }
 
+        // Surface spaces follow their planets
+        coord_cache_invalidate_sat_children(rCoordCache, rUniverse, planetMainSpace);
+
         // Phase 2: Transfers and stuff
 
         constexpr float captureDist = 500.0f;
@@ -270,11 +300,9 @@ Session setup_uni_testplanets(
                 OSP_LOG_INFO("Captured into Satellite {} under CoordSpace {}",
                              nearbyPlanet, int(rSatSurfaceSpaces[nearbyPlanet]));
 
-                CoSpaceId const surface         = rSatSurfaceSpaces[nearbyPlanet];
-                CoSpaceCommon  &rSurfaceCommon  = rUniverse.m_coordCommon[surface];
+                CoSpaceId const surface = rSatSurfaceSpaces[nearbyPlanet];
 
-                CoSpaceTransform const surfaceTf     = coord_get_transform(rSurfaceCommon, rSurfaceCommon, x, y, z, qx, qy, qz, qw);
-                CoordTransformer const mainToSurface = coord_parent_to_child(rMainSpaceCommon, surfaceTf);
+                CoordTransformer const mainToSurface = coord_cache_get(rCoordCache, rUniverse, planetMainSpace, surface);
 
                 // Transfer scene frame from Main to Surface coordinate space
                 rScnFrame.m_parent   = surface;
@@ -291,11 +319,9 @@ Session setup_uni_testplanets(
             {
                 OSP_LOG_INFO("Leaving planet");
 
-                CoSpaceId const surface       = rScnFrame.m_parent;
-                CoSpaceCommon &rSurfaceCommon = rUniverse.m_coordCommon[surface];
+                CoSpaceId const surface = rScnFrame.m_parent;
 
-                CoSpaceTransform const surfaceTf     = coord_get_transform(rSurfaceCommon, rSurfaceCommon, x, y, z, qx, qy, qz, qw);
-                CoordTransformer const surfaceToMain = coord_child_to_parent(rMainSpaceCommon, surfaceTf);
+                CoordTransformer const surfaceToMain = coord_cache_get(rCoordCache, rUniverse, surface, planetMainSpace);
 
                 // Transfer scene frame from Surface to Main coordinate space
                 rScnFrame.m_parent   = planetMainSpace;
@@ -311,6 +337,21 @@ Session setup_uni_testplanets(
 
 
 
+CoordTransformer testplanets_main_to_scene(CoordTransformCache& rCoordCache, Universe const& rUniverse, CoSpaceId const mainSpace, SceneFrame const& rScnFrame)
+{
+    if (rScnFrame.m_parent == mainSpace)
+    {
+        return coord_parent_to_child(rUniverse.m_coordCommon[mainSpace], rScnFrame);
+    }
+
+    CoSpaceId const landedId = rScnFrame.m_parent;
+
+    CoordTransformer const& mainToLanded = coord_cache_get(rCoordCache, rUniverse, mainSpace, landedId);
+    CoordTransformer const  landedToArea = coord_parent_to_child(rUniverse.m_coordCommon[landedId], rScnFrame);
+
+    return coord_composite(landedToArea, mainToLanded);
+}
+
 struct PlanetDraw
 {
     DrawEntVec_t            drawEnts;
@@ -370,7 +411,9 @@ Session setup_testplanets_draw(
 
         // check origin translation
         // ADL used for Magnum::Math::sign/floor/abs
-        float const maxDist = 512.0f;
+        // Rendering is camera-relative (see ViewProjMatrix), so this only needs to keep floats
+        // precise enough for the scene itself; ~0.5mm at 4096m
+        float const maxDist = 4096.0f;
         Vector3 const translate = sign(rCamPl) * floor(abs(rCamPl) / maxDist) * maxDist;
 
         if ( ! translate.isZero())
@@ -392,14 +435,9 @@ Session setup_testplanets_draw(
         .run_on     ({tgWin.resync(Run)})
         .sync_with  ({tgScnRdr.drawEntResized(ModifyOrSignal)})
         .push_to    (out.m_tasks)
-        .args       ({               idScnRender,            idPlanetDraw,          idUniverse,               idPlanetMainSpace})
-        .func([]    (ACtxSceneRender& rScnRender, PlanetDraw& rPlanetDraw, Universe& rUniverse, CoSpaceId const planetMainSpace) noexcept
+        .args       ({               idScnRender,            idPlanetDraw })
+        .func([]    (ACtxSceneRender& rScnRender, PlanetDraw& rPlanetDraw) noexcept
     {
-        CoSpaceCommon &rMainSpace = rUniverse.m_coordCommon[planetMainSpace];
-
-        rPlanetDraw.drawEnts.resize(rMainSpace.m_satCount, lgrn::id_null<DrawEnt>());
-
-        rScnRender.m_drawIds.create(rPlanetDraw.drawEnts   .begin(), rPlanetDraw.drawEnts   .end());
         rScnRender.m_drawIds.create(rPlanetDraw.axis       .begin(), rPlanetDraw.axis       .end());
         rPlanetDraw.attractor = rScnRender.m_drawIds.create();
     });
@@ -409,29 +447,15 @@ Session setup_testplanets_draw(
         .run_on     ({tgWin.resync(Run)})
         .sync_with  ({tgScnRdr.drawEntResized(Done), tgScnRdr.materialDirty(Modify_), tgScnRdr.entMeshDirty(Modify_)})
         .push_to    (out.m_tasks)
-        .args       ({           idDrawing,                 idScnRender,             idNMesh,            idPlanetDraw,          idUniverse,               idPlanetMainSpace})
-        .func([]    (ACtxDrawing& rDrawing, ACtxSceneRender& rScnRender, NamedMeshes& rNMesh, PlanetDraw& rPlanetDraw, Universe& rUniverse, CoSpaceId const planetMainSpace) noexcept
+        .args       ({           idDrawing,                 idScnRender,             idNMesh,            idPlanetDraw })
+        .func([]    (ACtxDrawing& rDrawing, ACtxSceneRender& rScnRender, NamedMeshes& rNMesh, PlanetDraw& rPlanetDraw) noexcept
     {
-        CoSpaceCommon &rMainSpace = rUniverse.m_coordCommon[planetMainSpace];
-
         Material &rMatPlanet = rScnRender.m_materials[rPlanetDraw.matPlanets];
         Material &rMatAxis   = rScnRender.m_materials[rPlanetDraw.matAxis];
 
         MeshId const sphereMeshId = rNMesh.m_shapeToMesh.at(EShape::Sphere);
         MeshId const cubeMeshId   = rNMesh.m_shapeToMesh.at(EShape::Box);
 
-        for (std::size_t i = 0; i < rMainSpace.m_satCount; ++i)
-        {
-            DrawEnt const drawEnt = rPlanetDraw.drawEnts[i];
-
-            rScnRender.m_mesh[drawEnt] = rDrawing.m_meshRefCounts.ref_add(sphereMeshId);
-            rScnRender.m_meshDirty.push_back(drawEnt);
-            rScnRender.m_visible.insert(drawEnt);
-            rScnRender.m_opaque.insert(drawEnt);
-            rMatPlanet.m_ents.insert(drawEnt);
-            rMatPlanet.m_dirty.push_back(drawEnt);
-        }
-
         rScnRender.m_mesh[rPlanetDraw.attractor] = rDrawing.m_meshRefCounts.ref_add(sphereMeshId);
         rScnRender.m_meshDirty.push_back(rPlanetDraw.attractor);
         rScnRender.m_visible.insert(rPlanetDraw.attractor);
@@ -455,38 +479,17 @@ Session setup_testplanets_draw(
     });
 
     rBuilder.task()
-        .name       ("Reposition test planet DrawEnts")
+        .name       ("Reposition test planet attractor DrawEnts")
         .run_on     ({tgScnRdr.render(Run)})
         .sync_with  ({tgScnRdr.drawTransforms(Modify_), tgScnRdr.drawEntResized(Done), tgCmCt.camCtrl(Ready), tgUSFrm.sceneFrame(Modify)})
         .push_to    (out.m_tasks)
-        .args       ({        idDrawing,                 idScnRender,            idPlanetDraw,          idUniverse,                  idScnFrame,               idPlanetMainSpace})
-        .func([] (ACtxDrawing& rDrawing, ACtxSceneRender& rScnRender, PlanetDraw& rPlanetDraw, Universe& rUniverse, SceneFrame const& rScnFrame, CoSpaceId const planetMainSpace) noexcept
+        .args       ({           idScnRender,            idPlanetDraw,          idUniverse,                  idScnFrame,               idPlanetMainSpace,                   idCoordCache })
+        .func([] (ACtxSceneRender& rScnRender, PlanetDraw& rPlanetDraw, Universe& rUniverse, SceneFrame const& rScnFrame, CoSpaceId const planetMainSpace, CoordTransformCache &rCoordCache) noexcept
     {
-
         CoSpaceCommon &rMainSpace = rUniverse.m_coordCommon[planetMainSpace];
-        auto const [x, y, z]        = sat_views(rMainSpace.m_satPositions, rMainSpace.m_data, rMainSpace.m_satCount);
-        auto const [qx, qy, qz, qw] = sat_views(rMainSpace.m_satRotations, rMainSpace.m_data, rMainSpace.m_satCount);
 
-        // Calculate transform from universe to area/local-space for rendering.
-        // This can be generalized by finding a common ancestor within the tree
-        // of coordinate spaces. Since there's only two possibilities, an if
-        // statement works.
-        CoordTransformer mainToArea;
-        if (rScnFrame.m_parent == planetMainSpace)
-        {
-            mainToArea = coord_parent_to_child(rMainSpace, rScnFrame);
-        }
-        else
-        {
-            CoSpaceId const landedId = rScnFrame.m_parent;
-            CoSpaceCommon &rLanded = rUniverse.m_coordCommon[landedId];
-
-            CoSpaceTransform const landedTf     = coord_get_transform(rLanded, rLanded, x, y, z, qx, qy, qz, qw);
-            CoordTransformer const mainToLanded = coord_parent_to_child(rMainSpace, landedTf);
-            CoordTransformer const landedToArea = coord_parent_to_child(landedTf, rScnFrame);
-
-            mainToArea = coord_composite(landedToArea, mainToLanded);
-        }
+        // Calculate transform from universe to area/local-space for rendering
+        CoordTransformer const mainToArea = testplanets_main_to_scene(rCoordCache, rUniverse, planetMainSpace, rScnFrame);
         Quaternion const mainToAreaRot{mainToArea.rotation()};
 
         float const scale = math::mul_2pow<float, int>(1.0f, -rMainSpace.m_precision);
@@ -511,22 +514,6 @@ Session setup_testplanets_draw(
             = Matrix4::translation(attractorPos)
             * Matrix4{mainToAreaRot.toMatrix()}
             * Matrix4::scaling({10, 10, 500000});
-
-        for (std::size_t i = 0; i < rMainSpace.m_satCount; ++i)
-        {
-            Vector3g const relative = mainToArea.transform_position({x[i], y[i], z[i]});
-            Vector3 const relativeMeters = Vector3(relative) * scale;
-
-            Quaterniond const rot{{qx[i], qy[i], qz[i]}, qw[i]};
-
-            DrawEnt const drawEnt = rPlanetDraw.drawEnts[i];
-
-            rScnRender.m_drawTransform[drawEnt]
-                = Matrix4::translation(relativeMeters)
-                * Matrix4::scaling({200, 200, 200})
-                * Matrix4{(mainToAreaRot * Quaternion{rot}).toMatrix()};
-        }
-
     });
 
     return out;
@@ -584,31 +571,30 @@ Session setup_solar_system_testplanets(
     }
 
     // Coordinate space data is a single allocation partitioned to hold positions, velocities, and
-    // rotations.
-    // TODO: Alignment is needed for SIMD (not yet implemented). see Corrade alignedAlloc
+    // rotations. Each column is aligned to gc_satDataAlignment for SIMD.
 
     std::size_t bytesUsed = 0;
 
     // Positions and velocities are arranged as XXXX... YYYY... ZZZZ...
-    partition(bytesUsed, c_planetCount, rMainSpaceCommon.m_satPositions[0]);
-    partition(bytesUsed, c_planetCount, rMainSpaceCommon.m_satPositions[1]);
-    partition(bytesUsed, c_planetCount, rMainSpaceCommon.m_satPositions[2]);
-    partition(bytesUsed, c_planetCount, rMainSpaceCommon.m_satVelocities[0]);
-    partition(bytesUsed, c_planetCount, rMainSpaceCommon.m_satVelocities[1]);
-    partition(bytesUsed, c_planetCount, rMainSpaceCommon.m_satVelocities[2]);
+    partition_aligned(bytesUsed, c_planetCount, rMainSpaceCommon.m_satPositions[0]);
+    partition_aligned(bytesUsed, c_planetCount, rMainSpaceCommon.m_satPositions[1]);
+    partition_aligned(bytesUsed, c_planetCount, rMainSpaceCommon.m_satPositions[2]);
+    partition_aligned(bytesUsed, c_planetCount, rMainSpaceCommon.m_satVelocities[0]);
+    partition_aligned(bytesUsed, c_planetCount, rMainSpaceCommon.m_satVelocities[1]);
+    partition_aligned(bytesUsed, c_planetCount, rMainSpaceCommon.m_satVelocities[2]);
 
     // Rotations use XYZWXYZWXYZWXYZW...
-    partition(bytesUsed, c_planetCount, rMainSpaceCommon.m_satRotations[0],
+    partition_aligned(bytesUsed, c_planetCount, rMainSpaceCommon.m_satRotations[0],
         rMainSpaceCommon.m_satRotations[1],
         rMainSpaceCommon.m_satRotations[2],
         rMainSpaceCommon.m_satRotations[3]);
 
-    partition(bytesUsed, c_planetCount, rCoordNBody[mainSpace].mass);
-    partition(bytesUsed, c_planetCount, rCoordNBody[mainSpace].radius);
-    partition(bytesUsed, c_planetCount, rCoordNBody[mainSpace].color);
+    partition_aligned(bytesUsed, c_planetCount, rCoordNBody[mainSpace].mass);
+    partition_aligned(bytesUsed, c_planetCount, rCoordNBody[mainSpace].radius);
+    partition_aligned(bytesUsed, c_planetCount, rCoordNBody[mainSpace].color);
 
     // Allocate data for all planets
-    rMainSpaceCommon.m_data = Array<unsigned char>{ Corrade::NoInit, bytesUsed };
+    rMainSpaceCommon.m_data = sat_data_alloc(bytesUsed);
 
     std::size_t nextBody = 0;
     auto const add_body = [&rMainSpaceCommon, &nextBody, &rCoordNBody, &mainSpace] (
@@ -692,6 +678,12 @@ Session setup_solar_system_testplanets(
         550.0f,
         { 1.0f, 0.5f, 0.0f });
 
+    // Planets barely pull on each other, so they orbit the Sun on rails until something
+    // disturbs them. See rails_check_perturbations.
+    CoSpaceNBody &rMainNBody = rCoordNBody[mainSpace];
+    rMainNBody.rails.attractor = 0;
+    rMainNBody.rails.gm        = rMainNBody.params.gravConstant * rMainNBody.mass.view(arrayView(rMainSpaceCommon.m_data), c_planetCount)[0];
+
     top_emplace< CoSpaceId >(topData, idPlanetMainSpace, mainSpace);
     top_emplace< float >(topData, tgUniDeltaTimeIn, 1.0f / 60.0f);
     top_emplace< CoSpaceIdVec_t >(topData, idSatSurfaceSpaces, std::move(satSurfaceSpaces));
@@ -708,44 +700,22 @@ Session setup_solar_system_testplanets(
         .sync_with({ tgUSFrm.sceneFrame(Modify) })
         .push_to(out.m_tasks)
         .args({ idUniverse,               idPlanetMainSpace,            idScnFrame,                      idSatSurfaceSpaces,           tgUniDeltaTimeIn,                                        idCoordNBody })
-        .func([](Universe& rUniverse, CoSpaceId const planetMainSpace, SceneFrame& rScnFrame, CoSpaceIdVec_t const& rSatSurfaceSpaces, float const uniDeltaTimeIn, osp::KeyedVec<CoSpaceId, CoSpaceNBody>& rCoordNBody) noexcept
+        .func([](Universe& rUniverse, CoSpaceId const planetMainSpace, SceneFrame& rScnFrame, CoSpaceIdVec_t const& rSatSurfaceSpaces, float const uniDeltaTimeIn, osp::KeyedVec<CoSpaceId, CoSpaceNBody>& rCoordNBody, WorkerContext ctx) noexcept
     {
         CoSpaceCommon& rMainSpaceCommon = rUniverse.m_coordCommon[planetMainSpace];
 
-        auto const scale = osp::math::mul_2pow<double, int>(1.0, -rMainSpaceCommon.m_precision);
-        double const scaleDelta = uniDeltaTimeIn / scale;
-
-        auto const [x, y, z] = sat_views(rMainSpaceCommon.m_satPositions, rMainSpaceCommon.m_data, rMainSpaceCommon.m_satCount);
-        auto const [vx, vy, vz] = sat_views(rMainSpaceCommon.m_satVelocities, rMainSpaceCommon.m_data, rMainSpaceCommon.m_satCount);
-
-        auto const massView = rCoordNBody[planetMainSpace].mass.view(arrayView(rMainSpaceCommon.m_data), c_planetCount);
-
-        for (std::size_t i = 0; i < rMainSpaceCommon.m_satCount; ++i) {
-            x[i] += vx[i] * scaleDelta;
-            y[i] += vy[i] * scaleDelta;
-            z[i] += vz[i] * scaleDelta;
-
-            for (std::size_t j = 0; j < rMainSpaceCommon.m_satCount; ++j) {
-                if (i == j) { continue; }
-
-                double iMass = massView[i];
-                double jMass = massView[j];
+        CoSpaceNBody &rNBody = rCoordNBody[planetMainSpace];
 
-                Vector3d const iPos = Vector3d(Vector3g(x[i], y[i], z[i])) * scale;
-                Vector3d const jPos = Vector3d(Vector3g(x[j], y[j], z[j])) * scale;
+        auto const massView = rNBody.mass.view(arrayView(rMainSpaceCommon.m_data), rMainSpaceCommon.m_satCount);
 
-                double r = (jPos - iPos).length();
-                Vector3d direction = (jPos - iPos).normalized();
+        nbody_step(rNBody.scratch, rNBody.params, rMainSpaceCommon, massView, uniDeltaTimeIn, {}, ctx.m_parallelFor, rNBody.rails.onRails);
 
-                double forceMagnitude = (iMass * jMass) / (r * r);
-                Vector3d force = direction * forceMagnitude;
-                Vector3d acceleration = (force / iMass);
+        // Moves the satellites nbody_step skipped, then uses this step's accelerations to decide
+        // which satellites get on or off rails for the next
+        rails_update(rNBody.rails, rMainSpaceCommon, uniDeltaTimeIn);
+        rails_check_perturbations(rNBody.rails, rMainSpaceCommon, rNBody.scratch);
 
-                vx[i] += acceleration.x() * uniDeltaTimeIn;
-                vy[i] += acceleration.y() * uniDeltaTimeIn;
-                vz[i] += acceleration.z() * uniDeltaTimeIn;
-            }
-        }
+        sat_frames_publish(rNBody.frames, rMainSpaceCommon, sat_frames_latest_time(rNBody.frames) + uniDeltaTimeIn);
     });
 
     return out;
@@ -801,7 +771,9 @@ Session setup_solar_system_planets_draw(
 
         // check origin translation
         // ADL used for Magnum::Math::sign/floor/abs
-        float const maxDist = 512.0f;
+        // Rendering is camera-relative (see ViewProjMatrix), so this only needs to keep floats
+        // precise enough for the scene itself; ~0.5mm at 4096m
+        float const maxDist = 4096.0f;
         Vector3 const translate = sign(rCamPl) * floor(abs(rCamPl) / maxDist) * maxDist;
 
         if (!translate.isZero())
@@ -858,6 +830,7 @@ Session setup_solar_system_planets_draw(
             rScnRender.m_opaque.insert(drawEnt);
             rMatPlanet.m_ents.insert(drawEnt);
             rMatPlanet.m_dirty.push_back(drawEnt);
+            add_planet_lods(rDrawing, rScnRender, rNMesh, drawEnt);
 
             rScnRender.m_color[drawEnt] = colorView[i];
         }
@@ -872,9 +845,17 @@ Session setup_solar_system_planets_draw(
         .func([](ACtxDrawing& rDrawing, ACtxSceneRender& rScnRender, PlanetDraw& rPlanetDraw, Universe& rUniverse, SceneFrame const& rScnFrame, CoSpaceId const planetMainSpace, osp::KeyedVec<CoSpaceId, CoSpaceNBody>& rCoordNBody) noexcept
     {
         CoSpaceCommon& rMainSpace = rUniverse.m_coordCommon[planetMainSpace];
-        auto const [x, y, z] = sat_views(rMainSpace.m_satPositions, rMainSpace.m_data, rMainSpace.m_satCount);
-        auto const [qx, qy, qz, qw] = sat_views(rMainSpace.m_satRotations, rMainSpace.m_data, rMainSpace.m_satCount);
-        auto const radiusView = rCoordNBody[planetMainSpace].radius.view(arrayView(rMainSpace.m_data), c_planetCount);
+        SatDataFrames const& frames = rCoordNBody[planetMainSpace].frames;
+        if (frames.published == 0)
+        {
+            return;
+        }
+
+        // Read the latest published frame instead of m_data, which the simulation may be writing
+        CoSpaceSatData const& frame = sat_frames_latest(frames);
+        auto const [x, y, z] = sat_views(frame.m_satPositions, frame.m_data, frame.m_satCount);
+        auto const [qx, qy, qz, qw] = sat_views(frame.m_satRotations, frame.m_data, frame.m_satCount);
+        auto const radiusView = rCoordNBody[planetMainSpace].radius.view(arrayView(frame.m_data), c_planetCount);
 
         // Calculate transform from universe to area/local-space for rendering.
         // This can be generalized by finding a common ancestor within the tree
@@ -900,7 +881,7 @@ Session setup_solar_system_planets_draw(
 
         float const f = math::mul_2pow<float, int>(1.0f, -rMainSpace.m_precision);
 
-        for (std::size_t i = 0; i < rMainSpace.m_satCount; ++i)
+        for (std::size_t i = 0; i < frame.m_satCount; ++i)
         {
             Vector3g const relative = mainToArea.transform_position({ x[i], y[i], z[i] });
             Vector3 const relativeMeters = Vector3(relative);
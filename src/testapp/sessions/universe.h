@@ -27,6 +27,10 @@
 #include "../scenarios.h"
 
 #include "osp/universe/universe.h"
+#include <osp/universe/coord_cache.h>
+#include <osp/universe/kepler.h>
+#include <osp/universe/nbody.h>
+#include <osp/universe/sat_frames.h>
 #include <osp/drawing/drawing.h>
 
 namespace testapp::scenes
@@ -60,8 +64,24 @@ osp::Session setup_uni_testplanets(
         osp::Session const&         uniScnFrame);
 
 
+/**
+ * @brief Transform from the main coordinate space of setup_uni_testplanets into the SceneFrame,
+ *        which is parented to either the main space or one of the planets' surface spaces
+ *
+ * The main space to surface part comes from rCoordCache, invalidated by "Update planets" each
+ * time the planets move.
+ */
+osp::universe::CoordTransformer testplanets_main_to_scene(
+        osp::universe::CoordTransformCache& rCoordCache,
+        osp::universe::Universe const&      rUniverse,
+        osp::universe::CoSpaceId            mainSpace,
+        osp::universe::SceneFrame const&    rScnFrame);
+
 /**
  * @brief Draw universe, specifically designed for setup_uni_test_planets
+ *
+ * Only draws the attractor and axes; the planets themselves are drawn by
+ * setup_testplanets_draw_magnum without a DrawEnt each.
  */
 osp::Session setup_testplanets_draw(
         osp::TopTaskBuilder&        rBuilder,
@@ -83,6 +103,15 @@ struct CoSpaceNBody
     osp::universe::TypedStrideDesc<float> mass;
     osp::universe::TypedStrideDesc<float> radius;
     osp::universe::TypedStrideDesc<Magnum::Color3> color;
+
+    osp::universe::NBodyParams params;
+    osp::universe::NBodyState scratch;
+
+    /// Satellites that barely feel anything but the attractor move along fixed orbits
+    osp::universe::SatRails rails;
+
+    /// Published after each step, read by drawing
+    osp::universe::SatDataFrames frames;
 };
 
 /**
@@ -29,10 +29,12 @@
 #include <adera/machines/links.h>
 
 #include <osp/activescene/basic.h>
+#include <osp/activescene/basic_fn.h>
 #include <osp/activescene/physics.h>
 #include <osp/activescene/prefab_fn.h>
 #include <osp/core/Resources.h>
 #include <osp/drawing/drawing.h>
+#include <osp/drawing/merge_draw.h>
 #include <osp/util/UserInputHandler.h>
 
 using namespace adera;
@@ -56,6 +58,7 @@ Session setup_parts(
         Session const&              scene)
 {
     OSP_DECLARE_GET_DATA_IDS(application,   TESTAPP_DATA_APPLICATION);
+    OSP_DECLARE_GET_DATA_IDS(scene,         TESTAPP_DATA_SCENE);
 
     auto const tgScn = scene.get_pipelines<PlScene>();
 
@@ -80,6 +83,7 @@ Session setup_parts(
     rBuilder.pipeline(tgParts.mapWeldActive)    .parent(tgScn.update);
     rBuilder.pipeline(tgParts.machUpdExtIn)     .parent(tgScn.update);
     rBuilder.pipeline(tgParts.linkLoop)         .parent(tgScn.update).loops(true);
+    rBuilder.pipeline(tgParts.machDirty)        .parent(tgParts.linkLoop);
 
     auto &rScnParts = top_emplace< ACtxParts >      (topData, idScnParts);
     auto &rUpdMach  = top_emplace< MachineUpdater > (topData, idUpdMach);
@@ -88,6 +92,7 @@ Session setup_parts(
     // These Global IDs are dynamically initialized just as the program starts
     rUpdMach.machTypesDirty.resize(MachTypeReg_t::size());
     rUpdMach.localDirty       .resize(MachTypeReg_t::size());
+    rUpdMach.wakeRequests     .resize(MachTypeReg_t::size());
     rScnParts.machines.perType.resize(MachTypeReg_t::size());
     rScnParts.nodePerType     .resize(NodeTypeReg_t::size());
 
@@ -106,6 +111,7 @@ Session setup_parts(
 
     rBuilder.task()
         .name       ("Clear Part dirty vectors after use")
+        .cheap      ()
         .run_on     ({tgParts.partDirty(Clear)})
         .push_to    (out.m_tasks)
         .args       ({      idScnParts})
@@ -116,6 +122,7 @@ Session setup_parts(
 
     rBuilder.task()
         .name       ("Clear Weld dirty vectors after use")
+        .cheap      ()
         .run_on     ({tgParts.weldDirty(Clear)})
         .push_to    (out.m_tasks)
         .args       ({      idScnParts})
@@ -124,6 +131,71 @@ Session setup_parts(
         rScnParts.weldDirty.clear();
     });
 
+    rBuilder.task()
+        .name       ("Compile signal levels when wiring changes")
+        .run_on     ({tgScn.update(Run)})
+        .sync_with  ({tgParts.machIds(Ready), tgParts.connect(Ready), tgParts.machUpdExtIn(New)})
+        .push_to    (out.m_tasks)
+        .args       ({            idScnParts,                 idUpdMach})
+        .func([] (ACtxParts const& rScnParts, MachineUpdater& rUpdMach) noexcept
+    {
+        if (rUpdMach.levelsRevision == rScnParts.connectRevision)
+        {
+            return; // Wiring didn't change
+        }
+        rUpdMach.levelsRevision = rScnParts.connectRevision;
+
+        compile_signal_levels(rScnParts.machines,
+                              {rScnParts.nodePerType.data(), rScnParts.nodePerType.size()},
+                              rUpdMach);
+    });
+
+    rBuilder.task()
+        .name       ("Wake up sleeping machines with timers that ran out")
+        .run_on     ({tgScn.update(Run)})
+        .sync_with  ({tgParts.machUpdExtIn(Modify)})
+        .push_to    (out.m_tasks)
+        .args       ({            idDeltaTimeIn,                idUpdMach})
+        .func([] (float const deltaTimeIn, MachineUpdater& rUpdMach) noexcept
+    {
+        if (update_wake_timers(rUpdMach, deltaTimeIn))
+        {
+            rUpdMach.requestMachineUpdateLoop = true;
+        }
+    });
+
+    rBuilder.task()
+        .name       ("Clear dirty machines of the previous link update iteration")
+        .run_on     ({tgParts.linkLoop(EStgLink::NodeUpd)})
+        .sync_with  ({tgParts.machDirty(Delete)})
+        .push_to    (out.m_tasks)
+        .args       ({           idUpdMach})
+        .func([] (MachineUpdater& rUpdMach) noexcept
+    {
+        for (MachTypeId const machTypeDirty : rUpdMach.machTypesDirty)
+        {
+            rUpdMach.localDirty[machTypeDirty].clear();
+        }
+        rUpdMach.machTypesDirty.clear();
+    });
+
+    rBuilder.task()
+        .name       ("Release lowest pending signal level")
+        .run_on     ({tgParts.linkLoop(EStgLink::NodeUpd)})
+        .sync_with  ({tgParts.machDirty(Ready)})
+        .push_to    (out.m_tasks)
+        .args       ({            idScnParts,                 idUpdMach})
+        .func([] (ACtxParts const& rScnParts, MachineUpdater& rUpdMach) noexcept
+    {
+        // Every signal type's node update task has added notified machines to levelPending by now.
+        // Only the lowest pending level updates this iteration. Its inputs are all final, as
+        // machines only write to higher levels.
+        if (release_signal_level(rScnParts.machines, rUpdMach))
+        {
+            rUpdMach.requestMachineUpdateLoop = true;
+        }
+    });
+
     rBuilder.task()
         .name       ("Schedule Link update")
         .schedules  ({tgParts.linkLoop(ScheduleLink)})
@@ -178,6 +250,7 @@ Session setup_vehicle_spawn(
 
     rBuilder.task()
         .name       ("Clear Vehicle Spawning vector after use")
+        .cheap      ()
         .run_on     ({tgVhSp.spawnRequest(Clear)})
         .push_to    (out.m_tasks)
         .args       ({             idVehicleSpawn})
@@ -224,10 +297,33 @@ Session setup_vehicle_spawn_vb(
 
     top_emplace< ACtxVehicleSpawnVB >(topData, idVehicleSpawnVB);
 
+    rBuilder.task()
+        .name       ("Group vehicles to spawn by VehicleData")
+        .run_on     ({tgVhSp.spawnRequest(UseOrRun)})
+        .sync_with  ({tgVhSpVB.dataVB(Modify_)})
+        .push_to    (out.m_tasks)
+        .args       ({                   idVehicleSpawn,                    idVehicleSpawnVB})
+        .func([] (ACtxVehicleSpawn const& rVehicleSpawn, ACtxVehicleSpawnVB& rVehicleSpawnVB) noexcept
+    {
+        SysVehicleSpawnVB::group_blueprints(rVehicleSpawn, rVehicleSpawnVB);
+    });
+
+    rBuilder.task()
+        .name       ("Clear VehicleData vector after use")
+        .cheap      ()
+        .run_on     ({tgVhSpVB.dataVB(Clear)})
+        .push_to    (out.m_tasks)
+        .args       ({             idVehicleSpawnVB})
+        .func([] (ACtxVehicleSpawnVB& rVehicleSpawnVB) noexcept
+    {
+        // Parallel with spawnRequest, which is cleared after every spawn too
+        rVehicleSpawnVB.dataVB.clear();
+    });
+
     rBuilder.task()
         .name       ("Create PartIds and WeldIds for vehicles to spawn from VehicleData")
         .run_on     ({tgVhSp.spawnRequest(UseOrRun)})
-        .sync_with  ({tgVhSp.spawnedParts(Resize), tgVhSpVB.remapParts(Modify_), tgVhSpVB.remapWelds(Modify_), tgParts.partIds(New), tgParts.weldIds(New), tgParts.mapWeldActive(New)})
+        .sync_with  ({tgVhSpVB.dataVB(UseOrRun), tgVhSp.spawnedParts(Resize), tgVhSpVB.remapParts(Modify_), tgVhSpVB.remapWelds(Modify_), tgParts.partIds(New), tgParts.weldIds(New), tgParts.mapWeldActive(New)})
         .push_to    (out.m_tasks)
         .args       ({             idVehicleSpawn,                    idVehicleSpawnVB,           idScnParts})
         .func([] (ACtxVehicleSpawn& rVehicleSpawn, ACtxVehicleSpawnVB& rVehicleSpawnVB, ACtxParts& rScnParts) noexcept
@@ -238,7 +334,7 @@ Session setup_vehicle_spawn_vb(
     rBuilder.task()
         .name       ("Request prefabs for vehicle parts from VehicleBuilder")
         .run_on     ({tgVhSp.spawnRequest(UseOrRun)})
-        .sync_with  ({tgPf.spawnRequest(Modify_), tgVhSp.spawnedParts(UseOrRun)})
+        .sync_with  ({tgVhSpVB.dataVB(UseOrRun), tgPf.spawnRequest(Modify_), tgVhSp.spawnedParts(UseOrRun)})
         .push_to    (out.m_tasks)
         .args       ({             idVehicleSpawn,                          idVehicleSpawnVB,           idScnParts,             idPrefabs,           idResources})
         .func([] (ACtxVehicleSpawn& rVehicleSpawn, ACtxVehicleSpawnVB const& rVehicleSpawnVB, ACtxParts& rScnParts, ACtxPrefabs& rPrefabs, Resources& rResources) noexcept
@@ -254,90 +350,7 @@ Session setup_vehicle_spawn_vb(
         .args       ({             idVehicleSpawn,                    idVehicleSpawnVB,           idScnParts})
         .func([] (ACtxVehicleSpawn& rVehicleSpawn, ACtxVehicleSpawnVB& rVehicleSpawnVB, ACtxParts& rScnParts) noexcept
     {
-        std::size_t const newVehicleCount = rVehicleSpawn.new_vehicle_count();
-        ACtxVehicleSpawnVB &rVSVB = rVehicleSpawnVB;
-
-        // Count total machines, and calculate offsets for remaps.
-
-        std::size_t machTotal = 0;
-        std::size_t remapMachTotal = 0;
-
-        rVSVB.machtypeCount.clear();
-        rVSVB.machtypeCount.resize(MachTypeReg_t::size(), 0);
-
-        rVSVB.remapMachOffsets.resize(newVehicleCount);
-
-        for (SpVehicleId vhId{0}; vhId.value < newVehicleCount; ++vhId.value)
-        {
-            VehicleData const* pVData = rVSVB.dataVB[vhId];
-            if (pVData == nullptr)
-            {
-                continue;
-            }
-
-            Machines const &srcMachines = pVData->m_machines;
-            std::size_t const bounds = srcMachines.ids.capacity();
-
-            rVSVB.remapMachOffsets[vhId] = remapMachTotal;
-
-            remapMachTotal += bounds;
-            machTotal += srcMachines.ids.size();
-
-            for (MachTypeId type = 0; type < MachTypeReg_t::largest(); ++type)
-            {
-                rVSVB.machtypeCount[type] += srcMachines.perType[type].localIds.size();
-            }
-        }
-
-        rVehicleSpawn.spawnedMachs.resize(machTotal);
-        rVSVB.remapMachs.resize(remapMachTotal);
-
-        // Create ACtxParts MachAny/LocalIDs and populate remaps
-
-        // MachAnyIDs created here
-        rScnParts.machines.ids.create(rVehicleSpawn.spawnedMachs.begin(),
-                                      rVehicleSpawn.spawnedMachs.end());
-
-        rScnParts.machines.machToLocal.resize(rScnParts.machines.ids.capacity());
-
-        auto itDstMachIds = rVehicleSpawn.spawnedMachs.cbegin();
-
-        for (SpVehicleId vhId{0}; vhId.value < newVehicleCount; ++vhId.value)
-        {
-            VehicleData const* pVData = rVSVB.dataVB[vhId];
-            if (pVData == nullptr)
-            {
-                continue;
-            }
-
-            Machines const &srcMachines = pVData->m_machines;
-
-            std::size_t const remapMachOffset = rVSVB.remapMachOffsets[vhId];
-
-            for (MachAnyId const srcMach : srcMachines.ids)
-            {
-                MachAnyId const dstMach = *itDstMachIds;
-                ++itDstMachIds;
-
-                // Populate map for "VehicleBuilder MachAnyId -> ACtxParts MachAnyId"
-                rVSVB.remapMachs[remapMachOffset + srcMach] = dstMach;
-
-                // Create ACtxParts MachLocalIds
-                // MachLocalIds don't need a remap, since they can be obtained
-                // from a MachAnyId.
-                // TODO: This can be optimized later, where all local IDs are
-                //       created at once with ids.create(first, last), and make
-                //       resize(..) called once per type too
-                MachTypeId const    type            = srcMachines.machTypes[srcMach];
-                PerMachType&        rDstPerType     = rScnParts.machines.perType[type];
-
-                MachLocalId const dstLocal = rDstPerType.localIds.create();
-                rDstPerType.localToAny.resize(rDstPerType.localIds.capacity());
-
-                rDstPerType.localToAny[dstLocal] = dstMach;
-                rScnParts.machines.machToLocal[dstMach] = dstLocal;
-            }
-        }
+        SysVehicleSpawnVB::create_machines(rVehicleSpawn, rVehicleSpawnVB, rScnParts);
     });
 
     rBuilder.task()
@@ -351,23 +364,24 @@ Session setup_vehicle_spawn_vb(
         std::size_t const newVehicleCount = rVehicleSpawn.new_vehicle_count();
         ACtxVehicleSpawnVB const& rVSVB = rVehicleSpawnVB;
 
+        rScnParts.machineToPart.resize(rScnParts.machines.ids.capacity());
+        rScnParts.partToMachines.ids_reserve(rScnParts.partIds.capacity());
+        rScnParts.partToMachines.data_reserve(rScnParts.machines.ids.capacity());
+
         for (SpVehicleId vhId{0}; vhId.value < newVehicleCount; ++vhId.value)
         {
-            VehicleData const* pVData = rVSVB.dataVB[vhId];
-            if (pVData == nullptr)
+            ACtxVehicleSpawnVB::Blueprint const* pBp = SysVehicleSpawnVB::blueprint_of(rVSVB, vhId);
+            if (pBp == nullptr)
             {
                 continue;
             }
-
-            rScnParts.machineToPart.resize(rScnParts.machines.ids.capacity());
-            rScnParts.partToMachines.ids_reserve(rScnParts.partIds.capacity());
-            rScnParts.partToMachines.data_reserve(rScnParts.machines.ids.capacity());
+            VehicleData const* pVData = pBp->pData;
 
             std::size_t const remapMachOffset = rVSVB.remapMachOffsets[vhId];
             std::size_t const remapPartOffset = rVSVB.remapPartOffsets[vhId];
 
             // Update rScnParts machine->part map
-            for (MachAnyId const srcMach : pVData->m_machines.ids)
+            for (MachAnyId const srcMach : pBp->machs)
             {
                 MachAnyId const dstMach = rVSVB.remapMachs[remapMachOffset + srcMach];
                 PartId const    srcPart = pVData->m_machToPart[srcMach];
@@ -377,7 +391,7 @@ Session setup_vehicle_spawn_vb(
             }
 
             // Update rScnParts part->machine multimap
-            for (PartId const srcPart : pVData->m_partIds)
+            for (PartId const srcPart : pBp->parts)
             {
                 PartId const dstPart = rVSVB.remapParts[remapPartOffset + srcPart];
 
@@ -415,18 +429,26 @@ Session setup_vehicle_spawn_vb(
         rVSVB.remapNodeOffsets.resize(newVehicleCount * NodeTypeReg_t::size());
         auto remapNodeOffsets2d = rVSVB.remap_node_offsets_2d();
 
-        // Add up bounds needed for all nodes of every type for remaps
+        // Add up bounds needed for all nodes of every type for remaps, and reserve space for
+        // all new connections at once, instead of reallocating for each vehicle
         std::size_t remapNodeTotal = 0;
-        for (VehicleData const* pVData : rVSVB.dataVB)
+        for (NodeTypeId nodeType = 0; nodeType < NodeTypeReg_t::largest(); ++nodeType)
         {
-            if (pVData == nullptr)
-            {
-                continue;
-            }
-            for (PerNodeType const &rSrcNodeType : pVData->m_nodePerType)
+            std::size_t nodeToMachTotal = 0;
+            std::size_t machToNodeTotal = 0;
+            for (VehicleData const* pVData : rVSVB.dataVB)
             {
-                remapNodeTotal += rSrcNodeType.nodeIds.capacity();
+                if (pVData == nullptr)
+                {
+                    continue;
+                }
+                PerNodeType const &rSrcNodeType = pVData->m_nodePerType[nodeType];
+                remapNodeTotal  += rSrcNodeType.nodeIds.capacity();
+                nodeToMachTotal += rSrcNodeType.nodeToMach.data_size();
+                machToNodeTotal += rSrcNodeType.machToNode.data_size();
             }
+            reserve_nodes(rScnParts.nodePerType[nodeType], rScnParts.machines.ids.capacity(),
+                          nodeToMachTotal, machToNodeTotal);
         }
         rVSVB.remapNodes.resize(remapNodeTotal);
 
@@ -454,6 +476,8 @@ Session setup_vehicle_spawn_vb(
                            rScnParts.nodePerType[nodeType], rScnParts.machines, nodeRemapOut);
             }
         }
+
+        ++rScnParts.connectRevision;
     });
 
     rBuilder.task()
@@ -484,41 +508,12 @@ Session setup_vehicle_spawn_vb(
     rBuilder.task()
         .name       ("Copy float signal values from VehicleBuilder")
         .run_on     ({tgVhSp.spawnRequest(UseOrRun)})
-        .sync_with  ({tgVhSp.spawnedParts(UseOrRun), tgVhSpVB.remapNodes(UseOrRun), tgSgFlt.sigFloatValues(New), tgSgFlt.sigFloatUpdExtIn(New)})
+        .sync_with  ({tgVhSp.spawnedParts(UseOrRun), tgVhSpVB.remapNodes(UseOrRun), tgSgFlt.sigValues(New), tgSgFlt.sigUpdExtIn(New)})
         .push_to    (out.m_tasks)
         .args       ({             idVehicleSpawn,                          idVehicleSpawnVB,           idScnParts,                       idSigValFloat,                    idSigUpdFloat})
         .func([] (ACtxVehicleSpawn& rVehicleSpawn, ACtxVehicleSpawnVB const& rVehicleSpawnVB, ACtxParts& rScnParts, SignalValues_t<float>& rSigValFloat, UpdateNodes<float>& rSigUpdFloat) noexcept
     {
-        Nodes const         &rFloatNodes    = rScnParts.nodePerType[gc_ntSigFloat];
-        std::size_t const   maxNodes        = rFloatNodes.nodeIds.capacity();
-        rSigUpdFloat.nodeNewValues.resize(maxNodes);
-        rSigUpdFloat.nodeDirty.resize(maxNodes);
-        rSigValFloat.resize(maxNodes);
-
-        std::size_t const           newVehicleCount     = rVehicleSpawn.new_vehicle_count();
-        ACtxVehicleSpawnVB const    &rVSVB              = rVehicleSpawnVB;
-
-        auto const remapNodeOffsets2d = rVSVB.remap_node_offsets_2d();
-        for (SpVehicleId vhId{0}; vhId.value < newVehicleCount; ++vhId.value)
-        {
-            VehicleData const* pVData = rVSVB.dataVB[vhId];
-            if (pVData == nullptr)
-            {
-                continue;
-            }
-
-            PerNodeType const&  srcFloatNodes       = pVData->m_nodePerType[gc_ntSigFloat];
-            entt::any const&    srcFloatValuesAny   = srcFloatNodes.m_nodeValues;
-            auto const&         srcFloatValues      = entt::any_cast< SignalValues_t<float> >(srcFloatValuesAny);
-            std::size_t const   nodeRemapOffset     = remapNodeOffsets2d[vhId.value][gc_ntSigFloat];
-            auto const          nodeRemap           = arrayView(rVSVB.remapNodes).exceptPrefix(nodeRemapOffset);
-
-            for (NodeId const srcNode : srcFloatNodes.nodeIds)
-            {
-                NodeId const dstNode = nodeRemap[srcNode];
-                rSigValFloat[dstNode] = srcFloatValues[srcNode];
-            }
-        }
+        SysVehicleSpawnVB::copy_signal_values<float>(rVehicleSpawn, rVehicleSpawnVB, rScnParts, rSigValFloat, rSigUpdFloat);
     });
 
     return out;
@@ -555,7 +550,150 @@ Session setup_vehicle_spawn_draw(
 } // setup_vehicle_spawn_draw
 
 
-Session setup_signals_float(
+
+
+struct WeldMergeDraw
+{
+    struct Weld
+    {
+        ActiveEnt       root        {lgrn::id_null<ActiveEnt>()};
+        std::size_t     entCount    {0};
+        int             stableFor   {0};
+        MergedDraw      merged;
+    };
+
+    KeyedVec<WeldId, Weld>  welds;
+    PkgId                   pkg;
+
+    /// Number of merges done, keeps the names of merged mesh resources unique
+    std::uint32_t           mergeCount  {0};
+
+    /// Frames a weld must stay unchanged before it's merged
+    int                     stableFrames{30};
+};
+
+Session setup_weld_merge_draw(
+        TopTaskBuilder&             rBuilder,
+        ArrayView<entt::any> const  topData,
+        Session const&              application,
+        Session const&              windowApp,
+        Session const&              commonScene,
+        Session const&              parts,
+        Session const&              sceneRenderer,
+        PkgId const                 pkg)
+{
+    OSP_DECLARE_GET_DATA_IDS(application,    TESTAPP_DATA_APPLICATION);
+    OSP_DECLARE_GET_DATA_IDS(commonScene,    TESTAPP_DATA_COMMON_SCENE);
+    OSP_DECLARE_GET_DATA_IDS(parts,          TESTAPP_DATA_PARTS);
+    OSP_DECLARE_GET_DATA_IDS(sceneRenderer,  TESTAPP_DATA_SCENE_RENDERER);
+    auto const tgWin    = windowApp     .get_pipelines<PlWindowApp>();
+    auto const tgScnRdr = sceneRenderer .get_pipelines<PlSceneRenderer>();
+    auto const tgParts  = parts         .get_pipelines<PlParts>();
+
+    Session out;
+    auto const [idWeldMerge] = out.acquire_data<1>(topData);
+    auto &rWeldMerge = top_emplace<WeldMergeDraw>(topData, idWeldMerge);
+    rWeldMerge.pkg = pkg;
+
+    rBuilder.task()
+        .name       ("Merge meshes of welds that stopped changing, unmerge changed welds")
+        .run_on     ({tgWin.sync(Run)})
+        .sync_with  ({tgScnRdr.drawEntResized(Done), tgScnRdr.drawEnt(Ready), tgScnRdr.entMesh(Modify), tgScnRdr.mesh(New),
+                      tgScnRdr.entMeshDirty(Modify_), tgScnRdr.meshResDirty(Modify_),
+                      tgParts.weldIds(Ready), tgParts.mapWeldActive(Ready)})
+        .push_to    (out.m_tasks)
+        .args       ({          idResources,                 idBasic,             idDrawing,                idDrawingRes,                 idScnRender,                 idScnParts,               idWeldMerge})
+        .func([]    (Resources& rResources, ACtxBasic const& rBasic, ACtxDrawing& rDrawing, ACtxDrawingRes& rDrawingRes, ACtxSceneRender& rScnRender, ACtxParts const& rScnParts, WeldMergeDraw& rWeldMerge) noexcept
+    {
+        rWeldMerge.welds.resize(rScnParts.weldIds.capacity());
+
+        for (std::size_t weldInt = 0; weldInt < rWeldMerge.welds.size(); ++weldInt)
+        {
+            auto const              weld        = WeldId(weldInt);
+            WeldMergeDraw::Weld     &rWeld      = rWeldMerge.welds[weld];
+
+            ActiveEnt const root = (rScnParts.weldIds.exists(weld) && weldInt < rScnParts.weldToActive.size())
+                                 ? rScnParts.weldToActive[weld] : lgrn::id_null<ActiveEnt>();
+            std::size_t const entCount = (root != lgrn::id_null<ActiveEnt>())
+                                       ? SysSceneGraph::descendants(rBasic.m_scnGraph, root).size() : 0;
+
+            if (root != rWeld.root || entCount != rWeld.entCount)
+            {
+                // Parts were added, removed, or the weld is gone
+                SysMergeDraw::unmerge(rWeld.merged, rScnRender, rDrawing);
+                rWeld.root      = root;
+                rWeld.entCount  = entCount;
+                rWeld.stableFor = 0;
+                continue;
+            }
+
+            if (root == lgrn::id_null<ActiveEnt>() || rWeld.stableFor > rWeldMerge.stableFrames)
+            {
+                continue; // Nothing to draw, or already merged
+            }
+
+            ++rWeld.stableFor;
+            if (rWeld.stableFor > rWeldMerge.stableFrames)
+            {
+                rWeld.merged = SysMergeDraw::merge(rScnRender, rDrawing, rDrawingRes, rResources, rBasic, root, rWeldMerge.pkg,
+                                                   "weld_merge_" + std::to_string(rWeldMerge.mergeCount++));
+            }
+        }
+    });
+
+    rBuilder.task()
+        .name       ("Unmerge welds with deleted DrawEnts")
+        .run_on     ({tgScnRdr.drawEntDelete(UseOrRun)})
+        .sync_with  ({tgScnRdr.entMesh(Prev), tgScnRdr.entMeshDirty(Modify_)})
+        .push_to    (out.m_tasks)
+        .args       ({            idDrawing,                 idScnRender,               idWeldMerge})
+        .func([]    (ACtxDrawing& rDrawing, ACtxSceneRender& rScnRender, WeldMergeDraw& rWeldMerge) noexcept
+    {
+        auto const is_deleted = [&rScnRender] (DrawEnt const drawEnt)
+        {
+            return rScnRender.m_drawDeleted.contains(drawEnt);
+        };
+
+        for (WeldMergeDraw::Weld &rWeld : rWeldMerge.welds)
+        {
+            MergedDraw &rMerged = rWeld.merged;
+            bool const anyDeleted
+                    =  std::any_of(rMerged.hidden.begin(), rMerged.hidden.end(), is_deleted)
+                    || std::any_of(rMerged.batches.begin(), rMerged.batches.end(),
+                                   [&] (MergedDraw::Batch const& batch) { return is_deleted(batch.drawEnt); });
+            if (anyDeleted)
+            {
+                // Originals are restored so deleting the DrawEnts releases them as usual
+                SysMergeDraw::unmerge(rMerged, rScnRender, rDrawing);
+                rWeld.stableFor = 0;
+            }
+        }
+    });
+
+    rBuilder.task()
+        .name       ("Clean up WeldMergeDraw")
+        .run_on     ({tgScnRdr.cleanup(Run_)})
+        .push_to    (out.m_tasks)
+        .args       ({            idDrawing,               idWeldMerge})
+        .func([]    (ACtxDrawing& rDrawing, WeldMergeDraw& rWeldMerge) noexcept
+    {
+        // Merged meshes in ACtxSceneRender::m_mesh are released along with the other scene owners
+        for (WeldMergeDraw::Weld &rWeld : rWeldMerge.welds)
+        {
+            for (MergedDraw::Batch &rBatch : rWeld.merged.batches)
+            {
+                rDrawing.m_meshRefCounts.ref_release(std::move(rBatch.original));
+            }
+            rWeld.merged.batches.clear();
+        }
+    });
+
+    return out;
+} // setup_weld_merge_draw
+
+
+template <typename VALUE_T>
+Session setup_signals(
         TopTaskBuilder&             rBuilder,
         ArrayView<entt::any> const  topData,
         Session const&              scene,
@@ -565,70 +703,80 @@ Session setup_signals_float(
     auto const tgScn = scene.get_pipelines<PlScene>();
     auto const tgParts = parts.get_pipelines<PlParts>();
 
+    using Signal_t = SignalType<VALUE_T>;
+    std::string const typeName{Signal_t::smc_name};
+
     Session out;
-    OSP_DECLARE_CREATE_DATA_IDS(out, topData, TESTAPP_DATA_SIGNALS_FLOAT);
-    auto const tgSgFlt = out.create_pipelines<PlSignalsFloat>(rBuilder);
+    OSP_DECLARE_CREATE_DATA_IDS(out, topData, TESTAPP_DATA_SIGNALS);
+    auto const tgSig = out.create_pipelines<PlSignals>(rBuilder);
 
-    rBuilder.pipeline(tgSgFlt.sigFloatValues)   .parent(tgScn.update);
-    rBuilder.pipeline(tgSgFlt.sigFloatUpdExtIn) .parent(tgScn.update);
-    rBuilder.pipeline(tgSgFlt.sigFloatUpdLoop)  .parent(tgParts.linkLoop);
+    rBuilder.pipeline(tgSig.sigValues)   .parent(tgScn.update);
+    rBuilder.pipeline(tgSig.sigUpdExtIn) .parent(tgScn.update);
+    rBuilder.pipeline(tgSig.sigUpdLoop)  .parent(tgParts.linkLoop);
 
-    top_emplace< SignalValues_t<float> >    (topData, idSigValFloat);
-    top_emplace< UpdateNodes<float> >       (topData, idSigUpdFloat);
+    top_emplace< SignalValues_t<VALUE_T> >        (topData, idSigVal);
+    top_emplace< UpdateNodes<VALUE_T> >           (topData, idSigUpd);
+    top_emplace< UpdateNodesPerWriter<VALUE_T> >  (topData, idSigUpdWriters);
 
-    // NOTE: Consider supporting per-thread UpdateNodes<float> to allow multiple threads to write
-    //       new float values in parallel.
+    // Tasks outside of the link loop write to idSigUpd directly. Machine update tasks within the
+    // loop may run in parallel, and each write to their own idSigUpdWriters[MachTypeId]
 
     rBuilder.task()
-        .name       ("Update Signal<float> Nodes")
-        .run_on     ({tgParts.linkLoop(EStgLink::NodeUpd)})
-        .sync_with  ({tgSgFlt.sigFloatUpdExtIn(Ready), tgParts.machUpdExtIn(Ready), tgSgFlt.sigFloatUpdLoop(Modify), tgSgFlt.sigFloatValues(Modify)})
+        .name       ("Resize per-machine-type Signal<" + typeName + "> update buffers")
+        .run_on     ({tgScn.update(Run)})
+        .sync_with  ({tgParts.nodeIds(Ready), tgParts.machUpdExtIn(New)})
         .push_to    (out.m_tasks)
-        .args       ({               idSigUpdFloat,                       idSigValFloat,                idUpdMach,                 idScnParts})
-        .func([] (UpdateNodes<float>& rSigUpdFloat, SignalValues_t<float>& rSigValFloat, MachineUpdater& rUpdMach, ACtxParts const& rScnParts) noexcept
+        .args       ({                          idSigUpdWriters,                 idScnParts})
+        .func([] (UpdateNodesPerWriter<VALUE_T>& rSigUpdWriters, ACtxParts const& rScnParts) noexcept
     {
-        if ( ! rSigUpdFloat.dirty )
-        {
-            return; // Not dirty, nothing to do
-        }
-
-        Nodes const &rFloatNodes = rScnParts.nodePerType[gc_ntSigFloat];
+        rSigUpdWriters.resize(MachTypeReg_t::size(), rScnParts.nodePerType[Signal_t::node_type()].nodeIds.capacity());
+    });
 
-        // NOTE: The various use of reset() clear entire bit arrays, which may or may
-        //       not be expensive. They likely optimize to memset
+    rBuilder.task()
+        .name       ("Update Signal<" + typeName + "> Nodes")
+        .run_on     ({tgParts.linkLoop(EStgLink::NodeUpd)})
+        .sync_with  ({tgSig.sigUpdExtIn(Ready), tgParts.machUpdExtIn(Ready), tgSig.sigUpdLoop(Modify), tgSig.sigValues(Modify), tgParts.machDirty(Modify)})
+        .push_to    (out.m_tasks)
+        .args       ({                 idSigUpd,                          idSigUpdWriters,                         idSigVal,                idUpdMach,                 idScnParts})
+        .func([] (UpdateNodes<VALUE_T>& rSigUpd, UpdateNodesPerWriter<VALUE_T>& rSigUpdWriters, SignalValues_t<VALUE_T>& rSigVal, MachineUpdater& rUpdMach, ACtxParts const& rScnParts) noexcept
+    {
+        // Writers are merged in MachTypeId order, deterministic regardless of thread timing
+        rSigUpdWriters.merge_into(rSigUpd);
 
-        for (MachTypeId const machTypeDirty : rUpdMach.machTypesDirty)
+        if ( ! rSigUpd.dirty )
         {
-            rUpdMach.localDirty[machTypeDirty].clear();
+            return; // Not dirty, nothing to do
         }
-        rUpdMach.machTypesDirty.clear();
 
-        // Sees which nodes changed, and writes into rUpdMach set dirty which MACHINES
-        // must be updated next
-        update_signal_nodes<float>(
-                rSigUpdFloat.nodeDirty,
-                rFloatNodes.nodeToMach,
+        // Sees which nodes changed, and writes into rUpdMach which MACHINES must be updated,
+        // deferred to their signal level
+        update_signal_nodes<VALUE_T>(
+                rSigUpd.nodeDirty,
+                rScnParts.nodePerType[Signal_t::node_type()].nodeToMach,
                 rScnParts.machines,
-                arrayView(rSigUpdFloat.nodeNewValues),
-                rSigValFloat,
+                arrayView(rSigUpd.nodeNewValues),
+                rSigVal,
                 rUpdMach);
-        rSigUpdFloat.nodeDirty.clear();
-        rSigUpdFloat.dirty = false;
-
-        // Run tasks needed to update machine types that are dirty
-        bool anyMachineNotified = false;
-        for (MachTypeId const type : rUpdMach.machTypesDirty)
-        {
-            anyMachineNotified = true;
-        }
-        if (anyMachineNotified && rUpdMach.requestMachineUpdateLoop.load())
-        {
-            rUpdMach.requestMachineUpdateLoop.store(true);
-        }
+        rSigUpd.nodeDirty.clear();
+        rSigUpd.dirty = false;
     });
 
     return out;
-} // setup_signals_float
+} // setup_signals
+
+template Session setup_signals<float>       (TopTaskBuilder&, ArrayView<entt::any>, Session const&, Session const&);
+template Session setup_signals<int32_t>     (TopTaskBuilder&, ArrayView<entt::any>, Session const&, Session const&);
+template Session setup_signals<SigMask_t>   (TopTaskBuilder&, ArrayView<entt::any>, Session const&, Session const&);
+template Session setup_signals<Vector3>     (TopTaskBuilder&, ArrayView<entt::any>, Session const&, Session const&);
+
+Session setup_signals_float(
+        TopTaskBuilder&             rBuilder,
+        ArrayView<entt::any> const  topData,
+        Session const&              scene,
+        Session const&              parts)
+{
+    return setup_signals<float>(rBuilder, topData, scene, parts);
+}
 
 
 } // namespace testapp::scenes
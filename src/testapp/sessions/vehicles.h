@@ -73,6 +73,19 @@ osp::Session setup_signals_float(
         osp::Session const&         scene,
         osp::Session const&         parts);
 
+/**
+ * @brief Signal Links of any type with an osp::link::SignalType specialization
+ *
+ * Provides TESTAPP_DATA_SIGNALS and PlSignals. setup_signals_float is setup_signals<float>.
+ * Instantiated for float, int32_t, SigMask_t, and Vector3.
+ */
+template <typename VALUE_T>
+osp::Session setup_signals(
+        osp::TopTaskBuilder&        rBuilder,
+        osp::ArrayView<entt::any>   topData,
+        osp::Session const&         scene,
+        osp::Session const&         parts);
+
 /**
  * @brief Links for Magic Rockets
  *
@@ -95,6 +108,34 @@ osp::Session setup_mach_rcsdriver(
         osp::Session const&         parts,
         osp::Session const&         signalsFloat);
 
+/**
+ * @brief Links for all machine types registered with osp::link::register_machine_plugin
+ *
+ * Each plugin gets the same tasks as a built-in batched machine type, and updates in parallel
+ * with other machine types.
+ */
+osp::Session setup_mach_plugins(
+        osp::TopTaskBuilder&        rBuilder,
+        osp::ArrayView<entt::any>   topData,
+        osp::Session const&         scene,
+        osp::Session const&         parts,
+        osp::Session const&         signalsFloat);
+
+/**
+ * @brief Fuel flow between tanks and engines through pipes, see adera::SysFluidNetwork
+ *
+ * The network is stepped every updateInterval seconds, much slower than physics. Tank masses are
+ * then written to their massEnt's ACompMass, and engine mass flows are available in idFluidNet.
+ */
+osp::Session setup_fluid_network(
+        osp::TopTaskBuilder&        rBuilder,
+        osp::ArrayView<entt::any>   topData,
+        osp::Session const&         scene,
+        osp::Session const&         commonScene,
+        osp::Session const&         physics,
+        osp::Session const&         parts,
+        float                       updateInterval);
+
 /**
  * @brief Logic and queues for spawning vehicles
  *
@@ -112,6 +153,21 @@ osp::Session setup_vehicle_spawn_draw(
         osp::Session const&         sceneRenderer,
         osp::Session const&         vehicleSpawn);
 
+/**
+ * @brief Merge the meshes of welds that stopped changing, drawing each weld with fewer DrawEnts
+ *
+ * Welds are unmerged as soon as their parts change, see SysMergeDraw
+ */
+osp::Session setup_weld_merge_draw(
+        osp::TopTaskBuilder&        rBuilder,
+        osp::ArrayView<entt::any>   topData,
+        osp::Session const&         application,
+        osp::Session const&         windowApp,
+        osp::Session const&         commonScene,
+        osp::Session const&         parts,
+        osp::Session const&         sceneRenderer,
+        osp::PkgId                  pkg);
+
 /**
  * @brief Support VehicleBuilder data to be used to spawn vehicles
  */
@@ -25,15 +25,19 @@
 #include "vehicles.h"
 
 #include <adera/activescene/vehicles_vb_fn.h>
+#include <adera/drawing/plume.h>
 #include <adera/drawing/CameraController.h>
+#include <adera/machines/fluid.h>
 #include <adera/machines/links.h>
 
 #include <osp/activescene/basic.h>
 #include <osp/activescene/physics.h>
+#include <osp/activescene/physics_fn.h>
 #include <osp/activescene/prefab_fn.h>
 #include <osp/core/Resources.h>
 #include <osp/drawing/drawing.h>
 #include <osp/drawing/drawing_fn.h>
+#include <osp/link/machine_plugins.h>
 #include <osp/util/UserInputHandler.h>
 
 using namespace adera;
@@ -160,6 +164,16 @@ Session setup_thrust_indicators(
         PerMachType const   &rockets        = rScnParts.machines.perType[gc_mtMagicRocket];
         Nodes const         &floats         = rScnParts.nodePerType[gc_ntSigFloat];
 
+        // Hide those of removed rockets, their DrawEnts are reused if the local IDs are
+        for (MachLocalId localId = 0; localId < rThrustIndicator.rktToDrawEnt.size(); ++localId)
+        {
+            DrawEnt const drawEnt = rThrustIndicator.rktToDrawEnt[localId];
+            if (drawEnt != lgrn::id_null<DrawEnt>() && ! rockets.localIds.exists(localId))
+            {
+                rScnRender.m_visible.erase(drawEnt);
+            }
+        }
+
         for (MachLocalId const localId : rockets.localIds)
         {
             DrawEnt const   drawEnt         = rThrustIndicator.rktToDrawEnt[localId];
@@ -199,7 +213,7 @@ Session setup_thrust_indicators(
             rScnRender.m_opaque .insert(drawEnt);
 
             rScnRender.m_color              [drawEnt] = rThrustIndicator.color;
-            rScnRender.drawTfObserverEnable [partEnt] = 1;
+            rScnRender.drawTfObserverEnable [partEnt] |= 1;
 
             SysRender::needs_draw_transforms(rBasic.m_scnGraph, rScnRender.m_needDrawTf, partEnt);
         }
@@ -246,7 +260,7 @@ Session setup_thrust_indicators(
 
     rBuilder.task()
         .name       ("Clean up ThrustIndicator")
-        .run_on     ({tgWin.cleanup(Run_)})
+        .run_on     ({tgScnRdr.cleanup(Run_)})
         .push_to    (out.m_tasks)
         .args       ({      idResources,             idDrawing,                 idThrustIndicator})
         .func([] (Resources& rResources, ACtxDrawing& rDrawing, ThrustIndicator& rThrustIndicator) noexcept
@@ -260,6 +274,202 @@ Session setup_thrust_indicators(
 
 
 
+struct RocketPlumes
+{
+    MaterialId      material;
+    MeshIdOwner_t   mesh;
+
+    KeyedVec<MachLocalId, DrawEnt> rktToDrawEnt;
+
+    /// Plume length at full throttle, in meters
+    float           length {4.0f};
+};
+
+Session setup_rocket_plumes(
+        TopTaskBuilder&             rBuilder,
+        ArrayView<entt::any> const  topData,
+        Session const&              application,
+        Session const&              windowApp,
+        Session const&              scene,
+        Session const&              commonScene,
+        Session const&              parts,
+        Session const&              signalsFloat,
+        Session const&              sceneRenderer,
+        PkgId const                 pkg,
+        MaterialId const            material)
+{
+    OSP_DECLARE_GET_DATA_IDS(application,    TESTAPP_DATA_APPLICATION);
+    OSP_DECLARE_GET_DATA_IDS(scene,          TESTAPP_DATA_SCENE);
+    OSP_DECLARE_GET_DATA_IDS(commonScene,    TESTAPP_DATA_COMMON_SCENE);
+    OSP_DECLARE_GET_DATA_IDS(parts,          TESTAPP_DATA_PARTS);
+    OSP_DECLARE_GET_DATA_IDS(signalsFloat,   TESTAPP_DATA_SIGNALS_FLOAT)
+    OSP_DECLARE_GET_DATA_IDS(sceneRenderer,  TESTAPP_DATA_SCENE_RENDERER);
+    auto const tgWin    = windowApp     .get_pipelines<PlWindowApp>();
+    auto const tgScnRdr = sceneRenderer .get_pipelines<PlSceneRenderer>();
+    auto const tgParts  = parts         .get_pipelines<PlParts>();
+
+    auto &rResources        = top_get< Resources >      (topData, idResources);
+    auto &rDrawing          = top_get< ACtxDrawing >    (topData, idDrawing);
+    auto &rDrawingRes       = top_get< ACtxDrawingRes > (topData, idDrawingRes);
+    auto &rDrawTfObservers  = top_get< DrawTfObservers >(topData, idDrawTfObservers);
+    auto &rScnParts         = top_get< ACtxParts >      (topData, idScnParts);
+
+    Session out;
+    OSP_DECLARE_CREATE_DATA_IDS(out, topData, TESTAPP_DATA_ROCKET_PLUMES);
+    auto const [idRocketPlumes] = out.acquire_data<1>(topData);
+
+    auto &rPlumes       = top_emplace<ACtxPlumes>   (topData, idPlumes);
+    auto &rRocketPlumes = top_emplace<RocketPlumes>(topData, idRocketPlumes);
+
+    rRocketPlumes.material  = material;
+    rRocketPlumes.mesh      = SysRender::add_drawable_mesh(rDrawing, rDrawingRes, rResources, pkg, "cone");
+
+    rBuilder.task()
+        .name       ("Create DrawEnts for rocket plumes")
+        .run_on     ({tgWin.sync(Run)})
+        .sync_with  ({tgScnRdr.drawEntResized(ModifyOrSignal), tgScnRdr.drawEnt(New), tgParts.machIds(Ready)})
+        .push_to    (out.m_tasks)
+        .args       ({               idScnRender,                  idScnParts,              idRocketPlumes})
+        .func([]    (ACtxSceneRender &rScnRender,  ACtxParts const& rScnParts, RocketPlumes& rRocketPlumes) noexcept
+    {
+        PerMachType const& rockets = rScnParts.machines.perType[gc_mtMagicRocket];
+
+        rRocketPlumes.rktToDrawEnt.resize(rockets.localIds.capacity());
+
+        for (MachLocalId const localId : rockets.localIds)
+        {
+            DrawEnt& rDrawEnt = rRocketPlumes.rktToDrawEnt[localId];
+            if (rDrawEnt == lgrn::id_null<DrawEnt>())
+            {
+                rDrawEnt = rScnRender.m_drawIds.create();
+            }
+        }
+    });
+
+    rBuilder.task()
+        .name       ("Write rocket plume power")
+        .run_on     ({tgWin.sync(Run)})
+        .sync_with  ({tgScnRdr.drawEntResized(Done), tgScnRdr.drawEnt(Ready), tgScnRdr.entMesh(New), tgScnRdr.material(New), tgScnRdr.materialDirty(Modify_), tgScnRdr.entMeshDirty(Modify_)})
+        .push_to    (out.m_tasks)
+        .args       ({         idBasic,                 idScnRender,             idDrawing,                 idScnParts,                             idSigValFloat,                    idPlumes,              idRocketPlumes,           idDeltaTimeIn})
+        .func([]    (ACtxBasic& rBasic, ACtxSceneRender &rScnRender, ACtxDrawing& rDrawing, ACtxParts const& rScnParts, SignalValues_t<float> const& rSigValFloat, ACtxPlumes& rPlumes, RocketPlumes& rRocketPlumes, float const deltaTimeIn) noexcept
+    {
+        Material            &rMat           = rScnRender.m_materials[rRocketPlumes.material];
+        PerMachType const   &rockets        = rScnParts.machines.perType[gc_mtMagicRocket];
+        Nodes const         &floats         = rScnParts.nodePerType[gc_ntSigFloat];
+
+        rPlumes.time += deltaTimeIn;
+        rPlumes.params.resize(rScnRender.m_drawIds.capacity());
+
+        // Hide those of removed rockets, their DrawEnts are reused if the local IDs are
+        for (MachLocalId localId = 0; localId < rRocketPlumes.rktToDrawEnt.size(); ++localId)
+        {
+            DrawEnt const drawEnt = rRocketPlumes.rktToDrawEnt[localId];
+            if (drawEnt != lgrn::id_null<DrawEnt>() && ! rockets.localIds.exists(localId))
+            {
+                rScnRender.m_visible.erase(drawEnt);
+            }
+        }
+
+        for (MachLocalId const localId : rockets.localIds)
+        {
+            DrawEnt const   drawEnt         = rRocketPlumes.rktToDrawEnt[localId];
+
+            MachAnyId const anyId           = rockets.localToAny[localId];
+            PartId const    part            = rScnParts.machineToPart[anyId];
+            ActiveEnt const partEnt         = rScnParts.partToActive[part];
+
+            auto const&     portSpan        = floats.machToNode[anyId];
+            NodeId const    throttleIn      = connected_node(portSpan, ports_magicrocket::gc_throttleIn.port);
+            NodeId const    multiplierIn    = connected_node(portSpan, ports_magicrocket::gc_multiplierIn.port);
+
+            float const     throttle        = std::clamp(rSigValFloat[throttleIn], 0.0f, 1.0f);
+            float const     multiplier      = rSigValFloat[multiplierIn];
+
+            if (throttle * multiplier == 0.0f)
+            {
+                rScnRender.m_visible.erase(drawEnt);
+                continue;
+            }
+
+            if (!rMat.m_ents.contains(drawEnt))
+            {
+                rMat.m_ents.insert(drawEnt);
+                rMat.m_dirty.push_back(drawEnt);
+            }
+
+            MeshIdOwner_t &rMeshOwner = rScnRender.m_mesh[drawEnt];
+            if ( ! rMeshOwner.has_value() )
+            {
+                rScnRender.m_mesh[drawEnt] = rDrawing.m_meshRefCounts.ref_add(rRocketPlumes.mesh.value());
+                rScnRender.m_meshDirty.push_back(drawEnt);
+            }
+
+            rScnRender.m_visible    .insert(drawEnt);
+            rScnRender.m_transparent.insert(drawEnt);
+
+            // The only per-engine work, the plume shader does the rest
+            rPlumes.params[drawEnt].power   = throttle;
+
+            rScnRender.drawTfObserverEnable [partEnt] |= 1 << 1;
+
+            SysRender::needs_draw_transforms(rBasic.m_scnGraph, rScnRender.m_needDrawTf, partEnt);
+        }
+    });
+
+    using UserData_t = DrawTfObservers::UserData_t;
+
+    DrawTfObservers::Observer &rObserver = rDrawTfObservers.observers[1];
+
+    rObserver.data = { &rRocketPlumes, &rScnParts };
+    rObserver.func = [] (ACtxSceneRender& rCtxScnRdr, Matrix4 const& drawTf, active::ActiveEnt ent, int depth, UserData_t data) noexcept
+    {
+        auto &rRocketPlumes             = *static_cast< RocketPlumes* > (data[0]);
+        auto &rScnParts                 = *static_cast< ACtxParts* >    (data[1]);
+
+        PartId const        part        = rScnParts.activeToPart[ent];
+
+        // Cone mesh spans Z -1 to 1, point it out the back of the nozzle
+        Matrix4 const plumeTf = drawTf
+                              * Matrix4::translation({0.0f, 0.0f, -0.5f * rRocketPlumes.length})
+                              * Matrix4::scaling({0.5f, 0.5f, 0.5f * rRocketPlumes.length});
+
+        for (MachinePair const pair : rScnParts.partToMachines[part])
+        if (pair.type == gc_mtMagicRocket)
+        {
+            rCtxScnRdr.m_drawTransform[rRocketPlumes.rktToDrawEnt[pair.local]] = plumeTf;
+        }
+    };
+
+    rBuilder.task()
+        .name       ("Clean up RocketPlumes")
+        .run_on     ({tgScnRdr.cleanup(Run_)})
+        .push_to    (out.m_tasks)
+        .args       ({      idResources,             idDrawing,              idRocketPlumes})
+        .func([] (Resources& rResources, ACtxDrawing& rDrawing, RocketPlumes& rRocketPlumes) noexcept
+    {
+        rDrawing.m_meshRefCounts.ref_release(std::move(rRocketPlumes.mesh));
+    });
+
+    return out;
+} // setup_rocket_plumes
+
+
+
+
+/**
+ * @brief RCS driver port nodes resolved ahead of time, and columns to update them in bulk
+ */
+struct ACtxRcsDrivers
+{
+    /// Float nodes connected to each port of each RCS driver, resolved when wiring changes
+    KeyedVec<MachLocalId, std::array<NodeId, ports_rcsdriver::gc_portCount>> localToNodes;
+    std::uint32_t               connectRevision{~std::uint32_t(0)};
+
+    std::vector<MachLocalId>    batchLocals;
+    RcsDriverBatch              batch;
+};
+
 Session setup_mach_rcsdriver(
         TopTaskBuilder&             rBuilder,
         ArrayView<entt::any> const  topData,
@@ -273,6 +483,8 @@ Session setup_mach_rcsdriver(
     auto const tgParts  = parts         .get_pipelines<PlParts>();
 
     Session out;
+    auto const [idRcsDrivers] = out.acquire_data<1>(topData);
+    top_emplace<ACtxRcsDrivers>(topData, idRcsDrivers);
 
     rBuilder.task()
         .name       ("Allocate Machine update bitset for RcsDriver")
@@ -285,64 +497,94 @@ Session setup_mach_rcsdriver(
         rUpdMach.localDirty[gc_mtRcsDriver].resize(rScnParts.machines.perType[gc_mtRcsDriver].localIds.capacity());
     });
 
+    rBuilder.task()
+        .name       ("Cache RCS Driver port nodes")
+        .run_on     ({tgScn.update(Run)})
+        .sync_with  ({tgParts.machIds(Ready), tgParts.connect(Ready)})
+        .push_to    (out.m_tasks)
+        .args       ({            idScnParts,                 idRcsDrivers})
+        .func([] (ACtxParts const& rScnParts, ACtxRcsDrivers& rRcsDrivers) noexcept
+    {
+        if (rRcsDrivers.connectRevision == rScnParts.connectRevision)
+        {
+            return; // Wiring didn't change, cached nodes are still valid
+        }
+        rRcsDrivers.connectRevision = rScnParts.connectRevision;
+
+        Nodes const         &rFloatNodes    = rScnParts.nodePerType[gc_ntSigFloat];
+        PerMachType const   &rDrivers       = rScnParts.machines.perType[gc_mtRcsDriver];
+
+        rRcsDrivers.localToNodes.resize(rDrivers.localIds.capacity());
+
+        for (MachLocalId local = 0; local < rDrivers.localIds.capacity(); ++local)
+        {
+            auto &rNodes = rRcsDrivers.localToNodes[local];
+            rNodes.fill(lgrn::id_null<NodeId>());
+
+            if ( ! rDrivers.localIds.exists(local) )
+            {
+                continue;
+            }
+
+            auto const portSpan = lgrn::Span<NodeId const>{rFloatNodes.machToNode[rDrivers.localToAny[local]]};
+            for (PortId port = 0; port < ports_rcsdriver::gc_portCount; ++port)
+            {
+                rNodes[port] = connected_node(portSpan, port);
+            }
+        }
+    });
+
     rBuilder.task()
         .name       ("RCS Drivers calculate new values")
         .run_on     ({tgParts.linkLoop(MachUpd)})
         .sync_with  ({tgParts.machUpdExtIn(Ready)})
         .push_to    (out.m_tasks)
-        .args       ({      idScnParts,                idUpdMach,                       idSigValFloat,                    idSigUpdFloat})
-        .func([] (ACtxParts& rScnParts, MachineUpdater& rUpdMach, SignalValues_t<float>& rSigValFloat, UpdateNodes<float>& rSigUpdFloat) noexcept
+        .args       ({           idRcsDrivers,                idUpdMach,                       idSigValFloat,                             idSigUpdFloatWriters})
+        .func([] (ACtxRcsDrivers& rRcsDrivers, MachineUpdater& rUpdMach, SignalValues_t<float>& rSigValFloat, UpdateNodesPerWriter<float>& rSigUpdFloatWriters) noexcept
     {
-        Nodes const &rFloatNodes = rScnParts.nodePerType[gc_ntSigFloat];
-        PerMachType &rRockets    = rScnParts.machines.perType[gc_mtRcsDriver];
+        UpdateNodes<float> &rSigUpdFloat = rSigUpdFloatWriters[gc_mtRcsDriver];
+
+        using ports_rcsdriver::gc_throttleOut;
 
+        // Only update drivers with a connected throttle output, calculations are useless otherwise
+        rRcsDrivers.batchLocals.clear();
         for (MachLocalId const local : rUpdMach.localDirty[gc_mtRcsDriver])
         {
-            MachAnyId const mach     = rRockets.localToAny[local];
-            auto const      portSpan = lgrn::Span<NodeId const>{rFloatNodes.machToNode[mach]};
-
-            NodeId const thrNode = connected_node(portSpan, ports_rcsdriver::gc_throttleOut.port);
-            if (thrNode == lgrn::id_null<NodeId>())
+            if (rRcsDrivers.localToNodes[local][gc_throttleOut.port] != lgrn::id_null<NodeId>())
             {
-                continue; // Throttle Output not connected, calculations below are useless
+                rRcsDrivers.batchLocals.push_back(local);
             }
+        }
+
+        std::vector<MachLocalId> const  &rLocals    = rRcsDrivers.batchLocals;
+        RcsDriverBatch                  &rBatch     = rRcsDrivers.batch;
+        rBatch.resize(rLocals.size());
 
-            auto const rcs_read = [&rSigValFloat, portSpan] (float& rDstVar, PortEntry const& entry)
+        // Gather inputs, one column at a time
+        for (PortId port = 0; port < ports_rcsdriver::gc_inputCount; ++port)
+        {
+            std::vector<float> &rColumn = rBatch.inputs[port];
+            for (std::size_t i = 0; i < rLocals.size(); ++i)
             {
-                NodeId const node = connected_node(portSpan, entry.port);
+                NodeId const node = rRcsDrivers.localToNodes[rLocals[i]][port];
+                rColumn[i] = (node != lgrn::id_null<NodeId>()) ? rSigValFloat[node] : 0.0f;
+            }
+        }
 
-                if (node != lgrn::id_null<NodeId>())
-                {
-                    rDstVar = rSigValFloat[node];
-                }
-            };
-
-            Vector3 pos     {0.0f};
-            Vector3 dir     {0.0f};
-            Vector3 cmdLin  {0.0f};
-            Vector3 cmdAng  {0.0f};
-
-            rcs_read( pos.x(),    ports_rcsdriver::gc_posXIn    );
-            rcs_read( pos.y(),    ports_rcsdriver::gc_posYIn    );
-            rcs_read( pos.z(),    ports_rcsdriver::gc_posZIn    );
-            rcs_read( dir.x(),    ports_rcsdriver::gc_dirXIn    );
-            rcs_read( dir.y(),    ports_rcsdriver::gc_dirYIn    );
-            rcs_read( dir.z(),    ports_rcsdriver::gc_dirZIn    );
-            rcs_read( cmdLin.x(), ports_rcsdriver::gc_cmdLinXIn );
-            rcs_read( cmdLin.y(), ports_rcsdriver::gc_cmdLinYIn );
-            rcs_read( cmdLin.z(), ports_rcsdriver::gc_cmdLinZIn );
-            rcs_read( cmdAng.x(), ports_rcsdriver::gc_cmdAngXIn );
-            rcs_read( cmdAng.y(), ports_rcsdriver::gc_cmdAngYIn );
-            rcs_read( cmdAng.z(), ports_rcsdriver::gc_cmdAngZIn );
-
-            OSP_LOG_TRACE("RCS controller {} pitch = {}", local, cmdAng.x());
-            OSP_LOG_TRACE("RCS controller {} yaw = {}", local, cmdAng.y());
-            OSP_LOG_TRACE("RCS controller {} roll = {}", local, cmdAng.z());
-
-            float const thrCurr = rSigValFloat[thrNode];
-            float const thrNew = thruster_influence(pos, dir, cmdLin, cmdAng);
-
-            if (thrCurr != thrNew)
+        thruster_influence_batch(rBatch);
+
+        // Scatter outputs
+        for (std::size_t i = 0; i < rLocals.size(); ++i)
+        {
+            MachLocalId const   local   = rLocals[i];
+            NodeId const        thrNode = rRcsDrivers.localToNodes[local][gc_throttleOut.port];
+            float const         thrNew  = rBatch.throttleOut[i];
+
+            OSP_LOG_TRACE("RCS controller {} pitch = {}", local, rBatch.inputs[ports_rcsdriver::gc_cmdAngXIn.port][i]);
+            OSP_LOG_TRACE("RCS controller {} yaw = {}",   local, rBatch.inputs[ports_rcsdriver::gc_cmdAngYIn.port][i]);
+            OSP_LOG_TRACE("RCS controller {} roll = {}",  local, rBatch.inputs[ports_rcsdriver::gc_cmdAngZIn.port][i]);
+
+            if (rSigValFloat[thrNode] != thrNew)
             {
                 rSigUpdFloat.assign(thrNode, thrNew);
                 rUpdMach.requestMachineUpdateLoop = true;
@@ -356,6 +598,174 @@ Session setup_mach_rcsdriver(
 
 
 
+Session setup_mach_plugins(
+        TopTaskBuilder&             rBuilder,
+        ArrayView<entt::any> const  topData,
+        Session const&              scene,
+        Session const&              parts,
+        Session const&              signalsFloat)
+{
+    OSP_DECLARE_GET_DATA_IDS(signalsFloat,  TESTAPP_DATA_SIGNALS_FLOAT)
+    OSP_DECLARE_GET_DATA_IDS(parts,         TESTAPP_DATA_PARTS);
+    auto const tgScn    = scene         .get_pipelines<PlScene>();
+    auto const tgParts  = parts         .get_pipelines<PlParts>();
+
+    std::vector<MachPlugin> const &plugins = registered_machine_plugins();
+
+    // One MachPluginInstance per plugin, so each gets its own tasks that run in parallel
+    Session out;
+    out.m_data.resize(plugins.size());
+    top_reserve(topData, 0, out.m_data.begin(), out.m_data.end());
+
+    for (std::size_t i = 0; i < plugins.size(); ++i)
+    {
+        TopDataId const idInstance = out.m_data[i];
+        top_emplace<MachPluginInstance>(topData, idInstance, MachPluginInstance{ .plugin = plugins[i] });
+
+        rBuilder.task()
+            .name       ("Allocate Machine update bitset for machine plugin")
+            .run_on     ({tgScn.update(Run)})
+            .sync_with  ({tgParts.machIds(Ready), tgParts.machUpdExtIn(New)})
+            .push_to    (out.m_tasks)
+            .args       ({idScnParts, idUpdMach, idInstance})
+            .func       ([] (ACtxParts& rScnParts, MachineUpdater& rUpdMach, MachPluginInstance& rInst)
+        {
+            MachTypeId const type = rInst.plugin.type;
+            rUpdMach.localDirty[type].resize(rScnParts.machines.perType[type].localIds.capacity());
+        });
+
+        rBuilder.task()
+            .name       ("Resize machine plugin state and cache port nodes")
+            .run_on     ({tgScn.update(Run)})
+            .sync_with  ({tgParts.machIds(Ready), tgParts.connect(Ready)})
+            .push_to    (out.m_tasks)
+            .args       ({            idScnParts,                   idInstance})
+            .func([] (ACtxParts const& rScnParts, MachPluginInstance& rInst) noexcept
+        {
+            if (rInst.connectRevision == rScnParts.connectRevision)
+            {
+                return; // Wiring didn't change, cached nodes are still valid
+            }
+            rInst.connectRevision = rScnParts.connectRevision;
+
+            mach_plugin_reconnect(rInst,
+                                  rScnParts.machines.perType[rInst.plugin.type],
+                                  rScnParts.nodePerType[gc_ntSigFloat]);
+        });
+
+        rBuilder.task()
+            .name       ("Machine plugin calculate new values")
+            .run_on     ({tgParts.linkLoop(MachUpd)})
+            .sync_with  ({tgParts.machUpdExtIn(Ready)})
+            .push_to    (out.m_tasks)
+            .args       ({               idInstance,                idUpdMach,                       idSigValFloat,                             idSigUpdFloatWriters})
+            .func([] (MachPluginInstance& rInst, MachineUpdater& rUpdMach, SignalValues_t<float>& rSigValFloat, UpdateNodesPerWriter<float>& rSigUpdFloatWriters) noexcept
+        {
+            MachTypeId const type = rInst.plugin.type;
+
+            if (mach_plugin_update(rInst, rUpdMach.localDirty[type], rSigValFloat, rSigUpdFloatWriters[type]))
+            {
+                rUpdMach.requestMachineUpdateLoop = true;
+            }
+        });
+    }
+
+    return out;
+} // setup_mach_plugins
+
+
+
+
+Session setup_fluid_network(
+        TopTaskBuilder&             rBuilder,
+        ArrayView<entt::any> const  topData,
+        Session const&              scene,
+        Session const&              commonScene,
+        Session const&              physics,
+        Session const&              parts,
+        float const                 updateInterval)
+{
+    OSP_DECLARE_GET_DATA_IDS(scene,         TESTAPP_DATA_SCENE);
+    OSP_DECLARE_GET_DATA_IDS(commonScene,   TESTAPP_DATA_COMMON_SCENE);
+    OSP_DECLARE_GET_DATA_IDS(physics,       TESTAPP_DATA_PHYSICS);
+    OSP_DECLARE_GET_DATA_IDS(parts,         TESTAPP_DATA_PARTS);
+    auto const tgScn    = scene         .get_pipelines<PlScene>();
+    auto const tgCS     = commonScene   .get_pipelines<PlCommonScene>();
+    auto const tgPhy    = physics       .get_pipelines<PlPhysics>();
+    auto const tgParts  = parts         .get_pipelines<PlParts>();
+
+    Session out;
+    OSP_DECLARE_CREATE_DATA_IDS(out, topData, TESTAPP_DATA_FLUID_NETWORK);
+    auto &rFluidNet = top_emplace<ACtxFluidNetwork>(topData, idFluidNet);
+    rFluidNet.interval = updateInterval;
+
+    rBuilder.task()
+        .name       ("Resize fluid machine states and compile network when wiring changes")
+        .run_on     ({tgScn.update(Run)})
+        .sync_with  ({tgParts.machIds(Ready), tgParts.connect(Ready)})
+        .push_to    (out.m_tasks)
+        .args       ({            idScnParts,                   idFluidNet})
+        .func([] (ACtxParts const& rScnParts, ACtxFluidNetwork& rFluidNet) noexcept
+    {
+        PerMachType const *pPerType = rScnParts.machines.perType.data();
+        rFluidNet.tanks     .resize(pPerType[gc_mtFluidTank]  .localIds.capacity());
+        rFluidNet.pipes     .resize(pPerType[gc_mtFluidPipe]  .localIds.capacity());
+        rFluidNet.engines   .resize(pPerType[gc_mtFluidEngine].localIds.capacity());
+
+        if (rFluidNet.connectRevision == rScnParts.connectRevision)
+        {
+            return; // Wiring didn't change
+        }
+        rFluidNet.connectRevision = rScnParts.connectRevision;
+
+        SysFluidNetwork::compile(rFluidNet, rScnParts.machines, rScnParts.nodePerType[gc_ntFluid]);
+    });
+
+    rBuilder.task()
+        .name       ("Move fluids between tanks and engines")
+        .run_on     ({tgScn.update(Run)})
+        .sync_with  ({tgParts.connect(Ready), tgPhy.physBody(Modify), tgCS.transform(Ready), tgCS.hierarchy(Ready)})
+        .push_to    (out.m_tasks)
+        .args       ({      idDeltaTimeIn,            idScnParts,                   idFluidNet,         idBasic,             idPhys})
+        .func([] (float const deltaTimeIn, ACtxParts const& rScnParts, ACtxFluidNetwork& rFluidNet, ACtxBasic& rBasic, ACtxPhysics& rPhys) noexcept
+    {
+        if ( ! SysFluidNetwork::update(rFluidNet, rScnParts.machines, rScnParts.nodePerType[gc_ntFluid], deltaTimeIn) )
+        {
+            return; // Not yet time for a network update
+        }
+
+        // Batch tank mass changes into ACompMass once per network update
+        for (MachLocalId const local : rFluidNet.tankMassDirty)
+        {
+            FluidTank const& tank = rFluidNet.tanks[local];
+            if (   tank.massEnt == lgrn::id_null<ActiveEnt>()
+                || ! rPhys.m_mass.contains(tank.massEnt) )
+            {
+                continue;
+            }
+
+            ACompMass mass          = rPhys.m_mass.get(tank.massEnt);
+            float const newMass     = tank.dryMass + tank.fluidMass;
+
+            // Fluid fills the same volume regardless of how much is left, so inertia scales
+            // with mass
+            if (mass.m_mass > 0.0f)
+            {
+                mass.m_inertia *= newMass / mass.m_mass;
+            }
+            mass.m_mass = newMass;
+
+            SysPhysics::update_subtree_mass(rBasic.m_transform, rPhys, rBasic.m_scnGraph, tank.massEnt, mass);
+        }
+        rFluidNet.tankMassDirty.clear();
+    });
+
+    return out;
+} // setup_fluid_network
+
+
+
+
 struct VehicleControls
 {
     MachLocalId selectedUsrCtrl{lgrn::id_null<MachLocalId>()};
@@ -452,7 +862,7 @@ Session setup_vehicle_control(
     rBuilder.task()
         .name       ("Write inputs to UserControl Machines")
         .run_on     ({tgScn.update(Run)})
-        .sync_with  ({tgWin.inputs(Run), tgSgFlt.sigFloatUpdExtIn(Modify)})
+        .sync_with  ({tgWin.inputs(Run), tgSgFlt.sigUpdExtIn(Modify)})
         .push_to    (out.m_tasks)
         .args       ({      idScnParts,                idUpdMach,                       idSigValFloat,                    idSigUpdFloat,                               idUserInput,                 idVhControls,           idDeltaTimeIn})
         .func([] (ACtxParts& rScnParts, MachineUpdater& rUpdMach, SignalValues_t<float>& rSigValFloat, UpdateNodes<float>& rSigUpdFloat, input::UserInputHandler const& rUserInput, VehicleControls& rVhControls, float const deltaTimeIn) noexcept
@@ -468,6 +878,11 @@ Session setup_vehicle_control(
             return; // No vehicle selected
         }
 
+        if ( ! rScnParts.machines.perType[gc_mtUserCtrl].localIds.exists(rVC.selectedUsrCtrl) )
+        {
+            return; // Selected vehicle was removed, camera task unselects it
+        }
+
         Nodes const &rFloatNodes = rScnParts.nodePerType[gc_ntSigFloat];
         float const thrRate = deltaTimeIn;
 
@@ -560,6 +975,13 @@ Session setup_camera_vehicle(
         .args       ({                 idCamCtrl,           idDeltaTimeIn,                 idBasic,                 idVhControls,                 idScnParts})
         .func([] (ACtxCameraController& rCamCtrl, float const deltaTimeIn, ACtxBasic const& rBasic, VehicleControls& rVhControls, ACtxParts const& rScnParts) noexcept
     {
+        if (   rVhControls.selectedUsrCtrl != lgrn::id_null<MachLocalId>()
+            && ! rScnParts.machines.perType.at(adera::gc_mtUserCtrl).localIds.exists(rVhControls.selectedUsrCtrl) )
+        {
+            rVhControls.selectedUsrCtrl = lgrn::id_null<MachLocalId>();
+            OSP_LOG_INFO("Selected vehicle was removed, unselected vehicles");
+        }
+
         if (rVhControls.selectedUsrCtrl != lgrn::id_null<MachLocalId>())
         {
             // Follow selected UserControl machine
@@ -72,4 +72,20 @@ osp::Session setup_thrust_indicators(
         osp::PkgId const            pkg,
         osp::draw::MaterialId       material);
 
+/**
+ * @brief Exhaust plumes behind Magic Rockets, draw with setup_shader_plume
+ */
+osp::Session setup_rocket_plumes(
+        osp::TopTaskBuilder&        rBuilder,
+        osp::ArrayView<entt::any>   topData,
+        osp::Session const&         application,
+        osp::Session const&         windowApp,
+        osp::Session const&         scene,
+        osp::Session const&         commonScene,
+        osp::Session const&         parts,
+        osp::Session const&         signalsFloat,
+        osp::Session const&         sceneRenderer,
+        osp::PkgId const            pkg,
+        osp::draw::MaterialId       material);
+
 } // namespace testapp::scenes
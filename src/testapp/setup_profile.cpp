@@ -0,0 +1,87 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "setup_profile.h"
+
+#include <osp/util/logging.h>
+
+#include <algorithm>
+
+namespace testapp
+{
+
+void SetupProfile::record(std::string_view const name, Clock_t::duration const time, bool const async)
+{
+    std::lock_guard<std::mutex> const lock{m_mutex};
+    m_entries.push_back({std::string{name}, time, async});
+}
+
+void SetupProfile::report(std::string_view const what, osp::Metrics const* const pMetrics)
+{
+    using Ms_t = std::chrono::duration<double, std::milli>;
+
+    std::vector<Entry> entries;
+    {
+        std::lock_guard<std::mutex> const lock{m_mutex};
+        entries = std::exchange(m_entries, {});
+    }
+
+    if (entries.empty())
+    {
+        return;
+    }
+
+    std::sort(entries.begin(), entries.end(), [] (Entry const& lhs, Entry const& rhs)
+    {
+        return lhs.time > rhs.time;
+    });
+
+    // Async steps overlap the others, so they're not part of the total
+    Clock_t::duration total{};
+    std::string lines;
+    for (Entry const& entry : entries)
+    {
+        double const ms = Ms_t{entry.time}.count();
+        if ( ! entry.async )
+        {
+            total += entry.time;
+        }
+        lines += fmt::format("\n* {:>9.2f} ms  {}{}", ms, entry.name, entry.async ? " (async)" : "");
+
+        if (pMetrics != nullptr)
+        {
+            pMetrics->gauge_set(fmt::format("startup_{}_ms", entry.name), ms);
+        }
+    }
+
+    OSP_LOG_INFO("{} setup took {:.2f} ms:{}", what, Ms_t{total}.count(), lines);
+}
+
+SetupProfile& setup_profile() noexcept
+{
+    static SetupProfile profile;
+    return profile;
+}
+
+} // namespace testapp
@@ -0,0 +1,146 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+#include <osp/util/metrics.h>
+
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Call a setup function and record how long it took in setup_profile()
+ *
+ * Use in place of the function name: TESTAPP_TIMED(setup_scene)(builder, rTopData, application)
+ */
+#define TESTAPP_TIMED(func)                                                                 \
+    ::testapp::SetupTimed{#func, [] (auto&& ... args) -> decltype(auto)                     \
+    {                                                                                       \
+        return func(std::forward<decltype(args)>(args)...);                                 \
+    }}
+
+namespace testapp
+{
+
+/**
+ * @brief Wall-clock time spent in each setup step while opening a scenario
+ *
+ * Steps are recorded as they finish, either by TESTAPP_TIMED or by jobs started with
+ * setup_async, then logged all at once by report(). Safe to record from multiple threads.
+ */
+class SetupProfile
+{
+public:
+    using Clock_t = std::chrono::steady_clock;
+
+    struct Entry
+    {
+        std::string         name;
+        Clock_t::duration   time;
+
+        /// Ran on its own thread by setup_async, overlapping other steps
+        bool                async;
+    };
+
+    void record(std::string_view name, Clock_t::duration time, bool async = false);
+
+    /**
+     * @brief Log steps since the last report and their total, slowest first, then clear them
+     *
+     * @param what      [in] What was set up, such as "Scene"
+     * @param pMetrics  [in] Optional, gets a "startup_<step>_ms" gauge for each step
+     */
+    void report(std::string_view what, osp::Metrics const* pMetrics);
+
+private:
+    std::mutex          m_mutex;
+    std::vector<Entry>  m_entries;
+};
+
+/**
+ * @return Profile recorded to by TESTAPP_TIMED and setup_async
+ */
+SetupProfile& setup_profile() noexcept;
+
+/**
+ * @brief Records the time from construction to destruction in setup_profile()
+ */
+struct SetupScope
+{
+    SetupScope(std::string_view name, bool async = false) noexcept
+     : m_name{name}
+     , m_start{SetupProfile::Clock_t::now()}
+     , m_async{async}
+    { }
+
+    ~SetupScope()
+    {
+        setup_profile().record(m_name, SetupProfile::Clock_t::now() - m_start, m_async);
+    }
+
+    std::string_view                m_name;
+    SetupProfile::Clock_t::time_point m_start;
+    bool                            m_async;
+};
+
+template <typename FUNC_T>
+struct SetupTimed
+{
+    template <typename ... ARGS_T>
+    decltype(auto) operator()(ARGS_T&& ... args)
+    {
+        SetupScope const scope{m_name};
+        return m_func(std::forward<ARGS_T>(args)...);
+    }
+
+    std::string_view    m_name;
+    FUNC_T              m_func;
+};
+
+template <typename FUNC_T>
+SetupTimed(std::string_view, FUNC_T) -> SetupTimed<FUNC_T>;
+
+/**
+ * @brief Start a setup step that only produces its own data on another thread
+ *
+ * For work such as LUT generation that doesn't touch TopData or any GL state. Start it before
+ * the sessions that don't depend on it are set up, then get() the result where it's needed.
+ */
+template <typename FUNC_T>
+[[nodiscard]] auto setup_async(std::string_view const name, FUNC_T&& func) -> std::shared_future<std::invoke_result_t<FUNC_T>>
+{
+    return std::async(std::launch::async, [name, func = std::forward<FUNC_T>(func)] () mutable
+    {
+        SetupScope const scope{name, true};
+        return func();
+    }).share();
+}
+
+} // namespace testapp
@@ -24,17 +24,69 @@
  */
 #include "testapp.h"
 #include "identifiers.h"
+#include "scenarios.h"
 
 #include <osp/core/Resources.h>
+#include <osp/core/memory_tracking.h>
+#include <osp/core/string_concat.h>
 #include <osp/drawing/own_restypes.h>
 #include <osp/tasks/top_execute.h>
+#include <osp/tasks/top_memory.h>
 #include <osp/tasks/top_utils.h>
+#include <osp/util/profiling.h>
 #include <osp/vehicles/ImporterData.h>
 #include <spdlog/fmt/ostr.h>
 
+#include <Corrade/Containers/ArrayViewStl.h>
+
+#include <algorithm>
+#include <cctype>
+#include <ostream>
+
 namespace testapp
 {
 
+osp::Resources& TestApp::setup_application(osp::Resources resources)
+{
+    using namespace osp;
+
+    TopTaskBuilder builder{m_tasks, m_applicationGroup.m_edges, m_taskData};
+    auto const plApp = m_application.create_pipelines<PlApplication>(builder);
+
+    builder.pipeline(plApp.mainLoop).loops(true).wait_for_signal(EStgOptn::ModifyOrSignal);
+
+    // declares idResources, idMainLoopCtrl, and idMetrics
+    OSP_DECLARE_CREATE_DATA_IDS(m_application, m_topData, TESTAPP_DATA_APPLICATION);
+
+    auto &rResources = top_emplace<Resources>       (m_topData, idResources, std::move(resources));
+    /* unused */       top_emplace<MainLoopControl> (m_topData, idMainLoopCtrl);
+    auto &rMetrics   = top_emplace<Metrics>         (m_topData, idMetrics);
+
+    m_pExecutor->m_pMetrics = &rMetrics;
+
+    builder.task()
+        .name       ("Schedule Main Loop")
+        .schedules  ({plApp.mainLoop(EStgOptn::Schedule)})
+        .push_to    (m_application.m_tasks)
+        .args       ({                  idMainLoopCtrl})
+        .func([] (MainLoopControl const& rMainLoopCtrl) noexcept -> TaskActions
+    {
+        if (   ! rMainLoopCtrl.doUpdate
+            && ! rMainLoopCtrl.doSync
+            && ! rMainLoopCtrl.doResync
+            && ! rMainLoopCtrl.doRender)
+        {
+            return TaskAction::Cancel;
+        }
+        else
+        {
+            return { };
+        }
+    });
+
+    return rResources;
+}
+
 void TestApp::close_sessions(osp::ArrayView<osp::Session> const sessions)
 {
     using namespace osp;
@@ -68,10 +120,7 @@ void TestApp::close_sessions(osp::ArrayView<osp::Session> const sessions)
         {
             m_tasks.m_taskIds.remove(task);
 
-            TopTask &rCurrTaskData = m_taskData[task];
-            rCurrTaskData.m_debugName.clear();
-            rCurrTaskData.m_dataUsed.clear();
-            rCurrTaskData.m_func = nullptr;
+            m_taskData[task] = {};
         }
         rSession.m_tasks.clear();
 
@@ -140,12 +189,218 @@ void TestApp::clear_resource_owners()
 //-----------------------------------------------------------------------------
 
 
+void IExecutor::label_sessions(TestApp const& rTestApp)
+{
+    m_taskSession.clear();
+    m_sessionMetric.clear();
+    m_sessionMemMetric.clear();
+    m_sessionData.clear();
+
+    auto const add = [this] (osp::Session const& session, std::string name)
+    {
+        auto const index = std::uint32_t(m_sessionMetric.size());
+        for (osp::TaskId const task : session.m_tasks)
+        {
+            if (m_taskSession.size() <= std::size_t(task))
+            {
+                m_taskSession.resize(std::size_t(task) + 1, smc_noSession);
+            }
+            m_taskSession[task] = index;
+        }
+
+        // Pipeline struct name, such as "PlJolt", is the most readable name a Session has.
+        // Mangled type names end with it, possibly followed by 'E' (Itanium ABI)
+        std::string_view structName = session.m_structName;
+        if (structName.size() > 1 && structName.front() == 'N' && structName.back() == 'E')
+        {
+            structName.remove_suffix(1);
+        }
+        std::size_t const nameStart = structName.find_last_not_of(
+                "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_0123456789");
+        if (nameStart != std::string_view::npos)
+        {
+            structName.remove_prefix(nameStart + 1);
+        }
+        while ( ! structName.empty() && std::isdigit(static_cast<unsigned char>(structName.front())) )
+        {
+            structName.remove_prefix(1); // Length prefixes of mangled names
+        }
+
+        std::string const label = structName.empty() ? name : osp::string_concat(name, ".", structName);
+        m_sessionMetric   .emplace_back(osp::string_concat("task_ms.", label));
+        m_sessionMemMetric.emplace_back(osp::string_concat("mem_bytes.", label));
+        m_sessionData     .emplace_back(session.m_data);
+    };
+
+    add(rTestApp.m_application, "application");
+    add(rTestApp.m_windowApp,   "windowApp");
+    add(rTestApp.m_magnum,      "magnum");
+    for (std::size_t i = 0; i < rTestApp.m_scene.m_sessions.size(); ++i)
+    {
+        add(rTestApp.m_scene.m_sessions[i], osp::string_concat("scene", std::to_string(i)));
+    }
+    for (std::size_t i = 0; i < rTestApp.m_renderer.m_sessions.size(); ++i)
+    {
+        add(rTestApp.m_renderer.m_sessions[i], osp::string_concat("renderer", std::to_string(i)));
+    }
+
+    m_sessionTime.assign(m_sessionMetric.size(), 0.0);
+}
+
+void IExecutor::write_critical_path(std::ostream& rStream, TestAppTasks const& appTasks, std::size_t const firstFrame) const
+{
+    if (m_pTrace == nullptr)
+    {
+        return;
+    }
+
+    // "task_ms.scene0.PlJolt" -> "scene0.PlJolt"
+    std::vector<std::string> sessionNames;
+    sessionNames.reserve(m_sessionMetric.size());
+    for (std::string_view name : m_sessionMetric)
+    {
+        name.remove_prefix(std::min(name.find('.') + 1, name.size()));
+        sessionNames.emplace_back(name);
+    }
+
+    osp::TopTraceCriticalPath const path = osp::top_trace_critical_path(appTasks.m_tasks, appTasks.m_graph, *m_pTrace, firstFrame);
+
+    rStream << osp::TopExecWriteCriticalPath{
+        .taskData   = appTasks.m_taskData,
+        .path       = path,
+        .taskGroup  = m_taskSession,
+        .groupNames = sessionNames };
+}
+
+osp::TopExecTrace* IExecutor::run_trace() noexcept
+{
+    if (m_pTrace != nullptr)
+    {
+        return m_pTrace.get();
+    }
+    return (m_pMetrics != nullptr) ? &m_metricsTrace : nullptr;
+}
+
+void IExecutor::record_metrics(osp::ExecContext const& exec, osp::TopExecTrace *pTrace, std::size_t const firstTaskEvent, Clock_t::time_point const start)
+{
+    if (m_pMetrics == nullptr)
+    {
+        return;
+    }
+
+    osp::Metrics const &rMetrics = *m_pMetrics;
+
+    rMetrics.histogram_record("exec.wait_ms", std::chrono::duration<double, std::milli>(Clock_t::now() - start).count());
+
+    osp::ExecStats const &stats = exec.stats;
+    rMetrics.counter_add("exec.updates",            stats.updates            - m_prevStats.updates);
+    rMetrics.counter_add("exec.update_cycles",      stats.cycles             - m_prevStats.cycles);
+    rMetrics.counter_add("exec.pipelines_advanced", stats.pipelinesAdvanced  - m_prevStats.pipelinesAdvanced);
+    rMetrics.gauge_set  ("exec.max_cycles_per_update", stats.maxCyclesPerUpdate);
+    m_prevStats = stats;
+
+    if (pTrace == nullptr)
+    {
+        return;
+    }
+
+    // Sum task time per session, including time spent on worker threads
+    for (std::size_t i = firstTaskEvent; i < pTrace->taskEvents.size(); ++i)
+    {
+        osp::TopExecTrace::TaskEvent const &event = pTrace->taskEvents[i];
+        if (std::size_t(event.task) < m_taskSession.size()
+            && m_taskSession[event.task] != smc_noSession)
+        {
+            m_sessionTime[m_taskSession[event.task]] += std::chrono::duration<double, std::milli>(event.end - event.start).count();
+        }
+    }
+
+    for (std::size_t i = 0; i < m_sessionTime.size(); ++i)
+    {
+        if (m_sessionTime[i] != 0.0)
+        {
+            rMetrics.histogram_record(m_sessionMetric[i], m_sessionTime[i]);
+            m_sessionTime[i] = 0.0;
+        }
+    }
+
+    if (pTrace == &m_metricsTrace)
+    {
+        m_metricsTrace.taskEvents.clear();
+        m_metricsTrace.stageEvents.clear();
+        m_metricsTrace.frameStarts.clear();
+    }
+}
+
+void IExecutor::flush_worker(osp::WorkerLocal& rLocal, std::uint32_t const workerIndex)
+{
+    if (m_pMetrics != nullptr)
+    {
+        osp::Metrics const &rMetrics = *m_pMetrics;
+        for (osp::WorkerMetric const& metric : rLocal.metrics)
+        {
+            switch (metric.kind)
+            {
+            case osp::WorkerMetric::EKind::Counter:
+                rMetrics.counter_add(metric.name, std::int64_t(metric.value));
+                break;
+            case osp::WorkerMetric::EKind::Gauge:
+                rMetrics.gauge_set(metric.name, metric.value);
+                break;
+            case osp::WorkerMetric::EKind::Histogram:
+                rMetrics.histogram_record(metric.name, metric.value);
+                break;
+            }
+        }
+    }
+    rLocal.metrics.clear();
+
+    for (std::string const& msg : rLocal.logMsgs)
+    {
+        OSP_LOG_INFO("[worker {}] {}", workerIndex, msg);
+    }
+    rLocal.logMsgs.clear();
+}
+
+//-----------------------------------------------------------------------------
+
 void SingleThreadedExecutor::load(TestAppTasks& rAppTasks)
 {
     osp::exec_conform(rAppTasks.m_tasks, m_execContext);
+    osp::top_dispatch_build(m_dispatch, rAppTasks.m_taskData, rAppTasks.m_topData);
     m_execContext.doLogging = m_log != nullptr;
 }
 
+void IExecutor::record_memory(TestAppTasks const& appTasks)
+{
+    Clock_t::time_point const now = Clock_t::now();
+    if (m_pMetrics == nullptr || now - m_lastMemory < smc_memoryPeriod)
+    {
+        return;
+    }
+    m_lastMemory = now;
+
+    osp::Metrics const &rMetrics = *m_pMetrics;
+
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < m_sessionData.size(); ++i)
+    {
+        osp::TopMemory const mem = osp::top_memory_bytes(appTasks.m_topData, m_sessionData[i]);
+        if (mem.tracked != 0)
+        {
+            rMetrics.gauge_set(m_sessionMemMetric[i], double(mem.bytes));
+            total += mem.bytes;
+        }
+    }
+    rMetrics.gauge_set("mem_bytes.total", double(total));
+
+    for (osp::MemoryCategoryStats const& category : osp::memory_category_stats())
+    {
+        rMetrics.gauge_set(osp::string_concat("mem_live.", category.name), double(category.live));
+        rMetrics.gauge_set(osp::string_concat("mem_peak.", category.name), double(category.peak));
+    }
+}
+
 void SingleThreadedExecutor::run(TestAppTasks& rAppTasks, osp::PipelineId pipeline)
 {
     osp::exec_request_run(m_execContext, pipeline);
@@ -166,8 +421,20 @@ void SingleThreadedExecutor::wait(TestAppTasks& rAppTasks)
         m_execContext.logMsg.clear();
     }
 
+    Clock_t::time_point const   start           = Clock_t::now();
+    osp::TopExecTrace           *pTrace         = run_trace();
+    std::size_t const           firstTaskEvent  = (pTrace != nullptr) ? pTrace->taskEvents.size() : 0;
+    if (pTrace != nullptr)
+    {
+        osp::top_trace_frame(*pTrace);
+    }
+
     osp::exec_update(rAppTasks.m_tasks, rAppTasks.m_graph, m_execContext);
-    osp::top_run_blocking(rAppTasks.m_tasks, rAppTasks.m_graph, rAppTasks.m_taskData, rAppTasks.m_topData, m_execContext);
+    osp::top_run_blocking(rAppTasks.m_tasks, rAppTasks.m_graph, rAppTasks.m_taskData, m_dispatch, rAppTasks.m_topData, m_execContext, {.m_pLocal = &m_workerLocal}, pTrace);
+
+    record_metrics(m_execContext, pTrace, firstTaskEvent, start);
+    record_memory(rAppTasks);
+    flush_worker(m_workerLocal, 0);
 
     if (m_log != nullptr)
     {
@@ -182,5 +449,78 @@ bool SingleThreadedExecutor::is_running(TestAppTasks const& appTasks)
     return m_execContext.hasRequestRun || (m_execContext.pipelinesRunning != 0);
 }
 
+//-----------------------------------------------------------------------------
+
+ThreadPoolExecutor::ThreadPoolExecutor(std::size_t const threadCount, osp::Logger_t workerLogger)
+ : m_pool{threadCount, [workerLogger = std::move(workerLogger)] (std::size_t const workerIndex)
+   {
+       // Separate logger per worker, so messages show which worker they came from. Clones share
+       // sinks, and with an async logger, its queue and flusher thread.
+       osp::Logger_t logger = workerLogger->clone(fmt::format("{}-{}", workerLogger->name(), workerIndex));
+       OSP_PROFILE_THREAD_NAME(logger->name().c_str());
+       osp::set_thread_logger(std::move(logger));
+   }, 1}
+{ }
+
+void ThreadPoolExecutor::load(TestAppTasks& rAppTasks)
+{
+    osp::exec_conform(rAppTasks.m_tasks, m_execContext);
+    osp::top_dispatch_build(m_dispatch, rAppTasks.m_taskData, rAppTasks.m_topData);
+    m_execContext.doLogging = m_log != nullptr;
+}
+
+void ThreadPoolExecutor::run(TestAppTasks& rAppTasks, osp::PipelineId pipeline)
+{
+    osp::exec_request_run(m_execContext, pipeline);
+}
+
+void ThreadPoolExecutor::signal(TestAppTasks& rAppTasks, osp::PipelineId pipeline)
+{
+    osp::exec_signal(m_execContext, pipeline);
+}
+
+void ThreadPoolExecutor::wait(TestAppTasks& rAppTasks)
+{
+    if (m_log != nullptr)
+    {
+        m_log->info("\n>>>>>>>>>> Previous State Changes\n{}\n>>>>>>>>>> Current State\n{}\n",
+                    osp::TopExecWriteLog  {rAppTasks.m_tasks, rAppTasks.m_taskData, rAppTasks.m_graph, m_execContext},
+                    osp::TopExecWriteState{rAppTasks.m_tasks, rAppTasks.m_taskData, rAppTasks.m_graph, m_execContext} );
+        m_execContext.logMsg.clear();
+    }
+
+    Clock_t::time_point const   start           = Clock_t::now();
+    osp::TopExecTrace           *pTrace         = run_trace();
+    std::size_t const           firstTaskEvent  = (pTrace != nullptr) ? pTrace->taskEvents.size() : 0;
+    if (pTrace != nullptr)
+    {
+        osp::top_trace_frame(*pTrace);
+    }
+
+    osp::exec_update(rAppTasks.m_tasks, rAppTasks.m_graph, m_execContext);
+    osp::top_run_parallel(rAppTasks.m_tasks, rAppTasks.m_graph, rAppTasks.m_taskData, rAppTasks.m_topData, m_execContext, m_pool, pTrace, m_coordinatorData, &m_dispatch);
+
+    record_metrics(m_execContext, pTrace, firstTaskEvent, start);
+    record_memory(rAppTasks);
+
+    // Nothing is in flight anymore, so worker buffers are safe to take from here
+    for (std::uint32_t i = 0; i <= m_pool.thread_count(); ++i)
+    {
+        flush_worker(m_pool.worker_local(i), i);
+    }
+
+    if (m_log != nullptr)
+    {
+        m_log->info("\n>>>>>>>>>> New State Changes\n{}",
+                    osp::TopExecWriteLog{rAppTasks.m_tasks, rAppTasks.m_taskData, rAppTasks.m_graph, m_execContext} );
+        m_execContext.logMsg.clear();
+    }
+}
+
+bool ThreadPoolExecutor::is_running(TestAppTasks const& appTasks)
+{
+    return m_execContext.hasRequestRun || (m_execContext.pipelinesRunning != 0);
+}
+
 
 } // namespace testapp
@@ -25,14 +25,19 @@
 #pragma once
 
 #include <osp/core/keyed_vector.h>
+#include <osp/core/package_archive.h>
+#include <osp/core/Resources.h>
 #include <osp/core/resourcetypes.h>
 #include <osp/tasks/tasks.h>
 #include <osp/tasks/top_execute.h>
 #include <osp/tasks/top_session.h>
+#include <osp/tasks/top_worker_pool.h>
 #include <osp/util/logging.h>
+#include <osp/util/metrics.h>
 
 #include <entt/core/any.hpp>
 
+#include <atomic>
 #include <optional>
 
 namespace testapp
@@ -54,6 +59,17 @@ struct TestAppTasks
 
 struct TestApp : TestAppTasks
 {
+    /**
+     * @brief Create m_application: the mainLoop pipeline, Resources, MainLoopControl, and Metrics
+     *
+     * m_pExecutor must be set first, its m_pMetrics is pointed at the new Metrics.
+     *
+     * @param resources [in] Resources to use, such as one shared with another TestApp
+     *
+     * @return Resources now in m_topData
+     */
+    osp::Resources& setup_application(osp::Resources resources);
+
     void close_sessions(osp::ArrayView<osp::Session> sessions);
 
     void close_session(osp::Session &rSession);
@@ -74,15 +90,29 @@ struct TestApp : TestAppTasks
 
     RendererSetupFunc_t             m_rendererSetup { nullptr };
 
+    /// Scene to switch to while MagnumApplication is open, consumed by its thread between frames
+    std::atomic<SceneSetupFunc_t>   m_pendingScene  { nullptr };
+
     IExecutor                       *m_pExecutor { nullptr };
 
+    /// Update the scene at its fixed delta time instead of once per frame drawn
+    bool                            m_fixedSimStep  { false };
+
+    /// UDP port scenes serve vehicle replication on, 0 to not replicate
+    std::uint16_t                   m_replicationPort { 0 };
+
     osp::PkgId                      m_defaultPkg    { lgrn::id_null<osp::PkgId>() };
+
+    // Archives that packages are loaded from, for packages that aren't loose files
+    osp::PackageArchives            m_packages;
 };
 
 class IExecutor
 {
 public:
 
+    virtual ~IExecutor() = default;
+
     virtual void load(TestAppTasks& rAppTasks) = 0;
 
     virtual void run(TestAppTasks& rAppTasks, osp::PipelineId pipeline) = 0;
@@ -92,6 +122,81 @@ public:
     virtual void wait(TestAppTasks& rAppTasks) = 0;
 
     virtual bool is_running(TestAppTasks const& rAppTasks) = 0;
+
+    /**
+     * @brief Name each task after the Session it belongs to, for per-session task time and
+     *        memory metrics
+     *
+     * Call again after sessions are opened or closed. Tasks not in any session aren't recorded.
+     */
+    void label_sessions(TestApp const& rTestApp);
+
+    /**
+     * @brief Write the critical path of tasks recorded in m_pTrace, grouped by Session
+     *
+     * Does nothing if m_pTrace is null. See osp::top_trace_critical_path
+     *
+     * @param firstFrame    [in] Index of the first frame to include, frames before it may have
+     *                           run with a different graph
+     */
+    void write_critical_path(std::ostream& rStream, TestAppTasks const& appTasks, std::size_t firstFrame) const;
+
+    std::shared_ptr<spdlog::logger> m_log;
+
+    /// Records task timings if not null, see osp::TopExecWriteChromeTrace
+    std::unique_ptr<osp::TopExecTrace> m_pTrace;
+
+    /// Records wait() time, exec_update cycles, and task time per Session if not null
+    osp::Metrics const              *m_pMetrics { nullptr };
+
+protected:
+
+    using Clock_t = osp::TopExecTrace::Clock_t;
+
+    /**
+     * @brief Trace to pass to top_run_*: m_pTrace if set, otherwise one only used for metrics
+     */
+    [[nodiscard]] osp::TopExecTrace* run_trace() noexcept;
+
+    /**
+     * @brief Record metrics of a wait() that started at start
+     *
+     * @param pTrace            [in] Trace returned by run_trace()
+     * @param firstTaskEvent    [in] Size of pTrace->taskEvents before running
+     */
+    void record_metrics(osp::ExecContext const& exec, osp::TopExecTrace *pTrace, std::size_t firstTaskEvent, Clock_t::time_point start);
+
+    /**
+     * @brief Set memory gauges of each Session's TopData and each osp::MemoryCategory
+     *
+     * Gauges are "mem_bytes.<session>", "mem_bytes.total", and "mem_live.<category>" and
+     * "mem_peak.<category>". Reads TopData, so only call while no tasks are running. Does nothing
+     * if m_pMetrics is null or if called again within smc_memoryPeriod.
+     */
+    void record_memory(TestAppTasks const& appTasks);
+
+    /**
+     * @brief Move metrics and log messages buffered by tasks into m_pMetrics and the thread logger
+     *
+     * Metrics are discarded if m_pMetrics is null.
+     */
+    void flush_worker(osp::WorkerLocal& rLocal, std::uint32_t workerIndex);
+
+private:
+
+    static constexpr std::uint32_t smc_noSession = ~std::uint32_t(0);
+
+    /// Summing TopData walks every container, too slow for every frame
+    static constexpr std::chrono::seconds smc_memoryPeriod{1};
+
+    osp::TopExecTrace                                   m_metricsTrace;
+    osp::KeyedVec<osp::TaskId, std::uint32_t>           m_taskSession;
+    std::vector<std::string>                            m_sessionMetric;
+    std::vector<double>                                 m_sessionTime;
+    std::vector<std::string>                            m_sessionMemMetric;
+    std::vector< std::vector<osp::TopDataId> >          m_sessionData;
+    Clock_t::time_point                                 m_lastMemory;
+    osp::ExecStats                                      m_prevStats;
 };
 
 //-----------------------------------------------------------------------------
@@ -110,7 +215,50 @@ public:
     bool is_running(TestAppTasks const& rAppTasks) override;
 
     osp::ExecContext                m_execContext;
-    std::shared_ptr<spdlog::logger> m_log;
+    osp::TopTaskDispatch            m_dispatch;
+    osp::WorkerLocal                m_workerLocal;
+};
+
+//-----------------------------------------------------------------------------
+
+/**
+ * @brief Runs tasks on a pool of worker threads, see osp::top_run_parallel
+ *
+ * The thread calling wait() coordinates the pool. Tasks using any of m_coordinatorData, or with
+ * osp::TopTaskAffinity::Main, only run on that thread. One dedicated worker is started on top of
+ * threadCount for osp::TopTaskAffinity::Dedicated tasks. Coroutine tasks are resumed on that
+ * thread too, using m_dispatch.
+ */
+class ThreadPoolExecutor final : public IExecutor
+{
+public:
+    /**
+     * @param threadCount   [in] Number of worker threads
+     * @param workerLogger  [in] Cloned into each worker thread's osp::t_logger, named after the worker
+     */
+    ThreadPoolExecutor(std::size_t threadCount, osp::Logger_t workerLogger);
+
+    void load(TestAppTasks& rAppTasks) override;
+
+    void run(TestAppTasks& rAppTasks, osp::PipelineId pipeline) override;
+
+    void signal(TestAppTasks& rAppTasks, osp::PipelineId pipeline) override;
+
+    void wait(TestAppTasks& rAppTasks) override;
+
+    bool is_running(TestAppTasks const& rAppTasks) override;
+
+    osp::ExecContext                m_execContext;
+    osp::TopTaskDispatch            m_dispatch;
+
+    /// TopData only to be touched by the thread calling wait(), such as anything holding GL objects
+    std::vector<osp::TopDataId>     m_coordinatorData;
+
+    /// Pool that wait() runs tasks on, can be shared by other runs while wait() isn't running
+    [[nodiscard]] osp::TopWorkerPool& pool() noexcept { return m_pool; }
+
+private:
+    osp::TopWorkerPool              m_pool;
 };
 
 } // namespace testapp
@@ -0,0 +1,131 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+// Helpers shared by the benchmarks in test/*/bench. Each benchmark is a plain executable that
+// writes CSV to the path given on its command line, or to stdout.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace osp::bench
+{
+
+using Clock_t = std::chrono::steady_clock;
+
+inline double micros_since(Clock_t::time_point const start)
+{
+    return std::chrono::duration<double, std::micro>(Clock_t::now() - start).count();
+}
+
+/**
+ * @brief Median of measurements, reorders rValues
+ */
+inline double median(std::vector<double>& rValues)
+{
+    auto const mid = rValues.begin() + std::ptrdiff_t(rValues.size() / 2);
+    std::nth_element(rValues.begin(), mid, rValues.end());
+    return *mid;
+}
+
+/**
+ * @brief Parse a comma-separated list of counts, such as "1000,10000,100000"
+ */
+inline std::vector<std::size_t> parse_counts(char const* str)
+{
+    std::vector<std::size_t> out;
+    std::string const list{str};
+    std::size_t start = 0;
+    while (start < list.size())
+    {
+        std::size_t const end = std::min(list.find(',', start), list.size());
+        out.push_back(std::stoul(list.substr(start, end - start)));
+        start = end + 1;
+    }
+    return out;
+}
+
+/**
+ * @brief Get the value of a "--name value" option at argv[rI]
+ *
+ * @return The value, with rI moved onto it. Null if argv[rI] isn't this option or has no value.
+ */
+inline char const* option_value(int const argc, char** argv, int& rI, char const* name)
+{
+    if (std::strcmp(argv[rI], name) != 0 || rI + 1 >= argc)
+    {
+        return nullptr;
+    }
+    return argv[++rI];
+}
+
+/**
+ * @brief Keep a result around, so the work computing it isn't optimized out
+ */
+template <typename T>
+void keep_result(T const value) noexcept
+{
+    static T volatile s_sink;
+    s_sink = value;
+}
+
+/**
+ * @brief File that CSV rows are written to, opened from a path or stdout if null
+ */
+class CsvOutput
+{
+public:
+    explicit CsvOutput(char const* path)
+     : m_pFile{(path != nullptr) ? std::fopen(path, "w") : stdout}
+    {
+        if (m_pFile == nullptr)
+        {
+            std::fprintf(stderr, "Can't open %s\n", path);
+        }
+    }
+
+    CsvOutput(CsvOutput const&) = delete;
+    CsvOutput& operator=(CsvOutput const&) = delete;
+
+    ~CsvOutput()
+    {
+        if (m_pFile != nullptr && m_pFile != stdout)
+        {
+            std::fclose(m_pFile);
+        }
+    }
+
+    /// Null if the file couldn't be opened
+    [[nodiscard]] std::FILE* file() const noexcept { return m_pFile; }
+
+private:
+    std::FILE *m_pFile;
+};
+
+} // namespace osp::bench
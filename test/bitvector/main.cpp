@@ -0,0 +1,155 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <osp/core/bitvector.h>
+#include <osp/core/id_bitset.h>
+
+#include <longeron/id_management/id_set_stl.hpp>
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using osp::bitint_t;
+
+namespace
+{
+
+enum class TestId : std::uint32_t { };
+
+std::vector<std::size_t> naive_ones(std::vector<bool> const& a, std::vector<bool> const& b, bool andNot)
+{
+    std::vector<std::size_t> out;
+    for (std::size_t i = 0; i < a.size(); ++i)
+    {
+        bool const inB = i < b.size() && b[i];
+        if (a[i] && (andNot ? ! inB : inB))
+        {
+            out.push_back(i);
+        }
+    }
+    return out;
+}
+
+} // namespace
+
+// Word-level iteration visits the same IDs as checking each one, including across word
+// boundaries and with sets of different sizes
+TEST(BitVector, IterateAndAndNot)
+{
+    std::size_t const sizeA = 300;
+    std::size_t const sizeB = 130;
+
+    lgrn::IdSetStl<TestId> a;
+    lgrn::IdSetStl<TestId> b;
+    a.resize(sizeA);
+    b.resize(sizeB);
+
+    std::vector<bool> naiveA(sizeA, false);
+    std::vector<bool> naiveB(sizeB, false);
+
+    for (std::size_t i = 0; i < sizeA; i += 3)
+    {
+        a.insert(TestId(i));
+        naiveA[i] = true;
+    }
+    for (std::size_t i : {0, 1, 63, 64, 65, 99, 127, 128, 129})
+    {
+        b.insert(TestId(i));
+        naiveB[i] = true;
+    }
+    a.insert(TestId(299));
+    naiveA[299] = true;
+
+    std::vector<std::size_t> gotAnd;
+    for (TestId const id : osp::bit_ones_and<TestId>(osp::bit_words(a), osp::bit_words(b)))
+    {
+        gotAnd.push_back(std::size_t(id));
+    }
+    EXPECT_EQ(gotAnd, naive_ones(naiveA, naiveB, false));
+
+    std::vector<std::size_t> gotAndNot;
+    for (std::size_t const id : osp::bit_ones_andnot(osp::bit_words(a), osp::bit_words(b)))
+    {
+        gotAndNot.push_back(id);
+    }
+    EXPECT_EQ(gotAndNot, naive_ones(naiveA, naiveB, true));
+
+    EXPECT_EQ(osp::bit_count(osp::bit_words(a)),                        101);
+    EXPECT_EQ(osp::bit_count_and(osp::bit_words(a), osp::bit_words(b)), gotAnd.size());
+}
+
+TEST(BitVector, Assign)
+{
+    osp::BitVector_t a;
+    osp::BitVector_t b;
+    osp::bitvector_resize(a, 128);
+    osp::bitvector_resize(b, 64);
+
+    a.ints() = {0b1100, 0b1};
+    b.ints() = {0b1010};
+
+    osp::bit_or_assign(osp::bit_words(a), osp::bit_words(b));
+    EXPECT_EQ(a.ints(), (std::vector<bitint_t>{0b1110, 0b1}));
+
+    osp::bit_andnot_assign(osp::bit_words(a), osp::bit_words(b));
+    EXPECT_EQ(a.ints(), (std::vector<bitint_t>{0b0100, 0b1}));
+
+    // Words past the end of b are cleared
+    osp::bit_and_assign(osp::bit_words(a), osp::bit_words(b));
+    EXPECT_EQ(a.ints(), (std::vector<bitint_t>{0b0000, 0b0}));
+}
+
+// Resizing a live set keeps its IDs, as the executor does when pipelines are added
+TEST(IdBitSet, ResizeKeepsContents)
+{
+    osp::IdBitSet<TestId> set;
+    set.resize(70);
+    set.insert(TestId(3));
+    set.insert(TestId(64));
+    set.insert(TestId(69));
+
+    set.resize(200);
+    EXPECT_EQ(set.capacity(), 200);
+    EXPECT_TRUE(set.contains(TestId(3)));
+    EXPECT_TRUE(set.contains(TestId(64)));
+    EXPECT_TRUE(set.contains(TestId(69)));
+    EXPECT_FALSE(set.contains(TestId(150)));
+
+    set.insert(TestId(150));
+    EXPECT_EQ((std::vector<TestId>(set.begin(), set.end())),
+              (std::vector<TestId>{TestId(3), TestId(64), TestId(69), TestId(150)}));
+
+    // Shrinking drops IDs past the end, and growing again doesn't bring them back
+    set.resize(65);
+    set.resize(200);
+    EXPECT_EQ((std::vector<TestId>(set.begin(), set.end())),
+              (std::vector<TestId>{TestId(3), TestId(64)}));
+
+    set.resize(3);
+    EXPECT_TRUE(set.empty());
+    set.resize(100);
+    EXPECT_TRUE(set.empty());
+    EXPECT_EQ(set.begin(), set.end());
+}
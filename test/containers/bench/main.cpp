@@ -0,0 +1,368 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Micro benchmark of the three containers components and IDs are kept in: entt storage
+// (Storage_t, e.g. ACtxBasic::m_transform), tables indexed by ID (KeyedVec, e.g. draw
+// transforms and the Jolt entity-body tables), and hash maps (IdMap_t). Writes CSV.
+//
+// Usage: osp-bench-containers [output.csv] [--ids N,N,...] [--reps N]
+//
+//   --ids N,...        Component counts (default: 1000,10000,100000,1000000)
+//   --reps N           Repetitions of each measurement, the median is written (default: 21)
+//
+// Every other entity has the component. Each container is measured with ACompTransform (64 bytes)
+// and ACompMass (28 bytes). Times are in microseconds:
+//   lookup     Reading the component of every entity that has one, in random order
+//   dense      Reading every component, the way whole-scene passes iterate
+//   dirty      Reading the components of a random 1% of entities, sorted by ID, the way
+//              dirty lists like ACtxPhysics::m_setVelocity are applied
+//   churn      Removing a random 10% of the components then adding them back
+//   bytes      Heap memory after filling, estimated from container capacities
+
+#include "../../bench_utils.h"
+
+#include <osp/activescene/active_ent.h>
+#include <osp/activescene/basic.h>
+#include <osp/activescene/physics.h>
+#include <osp/core/id_map.h>
+#include <osp/core/keyed_vector.h>
+#include <osp/core/memory_usage.h>
+#include <osp/core/storage.h>
+
+#include <longeron/id_management/id_set_stl.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using osp::active::ACompMass;
+using osp::active::ACompTransform;
+using osp::active::ActiveEnt;
+using osp::bench::Clock_t;
+using osp::bench::median;
+using osp::bench::micros_since;
+
+namespace
+{
+
+constexpr std::size_t gc_entsPerComp    = 2;
+constexpr std::size_t gc_dirtyPercent   = 1;
+constexpr std::size_t gc_churnPercent   = 10;
+
+// A float that depends on the component read, summed so reads can't be optimized out
+float sample(ACompTransform const& comp) noexcept { return comp.m_transform[3][0]; }
+float sample(ACompMass const& comp)      noexcept { return comp.m_mass; }
+
+// Every component samples to 1, so sums over N components are exactly N
+template <typename COMP_T>
+COMP_T make_comp() noexcept
+{
+    COMP_T comp{};
+    if constexpr (std::is_same_v<COMP_T, ACompTransform>)
+    {
+        comp.m_transform[3][0] = 1.0f;
+    }
+    else
+    {
+        comp.m_mass = 1.0f;
+    }
+    return comp;
+}
+
+/**
+ * @brief entt storage: sparse set of entities with components packed in pages
+ */
+template <typename COMP_T>
+struct StorageContainer
+{
+    static constexpr char const* smc_name = "storage";
+
+    osp::Storage_t<ActiveEnt, COMP_T> comps;
+
+    void add(ActiveEnt const ent, COMP_T const& comp) { comps.emplace(ent, comp); }
+    void remove(ActiveEnt const ent)                   { comps.erase(ent); }
+
+    COMP_T const& get(ActiveEnt const ent) const       { return comps.get(ent); }
+
+    float sum_dense() const
+    {
+        float sum = 0.0f;
+        for (COMP_T const& comp : comps)
+        {
+            sum += sample(comp);
+        }
+        return sum;
+    }
+
+    /// Payload and packed entities share capacity, the sparse array spans the largest entity
+    std::size_t bytes() const noexcept
+    {
+        return comps.capacity() * (sizeof(COMP_T) + sizeof(ActiveEnt))
+             + comps.extent()   * sizeof(ActiveEnt);
+    }
+};
+
+/**
+ * @brief Table indexed by entity, with an IdSetStl of which entries are in use
+ *
+ * Passes over all components iterate the set, the way draw data is iterated with
+ * ACtxSceneRender::m_visible.
+ */
+template <typename COMP_T>
+struct KeyedVecContainer
+{
+    static constexpr char const* smc_name = "keyedvec";
+
+    osp::KeyedVec<ActiveEnt, COMP_T>    comps;
+    lgrn::IdSetStl<ActiveEnt>           used;
+
+    void add(ActiveEnt const ent, COMP_T const& comp)
+    {
+        if (std::size_t(ent) >= comps.size())
+        {
+            std::size_t const size = std::max(std::size_t(ent) + 1, comps.size() * 2);
+            comps.resize(size);
+            used.resize(size);
+        }
+        comps[ent] = comp;
+        used.insert(ent);
+    }
+
+    void remove(ActiveEnt const ent) { used.erase(ent); }
+
+    COMP_T const& get(ActiveEnt const ent) const { return comps[ent]; }
+
+    float sum_dense() const
+    {
+        float sum = 0.0f;
+        for (ActiveEnt const ent : used)
+        {
+            sum += sample(comps[ent]);
+        }
+        return sum;
+    }
+
+    std::size_t bytes() const noexcept
+    {
+        return osp::heap_bytes(comps) + (used.capacity() + 63) / 64 * sizeof(std::uint64_t);
+    }
+};
+
+/**
+ * @brief Hash map from entity to component
+ */
+template <typename COMP_T>
+struct IdMapContainer
+{
+    static constexpr char const* smc_name = "idmap";
+
+    osp::IdMap_t<ActiveEnt, COMP_T> comps;
+
+    void add(ActiveEnt const ent, COMP_T const& comp) { comps.emplace(ent, comp); }
+    void remove(ActiveEnt const ent)                   { comps.erase(ent); }
+
+    COMP_T const& get(ActiveEnt const ent) const       { return comps.find(ent)->second; }
+
+    float sum_dense() const
+    {
+        float sum = 0.0f;
+        for (auto const& [ent, comp] : comps)
+        {
+            sum += sample(comp);
+        }
+        return sum;
+    }
+
+    std::size_t bytes() const noexcept { return osp::heap_bytes(comps); }
+};
+
+struct Times
+{
+    double      lookup;
+    double      dense;
+    double      dirty;
+    double      churn;
+    std::size_t bytes;
+};
+
+struct Orders
+{
+    std::vector<ActiveEnt> lookup;  ///< Every entity with a component, shuffled
+    std::vector<ActiveEnt> dirty;   ///< Random subset, sorted by ID
+    std::vector<ActiveEnt> churn;   ///< Random subset, shuffled
+};
+
+template <template <typename> class CONTAINER_T, typename COMP_T>
+Times run(Orders const& orders, std::size_t const count, int const reps)
+{
+    std::vector<double> lookup;
+    std::vector<double> dense;
+    std::vector<double> dirty;
+    std::vector<double> churn;
+    std::size_t         bytes = 0;
+
+    float const expectDense = float(count);
+    float sum = 0.0f;
+
+    for (int rep = 0; rep < reps; ++rep)
+    {
+        CONTAINER_T<COMP_T> container;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            auto const ent = ActiveEnt(std::uint32_t(i * gc_entsPerComp));
+            container.add(ent, make_comp<COMP_T>());
+        }
+        bytes = container.bytes();
+
+        auto start = Clock_t::now();
+        sum = 0.0f;
+        for (ActiveEnt const ent : orders.lookup)
+        {
+            sum += sample(container.get(ent));
+        }
+        lookup.push_back(micros_since(start));
+        if (sum != expectDense)
+        {
+            std::fprintf(stderr, "%s: lookup mismatch\n", CONTAINER_T<COMP_T>::smc_name);
+        }
+
+        start = Clock_t::now();
+        sum = container.sum_dense();
+        dense.push_back(micros_since(start));
+        if (sum != expectDense)
+        {
+            std::fprintf(stderr, "%s: dense mismatch\n", CONTAINER_T<COMP_T>::smc_name);
+        }
+
+        start = Clock_t::now();
+        sum = 0.0f;
+        for (ActiveEnt const ent : orders.dirty)
+        {
+            sum += sample(container.get(ent));
+        }
+        dirty.push_back(micros_since(start));
+        if (sum != float(orders.dirty.size()))
+        {
+            std::fprintf(stderr, "%s: dirty mismatch\n", CONTAINER_T<COMP_T>::smc_name);
+        }
+
+        start = Clock_t::now();
+        for (ActiveEnt const ent : orders.churn)
+        {
+            container.remove(ent);
+        }
+        for (ActiveEnt const ent : orders.churn)
+        {
+            container.add(ent, make_comp<COMP_T>());
+        }
+        churn.push_back(micros_since(start));
+        if (container.sum_dense() != expectDense)
+        {
+            std::fprintf(stderr, "%s: churn mismatch\n", CONTAINER_T<COMP_T>::smc_name);
+        }
+    }
+
+    return {median(lookup), median(dense), median(dirty), median(churn), bytes};
+}
+
+template <template <typename> class CONTAINER_T, typename COMP_T>
+void write_row(std::FILE *const pOut, char const* compName, Orders const& orders, std::size_t const count, int const reps)
+{
+    Times const times = run<CONTAINER_T, COMP_T>(orders, count, reps);
+    std::fprintf(pOut, "%s,%s,%zu,%.2f,%.2f,%.2f,%.2f,%zu\n",
+                 CONTAINER_T<COMP_T>::smc_name, compName, count,
+                 times.lookup, times.dense, times.dirty, times.churn, times.bytes);
+}
+
+template <typename COMP_T>
+void write_rows(std::FILE *const pOut, char const* compName, Orders const& orders, std::size_t const count, int const reps)
+{
+    write_row<StorageContainer,  COMP_T>(pOut, compName, orders, count, reps);
+    write_row<KeyedVecContainer, COMP_T>(pOut, compName, orders, count, reps);
+    write_row<IdMapContainer,    COMP_T>(pOut, compName, orders, count, reps);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    char const*                 outPath     = nullptr;
+    std::vector<std::size_t>    counts      {1000, 10000, 100000, 1000000};
+    int                         reps        = 21;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (char const* value = osp::bench::option_value(argc, argv, i, "--ids"))
+        {
+            counts = osp::bench::parse_counts(value);
+        }
+        else if (char const* value = osp::bench::option_value(argc, argv, i, "--reps"))
+        {
+            reps = std::max(1, std::stoi(value));
+        }
+        else
+        {
+            outPath = argv[i];
+        }
+    }
+
+    osp::bench::CsvOutput const output{outPath};
+    std::FILE *const pOut = output.file();
+    if (pOut == nullptr)
+    {
+        return 1;
+    }
+
+    std::fprintf(pOut, "container,component,ids,usLookup,usDense,usDirty,usChurn,bytes\n");
+
+    std::mt19937 gen{42};
+
+    for (std::size_t const count : counts)
+    {
+        Orders orders;
+        orders.lookup.resize(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            orders.lookup[i] = ActiveEnt(std::uint32_t(i * gc_entsPerComp));
+        }
+        std::shuffle(orders.lookup.begin(), orders.lookup.end(), gen);
+
+        // Take the subsets from the front of the shuffled order so they're random too
+        std::size_t const dirtyCount = std::max<std::size_t>(1, count * gc_dirtyPercent / 100);
+        std::size_t const churnCount = std::max<std::size_t>(1, count * gc_churnPercent / 100);
+        orders.dirty.assign(orders.lookup.begin(), orders.lookup.begin() + std::ptrdiff_t(dirtyCount));
+        std::sort(orders.dirty.begin(), orders.dirty.end());
+        orders.churn.assign(orders.lookup.end() - std::ptrdiff_t(churnCount), orders.lookup.end());
+
+        write_rows<ACompTransform>(pOut, "transform", orders, count, reps);
+        write_rows<ACompMass>     (pOut, "mass",      orders, count, reps);
+    }
+
+    return 0;
+}
@@ -0,0 +1,114 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <osp/util/input_recording.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+using osp::input::EButtonEvent;
+using osp::input::EVarOperator;
+using osp::input::EVarTrigger;
+using osp::input::InputPlayback;
+using osp::input::InputRecorder;
+using osp::input::UserInputHandler;
+
+namespace
+{
+
+std::string temp_path(char const* name)
+{
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+} // namespace
+
+// Playing a recording back gives the same deltas, in the same frames, with the same events
+TEST(InputRecording, RoundTrip)
+{
+    std::string const path = temp_path("osp_test_input_recording.ospi");
+
+    InputRecorder recorder;
+    recorder.end_frame(0.016f);
+    recorder.button(osp::input::sc_keyboard, 42, EButtonEvent::Pressed);
+    recorder.mouse_delta({3, -4});
+    recorder.end_frame(0.017f);
+    recorder.button(osp::input::sc_keyboard, 42, EButtonEvent::Released);
+    recorder.scroll_delta({0, 1});
+    recorder.end_frame(0.018f);
+    recorder.mouse_delta({100, 100}); // Not part of a finished frame, not saved
+
+    ASSERT_EQ(recorder.frame_count(), 3);
+    ASSERT_TRUE(recorder.save(path.c_str()));
+
+    std::optional<InputPlayback> playback = InputPlayback::load(path.c_str());
+    ASSERT_TRUE(playback.has_value());
+    EXPECT_EQ(playback->frame_count(), 3);
+
+    UserInputHandler input{2};
+    input.config_register_control("test", false, {{osp::input::sc_keyboard, 42, EVarTrigger::Pressed, EVarOperator::Or, false}});
+    auto const control = input.button_subscribe("test");
+
+    EXPECT_EQ(playback->play_frame(input), 0.016f);
+    input.update_controls();
+    EXPECT_FALSE(input.button_state(control).m_triggered);
+    input.clear_events();
+
+    EXPECT_EQ(playback->play_frame(input), 0.017f);
+    input.update_controls();
+    EXPECT_TRUE(input.button_state(control).m_triggered);
+    EXPECT_EQ(input.mouse_state().m_rawDelta, osp::Vector2i(3, -4));
+    input.clear_events();
+
+    EXPECT_EQ(playback->play_frame(input), 0.018f);
+    input.update_controls();
+    EXPECT_EQ(input.scroll_state().offset, osp::Vector2i(0, 1));
+    input.clear_events();
+
+    EXPECT_EQ(playback->frames_played(), 3);
+    EXPECT_FALSE(playback->play_frame(input).has_value());
+
+    std::remove(path.c_str());
+}
+
+// Truncated recordings fail to load instead of failing partway through playback
+TEST(InputRecording, RejectTruncated)
+{
+    std::string const path = temp_path("osp_test_input_recording_truncated.ospi");
+
+    InputRecorder recorder;
+    recorder.mouse_delta({1, 1});
+    recorder.end_frame(0.016f);
+    ASSERT_TRUE(recorder.save(path.c_str()));
+
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+    EXPECT_FALSE(InputPlayback::load(path.c_str()).has_value());
+
+    std::remove(path.c_str());
+
+    EXPECT_FALSE(InputPlayback::load(path.c_str()).has_value());
+}
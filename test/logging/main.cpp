@@ -0,0 +1,104 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <osp/util/logging.h>
+
+#include <spdlog/sinks/ostream_sink.h>
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using osp::LogRateLimiter;
+
+// Messages within the interval are held back and counted
+TEST(Logging, RateLimiter)
+{
+    LogRateLimiter limiter;
+    std::uint32_t suppressed = 1234;
+
+    ASSERT_TRUE(limiter.pass(1000.0f, suppressed));
+    EXPECT_EQ(suppressed, 0u);
+
+    for (int i = 0; i < 3; ++i)
+    {
+        EXPECT_FALSE(limiter.pass(1000.0f, suppressed));
+    }
+
+    // Still within the first message's interval
+    EXPECT_FALSE(limiter.pass(0.0f, suppressed));
+
+    LogRateLimiter other;
+    EXPECT_TRUE(other.pass(0.0f, suppressed));
+    EXPECT_TRUE(other.pass(0.0f, suppressed));
+    EXPECT_EQ(suppressed, 0u);
+}
+
+// Only one of many threads logging at once gets through
+TEST(Logging, RateLimiterThreads)
+{
+    constexpr int sc_threads = 8;
+    constexpr int sc_perThread = 1000;
+
+    LogRateLimiter limiter;
+    std::atomic<int> passed{0};
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < sc_threads; ++i)
+    {
+        threads.emplace_back([&limiter, &passed]
+        {
+            std::uint32_t suppressed;
+            for (int j = 0; j < sc_perThread; ++j)
+            {
+                passed += limiter.pass(1000.0f, suppressed) ? 1 : 0;
+            }
+        });
+    }
+    for (std::thread &rThread : threads)
+    {
+        rThread.join();
+    }
+
+    EXPECT_EQ(passed, 1);
+}
+
+// The macro reports how many messages were held back
+TEST(Logging, RateLimitedMacro)
+{
+    std::ostringstream stream;
+    auto const pLogger = std::make_shared<spdlog::logger>("test", std::make_shared<spdlog::sinks::ostream_sink_st>(stream));
+    pLogger->set_pattern("%v");
+    osp::set_thread_logger(pLogger);
+
+    for (int i = 0; i < 5; ++i)
+    {
+        OSP_LOG_RATE_LIMITED(OSP_LOG_INFO, 1000.0f, "Message {}", i);
+    }
+    EXPECT_EQ(stream.str(), std::string{"Message 0"} + spdlog::details::os::default_eol);
+
+    osp::set_thread_logger(nullptr);
+}
@@ -0,0 +1,219 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <osp/core/frame_arena.h>
+#include <osp/core/keyed_vector.h>
+#include <osp/core/large_alloc.h>
+#include <osp/core/memory_tracking.h>
+#include <osp/core/memory_usage.h>
+#include <osp/tasks/top_memory.h>
+#include <osp/tasks/top_utils.h>
+
+#include <Corrade/Containers/ArrayViewStl.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+
+struct TestTag
+{
+    static constexpr std::string_view smc_name = "test_tracking";
+};
+
+struct LargeTag
+{
+    static constexpr std::string_view smc_name = "test_large";
+};
+
+enum class TestId : std::uint32_t { };
+
+struct TestData
+{
+    std::vector<float>                              values;
+    osp::KeyedVec<TestId, std::vector<int>>         nested;
+};
+
+struct Untracked
+{
+    int value;
+};
+
+} // namespace
+
+namespace osp
+{
+
+template <>
+struct MemoryUsage<TestData>
+{
+    static std::size_t heap_bytes(TestData const& data) noexcept
+    {
+        return heap_bytes_sum(data.values, data.nested);
+    }
+};
+
+} // namespace osp
+
+// Test heap_bytes of std containers and a MemoryUsage specialization
+TEST(MemoryUsage, HeapBytes)
+{
+    TestData data;
+    data.values.reserve(10);
+    data.nested.resize(2);
+    data.nested[TestId(1)].reserve(4);
+
+    EXPECT_EQ(osp::heap_bytes(data.values), data.values.capacity() * sizeof(float));
+    EXPECT_EQ(osp::heap_bytes(data),  data.values.capacity() * sizeof(float)
+                                    + data.nested.capacity() * sizeof(std::vector<int>)
+                                    + data.nested[TestId(1)].capacity() * sizeof(int));
+}
+
+// Test that top_emplace registers types with MemoryUsage, and untracked types are counted apart
+TEST(MemoryUsage, TopData)
+{
+    std::vector<entt::any> topData(4);
+    osp::top_emplace<TestData>(topData, 0).values.resize(100);
+    osp::top_emplace<Untracked>(topData, 1, Untracked{5});
+    topData[2].emplace<osp::Reserved>();
+
+    std::vector<osp::TopDataId> const ids{0, 1, 2, 3};
+    osp::TopMemory const mem = osp::top_memory_bytes(topData, ids);
+
+    TestData const &data = entt::any_cast<TestData const&>(topData[0]);
+    EXPECT_EQ(mem.bytes, sizeof(TestData) + osp::heap_bytes(data));
+    EXPECT_EQ(mem.tracked, 1u);
+    EXPECT_EQ(mem.untracked, 1u);
+
+    EXPECT_FALSE(osp::top_memory_bytes(topData[1]).has_value());
+}
+
+// Test live and peak bytes of a TrackingAllocator category
+TEST(MemoryUsage, TrackingAllocator)
+{
+    using Vec_t = std::vector<std::uint64_t, osp::TrackingAllocator<std::uint64_t, TestTag>>;
+
+    osp::MemoryCategory const &category = osp::memory_category(TestTag::smc_name);
+    std::size_t const liveBefore = category.live();
+
+    {
+        Vec_t vec;
+        vec.reserve(100);
+        EXPECT_EQ(category.live(), liveBefore + 100 * sizeof(std::uint64_t));
+
+        vec.shrink_to_fit(); // empty, frees everything
+        EXPECT_EQ(category.live(), liveBefore);
+        EXPECT_GE(category.peak(), liveBefore + 100 * sizeof(std::uint64_t));
+
+        vec.resize(10);
+    }
+    EXPECT_EQ(category.live(), liveBefore);
+
+    bool found = false;
+    for (osp::MemoryCategoryStats const& stats : osp::memory_category_stats())
+    {
+        found |= (stats.name == TestTag::smc_name);
+    }
+    EXPECT_TRUE(found);
+}
+
+// Test that FrameArena blocks are counted in its category until freed
+TEST(MemoryUsage, FrameArena)
+{
+    osp::MemoryCategory &rCategory = osp::memory_category("test_arena");
+
+    {
+        osp::FrameArena arena{0, &rCategory};
+        EXPECT_EQ(rCategory.live(), 0u);
+
+        std::ignore = arena.allocate<std::uint32_t>(8192);
+        std::ignore = arena.allocate<std::uint32_t>(8192);
+        EXPECT_EQ(rCategory.live(), arena.capacity());
+
+        // Merging blocks frees the old ones
+        arena.reset();
+        EXPECT_EQ(rCategory.live(), arena.capacity());
+        EXPECT_GE(rCategory.peak(), rCategory.live());
+
+        osp::FrameArena moved = std::move(arena);
+        EXPECT_EQ(rCategory.live(), moved.capacity());
+    }
+    EXPECT_EQ(rCategory.live(), 0u);
+}
+
+// Test that LargeAllocator maps pages above the policy threshold, and counts both kinds
+TEST(MemoryUsage, LargeAllocator)
+{
+    using Vec_t = std::vector<std::uint64_t, osp::LargeAllocator<std::uint64_t, LargeTag, 64>>;
+
+    osp::large_alloc_policy_set(LargeTag::smc_name, {
+        .hugePages  = osp::EHugePages::Transparent,
+        .numa       = osp::ENumaPlacement::Local,
+        .threshold  = 4096 });
+
+    osp::MemoryCategory const &category = osp::memory_category(LargeTag::smc_name);
+
+    {
+        Vec_t small;
+        small.reserve(16);
+        EXPECT_EQ(category.live(), 16 * sizeof(std::uint64_t));
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(small.data()) % 64, 0u);
+        EXPECT_FALSE(osp::large_unmap(small.data()));
+
+        Vec_t big(1u << 20, 7);
+        EXPECT_EQ(category.live(), (16 + (1u << 20)) * sizeof(std::uint64_t));
+        EXPECT_EQ(big[12345], 7u);
+
+#if defined(__linux__)
+        osp::MemoryCategory const &mapped = osp::memory_category("test_large.mapped");
+        EXPECT_GE(mapped.live(), (1u << 20) * sizeof(std::uint64_t));
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(big.data()) % (std::uintptr_t(2) << 20), 0u);
+#endif
+    }
+    EXPECT_EQ(category.live(), 0u);
+
+    osp::large_alloc_policy_set(LargeTag::smc_name, {});
+    EXPECT_EQ(osp::large_map(std::size_t(8) << 20, LargeTag::smc_name), nullptr);
+}
+
+// Test parsing policy names
+TEST(MemoryUsage, LargeAllocPolicyNames)
+{
+    std::optional<osp::LargeAllocPolicy> const thpLocal = osp::large_alloc_policy_from_name("thp+local");
+    ASSERT_TRUE(thpLocal.has_value());
+    EXPECT_EQ(thpLocal->hugePages, osp::EHugePages::Transparent);
+    EXPECT_EQ(thpLocal->numa, osp::ENumaPlacement::Local);
+
+    std::optional<osp::LargeAllocPolicy> const none = osp::large_alloc_policy_from_name("none");
+    ASSERT_TRUE(none.has_value());
+    EXPECT_FALSE(none->maps_pages());
+
+    EXPECT_FALSE(osp::large_alloc_policy_from_name("thp+bogus").has_value());
+}
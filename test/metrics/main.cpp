@@ -0,0 +1,124 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <osp/util/metrics.h>
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <thread>
+#include <vector>
+
+TEST(Metrics, Percentiles)
+{
+    osp::Metrics metrics;
+
+    for (int i = 100; i >= 1; --i)
+    {
+        metrics.histogram_record("h", double(i));
+    }
+
+    osp::MetricHistogram::Summary const s = metrics.histogram("h").summary();
+    EXPECT_EQ(s.count, 100);
+    EXPECT_DOUBLE_EQ(s.mean, 50.5);
+    EXPECT_DOUBLE_EQ(s.p50,  50.0);
+    EXPECT_DOUBLE_EQ(s.p99,  99.0);
+    EXPECT_DOUBLE_EQ(s.max,  100.0);
+}
+
+// Percentiles only cover the most recent samples, but count and max cover all of them
+TEST(Metrics, HistogramWindow)
+{
+    osp::Metrics metrics;
+    osp::MetricHistogram const &rHist = metrics.histogram("h");
+
+    rHist.record(1000.0);
+    for (std::size_t i = 0; i < osp::MetricHistogram::smc_window; ++i)
+    {
+        rHist.record(1.0);
+    }
+
+    osp::MetricHistogram::Summary const s = rHist.summary();
+    EXPECT_EQ(s.count, osp::MetricHistogram::smc_window + 1);
+    EXPECT_DOUBLE_EQ(s.p99, 1.0);
+    EXPECT_DOUBLE_EQ(s.max, 1000.0);
+}
+
+TEST(Metrics, ConcurrentCounters)
+{
+    osp::Metrics metrics;
+
+    constexpr int threadCount   = 4;
+    constexpr int perThread     = 10000;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < threadCount; ++i)
+    {
+        threads.emplace_back([&metrics] ()
+        {
+            for (int j = 0; j < perThread; ++j)
+            {
+                metrics.counter_add("c");
+                metrics.histogram_record("h", 1.0);
+            }
+        });
+    }
+    for (std::thread &rThread : threads)
+    {
+        rThread.join();
+    }
+
+    EXPECT_EQ(metrics.counter("c").load(), threadCount * perThread);
+    EXPECT_EQ(metrics.histogram("h").summary().count, threadCount * perThread);
+}
+
+TEST(Metrics, WriteCsv)
+{
+    osp::Metrics metrics;
+    metrics.counter_add("a", 3);
+    metrics.gauge_set("b", 2.5);
+
+    std::ostringstream stream;
+    stream << osp::MetricsWriteCsv{metrics};
+
+    EXPECT_EQ(stream.str(), "name,kind,value,count,mean,p50,p99,max\n"
+                            "a,counter,3,,,,,\n"
+                            "b,gauge,2.5,,,,,\n");
+}
+
+TEST(Metrics, WriteCsvPrefix)
+{
+    osp::Metrics metrics;
+    metrics.counter_add("mem_allocs", 1);
+    metrics.gauge_set("mem_bytes.total", 64.0);
+    metrics.gauge_set("frame_ms", 16.0);
+    metrics.histogram_record("mem_scan_ms", 1.0);
+
+    std::ostringstream stream;
+    stream << osp::MetricsWriteCsv{.metrics = metrics, .header = false, .prefix = "mem_"};
+
+    EXPECT_EQ(stream.str(), "mem_allocs,counter,1,,,,,\n"
+                            "mem_bytes.total,gauge,64,,,,,\n"
+                            "mem_scan_ms,histogram,,1,1,1,1,1\n");
+}
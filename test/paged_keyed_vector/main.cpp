@@ -0,0 +1,90 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <osp/core/paged_keyed_vector.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+namespace
+{
+
+enum class TestId : std::uint32_t { };
+
+} // namespace
+
+// Growing keeps existing values and element addresses, and fills new elements
+TEST(PagedKeyedVec, GrowKeepsAddresses)
+{
+    osp::PagedKeyedVec<TestId, int, 16> vec;
+    vec.resize(20, -1);
+
+    for (std::uint32_t i = 0; i < 20; ++i)
+    {
+        vec[TestId(i)] = int(i);
+    }
+
+    int const *pFirst = &vec[TestId(0)];
+    int const *pLast  = &vec[TestId(19)];
+
+    vec.resize(100, -1);
+
+    EXPECT_EQ(pFirst, &vec[TestId(0)]);
+    EXPECT_EQ(pLast,  &vec[TestId(19)]);
+    EXPECT_EQ(vec.page_count(), 7);
+    EXPECT_EQ(vec.page(6).size(), 4);
+
+    for (std::uint32_t i = 0; i < 100; ++i)
+    {
+        EXPECT_EQ(vec[TestId(i)], (i < 20) ? int(i) : -1);
+    }
+
+    EXPECT_THROW(vec.at(TestId(100)), std::out_of_range);
+}
+
+// Elements cut off by shrinking are reset to the new value when grown back
+TEST(PagedKeyedVec, ShrinkThenGrow)
+{
+    osp::PagedKeyedVec<TestId, int, 16> vec;
+    vec.resize(40, 7);
+    vec.resize(10);
+    EXPECT_EQ(vec.page_count(), 1);
+
+    vec.resize(40, 3);
+    EXPECT_EQ(vec[TestId(9)], 7);
+    EXPECT_EQ(vec[TestId(10)], 3);
+    EXPECT_EQ(vec[TestId(39)], 3);
+
+    int sum = 0;
+    for (int const value : vec)
+    {
+        sum += value;
+    }
+    EXPECT_EQ(sum, 10 * 7 + 30 * 3);
+
+    osp::PagedKeyedVec<TestId, int, 16> const copy{vec};
+    EXPECT_EQ(copy[TestId(9)], 7);
+    EXPECT_NE(&copy[TestId(9)], &vec[TestId(9)]);
+}
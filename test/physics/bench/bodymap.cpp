@@ -0,0 +1,228 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Micro benchmark for entity <-> body lookups, comparing the hash maps the physics integrations
+// used to use against the direct-indexed tables they use now. Writes CSV.
+//
+// Usage: osp-bench-bodymap [output.csv] [--bodies N,N,...] [--reps N]
+//
+//   --bodies N,...     Body counts (default: 1000,10000,100000)
+//   --reps N           Repetitions of each measurement, the median is written (default: 51)
+//
+// Every third entity has a body, the rest stand in for colliders and parts without one.
+// Times are in microseconds:
+//   velocity   Looking up the body of every entity with a body in random order, the way
+//              ACtxPhysics::m_setVelocity is applied in update_world
+//   remove     Removing all bodies in random order, the way remove_components does
+
+#include "../../bench_utils.h"
+
+#include <osp/activescene/active_ent.h>
+#include <osp/core/id_map.h>
+#include <osp/core/keyed_vector.h>
+
+#include <longeron/id_management/null.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+using osp::active::ActiveEnt;
+using osp::bench::Clock_t;
+using osp::bench::median;
+using osp::bench::micros_since;
+
+namespace
+{
+
+using BodyId = std::uint32_t;
+
+constexpr std::size_t gc_entsPerBody = 3;
+
+/**
+ * @brief Previous layout: hash map from entity to body
+ */
+struct HashMaps
+{
+    osp::IdMap_t<ActiveEnt, BodyId> entToBody;
+
+    void add(ActiveEnt const ent, BodyId const body)
+    {
+        entToBody.emplace(ent, body);
+    }
+
+    BodyId find(ActiveEnt const ent) const
+    {
+        auto const found = entToBody.find(ent);
+        return (found != entToBody.end()) ? found->second : lgrn::id_null<BodyId>();
+    }
+
+    void remove(ActiveEnt const ent)
+    {
+        auto const found = entToBody.find(ent);
+        if (found != entToBody.end())
+        {
+            entToBody.erase(found);
+        }
+    }
+};
+
+/**
+ * @brief Current layout: table indexed by entity, see SysJolt::set_body_ent
+ */
+struct DenseTables
+{
+    osp::KeyedVec<ActiveEnt, BodyId> entToBody;
+
+    void add(ActiveEnt const ent, BodyId const body)
+    {
+        if (std::size_t(ent) >= entToBody.size())
+        {
+            entToBody.resize(std::max(std::size_t(ent) + 1, entToBody.size() * 2), lgrn::id_null<BodyId>());
+        }
+        entToBody[ent] = body;
+    }
+
+    BodyId find(ActiveEnt const ent) const
+    {
+        return (std::size_t(ent) < entToBody.size()) ? entToBody[ent] : lgrn::id_null<BodyId>();
+    }
+
+    void remove(ActiveEnt const ent)
+    {
+        if (find(ent) != lgrn::id_null<BodyId>())
+        {
+            entToBody[ent] = lgrn::id_null<BodyId>();
+        }
+    }
+};
+
+struct Times
+{
+    double velocity;
+    double remove;
+};
+
+template <typename MAPS_T>
+Times run(std::vector<ActiveEnt> const& order, std::size_t const bodies, int const reps)
+{
+    std::vector<double> velocity;
+    std::vector<double> remove;
+    std::vector<float>  bodyVelocity(bodies, 0.0f);
+
+    for (int rep = 0; rep < reps; ++rep)
+    {
+        MAPS_T maps;
+        for (BodyId body = 0; body < bodies; ++body)
+        {
+            maps.add(ActiveEnt(body * gc_entsPerBody), body);
+        }
+
+        // Write through the found body so the lookups can't be optimized out
+        auto start = Clock_t::now();
+        for (ActiveEnt const ent : order)
+        {
+            bodyVelocity[maps.find(ent)] += 1.0f;
+        }
+        velocity.push_back(micros_since(start));
+
+        start = Clock_t::now();
+        for (ActiveEnt const ent : order)
+        {
+            maps.remove(ent);
+        }
+        remove.push_back(micros_since(start));
+
+        if (maps.find(order.front()) != lgrn::id_null<BodyId>())
+        {
+            std::fprintf(stderr, "Body not removed\n");
+        }
+    }
+
+    if (std::accumulate(bodyVelocity.begin(), bodyVelocity.end(), 0.0f) != float(bodies * std::size_t(reps)))
+    {
+        std::fprintf(stderr, "Lookup mismatch\n");
+    }
+
+    return {median(velocity), median(remove)};
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    char const*                 outPath     = nullptr;
+    std::vector<std::size_t>    counts      {1000, 10000, 100000};
+    int                         reps        = 51;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (char const* value = osp::bench::option_value(argc, argv, i, "--bodies"))
+        {
+            counts = osp::bench::parse_counts(value);
+        }
+        else if (char const* value = osp::bench::option_value(argc, argv, i, "--reps"))
+        {
+            reps = std::max(1, std::stoi(value));
+        }
+        else
+        {
+            outPath = argv[i];
+        }
+    }
+
+    osp::bench::CsvOutput const output{outPath};
+    std::FILE *const pOut = output.file();
+    if (pOut == nullptr)
+    {
+        return 1;
+    }
+
+    std::fprintf(pOut, "layout,bodies,usVelocity,usRemove\n");
+
+    std::mt19937 gen{42};
+
+    for (std::size_t const count : counts)
+    {
+        std::vector<ActiveEnt> order(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            order[i] = ActiveEnt(std::uint32_t(i * gc_entsPerBody));
+        }
+        std::shuffle(order.begin(), order.end(), gen);
+
+        Times const hash  = run<HashMaps>(order, count, reps);
+        Times const dense = run<DenseTables>(order, count, reps);
+
+        std::fprintf(pOut, "hash,%zu,%.2f,%.2f\n",  count, hash.velocity,  hash.remove);
+        std::fprintf(pOut, "dense,%zu,%.2f,%.2f\n", count, dense.velocity, dense.remove);
+    }
+
+    return 0;
+}
@@ -0,0 +1,651 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Headless physics benchmark: builds the same scenes through the Jolt and Newton integrations,
+// and writes step timings for each backend, scene, and body count as CSV.
+//
+// Usage: osp-bench-physics [output.csv] [--backend jolt|newton|both] [--scene stack|rain|vehicle|all]
+//                          [--bodies N,N,...] [--steps N] [--threads N] [--shift-every N]
+//
+//   --bodies N,...     Body counts to run each scene with (default: 100,1000,10000,50000)
+//   --steps N          Timed steps per run, after a few untimed warm-up steps (default: 300)
+//   --threads N        Physics threads for both backends (default: one less than the hardware)
+//   --shift-every N    Translate the origin every N steps to time update_translate (default: 50)
+//
+// Times are in microseconds per step:
+//   translate  update_translate, only counting steps that shift the origin
+//   world      update_world. Includes the force callbacks and each engine's own transform
+//              write-back: Jolt's active body readback, and Newton's cb_set_transform.
+//   forces     Time spent in the gravity force factor, summed over all threads
+//   sync       Reading ACompTransform of entities flagged in ACtxSceneGraph::m_transformDirty,
+//              the way draw transforms are calculated
+//
+// Scenes (bodies are 1m boxes or spheres on a static floor, gravity is -Z):
+//   stack      Columns of 10 boxes resting on each other
+//   rain       Spheres dropped from random heights
+//   vehicle    Vehicles of 200 boxes welded into one compound body each; the body count is
+//              the number of parts
+
+#include "../../bench_utils.h"
+
+#include <osp/activescene/basic.h>
+#include <osp/activescene/physics.h>
+#include <osp/scientific/shapes.h>
+
+#include <ospjolt/activescene/joltinteg.h>
+#include <ospjolt/activescene/joltinteg_fn.h>
+
+#include <ospnewton/activescene/newtoninteg.h>
+#include <ospnewton/activescene/newtoninteg_fn.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using osp::Matrix3;
+using osp::Matrix4;
+using osp::Vector3;
+using osp::EShape;
+using osp::active::ActiveEnt;
+using osp::active::ACompTransform;
+using osp::active::ACompTransformStorage_t;
+using osp::active::ACtxPhysics;
+using osp::active::ACtxSceneGraph;
+using osp::bench::Clock_t;
+using osp::bench::micros_since;
+
+namespace
+{
+
+constexpr int       gc_warmupSteps  = 10;
+constexpr int       gc_stackHeight  = 10;
+constexpr int       gc_vehicleParts = 200;
+constexpr float     gc_timestep     = 1.0f / 60.0f;
+constexpr float     gc_partMass     = 1.0f;
+
+Vector3 const gc_gravity{0.0f, 0.0f, -9.81f};
+
+enum class EScene : std::uint8_t { Stack, Rain, Vehicle };
+
+char const* scene_name(EScene const scene)
+{
+    switch (scene)
+    {
+    case EScene::Stack:     return "stack";
+    case EScene::Rain:      return "rain";
+    case EScene::Vehicle:   return "vehicle";
+    }
+    return "?";
+}
+
+/**
+ * @brief Backend-neutral description of a scene, built identically by each backend
+ */
+struct SceneDesc
+{
+    struct Body
+    {
+        EShape  shape;
+        Vector3 scale;      ///< Same as ACompTransform scale, a box of scale 1 is 2m wide
+        Vector3 position;
+    };
+
+    struct Vehicle
+    {
+        Vector3 position;
+        std::vector<Vector3> partOffsets; ///< Box parts of scale gc_partScale
+    };
+
+    static constexpr float gc_partScale = 0.25f;
+
+    Vector3                 floorScale;
+    std::vector<Body>       bodies;
+    std::vector<Vehicle>    vehicles;
+
+    std::size_t body_count() const noexcept { return 1 + bodies.size() + vehicles.size(); }
+};
+
+SceneDesc make_scene(EScene const scene, std::size_t const count)
+{
+    SceneDesc out;
+    auto const side = static_cast<std::size_t>(std::ceil(std::sqrt(double(count))));
+
+    switch (scene)
+    {
+    case EScene::Stack:
+    {
+        std::size_t const columns       = (count + gc_stackHeight - 1) / gc_stackHeight;
+        auto const        columnsSide   = static_cast<std::size_t>(std::ceil(std::sqrt(double(columns))));
+        float const       spacing       = 1.5f;
+        float const       extent        = spacing * float(columnsSide) * 0.5f;
+
+        out.floorScale = {extent + 10.0f, extent + 10.0f, 1.0f};
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            std::size_t const column = i / gc_stackHeight;
+            std::size_t const level  = i % gc_stackHeight;
+            out.bodies.push_back({
+                .shape    = EShape::Box,
+                .scale    = Vector3{0.5f},
+                .position = { spacing * float(column % columnsSide) - extent,
+                              spacing * float(column / columnsSide) - extent,
+                              0.5f + float(level) * 1.0f } });
+        }
+        break;
+    }
+    case EScene::Rain:
+    {
+        // Fixed seed, so each backend gets the same rain
+        std::mt19937 rng{1234u};
+        float const extent = float(side);
+        std::uniform_real_distribution<float> distXY{-extent, extent};
+        std::uniform_real_distribution<float> distZ{2.0f, 2.0f + 0.01f * float(count) + 20.0f};
+
+        out.floorScale = {extent + 10.0f, extent + 10.0f, 1.0f};
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            out.bodies.push_back({
+                .shape    = EShape::Sphere,
+                .scale    = Vector3{0.5f},
+                .position = {distXY(rng), distXY(rng), distZ(rng)} });
+        }
+        break;
+    }
+    case EScene::Vehicle:
+    {
+        // 20 x 10 parts, each vehicle 5m x 2.5m
+        std::size_t const vehicles      = std::max<std::size_t>(1, count / gc_vehicleParts);
+        auto const        vehiclesSide  = static_cast<std::size_t>(std::ceil(std::sqrt(double(vehicles))));
+        float const       spacing       = 8.0f;
+        float const       extent        = spacing * float(vehiclesSide) * 0.5f;
+        float const       partSize      = SceneDesc::gc_partScale * 2.0f;
+
+        out.floorScale = {extent + 10.0f, extent + 10.0f, 1.0f};
+        for (std::size_t i = 0; i < vehicles; ++i)
+        {
+            SceneDesc::Vehicle &rVehicle = out.vehicles.emplace_back();
+            rVehicle.position = { spacing * float(i % vehiclesSide) - extent,
+                                  spacing * float(i / vehiclesSide) - extent,
+                                  3.0f };
+            for (int part = 0; part < gc_vehicleParts; ++part)
+            {
+                rVehicle.partOffsets.push_back({ partSize * (float(part % 20) - 9.5f),
+                                                 partSize * (float(part / 20) - 4.5f),
+                                                 0.0f });
+            }
+        }
+        break;
+    }
+    }
+
+    return out;
+}
+
+struct StepTimes
+{
+    double      translate   {0.0};
+    double      world       {0.0};
+    double      forces      {0.0};
+    double      sync        {0.0};
+    std::size_t moved       {0};
+};
+
+/**
+ * @brief OSP-side state shared by both backends: one entity per body, numbered from 0
+ */
+struct SceneState
+{
+    ACtxPhysics                 phys;
+    ACtxSceneGraph              scnGraph;
+    ACompTransformStorage_t     transform;
+    std::vector<Matrix4>        drawTf;
+
+    /// Nanoseconds spent in the gravity force factor, added to from physics threads
+    std::atomic<std::int64_t>   forceNanos{0};
+
+    void resize(std::size_t const ents)
+    {
+        scnGraph.resize(ents);
+        drawTf.resize(ents);
+        for (std::size_t i = 0; i < ents; ++i)
+        {
+            transform.emplace(ActiveEnt(std::uint32_t(i)));
+        }
+    }
+
+    /**
+     * @brief Read moved transforms and clear their dirty flags, like draw transforms do
+     */
+    std::size_t sync()
+    {
+        std::size_t moved = 0;
+        for (std::size_t i = 0; i < drawTf.size(); ++i)
+        {
+            auto const ent = ActiveEnt(std::uint32_t(i));
+            if (scnGraph.m_transformDirty[ent] != 0)
+            {
+                drawTf[i] = transform.get(ent).m_transform;
+                scnGraph.m_transformDirty[ent] = 0;
+                ++moved;
+            }
+        }
+        return moved;
+    }
+};
+
+/**
+ * @brief Gravity, timed. m_userData is {SceneState*}.
+ */
+template <typename BATCH_T, typename WORLD_T, typename USERDATA_T>
+void timed_gravity(BATCH_T const& batch, WORLD_T const& /*world*/, USERDATA_T const userData) noexcept
+{
+    auto const start = Clock_t::now();
+    for (std::uint32_t const i : batch.m_indices)
+    {
+        batch.m_forces[i] += gc_gravity * batch.m_masses[i];
+    }
+    auto const nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock_t::now() - start).count();
+    static_cast<SceneState*>(userData[0])->forceNanos.fetch_add(nanos, std::memory_order_relaxed);
+}
+
+class JoltBench
+{
+public:
+    static constexpr char const* smc_name = "jolt";
+
+    JoltBench(SceneDesc const& scene, SceneState& rState, int const threads)
+     : m_rState{rState}
+    {
+        using namespace ospjolt;
+
+        std::size_t const bodies = scene.body_count();
+
+        JoltWorldConfig const config
+        {
+            .m_pJobSystem               = SysJolt::shared_job_system(threads),
+            .m_tempAllocatorSize        = 64 * 1024 * 1024,
+            .m_maxBodies                = uint(std::max<std::size_t>(bodies, 1024)),
+            .m_maxBodyPairs             = uint(std::max<std::size_t>(bodies * 8, 65536)),
+            .m_maxContactConstraints    = uint(std::max<std::size_t>(bodies * 8, 10240))
+        };
+        m_pWorld = std::make_unique<ACtxJoltWorld>(config);
+        ACtxJoltWorld &rJolt = *m_pWorld;
+
+        rJolt.m_factors.push_back({
+            .m_batchFunc = &timed_gravity<ForceFactorBatch, ACtxJoltWorld, ACtxJoltWorld::ForceFactorFunc::UserData_t>,
+            .m_userData  = {&m_rState} });
+        ForceFactors_t const factors{1};
+
+        BodyInterface &bodyInterface = rJolt.m_pPhysicsSystem->GetBodyInterface();
+        BodyIDVector addedBodies;
+        std::uint32_t nextEnt = 0;
+
+        auto const add_body = [&] (BodyCreationSettings const& settings)
+        {
+            BodyId const bodyId = rJolt.m_bodyIds.create();
+            SysJolt::resize_body_data(rJolt);
+
+            auto const ent = ActiveEnt(nextEnt++);
+            SysJolt::set_body_ent(rJolt, bodyId, ent);
+            rJolt.m_bodyFactors[bodyId] = factors;
+
+            bodyInterface.CreateBodyWithID(BToJolt(bodyId), settings);
+            addedBodies.push_back(BToJolt(bodyId));
+        };
+
+        add_body(BodyCreationSettings(
+                SysJolt::create_primitive(rJolt, EShape::Box, Vec3MagnumToJolt(scene.floorScale)),
+                Vec3(0.0f, 0.0f, -scene.floorScale.z()), Quat::sIdentity(),
+                EMotionType::Static, Layers::NON_MOVING));
+
+        for (SceneDesc::Body const& body : scene.bodies)
+        {
+            BodyCreationSettings settings(
+                    SysJolt::create_primitive(rJolt, body.shape, Vec3MagnumToJolt(body.scale)),
+                    Vec3MagnumToJolt(body.position), Quat::sIdentity(),
+                    EMotionType::Dynamic, Layers::MOVING);
+
+            Vector3 const inertia = collider_inertia_tensor(body.shape, body.scale, gc_partMass);
+            settings.mMassPropertiesOverride.mMass      = gc_partMass;
+            settings.mMassPropertiesOverride.mInertia   = Mat44::sScale(Vec3MagnumToJolt(inertia));
+            settings.mOverrideMassProperties            = EOverrideMassProperties::MassAndInertiaProvided;
+            add_body(settings);
+        }
+
+        Ref<Shape> const partShape = SysJolt::create_primitive(rJolt, EShape::Box, Vec3::sReplicate(SceneDesc::gc_partScale));
+        for (SceneDesc::Vehicle const& vehicle : scene.vehicles)
+        {
+            MutableCompoundShapeSettings compound;
+            for (Vector3 const& offset : vehicle.partOffsets)
+            {
+                compound.AddShape(Vec3MagnumToJolt(offset), Quat::sIdentity(), partShape);
+            }
+
+            BodyCreationSettings settings(
+                    compound.Create().Get(), Vec3MagnumToJolt(vehicle.position), Quat::sIdentity(),
+                    EMotionType::Dynamic, Layers::VEHICLE);
+            settings.mMassPropertiesOverride.mMass  = gc_partMass * float(vehicle.partOffsets.size());
+            settings.mOverrideMassProperties        = EOverrideMassProperties::CalculateInertia;
+            add_body(settings);
+        }
+
+        int const numBodies = static_cast<int>(addedBodies.size());
+        BodyInterface::AddState addState = bodyInterface.AddBodiesPrepare(addedBodies.data(), numBodies);
+        bodyInterface.AddBodiesFinalize(addedBodies.data(), numBodies, addState, EActivation::Activate);
+        rJolt.m_pPhysicsSystem->OptimizeBroadPhase();
+    }
+
+    double translate()
+    {
+        auto const start = Clock_t::now();
+        ospjolt::SysJolt::update_translate(m_rState.phys, *m_pWorld, m_rState.transform, &m_rState.scnGraph.m_transformDirty);
+        return micros_since(start);
+    }
+
+    double world()
+    {
+        auto const start = Clock_t::now();
+        ospjolt::SysJolt::update_world(m_rState.phys, *m_pWorld, gc_timestep, m_rState.transform, &m_rState.scnGraph.m_transformDirty);
+        return micros_since(start);
+    }
+
+private:
+    std::unique_ptr<ospjolt::ACtxJoltWorld> m_pWorld;
+    SceneState                              &m_rState;
+};
+
+class NewtonBench
+{
+public:
+    static constexpr char const* smc_name = "newton";
+
+    NewtonBench(SceneDesc const& scene, SceneState& rState, int const threads)
+     : m_rState{rState}
+    {
+        using namespace ospnewton;
+
+        m_pWorld = std::make_unique<ACtxNwtWorld>(threads);
+        ACtxNwtWorld &rNwt = *m_pWorld;
+        NewtonWorld *const pNwtWorld = rNwt.m_world.get();
+
+        rNwt.m_factors.push_back({
+            .m_batchFunc = &timed_gravity<ForceFactorBatch, ACtxNwtWorld, ACtxNwtWorld::ForceFactorFunc::UserData_t>,
+            .m_userData  = {&m_rState} });
+        ForceFactors_t const factors{1};
+
+        std::uint32_t nextEnt = 0;
+
+        auto const add_body = [&] (NewtonCollision const* pCollision, Vector3 const position) -> NewtonBody*
+        {
+            NewtonBody *pBody = NewtonCreateDynamicBody(pNwtWorld, pCollision, Matrix4::translation(position).data());
+
+            BodyId const bodyId = rNwt.m_bodyIds.create();
+            SysNewton::resize_body_data(rNwt);
+
+            auto const ent = ActiveEnt(nextEnt++);
+            rNwt.m_bodyPtrs[bodyId].reset(pBody);
+            SysNewton::set_body_ent(rNwt, bodyId, ent);
+            rNwt.m_bodyFactors[bodyId]  = factors;
+
+            NewtonBodySetLinearDamping(pBody, 0.0f);
+            NewtonBodySetForceAndTorqueCallback(pBody, &SysNewton::cb_force_torque);
+            NewtonBodySetTransformCallback(pBody, &SysNewton::cb_set_transform);
+            SysNewton::set_userdata_bodyid(pBody, bodyId);
+            return pBody;
+        };
+
+        // Bodies keep their own reference to collisions, these can be destroyed after
+        auto const make_collision = [&rNwt] (EShape const shape, Vector3 const offset, Vector3 const scale)
+        {
+            NwtColliderPtr_t pCollision = SysNewton::create_primative(rNwt, shape);
+            SysNewton::orient_collision(pCollision.get(), shape, offset, Matrix3{}, scale);
+            return pCollision;
+        };
+
+        // Zero mass makes Newton bodies static
+        NwtColliderPtr_t const pFloor = make_collision(EShape::Box, {}, scene.floorScale);
+        NewtonBodySetMassMatrix(add_body(pFloor.get(), {0.0f, 0.0f, -scene.floorScale.z()}), 0.0f, 1.0f, 1.0f, 1.0f);
+
+        for (SceneDesc::Body const& body : scene.bodies)
+        {
+            NwtColliderPtr_t const pCollision = make_collision(body.shape, {}, body.scale);
+            Vector3 const inertia = collider_inertia_tensor(body.shape, body.scale, gc_partMass);
+            NewtonBodySetMassMatrix(add_body(pCollision.get(), body.position),
+                                    gc_partMass, inertia.x(), inertia.y(), inertia.z());
+        }
+
+        for (SceneDesc::Vehicle const& vehicle : scene.vehicles)
+        {
+            NwtColliderPtr_t const pCompound{ NewtonCreateCompoundCollision(pNwtWorld, 0) };
+
+            // Sub-collisions are copied into the compound
+            NewtonCompoundCollisionBeginAddRemove(pCompound.get());
+            for (Vector3 const& offset : vehicle.partOffsets)
+            {
+                NwtColliderPtr_t const pPart = make_collision(EShape::Box, offset, Vector3{SceneDesc::gc_partScale});
+                NewtonCompoundCollisionAddSubCollision(pCompound.get(), pPart.get());
+            }
+            NewtonCompoundCollisionEndAddRemove(pCompound.get());
+
+            NewtonBody *const pBody = add_body(pCompound.get(), vehicle.position);
+            NewtonBodySetMassProperties(pBody, gc_partMass * float(vehicle.partOffsets.size()), pCompound.get());
+            NewtonBodySetGyroscopicTorque(pBody, 1);
+        }
+    }
+
+    double translate()
+    {
+        auto const start = Clock_t::now();
+        ospnewton::SysNewton::update_translate(m_rState.phys, *m_pWorld);
+        return micros_since(start);
+    }
+
+    double world()
+    {
+        auto const start = Clock_t::now();
+        ospnewton::SysNewton::update_world(m_rState.phys, *m_pWorld, gc_timestep, m_rState.scnGraph, m_rState.transform, &m_rState.scnGraph.m_transformDirty);
+        return micros_since(start);
+    }
+
+private:
+    std::unique_ptr<ospnewton::ACtxNwtWorld> m_pWorld;
+    SceneState                               &m_rState;
+};
+
+struct RunOptions
+{
+    int steps       {300};
+    int threads     {-1};
+    int shiftEvery  {50};
+};
+
+double mean(std::vector<double> const& values)
+{
+    if (values.empty())
+    {
+        return 0.0;
+    }
+    double sum = 0.0;
+    for (double const value : values)
+    {
+        sum += value;
+    }
+    return sum / double(values.size());
+}
+
+double percentile(std::vector<double> values, double const fraction)
+{
+    if (values.empty())
+    {
+        return 0.0;
+    }
+    auto const nth = values.begin() + std::ptrdiff_t(fraction * double(values.size() - 1));
+    std::nth_element(values.begin(), nth, values.end());
+    return *nth;
+}
+
+template <typename BENCH_T>
+void run(std::FILE *const pOut, EScene const scene, std::size_t const count, RunOptions const& options)
+{
+    SceneDesc const desc = make_scene(scene, count);
+
+    SceneState state;
+    state.resize(desc.body_count());
+
+    auto const buildStart = Clock_t::now();
+    BENCH_T bench{desc, state, options.threads};
+    double const build = micros_since(buildStart);
+
+    std::vector<double> translate;
+    std::vector<double> world;
+    std::vector<double> forces;
+    std::vector<double> sync;
+    std::size_t         moved = 0;
+
+    float shift = 1.0f;
+    for (int step = -gc_warmupSteps; step < options.steps; ++step)
+    {
+        bool const timed = step >= 0;
+
+        if (options.shiftEvery > 0 && step % options.shiftEvery == 0)
+        {
+            // Alternate directions so the scene stays around the origin
+            state.phys.m_originTranslate = {shift, 0.0f, 0.0f};
+            shift = -shift;
+            double const micros = bench.translate();
+            if (timed)
+            {
+                translate.push_back(micros);
+            }
+        }
+
+        state.forceNanos.store(0, std::memory_order_relaxed);
+        state.phys.m_contacts.clear();
+        double const worldMicros = bench.world();
+
+        auto const syncStart = Clock_t::now();
+        std::size_t const stepMoved = state.sync();
+        double const syncMicros = micros_since(syncStart);
+
+        if (timed)
+        {
+            world .push_back(worldMicros);
+            forces.push_back(double(state.forceNanos.load(std::memory_order_relaxed)) / 1000.0);
+            sync  .push_back(syncMicros);
+            moved += stepMoved;
+        }
+    }
+
+    std::fprintf(pOut, "%s,%s,%zu,%zu,%d,%.1f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.1f\n",
+                 BENCH_T::smc_name, scene_name(scene), count, desc.body_count(), options.steps, build,
+                 mean(translate), mean(world), percentile(world, 0.5), percentile(world, 0.95),
+                 mean(forces), mean(sync), double(moved) / double(std::max(options.steps, 1)));
+    std::fflush(pOut);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    char const*                 outPath     = nullptr;
+    bool                        jolt        = true;
+    bool                        newton      = true;
+    std::vector<EScene>         scenes      {EScene::Stack, EScene::Rain, EScene::Vehicle};
+    std::vector<std::size_t>    counts      {100, 1000, 10000, 50000};
+    RunOptions                  options;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (char const* const backend = osp::bench::option_value(argc, argv, i, "--backend"))
+        {
+            jolt   = std::strcmp(backend, "newton") != 0;
+            newton = std::strcmp(backend, "jolt")   != 0;
+        }
+        else if (char const* const scene = osp::bench::option_value(argc, argv, i, "--scene"))
+        {
+            if      (std::strcmp(scene, "stack")   == 0) { scenes = {EScene::Stack}; }
+            else if (std::strcmp(scene, "rain")    == 0) { scenes = {EScene::Rain}; }
+            else if (std::strcmp(scene, "vehicle") == 0) { scenes = {EScene::Vehicle}; }
+        }
+        else if (char const* const value = osp::bench::option_value(argc, argv, i, "--bodies"))
+        {
+            counts = osp::bench::parse_counts(value);
+        }
+        else if (char const* const value = osp::bench::option_value(argc, argv, i, "--steps"))
+        {
+            options.steps = std::max(1, std::stoi(value));
+        }
+        else if (char const* const value = osp::bench::option_value(argc, argv, i, "--threads"))
+        {
+            options.threads = std::stoi(value);
+        }
+        else if (char const* const value = osp::bench::option_value(argc, argv, i, "--shift-every"))
+        {
+            options.shiftEvery = std::max(0, std::stoi(value));
+        }
+        else
+        {
+            outPath = argv[i];
+        }
+    }
+
+    osp::bench::CsvOutput const output{outPath};
+    std::FILE *const pOut = output.file();
+    if (pOut == nullptr)
+    {
+        return 1;
+    }
+
+    ospjolt::ACtxJoltWorld::initJoltGlobal();
+
+    std::fprintf(pOut, "backend,scene,requested,bodies,steps,usBuild,"
+                       "usTranslate,usWorld,usWorldP50,usWorldP95,usForces,usSync,moved\n");
+
+    for (EScene const scene : scenes)
+    {
+        for (std::size_t const count : counts)
+        {
+            if (jolt)
+            {
+                run<JoltBench>(pOut, scene, count, options);
+            }
+            if (newton)
+            {
+                run<NewtonBench>(pOut, scene, count, options);
+            }
+        }
+    }
+
+    return 0;
+}
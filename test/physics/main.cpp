@@ -0,0 +1,133 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <ospjolt/activescene/joltinteg.h>
+#include <ospjolt/activescene/joltinteg_fn.h>
+
+#include <Corrade/Containers/ArrayViewStl.h>
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using osp::Vector3;
+using osp::active::ActiveEnt;
+
+using namespace ospjolt;
+
+namespace
+{
+
+void factor_gravity(BodyId, ACtxJoltWorld const&, ACtxJoltWorld::ForceFactorFunc::UserData_t, Vector3&, Vector3&) noexcept { }
+void factor_thrust (BodyId, ACtxJoltWorld const&, ACtxJoltWorld::ForceFactorFunc::UserData_t, Vector3&, Vector3&) noexcept { }
+void factor_aero   (BodyId, ACtxJoltWorld const&, ACtxJoltWorld::ForceFactorFunc::UserData_t, Vector3&, Vector3&) noexcept { }
+
+JoltWorldConfig small_world_config()
+{
+    return {
+        .m_pJobSystem               = SysJolt::shared_job_system(1),
+        .m_tempAllocatorSize        = 1024 * 1024,
+        .m_maxBodies                = 64,
+        .m_maxBodyPairs             = 256,
+        .m_maxContactConstraints    = 256 };
+}
+
+} // namespace
+
+// Factors are matched by function, not by index, and factors the destination lacks are dropped
+TEST(Jolt, RemapFactors)
+{
+    int gravityA = 0;
+    int gravityB = 0;
+
+    std::vector<ACtxJoltWorld::ForceFactorFunc> const from{
+        { .m_func = &factor_gravity, .m_userData = {&gravityA} },
+        { .m_func = &factor_thrust },
+        { .m_func = &factor_aero } };
+
+    std::vector<ACtxJoltWorld::ForceFactorFunc> const to{
+        { .m_func = &factor_thrust },
+        { .m_func = &factor_gravity, .m_userData = {&gravityB} },
+        { .m_func = &factor_gravity, .m_userData = {&gravityA} } };
+
+    // Gravity with the same user data is preferred over the other world's gravity
+    EXPECT_EQ(SysJolt::remap_factors({0b011}, from, to), ForceFactors_t{0b101});
+
+    // No aero in the destination
+    EXPECT_EQ(SysJolt::remap_factors({0b100}, from, to), ForceFactors_t{0});
+
+    // Falls back to the destination's own gravity
+    std::vector<ACtxJoltWorld::ForceFactorFunc> const toOther{
+        { .m_func = &factor_gravity, .m_userData = {&gravityB} } };
+    EXPECT_EQ(SysJolt::remap_factors({0b001}, from, toOther), ForceFactors_t{0b1});
+}
+
+// Move a body between two worlds with different origins and factor layouts
+TEST(Jolt, TransferBody)
+{
+    ACtxJoltWorld::initJoltGlobal();
+
+    ACtxJoltWorld worldA{small_world_config()};
+    ACtxJoltWorld worldB{small_world_config()};
+
+    worldA.m_factors = { {.m_func = &factor_gravity}, {.m_func = &factor_thrust} };
+    worldB.m_factors = { {.m_func = &factor_aero},    {.m_func = &factor_thrust}, {.m_func = &factor_gravity} };
+
+    auto const entA = ActiveEnt(3);
+    auto const entB = ActiveEnt(5);
+
+    BodyId const bodyA = worldA.m_bodyIds.create();
+    SysJolt::resize_body_data(worldA);
+    SysJolt::set_body_ent(worldA, bodyA, entA);
+    worldA.m_bodyFactors[bodyA] = {0b11};
+
+    BodyCreationSettings settings(
+            SysJolt::create_primitive(worldA, osp::EShape::Sphere, Vec3::sReplicate(1.0f)),
+            Vec3(1.0f, 2.0f, 3.0f), Quat::sIdentity(), EMotionType::Dynamic, Layers::MOVING);
+    settings.mLinearVelocity = Vec3(0.0f, 0.0f, 5.0f);
+
+    BodyInterface &rBodiesA = worldA.m_pPhysicsSystem->GetBodyInterface();
+    rBodiesA.CreateBodyWithID(BToJolt(bodyA), settings);
+    rBodiesA.AddBody(BToJolt(bodyA), EActivation::Activate);
+
+    std::vector<ActiveEnt> entRemap(8, lgrn::id_null<ActiveEnt>());
+    entRemap[std::size_t(entA)] = entB;
+
+    BodyId const bodyB = SysJolt::transfer_body(worldA, worldB, entA, entRemap, Vector3{10.0f, 0.0f, 0.0f});
+    ASSERT_NE(bodyB, lgrn::id_null<BodyId>());
+
+    EXPECT_EQ(SysJolt::find_body(worldA, entA), lgrn::id_null<BodyId>());
+    EXPECT_EQ(worldA.m_bodyIds.size(), 0u);
+    EXPECT_FALSE(rBodiesA.IsAdded(BToJolt(bodyA)));
+
+    EXPECT_EQ(SysJolt::find_body(worldB, entB), bodyB);
+    EXPECT_EQ(SysJolt::find_ent (worldB, bodyB), entB);
+    EXPECT_EQ(worldB.m_bodyFactors[bodyB], ForceFactors_t{0b110});
+
+    BodyInterface &rBodiesB = worldB.m_pPhysicsSystem->GetBodyInterface();
+    ASSERT_TRUE(rBodiesB.IsAdded(BToJolt(bodyB)));
+    EXPECT_EQ(Vec3JoltToMagnum(rBodiesB.GetPosition(BToJolt(bodyB))),       Vector3(11.0f, 2.0f, 3.0f));
+    EXPECT_EQ(Vec3JoltToMagnum(rBodiesB.GetLinearVelocity(BToJolt(bodyB))), Vector3(0.0f, 0.0f, 5.0f));
+    EXPECT_EQ(rBodiesB.GetMotionType(BToJolt(bodyB)), EMotionType::Dynamic);
+}
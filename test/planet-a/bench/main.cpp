@@ -0,0 +1,446 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Headless terrain benchmark: flies a scripted camera path over an icosahedron planet, and
+// writes per-frame subdivision counts and phase timings as CSV.
+//
+// Usage: osp-bench-terrain [output.csv] [--threads N] [--budget N] [--reorder N] [--check]
+//
+//   --threads N   Threads for distance tests and per-chunk work, including a TopWorkerPool's
+//                 workers and the main thread (default: all)
+//   --budget N    Max distance-triggered subdivisions per frame (default: unlimited)
+//   --reorder N   Call SubdivTriangleSkeleton::tri_group_reorder every N frames (default: never)
+//   --check       Run debug_check_invariants on the skeleton and chunk mesh every frame
+//
+// The update steps mirror the terrain session in testapp (sessions/terrain.cpp), minus
+// caching and rendering, so numbers are comparable between builds.
+
+#include "../../bench_utils.h"
+
+#include <planet-a/chunk_generate.h>
+#include <planet-a/chunk_utils.h>
+#include <planet-a/geometry.h>
+#include <planet-a/icosahedron.h>
+#include <planet-a/skeleton.h>
+#include <planet-a/skeleton_subdiv.h>
+
+#include <osp/tasks/top_worker_pool.h>
+
+#include <Corrade/Containers/ArrayViewStl.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+
+using namespace planeta;
+using osp::Vector3;
+using osp::Vector3d;
+using osp::Vector3l;
+using osp::Vector3u;
+using osp::ZeroInit;
+using osp::bench::Clock_t;
+using osp::bench::micros_since;
+
+namespace
+{
+
+// Same planet as the testapp 'terrain' scenario
+constexpr double        gc_radius           = 50.0;
+constexpr double        gc_height           = 5.0;
+constexpr int           gc_precision        = 10;
+constexpr std::uint8_t  gc_skelLevels       = 7;
+constexpr std::uint8_t  gc_chunkLevels      = 4;
+
+constexpr int           gc_framesApproach   = 200;
+constexpr int           gc_framesFlyover    = 400;
+constexpr int           gc_framesLeave      = 200;
+
+struct Planet
+{
+    SubdivTriangleSkeleton      skeleton;
+    SkeletonVertexData          skData;
+    SkeletonSubdivScratchpad    skSP;
+    ChunkSkeleton               skChunks;
+    ChunkMeshBufferInfo         chunkInfo{};
+    BasicChunkMeshGeometry      chunkGeom;
+    ChunkScratchpad             chunkSP;
+
+    std::array<SkVrtxId,     12> icoVrtx;
+    std::array<SkTriGroupId, 5>  icoGroups;
+    std::array<SkTriId,      20> icoTri;
+};
+
+struct FrameStats
+{
+    std::size_t subdivs         {0};
+    std::size_t unsubdivs       {0};
+    std::size_t distanceChecks  {0};
+    std::size_t chunksAdded     {0};
+    std::size_t chunksRemoved   {0};
+    std::size_t chunks          {0};
+
+    // Microseconds
+    double      unsubdiv        {0.0};
+    double      subdiv          {0.0};
+    double      chunkEdit       {0.0};
+    double      fill            {0.0};
+    double      faces           {0.0};
+    double      normals         {0.0};
+};
+
+void initialize(Planet &rPlanet)
+{
+    double const scale     = std::pow(2.0, gc_precision);
+    double const maxRadius = gc_radius + gc_height;
+
+    rPlanet.skData.precision = gc_precision;
+    rPlanet.skeleton = create_skeleton_icosahedron(gc_radius, rPlanet.icoVrtx, rPlanet.icoGroups, rPlanet.icoTri, rPlanet.skData);
+    rPlanet.skeleton.levelMax = gc_skelLevels;
+
+    double const minThreshold = 0.75 * gc_icoMaxEdgeVsLevel[gc_skelLevels-1] * gc_radius * scale;
+    rPlanet.skData.compactShift = compact_shift_for(std::uint64_t(2.0 * maxRadius * scale), std::uint64_t(minThreshold));
+    rPlanet.skData.resize(rPlanet.skeleton);
+
+    for (SkTriGroupId const groupId : rPlanet.icoGroups)
+    {
+        ico_calc_sphere_tri_center(groupId, maxRadius, gc_height, rPlanet.skeleton, rPlanet.skData);
+    }
+
+    SkeletonSubdivScratchpad &rSP = rPlanet.skSP;
+    rSP.resize(rPlanet.skeleton);
+    for (SkTriId const sktriId : rPlanet.icoTri)
+    {
+        rSP.surfaceAdded.insert(sktriId);
+    }
+
+    rSP.onSubdiv = [] (SkTriId, SkTriGroupId groupId, std::array<SkVrtxId, 3> corners,
+                       std::array<osp::MaybeNewId<SkVrtxId>, 3> middles, SubdivTriangleSkeleton &rSkel,
+                       SkeletonVertexData &rSkData, SkeletonSubdivScratchpad::UserData_t) noexcept
+    {
+        ico_calc_middles(gc_radius, corners, middles, rSkData);
+        ico_calc_sphere_tri_center(groupId, gc_radius + gc_height, gc_height, rSkel, rSkData);
+    };
+    rSP.onUnsubdiv = [] (SkTriId, SkeletonTriangle&, SubdivTriangleSkeleton&, SkeletonVertexData&,
+                         SkeletonSubdivScratchpad::UserData_t) noexcept { };
+
+    for (int level = 0; level < gc_skelLevels; ++level)
+    {
+        float const subdivRadius = 0.75f * gc_icoMaxEdgeVsLevel[level] * gc_radius * scale;
+        rSP.distanceThresholdSubdiv[level]   = std::uint64_t(subdivRadius);
+        rSP.distanceThresholdUnsubdiv[level] = std::uint64_t(2.0f * subdivRadius);
+    }
+
+    rPlanet.skChunks = make_skeleton_chunks(gc_chunkLevels);
+    std::uint32_t const maxChunksApprox = 42 * gc_skelLevels + 30;
+    rPlanet.skChunks.chunk_reserve(std::uint16_t(maxChunksApprox));
+    rPlanet.skChunks.shared_reserve(std::uint32_t(0.6f * maxChunksApprox * rPlanet.skChunks.m_chunkSharedCount));
+
+    rPlanet.chunkInfo = make_chunk_mesh_buffer_info(rPlanet.skChunks);
+    rPlanet.chunkGeom.resize(rPlanet.skChunks, rPlanet.chunkInfo);
+
+    rPlanet.chunkSP.lut = std::make_shared<ChunkFillSubdivLUT const>(make_chunk_vrtx_subdiv_lut(gc_chunkLevels));
+    rPlanet.chunkSP.resize(rPlanet.skChunks);
+}
+
+void update_skeleton(Planet &rPlanet, Vector3l const pos, std::uint32_t const budget, osp::ParallelFor const& parallelFor, FrameStats &rStats)
+{
+    SubdivTriangleSkeleton   &rSkel   = rPlanet.skeleton;
+    SkeletonVertexData       &rSkData = rPlanet.skData;
+    SkeletonSubdivScratchpad &rSP     = rPlanet.skSP;
+
+    rSP.distanceCheckCount = 0;
+    std::size_t const groupsBefore = rSkel.tri_group_ids().size();
+
+    auto start = Clock_t::now();
+    for (int level = rSkel.levelMax-1; level >= 0; --level)
+    {
+        unsubdivide_select_by_distance(level, pos, rSkel, rSkData, rSP, parallelFor);
+        unsubdivide_deselect_invariant_violations(level, rSkel, rSkData, rSP);
+        unsubdivide_level(level, rSkel, rSkData, rSP);
+    }
+    rSP.distanceTestDone.clear();
+    rStats.unsubdiv = micros_since(start);
+
+    std::size_t const groupsMid = rSkel.tri_group_ids().size();
+
+    start = Clock_t::now();
+    for (SkTriId const sktriId : rPlanet.icoTri)
+    {
+        rSP.levels[0].distanceTestNext.push_back(sktriId);
+        rSP.distanceTestDone.insert(sktriId);
+    }
+    rSP.levelNeedProcess = 0;
+    rSP.subdivBudgetLeft = budget;
+    rSP.subdivDeferred   = 0;
+    for (int level = 0; level < rSkel.levelMax; ++level)
+    {
+        subdivide_level_by_distance(pos, level, rSkel, rSkData, rSP, parallelFor);
+    }
+    rSP.distanceTestDone.clear();
+    rStats.subdiv = micros_since(start);
+
+    rStats.unsubdivs      = groupsBefore - groupsMid;
+    rStats.subdivs        = rSkel.tri_group_ids().size() - groupsMid;
+    rStats.distanceChecks = rSP.distanceCheckCount;
+}
+
+void update_chunks(Planet &rPlanet, osp::ParallelFor const& parallelFor, FrameStats &rStats)
+{
+    SubdivTriangleSkeleton   &rSkel   = rPlanet.skeleton;
+    SkeletonVertexData       &rSkData = rPlanet.skData;
+    SkeletonSubdivScratchpad &rSkSP   = rPlanet.skSP;
+    ChunkSkeleton            &rSkCh   = rPlanet.skChunks;
+    ChunkMeshBufferInfo      &rChInfo = rPlanet.chunkInfo;
+    BasicChunkMeshGeometry   &rChGeo  = rPlanet.chunkGeom;
+    ChunkScratchpad          &rChSP   = rPlanet.chunkSP;
+
+    rChSP.chunksAdded       .clear();
+    rChSP.sharedNormalsDirty.clear();
+    rChSP.sharedAdded       .clear();
+    rChSP.sharedRemoved     .clear();
+    rChSP.chunksDirty       .clear();
+
+    auto start = Clock_t::now();
+
+    for (SkTriId const sktriId : rSkSP.surfaceRemoved)
+    {
+        ChunkId const chunkId = rSkCh.m_triToChunk[sktriId];
+        subtract_normal_contrib(chunkId, false, rChGeo, rChInfo, rChSP, rSkCh);
+        rSkCh.chunk_remove(chunkId, sktriId, rChSP.sharedRemoved, rSkel);
+        ++rStats.chunksRemoved;
+    }
+
+    auto const chLevel  = rSkCh.m_chunkSubdivLevel;
+    auto const edgeSize = rSkCh.m_chunkEdgeVrtxCount-1;
+
+    rSkCh.m_triToChunk.resize(rSkel.tri_group_ids().capacity() * 4);
+    for (SkTriId const sktriId : rSkSP.surfaceAdded)
+    {
+        auto const &corners = rSkel.tri_at(sktriId).vertices;
+
+        osp::ArrayView< osp::MaybeNewId<SkVrtxId> > const edgeVrtxView = rChSP.edgeVertices;
+        auto const edgeLft = edgeVrtxView.sliceSize(edgeSize * 0, edgeSize);
+        auto const edgeBtm = edgeVrtxView.sliceSize(edgeSize * 1, edgeSize);
+        auto const edgeRte = edgeVrtxView.sliceSize(edgeSize * 2, edgeSize);
+
+        rSkel.vrtx_create_chunk_edge_recurse(chLevel, corners[0], corners[1], edgeLft);
+        rSkel.vrtx_create_chunk_edge_recurse(chLevel, corners[1], corners[2], edgeBtm);
+        rSkel.vrtx_create_chunk_edge_recurse(chLevel, corners[2], corners[0], edgeRte);
+
+        ChunkId const chunkId = rSkCh.chunk_create(sktriId, rSkel, rChSP.sharedAdded, edgeLft, edgeBtm, edgeRte);
+        rChSP.chunksAdded.push_back(chunkId);
+
+        rSkData.resize(rSkel);
+        rSkSP.resize(rSkel);
+
+        ico_calc_chunk_edge(gc_radius, chLevel, corners[0], corners[1], edgeLft, rSkData);
+        ico_calc_chunk_edge(gc_radius, chLevel, corners[1], corners[2], edgeBtm, rSkData);
+        ico_calc_chunk_edge(gc_radius, chLevel, corners[2], corners[0], edgeRte, rSkData);
+    }
+
+    for (SkTriId const sktriId : rSkSP.surfaceAdded)
+    {
+        restitch_check(rSkCh.m_triToChunk[sktriId], sktriId, rSkCh, rSkel, rSkData, rChSP);
+    }
+
+    float const scalepow = std::pow(2.0f, -rSkData.precision);
+    for (SharedVrtxId const sharedVrtxId : rChSP.sharedAdded)
+    {
+        SkVrtxId const skelVrtx = rSkCh.m_sharedToSkVrtx[sharedVrtxId];
+        rChGeo.sharedNormalSum[sharedVrtxId] = Vector3{ZeroInit};
+        rChGeo.chunkVbufPos[rChInfo.vbufSharedOffset + sharedVrtxId.value] = Vector3(Vector3d(rSkData.positions[skelVrtx]) * scalepow);
+    }
+    rStats.chunkEdit   = micros_since(start);
+    rStats.chunksAdded = rChSP.chunksAdded.size();
+
+    start = Clock_t::now();
+    ChunkFillScratch scratch;
+    for (ChunkId const chunkId : rChSP.chunksAdded)
+    {
+        std::uint32_t const fillOffset = rChInfo.vbufFillOffset + std::uint32_t(chunkId.value) * rChInfo.fillVrtxCount;
+        ico_calc_chunk_fill(gc_radius, *rChSP.lut, rSkCh.shared_vertices_used(chunkId), fillOffset,
+                            rChInfo.vbufSharedOffset, osp::arrayView(rChGeo.chunkVbufPos), scratch);
+    }
+    rStats.fill = micros_since(start);
+
+    start = Clock_t::now();
+    for (ChunkId const chunkId : rSkCh.m_chunkIds)
+    {
+        SkTriId const sktriId = rSkCh.m_chunkToTri[chunkId];
+        update_faces(chunkId, sktriId, rSkSP.surfaceAdded.contains(sktriId), rSkel, rSkData, rChGeo, rChInfo, rChSP, rSkCh);
+    }
+    std::fill(rChSP.stitchCmds.begin(), rChSP.stitchCmds.end(), ChunkStitch{});
+    rStats.faces = micros_since(start);
+
+    start = Clock_t::now();
+    finalize_normals(rChGeo, rChInfo, rChSP, parallelFor);
+    rStats.normals = micros_since(start);
+
+    rStats.chunks = rSkCh.m_chunkIds.size();
+
+    rSkSP.surfaceAdded  .clear();
+    rSkSP.surfaceRemoved.clear();
+}
+
+void reorder(Planet &rPlanet)
+{
+    SkTriGroupRemap const remap = rPlanet.skeleton.tri_group_reorder();
+    if ( ! remap.changed )
+    {
+        return;
+    }
+
+    rPlanet.skData  .remap_tris(remap);
+    rPlanet.skSP    .remap_tris(remap);
+    rPlanet.skChunks.remap_tris(remap);
+
+    for (SkTriGroupId &rGroupId : rPlanet.icoGroups)
+    {
+        rGroupId = remap(rGroupId);
+    }
+    for (SkTriId &rTriId : rPlanet.icoTri)
+    {
+        rTriId = remap(rTriId);
+    }
+}
+
+/**
+ * @brief Camera position in meters for a frame: approach from orbit, low flyover, then leave
+ */
+Vector3d camera_path(int const frame)
+{
+    double const orbit = 4.0 * gc_radius;
+    double const low   = gc_radius + 2.0 * gc_height;
+
+    if (frame < gc_framesApproach)
+    {
+        double const t = double(frame) / gc_framesApproach;
+        return {0.0, 0.0, orbit + (low - orbit) * t};
+    }
+
+    if (frame < gc_framesApproach + gc_framesFlyover)
+    {
+        // Half an orbit around the planet at low altitude
+        double const angle = 3.14159265358979 * double(frame - gc_framesApproach) / gc_framesFlyover;
+        return {low * std::sin(angle), 0.0, low * std::cos(angle)};
+    }
+
+    double const t = double(frame - gc_framesApproach - gc_framesFlyover) / gc_framesLeave;
+    return {0.0, 0.0, -(low + (orbit - low) * t)};
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    char const*     outPath       = nullptr;
+    unsigned int    threads       = std::max(1u, std::thread::hardware_concurrency());
+    std::uint32_t   budget        = SkeletonSubdivScratchpad::smc_unlimited;
+    int             reorderPeriod = 0;
+    bool            check         = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--check") == 0)
+        {
+            check = true;
+        }
+        else if (char const* const value = osp::bench::option_value(argc, argv, i, "--threads"))
+        {
+            threads = std::max(1, std::stoi(value));
+        }
+        else if (char const* const value = osp::bench::option_value(argc, argv, i, "--budget"))
+        {
+            budget = std::uint32_t(std::stoul(value));
+        }
+        else if (char const* const value = osp::bench::option_value(argc, argv, i, "--reorder"))
+        {
+            reorderPeriod = std::max(0, std::stoi(value));
+        }
+        else
+        {
+            outPath = argv[i];
+        }
+    }
+
+    osp::bench::CsvOutput const output{outPath};
+    std::FILE *const pOut = output.file();
+    if (pOut == nullptr)
+    {
+        return 1;
+    }
+
+    // Workers help the main thread with ranges, the same way they help tasks in testapp
+    std::optional<osp::TopWorkerPool> pool;
+    osp::ParallelFor parallelFor;
+    if (threads > 1)
+    {
+        pool.emplace(threads - 1);
+        parallelFor = pool->parallel_for();
+    }
+
+    Planet planet;
+    initialize(planet);
+
+    std::fprintf(pOut, "frame,altitude,subdivs,unsubdivs,distanceChecks,chunksAdded,chunksRemoved,chunks,"
+                       "usUnsubdiv,usSubdiv,usChunkEdit,usFill,usFaces,usNormals\n");
+
+    double const scale = std::pow(2.0, gc_precision);
+    int const frames = gc_framesApproach + gc_framesFlyover + gc_framesLeave;
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        Vector3d const camPos = camera_path(frame);
+
+        FrameStats stats;
+        update_skeleton(planet, Vector3l(camPos * scale), budget, parallelFor, stats);
+        update_chunks(planet, parallelFor, stats);
+
+        if (reorderPeriod != 0 && (frame + 1) % reorderPeriod == 0)
+        {
+            reorder(planet);
+        }
+
+        if (check)
+        {
+            planet.skeleton.debug_check_invariants();
+            debug_check_invariants(planet.chunkGeom, planet.chunkInfo, planet.skChunks);
+        }
+
+        std::fprintf(pOut, "%d,%.3f,%zu,%zu,%zu,%zu,%zu,%zu,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f\n",
+                     frame, camPos.length() - gc_radius,
+                     stats.subdivs, stats.unsubdivs, stats.distanceChecks,
+                     stats.chunksAdded, stats.chunksRemoved, stats.chunks,
+                     stats.unsubdiv, stats.subdiv, stats.chunkEdit, stats.fill, stats.faces, stats.normals);
+    }
+
+    return 0;
+}
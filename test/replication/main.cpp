@@ -0,0 +1,276 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <osp/net/replication.h>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+using osp::Matrix4;
+using osp::Vector3;
+using osp::net::EReplDecode;
+using osp::net::ReplClient;
+using osp::net::ReplConfig;
+using osp::net::ReplObjId;
+using osp::net::ReplReceiver;
+using osp::net::ReplSnapshot;
+
+namespace
+{
+
+struct TestObject
+{
+    Vector3                 position;
+    Vector3                 velocity;
+    std::uint32_t           structureRev{1};
+    std::vector<std::byte>  structure;
+    std::vector<float>      signals;
+};
+
+ReplSnapshot make_snapshot(osp::net::ReplFrame const frame, std::vector<TestObject> const& objects)
+{
+    ReplSnapshot out;
+    out.frame = frame;
+    for (std::uint32_t i = 0; i < objects.size(); ++i)
+    {
+        TestObject const &obj = objects[i];
+        osp::net::repl_snapshot_add(out, ReplObjId(i), Matrix4::translation(obj.position),
+                                    obj.velocity, {}, obj.structureRev, obj.structure, obj.signals);
+    }
+    return out;
+}
+
+/// Send current to a client and decode it, optionally acknowledging it
+std::size_t send(ReplClient &rClient, ReplReceiver &rReceiver, ReplSnapshot const& current, ReplConfig const& config, bool const ack = true)
+{
+    std::vector<std::byte> packet;
+    osp::net::repl_encode(rClient, current, config, packet);
+    EXPECT_LE(packet.size(), config.packetBudget);
+    EXPECT_EQ(osp::net::repl_decode(rReceiver, packet), EReplDecode::Ok);
+
+    if (ack)
+    {
+        std::vector<std::byte> ackPacket;
+        osp::net::repl_write_ack(rReceiver, rClient.focus, ackPacket);
+        EXPECT_TRUE(osp::net::repl_read_ack(rClient, ackPacket));
+    }
+    return packet.size();
+}
+
+void expect_near(Vector3 const a, Vector3 const b, float const tolerance)
+{
+    EXPECT_NEAR(a.x(), b.x(), tolerance);
+    EXPECT_NEAR(a.y(), b.y(), tolerance);
+    EXPECT_NEAR(a.z(), b.z(), tolerance);
+}
+
+} // namespace
+
+// The client ends up with the quantized state, structure, and signals of every object
+TEST(Replication, RoundTrip)
+{
+    std::vector<TestObject> objects(3);
+    objects[0] = {.position = {1.0f, 2.0f, 3.0f},   .velocity = {0.5f, 0.0f, -1.0f}, .structure = {std::byte(7), std::byte(8)}, .signals = {1.0f, 0.25f}};
+    objects[1] = {.position = {-40.0f, 0.0f, 9.0f}, .velocity = {},                  .structure = {std::byte(1)},               .signals = {}};
+    objects[2] = {.position = {0.0f, 100.0f, 0.0f}, .velocity = {10.0f, 0.0f, 0.0f}, .structure = {},                           .signals = {-3.0f}};
+
+    ReplClient      client;
+    ReplReceiver    receiver;
+    ReplSnapshot const current = make_snapshot(1, objects);
+    send(client, receiver, current, ReplConfig{});
+
+    ReplSnapshot const &received = *receiver.latest();
+    ASSERT_EQ(received.ids.size(), 3);
+    for (std::uint32_t i = 0; i < 3; ++i)
+    {
+        ASSERT_EQ(received.ids[i], ReplObjId(i));
+        auto const state = osp::net::repl_object_state(received.objects[i]);
+        expect_near(state.transform.translation(), objects[i].position, float(osp::net::gc_replPositionStep));
+        expect_near(state.velocity, objects[i].velocity, osp::net::gc_replVelocityStep);
+
+        auto const structure = osp::net::repl_object_structure(received, received.objects[i]);
+        EXPECT_TRUE(std::equal(structure.begin(), structure.end(), objects[i].structure.begin(), objects[i].structure.end()));
+
+        auto const signals = osp::net::repl_object_signals(received, received.objects[i]);
+        EXPECT_TRUE(std::equal(signals.begin(), signals.end(), objects[i].signals.begin(), objects[i].signals.end()));
+    }
+}
+
+// Once acknowledged, only changes are sent, and unchanged objects cost nothing
+TEST(Replication, DeltaAgainstAck)
+{
+    std::vector<TestObject> objects(50, TestObject{.structure = std::vector<std::byte>(64, std::byte(3)), .signals = {1.0f, 2.0f, 3.0f, 4.0f}});
+    for (std::size_t i = 0; i < objects.size(); ++i)
+    {
+        objects[i].position = {float(i), 0.0f, 0.0f};
+    }
+
+    ReplClient      client;
+    ReplReceiver    receiver;
+    std::size_t const fullSize = send(client, receiver, make_snapshot(1, objects), ReplConfig{.packetBudget = 65000});
+
+    objects[10].position    = {10.0f, 1.0f, 0.0f};
+    objects[20].signals[2]  = 5.0f;
+    std::size_t const deltaSize = send(client, receiver, make_snapshot(2, objects), ReplConfig{.packetBudget = 65000});
+
+    EXPECT_LT(deltaSize * 50, fullSize);
+
+    ReplSnapshot const &received = *receiver.latest();
+    ASSERT_EQ(received.ids.size(), 50);
+    expect_near(osp::net::repl_object_state(received.objects[10]).transform.translation(), objects[10].position, 0.001f);
+    EXPECT_EQ(osp::net::repl_object_signals(received, received.objects[20])[2], 5.0f);
+    EXPECT_EQ(osp::net::repl_object_structure(received, received.objects[30]).size(), 64);
+
+    // Nothing changed at all, only the header and empty lists are sent
+    EXPECT_LT(send(client, receiver, make_snapshot(3, objects), ReplConfig{}), 16);
+}
+
+// Deltas stay decodable when packets or acks are lost, since they're always against a
+// snapshot the client acknowledged
+TEST(Replication, LostPackets)
+{
+    std::vector<TestObject> objects(4);
+
+    ReplClient      client;
+    ReplReceiver    receiver;
+    send(client, receiver, make_snapshot(1, objects), ReplConfig{});
+
+    // Lost on the way to the client
+    objects[1].position = {5.0f, 0.0f, 0.0f};
+    std::vector<std::byte> lost;
+    osp::net::repl_encode(client, make_snapshot(2, objects), ReplConfig{}, lost);
+
+    // Received, but the ack is lost
+    objects[2].position = {0.0f, 5.0f, 0.0f};
+    send(client, receiver, make_snapshot(3, objects), ReplConfig{}, false);
+
+    objects[3].position = {0.0f, 0.0f, 5.0f};
+    send(client, receiver, make_snapshot(4, objects), ReplConfig{});
+
+    ReplSnapshot const &received = *receiver.latest();
+    for (std::uint32_t i = 0; i < 4; ++i)
+    {
+        expect_near(osp::net::repl_object_state(received.objects[i]).transform.translation(), objects[i].position, 0.001f);
+    }
+
+    // Late duplicates are ignored
+    EXPECT_EQ(osp::net::repl_decode(receiver, lost), EReplDecode::Outdated);
+}
+
+// Only objects near the client's focus are sent, and objects leaving the area are removed
+TEST(Replication, InterestRadius)
+{
+    std::vector<TestObject> objects(3);
+    objects[0].position = {0.0f, 0.0f, 0.0f};
+    objects[1].position = {90.0f, 0.0f, 0.0f};
+    objects[2].position = {500.0f, 0.0f, 0.0f};
+
+    ReplConfig const config{.interestRadius = 100.0f};
+    ReplClient      client;
+    ReplReceiver    receiver;
+    send(client, receiver, make_snapshot(1, objects), config);
+
+    ASSERT_EQ(receiver.latest()->ids.size(), 2);
+    EXPECT_EQ(receiver.latest()->find(ReplObjId(2)), 2);
+
+    objects[1].position = {200.0f, 0.0f, 0.0f};
+    send(client, receiver, make_snapshot(2, objects), config);
+    ASSERT_EQ(receiver.latest()->ids.size(), 1);
+    EXPECT_EQ(receiver.latest()->ids[0], ReplObjId(0));
+
+    // Focus moved with the ack
+    client.focus = {450.0f, 0.0f, 0.0f};
+    send(client, receiver, make_snapshot(3, objects), config);
+    send(client, receiver, make_snapshot(4, objects), config);
+    ASSERT_EQ(receiver.latest()->ids.size(), 1);
+    EXPECT_EQ(receiver.latest()->ids[0], ReplObjId(2));
+}
+
+// With more changes than fit a packet, every object is still updated within a few packets
+TEST(Replication, PacketBudget)
+{
+    std::vector<TestObject> objects(400);
+    for (std::size_t i = 0; i < objects.size(); ++i)
+    {
+        objects[i].position = {float(i % 20) * 10.0f, float(i / 20) * 10.0f, 0.0f};
+    }
+
+    ReplConfig const config{.packetBudget = 1200};
+    ReplClient      client;
+    ReplReceiver    receiver;
+
+    osp::net::ReplFrame frame = 1;
+    for (; frame < 100 && (receiver.latest() == nullptr || receiver.latest()->ids.size() < objects.size()); ++frame)
+    {
+        send(client, receiver, make_snapshot(frame, objects), config);
+    }
+    ASSERT_EQ(receiver.latest()->ids.size(), objects.size());
+
+    // Everything moves each frame. Objects that weren't sent keep their last state, and are
+    // all sent again within a few frames.
+    std::vector<osp::net::ReplFrame> lastUpdate(objects.size(), 0);
+    for (int step = 0; step < 20; ++step, ++frame)
+    {
+        for (TestObject &rObj : objects)
+        {
+            rObj.position = rObj.position - Vector3{0.0f, 0.0f, 1.0f};
+        }
+        send(client, receiver, make_snapshot(frame, objects), config);
+
+        ReplSnapshot const &received = *receiver.latest();
+        for (std::uint32_t i = 0; i < objects.size(); ++i)
+        {
+            if (std::abs(osp::net::repl_object_state(received.objects[i]).transform.translation().z() - objects[i].position.z()) < 0.01f)
+            {
+                lastUpdate[i] = frame;
+            }
+        }
+    }
+    for (std::uint32_t i = 0; i < objects.size(); ++i)
+    {
+        EXPECT_GE(lastUpdate[i] + 10, frame) << "object " << i;
+    }
+}
+
+TEST(Replication, Malformed)
+{
+    std::vector<TestObject> objects(2, TestObject{.signals = {1.0f}});
+
+    ReplClient      client;
+    std::vector<std::byte> packet;
+    osp::net::repl_encode(client, make_snapshot(1, objects), ReplConfig{}, packet);
+
+    for (std::size_t size = 0; size < packet.size(); ++size)
+    {
+        ReplReceiver receiver;
+        EXPECT_NE(osp::net::repl_decode(receiver, {packet.data(), size}), EReplDecode::Ok);
+    }
+
+    // Baseline the receiver never got
+    client.acked = 1;
+    osp::net::repl_encode(client, make_snapshot(2, objects), ReplConfig{}, packet);
+    ReplReceiver receiver;
+    EXPECT_EQ(osp::net::repl_decode(receiver, packet), EReplDecode::MissingBaseline);
+}
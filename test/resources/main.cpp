@@ -27,6 +27,13 @@
 
 #include <gtest/gtest.h>
 
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
 using namespace osp;
 
 struct ImageData { int m_dummy{0}; };
@@ -96,6 +103,211 @@ TEST(Resources, Basic)
 
 }
 
+// Test interning names into a StringPool
+TEST(Resources, StringPool)
+{
+    StringPool pool;
+
+    EXPECT_EQ(pool.find("Image0"), lgrn::id_null<StrId>());
+
+    StrId const image0  = pool.intern("Image0");
+    StrId const mesh0   = pool.intern(std::string{"Mesh0"});
+    StrId const empty   = pool.intern("");
+
+    EXPECT_NE(image0, mesh0);
+    EXPECT_EQ(pool.intern(std::string{"Image0"}), image0);
+    EXPECT_EQ(pool.find("Mesh0"), mesh0);
+    EXPECT_EQ(pool.find(""), empty);
+    EXPECT_EQ(pool.view(image0), "Image0");
+    EXPECT_EQ(pool.hash(mesh0), StringPool::hash_string("Mesh0"));
+
+    // Views stay valid while many more strings are added
+    std::string_view const view = pool.view(image0);
+    for (int i = 0; i < 10000; ++i)
+    {
+        std::ignore = pool.intern(std::to_string(i));
+    }
+    EXPECT_EQ(pool.size(), 10003u);
+    EXPECT_EQ(view.data(), pool.view(image0).data());
+    EXPECT_EQ(pool.find("1234"), pool.intern("1234"));
+
+    // Resources with equal names share a name handle, and can be found by it
+    Resources res = setup_basic();
+    PkgId pkgA = res.pkg_create();
+    PkgId pkgB = res.pkg_create();
+    ResId imageA = res.create(restypes::gc_image, pkgA, SharedString::create_reference("Shared"));
+    ResId imageB = res.create(restypes::gc_image, pkgB, SharedString::create_reference("Shared"));
+    ResId meshA  = res.create(restypes::gc_mesh,  pkgA, SharedString::create_reference("Shared"));
+
+    StrId const shared = res.intern("Shared");
+    EXPECT_EQ(res.name_id(restypes::gc_image, imageA), shared);
+    EXPECT_EQ(res.name_id(restypes::gc_image, imageB), shared);
+    EXPECT_EQ(res.find(restypes::gc_image, pkgB, shared), imageB);
+    EXPECT_EQ(res.find(restypes::gc_mesh,  pkgA, shared), meshA);
+    EXPECT_EQ(res.find(restypes::gc_mesh,  pkgB, shared), lgrn::id_null<ResId>());
+    EXPECT_EQ(std::string_view{res.name(restypes::gc_mesh, meshA)}, "Shared");
+}
+
+// Test data of lazy resources only being held while they have owners
+TEST(Resources, Lazy)
+{
+    Resources res = setup_basic();
+    PkgId pkgA = res.pkg_create();
+
+    int loads = 0;
+    int unloads = 0;
+
+    ResId id = res.create(restypes::gc_mesh, pkgA, SharedString::create_reference("Mesh0"));
+    res.set_lazy(restypes::gc_mesh, id, Resources::LazyLoader
+    {
+        .m_load = [] (Resources &rResources, ResTypeId typeId, ResId resId, entt::any &rUserData)
+        {
+            ++ *entt::any_cast<std::pair<int*, int*>&>(rUserData).first;
+            rResources.data_add<MeshData>(typeId, resId, MeshData{42});
+            rResources.data_add<ExtraData>(typeId, resId, ExtraData{7});
+        },
+        .m_unload = [] (Resources&, ResTypeId, ResId, entt::any &rUserData)
+        {
+            ++ *entt::any_cast<std::pair<int*, int*>&>(rUserData).second;
+        },
+        .m_userData = std::pair<int*, int*>{&loads, &unloads}
+    });
+
+    // Nothing is loaded up front
+    EXPECT_FALSE(res.is_loaded(restypes::gc_mesh, id));
+    EXPECT_EQ(res.data_try_get<MeshData>(restypes::gc_mesh, id), nullptr);
+
+    // Loaded once by the first owner
+    ResIdOwner_t ownerA = res.owner_create(restypes::gc_mesh, id);
+    ResIdOwner_t ownerB = res.owner_create(restypes::gc_mesh, id);
+    EXPECT_EQ(loads, 1);
+    EXPECT_TRUE(res.is_loaded(restypes::gc_mesh, id));
+    EXPECT_EQ(res.data_get<MeshData>(restypes::gc_mesh, id).m_dummy, 42);
+
+    // Freed along with all other data once the last owner is gone
+    res.owner_destroy(restypes::gc_mesh, std::move(ownerA));
+    EXPECT_EQ(unloads, 0);
+    EXPECT_NE(res.data_try_get<MeshData>(restypes::gc_mesh, id), nullptr);
+
+    res.owner_destroy(restypes::gc_mesh, std::move(ownerB));
+    EXPECT_EQ(unloads, 1);
+    EXPECT_FALSE(res.is_loaded(restypes::gc_mesh, id));
+    EXPECT_EQ(res.data_try_get<MeshData>(restypes::gc_mesh, id), nullptr);
+    EXPECT_EQ(res.data_try_get<ExtraData>(restypes::gc_mesh, id), nullptr);
+
+    // Loaded again on next use
+    ResIdOwner_t ownerC = res.owner_create(restypes::gc_mesh, id);
+    EXPECT_EQ(loads, 2);
+    EXPECT_EQ(res.data_get<MeshData>(restypes::gc_mesh, id).m_dummy, 42);
+    res.owner_destroy(restypes::gc_mesh, std::move(ownerC));
+
+    // Resources that aren't lazy keep their data
+    ResId eager = res.create(restypes::gc_mesh, pkgA, SharedString::create_reference("Mesh1"));
+    res.data_add<MeshData>(restypes::gc_mesh, eager, MeshData{1});
+    EXPECT_TRUE(res.is_loaded(restypes::gc_mesh, eager));
+    res.owner_destroy(restypes::gc_mesh, res.owner_create(restypes::gc_mesh, eager));
+    EXPECT_NE(res.data_try_get<MeshData>(restypes::gc_mesh, eager), nullptr);
+}
+
+// Test creating, finding, and owning resources from multiple threads at once
+TEST(Resources, Concurrent)
+{
+    constexpr int threadCount   = 4;
+    constexpr int perThread     = 256;
+
+    Resources res = setup_basic();
+    PkgId pkgA = res.pkg_create();
+
+    ResId shared = res.create(restypes::gc_mesh, pkgA, SharedString::create_reference("Shared"));
+    res.data_add<MeshData>(restypes::gc_mesh, shared, MeshData{1});
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t)
+    {
+        threads.emplace_back([&res, pkgA, shared, t] ()
+        {
+            for (int i = 0; i < perThread; ++i)
+            {
+                int const value = t * perThread + i;
+                ResId const id = res.create(restypes::gc_mesh, pkgA, SharedString::create(std::to_string(value)));
+                res.data_add<MeshData>(restypes::gc_mesh, id, MeshData{value});
+
+                // Everyone touches the same resource's refcount
+                res.owner_destroy(restypes::gc_mesh, res.owner_create(restypes::gc_mesh, shared));
+                EXPECT_EQ(res.data_get<MeshData>(restypes::gc_mesh, shared).m_dummy, 1);
+            }
+        });
+    }
+
+    for (std::thread &rThread : threads)
+    {
+        rThread.join();
+    }
+
+    for (int value = 0; value < threadCount * perThread; ++value)
+    {
+        ResId const id = res.find(restypes::gc_mesh, pkgA, std::to_string(value));
+        ASSERT_NE(id, lgrn::id_null<ResId>());
+        EXPECT_EQ(res.data_get<MeshData>(restypes::gc_mesh, id).m_dummy, value);
+    }
+}
+
+// Test Resources sharing one store, as used by multiple simulations in one process
+TEST(Resources, Shared)
+{
+    Resources resA = setup_basic();
+    PkgId pkgA = resA.pkg_create();
+
+    int loads = 0;
+    int unloads = 0;
+
+    ResId lazy = resA.create(restypes::gc_mesh, pkgA, SharedString::create_reference("Lazy"));
+    resA.set_lazy(restypes::gc_mesh, lazy, Resources::LazyLoader
+    {
+        .m_load = [] (Resources &rResources, ResTypeId typeId, ResId resId, entt::any &rUserData)
+        {
+            ++ *entt::any_cast<std::pair<int*, int*>&>(rUserData).first;
+            rResources.data_add<MeshData>(typeId, resId, MeshData{42});
+        },
+        .m_unload = [] (Resources&, ResTypeId, ResId, entt::any &rUserData)
+        {
+            ++ *entt::any_cast<std::pair<int*, int*>&>(rUserData).second;
+        },
+        .m_userData = std::pair<int*, int*>{&loads, &unloads}
+    });
+
+    Resources resB = resA.share();
+
+    // Resources created by either are seen by both
+    ResId eager = resB.create(restypes::gc_mesh, pkgA, SharedString::create_reference("Eager"));
+    resB.data_add<MeshData>(restypes::gc_mesh, eager, MeshData{1});
+    EXPECT_EQ(resA.find(restypes::gc_mesh, pkgA, "Eager"), eager);
+    EXPECT_EQ(resA.data_get<MeshData>(restypes::gc_mesh, eager).m_dummy, 1);
+
+    // Lazy data is loaded once, and kept until neither has owners
+    ResIdOwner_t ownerA = resA.owner_create(restypes::gc_mesh, lazy);
+    ResIdOwner_t ownerB = resB.owner_create(restypes::gc_mesh, lazy);
+    EXPECT_EQ(loads, 1);
+    EXPECT_EQ(resB.data_get<MeshData>(restypes::gc_mesh, lazy).m_dummy, 42);
+
+    resA.owner_destroy(restypes::gc_mesh, std::move(ownerA));
+    EXPECT_EQ(unloads, 0);
+    EXPECT_TRUE(resA.is_loaded(restypes::gc_mesh, lazy));
+
+    resB.owner_destroy(restypes::gc_mesh, std::move(ownerB));
+    EXPECT_EQ(unloads, 1);
+    EXPECT_FALSE(resA.is_loaded(restypes::gc_mesh, lazy));
+
+    // Counts are per-instance; an instance can be destroyed while others still own resources
+    ResIdOwner_t ownerEager = resA.owner_create(restypes::gc_mesh, eager);
+    {
+        Resources resC = resA.share();
+        resC.owner_destroy(restypes::gc_mesh, resC.owner_create(restypes::gc_mesh, eager));
+    }
+    EXPECT_EQ(resA.data_get<MeshData>(restypes::gc_mesh, eager).m_dummy, 1);
+    resA.owner_destroy(restypes::gc_mesh, std::move(ownerEager));
+}
+
 // Test ref counting and storage features
 TEST(Resources, RefCounting)
 {
@@ -0,0 +1,248 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <osp/activescene/scene_save.h>
+#include <osp/core/Resources.h>
+
+#include <Corrade/Containers/ArrayViewStl.h>
+
+#include <gtest/gtest.h>
+
+#include <array>
+
+using osp::Matrix4;
+using osp::Vector3;
+using osp::active::ACtxBasic;
+using osp::active::ACtxParts;
+using osp::active::ActiveEnt;
+using osp::active::PartId;
+using osp::active::SysSceneSave;
+using osp::active::WeldId;
+using osp::link::Junction;
+using osp::link::MachAnyId;
+using osp::link::MachLocalId;
+using osp::link::MachTypeId;
+using osp::link::NodeId;
+
+namespace
+{
+
+MachTypeId const gc_mtTest = osp::link::MachTypeReg_t::create();
+
+struct TestScene
+{
+    ACtxBasic                           basic;
+    ACtxParts                           parts;
+    osp::link::SignalValues_t<float>    sigValFloat;
+};
+
+/**
+ * @brief Two welded parts, each with one machine, connected by a float node
+ *
+ * A few IDs are removed so there are free IDs to restore.
+ */
+void make_scene(TestScene &rScene)
+{
+    ACtxBasic &rBasic = rScene.basic;
+    std::array<ActiveEnt, 4> ents;
+    rBasic.m_activeIds.create(ents.begin(), ents.end());
+    rBasic.m_activeIds.remove(ents[1]);
+
+    rBasic.m_scnGraph.resize(rBasic.m_activeIds.capacity());
+    for (ActiveEnt const ent : {ents[0], ents[2], ents[3]})
+    {
+        rBasic.m_scnGraph.m_treeToEnt       .push_back(ent);
+        rBasic.m_scnGraph.m_treeDescendants .push_back(0);
+        rBasic.m_scnGraph.m_entToTreePos[ent] = static_cast<osp::active::TreePos_t>(rBasic.m_scnGraph.m_treeToEnt.size() - 1);
+    }
+    rBasic.m_scnGraph.m_treeDescendants[0] = 3;
+    rBasic.m_transform.emplace(ents[0], Matrix4::translation({1.0f, 2.0f, 3.0f}));
+    rBasic.m_transform.emplace(ents[3], Matrix4::translation({4.0f, 5.0f, 6.0f}));
+
+    ACtxParts &rParts = rScene.parts;
+    std::array<PartId, 3> parts;
+    rParts.partIds.create(parts.begin(), parts.end());
+    rParts.partIds.remove(parts[1]);
+    WeldId const weld = rParts.weldIds.create();
+
+    std::size_t const partCapacity = rParts.partIds.capacity();
+    rParts.partPrefabs      .resize(partCapacity);
+    rParts.partTransformWeld.resize(partCapacity);
+    rParts.partToWeld       .resize(partCapacity);
+    rParts.partToActive     .resize(partCapacity);
+    rParts.activeToPart     .resize(rBasic.m_activeIds.capacity());
+    rParts.weldToActive     .resize(rParts.weldIds.capacity());
+
+    rParts.weldToParts.ids_reserve(rParts.weldIds.capacity());
+    rParts.weldToParts.data_reserve(2);
+    PartId *pWeldParts = rParts.weldToParts.emplace(weld, 2);
+    pWeldParts[0] = parts[0];
+    pWeldParts[1] = parts[2];
+
+    rParts.partTransformWeld[parts[2]]  = Matrix4::translation({0.0f, 0.0f, 7.0f});
+    rParts.partToWeld[parts[0]]         = weld;
+    rParts.partToWeld[parts[2]]         = weld;
+    rParts.partToActive[parts[0]]       = ents[3];
+    rParts.partToActive[parts[2]]       = ents[2];
+    rParts.activeToPart[ents[3]]        = parts[0];
+    rParts.activeToPart[ents[2]]        = parts[2];
+    rParts.weldToActive[weld]           = ents[0];
+
+    // Machines
+
+    osp::link::Machines &rMachines = rParts.machines;
+    rMachines.perType.resize(osp::link::MachTypeReg_t::size());
+    osp::link::PerMachType &rPerType = rMachines.perType[gc_mtTest];
+
+    std::array<MachAnyId, 2> machs;
+    std::array<MachLocalId, 2> locals;
+    rMachines.ids.create(machs.begin(), machs.end());
+    rPerType.localIds.create(locals.begin(), locals.end());
+
+    rMachines.machTypes     .resize(rMachines.ids.capacity());
+    rMachines.machToLocal   .resize(rMachines.ids.capacity());
+    rPerType.localToAny     .resize(rPerType.localIds.capacity());
+    rParts.machineToPart    .resize(rMachines.ids.capacity());
+    rParts.partToMachines.ids_reserve(partCapacity);
+    rParts.partToMachines.data_reserve(2);
+
+    for (std::size_t i = 0; i < 2; ++i)
+    {
+        rMachines.machTypes[machs[i]]   = gc_mtTest;
+        rMachines.machToLocal[machs[i]] = locals[i];
+        rPerType.localToAny[locals[i]]  = machs[i];
+
+        PartId const part = (i == 0) ? parts[0] : parts[2];
+        rParts.machineToPart[machs[i]] = part;
+        *rParts.partToMachines.emplace(part, 1) = {locals[i], gc_mtTest};
+    }
+
+    // Nodes
+
+    rParts.nodePerType.resize(osp::link::NodeTypeReg_t::size());
+    osp::link::Nodes &rFloatNodes = rParts.nodePerType[osp::link::gc_ntSigFloat];
+
+    std::array<NodeId, 2> nodes;
+    rFloatNodes.nodeIds.create(nodes.begin(), nodes.end());
+    rFloatNodes.nodeIds.remove(nodes[0]);
+
+    rFloatNodes.nodeToMach.ids_reserve(rFloatNodes.nodeIds.capacity());
+    rFloatNodes.nodeToMach.data_reserve(2);
+    rFloatNodes.machToNode.ids_reserve(rMachines.ids.capacity());
+    rFloatNodes.machToNode.data_reserve(2);
+
+    Junction *pJunctions = rFloatNodes.nodeToMach.emplace(nodes[1], 2);
+    pJunctions[0] = {locals[0], gc_mtTest, 0};
+    pJunctions[1] = {locals[1], gc_mtTest, 1};
+    *rFloatNodes.machToNode.emplace(machs[0], 1) = nodes[1];
+    *rFloatNodes.machToNode.emplace(machs[1], 1) = nodes[1];
+    rParts.connectRevision = 42;
+
+    rScene.sigValFloat.resize(rFloatNodes.nodeIds.capacity());
+    rScene.sigValFloat[nodes[1]] = 1.5f;
+}
+
+} // namespace
+
+// Save a scene and load it back into empty contexts
+TEST(SceneSave, RoundTrip)
+{
+    osp::Resources resources;
+    resources.resize_types(osp::ResTypeIdReg_t::size());
+
+    TestScene saved;
+    make_scene(saved);
+
+    std::vector<std::byte> const blob = SysSceneSave::save(saved.basic, saved.parts, saved.sigValFloat, resources);
+
+    TestScene loaded;
+    ASSERT_TRUE(SysSceneSave::load(blob, loaded.basic, loaded.parts, loaded.sigValFloat, resources, osp::PkgId{}));
+
+    // ACtxBasic
+
+    ACtxBasic const &basic = loaded.basic;
+    EXPECT_EQ(basic.m_activeIds.size(), 3u);
+    EXPECT_FALSE(basic.m_activeIds.exists(ActiveEnt{1}));
+    EXPECT_EQ(basic.m_scnGraph.m_treeToEnt.base(),       saved.basic.m_scnGraph.m_treeToEnt.base());
+    EXPECT_EQ(basic.m_scnGraph.m_treeDescendants.base(), saved.basic.m_scnGraph.m_treeDescendants.base());
+    EXPECT_EQ(basic.m_scnGraph.m_entToTreePos.base(),    saved.basic.m_scnGraph.m_entToTreePos.base());
+    ASSERT_EQ(basic.m_transform.size(), 2u);
+    EXPECT_EQ(basic.m_transform.get(ActiveEnt{0}).m_transform, Matrix4::translation({1.0f, 2.0f, 3.0f}));
+    EXPECT_EQ(basic.m_transform.get(ActiveEnt{3}).m_transform, Matrix4::translation({4.0f, 5.0f, 6.0f}));
+    EXPECT_FALSE(basic.m_transform.contains(ActiveEnt{2}));
+
+    // ACtxParts
+
+    ACtxParts const &parts = loaded.parts;
+    EXPECT_EQ(parts.partIds.size(), 2u);
+    EXPECT_FALSE(parts.partIds.exists(1));
+    EXPECT_EQ(parts.partTransformWeld[2], Matrix4::translation({0.0f, 0.0f, 7.0f}));
+    ASSERT_TRUE(parts.weldToParts.contains(0));
+    ASSERT_EQ(parts.weldToParts[0].size(), 2u);
+    EXPECT_EQ(parts.weldToParts[0][1], 2u);
+    EXPECT_EQ(parts.partToWeld[2], 0u);
+    EXPECT_EQ(parts.partToActive[0], ActiveEnt{3});
+    EXPECT_EQ(parts.activeToPart[ActiveEnt{2}], 2u);
+    EXPECT_EQ(parts.weldToActive[0], ActiveEnt{0});
+    EXPECT_EQ(parts.connectRevision, 42u);
+
+    EXPECT_EQ(parts.machines.ids.size(), 2u);
+    EXPECT_EQ(parts.machines.machTypes[1], gc_mtTest);
+    EXPECT_EQ(parts.machines.perType[gc_mtTest].localToAny[1], 1u);
+    EXPECT_EQ(parts.machineToPart[1], 2u);
+    ASSERT_TRUE(parts.partToMachines.contains(2));
+    EXPECT_EQ(parts.partToMachines[2][0].local, 1u);
+
+    osp::link::Nodes const &floatNodes = parts.nodePerType[osp::link::gc_ntSigFloat];
+    EXPECT_FALSE(floatNodes.nodeIds.exists(0));
+    ASSERT_TRUE(floatNodes.nodeToMach.contains(1));
+    ASSERT_EQ(floatNodes.nodeToMach[1].size(), 2u);
+    EXPECT_EQ(floatNodes.nodeToMach[1][1].custom, 1u);
+    EXPECT_EQ(floatNodes.machToNode[0][0], 1u);
+
+    EXPECT_EQ(loaded.sigValFloat, saved.sigValFloat);
+
+    // Free IDs are handed out again first
+
+    EXPECT_EQ(loaded.basic.m_activeIds.create(), ActiveEnt{1});
+    EXPECT_EQ(loaded.parts.partIds.create(), 1u);
+}
+
+// Blobs that are truncated anywhere fail to load instead of reading past the end
+TEST(SceneSave, Truncated)
+{
+    osp::Resources resources;
+    resources.resize_types(osp::ResTypeIdReg_t::size());
+
+    TestScene saved;
+    make_scene(saved);
+
+    std::vector<std::byte> const blob = SysSceneSave::save(saved.basic, saved.parts, saved.sigValFloat, resources);
+
+    for (std::size_t size = 0; size < blob.size(); ++size)
+    {
+        TestScene loaded;
+        EXPECT_FALSE(SysSceneSave::load({blob.data(), size}, loaded.basic, loaded.parts, loaded.sigValFloat, resources, osp::PkgId{}));
+    }
+}
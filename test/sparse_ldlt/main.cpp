@@ -0,0 +1,108 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <osp/core/math_sparse_ldlt.h>
+
+#include <gtest/gtest.h>
+
+#include <array>
+
+using osp::ProfileLDLT;
+
+// Path graph Laplacian plus a diagonal, like a pipe with tanks on both ends
+TEST(SparseLDLT, Tridiagonal)
+{
+    constexpr std::uint32_t n = 5;
+
+    ProfileLDLT matrix;
+    matrix.reset({0, 0, 1, 2, 3});
+    ASSERT_EQ(matrix.profile_size(), 9u);
+
+    for (std::uint32_t i = 0; i + 1 < n; ++i)
+    {
+        matrix.add(i,     i,      1.0);
+        matrix.add(i + 1, i + 1,  1.0);
+        matrix.add(i,     i + 1, -1.0);
+    }
+    matrix.add(0,     0,      2.0);
+    matrix.add(n - 1, n - 1,  2.0);
+
+    ASSERT_TRUE(matrix.factorize());
+
+    // x = {1, 2, 3, 4, 5}, b = A x
+    std::array<double, n> x{1.0, 2.0, 3.0, 4.0, 5.0};
+    std::array<double, n> b{ 3*1.0 - 2.0,
+                            -1.0 + 2*2.0 - 3.0,
+                            -2.0 + 2*3.0 - 4.0,
+                            -3.0 + 2*4.0 - 5.0,
+                            -4.0 + 3*5.0 };
+
+    matrix.solve({b.data(), b.size()});
+
+    for (std::uint32_t i = 0; i < n; ++i)
+    {
+        EXPECT_NEAR(b[i], x[i], 1e-9);
+    }
+}
+
+// Rows with a gap in their profile, where fill-in happens within the profile
+TEST(SparseLDLT, FillIn)
+{
+    // A = [ 4  1  0  1 ]
+    //     [ 1  4  0  0 ]
+    //     [ 0  0  4  1 ]
+    //     [ 1  0  1  4 ]
+    ProfileLDLT matrix;
+    matrix.reset({0, 0, 2, 0});
+
+    matrix.add(0, 0, 4.0);
+    matrix.add(1, 1, 4.0);
+    matrix.add(2, 2, 4.0);
+    matrix.add(3, 3, 4.0);
+    matrix.add(0, 1, 1.0);
+    matrix.add(0, 3, 1.0);
+    matrix.add(2, 3, 1.0);
+
+    ASSERT_TRUE(matrix.factorize());
+
+    // x = {1, -1, 2, 0.5}
+    std::array<double, 4> b{4.0 - 1.0 + 0.5, 1.0 - 4.0, 8.0 + 0.5, 1.0 + 2.0 + 2.0};
+    matrix.solve({b.data(), b.size()});
+
+    EXPECT_NEAR(b[0],  1.0, 1e-9);
+    EXPECT_NEAR(b[1], -1.0, 1e-9);
+    EXPECT_NEAR(b[2],  2.0, 1e-9);
+    EXPECT_NEAR(b[3],  0.5, 1e-9);
+}
+
+TEST(SparseLDLT, NotPositiveDefinite)
+{
+    ProfileLDLT matrix;
+    matrix.reset({0, 0});
+    matrix.add(0, 0, 1.0);
+    matrix.add(1, 1, 1.0);
+    matrix.add(0, 1, 2.0);
+
+    EXPECT_FALSE(matrix.factorize());
+}
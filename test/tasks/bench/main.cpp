@@ -0,0 +1,380 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Benchmark of building and executing synthetic TaskGraphs. Writes CSV.
+//
+// Usage: osp-bench-tasks [output.csv] [--pipelines N,N,...] [--frames N] [--reps N]
+//
+//   --pipelines N,...  Pipeline counts of the generated graphs (default: 16,128,512)
+//   --frames N         Frames run per repetition (default: 100)
+//   --reps N           Repetitions of each measurement, the median is written (default: 11)
+//
+// Each pipeline count is run with 0 and 2 sync edges per task, and with 0% and 25% of pipeline
+// groups being loop scopes. Times are in microseconds:
+//   makeGraph      One rebuild_exec_graph call into the same TaskGraph
+//   frame          Running all pipelines until completion, as a frame would. Tasks are
+//                  completed in the order they're queued and do no work of their own.
+//   execUpdate     Time of a frame spent in exec_update
+//   completeTask   Time of a frame spent in complete_task
+
+#include "../../bench_utils.h"
+
+#include <osp/tasks/tasks.h>
+#include <osp/tasks/builder.h>
+#include <osp/tasks/execute.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace osp;
+
+using osp::bench::Clock_t;
+using osp::bench::median;
+using osp::bench::micros_since;
+
+namespace
+{
+
+enum class Stages { Schedule, Process, Done };
+
+struct GraphParams
+{
+    int pipelines;          ///< Number of pipelines, including loop scopes and their children
+    int tasksPerPipeline;
+    int syncPerTask;        ///< Number of sync_with edges per task to unrelated pipelines
+    int loopScopePercent;   ///< Chance for each group of pipelines to be a loop scope
+    int loopCount;          ///< Number of times each loop scope loops
+};
+
+struct TaskInfo
+{
+    bool    isScheduler     { false };
+    int     loopsLeft       { 0 };
+};
+
+/**
+ * @brief Randomly generated Tasks and TaskEdges, reproducible for the same GraphParams
+ *
+ * Pipelines are made in groups of 4. A group is either 4 independent pipelines, or a main
+ * pipeline with a loop scope child that has 2 child pipelines, similar to
+ * Tasks.BasicSingleThreadedLoop. Sync edges only ever require
+ * the Process stage of other independent pipelines, so the graph can never deadlock.
+ */
+struct SyntheticGraph
+{
+    explicit SyntheticGraph(GraphParams const params)
+     : m_params{params}
+    {
+        std::mt19937 randGen(420);
+
+        using Builder_t = BasicBuilderTraits<void(*)()>::Builder;
+        BasicBuilderTraits<void(*)()>::FuncVec_t funcs;
+        Builder_t builder{m_tasks, m_edges, funcs};
+
+        auto const add_pipeline = [this] () -> PipelineId
+        {
+            PipelineId const pl = m_tasks.m_pipelineIds.create();
+            std::size_t const capacity = m_tasks.m_pipelineIds.capacity();
+            m_tasks.m_pipelineInfo   .resize(capacity);
+            m_tasks.m_pipelineControl.resize(capacity);
+            m_tasks.m_pipelineParents.resize(capacity, lgrn::id_null<PipelineId>());
+            return pl;
+        };
+
+        auto const tpl = [] (PipelineId const pl, Stages const stage) -> TplPipelineStage
+        {
+            return {pl, StageId(stage)};
+        };
+
+        std::vector<PipelineId> independent;
+
+        for (int group = 0; group * 4 < params.pipelines; ++group)
+        {
+            bool const isLoop = int(randGen() % 100) < params.loopScopePercent;
+
+            if (isLoop)
+            {
+                PipelineId const main = add_pipeline();
+                PipelineId const loop = add_pipeline();
+                m_tasks.m_pipelineParents[loop] = main;
+                m_tasks.m_pipelineControl[loop].isLoopScope = true;
+                m_roots.push_back(main);
+
+                std::array<PipelineId, 2> steps{};
+                for (PipelineId &rStep : steps)
+                {
+                    rStep = add_pipeline();
+                    m_tasks.m_pipelineParents[rStep] = loop;
+                }
+
+                // Scheduler decides if the loop continues
+                TaskId const scheduler = builder.task()
+                    .run_on   (tpl(loop, Stages::Schedule))
+                    .sync_with({tpl(main, Stages::Process), tpl(steps[0], Stages::Schedule), tpl(steps[1], Stages::Schedule)})
+                    .m_taskId;
+                set_info(scheduler, {true, 0});
+
+                for (PipelineId const step : steps)
+                {
+                    for (int i = 0; i < params.tasksPerPipeline; ++i)
+                    {
+                        TaskId const task = builder.task()
+                            .run_on   (tpl(step, Stages::Process))
+                            .sync_with({tpl(main, Stages::Process), tpl(loop, Stages::Process)})
+                            .m_taskId;
+                        set_info(task, {});
+                    }
+                }
+            }
+            else
+            {
+                for (int i = 0; i < 4; ++i)
+                {
+                    PipelineId const pl = add_pipeline();
+                    independent.push_back(pl);
+                    m_roots.push_back(pl);
+                }
+            }
+        }
+
+        for (PipelineId const pl : independent)
+        {
+            for (int i = 0; i < params.tasksPerPipeline; ++i)
+            {
+                auto taskRef = builder.task().run_on(tpl(pl, Stages::Process));
+                set_info(taskRef.m_taskId, {});
+
+                for (int j = 0; j < params.syncPerTask; ++j)
+                {
+                    PipelineId const other = independent[randGen() % independent.size()];
+                    if (other != pl)
+                    {
+                        taskRef.sync_with({tpl(other, Stages::Process)});
+                    }
+                }
+            }
+        }
+    }
+
+    void set_info(TaskId const task, TaskInfo const info)
+    {
+        m_taskInfo.resize(m_tasks.m_taskIds.capacity());
+        m_taskInfo[task] = info;
+    }
+
+    GraphParams                 m_params;
+    Tasks                       m_tasks;
+    TaskEdges                   m_edges;
+    KeyedVec<TaskId, TaskInfo>  m_taskInfo;
+    std::vector<PipelineId>     m_roots;
+};
+
+struct Times
+{
+    double      makeGraph       {0.0};
+    double      frame           {0.0};
+    double      execUpdate      {0.0};
+    double      completeTask    {0.0};
+    double      tasksPerFrame   {0.0};
+    double      cyclesPerFrame  {0.0};
+    std::size_t tasks           {0};
+    bool        stuck           {false};
+};
+
+Times run(GraphParams const params, int const frames, int const reps)
+{
+    SyntheticGraph synth{params};
+
+    std::vector<double> makeGraph;
+    std::vector<double> frame;
+    std::vector<double> execUpdate;
+    std::vector<double> completeTask;
+
+    Times out;
+    out.tasks = synth.m_tasks.m_taskIds.size();
+
+    TaskGraph graph;
+    for (int rep = 0; rep < reps; ++rep)
+    {
+        auto const start = Clock_t::now();
+        rebuild_exec_graph(synth.m_tasks, {&synth.m_edges}, graph);
+        makeGraph.push_back(micros_since(start));
+        osp::bench::keep_result(graph.runtaskToTask.size());
+    }
+
+    ExecContext exec;
+    exec_conform(synth.m_tasks, exec);
+    exec.doLogging = false;
+
+    std::int64_t tasksRun = 0;
+    std::int64_t cycles   = 0;
+
+    for (int rep = 0; rep < reps; ++rep)
+    {
+        double updateTime   = 0.0;
+        double completeTime = 0.0;
+
+        auto const repStart = Clock_t::now();
+        for (int f = 0; f < frames; ++f)
+        {
+            for (TaskInfo &rInfo : synth.m_taskInfo)
+            {
+                rInfo.loopsLeft = synth.m_params.loopCount;
+            }
+
+            for (PipelineId const root : synth.m_roots)
+            {
+                exec_request_run(exec, root);
+            }
+
+            auto const updateStart = Clock_t::now();
+            exec_update(synth.m_tasks, graph, exec);
+            updateTime += micros_since(updateStart);
+
+            while ( ! exec.tasksQueuedRun.empty() )
+            {
+                TaskId const task   = exec.tasksQueuedRun[0];
+                TaskInfo    &rInfo  = synth.m_taskInfo[task];
+
+                TaskActions actions;
+                if (rInfo.isScheduler && (rInfo.loopsLeft-- == 0))
+                {
+                    actions = TaskAction::Cancel;
+                }
+
+                auto const completeStart = Clock_t::now();
+                complete_task(synth.m_tasks, graph, exec, task, actions);
+                completeTime += micros_since(completeStart);
+
+                auto const completeEnd = Clock_t::now();
+                exec_update(synth.m_tasks, graph, exec);
+                updateTime += micros_since(completeEnd);
+                ++ tasksRun;
+            }
+
+            if (exec.pipelinesRunning != 0)
+            {
+                out.stuck = true;
+                return out;
+            }
+
+            cycles += exec.stats.cycles;
+            exec.stats = {};
+        }
+
+        frame       .push_back(micros_since(repStart) / double(frames));
+        execUpdate  .push_back(updateTime   / double(frames));
+        completeTask.push_back(completeTime / double(frames));
+    }
+
+    double const framesRun = double(frames) * double(reps);
+
+    out.makeGraph       = median(makeGraph);
+    out.frame           = median(frame);
+    out.execUpdate      = median(execUpdate);
+    out.completeTask    = median(completeTask);
+    out.tasksPerFrame   = double(tasksRun) / framesRun;
+    out.cyclesPerFrame  = double(cycles)   / framesRun;
+    return out;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    char const*                 outPath     = nullptr;
+    std::vector<std::size_t>    pipelines   {16, 128, 512};
+    int                         frames      = 100;
+    int                         reps        = 11;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (char const* const value = osp::bench::option_value(argc, argv, i, "--pipelines"))
+        {
+            pipelines = osp::bench::parse_counts(value);
+        }
+        else if (char const* const value = osp::bench::option_value(argc, argv, i, "--frames"))
+        {
+            frames = std::max(1, std::stoi(value));
+        }
+        else if (char const* const value = osp::bench::option_value(argc, argv, i, "--reps"))
+        {
+            reps = std::max(1, std::stoi(value));
+        }
+        else
+        {
+            outPath = argv[i];
+        }
+    }
+
+    osp::bench::CsvOutput const output{outPath};
+    std::FILE *const pOut = output.file();
+    if (pOut == nullptr)
+    {
+        return 1;
+    }
+
+    std::fprintf(pOut, "pipelines,syncPerTask,loopPercent,tasks,usMakeGraph,"
+                       "usFrame,usExecUpdate,usCompleteTask,tasksPerFrame,cyclesPerFrame\n");
+
+    for (std::size_t const pipelineCount : pipelines)
+    {
+        for (int const sync : {0, 2})
+        {
+            for (int const loop : {0, 25})
+            {
+                GraphParams const params
+                {
+                    .pipelines          = int(pipelineCount),
+                    .tasksPerPipeline   = 4,
+                    .syncPerTask        = sync,
+                    .loopScopePercent   = loop,
+                    .loopCount          = 3
+                };
+
+                Times const times = run(params, frames, reps);
+                if (times.stuck)
+                {
+                    std::fprintf(stderr, "Synthetic graph got stuck: %zu pipelines, %d sync, %d%% loops\n",
+                                 pipelineCount, sync, loop);
+                    return 1;
+                }
+
+                std::fprintf(pOut, "%zu,%d,%d,%zu,%.1f,%.2f,%.2f,%.2f,%.1f,%.1f\n",
+                             pipelineCount, sync, loop, times.tasks,
+                             times.makeGraph, times.frame, times.execUpdate, times.completeTask,
+                             times.tasksPerFrame, times.cyclesPerFrame);
+                std::fflush(pOut);
+            }
+        }
+    }
+
+    return 0;
+}
@@ -25,13 +25,23 @@
 #include <osp/tasks/tasks.h>
 #include <osp/tasks/builder.h>
 #include <osp/tasks/execute.h>
+#include <osp/tasks/static_graph.h>
+#include <osp/tasks/top_execute.h>
+#include <osp/tasks/top_session.h>
+#include <osp/tasks/top_utils.h>
+#include <osp/tasks/top_worker_pool.h>
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <functional>
 #include <numeric>
 #include <random>
 #include <set>
+#include <sstream>
+#include <thread>
 
 using namespace osp;
 
@@ -175,6 +185,10 @@ TEST(Tasks, BasicSingleThreadedParallelTasks)
     }
 
     ASSERT_EQ(checksRun, sc_repetitions);
+
+    ASSERT_GE(exec.stats.updates, uint32_t(sc_repetitions));
+    ASSERT_GE(exec.stats.cycles,  exec.stats.maxCyclesPerUpdate);
+    ASSERT_NE(exec.stats.pipelinesAdvanced, 0u);
 }
 
 //-----------------------------------------------------------------------------
@@ -729,6 +743,1438 @@ TEST(Tasks, BasicSingleThreadedGameWorld)
     }
 }
 
+//-----------------------------------------------------------------------------
+
+namespace test_parallel
+{
+
+enum class Stages { Write, Check };
+
+struct Pipelines
+{
+    osp::PipelineDef<Stages> values;
+};
+
+} // namespace test_parallel
+
+// Independent TopTasks each writing to their own TopData, run by multiple threads
+TEST(Tasks, TopRunParallel)
+{
+    using namespace test_parallel;
+    using enum Stages;
+
+    constexpr int       sc_repetitions  = 64;
+    constexpr TopDataId sc_writerCount  = 16;
+    constexpr TopDataId sc_idChecks     = sc_writerCount;
+    constexpr TopDataId sc_idStep       = sc_writerCount + 1;
+
+    Tasks               tasks;
+    TaskEdges           edges;
+    TopTaskDataVec_t    taskData;
+    TopTaskBuilder      builder{tasks, edges, taskData};
+
+    auto const pl = builder.create_pipelines<Pipelines>();
+
+    std::vector<entt::any> topData(sc_writerCount + 2);
+    top_emplace<int>(topData, sc_idChecks, 0);
+    top_emplace<int>(topData, sc_idStep, 1);
+
+    std::vector<TopDataId> allIds;
+
+    // Writers only share a read-only step value, so all of them can run at the same time
+    for (TopDataId id = 0; id < sc_writerCount; ++id)
+    {
+        top_emplace<int>(topData, id, 0);
+        allIds.push_back(id);
+
+        builder.task()
+            .run_on(pl.values(Write))
+            .args({id, sc_idStep})
+            .func([] (int &rValue, int const& step) noexcept
+        {
+            rValue += step;
+        });
+    }
+    allIds.push_back(sc_idChecks);
+
+    TaskId const checkTask = builder.task()
+        .run_on(pl.values(Check))
+        .func_raw([] (WorkerContext, ArrayView<entt::any> data) noexcept -> TaskActions
+    {
+        int &rChecks = entt::any_cast<int&>(data.back());
+        ++ rChecks;
+        for (entt::any &rValue : data.prefix(data.size() - 1))
+        {
+            EXPECT_EQ(entt::any_cast<int&>(rValue), rChecks);
+        }
+        return {};
+    });
+    taskData[checkTask].m_dataUsed = allIds;
+
+    TaskGraph const graph = make_exec_graph(tasks, {&edges});
+
+    ExecContext exec;
+    exec_conform(tasks, exec);
+    exec.doLogging = false;
+
+    TopWorkerPool pool{4};
+
+    for (int i = 0; i < sc_repetitions; ++i)
+    {
+        exec_request_run(exec, pl.values);
+        exec_update(tasks, graph, exec);
+
+        top_run_parallel(tasks, graph, taskData, topData, exec, pool);
+
+        ASSERT_EQ(exec.pipelinesRunning, 0);
+    }
+
+    ASSERT_EQ(top_get<int>(topData, sc_idChecks), sc_repetitions);
+}
+
+// Several independent sets of tasks sharing one pool, each running a different number of frames
+TEST(Tasks, TopRunParallelInstances)
+{
+    using namespace test_parallel;
+    using enum Stages;
+
+    constexpr std::size_t   sc_instanceCount    = 3;
+    constexpr TopDataId     sc_writerCount      = 8;
+    constexpr TopDataId     sc_idChecks         = sc_writerCount;
+
+    struct Instance
+    {
+        Tasks                   tasks;
+        TaskEdges               edges;
+        TopTaskDataVec_t        taskData;
+        TaskGraph               graph;
+        ExecContext             exec;
+        std::vector<entt::any>  topData;
+        PipelineId              values;
+        int                     frames{0};
+    };
+
+    std::array<Instance, sc_instanceCount> instances;
+    std::array<TopRunInstance, sc_instanceCount> runs;
+
+    for (std::size_t i = 0; i < sc_instanceCount; ++i)
+    {
+        Instance &rInst = instances[i];
+        TopTaskBuilder builder{rInst.tasks, rInst.edges, rInst.taskData};
+
+        auto const pl = builder.create_pipelines<Pipelines>();
+        rInst.values = pl.values;
+
+        rInst.topData.resize(sc_writerCount + 1);
+        top_emplace<int>(rInst.topData, sc_idChecks, 0);
+
+        std::vector<TopDataId> allIds;
+        for (TopDataId id = 0; id < sc_writerCount; ++id)
+        {
+            top_emplace<int>(rInst.topData, id, 0);
+            allIds.push_back(id);
+
+            builder.task()
+                .run_on(pl.values(Write))
+                .args({id})
+                .func([] (int &rValue) noexcept
+            {
+                ++ rValue;
+            });
+        }
+        allIds.push_back(sc_idChecks);
+
+        TaskId const checkTask = builder.task()
+            .run_on(pl.values(Check))
+            .func_raw([] (WorkerContext, ArrayView<entt::any> data) noexcept -> TaskActions
+        {
+            int &rChecks = entt::any_cast<int&>(data.back());
+            ++ rChecks;
+            for (entt::any &rValue : data.prefix(data.size() - 1))
+            {
+                EXPECT_EQ(entt::any_cast<int&>(rValue), rChecks);
+            }
+            return {};
+        });
+        rInst.taskData[checkTask].m_dataUsed = allIds;
+
+        rInst.graph = make_exec_graph(rInst.tasks, {&rInst.edges});
+        exec_conform(rInst.tasks, rInst.exec);
+        rInst.exec.doLogging = false;
+
+        // Each instance runs twice as many frames as the previous one
+        int const frameCount = 8 << i;
+
+        runs[i] = TopRunInstance{
+            .pTasks     = &rInst.tasks,
+            .pGraph     = &rInst.graph,
+            .pTaskData  = &rInst.taskData,
+            .topData    = rInst.topData,
+            .pExec      = &rInst.exec,
+            .onIdle     = [&rInst, frameCount] () -> bool
+        {
+            if (++ rInst.frames == frameCount)
+            {
+                return false;
+            }
+            exec_request_run(rInst.exec, rInst.values);
+            return true;
+        } };
+
+        exec_request_run(rInst.exec, rInst.values);
+        exec_update(rInst.tasks, rInst.graph, rInst.exec);
+    }
+
+    TopWorkerPool pool{4};
+
+    top_run_parallel({runs.data(), runs.size()}, pool);
+
+    for (std::size_t i = 0; i < sc_instanceCount; ++i)
+    {
+        Instance const &rInst = instances[i];
+        EXPECT_EQ(rInst.frames, 8 << i);
+        EXPECT_EQ(rInst.exec.pipelinesRunning, 0);
+        EXPECT_EQ(top_get<int>(rInst.topData, sc_idChecks), 8 << i);
+        EXPECT_EQ(runs[i].tasksRun, std::uint64_t(sc_writerCount + 1) * std::uint64_t(8 << i));
+    }
+}
+
+// Tasks using coordinator-only TopData run on the thread calling top_run_parallel
+TEST(Tasks, ParallelCoordinatorData)
+{
+    using namespace test_parallel;
+    using enum Stages;
+
+    constexpr TopDataId sc_taskCount = 16;
+
+    Tasks               tasks;
+    TaskEdges           edges;
+    TopTaskDataVec_t    taskData;
+    TopTaskBuilder      builder{tasks, edges, taskData};
+
+    auto const pl = builder.create_pipelines<Pipelines>();
+
+    std::vector<entt::any> topData(sc_taskCount);
+    std::vector<TopDataId> pinned;
+
+    for (TopDataId id = 0; id < sc_taskCount; ++id)
+    {
+        top_emplace<std::thread::id>(topData, id);
+        if (id % 2 == 0)
+        {
+            pinned.push_back(id);
+        }
+
+        builder.task()
+            .run_on(pl.values(Write))
+            .args({id})
+            .func([] (std::thread::id &rRanOn) noexcept
+        {
+            rRanOn = std::this_thread::get_id();
+        });
+    }
+
+    TaskGraph const graph = make_exec_graph(tasks, {&edges});
+
+    ExecContext exec;
+    exec_conform(tasks, exec);
+    exec.doLogging = false;
+
+    TopWorkerPool pool{4};
+
+    exec_request_run(exec, pl.values);
+    exec_update(tasks, graph, exec);
+
+    top_run_parallel(tasks, graph, taskData, topData, exec, pool, nullptr, {pinned.data(), pinned.size()});
+
+    ASSERT_EQ(exec.pipelinesRunning, 0);
+
+    for (TopDataId const id : pinned)
+    {
+        EXPECT_EQ(top_get<std::thread::id>(topData, id), std::this_thread::get_id());
+    }
+}
+
+// TopTaskAffinity routes tasks to the calling thread or to dedicated workers
+TEST(Tasks, ParallelAffinity)
+{
+    using namespace test_parallel;
+    using enum Stages;
+
+    constexpr TopDataId sc_taskCount = 18;
+
+    Tasks               tasks;
+    TaskEdges           edges;
+    TopTaskDataVec_t    taskData;
+    TopTaskBuilder      builder{tasks, edges, taskData};
+
+    auto const pl = builder.create_pipelines<Pipelines>();
+
+    struct RanOn
+    {
+        std::thread::id thread;
+        uint32_t        worker;
+    };
+
+    std::vector<entt::any> topData(sc_taskCount);
+
+    auto const affinity_of = [] (TopDataId const id) noexcept
+    {
+        return TopTaskAffinity(id % 3);
+    };
+
+    for (TopDataId id = 0; id < sc_taskCount; ++id)
+    {
+        top_emplace<RanOn>(topData, id);
+
+        builder.task()
+            .run_on(pl.values(Write))
+            .affinity(affinity_of(id))
+            .args({id})
+            .func([] (RanOn &rRanOn, WorkerContext ctx) noexcept
+        {
+            rRanOn = {std::this_thread::get_id(), ctx.m_workerIndex};
+        });
+    }
+
+    TaskGraph const graph = make_exec_graph(tasks, {&edges});
+
+    ExecContext exec;
+    exec_conform(tasks, exec);
+    exec.doLogging = false;
+
+    TopWorkerPool pool{2, {}, 1};
+    ASSERT_EQ(pool.thread_count(), 3u);
+    ASSERT_EQ(pool.dedicated_count(), 1u);
+
+    exec_request_run(exec, pl.values);
+    exec_update(tasks, graph, exec);
+
+    top_run_parallel(tasks, graph, taskData, topData, exec, pool);
+
+    ASSERT_EQ(exec.pipelinesRunning, 0);
+
+    for (TopDataId id = 0; id < sc_taskCount; ++id)
+    {
+        RanOn const &ranOn = top_get<RanOn>(topData, id);
+        switch (affinity_of(id))
+        {
+        case TopTaskAffinity::Any:
+            EXPECT_NE(ranOn.worker, 3u);
+            break;
+        case TopTaskAffinity::Main:
+            EXPECT_EQ(ranOn.thread, std::this_thread::get_id());
+            EXPECT_EQ(ranOn.worker, 0u);
+            break;
+        case TopTaskAffinity::Dedicated:
+            EXPECT_EQ(ranOn.worker, 3u); // Dedicated workers come last
+            break;
+        }
+    }
+}
+
+// Tasks get the WorkerLocal of whichever thread runs them, with scratch reset after each task
+TEST(Tasks, WorkerContextLocal)
+{
+    using namespace test_parallel;
+    using enum Stages;
+
+    constexpr TopDataId sc_taskCount    = 16;
+    constexpr int       sc_scratchSize  = 64;
+
+    Tasks               tasks;
+    TaskEdges           edges;
+    TopTaskDataVec_t    taskData;
+    TopTaskBuilder      builder{tasks, edges, taskData};
+
+    auto const pl = builder.create_pipelines<Pipelines>();
+
+    std::vector<entt::any> topData(sc_taskCount);
+
+    for (TopDataId id = 0; id < sc_taskCount; ++id)
+    {
+        top_emplace<uint32_t>(topData, id, ~uint32_t(0));
+
+        builder.task()
+            .run_on(pl.values(Write))
+            .args({id})
+            .func([] (uint32_t &rRanOn, WorkerContext ctx) noexcept
+        {
+            EXPECT_EQ(ctx.m_pLocal->scratch.used(), 0u);
+
+            ArrayView<int> const values = ctx.scratch<int>(sc_scratchSize);
+            std::iota(values.begin(), values.end(), 0);
+            EXPECT_EQ(std::accumulate(values.begin(), values.end(), 0), sc_scratchSize * (sc_scratchSize - 1) / 2);
+
+            ctx.counter_add("tasks");
+            ctx.log("ran");
+            rRanOn = ctx.m_workerIndex;
+        });
+    }
+
+    TaskGraph const graph = make_exec_graph(tasks, {&edges});
+
+    ExecContext exec;
+    exec_conform(tasks, exec);
+    exec.doLogging = false;
+
+    TopWorkerPool pool{4};
+
+    exec_request_run(exec, pl.values);
+    exec_update(tasks, graph, exec);
+
+    top_run_parallel(tasks, graph, taskData, topData, exec, pool);
+
+    ASSERT_EQ(exec.pipelinesRunning, 0);
+
+    std::size_t counted = 0;
+    std::size_t logged  = 0;
+    for (std::size_t i = 0; i <= pool.thread_count(); ++i)
+    {
+        WorkerLocal const &rLocal = pool.worker_local(i);
+        EXPECT_EQ(rLocal.scratch.used(), 0u);
+        counted += rLocal.metrics.size();
+        logged  += rLocal.logMsgs.size();
+    }
+    EXPECT_EQ(counted, sc_taskCount);
+    EXPECT_EQ(logged,  sc_taskCount);
+
+    for (TopDataId id = 0; id < sc_taskCount; ++id)
+    {
+        EXPECT_LE(top_get<uint32_t>(topData, id), pool.thread_count());
+    }
+}
+
+// Tasks splitting their loops with WorkerContext::m_parallelFor visit each element exactly once,
+// even while every worker is busy with another such task
+TEST(Tasks, WorkerParallelFor)
+{
+    using namespace test_parallel;
+    using enum Stages;
+
+    constexpr TopDataId     sc_taskCount    = 8;
+    constexpr std::size_t   sc_elements     = 10000;
+
+    Tasks               tasks;
+    TaskEdges           edges;
+    TopTaskDataVec_t    taskData;
+    TopTaskBuilder      builder{tasks, edges, taskData};
+
+    auto const pl = builder.create_pipelines<Pipelines>();
+
+    std::vector<entt::any> topData(sc_taskCount);
+
+    for (TopDataId id = 0; id < sc_taskCount; ++id)
+    {
+        top_emplace< std::vector<int> >(topData, id, sc_elements, 0);
+
+        builder.task()
+            .run_on(pl.values(Write))
+            .args({id})
+            .func([] (std::vector<int> &rVisited, WorkerContext ctx) noexcept
+        {
+            EXPECT_EQ(ctx.m_parallelFor.m_threads, 5u);
+            ctx.m_parallelFor(rVisited.size(), 16, [&rVisited] (std::size_t const first, std::size_t const last)
+            {
+                for (std::size_t i = first; i < last; ++i)
+                {
+                    ++ rVisited[i];
+                }
+            });
+        });
+    }
+
+    TaskGraph const graph = make_exec_graph(tasks, {&edges});
+
+    ExecContext exec;
+    exec_conform(tasks, exec);
+    exec.doLogging = false;
+
+    TopWorkerPool pool{4};
+
+    exec_request_run(exec, pl.values);
+    exec_update(tasks, graph, exec);
+
+    top_run_parallel(tasks, graph, taskData, topData, exec, pool);
+
+    ASSERT_EQ(exec.pipelinesRunning, 0);
+
+    for (TopDataId id = 0; id < sc_taskCount; ++id)
+    {
+        auto const &rVisited = top_get< std::vector<int> >(topData, id);
+        EXPECT_TRUE(std::all_of(rVisited.begin(), rVisited.end(), [] (int const count) { return count == 1; }));
+    }
+}
+
+// Pre-resolved task arguments follow TopData that gets re-emplaced between runs
+TEST(Tasks, TopTaskDispatch)
+{
+    using namespace test_parallel;
+    using enum Stages;
+
+    constexpr TopDataId sc_idValue  = 0;
+    constexpr TopDataId sc_idSum    = 1;
+
+    Tasks               tasks;
+    TaskEdges           edges;
+    TopTaskDataVec_t    taskData;
+    TopTaskBuilder      builder{tasks, edges, taskData};
+
+    auto const pl = builder.create_pipelines<Pipelines>();
+
+    std::vector<entt::any> topData(2);
+    top_emplace<int>(topData, sc_idValue, 1);
+    top_emplace<int>(topData, sc_idSum, 0);
+
+    builder.task()
+        .run_on(pl.values(Check))
+        .args({sc_idValue, sc_idSum})
+        .func([] (int const& value, int &rSum) noexcept
+    {
+        rSum += value;
+    });
+
+    TaskGraph const graph = make_exec_graph(tasks, {&edges});
+
+    ExecContext exec;
+    exec_conform(tasks, exec);
+
+    TopTaskDispatch dispatch;
+    top_dispatch_build(dispatch, taskData, topData);
+
+    auto const run = [&] ()
+    {
+        exec_request_run(exec, pl.values);
+        exec_update(tasks, graph, exec);
+        top_run_blocking(tasks, graph, taskData, dispatch, topData, exec);
+        ASSERT_EQ(exec.pipelinesRunning, 0);
+    };
+
+    run();
+    ASSERT_EQ(top_get<int>(topData, sc_idSum), 1);
+
+    // Re-emplace both, tasks must see the new objects
+    top_emplace<int>(topData, sc_idValue, 10);
+    top_emplace<int>(topData, sc_idSum, 100);
+
+    run();
+    ASSERT_EQ(top_get<int>(topData, sc_idSum), 110);
+
+    // Reallocating topData moves everything
+    topData.resize(256);
+
+    run();
+    ASSERT_EQ(top_get<int>(topData, sc_idSum), 120);
+}
+
+// Cheap tasks queued at the same time run with a single exec_update after all of them
+TEST(Tasks, CheapTaskBatch)
+{
+    using namespace test_parallel;
+    using enum Stages;
+
+    constexpr TopDataId sc_taskCount = 8;
+
+    auto const updates_needed = [] (bool const cheap) -> uint32_t
+    {
+        Tasks               tasks;
+        TaskEdges           edges;
+        TopTaskDataVec_t    taskData;
+        TopTaskBuilder      builder{tasks, edges, taskData};
+
+        auto const pl = builder.create_pipelines<Pipelines>();
+
+        std::vector<entt::any> topData(sc_taskCount);
+
+        for (TopDataId id = 0; id < sc_taskCount; ++id)
+        {
+            top_emplace<std::vector<int>>(topData, id, std::vector<int>{1, 2, 3});
+
+            builder.task()
+                .run_on(pl.values(Check))
+                .cheap(cheap)
+                .args({id})
+                .func([] (std::vector<int> &rVec) noexcept
+            {
+                rVec.clear();
+            });
+        }
+
+        TaskGraph const graph = make_exec_graph(tasks, {&edges});
+
+        ExecContext exec;
+        exec_conform(tasks, exec);
+        exec.doLogging = false;
+
+        TopTaskDispatch dispatch;
+        top_dispatch_build(dispatch, taskData, topData);
+
+        exec_request_run(exec, pl.values);
+        exec_update(tasks, graph, exec);
+
+        uint32_t const before = exec.stats.updates;
+        top_run_blocking(tasks, graph, taskData, dispatch, topData, exec);
+
+        EXPECT_EQ(exec.pipelinesRunning, 0);
+        for (TopDataId id = 0; id < sc_taskCount; ++id)
+        {
+            EXPECT_TRUE(top_get<std::vector<int>>(topData, id).empty());
+        }
+
+        return exec.stats.updates - before;
+    };
+
+    uint32_t const separate = updates_needed(false);
+    uint32_t const batched  = updates_needed(true);
+
+    EXPECT_EQ(separate - batched, sc_taskCount - 1);
+}
+
+// Ready tasks run by priority, then by TaskId, the same way every frame
+TEST(Tasks, TaskPriority)
+{
+    using namespace test_parallel;
+    using enum Stages;
+
+    Tasks               tasks;
+    TaskEdges           edges;
+    TopTaskDataVec_t    taskData;
+    TopTaskBuilder      builder{tasks, edges, taskData};
 
-// TODO: Multi-threaded test with limits. Actual multithreading isn't needed;
-//       as long as task_start/finish are called at the right times
+    auto const pl = builder.create_pipelines<Pipelines>();
+
+    std::vector<entt::any> topData(1);
+    auto &rOrder = top_emplace<std::vector<int>>(topData, 0);
+
+    std::array<int, 4> const priorities{0, 2, 0, 1};
+    for (int index = 0; index < int(priorities.size()); ++index)
+    {
+        builder.task()
+            .run_on(pl.values(Check))
+            .priority(priorities[std::size_t(index)])
+            .args({0})
+            .func([index] (std::vector<int> &rOrderIn) noexcept
+        {
+            rOrderIn.push_back(index);
+        });
+    }
+
+    TaskGraph const graph = make_exec_graph(tasks, {&edges});
+
+    ExecContext exec;
+    exec_conform(tasks, exec);
+    exec.doLogging = false;
+
+    TopTaskDispatch dispatch;
+    top_dispatch_build(dispatch, taskData, topData);
+
+    std::vector<int> const expected{1, 3, 0, 2};
+
+    for (int frame = 0; frame < 2; ++frame)
+    {
+        rOrder.clear();
+        exec_request_run(exec, pl.values);
+        exec_update(tasks, graph, exec);
+        top_run_blocking(tasks, graph, taskData, topData, exec);
+        EXPECT_EQ(rOrder, expected);
+
+        rOrder.clear();
+        exec_request_run(exec, pl.values);
+        exec_update(tasks, graph, exec);
+        top_run_blocking(tasks, graph, taskData, dispatch, topData, exec);
+        EXPECT_EQ(rOrder, expected);
+    }
+}
+
+// Task and stage timings recorded by top_run_parallel written as Chrome trace JSON
+TEST(Tasks, TopExecTrace)
+{
+    using namespace test_parallel;
+    using enum Stages;
+
+    Tasks               tasks;
+    TaskEdges           edges;
+    TopTaskDataVec_t    taskData;
+    TopTaskBuilder      builder{tasks, edges, taskData};
+
+    auto const pl = builder.create_pipelines<Pipelines>();
+    tasks.m_pipelineInfo[pl.values].name = "values";
+
+    std::vector<entt::any> topData(2);
+    top_emplace<int>(topData, 0, 0);
+    top_emplace<int>(topData, 1, 0);
+
+    builder.task()
+        .name("Write \"A\"")
+        .run_on(pl.values(Write))
+        .args({0})
+        .func([] (int &rValue) noexcept { ++rValue; });
+
+    builder.task()
+        .name("Check B")
+        .run_on(pl.values(Check))
+        .args({1})
+        .func([] (int &rValue) noexcept { ++rValue; });
+
+    TaskGraph const graph = make_exec_graph(tasks, {&edges});
+
+    ExecContext exec;
+    exec_conform(tasks, exec);
+
+    TopWorkerPool pool{2};
+    TopExecTrace  trace;
+
+    exec_request_run(exec, pl.values);
+    exec_update(tasks, graph, exec);
+    top_run_parallel(tasks, graph, taskData, topData, exec, pool, &trace);
+
+    ASSERT_EQ(trace.taskEvents.size(), 2u);
+    for (TopExecTrace::TaskEvent const& event : trace.taskEvents)
+    {
+        EXPECT_NE(event.thread, TopExecTrace::smc_coordinatorThread);
+        EXPECT_LE(event.start, event.end);
+    }
+    ASSERT_FALSE(trace.stageEvents.empty());
+
+    std::ostringstream stream;
+    stream << TopExecWriteChromeTrace{tasks, taskData, trace};
+    std::string const json = stream.str();
+
+    EXPECT_NE(json.find("\"traceEvents\""),     std::string::npos);
+    EXPECT_NE(json.find(R"("Write \"A\"")"),    std::string::npos);
+    EXPECT_NE(json.find("\"Check B\""),         std::string::npos);
+    EXPECT_NE(json.find("\"values\""),          std::string::npos);
+}
+
+// Critical path of recorded task timings, following dependencies from the TaskGraph
+TEST(Tasks, TopTraceCriticalPath)
+{
+    using namespace test_parallel;
+    using enum Stages;
+
+    Tasks               tasks;
+    TaskEdges           edges;
+    TopTaskDataVec_t    taskData;
+    TopTaskBuilder      builder{tasks, edges, taskData};
+
+    auto const plA = builder.create_pipelines<Pipelines>();
+    auto const plB = builder.create_pipelines<Pipelines>();
+
+    TaskId const write = builder.task().name("Write A").run_on(plA.values(Write)).func([] () noexcept { });
+    TaskId const check = builder.task().name("Check A").run_on(plA.values(Check)).func([] () noexcept { });
+    TaskId const other = builder.task().name("Write B").run_on(plB.values(Write)).func([] () noexcept { });
+
+    TaskGraph const graph = make_exec_graph(tasks, {&edges});
+
+    // Two frames of: "Write B" in parallel with "Write A" then "Check A"
+    TopExecTrace trace;
+    auto const at = [&trace] (int const ms) { return trace.origin + std::chrono::milliseconds(ms); };
+    for (int const frame : {0, 100})
+    {
+        top_trace_frame(trace);
+        top_trace_task(trace, write, 1, at(frame + 0), at(frame + 4));
+        top_trace_task(trace, other, 2, at(frame + 0), at(frame + 6));
+        top_trace_task(trace, check, 1, at(frame + 4), at(frame + 7));
+    }
+
+    TopTraceCriticalPath const path = top_trace_critical_path(tasks, graph, trace);
+
+    ASSERT_EQ(path.frames.size(), 2u);
+    for (TopTraceCriticalPath::Frame const& frame : path.frames)
+    {
+        EXPECT_DOUBLE_EQ(frame.workMs, 13.0);
+        EXPECT_DOUBLE_EQ(frame.pathMs, 7.0);
+        EXPECT_DOUBLE_EQ(frame.wallMs, 7.0);
+        EXPECT_EQ(frame.taskCount, 3u);
+    }
+    EXPECT_DOUBLE_EQ(path.taskPathMs[write], 8.0);
+    EXPECT_DOUBLE_EQ(path.taskPathMs[check], 6.0);
+    EXPECT_DOUBLE_EQ(path.taskPathMs[other], 0.0);
+    EXPECT_DOUBLE_EQ(path.taskWorkMs[other], 12.0);
+
+    EXPECT_EQ(top_trace_critical_path(tasks, graph, trace, 1).frames.size(), 1u);
+
+    KeyedVec<TaskId, uint32_t> taskGroup;
+    taskGroup.resize(tasks.m_taskIds.capacity(), ~uint32_t(0));
+    taskGroup[write] = 0;
+    taskGroup[check] = 0;
+    std::vector<std::string> const groupNames{"groupA"};
+
+    std::ostringstream stream;
+    stream << TopExecWriteCriticalPath{taskData, path, taskGroup, groupNames};
+    std::string const report = stream.str();
+
+    EXPECT_NE(report.find("groupA"),    std::string::npos);
+    EXPECT_NE(report.find("Write A"),   std::string::npos);
+    EXPECT_EQ(report.find("Write B"),   std::string::npos);
+    EXPECT_LT(report.find("groupA"),    report.find("other"));
+}
+
+// Rebuild a TaskGraph into the same storage as a Session's tasks are added and removed
+TEST(Tasks, RebuildGraphInPlace)
+{
+    using namespace test_parallel;
+    using enum Stages;
+
+    constexpr TopDataId sc_idCountA = 0;
+    constexpr TopDataId sc_idCountB = 1;
+
+    Tasks               tasks;
+    TopTaskDataVec_t    taskData;
+    SessionGroup        group;
+    TopTaskBuilder      builder{tasks, group.m_edges, taskData};
+
+    std::vector<entt::any> topData(2);
+    top_emplace<int>(topData, sc_idCountA, 0);
+    top_emplace<int>(topData, sc_idCountB, 0);
+
+    Session &rSessionA = group.m_sessions.emplace_back();
+    auto const plA = rSessionA.create_pipelines<Pipelines>(builder);
+    builder.task()
+        .run_on(plA.values(Write))
+        .args({sc_idCountA})
+        .func([] (int &rCount) noexcept { ++rCount; })
+        .push_to(rSessionA.m_tasks);
+
+    TaskGraph   graph;
+    ExecContext exec;
+
+    auto const run_all = [&] (std::initializer_list<PipelineId> pipelines)
+    {
+        for (PipelineId const pipeline : pipelines)
+        {
+            exec_request_run(exec, pipeline);
+        }
+        exec_update(tasks, graph, exec);
+        top_run_blocking(tasks, graph, taskData, topData, exec);
+        ASSERT_EQ(exec.pipelinesRunning, 0);
+    };
+
+    rebuild_exec_graph(tasks, {&group.m_edges}, graph);
+    exec_conform(tasks, exec);
+    run_all({plA.values});
+    ASSERT_EQ(top_get<int>(topData, sc_idCountA), 1);
+
+    // Add a session that syncs with the first
+    Session &rSessionB = group.m_sessions.emplace_back();
+    auto const plB = rSessionB.create_pipelines<Pipelines>(builder);
+    builder.task()
+        .run_on(plB.values(Write))
+        .sync_with({plA.values(Check)})
+        .args({sc_idCountB})
+        .func([] (int &rCount) noexcept { ++rCount; })
+        .push_to(rSessionB.m_tasks);
+
+    rebuild_exec_graph(tasks, {&group.m_edges}, graph);
+    exec_conform(tasks, exec);
+    run_all({plA.values, plB.values});
+    ASSERT_EQ(top_get<int>(topData, sc_idCountA), 2);
+    ASSERT_EQ(top_get<int>(topData, sc_idCountB), 1);
+
+    // Remove the second session
+    session_remove_edges(group.m_edges, group.m_sessions[1]);
+    for (TaskId const task : group.m_sessions[1].m_tasks)
+    {
+        tasks.m_taskIds.remove(task);
+        taskData[task] = {};
+    }
+    for (PipelineId const pipeline : group.m_sessions[1].m_pipelines)
+    {
+        tasks.m_pipelineIds.remove(pipeline);
+        tasks.m_pipelineInfo[pipeline]    = {};
+        tasks.m_pipelineControl[pipeline] = {};
+    }
+    ASSERT_TRUE(group.m_edges.m_syncWith.empty());
+
+    rebuild_exec_graph(tasks, {&group.m_edges}, graph);
+    exec_conform(tasks, exec);
+    run_all({plA.values});
+    ASSERT_EQ(top_get<int>(topData, sc_idCountA), 3);
+    ASSERT_EQ(top_get<int>(topData, sc_idCountB), 1);
+
+    // Same as building from scratch
+    TaskGraph const fresh = make_exec_graph(tasks, {&group.m_edges});
+    EXPECT_EQ(graph.runtaskToTask,      fresh.runtaskToTask);
+    EXPECT_EQ(graph.anystgToPipeline,   fresh.anystgToPipeline);
+    EXPECT_EQ(graph.pltreeToPipeline,   fresh.pltreeToPipeline);
+}
+
+// Access modes inferred from task function parameters, and conflicts between tasks
+TEST(Tasks, TopTaskAccess)
+{
+    using namespace test_parallel;
+    using enum Stages;
+
+    Tasks               tasks;
+    TaskEdges           edges;
+    TopTaskDataVec_t    taskData;
+    TopTaskBuilder      builder{tasks, edges, taskData};
+
+    auto const pl = builder.create_pipelines<Pipelines>();
+
+    constexpr TopDataId idA = 0;
+    constexpr TopDataId idB = 1;
+
+    TaskId const readA = builder.task()
+        .run_on(pl.values(Write))
+        .args({idA, idB})
+        .func([] (int const& a, int b) noexcept { });
+
+    TaskId const readA2 = builder.task()
+        .run_on(pl.values(Write))
+        .args({idA})
+        .func([] (int const& a) noexcept { });
+
+    TaskId const writeA = builder.task()
+        .run_on(pl.values(Write))
+        .args({idA})
+        .func([] (int& a) noexcept { });
+
+    // Explicit access, no inference possible
+    TaskId const rawWriteB = builder.task()
+        .run_on(pl.values(Write))
+        .args({TopDataUse{idB, TopDataAccess::Write}})
+        .func_raw([] (WorkerContext, ArrayView<entt::any>) noexcept -> TaskActions { return {}; });
+
+    // No access given at all, assumed to write
+    TaskId const rawUnknownB = builder.task()
+        .run_on(pl.values(Write))
+        .args({idB})
+        .func_raw([] (WorkerContext, ArrayView<entt::any>) noexcept -> TaskActions { return {}; });
+
+    EXPECT_EQ(top_data_access(taskData[readA],  0), TopDataAccess::Read);
+    EXPECT_EQ(top_data_access(taskData[readA],  1), TopDataAccess::Read);
+    EXPECT_EQ(top_data_access(taskData[writeA], 0), TopDataAccess::Write);
+    EXPECT_EQ(top_data_access(taskData[rawUnknownB], 0), TopDataAccess::Write);
+
+    EXPECT_FALSE(top_tasks_conflict(taskData[readA],  taskData[readA2]));
+    EXPECT_TRUE (top_tasks_conflict(taskData[readA],  taskData[writeA]));
+    EXPECT_FALSE(top_tasks_conflict(taskData[writeA], taskData[rawWriteB]));
+    EXPECT_TRUE (top_tasks_conflict(taskData[readA],  taskData[rawWriteB]));
+    EXPECT_TRUE (top_tasks_conflict(taskData[rawWriteB], taskData[rawUnknownB]));
+}
+
+// ExecLog keeps only the newest messages once full
+TEST(Tasks, ExecLogRingBuffer)
+{
+    RingBuffer<int> ring{4};
+
+    for (int i = 0; i < 10; ++i)
+    {
+        ring.push_back(i);
+    }
+
+    ASSERT_EQ(ring.size(), 4u);
+    ASSERT_EQ(ring.dropped(), 6u);
+    ASSERT_TRUE(std::equal(ring.begin(), ring.end(), std::begin({6, 7, 8, 9})));
+
+    ring.clear();
+    ASSERT_TRUE(ring.empty());
+    ring.push_back(42);
+    ASSERT_EQ(*ring.begin(), 42);
+
+    ExecContext exec;
+    exec.logMsg.set_capacity(2);
+    exec.logMsg.push_back(ExecContext::UpdateStart{});
+    exec.logMsg.push_back(ExecContext::UpdateCycle{});
+    exec.logMsg.push_back(ExecContext::UpdateEnd{});
+    ASSERT_EQ(exec.logMsg.size(), 2u);
+    ASSERT_TRUE(std::holds_alternative<ExecContext::UpdateCycle>(*exec.logMsg.begin()));
+}
+
+//-----------------------------------------------------------------------------
+
+// Test that Semaphores limit how many tasks can run at once. Actual multithreading isn't needed;
+// tasks are 'running' from when they're queued to run until complete_task is called.
+TEST(Tasks, SemaphoreLimits)
+{
+    using namespace test_a;
+    using enum Stages;
+
+    using BasicTraits_t     = BasicBuilderTraits<TaskActions(*)(int&)>;
+    using Builder_t         = BasicTraits_t::Builder;
+    using TaskFuncVec_t     = BasicTraits_t::FuncVec_t;
+
+    constexpr int           sc_repetitions  = 32;
+    constexpr int           sc_taskCount    = 20;
+    constexpr unsigned int  sc_limit        = 3;
+    std::mt19937 randGen(69);
+
+    Tasks           tasks;
+    TaskEdges       edges;
+    TaskFuncVec_t   functions;
+    Builder_t       builder{tasks, edges, functions};
+    auto pl = builder.create_pipelines<Pipelines>();
+
+    SemaphoreId const sema = builder.create_semaphore(sc_limit);
+
+    for (int i = 0; i < sc_taskCount; ++i)
+    {
+        builder.task()
+            .run_on  (pl.vec(Fill))
+            .acquire ({sema})
+            .func( [] (int &rCount) -> TaskActions
+        {
+            ++rCount;
+            return {};
+        });
+    }
+
+    TaskGraph const graph = make_exec_graph(tasks, {&edges});
+
+    ExecContext exec;
+    exec_conform(tasks, exec);
+
+    for (int i = 0; i < sc_repetitions; ++i)
+    {
+        int             count       = 0;
+        std::size_t     maxRunning  = 0;
+
+        exec_request_run(exec, pl.vec);
+        exec_update(tasks, graph, exec);
+
+        while (exec.tasksQueuedRun.size() + exec.tasksQueuedSema.size() != 0)
+        {
+            std::size_t const running = exec.tasksQueuedRun.size();
+            ASSERT_LE(running, sc_limit);
+            ASSERT_EQ(exec.semaAcquired[sema], running);
+            maxRunning = std::max(maxRunning, running);
+
+            ASSERT_NE(running, 0) << "Deadlock, tasks are waiting on a semaphore nobody holds";
+
+            TaskId const task = exec.tasksQueuedRun[randGen() % running];
+            complete_task(tasks, graph, exec, task, functions[task](count));
+            exec_update(tasks, graph, exec);
+        }
+
+        ASSERT_EQ(count, sc_taskCount);
+        ASSERT_EQ(maxRunning, sc_limit);
+        ASSERT_EQ(exec.semaAcquired[sema], 0);
+    }
+}
+
+// Coroutine task spread over multiple calls to top_run_blocking, holding its pipeline's stage
+TEST(Tasks, TopCoroYieldAcrossFrames)
+{
+    using namespace test_parallel;
+    using enum Stages;
+
+    constexpr TopDataId sc_idSteps   = 0;
+    constexpr TopDataId sc_idChecked = 1;
+    constexpr TopDataId sc_idFrames  = 2;
+    constexpr int       sc_yields    = 3;
+
+    Tasks               tasks;
+    TaskEdges           edges;
+    TopTaskDataVec_t    taskData;
+    TopTaskBuilder      builder{tasks, edges, taskData};
+
+    auto const slow  = builder.create_pipelines<Pipelines>();
+    auto const frame = builder.create_pipelines<Pipelines>();
+
+    std::vector<entt::any> topData(3);
+    top_emplace<int>(topData, sc_idSteps,   0);
+    top_emplace<int>(topData, sc_idChecked, -1);
+    top_emplace<int>(topData, sc_idFrames,  0);
+
+    builder.task()
+        .run_on(slow.values(Write))
+        .args({sc_idSteps})
+        .coro([] (int &rSteps) noexcept -> TopCoro
+    {
+        for (int i = 0; i < sc_yields; ++i)
+        {
+            ++rSteps;
+            co_await top_yield();
+        }
+        ++rSteps;
+        co_return TaskActions{};
+    });
+
+    builder.task()
+        .run_on(slow.values(Check))
+        .args({sc_idSteps, sc_idChecked})
+        .func([] (int const& steps, int &rChecked) noexcept
+    {
+        rChecked = steps;
+    });
+
+    builder.task()
+        .run_on(frame.values(Write))
+        .args({sc_idFrames})
+        .func([] (int &rFrames) noexcept
+    {
+        ++rFrames;
+    });
+
+    TaskGraph const graph = make_exec_graph(tasks, {&edges});
+
+    ExecContext exec;
+    exec_conform(tasks, exec);
+
+    TopTaskDispatch dispatch;
+    top_dispatch_build(dispatch, taskData, topData);
+
+    exec_request_run(exec, slow.values);
+
+    for (int i = 0; i < sc_yields; ++i)
+    {
+        exec_request_run(exec, frame.values);
+        exec_update(tasks, graph, exec);
+        top_run_blocking(tasks, graph, taskData, dispatch, topData, exec);
+
+        // Coroutine ran once per frame, Check stage is not reached yet
+        ASSERT_EQ(top_get<int>(topData, sc_idSteps),    i + 1);
+        ASSERT_EQ(top_get<int>(topData, sc_idChecked),  -1);
+        ASSERT_EQ(top_get<int>(topData, sc_idFrames),   i + 1);
+        ASSERT_TRUE(exec.plData[slow.values].running);
+        ASSERT_FALSE(exec.plData[frame.values].running);
+    }
+
+    // No time left for coroutines, but other tasks still run
+    dispatch.coroBudget = {};
+    exec_request_run(exec, frame.values);
+    exec_update(tasks, graph, exec);
+    top_run_blocking(tasks, graph, taskData, dispatch, topData, exec);
+    ASSERT_EQ(top_get<int>(topData, sc_idSteps),    sc_yields);
+    ASSERT_EQ(top_get<int>(topData, sc_idFrames),   sc_yields + 1);
+
+    dispatch.coroBudget = std::chrono::milliseconds{4};
+    top_run_blocking(tasks, graph, taskData, dispatch, topData, exec);
+    ASSERT_EQ(top_get<int>(topData, sc_idSteps),    sc_yields + 1);
+    ASSERT_EQ(top_get<int>(topData, sc_idChecked),  sc_yields + 1);
+    ASSERT_EQ(exec.pipelinesRunning, 0);
+    ASSERT_FALSE(dispatch.coroutines[TaskId(0)].has_value());
+}
+
+// Same as above, but resumed by top_run_parallel while other tasks run on workers
+TEST(Tasks, TopCoroParallel)
+{
+    using namespace test_parallel;
+    using enum Stages;
+
+    constexpr TopDataId sc_idSteps   = 0;
+    constexpr TopDataId sc_idChecked = 1;
+    constexpr TopDataId sc_idFrames  = 2;
+    constexpr int       sc_yields    = 3;
+
+    Tasks               tasks;
+    TaskEdges           edges;
+    TopTaskDataVec_t    taskData;
+    TopTaskBuilder      builder{tasks, edges, taskData};
+
+    auto const slow  = builder.create_pipelines<Pipelines>();
+    auto const frame = builder.create_pipelines<Pipelines>();
+
+    std::vector<entt::any> topData(3);
+    top_emplace<int>(topData, sc_idSteps,   0);
+    top_emplace<int>(topData, sc_idChecked, -1);
+    top_emplace<int>(topData, sc_idFrames,  0);
+
+    builder.task()
+        .run_on(slow.values(Write))
+        .args({sc_idSteps})
+        .coro([] (int &rSteps) noexcept -> TopCoro
+    {
+        for (int i = 0; i < sc_yields; ++i)
+        {
+            ++rSteps;
+            co_await top_yield();
+        }
+        ++rSteps;
+        co_return TaskActions{};
+    });
+
+    builder.task()
+        .run_on(slow.values(Check))
+        .args({sc_idSteps, sc_idChecked})
+        .func([] (int const& steps, int &rChecked) noexcept
+    {
+        rChecked = steps;
+    });
+
+    builder.task()
+        .run_on(frame.values(Write))
+        .args({sc_idFrames})
+        .func([] (int &rFrames) noexcept
+    {
+        ++rFrames;
+    });
+
+    TaskGraph const graph = make_exec_graph(tasks, {&edges});
+
+    ExecContext exec;
+    exec_conform(tasks, exec);
+
+    TopTaskDispatch dispatch;
+    top_dispatch_build(dispatch, taskData, topData);
+
+    TopWorkerPool pool{2};
+
+    exec_request_run(exec, slow.values);
+
+    for (int i = 0; i < sc_yields; ++i)
+    {
+        exec_request_run(exec, frame.values);
+        exec_update(tasks, graph, exec);
+        top_run_parallel(tasks, graph, taskData, topData, exec, pool, nullptr, {}, &dispatch);
+
+        ASSERT_EQ(top_get<int>(topData, sc_idSteps),    i + 1);
+        ASSERT_EQ(top_get<int>(topData, sc_idChecked),  -1);
+        ASSERT_EQ(top_get<int>(topData, sc_idFrames),   i + 1);
+        ASSERT_TRUE(exec.plData[slow.values].running);
+        ASSERT_FALSE(exec.plData[frame.values].running);
+    }
+
+    top_run_parallel(tasks, graph, taskData, topData, exec, pool, nullptr, {}, &dispatch);
+    ASSERT_EQ(top_get<int>(topData, sc_idSteps),    sc_yields + 1);
+    ASSERT_EQ(top_get<int>(topData, sc_idChecked),  sc_yields + 1);
+    ASSERT_EQ(exec.pipelinesRunning, 0);
+    ASSERT_FALSE(dispatch.coroutines[TaskId(0)].has_value());
+}
+
+//-----------------------------------------------------------------------------
+
+namespace test_static
+{
+
+enum class Stages { Fill, Use, Clear };
+
+OSP_DECLARE_STAGE_NAMES(Stages, "Fill", "Use", "Clear");
+OSP_DECLARE_STAGE_NO_SCHEDULE(Stages);
+
+constexpr StaticPl<Stages> sc_plVec     {0};
+constexpr StaticPl<Stages> sc_plResult  {1};
+
+// Two pushers fill vec, a task sums it into result, then result is checked and vec is cleared
+constexpr StaticTaskGraph<2, 0, 5, 1> sc_graph
+{
+    .pipelines  = {{ static_pipeline<Stages>("vec"), static_pipeline<Stages>("result") }},
+    .tasks      = {{ {.runOn = sc_plVec(Stages::Fill)},
+                     {.runOn = sc_plVec(Stages::Fill)},
+                     {.runOn = sc_plVec(Stages::Use)},
+                     {.runOn = sc_plResult(Stages::Use)},
+                     {.runOn = sc_plVec(Stages::Clear)} }},
+    .syncWith   = {{ {.task = 2, .with = sc_plResult(Stages::Fill)} }}
+};
+
+static_assert(check_static_graph(sc_graph).error == EStaticGraphError::None);
+
+constexpr StaticGraphCheck sc_badStage = [] ()
+{
+    auto graph = sc_graph;
+    graph.syncWith[0].with.stage = StageId(3);
+    return check_static_graph(graph);
+}();
+static_assert(sc_badStage.error == EStaticGraphError::BadStage && sc_badStage.index == 0);
+
+constexpr StaticGraphCheck sc_cycle = [] ()
+{
+    auto graph = sc_graph;
+    graph.pipelines[0].parent = 1;
+    graph.pipelines[1].parent = 0;
+    return check_static_graph(graph);
+}();
+static_assert(sc_cycle.error == EStaticGraphError::ParentCycle);
+
+constexpr StaticGraphCheck sc_noScheduler = [] ()
+{
+    auto graph = sc_graph;
+    graph.pipelines[1].runEvery = 4;
+    return check_static_graph(graph);
+}();
+static_assert(sc_noScheduler.error == EStaticGraphError::NoScheduler && sc_noScheduler.index == 1);
+
+} // namespace test_static
+
+// Test tasks described by a constexpr StaticTaskGraph, with functions added afterwards
+TEST(Tasks, StaticTaskGraph)
+{
+    using namespace test_static;
+
+    using BasicTraits_t     = BasicBuilderTraits<TaskActions(*)(std::vector<int>&, int&, int&)>;
+    using Builder_t         = BasicTraits_t::Builder;
+    using TaskFuncVec_t     = BasicTraits_t::FuncVec_t;
+
+    constexpr int sc_repetitions = 16;
+    std::mt19937 randGen(69);
+
+    Tasks           tasks;
+    TaskEdges       edges;
+    TaskFuncVec_t   functions;
+    Builder_t       builder{tasks, edges, functions};
+
+    auto const ids = instantiate_static_graph(sc_graph, tasks, edges);
+
+    ASSERT_EQ(edges.m_syncWith.size(), 1u);
+    ASSERT_EQ(tasks.m_pipelineInfo[ids.pipelines[1]].name, "result");
+    ASSERT_EQ(tasks.m_taskRunOn[ids.tasks[3]].pipeline, ids.pipelines[1]);
+
+    auto const push = [] (std::vector<int>& rVec, int& rResult, int& rChecks) -> TaskActions
+    {
+        rVec.push_back(int(rVec.size()) + 1);
+        return {};
+    };
+    builder.task(ids.tasks[0]).func(push);
+    builder.task(ids.tasks[1]).func(push);
+    builder.task(ids.tasks[2]).func([] (std::vector<int>& rVec, int& rResult, int& rChecks) -> TaskActions
+    {
+        rResult = std::accumulate(rVec.begin(), rVec.end(), 0);
+        return {};
+    });
+    builder.task(ids.tasks[3]).func([] (std::vector<int>& rVec, int& rResult, int& rChecks) -> TaskActions
+    {
+        EXPECT_EQ(rResult, 1 + 2);
+        ++rChecks;
+        return {};
+    });
+    builder.task(ids.tasks[4]).func([] (std::vector<int>& rVec, int& rResult, int& rChecks) -> TaskActions
+    {
+        rVec.clear();
+        return {};
+    });
+
+    TaskGraph const graph = make_exec_graph(tasks, {&edges});
+
+    ExecContext exec;
+    exec_conform(tasks, exec);
+
+    std::vector<int>    vec;
+    int                 result = 0;
+    int                 checks = 0;
+
+    for (int i = 0; i < sc_repetitions; ++i)
+    {
+        result = 0;
+
+        exec_request_run(exec, ids.pipelines[0]);
+        exec_request_run(exec, ids.pipelines[1]);
+        exec_update(tasks, graph, exec);
+
+        randomized_singlethreaded_execute(tasks, graph, exec, randGen, 16, [&] (TaskId const task) -> TaskActions
+        {
+            return functions[task](vec, result, checks);
+        });
+    }
+
+    ASSERT_EQ(checks, sc_repetitions);
+}
+
+//-----------------------------------------------------------------------------
+
+namespace test_rate
+{
+
+struct TestState
+{
+    int     schedules   { 0 };
+    int     runs        { 0 };
+    bool    allow       { true };
+};
+
+enum class Stages { Schedule, Run, Done };
+
+OSP_DECLARE_STAGE_NAMES(Stages, "Schedule", "Run", "Done");
+OSP_DECLARE_STAGE_SCHEDULE(Stages, Stages::Schedule);
+
+struct Pipelines
+{
+    osp::PipelineDef<Stages> frame;
+    osp::PipelineDef<Stages> lowPriority;
+};
+
+} // namespace test_rate
+
+// Test a child pipeline that only runs once every few times its scheduler allows it to
+TEST(Tasks, PipelineRunEvery)
+{
+    using namespace test_rate;
+    using enum Stages;
+
+    using BasicTraits_t     = BasicBuilderTraits<TaskActions(*)(TestState&)>;
+    using Builder_t         = BasicTraits_t::Builder;
+    using TaskFuncVec_t     = BasicTraits_t::FuncVec_t;
+
+    std::mt19937 randGen(69);
+
+    Tasks           tasks;
+    TaskEdges       edges;
+    TaskFuncVec_t   functions;
+    Builder_t       builder{tasks, edges, functions};
+
+    auto const pl = builder.create_pipelines<Pipelines>();
+
+    builder.pipeline(pl.lowPriority).parent(pl.frame).run_every(3);
+
+    builder.task()
+        .schedules  ({pl.lowPriority(Schedule)})
+        .func( [] (TestState& rState) -> TaskActions
+    {
+        ++ rState.schedules;
+        return rState.allow ? TaskActions{} : TaskAction::Cancel;
+    });
+
+    builder.task()
+        .run_on     ({pl.lowPriority(Run)})
+        .func( [] (TestState& rState) -> TaskActions
+    {
+        ++ rState.runs;
+        return {};
+    });
+
+    // Only waits for lowPriority to finish or be canceled
+    builder.task()
+        .run_on     ({pl.frame(Done)})
+        .sync_with  ({pl.lowPriority(Done)})
+        .func( [] (TestState&) -> TaskActions
+    {
+        return {};
+    });
+
+    TaskGraph const graph = make_exec_graph(tasks, {&edges});
+
+    ExecContext exec;
+    exec_conform(tasks, exec);
+
+    TestState world;
+
+    auto const run_frames = [&] (int const count)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            exec_request_run(exec, pl.frame);
+            exec_update(tasks, graph, exec);
+
+            randomized_singlethreaded_execute(tasks, graph, exec, randGen, 10, [&] (TaskId const task) -> TaskActions
+            {
+                return functions[task](world);
+            });
+
+            ASSERT_FALSE(exec.plData[pl.frame].running);
+        }
+    };
+
+    // First run goes through, then every 3rd
+    run_frames(7);
+    EXPECT_EQ(world.schedules, 7);
+    EXPECT_EQ(world.runs, 3);
+
+    // Runs canceled by the scheduler itself don't count
+    world.allow = false;
+    run_frames(5);
+    EXPECT_EQ(world.runs, 3);
+
+    world.allow = true;
+    run_frames(2);
+    EXPECT_EQ(world.runs, 3);
+    run_frames(1);
+    EXPECT_EQ(world.runs, 4);
+
+    // Change the rate while running; lowering it also shortens skips already counted
+    exec_set_run_every(exec, pl.lowPriority, 10);
+    run_frames(1);
+    EXPECT_EQ(world.runs, 4);
+    exec_set_run_every(exec, pl.lowPriority, 1);
+    run_frames(4);
+    EXPECT_EQ(world.runs, 8);
+}
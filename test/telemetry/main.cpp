@@ -0,0 +1,190 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <osp/link/telemetry.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using osp::link::SignalTelemetry;
+using osp::link::SignalValues_t;
+using osp::link::TelemetryColumn;
+using osp::link::TelemetryHeader;
+
+namespace
+{
+
+template <typename VALUE_T>
+VALUE_T value_at(std::vector<unsigned char> const& block, TelemetryColumn const& column,
+                 std::uint64_t const frame, std::uint32_t const index)
+{
+    auto const &header = *reinterpret_cast<TelemetryHeader const*>(block.data());
+    std::size_t const slot   = std::size_t(frame % header.frameCapacity);
+    std::size_t const offset = column.dataOffset + (slot * column.nodeCount + index) * sizeof(VALUE_T);
+
+    VALUE_T out;
+    std::memcpy(&out, block.data() + offset, sizeof(VALUE_T));
+    return out;
+}
+
+} // namespace
+
+// Consecutive nodes of the same type are merged into one column
+TEST(Telemetry, MergesColumns)
+{
+    SignalTelemetry telemetry;
+    for (osp::link::NodeId const node : {7u, 2u, 3u, 4u, 3u, 9u})
+    {
+        telemetry.select<float>(node);
+    }
+    telemetry.select<std::int32_t>(5);
+
+    EXPECT_EQ(telemetry.allocate(4), osp::link::ETelemetryExport::Private);
+
+    auto const &columns = telemetry.columns();
+    ASSERT_EQ(columns.size(), 4);
+    EXPECT_EQ(columns[0].firstNode, 2);
+    EXPECT_EQ(columns[0].nodeCount, 3);
+    EXPECT_EQ(columns[1].firstNode, 7);
+    EXPECT_EQ(columns[2].firstNode, 9);
+
+    // Columns of one type are sorted together, but type order depends on registration
+    bool const intColumnLast = columns[3].nodeType == osp::link::gc_ntSigInt;
+    EXPECT_TRUE(intColumnLast || columns[0].nodeType == osp::link::gc_ntSigInt);
+}
+
+// Old frames are overwritten once frameCapacity is reached
+TEST(Telemetry, RingBuffer)
+{
+    SignalTelemetry telemetry;
+    telemetry.select<float>(1);
+    telemetry.select<float>(2);
+    telemetry.allocate(3);
+
+    SignalValues_t<float> values(4, 0.0f);
+    for (int frame = 0; frame < 5; ++frame)
+    {
+        values[1] = float(frame);
+        values[2] = float(frame) * 10.0f;
+
+        telemetry.begin_frame(double(frame) * 0.5);
+        telemetry.record(values);
+        telemetry.end_frame();
+    }
+
+    std::vector<unsigned char> copy;
+    ASSERT_TRUE(osp::link::telemetry_copy(telemetry.block(), copy));
+
+    auto const &header = *reinterpret_cast<TelemetryHeader const*>(copy.data());
+    EXPECT_EQ(header.frameCount, 5);
+    EXPECT_EQ(header.sequence.load(), 10);
+
+    TelemetryColumn const &column = telemetry.columns().at(0);
+
+    TelemetryColumn timeColumn{};
+    timeColumn.nodeCount  = 1;
+    timeColumn.dataOffset = header.timeOffset;
+
+    for (std::uint64_t frame = 2; frame < 5; ++frame)
+    {
+        EXPECT_EQ(value_at<float>(copy, column, frame, 0), float(frame));
+        EXPECT_EQ(value_at<float>(copy, column, frame, 1), float(frame) * 10.0f);
+        EXPECT_EQ(value_at<double>(copy, timeColumn, frame, 0), double(frame) * 0.5);
+    }
+}
+
+// Readers in another thread never see a half-written frame
+TEST(Telemetry, ConcurrentReader)
+{
+    SignalTelemetry telemetry;
+    for (osp::link::NodeId node = 0; node < 64; ++node)
+    {
+        telemetry.select<float>(node);
+    }
+    telemetry.allocate(2);
+
+    std::atomic<bool> done{false};
+    std::thread writer([&telemetry, &done] ()
+    {
+        SignalValues_t<float> values(64);
+        for (int frame = 0; frame < 20000; ++frame)
+        {
+            std::fill(values.begin(), values.end(), float(frame));
+            telemetry.begin_frame(double(frame));
+            telemetry.record(values);
+            telemetry.end_frame();
+        }
+        done = true;
+    });
+
+    TelemetryColumn const column = telemetry.columns().at(0);
+    std::vector<unsigned char> copy;
+    while ( ! done )
+    {
+        if ( ! osp::link::telemetry_copy(telemetry.block(), copy) )
+        {
+            continue;
+        }
+        auto const &header = *reinterpret_cast<TelemetryHeader const*>(copy.data());
+        if (header.frameCount == 0)
+        {
+            continue;
+        }
+        std::uint64_t const latest = header.frameCount - 1;
+        for (std::uint32_t i = 0; i < 64; ++i)
+        {
+            ASSERT_EQ(value_at<float>(copy, column, latest, i), float(latest));
+        }
+    }
+
+    writer.join();
+}
+
+#if defined(__linux__) || defined(__APPLE__)
+
+TEST(Telemetry, SharedMemory)
+{
+    SignalTelemetry telemetry;
+    telemetry.select<float>(0);
+
+    if (telemetry.allocate(8, "/osp_test_telemetry") != osp::link::ETelemetryExport::Shared)
+    {
+        GTEST_SKIP() << "Shared memory not available";
+    }
+    EXPECT_TRUE(telemetry.is_shared());
+
+    SignalValues_t<float> const values{42.0f};
+    telemetry.begin_frame(1.0);
+    telemetry.record(values);
+    telemetry.end_frame();
+
+    std::vector<unsigned char> copy;
+    ASSERT_TRUE(osp::link::telemetry_copy(telemetry.block(), copy));
+    EXPECT_EQ(value_at<float>(copy, telemetry.columns().at(0), 0, 0), 42.0f);
+}
+
+#endif
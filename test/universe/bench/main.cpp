@@ -0,0 +1,297 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Benchmark of coordinate transforms and iterating satellite data. Writes CSV.
+//
+// Usage: osp-bench-universe [output.csv] [--sats N,N,...] [--transform-sats N] [--reps N]
+//
+//   --sats N,...           Satellite counts for the layout cases (default: 10000,100000,1000000)
+//   --transform-sats N     Satellite count for the transform cases (default: 100000)
+//   --reps N               Repetitions of each measurement, the median is written (default: 21)
+//
+// Transform cases are run with child precision 4 coarser, equal, and 5 finer than the parent,
+// with and without rotation. Times are in microseconds for all satellites:
+//   scalar         One CoordTransformer::transform_position call per satellite
+//   batch          coord_transform_positions over whole columns
+//   iterateSoA     Integrating positions by velocity through sat_views, the current SoA layout
+//   iterateAoS     Same as above with an array-of-structs for comparison
+//   readSoA        Only reading positions, where SoA avoids loading velocities at all
+//   readAoS        Same as above with an array-of-structs
+
+#include "../../bench_utils.h"
+
+#include <osp/universe/coordinates.h>
+#include <osp/universe/universe.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace osp;
+using namespace osp::universe;
+
+using osp::bench::Clock_t;
+using osp::bench::median;
+using osp::bench::micros_since;
+
+namespace
+{
+
+/**
+ * @brief Coordinate space with randomly placed satellites, positions and velocities only
+ */
+struct SyntheticSpace
+{
+    explicit SyntheticSpace(std::size_t const count)
+    {
+        std::mt19937 randGen(1337);
+        std::uniform_int_distribution<spaceint_t> posDist(-(spaceint_t(1) << 40), spaceint_t(1) << 40);
+        std::uniform_real_distribution<double> velDist(-1000.0, 1000.0);
+
+        m_space.m_satCount      = uint32_t(count);
+        m_space.m_satCapacity   = uint32_t(count);
+
+        std::size_t bytesUsed = 0;
+        for (auto &rDesc : m_space.m_satPositions)  { partition_aligned(bytesUsed, count, rDesc); }
+        for (auto &rDesc : m_space.m_satVelocities) { partition_aligned(bytesUsed, count, rDesc); }
+        m_space.m_data = sat_data_alloc(bytesUsed);
+
+        auto const [x, y, z]    = sat_views(m_space.m_satPositions,  m_space.m_data, count);
+        auto const [vx, vy, vz] = sat_views(m_space.m_satVelocities, m_space.m_data, count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            x[i] = posDist(randGen);  y[i] = posDist(randGen);  z[i] = posDist(randGen);
+            vx[i] = velDist(randGen); vy[i] = velDist(randGen); vz[i] = velDist(randGen);
+        }
+    }
+
+    CoSpaceCommon m_space;
+};
+
+/// Same data as SyntheticSpace, but array-of-structs
+struct SatAoS
+{
+    Vector3g position;
+    Vector3d velocity;
+};
+
+std::vector<SatAoS> to_aos(SyntheticSpace& rSynth)
+{
+    CoSpaceCommon &rSpace = rSynth.m_space;
+    auto const [x, y, z]    = sat_views(rSpace.m_satPositions,  rSpace.m_data, rSpace.m_satCount);
+    auto const [vx, vy, vz] = sat_views(rSpace.m_satVelocities, rSpace.m_data, rSpace.m_satCount);
+
+    std::vector<SatAoS> out(rSpace.m_satCount);
+    for (std::size_t i = 0; i < out.size(); ++i)
+    {
+        out[i] = {{x[i], y[i], z[i]}, {vx[i], vy[i], vz[i]}};
+    }
+    return out;
+}
+
+CoordTransformer make_transformer(int const precisionDiff, bool const rotated)
+{
+    CoSpaceTransform const parent{ .m_precision = 10 };
+    CoSpaceTransform const child
+    {
+        .m_rotation  = rotated ? Quaterniond::rotation(Radd{0.5}, Vector3d{1.0, 2.0, 3.0}.normalized()) : Quaterniond{},
+        .m_position  = {spaceint_t(1) << 35, -(spaceint_t(1) << 34), spaceint_t(1) << 20},
+        .m_precision = 10 + precisionDiff
+    };
+    return coord_child_to_parent(parent, child);
+}
+
+/**
+ * @brief Median time of reps calls to func, after one untimed warm-up call
+ */
+template <typename FUNC_T>
+double median_micros(int const reps, FUNC_T&& func)
+{
+    func();
+
+    std::vector<double> times;
+    times.reserve(std::size_t(reps));
+    for (int rep = 0; rep < reps; ++rep)
+    {
+        auto const start = Clock_t::now();
+        func();
+        times.push_back(micros_since(start));
+    }
+    return median(times);
+}
+
+void write_row(std::FILE *const pOut, char const* caseName, std::size_t const sats,
+               char const* precDiff, char const* rotated, double const micros)
+{
+    std::fprintf(pOut, "%s,%zu,%s,%s,%.1f,%.3f\n",
+                 caseName, sats, precDiff, rotated, micros, micros * 1000.0 / double(std::max<std::size_t>(sats, 1)));
+    std::fflush(pOut);
+}
+
+void run_transforms(std::FILE *const pOut, std::size_t const sats, int const precDiff, bool const rotated, int const reps)
+{
+    SyntheticSpace synth(sats);
+    CoSpaceCommon &rSpace = synth.m_space;
+    CoordTransformer const tf = make_transformer(precDiff, rotated);
+
+    std::string const precStr    = std::to_string(precDiff);
+    char const* const rotatedStr = rotated ? "1" : "0";
+
+    std::vector<Vector3g> out(rSpace.m_satCount);
+    double const scalar = median_micros(reps, [&] ()
+    {
+        auto const [x, y, z] = sat_views(rSpace.m_satPositions, rSpace.m_data, rSpace.m_satCount);
+        for (std::size_t i = 0; i < out.size(); ++i)
+        {
+            out[i] = tf.transform_position({x[i], y[i], z[i]});
+        }
+        osp::bench::keep_result(out.back().x());
+    });
+    write_row(pOut, "scalar", sats, precStr.c_str(), rotatedStr, scalar);
+
+    std::vector<spaceint_t> outX(rSpace.m_satCount), outY(rSpace.m_satCount), outZ(rSpace.m_satCount);
+    double const batch = median_micros(reps, [&] ()
+    {
+        auto const [x, y, z] = sat_views(rSpace.m_satPositions, rSpace.m_data, rSpace.m_satCount);
+        coord_transform_positions(tf, x, y, z,
+                                  Corrade::Containers::arrayView(outX.data(), outX.size()),
+                                  Corrade::Containers::arrayView(outY.data(), outY.size()),
+                                  Corrade::Containers::arrayView(outZ.data(), outZ.size()));
+        osp::bench::keep_result(outX.back());
+    });
+    write_row(pOut, "batch", sats, precStr.c_str(), rotatedStr, batch);
+}
+
+void run_layouts(std::FILE *const pOut, std::size_t const sats, int const reps)
+{
+    SyntheticSpace synth(sats);
+    CoSpaceCommon &rSpace = synth.m_space;
+    std::vector<SatAoS> aos = to_aos(synth);
+
+    double const iterateSoA = median_micros(reps, [&rSpace] ()
+    {
+        auto const [x, y, z]    = sat_views(rSpace.m_satPositions,  rSpace.m_data, rSpace.m_satCount);
+        auto const [vx, vy, vz] = sat_views(rSpace.m_satVelocities, rSpace.m_data, rSpace.m_satCount);
+        for (std::size_t i = 0; i < rSpace.m_satCount; ++i)
+        {
+            x[i] += spaceint_t(vx[i]);
+            y[i] += spaceint_t(vy[i]);
+            z[i] += spaceint_t(vz[i]);
+        }
+        osp::bench::keep_result(x[rSpace.m_satCount - 1]);
+    });
+    write_row(pOut, "iterateSoA", sats, "", "", iterateSoA);
+
+    double const iterateAoS = median_micros(reps, [&aos] ()
+    {
+        for (SatAoS &rSat : aos)
+        {
+            rSat.position += Vector3g(rSat.velocity);
+        }
+        osp::bench::keep_result(aos.back().position.x());
+    });
+    write_row(pOut, "iterateAoS", sats, "", "", iterateAoS);
+
+    double const readSoA = median_micros(reps, [&rSpace] ()
+    {
+        auto const [x, y, z] = sat_views(rSpace.m_satPositions, rSpace.m_data, rSpace.m_satCount);
+        spaceint_t sum = 0;
+        for (std::size_t i = 0; i < rSpace.m_satCount; ++i)
+        {
+            sum += x[i] ^ y[i] ^ z[i];
+        }
+        osp::bench::keep_result(sum);
+    });
+    write_row(pOut, "readSoA", sats, "", "", readSoA);
+
+    double const readAoS = median_micros(reps, [&aos] ()
+    {
+        spaceint_t sum = 0;
+        for (SatAoS const& sat : aos)
+        {
+            sum += sat.position.x() ^ sat.position.y() ^ sat.position.z();
+        }
+        osp::bench::keep_result(sum);
+    });
+    write_row(pOut, "readAoS", sats, "", "", readAoS);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    char const*                 outPath         = nullptr;
+    std::vector<std::size_t>    counts          {10'000, 100'000, 1'000'000};
+    std::size_t                 transformSats   = 100'000;
+    int                         reps            = 21;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (char const* const value = osp::bench::option_value(argc, argv, i, "--sats"))
+        {
+            counts = osp::bench::parse_counts(value);
+        }
+        else if (char const* const value = osp::bench::option_value(argc, argv, i, "--transform-sats"))
+        {
+            transformSats = std::max<std::size_t>(1, std::stoul(value));
+        }
+        else if (char const* const value = osp::bench::option_value(argc, argv, i, "--reps"))
+        {
+            reps = std::max(1, std::stoi(value));
+        }
+        else
+        {
+            outPath = argv[i];
+        }
+    }
+
+    osp::bench::CsvOutput const output{outPath};
+    std::FILE *const pOut = output.file();
+    if (pOut == nullptr)
+    {
+        return 1;
+    }
+
+    std::fprintf(pOut, "case,sats,precDiff,rotated,us,nsPerSat\n");
+
+    // Precision difference (negative means the child has coarser units) and rotated or not
+    for (int const precDiff : {-4, 0, 5})
+    {
+        for (bool const rotated : {false, true})
+        {
+            run_transforms(pOut, transformSats, precDiff, rotated, reps);
+        }
+    }
+
+    for (std::size_t const count : counts)
+    {
+        run_layouts(pOut, std::max<std::size_t>(count, 1), reps);
+    }
+
+    return 0;
+}
@@ -24,12 +24,33 @@
  */
 #include <osp/universe/universe.h>
 #include <osp/universe/coordinates.h>
+#include <osp/universe/coord_cache.h>
+#include <osp/universe/kepler.h>
+#include <osp/universe/sat_frames.h>
+#include <osp/universe/sat_index.h>
+#include <osp/universe/nbody.h>
+#include <osp/universe/sharding.h>
+#include <osp/universe/snapshot.h>
+#include <osp/universe/soi.h>
+#include <osp/util/background_worker.h>
 #include <osp/core/math_2pow.h>
 
 #include <Magnum/Math/Functions.h>
 
+#include <Corrade/Containers/ArrayViewStl.h>
+
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
 using namespace osp;
 using namespace osp::universe;
 
@@ -205,4 +226,1329 @@ TEST(Universe, CoordTransformerRotations)
     expect_near_vec(moonToSun.transform_position(moonRay), planet.m_position, 4);
 }
 
+// Test batched coord_transform_positions against CoordTransformer::transform_position
+TEST(Universe, CoordTransformPositions)
+{
+    CoSpaceTransform sun
+    {
+        .m_precision = 10
+    };
+    CoSpaceTransform planet
+    {
+        .m_rotation  = Quaterniond::rotation(30.0_deg, Vector3d{1.0, 2.0, 3.0}.normalized()),
+        .m_position  = {sci64(150, 9, 10), sci64(-150, 9, 10), sci64(42, 0, 10)},
+        .m_precision = 13
+    };
+
+    constexpr std::size_t sc_count = 64;
+
+    auto const view = [] (auto &rArray) { return Corrade::Containers::stridedArrayView(Corrade::Containers::arrayView(rArray)); };
+
+    std::array<spaceint_t, sc_count> x, y, z, outX, outY, outZ;
+    for (std::size_t i = 0; i < sc_count; ++i)
+    {
+        spaceint_t const sign = (i % 2 == 0) ? 1 : -1;
+        x[i] = sign * sci64(spaceint_t(i) + 1, 6, 10) + spaceint_t(i);
+        y[i] = -sign * sci64(spaceint_t(i) * 7, 5, 10) - spaceint_t(i);
+        z[i] = sign * spaceint_t(i) * 12345;
+    }
+
+    CoSpaceTransform planetNoRot = planet;
+    planetNoRot.m_rotation = {};
+
+    // No rotations: expect exact results, including rounding of negative values
+    for (CoordTransformer const& tf : { coord_parent_to_child(sun, planetNoRot),
+                                        coord_child_to_parent(sun, planetNoRot) })
+    {
+        coord_transform_positions(tf, view(x), view(y), view(z), view(outX), view(outY), view(outZ));
+        for (std::size_t i = 0; i < sc_count; ++i)
+        {
+            EXPECT_EQ(Vector3g(outX[i], outY[i], outZ[i]), tf.transform_position({x[i], y[i], z[i]}));
+        }
+    }
+
+    // With rotations: matrix and quaternion rotation may round differently
+    for (CoordTransformer const& tf : { coord_parent_to_child(sun, planet),
+                                        coord_child_to_parent(sun, planet) })
+    {
+        coord_transform_positions(tf, view(x), view(y), view(z), view(outX), view(outY), view(outZ));
+        for (std::size_t i = 0; i < sc_count; ++i)
+        {
+            expect_near_vec(Vector3g(outX[i], outY[i], outZ[i]), tf.transform_position({x[i], y[i], z[i]}), 2);
+        }
+    }
+
+    // In-place
+    CoordTransformer const tf = coord_child_to_parent(sun, planet);
+    std::array<spaceint_t, sc_count> inPlaceX = x, inPlaceY = y, inPlaceZ = z;
+    coord_transform_positions(tf, view(x), view(y), view(z), view(outX), view(outY), view(outZ));
+    coord_transform_positions(tf, view(inPlaceX), view(inPlaceY), view(inPlaceZ), view(inPlaceX), view(inPlaceY), view(inPlaceZ));
+    EXPECT_EQ(inPlaceX, outX);
+    EXPECT_EQ(inPlaceY, outY);
+    EXPECT_EQ(inPlaceZ, outZ);
+}
+
+// Test that partition_aligned and sat_data_alloc give aligned columns
+TEST(Universe, PartitionAligned)
+{
+    constexpr std::size_t sc_count = 5;
+
+    CoSpaceSatData data;
+    std::size_t bytesUsed = 0;
+
+    partition_aligned(bytesUsed, sc_count, data.m_satPositions[0]);
+    partition_aligned(bytesUsed, sc_count, data.m_satPositions[1]);
+    partition_aligned(bytesUsed, sc_count, data.m_satPositions[2]);
+    partition_aligned(bytesUsed, sc_count, data.m_satRotations[0],
+                                           data.m_satRotations[1],
+                                           data.m_satRotations[2],
+                                           data.m_satRotations[3]);
+
+    EXPECT_EQ(data.m_satPositions[0].m_offset, 0u);
+    EXPECT_EQ(data.m_satPositions[1].m_offset, gc_satDataAlignment);
+    EXPECT_EQ(data.m_satPositions[2].m_offset, gc_satDataAlignment * 2);
+    EXPECT_EQ(data.m_satRotations[0].m_offset, gc_satDataAlignment * 3);
+    EXPECT_EQ(data.m_satRotations[1].m_offset, gc_satDataAlignment * 3 + sizeof(double));
+    EXPECT_EQ(data.m_satRotations[0].m_stride, std::ptrdiff_t(sizeof(double) * 4));
+    EXPECT_EQ(bytesUsed, gc_satDataAlignment * 3 + sizeof(double) * 4 * sc_count);
+
+    data.m_data = sat_data_alloc(bytesUsed);
+    ASSERT_EQ(data.m_data.size(), bytesUsed);
+
+    auto const [x, y, z] = sat_views(data.m_satPositions, data.m_data, sc_count);
+    for (auto const& view : {x, y, z})
+    {
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(view.data()) % gc_satDataAlignment, 0u);
+    }
+}
+
+// Test growing and compacting satellite data with sat_create and sat_remove
+TEST(Universe, SatCreateRemove)
+{
+    CoSpaceSatData data;
+    TypedStrideDesc<float> mass;
+    StrideDesc *const extra[] = {&mass};
+
+    // Initial layout with one satellite, velocities unused
+    data.m_satCount     = 0;
+    data.m_satCapacity  = 1;
+    std::size_t bytesUsed = 0;
+    partition_aligned(bytesUsed, 1, data.m_satPositions[0]);
+    partition_aligned(bytesUsed, 1, data.m_satPositions[1]);
+    partition_aligned(bytesUsed, 1, data.m_satPositions[2]);
+    partition_aligned(bytesUsed, 1, data.m_satRotations[0],
+                                    data.m_satRotations[1],
+                                    data.m_satRotations[2],
+                                    data.m_satRotations[3]);
+    partition_aligned(bytesUsed, 1, mass);
+    data.m_data = sat_data_alloc(bytesUsed);
+
+    auto const write_sat = [&data, &mass] (SatId const sat, int const value)
+    {
+        auto const [x, y, z]        = sat_views(data.m_satPositions, data.m_data, data.m_satCount);
+        auto const [qx, qy, qz, qw] = sat_views(data.m_satRotations, data.m_data, data.m_satCount);
+        x[sat] = value; y[sat] = value + 1; z[sat] = value + 2;
+        qx[sat] = value; qy[sat] = value; qz[sat] = value; qw[sat] = value;
+        mass.view(Corrade::Containers::arrayView(data.m_data), data.m_satCount)[sat] = float(value);
+    };
+
+    auto const check_sat = [&data, &mass] (SatId const sat, int const value)
+    {
+        auto const [x, y, z]        = sat_views(data.m_satPositions, data.m_data, data.m_satCount);
+        auto const [qx, qy, qz, qw] = sat_views(data.m_satRotations, data.m_data, data.m_satCount);
+        EXPECT_EQ(Vector3g(x[sat], y[sat], z[sat]), Vector3g(value, value + 1, value + 2));
+        EXPECT_EQ(qx[sat], value);
+        EXPECT_EQ(qw[sat], value);
+        EXPECT_EQ(mass.view(Corrade::Containers::arrayView(data.m_data), data.m_satCount)[sat], float(value));
+    };
+
+    constexpr int sc_satCount = 100;
+
+    for (int i = 0; i < sc_satCount; ++i)
+    {
+        SatId const sat = sat_create(data, extra);
+        ASSERT_EQ(sat, SatId(i));
+        write_sat(sat, i * 10);
+    }
+
+    EXPECT_EQ(data.m_satCount, uint32_t(sc_satCount));
+    EXPECT_EQ(data.m_satCapacity, 128u);
+    EXPECT_TRUE(data.m_satVelocities[0].not_used());
+    EXPECT_EQ(data.m_satRotations[1].m_offset, data.m_satRotations[0].m_offset + sizeof(double));
+    EXPECT_EQ(mass.m_offset % gc_satDataAlignment, 0u);
+
+    for (int i = 0; i < sc_satCount; ++i)
+    {
+        check_sat(SatId(i), i * 10);
+    }
+
+    // Remove from the middle, last satellite takes its place
+    std::vector<SatRemap> moved;
+    sat_remove(data, 5, moved, extra);
+    ASSERT_EQ(moved.size(), 1u);
+    EXPECT_EQ(moved[0].from, SatId(sc_satCount - 1));
+    EXPECT_EQ(moved[0].to, 5u);
+    check_sat(5, (sc_satCount - 1) * 10);
+
+    // Removing the last satellite doesn't move anything
+    sat_remove(data, data.m_satCount - 1, moved, extra);
+    EXPECT_EQ(moved.size(), 1u);
+    EXPECT_EQ(data.m_satCount, uint32_t(sc_satCount - 2));
+
+    for (SatId sat = 0; sat < data.m_satCount; ++sat)
+    {
+        check_sat(sat, (sat == 5) ? (sc_satCount - 1) * 10 : int(sat) * 10);
+    }
+}
+
+// Test a local space with 32-bit positions: growing, reading with visit_sat_positions, and
+// transforming to and from a 64-bit parent
+TEST(Universe, LocalSpace32)
+{
+    CoSpaceSatData data;
+    data.m_satCount     = 0;
+    data.m_satCapacity  = 1;
+    std::size_t bytesUsed = 0;
+    partition_aligned(bytesUsed, 1, data.m_satPositions32[0]);
+    partition_aligned(bytesUsed, 1, data.m_satPositions32[1]);
+    partition_aligned(bytesUsed, 1, data.m_satPositions32[2]);
+    data.m_data = sat_data_alloc(bytesUsed);
+
+    EXPECT_TRUE(data.positions_32bit());
+    EXPECT_TRUE(data.m_satPositions[0].not_used());
+    EXPECT_EQ(data.m_satPositions32[0].m_stride, std::ptrdiff_t(sizeof(spaceint32_t)));
+
+    constexpr int sc_satCount = 40;
+    for (int i = 0; i < sc_satCount; ++i)
+    {
+        SatId const sat = sat_create(data);
+        auto const [x, y, z] = sat_views(data.m_satPositions32, data.m_data, data.m_satCount);
+        x[sat] = i * 1000; y[sat] = -i; z[sat] = spaceint32_t(1) << 30;
+    }
+
+    visit_sat_positions(data, data.m_satCount, [] (auto const& x, auto const& y, auto const& z)
+    {
+        static_assert(std::is_same_v<std::remove_cvref_t<decltype(x[0])>, spaceint32_t>);
+        for (int i = 0; i < sc_satCount; ++i)
+        {
+            EXPECT_EQ(Vector3g(x[i], y[i], z[i]), Vector3g(i * 1000, -i, spaceint_t(1) << 30));
+        }
+    });
+
+    CoSpaceTransform parent
+    {
+        .m_precision = 10
+    };
+    CoSpaceTransform local
+    {
+        .m_rotation  = Quaterniond::rotation(30.0_deg, Vector3d{1.0, 2.0, 3.0}.normalized()),
+        .m_position  = {sci64(150, 9, 10), sci64(-150, 9, 10), sci64(42, 0, 10)},
+        .m_precision = 10
+    };
+
+    std::size_t const count = data.m_satCount;
+    std::vector<spaceint_t>     parentX(count), parentY(count), parentZ(count);
+    std::vector<spaceint32_t>   localX(count),  localY(count),  localZ(count);
+    auto const [x, y, z] = sat_views(data.m_satPositions32, data.m_data, count);
+
+    // Local to parent widens, positions far from the parent's origin still fit
+    CoordTransformer const toParent = coord_child_to_parent(parent, local);
+    coord_transform_positions<spaceint32_t, spaceint_t>(toParent, x, y, z,
+            Corrade::Containers::arrayView(parentX), Corrade::Containers::arrayView(parentY), Corrade::Containers::arrayView(parentZ));
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        expect_near_vec(Vector3g(parentX[i], parentY[i], parentZ[i]), toParent.transform_position({x[i], y[i], z[i]}), 2);
+    }
+
+    // And back, narrowing. Translated positions fit in 32 bits before they're rotated.
+    CoordTransformer const toLocal = coord_parent_to_child(parent, local);
+    coord_transform_positions<spaceint_t, spaceint32_t>(toLocal,
+            Corrade::Containers::arrayView(parentX), Corrade::Containers::arrayView(parentY), Corrade::Containers::arrayView(parentZ),
+            Corrade::Containers::arrayView(localX), Corrade::Containers::arrayView(localY), Corrade::Containers::arrayView(localZ));
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        expect_near_vec(Vector3g(localX[i], localY[i], localZ[i]), toLocal.transform_position({parentX[i], parentY[i], parentZ[i]}), 2);
+        expect_near_vec(Vector3g(localX[i], localY[i], localZ[i]), Vector3g(x[i], y[i], z[i]), 4);
+    }
+}
+
+// Test N-body accelerations and that the leapfrog integrator keeps a circular orbit stable
+TEST(Universe, NBody)
+{
+    // Random cluster, compare direct, split into ranges, and Barnes-Hut accelerations
+    constexpr std::size_t sc_bodies = 1000;
+
+    NBodyState state;
+    nbody_resize(state, sc_bodies);
+    for (std::size_t i = 0; i < sc_bodies; ++i)
+    {
+        // Deterministic scatter within a 1000m cube
+        state.posX[i] = double((i * 7919)  % 1000);
+        state.posY[i] = double((i * 104729) % 997);
+        state.posZ[i] = double((i * 1299709) % 991);
+        state.mass[i] = 1.0 + double(i % 5);
+    }
+
+    NBodyParams params{.softening = 1.0};
+
+    nbody_accelerations(state, params);
+    std::vector<double> const directX = state.accelX;
+    std::vector<double> const directY = state.accelY;
+
+    // Ranges may run in any order, such as on TopWorkerPool workers
+    osp::ParallelFor const reversed{
+        .m_func = [] (void*, std::size_t const count, std::size_t const ranges, osp::ParallelFor::RangeFunc_t const rangeFunc, void const* const pFunc)
+        {
+            for (std::size_t range = ranges; range-- != 0; )
+            {
+                rangeFunc(pFunc, count * range / ranges, count * (range + 1) / ranges);
+            }
+        },
+        .m_threads = 4 };
+    nbody_accelerations(state, params, reversed);
+    EXPECT_EQ(state.accelX, directX);
+    EXPECT_EQ(state.accelY, directY);
+
+    params.mode  = ENBodyMode::BarnesHut;
+    params.theta = 0.3;
+    nbody_accelerations(state, params);
+
+    double errorSum = 0.0;
+    double magSum   = 0.0;
+    for (std::size_t i = 0; i < sc_bodies; ++i)
+    {
+        errorSum += std::abs(state.accelX[i] - directX[i]) + std::abs(state.accelY[i] - directY[i]);
+        magSum   += std::abs(directX[i]) + std::abs(directY[i]);
+    }
+    EXPECT_LT(errorSum / magSum, 0.02);
+
+    // Light satellite in a circular orbit around a heavy body: v = sqrt(G*M/r)
+    constexpr int    sc_precision = 10;
+    constexpr double sc_radius    = 1000.0;
+    constexpr double sc_mass      = 1.0e6;
+    double const     orbitVel     = std::sqrt(sc_mass / sc_radius);
+
+    CoSpaceCommon space;
+    space.m_precision   = sc_precision;
+    space.m_satCount    = 2;
+    space.m_satCapacity = 2;
+    TypedStrideDesc<float> massDesc;
+    std::size_t bytesUsed = 0;
+    for (auto &rDesc : space.m_satPositions)  { partition_aligned(bytesUsed, 2, rDesc); }
+    for (auto &rDesc : space.m_satVelocities) { partition_aligned(bytesUsed, 2, rDesc); }
+    partition_aligned(bytesUsed, 2, massDesc);
+    space.m_data = sat_data_alloc(bytesUsed);
+
+    auto const [x, y, z]    = sat_views(space.m_satPositions,  space.m_data, 2);
+    auto const [vx, vy, vz] = sat_views(space.m_satVelocities, space.m_data, 2);
+    auto const mass         = massDesc.view(Corrade::Containers::arrayView(space.m_data), 2);
+
+    x[0] = 0; y[0] = 0; z[0] = 0; vx[0] = 0.0; vy[0] = 0.0; vz[0] = 0.0; mass[0] = float(sc_mass);
+    x[1] = spaceint_t(sc_radius) << sc_precision; y[1] = 0; z[1] = 0;
+    vx[1] = 0.0; vy[1] = orbitVel; vz[1] = 0.0; mass[1] = 1.0f;
+
+    NBodyParams const orbitParams;
+    double const period = 2.0 * 3.14159265358979 * sc_radius / orbitVel;
+    int const    steps  = 2000;
+
+    for (int i = 0; i < steps; ++i)
+    {
+        nbody_step(state, orbitParams, space, mass, period / steps);
+    }
+
+    // Expect back near the start, on the same radius
+    Vector3d const pos = Vector3d(Vector3g(x[1] - x[0], y[1] - y[0], z[1] - z[0])) / double(int_2pow<spaceint_t>(sc_precision));
+    EXPECT_NEAR(pos.length(), sc_radius, sc_radius * 0.01);
+    EXPECT_NEAR(pos.x(), sc_radius, sc_radius * 0.05);
+}
+
+// Test that accelerations from an offload backend are used one step late, and that nbody_step
+// falls back to the CPU once they're too old
+TEST(Universe, NBodyOffload)
+{
+    constexpr int    sc_precision = 10;
+    constexpr double sc_radius    = 1000.0;
+    constexpr double sc_mass      = 1.0e6;
+    double const     orbitVel     = std::sqrt(sc_mass / sc_radius);
+
+    CoSpaceCommon space;
+    space.m_precision   = sc_precision;
+    space.m_satCount    = 2;
+    space.m_satCapacity = 2;
+    TypedStrideDesc<float> massDesc;
+    std::size_t bytesUsed = 0;
+    for (auto &rDesc : space.m_satPositions)  { partition_aligned(bytesUsed, 2, rDesc); }
+    for (auto &rDesc : space.m_satVelocities) { partition_aligned(bytesUsed, 2, rDesc); }
+    partition_aligned(bytesUsed, 2, massDesc);
+    space.m_data = sat_data_alloc(bytesUsed);
+
+    auto const [x, y, z]    = sat_views(space.m_satPositions,  space.m_data, 2);
+    auto const [vx, vy, vz] = sat_views(space.m_satVelocities, space.m_data, 2);
+    auto const mass         = massDesc.view(Corrade::Containers::arrayView(space.m_data), 2);
+
+    x[0] = 0; y[0] = 0; z[0] = 0; vx[0] = 0.0; vy[0] = 0.0; vz[0] = 0.0; mass[0] = float(sc_mass);
+    x[1] = spaceint_t(sc_radius) << sc_precision; y[1] = 0; z[1] = 0;
+    vx[1] = 0.0; vy[1] = orbitVel; vz[1] = 0.0; mass[1] = 1.0f;
+
+    NBodyState state;
+    state.offload.enabled = true;
+
+    // Stand-in for a GPU backend, calculates accelerations of the uploaded floats
+    auto const run_backend = [&state] ()
+    {
+        NBodyOffload &rOffload = state.offload;
+        std::size_t const count = rOffload.bodies.size() / 4;
+        rOffload.accel.assign(count * 4, 0.0f);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            for (std::size_t j = 0; j < count; ++j)
+            {
+                float const dx = rOffload.bodies[j*4]     - rOffload.bodies[i*4];
+                float const dy = rOffload.bodies[j*4 + 1] - rOffload.bodies[i*4 + 1];
+                float const dz = rOffload.bodies[j*4 + 2] - rOffload.bodies[i*4 + 2];
+                float const r2 = dx*dx + dy*dy + dz*dz;
+                float const s  = (r2 > 0.0f) ? rOffload.bodies[j*4 + 3] / (r2 * std::sqrt(r2)) : 0.0f;
+                rOffload.accel[i*4]     += dx * s;
+                rOffload.accel[i*4 + 1] += dy * s;
+                rOffload.accel[i*4 + 2] += dz * s;
+            }
+        }
+        rOffload.accelStep  = rOffload.step;
+        rOffload.accelCount = count;
+        rOffload.accelValid = true;
+    };
+
+    NBodyParams const params;
+    double const period = 2.0 * 3.14159265358979 * sc_radius / orbitVel;
+    int const    steps  = 2000;
+
+    // Nothing to use yet
+    nbody_step(state, params, space, mass, period / steps);
+    EXPECT_FALSE(state.offload.accelUsed);
+    EXPECT_EQ(state.offload.step, 1u);
+
+    for (int i = 1; i < steps; ++i)
+    {
+        run_backend();
+        nbody_step(state, params, space, mass, period / steps);
+        ASSERT_TRUE(state.offload.accelUsed);
+    }
+
+    Vector3d const pos = Vector3d(Vector3g(x[1] - x[0], y[1] - y[0], z[1] - z[0])) / double(int_2pow<spaceint_t>(sc_precision));
+    EXPECT_NEAR(pos.length(), sc_radius, sc_radius * 0.01);
+    EXPECT_NEAR(pos.x(), sc_radius, sc_radius * 0.05);
+
+    // Backend stops, the last accelerations are now two steps late
+    nbody_step(state, params, space, mass, period / steps);
+    EXPECT_FALSE(state.offload.accelUsed);
+}
+
+// Test CoordTransformCache against manually composed transforms, and invalidation
+TEST(Universe, CoordTransformCache)
+{
+    Universe universe;
+    CoSpaceId const sun     = universe.m_coordIds.create();
+    CoSpaceId const planet  = universe.m_coordIds.create();
+    CoSpaceId const moon    = universe.m_coordIds.create();
+    CoSpaceId const station = universe.m_coordIds.create();
+    universe.m_coordCommon.resize(universe.m_coordIds.capacity());
+
+    // Sun has one satellite which the planet's coordinate space is parented to
+    CoSpaceCommon &rSun = universe.m_coordCommon[sun];
+    rSun.m_precision    = 10;
+    rSun.m_satCount     = 1;
+    rSun.m_satCapacity  = 1;
+    std::size_t bytesUsed = 0;
+    for (auto &rDesc : rSun.m_satPositions) { partition_aligned(bytesUsed, 1, rDesc); }
+    partition_aligned(bytesUsed, 1, rSun.m_satRotations[0], rSun.m_satRotations[1],
+                                    rSun.m_satRotations[2], rSun.m_satRotations[3]);
+    rSun.m_data = sat_data_alloc(bytesUsed);
+
+    auto const [x, y, z]        = sat_views(rSun.m_satPositions, rSun.m_data, 1);
+    auto const [qx, qy, qz, qw] = sat_views(rSun.m_satRotations, rSun.m_data, 1);
+    x[0] = sci64(150, 9, 10); y[0] = sci64(-20, 9, 10); z[0] = 0;
+    qx[0] = 0.0; qy[0] = 0.0; qz[0] = 0.0; qw[0] = 1.0;
+
+    CoSpaceCommon &rPlanet = universe.m_coordCommon[planet];
+    rPlanet.m_parent    = sun;
+    rPlanet.m_parentSat = 0;
+    rPlanet.m_precision = 12;
+
+    CoSpaceCommon &rMoon = universe.m_coordCommon[moon];
+    rMoon.m_parent      = planet;
+    rMoon.m_position    = {sci64(280, 6, 12), sci64(280, 6, 12), 0};
+    rMoon.m_rotation    = Quaterniond::rotation(45.0_deg, {0.0, 0.0, 1.0});
+    rMoon.m_precision   = 15;
+
+    CoSpaceCommon &rStation = universe.m_coordCommon[station];
+    rStation.m_parent    = sun;
+    rStation.m_position  = {sci64(-100, 9, 10), 0, sci64(5, 9, 10)};
+    rStation.m_precision = 11;
+
+    auto const expect_manual = [&] (CoordTransformer const& tf)
+    {
+        CoSpaceTransform const planetTf = coord_get_transform(rPlanet, rPlanet, x, y, z, qx, qy, qz, qw);
+        CoordTransformer const moonToPlanet   = coord_child_to_parent(planetTf, rMoon);
+        CoordTransformer const planetToSun    = coord_child_to_parent(rSun, planetTf);
+        CoordTransformer const sunToStation   = coord_parent_to_child(rSun, rStation);
+        CoordTransformer const manual = coord_composite(sunToStation, coord_composite(planetToSun, moonToPlanet));
+
+        Vector3g const point{sci64(1, 6, 15), sci64(-3, 6, 15), sci64(7, 5, 15)};
+        expect_near_vec(tf.transform_position(point), manual.transform_position(point), 4);
+    };
+
+    CoordTransformCache cache;
+
+    CoordTransformer const first = coord_cache_get(cache, universe, moon, station);
+    expect_manual(first);
+    EXPECT_EQ(cache.m_entries.size(), 1u);
+
+    // Cached, nothing recomputed
+    coord_cache_get(cache, universe, moon, station);
+    EXPECT_EQ(cache.m_entries[0].generation, 1u);
+
+    // Unrelated space doesn't invalidate
+    coord_cache_invalidate(cache, sun);
+    EXPECT_TRUE(cache.m_entries[0].valid);
+
+    // Move the satellite the planet is parented to
+    x[0] += sci64(1, 9, 10);
+    coord_cache_invalidate_sat_children(cache, universe, sun);
+    EXPECT_FALSE(cache.m_entries[0].valid);
+
+    CoordTransformer const moved = coord_cache_get(cache, universe, moon, station);
+    expect_manual(moved);
+    EXPECT_NE(moved.transform_position({}), first.transform_position({}));
+    EXPECT_EQ(cache.m_entries[0].generation, 2u);
+
+    // Reverse direction is the inverse
+    Vector3g const point{sci64(2, 6, 15), sci64(5, 6, 15), 0};
+    CoordTransformer const &rStationToMoon = coord_cache_get(cache, universe, station, moon);
+    expect_near_vec(rStationToMoon.transform_position(moved.transform_position(point)), point, 64);
+}
+
+// Test writing a Universe to a snapshot and loading it back
+TEST(Universe, Snapshot)
+{
+    constexpr std::size_t sc_satCount = 100;
+
+    Universe universe;
+    CoSpaceId const mainSpace    = universe.m_coordIds.create();
+    CoSpaceId const removed = universe.m_coordIds.create();
+    CoSpaceId const child   = universe.m_coordIds.create();
+    universe.m_coordIds.remove(removed);
+    universe.m_coordCommon.resize(universe.m_coordIds.capacity());
+
+    CoSpaceCommon &rMain = universe.m_coordCommon[mainSpace];
+    rMain.m_precision   = 11;
+    rMain.m_rotation    = Quaterniond::rotation(10.0_deg, {0.0, 1.0, 0.0});
+    rMain.m_satCount    = sc_satCount;
+    rMain.m_satCapacity = sc_satCount;
+    std::size_t bytesUsed = 0;
+    for (auto &rDesc : rMain.m_satPositions)  { partition_aligned(bytesUsed, sc_satCount, rDesc); }
+    for (auto &rDesc : rMain.m_satVelocities) { partition_aligned(bytesUsed, sc_satCount, rDesc); }
+    rMain.m_data = sat_data_alloc(bytesUsed);
+
+    auto const [x, y, z]    = sat_views(rMain.m_satPositions,  rMain.m_data, sc_satCount);
+    auto const [vx, vy, vz] = sat_views(rMain.m_satVelocities, rMain.m_data, sc_satCount);
+    for (std::size_t i = 0; i < sc_satCount; ++i)
+    {
+        x[i] = spaceint_t(i) * 1000; y[i] = -spaceint_t(i); z[i] = spaceint_t(i) << 40;
+        vx[i] = double(i) * 0.5;     vy[i] = 0.0;           vz[i] = -double(i);
+    }
+
+    CoSpaceCommon &rChild = universe.m_coordCommon[child];
+    rChild.m_parent     = mainSpace;
+    rChild.m_parentSat  = 42;
+    rChild.m_precision  = 14;
+
+    std::string const path = testing::TempDir() + "osp_universe_snapshot.bin";
+    ASSERT_EQ(universe_snapshot_write(universe, path.c_str()), ESnapshotStatus::Ok);
+
+    Universe loaded;
+    ASSERT_EQ(universe_snapshot_read(loaded, path.c_str()), ESnapshotStatus::Ok);
+
+    EXPECT_TRUE(loaded.m_coordIds.exists(mainSpace));
+    EXPECT_FALSE(loaded.m_coordIds.exists(removed));
+    EXPECT_TRUE(loaded.m_coordIds.exists(child));
+    ASSERT_EQ(loaded.m_coordCommon.size(), universe.m_coordCommon.size());
+
+    CoSpaceCommon const &rLoadedMain  = loaded.m_coordCommon[mainSpace];
+    CoSpaceCommon const &rLoadedChild = loaded.m_coordCommon[child];
+
+    EXPECT_EQ(rLoadedMain.m_precision, 11);
+    EXPECT_EQ(rLoadedMain.m_rotation, rMain.m_rotation);
+    EXPECT_EQ(rLoadedMain.m_satCount, sc_satCount);
+    EXPECT_EQ(rLoadedMain.m_satPositions[1].m_offset, rMain.m_satPositions[1].m_offset);
+    EXPECT_EQ(rLoadedChild.m_parent, mainSpace);
+    EXPECT_EQ(rLoadedChild.m_parentSat, 42u);
+    EXPECT_TRUE(rLoadedChild.m_data.isEmpty());
+
+    // Views work directly on the loaded data
+    auto const [lx, ly, lz]    = sat_views(rLoadedMain.m_satPositions,  rLoadedMain.m_data, sc_satCount);
+    auto const [lvx, lvy, lvz] = sat_views(rLoadedMain.m_satVelocities, rLoadedMain.m_data, sc_satCount);
+    for (std::size_t i = 0; i < sc_satCount; ++i)
+    {
+        EXPECT_EQ(Vector3g(lx[i], ly[i], lz[i]), Vector3g(x[i], y[i], z[i]));
+        EXPECT_EQ(Vector3d(lvx[i], lvy[i], lvz[i]), Vector3d(vx[i], vy[i], vz[i]));
+    }
+
+    // Loaded data can be modified without affecting the file
+    loaded.m_coordCommon[mainSpace].m_data[0] ^= 0xFF;
+
+    Universe reloaded;
+    ASSERT_EQ(universe_snapshot_read(reloaded, path.c_str()), ESnapshotStatus::Ok);
+    EXPECT_EQ(reloaded.m_coordCommon[mainSpace].m_data[0], rMain.m_data[0]);
+
+    // Not a snapshot
+    std::string const badPath = testing::TempDir() + "osp_universe_not_snapshot.bin";
+    {
+        std::FILE *pFile = std::fopen(badPath.c_str(), "wb");
+        ASSERT_NE(pFile, nullptr);
+        std::fputs("Hello there, this is definitely not a snapshot", pFile);
+        std::fclose(pFile);
+    }
+    EXPECT_EQ(universe_snapshot_read(loaded, badPath.c_str()), ESnapshotStatus::NotASnapshot);
+    EXPECT_EQ(universe_snapshot_read(loaded, (testing::TempDir() + "missing/nothing.bin").c_str()), ESnapshotStatus::CantOpen);
+}
+
+// Test capturing a Universe and writing the capture from a background thread
+TEST(Universe, SnapshotCapture)
+{
+    constexpr std::size_t sc_satCount = 20000; // Enough for a few pages
+
+    Universe universe;
+    CoSpaceId const mainSpace = universe.m_coordIds.create();
+    universe.m_coordCommon.resize(universe.m_coordIds.capacity());
+
+    CoSpaceCommon &rMain = universe.m_coordCommon[mainSpace];
+    rMain.m_satCount    = sc_satCount;
+    rMain.m_satCapacity = sc_satCount;
+    std::size_t bytesUsed = 0;
+    for (auto &rDesc : rMain.m_satPositions) { partition_aligned(bytesUsed, sc_satCount, rDesc); }
+    rMain.m_data = sat_data_alloc(bytesUsed);
+
+    auto const [x, y, z] = sat_views(rMain.m_satPositions, rMain.m_data, sc_satCount);
+    for (std::size_t i = 0; i < sc_satCount; ++i)
+    {
+        x[i] = spaceint_t(i); y[i] = 0; z[i] = -spaceint_t(i);
+    }
+
+    UniverseCapture const first = universe_snapshot_capture(universe);
+    ASSERT_EQ(first.data[mainSpace].size(), rMain.m_data.size());
+    ASSERT_GT(first.data[mainSpace].page_count(), 2u);
+
+    // Only the page that changed is copied, the rest are shared with the previous capture
+    z[sc_satCount - 1] = 1234;
+    UniverseCapture const second = universe_snapshot_capture(universe, &first);
+    EXPECT_EQ(second.data[mainSpace].shared_page_count(first.data[mainSpace]), first.data[mainSpace].page_count() - 1);
+
+    // Later changes don't affect the capture
+    x[0] = 5678;
+
+    std::string const capturePath  = testing::TempDir() + "osp_universe_capture.bin";
+    std::string const directPath   = testing::TempDir() + "osp_universe_direct.bin";
+    ESnapshotStatus status = ESnapshotStatus::WriteFailed;
+    {
+        osp::BackgroundWorker worker;
+        worker.push([&second, &capturePath, &status] { status = universe_snapshot_write(second, capturePath.c_str()); });
+        worker.wait_idle();
+    }
+    ASSERT_EQ(status, ESnapshotStatus::Ok);
+
+    Universe loaded;
+    ASSERT_EQ(universe_snapshot_read(loaded, capturePath.c_str()), ESnapshotStatus::Ok);
+    auto const [lx, ly, lz] = sat_views(loaded.m_coordCommon[mainSpace].m_satPositions, loaded.m_coordCommon[mainSpace].m_data, sc_satCount);
+    EXPECT_EQ(lx[0], 0);
+    EXPECT_EQ(lz[sc_satCount - 1], 1234);
+    EXPECT_EQ(lx[sc_satCount - 1], spaceint_t(sc_satCount - 1));
+
+    // Same file as writing the universe directly, as it was when captured
+    x[0] = 0;
+    ASSERT_EQ(universe_snapshot_write(universe, directPath.c_str()), ESnapshotStatus::Ok);
+
+    auto const read_file = [] (std::string const& path)
+    {
+        std::vector<char> out;
+        std::FILE *pFile = std::fopen(path.c_str(), "rb");
+        for (int c = std::fgetc(pFile); c != EOF; c = std::fgetc(pFile))
+        {
+            out.push_back(char(c));
+        }
+        std::fclose(pFile);
+        return out;
+    };
+    EXPECT_EQ(read_file(capturePath), read_file(directPath));
+}
+
+// Test orbital element conversions, and moving satellites on rails
+TEST(Universe, KeplerRails)
+{
+    constexpr double sc_gm = 3.986e14;
+
+    // Elliptic and hyperbolic orbits are reproduced at epoch, and conserve energy later
+    std::array<KeplerState, 3> const states
+    {{
+        { {7.0e6, 0.0,   0.0},   {0.0,     7546.0,  0.0} },
+        { {7.0e6, 1.0e6, 2.0e5}, {100.0,   9000.0,  3000.0} },
+        { {7.0e6, 0.0,   0.0},   {0.0,     12000.0, 1000.0} }
+    }};
+
+    for (KeplerState const& state : states)
+    {
+        KeplerOrbit orbit;
+        ASSERT_TRUE(kepler_from_state(orbit, state, sc_gm, 10.0));
+
+        KeplerState const atEpoch = kepler_to_state(orbit, 10.0);
+        EXPECT_LT((atEpoch.position - state.position).length(), 1.0e-3);
+        EXPECT_LT((atEpoch.velocity - state.velocity).length(), 1.0e-6);
+
+        KeplerState const later = kepler_to_state(orbit, 123456.0);
+        double const energy      = state.velocity.dot() * 0.5 - sc_gm / state.position.length();
+        double const energyLater = later.velocity.dot() * 0.5 - sc_gm / later.position.length();
+        EXPECT_NEAR(energyLater, energy, std::abs(energy) * 1.0e-12);
+    }
+
+    // Radial orbits aren't supported
+    KeplerOrbit radial;
+    EXPECT_FALSE(kepler_from_state(radial, { {7.0e6, 0.0, 0.0}, {100.0, 0.0, 0.0} }, sc_gm, 0.0));
+
+    // Space with a planet and a satellite in a circular orbit
+    constexpr int    sc_precision = 0;
+    constexpr double sc_radius    = 7.0e6;
+    double const     orbitVel     = std::sqrt(sc_gm / sc_radius);
+    double const     period       = 2.0 * 3.14159265358979 * sc_radius / orbitVel;
+
+    CoSpaceCommon space;
+    space.m_precision   = sc_precision;
+    space.m_satCount    = 2;
+    space.m_satCapacity = 2;
+    std::size_t bytesUsed = 0;
+    for (auto &rDesc : space.m_satPositions)  { partition_aligned(bytesUsed, 2, rDesc); }
+    for (auto &rDesc : space.m_satVelocities) { partition_aligned(bytesUsed, 2, rDesc); }
+    space.m_data = sat_data_alloc(bytesUsed);
+
+    auto const [x, y, z]    = sat_views(space.m_satPositions,  space.m_data, 2);
+    auto const [vx, vy, vz] = sat_views(space.m_satVelocities, space.m_data, 2);
+
+    x[0] = 1000; y[0] = 2000; z[0] = 3000; vx[0] = 0.0; vy[0] = 0.0; vz[0] = 0.0;
+    x[1] = x[0] + spaceint_t(sc_radius); y[1] = y[0]; z[1] = z[0];
+    vx[1] = 0.0; vy[1] = orbitVel; vz[1] = 0.0;
+
+    SatRails rails;
+    rails.attractor = 0;
+    rails.gm        = sc_gm;
+    ASSERT_TRUE(rails_enter(rails, space, 1));
+
+    // One big time step for half an orbit lands on the opposite side
+    rails_update(rails, space, period * 0.5);
+    EXPECT_NEAR(double(x[1] - x[0]), -sc_radius, 2.0);
+    EXPECT_NEAR(double(y[1] - y[0]), 0.0, 2.0);
+    EXPECT_NEAR(vy[1], -orbitVel, 1.0e-6);
+
+    // Perturbations above the threshold take the satellite off rails
+    NBodyState nbody;
+    nbody_resize(nbody, 2);
+    nbody.posX = { 0.0, sc_radius };
+    nbody.posY = { 0.0, 0.0 };
+    nbody.posZ = { 0.0, 0.0 };
+    nbody.accelX = { 0.0, -sc_gm / (sc_radius * sc_radius) };
+    nbody.accelY = { 0.0, 0.0 };
+    nbody.accelZ = { 0.0, 0.0 };
+
+    rails_check_perturbations(rails, space, nbody);
+    EXPECT_EQ(rails.onRails[1], 1);
+
+    nbody.accelY[1] = -sc_gm / (sc_radius * sc_radius) * 0.01;
+    rails_check_perturbations(rails, space, nbody);
+    EXPECT_EQ(rails.onRails[1], 0);
+
+    // Off-rails satellites aren't moved
+    spaceint_t const xBefore = x[1];
+    rails_update(rails, space, period * 0.25);
+    EXPECT_EQ(x[1], xBefore);
+
+    // ...and go back on rails once perturbations are small again
+    nbody.accelY[1] = 0.0;
+    rails_check_perturbations(rails, space, nbody);
+    EXPECT_EQ(rails.onRails[1], 1);
+
+    // nbody_step leaves satellites on rails alone, but still integrates the rest
+    std::array<float, 2> const mass{ float(sc_gm), 1.0f };
+    vx[0] = 1.0;
+    spaceint_t const xAttBefore = x[0];
+    spaceint_t const yBefore    = y[1];
+    double const     vyBefore   = vy[1];
+    nbody_step(nbody, NBodyParams{}, space, Corrade::Containers::arrayView(mass), 10.0, {}, {}, rails.onRails);
+    EXPECT_EQ(y[1],  yBefore);
+    EXPECT_EQ(vy[1], vyBefore);
+    EXPECT_NE(x[0],  xAttBefore);
+}
+
+// Predict sphere of influence crossings, only checking satellites when they're due
+TEST(Universe, SoiPredictor)
+{
+    constexpr double sc_gm = 3.986e14;
+
+    // Time to leave is solved analytically for elliptic and hyperbolic orbits
+    std::array<KeplerState, 2> const states
+    {{
+        { {7.0e6, 0.0, 0.0}, {0.0, 10000.0, 0.0} },
+        { {7.0e6, 0.0, 0.0}, {0.0, 12000.0, 0.0} }
+    }};
+    for (KeplerState const& state : states)
+    {
+        KeplerOrbit orbit;
+        ASSERT_TRUE(kepler_from_state(orbit, state, sc_gm, 0.0));
+
+        double const      leave   = kepler_time_outbound(orbit, 2.0e7, 0.0);
+        KeplerState const atLeave = kepler_to_state(orbit, leave);
+        EXPECT_NEAR(atLeave.position.length(), 2.0e7, 1.0);
+        EXPECT_GT(Magnum::Math::dot(atLeave.position, atLeave.velocity), 0.0);
+
+        // Asking later than the crossing gives the next one, or none for hyperbolic
+        double const next = kepler_time_outbound(orbit, 2.0e7, leave + 1.0);
+        if (orbit.eccentricity < 1.0)
+        {
+            EXPECT_NEAR(next - leave, 2.0 * 3.14159265358979 / orbit.meanMotion, 1.0e-3);
+        }
+        else
+        {
+            EXPECT_EQ(next, leave + 1.0);
+        }
+    }
+
+    KeplerOrbit bound;
+    ASSERT_TRUE(kepler_from_state(bound, states[0], sc_gm, 0.0));
+    EXPECT_TRUE(std::isinf(kepler_time_outbound(bound, 1.0e9, 0.0)));
+
+    // Space with a planet, one satellite approaching it, and many satellites far away
+    constexpr std::size_t sc_sats = 1000;
+
+    CoSpaceCommon space;
+    space.m_satCount    = sc_sats;
+    space.m_satCapacity = sc_sats;
+    std::size_t bytesUsed = 0;
+    for (auto &rDesc : space.m_satPositions)  { partition_aligned(bytesUsed, sc_sats, rDesc); }
+    for (auto &rDesc : space.m_satVelocities) { partition_aligned(bytesUsed, sc_sats, rDesc); }
+    space.m_data = sat_data_alloc(bytesUsed);
+
+    auto const [x, y, z]    = sat_views(space.m_satPositions,  space.m_data, sc_sats);
+    auto const [vx, vy, vz] = sat_views(space.m_satVelocities, space.m_data, sc_sats);
+
+    for (SatId sat = 0; sat < sc_sats; ++sat)
+    {
+        x[sat] = 1000000000 + spaceint_t(sat) * 1000; y[sat] = 0; z[sat] = 0;
+        vx[sat] = 0.0; vy[sat] = 0.0; vz[sat] = 0.0;
+    }
+    x[0] = 0;
+    x[1] = 2000000; vx[1] = -1000.0;
+
+    SoiPredictor pred;
+    pred.bodies.push_back({0, 1.0e6, 1});
+    pred.maxAccel    = 0.0;
+    pred.maxInterval = 1.0e9;
+
+    soi_reset(pred, space, nullptr, 0.0);
+    EXPECT_EQ(pred.parent[1], SoiPredictor::smc_none);
+
+    std::vector<SoiTransition> transitions;
+    double enterTime = -1.0;
+    for (int step = 1; step <= 1100; ++step)
+    {
+        x[1] -= 1000;
+        soi_update(pred, space, nullptr, double(step), transitions);
+        if ( ! transitions.empty() && enterTime < 0.0 )
+        {
+            enterTime = double(step);
+        }
+    }
+
+    ASSERT_EQ(transitions.size(), 1u);
+    EXPECT_EQ(transitions[0].sat,  1u);
+    EXPECT_EQ(transitions[0].from, SoiPredictor::smc_none);
+    EXPECT_EQ(transitions[0].to,   0u);
+    EXPECT_EQ(pred.parent[1], 0u);
+    EXPECT_NEAR(enterTime, 1001.0, 1.0);
+
+    // Only the approaching satellite was ever checked, instead of every satellite every step.
+    // Once inside, checks get further apart as it moves away from the boundary.
+    EXPECT_LE(pred.checks, 10u);
+
+    // Satellites added later are tracked too
+    space.m_satCount = sc_sats - 1;
+    soi_reset(pred, space, nullptr, 1100.0);
+    space.m_satCount = sc_sats;
+    x[sc_sats - 1] = 100;
+    transitions.clear();
+    soi_update(pred, space, nullptr, 1101.0, transitions);
+    EXPECT_EQ(pred.parent[sc_sats - 1], 0u);
+}
+
+// Compare SatSpatialIndex queries against brute force, before and after satellites move
+TEST(Universe, SatSpatialIndex)
+{
+    constexpr std::size_t sc_sats = 5000;
+
+    CoSpaceCommon space;
+    space.m_satCount    = sc_sats;
+    space.m_satCapacity = sc_sats;
+    std::size_t bytesUsed = 0;
+    for (auto &rDesc : space.m_satPositions) { partition_aligned(bytesUsed, sc_sats, rDesc); }
+    space.m_data = sat_data_alloc(bytesUsed);
+
+    auto const [x, y, z] = sat_views(space.m_satPositions, space.m_data, sc_sats);
+
+    // Deterministic scatter, flattened on Y like a disk of orbits
+    auto const scatter = [] (std::size_t i, uint64_t prime, spaceint_t range) -> spaceint_t
+    {
+        return spaceint_t((uint64_t(i) * prime) % uint64_t(range * 2)) - range;
+    };
+    for (std::size_t i = 0; i < sc_sats; ++i)
+    {
+        x[i] = scatter(i, 7919,    1 << 30);
+        y[i] = scatter(i, 104729,  1 << 26);
+        z[i] = scatter(i, 1299709, 1 << 30);
+    }
+
+    auto const distanceSq = [&x = x, &y = y, &z = z] (std::size_t i, Vector3g const p)
+    {
+        return Vector3d(Vector3g{x[i], y[i], z[i]} - p).dot();
+    };
+
+    SatSpatialIndex index;
+
+    auto const check = [&] ()
+    {
+        for (std::size_t q = 0; q < 20; ++q)
+        {
+            Vector3g const center{scatter(q, 15485863, 1 << 30), scatter(q, 32452843, 1 << 26), scatter(q, 49979687, 1 << 30)};
+            double const   radius = double(1 << 27);
+
+            std::vector<SatId> found;
+            sat_index_query_radius(index, center, radius, found);
+            std::sort(found.begin(), found.end());
+
+            std::vector<SatId> expected;
+            std::vector<std::pair<double, SatId>> byDistance;
+            for (std::size_t i = 0; i < sc_sats; ++i)
+            {
+                double const d = distanceSq(i, center);
+                if (d <= radius * radius)
+                {
+                    expected.push_back(SatId(i));
+                }
+                byDistance.emplace_back(d, SatId(i));
+            }
+            EXPECT_EQ(found, expected);
+
+            std::vector<SatId> nearest;
+            sat_index_query_nearest(index, center, 8, nearest);
+            std::sort(byDistance.begin(), byDistance.end());
+            ASSERT_EQ(nearest.size(), 8);
+            for (std::size_t i = 0; i < 8; ++i)
+            {
+                EXPECT_EQ(nearest[i], byDistance[i].second);
+            }
+        }
+    };
+
+    sat_index_update(index, space);
+    EXPECT_EQ(index.rebuilds, 1);
+    check();
+
+    // Small moves are handled without a rebuild
+    for (std::size_t i = 0; i < sc_sats; i += 97)
+    {
+        x[i] += 1 << 24;
+    }
+    sat_index_update(index, space);
+    EXPECT_EQ(index.rebuilds, 1);
+    check();
+
+    // Leaving the loose bounds forces a rebuild
+    x[3] = spaceint_t(1) << 40;
+    sat_index_update(index, space);
+    EXPECT_EQ(index.rebuilds, 2);
+    check();
+}
+
+// Test publishing frames while the simulation keeps modifying m_data, and interpolation
+TEST(Universe, SatDataFrames)
+{
+    CoSpaceCommon space;
+    space.m_satCount    = 2;
+    space.m_satCapacity = 2;
+    std::size_t bytesUsed = 0;
+    for (auto &rDesc : space.m_satPositions) { partition_aligned(bytesUsed, 2, rDesc); }
+    partition_aligned(bytesUsed, 2, space.m_satRotations[0], space.m_satRotations[1],
+                      space.m_satRotations[2], space.m_satRotations[3]);
+    space.m_data = sat_data_alloc(bytesUsed);
+
+    auto const [x, y, z]        = sat_views(space.m_satPositions, space.m_data, 2);
+    auto const [qx, qy, qz, qw] = sat_views(space.m_satRotations, space.m_data, 2);
+    for (std::size_t i = 0; i < 2; ++i)
+    {
+        x[i] = 0; y[i] = 0; z[i] = 0;
+        qx[i] = 0.0; qy[i] = 0.0; qz[i] = 0.0; qw[i] = 1.0;
+    }
+
+    SatDataFrames frames;
+    frames.frameCount = 3;
+    sat_frames_publish(frames, space, 0.0);
+
+    x[0] = 1000; y[1] = -2000;
+    Quaterniond const rot = Quaterniond::rotation(Radd{1.0}, {0.0, 0.0, 1.0});
+    qz[0] = rot.vector().z(); qw[0] = rot.scalar();
+    sat_frames_publish(frames, space, 1.0);
+
+    // Simulation continuing to write doesn't affect published frames
+    x[0] = 99999;
+    {
+        CoSpaceSatData const &latest = sat_frames_latest(frames);
+        auto const [lx, ly, lz] = sat_views(latest.m_satPositions, latest.m_data, latest.m_satCount);
+        EXPECT_EQ(lx[0], 1000);
+        EXPECT_EQ(ly[1], -2000);
+        EXPECT_EQ(sat_frames_latest_time(frames), 1.0);
+    }
+
+    std::array<spaceint_t, 2> outX{}, outY{}, outZ{};
+    auto const view = [] (auto &rArray) { return Corrade::Containers::stridedArrayView(Corrade::Containers::arrayView(rArray)); };
+    std::array<double, 8> outRot{};
+    std::array<Corrade::Containers::StridedArrayView1D<double>, 4> const outQ
+    {
+        Corrade::Containers::StridedArrayView1D<double>{outRot, &outRot[0], 2, 4 * sizeof(double)},
+        Corrade::Containers::StridedArrayView1D<double>{outRot, &outRot[1], 2, 4 * sizeof(double)},
+        Corrade::Containers::StridedArrayView1D<double>{outRot, &outRot[2], 2, 4 * sizeof(double)},
+        Corrade::Containers::StridedArrayView1D<double>{outRot, &outRot[3], 2, 4 * sizeof(double)}
+    };
+
+    sat_frames_interpolate_positions(frames, 0.25, view(outX), view(outY), view(outZ));
+    EXPECT_EQ(outX[0], 250);
+    EXPECT_EQ(outY[1], -500);
+
+    sat_frames_interpolate_rotations(frames, 0.5, outQ);
+    Quaterniond const half{{outRot[0], outRot[1], outRot[2]}, outRot[3]};
+    EXPECT_NEAR(double(half.angle()), 0.5, 1.0e-6);
+
+    // Clamped past the latest frame
+    sat_frames_interpolate_positions(frames, 5.0, view(outX), view(outY), view(outZ));
+    EXPECT_EQ(outX[0], 1000);
+
+    // Publishing again overwrites the oldest frame, keeping the previous latest
+    sat_frames_publish(frames, space, 2.0);
+    sat_frames_interpolate_positions(frames, 1.5, view(outX), view(outY), view(outZ));
+    EXPECT_EQ(outX[0], 50500);
+}
+
 // TODO: Test CoordTransformer for hopping across nested rotated coordinate spaces
+
+// Partition positions, velocities, rotations, and optionally masses of a space
+static void shard_test_partition(CoSpaceCommon& rSpace, uint32_t const capacity, TypedStrideDesc<float> *pMass = nullptr)
+{
+    rSpace.m_satCount       = 0;
+    rSpace.m_satCapacity    = capacity;
+    std::size_t bytesUsed = 0;
+    for (auto &rDesc : rSpace.m_satPositions)  { partition_aligned(bytesUsed, capacity, rDesc); }
+    for (auto &rDesc : rSpace.m_satVelocities) { partition_aligned(bytesUsed, capacity, rDesc); }
+    partition_aligned(bytesUsed, capacity, rSpace.m_satRotations[0],
+                                           rSpace.m_satRotations[1],
+                                           rSpace.m_satRotations[2],
+                                           rSpace.m_satRotations[3]);
+    if (pMass != nullptr)
+    {
+        partition_aligned(bytesUsed, capacity, *pMass);
+    }
+    rSpace.m_data = sat_data_alloc(bytesUsed);
+}
+
+static Universe shard_test_universe(std::size_t const spaceCount)
+{
+    Universe universe;
+    for (std::size_t i = 0; i < spaceCount; ++i)
+    {
+        CoSpaceId const id = universe.m_coordIds.create();
+        universe.m_coordCommon.resize(std::size_t(id) + 1);
+        shard_test_partition(universe.m_coordCommon[id], 1);
+    }
+    return universe;
+}
+
+// Test that mirrored spaces follow their owner, and that outdated or broken messages are dropped
+TEST(Universe, ShardBoundaryExchange)
+{
+    constexpr ShardId   sc_shardA   = 0;
+    constexpr ShardId   sc_shardB   = 1;
+    constexpr CoSpaceId sc_spaceA   = 0;
+    constexpr CoSpaceId sc_spaceB   = 1;
+    constexpr uint32_t  sc_sats     = 50;
+
+    ShardCtx ctxA;
+    ShardCtx ctxB;
+    for (ShardCtx *pCtx : {&ctxA, &ctxB})
+    {
+        shard_assign(pCtx->map, sc_spaceA, sc_shardA);
+        shard_assign(pCtx->map, sc_spaceB, sc_shardB);
+        pCtx->config.exchangeInterval = 1.0;
+    }
+    ctxA.map.local = sc_shardA;
+    ctxB.map.local = sc_shardB;
+    ctxA.peerSpaces.resize(2);
+    ctxA.peerSpaces[sc_shardB] = {sc_spaceA};
+
+    Universe uniA = shard_test_universe(2);
+    Universe uniB = shard_test_universe(2);
+
+    CoSpaceCommon &rOwned = uniA.m_coordCommon[sc_spaceA];
+    for (uint32_t i = 0; i < sc_sats; ++i)
+    {
+        sat_create(rOwned);
+    }
+    auto const write_sats = [&rOwned] (int const offset)
+    {
+        auto const [x, y, z]        = sat_views(rOwned.m_satPositions,  rOwned.m_data, rOwned.m_satCount);
+        auto const [vx, vy, vz]     = sat_views(rOwned.m_satVelocities, rOwned.m_data, rOwned.m_satCount);
+        auto const [qx, qy, qz, qw] = sat_views(rOwned.m_satRotations,  rOwned.m_data, rOwned.m_satCount);
+        for (SatId sat = 0; sat < rOwned.m_satCount; ++sat)
+        {
+            x[sat] = sat * 1000 + offset; y[sat] = -spaceint_t(sat); z[sat] = offset;
+            vx[sat] = double(sat); vy[sat] = 0.5; vz[sat] = -double(offset);
+            qx[sat] = 0.0; qy[sat] = 0.0; qz[sat] = 0.0; qw[sat] = 1.0;
+        }
+    };
+    write_sats(0);
+
+    // Exchanges are due once per interval, without catching up
+    EXPECT_FALSE(shard_step(ctxA, 0.4));
+    EXPECT_FALSE(shard_step(ctxA, 0.4));
+    EXPECT_TRUE (shard_step(ctxA, 0.4));
+    EXPECT_FALSE(shard_step(ctxA, 0.4));
+    EXPECT_TRUE (shard_step(ctxA, 0.4));
+
+    ShardMassProxy const proxy{ .space = sc_spaceA, .position = {1, 2, 3}, .velocity = {0.0, 0.0, 0.0}, .mass = 10.0 };
+
+    std::vector<std::byte> message;
+    shard_write_boundary(ctxA, uniA, sc_shardB, {&proxy, 1}, message);
+    ASSERT_EQ(shard_read_boundary(ctxB, uniB, message), EShardRead::Ok);
+
+    auto const check_mirror = [&uniB] (int const offset)
+    {
+        CoSpaceCommon const &rMirror = uniB.m_coordCommon[sc_spaceA];
+        ASSERT_EQ(rMirror.m_satCount, uint32_t(sc_sats));
+        auto const [x, y, z]    = sat_views(rMirror.m_satPositions,  rMirror.m_data, rMirror.m_satCount);
+        auto const [vx, vy, vz] = sat_views(rMirror.m_satVelocities, rMirror.m_data, rMirror.m_satCount);
+        auto const qw           = rMirror.m_satRotations[3].view(Corrade::Containers::arrayView(rMirror.m_data), rMirror.m_satCount);
+        for (SatId sat = 0; sat < rMirror.m_satCount; ++sat)
+        {
+            EXPECT_EQ(Vector3g(x[sat], y[sat], z[sat]), Vector3g(sat * 1000 + offset, -spaceint_t(sat), offset));
+            EXPECT_EQ(Vector3d(vx[sat], vy[sat], vz[sat]), Vector3d(double(sat), 0.5, -double(offset)));
+            EXPECT_EQ(qw[sat], 1.0);
+        }
+    };
+    check_mirror(0);
+
+    ASSERT_GT(ctxB.peerProxies.size(), sc_shardA);
+    ASSERT_EQ(ctxB.peerProxies[sc_shardA].size(), 1u);
+    EXPECT_EQ(ctxB.peerProxies[sc_shardA][0].position, proxy.position);
+
+    // Same time as the last message applied, dropped
+    write_sats(7);
+    shard_write_boundary(ctxA, uniA, sc_shardB, {}, message);
+    ASSERT_EQ(shard_read_boundary(ctxB, uniB, message), EShardRead::Ok);
+    check_mirror(0);
+
+    // Truncated, nothing applied
+    shard_step(ctxA, 1.0);
+    shard_write_boundary(ctxA, uniA, sc_shardB, {}, message);
+    std::vector<std::byte> const truncated(message.begin(), message.end() - 1);
+    EXPECT_EQ(shard_read_boundary(ctxB, uniB, truncated), EShardRead::Malformed);
+    check_mirror(0);
+
+    ASSERT_EQ(shard_read_boundary(ctxB, uniB, message), EShardRead::Ok);
+    check_mirror(7);
+
+    // Exchange the other way, and messages aren't applied to spaces of the receiver
+    sat_create(uniB.m_coordCommon[sc_spaceB]);
+    ctxB.peerSpaces.resize(2);
+    ctxB.peerSpaces[sc_shardA] = {sc_spaceB};
+    std::vector<std::byte> reply;
+    shard_write_boundary(ctxB, uniB, sc_shardA, {}, reply);
+    ASSERT_EQ(shard_read_boundary(ctxA, uniA, reply), EShardRead::Ok);
+    EXPECT_EQ(uniA.m_coordCommon[sc_spaceB].m_satCount, 1u);
+    ASSERT_EQ(shard_read_boundary(ctxB, uniB, reply), EShardRead::Ok);
+    EXPECT_EQ(uniB.m_coordCommon[sc_spaceB].m_satCount, 1u);
+    check_mirror(7);
+
+    EXPECT_EQ(shard_read_boundary(ctxB, uniB, ArrayView<std::byte const>{}), EShardRead::Malformed);
+}
+
+// Test moving satellites between shards, including to a space that changes owner on the way
+TEST(Universe, ShardMigration)
+{
+    constexpr ShardId   sc_shardA   = 0;
+    constexpr ShardId   sc_shardB   = 1;
+    constexpr ShardId   sc_shardC   = 2;
+    constexpr CoSpaceId sc_spaceA   = 0;
+    constexpr CoSpaceId sc_spaceB   = 1;
+
+    ShardCtx ctxA;
+    ShardCtx ctxB;
+    ShardCtx ctxC;
+    for (ShardCtx *pCtx : {&ctxA, &ctxB, &ctxC})
+    {
+        shard_assign(pCtx->map, sc_spaceA, sc_shardA);
+        shard_assign(pCtx->map, sc_spaceB, sc_shardB);
+    }
+    ctxA.map.local = sc_shardA;
+    ctxB.map.local = sc_shardB;
+    ctxC.map.local = sc_shardC;
+
+    Universe uniA = shard_test_universe(2);
+    Universe uniB = shard_test_universe(2);
+    Universe uniC = shard_test_universe(2);
+
+    CoSpaceCommon &rSpaceA = uniA.m_coordCommon[sc_spaceA];
+    for (int i = 0; i < 3; ++i)
+    {
+        SatId const sat = sat_create(rSpaceA);
+        auto const [x, y, z]        = sat_views(rSpaceA.m_satPositions,  rSpaceA.m_data, rSpaceA.m_satCount);
+        auto const [vx, vy, vz]     = sat_views(rSpaceA.m_satVelocities, rSpaceA.m_data, rSpaceA.m_satCount);
+        auto const [qx, qy, qz, qw] = sat_views(rSpaceA.m_satRotations,  rSpaceA.m_data, rSpaceA.m_satCount);
+        x[sat] = 100 * i; y[sat] = 0; z[sat] = 0;
+        vx[sat] = 1.0; vy[sat] = 0.0; vz[sat] = 0.0;
+        qx[sat] = 0.0; qy[sat] = 0.0; qz[sat] = 0.0; qw[sat] = 1.0;
+    }
+
+    // Space B is offset by -1000 and rotated 90 degrees around Z, relative to space A
+    Quaterniond const rotZ{{0.0, 0.0, std::sqrt(0.5)}, std::sqrt(0.5)};
+    CoordTransformer const aToB{ .m_rotOut = rotZ, .m_c = {1000, 0, 0} };
+
+    float const mass = 42.0f;
+    std::vector<SatRemap> moved;
+    shard_migrate_out(ctxA, uniA, sc_spaceA, 0, sc_spaceB, aToB,
+                      {reinterpret_cast<std::byte const*>(&mass), sizeof(mass)}, moved);
+
+    EXPECT_EQ(rSpaceA.m_satCount, 2u);
+    ASSERT_EQ(moved.size(), 1u);
+    EXPECT_EQ(moved[0].from, 2u);
+    ASSERT_EQ(ctxA.migrationsOut.size(), 2u);
+    ASSERT_FALSE(ctxA.migrationsOut[sc_shardB].empty());
+
+    std::vector<ShardMigration> arrived;
+    ASSERT_EQ(shard_read_migrations(ctxB, ctxA.migrationsOut[sc_shardB], arrived), EShardRead::Ok);
+    ASSERT_EQ(arrived.size(), 1u);
+    EXPECT_EQ(arrived[0].dest, sc_spaceB);
+    expect_near_vec(arrived[0].position, Vector3g(0, 1000, 0), 1);
+    EXPECT_NEAR(arrived[0].velocity.y(), 1.0, 1e-12);
+    ASSERT_EQ(arrived[0].extra.size(), sizeof(float));
+
+    float massOut;
+    std::memcpy(&massOut, arrived[0].extra.data(), sizeof(float));
+    EXPECT_EQ(massOut, mass);
+
+    SatId const sat = shard_accept_migration(uniB, arrived[0]);
+    CoSpaceCommon const &rSpaceB = uniB.m_coordCommon[sc_spaceB];
+    ASSERT_EQ(rSpaceB.m_satCount, 1u);
+    auto const [x, y, z] = sat_views(rSpaceB.m_satPositions, rSpaceB.m_data, rSpaceB.m_satCount);
+    expect_near_vec(Vector3g(x[sat], y[sat], z[sat]), Vector3g(0, 1000, 0), 1);
+    auto const qz = rSpaceB.m_satRotations[2].view(Corrade::Containers::arrayView(rSpaceB.m_data), rSpaceB.m_satCount);
+    EXPECT_NEAR(qz[sat], std::sqrt(0.5), 1e-12);
+
+    // Space B moved to shard C while a migration was on its way, B forwards it
+    ctxA.migrationsOut[sc_shardB].clear();
+    shard_migrate_out(ctxA, uniA, sc_spaceA, 0, sc_spaceB, aToB, {}, moved);
+    shard_assign(ctxB.map, sc_spaceB, sc_shardC);
+    shard_assign(ctxC.map, sc_spaceB, sc_shardC);
+
+    arrived.clear();
+    ASSERT_EQ(shard_read_migrations(ctxB, ctxA.migrationsOut[sc_shardB], arrived), EShardRead::Ok);
+    EXPECT_TRUE(arrived.empty());
+    ASSERT_EQ(ctxB.migrationsOut.size(), 3u);
+
+    ASSERT_EQ(shard_read_migrations(ctxC, ctxB.migrationsOut[sc_shardC], arrived), EShardRead::Ok);
+    ASSERT_EQ(arrived.size(), 1u);
+    shard_accept_migration(uniC, arrived[0]);
+    EXPECT_EQ(uniC.m_coordCommon[sc_spaceB].m_satCount, 1u);
+
+    // Broken messages don't add anything
+    std::vector<std::byte> broken = ctxB.migrationsOut[sc_shardC];
+    broken.pop_back();
+    arrived.clear();
+    EXPECT_EQ(shard_read_migrations(ctxC, broken, arrived), EShardRead::Malformed);
+    EXPECT_TRUE(arrived.empty());
+    EXPECT_EQ(shard_read_migrations(ctxC, ctxA.migrationsOut[sc_shardB], arrived), EShardRead::Ok);
+    EXPECT_EQ(shard_read_boundary(ctxC, uniC, ctxB.migrationsOut[sc_shardC]), EShardRead::WrongType);
+}
+
+// Test that a far cluster pulls like its aggregated mass proxy
+TEST(Universe, ShardMassProxies)
+{
+    constexpr int    sc_precision   = 10;
+    constexpr double sc_distance    = 1.0e5;
+    constexpr int    sc_clusterSats = 64;
+
+    CoSpaceCommon cluster;
+    cluster.m_precision = sc_precision;
+    TypedStrideDesc<float> massDesc;
+    shard_test_partition(cluster, sc_clusterSats, &massDesc);
+    cluster.m_satCount = sc_clusterSats;
+
+    auto const [x, y, z]    = sat_views(cluster.m_satPositions,  cluster.m_data, sc_clusterSats);
+    auto const [vx, vy, vz] = sat_views(cluster.m_satVelocities, cluster.m_data, sc_clusterSats);
+    auto const mass         = massDesc.view(Corrade::Containers::arrayView(cluster.m_data), sc_clusterSats);
+
+    double massSum = 0.0;
+    for (int i = 0; i < sc_clusterSats; ++i)
+    {
+        // Within 12m of (sc_distance, 20, 20) on each axis, over a few 16m cells
+        x[i] = (spaceint_t(sc_distance) << sc_precision) + spaceint_t((i % 4) * 8 - 12) * 1024;
+        y[i] = spaceint_t((i / 4 % 4) * 8 + 8) * 1024;
+        z[i] = spaceint_t((i / 16) * 8 + 8) * 1024;
+        vx[i] = 0.0; vy[i] = 2.0; vz[i] = 0.0;
+        mass[i] = 1.0e6f + float(i);
+        massSum += mass[i];
+    }
+
+    std::vector<ShardMassProxy> proxies;
+    shard_mass_proxies(cluster, 7, mass, 1.0e9, proxies);
+    ASSERT_EQ(proxies.size(), 1u);
+    EXPECT_EQ(proxies[0].space, 7u);
+    EXPECT_NEAR(proxies[0].mass, massSum, massSum * 1e-9);
+    EXPECT_NEAR(proxies[0].velocity.y(), 2.0, 1e-12);
+
+    std::vector<ShardMassProxy> fine;
+    shard_mass_proxies(cluster, 7, mass, 16.0, fine);
+    EXPECT_GT(fine.size(), 1u);
+
+    // Another space with the same origin and one light satellite at its origin
+    CoSpaceCommon probe;
+    probe.m_precision = sc_precision;
+    shard_test_partition(probe, 1);
+    probe.m_satCount = 1;
+    std::vector<float> probeMass{1.0f};
+    {
+        auto const [px, py, pz]     = sat_views(probe.m_satPositions,  probe.m_data, 1);
+        auto const [pvx, pvy, pvz]  = sat_views(probe.m_satVelocities, probe.m_data, 1);
+        px[0] = 0; py[0] = 0; pz[0] = 0; pvx[0] = 0.0; pvy[0] = 0.0; pvz[0] = 0.0;
+    }
+
+    std::vector<NBodyProxy> bodies;
+    shard_proxies_to_nbody(proxies, 6, CoordTransformer{}, sc_precision, bodies);
+    EXPECT_TRUE(bodies.empty());
+    shard_proxies_to_nbody(proxies, 7, CoordTransformer{}, sc_precision, bodies);
+    ASSERT_EQ(bodies.size(), 1u);
+    EXPECT_NEAR(bodies[0].position.x(), sc_distance, 1.0);
+    EXPECT_NEAR(bodies[0].position.y(), 20.0, 1.0);
+
+    NBodyState state;
+    NBodyParams const params;
+    nbody_step(state, params, probe, Corrade::Containers::arrayView(probeMass), 1.0, bodies);
+
+    // Probe doesn't move far in one second, so its velocity is close to the acceleration
+    auto const [pvx, pvy, pvz] = sat_views(probe.m_satVelocities, probe.m_data, 1);
+    Vector3d const toCluster = bodies[0].position;
+    Vector3d const expected  = toCluster * (massSum / std::pow(toCluster.length(), 3.0));
+    EXPECT_NEAR(pvx[0], expected.x(), expected.x() * 1e-3);
+    EXPECT_NEAR(pvy[0], expected.y(), expected.x() * 1e-3);
+    EXPECT_EQ(state.proxyCount, 1u);
+}
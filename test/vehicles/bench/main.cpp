@@ -0,0 +1,694 @@
+/**
+ * Open Space Program
+ * Copyright © 2019-2024 Open Space Program Project
+ *
+ * MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Headless vehicle scaling benchmark: builds vehicles of increasing part counts with
+// VehicleBuilder, wired like the prebuilt command module (user control -> RCS drivers ->
+// rockets), and writes timings of each stage of their life in a scene as CSV.
+//
+// Usage: osp-bench-vehicles [output.csv] [--parts N,N,...] [--copies N] [--frames N]
+//
+//   --parts N,...      Parts per vehicle to run with (default: 10,100,1000,10000)
+//   --copies N         Copies of the vehicle spawned at once (default: 1)
+//   --frames N         Timed machine update frames, after a few untimed warm-up frames (default: 300)
+//
+// Times are in microseconds:
+//   build      VehicleBuilder, from the first part to finalize_release
+//   spawn      Copying VehicleData into ACtxParts with the same SysVehicleSpawnVB and copy_nodes
+//              calls as the vehicle spawn session. No prefabs are requested, there's no renderer.
+//   wire       compile_signal_levels of the scene's wiring
+//   frame      One frame of machine updates: user controls change, and the wave of signals runs
+//              through RCS drivers and rockets until no machines are left to update
+//   reweld     Rebuilding weldToParts from partToWeld, and each weld's centre from part transforms
+//   delete     Removing every part, weld, machine, and node of the vehicles from ACtxParts
+
+#include "../../bench_utils.h"
+
+#include <adera/activescene/VehicleBuilder.h>
+#include <adera/activescene/vehicles_vb_fn.h>
+#include <adera/machines/links.h>
+
+#include <osp/core/Resources.h>
+#include <osp/link/signal.h>
+#include <osp/vehicles/prefabs.h>
+
+#include <Corrade/Containers/ArrayViewStl.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace osp::link;
+
+using adera::VehicleBuilder;
+using adera::VehicleData;
+using adera::PerNodeType;
+using adera::ACtxVehicleSpawnVB;
+using adera::SysVehicleSpawnVB;
+using adera::RcsDriverBatch;
+using adera::gc_mtUserCtrl;
+using adera::gc_mtMagicRocket;
+using adera::gc_mtRcsDriver;
+
+using osp::Matrix4;
+using osp::Vector3;
+using osp::active::ACtxParts;
+using osp::active::ACtxVehicleSpawn;
+using osp::active::PartId;
+using osp::active::WeldId;
+using osp::active::SpVehicleId;
+using osp::bench::Clock_t;
+using osp::bench::micros_since;
+
+namespace ports_userctrl    = adera::ports_userctrl;
+namespace ports_magicrocket = adera::ports_magicrocket;
+namespace ports_rcsdriver   = adera::ports_rcsdriver;
+
+namespace
+{
+
+constexpr int       gc_warmupFrames = 10;
+constexpr float     gc_partSpacing  = 1.0f;
+constexpr float     gc_rcsThrust    = 3000.0f;
+constexpr float     gc_engineThrust = 50000.0f;
+
+// Directions RCS nozzles point in, cycled through so commands produce some torque
+std::array<Vector3, 6> const gc_nozzleDirs
+{{
+    { 1.0f,  0.0f,  0.0f}, {-1.0f,  0.0f,  0.0f},
+    { 0.0f,  1.0f,  0.0f}, { 0.0f, -1.0f,  0.0f},
+    { 0.0f,  0.0f,  1.0f}, { 0.0f,  0.0f, -1.0f}
+}};
+
+double mean(std::vector<double> const& values)
+{
+    if (values.empty())
+    {
+        return 0.0;
+    }
+    double sum = 0.0;
+    for (double const value : values)
+    {
+        sum += value;
+    }
+    return sum / double(values.size());
+}
+
+double percentile(std::vector<double> values, double const fraction)
+{
+    if (values.empty())
+    {
+        return 0.0;
+    }
+    auto const nth = values.begin() + std::ptrdiff_t(fraction * double(values.size() - 1));
+    std::nth_element(values.begin(), nth, values.end());
+    return *nth;
+}
+
+struct ControlNodes
+{
+    NodeId pitch;
+    NodeId yaw;
+    NodeId roll;
+    NodeId throttle;
+    NodeId engineMul;
+    NodeId rcsMul;
+};
+
+void add_rcs_nozzle(VehicleBuilder& rBuilder, ControlNodes const& ctrl, PartId const part, Vector3 const pos, Vector3 const dir)
+{
+    auto const [posX, posY, posZ, dirX, dirY, dirZ, driverOut] = rBuilder.create_nodes<7>(gc_ntSigFloat);
+
+    rBuilder.create_machine(part, gc_mtRcsDriver, {
+        { ports_rcsdriver::gc_posXIn,       posX        },
+        { ports_rcsdriver::gc_posYIn,       posY        },
+        { ports_rcsdriver::gc_posZIn,       posZ        },
+        { ports_rcsdriver::gc_dirXIn,       dirX        },
+        { ports_rcsdriver::gc_dirYIn,       dirY        },
+        { ports_rcsdriver::gc_dirZIn,       dirZ        },
+        { ports_rcsdriver::gc_cmdAngXIn,    ctrl.pitch  },
+        { ports_rcsdriver::gc_cmdAngYIn,    ctrl.yaw    },
+        { ports_rcsdriver::gc_cmdAngZIn,    ctrl.roll   },
+        { ports_rcsdriver::gc_throttleOut,  driverOut   }
+    } );
+
+    rBuilder.create_machine(part, gc_mtMagicRocket, {
+        { ports_magicrocket::gc_throttleIn,     driverOut   },
+        { ports_magicrocket::gc_multiplierIn,   ctrl.rcsMul }
+    } );
+
+    auto &rFloatValues = rBuilder.node_values< SignalValues_t<float> >(gc_ntSigFloat);
+    rFloatValues[posX] = pos.x();
+    rFloatValues[posY] = pos.y();
+    rFloatValues[posZ] = pos.z();
+    rFloatValues[dirX] = dir.x();
+    rFloatValues[dirY] = dir.y();
+    rFloatValues[dirZ] = dir.z();
+}
+
+/**
+ * @brief Build a vehicle of partCount parts, all welded together into a flat grid
+ *
+ * The first part is a capsule with user controls. Of the rest, half are structure without any
+ * machines, a quarter are RCS nozzles with an RCS driver and rocket each, and a quarter are
+ * engines driven by the throttle directly.
+ */
+VehicleData make_vehicle(osp::Resources& rResources, std::size_t const partCount)
+{
+    VehicleBuilder vbuilder{&rResources};
+    VehicleBuilder::WeldVec_t toWeld;
+
+    auto const [capsule] = vbuilder.create_parts<1>();
+    toWeld.push_back({capsule, Matrix4{}});
+
+    auto const [pitch, yaw, roll, throttle, engineMul, rcsMul] = vbuilder.create_nodes<6>(gc_ntSigFloat);
+    ControlNodes const ctrl{pitch, yaw, roll, throttle, engineMul, rcsMul};
+
+    auto &rFloatValues = vbuilder.node_values< SignalValues_t<float> >(gc_ntSigFloat);
+    rFloatValues[engineMul] = gc_engineThrust;
+    rFloatValues[rcsMul]    = gc_rcsThrust;
+
+    vbuilder.create_machine(capsule, gc_mtUserCtrl, {
+        { ports_userctrl::gc_throttleOut,   throttle },
+        { ports_userctrl::gc_pitchOut,      pitch    },
+        { ports_userctrl::gc_yawOut,        yaw      },
+        { ports_userctrl::gc_rollOut,       roll     }
+    } );
+
+    auto const side = static_cast<std::size_t>(std::ceil(std::sqrt(double(partCount))));
+    float const centre = 0.5f * float(side);
+
+    for (std::size_t i = 1; i < partCount; ++i)
+    {
+        auto const [part] = vbuilder.create_parts<1>();
+        Vector3 const pos{ gc_partSpacing * (float(i % side) - centre),
+                           gc_partSpacing * (float(i / side) - centre),
+                           0.0f };
+        toWeld.push_back({part, Matrix4::translation(pos)});
+
+        switch (i % 4)
+        {
+        case 1:
+            add_rcs_nozzle(vbuilder, ctrl, part, pos, gc_nozzleDirs[(i / 4) % gc_nozzleDirs.size()]);
+            break;
+        case 3:
+            vbuilder.create_machine(part, gc_mtMagicRocket, {
+                { ports_magicrocket::gc_throttleIn,     throttle  },
+                { ports_magicrocket::gc_multiplierIn,   engineMul }
+            } );
+            break;
+        default:
+            break; // Structure
+        }
+    }
+
+    vbuilder.weld(toWeld);
+
+    return vbuilder.finalize_release();
+}
+
+/**
+ * @brief Scene containers, set up the same way as the parts and signal sessions of the test app
+ */
+struct Scene
+{
+    Scene()
+    {
+        updMach.machTypesDirty  .resize(MachTypeReg_t::size());
+        updMach.localDirty      .resize(MachTypeReg_t::size());
+        updMach.wakeRequests    .resize(MachTypeReg_t::size());
+        parts.machines.perType  .resize(MachTypeReg_t::size());
+        parts.nodePerType       .resize(NodeTypeReg_t::size());
+    }
+
+    ACtxParts                       parts;
+    ACtxVehicleSpawn                spawn;
+    ACtxVehicleSpawnVB              spawnVB;
+
+    MachineUpdater                  updMach;
+    SignalValues_t<float>           sigVal;
+    UpdateNodes<float>              sigUpd;
+    UpdateNodesPerWriter<float>     sigUpdWriters;
+
+    // Same as ACtxRcsDrivers in the test app
+    std::vector< std::array<NodeId, ports_rcsdriver::gc_portCount> > rcsNodes;
+    std::vector<MachLocalId>        rcsLocals;
+    RcsDriverBatch                  rcsBatch;
+
+    // Sum of all rocket thrust, stands in for applying forces to rigid bodies
+    float                           thrustTotal{0.0f};
+};
+
+/**
+ * @brief Spawn copies of a vehicle, following the tasks of setup_vehicle_spawn_vb
+ */
+void spawn(Scene& rScene, VehicleData const& data, std::size_t const copies)
+{
+    ACtxParts           &rParts = rScene.parts;
+    ACtxVehicleSpawn    &rSpawn = rScene.spawn;
+    ACtxVehicleSpawnVB  &rVSVB  = rScene.spawnVB;
+
+    rSpawn.spawnRequest.resize(copies);
+    rVSVB.dataVB.assign(copies, &data);
+
+    SysVehicleSpawnVB::group_blueprints         (rSpawn, rVSVB);
+    SysVehicleSpawnVB::create_parts_and_welds   (rSpawn, rVSVB, rParts);
+    SysVehicleSpawnVB::create_machines          (rSpawn, rVSVB, rParts);
+
+    // "Update Part<->Machine maps"
+    rParts.machineToPart.resize(rParts.machines.ids.capacity());
+    rParts.partToMachines.ids_reserve(rParts.partIds.capacity());
+    rParts.partToMachines.data_reserve(rParts.machines.ids.capacity());
+    for (SpVehicleId vhId{0}; vhId.value < copies; ++vhId.value)
+    {
+        std::size_t const remapMachOffset = rVSVB.remapMachOffsets[vhId];
+        std::size_t const remapPartOffset = rVSVB.remapPartOffsets[vhId];
+
+        for (MachAnyId const srcMach : data.m_machines.ids)
+        {
+            rParts.machineToPart[rVSVB.remapMachs[remapMachOffset + srcMach]]
+                    = rVSVB.remapParts[remapPartOffset + data.m_machToPart[srcMach]];
+        }
+
+        for (PartId const srcPart : data.m_partIds)
+        {
+            auto const srcPairs = data.m_partToMachines[srcPart];
+            MachinePair *pDstPair = rParts.partToMachines.emplace(rVSVB.remapParts[remapPartOffset + srcPart], srcPairs.size());
+            for (MachinePair const& srcPair : srcPairs)
+            {
+                MachAnyId const srcMach = data.m_machines.perType[srcPair.type].localToAny[srcPair.local];
+                MachAnyId const dstMach = rVSVB.remapMachs[remapMachOffset + srcMach];
+                *pDstPair = { .local = rParts.machines.machToLocal[dstMach], .type = srcPair.type };
+                ++pDstPair;
+            }
+        }
+    }
+
+    // "Create (and connect) Node IDs copied from VehicleBuilder"
+    rVSVB.remapNodeOffsets.resize(copies * NodeTypeReg_t::size());
+    auto remapNodeOffsets2d = rVSVB.remap_node_offsets_2d();
+
+    std::size_t remapNodeTotal = 0;
+    for (NodeTypeId nodeType = 0; nodeType < NodeTypeReg_t::size(); ++nodeType)
+    {
+        PerNodeType const &srcNodes = data.m_nodePerType[nodeType];
+        remapNodeTotal += copies * srcNodes.nodeIds.capacity();
+        reserve_nodes(rParts.nodePerType[nodeType], rParts.machines.ids.capacity(),
+                      copies * srcNodes.nodeToMach.data_size(), copies * srcNodes.machToNode.data_size());
+    }
+    rVSVB.remapNodes.resize(remapNodeTotal);
+
+    std::size_t nodeRemapUsed = 0;
+    for (SpVehicleId vhId{0}; vhId.value < copies; ++vhId.value)
+    {
+        auto const machRemap = osp::arrayView(std::as_const(rVSVB.remapMachs)).exceptPrefix(rVSVB.remapMachOffsets[vhId]);
+
+        for (NodeTypeId nodeType = 0; nodeType < NodeTypeReg_t::size(); ++nodeType)
+        {
+            PerNodeType const &srcNodes = data.m_nodePerType[nodeType];
+            std::size_t const remapSize = srcNodes.nodeIds.capacity();
+
+            remapNodeOffsets2d[vhId.value][nodeType] = nodeRemapUsed;
+            copy_nodes(srcNodes, data.m_machines, machRemap, rParts.nodePerType[nodeType], rParts.machines,
+                       osp::arrayView(rVSVB.remapNodes).sliceSize(nodeRemapUsed, remapSize));
+            nodeRemapUsed += remapSize;
+        }
+    }
+    ++rParts.connectRevision;
+
+    // Signal values and update buffers
+    SysVehicleSpawnVB::copy_signal_values<float>(rSpawn, rVSVB, rParts, rScene.sigVal, rScene.sigUpd);
+    rScene.sigUpdWriters.resize(MachTypeReg_t::size(), rParts.nodePerType[gc_ntSigFloat].nodeIds.capacity());
+    for (MachTypeId type = 0; type < MachTypeReg_t::size(); ++type)
+    {
+        rScene.updMach.localDirty[type].resize(rParts.machines.perType[type].localIds.capacity());
+    }
+
+    // "Cache RCS Driver port nodes"
+    Nodes const         &floats     = rParts.nodePerType[gc_ntSigFloat];
+    PerMachType const   &drivers    = rParts.machines.perType[gc_mtRcsDriver];
+    rScene.rcsNodes.resize(drivers.localIds.capacity());
+    for (MachLocalId const local : drivers.localIds)
+    {
+        auto const portSpan = lgrn::Span<NodeId const>{floats.machToNode[drivers.localToAny[local]]};
+        for (PortId port = 0; port < ports_rcsdriver::gc_portCount; ++port)
+        {
+            rScene.rcsNodes[local][port] = connected_node(portSpan, port);
+        }
+    }
+
+    rSpawn.spawnRequest.clear();
+}
+
+void wire(Scene& rScene)
+{
+    ArrayView<Nodes const> const nodePerType{rScene.parts.nodePerType.data(), rScene.parts.nodePerType.size()};
+    compile_signal_levels(rScene.parts.machines, nodePerType, rScene.updMach);
+    rScene.updMach.levelsRevision = rScene.parts.connectRevision;
+}
+
+void update_rcs_drivers(Scene& rScene)
+{
+    UpdateNodes<float>  &rSigUpd    = rScene.sigUpdWriters[gc_mtRcsDriver];
+    RcsDriverBatch      &rBatch     = rScene.rcsBatch;
+    PortId const        throttleOut = ports_rcsdriver::gc_throttleOut.port;
+
+    rScene.rcsLocals.clear();
+    for (MachLocalId const local : rScene.updMach.localDirty[gc_mtRcsDriver])
+    {
+        if (rScene.rcsNodes[local][throttleOut] != lgrn::id_null<NodeId>())
+        {
+            rScene.rcsLocals.push_back(local);
+        }
+    }
+    rBatch.resize(rScene.rcsLocals.size());
+
+    for (PortId port = 0; port < ports_rcsdriver::gc_inputCount; ++port)
+    {
+        std::vector<float> &rColumn = rBatch.inputs[port];
+        for (std::size_t i = 0; i < rScene.rcsLocals.size(); ++i)
+        {
+            NodeId const node = rScene.rcsNodes[rScene.rcsLocals[i]][port];
+            rColumn[i] = (node != lgrn::id_null<NodeId>()) ? rScene.sigVal[node] : 0.0f;
+        }
+    }
+
+    adera::thruster_influence_batch(rBatch);
+
+    for (std::size_t i = 0; i < rScene.rcsLocals.size(); ++i)
+    {
+        NodeId const thrNode = rScene.rcsNodes[rScene.rcsLocals[i]][throttleOut];
+        if (rScene.sigVal[thrNode] != rBatch.throttleOut[i])
+        {
+            rSigUpd.assign(thrNode, rBatch.throttleOut[i]);
+        }
+    }
+}
+
+void update_rockets(Scene& rScene)
+{
+    PerMachType const   &rockets    = rScene.parts.machines.perType[gc_mtMagicRocket];
+    Nodes const         &floats     = rScene.parts.nodePerType[gc_ntSigFloat];
+
+    for (MachLocalId const local : rScene.updMach.localDirty[gc_mtMagicRocket])
+    {
+        auto const      portSpan    = floats.machToNode[rockets.localToAny[local]];
+        NodeId const    throttleIn  = connected_node(portSpan, ports_magicrocket::gc_throttleIn.port);
+        NodeId const    mulIn       = connected_node(portSpan, ports_magicrocket::gc_multiplierIn.port);
+
+        rScene.thrustTotal += std::clamp(rScene.sigVal[throttleIn], 0.0f, 1.0f) * rScene.sigVal[mulIn];
+    }
+}
+
+/**
+ * @brief One frame of machine updates, the same loop as the link pipeline of the test app
+ */
+void frame(Scene& rScene, int const frameNum)
+{
+    MachineUpdater      &rUpdMach   = rScene.updMach;
+    PerMachType const   &userCtrls  = rScene.parts.machines.perType[gc_mtUserCtrl];
+    Nodes const         &floats     = rScene.parts.nodePerType[gc_ntSigFloat];
+
+    // Pilot wiggles the controls, so every RCS driver has to recalculate
+    float const t = float(frameNum) * 0.1f;
+    UpdateNodes<float> &rCtrlUpd = rScene.sigUpdWriters[gc_mtUserCtrl];
+    for (MachLocalId const local : userCtrls.localIds)
+    {
+        auto const portSpan = floats.machToNode[userCtrls.localToAny[local]];
+        rCtrlUpd.assign(connected_node(portSpan, ports_userctrl::gc_throttleOut.port), 0.5f + 0.5f * std::sin(t));
+        rCtrlUpd.assign(connected_node(portSpan, ports_userctrl::gc_pitchOut.port),    std::sin(t));
+        rCtrlUpd.assign(connected_node(portSpan, ports_userctrl::gc_yawOut.port),      std::cos(t));
+        rCtrlUpd.assign(connected_node(portSpan, ports_userctrl::gc_rollOut.port),     std::sin(2.0f * t));
+    }
+
+    while (true)
+    {
+        // NodeUpd
+        rScene.sigUpdWriters.merge_into(rScene.sigUpd);
+        if (rScene.sigUpd.dirty)
+        {
+            update_signal_nodes<float>(
+                    rScene.sigUpd.nodeDirty, floats.nodeToMach, rScene.parts.machines,
+                    {rScene.sigUpd.nodeNewValues.data(), rScene.sigUpd.nodeNewValues.size()},
+                    {rScene.sigVal.data(), rScene.sigVal.size()},
+                    rUpdMach);
+            rScene.sigUpd.nodeDirty.clear();
+            rScene.sigUpd.dirty = false;
+        }
+
+        // Release the lowest level of machines notified by the node update, if there are any
+        if ( ! signal_levels_pending(rUpdMach) )
+        {
+            break;
+        }
+        release_signal_level(rScene.parts.machines, rUpdMach);
+
+        // MachUpd
+        update_rcs_drivers(rScene);
+        update_rockets(rScene);
+
+        for (MachTypeId const type : rUpdMach.machTypesDirty)
+        {
+            rUpdMach.localDirty[type].clear();
+        }
+        rUpdMach.machTypesDirty.clear();
+    }
+}
+
+/**
+ * @brief Rebuild weldToParts from partToWeld, as needed when parts are welded differently
+ */
+double reweld(Scene& rScene)
+{
+    ACtxParts &rParts = rScene.parts;
+
+    auto const start = Clock_t::now();
+
+    std::vector<std::uint32_t> weldPartCount(rParts.weldIds.capacity(), 0);
+    for (PartId const part : rParts.partIds)
+    {
+        ++weldPartCount[rParts.partToWeld[part]];
+    }
+
+    rParts.weldToParts = {};
+    rParts.weldToParts.ids_reserve(rParts.weldIds.capacity());
+    rParts.weldToParts.data_reserve(rParts.partIds.capacity());
+
+    std::vector<PartId*> weldPartOut(rParts.weldIds.capacity(), nullptr);
+    for (WeldId const weld : rParts.weldIds)
+    {
+        weldPartOut[weld] = rParts.weldToParts.emplace(weld, weldPartCount[weld]);
+    }
+    for (PartId const part : rParts.partIds)
+    {
+        PartId *&rpOut = weldPartOut[rParts.partToWeld[part]];
+        *rpOut = part;
+        ++rpOut;
+    }
+
+    // Weld centres, where a compound rigid body would be placed
+    Vector3 centreSum{0.0f};
+    for (WeldId const weld : rParts.weldIds)
+    {
+        Vector3 centre{0.0f};
+        auto const weldParts = rParts.weldToParts[weld];
+        for (PartId const part : weldParts)
+        {
+            centre += rParts.partTransformWeld[part].translation();
+        }
+        centreSum += centre / float(std::max<std::size_t>(weldParts.size(), 1));
+    }
+
+    double const out = micros_since(start);
+    rScene.thrustTotal += centreSum.x(); // Keep the result alive
+    return out;
+}
+
+/**
+ * @brief Remove every part, weld, machine, and node from ACtxParts, one ID at a time
+ */
+void delete_all(Scene& rScene)
+{
+    ACtxParts &rParts = rScene.parts;
+
+    for (NodeTypeId nodeType = 0; nodeType < NodeTypeReg_t::size(); ++nodeType)
+    {
+        Nodes &rNodes = rParts.nodePerType[nodeType];
+        for (MachAnyId const mach : rParts.machines.ids)
+        {
+            if (rNodes.machToNode.contains(mach))
+            {
+                rNodes.machToNode.erase(mach);
+            }
+        }
+        for (NodeId const node : std::exchange(rNodes.nodeIds, {}))
+        {
+            rNodes.nodeToMach.erase(node);
+        }
+    }
+
+    for (MachAnyId const mach : std::exchange(rParts.machines.ids, {}))
+    {
+        PerMachType &rPerType = rParts.machines.perType[rParts.machines.machTypes[mach]];
+        rPerType.localIds.remove(rParts.machines.machToLocal[mach]);
+    }
+
+    for (WeldId const weld : std::exchange(rParts.weldIds, {}))
+    {
+        rParts.weldToParts.erase(weld);
+    }
+
+    for (PartId const part : std::exchange(rParts.partIds, {}))
+    {
+        if (rParts.partToMachines.contains(part))
+        {
+            rParts.partToMachines.erase(part);
+        }
+    }
+}
+
+struct RunResult
+{
+    std::size_t parts       {0};
+    std::size_t machines    {0};
+    std::size_t nodes       {0};
+    double      build       {0.0};
+    double      spawn       {0.0};
+    double      wire        {0.0};
+    double      frameMean   {0.0};
+    double      frameP50    {0.0};
+    double      frameP95    {0.0};
+    double      reweld      {0.0};
+    double      del         {0.0};
+};
+
+RunResult run(std::size_t const partCount, std::size_t const copies, int const frames)
+{
+    RunResult out;
+
+    osp::Resources resources;
+    resources.resize_types(osp::ResTypeIdReg_t::size());
+
+    auto const buildStart = Clock_t::now();
+    VehicleData const data = make_vehicle(resources, partCount);
+    out.build = micros_since(buildStart);
+
+    Scene scene;
+
+    auto const spawnStart = Clock_t::now();
+    spawn(scene, data, copies);
+    out.spawn = micros_since(spawnStart);
+
+    out.parts       = scene.parts.partIds.size();
+    out.machines    = scene.parts.machines.ids.size();
+    out.nodes       = scene.parts.nodePerType[gc_ntSigFloat].nodeIds.size();
+
+    auto const wireStart = Clock_t::now();
+    wire(scene);
+    out.wire = micros_since(wireStart);
+
+    std::vector<double> frameTimes;
+    frameTimes.reserve(std::size_t(frames));
+    for (int frameNum = -gc_warmupFrames; frameNum < frames; ++frameNum)
+    {
+        auto const frameStart = Clock_t::now();
+        frame(scene, frameNum);
+        if (frameNum >= 0)
+        {
+            frameTimes.push_back(micros_since(frameStart));
+        }
+    }
+    out.frameMean   = mean(frameTimes);
+    out.frameP50    = percentile(frameTimes, 0.5);
+    out.frameP95    = percentile(frameTimes, 0.95);
+
+    out.reweld = reweld(scene);
+
+    auto const deleteStart = Clock_t::now();
+    delete_all(scene);
+    out.del = micros_since(deleteStart);
+
+    // Printed so the compiler can't throw away the machine updates
+    std::fprintf(stderr, "parts %zu: total thrust %g\n", partCount, double(scene.thrustTotal));
+
+    return out;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    char const*                 outPath     = nullptr;
+    std::vector<std::size_t>    partCounts  {10, 100, 1000, 10000};
+    std::size_t                 copies      = 1;
+    int                         frames      = 300;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (char const* const value = osp::bench::option_value(argc, argv, i, "--parts"))
+        {
+            partCounts = osp::bench::parse_counts(value);
+        }
+        else if (char const* const value = osp::bench::option_value(argc, argv, i, "--copies"))
+        {
+            copies = std::max<std::size_t>(1, std::stoul(value));
+        }
+        else if (char const* const value = osp::bench::option_value(argc, argv, i, "--frames"))
+        {
+            frames = std::max(1, std::stoi(value));
+        }
+        else
+        {
+            outPath = argv[i];
+        }
+    }
+
+    osp::bench::CsvOutput const output{outPath};
+    std::FILE *const pOut = output.file();
+    if (pOut == nullptr)
+    {
+        return 1;
+    }
+
+    std::fprintf(pOut, "partsPerVehicle,copies,parts,machines,nodes,frames,usBuild,usSpawn,usWire,"
+                       "usFrame,usFrameP50,usFrameP95,usReweld,usDelete\n");
+
+    for (std::size_t const partCount : partCounts)
+    {
+        RunResult const result = run(std::max<std::size_t>(partCount, 1), copies, frames);
+        std::fprintf(pOut, "%zu,%zu,%zu,%zu,%zu,%d,%.1f,%.1f,%.1f,%.2f,%.2f,%.2f,%.1f,%.1f\n",
+                     partCount, copies, result.parts, result.machines, result.nodes, frames,
+                     result.build, result.spawn, result.wire,
+                     result.frameMean, result.frameP50, result.frameP95,
+                     result.reweld, result.del);
+        std::fflush(pOut);
+    }
+
+    return 0;
+}